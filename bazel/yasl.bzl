@@ -21,6 +21,8 @@ FAST_FLAGS = ["-O1"]
 
 EMP_COPT_FLAGS = select({
      "@platforms//cpu:aarch64": ["-O3"],
+     # emp-tool inlines aes-ni and pclmul, the floor of a portable build.
+     "@yasl//bazel:yasl_portable_build": ["-maes", "-mpclmul", "-msse4.2"],
      "//conditions:default": ["-march=native"],
  })
 
@@ -0,0 +1,99 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/base/bit_vector.h"
+
+#include <cstring>
+#include <utility>
+
+#include "absl/numeric/bits.h"
+
+namespace yasl {
+
+BitVector::BitVector(absl::Span<const uint128_t> words, size_t size)
+    : size_(size) {
+  YASL_ENFORCE_GE(words.size(), NumWords(size));
+  words_.assign(words.begin(), words.begin() + NumWords(size));
+  ClearUnusedBits();
+}
+
+BitVector::BitVector(std::vector<uint128_t>&& words, size_t size)
+    : size_(size), words_(std::move(words)) {
+  YASL_ENFORCE_GE(words_.size(), NumWords(size));
+  words_.resize(NumWords(size));
+  ClearUnusedBits();
+}
+
+void BitVector::resize(size_t size, bool value) {
+  const size_t old_size = size_;
+  if (value && size > old_size && old_size % kWordBits != 0) {
+    // fill the tail of the old last word, the rest is filled by words.
+    words_.back() |= ~uint128_t(0) << (old_size % kWordBits);
+  }
+  words_.resize(NumWords(size), value ? ~uint128_t(0) : uint128_t(0));
+  size_ = size;
+  ClearUnusedBits();
+}
+
+size_t BitVector::Count() const {
+  size_t count = 0;
+  for (const auto word : words_) {
+    count += absl::popcount(static_cast<uint64_t>(word)) +
+             absl::popcount(static_cast<uint64_t>(word >> 64));
+  }
+  return count;
+}
+
+BitVector& BitVector::operator^=(const BitVector& other) {
+  YASL_ENFORCE_EQ(size_, other.size_);
+  for (size_t i = 0; i < words_.size(); ++i) {
+    words_[i] ^= other.words_[i];
+  }
+  return *this;
+}
+
+Buffer BitVector::Serialize() const {
+  const uint64_t size = size_;
+  const size_t num_bytes = (size_ + 7) / 8;
+  Buffer buf(static_cast<int64_t>(sizeof(size) + num_bytes));
+  std::memcpy(buf.data(), &size, sizeof(size));
+  if (num_bytes > 0) {
+    std::memcpy(buf.data<uint8_t>() + sizeof(size), words_.data(), num_bytes);
+  }
+  return buf;
+}
+
+BitVector BitVector::Deserialize(ByteContainerView buf) {
+  uint64_t size = 0;
+  YASL_ENFORCE_GE(buf.size(), sizeof(size));
+  std::memcpy(&size, buf.data(), sizeof(size));
+  const size_t num_bytes = (size + 7) / 8;
+  YASL_ENFORCE_EQ(buf.size(), sizeof(size) + num_bytes,
+                  "corrupted bit vector of size={}", size);
+
+  BitVector ret(size);
+  if (num_bytes > 0) {
+    std::memcpy(ret.words_.data(), buf.data() + sizeof(size), num_bytes);
+  }
+  ret.ClearUnusedBits();
+  return ret;
+}
+
+void BitVector::ClearUnusedBits() {
+  if (size_ % kWordBits != 0) {
+    words_.back() &= (uint128_t(1) << (size_ % kWordBits)) - 1;
+  }
+}
+
+}  // namespace yasl
@@ -0,0 +1,101 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/byte_container_view.h"
+#include "yasl/base/exception.h"
+#include "yasl/base/int128.h"
+
+namespace yasl {
+
+// A bit vector packed into 128 bits words, bit i is the (i % 128)th bit of
+// word i / 128, which is the layout of choice bits in OT apis. Bits beyond
+// size are always 0, so that words can be xor-ed and counted as a whole.
+class BitVector {
+ public:
+  static constexpr size_t kWordBits = sizeof(uint128_t) * 8;
+
+  BitVector() = default;
+  explicit BitVector(size_t size, bool value = false) { resize(size, value); }
+  // take the first `size` bits of `words`.
+  BitVector(absl::Span<const uint128_t> words, size_t size);
+  // the same, taking over `words` without a copy.
+  BitVector(std::vector<uint128_t>&& words, size_t size);
+
+  static size_t NumWords(size_t size) {
+    return (size + kWordBits - 1) / kWordBits;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  bool operator[](size_t idx) const {
+    return (words_[idx / kWordBits] >> (idx % kWordBits)) & 1;
+  }
+  bool at(size_t idx) const {
+    YASL_ENFORCE_LT(idx, size_);
+    return (*this)[idx];
+  }
+
+  void Set(size_t idx, bool value) {
+    const uint128_t mask = uint128_t(1) << (idx % kWordBits);
+    auto& word = words_[idx / kWordBits];
+    word = value ? (word | mask) : (word & ~mask);
+  }
+
+  void push_back(bool value) {
+    resize(size_ + 1);
+    Set(size_ - 1, value);
+  }
+
+  void resize(size_t size, bool value = false);
+
+  // words of the vector, a zero-copy view for word level access.
+  absl::Span<const uint128_t> words() const { return words_; }
+
+  // number of 1 bits.
+  size_t Count() const;
+
+  BitVector& operator^=(const BitVector& other);
+  BitVector operator^(const BitVector& other) const {
+    BitVector ret = *this;
+    ret ^= other;
+    return ret;
+  }
+
+  bool operator==(const BitVector& other) const {
+    return size_ == other.size_ && words_ == other.words_;
+  }
+  bool operator!=(const BitVector& other) const { return !(*this == other); }
+
+  // 8 bytes of size, then the bits in ceil(size / 8) bytes.
+  Buffer Serialize() const;
+  static BitVector Deserialize(ByteContainerView buf);
+
+ private:
+  // zero bits beyond size in the last word.
+  void ClearUnusedBits();
+
+  size_t size_ = 0;
+  std::vector<uint128_t> words_;
+};
+
+}  // namespace yasl
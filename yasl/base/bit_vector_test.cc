@@ -0,0 +1,97 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/base/bit_vector.h"
+
+#include <random>
+
+#include "gtest/gtest.h"
+
+namespace yasl {
+
+TEST(BitVectorTest, SetAndGetWork) {
+  // GIVEN
+  const size_t size = 300;
+  std::vector<bool> bits(size);
+  std::mt19937 gen(0);
+  for (size_t i = 0; i < size; ++i) {
+    bits[i] = gen() & 1;
+  }
+
+  // WHEN
+  BitVector v(size);
+  BitVector pushed;
+  for (size_t i = 0; i < size; ++i) {
+    v.Set(i, bits[i]);
+    pushed.push_back(bits[i]);
+  }
+
+  // THEN
+  EXPECT_EQ(v.size(), size);
+  EXPECT_EQ(v.words().size(), 3);
+  EXPECT_EQ(v, pushed);
+  size_t count = 0;
+  for (size_t i = 0; i < size; ++i) {
+    EXPECT_EQ(v[i], bits[i]);
+    EXPECT_EQ((v.words()[i / 128] >> (i % 128)) & 1, bits[i]);
+    count += bits[i];
+  }
+  EXPECT_EQ(v.Count(), count);
+  EXPECT_THROW(v.at(size), Exception);
+}
+
+TEST(BitVectorTest, UnusedBitsShouldBeZero) {
+  // GIVEN
+  const std::vector<uint128_t> words = {~uint128_t(0), ~uint128_t(0)};
+
+  // WHEN
+  BitVector v(words, 130);
+  BitVector moved(std::vector<uint128_t>(words), 130);
+  BitVector ones(130, true);
+  BitVector resized(100, true);
+  resized.resize(200, false);
+
+  // THEN
+  EXPECT_EQ(v.words()[1], 3);
+  EXPECT_EQ(v.Count(), 130);
+  EXPECT_EQ(v, ones);
+  EXPECT_EQ(moved, ones);
+  EXPECT_EQ((v ^ ones).Count(), 0);
+  EXPECT_EQ(resized.Count(), 100);
+  resized.resize(250, true);
+  EXPECT_EQ(resized.Count(), 150);
+  EXPECT_FALSE(resized[199]);
+  EXPECT_TRUE(resized[200]);
+}
+
+TEST(BitVectorTest, SerializeWorks) {
+  for (size_t size : {0, 1, 8, 127, 128, 129, 1000}) {
+    // GIVEN
+    BitVector v(size);
+    for (size_t i = 0; i < size; i += 3) {
+      v.Set(i, true);
+    }
+
+    // WHEN
+    auto buf = v.Serialize();
+    auto out = BitVector::Deserialize(buf);
+
+    // THEN
+    EXPECT_EQ(buf.size(), 8 + (size + 7) / 8);
+    EXPECT_EQ(out, v);
+  }
+  EXPECT_THROW(BitVector::Deserialize("abc"), Exception);
+}
+
+}  // namespace yasl
@@ -17,15 +17,21 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <functional>
 #include <string_view>
 #include <utility>
 
+#include "yasl/base/buffer_allocator.h"
 #include "yasl/base/exception.h"
 
 namespace yasl {
 
 // A buffer is an RAII object which represent an in memory buffer.
+//
+// Unless it owns memory of a user provided deleter, the memory comes from
+// the buffer allocator, aligned to kBufferAlignment, and may be larger than
+// the size; resize within the capacity does not reallocate.
 class Buffer final {
   std::byte* ptr_{nullptr};
   int64_t size_{0};
@@ -39,9 +45,9 @@ class Buffer final {
   Buffer() = default;
   explicit Buffer(int64_t size) : size_(size) {
     YASL_ENFORCE(size >= 0);
-    // C++17 ensures alignment of allocated memory is >=
-    // __STDCPP_DEFAULT_NEW_ALIGNMENT__ Which should be 16
-    ptr_ = new std::byte[size];
+    if (size > 0) {
+      ptr_ = internal::AllocateBufferBlock(size);
+    }
   }
 
   template <typename ByteContainer,
@@ -114,26 +120,54 @@ class Buffer final {
                       : std::string_view(reinterpret_cast<char*>(ptr_), size_);
   }
 
+  // bytes the buffer may grow to without reallocating.
+  int64_t capacity() const {
+    if (ptr_ == nullptr || has_deleter()) {
+      return size_;
+    }
+    return internal::BufferBlockCapacity(ptr_);
+  }
+
+  // keeps the contents, grows by half the capacity at least, so that
+  // appending a bit at a time is amortized linear.
   void resize(int64_t new_size) {
+    YASL_ENFORCE(new_size >= 0, "new size = {}", new_size);
     if (new_size == size_) {
       return;
     }
-
-    std::byte* new_ptr = nullptr;
-    if (new_size != 0) {
-      new_ptr = new std::byte[new_size];
-      if (ptr_ != nullptr) {
-        std::copy(ptr_, ptr_ + std::min(new_size, size_), new_ptr);
-      }
+    if (new_size == 0 && has_deleter()) {
+      reset();
+      return;
+    }
+    if (new_size > capacity() || has_deleter()) {
+      const int64_t cap = capacity();
+      reallocate(has_deleter() ? new_size
+                               : std::max(new_size, cap + cap / 2));
     }
+    size_ = new_size;
+  }
 
-    reset();
+  // makes the capacity at least new_capacity, keeping the contents.
+  void reserve(int64_t new_capacity) {
+    if (new_capacity > capacity()) {
+      reallocate(new_capacity);
+    }
+  }
 
-    ptr_ = new_ptr;
-    size_ = new_size;
-    YASL_ENFORCE(size_ == 0 || ptr_ != nullptr, "new size = {}", new_size);
+  // gives back the capacity beyond the size.
+  void shrink_to_fit() {
+    if (size_ == 0) {
+      reset();
+    } else if (capacity() > size_) {
+      reallocate(size_);
+    }
   }
 
+  // whether the memory is released by a user provided deleter.
+  bool has_deleter() const { return deleter_ != nullptr; }
+
+  // gives up the memory without freeing it. unless the buffer has a
+  // deleter, free it with Buffer::Free.
   void* release() {
     void* tmp = ptr_;
     ptr_ = nullptr;
@@ -145,12 +179,28 @@ class Buffer final {
     if (deleter_ != nullptr) {
       deleter_(reinterpret_cast<void*>(ptr_));
     } else {
-      delete[] ptr_;
+      internal::FreeBufferBlock(ptr_);
     }
     deleter_ = nullptr;
     ptr_ = nullptr;
     size_ = 0;
   }
+
+  // frees the memory of release(), a plain function to hand over as a
+  // deleter.
+  static void Free(void* ptr) { internal::FreeBufferBlock(ptr); }
+
+ private:
+  void reallocate(int64_t new_capacity) {
+    std::byte* new_ptr = internal::AllocateBufferBlock(new_capacity);
+    const int64_t size = std::min(size_, new_capacity);
+    if (size > 0) {
+      std::memcpy(new_ptr, ptr_, size);
+    }
+    reset();
+    ptr_ = new_ptr;
+    size_ = size;
+  }
 };
 
 std::ostream& operator<<(std::ostream& out, const Buffer& v);
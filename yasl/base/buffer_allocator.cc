@@ -0,0 +1,271 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/base/buffer_allocator.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "yasl/base/exception.h"
+#include "yasl/base/huge_page.h"
+#include "yasl/base/memory_tracker.h"
+
+namespace yasl {
+
+namespace {
+
+class AlignedAllocator final : public BufferAllocator {
+ public:
+  void* Allocate(size_t size, size_t* capacity) override {
+    *capacity = size;
+    return ::operator new(size, std::align_val_t(kBufferAlignment));
+  }
+
+  void Deallocate(void* ptr, size_t capacity) override {
+    ::operator delete(ptr, std::align_val_t(kBufferAlignment));
+  }
+};
+
+// size classes are the powers of two from 128 B, a header and a cache line,
+// to 1 MiB.
+constexpr size_t kMinClassShift = 7;
+constexpr size_t kMaxClassShift = 20;
+constexpr size_t kNumClasses = kMaxClassShift - kMinClassShift + 1;
+
+// free blocks a thread keeps of a class, about 256 KiB of each. the shared
+// pool keeps 4 times that.
+constexpr size_t ThreadCacheLimit(size_t cls) {
+  return std::max<size_t>(2, (size_t{256} << 10) >> (cls + kMinClassShift));
+}
+constexpr size_t kSharedPoolFactor = 4;
+
+size_t ClassOf(size_t size) {
+  size_t shift = kMinClassShift;
+  if (size > (size_t{1} << kMinClassShift)) {
+    shift = 64 - __builtin_clzll(size - 1);
+  }
+  return shift - kMinClassShift;
+}
+
+size_t ClassSize(size_t cls) { return size_t{1} << (cls + kMinClassShift); }
+
+MemoryTag* BufferTag() {
+  static auto* tag = MemoryTag::Get("buffer");
+  return tag;
+}
+
+// free blocks of the pool, in the thread caches and the shared pool.
+MemoryTag* PoolTag() {
+  static auto* tag = MemoryTag::Get("buffer_pool");
+  return tag;
+}
+
+AlignedAllocator* GetAlignedAllocator() {
+  // leaked, buffers may be freed during static destruction.
+  static auto* allocator = new AlignedAllocator();
+  return allocator;
+}
+
+struct SharedPool {
+  std::array<std::mutex, kNumClasses> mutexes;
+  std::array<std::vector<void*>, kNumClasses> blocks;
+
+  void* Pop(size_t cls) {
+    std::lock_guard<std::mutex> lock(mutexes[cls]);
+    if (blocks[cls].empty()) {
+      return nullptr;
+    }
+    void* ptr = blocks[cls].back();
+    blocks[cls].pop_back();
+    return ptr;
+  }
+
+  // false if the pool is full.
+  bool Push(size_t cls, void* ptr) {
+    std::lock_guard<std::mutex> lock(mutexes[cls]);
+    if (blocks[cls].size() >= kSharedPoolFactor * ThreadCacheLimit(cls)) {
+      return false;
+    }
+    blocks[cls].push_back(ptr);
+    return true;
+  }
+};
+
+SharedPool* GetSharedPool() {
+  static auto* pool = new SharedPool();
+  return pool;
+}
+
+void FreeToSharedPool(size_t cls, void* ptr) {
+  if (GetSharedPool()->Push(cls, ptr)) {
+    PoolTag()->Add(ClassSize(cls));
+  } else {
+    GetAlignedAllocator()->Deallocate(ptr, ClassSize(cls));
+  }
+}
+
+// the cache of a thread is gone once it began to exit, blocks freed after
+// that go to the shared pool. trivially destructible, so always readable.
+thread_local bool thread_cache_alive = false;
+
+struct ThreadCache {
+  std::array<std::vector<void*>, kNumClasses> blocks;
+
+  ThreadCache() { thread_cache_alive = true; }
+
+  ~ThreadCache() {
+    thread_cache_alive = false;
+    for (size_t cls = 0; cls < kNumClasses; ++cls) {
+      for (void* ptr : blocks[cls]) {
+        PoolTag()->Add(-static_cast<int64_t>(ClassSize(cls)));
+        FreeToSharedPool(cls, ptr);
+      }
+    }
+  }
+};
+
+// nullptr once the thread is exiting.
+ThreadCache* GetThreadCache() {
+  static thread_local bool created = false;
+  if (created && !thread_cache_alive) {
+    return nullptr;
+  }
+  created = true;
+  static thread_local ThreadCache cache;
+  return &cache;
+}
+
+class PooledAllocator final : public BufferAllocator {
+ public:
+  void* Allocate(size_t size, size_t* capacity) override {
+    if (UseHugePages(size)) {
+      *capacity = HugePageCapacity(size);
+      return MapHugePages(size);
+    }
+    if (size > (size_t{1} << kMaxClassShift)) {
+      return GetAlignedAllocator()->Allocate(size, capacity);
+    }
+    const size_t cls = ClassOf(size);
+    *capacity = ClassSize(cls);
+    if (auto* cache = GetThreadCache();
+        cache != nullptr && !cache->blocks[cls].empty()) {
+      void* ptr = cache->blocks[cls].back();
+      cache->blocks[cls].pop_back();
+      PoolTag()->Add(-static_cast<int64_t>(*capacity));
+      return ptr;
+    }
+    if (void* ptr = GetSharedPool()->Pop(cls)) {
+      PoolTag()->Add(-static_cast<int64_t>(*capacity));
+      return ptr;
+    }
+    return GetAlignedAllocator()->Allocate(*capacity, capacity);
+  }
+
+  void Deallocate(void* ptr, size_t capacity) override {
+    if (UseHugePages(capacity)) {
+      UnmapHugePages(ptr, capacity);
+      return;
+    }
+    if (capacity > (size_t{1} << kMaxClassShift)) {
+      GetAlignedAllocator()->Deallocate(ptr, capacity);
+      return;
+    }
+    const size_t cls = ClassOf(capacity);
+    if (auto* cache = GetThreadCache();
+        cache != nullptr && cache->blocks[cls].size() < ThreadCacheLimit(cls)) {
+      cache->blocks[cls].push_back(ptr);
+      PoolTag()->Add(capacity);
+      return;
+    }
+    FreeToSharedPool(cls, ptr);
+  }
+};
+
+std::atomic<BufferAllocator*> current_allocator{nullptr};
+
+struct BlockHeader {
+  BufferAllocator* allocator;
+  size_t capacity;
+};
+static_assert(sizeof(BlockHeader) <= kBufferAlignment);
+
+BlockHeader* HeaderOf(const void* data) {
+  return reinterpret_cast<BlockHeader*>(
+      const_cast<std::byte*>(static_cast<const std::byte*>(data)) -
+      kBufferAlignment);
+}
+
+}  // namespace
+
+BufferAllocator* DefaultBufferAllocator() { return GetAlignedAllocator(); }
+
+BufferAllocator* PooledBufferAllocator() {
+  static auto* allocator = new PooledAllocator();
+  return allocator;
+}
+
+void SetBufferAllocator(BufferAllocator* allocator) {
+  YASL_ENFORCE(allocator != nullptr);
+  current_allocator.store(allocator, std::memory_order_release);
+}
+
+BufferAllocator* GetBufferAllocator() {
+  auto* allocator = current_allocator.load(std::memory_order_acquire);
+  if (allocator != nullptr) {
+    return allocator;
+  }
+#if defined(__SANITIZE_ADDRESS__)
+  return DefaultBufferAllocator();
+#else
+  return PooledBufferAllocator();
+#endif
+}
+
+namespace internal {
+
+std::byte* AllocateBufferBlock(int64_t size) {
+  YASL_ENFORCE(size > 0, "size = {}", size);
+  auto* allocator = GetBufferAllocator();
+  size_t capacity = 0;
+  auto* block = static_cast<std::byte*>(
+      allocator->Allocate(size + kBufferAlignment, &capacity));
+  YASL_ENFORCE(block != nullptr && capacity >= size + kBufferAlignment &&
+                   reinterpret_cast<uintptr_t>(block) % kBufferAlignment == 0,
+               "bad block of buffer allocator, size = {}", size);
+  auto* data = block + kBufferAlignment;
+  *HeaderOf(data) = {allocator, capacity};
+  BufferTag()->Add(capacity);
+  return data;
+}
+
+void FreeBufferBlock(void* data) {
+  if (data == nullptr) {
+    return;
+  }
+  const BlockHeader header = *HeaderOf(data);
+  BufferTag()->Add(-static_cast<int64_t>(header.capacity));
+  header.allocator->Deallocate(HeaderOf(data), header.capacity);
+}
+
+int64_t BufferBlockCapacity(const void* data) {
+  return HeaderOf(data)->capacity - kBufferAlignment;
+}
+
+}  // namespace internal
+
+}  // namespace yasl
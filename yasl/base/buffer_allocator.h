@@ -0,0 +1,70 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Brief: where the memory of yasl::Buffer comes from.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace yasl {
+
+// buffer memory is aligned to a cache line, which is also what avx-512
+// loads and rdma registration want.
+constexpr size_t kBufferAlignment = 64;
+
+// An allocator of buffer memory. Blocks are kBufferAlignment aligned.
+class BufferAllocator {
+ public:
+  virtual ~BufferAllocator() = default;
+
+  // a block of at least size bytes, size > 0. *capacity is set to its real
+  // size, which is then passed back to Deallocate.
+  virtual void* Allocate(size_t size, size_t* capacity) = 0;
+
+  virtual void Deallocate(void* ptr, size_t capacity) = 0;
+};
+
+// aligned operator new and delete.
+BufferAllocator* DefaultBufferAllocator();
+
+// blocks up to 1 MiB are rounded up to a power of two and recycled: a
+// thread keeps a few free blocks of every size in a cache of its own, in
+// front of a pool shared by all threads. larger ones go to the default
+// allocator, and those of UseHugePages to huge pages.
+BufferAllocator* PooledBufferAllocator();
+
+// the allocator of buffers allocated from now on, the pooled one by
+// default (the default one under address sanitizer, which a pool would
+// blind). a block is always returned to the allocator it came from, so an
+// allocator must outlive its buffers.
+void SetBufferAllocator(BufferAllocator* allocator);
+BufferAllocator* GetBufferAllocator();
+
+namespace internal {
+
+// a block of at least size bytes of the current allocator, preceded by a
+// header which remembers the allocator and the capacity.
+std::byte* AllocateBufferBlock(int64_t size);
+
+// frees a block of AllocateBufferBlock, nullptr is ignored.
+void FreeBufferBlock(void* data);
+
+// usable bytes of a block of AllocateBufferBlock.
+int64_t BufferBlockCapacity(const void* data);
+
+}  // namespace internal
+
+}  // namespace yasl
@@ -0,0 +1,184 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/base/buffer.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/huge_page.h"
+
+namespace yasl {
+
+namespace {
+
+bool Aligned(const void* ptr) {
+  return reinterpret_cast<uintptr_t>(ptr) % kBufferAlignment == 0;
+}
+
+class CountingAllocator final : public BufferAllocator {
+ public:
+  void* Allocate(size_t size, size_t* capacity) override {
+    ++allocated;
+    return DefaultBufferAllocator()->Allocate(size, capacity);
+  }
+
+  void Deallocate(void* ptr, size_t capacity) override {
+    ++deallocated;
+    DefaultBufferAllocator()->Deallocate(ptr, capacity);
+  }
+
+  std::atomic<int> allocated{0};
+  std::atomic<int> deallocated{0};
+};
+
+}  // namespace
+
+TEST(BufferTest, Aligned) {
+  for (int64_t size : {1, 7, 64, 100, 4096, 5000, 3 << 20}) {
+    Buffer buf(size);
+    EXPECT_TRUE(Aligned(buf.data())) << size;
+    EXPECT_GE(buf.capacity(), size);
+  }
+  EXPECT_EQ(Buffer(0).data(), nullptr);
+}
+
+TEST(BufferTest, ResizeWithinCapacity) {
+  Buffer buf(std::string(10, 'x'));
+  const void* data = buf.data();
+  const int64_t cap = buf.capacity();
+  buf.resize(cap);
+  EXPECT_EQ(buf.data(), data);
+  buf.resize(5);
+  EXPECT_EQ(buf.data(), data);
+  EXPECT_EQ(std::string_view(buf), "xxxxx");
+
+  buf.resize(cap + 1);
+  EXPECT_NE(buf.data(), data);
+  EXPECT_GE(buf.capacity(), cap + cap / 2);
+  EXPECT_EQ(std::string_view(buf).substr(0, 5), "xxxxx");
+
+  buf.resize(3);
+  buf.shrink_to_fit();
+  EXPECT_LT(buf.capacity(), cap + cap / 2);
+  EXPECT_EQ(std::string_view(buf), "xxx");
+}
+
+TEST(BufferTest, Reserve) {
+  Buffer buf;
+  buf.reserve(1000);
+  EXPECT_EQ(buf.size(), 0);
+  EXPECT_GE(buf.capacity(), 1000);
+  const void* data = buf.data();
+  for (int i = 0; i < 1000; ++i) {
+    buf.resize(i + 1);
+    buf.data<char>()[i] = 'a' + i % 26;
+  }
+  EXPECT_EQ(buf.data(), data);
+  EXPECT_EQ(buf.data<char>()[999], 'a' + 999 % 26);
+}
+
+TEST(BufferTest, Deleter) {
+  void* ptr = std::aligned_alloc(16, 32);
+  bool deleted = false;
+  {
+    Buffer buf(ptr, 32, [&](void* p) {
+      deleted = true;
+      std::free(p);
+    });
+    EXPECT_EQ(buf.capacity(), 32);
+    buf.resize(16);
+    EXPECT_TRUE(deleted);
+    EXPECT_FALSE(buf.has_deleter());
+    EXPECT_TRUE(Aligned(buf.data()));
+  }
+}
+
+TEST(BufferTest, Release) {
+  Buffer buf(std::string(100, 'y'));
+  void* data = buf.release();
+  EXPECT_EQ(buf.size(), 0);
+  EXPECT_EQ(static_cast<char*>(data)[99], 'y');
+  Buffer::Free(data);
+  Buffer::Free(nullptr);
+}
+
+TEST(BufferTest, PluggableAllocator) {
+  CountingAllocator counting;
+  auto* prev = GetBufferAllocator();
+  SetBufferAllocator(&counting);
+  Buffer a(100);
+  SetBufferAllocator(prev);
+  Buffer b(100);
+  EXPECT_EQ(counting.allocated, 1);
+  // a block goes back to the allocator it came from.
+  a = Buffer();
+  b = Buffer();
+  EXPECT_EQ(counting.deallocated, 1);
+}
+
+TEST(BufferTest, PoolAcrossThreads) {
+  auto* prev = GetBufferAllocator();
+  SetBufferAllocator(PooledBufferAllocator());
+  {
+    // the same block is recycled within a thread.
+    const void* data = Buffer(200).data();
+    EXPECT_EQ(Buffer(200).data(), data);
+  }
+  // buffers freed by another thread than the one allocating them.
+  std::vector<Buffer> bufs;
+  for (int i = 0; i < 1000; ++i) {
+    bufs.emplace_back(1 + i * 37 % 5000);
+    std::memset(bufs.back().data(), i, bufs.back().size());
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = t; i < 1000; i += 4) {
+        const auto* p = bufs[i].data<unsigned char>();
+        EXPECT_EQ(p[bufs[i].size() - 1], static_cast<unsigned char>(i));
+        bufs[i] = Buffer();
+        Buffer tmp(i * 13 % 3000 + 1);
+        EXPECT_TRUE(Aligned(tmp.data()));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  SetBufferAllocator(prev);
+}
+
+TEST(BufferTest, PooledHugePages) {
+  auto* prev = GetBufferAllocator();
+  SetBufferAllocator(PooledBufferAllocator());
+  Buffer buf(kHugePageThreshold);
+  if (UseHugePages(kHugePageThreshold + kBufferAlignment)) {
+    const size_t capacity =
+        HugePageCapacity(kHugePageThreshold + kBufferAlignment);
+    EXPECT_EQ(buf.capacity(),
+              static_cast<int64_t>(capacity - kBufferAlignment));
+  }
+  std::memset(buf.data(), 1, buf.size());
+  EXPECT_TRUE(Aligned(buf.data()));
+  buf = Buffer();
+  SetBufferAllocator(prev);
+}
+
+}  // namespace yasl
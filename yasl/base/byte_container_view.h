@@ -15,9 +15,12 @@
 
 #pragma once
 
+#include <cstring>
+#include <initializer_list>
 #include <string>
 #include <type_traits>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/types/span.h"
 
 #include "yasl/base/buffer.h"
@@ -72,4 +75,55 @@ class ByteContainerView : public absl::Span<const uint8_t> {
   }
 };
 
+// ByteChainView is a list of byte ranges viewed as their concatenation, like
+// an iovec, so that a msg of several parts, e.g. a header and some share
+// arrays, is sent or serialized without assembling it first. The ranges are
+// not owned and must outlive the view.
+class ByteChainView {
+ public:
+  ByteChainView() = default;
+
+  explicit ByteChainView(std::initializer_list<ByteContainerView> parts) {
+    for (const auto &part : parts) {
+      Append(part);
+    }
+  }
+
+  // empty parts are dropped.
+  ByteChainView &Append(ByteContainerView part) {
+    if (!part.empty()) {
+      parts_.push_back(part);
+      size_ += part.size();
+    }
+    return *this;
+  }
+
+  absl::Span<const ByteContainerView> parts() const { return parts_; }
+
+  // total bytes of the parts.
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  // copies the concatenation to out, which holds size() bytes at least.
+  void CopyTo(void *out) const {
+    auto *p = static_cast<uint8_t *>(out);
+    for (const auto &part : parts_) {
+      std::memcpy(p, part.data(), part.size());
+      p += part.size();
+    }
+  }
+
+  // the concatenation, for consumers of a single range.
+  Buffer Flatten() const {
+    Buffer out(static_cast<int64_t>(size_));
+    CopyTo(out.data());
+    return out;
+  }
+
+ private:
+  absl::InlinedVector<ByteContainerView, 4> parts_;
+  size_t size_ = 0;
+};
+
 }  // namespace yasl
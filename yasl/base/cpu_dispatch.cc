@@ -0,0 +1,157 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "yasl/base/cpu_dispatch.h"
+
+#include <cstdlib>
+#include <mutex>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_split.h"
+
+#include "yasl/base/exception.h"
+
+#ifdef __x86_64
+#include "yasl/base/cpu_info.h"
+#endif
+
+namespace yasl {
+
+namespace {
+
+constexpr std::pair<CpuIsa, const char*> kIsaNames[] = {
+    {kIsaSse2, "sse2"},
+    {kIsaSsse3, "ssse3"},
+    {kIsaSse42, "sse4.2"},
+    {kIsaPopcnt, "popcnt"},
+    {kIsaBmi2, "bmi2"},
+    {kIsaAvx, "avx"},
+    {kIsaAvx2, "avx2"},
+    {kIsaAvx512f, "avx512f"},
+    {kIsaAvx512bw, "avx512bw"},
+    {kIsaAvx512Vpopcntdq, "avx512vpopcntdq"},
+    {kIsaAes, "aes"},
+    {kIsaVaes, "vaes"},
+    {kIsaPclmul, "pclmul"},
+    {kIsaVpclmul, "vpclmul"},
+    {kIsaSha, "sha"},
+    {kIsaNeon, "neon"},
+};
+
+uint32_t DetectCpuIsa() {
+  uint32_t isa = kIsaPortable;
+#ifdef __x86_64
+  const auto& f = GetCpuFeatures();
+  const std::pair<bool, CpuIsa> bits[] = {
+      {f.sse2, kIsaSse2},
+      {f.ssse3, kIsaSsse3},
+      {f.sse4_2, kIsaSse42},
+      {f.popcnt, kIsaPopcnt},
+      {f.bmi2, kIsaBmi2},
+      {f.avx, kIsaAvx},
+      {f.avx2, kIsaAvx2},
+      {f.avx512f, kIsaAvx512f},
+      {f.avx512bw, kIsaAvx512bw},
+      {f.avx512vpopcntdq, kIsaAvx512Vpopcntdq},
+      {f.aes, kIsaAes},
+      {f.vaes, kIsaVaes},
+      {f.pclmulqdq, kIsaPclmul},
+      {f.vpclmulqdq, kIsaVpclmul},
+      {f.sha, kIsaSha},
+  };
+  for (const auto& [has, bit] : bits) {
+    if (has) {
+      isa |= bit;
+    }
+  }
+#endif
+#ifdef __aarch64__
+  isa |= kIsaNeon;
+#endif
+  return isa;
+}
+
+struct BindingRegistry {
+  std::mutex mutex;
+  std::map<std::string, std::string> bindings;
+};
+
+BindingRegistry* GetBindingRegistry() {
+  // leaked, kernels may be bound during static destruction as well.
+  static auto* registry = new BindingRegistry();
+  return registry;
+}
+
+}  // namespace
+
+uint32_t GetCpuIsa() {
+  static const uint32_t isa = [] {
+    uint32_t detected = DetectCpuIsa();
+    if (const char* disabled = std::getenv("YASL_CPU_ISA_DISABLE")) {
+      detected &= ~ParseCpuIsa(disabled);
+    }
+    return detected;
+  }();
+  return isa;
+}
+
+std::string CpuIsaToString(uint32_t isa) {
+  std::string names;
+  for (const auto& [bit, name] : kIsaNames) {
+    if ((isa & bit) != 0) {
+      names += names.empty() ? "" : ",";
+      names += name;
+    }
+  }
+  return names.empty() ? "portable" : names;
+}
+
+uint32_t ParseCpuIsa(std::string_view names) {
+  uint32_t isa = kIsaPortable;
+  for (absl::string_view name : absl::StrSplit(
+           absl::string_view(names.data(), names.size()), ',',
+           absl::SkipWhitespace())) {
+    name = absl::StripAsciiWhitespace(name);
+    if (name == "portable") {
+      continue;
+    }
+    bool found = false;
+    for (const auto& [bit, isa_name] : kIsaNames) {
+      if (name == isa_name) {
+        isa |= bit;
+        found = true;
+        break;
+      }
+    }
+    YASL_ENFORCE(found, "unknown instruction set {}", std::string(name));
+  }
+  return isa;
+}
+
+std::map<std::string, std::string> ListKernelBindings() {
+  auto* registry = GetBindingRegistry();
+  std::lock_guard<std::mutex> lock(registry->mutex);
+  return registry->bindings;
+}
+
+namespace internal {
+
+void RecordKernelBinding(std::string kernel, uint32_t isa) {
+  auto* registry = GetBindingRegistry();
+  std::lock_guard<std::mutex> lock(registry->mutex);
+  registry->bindings[std::move(kernel)] = CpuIsaToString(isa);
+}
+
+}  // namespace internal
+
+}  // namespace yasl
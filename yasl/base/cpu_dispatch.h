@@ -0,0 +1,114 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// Brief: runtime selection of simd kernels. A kernel lists its
+// implementations along with the instruction sets each needs, and the best
+// one this cpu supports is bound once, so one portable binary runs the
+// fastest path of every host:
+//
+//   XorFn SelectXor() {
+//     CpuDispatch<XorFn> dispatch("bitwise.xor", XorPortable);
+//     dispatch.Add(kIsaAvx2, XorAvx2).Add(kIsaAvx512f, XorAvx512);
+//     return dispatch.Bind();
+//   }
+//   static const XorFn kXor = SelectXor();
+//
+// YASL_CPU_ISA_DISABLE, e.g. "avx512f,vaes", hides instruction sets from
+// dispatch, to compare paths or to avoid a slow one on some host.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace yasl {
+
+// instruction sets kernels are specialized for, combined as bits.
+enum CpuIsa : uint32_t {
+  kIsaPortable = 0,
+  kIsaSse2 = 1u << 0,
+  kIsaSsse3 = 1u << 1,
+  kIsaSse42 = 1u << 2,
+  kIsaPopcnt = 1u << 3,
+  kIsaBmi2 = 1u << 4,
+  kIsaAvx = 1u << 5,
+  kIsaAvx2 = 1u << 6,
+  kIsaAvx512f = 1u << 7,
+  kIsaAvx512bw = 1u << 8,
+  kIsaAvx512Vpopcntdq = 1u << 9,
+  kIsaAes = 1u << 10,
+  kIsaVaes = 1u << 11,
+  kIsaPclmul = 1u << 12,
+  kIsaVpclmul = 1u << 13,
+  kIsaSha = 1u << 14,
+  kIsaNeon = 1u << 15,
+};
+
+// the instruction sets of this cpu, detected once, less those of
+// YASL_CPU_ISA_DISABLE.
+uint32_t GetCpuIsa();
+
+// whether all instruction sets of isa are available.
+inline bool CpuSupports(uint32_t isa) { return (GetCpuIsa() & isa) == isa; }
+
+// "avx2,avx512f", or "portable" for none.
+std::string CpuIsaToString(uint32_t isa);
+
+// the inverse of CpuIsaToString, throws on an unknown name.
+uint32_t ParseCpuIsa(std::string_view names);
+
+// kernel name and the instruction sets of its bound implementation, of the
+// kernels bound so far.
+std::map<std::string, std::string> ListKernelBindings();
+
+namespace internal {
+
+void RecordKernelBinding(std::string kernel, uint32_t isa);
+
+}  // namespace internal
+
+template <typename Fn>
+class CpuDispatch {
+ public:
+  CpuDispatch(std::string kernel, Fn portable) : kernel_(std::move(kernel)) {
+    Add(kIsaPortable, portable);
+  }
+
+  // an implementation needing isa, preferred over those added before it.
+  CpuDispatch& Add(uint32_t isa, Fn fn) {
+    impls_.emplace_back(isa, fn);
+    return *this;
+  }
+
+  // the last added implementation the cpu supports.
+  Fn Bind() const {
+    for (auto it = impls_.rbegin(); it != impls_.rend(); ++it) {
+      if (CpuSupports(it->first)) {
+        internal::RecordKernelBinding(kernel_, it->first);
+        return it->second;
+      }
+    }
+    // unreachable, the portable one is always supported.
+    return impls_.front().second;
+  }
+
+ private:
+  const std::string kernel_;
+  std::vector<std::pair<uint32_t, Fn>> impls_;
+};
+
+}  // namespace yasl
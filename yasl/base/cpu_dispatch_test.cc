@@ -0,0 +1,63 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "yasl/base/cpu_dispatch.h"
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl {
+namespace {
+
+int Portable() { return 0; }
+int Avx2() { return 2; }
+int Avx512() { return 512; }
+int Unsupported() { return -1; }
+
+}  // namespace
+
+TEST(CpuDispatchTest, Names) {
+  EXPECT_EQ(CpuIsaToString(kIsaPortable), "portable");
+  EXPECT_EQ(CpuIsaToString(kIsaAvx2 | kIsaAvx512f), "avx2,avx512f");
+  EXPECT_EQ(ParseCpuIsa("avx512f, avx2"), kIsaAvx2 | kIsaAvx512f);
+  EXPECT_EQ(ParseCpuIsa(""), kIsaPortable);
+  EXPECT_EQ(ParseCpuIsa("portable"), kIsaPortable);
+  EXPECT_EQ(ParseCpuIsa(CpuIsaToString(GetCpuIsa())), GetCpuIsa());
+  EXPECT_THROW(ParseCpuIsa("avx3"), EnforceNotMet);
+}
+
+TEST(CpuDispatchTest, BindsBestSupported) {
+  EXPECT_TRUE(CpuSupports(kIsaPortable));
+
+  using Fn = int (*)();
+  // an impl needing every instruction set is never supported.
+  CpuDispatch<Fn> dispatch("test.kernel", Portable);
+  dispatch.Add(kIsaAvx2, Avx2)
+      .Add(kIsaAvx512f, Avx512)
+      .Add(~uint32_t{0}, Unsupported);
+  const int bound = dispatch.Bind()();
+
+  if (CpuSupports(kIsaAvx512f)) {
+    EXPECT_EQ(bound, 512);
+  } else if (CpuSupports(kIsaAvx2)) {
+    EXPECT_EQ(bound, 2);
+  } else {
+    EXPECT_EQ(bound, 0);
+  }
+  const auto bindings = ListKernelBindings();
+  ASSERT_EQ(bindings.count("test.kernel"), 1);
+  EXPECT_NE(bindings.at("test.kernel"), "");
+}
+
+}  // namespace yasl
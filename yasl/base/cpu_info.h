@@ -0,0 +1,27 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// Brief: the features of the cpu, probed once per process. Kernels pick
+// their simd paths from it instead of running cpuid each, which also adds to
+// the startup of short lived processes.
+
+#pragma once
+
+#include "cpu_features/cpuinfo_x86.h"
+
+namespace yasl {
+
+// probed on first use, thread safe.
+const cpu_features::X86Features& GetCpuFeatures();
+
+}  // namespace yasl
@@ -0,0 +1,30 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "yasl/base/cpu_info.h"
+
+#include "gtest/gtest.h"
+
+namespace yasl {
+
+TEST(CpuInfoTest, ProbedOnce) {
+  const auto& features = GetCpuFeatures();
+  EXPECT_EQ(&features, &GetCpuFeatures());
+
+  const auto probed = cpu_features::GetX86Info().features;
+  EXPECT_EQ(features.aes, probed.aes);
+  EXPECT_EQ(features.avx2, probed.avx2);
+  EXPECT_EQ(features.avx512f, probed.avx512f);
+}
+
+}  // namespace yasl
@@ -18,6 +18,8 @@
 #include <array>
 #include <exception>
 
+#include "absl/base/attributes.h"
+#include "absl/base/optimization.h"
 #include "absl/debugging/stacktrace.h"
 #include "absl/debugging/symbolize.h"
 #include "absl/strings/str_join.h"
@@ -142,58 +144,57 @@ using stacktrace_t = std::array<void*, ::yasl::internal::kMaxStackTraceDep>;
 //   ...
 // }
 //
-#define YASL_THROW(...)                                                    \
-  do {                                                                     \
-    ::yasl::stacktrace_t stacks;                                           \
-    int dep = absl::GetStackTrace(stacks.data(),                           \
-                                  ::yasl::internal::kMaxStackTraceDep, 0); \
-    throw ::yasl::RuntimeError(YASL_ERROR_MSG(__VA_ARGS__), stacks.data(), \
-                               dep);                                       \
-  } while (false)
+#define YASL_THROW(...) YASL_THROW_AS(::yasl::RuntimeError, __VA_ARGS__)
 
-#define YASL_THROW_LOGIC_ERROR(...)                                            \
-  do {                                                                         \
-    ::yasl::stacktrace_t stacks;                                               \
-    int dep = absl::GetStackTrace(stacks.data(),                               \
-                                  ::yasl::internal::kMaxStackTraceDep, 0);     \
-    throw ::yasl::LogicError(YASL_ERROR_MSG(__VA_ARGS__), stacks.data(), dep); \
-  } while (false)
+#define YASL_THROW_LOGIC_ERROR(...) \
+  YASL_THROW_AS(::yasl::LogicError, __VA_ARGS__)
 
-#define YASL_THROW_IO_ERROR(...)                                            \
-  do {                                                                      \
-    ::yasl::stacktrace_t stacks;                                            \
-    int dep = absl::GetStackTrace(stacks.data(),                            \
-                                  ::yasl::internal::kMaxStackTraceDep, 0);  \
-    throw ::yasl::IoError(YASL_ERROR_MSG(__VA_ARGS__), stacks.data(), dep); \
-  } while (false)
+#define YASL_THROW_IO_ERROR(...) YASL_THROW_AS(::yasl::IoError, __VA_ARGS__)
 
-#define YASL_THROW_NETWORK_ERROR(...)                                      \
-  do {                                                                     \
-    ::yasl::stacktrace_t stacks;                                           \
-    int dep = absl::GetStackTrace(stacks.data(),                           \
-                                  ::yasl::internal::kMaxStackTraceDep, 0); \
-    throw ::yasl::NetworkError(YASL_ERROR_MSG(__VA_ARGS__), stacks.data(), \
-                               dep);                                       \
-  } while (false)
+#define YASL_THROW_NETWORK_ERROR(...) \
+  YASL_THROW_AS(::yasl::NetworkError, __VA_ARGS__)
 
-#define YASL_THROW_INVALID_FORMAT(...)                                      \
-  do {                                                                      \
-    ::yasl::stacktrace_t stacks;                                            \
-    int dep = absl::GetStackTrace(stacks.data(),                            \
-                                  ::yasl::internal::kMaxStackTraceDep, 0);  \
-    throw ::yasl::InvalidFormat(YASL_ERROR_MSG(__VA_ARGS__), stacks.data(), \
-                                dep);                                       \
-  } while (false)
+#define YASL_THROW_INVALID_FORMAT(...) \
+  YASL_THROW_AS(::yasl::InvalidFormat, __VA_ARGS__)
+
+#define YASL_THROW_ARGUMENT_ERROR(...) \
+  YASL_THROW_AS(::yasl::ArgumentError, __VA_ARGS__)
 
-#define YASL_THROW_ARGUMENT_ERROR(...)                                      \
-  do {                                                                      \
-    ::yasl::stacktrace_t stacks;                                            \
-    int dep = absl::GetStackTrace(stacks.data(),                            \
-                                  ::yasl::internal::kMaxStackTraceDep, 0);  \
-    throw ::yasl::ArgumentError(YASL_ERROR_MSG(__VA_ARGS__), stacks.data(), \
-                                dep);                                       \
+// throws an exception of type, which is constructible like RuntimeError.
+#define YASL_THROW_AS(type, ...)                                      \
+  do {                                                                \
+    ::yasl::internal::Thrower<type>(__FILE__, __LINE__)(__VA_ARGS__); \
   } while (false)
 
+namespace internal {
+
+// the throwing half of the macros, out of line and cold, so that a check
+// inlines to a compare and a call. the message is formatted and the stack
+// walked only once it throws.
+// constructed with parentheses, as the macros may be arguments of macros.
+template <typename E>
+class Thrower {
+ public:
+  Thrower(const char* file, int line) : file_(file), line_(line) {}
+
+  template <typename... Args>
+  [[noreturn]] ABSL_ATTRIBUTE_NOINLINE ABSL_ATTRIBUTE_COLD void operator()(
+      Args&&... args) const {
+    stacktrace_t stacks;
+    // skips this frame.
+    int dep = absl::GetStackTrace(stacks.data(), kMaxStackTraceDep, 1);
+    throw E(fmt::format("[{}:{}] {}", file_, line_,
+                        fmt::format(std::forward<Args>(args)...)),
+            stacks.data(), dep);
+  }
+
+ private:
+  const char* file_;
+  int line_;
+};
+
+}  // namespace internal
+
 // For Status.
 #define CHECK_OR_THROW(statement) \
   do {                            \
@@ -243,16 +244,37 @@ class EnforceNotMet : public Exception {
   std::string full_msg_;
 };
 
-#define YASL_ENFORCE(condition, ...)                                         \
-  do {                                                                       \
-    if (!(condition)) {                                                      \
-      ::yasl::stacktrace_t stacks;                                           \
-      int dep = absl::GetStackTrace(stacks.data(),                           \
-                                    ::yasl::internal::kMaxStackTraceDep, 0); \
-      throw ::yasl::EnforceNotMet(__FILE__, __LINE__, #condition,            \
-                                  ::yasl::internal::Format(__VA_ARGS__),     \
-                                  stacks.data(), dep);                       \
-    }                                                                        \
+namespace internal {
+
+class EnforceThrower {
+ public:
+  EnforceThrower(const char* file, int line, const char* condition)
+      : file_(file), line_(line), condition_(condition) {}
+
+  template <typename... Args>
+  [[noreturn]] ABSL_ATTRIBUTE_NOINLINE ABSL_ATTRIBUTE_COLD void operator()(
+      Args&&... args) const {
+    stacktrace_t stacks;
+    int dep = absl::GetStackTrace(stacks.data(), kMaxStackTraceDep, 1);
+    throw EnforceNotMet(file_, line_, condition_,
+                        Format(std::forward<Args>(args)...), stacks.data(),
+                        dep);
+  }
+
+ private:
+  const char* file_;
+  int line_;
+  const char* condition_;
+};
+
+}  // namespace internal
+
+#define YASL_ENFORCE(condition, ...)                                   \
+  do {                                                                 \
+    if (ABSL_PREDICT_FALSE(!(condition))) {                            \
+      ::yasl::internal::EnforceThrower(__FILE__, __LINE__, #condition)( \
+          __VA_ARGS__);                                                \
+    }                                                                  \
   } while (false)
 
 /**
@@ -323,13 +345,19 @@ class EnforceFailMessage {
   std::string* msg_;
 };
 
+template <typename T1, typename T2>
+ABSL_ATTRIBUTE_NOINLINE ABSL_ATTRIBUTE_COLD EnforceFailMessage
+FormatComparison(const T1& x, const T2& y) {
+  return fmt::format("{} vs {}", x, y);
+}
+
 #define BINARY_COMP_HELPER(name, op)                         \
   template <typename T1, typename T2>                        \
   inline EnforceFailMessage name(const T1& x, const T2& y) { \
-    if (x op y) {                                            \
+    if (ABSL_PREDICT_TRUE(x op y)) {                         \
       return EnforceOK();                                    \
     }                                                        \
-    return fmt::format("{} vs {}", x, y);                    \
+    return FormatComparison(x, y);                           \
   }
 BINARY_COMP_HELPER(Equals, ==)
 BINARY_COMP_HELPER(NotEquals, !=)
@@ -339,14 +367,34 @@ BINARY_COMP_HELPER(Less, <)
 BINARY_COMP_HELPER(LessEquals, <=)
 #undef BINARY_COMP_HELPER
 
-#define YASL_ENFORCE_THAT_IMPL(condition, expr, ...)                   \
-  do {                                                                 \
-    ::yasl::enforce_detail::EnforceFailMessage r(condition);           \
-    if (r.Bad()) {                                                     \
-      throw ::yasl::EnforceNotMet(                                     \
-          __FILE__, __LINE__, expr,                                    \
-          r.GetMessageAndFree(::yasl::internal::Format(__VA_ARGS__))); \
-    }                                                                  \
+class EnforceThatThrower {
+ public:
+  EnforceThatThrower(const char* file, int line, const char* expr,
+                     EnforceFailMessage* message)
+      : file_(file), line_(line), expr_(expr), message_(message) {}
+
+  template <typename... Args>
+  [[noreturn]] ABSL_ATTRIBUTE_NOINLINE ABSL_ATTRIBUTE_COLD void operator()(
+      Args&&... args) const {
+    throw EnforceNotMet(file_, line_, expr_,
+                        message_->GetMessageAndFree(::yasl::internal::Format(
+                            std::forward<Args>(args)...)));
+  }
+
+ private:
+  const char* file_;
+  int line_;
+  const char* expr_;
+  EnforceFailMessage* message_;
+};
+
+#define YASL_ENFORCE_THAT_IMPL(condition, expr, ...)                       \
+  do {                                                                     \
+    ::yasl::enforce_detail::EnforceFailMessage r(condition);               \
+    if (ABSL_PREDICT_FALSE(r.Bad())) {                                     \
+      ::yasl::enforce_detail::EnforceThatThrower(__FILE__, __LINE__, expr, \
+                                                 &r)(__VA_ARGS__);         \
+    }                                                                      \
   } while (false)
 }  // namespace enforce_detail
 
@@ -372,6 +420,35 @@ BINARY_COMP_HELPER(LessEquals, <=)
   YASL_ENFORCE_THAT_IMPL(::yasl::enforce_detail::Greater((x), (y)), \
                          #x " > " #y, __VA_ARGS__)
 
+// checks of debug builds only, for hot paths such as per element accessors.
+// with NDEBUG they are compiled, so their arguments stay valid code, but
+// never evaluated.
+#ifdef NDEBUG
+#define YASL_DEBUG_ONLY(statement) \
+  do {                             \
+    if (false) {                   \
+      statement;                   \
+    }                              \
+  } while (false)
+#else
+#define YASL_DEBUG_ONLY(statement) statement
+#endif
+
+#define YASL_DEBUG_ENFORCE(condition, ...) \
+  YASL_DEBUG_ONLY(YASL_ENFORCE(condition, __VA_ARGS__))
+#define YASL_DEBUG_ENFORCE_EQ(x, y, ...) \
+  YASL_DEBUG_ONLY(YASL_ENFORCE_EQ(x, y, __VA_ARGS__))
+#define YASL_DEBUG_ENFORCE_NE(x, y, ...) \
+  YASL_DEBUG_ONLY(YASL_ENFORCE_NE(x, y, __VA_ARGS__))
+#define YASL_DEBUG_ENFORCE_LE(x, y, ...) \
+  YASL_DEBUG_ONLY(YASL_ENFORCE_LE(x, y, __VA_ARGS__))
+#define YASL_DEBUG_ENFORCE_LT(x, y, ...) \
+  YASL_DEBUG_ONLY(YASL_ENFORCE_LT(x, y, __VA_ARGS__))
+#define YASL_DEBUG_ENFORCE_GE(x, y, ...) \
+  YASL_DEBUG_ONLY(YASL_ENFORCE_GE(x, y, __VA_ARGS__))
+#define YASL_DEBUG_ENFORCE_GT(x, y, ...) \
+  YASL_DEBUG_ONLY(YASL_ENFORCE_GT(x, y, __VA_ARGS__))
+
 template <typename T, std::enable_if_t<std::is_pointer<T>::value, int> = 0>
 T CheckNotNull(T t) {
   YASL_ENFORCE(t != nullptr);
@@ -122,4 +122,36 @@ TEST(Exception, Compares) {
   ASSERT_NO_THROW(YASL_ENFORCE_GT(1, 0));
 }
 
+TEST(Exception, ThrowTypes) {
+  ASSERT_THROW(YASL_THROW_IO_ERROR("io"), IoError);
+  ASSERT_THROW(YASL_THROW_INVALID_FORMAT("format {}", 1), InvalidFormat);
+  ASSERT_THROW(YASL_THROW_ARGUMENT_ERROR("argument"), ArgumentError);
+  ASSERT_THROW(YASL_THROW_AS(LogicError, "logic"), LogicError);
+}
+
+TEST(Exception, EnforceEvaluatesArgsOnFailure) {
+  int evaluated = 0;
+  auto arg = [&] { return ++evaluated; };
+  YASL_ENFORCE(true, "{}", arg());
+  YASL_ENFORCE_EQ(1, 1, "{}", arg());
+  EXPECT_EQ(evaluated, 0);
+  EXPECT_THROW(YASL_ENFORCE(false, "{}", arg()), EnforceNotMet);
+  EXPECT_EQ(evaluated, 1);
+}
+
+TEST(Exception, DebugEnforce) {
+  int evaluated = 0;
+  auto check = [&] { return ++evaluated < 0; };
+#ifdef NDEBUG
+  ASSERT_NO_THROW(YASL_DEBUG_ENFORCE(check()));
+  ASSERT_NO_THROW(YASL_DEBUG_ENFORCE_LT(1, 0));
+  EXPECT_EQ(evaluated, 0);
+#else
+  ASSERT_THROW(YASL_DEBUG_ENFORCE(check(), "{}", 1), EnforceNotMet);
+  ASSERT_THROW(YASL_DEBUG_ENFORCE_LT(1, 0), EnforceNotMet);
+  EXPECT_EQ(evaluated, 1);
+#endif
+  ASSERT_NO_THROW(YASL_DEBUG_ENFORCE_LE(0, 1));
+}
+
 }  // namespace yasl
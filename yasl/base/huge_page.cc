@@ -0,0 +1,138 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/base/huge_page.h"
+
+#include <sys/mman.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+#include "yasl/base/exception.h"
+#include "yasl/base/memory_tracker.h"
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+namespace yasl {
+
+namespace {
+
+constexpr size_t kGiantPageSize = size_t{1} << 30;
+
+size_t RoundUp(size_t size, size_t page) {
+  return (size + page - 1) / page * page;
+}
+
+// 1 GiB pages once they waste at most 1/8 of the block. decided on whole
+// 2 MiB pages, so that HugePageCapacity(HugePageCapacity(size)) is the same.
+bool UseGiantPages(size_t size) {
+  const size_t pages = RoundUp(size, kHugePageSize);
+  return GetHugePageMode() == HugePageMode::kHugetlb &&
+         pages >= kGiantPageSize &&
+         RoundUp(pages, kGiantPageSize) - pages <= pages / 8;
+}
+
+MemoryTag* HugePageTag() {
+  static auto* tag = MemoryTag::Get("huge_page");
+  return tag;
+}
+
+void* MapAnonymous(size_t size, int flags) {
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+  return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+// plain pages aligned to kHugePageSize, advised to be huge ones.
+void* MapTransparent(size_t capacity) {
+  auto* raw =
+      static_cast<std::byte*>(MapAnonymous(capacity + kHugePageSize, 0));
+  if (raw == nullptr) {
+    throw std::bad_alloc();
+  }
+  const size_t head =
+      RoundUp(reinterpret_cast<uintptr_t>(raw), kHugePageSize) -
+      reinterpret_cast<uintptr_t>(raw);
+  if (head > 0) {
+    munmap(raw, head);
+  }
+  auto* ptr = raw + head;
+  if (kHugePageSize - head > 0) {
+    munmap(ptr + capacity, kHugePageSize - head);
+  }
+  // fails where thp is disabled, plain pages then.
+  madvise(ptr, capacity, MADV_HUGEPAGE);
+  return ptr;
+}
+
+}  // namespace
+
+HugePageMode GetHugePageMode() {
+  static const HugePageMode mode = [] {
+    const char* env = std::getenv("YASL_HUGE_PAGES");
+    const std::string_view name =
+        env == nullptr || *env == '\0' ? "thp" : env;
+    if (name == "off") {
+      return HugePageMode::kOff;
+    }
+    if (name == "thp") {
+      return HugePageMode::kTransparent;
+    }
+    YASL_ENFORCE(name == "hugetlb", "unknown YASL_HUGE_PAGES={}", name);
+    return HugePageMode::kHugetlb;
+  }();
+  return mode;
+}
+
+size_t HugePageCapacity(size_t size) {
+  return RoundUp(size, UseGiantPages(size) ? kGiantPageSize : kHugePageSize);
+}
+
+void* MapHugePages(size_t size) {
+  const size_t capacity = HugePageCapacity(size);
+  void* ptr = nullptr;
+  if (GetHugePageMode() == HugePageMode::kHugetlb) {
+    if (UseGiantPages(size)) {
+      ptr = MapAnonymous(capacity, MAP_HUGETLB | MAP_HUGE_1GB);
+    }
+    if (ptr == nullptr) {
+      ptr = MapAnonymous(capacity, MAP_HUGETLB | MAP_HUGE_2MB);
+    }
+  }
+  if (ptr == nullptr) {
+    ptr = MapTransparent(capacity);
+  }
+  HugePageTag()->Add(capacity);
+  return ptr;
+}
+
+void UnmapHugePages(void* ptr, size_t size) {
+  if (ptr == nullptr) {
+    return;
+  }
+  const size_t capacity = HugePageCapacity(size);
+  HugePageTag()->Add(-static_cast<int64_t>(capacity));
+  munmap(ptr, capacity);
+}
+
+}  // namespace yasl
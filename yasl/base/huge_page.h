@@ -0,0 +1,97 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Brief: huge page backed memory of large arrays. OT matrices and dpf
+// outputs run to GBs, which 4 KiB pages spread over more tlb entries than a
+// core has.
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace yasl {
+
+// by env YASL_HUGE_PAGES, read once:
+//   "off":     plain pages.
+//   "thp":     madvise(MADV_HUGEPAGE) of 2 MiB aligned mappings, the default.
+//              a hint, the kernel may still back them by 4 KiB pages.
+//   "hugetlb": mmap(MAP_HUGETLB) of the reserved pool, 1 GiB pages for
+//              blocks of GBs. falls back to "thp" once the pool runs out.
+enum class HugePageMode { kOff, kTransparent, kHugetlb };
+
+HugePageMode GetHugePageMode();
+
+// smaller blocks stay on the heap, a huge page of them would be mostly
+// waste.
+inline constexpr size_t kHugePageThreshold = size_t{32} << 20;
+inline constexpr size_t kHugePageSize = size_t{2} << 20;
+
+// whether a block of size bytes is mapped by MapHugePages. depends on size
+// only, so a block is freed the way it was allocated.
+inline bool UseHugePages(size_t size) {
+  return size >= kHugePageThreshold && GetHugePageMode() != HugePageMode::kOff;
+}
+
+// size rounded up to the pages MapHugePages takes for it, the capacity of a
+// block maps to itself.
+size_t HugePageCapacity(size_t size);
+
+// maps HugePageCapacity(size) bytes, aligned to kHugePageSize. throws
+// std::bad_alloc if even plain pages are out.
+void* MapHugePages(size_t size);
+
+// size is the one given to MapHugePages or its capacity.
+void UnmapHugePages(void* ptr, size_t size);
+
+// a std allocator taking huge pages for blocks of UseHugePages.
+template <typename T>
+class HugePageAllocator {
+ public:
+  using value_type = T;
+
+  HugePageAllocator() = default;
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    if (UseHugePages(n * sizeof(T))) {
+      return static_cast<T*>(MapHugePages(n * sizeof(T)));
+    }
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    if (UseHugePages(n * sizeof(T))) {
+      UnmapHugePages(ptr, n * sizeof(T));
+      return;
+    }
+    std::allocator<T>().deallocate(ptr, n);
+  }
+
+  template <typename U>
+  bool operator==(const HugePageAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const HugePageAllocator<U>&) const {
+    return false;
+  }
+};
+
+template <typename T>
+using HugePageVector = std::vector<T, HugePageAllocator<T>>;
+
+}  // namespace yasl
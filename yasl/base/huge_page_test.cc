@@ -0,0 +1,72 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/base/huge_page.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/memory_tracker.h"
+
+namespace yasl {
+
+TEST(HugePageTest, SmallBlocksStayOnHeap) {
+  EXPECT_FALSE(UseHugePages(kHugePageThreshold - 1));
+  EXPECT_EQ(UseHugePages(kHugePageThreshold),
+            GetHugePageMode() != HugePageMode::kOff);
+}
+
+TEST(HugePageTest, MapAndUnmap) {
+  auto* tag = MemoryTag::Get("huge_page");
+  const int64_t live = tag->live_bytes();
+
+  const size_t size = kHugePageThreshold + 100;
+  EXPECT_EQ(HugePageCapacity(size), kHugePageThreshold + kHugePageSize);
+  auto* ptr = static_cast<uint8_t*>(MapHugePages(size));
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % kHugePageSize, 0);
+  EXPECT_EQ(tag->live_bytes(), live + HugePageCapacity(size));
+  std::memset(ptr, 0xab, size);
+  EXPECT_EQ(ptr[size - 1], 0xab);
+
+  UnmapHugePages(ptr, size);
+  EXPECT_EQ(tag->live_bytes(), live);
+}
+
+TEST(HugePageTest, Vector) {
+  HugePageVector<uint64_t> small(16, 7);
+  EXPECT_EQ(small[15], 7);
+
+  const size_t n = kHugePageThreshold / sizeof(uint64_t) + 1;
+  HugePageVector<uint64_t> large(n);
+  for (size_t i = 0; i + 1 < n; i += 4096) {
+    large[i] = i;
+  }
+  EXPECT_EQ(large[n - 1], 0);
+  if (UseHugePages(n * sizeof(uint64_t))) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(large.data()) % kHugePageSize, 0);
+  }
+
+  large.resize(2 * n);
+  EXPECT_EQ(large[4096], 4096);
+  large.erase(large.begin(), large.begin() + n);
+  EXPECT_EQ(large.size(), n);
+  large.shrink_to_fit();
+  small = HugePageVector<uint64_t>(large.begin(), large.begin() + 16);
+  EXPECT_EQ(small[0], 0);
+}
+
+}  // namespace yasl
@@ -18,10 +18,12 @@
 #endif
 
 #include <random>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 
 #include "yasl/base/int128.h"
+#include "yasl/base/int128_vec.h"
 
 namespace {
 
@@ -64,6 +66,60 @@ void BM_BMI2_Mul6464_128(benchmark::State& state) {
 }
 #endif
 
+std::vector<uint128_t> GetRandomVec(size_t n) {
+  std::vector<uint128_t> vec;
+  vec.reserve(n);
+  for (const auto& pair : GetRandomSamples(n)) {
+    vec.push_back(yasl::MakeUint128(pair.first, pair.second));
+  }
+  return vec;
+}
+
+enum class VecOp { kAdd, kSub, kMul, kArshift };
+
+// element-wise loops the compiler is left to vectorize.
+template <VecOp kOp>
+void BM_ScalarVec(benchmark::State& state) {
+  const auto x = GetRandomVec(state.range(0));
+  const auto y = GetRandomVec(state.range(0));
+  std::vector<uint128_t> out(x.size());
+  while (state.KeepRunningBatch(x.size())) {
+    for (size_t i = 0; i < x.size(); ++i) {
+      if constexpr (kOp == VecOp::kAdd) {
+        out[i] = x[i] + y[i];
+      } else if constexpr (kOp == VecOp::kSub) {
+        out[i] = x[i] - y[i];
+      } else if constexpr (kOp == VecOp::kMul) {
+        out[i] = x[i] * y[i];
+      } else {
+        out[i] = static_cast<uint128_t>(static_cast<int128_t>(x[i]) >> 13);
+      }
+    }
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+}
+
+template <VecOp kOp>
+void BM_Int128Vec(benchmark::State& state) {
+  const auto x = GetRandomVec(state.range(0));
+  const auto y = GetRandomVec(state.range(0));
+  std::vector<uint128_t> out(x.size());
+  while (state.KeepRunningBatch(x.size())) {
+    if constexpr (kOp == VecOp::kAdd) {
+      yasl::Int128VecAdd(x, y, absl::MakeSpan(out));
+    } else if constexpr (kOp == VecOp::kSub) {
+      yasl::Int128VecSub(x, y, absl::MakeSpan(out));
+    } else if constexpr (kOp == VecOp::kMul) {
+      yasl::Int128VecMul(x, y, absl::MakeSpan(out));
+    } else {
+      yasl::Int128VecArshift(x, 13, absl::MakeSpan(out));
+    }
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+}
+
 }  // namespace
 
 #ifdef YASL_ENABLE_BMI2
@@ -72,4 +128,14 @@ BENCHMARK(BM_BMI2_Mul6464_128);
 
 BENCHMARK(BM_Mul6464_128);
 
+// from L1 to memory.
+BENCHMARK_TEMPLATE(BM_ScalarVec, VecOp::kAdd)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Int128Vec, VecOp::kAdd)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_ScalarVec, VecOp::kSub)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Int128Vec, VecOp::kSub)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_ScalarVec, VecOp::kMul)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Int128Vec, VecOp::kMul)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_ScalarVec, VecOp::kArshift)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Int128Vec, VecOp::kArshift)->Range(1 << 10, 1 << 22);
+
 BENCHMARK_MAIN();
\ No newline at end of file
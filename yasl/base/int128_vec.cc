@@ -0,0 +1,295 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/base/int128_vec.h"
+
+#include <cstdint>
+
+#include "yasl/base/cpu_dispatch.h"
+#include "yasl/base/exception.h"
+
+#ifdef __x86_64
+#include <immintrin.h>
+#endif
+
+namespace yasl {
+
+namespace {
+
+enum class Shift { kLeft, kRight, kArith };
+
+// x is null for zero, as in Neg.
+using AddSubFn = void (*)(const uint128_t* x, const uint128_t* y,
+                          uint128_t* out, size_t n);
+using MulFn = void (*)(const uint128_t* x, const uint128_t* y, uint128_t* out,
+                       size_t n);
+using ShiftFn = void (*)(const uint128_t* x, size_t bits, uint128_t* out,
+                         size_t n);
+
+template <bool kSub>
+void AddSubScalar(const uint128_t* x, const uint128_t* y, uint128_t* out,
+                  size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    const uint128_t a = x == nullptr ? 0 : x[i];
+    out[i] = kSub ? a - y[i] : a + y[i];
+  }
+}
+
+void MulScalar(const uint128_t* x, const uint128_t* y, uint128_t* out,
+               size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = x[i] * y[i];
+  }
+}
+
+template <Shift kShift>
+void ShiftScalar(const uint128_t* x, size_t bits, uint128_t* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    if constexpr (kShift == Shift::kLeft) {
+      out[i] = x[i] << bits;
+    } else if constexpr (kShift == Shift::kRight) {
+      out[i] = x[i] >> bits;
+    } else {
+      out[i] = static_cast<uint128_t>(static_cast<int128_t>(x[i]) >> bits);
+    }
+  }
+}
+
+#ifdef __x86_64
+// the 64-bit lanes of the high halves.
+constexpr __mmask8 kHighLanes = 0xaa;
+
+template <bool kSub>
+__attribute__((target("avx512f"))) void AddSubAvx512(const uint128_t* x,
+                                                     const uint128_t* y,
+                                                     uint128_t* out,
+                                                     size_t n) {
+  const __m512i one = _mm512_set1_epi64(1);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m512i a =
+        x == nullptr ? _mm512_setzero_si512() : _mm512_loadu_si512(x + i);
+    const __m512i b = _mm512_loadu_si512(y + i);
+    __m512i r;
+    __mmask8 carry;
+    if constexpr (kSub) {
+      r = _mm512_sub_epi64(a, b);
+      carry = _mm512_cmplt_epu64_mask(a, b);
+    } else {
+      r = _mm512_add_epi64(a, b);
+      carry = _mm512_cmplt_epu64_mask(r, a);
+    }
+    // the carries of the low halves go to the high ones.
+    carry = static_cast<__mmask8>((carry << 1) & kHighLanes);
+    r = kSub ? _mm512_mask_sub_epi64(r, carry, r, one)
+             : _mm512_mask_add_epi64(r, carry, r, one);
+    _mm512_storeu_si512(out + i, r);
+  }
+  AddSubScalar<kSub>(x == nullptr ? nullptr : x + i, y + i, out + i, n - i);
+}
+
+// unsigned a < b on 64-bit lanes, by flipping the sign bits.
+__attribute__((target("avx2"))) inline __m256i LessThan(__m256i a, __m256i b) {
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  return _mm256_cmpgt_epi64(_mm256_xor_si256(b, sign),
+                            _mm256_xor_si256(a, sign));
+}
+
+template <bool kSub>
+__attribute__((target("avx2"))) void AddSubAvx2(const uint128_t* x,
+                                                const uint128_t* y,
+                                                uint128_t* out, size_t n) {
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    const __m256i a =
+        x == nullptr
+            ? _mm256_setzero_si256()
+            : _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+    const __m256i b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+    __m256i r;
+    __m256i carry;
+    if constexpr (kSub) {
+      r = _mm256_sub_epi64(a, b);
+      carry = LessThan(a, b);
+    } else {
+      r = _mm256_add_epi64(a, b);
+      carry = LessThan(r, a);
+    }
+    // all ones masks of the low halves moved to the high ones, -1 per carry.
+    carry = _mm256_slli_si256(carry, 8);
+    r = kSub ? _mm256_add_epi64(r, carry) : _mm256_sub_epi64(r, carry);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+  }
+  AddSubScalar<kSub>(x == nullptr ? nullptr : x + i, y + i, out + i, n - i);
+}
+
+// the same loop, where the compiler emits mulx for the low product.
+__attribute__((target("bmi2"))) void MulBmi2(const uint128_t* x,
+                                             const uint128_t* y,
+                                             uint128_t* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = x[i] * y[i];
+  }
+}
+
+// the zero masked forms, as gcc warns on the undefined sources of the plain
+// ones.
+__attribute__((target("avx512f"))) inline __m512i Sll(__m512i v, __m128i s) {
+  return _mm512_maskz_sll_epi64(0xff, v, s);
+}
+
+__attribute__((target("avx512f"))) inline __m512i Srl(__m512i v, __m128i s) {
+  return _mm512_maskz_srl_epi64(0xff, v, s);
+}
+
+__attribute__((target("avx512f"))) inline __m512i Sra(__m512i v, __m128i s) {
+  return _mm512_maskz_sra_epi64(0xff, v, s);
+}
+
+// the low halves of t moved to the high lanes, the rest zero.
+__attribute__((target("avx512f"))) inline __m512i ToHigh(__m512i t) {
+  return _mm512_maskz_shuffle_epi32(0xcccc, t,
+                                    static_cast<_MM_PERM_ENUM>(0x4e));
+}
+
+__attribute__((target("avx512f"))) inline __m512i ToLow(__m512i t) {
+  return _mm512_maskz_shuffle_epi32(0x3333, t,
+                                    static_cast<_MM_PERM_ENUM>(0x4e));
+}
+
+template <Shift kShift>
+__attribute__((target("avx512f"))) void ShiftAvx512(const uint128_t* x,
+                                                    size_t bits,
+                                                    uint128_t* out, size_t n) {
+  const bool wide = bits >= 64;
+  const __m128i s = _mm_cvtsi64_si128(wide ? bits - 64 : bits);
+  // the bits crossing the halves, none for a shift by 0.
+  const __m128i spill = _mm_cvtsi64_si128(64 - bits);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m512i v = _mm512_loadu_si512(x + i);
+    __m512i r;
+    if constexpr (kShift == Shift::kLeft) {
+      r = wide ? ToHigh(Sll(v, s))
+               : _mm512_or_si512(Sll(v, s), ToHigh(Srl(v, spill)));
+    } else if constexpr (kShift == Shift::kRight) {
+      r = wide ? ToLow(Srl(v, s))
+               : _mm512_or_si512(Srl(v, s), ToLow(Sll(v, spill)));
+    } else {
+      if (wide) {
+        r = _mm512_mask_blend_epi64(kHighLanes, ToLow(Sra(v, s)),
+                                    Sra(v, _mm_cvtsi64_si128(63)));
+      } else {
+        const __m512i shifted =
+            _mm512_mask_sra_epi64(Srl(v, s), kHighLanes, v, s);
+        r = _mm512_or_si512(shifted, ToLow(Sll(v, spill)));
+      }
+    }
+    _mm512_storeu_si512(out + i, r);
+  }
+  ShiftScalar<kShift>(x + i, bits, out + i, n - i);
+}
+#endif
+
+template <bool kSub>
+AddSubFn SelectAddSub() {
+  CpuDispatch<AddSubFn> dispatch(kSub ? "int128_vec.sub" : "int128_vec.add",
+                                 AddSubScalar<kSub>);
+#ifdef __x86_64
+  dispatch.Add(kIsaAvx2, AddSubAvx2<kSub>)
+      .Add(kIsaAvx512f, AddSubAvx512<kSub>);
+#endif
+  return dispatch.Bind();
+}
+
+MulFn SelectMul() {
+  CpuDispatch<MulFn> dispatch("int128_vec.mul", MulScalar);
+#ifdef __x86_64
+  dispatch.Add(kIsaBmi2, MulBmi2);
+#endif
+  return dispatch.Bind();
+}
+
+template <Shift kShift>
+ShiftFn SelectShift() {
+  constexpr const char* kNames[] = {"int128_vec.shl", "int128_vec.shr",
+                                    "int128_vec.sar"};
+  CpuDispatch<ShiftFn> dispatch(kNames[static_cast<int>(kShift)],
+                                ShiftScalar<kShift>);
+#ifdef __x86_64
+  dispatch.Add(kIsaAvx512f, ShiftAvx512<kShift>);
+#endif
+  return dispatch.Bind();
+}
+
+template <bool kSub>
+void AddSub(const uint128_t* x, absl::Span<const uint128_t> y,
+            absl::Span<uint128_t> out) {
+  static const AddSubFn add_sub = SelectAddSub<kSub>();
+  YASL_ENFORCE_EQ(y.size(), out.size());
+  add_sub(x, y.data(), out.data(), out.size());
+}
+
+template <Shift kShift>
+void ShiftBy(absl::Span<const uint128_t> x, size_t bits,
+             absl::Span<uint128_t> out) {
+  static const ShiftFn shift = SelectShift<kShift>();
+  YASL_ENFORCE_EQ(x.size(), out.size());
+  YASL_ENFORCE_LT(bits, 128u);
+  shift(x.data(), bits, out.data(), out.size());
+}
+
+}  // namespace
+
+void Int128VecAdd(absl::Span<const uint128_t> x, absl::Span<const uint128_t> y,
+                  absl::Span<uint128_t> out) {
+  YASL_ENFORCE_EQ(x.size(), y.size());
+  AddSub<false>(x.data(), y, out);
+}
+
+void Int128VecSub(absl::Span<const uint128_t> x, absl::Span<const uint128_t> y,
+                  absl::Span<uint128_t> out) {
+  YASL_ENFORCE_EQ(x.size(), y.size());
+  AddSub<true>(x.data(), y, out);
+}
+
+void Int128VecNeg(absl::Span<const uint128_t> x, absl::Span<uint128_t> out) {
+  AddSub<true>(nullptr, x, out);
+}
+
+void Int128VecMul(absl::Span<const uint128_t> x, absl::Span<const uint128_t> y,
+                  absl::Span<uint128_t> out) {
+  static const MulFn mul = SelectMul();
+  YASL_ENFORCE_EQ(x.size(), y.size());
+  YASL_ENFORCE_EQ(x.size(), out.size());
+  mul(x.data(), y.data(), out.data(), out.size());
+}
+
+void Int128VecLshift(absl::Span<const uint128_t> x, size_t bits,
+                     absl::Span<uint128_t> out) {
+  ShiftBy<Shift::kLeft>(x, bits, out);
+}
+
+void Int128VecRshift(absl::Span<const uint128_t> x, size_t bits,
+                     absl::Span<uint128_t> out) {
+  ShiftBy<Shift::kRight>(x, bits, out);
+}
+
+void Int128VecArshift(absl::Span<const uint128_t> x, size_t bits,
+                      absl::Span<uint128_t> out) {
+  ShiftBy<Shift::kArith>(x, bits, out);
+}
+
+}  // namespace yasl
@@ -0,0 +1,52 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/int128.h"
+
+namespace yasl {
+
+// Element-wise arithmetic on the ring Z_2^128, say on vectors of shares.
+//
+// Add, Sub and Neg carry between the 64-bit halves by an unsigned compare,
+// 4 elements a time on AVX-512 and 2 on AVX2. The shifts take 4 elements a
+// time on AVX-512. Mul is the 3 multiplies of the schoolbook product mod
+// 2^128, on BMI2 mulx when the cpu has it, which is already the fastest as
+// there is no 64x64->128 bit vector multiply. Kernels are picked once at
+// runtime, the others are plain loops.
+//
+// out may be the same as an input, all spans are of the same size.
+
+void Int128VecAdd(absl::Span<const uint128_t> x, absl::Span<const uint128_t> y,
+                  absl::Span<uint128_t> out);
+void Int128VecSub(absl::Span<const uint128_t> x, absl::Span<const uint128_t> y,
+                  absl::Span<uint128_t> out);
+void Int128VecNeg(absl::Span<const uint128_t> x, absl::Span<uint128_t> out);
+void Int128VecMul(absl::Span<const uint128_t> x, absl::Span<const uint128_t> y,
+                  absl::Span<uint128_t> out);
+
+// Shifts by bits < 128. Arshift shifts in the sign bit, as int128_t does.
+void Int128VecLshift(absl::Span<const uint128_t> x, size_t bits,
+                     absl::Span<uint128_t> out);
+void Int128VecRshift(absl::Span<const uint128_t> x, size_t bits,
+                     absl::Span<uint128_t> out);
+void Int128VecArshift(absl::Span<const uint128_t> x, size_t bits,
+                      absl::Span<uint128_t> out);
+
+}  // namespace yasl
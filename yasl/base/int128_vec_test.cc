@@ -0,0 +1,102 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/base/int128_vec.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace yasl {
+
+namespace {
+
+std::vector<uint128_t> RandomVec(size_t n, std::mt19937_64* rng) {
+  std::vector<uint128_t> v(n);
+  for (size_t i = 0; i < n; ++i) {
+    // carries across the halves often.
+    const uint64_t lo = i % 3 == 0 ? ~uint64_t{0} - (*rng)() % 4 : (*rng)();
+    v[i] = MakeUint128((*rng)(), lo);
+  }
+  return v;
+}
+
+}  // namespace
+
+TEST(Int128VecTest, Arithmetic) {
+  std::mt19937_64 rng(1);
+  for (size_t n : {0, 1, 2, 3, 4, 5, 7, 8, 9, 100}) {
+    const auto x = RandomVec(n, &rng);
+    const auto y = RandomVec(n, &rng);
+    std::vector<uint128_t> add(n);
+    std::vector<uint128_t> sub(n);
+    std::vector<uint128_t> neg(n);
+    std::vector<uint128_t> mul(n);
+    Int128VecAdd(x, y, absl::MakeSpan(add));
+    Int128VecSub(x, y, absl::MakeSpan(sub));
+    Int128VecNeg(x, absl::MakeSpan(neg));
+    Int128VecMul(x, y, absl::MakeSpan(mul));
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_EQ(add[i], x[i] + y[i]) << i;
+      EXPECT_EQ(sub[i], x[i] - y[i]) << i;
+      EXPECT_EQ(neg[i], -x[i]) << i;
+      EXPECT_EQ(mul[i], x[i] * y[i]) << i;
+    }
+  }
+}
+
+TEST(Int128VecTest, Shifts) {
+  std::mt19937_64 rng(2);
+  const auto x = RandomVec(11, &rng);
+  std::vector<uint128_t> lshift(x.size());
+  std::vector<uint128_t> rshift(x.size());
+  std::vector<uint128_t> arshift(x.size());
+  for (size_t bits = 0; bits < 128; ++bits) {
+    Int128VecLshift(x, bits, absl::MakeSpan(lshift));
+    Int128VecRshift(x, bits, absl::MakeSpan(rshift));
+    Int128VecArshift(x, bits, absl::MakeSpan(arshift));
+    for (size_t i = 0; i < x.size(); ++i) {
+      EXPECT_EQ(lshift[i], x[i] << bits) << bits;
+      EXPECT_EQ(rshift[i], x[i] >> bits) << bits;
+      EXPECT_EQ(arshift[i],
+                static_cast<uint128_t>(static_cast<int128_t>(x[i]) >> bits))
+          << bits;
+    }
+  }
+  EXPECT_ANY_THROW(Int128VecLshift(x, 128, absl::MakeSpan(lshift)));
+}
+
+TEST(Int128VecTest, InPlace) {
+  std::mt19937_64 rng(3);
+  const auto x = RandomVec(9, &rng);
+  const auto y = RandomVec(9, &rng);
+  auto z = x;
+  Int128VecAdd(z, y, absl::MakeSpan(z));
+  Int128VecMul(z, y, absl::MakeSpan(z));
+  Int128VecArshift(z, 7, absl::MakeSpan(z));
+  for (size_t i = 0; i < x.size(); ++i) {
+    EXPECT_EQ(z[i], static_cast<uint128_t>(
+                        static_cast<int128_t>((x[i] + y[i]) * y[i]) >> 7));
+  }
+}
+
+TEST(Int128VecTest, SizeMismatchThrows) {
+  std::vector<uint128_t> x(4);
+  std::vector<uint128_t> y(3);
+  EXPECT_ANY_THROW(Int128VecAdd(x, y, absl::MakeSpan(x)));
+  EXPECT_ANY_THROW(Int128VecNeg(x, absl::MakeSpan(y)));
+}
+
+}  // namespace yasl
@@ -0,0 +1,86 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/base/memory_tracker.h"
+
+#include <iterator>
+#include <map>
+#include <mutex>
+
+#include "fmt/format.h"
+
+namespace yasl {
+
+namespace {
+
+struct TagRegistry {
+  std::mutex mutex;
+  std::map<std::string, MemoryTag*, std::less<>> tags;
+};
+
+TagRegistry* GetTagRegistry() {
+  // leaked, memory is released during static destruction as well.
+  static auto* registry = new TagRegistry();
+  return registry;
+}
+
+std::string FormatBytes(int64_t bytes) {
+  constexpr const char* kUnits[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+  double value = bytes;
+  size_t unit = 0;
+  while ((value >= 1024 || value <= -1024) && unit + 1 < std::size(kUnits)) {
+    value /= 1024;
+    unit++;
+  }
+  return unit == 0 ? fmt::format("{}B", bytes)
+                   : fmt::format("{:.1f}{}", value, kUnits[unit]);
+}
+
+}  // namespace
+
+MemoryTag* MemoryTag::Get(std::string_view name) {
+  auto* registry = GetTagRegistry();
+  std::lock_guard<std::mutex> lock(registry->mutex);
+  auto it = registry->tags.find(name);
+  if (it == registry->tags.end()) {
+    it = registry->tags
+             .emplace(std::string(name), new MemoryTag(std::string(name)))
+             .first;
+  }
+  return it->second;
+}
+
+std::vector<MemoryUsage> GetMemoryUsage() {
+  auto* registry = GetTagRegistry();
+  std::lock_guard<std::mutex> lock(registry->mutex);
+  std::vector<MemoryUsage> usage;
+  for (const auto& [name, tag] : registry->tags) {
+    usage.push_back({name, tag->live_bytes(), tag->peak_bytes()});
+  }
+  return usage;
+}
+
+std::string MemoryUsageString() {
+  std::string out = "memory:";
+  const char* sep = " ";
+  for (const auto& usage : GetMemoryUsage()) {
+    out += fmt::format("{}{}={}(peak {})", sep, usage.tag,
+                       FormatBytes(usage.live_bytes),
+                       FormatBytes(usage.peak_bytes));
+    sep = ",";
+  }
+  return out;
+}
+
+}  // namespace yasl
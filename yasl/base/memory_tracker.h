@@ -0,0 +1,117 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Brief: memory accounting by subsystem. The holders of large memory charge
+// the live bytes they hold to a named tag, which also keeps the peak, so
+// where the memory of a job went can be read while it runs:
+//
+//   buffer       memory of all yasl::Buffers
+//   buffer_pool  free blocks kept by the buffer pool
+//   link.msg_db  msgs received but not read yet
+//   ot.kkrt      kkrt ot extension matrices
+//   io.csv       batches of csv readers
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace yasl {
+
+class MemoryTag {
+ public:
+  // the tag of name, created on first use and never destroyed, so that the
+  // pointer may be cached.
+  static MemoryTag* Get(std::string_view name);
+
+  // charges bytes, or releases them if negative.
+  void Add(int64_t bytes) {
+    const int64_t live = live_.fetch_add(bytes, std::memory_order_relaxed) +
+                         bytes;
+    int64_t peak = peak_.load(std::memory_order_relaxed);
+    while (live > peak && !peak_.compare_exchange_weak(
+                              peak, live, std::memory_order_relaxed)) {
+    }
+  }
+
+  int64_t live_bytes() const { return live_.load(std::memory_order_relaxed); }
+  int64_t peak_bytes() const { return peak_.load(std::memory_order_relaxed); }
+
+  // the peak from now on starts at the live bytes.
+  void ResetPeak() { peak_.store(live_bytes(), std::memory_order_relaxed); }
+
+  const std::string& name() const { return name_; }
+
+ private:
+  explicit MemoryTag(std::string name) : name_(std::move(name)) {}
+
+  const std::string name_;
+  // a cache line of their own, they are hot.
+  alignas(64) std::atomic<int64_t> live_{0};
+  std::atomic<int64_t> peak_{0};
+};
+
+// a charge of a holder whose size changes, such as a container, which is
+// released when the charge is destroyed.
+class MemoryCharge {
+ public:
+  MemoryCharge() = default;
+  explicit MemoryCharge(MemoryTag* tag, int64_t bytes = 0) : tag_(tag) {
+    Set(bytes);
+  }
+  ~MemoryCharge() { Set(0); }
+
+  MemoryCharge(MemoryCharge&& other) noexcept { *this = std::move(other); }
+  MemoryCharge& operator=(MemoryCharge&& other) noexcept {
+    if (this != &other) {
+      Set(0);
+      tag_ = other.tag_;
+      bytes_ = other.bytes_;
+      other.bytes_ = 0;
+    }
+    return *this;
+  }
+
+  // the holder holds bytes now.
+  void Set(int64_t bytes) {
+    if (tag_ != nullptr && bytes != bytes_) {
+      tag_->Add(bytes - bytes_);
+      bytes_ = bytes;
+    }
+  }
+
+  int64_t bytes() const { return bytes_; }
+
+ private:
+  MemoryTag* tag_ = nullptr;
+  int64_t bytes_ = 0;
+};
+
+struct MemoryUsage {
+  std::string tag;
+  int64_t live_bytes = 0;
+  int64_t peak_bytes = 0;
+};
+
+// of all tags, by name.
+std::vector<MemoryUsage> GetMemoryUsage();
+
+// one line, like "memory: buffer=1.5MiB(peak 8.0MiB),link.msg_db=0B(...)".
+std::string MemoryUsageString();
+
+}  // namespace yasl
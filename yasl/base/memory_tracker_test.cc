@@ -0,0 +1,112 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/base/memory_tracker.h"
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/buffer.h"
+
+namespace yasl {
+
+TEST(MemoryTrackerTest, LiveAndPeak) {
+  auto* tag = MemoryTag::Get("test.live_and_peak");
+  EXPECT_EQ(tag, MemoryTag::Get("test.live_and_peak"));
+  EXPECT_EQ(tag->name(), "test.live_and_peak");
+
+  tag->Add(100);
+  tag->Add(50);
+  tag->Add(-120);
+  EXPECT_EQ(tag->live_bytes(), 30);
+  EXPECT_EQ(tag->peak_bytes(), 150);
+
+  tag->ResetPeak();
+  EXPECT_EQ(tag->peak_bytes(), 30);
+  tag->Add(-30);
+  EXPECT_EQ(tag->live_bytes(), 0);
+  EXPECT_EQ(tag->peak_bytes(), 30);
+}
+
+TEST(MemoryTrackerTest, Charge) {
+  auto* tag = MemoryTag::Get("test.charge");
+  {
+    MemoryCharge charge(tag, 10);
+    EXPECT_EQ(tag->live_bytes(), 10);
+    charge.Set(40);
+    charge.Set(20);
+    EXPECT_EQ(tag->live_bytes(), 20);
+
+    MemoryCharge moved = std::move(charge);
+    EXPECT_EQ(moved.bytes(), 20);
+    EXPECT_EQ(charge.bytes(), 0);
+    EXPECT_EQ(tag->live_bytes(), 20);
+  }
+  EXPECT_EQ(tag->live_bytes(), 0);
+  EXPECT_EQ(tag->peak_bytes(), 40);
+}
+
+TEST(MemoryTrackerTest, Concurrent) {
+  auto* tag = MemoryTag::Get("test.concurrent");
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([tag] {
+      for (int i = 0; i < 10000; i++) {
+        tag->Add(8);
+        tag->Add(-8);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(tag->live_bytes(), 0);
+  EXPECT_GE(tag->peak_bytes(), 8);
+  EXPECT_LE(tag->peak_bytes(), 32);
+}
+
+TEST(MemoryTrackerTest, Buffers) {
+  auto* tag = MemoryTag::Get("buffer");
+  const int64_t before = tag->live_bytes();
+  {
+    Buffer buf(1 << 20);
+    EXPECT_GE(tag->live_bytes() - before, buf.capacity());
+    buf.resize(3 << 20);
+    EXPECT_GE(tag->live_bytes() - before, buf.capacity());
+  }
+  EXPECT_EQ(tag->live_bytes(), before);
+  EXPECT_GE(tag->peak_bytes(), before + (3 << 20));
+}
+
+TEST(MemoryTrackerTest, UsageString) {
+  MemoryTag::Get("test.usage")->Add(3 << 20);
+  const auto usage = GetMemoryUsage();
+  bool found = false;
+  for (const auto& u : usage) {
+    if (u.tag == "test.usage") {
+      found = true;
+      EXPECT_EQ(u.live_bytes, 3 << 20);
+    }
+  }
+  EXPECT_TRUE(found);
+  EXPECT_NE(MemoryUsageString().find("test.usage=3.0MiB(peak 3.0MiB)"),
+            std::string::npos)
+      << MemoryUsageString();
+  MemoryTag::Get("test.usage")->Add(-(3 << 20));
+}
+
+}  // namespace yasl
@@ -0,0 +1,109 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/byte_container_view.h"
+#include "yasl/base/exception.h"
+
+namespace yasl {
+
+// An immutable view of a reference counted Buffer. Copies and slices share
+// the bytes, so splitting a large payload, or handing parts of it around,
+// is O(1). The bytes live until the last view of them is gone.
+//
+// Unlike Buffer, a slice is not aligned, it starts wherever it starts.
+class SharedBuffer final {
+ public:
+  using value_type = std::byte;
+
+  SharedBuffer() = default;
+
+  // takes over buf, no copy. a template, so that other containers, which
+  // convert to Buffer as well, take the copying constructor.
+  template <typename B,
+            std::enable_if_t<std::is_same_v<B, Buffer>, bool> = true>
+  /* implicit */ SharedBuffer(B&& buf)
+      : store_(std::make_shared<Buffer>(std::move(buf))),
+        data_(store_->data<std::byte>()),
+        size_(store_->size()) {}
+
+  // copies the bytes.
+  explicit SharedBuffer(ByteContainerView view)
+      : SharedBuffer(Buffer(view.data(), view.size())) {}
+
+  template <typename T = std::byte>
+  T const* data() const {
+    return reinterpret_cast<T const*>(data_);
+  }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  // bytes [offset, offset + length) of this one, sharing the same store.
+  SharedBuffer Slice(size_t offset, size_t length) const {
+    YASL_ENFORCE(offset <= size_ && length <= size_ - offset,
+                 "slice [{}, {}) out of {}", offset, offset + length, size_);
+    SharedBuffer slice;
+    slice.store_ = store_;
+    slice.data_ = data_ + offset;
+    slice.size_ = length;
+    return slice;
+  }
+
+  SharedBuffer Slice(size_t offset) const {
+    YASL_ENFORCE(offset <= size_, "slice from {} out of {}", offset, size_);
+    return Slice(offset, size_ - offset);
+  }
+
+  operator std::string_view() const {
+    return std::string_view(reinterpret_cast<const char*>(data_), size_);
+  }
+
+  bool operator==(const SharedBuffer& other) const {
+    return std::string_view(*this) == std::string_view(other);
+  }
+
+  // a Buffer of the bytes. the store is moved out when this is the last view
+  // of it and covers all of it, otherwise the bytes are copied.
+  Buffer ToBuffer() && {
+    if (store_ != nullptr && store_.use_count() == 1 &&
+        data_ == store_->data<std::byte>() && size_ == size_t(store_->size())) {
+      Buffer buf = std::move(*store_);
+      *this = SharedBuffer();
+      return buf;
+    }
+    return std::as_const(*this).ToBuffer();
+  }
+
+  Buffer ToBuffer() const& { return Buffer(data_, size_); }
+
+  // views sharing the store, 0 for an empty buffer.
+  long use_count() const { return store_.use_count(); }
+
+ private:
+  std::shared_ptr<Buffer> store_;
+  const std::byte* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace yasl
@@ -0,0 +1,76 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/base/shared_buffer.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace yasl {
+
+TEST(SharedBufferTest, SliceSharesBytes) {
+  Buffer buf(std::string("hello world"));
+  const void* data = buf.data();
+  SharedBuffer shared(std::move(buf));
+  EXPECT_EQ(shared.data(), data);
+  EXPECT_EQ(std::string_view(shared), "hello world");
+
+  auto world = shared.Slice(6);
+  auto ell = shared.Slice(1, 3);
+  EXPECT_EQ(std::string_view(world), "world");
+  EXPECT_EQ(std::string_view(ell), "ell");
+  EXPECT_EQ(world.data(), shared.data() + 6);
+  EXPECT_EQ(shared.use_count(), 3);
+  EXPECT_EQ(world.Slice(1, 2), SharedBuffer(std::string("or")));
+  EXPECT_TRUE(shared.Slice(11).empty());
+
+  EXPECT_THROW(shared.Slice(12), EnforceNotMet);
+  EXPECT_THROW(shared.Slice(6, 6), EnforceNotMet);
+}
+
+TEST(SharedBufferTest, OutlivesOriginal) {
+  SharedBuffer slice;
+  {
+    SharedBuffer shared(std::string("abcdef"));
+    slice = shared.Slice(2, 2);
+  }
+  EXPECT_EQ(slice.use_count(), 1);
+  EXPECT_EQ(std::string_view(slice), "cd");
+  ByteContainerView view = slice;
+  EXPECT_EQ(view.size(), 2);
+}
+
+TEST(SharedBufferTest, ToBuffer) {
+  Buffer buf(std::string("abcdef"));
+  const void* data = buf.data();
+
+  SharedBuffer shared(std::move(buf));
+  auto slice = shared.Slice(1, 2);
+  // shared, so copied.
+  Buffer copy = SharedBuffer(shared).ToBuffer();
+  EXPECT_NE(copy.data(), data);
+  EXPECT_EQ(std::string_view(copy), "abcdef");
+  EXPECT_EQ(std::string_view(slice.ToBuffer()), "bc");
+
+  // the last view of all of it, so moved.
+  slice = SharedBuffer();
+  Buffer moved = std::move(shared).ToBuffer();
+  EXPECT_EQ(moved.data(), data);
+  EXPECT_TRUE(shared.empty());
+
+  EXPECT_EQ(SharedBuffer().ToBuffer().size(), 0);
+}
+
+}  // namespace yasl
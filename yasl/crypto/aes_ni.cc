@@ -0,0 +1,339 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/aes_ni.h"
+
+#include "yasl/base/exception.h"
+
+#ifdef __x86_64
+#include <immintrin.h>
+
+#include "yasl/base/cpu_dispatch.h"
+#endif
+
+namespace yasl {
+
+namespace {
+
+#ifdef __x86_64
+constexpr size_t kBlockSize = sizeof(uint128_t);
+
+// blocks in flight, aesenc has a latency of several cycles, and one issue
+// per cycle.
+constexpr size_t kParallelBlocks = 8;
+// zmm registers in flight, of 4 blocks each.
+constexpr size_t kParallelVecs = 8;
+
+const bool kCPUSupportsAesNi = CpuSupports(kIsaAes);
+const bool kCPUSupportsVaes = CpuSupports(kIsaAes | kIsaVaes | kIsaAvx512f);
+
+__attribute__((target("aes,sse2"))) inline __m128i ExpandKey(__m128i key,
+                                                             __m128i assist) {
+  assist = _mm_shuffle_epi32(assist, _MM_SHUFFLE(3, 3, 3, 3));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, assist);
+}
+
+// the kernels increment the low words of the counters only, runs are split
+// where the low word wraps.
+template <typename Kernel>
+void ForEachRun(uint128_t counter, uint8_t* out, size_t nblock,
+                Kernel&& kernel) {
+  while (nblock > 0) {
+    // blocks to the wrap, 0 for 2^64.
+    const uint64_t to_wrap = -static_cast<uint64_t>(counter);
+    const size_t run = (to_wrap != 0 && to_wrap < nblock) ? to_wrap : nblock;
+    kernel(counter, out, run);
+    counter += run;
+    out += run * kBlockSize;
+    nblock -= run;
+  }
+}
+
+__attribute__((target("aes,sse2"))) void AesNiCtrRun(
+    const AesRoundKeys& round_keys, uint128_t counter, uint8_t* out,
+    size_t n) {
+  __m128i rk[11];
+  for (size_t r = 0; r < 11; ++r) {
+    rk[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&round_keys[r]));
+  }
+  __m128i ctr = _mm_set_epi64x(static_cast<int64_t>(counter >> 64),
+                               static_cast<int64_t>(counter));
+  const __m128i one = _mm_set_epi64x(0, 1);
+  auto* dst = reinterpret_cast<__m128i*>(out);
+  size_t i = 0;
+  // the loops are unrolled, so that b[] is kept in registers at -O2.
+  for (; i + kParallelBlocks <= n; i += kParallelBlocks) {
+    __m128i b[kParallelBlocks];
+#pragma GCC unroll 8
+    for (size_t j = 0; j < kParallelBlocks; ++j) {
+      b[j] = _mm_xor_si128(ctr, rk[0]);
+      ctr = _mm_add_epi64(ctr, one);
+    }
+#pragma GCC unroll 9
+    for (size_t r = 1; r < 10; ++r) {
+#pragma GCC unroll 8
+      for (size_t j = 0; j < kParallelBlocks; ++j) {
+        b[j] = _mm_aesenc_si128(b[j], rk[r]);
+      }
+    }
+#pragma GCC unroll 8
+    for (size_t j = 0; j < kParallelBlocks; ++j) {
+      _mm_storeu_si128(dst + i + j, _mm_aesenclast_si128(b[j], rk[10]));
+    }
+  }
+  for (; i < n; ++i) {
+    __m128i b = _mm_xor_si128(ctr, rk[0]);
+    ctr = _mm_add_epi64(ctr, one);
+    for (size_t r = 1; r < 10; ++r) {
+      b = _mm_aesenc_si128(b, rk[r]);
+    }
+    _mm_storeu_si128(dst + i, _mm_aesenclast_si128(b, rk[10]));
+  }
+}
+
+// x in each 128-bit lane.
+__attribute__((target("avx512f"))) inline __m512i Broadcast(uint128_t x) {
+  const auto hi = static_cast<int64_t>(x >> 64);
+  const auto lo = static_cast<int64_t>(x);
+  return _mm512_set_epi64(hi, lo, hi, lo, hi, lo, hi, lo);
+}
+
+// the rounds of 4 blocks per zmm register, the tail of less than
+// kParallelVecs registers goes to AES-NI.
+__attribute__((target("aes,vaes,avx512f"))) void VaesCtrRun(
+    const AesRoundKeys& round_keys, uint128_t counter, uint8_t* out,
+    size_t n) {
+  constexpr size_t kStep = 4 * kParallelVecs;
+  __m512i rk[11];
+  for (size_t r = 0; r < 11; ++r) {
+    rk[r] = Broadcast(round_keys[r]);
+  }
+  __m512i ctr = _mm512_add_epi64(Broadcast(counter),
+                                 _mm512_set_epi64(0, 3, 0, 2, 0, 1, 0, 0));
+  const __m512i four = _mm512_set_epi64(0, 4, 0, 4, 0, 4, 0, 4);
+  size_t i = 0;
+  for (; i + kStep <= n; i += kStep) {
+    __m512i b[kParallelVecs];
+#pragma GCC unroll 8
+    for (size_t j = 0; j < kParallelVecs; ++j) {
+      b[j] = _mm512_xor_si512(ctr, rk[0]);
+      ctr = _mm512_add_epi64(ctr, four);
+    }
+#pragma GCC unroll 9
+    for (size_t r = 1; r < 10; ++r) {
+#pragma GCC unroll 8
+      for (size_t j = 0; j < kParallelVecs; ++j) {
+        b[j] = _mm512_aesenc_epi128(b[j], rk[r]);
+      }
+    }
+#pragma GCC unroll 8
+    for (size_t j = 0; j < kParallelVecs; ++j) {
+      _mm512_storeu_si512(out + (i + 4 * j) * kBlockSize,
+                          _mm512_aesenclast_epi128(b[j], rk[10]));
+    }
+  }
+  if (i < n) {
+    AesNiCtrRun(round_keys, counter + i, out + i * kBlockSize, n - i);
+  }
+}
+
+template <bool kDecrypt>
+__attribute__((target("aes,sse2"))) inline __m128i Round(__m128i b,
+                                                         __m128i rk) {
+  if constexpr (kDecrypt) {
+    return _mm_aesdec_si128(b, rk);
+  } else {
+    return _mm_aesenc_si128(b, rk);
+  }
+}
+
+template <bool kDecrypt>
+__attribute__((target("aes,sse2"))) inline __m128i LastRound(__m128i b,
+                                                             __m128i rk) {
+  if constexpr (kDecrypt) {
+    return _mm_aesdeclast_si128(b, rk);
+  } else {
+    return _mm_aesenclast_si128(b, rk);
+  }
+}
+
+__attribute__((target("sse2"))) inline __m128i LoadKey(const uint128_t* rk) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(rk));
+}
+
+// as AesNiCtrRun, but each block loads the round keys of its own key, which
+// stay in L1 for a working set of keys.
+template <bool kDecrypt>
+__attribute__((target("aes,sse2"))) void AesNiMultiKeyRun(
+    const AesRoundKeys* keys, const uint32_t* key_idx, const uint8_t* in,
+    uint8_t* out, size_t n) {
+  const auto* src = reinterpret_cast<const __m128i*>(in);
+  auto* dst = reinterpret_cast<__m128i*>(out);
+  size_t i = 0;
+  for (; i + kParallelBlocks <= n; i += kParallelBlocks) {
+    const uint128_t* rk[kParallelBlocks];
+    __m128i b[kParallelBlocks];
+#pragma GCC unroll 8
+    for (size_t j = 0; j < kParallelBlocks; ++j) {
+      rk[j] = keys[key_idx[i + j]].data();
+      b[j] = _mm_xor_si128(_mm_loadu_si128(src + i + j), LoadKey(rk[j]));
+    }
+#pragma GCC unroll 9
+    for (size_t r = 1; r < 10; ++r) {
+#pragma GCC unroll 8
+      for (size_t j = 0; j < kParallelBlocks; ++j) {
+        b[j] = Round<kDecrypt>(b[j], LoadKey(rk[j] + r));
+      }
+    }
+#pragma GCC unroll 8
+    for (size_t j = 0; j < kParallelBlocks; ++j) {
+      _mm_storeu_si128(dst + i + j,
+                       LastRound<kDecrypt>(b[j], LoadKey(rk[j] + 10)));
+    }
+  }
+  for (; i < n; ++i) {
+    const uint128_t* rk = keys[key_idx[i]].data();
+    __m128i b = _mm_xor_si128(_mm_loadu_si128(src + i), LoadKey(rk));
+    for (size_t r = 1; r < 10; ++r) {
+      b = Round<kDecrypt>(b, LoadKey(rk + r));
+    }
+    _mm_storeu_si128(dst + i, LastRound<kDecrypt>(b, LoadKey(rk + 10)));
+  }
+}
+#endif
+
+}  // namespace
+
+bool CpuSupportsAesNi() {
+#ifdef __x86_64
+  return kCPUSupportsAesNi;
+#else
+  return false;
+#endif
+}
+
+bool CpuSupportsVaes() {
+#ifdef __x86_64
+  return kCPUSupportsVaes;
+#else
+  return false;
+#endif
+}
+
+#ifdef __x86_64
+__attribute__((target("aes,sse2"))) void AesNiKeySchedule(
+    uint128_t key, AesRoundKeys* round_keys) {
+  YASL_ENFORCE(kCPUSupportsAesNi, "AES-NI is not supported");
+  __m128i rk[11];
+  rk[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&key));
+  // the round constant must be an immediate.
+  rk[1] = ExpandKey(rk[0], _mm_aeskeygenassist_si128(rk[0], 0x01));
+  rk[2] = ExpandKey(rk[1], _mm_aeskeygenassist_si128(rk[1], 0x02));
+  rk[3] = ExpandKey(rk[2], _mm_aeskeygenassist_si128(rk[2], 0x04));
+  rk[4] = ExpandKey(rk[3], _mm_aeskeygenassist_si128(rk[3], 0x08));
+  rk[5] = ExpandKey(rk[4], _mm_aeskeygenassist_si128(rk[4], 0x10));
+  rk[6] = ExpandKey(rk[5], _mm_aeskeygenassist_si128(rk[5], 0x20));
+  rk[7] = ExpandKey(rk[6], _mm_aeskeygenassist_si128(rk[6], 0x40));
+  rk[8] = ExpandKey(rk[7], _mm_aeskeygenassist_si128(rk[7], 0x80));
+  rk[9] = ExpandKey(rk[8], _mm_aeskeygenassist_si128(rk[8], 0x1b));
+  rk[10] = ExpandKey(rk[9], _mm_aeskeygenassist_si128(rk[9], 0x36));
+  for (size_t r = 0; r < 11; ++r) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&(*round_keys)[r]), rk[r]);
+  }
+}
+
+void AesCtrEncrypt(const AesRoundKeys& round_keys, uint128_t counter,
+                   uint8_t* out, size_t nblock) {
+  if (kCPUSupportsVaes) {
+    VaesCtrEncrypt(round_keys, counter, out, nblock);
+  } else {
+    AesNiCtrEncrypt(round_keys, counter, out, nblock);
+  }
+}
+
+void AesNiCtrEncrypt(const AesRoundKeys& round_keys, uint128_t counter,
+                     uint8_t* out, size_t nblock) {
+  YASL_ENFORCE(kCPUSupportsAesNi, "AES-NI is not supported");
+  ForEachRun(counter, out, nblock, [&](uint128_t c, uint8_t* o, size_t n) {
+    AesNiCtrRun(round_keys, c, o, n);
+  });
+}
+
+void VaesCtrEncrypt(const AesRoundKeys& round_keys, uint128_t counter,
+                    uint8_t* out, size_t nblock) {
+  YASL_ENFORCE(kCPUSupportsVaes, "VAES is not supported");
+  ForEachRun(counter, out, nblock, [&](uint128_t c, uint8_t* o, size_t n) {
+    VaesCtrRun(round_keys, c, o, n);
+  });
+}
+
+__attribute__((target("aes,sse2"))) void AesNiDecryptKeySchedule(
+    const AesRoundKeys& enc_keys, AesRoundKeys* dec_keys) {
+  YASL_ENFORCE(kCPUSupportsAesNi, "AES-NI is not supported");
+  // the rounds in reverse, InvMixColumns on the inner ones.
+  (*dec_keys)[0] = enc_keys[10];
+  for (size_t r = 1; r < 10; ++r) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&(*dec_keys)[r]),
+                     _mm_aesimc_si128(LoadKey(&enc_keys[10 - r])));
+  }
+  (*dec_keys)[10] = enc_keys[0];
+}
+
+void AesNiMultiKeyEncrypt(const AesRoundKeys* keys, const uint32_t* key_idx,
+                          const uint8_t* in, uint8_t* out, size_t nblock) {
+  YASL_ENFORCE(kCPUSupportsAesNi, "AES-NI is not supported");
+  AesNiMultiKeyRun<false>(keys, key_idx, in, out, nblock);
+}
+
+void AesNiMultiKeyDecrypt(const AesRoundKeys* dec_keys, const uint32_t* key_idx,
+                          const uint8_t* in, uint8_t* out, size_t nblock) {
+  YASL_ENFORCE(kCPUSupportsAesNi, "AES-NI is not supported");
+  AesNiMultiKeyRun<true>(dec_keys, key_idx, in, out, nblock);
+}
+#else
+void AesNiKeySchedule(uint128_t, AesRoundKeys*) {
+  YASL_THROW("AES-NI is not supported");
+}
+
+void AesCtrEncrypt(const AesRoundKeys&, uint128_t, uint8_t*, size_t) {
+  YASL_THROW("AES-NI is not supported");
+}
+
+void AesNiCtrEncrypt(const AesRoundKeys&, uint128_t, uint8_t*, size_t) {
+  YASL_THROW("AES-NI is not supported");
+}
+
+void VaesCtrEncrypt(const AesRoundKeys&, uint128_t, uint8_t*, size_t) {
+  YASL_THROW("VAES is not supported");
+}
+
+void AesNiDecryptKeySchedule(const AesRoundKeys&, AesRoundKeys*) {
+  YASL_THROW("AES-NI is not supported");
+}
+
+void AesNiMultiKeyEncrypt(const AesRoundKeys*, const uint32_t*,
+                          const uint8_t*, uint8_t*, size_t) {
+  YASL_THROW("AES-NI is not supported");
+}
+
+void AesNiMultiKeyDecrypt(const AesRoundKeys*, const uint32_t*,
+                          const uint8_t*, uint8_t*, size_t) {
+  YASL_THROW("AES-NI is not supported");
+}
+#endif
+
+}  // namespace yasl
@@ -0,0 +1,68 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "yasl/base/int128.h"
+
+namespace yasl {
+
+// AES-128 kernels on AES-NI, and on VAES with AVX-512 where available. They
+// are bit compatible with AES128_ECB of SymmetricCrypto, uint128_t being
+// loaded and stored as its little endian bytes.
+
+using AesRoundKeys = std::array<uint128_t, 11>;
+
+// Whether the cpu runs the kernels below, false on other archs.
+bool CpuSupportsAesNi();
+// Whether AesCtrEncrypt runs 4 blocks per instruction, implies AES-NI.
+bool CpuSupportsVaes();
+
+// Expands `key` into the 11 round keys of AES-128, requires AES-NI.
+void AesNiKeySchedule(uint128_t key, AesRoundKeys* round_keys);
+
+// Fixed key CTR keystream, the `nblock` blocks of `out` are AES_key(counter),
+// AES_key(counter + 1), ... The counters are generated in registers, so
+// nothing is read from `out`, which needs no alignment. Runs on VAES if
+// CpuSupportsVaes(), on AES-NI otherwise.
+void AesCtrEncrypt(const AesRoundKeys& round_keys, uint128_t counter,
+                   uint8_t* out, size_t nblock);
+
+// The AES-NI and the VAES kernel of AesCtrEncrypt, for benchmarks.
+void AesNiCtrEncrypt(const AesRoundKeys& round_keys, uint128_t counter,
+                     uint8_t* out, size_t nblock);
+void VaesCtrEncrypt(const AesRoundKeys& round_keys, uint128_t counter,
+                    uint8_t* out, size_t nblock);
+
+// Turns the round keys of AesNiKeySchedule into those of the equivalent
+// inverse cipher, for AesNiMultiKeyDecrypt. Requires AES-NI.
+void AesNiDecryptKeySchedule(const AesRoundKeys& enc_keys,
+                             AesRoundKeys* dec_keys);
+
+// ECB by many keys, block i of `in` is encrypted into block i of `out` by
+// `keys[key_idx[i]]`. The blocks of different keys are interleaved as those
+// of a single key, so that it runs at about the speed of one key. `in` and
+// `out` may be the same and need no alignment. Requires AES-NI.
+void AesNiMultiKeyEncrypt(const AesRoundKeys* keys, const uint32_t* key_idx,
+                          const uint8_t* in, uint8_t* out, size_t nblock);
+
+// As AesNiMultiKeyEncrypt, by the keys of AesNiDecryptKeySchedule.
+void AesNiMultiKeyDecrypt(const AesRoundKeys* dec_keys, const uint32_t* key_idx,
+                          const uint8_t* in, uint8_t* out, size_t nblock);
+
+}  // namespace yasl
@@ -0,0 +1,86 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/aes_ni.h"
+
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/crypto/symmetric_crypto.h"
+
+namespace yasl {
+
+namespace {
+
+constexpr uint128_t kKey = 0x0123456789abcdefULL;
+
+// AES128_ECB of the counters from `counter`.
+std::vector<uint128_t> EncryptCounters(uint128_t counter, size_t n) {
+  std::vector<uint128_t> ctrs(n);
+  for (size_t i = 0; i < n; ++i) {
+    ctrs[i] = counter + i;
+  }
+  std::vector<uint128_t> expected(n);
+  SymmetricCrypto(SymmetricCrypto::CryptoType::AES128_ECB, kKey)
+      .Encrypt(absl::MakeConstSpan(ctrs), absl::MakeSpan(expected));
+  return expected;
+}
+
+using CtrKernel = void (*)(const AesRoundKeys&, uint128_t, uint8_t*, size_t);
+
+void CheckKernel(CtrKernel kernel) {
+  AesRoundKeys round_keys;
+  AesNiKeySchedule(kKey, &round_keys);
+  // the runs across the wrap of the low word carry into the high word.
+  for (uint128_t counter : {uint128_t(0), uint128_t(12345),
+                            MakeUint128(7, ~uint64_t(0) - 20)}) {
+    for (size_t n : {0, 1, 7, 8, 9, 31, 32, 33, 100, 1000}) {
+      // unaligned output.
+      std::vector<uint8_t> out(n * sizeof(uint128_t) + 1);
+      kernel(round_keys, counter, out.data() + 1, n);
+      const auto expected = EncryptCounters(counter, n);
+      EXPECT_EQ(std::memcmp(out.data() + 1, expected.data(),
+                            n * sizeof(uint128_t)),
+                0)
+          << "n=" << n;
+    }
+  }
+}
+
+}  // namespace
+
+TEST(AesNiTest, AesNiCtrEncrypt) {
+  if (!CpuSupportsAesNi()) {
+    GTEST_SKIP() << "AES-NI is not supported";
+  }
+  CheckKernel(&AesNiCtrEncrypt);
+}
+
+TEST(AesNiTest, VaesCtrEncrypt) {
+  if (!CpuSupportsVaes()) {
+    GTEST_SKIP() << "VAES is not supported";
+  }
+  CheckKernel(&VaesCtrEncrypt);
+}
+
+TEST(AesNiTest, AesCtrEncrypt) {
+  if (!CpuSupportsAesNi()) {
+    GTEST_SKIP() << "AES-NI is not supported";
+  }
+  CheckKernel(&AesCtrEncrypt);
+}
+
+}  // namespace yasl
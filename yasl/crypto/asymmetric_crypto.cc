@@ -0,0 +1,55 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/asymmetric_crypto.h"
+
+#include "yasl/utils/parallel.h"
+
+namespace yasl::crypto {
+
+namespace {
+
+// plaintexts encrypted by one task at least, each takes tens of us.
+constexpr int64_t kEncryptGrainSize = 16;
+
+}  // namespace
+
+std::vector<std::vector<uint8_t>> AsymmetricEncryptor::EncryptBatch(
+    absl::Span<const ByteContainerView> plaintexts) {
+  std::vector<std::vector<uint8_t>> ciphertexts;
+  ciphertexts.reserve(plaintexts.size());
+  for (const auto& plaintext : plaintexts) {
+    ciphertexts.push_back(Encrypt(plaintext));
+  }
+  return ciphertexts;
+}
+
+namespace internal {
+
+std::vector<std::vector<uint8_t>> ParallelEncrypt(
+    absl::Span<const ByteContainerView> plaintexts,
+    const std::function<std::vector<uint8_t>(ByteContainerView)>& encrypt) {
+  std::vector<std::vector<uint8_t>> ciphertexts(plaintexts.size());
+  parallel_for(0, plaintexts.size(), kEncryptGrainSize,
+               [&](int64_t begin, int64_t end) {
+                 for (int64_t i = begin; i < end; i++) {
+                   ciphertexts[i] = encrypt(plaintexts[i]);
+                 }
+               });
+  return ciphertexts;
+}
+
+}  // namespace internal
+
+}  // namespace yasl::crypto
@@ -14,8 +14,13 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <vector>
 
+#include "absl/types/span.h"
+
 #include "yasl/base/byte_container_view.h"
 
 namespace yasl::crypto {
@@ -29,6 +34,12 @@ class AsymmetricEncryptor {
   virtual AsymCryptoSchema GetSchema() const = 0;
 
   virtual std::vector<uint8_t> Encrypt(ByteContainerView plaintext) = 0;
+
+  // Encrypts plaintexts[i] into the i-th ciphertext, say session keys wrapped
+  // for one recipient. Runs Encrypt in a loop, subclasses whose Encrypt is
+  // thread safe spread it over the thread pool.
+  virtual std::vector<std::vector<uint8_t>> EncryptBatch(
+      absl::Span<const ByteContainerView> plaintexts);
 };
 
 class AsymmetricDecryptor {
@@ -40,4 +51,13 @@ class AsymmetricDecryptor {
   virtual std::vector<uint8_t> Decrypt(ByteContainerView ciphertext) = 0;
 };
 
+namespace internal {
+
+// Runs encrypt(plaintexts[i]) on the thread pool.
+std::vector<std::vector<uint8_t>> ParallelEncrypt(
+    absl::Span<const ByteContainerView> plaintexts,
+    const std::function<std::vector<uint8_t>(ByteContainerView)>& encrypt);
+
+}  // namespace internal
+
 }  // namespace yasl::crypto
\ No newline at end of file
@@ -17,7 +17,6 @@
 #include <iostream>
 
 #include "absl/memory/memory.h"
-#include "openssl/pem.h"
 
 #include "yasl/base/exception.h"
 #include "yasl/crypto/asymmetric_util.h"
@@ -33,16 +32,8 @@ constexpr int kRsaPadding = RSA_PKCS1_OAEP_PADDING;
 
 std::unique_ptr<RsaEncryptor> RsaEncryptor::CreateFromX509(
     ByteContainerView x509_public_key) {
-  UniqueBio pem_bio(
-      BIO_new_mem_buf(x509_public_key.data(), x509_public_key.size()),
-      BIO_free);
-  X509* cert = PEM_read_bio_X509(pem_bio.get(), nullptr, nullptr, nullptr);
-  YASL_ENFORCE(cert, "No X509 from cert.");
-  UniqueX509 unique_cert(cert, ::X509_free);
-  EVP_PKEY* pubkey = X509_get_pubkey(unique_cert.get());
-  YASL_ENFORCE(pubkey, "No pubkey in x509.");
-  UniqueEVP unique_pkey(pubkey, ::EVP_PKEY_free);
-  RSA* rsa = EVP_PKEY_get1_RSA(unique_pkey.get());
+  auto pkey = internal::CreatePubPkeyFromCertPem(x509_public_key);
+  RSA* rsa = EVP_PKEY_get1_RSA(pkey.get());
   YASL_ENFORCE(rsa, "No Rsa from pem string.");
   // Using `new` to access a non-public constructor.
   // ref https://abseil.io/tips/134
@@ -52,10 +43,8 @@ std::unique_ptr<RsaEncryptor> RsaEncryptor::CreateFromX509(
 
 std::unique_ptr<RsaEncryptor> RsaEncryptor::CreateFromPem(
     ByteContainerView public_key) {
-  UniqueBio pem_bio(BIO_new_mem_buf(public_key.data(), public_key.size()),
-                    BIO_free);
-  RSA* rsa =
-      PEM_read_bio_RSAPublicKey(pem_bio.get(), nullptr, nullptr, nullptr);
+  auto pkey = internal::CreatePubPkeyFromRsaPem(public_key);
+  RSA* rsa = EVP_PKEY_get1_RSA(pkey.get());
   YASL_ENFORCE(rsa, "No rsa from pem.");
   return std::unique_ptr<RsaEncryptor>(
       new RsaEncryptor(UniqueRsa(rsa, ::RSA_free)));
@@ -64,6 +53,17 @@ std::unique_ptr<RsaEncryptor> RsaEncryptor::CreateFromPem(
 AsymCryptoSchema RsaEncryptor::GetSchema() const { return schema_; }
 
 std::vector<uint8_t> RsaEncryptor::Encrypt(ByteContainerView plaintext) {
+  return DoEncrypt(plaintext);
+}
+
+std::vector<std::vector<uint8_t>> RsaEncryptor::EncryptBatch(
+    absl::Span<const ByteContainerView> plaintexts) {
+  return internal::ParallelEncrypt(
+      plaintexts, [this](ByteContainerView p) { return DoEncrypt(p); });
+}
+
+std::vector<uint8_t> RsaEncryptor::DoEncrypt(
+    ByteContainerView plaintext) const {
   int buf_size = RSA_size(rsa_.get());
   YASL_ENFORCE_GT(buf_size, 0, "Illegal RSA_size.");
   YASL_ENFORCE_LT((int)plaintext.size() + kRsaInputSizeLimitOffset, buf_size,
@@ -78,10 +78,8 @@ std::vector<uint8_t> RsaEncryptor::Encrypt(ByteContainerView plaintext) {
 
 std::unique_ptr<RsaDecryptor> RsaDecryptor::CreateFromPem(
     ByteContainerView private_key) {
-  UniqueBio pem_bio(BIO_new_mem_buf(private_key.data(), private_key.size()),
-                    BIO_free);
-  RSA* rsa =
-      PEM_read_bio_RSAPrivateKey(pem_bio.get(), nullptr, nullptr, nullptr);
+  auto pkey = internal::CreatePriPkeyFromRsaPem(private_key);
+  RSA* rsa = EVP_PKEY_get1_RSA(pkey.get());
   YASL_ENFORCE(rsa, "No rsa from string.");
   return std::unique_ptr<RsaDecryptor>(
       new RsaDecryptor(UniqueRsa(rsa, ::RSA_free)));
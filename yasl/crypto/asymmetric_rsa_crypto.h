@@ -42,10 +42,17 @@ class RsaEncryptor : public crypto::AsymmetricEncryptor {
 
   std::vector<uint8_t> Encrypt(ByteContainerView plaintext) override;
 
+  // The public key operations share the montgomery context cached in the
+  // key, and run on the thread pool.
+  std::vector<std::vector<uint8_t>> EncryptBatch(
+      absl::Span<const ByteContainerView> plaintexts) override;
+
  private:
   explicit RsaEncryptor(UniqueRsa rsa)
       : rsa_(std::move(rsa)), schema_(AsymCryptoSchema::RSA2048_OAEP) {}
 
+  std::vector<uint8_t> DoEncrypt(ByteContainerView plaintext) const;
+
   const UniqueRsa rsa_;
   const AsymCryptoSchema schema_;
 };
@@ -14,6 +14,9 @@
 
 #include "yasl/crypto/asymmetric_rsa_crypto.h"
 
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "yasl/crypto/asymmetric_util.h"
@@ -37,4 +40,27 @@ TEST(AsymmetricRsa, EncryptDecrypt_shouldOk) {
   EXPECT_EQ(plaintext, decrypted);
 }
 
+TEST(AsymmetricRsa, EncryptBatch_shouldOk) {
+  // GIVEN
+  auto [public_key, private_key] = CreateRsaKeyPair();
+  std::vector<std::string> plaintexts;
+  for (int i = 0; i < 50; i++) {
+    plaintexts.push_back("session key " + std::to_string(i));
+  }
+  std::vector<ByteContainerView> views(plaintexts.begin(), plaintexts.end());
+
+  // WHEN
+  auto encryptor = RsaEncryptor::CreateFromPem(public_key);
+  auto encrypted = encryptor->EncryptBatch(views);
+
+  // THEN
+  auto decryptor = RsaDecryptor::CreateFromPem(private_key);
+  ASSERT_EQ(encrypted.size(), plaintexts.size());
+  for (size_t i = 0; i < plaintexts.size(); i++) {
+    auto decrypted_bytes = decryptor->Decrypt(encrypted[i]);
+    EXPECT_EQ(plaintexts[i],
+              std::string(decrypted_bytes.begin(), decrypted_bytes.end()));
+  }
+}
+
 }  // namespace yasl::crypto
\ No newline at end of file
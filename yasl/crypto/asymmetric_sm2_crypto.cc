@@ -15,6 +15,7 @@
 #include "yasl/crypto/asymmetric_sm2_crypto.h"
 
 #include <iostream>
+#include <utility>
 
 #include "absl/memory/memory.h"
 #include "openssl/pem.h"
@@ -33,24 +34,41 @@ std::unique_ptr<Sm2Encryptor> Sm2Encryptor::CreateFromPem(
       new Sm2Encryptor(internal::CreatePubPkeyFromSm2Pem(sm2_pem)));
 }
 
+Sm2Encryptor::Sm2Encryptor(UniquePkey pkey)
+    : pkey_(std::move(pkey)),
+      schema_(AsymCryptoSchema::SM2),
+      encrypt_ctx_(EVP_PKEY_CTX_new(pkey_.get(), nullptr), EVP_PKEY_CTX_free) {
+  YASL_ENFORCE(encrypt_ctx_ != nullptr, "Failed to create EVP_PKEY_CTX");
+  YASL_ENFORCE_GT(EVP_PKEY_encrypt_init(encrypt_ctx_.get()), 0);
+}
+
 AsymCryptoSchema Sm2Encryptor::GetSchema() const { return schema_; }
 
 std::vector<uint8_t> Sm2Encryptor::Encrypt(ByteContainerView plaintext) {
-  EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(pkey_.get(), nullptr);
-  YASL_ENFORCE(ctx != nullptr, "Failed to create EVP_PKEY_CTX");
-  YASL_ENFORCE_GT(EVP_PKEY_encrypt_init(ctx), 0);
-  ON_SCOPE_EXIT([&] { EVP_PKEY_CTX_free(ctx); });
+  return DoEncrypt(plaintext);
+}
+
+std::vector<std::vector<uint8_t>> Sm2Encryptor::EncryptBatch(
+    absl::Span<const ByteContainerView> plaintexts) {
+  return internal::ParallelEncrypt(
+      plaintexts, [this](ByteContainerView p) { return DoEncrypt(p); });
+}
+
+std::vector<uint8_t> Sm2Encryptor::DoEncrypt(
+    ByteContainerView plaintext) const {
+  UniquePkeyCtx ctx(EVP_PKEY_CTX_dup(encrypt_ctx_.get()), EVP_PKEY_CTX_free);
+  YASL_ENFORCE(ctx != nullptr, "Failed to copy EVP_PKEY_CTX");
   size_t cipher_len;
   // Determine buffer length.
   // Note that cipher_len is the maximum but not exact size of the output
   // buffer. Ref
   // https://www.openssl.org/docs/man1.1.1/man3/EVP_PKEY_encrypt.html
-  YASL_ENFORCE_GT(EVP_PKEY_encrypt(ctx, nullptr, &cipher_len, plaintext.data(),
-                                   plaintext.size()),
+  YASL_ENFORCE_GT(EVP_PKEY_encrypt(ctx.get(), nullptr, &cipher_len,
+                                   plaintext.data(), plaintext.size()),
                   0);
   std::vector<uint8_t> ciphertext(cipher_len);
   // Do encryption
-  YASL_ENFORCE_GT(EVP_PKEY_encrypt(ctx, ciphertext.data(), &cipher_len,
+  YASL_ENFORCE_GT(EVP_PKEY_encrypt(ctx.get(), ciphertext.data(), &cipher_len,
                                    plaintext.data(), plaintext.size()),
                   0);
   // Correct the size to actual size.
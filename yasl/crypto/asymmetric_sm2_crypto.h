@@ -24,10 +24,14 @@
 
 namespace yasl::crypto {
 
+// The pkey context is set up for encryption at creation, Encrypt only copies
+// it. Encrypt is thread safe.
 class Sm2Encryptor : public crypto::AsymmetricEncryptor {
  public:
   using UniqueBio = std::unique_ptr<BIO, decltype(&BIO_free)>;
   using UniquePkey = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
+  using UniquePkeyCtx =
+      std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)>;
 
   static std::unique_ptr<Sm2Encryptor> CreateFromPem(ByteContainerView sm2_pem);
 
@@ -35,12 +39,19 @@ class Sm2Encryptor : public crypto::AsymmetricEncryptor {
 
   std::vector<uint8_t> Encrypt(ByteContainerView plaintext) override;
 
+  // Runs on the thread pool.
+  std::vector<std::vector<uint8_t>> EncryptBatch(
+      absl::Span<const ByteContainerView> plaintexts) override;
+
  private:
-  explicit Sm2Encryptor(UniquePkey pkey)
-      : pkey_(std::move(pkey)), schema_(AsymCryptoSchema::SM2) {}
+  explicit Sm2Encryptor(UniquePkey pkey);
+
+  std::vector<uint8_t> DoEncrypt(ByteContainerView plaintext) const;
 
   const UniquePkey pkey_;
   const AsymCryptoSchema schema_;
+  // after EVP_PKEY_encrypt_init.
+  UniquePkeyCtx encrypt_ctx_;
 };
 
 class Sm2Decryptor : public crypto::AsymmetricDecryptor {
@@ -14,6 +14,9 @@
 
 #include "yasl/crypto/asymmetric_sm2_crypto.h"
 
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "yasl/crypto/asymmetric_util.h"
@@ -37,4 +40,27 @@ TEST(AsymmetricSm2, EncryptDecrypt_shouldOk) {
   EXPECT_EQ(plaintext, decrypted);
 }
 
+TEST(AsymmetricSm2, EncryptBatch_shouldOk) {
+  // GIVEN
+  auto [public_key, private_key] = CreateSm2KeyPair();
+  std::vector<std::string> plaintexts;
+  for (int i = 0; i < 50; i++) {
+    plaintexts.push_back("session key " + std::to_string(i));
+  }
+  std::vector<ByteContainerView> views(plaintexts.begin(), plaintexts.end());
+
+  // WHEN
+  auto encryptor = Sm2Encryptor::CreateFromPem(public_key);
+  auto encrypted = encryptor->EncryptBatch(views);
+
+  // THEN
+  auto decryptor = Sm2Decryptor::CreateFromPem(private_key);
+  ASSERT_EQ(encrypted.size(), plaintexts.size());
+  for (size_t i = 0; i < plaintexts.size(); i++) {
+    auto decrypted_bytes = decryptor->Decrypt(encrypted[i]);
+    EXPECT_EQ(plaintexts[i],
+              std::string(decrypted_bytes.begin(), decrypted_bytes.end()));
+  }
+}
+
 }  // namespace yasl::crypto
\ No newline at end of file
@@ -14,11 +14,15 @@
 
 #include "yasl/crypto/asymmetric_util.h"
 
+#include <mutex>
 #include <random>
+#include <string>
 
 #include "openssl/bn.h"
+#include "openssl/err.h"
 #include "openssl/pem.h"
 #include "openssl/rsa.h"
+#include "openssl/sha.h"
 #include "openssl/x509v3.h"
 
 #include "yasl/base/exception.h"
@@ -30,6 +34,7 @@ using UniqueBio = std::unique_ptr<BIO, decltype(&BIO_free)>;
 using UniqueRsa = std::unique_ptr<RSA, decltype(&RSA_free)>;
 using UniqueEVP = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
 using UniqueX509 = std::unique_ptr<X509, decltype(&X509_free)>;
+using internal::UniquePkey;
 
 namespace {
 
@@ -65,9 +70,9 @@ inline void AddX509Extension(X509* cert, int nid, char* value) {
 
 }  // namespace
 
-namespace internal {
+namespace {
 
-UniquePkey CreatePriPkeyFromSm2Pem(ByteContainerView pem) {
+UniquePkey ParseSm2PriPem(ByteContainerView pem) {
   UniqueBio pem_bio(BIO_new_mem_buf(pem.data(), pem.size()), BIO_free);
   EC_KEY* ec_key =
       PEM_read_bio_ECPrivateKey(pem_bio.get(), nullptr, nullptr, nullptr);
@@ -81,7 +86,7 @@ UniquePkey CreatePriPkeyFromSm2Pem(ByteContainerView pem) {
   return UniquePkey(pri_key, ::EVP_PKEY_free);
 }
 
-UniquePkey CreatePubPkeyFromSm2Pem(ByteContainerView pem) {
+UniquePkey ParseSm2PubPem(ByteContainerView pem) {
   UniqueBio pem_bio(BIO_new_mem_buf(pem.data(), pem.size()), BIO_free);
   EC_KEY* ec_key =
       PEM_read_bio_EC_PUBKEY(pem_bio.get(), nullptr, nullptr, nullptr);
@@ -95,8 +100,154 @@ UniquePkey CreatePubPkeyFromSm2Pem(ByteContainerView pem) {
   return UniquePkey(pub_key, ::EVP_PKEY_free);
 }
 
+UniquePkey RsaToPkey(RSA* rsa) {
+  UniqueRsa unique_rsa(rsa, RSA_free);
+  UniquePkey pkey(EVP_PKEY_new(), ::EVP_PKEY_free);
+  YASL_ENFORCE(pkey != nullptr, "Failed to create evp key.");
+  // the rsa is freed with the pkey from now on.
+  YASL_ENFORCE_EQ(EVP_PKEY_assign_RSA(pkey.get(), unique_rsa.get()), 1);
+  unique_rsa.release();
+  return pkey;
+}
+
+UniquePkey ParseRsaPriPem(ByteContainerView pem) {
+  UniqueBio pem_bio(BIO_new_mem_buf(pem.data(), pem.size()), BIO_free);
+  RSA* rsa =
+      PEM_read_bio_RSAPrivateKey(pem_bio.get(), nullptr, nullptr, nullptr);
+  YASL_ENFORCE(rsa, "Failed to get rsa from pem.");
+  return RsaToPkey(rsa);
+}
+
+UniquePkey ParseRsaPubPem(ByteContainerView pem) {
+  UniqueBio pem_bio(BIO_new_mem_buf(pem.data(), pem.size()), BIO_free);
+  RSA* rsa =
+      PEM_read_bio_RSAPublicKey(pem_bio.get(), nullptr, nullptr, nullptr);
+  YASL_ENFORCE(rsa, "Failed to get rsa from pem.");
+  return RsaToPkey(rsa);
+}
+
+UniquePkey ParseCertPem(ByteContainerView cert_pem) {
+  UniqueBio pem_bio(BIO_new_mem_buf(cert_pem.data(), cert_pem.size()),
+                    BIO_free);
+  UniqueX509 cert(PEM_read_bio_X509(pem_bio.get(), nullptr, nullptr, nullptr),
+                  ::X509_free);
+  YASL_ENFORCE(cert != nullptr, "No X509 from cert.");
+  EVP_PKEY* pkey = X509_get_pubkey(cert.get());
+  YASL_ENFORCE(pkey != nullptr, "No pubkey in x509.");
+  return UniquePkey(pkey, ::EVP_PKEY_free);
+}
+
+// the whole cache is dropped when full, keys are rarely that many.
+constexpr size_t kMaxCachedKeys = 1024;
+
+class PkeyCache {
+ public:
+  static PkeyCache& Instance() {
+    static PkeyCache cache;
+    return cache;
+  }
+
+  UniquePkey Get(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = keys_.find(id);
+    if (it == keys_.end()) {
+      return UniquePkey(nullptr, ::EVP_PKEY_free);
+    }
+    return Ref(it->second.get());
+  }
+
+  // keeps the key cached first.
+  UniquePkey Put(const std::string& id, UniquePkey pkey) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (keys_.size() >= kMaxCachedKeys) {
+      keys_.clear();
+    }
+    auto it = keys_.emplace(id, std::move(pkey)).first;
+    return Ref(it->second.get());
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    keys_.clear();
+  }
+
+  size_t Size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return keys_.size();
+  }
+
+ private:
+  static UniquePkey Ref(EVP_PKEY* pkey) {
+    YASL_ENFORCE_EQ(EVP_PKEY_up_ref(pkey), 1);
+    return UniquePkey(pkey, ::EVP_PKEY_free);
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, UniquePkey> keys_;
+};
+
+}  // namespace
+
+namespace internal {
+
+UniquePkey CachedPkey(
+    std::string_view kind, ByteContainerView pem,
+    const std::function<UniquePkey(ByteContainerView)>& parse) {
+  std::string id(kind);
+  id.push_back('/');
+  id.resize(id.size() + SHA256_DIGEST_LENGTH);
+  SHA256(pem.data(), pem.size(),
+         reinterpret_cast<uint8_t*>(id.data()) + kind.size() + 1);
+
+  auto& cache = PkeyCache::Instance();
+  if (auto pkey = cache.Get(id)) {
+    return pkey;
+  }
+  // parses unlocked, a concurrent parse of the same pem is harmless.
+  auto pkey = parse(pem);
+  YASL_ENFORCE(pkey != nullptr);
+  return cache.Put(id, std::move(pkey));
+}
+
+UniquePkey CreatePriPkeyFromSm2Pem(ByteContainerView pem) {
+  return CachedPkey("sm2 private", pem, ParseSm2PriPem);
+}
+
+UniquePkey CreatePubPkeyFromSm2Pem(ByteContainerView pem) {
+  return CachedPkey("sm2 public", pem, ParseSm2PubPem);
+}
+
+UniquePkey CreatePriPkeyFromRsaPem(ByteContainerView pem) {
+  return CachedPkey("rsa private", pem, ParseRsaPriPem);
+}
+
+UniquePkey CreatePubPkeyFromRsaPem(ByteContainerView pem) {
+  return CachedPkey("rsa public", pem, ParseRsaPubPem);
+}
+
+UniquePkey CreatePubPkeyFromCertPem(ByteContainerView cert_pem) {
+  return CachedPkey("cert", cert_pem, ParseCertPem);
+}
+
+bool DigestVerifyFrom(const EVP_MD_CTX* ready, EVP_MD_CTX* m_ctx,
+                      ByteContainerView message, ByteContainerView signature) {
+  const bool ok =
+      EVP_MD_CTX_copy_ex(m_ctx, ready) > 0 &&
+      EVP_DigestVerifyUpdate(m_ctx, message.data(), message.size()) > 0 &&
+      EVP_DigestVerifyFinal(m_ctx, signature.data(), signature.size()) == 1;
+  if (!ok) {
+    // bad signatures would pile up in the error queue of the thread.
+    ERR_clear_error();
+  }
+  return ok;
+}
+
 }  // namespace internal
 
+void ClearAsymmetricKeyCache() { PkeyCache::Instance().Clear(); }
+
+size_t AsymmetricKeyCacheSize() { return PkeyCache::Instance().Size(); }
+
 std::tuple<std::string, std::string> CreateSm2KeyPair() {
   // Create sm2 curve
   EC_KEY* ec_key = EC_KEY_new();
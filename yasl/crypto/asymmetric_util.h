@@ -14,6 +14,10 @@
 
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -29,12 +33,39 @@ namespace internal {
 
 using UniquePkey = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
 
+// Returns the key parsed by `parse` from `pem`. Parsed keys are cached
+// process wide by `kind` and the sha-256 of the pem, so objects created per
+// request from the same pem share one key and skip the parsing. The returned
+// pointer holds its own reference to the key.
+UniquePkey CachedPkey(
+    std::string_view kind, ByteContainerView pem,
+    const std::function<UniquePkey(ByteContainerView)>& parse);
+
+// All the keys below are cached.
 UniquePkey CreatePriPkeyFromSm2Pem(ByteContainerView pem);
 
 UniquePkey CreatePubPkeyFromSm2Pem(ByteContainerView pem);
 
+UniquePkey CreatePriPkeyFromRsaPem(ByteContainerView pem);
+
+UniquePkey CreatePubPkeyFromRsaPem(ByteContainerView pem);
+
+// the public key of a x509 certificate in pem.
+UniquePkey CreatePubPkeyFromCertPem(ByteContainerView cert_pem);
+
+// Copies `ready`, a context after EVP_DigestVerifyInit, to `m_ctx` and
+// verifies with it. Returns false instead of raising, for batches.
+bool DigestVerifyFrom(const EVP_MD_CTX* ready, EVP_MD_CTX* m_ctx,
+                      ByteContainerView message, ByteContainerView signature);
+
 }  // namespace internal
 
+// Drops the parsed keys cached by CreateFromPem of the signers, verifiers,
+// encryptors and decryptors.
+void ClearAsymmetricKeyCache();
+
+size_t AsymmetricKeyCacheSize();
+
 std::tuple<std::string, std::string> CreateSm2KeyPair();
 
 std::tuple<std::string, std::string> CreateRsaKeyPair();
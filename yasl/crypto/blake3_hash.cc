@@ -14,12 +14,146 @@
 
 #include "yasl/crypto/blake3_hash.h"
 
+#include <cstring>
 #include <vector>
 
+// blake3_compress_in_place and blake3_hash_many hash chunks and parent nodes
+// of the tree without the root finalization of blake3.h. the header has no
+// c++ guard.
+extern "C" {
+#include "c/blake3_impl.h"
+}
+
 #include "yasl/base/exception.h"
+#include "yasl/utils/parallel.h"
 
 namespace yasl::crypto {
 
+namespace {
+
+// Updates from kParallelMinLen on hash subtrees of kSubtreeChunks chunks on
+// the thread pool, which is as fast as the memory once there are enough
+// cores. The chaining values of the subtrees are then pushed to the hasher
+// as blake3_hasher_update does for the subtrees it hashes itself, so the
+// digest is the same.
+constexpr size_t kSubtreeChunks = 256;
+constexpr size_t kSubtreeLen = kSubtreeChunks * BLAKE3_CHUNK_LEN;
+constexpr size_t kParallelMinLen = 4 * kSubtreeLen;
+
+void StoreCv(const uint32_t cv_words[8], uint8_t cv[BLAKE3_OUT_LEN]) {
+  for (size_t i = 0; i < 8; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      cv[4 * i + j] = static_cast<uint8_t>(cv_words[i] >> (8 * j));
+    }
+  }
+}
+
+size_t ChunkStateLen(const blake3_chunk_state& chunk) {
+  return BLAKE3_BLOCK_LEN * chunk.blocks_compressed + chunk.buf_len;
+}
+
+// Same as hasher_merge_cv_stack of blake3.c, which leaves one chaining value
+// per bit of `total_chunks`.
+void MergeCvStack(blake3_hasher* hasher, uint64_t total_chunks) {
+  const size_t post_merge_len = __builtin_popcountll(total_chunks);
+  while (hasher->cv_stack_len > post_merge_len) {
+    uint8_t* parent_node =
+        &hasher->cv_stack[(hasher->cv_stack_len - 2) * BLAKE3_OUT_LEN];
+    uint32_t cv_words[8];
+    std::memcpy(cv_words, hasher->key, sizeof(cv_words));
+    blake3_compress_in_place(cv_words, parent_node, BLAKE3_BLOCK_LEN, 0,
+                             hasher->chunk.flags | PARENT);
+    StoreCv(cv_words, parent_node);
+    hasher->cv_stack_len -= 1;
+  }
+}
+
+void PushCv(blake3_hasher* hasher, const uint8_t cv[BLAKE3_OUT_LEN],
+            uint64_t chunk_counter) {
+  MergeCvStack(hasher, chunk_counter);
+  std::memcpy(&hasher->cv_stack[hasher->cv_stack_len * BLAKE3_OUT_LEN], cv,
+              BLAKE3_OUT_LEN);
+  hasher->cv_stack_len += 1;
+}
+
+// The chaining value of the kSubtreeChunks chunks at `input`, which is never
+// the root.
+void SubtreeCv(const blake3_hasher& hasher, const uint8_t* input,
+               uint64_t chunk_counter, uint8_t cv[BLAKE3_OUT_LEN]) {
+  std::vector<const uint8_t*> inputs(kSubtreeChunks);
+  for (size_t i = 0; i < kSubtreeChunks; ++i) {
+    inputs[i] = input + i * BLAKE3_CHUNK_LEN;
+  }
+  std::vector<uint8_t> cvs(kSubtreeChunks * BLAKE3_OUT_LEN);
+  std::vector<uint8_t> parent_cvs(cvs.size() / 2);
+  blake3_hash_many(inputs.data(), kSubtreeChunks,
+                   BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN, hasher.key,
+                   chunk_counter, true, hasher.chunk.flags, CHUNK_START,
+                   CHUNK_END, cvs.data());
+  for (size_t n = kSubtreeChunks / 2; n > 0; n /= 2) {
+    // a parent node is the two chaining values of its children.
+    for (size_t i = 0; i < n; ++i) {
+      inputs[i] = cvs.data() + i * BLAKE3_BLOCK_LEN;
+    }
+    blake3_hash_many(inputs.data(), n, 1, hasher.key, 0, false,
+                     hasher.chunk.flags | PARENT, 0, 0, parent_cvs.data());
+    cvs.swap(parent_cvs);
+  }
+  std::memcpy(cv, cvs.data(), BLAKE3_OUT_LEN);
+}
+
+void ParallelUpdate(blake3_hasher* hasher, const uint8_t* input,
+                    size_t input_len) {
+  // up to a multiple of kSubtreeLen, after which the chunk state is empty or
+  // holds the last whole chunk.
+  const uint64_t hashed_len = hasher->chunk.chunk_counter * BLAKE3_CHUNK_LEN +
+                              ChunkStateLen(hasher->chunk);
+  const size_t head_len =
+      (kSubtreeLen - hashed_len % kSubtreeLen) % kSubtreeLen;
+  blake3_hasher_update(hasher, input, head_len);
+  input += head_len;
+  input_len -= head_len;
+  if (ChunkStateLen(hasher->chunk) == BLAKE3_CHUNK_LEN) {
+    // more input follows, so it is not the root.
+    uint32_t cv_words[8];
+    std::memcpy(cv_words, hasher->chunk.cv, sizeof(cv_words));
+    blake3_compress_in_place(cv_words, hasher->chunk.buf,
+                             hasher->chunk.buf_len,
+                             hasher->chunk.chunk_counter,
+                             hasher->chunk.flags | CHUNK_END);
+    uint8_t cv[BLAKE3_OUT_LEN];
+    StoreCv(cv_words, cv);
+    PushCv(hasher, cv, hasher->chunk.chunk_counter);
+    std::memcpy(hasher->chunk.cv, hasher->key, sizeof(hasher->chunk.cv));
+    hasher->chunk.chunk_counter += 1;
+    hasher->chunk.blocks_compressed = 0;
+    std::memset(hasher->chunk.buf, 0, sizeof(hasher->chunk.buf));
+    hasher->chunk.buf_len = 0;
+  }
+
+  // at least one byte is left to blake3_hasher_update, which finalizes the
+  // root.
+  const size_t num_subtrees = (input_len - 1) / kSubtreeLen;
+  const uint64_t chunk_counter = hasher->chunk.chunk_counter;
+  std::vector<uint8_t> cvs(num_subtrees * BLAKE3_OUT_LEN);
+  parallel_for(0, num_subtrees, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      SubtreeCv(*hasher, input + i * kSubtreeLen,
+                chunk_counter + i * kSubtreeChunks,
+                cvs.data() + i * BLAKE3_OUT_LEN);
+    }
+  });
+  for (size_t i = 0; i < num_subtrees; ++i) {
+    PushCv(hasher, cvs.data() + i * BLAKE3_OUT_LEN,
+           chunk_counter + i * kSubtreeChunks);
+  }
+  hasher->chunk.chunk_counter += num_subtrees * kSubtreeChunks;
+  blake3_hasher_update(hasher, input + num_subtrees * kSubtreeLen,
+                       input_len - num_subtrees * kSubtreeLen);
+}
+
+}  // namespace
+
 Blake3Hash::Blake3Hash()
     : hash_algo_(HashAlgorithm::BLAKE3), digest_size_(BLAKE3_OUT_LEN) {
   Init();
@@ -47,20 +181,27 @@ Blake3Hash& Blake3Hash::Reset() {
 }
 
 Blake3Hash& Blake3Hash::Update(ByteContainerView data) {
-  blake3_hasher_update(&hasher_ctx_, data.data(), data.size());
+  if (data.size() >= kParallelMinLen) {
+    ParallelUpdate(&hasher_ctx_, data.data(), data.size());
+  } else {
+    blake3_hasher_update(&hasher_ctx_, data.data(), data.size());
+  }
   return *this;
 }
 
 std::vector<uint8_t> Blake3Hash::CumulativeHash() const {
+  std::vector<uint8_t> digest(digest_size_);
+  CumulativeHash(absl::MakeSpan(digest));
+  return digest;
+}
+
+void Blake3Hash::CumulativeHash(absl::Span<uint8_t> digest) const {
+  YASL_ENFORCE_EQ(digest.size(), digest_size_);
   // Do not finalize the internally stored hash context. Instead, finalize a
   // copy of the current context so that the current context can be updated in
   // future calls to Update.
   blake3_hasher blake3_ctx_snapshot = hasher_ctx_;
-
-  std::vector<uint8_t> digest(digest_size_);
   blake3_hasher_finalize(&blake3_ctx_snapshot, digest.data(), digest_size_);
-
-  return digest;
 }
 
 }  // namespace yasl::crypto
@@ -24,6 +24,8 @@ namespace yasl::crypto {
 // https://github.com/BLAKE3-team/BLAKE3-specs/blob/master/blake3.pdf
 // https://github.com/BLAKE3-team/BLAKE3
 // blake3 hash implements HashInterface.
+// Updates of 1 MiB and more are hashed by subtrees on the thread pool of
+// yasl/utils/parallel.h.
 class Blake3Hash : public HashInterface {
  public:
   Blake3Hash();
@@ -36,6 +38,7 @@ class Blake3Hash : public HashInterface {
   Blake3Hash& Reset() override;
   Blake3Hash& Update(ByteContainerView data) override;
   std::vector<uint8_t> CumulativeHash() const override;
+  void CumulativeHash(absl::Span<uint8_t> digest) const override;
 
  private:
   const HashAlgorithm hash_algo_;
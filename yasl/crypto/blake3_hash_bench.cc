@@ -14,6 +14,7 @@
 
 #include <future>
 #include <iostream>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 
@@ -46,4 +47,41 @@ BENCHMARK(BM_Blake3)
     ->Arg(81920)
     ->Arg(1 << 21);
 
+// state.range(0) is the input length in MiB.
+static void BM_Blake3Serial(benchmark::State& state) {
+  std::vector<uint8_t> data(state.range(0) << 20, 0x5a);
+  std::vector<uint8_t> digest(BLAKE3_OUT_LEN);
+  for (auto _ : state) {
+    blake3_hasher hasher;
+    blake3_hasher_init(&hasher);
+    blake3_hasher_update(&hasher, data.data(), data.size());
+    blake3_hasher_finalize(&hasher, digest.data(), digest.size());
+    benchmark::DoNotOptimize(digest.data());
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+static void BM_Blake3Parallel(benchmark::State& state) {
+  std::vector<uint8_t> data(state.range(0) << 20, 0x5a);
+  for (auto _ : state) {
+    yasl::crypto::Blake3Hash blake3;
+    benchmark::DoNotOptimize(blake3.Update(data).CumulativeHash());
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+BENCHMARK(BM_Blake3Serial)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->Arg(16)
+    ->Arg(256)
+    ->Arg(1024);
+
+BENCHMARK(BM_Blake3Parallel)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime()
+    ->Arg(16)
+    ->Arg(256)
+    ->Arg(1024);
+
 BENCHMARK_MAIN();
@@ -14,6 +14,7 @@
 
 #include "yasl/crypto/blake3_hash.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -125,4 +126,38 @@ TEST(Blake3HashTest, CustomOutLength) {
   }
 }
 
+// Updates from 1 MiB on are hashed in parallel, and have to give the digest of
+// the serial hasher, whatever is hashed before and after them.
+TEST(Blake3HashTest, LargeUpdates) {
+  std::vector<uint8_t> data((8 << 20) + 5000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(i % 251);
+  }
+  for (size_t prefix_len : {0, 1, 1024, 5000}) {
+    for (size_t len : {1 << 20, (1 << 20) + 1, 2 << 20, (3 << 20) + 1000,
+                       8 << 20}) {
+      const size_t suffix_len = data.size() - prefix_len - len;
+      for (size_t suffix : {size_t{0}, suffix_len}) {
+        const size_t total_len = prefix_len + len + suffix;
+        blake3_hasher hasher;
+        blake3_hasher_init(&hasher);
+        // below the parallel threshold.
+        for (size_t i = 0; i < total_len; i += 4096) {
+          blake3_hasher_update(&hasher, data.data() + i,
+                               std::min<size_t>(4096, total_len - i));
+        }
+        std::vector<uint8_t> expected(BLAKE3_OUT_LEN);
+        blake3_hasher_finalize(&hasher, expected.data(), expected.size());
+
+        Blake3Hash blake3;
+        blake3.Update({data.data(), prefix_len})
+            .Update({data.data() + prefix_len, len})
+            .Update({data.data() + prefix_len + len, suffix});
+        EXPECT_EQ(blake3.CumulativeHash(), expected)
+            << prefix_len << " " << len << " " << suffix;
+      }
+    }
+  }
+}
+
 }  // namespace yasl::crypto
@@ -0,0 +1,238 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/crhash.h"
+
+#include <algorithm>
+
+#include "yasl/base/exception.h"
+#include "yasl/crypto/aes_ni.h"
+#include "yasl/crypto/symmetric_crypto.h"
+
+#ifdef __x86_64
+#include <immintrin.h>
+#endif
+
+namespace yasl {
+
+namespace {
+
+// the key of RandomOracle::GetDefault().
+constexpr uint128_t kCrHashAesKey = 0x12345678;
+
+constexpr size_t kMaxBlocks = 8;
+
+enum class Mode { kCr, kCcr, kTccr };
+
+uint128_t Sigma(uint128_t x) {
+  const uint64_t hi = static_cast<uint64_t>(x >> 64);
+  const uint64_t lo = static_cast<uint64_t>(x);
+  return MakeUint128(hi ^ lo, hi);
+}
+
+class FixedKeyAes {
+ public:
+  FixedKeyAes()
+      : sym_alg_(SymmetricCrypto::CryptoType::AES128_ECB, kCrHashAesKey) {
+    if (CpuSupportsAesNi()) {
+      use_aes_ni_ = true;
+      AesNiKeySchedule(kCrHashAesKey, &round_keys_);
+    }
+  }
+
+  bool use_aes_ni() const { return use_aes_ni_; }
+  const AesRoundKeys& round_keys() const { return round_keys_; }
+
+  void Encrypt(absl::Span<const uint128_t> in,
+               absl::Span<uint128_t> out) const {
+    sym_alg_.Encrypt(in, out);
+  }
+
+ private:
+  const SymmetricCrypto sym_alg_;
+  bool use_aes_ni_ = false;
+  AesRoundKeys round_keys_{};
+};
+
+const FixedKeyAes& GetFixedKeyAes() {
+  static const FixedKeyAes aes;
+  return aes;
+}
+
+#ifdef __x86_64
+template <size_t N>
+__attribute__((target("aes,sse2"))) inline void AesNiEncryptBlocks(
+    const __m128i* rk, __m128i* b) {
+  for (size_t j = 0; j < N; ++j) {
+    b[j] = _mm_xor_si128(b[j], rk[0]);
+  }
+  for (size_t r = 1; r < 10; ++r) {
+    for (size_t j = 0; j < N; ++j) {
+      b[j] = _mm_aesenc_si128(b[j], rk[r]);
+    }
+  }
+  for (size_t j = 0; j < N; ++j) {
+    b[j] = _mm_aesenclast_si128(b[j], rk[10]);
+  }
+}
+
+// N blocks with their rounds interleaved, all loads before the stores.
+template <Mode mode, size_t N>
+__attribute__((target("aes,sse2"))) inline void AesNiHashBlocks(
+    const __m128i* rk, const uint128_t* in, const uint128_t* tweaks,
+    uint128_t* out) {
+  const __m128i high_mask = _mm_set_epi64x(-1, 0);
+  __m128i x[N];
+  __m128i b[N];
+  for (size_t j = 0; j < N; ++j) {
+    x[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + j));
+    if constexpr (mode == Mode::kCcr) {
+      // sigma, the halves swapped and the high one xor-ed into the high.
+      x[j] = _mm_xor_si128(_mm_shuffle_epi32(x[j], 0x4e),
+                           _mm_and_si128(x[j], high_mask));
+    }
+    b[j] = x[j];
+  }
+  AesNiEncryptBlocks<N>(rk, b);
+  if constexpr (mode == Mode::kTccr) {
+    for (size_t j = 0; j < N; ++j) {
+      x[j] = b[j];
+      b[j] = _mm_xor_si128(
+          b[j], _mm_loadu_si128(reinterpret_cast<const __m128i*>(tweaks + j)));
+    }
+    AesNiEncryptBlocks<N>(rk, b);
+  }
+  for (size_t j = 0; j < N; ++j) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j),
+                     _mm_xor_si128(b[j], x[j]));
+  }
+}
+
+template <Mode mode>
+__attribute__((target("aes,sse2"))) void AesNiHash(
+    const AesRoundKeys& round_keys, const uint128_t* in,
+    const uint128_t* tweaks, uint128_t* out, size_t n) {
+  __m128i rk[11];
+  for (size_t r = 0; r < 11; ++r) {
+    rk[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&round_keys[r]));
+  }
+  // tweaks are only read by tccr.
+  auto tweak_at = [&](size_t i) {
+    return mode == Mode::kTccr ? tweaks + i : nullptr;
+  };
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    AesNiHashBlocks<mode, 8>(rk, in + i, tweak_at(i), out + i);
+  }
+  if (n - i >= 4) {
+    AesNiHashBlocks<mode, 4>(rk, in + i, tweak_at(i), out + i);
+    i += 4;
+  }
+  if (n - i >= 2) {
+    AesNiHashBlocks<mode, 2>(rk, in + i, tweak_at(i), out + i);
+    i += 2;
+  }
+  if (n - i >= 1) {
+    AesNiHashBlocks<mode, 1>(rk, in + i, tweak_at(i), out + i);
+  }
+}
+#endif
+
+// chunks of kMaxBlocks through SymmetricCrypto.
+template <Mode mode>
+void PortableHash(const FixedKeyAes& aes, const uint128_t* in,
+                  const uint128_t* tweaks, uint128_t* out, size_t n) {
+  std::array<uint128_t, kMaxBlocks> x;
+  std::array<uint128_t, kMaxBlocks> y;
+  for (size_t i = 0; i < n; i += kMaxBlocks) {
+    const size_t m = std::min(kMaxBlocks, n - i);
+    for (size_t j = 0; j < m; ++j) {
+      x[j] = mode == Mode::kCcr ? Sigma(in[i + j]) : in[i + j];
+    }
+    aes.Encrypt(absl::MakeConstSpan(x.data(), m), absl::MakeSpan(y.data(), m));
+    if constexpr (mode == Mode::kTccr) {
+      for (size_t j = 0; j < m; ++j) {
+        x[j] = y[j];
+        y[j] ^= tweaks[i + j];
+      }
+      aes.Encrypt(absl::MakeConstSpan(y.data(), m),
+                  absl::MakeSpan(y.data(), m));
+    }
+    for (size_t j = 0; j < m; ++j) {
+      out[i + j] = y[j] ^ x[j];
+    }
+  }
+}
+
+template <Mode mode>
+void Hash(absl::Span<const uint128_t> in, const uint128_t* tweaks,
+          absl::Span<uint128_t> out) {
+  YASL_ENFORCE_EQ(in.size(), out.size());
+  const auto& aes = GetFixedKeyAes();
+#ifdef __x86_64
+  if (aes.use_aes_ni()) {
+    AesNiHash<mode>(aes.round_keys(), in.data(), tweaks, out.data(),
+                    in.size());
+    return;
+  }
+#endif
+  PortableHash<mode>(aes, in.data(), tweaks, out.data(), in.size());
+}
+
+}  // namespace
+
+uint128_t CrHash(uint128_t x) {
+  CrHash(absl::MakeConstSpan(&x, 1), absl::MakeSpan(&x, 1));
+  return x;
+}
+
+uint128_t CcrHash(uint128_t x) {
+  CcrHash(absl::MakeConstSpan(&x, 1), absl::MakeSpan(&x, 1));
+  return x;
+}
+
+uint128_t TccrHash(uint128_t x, uint128_t tweak) {
+  TccrHash(absl::MakeConstSpan(&x, 1), absl::MakeConstSpan(&tweak, 1),
+           absl::MakeSpan(&x, 1));
+  return x;
+}
+
+void CrHash(absl::Span<const uint128_t> in, absl::Span<uint128_t> out) {
+  Hash<Mode::kCr>(in, nullptr, out);
+}
+
+void CcrHash(absl::Span<const uint128_t> in, absl::Span<uint128_t> out) {
+  Hash<Mode::kCcr>(in, nullptr, out);
+}
+
+void TccrHash(absl::Span<const uint128_t> in,
+              absl::Span<const uint128_t> tweaks, absl::Span<uint128_t> out) {
+  YASL_ENFORCE_EQ(in.size(), tweaks.size());
+  Hash<Mode::kTccr>(in, tweaks.data(), out);
+}
+
+void TccrHash(absl::Span<const uint128_t> in, uint128_t first_tweak,
+              absl::Span<uint128_t> out) {
+  YASL_ENFORCE_EQ(in.size(), out.size());
+  std::array<uint128_t, kMaxBlocks> tweaks;
+  for (size_t i = 0; i < in.size(); i += kMaxBlocks) {
+    const size_t n = std::min(kMaxBlocks, in.size() - i);
+    for (size_t j = 0; j < n; ++j) {
+      tweaks[j] = first_tweak + i + j;
+    }
+    Hash<Mode::kTccr>(in.subspan(i, n), tweaks.data(), out.subspan(i, n));
+  }
+}
+
+}  // namespace yasl
@@ -0,0 +1,76 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/int128.h"
+
+namespace yasl {
+
+// Correlation robust hashes on fixed key AES, pi below, of "Efficient and
+// Secure Multiparty Computation from Fixed-Key Block Ciphers" (GKWY20), for
+// OT extensions and garbled circuits. The key is public, the one of
+// RandomOracle::GetDefault(), so pi(x) is RandomOracle::GetDefault().Gen(x).
+//
+// - CR:   H(x) = pi(x) ^ x, for inputs correlated by a fixed unknown delta.
+// - CCR:  H(x) = pi(sigma(x)) ^ sigma(x), circular correlation robust, where
+//         sigma(hi || lo) = (hi ^ lo) || hi is a linear orthomorphism.
+// - TCCR: H(x, i) = pi(pi(x) ^ i) ^ pi(x), tweakable, say by the ot index.
+//
+// The blocks are hashed 8, 4, 2 or 1 at a time with their AES rounds
+// interleaved on AES-NI, and through SymmetricCrypto on other cpus. Inputs
+// and outputs may be the same.
+
+uint128_t CrHash(uint128_t x);
+uint128_t CcrHash(uint128_t x);
+uint128_t TccrHash(uint128_t x, uint128_t tweak);
+
+void CrHash(absl::Span<const uint128_t> in, absl::Span<uint128_t> out);
+void CcrHash(absl::Span<const uint128_t> in, absl::Span<uint128_t> out);
+void TccrHash(absl::Span<const uint128_t> in,
+              absl::Span<const uint128_t> tweaks, absl::Span<uint128_t> out);
+// Tweaks first_tweak, first_tweak + 1, ...
+void TccrHash(absl::Span<const uint128_t> in, uint128_t first_tweak,
+              absl::Span<uint128_t> out);
+
+// Fixed size batches, N of 1, 2, 4 or 8 fills the registers in one pass.
+template <size_t N>
+std::array<uint128_t, N> CrHash(const std::array<uint128_t, N>& x) {
+  std::array<uint128_t, N> out;
+  CrHash(absl::MakeConstSpan(x), absl::MakeSpan(out));
+  return out;
+}
+
+template <size_t N>
+std::array<uint128_t, N> CcrHash(const std::array<uint128_t, N>& x) {
+  std::array<uint128_t, N> out;
+  CcrHash(absl::MakeConstSpan(x), absl::MakeSpan(out));
+  return out;
+}
+
+template <size_t N>
+std::array<uint128_t, N> TccrHash(const std::array<uint128_t, N>& x,
+                                  const std::array<uint128_t, N>& tweaks) {
+  std::array<uint128_t, N> out;
+  TccrHash(absl::MakeConstSpan(x), absl::MakeConstSpan(tweaks),
+           absl::MakeSpan(out));
+  return out;
+}
+
+}  // namespace yasl
@@ -0,0 +1,120 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/crhash.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/crypto/random_oracle.h"
+
+namespace yasl {
+
+namespace {
+
+uint128_t Pi(uint128_t x) { return RandomOracle::GetDefault().Gen(x); }
+
+uint128_t Sigma(uint128_t x) {
+  const uint64_t hi = static_cast<uint64_t>(x >> 64);
+  const uint64_t lo = static_cast<uint64_t>(x);
+  return MakeUint128(hi ^ lo, hi);
+}
+
+std::vector<uint128_t> Inputs(size_t n) {
+  std::vector<uint128_t> in(n);
+  for (size_t i = 0; i < n; ++i) {
+    in[i] = MakeUint128(i * 0x9e3779b97f4a7c15, ~i * 0xc2b2ae3d27d4eb4f);
+  }
+  return in;
+}
+
+}  // namespace
+
+TEST(CrHashTest, MatchesDefinitions) {
+  for (uint128_t x : Inputs(4)) {
+    EXPECT_EQ(CrHash(x), Pi(x) ^ x);
+    EXPECT_EQ(CcrHash(x), Pi(Sigma(x)) ^ Sigma(x));
+    EXPECT_EQ(TccrHash(x, 7), Pi(Pi(x) ^ 7) ^ Pi(x));
+  }
+  // RandomOracle's own crhash.
+  EXPECT_EQ(CrHash(uint128_t(42)), RandomOracle::GetDefault().Gen(42) ^ 42);
+}
+
+TEST(CrHashTest, SpansMatchScalars) {
+  for (size_t n : {0, 1, 3, 7, 8, 15, 100}) {
+    const auto in = Inputs(n);
+    std::vector<uint128_t> tweaks(n);
+    for (size_t i = 0; i < n; ++i) {
+      tweaks[i] = 1000 + i;
+    }
+    std::vector<uint128_t> cr(n);
+    std::vector<uint128_t> ccr(n);
+    std::vector<uint128_t> tccr(n);
+    std::vector<uint128_t> tccr_counter(n);
+    CrHash(in, absl::MakeSpan(cr));
+    CcrHash(in, absl::MakeSpan(ccr));
+    TccrHash(in, tweaks, absl::MakeSpan(tccr));
+    TccrHash(in, 1000, absl::MakeSpan(tccr_counter));
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_EQ(cr[i], CrHash(in[i]));
+      EXPECT_EQ(ccr[i], CcrHash(in[i]));
+      EXPECT_EQ(tccr[i], TccrHash(in[i], tweaks[i]));
+    }
+    EXPECT_EQ(tccr_counter, tccr);
+  }
+}
+
+TEST(CrHashTest, FixedSizes) {
+  const auto in = Inputs(8);
+  std::array<uint128_t, 8> x;
+  std::array<uint128_t, 8> tweaks;
+  for (size_t i = 0; i < 8; ++i) {
+    x[i] = in[i];
+    tweaks[i] = i;
+  }
+  const auto cr = CrHash(x);
+  const auto ccr = CcrHash(x);
+  const auto tccr = TccrHash(x, tweaks);
+  for (size_t i = 0; i < 8; ++i) {
+    EXPECT_EQ(cr[i], CrHash(x[i]));
+    EXPECT_EQ(ccr[i], CcrHash(x[i]));
+    EXPECT_EQ(tccr[i], TccrHash(x[i], i));
+  }
+  EXPECT_EQ(CrHash(std::array<uint128_t, 1>{x[0]})[0], cr[0]);
+}
+
+TEST(CrHashTest, InPlace) {
+  const auto in = Inputs(13);
+  auto cr = in;
+  auto ccr = in;
+  auto tccr = in;
+  CrHash(cr, absl::MakeSpan(cr));
+  CcrHash(ccr, absl::MakeSpan(ccr));
+  TccrHash(tccr, 5, absl::MakeSpan(tccr));
+  for (size_t i = 0; i < in.size(); ++i) {
+    EXPECT_EQ(cr[i], CrHash(in[i]));
+    EXPECT_EQ(ccr[i], CcrHash(in[i]));
+    EXPECT_EQ(tccr[i], TccrHash(in[i], 5 + i));
+  }
+}
+
+TEST(CrHashTest, SizeMismatchThrows) {
+  std::vector<uint128_t> in(4);
+  std::vector<uint128_t> out(3);
+  EXPECT_ANY_THROW(CrHash(in, absl::MakeSpan(out)));
+  EXPECT_ANY_THROW(TccrHash(in, absl::MakeConstSpan(out), absl::MakeSpan(in)));
+}
+
+}  // namespace yasl
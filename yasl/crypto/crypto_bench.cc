@@ -0,0 +1,419 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the crypto primitives, over message sizes, backends and
+// threads, for comparing builds and machines. Each benchmark thread works on
+// its own objects, so `threads:n` is the aggregate throughput of n callers,
+// while the prg runs one fill on n threads of the intra-op pool. Run with
+// `--benchmark_format=json`, or `--benchmark_out=<file>
+// --benchmark_out_format=json`, for machine readable results; the context
+// of the json records the cpu features and backends of the run. Arguments
+// are enum values: CryptoType, PRG_MODE, GcmCryptoSchema, HashAlgorithm and
+// CryptoBackend.
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "yasl/crypto/aes_ni.h"
+#include "yasl/crypto/asymmetric_rsa_crypto.h"
+#include "yasl/crypto/asymmetric_sm2_crypto.h"
+#include "yasl/crypto/asymmetric_util.h"
+#include "yasl/crypto/blake3_hash.h"
+#include "yasl/crypto/digital_envelope.h"
+#include "yasl/crypto/drbg/nist_aes_drbg.h"
+#include "yasl/crypto/drbg/sm4_drbg.h"
+#include "yasl/crypto/gcm_crypto.h"
+#include "yasl/crypto/hmac.h"
+#include "yasl/crypto/ipp_crypto.h"
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/rsa_signing.h"
+#include "yasl/crypto/sm2_signing.h"
+#include "yasl/crypto/sm4_ni.h"
+#include "yasl/crypto/ssl_hash.h"
+#include "yasl/crypto/symmetric_crypto.h"
+#include "yasl/utils/parallel.h"
+
+namespace yasl::crypto {
+namespace {
+
+const std::vector<int64_t> kSizes = {64, 4096, 1 << 20};
+const std::vector<int64_t> kBackends = {
+    static_cast<int64_t>(CryptoBackend::kOpenssl),
+    static_cast<int64_t>(CryptoBackend::kIppCrypto)};
+constexpr int kMaxThreads = 8;
+constexpr size_t kAsymMessageSize = 32;
+
+std::vector<int64_t> Enums(int64_t begin, int64_t end) {
+  std::vector<int64_t> ret;
+  for (int64_t i = begin; i < end; ++i) {
+    ret.push_back(i);
+  }
+  return ret;
+}
+
+// the backend of the process, set back after each run on a given one.
+CryptoBackend default_backend;
+
+// The backend is process wide, so every thread of a run sets the same one.
+class ScopedBackend {
+ public:
+  explicit ScopedBackend(CryptoBackend backend) { SetCryptoBackend(backend); }
+  ~ScopedBackend() { SetCryptoBackend(default_backend); }
+};
+
+// false if the backend is not built in, the run is then reported as skipped.
+bool BackendAvailable(benchmark::State& state, int64_t backend) {
+  if (static_cast<CryptoBackend>(backend) == CryptoBackend::kIppCrypto &&
+      !IppCryptoAvailable()) {
+    state.SkipWithError("IPP-Crypto is not available");
+    return false;
+  }
+  return true;
+}
+
+void SetBytesProcessed(benchmark::State& state, int64_t size) {
+  state.SetBytesProcessed(state.iterations() * size);
+}
+
+const std::tuple<std::string, std::string>& Sm2Keys() {
+  static const auto keys = CreateSm2KeyPair();
+  return keys;
+}
+
+const std::tuple<std::string, std::string>& RsaKeys() {
+  static const auto keys = CreateRsaKeyPair();
+  return keys;
+}
+
+// args: type, size, backend.
+void BM_SymmetricEncrypt(benchmark::State& state) {
+  const int64_t size = state.range(1);
+  if (!BackendAvailable(state, state.range(2))) {
+    return;
+  }
+  ScopedBackend backend(static_cast<CryptoBackend>(state.range(2)));
+  SymmetricCrypto crypto(
+      static_cast<SymmetricCrypto::CryptoType>(state.range(0)), 1234, 5678);
+  std::vector<uint8_t> in(size, 0x5a);
+  std::vector<uint8_t> out(size);
+  for (auto _ : state) {
+    crypto.Encrypt(in, absl::MakeSpan(out));
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetBytesProcessed(state, size);
+}
+
+// args: mode, size, intra-op threads.
+void BM_PrgFill(benchmark::State& state) {
+  const int64_t size = state.range(1);
+  const int prev_threads = get_num_threads();
+  set_num_threads(static_cast<int>(state.range(2)));
+  PseudoRandomGenerator<uint8_t> prg(1234,
+                                     static_cast<PRG_MODE>(state.range(0)));
+  std::vector<uint8_t> out(size);
+  for (auto _ : state) {
+    prg.Fill(absl::MakeSpan(out));
+    benchmark::DoNotOptimize(out.data());
+  }
+  set_num_threads(prev_threads);
+  SetBytesProcessed(state, size);
+}
+
+// args: size.
+template <typename Drbg>
+void BM_DrbgFill(benchmark::State& state) {
+  const int64_t size = state.range(0);
+  Drbg drbg(1234);
+  std::vector<uint8_t> out(size);
+  for (auto _ : state) {
+    drbg.FillRandomBytes(absl::MakeSpan(out));
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetBytesProcessed(state, size);
+}
+
+// args: schema, size, backend.
+void BM_GcmEncrypt(benchmark::State& state) {
+  const auto schema = static_cast<GcmCryptoSchema>(state.range(0));
+  const int64_t size = state.range(1);
+  if (!BackendAvailable(state, state.range(2))) {
+    return;
+  }
+  ScopedBackend backend(static_cast<CryptoBackend>(state.range(2)));
+  const std::string key(schema == GcmCryptoSchema::AES128_GCM ? 16 : 32, 'k');
+  GcmCrypto crypto(schema, key, "123456781234");
+  std::vector<uint8_t> in(size, 0x5a);
+  std::vector<uint8_t> out(size);
+  std::vector<uint8_t> mac(16);
+  for (auto _ : state) {
+    crypto.Encrypt(in, "", absl::MakeSpan(out), absl::MakeSpan(mac));
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetBytesProcessed(state, size);
+}
+
+// args: hash algorithm, size.
+void BM_Hmac(benchmark::State& state) {
+  const int64_t size = state.range(1);
+  Hmac hmac(static_cast<HashAlgorithm>(state.range(0)), "hmac key");
+  std::vector<uint8_t> in(size, 0x5a);
+  std::vector<uint8_t> mac(hmac.MacSize());
+  for (auto _ : state) {
+    hmac.Reset().Update(in).CumulativeMac(absl::MakeSpan(mac));
+    benchmark::DoNotOptimize(mac.data());
+  }
+  SetBytesProcessed(state, size);
+}
+
+// args: hash algorithm, size, backend. BLAKE3 is always Blake3Hash.
+void BM_Hash(benchmark::State& state) {
+  const auto hash_algo = static_cast<HashAlgorithm>(state.range(0));
+  const int64_t size = state.range(1);
+  if (!BackendAvailable(state, state.range(2))) {
+    return;
+  }
+  ScopedBackend backend(static_cast<CryptoBackend>(state.range(2)));
+  std::unique_ptr<HashInterface> hash;
+  if (hash_algo == HashAlgorithm::BLAKE3) {
+    hash = std::make_unique<Blake3Hash>();
+  } else {
+    hash = std::make_unique<SslHash>(hash_algo);
+  }
+  std::vector<uint8_t> in(size, 0x5a);
+  std::vector<uint8_t> digest(hash->DigestSize());
+  for (auto _ : state) {
+    hash->Reset().Update(in).CumulativeHash(absl::MakeSpan(digest));
+    benchmark::DoNotOptimize(digest.data());
+  }
+  SetBytesProcessed(state, size);
+}
+
+std::unique_ptr<AsymmetricSigner> CreateSigner(SignatureScheme scheme) {
+  if (scheme == SignatureScheme::SM2_SIGNING_SM3_HASH) {
+    return Sm2Signer::CreateFromPem(std::get<1>(Sm2Keys()));
+  }
+  return RsaSigner::CreateFromPem(std::get<1>(RsaKeys()));
+}
+
+std::unique_ptr<AsymmetricVerifier> CreateVerifier(SignatureScheme scheme) {
+  if (scheme == SignatureScheme::SM2_SIGNING_SM3_HASH) {
+    return Sm2Verifier::CreateFromPem(std::get<0>(Sm2Keys()));
+  }
+  return RsaVerifier::CreateFromPem(std::get<0>(RsaKeys()));
+}
+
+void BM_Sign(benchmark::State& state, SignatureScheme scheme) {
+  const auto signer = CreateSigner(scheme);
+  const std::string message(kAsymMessageSize, 'm');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(signer->Sign(message));
+  }
+}
+
+void BM_Verify(benchmark::State& state, SignatureScheme scheme) {
+  const auto signature = CreateSigner(scheme)->Sign("message");
+  const auto verifier = CreateVerifier(scheme);
+  for (auto _ : state) {
+    verifier->Verify("message", signature);
+  }
+}
+
+void BM_AsymEncrypt(benchmark::State& state, bool sm2) {
+  std::unique_ptr<AsymmetricEncryptor> encryptor;
+  if (sm2) {
+    encryptor = Sm2Encryptor::CreateFromPem(std::get<0>(Sm2Keys()));
+  } else {
+    encryptor = RsaEncryptor::CreateFromPem(std::get<0>(RsaKeys()));
+  }
+  const std::string message(kAsymMessageSize, 'm');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(encryptor->Encrypt(message));
+  }
+}
+
+void BM_AsymDecrypt(benchmark::State& state, bool sm2) {
+  std::unique_ptr<AsymmetricDecryptor> decryptor;
+  std::vector<uint8_t> ciphertext;
+  const std::string message(kAsymMessageSize, 'm');
+  if (sm2) {
+    ciphertext = Sm2Encryptor::CreateFromPem(std::get<0>(Sm2Keys()))
+                     ->Encrypt(message);
+    decryptor = Sm2Decryptor::CreateFromPem(std::get<1>(Sm2Keys()));
+  } else {
+    ciphertext = RsaEncryptor::CreateFromPem(std::get<0>(RsaKeys()))
+                     ->Encrypt(message);
+    decryptor = RsaDecryptor::CreateFromPem(std::get<1>(RsaKeys()));
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(decryptor->Decrypt(ciphertext));
+  }
+}
+
+// args: size.
+void BM_SmEnvSeal(benchmark::State& state) {
+  const int64_t size = state.range(0);
+  const std::string plaintext(size, 'p');
+  std::vector<uint8_t> encrypted_key;
+  std::vector<uint8_t> ciphertext;
+  for (auto _ : state) {
+    SmEnvSeal(std::get<0>(Sm2Keys()), "1234567812345678", plaintext,
+              &encrypted_key, &ciphertext);
+  }
+  SetBytesProcessed(state, size);
+}
+
+void BM_SmEnvOpen(benchmark::State& state) {
+  const int64_t size = state.range(0);
+  std::vector<uint8_t> encrypted_key;
+  std::vector<uint8_t> ciphertext;
+  SmEnvSeal(std::get<0>(Sm2Keys()), "1234567812345678", std::string(size, 'p'),
+            &encrypted_key, &ciphertext);
+  std::vector<uint8_t> plaintext;
+  for (auto _ : state) {
+    SmEnvOpen(std::get<1>(Sm2Keys()), "1234567812345678", encrypted_key,
+              ciphertext, &plaintext);
+  }
+  SetBytesProcessed(state, size);
+}
+
+void BM_RsaEnvSeal(benchmark::State& state) {
+  const int64_t size = state.range(0);
+  const std::string plaintext(size, 'p');
+  std::vector<uint8_t> encrypted_key;
+  std::vector<uint8_t> ciphertext;
+  std::vector<uint8_t> mac;
+  for (auto _ : state) {
+    RsaEnvSeal(std::get<0>(RsaKeys()), "123456781234", plaintext,
+               &encrypted_key, &ciphertext, &mac);
+  }
+  SetBytesProcessed(state, size);
+}
+
+void BM_RsaEnvOpen(benchmark::State& state) {
+  const int64_t size = state.range(0);
+  std::vector<uint8_t> encrypted_key;
+  std::vector<uint8_t> ciphertext;
+  std::vector<uint8_t> mac;
+  RsaEnvSeal(std::get<0>(RsaKeys()), "123456781234", std::string(size, 'p'),
+             &encrypted_key, &ciphertext, &mac);
+  std::vector<uint8_t> plaintext;
+  for (auto _ : state) {
+    RsaEnvOpen(std::get<1>(RsaKeys()), "123456781234", encrypted_key,
+               ciphertext, mac, &plaintext);
+  }
+  SetBytesProcessed(state, size);
+}
+
+}  // namespace
+
+BENCHMARK(BM_SymmetricEncrypt)
+    ->ArgNames({"type", "size", "backend"})
+    ->ArgsProduct({Enums(0, 6), kSizes, kBackends})
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+BENCHMARK(BM_PrgFill)
+    ->ArgNames({"mode", "size", "threads"})
+    ->ArgsProduct({Enums(0, 4), kSizes, {1, 2, 4, kMaxThreads}})
+    ->UseRealTime();
+
+BENCHMARK_TEMPLATE(BM_DrbgFill, NistAesDrbg)
+    ->ArgNames({"size"})
+    ->ArgsProduct({kSizes})
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_DrbgFill, Sm4Drbg)
+    ->ArgNames({"size"})
+    ->ArgsProduct({kSizes})
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+BENCHMARK(BM_GcmEncrypt)
+    ->ArgNames({"schema", "size", "backend"})
+    ->ArgsProduct({Enums(0, 2), kSizes, kBackends})
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+BENCHMARK(BM_Hmac)
+    ->ArgNames({"hash", "size"})
+    ->ArgsProduct({{static_cast<int64_t>(HashAlgorithm::SHA256),
+                    static_cast<int64_t>(HashAlgorithm::SM3)},
+                   kSizes})
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+BENCHMARK(BM_Hash)
+    ->ArgNames({"hash", "size", "backend"})
+    ->ArgsProduct({{static_cast<int64_t>(HashAlgorithm::SHA256),
+                    static_cast<int64_t>(HashAlgorithm::SM3),
+                    static_cast<int64_t>(HashAlgorithm::BLAKE2B),
+                    static_cast<int64_t>(HashAlgorithm::BLAKE3)},
+                   kSizes, kBackends})
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+BENCHMARK_CAPTURE(BM_Sign, Sm2, SignatureScheme::SM2_SIGNING_SM3_HASH)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_Sign, Rsa, SignatureScheme::RSA_SIGNING_SHA256_HASH)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_Verify, Sm2, SignatureScheme::SM2_SIGNING_SM3_HASH)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_Verify, Rsa, SignatureScheme::RSA_SIGNING_SHA256_HASH)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_AsymEncrypt, Sm2, true)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_AsymEncrypt, Rsa, false)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_AsymDecrypt, Sm2, true)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_AsymDecrypt, Rsa, false)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+BENCHMARK(BM_SmEnvSeal)->ArgNames({"size"})->ArgsProduct({kSizes});
+BENCHMARK(BM_SmEnvOpen)->ArgNames({"size"})->ArgsProduct({kSizes});
+BENCHMARK(BM_RsaEnvSeal)->ArgNames({"size"})->ArgsProduct({kSizes});
+BENCHMARK(BM_RsaEnvOpen)->ArgNames({"size"})->ArgsProduct({kSizes});
+
+}  // namespace yasl::crypto
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  auto bool_str = [](bool b) { return b ? "true" : "false"; };
+  yasl::crypto::default_backend = yasl::crypto::GetCryptoBackend();
+  benchmark::AddCustomContext("aes_ni", bool_str(yasl::CpuSupportsAesNi()));
+  benchmark::AddCustomContext("vaes", bool_str(yasl::CpuSupportsVaes()));
+  benchmark::AddCustomContext("sm4_ni", bool_str(yasl::CpuSupportsSm4Ni()));
+  benchmark::AddCustomContext(
+      "ipp_crypto", bool_str(yasl::crypto::IppCryptoAvailable()));
+  benchmark::AddCustomContext("intra_op_threads",
+                              std::to_string(yasl::get_num_threads()));
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,189 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/cuckoo_hash.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "yasl/base/cpu_dispatch.h"
+#include "yasl/base/exception.h"
+#include "yasl/crypto/crhash.h"
+#include "yasl/crypto/hash_util.h"
+#include "yasl/utils/parallel.h"
+
+#ifdef __x86_64
+#include <immintrin.h>
+#endif
+
+namespace yasl {
+
+namespace {
+
+// items hashed by one task at least.
+constexpr int64_t kHashGrainSize = 4096;
+// items hashed in one pass through the stack buffers.
+constexpr size_t kHashChunk = 256;
+// items whose bins are prefetched ahead of the insertion.
+constexpr size_t kPrefetchDistance = 8;
+
+void FastRangeScalar(const uint32_t* words, uint32_t num_bins, uint32_t* out,
+                     size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = static_cast<uint32_t>(
+        (static_cast<uint64_t>(words[i]) * num_bins) >> 32);
+  }
+}
+
+#ifdef __x86_64
+__attribute__((target("avx2"))) void FastRangeAvx2(const uint32_t* words,
+                                                   uint32_t num_bins,
+                                                   uint32_t* out, size_t n) {
+  const __m256i m = _mm256_set1_epi64x(num_bins);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i w =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+    // the products of the even and of the odd words.
+    const __m256i even = _mm256_mul_epu32(w, m);
+    const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(w, 32), m);
+    // their high halves, back in place.
+    const __m256i r =
+        _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+  }
+  FastRangeScalar(words + i, num_bins, out + i, n - i);
+}
+#endif
+
+using FastRangeFn = void (*)(const uint32_t* words, uint32_t num_bins,
+                              uint32_t* out, size_t n);
+
+FastRangeFn SelectFastRange() {
+  CpuDispatch<FastRangeFn> dispatch("cuckoo.fast_range", FastRangeScalar);
+#ifdef __x86_64
+  dispatch.Add(kIsaAvx2, FastRangeAvx2);
+#endif
+  return dispatch.Bind();
+}
+
+void FastRange(const uint32_t* words, uint32_t num_bins, uint32_t* out,
+               size_t n) {
+  static const FastRangeFn kFastRange = SelectFastRange();
+  kFastRange(words, num_bins, out, n);
+}
+
+// hashes of items[begin, end) to out[num_hashes * begin, ...).
+void HashRange(absl::Span<const uint128_t> items, size_t num_hashes,
+               uint32_t num_bins, size_t begin, size_t end, uint32_t* out) {
+  std::array<uint128_t, kHashChunk> blocks;
+  std::array<uint32_t, kMaxCuckooHashes * kHashChunk> bins;
+  for (size_t i = begin; i < end; i += kHashChunk) {
+    const size_t n = std::min(kHashChunk, end - i);
+    CrHash(items.subspan(i, n), absl::MakeSpan(blocks.data(), n));
+    // word j of a block is its bits [32 j, 32 j + 32).
+    const auto* words = reinterpret_cast<const uint32_t*>(blocks.data());
+    if (num_hashes == kMaxCuckooHashes) {
+      FastRange(words, num_bins, out + kMaxCuckooHashes * i,
+                kMaxCuckooHashes * n);
+      continue;
+    }
+    FastRange(words, num_bins, bins.data(), kMaxCuckooHashes * n);
+    for (size_t k = 0; k < n; ++k) {
+      std::memcpy(out + num_hashes * (i + k), &bins[kMaxCuckooHashes * k],
+                  num_hashes * sizeof(uint32_t));
+    }
+  }
+}
+
+}  // namespace
+
+void CuckooHashToBins(absl::Span<const uint128_t> items, size_t num_hashes,
+                      uint32_t num_bins, absl::Span<uint32_t> out) {
+  YASL_ENFORCE(num_hashes > 0 && num_hashes <= kMaxCuckooHashes,
+               "{} hashes out of [1, {}]", num_hashes, kMaxCuckooHashes);
+  YASL_ENFORCE_GT(num_bins, 0u);
+  YASL_ENFORCE_EQ(out.size(), items.size() * num_hashes);
+  parallel_for(0, items.size(), kHashGrainSize,
+               [&](int64_t begin, int64_t end) {
+                 HashRange(items, num_hashes, num_bins, begin, end,
+                           out.data());
+               });
+}
+
+void CuckooHashToBins(absl::Span<const ByteContainerView> items,
+                      size_t num_hashes, uint32_t num_bins,
+                      absl::Span<uint32_t> out) {
+  std::vector<uint128_t> blocks(items.size());
+  parallel_for(0, items.size(), kHashGrainSize,
+               [&](int64_t begin, int64_t end) {
+                 for (int64_t i = begin; i < end; ++i) {
+                   blocks[i] = crypto::Blake3_128(items[i]);
+                 }
+               });
+  CuckooHashToBins(blocks, num_hashes, num_bins, out);
+}
+
+CuckooHashTable::CuckooHashTable(size_t max_items, size_t num_hashes,
+                                 double scale_factor, size_t max_evictions)
+    : num_hashes_(num_hashes),
+      num_bins_(static_cast<uint32_t>(std::max(
+          1.0, std::ceil(static_cast<double>(max_items) * scale_factor)))),
+      max_evictions_(max_evictions) {
+  YASL_ENFORCE(num_hashes_ > 0 && num_hashes_ <= kMaxCuckooHashes,
+               "{} hashes out of [1, {}]", num_hashes_, kMaxCuckooHashes);
+  YASL_ENFORCE(std::ceil(static_cast<double>(max_items) * scale_factor) <
+                   static_cast<double>(std::numeric_limits<uint32_t>::max()),
+               "too many bins for {} items", max_items);
+  bins_.resize(num_bins_);
+}
+
+void CuckooHashTable::Insert(absl::Span<const uint128_t> items) {
+  const uint64_t first = num_items();
+  hashes_.resize((first + items.size()) * num_hashes_);
+  CuckooHashToBins(items, num_hashes_, num_bins_,
+                   absl::MakeSpan(hashes_).subspan(first * num_hashes_));
+
+  for (size_t i = 0; i < items.size(); ++i) {
+    if (i + kPrefetchDistance < items.size()) {
+      for (uint32_t bin : ItemBins(first + i + kPrefetchDistance)) {
+        __builtin_prefetch(&bins_[bin], 1);
+      }
+    }
+    InsertItem(first + i);
+  }
+}
+
+void CuckooHashTable::InsertItem(uint64_t item) {
+  Bin moving{item, 0};
+  for (size_t evictions = 0; evictions <= max_evictions_; ++evictions) {
+    const auto item_bins = ItemBins(moving.item);
+    for (size_t j = 0; j < num_hashes_; ++j) {
+      Bin& bin = bins_[item_bins[j]];
+      if (bin.item == kEmpty) {
+        bin = {moving.item, static_cast<uint32_t>(j)};
+        return;
+      }
+    }
+    // the evicted item tries its next hash function.
+    std::swap(moving, bins_[item_bins[moving.hash_index]]);
+    moving.hash_index = (moving.hash_index + 1) % num_hashes_;
+  }
+  stash_.push_back(moving.item);
+}
+
+}  // namespace yasl
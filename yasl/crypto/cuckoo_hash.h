@@ -0,0 +1,101 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/byte_container_view.h"
+#include "yasl/base/int128.h"
+
+namespace yasl {
+
+// Up to this many hash functions, one per 32-bit word of a block.
+inline constexpr size_t kMaxCuckooHashes = 4;
+
+// Hashes items into bins for cuckoo hashing, say of the KKRT PSI.
+//
+// h_j(x) for j < num_hashes is the j-th 32-bit word of CrHash(x), the fixed
+// key AES hash of crhash.h, reduced into [0, num_bins) by the multiply-shift
+// of Lemire's fastrange, (word * num_bins) >> 32. Items are hashed 8 blocks a
+// time on AES-NI and reduced 8 words a time on AVX2, chunks of them on the
+// thread pool.
+//
+// out[num_hashes * i + j] = h_j(items[i]).
+void CuckooHashToBins(absl::Span<const uint128_t> items, size_t num_hashes,
+                      uint32_t num_bins, absl::Span<uint32_t> out);
+
+// Items of bytes, reduced to 128 bits by Blake3_128 first.
+void CuckooHashToBins(absl::Span<const ByteContainerView> items,
+                      size_t num_hashes, uint32_t num_bins,
+                      absl::Span<uint32_t> out);
+
+// Cuckoo hash table of the items inserted, by their indices.
+//
+// The hashes of a batch of items are computed by CuckooHashToBins up front.
+// An item goes to the first empty bin of its hash functions, else it evicts
+// the item of one of them, which moves on to its next hash function, up to
+// max_evictions times before the item left over goes to the stash.
+class CuckooHashTable {
+ public:
+  static constexpr uint64_t kEmpty = std::numeric_limits<uint64_t>::max();
+
+  struct Bin {
+    // index of the item, kEmpty if none.
+    uint64_t item = kEmpty;
+    // the hash function that maps the item here.
+    uint32_t hash_index = 0;
+  };
+
+  // num_bins = ceil(max_items * scale_factor), 1.27 bins per item with 3
+  // hashes leave the stash empty with high probability.
+  explicit CuckooHashTable(size_t max_items, size_t num_hashes = 3,
+                           double scale_factor = 1.27,
+                           size_t max_evictions = 500);
+
+  // The items are indexed from the number of items inserted so far.
+  void Insert(absl::Span<const uint128_t> items);
+
+  size_t num_hashes() const { return num_hashes_; }
+  uint32_t num_bins() const { return num_bins_; }
+  size_t num_items() const { return hashes_.size() / num_hashes_; }
+
+  const std::vector<Bin>& bins() const { return bins_; }
+  const std::vector<uint64_t>& stash() const { return stash_; }
+
+  // the bins of the hash functions of an item.
+  absl::Span<const uint32_t> ItemBins(uint64_t item) const {
+    return absl::MakeConstSpan(hashes_.data() + item * num_hashes_,
+                               num_hashes_);
+  }
+
+ private:
+  void InsertItem(uint64_t item);
+
+  const size_t num_hashes_;
+  const uint32_t num_bins_;
+  const size_t max_evictions_;
+
+  std::vector<Bin> bins_;
+  std::vector<uint64_t> stash_;
+  // num_hashes_ bins per item.
+  std::vector<uint32_t> hashes_;
+};
+
+}  // namespace yasl
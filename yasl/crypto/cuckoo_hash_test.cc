@@ -0,0 +1,117 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/cuckoo_hash.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/crypto/crhash.h"
+#include "yasl/crypto/hash_util.h"
+
+namespace yasl {
+
+namespace {
+
+std::vector<uint128_t> RandomItems(size_t n) {
+  std::mt19937_64 rng(n);
+  std::vector<uint128_t> items(n);
+  for (auto& item : items) {
+    item = MakeUint128(rng(), rng());
+  }
+  return items;
+}
+
+uint32_t Bin(uint128_t item, size_t j, uint32_t num_bins) {
+  const auto word = static_cast<uint32_t>(CrHash(item) >> (32 * j));
+  return static_cast<uint32_t>((static_cast<uint64_t>(word) * num_bins) >> 32);
+}
+
+}  // namespace
+
+TEST(CuckooHashTest, HashToBins) {
+  const auto items = RandomItems(1001);
+  for (size_t num_hashes = 1; num_hashes <= kMaxCuckooHashes; ++num_hashes) {
+    std::vector<uint32_t> bins(items.size() * num_hashes);
+    CuckooHashToBins(items, num_hashes, 12345, absl::MakeSpan(bins));
+    for (size_t i = 0; i < items.size(); ++i) {
+      for (size_t j = 0; j < num_hashes; ++j) {
+        EXPECT_EQ(bins[num_hashes * i + j], Bin(items[i], j, 12345));
+        EXPECT_LT(bins[num_hashes * i + j], 12345);
+      }
+    }
+  }
+
+  std::vector<uint32_t> bins(5);
+  EXPECT_ANY_THROW(CuckooHashToBins(items, 5, 10, absl::MakeSpan(bins)));
+  EXPECT_ANY_THROW(CuckooHashToBins(items, 3, 10, absl::MakeSpan(bins)));
+}
+
+TEST(CuckooHashTest, HashBytesToBins) {
+  const std::vector<std::string> strs = {"alice", "bob", "carol"};
+  const std::vector<ByteContainerView> items(strs.begin(), strs.end());
+  std::vector<uint32_t> bins(3 * items.size());
+  CuckooHashToBins(items, 3, 100, absl::MakeSpan(bins));
+  for (size_t i = 0; i < items.size(); ++i) {
+    const uint128_t item = crypto::Blake3_128(items[i]);
+    for (size_t j = 0; j < 3; ++j) {
+      EXPECT_EQ(bins[3 * i + j], Bin(item, j, 100));
+    }
+  }
+}
+
+TEST(CuckooHashTest, TablePlacesEveryItem) {
+  constexpr size_t kItems = 100000;
+  const auto items = RandomItems(kItems);
+  CuckooHashTable table(kItems);
+  // in two batches.
+  table.Insert(absl::MakeConstSpan(items).first(kItems / 3));
+  table.Insert(absl::MakeConstSpan(items).subspan(kItems / 3));
+  ASSERT_EQ(table.num_items(), kItems);
+
+  std::vector<int> seen(kItems, 0);
+  for (uint32_t b = 0; b < table.num_bins(); ++b) {
+    const auto& bin = table.bins()[b];
+    if (bin.item == CuckooHashTable::kEmpty) {
+      continue;
+    }
+    seen[bin.item]++;
+    EXPECT_EQ(table.ItemBins(bin.item)[bin.hash_index], b);
+    EXPECT_EQ(Bin(items[bin.item], bin.hash_index, table.num_bins()), b);
+  }
+  for (uint64_t item : table.stash()) {
+    seen[item]++;
+  }
+  for (size_t i = 0; i < kItems; ++i) {
+    EXPECT_EQ(seen[i], 1) << i;
+  }
+  EXPECT_LE(table.stash().size(), 4);
+}
+
+TEST(CuckooHashTest, OverfullTableStashes) {
+  const auto items = RandomItems(100);
+  CuckooHashTable table(50, 2, 1.0, 10);
+  table.Insert(items);
+  size_t placed = 0;
+  for (const auto& bin : table.bins()) {
+    placed += bin.item != CuckooHashTable::kEmpty;
+  }
+  EXPECT_EQ(placed + table.stash().size(), items.size());
+  EXPECT_GE(table.stash().size(), 50);
+}
+
+}  // namespace yasl
@@ -14,10 +14,13 @@
 
 #include "yasl/crypto/digital_envelope.h"
 
+#include <algorithm>
+#include <functional>
 #include <random>
 
 #include "absl/types/span.h"
 
+#include "yasl/base/exception.h"
 #include "yasl/crypto/asymmetric_rsa_crypto.h"
 #include "yasl/crypto/asymmetric_sm2_crypto.h"
 #include "yasl/crypto/gcm_crypto.h"
@@ -26,6 +29,7 @@
 #include "yasl/crypto/sm4_mac.h"
 #include "yasl/crypto/ssl_hash.h"
 #include "yasl/crypto/symmetric_crypto.h"
+#include "yasl/utils/parallel.h"
 
 namespace yasl::crypto {
 namespace {
@@ -39,6 +43,99 @@ std::vector<uint8_t> GenRandKey(size_t key_size) {
   return symmetric_key;
 }
 
+constexpr size_t kGcmMacSize = 16;
+constexpr size_t kSm4MteOverhead = 32;
+// segments read and sealed at once.
+constexpr size_t kStreamBatch = 64;
+
+// (index << 1 | last) xor the first 8 bytes of `iv`. The sm4-ctr counter
+// runs in the low bytes, so the keystreams of segments do not overlap.
+std::vector<uint8_t> SegmentIv(ByteContainerView iv, uint64_t index,
+                               bool last) {
+  YASL_ENFORCE(iv.size() >= 8);
+  YASL_ENFORCE(index < (uint64_t{1} << 63), "Too many segments.");
+  std::vector<uint8_t> segment_iv(iv.begin(), iv.end());
+  const uint64_t tweak = index << 1 | (last ? 1 : 0);
+  for (size_t i = 0; i < 8; i++) {
+    segment_iv[7 - i] ^= static_cast<uint8_t>(tweak >> (8 * i));
+  }
+  return segment_iv;
+}
+
+// Reads until `length` bytes or the end of `in`, Read may return less.
+size_t ReadFull(io::InputStream* in, uint8_t* buf, size_t length) {
+  size_t total = 0;
+  while (total < length) {
+    const size_t pos = in->Tellg();
+    in->Read(buf + total, length - total);
+    const size_t n = in->Tellg() - pos;
+    if (n == 0) {
+      break;
+    }
+    total += n;
+  }
+  return total;
+}
+
+// fn(index, last, in, out) seals or opens one segment.
+using SegmentFn =
+    std::function<void(uint64_t, bool, ByteContainerView, absl::Span<uint8_t>)>;
+
+void SealStream(io::InputStream* in, io::OutputStream* out,
+                size_t segment_size, size_t overhead, const SegmentFn& seal) {
+  YASL_ENFORCE(segment_size > 0);
+  const size_t sealed_size = segment_size + overhead;
+  std::vector<uint8_t> plain(kStreamBatch * segment_size);
+  std::vector<uint8_t> sealed(kStreamBatch * sealed_size);
+  uint64_t index = 0;
+  bool done = false;
+  while (!done) {
+    const size_t n = ReadFull(in, plain.data(), plain.size());
+    done = n < plain.size();
+    // a short read ends with a short, maybe empty, last segment.
+    const size_t num_segments = n / segment_size + (done ? 1 : 0);
+    parallel_for(0, num_segments, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        const size_t size = std::min(segment_size, n - i * segment_size);
+        const bool last = done && i + 1 == (int64_t)num_segments;
+        seal(index + i, last,
+             ByteContainerView(plain.data() + i * segment_size, size),
+             absl::MakeSpan(sealed.data() + i * sealed_size, size + overhead));
+      }
+    });
+    out->Write(sealed.data(), n + num_segments * overhead);
+    index += num_segments;
+  }
+}
+
+void OpenStream(io::InputStream* in, io::OutputStream* out,
+                size_t segment_size, size_t overhead, const SegmentFn& open) {
+  YASL_ENFORCE(segment_size > 0);
+  const size_t sealed_size = segment_size + overhead;
+  std::vector<uint8_t> sealed(kStreamBatch * sealed_size);
+  std::vector<uint8_t> plain(kStreamBatch * segment_size);
+  uint64_t index = 0;
+  bool done = false;
+  while (!done) {
+    const size_t n = ReadFull(in, sealed.data(), sealed.size());
+    done = n < sealed.size();
+    const size_t num_segments = n / sealed_size + (done ? 1 : 0);
+    YASL_ENFORCE(!done || n % sealed_size >= overhead,
+                 "Sealed stream is truncated.");
+    parallel_for(0, num_segments, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        const size_t size = std::min(sealed_size, n - i * sealed_size);
+        const bool last = done && i + 1 == (int64_t)num_segments;
+        open(index + i, last,
+             ByteContainerView(sealed.data() + i * sealed_size, size),
+             absl::MakeSpan(plain.data() + i * segment_size, size - overhead));
+      }
+    });
+    out->Write(plain.data(), n - num_segments * overhead);
+    index += num_segments;
+  }
+}
+
 }  // namespace
 
 void SmEnvSeal(ByteContainerView pub_key, ByteContainerView iv,
@@ -86,4 +183,77 @@ void RsaEnvOpen(ByteContainerView pri_key, ByteContainerView iv,
       .Decrypt(ciphertext, "", mac, absl::Span<uint8_t>(*plaintext));
 }
 
+void SmEnvSealStream(ByteContainerView pub_key, ByteContainerView iv,
+                     io::InputStream* in, io::OutputStream* out,
+                     std::vector<uint8_t>* encrypted_key,
+                     size_t segment_size) {
+  YASL_ENFORCE_EQ(iv.size(), 16U);
+  std::vector<uint8_t> symmetric_key = GenRandKey(16);
+  *encrypted_key = Sm2Encryptor::CreateFromPem(pub_key)->Encrypt(symmetric_key);
+  SealStream(in, out, segment_size, kSm4MteOverhead,
+             [&](uint64_t index, bool last, ByteContainerView plaintext,
+                 absl::Span<uint8_t> ciphertext) {
+               auto sealed = Sm4MteEncrypt(
+                   symmetric_key, SegmentIv(iv, index, last), plaintext);
+               YASL_ENFORCE_EQ(sealed.size(), ciphertext.size());
+               std::copy(sealed.begin(), sealed.end(), ciphertext.begin());
+             });
+}
+
+void SmEnvOpenStream(ByteContainerView pri_key, ByteContainerView iv,
+                     ByteContainerView encrypted_key, io::InputStream* in,
+                     io::OutputStream* out, size_t segment_size) {
+  YASL_ENFORCE_EQ(iv.size(), 16U);
+  std::vector<uint8_t> symmetric_key =
+      Sm2Decryptor::CreateFromPem(pri_key)->Decrypt(encrypted_key);
+  OpenStream(in, out, segment_size, kSm4MteOverhead,
+             [&](uint64_t index, bool last, ByteContainerView ciphertext,
+                 absl::Span<uint8_t> plaintext) {
+               // Sm4MteDecrypt takes no empty plaintext, check it here.
+               if (plaintext.empty()) {
+                 auto expected = Sm4MteEncrypt(
+                     symmetric_key, SegmentIv(iv, index, last), "");
+                 YASL_ENFORCE(std::equal(expected.begin(), expected.end(),
+                                         ciphertext.begin(), ciphertext.end()),
+                              "Failed to verify segment {}.", index);
+                 return;
+               }
+               auto opened = Sm4MteDecrypt(
+                   symmetric_key, SegmentIv(iv, index, last), ciphertext);
+               YASL_ENFORCE_EQ(opened.size(), plaintext.size());
+               std::copy(opened.begin(), opened.end(), plaintext.begin());
+             });
+}
+
+void RsaEnvSealStream(ByteContainerView pub_key, ByteContainerView iv,
+                      io::InputStream* in, io::OutputStream* out,
+                      std::vector<uint8_t>* encrypted_key,
+                      size_t segment_size) {
+  YASL_ENFORCE_EQ(iv.size(), 12U);
+  std::vector<uint8_t> symmetric_key = GenRandKey(16);
+  *encrypted_key = RsaEncryptor::CreateFromPem(pub_key)->Encrypt(symmetric_key);
+  SealStream(in, out, segment_size, kGcmMacSize,
+             [&](uint64_t index, bool last, ByteContainerView plaintext,
+                 absl::Span<uint8_t> ciphertext) {
+               Aes128GcmCrypto(symmetric_key, SegmentIv(iv, index, last))
+                   .Encrypt(plaintext, "", ciphertext.first(plaintext.size()),
+                            ciphertext.subspan(plaintext.size()));
+             });
+}
+
+void RsaEnvOpenStream(ByteContainerView pri_key, ByteContainerView iv,
+                      ByteContainerView encrypted_key, io::InputStream* in,
+                      io::OutputStream* out, size_t segment_size) {
+  YASL_ENFORCE_EQ(iv.size(), 12U);
+  std::vector<uint8_t> symmetric_key =
+      RsaDecryptor::CreateFromPem(pri_key)->Decrypt(encrypted_key);
+  OpenStream(in, out, segment_size, kGcmMacSize,
+             [&](uint64_t index, bool last, ByteContainerView ciphertext,
+                 absl::Span<uint8_t> plaintext) {
+               Aes128GcmCrypto(symmetric_key, SegmentIv(iv, index, last))
+                   .Decrypt(ciphertext.subspan(0, plaintext.size()), "",
+                            ciphertext.subspan(plaintext.size()), plaintext);
+             });
+}
+
 }  // namespace yasl::crypto
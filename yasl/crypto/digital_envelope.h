@@ -14,9 +14,11 @@
 
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
 #include "yasl/base/byte_container_view.h"
+#include "yasl/io/stream/interface.h"
 
 namespace yasl::crypto {
 
@@ -74,4 +76,41 @@ void RsaEnvOpen(ByteContainerView pri_key, ByteContainerView iv,
                 ByteContainerView encrypted_key, ByteContainerView ciphertext,
                 ByteContainerView mac, std::vector<uint8_t>* plaintext);
 
+// Streaming envelopes, for payloads that do not fit in memory. The plaintext
+// is cut into segments of `segment_size` bytes, each sealed on its own with
+// a nonce derived from `iv`, its index and whether it is the last one. The
+// last segment is shorter than `segment_size`, possibly empty, so dropping
+// or reordering segments fails to open. Up to 64 segments are read and
+// sealed at once on the thread pool, memory stays bounded by them.
+//
+// A sealed segment is 16 bytes longer than its plaintext for rsa (the gcm
+// mac), 32 bytes longer for sm (the hmac-sm3). Both sides must agree on
+// `segment_size`.
+//
+// The open functions raise if a segment does not authenticate, the output
+// written so far must then be dropped.
+constexpr size_t kEnvSegmentSize = 64 * 1024;
+
+// sm4-ctr + hmac-sm3 per segment, the key is sealed by sm2. `iv` is 16 bytes.
+void SmEnvSealStream(ByteContainerView pub_key, ByteContainerView iv,
+                     io::InputStream* in, io::OutputStream* out,
+                     std::vector<uint8_t>* encrypted_key,
+                     size_t segment_size = kEnvSegmentSize);
+
+void SmEnvOpenStream(ByteContainerView pri_key, ByteContainerView iv,
+                     ByteContainerView encrypted_key, io::InputStream* in,
+                     io::OutputStream* out,
+                     size_t segment_size = kEnvSegmentSize);
+
+// aes-128-gcm per segment, the key is sealed by rsa. `iv` is 12 bytes.
+void RsaEnvSealStream(ByteContainerView pub_key, ByteContainerView iv,
+                      io::InputStream* in, io::OutputStream* out,
+                      std::vector<uint8_t>* encrypted_key,
+                      size_t segment_size = kEnvSegmentSize);
+
+void RsaEnvOpenStream(ByteContainerView pri_key, ByteContainerView iv,
+                      ByteContainerView encrypted_key, io::InputStream* in,
+                      io::OutputStream* out,
+                      size_t segment_size = kEnvSegmentSize);
+
 }  // namespace yasl::crypto
\ No newline at end of file
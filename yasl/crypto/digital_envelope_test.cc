@@ -17,9 +17,22 @@
 #include "gtest/gtest.h"
 
 #include "yasl/crypto/asymmetric_util.h"
+#include "yasl/io/stream/mem_io.h"
 
 namespace yasl::crypto {
 
+namespace {
+
+std::string MakePlaintext(size_t size) {
+  std::string plaintext(size, 0);
+  for (size_t i = 0; i < size; i++) {
+    plaintext[i] = static_cast<char>(i * 131 + 7);
+  }
+  return plaintext;
+}
+
+}  // namespace
+
 TEST(SmDigitalEnvelope, SealOpen_shouldOk) {
   // GIVEN
   auto [public_key, private_key] = CreateSm2KeyPair();
@@ -57,4 +70,83 @@ TEST(RsaDigitalEnvelope, SealOpen_shouldOk) {
   EXPECT_EQ(plaintext, std::string(decrypted.begin(), decrypted.end()));
 }
 
+TEST(RsaDigitalEnvelope, SealOpenStream_shouldOk) {
+  // GIVEN
+  auto [public_key, private_key] = CreateRsaKeyPair();
+  std::string iv = "123456781234";
+  const size_t segment_size = 100;
+
+  // more than one batch of segments, and on the segment edges.
+  for (size_t size : {0, 1, 99, 100, 350, 6400, 7000}) {
+    std::string plaintext = MakePlaintext(size);
+
+    // WHEN
+    std::string sealed;
+    std::vector<uint8_t> encrypted_key;
+    {
+      io::MemInputStream in(plaintext);
+      io::MemOutputStream out(&sealed);
+      RsaEnvSealStream(public_key, iv, &in, &out, &encrypted_key,
+                       segment_size);
+    }
+    std::string opened;
+    {
+      io::MemInputStream in(sealed);
+      io::MemOutputStream out(&opened);
+      RsaEnvOpenStream(private_key, iv, encrypted_key, &in, &out,
+                       segment_size);
+    }
+
+    // THEN
+    EXPECT_EQ(sealed.size(), size + (size / segment_size + 1) * 16);
+    EXPECT_EQ(opened, plaintext);
+
+    // a stream cut at a segment edge does not open.
+    std::string truncated =
+        sealed.substr(0, sealed.size() / (segment_size + 16) *
+                             (segment_size + 16));
+    std::string ignored;
+    io::MemInputStream in(truncated);
+    io::MemOutputStream out(&ignored);
+    EXPECT_ANY_THROW(RsaEnvOpenStream(private_key, iv, encrypted_key, &in,
+                                      &out, segment_size));
+  }
+}
+
+TEST(SmDigitalEnvelope, SealOpenStream_shouldOk) {
+  // GIVEN
+  auto [public_key, private_key] = CreateSm2KeyPair();
+  std::string iv = "1234567812345678";
+  const size_t segment_size = 64;
+
+  for (size_t size : {0, 63, 64, 4096, 5000}) {
+    std::string plaintext = MakePlaintext(size);
+
+    // WHEN
+    std::string sealed;
+    std::vector<uint8_t> encrypted_key;
+    {
+      io::MemInputStream in(plaintext);
+      io::MemOutputStream out(&sealed);
+      SmEnvSealStream(public_key, iv, &in, &out, &encrypted_key, segment_size);
+    }
+    std::string opened;
+    {
+      io::MemInputStream in(sealed);
+      io::MemOutputStream out(&opened);
+      SmEnvOpenStream(private_key, iv, encrypted_key, &in, &out, segment_size);
+    }
+
+    // THEN
+    EXPECT_EQ(opened, plaintext);
+
+    sealed[sealed.size() / 2] ^= 1;
+    std::string ignored;
+    io::MemInputStream in(sealed);
+    io::MemOutputStream out(&ignored);
+    EXPECT_ANY_THROW(SmEnvOpenStream(private_key, iv, encrypted_key, &in, &out,
+                                     segment_size));
+  }
+}
+
 }  // namespace yasl::crypto
\ No newline at end of file
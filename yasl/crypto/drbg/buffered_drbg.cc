@@ -0,0 +1,131 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/drbg/buffered_drbg.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "yasl/base/exception.h"
+
+namespace yasl::crypto {
+
+BufferedDrbg::BufferedDrbg(std::unique_ptr<IDrbg> drbg, size_t block_bytes)
+    : drbg_(std::move(drbg)), block_bytes_(block_bytes) {
+  YASL_ENFORCE(drbg_ != nullptr);
+  YASL_ENFORCE(block_bytes_ > 0);
+  blocks_[0].resize(block_bytes_);
+  blocks_[1].resize(block_bytes_);
+  // the front starts used up, served once the first back block is ready.
+  front_pos_ = block_bytes_;
+  refill_thread_ = std::thread([this] { Refill(); });
+}
+
+BufferedDrbg::~BufferedDrbg() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  refill_cv_.notify_one();
+  refill_thread_.join();
+}
+
+void BufferedDrbg::Generate(absl::Span<uint8_t> out) {
+  std::lock_guard<std::mutex> drbg_lock(drbg_mutex_);
+  drbg_->FillRandomBytes(out);
+}
+
+void BufferedDrbg::Refill() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    refill_cv_.wait(lock, [this] { return stop_ || !back_ready_; });
+    if (stop_) {
+      return;
+    }
+    // the back block is not read until it is ready.
+    auto& back = blocks_[1 - front_];
+    const uint64_t epoch = epoch_;
+    lock.unlock();
+    try {
+      Generate(absl::MakeSpan(back));
+    } catch (...) {
+      // requests are served on the calling thread from now on, where the
+      // drbg throws to the caller.
+      return;
+    }
+    lock.lock();
+    if (epoch == epoch_) {
+      back_ready_ = true;
+      stats_.generated_bytes += back.size();
+    }
+  }
+}
+
+void BufferedDrbg::FillRandomBytes(absl::Span<uint8_t> out) {
+  size_t taken = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (taken < out.size()) {
+      if (front_pos_ == block_bytes_) {
+        if (!back_ready_) {
+          break;
+        }
+        front_ = 1 - front_;
+        front_pos_ = 0;
+        back_ready_ = false;
+        refill_cv_.notify_one();
+      }
+      const size_t n = std::min(out.size() - taken, block_bytes_ - front_pos_);
+      uint8_t* first = blocks_[front_].data() + front_pos_;
+      std::memcpy(out.data() + taken, first, n);
+      std::memset(first, 0, n);
+      front_pos_ += n;
+      taken += n;
+    }
+    stats_.served_bytes += out.size();
+    stats_.missed_bytes += out.size() - taken;
+  }
+
+  if (taken < out.size()) {
+    Generate(out.subspan(taken));
+  }
+}
+
+void BufferedDrbg::RunOnDrbg(const std::function<void(IDrbg*)>& fn) {
+  {
+    std::lock_guard<std::mutex> drbg_lock(drbg_mutex_);
+    fn(drbg_.get());
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  epoch_++;
+  auto& front = blocks_[front_];
+  std::memset(front.data() + front_pos_, 0, block_bytes_ - front_pos_);
+  stats_.dropped_bytes += block_bytes_ - front_pos_;
+  front_pos_ = block_bytes_;
+  if (back_ready_) {
+    auto& back = blocks_[1 - front_];
+    std::memset(back.data(), 0, back.size());
+    stats_.dropped_bytes += back.size();
+    back_ready_ = false;
+    refill_cv_.notify_one();
+  }
+}
+
+BufferedDrbg::Stats BufferedDrbg::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace yasl::crypto
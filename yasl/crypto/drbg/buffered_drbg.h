@@ -0,0 +1,97 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/crypto/drbg/drbg.h"
+
+namespace yasl::crypto {
+
+// Drbg with its output generated ahead of time.
+//
+// The output of `drbg` is double buffered in two blocks of `block_bytes`: a
+// background thread generates the back block while the front one is served,
+// and the two swap once the front is used up. A request the blocks cannot
+// cover is completed by `drbg` on the calling thread, so a request costs a
+// memcpy as long as the thread keeps up. Bytes are served once and wiped.
+//
+// The buffered bytes were generated before the request, so they come with no
+// prediction resistance. Requests that need it, say NistAesDrbg::Generate
+// with PredictionResistanceFlags::kYes, go through RunOnDrbg, which drops
+// what is buffered afterwards: every byte served later is generated from the
+// reseeded state.
+class BufferedDrbg : public IDrbg {
+ public:
+  static constexpr size_t kDefaultBlockBytes = 1 << 20;
+
+  struct Stats {
+    uint64_t generated_bytes = 0;
+    uint64_t served_bytes = 0;
+    // bytes generated on the calling thread.
+    uint64_t missed_bytes = 0;
+    // buffered bytes dropped by RunOnDrbg.
+    uint64_t dropped_bytes = 0;
+  };
+
+  explicit BufferedDrbg(std::unique_ptr<IDrbg> drbg,
+                        size_t block_bytes = kDefaultBlockBytes);
+  ~BufferedDrbg() override;
+
+  BufferedDrbg(const BufferedDrbg&) = delete;
+  BufferedDrbg& operator=(const BufferedDrbg&) = delete;
+
+  void FillRandomBytes(absl::Span<uint8_t> out) override;
+
+  // Runs `fn` on the wrapped drbg on the calling thread, then drops the
+  // buffered bytes.
+  void RunOnDrbg(const std::function<void(IDrbg*)>& fn);
+
+  Stats GetStats() const;
+
+ private:
+  void Refill();
+  void Generate(absl::Span<uint8_t> out);
+
+  const std::unique_ptr<IDrbg> drbg_;
+  const size_t block_bytes_;
+
+  // serializes the calls to `drbg_`.
+  std::mutex drbg_mutex_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable refill_cv_;
+  std::vector<uint8_t> blocks_[2];
+  size_t front_ = 0;
+  // served bytes of the front block.
+  size_t front_pos_;
+  bool back_ready_ = false;
+  // bumped by RunOnDrbg, a block generated across it is not served.
+  uint64_t epoch_ = 0;
+  Stats stats_;
+  bool stop_ = false;
+
+  std::thread refill_thread_;
+};
+
+}  // namespace yasl::crypto
@@ -0,0 +1,148 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/drbg/buffered_drbg.h"
+
+#include <chrono>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/crypto/drbg/sm4_drbg.h"
+
+namespace yasl::crypto {
+
+namespace {
+
+constexpr size_t kBlockBytes = 1024;
+constexpr size_t kBlockWords = kBlockBytes / sizeof(uint64_t);
+
+// fills the index of each word in its output stream.
+class CountingDrbg : public IDrbg {
+ public:
+  void FillRandomBytes(absl::Span<uint8_t> out) override {
+    auto words = absl::MakeSpan(reinterpret_cast<uint64_t*>(out.data()),
+                                out.size() / sizeof(uint64_t));
+    for (auto& word : words) {
+      word = next_++;
+    }
+  }
+
+  uint64_t next() const { return next_; }
+
+ private:
+  uint64_t next_ = 0;
+};
+
+void WaitForBlocks(const BufferedDrbg& drbg, size_t blocks) {
+  for (int i = 0;
+       i < 1000 && drbg.GetStats().generated_bytes < blocks * kBlockBytes;
+       ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+}  // namespace
+
+TEST(BufferedDrbgTest, ServesTheDrbgStream) {
+  BufferedDrbg drbg(std::make_unique<CountingDrbg>(), kBlockBytes);
+  WaitForBlocks(drbg, 1);
+
+  std::vector<uint64_t> words(kBlockWords / 4);
+  for (size_t i = 0; i < 4; ++i) {
+    drbg.FillRandom(absl::MakeSpan(words));
+    for (size_t j = 0; j < words.size(); ++j) {
+      EXPECT_EQ(words[j], i * words.size() + j);
+    }
+  }
+
+  const auto stats = drbg.GetStats();
+  EXPECT_EQ(stats.served_bytes, kBlockBytes);
+  EXPECT_EQ(stats.missed_bytes, 0);
+}
+
+TEST(BufferedDrbgTest, LargeRequestMissesBuffer) {
+  BufferedDrbg drbg(std::make_unique<CountingDrbg>(), kBlockBytes);
+  WaitForBlocks(drbg, 1);
+
+  std::vector<uint64_t> words(3 * kBlockWords);
+  drbg.FillRandom(absl::MakeSpan(words));
+  EXPECT_GE(drbg.GetStats().missed_bytes, kBlockBytes);
+  EXPECT_EQ(std::set<uint64_t>(words.begin(), words.end()).size(),
+            words.size());
+}
+
+TEST(BufferedDrbgTest, RunOnDrbgDropsBuffer) {
+  BufferedDrbg drbg(std::make_unique<CountingDrbg>(), kBlockBytes);
+  WaitForBlocks(drbg, 1);
+
+  uint64_t before = 0;
+  drbg.FillRandom(absl::MakeSpan(&before, 1));
+  uint64_t next = 0;
+  drbg.RunOnDrbg(
+      [&](IDrbg* d) { next = static_cast<CountingDrbg*>(d)->next(); });
+  EXPECT_GE(drbg.GetStats().dropped_bytes, kBlockBytes - sizeof(uint64_t));
+
+  // nothing generated before the call is served.
+  std::vector<uint64_t> words(kBlockWords);
+  drbg.FillRandom(absl::MakeSpan(words));
+  for (uint64_t word : words) {
+    EXPECT_GE(word, next);
+  }
+}
+
+TEST(BufferedDrbgTest, ConcurrentRequestsNeverShareBytes) {
+  BufferedDrbg drbg(std::make_unique<CountingDrbg>(), kBlockBytes);
+
+  constexpr size_t kThreads = 4;
+  std::vector<std::vector<uint64_t>> outs(kThreads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < 200; ++i) {
+        std::vector<uint64_t> words(1 + (i + t) % 40);
+        drbg.FillRandom(absl::MakeSpan(words));
+        outs[t].insert(outs[t].end(), words.begin(), words.end());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::set<uint64_t> all;
+  size_t total = 0;
+  for (const auto& out : outs) {
+    all.insert(out.begin(), out.end());
+    total += out.size();
+  }
+  EXPECT_EQ(all.size(), total);
+}
+
+TEST(BufferedDrbgTest, WrapsSm4Drbg) {
+  auto sm4_drbg = std::make_unique<Sm4Drbg>();
+  sm4_drbg->Instantiate();
+  BufferedDrbg drbg(std::move(sm4_drbg));
+
+  std::vector<uint8_t> random_buf1(80);
+  std::vector<uint8_t> random_buf2(80);
+  drbg.FillRandom(absl::MakeSpan(random_buf1));
+  drbg.FillRandom(absl::MakeSpan(random_buf2));
+  EXPECT_NE(random_buf1, random_buf2);
+}
+
+}  // namespace yasl::crypto
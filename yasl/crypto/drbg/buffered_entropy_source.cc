@@ -0,0 +1,239 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/drbg/buffered_entropy_source.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <utility>
+
+#include "yasl/base/exception.h"
+
+namespace yasl::crypto {
+
+namespace {
+
+// SP 800-90B 4.4.1, cutoff 1 + ceil(20 / H) for a false positive rate of
+// 2^-20 and H = 8.
+constexpr size_t kRepetitionCutoff = 4;
+// SP 800-90B 4.4.2, window of 512 samples, cutoff for H = 8.
+constexpr size_t kProportionWindow = 512;
+constexpr size_t kProportionCutoff = 13;
+
+// live sources, for the fork handlers. never destroyed, since sources may
+// outlive static destruction.
+std::mutex& LiveMutex() {
+  static auto* mutex = new std::mutex;
+  return *mutex;
+}
+
+std::set<BufferedEntropySource*>& LiveSources() {
+  static auto* sources = new std::set<BufferedEntropySource*>;
+  return *sources;
+}
+
+}  // namespace
+
+BufferedEntropySource::BufferedEntropySource(
+    std::shared_ptr<IEntropySource> source, size_t pool_bytes)
+    : source_(std::move(source)), pool_bytes_(pool_bytes) {
+  YASL_ENFORCE(source_ != nullptr);
+  YASL_ENFORCE(pool_bytes_ >= kChunkBytes, "pool of {} bytes is too small",
+               pool_bytes_);
+  pool_.reserve(pool_bytes_);
+
+  static std::once_flag atfork_flag;
+  std::call_once(atfork_flag, [] {
+    YASL_ENFORCE(pthread_atfork(&PrepareFork, &ParentAfterFork,
+                                &ChildAfterFork) == 0,
+                 "pthread_atfork failed");
+  });
+  {
+    std::lock_guard<std::mutex> live_lock(LiveMutex());
+    LiveSources().insert(this);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  StartRefill();
+}
+
+BufferedEntropySource::~BufferedEntropySource() {
+  {
+    std::lock_guard<std::mutex> live_lock(LiveMutex());
+    LiveSources().erase(this);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    if (refiller_) {
+      refiller_->cv.notify_one();
+    }
+  }
+  if (refiller_) {
+    refiller_->thread.join();
+  }
+}
+
+// the locks are held across fork, so that the child never inherits one held
+// by a thread it does not have.
+void BufferedEntropySource::PrepareFork() {
+  LiveMutex().lock();
+  for (auto* source : LiveSources()) {
+    source->source_mutex_.lock();
+    source->mutex_.lock();
+  }
+}
+
+void BufferedEntropySource::ParentAfterFork() {
+  for (auto* source : LiveSources()) {
+    source->mutex_.unlock();
+    source->source_mutex_.unlock();
+  }
+  LiveMutex().unlock();
+}
+
+void BufferedEntropySource::ChildAfterFork() {
+  for (auto* source : LiveSources()) {
+    // the parent serves the same bytes.
+    std::memset(source->pool_.data(), 0, source->pool_.size());
+    source->pool_.clear();
+    // the thread is gone, and the cv may count it as a waiter, leak both.
+    static_cast<void>(source->refiller_.release());
+    source->mutex_.unlock();
+    source->source_mutex_.unlock();
+  }
+  LiveMutex().unlock();
+}
+
+void BufferedEntropySource::StartRefill() {
+  refiller_ = std::make_unique<Refiller>();
+  refiller_->thread =
+      std::thread([this, refiller = refiller_.get()] { Refill(refiller); });
+}
+
+bool BufferedEntropySource::HealthTest(const std::string& chunk) {
+  size_t run = 1;
+  for (size_t i = 1; i < chunk.size(); ++i) {
+    run = chunk[i] == chunk[i - 1] ? run + 1 : 1;
+    if (run >= kRepetitionCutoff) {
+      return false;
+    }
+  }
+  for (size_t w = 0; w < chunk.size(); w += kProportionWindow) {
+    const auto end = chunk.begin() + std::min(w + kProportionWindow,
+                                              chunk.size());
+    if (static_cast<size_t>(std::count(chunk.begin() + w, end, chunk[w])) >=
+        kProportionCutoff) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string BufferedEntropySource::Harvest() {
+  std::lock_guard<std::mutex> source_lock(source_mutex_);
+  while (true) {
+    std::string chunk = source_->GetEntropy(kChunkBytes);
+    if (HealthTest(chunk)) {
+      failed_in_row_ = 0;
+      return chunk;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.failed_chunks++;
+    if (++failed_in_row_ >= kMaxFailedChunks) {
+      broken_ = true;
+      YASL_THROW("entropy source failed {} health tests in a row",
+                 failed_in_row_);
+    }
+  }
+}
+
+void BufferedEntropySource::Refill(Refiller* refiller) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    refiller->cv.wait(lock, [this] {
+      return stop_ || (!broken_ && pool_.size() < pool_bytes_ / 2);
+    });
+    if (stop_) {
+      return;
+    }
+    while (!stop_ && pool_.size() + kChunkBytes <= pool_bytes_) {
+      lock.unlock();
+      std::string chunk;
+      try {
+        chunk = Harvest();
+      } catch (...) {
+        // GetEntropy throws from now on.
+        lock.lock();
+        broken_ = true;
+        break;
+      }
+      lock.lock();
+      pool_.insert(pool_.end(), chunk.begin(), chunk.end());
+      stats_.harvested_bytes += chunk.size();
+    }
+  }
+}
+
+std::string BufferedEntropySource::GetEntropy(size_t entropy_bytes) {
+  std::string entropy_buf(entropy_bytes, 0);
+  size_t taken;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    YASL_ENFORCE(!broken_, "entropy source failed the health tests");
+    if (!refiller_) {
+      // the first request of a forked child.
+      StartRefill();
+    }
+    taken = std::min(entropy_bytes, pool_.size());
+    uint8_t* first = pool_.data() + pool_.size() - taken;
+    std::memcpy(entropy_buf.data(), first, taken);
+    // entropy is not left behind in the pool.
+    std::memset(first, 0, taken);
+    pool_.resize(pool_.size() - taken);
+    stats_.served_bytes += entropy_bytes;
+    stats_.missed_bytes += entropy_bytes - taken;
+    refiller_->cv.notify_one();
+  }
+
+  while (taken < entropy_bytes) {
+    const std::string chunk = Harvest();
+    const size_t n = std::min(chunk.size(), entropy_bytes - taken);
+    std::memcpy(entropy_buf.data() + taken, chunk.data(), n);
+    taken += n;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.harvested_bytes += chunk.size();
+    // the rest of the chunk goes to the pool.
+    const size_t room = pool_bytes_ - pool_.size();
+    const size_t left = std::min(chunk.size() - n, room);
+    pool_.insert(pool_.end(), chunk.begin() + n, chunk.begin() + n + left);
+  }
+  return entropy_buf;
+}
+
+uint64_t BufferedEntropySource::GetEntropy() {
+  uint64_t entropy;
+  const std::string entropy_buf = GetEntropy(sizeof(entropy));
+  std::memcpy(&entropy, entropy_buf.data(), sizeof(entropy));
+  return entropy;
+}
+
+BufferedEntropySource::Stats BufferedEntropySource::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace yasl::crypto
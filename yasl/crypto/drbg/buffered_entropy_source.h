@@ -0,0 +1,109 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "yasl/crypto/drbg/entropy_source.h"
+
+namespace yasl::crypto {
+
+// Entropy source with a pool harvested ahead of time.
+//
+// A background thread keeps the pool of `source` filled, so that a reseed
+// copies its entropy from memory instead of waiting for RDSEED or
+// /dev/urandom. The pool is refilled once it drops below half. Requests
+// larger than the pool left are completed by `source` on the calling thread.
+//
+// Each harvested chunk of kChunkBytes bytes goes through the health tests of
+// NIST SP 800-90B 4.4 on its bytes, the repetition count test and the
+// adaptive proportion test, taking a byte to hold 8 bits of min-entropy.
+// Failed chunks are discarded, and after kMaxFailedChunks failures in a row
+// the source is considered broken and GetEntropy throws.
+//
+// It is fork safe: a forked child wipes the pool inherited from its parent,
+// so that both never serve the same entropy, and restarts the refill thread
+// on its first request.
+class BufferedEntropySource : public IEntropySource {
+ public:
+  static constexpr size_t kChunkBytes = 512;
+  static constexpr size_t kMaxFailedChunks = 3;
+
+  struct Stats {
+    uint64_t harvested_bytes = 0;
+    uint64_t served_bytes = 0;
+    // bytes served by `source` on the calling thread.
+    uint64_t missed_bytes = 0;
+    uint64_t failed_chunks = 0;
+  };
+
+  explicit BufferedEntropySource(std::shared_ptr<IEntropySource> source,
+                                 size_t pool_bytes = 8 * kChunkBytes);
+  ~BufferedEntropySource() override;
+
+  BufferedEntropySource(const BufferedEntropySource&) = delete;
+  BufferedEntropySource& operator=(const BufferedEntropySource&) = delete;
+
+  std::string GetEntropy(size_t entropy_bytes) override;
+  uint64_t GetEntropy() override;
+
+  Stats GetStats() const;
+
+  // The health tests on a chunk of bytes.
+  static bool HealthTest(const std::string& chunk);
+
+ private:
+  // the refill thread, left behind by a fork in the child.
+  struct Refiller {
+    std::condition_variable cv;
+    std::thread thread;
+  };
+
+  // pthread_atfork handlers, over all live sources.
+  static void PrepareFork();
+  static void ParentAfterFork();
+  static void ChildAfterFork();
+
+  // should be called with mutex_ held.
+  void StartRefill();
+  void Refill(Refiller* refiller);
+  // harvests a chunk that passes the health tests, throws if there is none.
+  std::string Harvest();
+
+  const std::shared_ptr<IEntropySource> source_;
+  const size_t pool_bytes_;
+
+  mutable std::mutex mutex_;
+  // consumed from the back.
+  std::vector<uint8_t> pool_;
+  Stats stats_;
+  bool broken_ = false;
+  bool stop_ = false;
+
+  // serializes the calls to `source_`.
+  std::mutex source_mutex_;
+  uint64_t failed_in_row_ = 0;
+
+  // null in a forked child until its first request.
+  std::unique_ptr<Refiller> refiller_;
+};
+
+}  // namespace yasl::crypto
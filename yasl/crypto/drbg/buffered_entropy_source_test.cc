@@ -0,0 +1,141 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/drbg/buffered_entropy_source.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "yasl/crypto/drbg/std_entropy_source.h"
+
+namespace yasl::crypto {
+
+namespace {
+
+constexpr size_t kPoolBytes = 4 * BufferedEntropySource::kChunkBytes;
+
+// a source stuck at one byte.
+class StuckEntropySource : public IEntropySource {
+ public:
+  std::string GetEntropy(size_t entropy_bytes) override {
+    return std::string(entropy_bytes, 'x');
+  }
+  uint64_t GetEntropy() override { return 0; }
+};
+
+void WaitForPool(const BufferedEntropySource& source, size_t bytes) {
+  for (int i = 0; i < 1000 && source.GetStats().harvested_bytes < bytes; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+}  // namespace
+
+TEST(BufferedEntropySourceTest, ServesFromPool) {
+  BufferedEntropySource source(std::make_shared<StdEntropySource>(),
+                               kPoolBytes);
+  WaitForPool(source, kPoolBytes);
+
+  std::string entropy_str1 = source.GetEntropy(128);
+  std::string entropy_str2 = source.GetEntropy(128);
+  EXPECT_EQ(entropy_str1.size(), 128);
+  EXPECT_NE(entropy_str1, entropy_str2);
+  EXPECT_NE(source.GetEntropy(), source.GetEntropy());
+
+  const auto stats = source.GetStats();
+  EXPECT_EQ(stats.served_bytes, 2 * 128 + 2 * sizeof(uint64_t));
+  EXPECT_EQ(stats.missed_bytes, 0);
+  EXPECT_EQ(stats.failed_chunks, 0);
+}
+
+TEST(BufferedEntropySourceTest, LargeRequestMissesPool) {
+  BufferedEntropySource source(std::make_shared<StdEntropySource>(),
+                               kPoolBytes);
+  WaitForPool(source, kPoolBytes);
+
+  std::string entropy_str = source.GetEntropy(kPoolBytes + 100);
+  EXPECT_EQ(entropy_str.size(), kPoolBytes + 100);
+  EXPECT_GE(source.GetStats().missed_bytes, 100);
+}
+
+TEST(BufferedEntropySourceTest, ThrowsOnStuckSource) {
+  BufferedEntropySource source(std::make_shared<StuckEntropySource>(),
+                               kPoolBytes);
+  EXPECT_THROW(source.GetEntropy(16), yasl::Exception);
+  EXPECT_GE(source.GetStats().failed_chunks,
+            BufferedEntropySource::kMaxFailedChunks);
+}
+
+TEST(BufferedEntropySourceTest, ForkedChildShouldNotSharePool) {
+  BufferedEntropySource source(std::make_shared<StdEntropySource>(),
+                               kPoolBytes);
+  WaitForPool(source, kPoolBytes);
+
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    // the pool is wiped, and refilled by a new thread.
+    const std::string entropy = source.GetEntropy(64);
+    const bool missed = source.GetStats().missed_bytes == 64;
+    WaitForPool(source, kPoolBytes + 64);
+    const bool refilled = source.GetStats().harvested_bytes >= kPoolBytes;
+    const bool written =
+        write(fds[1], entropy.data(), entropy.size()) ==
+        static_cast<ssize_t>(entropy.size());
+    _exit(missed && refilled && written ? 0 : 1);
+  }
+  close(fds[1]);
+  const std::string entropy = source.GetEntropy(64);
+  std::string child_entropy(64, 0);
+  EXPECT_EQ(read(fds[0], child_entropy.data(), child_entropy.size()), 64);
+  close(fds[0]);
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  EXPECT_NE(entropy, child_entropy);
+  EXPECT_EQ(source.GetStats().missed_bytes, 0);
+}
+
+TEST(BufferedEntropySourceTest, HealthTest) {
+  std::mt19937 rng(1);
+  std::string chunk(BufferedEntropySource::kChunkBytes, 0);
+  for (auto& c : chunk) {
+    c = static_cast<char>(rng());
+  }
+  EXPECT_TRUE(BufferedEntropySource::HealthTest(chunk));
+
+  // repetition count.
+  std::string repeated = chunk;
+  repeated.replace(100, 4, "aaaa");
+  EXPECT_FALSE(BufferedEntropySource::HealthTest(repeated));
+
+  // adaptive proportion, the first byte of the window 13 times.
+  std::string biased = chunk;
+  for (size_t i = 1; i < 13; ++i) {
+    biased[i * 30] = biased[0];
+  }
+  EXPECT_FALSE(BufferedEntropySource::HealthTest(biased));
+}
+
+}  // namespace yasl::crypto
@@ -16,6 +16,8 @@
 #include "yasl/crypto/drbg/entropy_source_selector.h"
 #include <memory>
 
+#include "yasl/crypto/drbg/buffered_entropy_source.h"
+
 #ifdef __x86_64
 #include "yasl/crypto/drbg/intel_entropy_source.h"
 #else
@@ -25,11 +27,15 @@
 namespace yasl::crypto {
 
 std::shared_ptr<IEntropySource> makeEntropySource() {
+  // one pool for the process, harvested by a background thread.
 #ifdef __x86_64
-    return std::make_shared<IntelEntropySource>();
+  static auto source = std::make_shared<BufferedEntropySource>(
+      std::make_shared<IntelEntropySource>());
 #else
-    return std::make_shared<StdEntropySource>();
+  static auto source = std::make_shared<BufferedEntropySource>(
+      std::make_shared<StdEntropySource>());
 #endif
+  return source;
 }
 
 }  // namespace yasl::crypto
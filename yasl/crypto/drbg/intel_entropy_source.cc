@@ -22,7 +22,7 @@
 #include "ippcp.h"
 
 #ifdef __x86_64
-#include "cpu_features/cpuinfo_x86.h"
+#include "yasl/base/cpu_info.h"
 #endif
 
 #include "yasl/base/exception.h"
@@ -32,7 +32,7 @@ namespace yasl::crypto {
 IntelEntropySource::IntelEntropySource() {
 #ifdef __x86_64
   // check RDSEED support
-  has_rdseed_ = cpu_features::GetX86Info().features.rdseed;
+  has_rdseed_ = GetCpuFeatures().rdseed;
 #else
   has_rdseed_ = false;
 #endif
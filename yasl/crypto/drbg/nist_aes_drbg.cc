@@ -60,7 +60,7 @@ using ENTROPY_CTX = struct entropy_st {
 size_t GetEntropy(RAND_DRBG *drbg, unsigned char **pout, int entropy_bits,
                   size_t min_len, size_t max_len, int prediction_resistance) {
   auto *ctx = reinterpret_cast<ENTROPY_CTX *>(
-      RAND_DRBG_get_ex_data(drbg, NistAesDrbg::app_data_index_));
+      RAND_DRBG_get_ex_data(drbg, NistAesDrbg::AppDataIndex()));
 
   ctx->entropy_cnt++;
   // key size + block size
@@ -81,7 +81,7 @@ size_t GetEntropy(RAND_DRBG *drbg, unsigned char **pout, int entropy_bits,
 size_t GetNonce(RAND_DRBG *drbg, unsigned char **pout, int nonce_bits,
                 size_t min_len, size_t max_len) {
   auto *ctx = reinterpret_cast<ENTROPY_CTX *>(
-      RAND_DRBG_get_ex_data(drbg, NistAesDrbg::app_data_index_));
+      RAND_DRBG_get_ex_data(drbg, NistAesDrbg::AppDataIndex()));
 
   ctx->nonce_cnt++;
   int nonce_bytes = std::max(min_len, static_cast<size_t>(nonce_bits / 8));
@@ -97,7 +97,7 @@ void SetEntropyExData(RAND_DRBG *drbg,
                       const std::shared_ptr<IEntropySource> &entropy_source,
                       SecurityStrengthFlags security_strength) {
   auto *ctx = reinterpret_cast<ENTROPY_CTX *>(
-      RAND_DRBG_get_ex_data(drbg, NistAesDrbg::app_data_index_));
+      RAND_DRBG_get_ex_data(drbg, NistAesDrbg::AppDataIndex()));
 
   if (ctx == nullptr) {
     ctx = new ENTROPY_CTX();
@@ -109,7 +109,7 @@ void SetEntropyExData(RAND_DRBG *drbg,
     ctx->nonce_len = entropy_source->GetNonceBytes(security_strength);
     ctx->nonce_cnt = 0;
     YASL_ENFORCE(
-        RAND_DRBG_set_ex_data(drbg, NistAesDrbg::app_data_index_, ctx));
+        RAND_DRBG_set_ex_data(drbg, NistAesDrbg::AppDataIndex(), ctx));
   }
 }
 
@@ -130,8 +130,15 @@ inline int GetPredictionResistance(
 
 }  // namespace
 
-int NistAesDrbg::app_data_index_ =
-    RAND_DRBG_get_ex_new_index(0L, nullptr, nullptr, nullptr, nullptr);
+int NistAesDrbg::AppDataIndex() {
+  static const int index = [] {
+    ERR_load_ERR_strings();
+    ERR_load_crypto_strings();
+    ERR_load_BIO_strings();
+    return RAND_DRBG_get_ex_new_index(0L, nullptr, nullptr, nullptr, nullptr);
+  }();
+  return index;
+}
 
 NistAesDrbg::NistAesDrbg(uint128_t personal_data,
                          SecurityStrengthFlags security_strength)
@@ -161,10 +168,8 @@ NistAesDrbg::NistAesDrbg(std::shared_ptr<IEntropySource> entropy_source_ptr,
       break;
   }
 
-  ERR_load_ERR_strings();
-  ERR_load_crypto_strings();
-  ERR_load_BIO_strings();
-
+  // the one time openssl setup, before any openssl error may be raised.
+  static_cast<void>(AppDataIndex());
   RAND_DRBG *drbg_ptr = RAND_DRBG_new(drbg_type, RAND_DRBG_FLAGS, nullptr);
   YASL_ENFORCE(drbg_ptr != nullptr);
   drbg_ = NistAesDrbg::RandDrbgPtr(drbg_ptr);
@@ -215,7 +220,7 @@ void NistAesDrbg::Instantiate(uint128_t personal_string) {
 
 void NistAesDrbg::UnInstantiate() {
   auto *ctx = reinterpret_cast<ENTROPY_CTX *>(
-      RAND_DRBG_get_ex_data(drbg_.get(), app_data_index_));
+      RAND_DRBG_get_ex_data(drbg_.get(), AppDataIndex()));
 
   delete ctx;
 }
@@ -226,7 +231,7 @@ void NistAesDrbg::ReSeed(int reseed_interval) {
 
 bool NistAesDrbg::HealthCheck() {
   auto *ctx = reinterpret_cast<ENTROPY_CTX *>(
-      RAND_DRBG_get_ex_data(drbg_.get(), NistAesDrbg::app_data_index_));
+      RAND_DRBG_get_ex_data(drbg_.get(), NistAesDrbg::AppDataIndex()));
 
   std::array<uint64_t, kDefaultHealthCheckSize> random_buffer;
   std::array<uint64_t, kDefaultHealthCheckSize> entropy_buffer;
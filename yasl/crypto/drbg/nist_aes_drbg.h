@@ -80,7 +80,9 @@ class NistAesDrbg : public IDrbg {
 
   bool HealthCheck();
 
-  static int app_data_index_;
+  // the ex data index of the entropy ctx of a drbg, allocated on first use
+  // along with the one time openssl setup, not at process start.
+  static int AppDataIndex();
 
   class RandDrbgDeleter {
    public:
@@ -0,0 +1,84 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/drbg/thread_local_drbg.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#include "yasl/base/exception.h"
+#include "yasl/base/int128.h"
+#include "yasl/crypto/drbg/nist_aes_drbg.h"
+#include "yasl/crypto/drbg/sm4_drbg.h"
+
+namespace yasl::crypto {
+
+namespace {
+
+constexpr size_t kNumDrbgTypes = 2;
+
+// ids of the threads which have called Get, from 1, so that personalization
+// strings are never 0, which Sm4Drbg would drop.
+uint64_t ThreadId() {
+  static std::atomic<uint64_t> next_id{1};
+  thread_local const uint64_t id = next_id++;
+  return id;
+}
+
+}  // namespace
+
+ThreadLocalDrbg& ThreadLocalDrbg::Get(DrbgType type) {
+  thread_local std::array<std::unique_ptr<ThreadLocalDrbg>, kNumDrbgTypes>
+      drbgs;
+  const auto idx = static_cast<size_t>(type);
+  YASL_ENFORCE(idx < kNumDrbgTypes, "unknown drbg type {}", idx);
+  if (!drbgs[idx]) {
+    drbgs[idx].reset(new ThreadLocalDrbg(type, ThreadId()));
+  }
+  return *drbgs[idx];
+}
+
+ThreadLocalDrbg::ThreadLocalDrbg(DrbgType type, uint64_t thread_id)
+    : type_(type), thread_id_(thread_id) {
+  Instantiate();
+}
+
+void ThreadLocalDrbg::Instantiate() {
+  const uint128_t personal_data =
+      MakeUint128(thread_id_, ++num_instantiations_);
+  switch (type_) {
+    case DrbgType::kNistAes:
+      drbg_ = std::make_unique<NistAesDrbg>(personal_data);
+      break;
+    case DrbgType::kSm4:
+      drbg_ = std::make_unique<Sm4Drbg>(personal_data);
+      break;
+  }
+  bytes_ = 0;
+}
+
+void ThreadLocalDrbg::FillRandomBytes(absl::Span<uint8_t> out) {
+  while (!out.empty()) {
+    if (bytes_ == kReseedBytes) {
+      Instantiate();
+    }
+    const size_t n = std::min<uint64_t>(out.size(), kReseedBytes - bytes_);
+    drbg_->FillRandomBytes(out.subspan(0, n));
+    bytes_ += n;
+    out.remove_prefix(n);
+  }
+}
+
+}  // namespace yasl::crypto
@@ -0,0 +1,71 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/types/span.h"
+
+#include "yasl/crypto/drbg/drbg.h"
+
+namespace yasl::crypto {
+
+enum class DrbgType { kNistAes, kSm4 };
+
+// Thread local drbg cache.
+//
+// NistAesDrbg and Sm4Drbg are not thread safe, and instantiating one pulls
+// entropy, so each thread keeps one drbg per type, instantiated on its first
+// Get. The personalization string of a drbg is the id of its thread and the
+// count of its instantiations, so no two drbgs of a process share it. On top
+// of the reseeding of the drbg itself, it is instantiated afresh every
+// kReseedBytes bytes. No locks are taken.
+//
+//   ThreadLocalDrbg::Get().FillRandom(absl::MakeSpan(key));
+class ThreadLocalDrbg : public IDrbg {
+ public:
+  // Bytes of a drbg between two instantiations.
+  static constexpr uint64_t kReseedBytes = uint64_t(1) << 30;
+
+  // The drbg of the calling thread, which lives as long as the thread, and
+  // must not be handed to others.
+  static ThreadLocalDrbg& Get(DrbgType type = DrbgType::kNistAes);
+
+  ThreadLocalDrbg(const ThreadLocalDrbg&) = delete;
+  ThreadLocalDrbg& operator=(const ThreadLocalDrbg&) = delete;
+
+  void FillRandomBytes(absl::Span<uint8_t> out) override;
+
+  DrbgType GetType() const { return type_; }
+
+  // Reseed accounting, the instantiations of this drbg, the first included,
+  // and the bytes generated since the last one.
+  uint64_t NumInstantiations() const { return num_instantiations_; }
+  uint64_t BytesSinceInstantiation() const { return bytes_; }
+
+ private:
+  ThreadLocalDrbg(DrbgType type, uint64_t thread_id);
+
+  void Instantiate();
+
+  const DrbgType type_;
+  const uint64_t thread_id_;
+  std::unique_ptr<IDrbg> drbg_;
+  uint64_t num_instantiations_ = 0;
+  uint64_t bytes_ = 0;
+};
+
+}  // namespace yasl::crypto
@@ -0,0 +1,74 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/drbg/thread_local_drbg.h"
+
+#include <future>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace yasl::crypto {
+
+class ThreadLocalDrbgTest : public testing::TestWithParam<DrbgType> {};
+
+TEST_P(ThreadLocalDrbgTest, SameDrbgInThread) {
+  auto& drbg = ThreadLocalDrbg::Get(GetParam());
+  EXPECT_EQ(&drbg, &ThreadLocalDrbg::Get(GetParam()));
+  EXPECT_EQ(drbg.GetType(), GetParam());
+  EXPECT_EQ(drbg.NumInstantiations(), 1);
+
+  std::vector<uint8_t> random_buf1(80);
+  std::vector<uint8_t> random_buf2(80);
+  drbg.FillRandom(absl::MakeSpan(random_buf1));
+  drbg.FillRandom(absl::MakeSpan(random_buf2));
+  EXPECT_NE(random_buf1, random_buf2);
+}
+
+TEST_P(ThreadLocalDrbgTest, OwnDrbgPerThread) {
+  constexpr size_t kThreads = 4;
+  std::vector<std::future<std::pair<IDrbg*, std::vector<uint8_t>>>> futures;
+  for (size_t i = 0; i < kThreads; ++i) {
+    futures.push_back(std::async(std::launch::async, [&] {
+      auto& drbg = ThreadLocalDrbg::Get(GetParam());
+      std::vector<uint8_t> random_buf(32);
+      drbg.FillRandom(absl::MakeSpan(random_buf));
+      return std::make_pair(static_cast<IDrbg*>(&drbg), random_buf);
+    }));
+  }
+  std::vector<std::pair<IDrbg*, std::vector<uint8_t>>> results;
+  for (auto& f : futures) {
+    results.push_back(f.get());
+  }
+  for (size_t i = 0; i < kThreads; ++i) {
+    EXPECT_NE(results[i].first, &ThreadLocalDrbg::Get(GetParam()));
+    for (size_t j = i + 1; j < kThreads; ++j) {
+      EXPECT_NE(results[i].second, results[j].second);
+    }
+  }
+}
+
+TEST_P(ThreadLocalDrbgTest, CountsBytes) {
+  auto& drbg = ThreadLocalDrbg::Get(GetParam());
+  const uint64_t before = drbg.BytesSinceInstantiation();
+  std::vector<uint32_t> random_buf(25);
+  drbg.FillRandom(absl::MakeSpan(random_buf));
+  EXPECT_EQ(drbg.BytesSinceInstantiation(), before + 100);
+  EXPECT_EQ(drbg.NumInstantiations(), 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(Cases, ThreadLocalDrbgTest,
+                         testing::Values(DrbgType::kNistAes, DrbgType::kSm4));
+
+}  // namespace yasl::crypto
@@ -0,0 +1,300 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/ecc/ecc_batch.h"
+
+#include <cstring>
+
+#include "openssl/bn.h"
+#include "openssl/ec.h"
+#include "openssl/err.h"
+#include "openssl/evp.h"
+#include "openssl/obj_mac.h"
+#include "sodium.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/utils/parallel.h"
+
+namespace yasl::crypto {
+
+namespace {
+
+constexpr size_t kSodiumPointBytes = 32;
+constexpr size_t kSm2PointBytes = 33;
+constexpr size_t kScalarBytes = 32;
+// public key ops are heavy, a few of them are enough per task.
+constexpr int64_t kGrainSize = 16;
+// half the x are on the curve, failing this many is out of question.
+constexpr uint32_t kSm2MaxTries = 256;
+
+static_assert(crypto_scalarmult_curve25519_BYTES == kSodiumPointBytes);
+static_assert(crypto_core_ristretto255_BYTES == kSodiumPointBytes);
+static_assert(crypto_core_ristretto255_SCALARBYTES == kScalarBytes);
+
+using UniqueBn = std::unique_ptr<BIGNUM, decltype(&BN_free)>;
+using UniqueBnCtx = std::unique_ptr<BN_CTX, decltype(&BN_CTX_free)>;
+using UniquePoint = std::unique_ptr<EC_POINT, decltype(&EC_POINT_free)>;
+using UniqueMdCtx = std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>;
+
+// The state of one task over a chunk of points, the openssl objects of sm2
+// are not shared between threads.
+class Worker {
+ public:
+  Worker(CurveType curve, const EC_GROUP* group, ByteContainerView scalar)
+      : curve_(curve),
+        group_(group),
+        scalar_(scalar),
+        bn_ctx_(nullptr, BN_CTX_free),
+        k_(nullptr, BN_free),
+        p_(nullptr, BN_free),
+        x_(nullptr, BN_free),
+        point_(nullptr, EC_POINT_free),
+        md_ctx_(nullptr, EVP_MD_CTX_free) {
+    if (curve_ != CurveType::kSm2) {
+      return;
+    }
+    bn_ctx_.reset(BN_CTX_new());
+    p_.reset(BN_new());
+    x_.reset(BN_new());
+    point_.reset(EC_POINT_new(group_));
+    md_ctx_.reset(EVP_MD_CTX_new());
+    YASL_ENFORCE(bn_ctx_ && p_ && x_ && point_ && md_ctx_);
+    YASL_ENFORCE_EQ(EC_GROUP_get_curve(group_, p_.get(), nullptr, nullptr,
+                                       bn_ctx_.get()),
+                    1);
+    if (!scalar_.empty()) {
+      k_.reset(BN_bin2bn(scalar_.data(), scalar_.size(), nullptr));
+      YASL_ENFORCE(k_ != nullptr);
+      YASL_ENFORCE(!BN_is_zero(k_.get()) &&
+                       BN_cmp(k_.get(), EC_GROUP_get0_order(group_)) < 0,
+                   "Invalid sm2 scalar.");
+    }
+  }
+
+  void HashToPoint(ByteContainerView item, uint8_t* out) {
+    switch (curve_) {
+      case CurveType::kCurve25519:
+        crypto_hash_sha256(out, item.data(), item.size());
+        return;
+      case CurveType::kRistretto255: {
+        uint8_t hash[crypto_hash_sha512_BYTES];
+        crypto_hash_sha512(hash, item.data(), item.size());
+        crypto_core_ristretto255_from_hash(out, hash);
+        return;
+      }
+      case CurveType::kSm2:
+        Sm2HashToPoint(item);
+        Sm2Encode(out);
+        return;
+    }
+  }
+
+  void Mul(const uint8_t* in, uint8_t* out) {
+    switch (curve_) {
+      case CurveType::kCurve25519:
+      case CurveType::kRistretto255: {
+        // in and out may alias.
+        uint8_t result[kSodiumPointBytes];
+        const int rc =
+            curve_ == CurveType::kCurve25519
+                ? crypto_scalarmult_curve25519(result, scalar_.data(), in)
+                : crypto_scalarmult_ristretto255(result, scalar_.data(), in);
+        YASL_ENFORCE(rc == 0, "Invalid or low order point.");
+        std::memcpy(out, result, kSodiumPointBytes);
+        return;
+      }
+      case CurveType::kSm2:
+        YASL_ENFORCE(EC_POINT_oct2point(group_, point_.get(), in,
+                                        kSm2PointBytes, bn_ctx_.get()) == 1,
+                     "Invalid point.");
+        Sm2Mul();
+        Sm2Encode(out);
+        return;
+    }
+  }
+
+  void HashAndMul(ByteContainerView item, uint8_t* out) {
+    if (curve_ == CurveType::kSm2) {
+      // skips decoding the point, which takes a square root.
+      Sm2HashToPoint(item);
+      Sm2Mul();
+      Sm2Encode(out);
+      return;
+    }
+    HashToPoint(item, out);
+    Mul(out, out);
+  }
+
+ private:
+  void Sm2HashToPoint(ByteContainerView item) {
+    uint8_t digest[EVP_MAX_MD_SIZE];
+    for (uint32_t i = 0; i < kSm2MaxTries; i++) {
+      const uint8_t counter[4] = {
+          static_cast<uint8_t>(i >> 24), static_cast<uint8_t>(i >> 16),
+          static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)};
+      unsigned int digest_len;
+      YASL_ENFORCE(
+          EVP_DigestInit_ex(md_ctx_.get(), EVP_sm3(), nullptr) == 1 &&
+          EVP_DigestUpdate(md_ctx_.get(), item.data(), item.size()) == 1 &&
+          EVP_DigestUpdate(md_ctx_.get(), counter, sizeof(counter)) == 1 &&
+          EVP_DigestFinal_ex(md_ctx_.get(), digest, &digest_len) == 1);
+      YASL_ENFORCE(BN_bin2bn(digest, digest_len, x_.get()) != nullptr);
+      // the even y, if x is a coordinate at all.
+      if (BN_cmp(x_.get(), p_.get()) < 0 &&
+          EC_POINT_set_compressed_coordinates(group_, point_.get(), x_.get(),
+                                              0, bn_ctx_.get()) == 1) {
+        return;
+      }
+      ERR_clear_error();
+    }
+    YASL_THROW("Failed to hash to the sm2 curve.");
+  }
+
+  void Sm2Mul() {
+    YASL_ENFORCE(EC_POINT_mul(group_, point_.get(), nullptr, point_.get(),
+                              k_.get(), bn_ctx_.get()) == 1);
+  }
+
+  void Sm2Encode(uint8_t* out) {
+    // the point at infinity would take 1 byte.
+    YASL_ENFORCE_EQ(
+        EC_POINT_point2oct(group_, point_.get(), POINT_CONVERSION_COMPRESSED,
+                           out, kSm2PointBytes, bn_ctx_.get()),
+        kSm2PointBytes);
+  }
+
+  const CurveType curve_;
+  const EC_GROUP* group_;
+  const ByteContainerView scalar_;
+  UniqueBnCtx bn_ctx_;
+  UniqueBn k_;
+  UniqueBn p_;
+  UniqueBn x_;
+  UniquePoint point_;
+  UniqueMdCtx md_ctx_;
+};
+
+}  // namespace
+
+EccBatch::EccBatch(CurveType curve)
+    : curve_(curve), group_(nullptr, EC_GROUP_free) {
+  YASL_ENFORCE(sodium_init() >= 0, "sodium_init failed");
+  switch (curve_) {
+    case CurveType::kCurve25519:
+    case CurveType::kRistretto255:
+      break;
+    case CurveType::kSm2:
+      group_.reset(EC_GROUP_new_by_curve_name(NID_sm2));
+      YASL_ENFORCE(group_ != nullptr);
+      break;
+    default:
+      YASL_THROW("Unknown curve: {}", static_cast<int>(curve_));
+  }
+}
+
+EccBatch::~EccBatch() = default;
+
+size_t EccBatch::PointSize() const {
+  return curve_ == CurveType::kSm2 ? kSm2PointBytes : kSodiumPointBytes;
+}
+
+size_t EccBatch::ScalarSize() const { return kScalarBytes; }
+
+std::vector<uint8_t> EccBatch::RandomScalar() const {
+  std::vector<uint8_t> scalar(kScalarBytes);
+  switch (curve_) {
+    case CurveType::kCurve25519:
+      // clamped by x25519.
+      randombytes_buf(scalar.data(), scalar.size());
+      break;
+    case CurveType::kRistretto255:
+      crypto_core_ristretto255_scalar_random(scalar.data());
+      break;
+    case CurveType::kSm2: {
+      UniqueBn k(BN_new(), BN_free);
+      YASL_ENFORCE(k != nullptr);
+      do {
+        YASL_ENFORCE_EQ(
+            BN_priv_rand_range(k.get(), EC_GROUP_get0_order(group_.get())), 1);
+      } while (BN_is_zero(k.get()));
+      YASL_ENFORCE_EQ(BN_bn2binpad(k.get(), scalar.data(), scalar.size()),
+                      (int)scalar.size());
+      break;
+    }
+  }
+  return scalar;
+}
+
+void EccBatch::HashToPoints(absl::Span<const ByteContainerView> items,
+                            absl::Span<uint8_t> out) const {
+  const size_t point_size = PointSize();
+  YASL_ENFORCE_EQ(out.size(), items.size() * point_size);
+  parallel_for(0, items.size(), kGrainSize, [&](int64_t begin, int64_t end) {
+    Worker worker(curve_, group_.get(), {});
+    for (int64_t i = begin; i < end; i++) {
+      worker.HashToPoint(items[i], out.data() + i * point_size);
+    }
+  });
+}
+
+Buffer EccBatch::HashToPoints(absl::Span<const ByteContainerView> items) const {
+  Buffer out(items.size() * PointSize());
+  HashToPoints(items, absl::MakeSpan(out.data<uint8_t>(), out.size()));
+  return out;
+}
+
+void EccBatch::Mul(ByteContainerView scalar, ByteContainerView points,
+                   absl::Span<uint8_t> out) const {
+  const size_t point_size = PointSize();
+  YASL_ENFORCE_EQ(scalar.size(), kScalarBytes);
+  YASL_ENFORCE_EQ(points.size() % point_size, 0U);
+  YASL_ENFORCE_EQ(out.size(), points.size());
+  const int64_t num_points = points.size() / point_size;
+  parallel_for(0, num_points, kGrainSize, [&](int64_t begin, int64_t end) {
+    Worker worker(curve_, group_.get(), scalar);
+    for (int64_t i = begin; i < end; i++) {
+      worker.Mul(points.data() + i * point_size, out.data() + i * point_size);
+    }
+  });
+}
+
+Buffer EccBatch::Mul(ByteContainerView scalar,
+                     ByteContainerView points) const {
+  Buffer out(points.size());
+  Mul(scalar, points, absl::MakeSpan(out.data<uint8_t>(), out.size()));
+  return out;
+}
+
+void EccBatch::HashAndMul(ByteContainerView scalar,
+                          absl::Span<const ByteContainerView> items,
+                          absl::Span<uint8_t> out) const {
+  const size_t point_size = PointSize();
+  YASL_ENFORCE_EQ(scalar.size(), kScalarBytes);
+  YASL_ENFORCE_EQ(out.size(), items.size() * point_size);
+  parallel_for(0, items.size(), kGrainSize, [&](int64_t begin, int64_t end) {
+    Worker worker(curve_, group_.get(), scalar);
+    for (int64_t i = begin; i < end; i++) {
+      worker.HashAndMul(items[i], out.data() + i * point_size);
+    }
+  });
+}
+
+Buffer EccBatch::HashAndMul(ByteContainerView scalar,
+                            absl::Span<const ByteContainerView> items) const {
+  Buffer out(items.size() * PointSize());
+  HashAndMul(scalar, items, absl::MakeSpan(out.data<uint8_t>(), out.size()));
+  return out;
+}
+
+}  // namespace yasl::crypto
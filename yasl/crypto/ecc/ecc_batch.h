@@ -0,0 +1,85 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/byte_container_view.h"
+
+// from openssl.
+struct ec_group_st;
+
+namespace yasl::crypto {
+
+enum class CurveType : int {
+  // x25519 on the u coordinate, a point is the sha-256 of the item.
+  kCurve25519,
+  // libsodium ristretto255, points from the sha-512 of the item.
+  kRistretto255,
+  // the sm2 curve, compressed points. An item is hashed to x by sm3, with a
+  // counter tried until x is on the curve.
+  kSm2,
+};
+
+// Batched elliptic curve operations of ECDH-PSI: hashing items to points and
+// multiplying points by a secret scalar, spread over the thread pool. Points
+// are packed back to back in fixed size encodings, so a batch is one buffer
+// to send as is. On all the curves, Mul(a, Mul(b, p)) == Mul(b, Mul(a, p)).
+//
+// Thread safe.
+class EccBatch {
+ public:
+  explicit EccBatch(CurveType curve);
+  ~EccBatch();
+
+  CurveType Curve() const { return curve_; }
+  // 32, or 33 for sm2.
+  size_t PointSize() const;
+  size_t ScalarSize() const;
+
+  // A fresh secret scalar.
+  std::vector<uint8_t> RandomScalar() const;
+
+  // Writes the point of items[i] to out[PointSize() * i, ...).
+  void HashToPoints(absl::Span<const ByteContainerView> items,
+                    absl::Span<uint8_t> out) const;
+  Buffer HashToPoints(absl::Span<const ByteContainerView> items) const;
+
+  // out = scalar * points, point by point, `out` may be `points`. Raises on
+  // points not on the curve.
+  void Mul(ByteContainerView scalar, ByteContainerView points,
+           absl::Span<uint8_t> out) const;
+  Buffer Mul(ByteContainerView scalar, ByteContainerView points) const;
+
+  // Mul of HashToPoints, the first round of ECDH-PSI, in one pass.
+  void HashAndMul(ByteContainerView scalar,
+                  absl::Span<const ByteContainerView> items,
+                  absl::Span<uint8_t> out) const;
+  Buffer HashAndMul(ByteContainerView scalar,
+                    absl::Span<const ByteContainerView> items) const;
+
+ private:
+  const CurveType curve_;
+  // only for sm2.
+  std::unique_ptr<ec_group_st, void (*)(ec_group_st*)> group_;
+};
+
+}  // namespace yasl::crypto
@@ -0,0 +1,65 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "yasl/crypto/ecc/ecc_batch.h"
+
+namespace {
+
+std::vector<std::string> MakeItems(size_t n) {
+  std::vector<std::string> items(n);
+  for (size_t i = 0; i < n; ++i) {
+    items[i] = "item " + std::to_string(i);
+  }
+  return items;
+}
+
+}  // namespace
+
+// state.range(0) is the curve, state.range(1) the number of items.
+static void BM_HashAndMul(benchmark::State& state) {
+  yasl::crypto::EccBatch ecc(
+      static_cast<yasl::crypto::CurveType>(state.range(0)));
+  const auto items = MakeItems(state.range(1));
+  const std::vector<yasl::ByteContainerView> views(items.begin(), items.end());
+  const auto scalar = ecc.RandomScalar();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ecc.HashAndMul(scalar, views));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+static void BM_Mul(benchmark::State& state) {
+  yasl::crypto::EccBatch ecc(
+      static_cast<yasl::crypto::CurveType>(state.range(0)));
+  const auto items = MakeItems(state.range(1));
+  const std::vector<yasl::ByteContainerView> views(items.begin(), items.end());
+  const auto scalar = ecc.RandomScalar();
+  const auto points = ecc.HashToPoints(views);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ecc.Mul(scalar, points));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+BENCHMARK(BM_HashAndMul)
+    ->Unit(benchmark::kMillisecond)
+    ->ArgsProduct({{0, 1, 2}, {1 << 10, 1 << 16}});
+BENCHMARK(BM_Mul)
+    ->Unit(benchmark::kMillisecond)
+    ->ArgsProduct({{0, 1, 2}, {1 << 10, 1 << 16}});
@@ -0,0 +1,100 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/ecc/ecc_batch.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl::crypto {
+
+class EccBatchTest : public testing::TestWithParam<CurveType> {};
+
+INSTANTIATE_TEST_SUITE_P(Curves, EccBatchTest,
+                         testing::Values(CurveType::kCurve25519,
+                                         CurveType::kRistretto255,
+                                         CurveType::kSm2));
+
+TEST_P(EccBatchTest, EcdhPsi_ShouldOk) {
+  EccBatch ecc(GetParam());
+  const size_t point_size = ecc.PointSize();
+  std::vector<std::string> items_a;
+  std::vector<std::string> items_b;
+  for (int i = 0; i < 100; i++) {
+    items_a.push_back("item " + std::to_string(i));
+    // the odd ones are shared.
+    items_b.push_back("item " + std::to_string(i % 2 == 1 ? i : -i - 1));
+  }
+  std::vector<ByteContainerView> views_a(items_a.begin(), items_a.end());
+  std::vector<ByteContainerView> views_b(items_b.begin(), items_b.end());
+  const auto a = ecc.RandomScalar();
+  const auto b = ecc.RandomScalar();
+  ASSERT_EQ(a.size(), ecc.ScalarSize());
+  EXPECT_NE(a, b);
+
+  // first round, hash and multiply by the own scalar.
+  Buffer round_a = ecc.HashAndMul(a, views_a);
+  Buffer round_b = ecc.HashAndMul(b, views_b);
+  ASSERT_EQ(round_a.size(), static_cast<int64_t>(100 * point_size));
+  Buffer hashed_a = ecc.HashToPoints(views_a);
+  EXPECT_EQ(ecc.Mul(a, hashed_a), round_a);
+
+  // second round, in place.
+  auto span_a = absl::MakeSpan(round_a.data<uint8_t>(), round_a.size());
+  auto span_b = absl::MakeSpan(round_b.data<uint8_t>(), round_b.size());
+  ecc.Mul(b, span_a, span_a);
+  ecc.Mul(a, span_b, span_b);
+  for (int i = 0; i < 100; i++) {
+    const bool equal =
+        std::equal(span_a.begin() + i * point_size,
+                   span_a.begin() + (i + 1) * point_size,
+                   span_b.begin() + i * point_size);
+    EXPECT_EQ(equal, i % 2 == 1) << i;
+  }
+}
+
+TEST_P(EccBatchTest, HashToPoints_ShouldBeDeterministic) {
+  EccBatch ecc(GetParam());
+  std::vector<ByteContainerView> items = {"", "a", "b", "a"};
+  Buffer points = ecc.HashToPoints(items);
+  const auto* p = points.data<uint8_t>();
+  const size_t size = ecc.PointSize();
+  EXPECT_TRUE(std::equal(p + size, p + 2 * size, p + 3 * size));
+  EXPECT_FALSE(std::equal(p + size, p + 2 * size, p + 2 * size));
+  EXPECT_EQ(ecc.HashToPoints(items), points);
+}
+
+TEST_P(EccBatchTest, InvalidInput_ShouldThrowException) {
+  EccBatch ecc(GetParam());
+  const auto scalar = ecc.RandomScalar();
+  std::vector<uint8_t> points(ecc.PointSize() * 2, 0);
+  std::vector<uint8_t> out(points.size());
+  if (GetParam() != CurveType::kCurve25519) {
+    EXPECT_THROW(ecc.Mul(scalar, points, absl::MakeSpan(out)),
+                 yasl::Exception);
+  }
+  // not whole points.
+  EXPECT_THROW(ecc.Mul(scalar, absl::MakeConstSpan(points).first(3),
+                       absl::MakeSpan(out).first(3)),
+               yasl::Exception);
+  EXPECT_THROW(ecc.Mul(absl::MakeConstSpan(scalar).first(16), points,
+                       absl::MakeSpan(out)),
+               yasl::Exception);
+}
+
+}  // namespace yasl::crypto
@@ -15,6 +15,8 @@
 
 #include "yasl/crypto/gcm_crypto.h"
 
+#include <algorithm>
+
 #include "openssl/evp.h"
 
 #include "yasl/base/exception.h"
@@ -55,13 +57,17 @@ void GcmCrypto::Encrypt(ByteContainerView plaintext, ByteContainerView aad,
                         absl::Span<uint8_t> mac) const {
   YASL_ENFORCE_EQ(ciphertext.size(), plaintext.size());
   YASL_ENFORCE_EQ(mac.size(), GetMacSize(schema_));
+  const EVP_CIPHER* cipher = CreateEvpCipher(schema_);
+  YASL_ENFORCE_EQ(key_.size(), (size_t)EVP_CIPHER_key_length(cipher));
+  YASL_ENFORCE_EQ(iv_.size(), (size_t)EVP_CIPHER_iv_length(cipher));
+  if (GetCryptoBackend() == CryptoBackend::kIppCrypto) {
+    IppGcm(key_).Encrypt(iv_, plaintext, aad, ciphertext, mac);
+    return;
+  }
 
   EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
   YASL_ENFORCE(ctx, "Failed to new evp cipher context.");
   ON_SCOPE_EXIT([&] { EVP_CIPHER_CTX_free(ctx); });
-  const EVP_CIPHER* cipher = CreateEvpCipher(schema_);
-  YASL_ENFORCE_EQ(key_.size(), (size_t)EVP_CIPHER_key_length(cipher));
-  YASL_ENFORCE_EQ(iv_.size(), (size_t)EVP_CIPHER_iv_length(cipher));
   YASL_ENFORCE_EQ(
       EVP_EncryptInit_ex(ctx, cipher, nullptr, key_.data(), iv_.data()), 1);
   int out_length;
@@ -89,13 +95,17 @@ void GcmCrypto::Decrypt(ByteContainerView ciphertext, ByteContainerView aad,
                         absl::Span<uint8_t> plaintext) const {
   YASL_ENFORCE_EQ(ciphertext.size(), plaintext.size());
   YASL_ENFORCE_EQ(mac.size(), GetMacSize(schema_));
+  const EVP_CIPHER* cipher = CreateEvpCipher(schema_);
+  YASL_ENFORCE_EQ(key_.size(), (size_t)EVP_CIPHER_key_length(cipher));
+  YASL_ENFORCE_EQ(iv_.size(), (size_t)EVP_CIPHER_iv_length(cipher));
+  if (GetCryptoBackend() == CryptoBackend::kIppCrypto) {
+    IppGcm(key_).Decrypt(iv_, ciphertext, aad, mac, plaintext);
+    return;
+  }
 
   EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
   YASL_ENFORCE(ctx, "Failed to new evp cipher context.");
   ON_SCOPE_EXIT([&] { EVP_CIPHER_CTX_free(ctx); });
-  const EVP_CIPHER* cipher = CreateEvpCipher(schema_);
-  YASL_ENFORCE_EQ(key_.size(), (size_t)EVP_CIPHER_key_length(cipher));
-  YASL_ENFORCE_EQ(iv_.size(), (size_t)EVP_CIPHER_iv_length(cipher));
   YASL_ENFORCE(
       EVP_DecryptInit_ex(ctx, cipher, nullptr, key_.data(), iv_.data()));
 
@@ -120,4 +130,274 @@ void GcmCrypto::Decrypt(ByteContainerView ciphertext, ByteContainerView aad,
                   "Failed to verfiy mac.");
 }
 
+namespace {
+
+// EVP takes int lengths, longer data is fed piece by piece.
+constexpr size_t kMaxUpdateSize = 1U << 30;
+
+}  // namespace
+
+GcmCipherContext::GcmCipherContext(GcmCryptoSchema schema,
+                                   ByteContainerView key)
+    : schema_(schema),
+      encrypt_ctx_(nullptr, EVP_CIPHER_CTX_free),
+      decrypt_ctx_(nullptr, EVP_CIPHER_CTX_free) {
+  const EVP_CIPHER* cipher = CreateEvpCipher(schema_);
+  YASL_ENFORCE_EQ(key.size(), (size_t)EVP_CIPHER_key_length(cipher));
+  if (GetCryptoBackend() == CryptoBackend::kIppCrypto) {
+    ipp_encrypt_ = std::make_unique<IppGcm>(key);
+    ipp_decrypt_ = std::make_unique<IppGcm>(key);
+    return;
+  }
+  encrypt_ctx_.reset(EVP_CIPHER_CTX_new());
+  decrypt_ctx_.reset(EVP_CIPHER_CTX_new());
+  YASL_ENFORCE(encrypt_ctx_ && decrypt_ctx_,
+               "Failed to new evp cipher context.");
+  YASL_ENFORCE_EQ(EVP_EncryptInit_ex(encrypt_ctx_.get(), cipher, nullptr,
+                                     key.data(), nullptr),
+                  1);
+  YASL_ENFORCE_EQ(EVP_DecryptInit_ex(decrypt_ctx_.get(), cipher, nullptr,
+                                     key.data(), nullptr),
+                  1);
+}
+
+size_t GcmCipherContext::MacSize() const { return GetMacSize(schema_); }
+
+void GcmCipherContext::Encrypt(ByteContainerView iv,
+                               ByteContainerView plaintext,
+                               ByteContainerView aad,
+                               absl::Span<uint8_t> ciphertext,
+                               absl::Span<uint8_t> mac) {
+  if (ipp_encrypt_) {
+    YASL_ENFORCE_EQ(ciphertext.size(), plaintext.size());
+    YASL_ENFORCE_EQ(mac.size(), GetMacSize(schema_));
+    YASL_ENFORCE_EQ(iv.size(),
+                    (size_t)EVP_CIPHER_iv_length(CreateEvpCipher(schema_)));
+    ipp_encrypt_->Encrypt(iv, plaintext, aad, ciphertext, mac);
+    return;
+  }
+  EVP_CIPHER_CTX* ctx = encrypt_ctx_.get();
+  YASL_ENFORCE_EQ(ciphertext.size(), plaintext.size());
+  YASL_ENFORCE_EQ(mac.size(), GetMacSize(schema_));
+  YASL_ENFORCE_EQ(iv.size(), (size_t)EVP_CIPHER_CTX_iv_length(ctx));
+
+  // keeps the key schedule, only the iv is reset.
+  YASL_ENFORCE_EQ(
+      EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, iv.data()), 1);
+  int out_length;
+  if (!aad.empty()) {
+    YASL_ENFORCE_EQ(EVP_EncryptUpdate(ctx, nullptr, &out_length, aad.data(),
+                                      aad.size()),
+                    1);
+  }
+  for (size_t pos = 0; pos < plaintext.size(); pos += kMaxUpdateSize) {
+    const size_t size = std::min(kMaxUpdateSize, plaintext.size() - pos);
+    YASL_ENFORCE_EQ(EVP_EncryptUpdate(ctx, ciphertext.data() + pos, &out_length,
+                                      plaintext.data() + pos, size),
+                    1);
+    YASL_ENFORCE_EQ(out_length, (int)size, "Unexpected encrypte out length.");
+  }
+  // Note that get no output here as the data is always aligned for GCM.
+  EVP_EncryptFinal_ex(ctx, nullptr, &out_length);
+  YASL_ENFORCE_EQ(
+      EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, mac.size(), mac.data()),
+      1, "Failed to get mac.");
+}
+
+void GcmCipherContext::Decrypt(ByteContainerView iv,
+                               ByteContainerView ciphertext,
+                               ByteContainerView aad, ByteContainerView mac,
+                               absl::Span<uint8_t> plaintext) {
+  if (ipp_decrypt_) {
+    YASL_ENFORCE_EQ(ciphertext.size(), plaintext.size());
+    YASL_ENFORCE_EQ(mac.size(), GetMacSize(schema_));
+    YASL_ENFORCE_EQ(iv.size(),
+                    (size_t)EVP_CIPHER_iv_length(CreateEvpCipher(schema_)));
+    ipp_decrypt_->Decrypt(iv, ciphertext, aad, mac, plaintext);
+    return;
+  }
+  EVP_CIPHER_CTX* ctx = decrypt_ctx_.get();
+  YASL_ENFORCE_EQ(ciphertext.size(), plaintext.size());
+  YASL_ENFORCE_EQ(mac.size(), GetMacSize(schema_));
+  YASL_ENFORCE_EQ(iv.size(), (size_t)EVP_CIPHER_CTX_iv_length(ctx));
+
+  YASL_ENFORCE_EQ(
+      EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, iv.data()), 1);
+  int out_length;
+  if (!aad.empty()) {
+    YASL_ENFORCE_EQ(EVP_DecryptUpdate(ctx, nullptr, &out_length, aad.data(),
+                                      aad.size()),
+                    1);
+  }
+  for (size_t pos = 0; pos < ciphertext.size(); pos += kMaxUpdateSize) {
+    const size_t size = std::min(kMaxUpdateSize, ciphertext.size() - pos);
+    YASL_ENFORCE_EQ(EVP_DecryptUpdate(ctx, plaintext.data() + pos, &out_length,
+                                      ciphertext.data() + pos, size),
+                    1);
+    YASL_ENFORCE_EQ(out_length, (int)size, "Unexpcted decryption out length.");
+  }
+  YASL_ENFORCE_EQ(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, mac.size(),
+                                      (void*)mac.data()),
+                  1, "Failed to set mac.");
+  YASL_ENFORCE_EQ(EVP_DecryptFinal_ex(ctx, nullptr, &out_length), 1,
+                  "Failed to verfiy mac.");
+}
+
+namespace {
+
+// feeds `in` to an EVP update, kMaxUpdateSize at a time.
+template <typename UpdateFn>
+void StreamUpdate(EVP_CIPHER_CTX* ctx, UpdateFn update,
+                  absl::Span<const uint8_t> in, uint8_t* out) {
+  int out_length;
+  for (size_t pos = 0; pos < in.size(); pos += kMaxUpdateSize) {
+    const size_t size = std::min(kMaxUpdateSize, in.size() - pos);
+    YASL_ENFORCE_EQ(update(ctx, out == nullptr ? nullptr : out + pos,
+                           &out_length, in.data() + pos, size),
+                    1);
+    YASL_ENFORCE_EQ(out_length, (int)size, "Unexpected gcm out length.");
+  }
+}
+
+}  // namespace
+
+GcmEncryptor::GcmEncryptor(GcmCryptoSchema schema, ByteContainerView key)
+    : schema_(schema), ctx_(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free) {
+  const EVP_CIPHER* cipher = CreateEvpCipher(schema_);
+  YASL_ENFORCE_EQ(key.size(), (size_t)EVP_CIPHER_key_length(cipher));
+  YASL_ENFORCE(ctx_, "Failed to new evp cipher context.");
+  YASL_ENFORCE_EQ(
+      EVP_EncryptInit_ex(ctx_.get(), cipher, nullptr, key.data(), nullptr), 1);
+}
+
+size_t GcmEncryptor::MacSize() const { return GetMacSize(schema_); }
+
+void GcmEncryptor::Start(ByteContainerView iv) {
+  YASL_ENFORCE_EQ(iv.size(), (size_t)EVP_CIPHER_CTX_iv_length(ctx_.get()));
+  // keeps the key schedule, only the iv is reset.
+  YASL_ENFORCE_EQ(
+      EVP_EncryptInit_ex(ctx_.get(), nullptr, nullptr, nullptr, iv.data()), 1);
+  state_ = State::kAad;
+}
+
+void GcmEncryptor::UpdateAad(ByteContainerView aad) {
+  YASL_ENFORCE(state_ == State::kAad, "Aad goes between Start and Update.");
+  StreamUpdate(ctx_.get(), EVP_EncryptUpdate, aad, nullptr);
+}
+
+void GcmEncryptor::Update(absl::Span<const uint8_t> in,
+                          absl::Span<uint8_t> out) {
+  YASL_ENFORCE(state_ != State::kIdle, "Start a message first.");
+  YASL_ENFORCE_EQ(out.size(), in.size());
+  StreamUpdate(ctx_.get(), EVP_EncryptUpdate, in, out.data());
+  state_ = State::kData;
+}
+
+void GcmEncryptor::Finalize(absl::Span<uint8_t> mac) {
+  YASL_ENFORCE(state_ != State::kIdle, "Start a message first.");
+  YASL_ENFORCE_EQ(mac.size(), GetMacSize(schema_));
+  state_ = State::kIdle;
+  int out_length;
+  // Note that get no output here as the data is always aligned for GCM.
+  YASL_ENFORCE_EQ(EVP_EncryptFinal_ex(ctx_.get(), nullptr, &out_length), 1);
+  YASL_ENFORCE_EQ(EVP_CIPHER_CTX_ctrl(ctx_.get(), EVP_CTRL_GCM_GET_TAG,
+                                      mac.size(), mac.data()),
+                  1, "Failed to get mac.");
+}
+
+GcmDecryptor::GcmDecryptor(GcmCryptoSchema schema, ByteContainerView key)
+    : schema_(schema), ctx_(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free) {
+  const EVP_CIPHER* cipher = CreateEvpCipher(schema_);
+  YASL_ENFORCE_EQ(key.size(), (size_t)EVP_CIPHER_key_length(cipher));
+  YASL_ENFORCE(ctx_, "Failed to new evp cipher context.");
+  YASL_ENFORCE_EQ(
+      EVP_DecryptInit_ex(ctx_.get(), cipher, nullptr, key.data(), nullptr), 1);
+}
+
+size_t GcmDecryptor::MacSize() const { return GetMacSize(schema_); }
+
+void GcmDecryptor::Start(ByteContainerView iv) {
+  YASL_ENFORCE_EQ(iv.size(), (size_t)EVP_CIPHER_CTX_iv_length(ctx_.get()));
+  YASL_ENFORCE_EQ(
+      EVP_DecryptInit_ex(ctx_.get(), nullptr, nullptr, nullptr, iv.data()), 1);
+  state_ = State::kAad;
+}
+
+void GcmDecryptor::UpdateAad(ByteContainerView aad) {
+  YASL_ENFORCE(state_ == State::kAad, "Aad goes between Start and Update.");
+  StreamUpdate(ctx_.get(), EVP_DecryptUpdate, aad, nullptr);
+}
+
+void GcmDecryptor::Update(absl::Span<const uint8_t> in,
+                          absl::Span<uint8_t> out) {
+  YASL_ENFORCE(state_ != State::kIdle, "Start a message first.");
+  YASL_ENFORCE_EQ(out.size(), in.size());
+  StreamUpdate(ctx_.get(), EVP_DecryptUpdate, in, out.data());
+  state_ = State::kData;
+}
+
+void GcmDecryptor::Finalize(ByteContainerView mac) {
+  YASL_ENFORCE(state_ != State::kIdle, "Start a message first.");
+  YASL_ENFORCE_EQ(mac.size(), GetMacSize(schema_));
+  state_ = State::kIdle;
+  YASL_ENFORCE_EQ(EVP_CIPHER_CTX_ctrl(ctx_.get(), EVP_CTRL_GCM_SET_TAG,
+                                      mac.size(), (void*)mac.data()),
+                  1, "Failed to set mac.");
+  int out_length;
+  YASL_ENFORCE_EQ(EVP_DecryptFinal_ex(ctx_.get(), nullptr, &out_length), 1,
+                  "Failed to verfiy mac.");
+}
+
+GcmBatchSealer::GcmBatchSealer(GcmCryptoSchema schema, ByteContainerView key,
+                               ByteContainerView nonce_base)
+    : ctx_(schema, key) {
+  YASL_ENFORCE_EQ(nonce_base.size(), kNonceSize);
+  std::copy(nonce_base.begin(), nonce_base.end(), nonce_base_.begin());
+}
+
+std::array<uint8_t, GcmBatchSealer::kNonceSize> GcmBatchSealer::Nonce(
+    uint64_t seq) const {
+  auto nonce = nonce_base_;
+  for (size_t i = 0; i < 8; i++) {
+    nonce[kNonceSize - 1 - i] ^= static_cast<uint8_t>(seq >> (8 * i));
+  }
+  return nonce;
+}
+
+void GcmBatchSealer::Seal(absl::Span<const ByteContainerView> in,
+                          ByteContainerView aad,
+                          absl::Span<const absl::Span<uint8_t>> out) {
+  YASL_ENFORCE_EQ(in.size(), out.size());
+  // a wrapped sequence would reuse nonces.
+  YASL_ENFORCE(in.size() <= UINT64_MAX - seal_seq_, "Sequence exhausted.");
+  const size_t mac_size = MacSize();
+  for (size_t i = 0; i < in.size(); i++) {
+    YASL_ENFORCE_EQ(out[i].size(), in[i].size() + mac_size);
+  }
+  for (size_t i = 0; i < in.size(); i++) {
+    // advanced before the record is sealed, so that a failed call never
+    // hands its nonces out again.
+    const auto nonce = Nonce(seal_seq_++);
+    ctx_.Encrypt(nonce, in[i], aad, out[i].first(in[i].size()),
+                 out[i].subspan(in[i].size()));
+  }
+}
+
+void GcmBatchSealer::Open(absl::Span<const ByteContainerView> in,
+                          ByteContainerView aad,
+                          absl::Span<const absl::Span<uint8_t>> out) {
+  YASL_ENFORCE_EQ(in.size(), out.size());
+  YASL_ENFORCE(in.size() <= UINT64_MAX - open_seq_, "Sequence exhausted.");
+  const size_t mac_size = MacSize();
+  for (size_t i = 0; i < in.size(); i++) {
+    YASL_ENFORCE(in[i].size() >= mac_size, "Record {} is too short.", i);
+    const size_t size = in[i].size() - mac_size;
+    YASL_ENFORCE_EQ(out[i].size(), size);
+    const auto nonce = Nonce(open_seq_ + i);
+    ctx_.Decrypt(nonce, in[i].subspan(0, size), aad, in[i].subspan(size),
+                 out[i]);
+  }
+  open_seq_ += in.size();
+}
+
 }  // namespace yasl::crypto
@@ -14,11 +14,18 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "absl/types/span.h"
 
 #include "yasl/base/byte_container_view.h"
+#include "yasl/crypto/ipp_crypto.h"
+
+// from openssl.
+struct evp_cipher_ctx_st;
 
 namespace yasl::crypto {
 
@@ -60,6 +67,141 @@ class Aes256GcmCrypto : public GcmCrypto {
   Aes256GcmCrypto(ByteContainerView key, ByteContainerView iv)
       : GcmCrypto(GcmCryptoSchema::AES256_GCM, key, iv) {}
 };
+// Encrypts and decrypts many messages with one key, each by its own iv. Unlike
+// GcmCrypto, the cipher contexts and the key schedule are set up only once,
+// which dominates the cost of short messages. Input and output may be the
+// same buffer, for in place operation.
+//
+// Not thread safe, but one Encrypt and one Decrypt may run concurrently.
+class GcmCipherContext {
+ public:
+  GcmCipherContext(GcmCryptoSchema schema, ByteContainerView key);
+
+  size_t MacSize() const;
+
+  void Encrypt(ByteContainerView iv, ByteContainerView plaintext,
+               ByteContainerView aad, absl::Span<uint8_t> ciphertext,
+               absl::Span<uint8_t> mac);
+
+  // raise if the mac does not match.
+  void Decrypt(ByteContainerView iv, ByteContainerView ciphertext,
+               ByteContainerView aad, ByteContainerView mac,
+               absl::Span<uint8_t> plaintext);
+
+ private:
+  using CipherCtxPtr =
+      std::unique_ptr<evp_cipher_ctx_st, void (*)(evp_cipher_ctx_st*)>;
+
+  const GcmCryptoSchema schema_;
+  // nullptr on IPP-Crypto.
+  CipherCtxPtr encrypt_ctx_;
+  CipherCtxPtr decrypt_ctx_;
+
+  std::unique_ptr<IppGcm> ipp_encrypt_;
+  std::unique_ptr<IppGcm> ipp_decrypt_;
+};
+
+// Encrypts one message piece by piece, for data that does not fit in memory
+// or arrives in chunks. The key schedule is set up once, Start begins each
+// new message. Per message:
+//
+//   Start(iv), UpdateAad(aad)*, Update(in, out)*, Finalize(mac)
+//
+// Update writes in.size() bytes to `out`, which may be `in` itself. Pieces
+// can have any length, the output equals GcmCrypto over their concatenation.
+//
+// Always runs on OpenSSL, the IPP-Crypto backend has no streaming here.
+class GcmEncryptor {
+ public:
+  GcmEncryptor(GcmCryptoSchema schema, ByteContainerView key);
+
+  size_t MacSize() const;
+
+  void Start(ByteContainerView iv);
+  // all the aad goes before the first Update.
+  void UpdateAad(ByteContainerView aad);
+  void Update(absl::Span<const uint8_t> in, absl::Span<uint8_t> out);
+  void Finalize(absl::Span<uint8_t> mac);
+
+ private:
+  using CipherCtxPtr =
+      std::unique_ptr<evp_cipher_ctx_st, void (*)(evp_cipher_ctx_st*)>;
+
+  enum class State { kIdle, kAad, kData };
+
+  const GcmCryptoSchema schema_;
+  CipherCtxPtr ctx_;
+  State state_ = State::kIdle;
+};
+
+// The decrypting side of GcmEncryptor. Finalize raises if the mac does not
+// match, the plaintext written by Update must not be trusted before that.
+class GcmDecryptor {
+ public:
+  GcmDecryptor(GcmCryptoSchema schema, ByteContainerView key);
+
+  size_t MacSize() const;
+
+  void Start(ByteContainerView iv);
+  // all the aad goes before the first Update.
+  void UpdateAad(ByteContainerView aad);
+  void Update(absl::Span<const uint8_t> in, absl::Span<uint8_t> out);
+  void Finalize(ByteContainerView mac);
+
+ private:
+  using CipherCtxPtr =
+      std::unique_ptr<evp_cipher_ctx_st, void (*)(evp_cipher_ctx_st*)>;
+
+  enum class State { kIdle, kAad, kData };
+
+  const GcmCryptoSchema schema_;
+  CipherCtxPtr ctx_;
+  State state_ = State::kIdle;
+};
+
+// Seals many records under one key, the nonce of each is derived from its
+// sequence number as in TLS 1.3: the big endian number xor the last 8 bytes
+// of `nonce_base`. Seal and Open each keep their own sequence, starting from
+// 0 and advancing by one per record, so the two sides stay in step without
+// sending nonces. A sealed record is the ciphertext followed by the mac.
+//
+// A (key, nonce_base) pair must seal in one direction only: the two
+// directions of a link each need their own key or nonce_base, otherwise
+// both sides seal under the same nonces.
+//
+// The key schedule is expanded once, a record costs little more than its
+// AES-GCM pass. Not thread safe.
+class GcmBatchSealer {
+ public:
+  static constexpr size_t kNonceSize = 12;
+
+  GcmBatchSealer(GcmCryptoSchema schema, ByteContainerView key,
+                 ByteContainerView nonce_base);
+
+  size_t MacSize() const { return ctx_.MacSize(); }
+  uint64_t SealSequence() const { return seal_seq_; }
+  uint64_t OpenSequence() const { return open_seq_; }
+
+  std::array<uint8_t, kNonceSize> Nonce(uint64_t seq) const;
+
+  // out[i] holds in[i].size() + MacSize() bytes, `aad` is shared by all the
+  // records. sizes are checked before any record is sealed. if a record
+  // fails to seal, the seal sequence stays past it, its nonce is burnt.
+  void Seal(absl::Span<const ByteContainerView> in, ByteContainerView aad,
+            absl::Span<const absl::Span<uint8_t>> out);
+
+  // out[i] holds in[i].size() - MacSize() bytes. Raises if a mac does not
+  // match, the open sequence is then left at the first record of the call.
+  void Open(absl::Span<const ByteContainerView> in, ByteContainerView aad,
+            absl::Span<const absl::Span<uint8_t>> out);
+
+ private:
+  GcmCipherContext ctx_;
+  std::array<uint8_t, kNonceSize> nonce_base_;
+  uint64_t seal_seq_ = 0;
+  uint64_t open_seq_ = 0;
+};
+
 // TODO: Add SM4 GCM when openssl supports.
 
 }  // namespace yasl::crypto
\ No newline at end of file
@@ -112,4 +112,198 @@ TYPED_TEST(AesGcmCryptoTest, EncryptDecrypt_withErrorAAD_ShouldThrowException) {
   });
 }
 
+TEST(GcmCipherContextTest, InPlaceWithManyIvs_ShouldOk) {
+  GcmCipherContext ctx(GcmCryptoSchema::AES128_GCM, std::string(key_128));
+  const std::string aad = "This is additional authenticated data.";
+
+  for (char i = 0; i < 3; i++) {
+    const std::string iv(12, i);
+    const std::string plaintext = "I am a plaintext." + std::string(100, i);
+    Aes128GcmCrypto crypto(std::string(key_128), iv);
+    std::vector<uint8_t> expected(plaintext.size());
+    std::vector<uint8_t> expected_mac(16);
+    crypto.Encrypt(plaintext, aad, absl::MakeSpan(expected),
+                   absl::MakeSpan(expected_mac));
+
+    std::vector<uint8_t> data(plaintext.begin(), plaintext.end());
+    std::vector<uint8_t> mac(ctx.MacSize());
+    ctx.Encrypt(iv, data, aad, absl::MakeSpan(data), absl::MakeSpan(mac));
+    EXPECT_EQ(data, expected);
+    EXPECT_EQ(mac, expected_mac);
+
+    ctx.Decrypt(iv, data, aad, mac, absl::MakeSpan(data));
+    EXPECT_EQ(plaintext, std::string(data.begin(), data.end()));
+
+    mac[0] += 1;
+    EXPECT_ANY_THROW(ctx.Decrypt(iv, data, aad, mac, absl::MakeSpan(data)));
+  }
+}
+
+TEST(GcmStreamTest, ChunkedInPlace_ShouldOk) {
+  const std::string aad = "This is additional authenticated data.";
+  for (auto [schema, key] :
+       {std::make_pair(GcmCryptoSchema::AES128_GCM, std::string(key_128)),
+        std::make_pair(GcmCryptoSchema::AES256_GCM, std::string(key_256))}) {
+    GcmEncryptor encryptor(schema, key);
+    GcmDecryptor decryptor(schema, key);
+    for (size_t chunk : {1, 7, 16, 100, 5000}) {
+      const std::string iv(12, static_cast<char>(chunk));
+      std::vector<uint8_t> plaintext(1000);
+      for (size_t i = 0; i < plaintext.size(); i++) {
+        plaintext[i] = static_cast<uint8_t>(i * 31 + chunk);
+      }
+      std::vector<uint8_t> expected(plaintext.size());
+      std::vector<uint8_t> expected_mac(16);
+      GcmCrypto(schema, key, iv)
+          .Encrypt(plaintext, aad, absl::MakeSpan(expected),
+                   absl::MakeSpan(expected_mac));
+
+      std::vector<uint8_t> data = plaintext;
+      std::vector<uint8_t> mac(encryptor.MacSize());
+      encryptor.Start(iv);
+      encryptor.UpdateAad(std::string_view(aad).substr(0, 5));
+      encryptor.UpdateAad(std::string_view(aad).substr(5));
+      for (size_t pos = 0; pos < data.size(); pos += chunk) {
+        auto piece = absl::MakeSpan(data).subspan(pos, chunk);
+        encryptor.Update(piece, piece);
+      }
+      encryptor.Finalize(absl::MakeSpan(mac));
+      EXPECT_EQ(data, expected);
+      EXPECT_EQ(mac, expected_mac);
+
+      decryptor.Start(iv);
+      decryptor.UpdateAad(aad);
+      for (size_t pos = 0; pos < data.size(); pos += chunk) {
+        auto piece = absl::MakeSpan(data).subspan(pos, chunk);
+        decryptor.Update(piece, piece);
+      }
+      decryptor.Finalize(mac);
+      EXPECT_EQ(data, plaintext);
+
+      mac[0] ^= 1;
+      decryptor.Start(iv);
+      decryptor.UpdateAad(aad);
+      decryptor.Update(expected, absl::MakeSpan(data));
+      EXPECT_ANY_THROW(decryptor.Finalize(mac));
+    }
+  }
+}
+
+TEST(GcmStreamTest, WrongOrder_ShouldThrowException) {
+  GcmEncryptor encryptor(GcmCryptoSchema::AES128_GCM, std::string(key_128));
+  std::vector<uint8_t> data(10);
+  std::vector<uint8_t> mac(16);
+  EXPECT_ANY_THROW(encryptor.Update(data, absl::MakeSpan(data)));
+  EXPECT_ANY_THROW(encryptor.Finalize(absl::MakeSpan(mac)));
+
+  encryptor.Start(std::string(iv_96));
+  encryptor.Update(data, absl::MakeSpan(data));
+  EXPECT_ANY_THROW(encryptor.UpdateAad(std::string("aad")));
+  encryptor.Finalize(absl::MakeSpan(mac));
+  EXPECT_ANY_THROW(encryptor.Finalize(absl::MakeSpan(mac)));
+}
+
+TEST(GcmBatchSealerTest, SealOpen_ShouldOk) {
+  const std::string nonce_base = "abcdefghijkl";
+  const std::string aad = "header";
+  GcmBatchSealer sender(GcmCryptoSchema::AES128_GCM, std::string(key_128),
+                        nonce_base);
+  GcmBatchSealer receiver(GcmCryptoSchema::AES128_GCM, std::string(key_128),
+                          nonce_base);
+
+  std::vector<std::string> records;
+  for (size_t i = 0; i < 20; i++) {
+    records.push_back(std::string(i * 7, static_cast<char>('a' + i)));
+  }
+  std::vector<ByteContainerView> in(records.begin(), records.end());
+  std::vector<std::vector<uint8_t>> sealed;
+  std::vector<absl::Span<uint8_t>> sealed_spans;
+  for (const auto& record : records) {
+    sealed.emplace_back(record.size() + sender.MacSize());
+  }
+  for (auto& s : sealed) {
+    sealed_spans.push_back(absl::MakeSpan(s));
+  }
+  // two calls continue one sequence.
+  sender.Seal(absl::MakeSpan(in).first(5), aad,
+              absl::MakeSpan(sealed_spans).first(5));
+  sender.Seal(absl::MakeSpan(in).subspan(5), aad,
+              absl::MakeSpan(sealed_spans).subspan(5));
+  EXPECT_EQ(sender.SealSequence(), records.size());
+
+  for (size_t i = 0; i < records.size(); i++) {
+    const auto nonce = sender.Nonce(i);
+    std::vector<uint8_t> expected(records[i].size());
+    std::vector<uint8_t> expected_mac(16);
+    Aes128GcmCrypto(std::string(key_128), nonce)
+        .Encrypt(records[i], aad, absl::MakeSpan(expected),
+                 absl::MakeSpan(expected_mac));
+    expected.insert(expected.end(), expected_mac.begin(), expected_mac.end());
+    EXPECT_EQ(sealed[i], expected);
+  }
+  EXPECT_EQ(sender.Nonce(0)[11], 'l');
+  EXPECT_EQ(sender.Nonce(0x102)[10], 'k' ^ 1);
+  EXPECT_EQ(sender.Nonce(0x102)[11], 'l' ^ 2);
+
+  std::vector<ByteContainerView> sealed_views(sealed.begin(), sealed.end());
+  std::vector<std::vector<uint8_t>> opened;
+  std::vector<absl::Span<uint8_t>> opened_spans;
+  for (const auto& record : records) {
+    opened.emplace_back(record.size());
+  }
+  for (auto& o : opened) {
+    opened_spans.push_back(absl::MakeSpan(o));
+  }
+  receiver.Open(sealed_views, aad, opened_spans);
+  EXPECT_EQ(receiver.OpenSequence(), records.size());
+  for (size_t i = 0; i < records.size(); i++) {
+    EXPECT_EQ(std::string(opened[i].begin(), opened[i].end()), records[i]);
+  }
+
+  // out of sequence records do not open.
+  EXPECT_ANY_THROW(receiver.Open(absl::MakeSpan(sealed_views).first(1), aad,
+                                 absl::MakeSpan(opened_spans).first(1)));
+  EXPECT_EQ(receiver.OpenSequence(), records.size());
+}
+
+
+TEST(GcmBatchSealerTest, FailedSeal_ShouldNotReuseNonces) {
+  GcmBatchSealer sender(GcmCryptoSchema::AES128_GCM, std::string(key_128),
+                        std::string("abcdefghijkl"));
+  const std::string record = "record";
+  std::vector<std::vector<uint8_t>> sealed(
+      3, std::vector<uint8_t>(record.size() + sender.MacSize()));
+  std::vector<ByteContainerView> in(3, record);
+  std::vector<absl::Span<uint8_t>> out;
+  for (auto& s : sealed) {
+    out.push_back(absl::MakeSpan(s));
+  }
+  sender.Seal(absl::MakeSpan(in).first(1), "", absl::MakeSpan(out).first(1));
+  ASSERT_EQ(sender.SealSequence(), 1);
+
+  // a bad size anywhere fails the batch before any record is sealed.
+  std::vector<uint8_t> short_out(record.size());
+  out[2] = absl::MakeSpan(short_out);
+  const std::vector<uint8_t> untouched = sealed[1];
+  EXPECT_ANY_THROW(sender.Seal(absl::MakeSpan(in).subspan(1), "",
+                               absl::MakeSpan(out).subspan(1)));
+  EXPECT_EQ(sealed[1], untouched);
+  EXPECT_EQ(sender.SealSequence(), 1);
+
+  // the next batch goes on with fresh nonces.
+  out[2] = absl::MakeSpan(sealed[2]);
+  sender.Seal(absl::MakeSpan(in).subspan(1), "",
+              absl::MakeSpan(out).subspan(1));
+  EXPECT_EQ(sender.SealSequence(), 3);
+  EXPECT_NE(sealed[0], sealed[1]);
+  EXPECT_NE(sealed[1], sealed[2]);
+  std::vector<uint8_t> expected(record.size());
+  std::vector<uint8_t> expected_mac(16);
+  Aes128GcmCrypto(std::string(key_128), sender.Nonce(2))
+      .Encrypt(record, "", absl::MakeSpan(expected),
+               absl::MakeSpan(expected_mac));
+  expected.insert(expected.end(), expected_mac.begin(), expected_mac.end());
+  EXPECT_EQ(sealed[2], expected);
+}
+
 }  // namespace yasl::crypto
@@ -15,9 +15,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <vector>
 
+#include "absl/types/span.h"
+
 #include "yasl/base/byte_container_view.h"
+#include "yasl/base/exception.h"
 
 namespace yasl::crypto {
 
@@ -75,6 +79,14 @@ class HashInterface {
   // Note that the internal state of the object remains unchanged, and the
   // object can continue to accumulate additional data via Update() operations.
   virtual std::vector<uint8_t> CumulativeHash() const = 0;
+
+  // Same as above, but writes the hash to |digest|, which holds DigestSize()
+  // bytes. Implementations override it to not allocate.
+  virtual void CumulativeHash(absl::Span<uint8_t> digest) const {
+    const std::vector<uint8_t> hash = CumulativeHash();
+    YASL_ENFORCE_EQ(digest.size(), hash.size());
+    std::copy(hash.begin(), hash.end(), digest.begin());
+  }
 };
 
 }  // namespace yasl::crypto
@@ -14,21 +14,41 @@
 
 #include "yasl/crypto/hash_util.h"
 
-#include <iostream>
+#include <limits>
+#include <memory>
 #include <vector>
 
 #include "c/blake3.h"
 
 #include "yasl/base/exception.h"
+#include "yasl/crypto/multi_buffer_hash.h"
 
 namespace yasl::crypto {
 
+namespace {
+
+// A hash context per thread, made again when the crypto backend changes.
+template <HashAlgorithm kHashAlgo>
+SslHash& ThreadLocalHash() {
+  thread_local std::unique_ptr<SslHash> hash;
+  thread_local CryptoBackend backend;
+  if (!hash || backend != GetCryptoBackend()) {
+    backend = GetCryptoBackend();
+    hash = std::make_unique<SslHash>(kHashAlgo);
+  }
+  return hash->Reset();
+}
+
+}  // namespace
+
 std::vector<uint8_t> Sha256(ByteContainerView data) {
-  return SslHash(HashAlgorithm::SHA256).Update(data).CumulativeHash();
+  const auto digest = Sha256Fixed(data);
+  return {digest.begin(), digest.end()};
 }
 
 std::vector<uint8_t> Sm3(ByteContainerView data) {
-  return SslHash(HashAlgorithm::SM3).Update(data).CumulativeHash();
+  const auto digest = Sm3Fixed(data);
+  return {digest.begin(), digest.end()};
 }
 
 std::vector<uint8_t> Blake2(ByteContainerView data) {
@@ -36,26 +56,112 @@ std::vector<uint8_t> Blake2(ByteContainerView data) {
 }
 
 std::vector<uint8_t> Blake3(ByteContainerView data) {
-  blake3_hasher hasher;
+  const auto digest = Blake3Fixed(data);
+  return {digest.begin(), digest.end()};
+}
 
+uint128_t Blake3_128(ByteContainerView data) {
+  blake3_hasher hasher;
   blake3_hasher_init(&hasher);
   blake3_hasher_update(&hasher, data.data(), data.size());
 
-  std::vector<uint8_t> digest(BLAKE3_OUT_LEN);
+  uint128_t ret;
+  blake3_hasher_finalize(&hasher, reinterpret_cast<uint8_t*>(&ret),
+                         sizeof(ret));
+  return ret;
+}
 
-  blake3_hasher_finalize(&hasher, digest.data(), BLAKE3_OUT_LEN);
+Sha256Digest Sha256Fixed(ByteContainerView data) {
+  Sha256Digest digest;
+  Sha256(data, absl::MakeSpan(digest));
+  return digest;
+}
 
+Sm3Digest Sm3Fixed(ByteContainerView data) {
+  Sm3Digest digest;
+  Sm3(data, absl::MakeSpan(digest));
   return digest;
 }
 
-uint128_t Blake3_128(ByteContainerView data) {
-  std::vector<uint8_t> hash_bytes = Blake3(data);
-  uint128_t ret;
+Blake3Digest Blake3Fixed(ByteContainerView data) {
+  Blake3Digest digest;
+  Blake3(data, absl::MakeSpan(digest));
+  return digest;
+}
 
-  YASL_ENFORCE(hash_bytes.size() >= sizeof(ret));
+void Sha256(ByteContainerView data, absl::Span<uint8_t> digest) {
+  ThreadLocalHash<HashAlgorithm::SHA256>().Update(data).CumulativeHash(digest);
+}
 
-  std::memcpy(reinterpret_cast<uint8_t*>(&ret), hash_bytes.data(), sizeof(ret));
-  return ret;
+void Sm3(ByteContainerView data, absl::Span<uint8_t> digest) {
+  ThreadLocalHash<HashAlgorithm::SM3>().Update(data).CumulativeHash(digest);
+}
+
+void Blake3(ByteContainerView data, absl::Span<uint8_t> digest) {
+  YASL_ENFORCE_EQ(digest.size(), static_cast<size_t>(BLAKE3_OUT_LEN));
+  blake3_hasher hasher;
+  blake3_hasher_init(&hasher);
+  blake3_hasher_update(&hasher, data.data(), data.size());
+  blake3_hasher_finalize(&hasher, digest.data(), digest.size());
+}
+
+void HashBatch(HashAlgorithm hash_algo, absl::Span<const ByteContainerView> in,
+               absl::Span<uint8_t> out_digests) {
+  if (hash_algo == HashAlgorithm::BLAKE3) {
+    YASL_ENFORCE(out_digests.size() == in.size() * BLAKE3_OUT_LEN,
+                 "out_digests size {} != {} digests", out_digests.size(),
+                 in.size());
+    blake3_hasher hasher;
+    for (size_t i = 0; i < in.size(); ++i) {
+      blake3_hasher_init(&hasher);
+      blake3_hasher_update(&hasher, in[i].data(), in[i].size());
+      blake3_hasher_finalize(&hasher, out_digests.data() + i * BLAKE3_OUT_LEN,
+                             BLAKE3_OUT_LEN);
+    }
+    return;
+  }
+
+  SslHash hash(hash_algo);
+  const size_t digest_size = hash.DigestSize();
+  YASL_ENFORCE(out_digests.size() == in.size() * digest_size,
+               "out_digests size {} != {} digests", out_digests.size(),
+               in.size());
+  auto hash_one = [&](size_t i) {
+    hash.Reset().Update(in[i]).CumulativeHash(
+        out_digests.subspan(i * digest_size, digest_size));
+  };
+
+  const bool is_sha256 = hash_algo == HashAlgorithm::SHA256;
+  if ((!is_sha256 && hash_algo != HashAlgorithm::SM3) ||
+      !CpuSupportsMultiBufferHash()) {
+    for (size_t i = 0; i < in.size(); ++i) {
+      hash_one(i);
+    }
+    return;
+  }
+
+  // runs of short messages go to the lanes, long SHA-256 messages to openssl.
+  const size_t max_length = is_sha256 ? Sha256MultiBufferMaxLength()
+                                      : std::numeric_limits<size_t>::max();
+  size_t begin = 0;
+  while (begin < in.size()) {
+    size_t end = begin;
+    while (end < in.size() && in[end].size() < max_length) {
+      ++end;
+    }
+    const auto run_in = in.subspan(begin, end - begin);
+    const auto run_out = out_digests.subspan(begin * digest_size,
+                                             run_in.size() * digest_size);
+    if (is_sha256) {
+      MultiBufferSha256(run_in, run_out);
+    } else {
+      MultiBufferSm3(run_in, run_out);
+    }
+    if (end < in.size()) {
+      hash_one(end++);
+    }
+    begin = end;
+  }
 }
 
 }  // namespace yasl::crypto
@@ -14,11 +14,19 @@
 
 #pragma once
 
+#include <array>
+
+#include "absl/types/span.h"
+
 #include "yasl/base/int128.h"
 #include "yasl/crypto/ssl_hash.h"
 
 namespace yasl::crypto {
 
+using Sha256Digest = std::array<uint8_t, 32>;
+using Sm3Digest = std::array<uint8_t, 32>;
+using Blake3Digest = std::array<uint8_t, 32>;
+
 std::vector<uint8_t> Sha256(ByteContainerView data);
 
 std::vector<uint8_t> Sm3(ByteContainerView data);
@@ -28,4 +36,22 @@ std::vector<uint8_t> Blake3(ByteContainerView data);
 
 uint128_t Blake3_128(ByteContainerView data);
 
+// The same hashes without allocating, for hashing in loops. SHA-256 and SM3
+// reuse a hash context of the calling thread.
+Sha256Digest Sha256Fixed(ByteContainerView data);
+Sm3Digest Sm3Fixed(ByteContainerView data);
+Blake3Digest Blake3Fixed(ByteContainerView data);
+
+// `digest` holds the 32 bytes of the digest.
+void Sha256(ByteContainerView data, absl::Span<uint8_t> digest);
+void Sm3(ByteContainerView data, absl::Span<uint8_t> digest);
+void Blake3(ByteContainerView data, absl::Span<uint8_t> digest);
+
+// Hashes each of `in` and writes the digests back to back to `out_digests`,
+// which holds in.size() * digest size bytes. SHA-256 and SM3 run 8 messages
+// at once on AVX2 cpus, which hashes short messages several times faster
+// than the functions above, and nothing is allocated per message.
+void HashBatch(HashAlgorithm hash_algo, absl::Span<const ByteContainerView> in,
+               absl::Span<uint8_t> out_digests);
+
 }  // namespace yasl::crypto
@@ -0,0 +1,87 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "yasl/crypto/hash_util.h"
+
+namespace {
+
+constexpr size_t kNumMessages = 1 << 14;
+
+// state.range(0) is the message length.
+std::vector<uint8_t> Buffer(const benchmark::State& state) {
+  return std::vector<uint8_t>(kNumMessages * state.range(0), 0x5a);
+}
+
+void SetBytesProcessed(benchmark::State& state) {
+  state.SetBytesProcessed(state.iterations() * kNumMessages * state.range(0));
+}
+
+void BM_Sha256(benchmark::State& state) {
+  const auto buffer = Buffer(state);
+  const size_t length = state.range(0);
+  for (auto _ : state) {
+    for (size_t i = 0; i < kNumMessages; ++i) {
+      benchmark::DoNotOptimize(yasl::crypto::Sha256(
+          yasl::ByteContainerView(buffer.data() + i * length, length)));
+    }
+  }
+  SetBytesProcessed(state);
+}
+
+void BM_Sm3(benchmark::State& state) {
+  const auto buffer = Buffer(state);
+  const size_t length = state.range(0);
+  for (auto _ : state) {
+    for (size_t i = 0; i < kNumMessages; ++i) {
+      benchmark::DoNotOptimize(yasl::crypto::Sm3(
+          yasl::ByteContainerView(buffer.data() + i * length, length)));
+    }
+  }
+  SetBytesProcessed(state);
+}
+
+void BM_HashBatch(benchmark::State& state,
+                  yasl::crypto::HashAlgorithm hash_algo) {
+  const auto buffer = Buffer(state);
+  const size_t length = state.range(0);
+  std::vector<yasl::ByteContainerView> in;
+  for (size_t i = 0; i < kNumMessages; ++i) {
+    in.emplace_back(buffer.data() + i * length, length);
+  }
+  std::vector<uint8_t> out(kNumMessages * 32);
+  for (auto _ : state) {
+    yasl::crypto::HashBatch(hash_algo, in, absl::MakeSpan(out));
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetBytesProcessed(state);
+}
+
+}  // namespace
+
+BENCHMARK(BM_Sha256)->Arg(16)->Arg(64)->Arg(1024);
+BENCHMARK(BM_Sm3)->Arg(16)->Arg(64)->Arg(1024);
+BENCHMARK_CAPTURE(BM_HashBatch, Sha256, yasl::crypto::HashAlgorithm::SHA256)
+    ->Arg(16)
+    ->Arg(64)
+    ->Arg(1024);
+BENCHMARK_CAPTURE(BM_HashBatch, Sm3, yasl::crypto::HashAlgorithm::SM3)
+    ->Arg(16)
+    ->Arg(64)
+    ->Arg(1024);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,136 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/hash_util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/crypto/multi_buffer_hash.h"
+
+namespace yasl::crypto {
+
+namespace {
+
+// the lengths around the one and two padding blocks, then random ones, more
+// than 8 messages so that the lanes get refilled.
+std::vector<std::vector<uint8_t>> Messages() {
+  std::mt19937 rng(42);
+  std::vector<size_t> lengths = {0,   1,   55,  56,  63,   64,  65,
+                                 119, 120, 128, 129, 1000, 4095, 4096,
+                                 5000};
+  for (size_t i = 0; i < 29; ++i) {
+    lengths.push_back(rng() % 300);
+  }
+  std::vector<std::vector<uint8_t>> messages;
+  for (size_t length : lengths) {
+    std::vector<uint8_t> message(length);
+    for (auto& b : message) {
+      b = static_cast<uint8_t>(rng());
+    }
+    messages.push_back(std::move(message));
+  }
+  return messages;
+}
+
+}  // namespace
+
+TEST(HashUtilTest, HashBatch) {
+  const auto messages = Messages();
+  const std::vector<ByteContainerView> in(messages.begin(), messages.end());
+  for (auto hash_algo : {HashAlgorithm::SHA256, HashAlgorithm::SM3,
+                         HashAlgorithm::BLAKE2B, HashAlgorithm::BLAKE3}) {
+    std::vector<uint8_t> expected;
+    for (const auto& message : messages) {
+      std::vector<uint8_t> digest;
+      if (hash_algo == HashAlgorithm::BLAKE3) {
+        digest = Blake3(message);
+      } else {
+        digest = SslHash(hash_algo).Update(message).CumulativeHash();
+      }
+      expected.insert(expected.end(), digest.begin(), digest.end());
+    }
+
+    std::vector<uint8_t> out(expected.size());
+    HashBatch(hash_algo, in, absl::MakeSpan(out));
+    EXPECT_EQ(out, expected) << static_cast<int>(hash_algo);
+
+    // a batch shorter than the lanes.
+    const size_t digest_size = expected.size() / messages.size();
+    HashBatch(hash_algo, absl::MakeConstSpan(in).subspan(3, 2),
+              absl::MakeSpan(out.data(), 2 * digest_size));
+    EXPECT_TRUE(std::equal(out.begin(), out.begin() + 2 * digest_size,
+                           expected.begin() + 3 * digest_size))
+        << static_cast<int>(hash_algo);
+
+    EXPECT_THROW(HashBatch(hash_algo, in, absl::MakeSpan(out).subspan(1)),
+                 yasl::Exception);
+  }
+  HashBatch(HashAlgorithm::SHA256, {}, {});
+}
+
+TEST(HashUtilTest, FixedDigests) {
+  const auto messages = Messages();
+  for (const auto& message : messages) {
+    const auto sha256 = Sha256Fixed(message);
+    EXPECT_EQ(std::vector<uint8_t>(sha256.begin(), sha256.end()),
+              SslHash(HashAlgorithm::SHA256).Update(message).CumulativeHash());
+    const auto sm3 = Sm3Fixed(message);
+    EXPECT_EQ(std::vector<uint8_t>(sm3.begin(), sm3.end()),
+              SslHash(HashAlgorithm::SM3).Update(message).CumulativeHash());
+    const auto blake3 = Blake3Fixed(message);
+    EXPECT_EQ(std::vector<uint8_t>(blake3.begin(), blake3.end()),
+              Blake3(message));
+
+    std::vector<uint8_t> digest(32);
+    Sha256(message, absl::MakeSpan(digest));
+    EXPECT_EQ(digest, Sha256(message));
+    Sm3(message, absl::MakeSpan(digest));
+    EXPECT_EQ(digest, Sm3(message));
+    Blake3(message, absl::MakeSpan(digest));
+    EXPECT_EQ(digest, Blake3(message));
+  }
+
+  uint128_t blake3_128;
+  std::memcpy(&blake3_128, Blake3Fixed(messages[1]).data(), sizeof(uint128_t));
+  EXPECT_EQ(Blake3_128(messages[1]), blake3_128);
+}
+
+TEST(HashUtilTest, MultiBufferHash) {
+  if (!CpuSupportsMultiBufferHash()) {
+    GTEST_SKIP() << "AVX2 is not supported";
+  }
+  const auto messages = Messages();
+  const std::vector<ByteContainerView> in(messages.begin(), messages.end());
+  std::vector<uint8_t> out(in.size() * kMultiBufferDigestSize);
+  auto digest = [&](size_t i) {
+    const auto begin = out.begin() + i * kMultiBufferDigestSize;
+    return std::vector<uint8_t>(begin, begin + kMultiBufferDigestSize);
+  };
+  MultiBufferSha256(in, absl::MakeSpan(out));
+  for (size_t i = 0; i < in.size(); ++i) {
+    EXPECT_EQ(digest(i), Sha256(in[i])) << "length " << in[i].size();
+  }
+  MultiBufferSm3(in, absl::MakeSpan(out));
+  for (size_t i = 0; i < in.size(); ++i) {
+    EXPECT_EQ(digest(i), Sm3(in[i])) << "length " << in[i].size();
+  }
+}
+
+}  // namespace yasl::crypto
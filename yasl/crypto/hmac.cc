@@ -18,7 +18,6 @@
 #include "openssl/evp.h"
 
 #include "yasl/base/exception.h"
-#include "yasl/utils/scope_guard.h"
 
 namespace yasl::crypto {
 
@@ -26,6 +25,11 @@ namespace {
 
 void Init_HMAC(HashAlgorithm hash_algo, ByteContainerView key,
                HMAC_CTX* context) {
+  // a null key keeps the current one, so an empty key must not be null.
+  static constexpr uint8_t kEmptyKey = 0;
+  if (key.empty()) {
+    key = ByteContainerView(&kEmptyKey, 0);
+  }
   int res = 0;
   switch (hash_algo) {
     case HashAlgorithm::SHA224:
@@ -64,45 +68,87 @@ void Init_HMAC(HashAlgorithm hash_algo, ByteContainerView key,
 Hmac::Hmac(HashAlgorithm hash_algo, ByteContainerView key)
     : hash_algo_(hash_algo),
       key_(key.begin(), key.end()),
-      context_(CheckNotNull(HMAC_CTX_new())) {
-  Reset();
+      context_(CheckNotNull(HMAC_CTX_new())),
+      snapshot_(CheckNotNull(HMAC_CTX_new())) {
+  Init_HMAC(hash_algo_, key_, context_);
+  if (CpuSupportsMultiBufferHash() && (hash_algo_ == HashAlgorithm::SHA256 ||
+                                       hash_algo_ == HashAlgorithm::SM3)) {
+    multi_buffer_ = std::make_shared<MultiBufferHmac>(hash_algo_, key_);
+  }
 }
 
-Hmac::~Hmac() { HMAC_CTX_free(context_); }
+Hmac::Hmac(const Hmac& other, HMAC_CTX* context)
+    : hash_algo_(other.hash_algo_),
+      key_(other.key_),
+      context_(context),
+      snapshot_(CheckNotNull(HMAC_CTX_new())),
+      multi_buffer_(other.multi_buffer_) {}
+
+Hmac::~Hmac() {
+  HMAC_CTX_free(context_);
+  HMAC_CTX_free(snapshot_);
+}
 
 HashAlgorithm Hmac::GetHashAlgorithm() const { return hash_algo_; }
 
+size_t Hmac::MacSize() const { return HMAC_size(context_); }
+
 Hmac& Hmac::Reset() {
-  YASL_ENFORCE_EQ(HMAC_CTX_reset(context_), 1);
-  Init_HMAC(hash_algo_, key_, context_);
+  // no key nor md restarts from the inner state of the key.
+  YASL_ENFORCE_EQ(HMAC_Init_ex(context_, nullptr, 0, nullptr, nullptr), 1);
   return *this;
 }
 
+std::unique_ptr<Hmac> Hmac::Clone() const {
+  HMAC_CTX* context = CheckNotNull(HMAC_CTX_new());
+  if (HMAC_CTX_copy(context, context_) != 1) {
+    HMAC_CTX_free(context);
+    YASL_THROW("HMAC_CTX_copy failed");
+  }
+  return std::unique_ptr<Hmac>(new Hmac(*this, context));
+}
+
+void Hmac::MacBatch(absl::Span<const ByteContainerView> in,
+                    absl::Span<uint8_t> out) const {
+  const size_t mac_size = MacSize();
+  YASL_ENFORCE_EQ(out.size(), in.size() * mac_size);
+  if (multi_buffer_) {
+    multi_buffer_->Mac(in, out);
+    return;
+  }
+  // snapshot_ carries the keyed states, its data so far is dropped.
+  YASL_ENFORCE_EQ(HMAC_CTX_copy(snapshot_, context_), 1);
+  for (size_t i = 0; i < in.size(); ++i) {
+    YASL_ENFORCE_EQ(HMAC_Init_ex(snapshot_, nullptr, 0, nullptr, nullptr), 1);
+    YASL_ENFORCE_EQ(HMAC_Update(snapshot_, in[i].data(), in[i].size()), 1);
+    unsigned int len;
+    YASL_ENFORCE_EQ(HMAC_Final(snapshot_, out.data() + i * mac_size, &len),
+                    1);
+    YASL_ENFORCE_EQ(len, mac_size);
+  }
+}
+
 Hmac& Hmac::Update(ByteContainerView data) {
   YASL_ENFORCE(HMAC_Update(context_, data.data(), data.size()) == 1, "HMAC_Update failed");
   return *this;
 }
 
 std::vector<uint8_t> Hmac::CumulativeMac() const {
+  std::vector<uint8_t> mac(MacSize());
+  CumulativeMac(absl::MakeSpan(mac));
+  return mac;
+}
+
+void Hmac::CumulativeMac(absl::Span<uint8_t> mac) const {
+  YASL_ENFORCE_GT(mac.size(), (size_t)0);
+  YASL_ENFORCE_EQ(mac.size(), MacSize());
   // Do not finalize the internally stored hash context. Instead, finalize a
   // copy of the current context so that the current context can be updated in
-  // future calls to Update.
-  HMAC_CTX* context_snapshot = HMAC_CTX_new();
-  YASL_ENFORCE(context_snapshot != nullptr);
-  ON_SCOPE_EXIT([&] { HMAC_CTX_free(context_snapshot); });
-  Init_HMAC(hash_algo_, key_, context_snapshot);
-  YASL_ENFORCE_EQ(HMAC_CTX_copy(context_snapshot, context_), 1);
-  size_t mac_size = HMAC_size(context_snapshot);
-  YASL_ENFORCE_GT(mac_size, (size_t)0);
-  std::vector<uint8_t> mac(mac_size);
+  // future calls to Update. The copy reuses the digest states of snapshot_.
+  YASL_ENFORCE_EQ(HMAC_CTX_copy(snapshot_, context_), 1);
   unsigned int len;
-  YASL_ENFORCE_EQ(HMAC_Final(context_snapshot, mac.data(), &len), 1);
-  // Correct the mac size if needed.
-  if (mac_size != len) {
-    mac.resize(len);
-  }
-
-  return mac;
+  YASL_ENFORCE_EQ(HMAC_Final(snapshot_, mac.data(), &len), 1);
+  YASL_ENFORCE_EQ(len, mac.size());
 }
 
 }  // namespace yasl::crypto
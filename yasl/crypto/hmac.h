@@ -15,12 +15,15 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "openssl/hmac.h"
 
 #include "yasl/base/byte_container_view.h"
 #include "yasl/crypto/hash_interface.h"
+#include "yasl/crypto/multi_buffer_hash.h"
 
 namespace yasl::crypto {
 
@@ -31,6 +34,9 @@ namespace yasl::crypto {
 // method to get a mac of all data added to the object since its creation or
 // last call to its Init() method.
 //
+// The hash states after the inner and outer padded keys are computed once by
+// the constructor, Reset(), Clone() and MacBatch() start from them.
+//
 // This is not thread-safe.
 class Hmac {
  public:
@@ -59,10 +65,32 @@ class Hmac {
   // object can continue to accumulate additional data via Update() operations.
   std::vector<uint8_t> CumulativeMac() const;
 
+  // Same as above, but writes the mac to |mac|, which holds MacSize() bytes,
+  // without allocating.
+  void CumulativeMac(absl::Span<uint8_t> mac) const;
+
+  size_t MacSize() const;
+
+  // A copy of this object, keyed state and data so far, without keying again.
+  std::unique_ptr<Hmac> Clone() const;
+
+  // Writes the mac of each of |in| back to back to |out|, which holds
+  // in.size() * MacSize() bytes. The data added by Update() is not part of
+  // them and is kept. HMAC-SHA256 and HMAC-SM3 run 8 messages at once on
+  // AVX2 cpus, which is several times faster for short messages.
+  void MacBatch(absl::Span<const ByteContainerView> in,
+                absl::Span<uint8_t> out) const;
+
  private:
+  Hmac(const Hmac &other, HMAC_CTX *context);
+
   const HashAlgorithm hash_algo_;
   const std::vector<uint8_t> key_;
   HMAC_CTX *context_;
+  // finalizes copies of context_, reused so that copying does not allocate.
+  HMAC_CTX *snapshot_;
+  // nullptr if the cpu or the hash algo has no multi-buffer kernel.
+  std::shared_ptr<const MultiBufferHmac> multi_buffer_;
 };
 
 }  // namespace yasl::crypto
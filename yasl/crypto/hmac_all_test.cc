@@ -125,4 +125,60 @@ TYPED_TEST(HmacTest, MultipleUpdates) {
             this->Data().result2);
 }
 
+TYPED_TEST(HmacTest, CumulativeMacToSpan) {
+  TypeParam hmac(this->Data().key);
+  std::vector<uint8_t> mac(hmac.MacSize());
+  hmac.Update(this->Data().vector1).CumulativeMac(absl::MakeSpan(mac));
+  EXPECT_EQ(absl::BytesToHexString(
+                absl::string_view((const char*)mac.data(), mac.size())),
+            this->Data().result1);
+
+  hmac.Update(this->Data().suffix).CumulativeMac(absl::MakeSpan(mac));
+  EXPECT_EQ(absl::BytesToHexString(
+                absl::string_view((const char*)mac.data(), mac.size())),
+            this->Data().result2);
+
+  EXPECT_THROW(hmac.CumulativeMac(absl::MakeSpan(mac).subspan(1)),
+               ::yasl::EnforceNotMet);
+}
+
+TYPED_TEST(HmacTest, Clone) {
+  TypeParam hmac(this->Data().key);
+  hmac.Update(this->Data().vector1);
+  auto clone = hmac.Clone();
+  EXPECT_EQ(clone->CumulativeMac(), hmac.CumulativeMac());
+  EXPECT_EQ(clone->Update(this->Data().suffix).CumulativeMac(),
+            hmac.Update(this->Data().suffix).CumulativeMac());
+  EXPECT_EQ(clone->Reset().Update(this->Data().vector2).CumulativeMac(),
+            hmac.Reset().Update(this->Data().vector2).CumulativeMac());
+}
+
+// Same macs as one object per message, for keys of up to and over a block.
+TYPED_TEST(HmacTest, MacBatch) {
+  std::vector<std::string> messages;
+  for (size_t len : {0, 1, 31, 55, 56, 64, 100, 1000}) {
+    messages.push_back(std::string(len, static_cast<char>('a' + len % 26)));
+  }
+  const std::vector<ByteContainerView> in(messages.begin(), messages.end());
+  for (size_t key_len : {0, 16, 64, 65, 200}) {
+    const std::string key(key_len, 'k');
+    TypeParam hmac(key);
+    // kept by MacBatch.
+    hmac.Update(this->Data().vector1);
+    std::vector<uint8_t> out(in.size() * hmac.MacSize());
+    hmac.MacBatch(in, absl::MakeSpan(out));
+    for (size_t i = 0; i < in.size(); ++i) {
+      const auto mac = TypeParam(key).Update(in[i]).CumulativeMac();
+      EXPECT_EQ(std::vector<uint8_t>(out.begin() + i * mac.size(),
+                                     out.begin() + (i + 1) * mac.size()),
+                mac)
+          << "key " << key_len << " message " << in[i].size();
+    }
+    EXPECT_EQ(hmac.CumulativeMac(),
+              TypeParam(key).Update(this->Data().vector1).CumulativeMac());
+    EXPECT_THROW(hmac.MacBatch(in, absl::MakeSpan(out).subspan(1)),
+                 ::yasl::EnforceNotMet);
+  }
+}
+
 }  // namespace yasl::crypto
@@ -0,0 +1,356 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/ipp_crypto.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "yasl/base/exception.h"
+
+#ifdef YASL_ENABLE_IPP_CRYPTO
+#include "yasl/base/cpu_dispatch.h"
+#include "ippcp.h"
+#endif
+
+namespace yasl::crypto {
+
+namespace {
+
+#ifdef YASL_ENABLE_IPP_CRYPTO
+constexpr size_t kBlockSize = 16;
+constexpr size_t kMacSize = 16;
+constexpr size_t kDigestSize = 32;
+// ipp-crypto takes int lengths, longer data is fed piece by piece.
+constexpr size_t kMaxUpdateSize = 1U << 30;
+
+void CheckStatus(IppStatus status, const char* what) {
+  YASL_ENFORCE(status == ippStsNoErr, "{} failed: {}", what,
+               ippcpGetStatusString(status));
+}
+
+bool InitIppCrypto() {
+  if (!CpuSupports(kIsaAes)) {
+    return false;
+  }
+  // picks the code for the cpu.
+  CheckStatus(ippcpInit(), "ippcpInit");
+  return true;
+}
+
+const bool kIppCryptoAvailable = InitIppCrypto();
+#else
+constexpr bool kIppCryptoAvailable = false;
+#endif
+
+// IPP-Crypto is opt-in even when built in, see SetCryptoBackend.
+std::atomic<CryptoBackend> backend{CryptoBackend::kOpenssl};
+
+}  // namespace
+
+bool IppCryptoAvailable() { return kIppCryptoAvailable; }
+
+CryptoBackend GetCryptoBackend() { return backend.load(); }
+
+void SetCryptoBackend(CryptoBackend new_backend) {
+  YASL_ENFORCE(new_backend == CryptoBackend::kOpenssl || kIppCryptoAvailable,
+               "IPP-Crypto is not available, build with --config=ipp");
+  backend.store(new_backend);
+}
+
+#ifdef YASL_ENABLE_IPP_CRYPTO
+
+IppBlockCipher::IppBlockCipher(Algorithm algorithm, Mode mode,
+                               ByteContainerView key)
+    : algorithm_(algorithm), mode_(mode) {
+  YASL_ENFORCE_EQ(key.size(), kBlockSize);
+  int size;
+  if (algorithm_ == Algorithm::kAes128) {
+    CheckStatus(ippsAESGetSize(&size), "ippsAESGetSize");
+    spec_.resize(size);
+    CheckStatus(ippsAESInit(key.data(), key.size(),
+                            reinterpret_cast<IppsAESSpec*>(spec_.data()),
+                            size),
+                "ippsAESInit");
+  } else {
+    CheckStatus(ippsSMS4GetSize(&size), "ippsSMS4GetSize");
+    spec_.resize(size);
+    CheckStatus(ippsSMS4Init(key.data(), key.size(),
+                             reinterpret_cast<IppsSMS4Spec*>(spec_.data()),
+                             size),
+                "ippsSMS4Init");
+  }
+}
+
+void IppBlockCipher::Encrypt(ByteContainerView iv,
+                             absl::Span<const uint8_t> in,
+                             absl::Span<uint8_t> out) const {
+  Crypt(true, iv, in, out);
+}
+
+void IppBlockCipher::Decrypt(ByteContainerView iv,
+                             absl::Span<const uint8_t> in,
+                             absl::Span<uint8_t> out) const {
+  Crypt(false, iv, in, out);
+}
+
+void IppBlockCipher::Crypt(bool encrypt, ByteContainerView iv,
+                           absl::Span<const uint8_t> in,
+                           absl::Span<uint8_t> out) const {
+  YASL_ENFORCE_EQ(in.size(), out.size());
+  if (mode_ != Mode::kCtr) {
+    YASL_ENFORCE(in.size() % kBlockSize == 0,
+                 "Requires size can be divided by block_size={}.", kBlockSize);
+  }
+  // the iv of CBC and the counter of CTR, carried across the pieces.
+  uint8_t chain[kBlockSize] = {};
+  if (mode_ != Mode::kEcb) {
+    YASL_ENFORCE_EQ(iv.size(), kBlockSize);
+    std::memcpy(chain, iv.data(), kBlockSize);
+  }
+  const auto* aes = reinterpret_cast<const IppsAESSpec*>(spec_.data());
+  const auto* sm4 = reinterpret_cast<const IppsSMS4Spec*>(spec_.data());
+  const bool is_aes = algorithm_ == Algorithm::kAes128;
+  constexpr int kCtrBits = kBlockSize * 8;
+
+  for (size_t pos = 0; pos < in.size(); pos += kMaxUpdateSize) {
+    const int len = std::min(kMaxUpdateSize, in.size() - pos);
+    const uint8_t* src = in.data() + pos;
+    uint8_t* dst = out.data() + pos;
+    // the last ciphertext block, before an in place decryption overwrites it.
+    uint8_t next_chain[kBlockSize];
+    if (mode_ == Mode::kCbc && !encrypt) {
+      std::memcpy(next_chain, src + len - kBlockSize, kBlockSize);
+    }
+
+    IppStatus status;
+    switch (mode_) {
+      case Mode::kEcb:
+        if (is_aes) {
+          status = encrypt ? ippsAESEncryptECB(src, dst, len, aes)
+                           : ippsAESDecryptECB(src, dst, len, aes);
+        } else {
+          status = encrypt ? ippsSMS4EncryptECB(src, dst, len, sm4)
+                           : ippsSMS4DecryptECB(src, dst, len, sm4);
+        }
+        break;
+      case Mode::kCbc:
+        if (is_aes) {
+          status = encrypt ? ippsAESEncryptCBC(src, dst, len, aes, chain)
+                           : ippsAESDecryptCBC(src, dst, len, aes, chain);
+        } else {
+          status = encrypt ? ippsSMS4EncryptCBC(src, dst, len, sm4, chain)
+                           : ippsSMS4DecryptCBC(src, dst, len, sm4, chain);
+        }
+        break;
+      case Mode::kCtr:
+        // the counter is advanced in place.
+        if (is_aes) {
+          status =
+              encrypt
+                  ? ippsAESEncryptCTR(src, dst, len, aes, chain, kCtrBits)
+                  : ippsAESDecryptCTR(src, dst, len, aes, chain, kCtrBits);
+        } else {
+          status =
+              encrypt
+                  ? ippsSMS4EncryptCTR(src, dst, len, sm4, chain, kCtrBits)
+                  : ippsSMS4DecryptCTR(src, dst, len, sm4, chain, kCtrBits);
+        }
+        break;
+      default:
+        YASL_THROW("unknown mode: {}", static_cast<int>(mode_));
+    }
+    CheckStatus(status, encrypt ? "encrypt" : "decrypt");
+
+    if (mode_ == Mode::kCbc) {
+      std::memcpy(chain, encrypt ? dst + len - kBlockSize : next_chain,
+                  kBlockSize);
+    }
+  }
+}
+
+IppGcm::IppGcm(ByteContainerView key) {
+  YASL_ENFORCE(key.size() == 16 || key.size() == 32,
+               "unsupported key size {}", key.size());
+  int size;
+  CheckStatus(ippsAES_GCMGetSize(&size), "ippsAES_GCMGetSize");
+  state_.resize(size);
+  CheckStatus(
+      ippsAES_GCMInit(key.data(), key.size(),
+                      reinterpret_cast<IppsAES_GCMState*>(state_.data()),
+                      size),
+      "ippsAES_GCMInit");
+}
+
+void IppGcm::Encrypt(ByteContainerView iv, ByteContainerView plaintext,
+                     ByteContainerView aad, absl::Span<uint8_t> ciphertext,
+                     absl::Span<uint8_t> mac) {
+  YASL_ENFORCE_EQ(ciphertext.size(), plaintext.size());
+  YASL_ENFORCE_EQ(mac.size(), kMacSize);
+  auto* state = reinterpret_cast<IppsAES_GCMState*>(state_.data());
+  CheckStatus(ippsAES_GCMStart(iv.data(), iv.size(), aad.data(), aad.size(),
+                               state),
+              "ippsAES_GCMStart");
+  for (size_t pos = 0; pos < plaintext.size(); pos += kMaxUpdateSize) {
+    const int len = std::min(kMaxUpdateSize, plaintext.size() - pos);
+    CheckStatus(ippsAES_GCMEncrypt(plaintext.data() + pos,
+                                   ciphertext.data() + pos, len, state),
+                "ippsAES_GCMEncrypt");
+  }
+  CheckStatus(ippsAES_GCMGetTag(mac.data(), mac.size(), state),
+              "ippsAES_GCMGetTag");
+}
+
+void IppGcm::Decrypt(ByteContainerView iv, ByteContainerView ciphertext,
+                     ByteContainerView aad, ByteContainerView mac,
+                     absl::Span<uint8_t> plaintext) {
+  YASL_ENFORCE_EQ(ciphertext.size(), plaintext.size());
+  YASL_ENFORCE_EQ(mac.size(), kMacSize);
+  auto* state = reinterpret_cast<IppsAES_GCMState*>(state_.data());
+  CheckStatus(ippsAES_GCMStart(iv.data(), iv.size(), aad.data(), aad.size(),
+                               state),
+              "ippsAES_GCMStart");
+  for (size_t pos = 0; pos < ciphertext.size(); pos += kMaxUpdateSize) {
+    const int len = std::min(kMaxUpdateSize, ciphertext.size() - pos);
+    CheckStatus(ippsAES_GCMDecrypt(ciphertext.data() + pos,
+                                   plaintext.data() + pos, len, state),
+                "ippsAES_GCMDecrypt");
+  }
+  uint8_t expected[kMacSize];
+  CheckStatus(ippsAES_GCMGetTag(expected, kMacSize, state),
+              "ippsAES_GCMGetTag");
+  // in constant time.
+  uint8_t diff = 0;
+  for (size_t i = 0; i < kMacSize; ++i) {
+    diff |= expected[i] ^ mac[i];
+  }
+  if (diff != 0) {
+    std::fill(plaintext.begin(), plaintext.end(), 0);
+    YASL_THROW("Failed to verfiy mac.");
+  }
+}
+
+namespace {
+
+const IppsHashMethod* GetHashMethod(HashAlgorithm hash_algo) {
+  switch (hash_algo) {
+    case HashAlgorithm::SHA256:
+      // SHA-NI where available.
+      return ippsHashMethod_SHA256_TT();
+    case HashAlgorithm::SM3:
+      return ippsHashMethod_SM3();
+    default:
+      YASL_THROW("Unsupported hash algo: {}", static_cast<int>(hash_algo));
+  }
+}
+
+}  // namespace
+
+IppHash::IppHash(HashAlgorithm hash_algo) : hash_algo_(hash_algo) {
+  int size;
+  CheckStatus(ippsHashGetSize_rmf(&size), "ippsHashGetSize_rmf");
+  state_.resize(size);
+  Reset();
+}
+
+void IppHash::Reset() {
+  CheckStatus(
+      ippsHashInit_rmf(reinterpret_cast<IppsHashState_rmf*>(state_.data()),
+                       GetHashMethod(hash_algo_)),
+      "ippsHashInit_rmf");
+}
+
+void IppHash::Update(ByteContainerView data) {
+  auto* state = reinterpret_cast<IppsHashState_rmf*>(state_.data());
+  for (size_t pos = 0; pos < data.size(); pos += kMaxUpdateSize) {
+    const int len = std::min(kMaxUpdateSize, data.size() - pos);
+    CheckStatus(ippsHashUpdate_rmf(data.data() + pos, len, state),
+                "ippsHashUpdate_rmf");
+  }
+}
+
+std::vector<uint8_t> IppHash::CumulativeHash() const {
+  std::vector<uint8_t> digest(kDigestSize);
+  CumulativeHash(absl::MakeSpan(digest));
+  return digest;
+}
+
+void IppHash::CumulativeHash(absl::Span<uint8_t> digest) const {
+  YASL_ENFORCE_EQ(digest.size(), kDigestSize);
+  CheckStatus(ippsHashGetTag_rmf(
+                  digest.data(), digest.size(),
+                  reinterpret_cast<const IppsHashState_rmf*>(state_.data())),
+              "ippsHashGetTag_rmf");
+}
+
+#else
+
+IppBlockCipher::IppBlockCipher(Algorithm algorithm, Mode mode,
+                               ByteContainerView)
+    : algorithm_(algorithm), mode_(mode) {
+  YASL_THROW("IPP-Crypto is not built in, build with --config=ipp");
+}
+
+void IppBlockCipher::Encrypt(ByteContainerView, absl::Span<const uint8_t>,
+                             absl::Span<uint8_t>) const {
+  YASL_THROW("IPP-Crypto is not built in, build with --config=ipp");
+}
+
+void IppBlockCipher::Decrypt(ByteContainerView, absl::Span<const uint8_t>,
+                             absl::Span<uint8_t>) const {
+  YASL_THROW("IPP-Crypto is not built in, build with --config=ipp");
+}
+
+IppGcm::IppGcm(ByteContainerView) {
+  YASL_THROW("IPP-Crypto is not built in, build with --config=ipp");
+}
+
+void IppGcm::Encrypt(ByteContainerView, ByteContainerView, ByteContainerView,
+                     absl::Span<uint8_t>, absl::Span<uint8_t>) {
+  YASL_THROW("IPP-Crypto is not built in, build with --config=ipp");
+}
+
+void IppGcm::Decrypt(ByteContainerView, ByteContainerView, ByteContainerView,
+                     ByteContainerView, absl::Span<uint8_t>) {
+  YASL_THROW("IPP-Crypto is not built in, build with --config=ipp");
+}
+
+IppHash::IppHash(HashAlgorithm hash_algo) : hash_algo_(hash_algo) {
+  YASL_THROW("IPP-Crypto is not built in, build with --config=ipp");
+}
+
+void IppHash::Reset() {
+  YASL_THROW("IPP-Crypto is not built in, build with --config=ipp");
+}
+
+void IppHash::Update(ByteContainerView) {
+  YASL_THROW("IPP-Crypto is not built in, build with --config=ipp");
+}
+
+std::vector<uint8_t> IppHash::CumulativeHash() const {
+  YASL_THROW("IPP-Crypto is not built in, build with --config=ipp");
+}
+
+void IppHash::CumulativeHash(absl::Span<uint8_t>) const {
+  YASL_THROW("IPP-Crypto is not built in, build with --config=ipp");
+}
+
+#endif
+
+bool IppHash::Supports(HashAlgorithm hash_algo) {
+  return hash_algo == HashAlgorithm::SHA256 || hash_algo == HashAlgorithm::SM3;
+}
+
+}  // namespace yasl::crypto
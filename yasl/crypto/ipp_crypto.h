@@ -0,0 +1,109 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/byte_container_view.h"
+#include "yasl/crypto/hash_interface.h"
+
+namespace yasl::crypto {
+
+// Backend of SymmetricCrypto, GcmCrypto, GcmCipherContext and SslHash for
+// SHA-256 and SM3.
+//
+// OpenSSL is the default backend. IPP-Crypto is built in by `--config=ipp` on
+// x86_64, and is then available if the cpu has AES-NI, ipp-crypto dispatching
+// to the best code for the cpu by itself. It is used only once selected by
+// SetCryptoBackend. Objects pick the backend when constructed, so switching
+// it leaves the existing ones as they are.
+enum class CryptoBackend : int { kOpenssl, kIppCrypto };
+
+// Whether IPP-Crypto is built in and runs on this cpu.
+bool IppCryptoAvailable();
+
+CryptoBackend GetCryptoBackend();
+// Throws if `backend` is not available.
+void SetCryptoBackend(CryptoBackend backend);
+
+// The wrappers below throw when IPP-Crypto is not built in. Lengths are
+// those of openssl, and so are the outputs, bit for bit.
+
+// AES-128 and SM4 in ECB, CBC and CTR modes, CTR counting the iv as a big
+// endian integer.
+class IppBlockCipher {
+ public:
+  enum class Algorithm : int { kAes128, kSm4 };
+  enum class Mode : int { kEcb, kCbc, kCtr };
+
+  IppBlockCipher(Algorithm algorithm, Mode mode, ByteContainerView key);
+
+  // `iv` is ignored by ECB. ECB and CBC take whole blocks.
+  void Encrypt(ByteContainerView iv, absl::Span<const uint8_t> in,
+               absl::Span<uint8_t> out) const;
+  void Decrypt(ByteContainerView iv, absl::Span<const uint8_t> in,
+               absl::Span<uint8_t> out) const;
+
+ private:
+  void Crypt(bool encrypt, ByteContainerView iv, absl::Span<const uint8_t> in,
+             absl::Span<uint8_t> out) const;
+
+  const Algorithm algorithm_;
+  const Mode mode_;
+  // IppsAESSpec or IppsSMS4Spec.
+  std::vector<uint8_t> spec_;
+};
+
+// AES-GCM with a 128 or 256 bits key and a 16 bytes mac.
+class IppGcm {
+ public:
+  explicit IppGcm(ByteContainerView key);
+
+  void Encrypt(ByteContainerView iv, ByteContainerView plaintext,
+               ByteContainerView aad, absl::Span<uint8_t> ciphertext,
+               absl::Span<uint8_t> mac);
+  // raise if the mac does not match.
+  void Decrypt(ByteContainerView iv, ByteContainerView ciphertext,
+               ByteContainerView aad, ByteContainerView mac,
+               absl::Span<uint8_t> plaintext);
+
+ private:
+  // IppsAES_GCMState.
+  std::vector<uint8_t> state_;
+};
+
+// SHA-256 and SM3.
+class IppHash {
+ public:
+  static bool Supports(HashAlgorithm hash_algo);
+
+  explicit IppHash(HashAlgorithm hash_algo);
+
+  void Reset();
+  void Update(ByteContainerView data);
+  // the digest of the data so far, the state is kept.
+  std::vector<uint8_t> CumulativeHash() const;
+  void CumulativeHash(absl::Span<uint8_t> digest) const;
+
+ private:
+  const HashAlgorithm hash_algo_;
+  // IppsHashState_rmf.
+  std::vector<uint8_t> state_;
+};
+
+}  // namespace yasl::crypto
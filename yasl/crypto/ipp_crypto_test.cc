@@ -0,0 +1,166 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/ipp_crypto.h"
+
+#include <numeric>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/crypto/gcm_crypto.h"
+#include "yasl/crypto/ssl_hash.h"
+#include "yasl/crypto/symmetric_crypto.h"
+
+namespace yasl::crypto {
+
+namespace {
+
+// restores the backend on exit.
+class BackendGuard {
+ public:
+  BackendGuard() : backend_(GetCryptoBackend()) {}
+  ~BackendGuard() { SetCryptoBackend(backend_); }
+
+ private:
+  const CryptoBackend backend_;
+};
+
+std::vector<uint8_t> Bytes(size_t n) {
+  std::vector<uint8_t> bytes(n);
+  std::iota(bytes.begin(), bytes.end(), 7);
+  return bytes;
+}
+
+}  // namespace
+
+TEST(IppCryptoTest, Backend) {
+  // opt-in even when built in.
+  EXPECT_EQ(GetCryptoBackend(), CryptoBackend::kOpenssl);
+  BackendGuard guard;
+  SetCryptoBackend(CryptoBackend::kOpenssl);
+  EXPECT_EQ(GetCryptoBackend(), CryptoBackend::kOpenssl);
+  if (IppCryptoAvailable()) {
+    SetCryptoBackend(CryptoBackend::kIppCrypto);
+    EXPECT_EQ(GetCryptoBackend(), CryptoBackend::kIppCrypto);
+  } else {
+    EXPECT_THROW(SetCryptoBackend(CryptoBackend::kIppCrypto), yasl::Exception);
+    EXPECT_EQ(GetCryptoBackend(), CryptoBackend::kOpenssl);
+  }
+}
+
+TEST(IppCryptoTest, SymmetricCryptoSameAsOpenssl) {
+  if (!IppCryptoAvailable()) {
+    GTEST_SKIP() << "IPP-Crypto is not available";
+  }
+  BackendGuard guard;
+  const uint128_t key = MakeUint128(0x0123456789abcdef, 42);
+  // the big endian counter carries across bytes.
+  const uint128_t iv = MakeUint128(0x1234, 0xfeffffffffffffffULL);
+  for (auto type : {SymmetricCrypto::CryptoType::AES128_ECB,
+                    SymmetricCrypto::CryptoType::AES128_CBC,
+                    SymmetricCrypto::CryptoType::AES128_CTR,
+                    SymmetricCrypto::CryptoType::SM4_ECB,
+                    SymmetricCrypto::CryptoType::SM4_CBC,
+                    SymmetricCrypto::CryptoType::SM4_CTR}) {
+    const bool is_ctr = type == SymmetricCrypto::CryptoType::AES128_CTR ||
+                        type == SymmetricCrypto::CryptoType::SM4_CTR;
+    const auto plaintext = Bytes(is_ctr ? 1000 : 1024);
+
+    SetCryptoBackend(CryptoBackend::kOpenssl);
+    SymmetricCrypto openssl_crypto(type, key, iv);
+    std::vector<uint8_t> expected(plaintext.size());
+    openssl_crypto.Encrypt(plaintext, absl::MakeSpan(expected));
+
+    SetCryptoBackend(CryptoBackend::kIppCrypto);
+    SymmetricCrypto ipp_crypto(type, key, iv);
+    std::vector<uint8_t> ciphertext(plaintext.size());
+    ipp_crypto.Encrypt(plaintext, absl::MakeSpan(ciphertext));
+    EXPECT_EQ(ciphertext, expected) << static_cast<int>(type);
+
+    // each call restarts from the iv.
+    std::vector<uint8_t> decrypted(plaintext.size());
+    ipp_crypto.Decrypt(ciphertext, absl::MakeSpan(decrypted));
+    EXPECT_EQ(decrypted, plaintext) << static_cast<int>(type);
+  }
+}
+
+TEST(IppCryptoTest, GcmSameAsOpenssl) {
+  if (!IppCryptoAvailable()) {
+    GTEST_SKIP() << "IPP-Crypto is not available";
+  }
+  BackendGuard guard;
+  const auto plaintext = Bytes(1000);
+  const auto aad = Bytes(33);
+  const auto iv = Bytes(12);
+  for (auto [schema, key_size] :
+       {std::make_pair(GcmCryptoSchema::AES128_GCM, 16),
+        std::make_pair(GcmCryptoSchema::AES256_GCM, 32)}) {
+    const auto key = Bytes(key_size);
+    std::vector<uint8_t> expected(plaintext.size());
+    std::vector<uint8_t> expected_mac(16);
+    SetCryptoBackend(CryptoBackend::kOpenssl);
+    GcmCrypto(schema, key, iv)
+        .Encrypt(plaintext, aad, absl::MakeSpan(expected),
+                 absl::MakeSpan(expected_mac));
+
+    SetCryptoBackend(CryptoBackend::kIppCrypto);
+    std::vector<uint8_t> ciphertext(plaintext.size());
+    std::vector<uint8_t> mac(16);
+    GcmCrypto(schema, key, iv)
+        .Encrypt(plaintext, aad, absl::MakeSpan(ciphertext),
+                 absl::MakeSpan(mac));
+    EXPECT_EQ(ciphertext, expected);
+    EXPECT_EQ(mac, expected_mac);
+
+    GcmCipherContext ctx(schema, key);
+    ctx.Encrypt(iv, plaintext, aad, absl::MakeSpan(ciphertext),
+                absl::MakeSpan(mac));
+    EXPECT_EQ(ciphertext, expected);
+    EXPECT_EQ(mac, expected_mac);
+    std::vector<uint8_t> decrypted(plaintext.size());
+    ctx.Decrypt(iv, ciphertext, aad, mac, absl::MakeSpan(decrypted));
+    EXPECT_EQ(decrypted, plaintext);
+
+    mac[0] ^= 1;
+    EXPECT_THROW(
+        ctx.Decrypt(iv, ciphertext, aad, mac, absl::MakeSpan(decrypted)),
+        yasl::Exception);
+  }
+}
+
+TEST(IppCryptoTest, HashSameAsOpenssl) {
+  if (!IppCryptoAvailable()) {
+    GTEST_SKIP() << "IPP-Crypto is not available";
+  }
+  BackendGuard guard;
+  const auto data = Bytes(1000);
+  for (auto algo : {HashAlgorithm::SHA256, HashAlgorithm::SM3}) {
+    SetCryptoBackend(CryptoBackend::kOpenssl);
+    SslHash openssl_hash(algo);
+    SetCryptoBackend(CryptoBackend::kIppCrypto);
+    SslHash ipp_hash(algo);
+    for (size_t n : {0, 1, 63, 64, 500}) {
+      openssl_hash.Update(absl::MakeConstSpan(data.data(), n));
+      ipp_hash.Update(absl::MakeConstSpan(data.data(), n));
+      EXPECT_EQ(ipp_hash.CumulativeHash(), openssl_hash.CumulativeHash());
+    }
+    ipp_hash.Reset();
+    openssl_hash.Reset();
+    EXPECT_EQ(ipp_hash.CumulativeHash(), openssl_hash.CumulativeHash());
+  }
+}
+
+}  // namespace yasl::crypto
@@ -0,0 +1,472 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/multi_buffer_hash.h"
+
+#include <array>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "yasl/base/exception.h"
+
+#ifdef __x86_64
+#include <immintrin.h>
+
+#include "yasl/base/cpu_dispatch.h"
+#endif
+
+namespace yasl::crypto {
+
+namespace {
+
+#ifdef __x86_64
+constexpr size_t kLanes = 8;
+constexpr size_t kBlockSize = 64;
+
+const bool kCpuSupportsAvx2 = CpuSupports(kIsaAvx2);
+
+constexpr uint32_t kSha256Iv[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                                   0xa54ff53a, 0x510e527f, 0x9b05688c,
+                                   0x1f83d9ab, 0x5be0cd19};
+
+constexpr uint32_t kSha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+constexpr uint32_t kSm3Iv[8] = {0x7380166f, 0x4914b2b9, 0x172442d7,
+                                0xda8a0600, 0xa96f30bc, 0x163138aa,
+                                0xe38dee4d, 0xb0fb0e4e};
+
+constexpr uint32_t Rotl(uint32_t x, int n) {
+  return n == 0 ? x : (x << n) | (x >> (32 - n));
+}
+
+// rol(T_j, j mod 32) of the SM3 rounds.
+constexpr std::array<uint32_t, 64> MakeSm3T() {
+  std::array<uint32_t, 64> t{};
+  for (int j = 0; j < 64; ++j) {
+    t[j] = Rotl(j < 16 ? 0x79cc4519 : 0x7a879d8a, j % 32);
+  }
+  return t;
+}
+
+constexpr std::array<uint32_t, 64> kSm3T = MakeSm3T();
+
+// the padding of an empty idle lane, never written out.
+constexpr uint8_t kIdleBlock[kBlockSize] = {};
+
+template <int N>
+__attribute__((target("avx2"))) inline __m256i Rotl(__m256i x) {
+  return _mm256_or_si256(_mm256_slli_epi32(x, N), _mm256_srli_epi32(x, 32 - N));
+}
+
+__attribute__((target("avx2"))) inline __m256i Add(__m256i a, __m256i b) {
+  return _mm256_add_epi32(a, b);
+}
+
+__attribute__((target("avx2"))) inline __m256i Xor(__m256i a, __m256i b) {
+  return _mm256_xor_si256(a, b);
+}
+
+__attribute__((target("avx2"))) inline __m256i Splat(uint32_t x) {
+  return _mm256_set1_epi32(static_cast<int>(x));
+}
+
+// w[t] holds word t of the block of each lane, as big endian integers.
+__attribute__((target("avx2"))) void LoadMessage(
+    const uint8_t* const blocks[kLanes], __m256i w[16]) {
+  const __m256i bswap = _mm256_setr_epi8(
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,  //
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+#pragma GCC unroll 2
+  for (size_t half = 0; half < 2; ++half) {
+    __m256i r[kLanes];
+#pragma GCC unroll 8
+    for (size_t i = 0; i < kLanes; ++i) {
+      r[i] = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(blocks[i] + 32 * half));
+    }
+    // 8x8 transpose of the 32-bit words.
+    __m256i t[kLanes];
+#pragma GCC unroll 4
+    for (size_t i = 0; i < kLanes; i += 2) {
+      t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+      t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+    }
+#pragma GCC unroll 2
+    for (size_t i = 0; i < kLanes; i += 4) {
+      r[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+      r[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+      r[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+      r[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+#pragma GCC unroll 4
+    for (size_t i = 0; i < 4; ++i) {
+      w[8 * half + i] = _mm256_shuffle_epi8(
+          _mm256_permute2x128_si256(r[i], r[i + 4], 0x20), bswap);
+      w[8 * half + i + 4] = _mm256_shuffle_epi8(
+          _mm256_permute2x128_si256(r[i], r[i + 4], 0x31), bswap);
+    }
+  }
+}
+
+__attribute__((target("avx2"))) void Sha256Compress(
+    uint32_t state[8][kLanes], const uint8_t* const blocks[kLanes]) {
+  __m256i w[16];
+  LoadMessage(blocks, w);
+  __m256i s[8];
+#pragma GCC unroll 8
+  for (size_t i = 0; i < 8; ++i) {
+    s[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[i]));
+  }
+  __m256i a = s[0], b = s[1], c = s[2], d = s[3];
+  __m256i e = s[4], f = s[5], g = s[6], h = s[7];
+  for (size_t j = 0; j < 64; j += 16) {
+#pragma GCC unroll 16
+    for (size_t i = 0; i < 16; ++i) {
+      if (j > 0) {
+        const __m256i w2 = w[(i + 14) % 16];
+        const __m256i w15 = w[(i + 1) % 16];
+        const __m256i s0 = Xor(Xor(Rotl<25>(w15), Rotl<14>(w15)),
+                               _mm256_srli_epi32(w15, 3));
+        const __m256i s1 = Xor(Xor(Rotl<15>(w2), Rotl<13>(w2)),
+                               _mm256_srli_epi32(w2, 10));
+        w[i] = Add(Add(w[i], s0), Add(w[(i + 9) % 16], s1));
+      }
+      const __m256i sigma1 = Xor(Xor(Rotl<26>(e), Rotl<21>(e)), Rotl<7>(e));
+      const __m256i ch = Xor(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+      const __m256i t1 =
+          Add(Add(Add(h, sigma1), Add(ch, Splat(kSha256K[j + i]))), w[i]);
+      const __m256i sigma0 = Xor(Xor(Rotl<30>(a), Rotl<19>(a)), Rotl<10>(a));
+      const __m256i maj =
+          Xor(_mm256_and_si256(a, b), _mm256_and_si256(c, Xor(a, b)));
+      h = g;
+      g = f;
+      f = e;
+      e = Add(d, t1);
+      d = c;
+      c = b;
+      b = a;
+      a = Add(t1, Add(sigma0, maj));
+    }
+  }
+  s[0] = Add(s[0], a);
+  s[1] = Add(s[1], b);
+  s[2] = Add(s[2], c);
+  s[3] = Add(s[3], d);
+  s[4] = Add(s[4], e);
+  s[5] = Add(s[5], f);
+  s[6] = Add(s[6], g);
+  s[7] = Add(s[7], h);
+#pragma GCC unroll 8
+  for (size_t i = 0; i < 8; ++i) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(state[i]), s[i]);
+  }
+}
+
+__attribute__((target("avx2"))) inline __m256i Sm3P0(__m256i x) {
+  return Xor(Xor(x, Rotl<9>(x)), Rotl<17>(x));
+}
+
+__attribute__((target("avx2"))) inline __m256i Sm3P1(__m256i x) {
+  return Xor(Xor(x, Rotl<15>(x)), Rotl<23>(x));
+}
+
+__attribute__((target("avx2"))) void Sm3Compress(
+    uint32_t state[8][kLanes], const uint8_t* const blocks[kLanes]) {
+  // round j takes w'[j] = w[j] ^ w[j + 4], so the ring of the message
+  // schedule runs 4 words ahead of the rounds.
+  __m256i w[16];
+  LoadMessage(blocks, w);
+  __m256i s[8];
+#pragma GCC unroll 8
+  for (size_t i = 0; i < 8; ++i) {
+    s[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(state[i]));
+  }
+  __m256i a = s[0], b = s[1], c = s[2], d = s[3];
+  __m256i e = s[4], f = s[5], g = s[6], h = s[7];
+  for (size_t j = 0; j < 64; j += 16) {
+#pragma GCC unroll 16
+    for (size_t i = 0; i < 16; ++i) {
+      // w[j + i + 4] replaces w[j + i - 12].
+      if (j + i + 4 >= 16) {
+        const size_t k = (i + 4) % 16;
+        const __m256i x = Xor(Xor(w[k], w[(k + 7) % 16]),
+                              Rotl<15>(w[(k + 13) % 16]));
+        w[k] = Xor(Xor(Sm3P1(x), Rotl<7>(w[(k + 3) % 16])), w[(k + 10) % 16]);
+      }
+      const __m256i a12 = Rotl<12>(a);
+      const __m256i ss1 = Rotl<7>(Add(Add(a12, e), Splat(kSm3T[j + i])));
+      const __m256i ss2 = Xor(ss1, a12);
+      __m256i ff;
+      __m256i gg;
+      if (j == 0) {
+        ff = Xor(Xor(a, b), c);
+        gg = Xor(Xor(e, f), g);
+      } else {
+        ff = _mm256_or_si256(_mm256_and_si256(a, b),
+                             _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        gg = Xor(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+      }
+      const __m256i tt1 =
+          Add(Add(ff, d), Add(ss2, Xor(w[i], w[(i + 4) % 16])));
+      const __m256i tt2 = Add(Add(gg, h), Add(ss1, w[i]));
+      d = c;
+      c = Rotl<9>(b);
+      b = a;
+      a = tt1;
+      h = g;
+      g = Rotl<19>(f);
+      f = e;
+      e = Sm3P0(tt2);
+    }
+  }
+  s[0] = Xor(s[0], a);
+  s[1] = Xor(s[1], b);
+  s[2] = Xor(s[2], c);
+  s[3] = Xor(s[3], d);
+  s[4] = Xor(s[4], e);
+  s[5] = Xor(s[5], f);
+  s[6] = Xor(s[6], g);
+  s[7] = Xor(s[7], h);
+#pragma GCC unroll 8
+  for (size_t i = 0; i < 8; ++i) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(state[i]), s[i]);
+  }
+}
+
+// The message of a lane, its whole blocks are read in place and the rest
+// with the padding is copied to `tail`.
+struct Lane {
+  size_t index;
+  const uint8_t* data;
+  size_t num_data_blocks;
+  size_t num_blocks;
+  size_t next_block;
+  uint8_t tail[2 * kBlockSize];
+
+  // `prefix_len` bytes were hashed before the message.
+  void Start(size_t message_index, ByteContainerView message,
+             uint64_t prefix_len) {
+    index = message_index;
+    data = message.data();
+    num_data_blocks = message.size() / kBlockSize;
+    next_block = 0;
+    const size_t rest = message.size() % kBlockSize;
+    // 0x80 and the 64 bits length have to fit.
+    const size_t num_tail_blocks = rest + 9 <= kBlockSize ? 1 : 2;
+    num_blocks = num_data_blocks + num_tail_blocks;
+    std::memset(tail, 0, sizeof(tail));
+    if (rest > 0) {
+      std::memcpy(tail, data + num_data_blocks * kBlockSize, rest);
+    }
+    tail[rest] = 0x80;
+    const uint64_t bits = (prefix_len + message.size()) * 8;
+    uint8_t* length = tail + num_tail_blocks * kBlockSize - 8;
+    for (size_t i = 0; i < 8; ++i) {
+      length[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+    }
+  }
+
+  const uint8_t* Block() const {
+    return next_block < num_data_blocks
+               ? data + next_block * kBlockSize
+               : tail + (next_block - num_data_blocks) * kBlockSize;
+  }
+};
+
+using CompressFn = void (*)(uint32_t[8][kLanes], const uint8_t* const[]);
+
+// `iv` is the state after `prefix_len` bytes, a multiple of the block size.
+void MultiBufferHash(const uint32_t iv[8], uint64_t prefix_len,
+                     CompressFn compress,
+                     absl::Span<const ByteContainerView> in,
+                     absl::Span<uint8_t> out) {
+  YASL_ENFORCE(kCpuSupportsAvx2, "multi-buffer hash needs AVX2");
+  YASL_ENFORCE(out.size() == in.size() * kMultiBufferDigestSize,
+               "out size {} != {} digests", out.size(), in.size());
+
+  std::array<Lane, kLanes> lanes;
+  std::array<bool, kLanes> busy{};
+  alignas(32) uint32_t state[8][kLanes];
+  size_t num_started = 0;
+  size_t num_busy = 0;
+  auto start_next = [&](size_t lane) {
+    busy[lane] = num_started < in.size();
+    if (busy[lane]) {
+      lanes[lane].Start(num_started, in[num_started], prefix_len);
+      for (size_t i = 0; i < 8; ++i) {
+        state[i][lane] = iv[i];
+      }
+      ++num_started;
+      ++num_busy;
+    }
+  };
+  for (size_t lane = 0; lane < kLanes; ++lane) {
+    start_next(lane);
+  }
+
+  const uint8_t* blocks[kLanes];
+  while (num_busy > 0) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      blocks[lane] = busy[lane] ? lanes[lane].Block() : kIdleBlock;
+    }
+    compress(state, blocks);
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      if (!busy[lane] || ++lanes[lane].next_block < lanes[lane].num_blocks) {
+        continue;
+      }
+      uint8_t* digest = out.data() + lanes[lane].index * kMultiBufferDigestSize;
+      for (size_t i = 0; i < 8; ++i) {
+        const uint32_t word = state[i][lane];
+        digest[4 * i] = static_cast<uint8_t>(word >> 24);
+        digest[4 * i + 1] = static_cast<uint8_t>(word >> 16);
+        digest[4 * i + 2] = static_cast<uint8_t>(word >> 8);
+        digest[4 * i + 3] = static_cast<uint8_t>(word);
+      }
+      --num_busy;
+      start_next(lane);
+    }
+  }
+}
+
+void CheckHmacAlgorithm(HashAlgorithm hash_algo) {
+  YASL_ENFORCE(kCpuSupportsAvx2, "multi-buffer hash needs AVX2");
+  YASL_ENFORCE(
+      hash_algo == HashAlgorithm::SHA256 || hash_algo == HashAlgorithm::SM3,
+      "unsupported multi-buffer hmac algo: {}", static_cast<int>(hash_algo));
+}
+
+const uint32_t* GetIv(HashAlgorithm hash_algo) {
+  return hash_algo == HashAlgorithm::SHA256 ? kSha256Iv : kSm3Iv;
+}
+
+CompressFn GetCompress(HashAlgorithm hash_algo) {
+  return hash_algo == HashAlgorithm::SHA256 ? Sha256Compress : Sm3Compress;
+}
+#endif
+
+}  // namespace
+
+#ifdef __x86_64
+bool CpuSupportsMultiBufferHash() { return kCpuSupportsAvx2; }
+
+size_t Sha256MultiBufferMaxLength() {
+  // where the 8 lanes fall behind the sha256rnds2 of openssl.
+  return CpuSupports(kIsaSha) ? 4096 : std::numeric_limits<size_t>::max();
+}
+
+void MultiBufferSha256(absl::Span<const ByteContainerView> in,
+                       absl::Span<uint8_t> out) {
+  MultiBufferHash(kSha256Iv, 0, Sha256Compress, in, out);
+}
+
+void MultiBufferSm3(absl::Span<const ByteContainerView> in,
+                    absl::Span<uint8_t> out) {
+  MultiBufferHash(kSm3Iv, 0, Sm3Compress, in, out);
+}
+
+MultiBufferHmac::MultiBufferHmac(HashAlgorithm hash_algo,
+                                 ByteContainerView key)
+    : hash_algo_(hash_algo) {
+  CheckHmacAlgorithm(hash_algo_);
+  const uint32_t* iv = GetIv(hash_algo_);
+  const CompressFn compress = GetCompress(hash_algo_);
+
+  // keys longer than a block are hashed first.
+  uint8_t padded_key[kBlockSize] = {};
+  if (key.size() > kBlockSize) {
+    MultiBufferHash(iv, 0, compress, {&key, 1},
+                    absl::MakeSpan(padded_key, kMultiBufferDigestSize));
+  } else if (!key.empty()) {
+    std::memcpy(padded_key, key.data(), key.size());
+  }
+  uint8_t inner_block[kBlockSize];
+  uint8_t outer_block[kBlockSize];
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    inner_block[i] = padded_key[i] ^ 0x36;
+    outer_block[i] = padded_key[i] ^ 0x5c;
+  }
+
+  // both states in one call, on lanes 0 and 1.
+  alignas(32) uint32_t state[8][kLanes];
+  for (size_t i = 0; i < 8; ++i) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      state[i][lane] = iv[i];
+    }
+  }
+  const uint8_t* blocks[kLanes];
+  for (size_t lane = 0; lane < kLanes; ++lane) {
+    blocks[lane] = kIdleBlock;
+  }
+  blocks[0] = inner_block;
+  blocks[1] = outer_block;
+  compress(state, blocks);
+  for (size_t i = 0; i < 8; ++i) {
+    inner_state_[i] = state[i][0];
+    outer_state_[i] = state[i][1];
+  }
+}
+
+void MultiBufferHmac::Mac(absl::Span<const ByteContainerView> in,
+                          absl::Span<uint8_t> out) const {
+  const CompressFn compress = GetCompress(hash_algo_);
+  MultiBufferHash(inner_state_.data(), kBlockSize, compress, in, out);
+  // the inner digests are hashed in place, each is copied to the tail of its
+  // lane before the lane writes to it.
+  std::vector<ByteContainerView> inner_digests(in.size());
+  for (size_t i = 0; i < in.size(); ++i) {
+    inner_digests[i] = ByteContainerView(
+        out.data() + i * kMultiBufferDigestSize, kMultiBufferDigestSize);
+  }
+  MultiBufferHash(outer_state_.data(), kBlockSize, compress, inner_digests,
+                  out);
+}
+#else
+bool CpuSupportsMultiBufferHash() { return false; }
+
+size_t Sha256MultiBufferMaxLength() { return 0; }
+
+void MultiBufferSha256(absl::Span<const ByteContainerView>,
+                       absl::Span<uint8_t>) {
+  YASL_THROW("multi-buffer hash needs AVX2");
+}
+
+void MultiBufferSm3(absl::Span<const ByteContainerView>, absl::Span<uint8_t>) {
+  YASL_THROW("multi-buffer hash needs AVX2");
+}
+
+MultiBufferHmac::MultiBufferHmac(HashAlgorithm hash_algo, ByteContainerView)
+    : hash_algo_(hash_algo) {
+  YASL_THROW("multi-buffer hash needs AVX2");
+}
+
+void MultiBufferHmac::Mac(absl::Span<const ByteContainerView>,
+                          absl::Span<uint8_t>) const {
+  YASL_THROW("multi-buffer hash needs AVX2");
+}
+#endif
+
+}  // namespace yasl::crypto
@@ -0,0 +1,66 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/byte_container_view.h"
+#include "yasl/crypto/hash_interface.h"
+
+namespace yasl::crypto {
+
+// Multi-buffer SHA-256 and SM3, the messages are hashed 8 at a time, one per
+// 32-bit lane of the AVX2 registers. A lane moves on to the next message as
+// soon as its message is done, so messages of different lengths keep the
+// lanes busy. The throughput on short messages is several times that of
+// hashing them one by one, where the per message overhead dominates.
+
+constexpr size_t kMultiBufferDigestSize = 32;
+
+// Whether the cpu runs the kernels below, false on other archs.
+bool CpuSupportsMultiBufferHash();
+
+// Messages from this length on are hashed faster one at a time by the SHA
+// extensions of the cpu, SIZE_MAX if it has none.
+size_t Sha256MultiBufferMaxLength();
+
+// Writes the digest of in[i] to out[32 * i, 32 * i + 32).
+void MultiBufferSha256(absl::Span<const ByteContainerView> in,
+                       absl::Span<uint8_t> out);
+void MultiBufferSm3(absl::Span<const ByteContainerView> in,
+                    absl::Span<uint8_t> out);
+
+// HMAC-SHA256 and HMAC-SM3 on the kernels above. The states after the inner
+// and outer padded keys are computed once, so a short message costs two
+// compressions shared by 8 lanes.
+class MultiBufferHmac {
+ public:
+  MultiBufferHmac(HashAlgorithm hash_algo, ByteContainerView key);
+
+  // Writes the mac of in[i] to out[32 * i, 32 * i + 32).
+  void Mac(absl::Span<const ByteContainerView> in,
+           absl::Span<uint8_t> out) const;
+
+ private:
+  const HashAlgorithm hash_algo_;
+  std::array<uint32_t, 8> inner_state_;
+  std::array<uint32_t, 8> outer_state_;
+};
+
+}  // namespace yasl::crypto
@@ -14,16 +14,24 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <memory>
 #include <numeric>
+#include <type_traits>
+#include <vector>
 
+#include "absl/types/span.h"
+
+#include "yasl/base/exception.h"
 #include "yasl/base/int128.h"
 #include "yasl/crypto/drbg/drbg.h"
 #include "yasl/crypto/drbg/entropy_source.h"
 #include "yasl/crypto/drbg/nist_aes_drbg.h"
 #include "yasl/crypto/drbg/sm4_drbg.h"
 #include "yasl/crypto/symmetric_crypto.h"
+#include "yasl/utils/parallel.h"
 
 namespace yasl {
 
@@ -38,24 +46,196 @@ enum class PRG_MODE {
 };
 
 namespace internal {
-template <typename T, size_t BATCH_SIZE>
+// The budget of PseudoRandomGenerator::operator(), `size()` elements over
+// `bytes()` of random bytes.
+template <typename T>
 struct cipher_data {
-  std::array<T, BATCH_SIZE> cipher_budget_{};
-  T& operator[](size_t idx) { return cipher_budget_[idx]; }
+  std::vector<T> cipher_budget_;
+  size_t size_ = 0;
+  size_t size() const { return size_; }
+  void resize(size_t n) {
+    cipher_budget_.resize(n);
+    size_ = n;
+  }
+  absl::Span<uint8_t> bytes() {
+    return absl::MakeSpan(reinterpret_cast<uint8_t*>(cipher_budget_.data()),
+                          cipher_budget_.size() * sizeof(T));
+  }
   const T& operator[](size_t idx) const { return cipher_budget_[idx]; }
 };
 
-// TODO: `bool` memory usage is not ideal. Figure out a better way.
-template <size_t BATCH_SIZE>
-struct cipher_data<bool, BATCH_SIZE> {
-  std::array<std::uint8_t, BATCH_SIZE> cipher_budget_{};
-  bool operator[](const size_t& idx) { return !!(cipher_budget_[idx] & 0x01); }
-  bool operator[](const size_t& idx) const {
-    return !!(cipher_budget_[idx] & 0x01);
+// `bool` is packed, each random bit is an element.
+template <>
+struct cipher_data<bool> {
+  std::vector<uint64_t> words_;
+  size_t size_ = 0;
+  size_t size() const { return size_; }
+  void resize(size_t n) {
+    size_ = n;
+    words_.resize((n + 63) / 64);
+  }
+  absl::Span<uint8_t> bytes() {
+    return absl::MakeSpan(reinterpret_cast<uint8_t*>(words_.data()),
+                          words_.size() * sizeof(uint64_t));
+  }
+  bool operator[](size_t idx) const {
+    return (words_[idx / 64] >> (idx % 64)) & 1;
   }
 };
+
+// The elements of operator() not handed out yet. The budget starts at
+// BATCH_SIZE elements and doubles on each refill up to kMaxBudgetBytes, so a
+// few calls cost little and sustained use amortizes the cipher over a few
+// KB.
+template <typename T, size_t BATCH_SIZE>
+class Budget {
+ public:
+  // `refill(bytes)` fills the grown budget when it is used up.
+  template <typename Refill>
+  T Next(Refill&& refill) {
+    if (num_consumed_ == data_.size()) {
+      const size_t size = data_.size();
+      data_.resize(size == 0 ? BATCH_SIZE
+                             : std::max(size, std::min(2 * size, kMaxSize)));
+      refill(data_.bytes());
+      num_consumed_ = 0;
+    }
+    return data_[num_consumed_++];
+  }
+
+ private:
+  static constexpr size_t kMaxBudgetBytes = 4096;
+  static constexpr size_t kMaxSize = std::is_same_v<T, bool>
+                                         ? kMaxBudgetBytes * 8
+                                         : kMaxBudgetBytes / sizeof(T);
+
+  cipher_data<T> data_;
+  size_t num_consumed_ = 0;
+};
+
+// Below this a counter mode Fill runs on the calling thread.
+constexpr size_t kParallelFillBytes = 1 << 20;
+// Bytes per task of a parallel Fill.
+constexpr size_t kParallelFillGrain = 1 << 18;
+
+// Fills `out` with the blocks of counters from `counter` by `fill(counter,
+// out)`, or, from kParallelFillBytes on, across parallel_for by
+// `task_fill(counter, out)`, which keys a cipher of its own. Block i is the
+// encrypted counter + i either way. Returns the next counter.
+template <typename Fill, typename TaskFill>
+uint128_t CtrFill(uint128_t counter, absl::Span<uint8_t> out, Fill&& fill,
+                  TaskFill&& task_fill) {
+  constexpr size_t kBlockSize = SymmetricCrypto::BlockSize();
+  if (out.size() < kParallelFillBytes || get_num_threads() == 1) {
+    return fill(counter, out);
+  }
+  const int64_t nblock = divup(out.size(), kBlockSize);
+  parallel_for(0, nblock, kParallelFillGrain / kBlockSize,
+               [&](int64_t begin, int64_t end) {
+                 const size_t offset = begin * kBlockSize;
+                 const size_t len =
+                     std::min(end * kBlockSize, out.size()) - offset;
+                 task_fill(counter + begin, out.subspan(offset, len));
+               });
+  return counter + nblock;
+}
 }  // namespace internal
 
+// Keystream policies of Prg. A policy is keyed by the seed, and its
+// Fill(counter, out) writes the blocks from `counter` and returns the next
+// counter. Seekable policies are counter modes, the others ignore the
+// counter.
+
+// The keystream of CipherPrg, AES on the AES-NI/VAES kernel and SM4 on the
+// SM4 kernel where available.
+template <SymmetricCrypto::CryptoType kType>
+class CipherCtrPolicy {
+ public:
+  static constexpr bool kSeekable = true;
+
+  explicit CipherCtrPolicy(uint128_t seed)
+      : cipher_prg_(std::make_unique<CipherPrg>(kType, seed)) {}
+
+  uint128_t Fill(uint128_t counter, absl::Span<uint8_t> out) {
+    return cipher_prg_->Fill(counter, out);
+  }
+
+ private:
+  std::unique_ptr<CipherPrg> cipher_prg_;
+};
+
+using AesCtrPolicy = CipherCtrPolicy<SymmetricCrypto::CryptoType::AES128_ECB>;
+using Sm4CtrPolicy = CipherCtrPolicy<SymmetricCrypto::CryptoType::SM4_ECB>;
+
+// A drbg of a known type, whose FillRandomBytes is called non-virtually.
+template <typename Drbg>
+class DrbgPolicy {
+ public:
+  static constexpr bool kSeekable = false;
+
+  explicit DrbgPolicy(uint128_t seed) : drbg_(std::make_unique<Drbg>(seed)) {}
+
+  uint128_t Fill(uint128_t counter, absl::Span<uint8_t> out) {
+    drbg_->Drbg::FillRandomBytes(out);
+    return counter;
+  }
+
+ private:
+  std::unique_ptr<Drbg> drbg_;
+};
+
+// A prg on a keystream policy fixed at compile time, for inner loops. The
+// budget of operator() is refilled by a direct call of the policy, with no
+// switch on the mode and no virtual drbg, so the hot path inlines. The
+// outputs of a seed are those of PseudoRandomGenerator on the matching
+// PRG_MODE, which is the run time facade over the same keystreams.
+template <typename T, typename Policy, size_t BATCH_SIZE = 128>
+class Prg {
+ public:
+  static_assert(std::is_standard_layout_v<T>);
+  static_assert(BATCH_SIZE % sizeof(uint128_t) == 0);
+
+  explicit Prg(uint128_t seed = 0) : seed_(seed), policy_(seed) {}
+
+  uint128_t Seed() const { return seed_; }
+
+  uint128_t Counter() const { return counter_; }
+
+  T operator()() {
+    return budget_.Next([this](absl::Span<uint8_t> bytes) {
+      counter_ = policy_.Fill(counter_, bytes);
+    });
+  }
+
+  // As PseudoRandomGenerator::Fill.
+  template <typename Y,
+            std::enable_if_t<std::is_trivially_copyable_v<Y>, int> = 0>
+  void Fill(absl::Span<Y> out) {
+    const auto bytes = absl::MakeSpan(reinterpret_cast<uint8_t*>(out.data()),
+                                      out.size() * sizeof(Y));
+    if constexpr (Policy::kSeekable) {
+      counter_ = internal::CtrFill(
+          counter_, bytes,
+          [this](uint128_t counter, absl::Span<uint8_t> o) {
+            return policy_.Fill(counter, o);
+          },
+          [this](uint128_t counter, absl::Span<uint8_t> o) {
+            Policy(seed_).Fill(counter, o);
+          });
+    } else {
+      counter_ = policy_.Fill(counter_, bytes);
+    }
+  }
+
+ private:
+  const uint128_t seed_;
+  uint128_t counter_ = 0;
+  Policy policy_;
+  internal::Budget<T, BATCH_SIZE> budget_;
+};
+
+// The run time counterpart of Prg, the keystream is picked by a PRG_MODE.
+
 template <typename T, size_t BATCH_SIZE = 128,
           std::enable_if_t<std::is_standard_layout_v<T>, int> = 0>
 class PseudoRandomGenerator {
@@ -84,23 +264,22 @@ class PseudoRandomGenerator {
     seed_ = seed;
     // Reset counter. Make this behave same with STL PRG.
     counter_ = 0;
+    limit_ = 0;
   }
 
   void SetStatus(uint128_t seed, uint128_t counter) {
     seed_ = seed;
     counter_ = counter;
+    limit_ = 0;
   }
 
   T operator()() {
-    if (num_consumed_ == cipher_data_.cipher_budget_.size()) {
-      // Generate budgets.
-      GenerateBudgets();
-      // Reset consumed.
-      num_consumed_ = 0;
-    }
-    return cipher_data_[num_consumed_++];
+    return budget_.Next(
+        [this](absl::Span<uint8_t> bytes) { GenerateBudgets(bytes); });
   }
 
+  // Outputs of the ecb modes from kParallelFillBytes bytes on are split
+  // across parallel_for, with the same bytes as a serial fill.
   template <typename Y,
             std::enable_if_t<std::is_trivially_copyable_v<Y>, int> = 0>
   void Fill(absl::Span<Y> out) {
@@ -112,50 +291,132 @@ class PseudoRandomGenerator {
         ctr_drbg_->FillRandom(absl::MakeSpan(out));
         break;
       case PRG_MODE::kAesEcb:
-        counter_ = FillPseudoRandom(SymmetricCrypto::CryptoType::AES128_ECB,
-                                    seed_, kInitVector, counter_, out);
-        break;
       case PRG_MODE::KSm4Ecb:
-        counter_ = FillPseudoRandom(SymmetricCrypto::CryptoType::SM4_ECB, seed_,
-                                    kInitVector, counter_, out);
+        counter_ = FillCipher(absl::MakeSpan(
+            reinterpret_cast<uint8_t*>(out.data()), out.size() * sizeof(Y)));
         break;
     }
   }
 
+  // Streams. Counters of the ecb modes are 128 bits, the high word is the
+  // stream and the low word the block in it, so a seed has 2^64 streams of
+  // 2^64 blocks, and a generator starts on stream 0. Jumps are O(1), and
+  // generators on disjoint blocks are independent without coordination, say
+  // the threads of an OT extension taking a substream each. The drbg modes
+  // have no counter: Skip generates and drops the bytes, Substream and Split
+  // throw.
+
+  uint64_t Stream() const { return static_cast<uint64_t>(counter_ >> 64); }
+
+  // Advances as a Fill of `n_bytes` would, ceil(n_bytes / 16) blocks. The
+  // budget of operator() is kept.
+  void Skip(size_t n_bytes) {
+    if (IsCounterMode()) {
+      counter_ += (n_bytes + sizeof(uint128_t) - 1) / sizeof(uint128_t);
+      return;
+    }
+    std::array<uint8_t, kSkipChunk> sink;
+    for (size_t i = 0; i < n_bytes; i += kSkipChunk) {
+      ctr_drbg_->FillRandom(
+          absl::MakeSpan(sink.data(), std::min(kSkipChunk, n_bytes - i)));
+    }
+  }
+
+  // A generator of this seed and mode at the start of stream `i`.
+  PseudoRandomGenerator Substream(uint64_t i) const {
+    YASL_ENFORCE(IsCounterMode(), "drbg streams are not seekable");
+    PseudoRandomGenerator prg(seed_, prg_mode_);
+    prg.counter_ = MakeUint128(i, 0);
+    return prg;
+  }
+
+  // Splits the blocks left to this generator, up to the end of its stream or
+  // of its share of a former Split, into k + 1 equal shares. This generator
+  // keeps the first one, and is not advanced, the `k` returned generators
+  // start on the others. No generator may run past its share, which is not
+  // checked, so splits of splits stay disjoint.
+  std::vector<PseudoRandomGenerator> Split(size_t k) {
+    YASL_ENFORCE(IsCounterMode(), "drbg streams are not seekable");
+    // wraps to 0 at the end of the last stream.
+    const uint128_t limit =
+        limit_ != 0 ? limit_ : MakeUint128(Stream() + 1, 0);
+    const uint128_t share = (limit - counter_) / (k + 1);
+    YASL_ENFORCE(share > 0, "no blocks left to split in {} shares", k + 1);
+    std::vector<PseudoRandomGenerator> prgs;
+    prgs.reserve(k);
+    for (size_t j = 1; j <= k; ++j) {
+      prgs.emplace_back(seed_, prg_mode_);
+      prgs.back().counter_ = counter_ + j * share;
+      prgs.back().limit_ = j < k ? counter_ + (j + 1) * share : limit;
+    }
+    limit_ = counter_ + share;
+    return prgs;
+  }
+
   inline static constexpr uint128_t kInitVector = 0;
 
+  static constexpr size_t kParallelFillBytes = internal::kParallelFillBytes;
+  static constexpr size_t kParallelFillGrain = internal::kParallelFillGrain;
+
  private:
-  void GenerateBudgets() {
+  void GenerateBudgets(absl::Span<uint8_t> bytes) {
     switch (prg_mode_) {
       case PRG_MODE::kNistAesCtrDrbg:
       case PRG_MODE::kGmSm4CtrDrbg:
-        ctr_drbg_->FillRandom(absl::MakeSpan(cipher_data_.cipher_budget_));
+        ctr_drbg_->FillRandom(bytes);
         break;
       case PRG_MODE::kAesEcb:
-        counter_ = FillPseudoRandom(
-            SymmetricCrypto::CryptoType::AES128_ECB, seed_, kInitVector,
-            counter_, absl::MakeSpan(cipher_data_.cipher_budget_));
-        break;
       case PRG_MODE::KSm4Ecb:
-        counter_ = FillPseudoRandom(
-            SymmetricCrypto::CryptoType::SM4_ECB, seed_, kInitVector, counter_,
-            absl::MakeSpan(cipher_data_.cipher_budget_));
+        counter_ = GetCipherPrg().Fill(counter_, bytes);
         break;
     }
   }
 
+  // Bytes dropped at a time by Skip of the drbg modes.
+  static constexpr size_t kSkipChunk = 1024;
+
+  bool IsCounterMode() const {
+    return prg_mode_ == PRG_MODE::kAesEcb || prg_mode_ == PRG_MODE::KSm4Ecb;
+  }
+
+  // Returns the next counter.
+  uint128_t FillCipher(absl::Span<uint8_t> out) {
+    auto& cipher_prg = GetCipherPrg();
+    return internal::CtrFill(
+        counter_, out,
+        [&](uint128_t counter, absl::Span<uint8_t> o) {
+          return cipher_prg.Fill(counter, o);
+        },
+        [&](uint128_t counter, absl::Span<uint8_t> o) {
+          CipherPrg(cipher_prg.GetType(), seed_, kInitVector).Fill(counter, o);
+        });
+  }
+
+  // The keyed cipher of the ecb modes, it is kept until the seed changes.
+  CipherPrg& GetCipherPrg() {
+    if (!cipher_prg_ || cipher_prg_->GetSeed() != seed_) {
+      const auto type = prg_mode_ == PRG_MODE::kAesEcb
+                            ? SymmetricCrypto::CryptoType::AES128_ECB
+                            : SymmetricCrypto::CryptoType::SM4_ECB;
+      cipher_prg_ = std::make_unique<CipherPrg>(type, seed_, kInitVector);
+    }
+    return *cipher_prg_;
+  }
+
   // Seed.
   uint128_t seed_;
   // Counter as encrypt messages.
   uint128_t counter_ = 0;
+  // End of the share of Split, 0 for the end of the stream.
+  uint128_t limit_ = 0;
   // Cipher budget.
-  internal::cipher_data<T, BATCH_SIZE> cipher_data_;
-  // How many ciphers are consumed.
-  size_t num_consumed_ = BATCH_SIZE;
+  internal::Budget<T, BATCH_SIZE> budget_;
 
   PRG_MODE prg_mode_;
   // for nist aes ctr drbg
   std::unique_ptr<yasl::crypto::IDrbg> ctr_drbg_;
+  // for aes/sm4 ecb
+  std::unique_ptr<CipherPrg> cipher_prg_;
 };
 
 }  // namespace yasl
@@ -16,6 +16,7 @@
 
 #include <memory>
 #include <random>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -59,6 +60,23 @@ TEST(PseudoRandomGenerator, BooleanWorks) {
   EXPECT_TRUE(std::abs(ratio - 0.5) <= 0.05) << ratio;
 }
 
+TEST(PseudoRandomGenerator, BudgetIsTheKeystream) {
+  // the budget grows by whole blocks, so the calls read the bytes of a Fill,
+  // bools bit by bit.
+  constexpr size_t kNum = 100000;
+  PseudoRandomGenerator<uint32_t> words(kKey1);
+  PseudoRandomGenerator<bool> bits(kKey1);
+  std::vector<uint32_t> expected(kNum);
+  PseudoRandomGenerator<uint32_t>(kKey1).Fill(absl::MakeSpan(expected));
+
+  for (size_t i = 0; i < kNum; ++i) {
+    ASSERT_EQ(words(), expected[i]) << i;
+  }
+  for (size_t i = 0; i < kNum * 32; ++i) {
+    ASSERT_EQ(bits(), ((expected[i / 32] >> (i % 32)) & 1) != 0) << i;
+  }
+}
+
 TEST(PseudoRandomGenerator, BuiltinScalarsWorks) {
   {
     // GIVEN
@@ -167,7 +185,118 @@ TEST(PseudoRandomGenerator, DeterministicWithDifferentSeedSm4) {
   }
 }
 
+TEST(PseudoRandomGenerator, ParallelFillSameAsSerial) {
+  set_num_threads(4);
+  using Prg = PseudoRandomGenerator<uint128_t>;
+  // whole tasks, then a partial block.
+  constexpr size_t kSize = 4 * Prg::kParallelFillBytes + 5;
+  constexpr size_t kChunk = Prg::kParallelFillBytes / 4;
+  for (auto mode : {PRG_MODE::kAesEcb, PRG_MODE::KSm4Ecb}) {
+    Prg parallel(kKey1, mode);
+    std::vector<uint8_t> output1(kSize);
+    parallel.Fill(absl::MakeSpan(output1));
+
+    // serial fills of whole blocks.
+    Prg serial(kKey1, mode);
+    std::vector<uint8_t> output2(kSize);
+    for (size_t i = 0; i < kSize; i += kChunk) {
+      serial.Fill(absl::MakeSpan(output2).subspan(i, kChunk));
+    }
+    EXPECT_EQ(output1, output2);
+    EXPECT_EQ(parallel.Counter(), serial.Counter());
+    EXPECT_EQ(parallel(), serial());
+  }
+}
+
+TEST(PseudoRandomGenerator, SkipSameAsFill) {
+  for (auto mode : {PRG_MODE::kAesEcb, PRG_MODE::KSm4Ecb}) {
+    for (size_t skipped : {0, 1, 16, 37}) {
+      PseudoRandomGenerator<uint8_t> prg1(kKey1, mode);
+      std::vector<uint8_t> output1(skipped);
+      prg1.Fill(absl::MakeSpan(output1));
+      prg1.Fill(absl::MakeSpan(output1 = std::vector<uint8_t>(100)));
+
+      PseudoRandomGenerator<uint8_t> prg2(kKey1, mode);
+      prg2.Skip(skipped);
+      std::vector<uint8_t> output2(100);
+      prg2.Fill(absl::MakeSpan(output2));
+      EXPECT_EQ(output1, output2);
+      EXPECT_EQ(prg1.Counter(), prg2.Counter());
+    }
+  }
+}
+
+TEST(PseudoRandomGenerator, SubstreamWorks) {
+  PseudoRandomGenerator<uint128_t> prg(kKey1);
+  EXPECT_EQ(prg.Stream(), 0);
+  auto sub0 = prg.Substream(0);
+  EXPECT_EQ(sub0(), prg());
+
+  auto sub3 = prg.Substream(3);
+  EXPECT_EQ(sub3.Stream(), 3);
+  PseudoRandomGenerator<uint128_t> seeked(kKey1);
+  seeked.SetStatus(kKey1, MakeUint128(3, 0));
+  EXPECT_EQ(sub3(), seeked());
+  EXPECT_NE(prg.Substream(4)(), prg.Substream(3)());
+}
+
+TEST(PseudoRandomGenerator, SplitWorks) {
+  PseudoRandomGenerator<uint128_t> prg(kKey1);
+  prg.Skip(100);
+  const uint128_t first = prg.Counter();
+  auto prgs = prg.Split(3);
+  ASSERT_EQ(prgs.size(), 3);
+  EXPECT_EQ(prg.Counter(), first);
+  const uint128_t share = (MakeUint128(1, 0) - first) / 4;
+  for (size_t j = 0; j < prgs.size(); ++j) {
+    EXPECT_EQ(prgs[j].Counter(), first + (j + 1) * share);
+    EXPECT_EQ(prgs[j].Stream(), 0);
+    EXPECT_EQ(prgs[j].Seed(), kKey1);
+  }
+  EXPECT_NE(prgs[0](), prgs[1]());
+
+  // splits of splits stay in their shares.
+  auto nested = prgs[1].Split(2);
+  EXPECT_GT(nested[0].Counter(), prgs[1].Counter());
+  EXPECT_LT(nested[1].Counter(), prgs[2].Counter());
+  auto first_nested = prg.Split(1);
+  EXPECT_LT(first_nested[0].Counter(), prgs[0].Counter());
+  auto last_nested = prgs[2].Split(1);
+  EXPECT_EQ(last_nested[0].Counter(),
+            prgs[2].Counter() + (MakeUint128(1, 0) - prgs[2].Counter()) / 2);
+}
+
 // nist ase_ctr drbg
+TEST(Prg, SameAsPseudoRandomGenerator) {
+  constexpr size_t kNum = 10000;
+  PseudoRandomGenerator<uint64_t> expected_aes(kKey1);
+  PseudoRandomGenerator<uint64_t> expected_sm4(kKey1, PRG_MODE::KSm4Ecb);
+  Prg<uint64_t, AesCtrPolicy> aes(kKey1);
+  Prg<uint64_t, Sm4CtrPolicy> sm4(kKey1);
+
+  for (size_t i = 0; i < kNum; ++i) {
+    ASSERT_EQ(aes(), expected_aes());
+    ASSERT_EQ(sm4(), expected_sm4());
+  }
+  // parallel on more threads.
+  set_num_threads(4);
+  std::vector<uint8_t> fill(3 * internal::kParallelFillBytes + 7);
+  std::vector<uint8_t> expected_fill(fill.size());
+  aes.Fill(absl::MakeSpan(fill));
+  expected_aes.Fill(absl::MakeSpan(expected_fill));
+  EXPECT_EQ(fill, expected_fill);
+  EXPECT_EQ(aes.Counter(), expected_aes.Counter());
+  EXPECT_EQ(aes(), expected_aes());
+}
+
+TEST(Prg, DrbgWorks) {
+  Prg<uint64_t, DrbgPolicy<crypto::Sm4Drbg>> prg(kKey1);
+  std::vector<uint64_t> out(100);
+  prg.Fill(absl::MakeSpan(out));
+  EXPECT_NE(out[0], out[1]);
+  EXPECT_NE(prg(), prg());
+}
+
 TEST(PseudoRandomCtrDrbg, BooleanWorks) {
   // GIVEN
   PseudoRandomGenerator<bool> prg(kKey1, PRG_MODE::kNistAesCtrDrbg);
@@ -349,4 +478,10 @@ TEST(PseudoRandomSm4Drbg, DeterministicWithDifferentSeed) {
   }
 }
 
+TEST(PseudoRandomSm4Drbg, IsNotSeekable) {
+  PseudoRandomGenerator<uint128_t> prg(kKey1, PRG_MODE::kGmSm4CtrDrbg);
+  EXPECT_THROW(prg.Substream(1), yasl::Exception);
+  EXPECT_THROW(prg.Split(2), yasl::Exception);
+}
+
 }  // namespace yasl
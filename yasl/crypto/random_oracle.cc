@@ -0,0 +1,147 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/random_oracle.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "yasl/base/exception.h"
+#include "yasl/crypto/aes_ni.h"
+
+#ifdef __x86_64
+#include <immintrin.h>
+#endif
+
+namespace yasl {
+
+namespace {
+
+// blocks in flight, aesenc has a latency of several cycles, and one issue
+// per cycle.
+constexpr size_t kParallelBlocks = 8;
+
+#ifdef __x86_64
+// out = pi(in) ^ (cr ? in : 0), rounds of kParallelBlocks blocks are
+// interleaved.
+template <bool cr>
+__attribute__((target("aes,sse2"))) void AesNiEncrypt(
+    const AesRoundKeys& round_keys, const uint128_t* in,
+    uint128_t* out, size_t n) {
+  __m128i rk[11];
+  for (size_t r = 0; r < 11; ++r) {
+    rk[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&round_keys[r]));
+  }
+  size_t i = 0;
+  for (; i + kParallelBlocks <= n; i += kParallelBlocks) {
+    __m128i x[kParallelBlocks];
+    __m128i b[kParallelBlocks];
+    for (size_t j = 0; j < kParallelBlocks; ++j) {
+      x[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + j));
+      b[j] = _mm_xor_si128(x[j], rk[0]);
+    }
+    for (size_t r = 1; r < 10; ++r) {
+      for (size_t j = 0; j < kParallelBlocks; ++j) {
+        b[j] = _mm_aesenc_si128(b[j], rk[r]);
+      }
+    }
+    for (size_t j = 0; j < kParallelBlocks; ++j) {
+      b[j] = _mm_aesenclast_si128(b[j], rk[10]);
+      if constexpr (cr) {
+        b[j] = _mm_xor_si128(b[j], x[j]);
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + j), b[j]);
+    }
+  }
+  for (; i < n; ++i) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128i b = _mm_xor_si128(x, rk[0]);
+    for (size_t r = 1; r < 10; ++r) {
+      b = _mm_aesenc_si128(b, rk[r]);
+    }
+    b = _mm_aesenclast_si128(b, rk[10]);
+    if constexpr (cr) {
+      b = _mm_xor_si128(b, x);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), b);
+  }
+}
+#endif
+
+}  // namespace
+
+RandomOracle::RandomOracle(SymmetricCrypto::CryptoType ctype, uint128_t key,
+                           uint128_t iv)
+    : sym_alg(ctype, key, iv) {
+  if (ctype == SymmetricCrypto::CryptoType::AES128_ECB && CpuSupportsAesNi()) {
+    use_aes_ni_ = true;
+    AesNiKeySchedule(key, &round_keys_);
+  }
+}
+
+void RandomOracle::Gen(uint128_t x, absl::Span<uint128_t> out) const {
+  if (!use_aes_ni_) {
+    // chained modes take the counters as a whole.
+    std::vector<uint128_t> input(out.size());
+    for (size_t i = 0; i < out.size(); ++i) {
+      input[i] = x + i;
+    }
+    sym_alg.Encrypt(input, out);
+    return;
+  }
+  AesCtrEncrypt(round_keys_, x, reinterpret_cast<uint8_t*>(out.data()),
+                out.size());
+}
+
+void RandomOracle::Gen(absl::Span<const uint128_t> in,
+                       absl::Span<uint128_t> out) const {
+  YASL_ENFORCE_EQ(in.size(), out.size());
+#ifdef __x86_64
+  if (use_aes_ni_) {
+    AesNiEncrypt<false>(round_keys_, in.data(), out.data(), in.size());
+    return;
+  }
+#endif
+  sym_alg.Encrypt(in, out);
+}
+
+void RandomOracle::CrHash(absl::Span<const uint128_t> in,
+                          absl::Span<uint128_t> out) const {
+  YASL_ENFORCE_EQ(in.size(), out.size());
+#ifdef __x86_64
+  if (use_aes_ni_) {
+    AesNiEncrypt<true>(round_keys_, in.data(), out.data(), in.size());
+    return;
+  }
+#endif
+  // blocks are hashed in chunks, so that `in` may be `out`.
+  std::array<uint128_t, kParallelBlocks> buf;
+  for (size_t i = 0; i < in.size(); i += kParallelBlocks) {
+    const size_t n = std::min(kParallelBlocks, in.size() - i);
+    auto chunk = absl::MakeSpan(buf.data(), n);
+    sym_alg.Encrypt(in.subspan(i, n), chunk);
+    for (size_t j = 0; j < n; ++j) {
+      out[i + j] = chunk[j] ^ in[i + j];
+    }
+  }
+}
+
+RandomOracle& RandomOracle::GetDefault() {
+  constexpr uint128_t kDefaultRoAesKey = 0x12345678;
+  static RandomOracle ro(SymmetricCrypto::CryptoType::AES128_ECB,
+                         kDefaultRoAesKey);
+  return ro;
+}
+
+}  // namespace yasl
@@ -17,24 +17,26 @@
 
 #include <array>
 
+#include "yasl/crypto/aes_ni.h"
 #include "yasl/crypto/symmetric_crypto.h"
 
 namespace yasl {
 
 // Symmetric crypto based random oracle.
 //
+// Fixed key AES128_ECB, the default one, runs on AES-NI by 8 interleaved
+// blocks where available, the others go through SymmetricCrypto.
 class RandomOracle {
  public:
   explicit RandomOracle(SymmetricCrypto::CryptoType ctype, uint128_t key,
-                        uint128_t iv = 0)
-      : sym_alg(ctype, key, iv) {}
+                        uint128_t iv = 0);
 
   // Flat output.
   template <size_t N = 1>
   auto Gen(uint128_t x) const {
     if constexpr (N == 1) {
       uint128_t output;
-      Gen(x, absl::Span<uint128_t>(&output, 1));
+      Gen(absl::MakeConstSpan(&x, 1), absl::MakeSpan(&output, 1));
       return output;
     } else {
       std::array<uint128_t, N> output;
@@ -43,24 +45,30 @@ class RandomOracle {
     }
   }
 
-  // Overload for dynamic containers say `vector<uint128_t>`.
-  void Gen(uint128_t x, absl::Span<uint128_t> out) const {
-    std::vector<uint128_t> input(out.size(), 0);
-    for (size_t i = 0; i < out.size(); ++i) {
-      input[i] = x + i;
-    }
-    sym_alg.Encrypt(input, out);
-  }
+  // Overload for dynamic containers say `vector<uint128_t>`, out[i] is the
+  // output of x + i.
+  void Gen(uint128_t x, absl::Span<uint128_t> out) const;
+
+  // Batch of blocks, out[i] = pi(in[i]), `in` and `out` may be the same.
+  void Gen(absl::Span<const uint128_t> in, absl::Span<uint128_t> out) const;
 
-  static RandomOracle& GetDefault() {
-    constexpr uint128_t kDefaultRoAesKey = 0x12345678;
-    static RandomOracle ro(SymmetricCrypto::CryptoType::AES128_ECB,
-                           kDefaultRoAesKey);
-    return ro;
+  // Correlation robust hash H(x) = pi(x) ^ x, which hides x even if the key
+  // is public, use it to break correlations of OT extensions.
+  uint128_t CrHash(uint128_t x) const {
+    uint128_t output;
+    CrHash(absl::MakeConstSpan(&x, 1), absl::MakeSpan(&output, 1));
+    return output;
   }
+  void CrHash(absl::Span<const uint128_t> in, absl::Span<uint128_t> out) const;
+
+  static RandomOracle& GetDefault();
 
  private:
   SymmetricCrypto sym_alg;
+
+  // aes round keys, if blocks are encrypted by AES-NI.
+  bool use_aes_ni_ = false;
+  AesRoundKeys round_keys_{};
 };
 
 }  // namespace yasl
@@ -23,16 +23,6 @@
 
 namespace yasl {
 
-inline size_t HammingDistance(absl::Span<const uint128_t> x,
-                              absl::Span<const uint128_t> y) {
-  YASL_ENFORCE_EQ(x.size(), y.size());
-  size_t sum = 0;
-  for (size_t i = 0; i < x.size(); ++i) {
-    sum += HammingDistance(x[i], y[i]);
-  }
-  return sum;
-}
-
 // Reference: https://eprint.iacr.org/2016/799.pdf
 //
 // See `Pseudorandom codes` in Charpter II. Which guarantees the hamming
@@ -76,4 +66,51 @@ TEST(RandomOracle, AutoOutputTypeInference) {
   EXPECT_EQ(y, z[0]) << y << ", " << z[0];
 }
 
+TEST(RandomOracle, BatchShouldMatchSymmetricCrypto) {
+  // GIVEN
+  const uint128_t key = 9527;
+  RandomOracle ro(SymmetricCrypto::CryptoType::AES128_ECB, key);
+  SymmetricCrypto aes(SymmetricCrypto::CryptoType::AES128_ECB, key);
+  // not a multiple of the interleaved blocks.
+  std::vector<uint128_t> in(1000 + 3);
+  std::random_device rd;
+  for (auto& x : in) {
+    x = MakeUint128(rd(), rd());
+  }
+
+  // WHEN
+  std::vector<uint128_t> out(in.size());
+  ro.Gen(in, absl::MakeSpan(out));
+  std::vector<uint128_t> hashes(in.size());
+  ro.CrHash(in, absl::MakeSpan(hashes));
+  std::vector<uint128_t> counters(in.size());
+  ro.Gen(in[0], absl::MakeSpan(counters));
+
+  // THEN
+  for (size_t i = 0; i < in.size(); ++i) {
+    EXPECT_EQ(out[i], aes.Encrypt(in[i]));
+    EXPECT_EQ(out[i], ro.Gen(in[i]));
+    EXPECT_EQ(hashes[i], out[i] ^ in[i]);
+    EXPECT_EQ(hashes[i], ro.CrHash(in[i]));
+    EXPECT_EQ(counters[i], aes.Encrypt(in[0] + i));
+  }
+}
+
+TEST(RandomOracle, CrHashWorksInPlace) {
+  // GIVEN
+  RandomOracle ro(SymmetricCrypto::CryptoType::SM4_ECB, 9527);
+  std::vector<uint128_t> blocks(20);
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    blocks[i] = i;
+  }
+
+  // WHEN
+  ro.CrHash(blocks, absl::MakeSpan(blocks));
+
+  // THEN
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    EXPECT_EQ(blocks[i], ro.Gen(i) ^ i);
+  }
+}
+
 }  // namespace yasl
@@ -15,49 +15,46 @@
 #include "yasl/crypto/rsa_signing.h"
 
 #include "openssl/evp.h"
-#include "openssl/pem.h"
 
 #include "yasl/base/exception.h"
-#include "yasl/utils/scope_guard.h"
+#include "yasl/crypto/asymmetric_util.h"
 
 namespace yasl::crypto {
 
 std::unique_ptr<RsaSigner> RsaSigner::CreateFromPem(ByteContainerView pem) {
-  BIO* bio_pkey = BIO_new_mem_buf(pem.data(), pem.size());
-  YASL_ENFORCE(bio_pkey, "Failed to create BIO");
-  ON_SCOPE_EXIT([&bio_pkey] { BIO_free(bio_pkey); });
-  RSA* rsa = PEM_read_bio_RSAPrivateKey(bio_pkey, NULL, NULL, NULL);
-  YASL_ENFORCE(rsa, "Failed to get rsa from pem.");
-  EVP_PKEY* pkey = EVP_PKEY_new();
-  YASL_ENFORCE(pkey, "Failed to create evp key.");
-  // Use assign here for that rsa will be freed when pkey is freed.
-  YASL_ENFORCE_EQ(EVP_PKEY_assign_RSA(pkey, rsa), 1);
   // Using `new` to access a non-public constructor.
   // ref https://abseil.io/tips/134
   return std::unique_ptr<RsaSigner>(
-      new RsaSigner(UniquePkey(pkey, &EVP_PKEY_free)));
+      new RsaSigner(internal::CreatePriPkeyFromRsaPem(pem)));
+}
+
+RsaSigner::RsaSigner(UniquePkey pkey)
+    : pkey_(std::move(pkey)),
+      schema_(SignatureScheme::RSA_SIGNING_SHA256_HASH),
+      sign_ctx_(EVP_MD_CTX_new(), ::EVP_MD_CTX_free) {
+  YASL_ENFORCE(sign_ctx_ != nullptr);
+  YASL_ENFORCE_GT(EVP_DigestSignInit(sign_ctx_.get(), nullptr, EVP_sha256(),
+                                     nullptr, pkey_.get()),
+                  0);
 }
 
 SignatureScheme RsaSigner::GetSignatureSchema() const { return schema_; }
 
 std::vector<uint8_t> RsaSigner::Sign(ByteContainerView message) const {
-  EVP_MD_CTX* m_ctx = EVP_MD_CTX_new();
+  UniqueMdCtx m_ctx(EVP_MD_CTX_new(), ::EVP_MD_CTX_free);
   YASL_ENFORCE(m_ctx != nullptr);
-  ON_SCOPE_EXIT([&] { EVP_MD_CTX_free(m_ctx); });
-
+  YASL_ENFORCE_GT(EVP_MD_CTX_copy_ex(m_ctx.get(), sign_ctx_.get()), 0);
   YASL_ENFORCE_GT(
-      EVP_DigestSignInit(m_ctx, nullptr, EVP_sha256(), nullptr, pkey_.get()),
-      0);
-  YASL_ENFORCE_GT(EVP_DigestSignUpdate(m_ctx, message.data(), message.size()),
-                  0);
+      EVP_DigestSignUpdate(m_ctx.get(), message.data(), message.size()), 0);
 
   // Determine the size of the signature
   // Note that sig_len is the max but not exact size of the output buffer.
   // Ref https://www.openssl.org/docs/man1.1.1/man3/EVP_DigestSignFinal.html
   size_t sig_len;
-  YASL_ENFORCE_GT(EVP_DigestSignFinal(m_ctx, nullptr, &sig_len), 0);
+  YASL_ENFORCE_GT(EVP_DigestSignFinal(m_ctx.get(), nullptr, &sig_len), 0);
   std::vector<uint8_t> signature(sig_len);
-  YASL_ENFORCE_GT(EVP_DigestSignFinal(m_ctx, signature.data(), &sig_len), 0);
+  YASL_ENFORCE_GT(EVP_DigestSignFinal(m_ctx.get(), signature.data(), &sig_len),
+                  0);
   // Correct the signature size.
   signature.resize(sig_len);
 
@@ -65,49 +62,55 @@ std::vector<uint8_t> RsaSigner::Sign(ByteContainerView message) const {
 }
 
 std::unique_ptr<RsaVerifier> RsaVerifier::CreateFromPem(ByteContainerView pem) {
-  BIO* bio_pkey = BIO_new_mem_buf(pem.data(), pem.size());
-  YASL_ENFORCE(bio_pkey, "Failed to create BIO");
-  ON_SCOPE_EXIT([&bio_pkey] { BIO_free(bio_pkey); });
-  RSA* rsa = PEM_read_bio_RSAPublicKey(bio_pkey, NULL, NULL, NULL);
-  YASL_ENFORCE(rsa, "Failed to get rsa from pem.");
-  EVP_PKEY* pkey = EVP_PKEY_new();
-  YASL_ENFORCE(pkey, "Failed to create evp key.");
-  // Use assign here for that rsa will be freed when pkey is freed.
-  YASL_ENFORCE_EQ(EVP_PKEY_assign_RSA(pkey, rsa), 1);
   // Using `new` to access a non-public constructor.
   // ref https://abseil.io/tips/134
   return std::unique_ptr<RsaVerifier>(
-      new RsaVerifier(UniquePkey(pkey, ::EVP_PKEY_free)));
+      new RsaVerifier(internal::CreatePubPkeyFromRsaPem(pem)));
 }
 
 std::unique_ptr<RsaVerifier> RsaVerifier::CreateFromCertPem(
     ByteContainerView cert_pem) {
-  UniqueBio bio_cert(BIO_new_mem_buf(cert_pem.data(), cert_pem.size()),
-                     ::BIO_free);
-  UniqueX509 unique_cert(
-      PEM_read_bio_X509(bio_cert.get(), nullptr, nullptr, nullptr),
-      ::X509_free);
-  EVP_PKEY* pk = X509_get_pubkey(unique_cert.get());
-  YASL_ENFORCE(pk != nullptr);
   return std::unique_ptr<RsaVerifier>(
-      new RsaVerifier(UniquePkey(pk, ::EVP_PKEY_free)));
+      new RsaVerifier(internal::CreatePubPkeyFromCertPem(cert_pem)));
+}
+
+RsaVerifier::RsaVerifier(UniquePkey pkey)
+    : pkey_(std::move(pkey)),
+      schema_(SignatureScheme::RSA_SIGNING_SHA256_HASH),
+      verify_ctx_(EVP_MD_CTX_new(), ::EVP_MD_CTX_free) {
+  YASL_ENFORCE(verify_ctx_ != nullptr);
+  YASL_ENFORCE_GT(EVP_DigestVerifyInit(verify_ctx_.get(), nullptr,
+                                       EVP_sha256(), nullptr, pkey_.get()),
+                  0);
 }
 
 SignatureScheme RsaVerifier::GetSignatureSchema() const { return schema_; }
 
 void RsaVerifier::Verify(ByteContainerView message,
                          ByteContainerView signature) const {
-  EVP_MD_CTX* m_ctx = EVP_MD_CTX_new();
+  UniqueMdCtx m_ctx(EVP_MD_CTX_new(), ::EVP_MD_CTX_free);
   YASL_ENFORCE(m_ctx != nullptr);
-  ON_SCOPE_EXIT([&] { EVP_MD_CTX_free(m_ctx); });
-
+  YASL_ENFORCE_GT(EVP_MD_CTX_copy_ex(m_ctx.get(), verify_ctx_.get()), 0);
   YASL_ENFORCE_GT(
-      EVP_DigestVerifyInit(m_ctx, nullptr, EVP_sha256(), nullptr, pkey_.get()),
-      0);
-  YASL_ENFORCE_GT(EVP_DigestVerifyUpdate(m_ctx, message.data(), message.size()),
-                  0);
+      EVP_DigestVerifyUpdate(m_ctx.get(), message.data(), message.size()), 0);
   YASL_ENFORCE_GT(
-      EVP_DigestVerifyFinal(m_ctx, signature.data(), signature.size()), 0);
+      EVP_DigestVerifyFinal(m_ctx.get(), signature.data(), signature.size()),
+      0);
+}
+
+std::vector<bool> RsaVerifier::VerifyBatch(
+    absl::Span<const ByteContainerView> messages,
+    absl::Span<const ByteContainerView> signatures) const {
+  YASL_ENFORCE_EQ(messages.size(), signatures.size());
+  return internal::ParallelVerify(
+      messages.size(), [&](size_t begin, size_t end, uint8_t* ok) {
+        UniqueMdCtx m_ctx(EVP_MD_CTX_new(), ::EVP_MD_CTX_free);
+        YASL_ENFORCE(m_ctx != nullptr);
+        for (size_t i = begin; i < end; i++) {
+          ok[i - begin] = internal::DigestVerifyFrom(
+              verify_ctx_.get(), m_ctx.get(), messages[i], signatures[i]);
+        }
+      });
 }
 
-}  // namespace yasl::crypto
\ No newline at end of file
+}  // namespace yasl::crypto
@@ -23,9 +23,14 @@
 namespace yasl::crypto {
 
 // RSA sign with sha256
+//
+// The key is parsed once per pem, see ClearAsymmetricKeyCache, and the
+// digest context is set up at creation, Sign only copies it. Sign is thread
+// safe.
 class RsaSigner final : public crypto::AsymmetricSigner {
  public:
   using UniquePkey = std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>;
+  using UniqueMdCtx = std::unique_ptr<EVP_MD_CTX, decltype(&::EVP_MD_CTX_free)>;
 
   static std::unique_ptr<RsaSigner> CreateFromPem(ByteContainerView pem);
 
@@ -34,20 +39,21 @@ class RsaSigner final : public crypto::AsymmetricSigner {
   std::vector<uint8_t> Sign(ByteContainerView message) const override;
 
  private:
-  explicit RsaSigner(UniquePkey pkey)
-      : pkey_(std::move(pkey)),
-        schema_(SignatureScheme::RSA_SIGNING_SHA256_HASH) {}
+  explicit RsaSigner(UniquePkey pkey);
 
   const UniquePkey pkey_;
   const SignatureScheme schema_;
+  // after EVP_DigestSignInit.
+  UniqueMdCtx sign_ctx_;
 };
 
-// RSA verify with sha256
+// RSA verify with sha256, the same as RsaSigner on keys and contexts.
 class RsaVerifier final : public crypto::AsymmetricVerifier {
  public:
   using UniquePkey = std::unique_ptr<EVP_PKEY, decltype(&::EVP_PKEY_free)>;
   using UniqueBio = std::unique_ptr<BIO, decltype(&::BIO_free)>;
   using UniqueX509 = std::unique_ptr<X509, decltype(&::X509_free)>;
+  using UniqueMdCtx = std::unique_ptr<EVP_MD_CTX, decltype(&::EVP_MD_CTX_free)>;
 
   static std::unique_ptr<RsaVerifier> CreateFromPem(ByteContainerView pem);
 
@@ -59,13 +65,19 @@ class RsaVerifier final : public crypto::AsymmetricVerifier {
   void Verify(ByteContainerView message,
               ByteContainerView signature) const override;
 
+  // RSA public key operations reuse the montgomery context cached in the
+  // shared key, and failures cost no exception.
+  std::vector<bool> VerifyBatch(
+      absl::Span<const ByteContainerView> messages,
+      absl::Span<const ByteContainerView> signatures) const override;
+
  private:
-  explicit RsaVerifier(UniquePkey pkey)
-      : pkey_(std::move(pkey)),
-        schema_(SignatureScheme::RSA_SIGNING_SHA256_HASH) {}
+  explicit RsaVerifier(UniquePkey pkey);
 
   const UniquePkey pkey_;
   const SignatureScheme schema_;
+  // after EVP_DigestVerifyInit.
+  UniqueMdCtx verify_ctx_;
 };
 
 }  // namespace yasl::crypto
\ No newline at end of file
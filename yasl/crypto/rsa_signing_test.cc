@@ -14,6 +14,9 @@
 
 #include "yasl/crypto/rsa_signing.h"
 
+#include <thread>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "openssl/pem.h"
 
@@ -54,4 +57,75 @@ TEST(RsaSigning, SignVerifyInitWithCert_shouldOk) {
   rsa_verifier->Verify(plaintext, signature);
 }
 
+TEST(RsaSigning, CachedKeysAndConcurrentSign_shouldOk) {
+  // GIVEN
+  auto [public_key, private_key] = CreateRsaKeyPair();
+  ClearAsymmetricKeyCache();
+
+  // WHEN
+  auto rsa_signer = RsaSigner::CreateFromPem(private_key);
+  auto rsa_verifier = RsaVerifier::CreateFromPem(public_key);
+  EXPECT_EQ(AsymmetricKeyCacheSize(), 2);
+  // the same pem parses no more.
+  auto another_verifier = RsaVerifier::CreateFromPem(public_key);
+  EXPECT_EQ(AsymmetricKeyCacheSize(), 2);
+
+  // THEN
+  // one signer and verifier used by many threads.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < 8; j++) {
+        std::string plaintext = "message " + std::to_string(i * 8 + j);
+        auto signature = rsa_signer->Sign(plaintext);
+        rsa_verifier->Verify(plaintext, signature);
+        another_verifier->Verify(plaintext, signature);
+        EXPECT_ANY_THROW(rsa_verifier->Verify(plaintext + "!", signature));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ClearAsymmetricKeyCache();
+  EXPECT_EQ(AsymmetricKeyCacheSize(), 0);
+  // objects keep their keys.
+  rsa_verifier->Verify("hello", rsa_signer->Sign("hello"));
+}
+
+TEST(RsaSigning, VerifyBatch_shouldOk) {
+  // GIVEN
+  auto [public_key, private_key] = CreateRsaKeyPair();
+  auto rsa_signer = RsaSigner::CreateFromPem(private_key);
+  auto rsa_verifier = RsaVerifier::CreateFromPem(public_key);
+  std::vector<std::string> messages;
+  std::vector<std::vector<uint8_t>> signatures;
+  for (int i = 0; i < 50; i++) {
+    messages.push_back("message " + std::to_string(i));
+    signatures.push_back(rsa_signer->Sign(messages.back()));
+  }
+  // every third one is bad.
+  for (size_t i = 0; i < signatures.size(); i += 3) {
+    signatures[i][i] ^= 1;
+  }
+
+  // WHEN
+  std::vector<ByteContainerView> message_views(messages.begin(),
+                                               messages.end());
+  std::vector<ByteContainerView> signature_views(signatures.begin(),
+                                                 signatures.end());
+  auto ok = rsa_verifier->VerifyBatch(message_views, signature_views);
+  // the generic version, by Verify.
+  auto ok_by_verify = rsa_verifier->AsymmetricVerifier::VerifyBatch(
+      message_views, signature_views);
+
+  // THEN
+  ASSERT_EQ(ok.size(), messages.size());
+  for (size_t i = 0; i < ok.size(); i++) {
+    EXPECT_EQ(ok[i], i % 3 != 0) << i;
+  }
+  EXPECT_EQ(ok_by_verify, ok);
+}
+
 }  // namespace yasl::crypto
\ No newline at end of file
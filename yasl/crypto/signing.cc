@@ -0,0 +1,60 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/signing.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/utils/parallel.h"
+
+namespace yasl::crypto {
+
+namespace {
+
+// signatures verified by one task at least, each takes tens of us.
+constexpr int64_t kVerifyGrainSize = 16;
+
+}  // namespace
+
+std::vector<bool> AsymmetricVerifier::VerifyBatch(
+    absl::Span<const ByteContainerView> messages,
+    absl::Span<const ByteContainerView> signatures) const {
+  YASL_ENFORCE_EQ(messages.size(), signatures.size());
+  return internal::ParallelVerify(
+      messages.size(), [&](size_t begin, size_t end, uint8_t* ok) {
+        for (size_t i = begin; i < end; i++) {
+          try {
+            Verify(messages[i], signatures[i]);
+            ok[i - begin] = 1;
+          } catch (const yasl::Exception&) {
+          }
+        }
+      });
+}
+
+namespace internal {
+
+std::vector<bool> ParallelVerify(
+    size_t size,
+    const std::function<void(size_t, size_t, uint8_t*)>& verify_range) {
+  // bytes, as tasks cannot write to the bits of a shared word.
+  std::vector<uint8_t> ok(size, 0);
+  parallel_for(0, size, kVerifyGrainSize, [&](int64_t begin, int64_t end) {
+    verify_range(begin, end, ok.data() + begin);
+  });
+  return std::vector<bool>(ok.begin(), ok.end());
+}
+
+}  // namespace internal
+
+}  // namespace yasl::crypto
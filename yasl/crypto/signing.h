@@ -14,8 +14,13 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <vector>
 
+#include "absl/types/span.h"
+
 #include "yasl/base/byte_container_view.h"
 
 namespace yasl::crypto {
@@ -43,6 +48,23 @@ class AsymmetricVerifier {
 
   virtual void Verify(ByteContainerView message,
                       ByteContainerView signature) const = 0;
+
+  // Verifies signatures[i] on messages[i] on the thread pool, bit i tells
+  // whether it holds. Bad signatures throw nothing, which is what makes this
+  // faster than Verify in a loop when many fail.
+  virtual std::vector<bool> VerifyBatch(
+      absl::Span<const ByteContainerView> messages,
+      absl::Span<const ByteContainerView> signatures) const;
 };
 
+namespace internal {
+
+// Runs verify_range(begin, end, ok) over chunks of [0, size) on the thread
+// pool, it sets ok[i - begin] to 1 for each good signature i.
+std::vector<bool> ParallelVerify(
+    size_t size,
+    const std::function<void(size_t, size_t, uint8_t*)>& verify_range);
+
+}  // namespace internal
+
 }  // namespace yasl::crypto
\ No newline at end of file
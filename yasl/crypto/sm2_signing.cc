@@ -14,6 +14,8 @@
 
 #include "yasl/crypto/sm2_signing.h"
 
+#include <algorithm>
+
 #include "absl/memory/memory.h"
 #include "openssl/pem.h"
 
@@ -23,6 +25,37 @@
 
 namespace yasl::crypto {
 
+namespace {
+
+bool IsDefaultId(ByteContainerView id) {
+  return id.size() == SM2_ID_DEFAULT_LENGTH &&
+         std::equal(id.begin(), id.end(), SM2_ID_DEFAULT);
+}
+
+// Sets up `m_ctx` to sign or verify with sm3 and `id`. The init hashes the Z
+// value of the key and id, so copies of `m_ctx` start from there.
+void InitSm2MdCtx(EVP_PKEY* pkey, ByteContainerView id, bool sign,
+                  Sm2Signer::UniquePkeyCtx* p_ctx,
+                  Sm2Signer::UniqueMdCtx* m_ctx) {
+  p_ctx->reset(EVP_PKEY_CTX_new(pkey, nullptr));
+  YASL_ENFORCE(*p_ctx != nullptr);
+  EVP_PKEY_CTX_set1_id(p_ctx->get(), id.data(), id.size());
+  m_ctx->reset(EVP_MD_CTX_new());
+  YASL_ENFORCE(*m_ctx != nullptr);
+  EVP_MD_CTX_set_pkey_ctx(m_ctx->get(), p_ctx->get());
+  if (sign) {
+    YASL_ENFORCE_GT(
+        EVP_DigestSignInit(m_ctx->get(), nullptr, EVP_sm3(), nullptr, pkey),
+        0);
+  } else {
+    YASL_ENFORCE_GT(
+        EVP_DigestVerifyInit(m_ctx->get(), nullptr, EVP_sm3(), nullptr, pkey),
+        0);
+  }
+}
+
+}  // namespace
+
 std::unique_ptr<Sm2Signer> Sm2Signer::CreateFromPem(ByteContainerView sm2_pem) {
   // Using `new` to access a non-public constructor.
   // ref https://abseil.io/tips/134
@@ -30,6 +63,16 @@ std::unique_ptr<Sm2Signer> Sm2Signer::CreateFromPem(ByteContainerView sm2_pem) {
       new Sm2Signer(internal::CreatePriPkeyFromSm2Pem(sm2_pem)));
 }
 
+Sm2Signer::Sm2Signer(UniquePkey pkey)
+    : pkey_(std::move(pkey)),
+      schema_(SignatureScheme::SM2_SIGNING_SM3_HASH),
+      default_pctx_(nullptr, EVP_PKEY_CTX_free),
+      default_ctx_(nullptr, EVP_MD_CTX_free) {
+  InitSm2MdCtx(pkey_.get(),
+               ByteContainerView(SM2_ID_DEFAULT, SM2_ID_DEFAULT_LENGTH), true,
+               &default_pctx_, &default_ctx_);
+}
+
 SignatureScheme Sm2Signer::GetSignatureSchema() const { return schema_; }
 
 std::vector<uint8_t> Sm2Signer::Sign(ByteContainerView message) const {
@@ -39,28 +82,28 @@ std::vector<uint8_t> Sm2Signer::Sign(ByteContainerView message) const {
 
 std::vector<uint8_t> Sm2Signer::Sign(ByteContainerView message,
                                      ByteContainerView id) const {
-  EVP_PKEY_CTX* p_ctx = EVP_PKEY_CTX_new(pkey_.get(), nullptr);
-  YASL_ENFORCE(p_ctx != nullptr);
-  ON_SCOPE_EXIT([&] { EVP_PKEY_CTX_free(p_ctx); });
-  EVP_PKEY_CTX_set1_id(p_ctx, id.data(), id.size());
-  EVP_MD_CTX* m_ctx = EVP_MD_CTX_new();
-  YASL_ENFORCE(m_ctx != nullptr);
-  ON_SCOPE_EXIT([&] { EVP_MD_CTX_free(m_ctx); });
-  EVP_MD_CTX_init(m_ctx);
-  EVP_MD_CTX_set_pkey_ctx(m_ctx, p_ctx);
+  UniquePkeyCtx p_ctx(nullptr, EVP_PKEY_CTX_free);
+  UniqueMdCtx m_ctx(nullptr, EVP_MD_CTX_free);
+  if (IsDefaultId(id)) {
+    // the copy owns a copy of the pkey context.
+    m_ctx.reset(EVP_MD_CTX_new());
+    YASL_ENFORCE(m_ctx != nullptr);
+    YASL_ENFORCE_GT(EVP_MD_CTX_copy_ex(m_ctx.get(), default_ctx_.get()), 0);
+  } else {
+    InitSm2MdCtx(pkey_.get(), id, true, &p_ctx, &m_ctx);
+  }
 
   YASL_ENFORCE_GT(
-      EVP_DigestSignInit(m_ctx, nullptr, EVP_sm3(), nullptr, pkey_.get()), 0);
-  YASL_ENFORCE_GT(EVP_DigestSignUpdate(m_ctx, message.data(), message.size()),
-                  0);
+      EVP_DigestSignUpdate(m_ctx.get(), message.data(), message.size()), 0);
 
   // Determine the size of the signature
   // Note that sig_len is the max but not exact size of the output buffer.
   // Ref https://www.openssl.org/docs/man1.1.1/man3/EVP_DigestSignFinal.html
   size_t sig_len;
-  YASL_ENFORCE_GT(EVP_DigestSignFinal(m_ctx, nullptr, &sig_len), 0);
+  YASL_ENFORCE_GT(EVP_DigestSignFinal(m_ctx.get(), nullptr, &sig_len), 0);
   std::vector<uint8_t> signature(sig_len);
-  YASL_ENFORCE_GT(EVP_DigestSignFinal(m_ctx, signature.data(), &sig_len), 0);
+  YASL_ENFORCE_GT(EVP_DigestSignFinal(m_ctx.get(), signature.data(), &sig_len),
+                  0);
   // Correct the signature size.
   signature.resize(sig_len);
 
@@ -75,15 +118,8 @@ std::unique_ptr<Sm2Verifier> Sm2Verifier::CreateFromPem(
 
 std::unique_ptr<Sm2Verifier> Sm2Verifier::CreateFromCertPem(
     ByteContainerView sm2_cert_pem) {
-  UniqueBio bio_cert(BIO_new_mem_buf(sm2_cert_pem.data(), sm2_cert_pem.size()),
-                     BIO_free);
-  X509* cert = PEM_read_bio_X509(bio_cert.get(), nullptr, nullptr, nullptr);
-  YASL_ENFORCE(cert != nullptr);
-  UniqueX509 unique_cert(cert, ::X509_free);
-  EVP_PKEY* pk = X509_get_pubkey(unique_cert.get());
-  YASL_ENFORCE(pk != nullptr);
   return std::unique_ptr<Sm2Verifier>(
-      new Sm2Verifier(UniquePkey(pk, ::EVP_PKEY_free)));
+      new Sm2Verifier(internal::CreatePubPkeyFromCertPem(sm2_cert_pem)));
 }
 
 std::unique_ptr<Sm2Verifier> Sm2Verifier::CreateFromOct(
@@ -124,6 +160,16 @@ std::unique_ptr<Sm2Verifier> Sm2Verifier::CreateFromCertDer(
   return std::unique_ptr<Sm2Verifier>(new Sm2Verifier(std::move(unique_pk)));
 }
 
+Sm2Verifier::Sm2Verifier(UniquePkey pkey)
+    : pkey_(std::move(pkey)),
+      schema_(SignatureScheme::SM2_SIGNING_SM3_HASH),
+      default_pctx_(nullptr, EVP_PKEY_CTX_free),
+      default_ctx_(nullptr, EVP_MD_CTX_free) {
+  InitSm2MdCtx(pkey_.get(),
+               ByteContainerView(SM2_ID_DEFAULT, SM2_ID_DEFAULT_LENGTH), false,
+               &default_pctx_, &default_ctx_);
+}
+
 SignatureScheme Sm2Verifier::GetSignatureSchema() const { return schema_; }
 
 void Sm2Verifier::Verify(ByteContainerView message,
@@ -134,21 +180,36 @@ void Sm2Verifier::Verify(ByteContainerView message,
 
 void Sm2Verifier::Verify(ByteContainerView message, ByteContainerView signature,
                          ByteContainerView id) const {
-  EVP_PKEY_CTX* p_ctx = EVP_PKEY_CTX_new(pkey_.get(), nullptr);
-  YASL_ENFORCE(p_ctx != nullptr);
-  ON_SCOPE_EXIT([&] { EVP_PKEY_CTX_free(p_ctx); });
-  EVP_PKEY_CTX_set1_id(p_ctx, id.data(), id.size());
-  EVP_MD_CTX* m_ctx = EVP_MD_CTX_new();
-  YASL_ENFORCE(m_ctx != nullptr);
-  ON_SCOPE_EXIT([&] { EVP_MD_CTX_free(m_ctx); });
-  EVP_MD_CTX_set_pkey_ctx(m_ctx, p_ctx);
+  UniquePkeyCtx p_ctx(nullptr, EVP_PKEY_CTX_free);
+  UniqueMdCtx m_ctx(nullptr, EVP_MD_CTX_free);
+  if (IsDefaultId(id)) {
+    m_ctx.reset(EVP_MD_CTX_new());
+    YASL_ENFORCE(m_ctx != nullptr);
+    YASL_ENFORCE_GT(EVP_MD_CTX_copy_ex(m_ctx.get(), default_ctx_.get()), 0);
+  } else {
+    InitSm2MdCtx(pkey_.get(), id, false, &p_ctx, &m_ctx);
+  }
 
   YASL_ENFORCE_GT(
-      EVP_DigestVerifyInit(m_ctx, nullptr, EVP_sm3(), nullptr, pkey_.get()), 0);
-  YASL_ENFORCE_GT(EVP_DigestVerifyUpdate(m_ctx, message.data(), message.size()),
-                  0);
+      EVP_DigestVerifyUpdate(m_ctx.get(), message.data(), message.size()), 0);
   YASL_ENFORCE_GT(
-      EVP_DigestVerifyFinal(m_ctx, signature.data(), signature.size()), 0);
+      EVP_DigestVerifyFinal(m_ctx.get(), signature.data(), signature.size()),
+      0);
+}
+
+std::vector<bool> Sm2Verifier::VerifyBatch(
+    absl::Span<const ByteContainerView> messages,
+    absl::Span<const ByteContainerView> signatures) const {
+  YASL_ENFORCE_EQ(messages.size(), signatures.size());
+  return internal::ParallelVerify(
+      messages.size(), [&](size_t begin, size_t end, uint8_t* ok) {
+        UniqueMdCtx m_ctx(EVP_MD_CTX_new(), ::EVP_MD_CTX_free);
+        YASL_ENFORCE(m_ctx != nullptr);
+        for (size_t i = begin; i < end; i++) {
+          ok[i - begin] = internal::DigestVerifyFrom(
+              default_ctx_.get(), m_ctx.get(), messages[i], signatures[i]);
+        }
+      });
 }
 
 }  // namespace yasl::crypto
\ No newline at end of file
@@ -32,9 +32,15 @@ inline constexpr size_t SM2_ID_DEFAULT_LENGTH = 16;
 inline constexpr char SM2_ID_DEFAULT[SM2_ID_DEFAULT_LENGTH + 1] =
     "1234567812345678";
 
+// The key is parsed once per pem, see ClearAsymmetricKeyCache. The digest
+// context of the default id, which has hashed the sm2 Z value already, is set
+// up at creation and Sign only copies it. Sign is thread safe.
 class Sm2Signer final : public crypto::AsymmetricSigner {
  public:
   using UniquePkey = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
+  using UniquePkeyCtx =
+      std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)>;
+  using UniqueMdCtx = std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>;
 
   static std::unique_ptr<Sm2Signer> CreateFromPem(ByteContainerView sm2_pem);
 
@@ -47,17 +53,22 @@ class Sm2Signer final : public crypto::AsymmetricSigner {
                             ByteContainerView id) const;
 
  private:
-  explicit Sm2Signer(UniquePkey pkey)
-      : pkey_(std::move(pkey)),
-        schema_(SignatureScheme::SM2_SIGNING_SM3_HASH) {}
+  explicit Sm2Signer(UniquePkey pkey);
 
   const UniquePkey pkey_;
   const SignatureScheme schema_;
+  // the md context does not own the pkey context.
+  UniquePkeyCtx default_pctx_;
+  UniqueMdCtx default_ctx_;
 };
 
+// The same as Sm2Signer on keys and contexts.
 class Sm2Verifier final : public crypto::AsymmetricVerifier {
  public:
   using UniquePkey = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
+  using UniquePkeyCtx =
+      std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)>;
+  using UniqueMdCtx = std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>;
   using UniqueBio = std::unique_ptr<BIO, decltype(&BIO_free)>;
   using UniqueX509 = std::unique_ptr<X509, decltype(&X509_free)>;
 
@@ -78,13 +89,19 @@ class Sm2Verifier final : public crypto::AsymmetricVerifier {
   void Verify(ByteContainerView message, ByteContainerView signature,
               ByteContainerView id) const;
 
+  // With the default id, one by one on the thread pool. SM2 has no batch
+  // verification, the signature keeps only the x of the point R.
+  std::vector<bool> VerifyBatch(
+      absl::Span<const ByteContainerView> messages,
+      absl::Span<const ByteContainerView> signatures) const override;
+
  private:
-  explicit Sm2Verifier(UniquePkey pkey)
-      : pkey_(std::move(pkey)),
-        schema_(SignatureScheme::SM2_SIGNING_SM3_HASH) {}
+  explicit Sm2Verifier(UniquePkey pkey);
 
   const UniquePkey pkey_;
   const SignatureScheme schema_;
+  UniquePkeyCtx default_pctx_;
+  UniqueMdCtx default_ctx_;
 };
 
 // TODO @raofei: support sm2 certificate
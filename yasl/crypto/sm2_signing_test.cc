@@ -34,4 +34,50 @@ TEST(Sm2Signing, SignVerify_shouldOk) {
   sm2_verifier->Verify(plaintext, signature);
 }
 
+TEST(Sm2Signing, SignVerifyWithIds_shouldOk) {
+  // GIVEN
+  auto [public_key, private_key] = CreateSm2KeyPair();
+  std::string plaintext = "I am a plaintext.";
+  std::string id = "another id";
+
+  // WHEN & THEN
+  // creating twice uses the cached keys and contexts.
+  for (int i = 0; i < 2; i++) {
+    auto sm2_signer = Sm2Signer::CreateFromPem(private_key);
+    auto sm2_verifier = Sm2Verifier::CreateFromPem(public_key);
+    sm2_verifier->Verify(plaintext, sm2_signer->Sign(plaintext));
+    sm2_verifier->Verify(plaintext, sm2_signer->Sign(plaintext, id), id);
+    EXPECT_ANY_THROW(
+        sm2_verifier->Verify(plaintext, sm2_signer->Sign(plaintext, id)));
+  }
+}
+
+TEST(Sm2Signing, VerifyBatch_shouldOk) {
+  // GIVEN
+  auto [public_key, private_key] = CreateSm2KeyPair();
+  auto sm2_signer = Sm2Signer::CreateFromPem(private_key);
+  auto sm2_verifier = Sm2Verifier::CreateFromPem(public_key);
+  std::vector<std::string> messages;
+  std::vector<std::vector<uint8_t>> signatures;
+  for (int i = 0; i < 20; i++) {
+    messages.push_back("message " + std::to_string(i));
+    signatures.push_back(sm2_signer->Sign(messages.back()));
+  }
+  messages[3] += "!";
+  signatures[7].pop_back();
+
+  // WHEN
+  std::vector<ByteContainerView> message_views(messages.begin(),
+                                               messages.end());
+  std::vector<ByteContainerView> signature_views(signatures.begin(),
+                                                 signatures.end());
+  auto ok = sm2_verifier->VerifyBatch(message_views, signature_views);
+
+  // THEN
+  ASSERT_EQ(ok.size(), messages.size());
+  for (size_t i = 0; i < ok.size(); i++) {
+    EXPECT_EQ(ok[i], i != 3 && i != 7) << i;
+  }
+}
+
 }  // namespace yasl::crypto
\ No newline at end of file
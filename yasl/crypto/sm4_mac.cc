@@ -14,6 +14,9 @@
 
 #include "yasl/crypto/sm4_mac.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "yasl/base/exception.h"
 #include "yasl/crypto/hmac_sm3.h"
 #include "yasl/crypto/ssl_hash.h"
@@ -26,6 +29,50 @@ namespace {
 constexpr size_t HMAC_SIZE = 32;
 constexpr size_t HMAC_KEY_SIZE = 16;
 
+constexpr size_t kBlockSize = 16;
+// interleaved cmac chains, a full batch of the VAES kernel.
+constexpr size_t kCmacLanes = 16;
+
+void XorBlock(const uint8_t* in, uint8_t* out, size_t n = kBlockSize) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] ^= in[i];
+  }
+}
+
+// multiplies by x in GF(2^128), big endian, as the cmac subkeys.
+std::array<uint8_t, kBlockSize> Double(
+    const std::array<uint8_t, kBlockSize>& in) {
+  std::array<uint8_t, kBlockSize> out;
+  for (size_t i = 0; i + 1 < kBlockSize; ++i) {
+    out[i] = static_cast<uint8_t>((in[i] << 1) | (in[i + 1] >> 7));
+  }
+  out[kBlockSize - 1] = static_cast<uint8_t>(in[kBlockSize - 1] << 1);
+  if (in[0] & 0x80) {
+    out[kBlockSize - 1] ^= 0x87;
+  }
+  return out;
+}
+
+uint128_t CmacKey(ByteContainerView key) {
+  YASL_ENFORCE_EQ(key.size(), kBlockSize);
+  uint128_t ret;
+  std::memcpy(&ret, key.data(), kBlockSize);
+  return ret;
+}
+
+// xors the last `n` bytes of a message, n <= 16, padded into `x`.
+void XorLastBlock(const uint8_t* last, size_t n,
+                  const std::array<uint8_t, kBlockSize>& k1,
+                  const std::array<uint8_t, kBlockSize>& k2, uint8_t* x) {
+  XorBlock(last, x, n);
+  if (n == kBlockSize) {
+    XorBlock(k1.data(), x);
+  } else {
+    x[n] ^= 0x80;
+    XorBlock(k2.data(), x);
+  }
+}
+
 }  // namespace
 
 std::vector<uint8_t> Sm4MteEncrypt(ByteContainerView key, ByteContainerView iv,
@@ -78,4 +125,98 @@ std::vector<uint8_t> Sm4MteDecrypt(ByteContainerView key, ByteContainerView iv,
   return {hmac_plaintext.begin() + HMAC_SIZE, hmac_plaintext.end()};
 }
 
+Sm4Cmac::Sm4Cmac(ByteContainerView key)
+    : ecb_(SymmetricCrypto::CryptoType::SM4_ECB, CmacKey(key)) {
+  Block l = {};
+  ecb_.Encrypt(l, absl::MakeSpan(l));
+  k1_ = Double(l);
+  k2_ = Double(k1_);
+  Reset();
+}
+
+Sm4Cmac& Sm4Cmac::Reset() {
+  state_.fill(0);
+  pending_size_ = 0;
+  return *this;
+}
+
+Sm4Cmac& Sm4Cmac::Update(ByteContainerView data) {
+  size_t n = std::min(kBlockSize - pending_size_, data.size());
+  std::memcpy(pending_.data() + pending_size_, data.data(), n);
+  pending_size_ += n;
+  // a full pending block is chained only once more data follows.
+  for (size_t off = n; off < data.size(); off += n) {
+    XorBlock(pending_.data(), state_.data());
+    ecb_.Encrypt(state_, absl::MakeSpan(state_));
+    n = std::min(kBlockSize, data.size() - off);
+    std::memcpy(pending_.data(), data.data() + off, n);
+    pending_size_ = n;
+  }
+  return *this;
+}
+
+std::vector<uint8_t> Sm4Cmac::CumulativeMac() const {
+  std::vector<uint8_t> mac(kMacSize);
+  CumulativeMac(absl::MakeSpan(mac));
+  return mac;
+}
+
+void Sm4Cmac::CumulativeMac(absl::Span<uint8_t> mac) const {
+  YASL_ENFORCE_EQ(mac.size(), kMacSize);
+  Block x = state_;
+  XorLastBlock(pending_.data(), pending_size_, k1_, k2_, x.data());
+  ecb_.Encrypt(x, mac);
+}
+
+void Sm4Cmac::MacBatch(absl::Span<const ByteContainerView> in,
+                       absl::Span<uint8_t> out) const {
+  YASL_ENFORCE_EQ(out.size(), in.size() * kMacSize);
+  struct Lane {
+    size_t msg;
+    size_t offset;
+  };
+  std::array<Lane, kCmacLanes> lanes;
+  // the chaining values of the lanes, encrypted in one call.
+  std::array<uint8_t, kCmacLanes * kBlockSize> states;
+  size_t active = 0;
+  size_t next = 0;
+  auto start = [&](size_t lane) {
+    lanes[lane] = {next++, 0};
+    std::memset(states.data() + lane * kBlockSize, 0, kBlockSize);
+  };
+  while (active < kCmacLanes && next < in.size()) {
+    start(active++);
+  }
+  while (active > 0) {
+    for (size_t i = 0; i < active; ++i) {
+      const ByteContainerView msg = in[lanes[i].msg];
+      const size_t offset = lanes[i].offset;
+      uint8_t* x = states.data() + i * kBlockSize;
+      if (msg.size() - offset > kBlockSize) {
+        XorBlock(msg.data() + offset, x);
+      } else {
+        XorLastBlock(msg.data() + offset, msg.size() - offset, k1_, k2_, x);
+      }
+      lanes[i].offset += kBlockSize;
+    }
+    const auto batch = absl::MakeSpan(states.data(), active * kBlockSize);
+    ecb_.Encrypt(batch, batch);
+    // backwards, so that a lane moved into a finished one is done this round.
+    for (size_t i = active; i-- > 0;) {
+      if (lanes[i].offset < in[lanes[i].msg].size()) {
+        continue;
+      }
+      std::memcpy(out.data() + lanes[i].msg * kMacSize,
+                  states.data() + i * kBlockSize, kMacSize);
+      if (next < in.size()) {
+        start(i);
+      } else if (i != --active) {
+        lanes[i] = lanes[active];
+        std::memcpy(states.data() + i * kBlockSize,
+                    states.data() + active * kBlockSize, kBlockSize);
+      }
+    }
+  }
+}
+
 }  // namespace yasl::crypto
@@ -14,9 +14,15 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
+#include "absl/types/span.h"
+
 #include "yasl/base/byte_container_view.h"
+#include "yasl/crypto/symmetric_crypto.h"
 
 namespace yasl::crypto {
 
@@ -45,4 +51,47 @@ std::vector<uint8_t> Sm4MteEncrypt(ByteContainerView key, ByteContainerView iv,
 std::vector<uint8_t> Sm4MteDecrypt(ByteContainerView key, ByteContainerView iv,
                                    ByteContainerView ciphertext);
 
-}  // namespace yasl::crypto
\ No newline at end of file
+// SM4-CMAC, the CBC-MAC of GB/T 15852.1 algorithm 5 and NIST SP 800-38B,
+// which unlike plain CBC-MAC is secure for messages of any length. The blocks
+// are encrypted by SM4_ECB of SymmetricCrypto, on the kernels of sm4_ni.h
+// where available.
+class Sm4Cmac {
+ public:
+  static constexpr size_t kMacSize = 16;
+
+  // `key` holds 16 bytes.
+  explicit Sm4Cmac(ByteContainerView key);
+
+  // Clears the data added so far.
+  Sm4Cmac& Reset();
+
+  Sm4Cmac& Update(ByteContainerView data);
+
+  // The mac of the data added so far, which is kept.
+  std::vector<uint8_t> CumulativeMac() const;
+  void CumulativeMac(absl::Span<uint8_t> mac) const;
+
+  // Writes the mac of each of `in` back to back to `out`, which holds
+  // in.size() * kMacSize bytes. The chains of up to 16 messages are
+  // interleaved, so each kernel call encrypts one block of every chain, and
+  // a chain moves on to the next message as soon as its message is done.
+  // The data added by Update() is not part of them and is kept.
+  void MacBatch(absl::Span<const ByteContainerView> in,
+                absl::Span<uint8_t> out) const;
+
+ private:
+  using Block = std::array<uint8_t, 16>;
+
+  const SymmetricCrypto ecb_;
+  // the subkeys for a full and a padded last block.
+  Block k1_;
+  Block k2_;
+
+  // the chaining value, and the last block seen, held back as it might be
+  // the last one of the message.
+  Block state_;
+  Block pending_;
+  size_t pending_size_ = 0;
+};
+
+}  // namespace yasl::crypto
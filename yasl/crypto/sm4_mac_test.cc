@@ -14,7 +14,12 @@
 
 #include "yasl/crypto/sm4_mac.h"
 
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
+#include "openssl/cmac.h"
+#include "openssl/evp.h"
 
 namespace yasl::crypto {
 
@@ -33,4 +38,68 @@ TEST(Sm4Mac, Sm4Mac_shouldOk) {
   EXPECT_EQ(plaintext, std::string(decrypted.begin(), decrypted.end()));
 }
 
-}  // namespace yasl::crypto
\ No newline at end of file
+namespace {
+
+std::vector<uint8_t> OpensslSm4Cmac(const std::string& key,
+                                    const std::string& msg) {
+  std::vector<uint8_t> mac(Sm4Cmac::kMacSize);
+  size_t mac_len = 0;
+  CMAC_CTX* ctx = CMAC_CTX_new();
+  EXPECT_EQ(CMAC_Init(ctx, key.data(), key.size(), EVP_sm4_cbc(), nullptr), 1);
+  EXPECT_EQ(CMAC_Update(ctx, msg.data(), msg.size()), 1);
+  EXPECT_EQ(CMAC_Final(ctx, mac.data(), &mac_len), 1);
+  CMAC_CTX_free(ctx);
+  EXPECT_EQ(mac_len, mac.size());
+  return mac;
+}
+
+}  // namespace
+
+TEST(Sm4Cmac, Update_shouldOk) {
+  std::string key = "abcdefghabcdefgh";
+  for (size_t size : {0, 1, 15, 16, 17, 32, 33, 1000}) {
+    std::string msg(size, 'x');
+    for (size_t i = 0; i < size; ++i) {
+      msg[i] = static_cast<char>(i * 7);
+    }
+    auto expected = OpensslSm4Cmac(key, msg);
+
+    Sm4Cmac cmac(key);
+    EXPECT_EQ(cmac.Update(msg).CumulativeMac(), expected);
+    // byte by byte, and in odd chunks.
+    cmac.Reset();
+    for (char c : msg) {
+      cmac.Update(std::string(1, c));
+    }
+    EXPECT_EQ(cmac.CumulativeMac(), expected);
+    cmac.Reset();
+    for (size_t i = 0; i < size; i += 13) {
+      cmac.Update(msg.substr(i, 13));
+    }
+    EXPECT_EQ(cmac.CumulativeMac(), expected);
+  }
+}
+
+TEST(Sm4Cmac, MacBatch_shouldOk) {
+  std::string key = "1234567812345678";
+  // more messages than lanes, of mixed lengths.
+  std::vector<std::string> msgs;
+  for (size_t i = 0; i < 50; ++i) {
+    msgs.emplace_back((i * 37) % 300, static_cast<char>(i));
+  }
+  std::vector<ByteContainerView> in(msgs.begin(), msgs.end());
+  std::vector<uint8_t> out(msgs.size() * Sm4Cmac::kMacSize);
+
+  Sm4Cmac cmac(key);
+  cmac.Update("kept");
+  cmac.MacBatch(in, absl::MakeSpan(out));
+
+  for (size_t i = 0; i < msgs.size(); ++i) {
+    EXPECT_EQ(std::vector<uint8_t>(out.begin() + i * Sm4Cmac::kMacSize,
+                                   out.begin() + (i + 1) * Sm4Cmac::kMacSize),
+              OpensslSm4Cmac(key, msgs[i]));
+  }
+  EXPECT_EQ(cmac.CumulativeMac(), OpensslSm4Cmac(key, "kept"));
+}
+
+}  // namespace yasl::crypto
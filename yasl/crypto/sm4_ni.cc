@@ -0,0 +1,501 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/sm4_ni.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "yasl/base/exception.h"
+
+#ifdef __x86_64
+#include <immintrin.h>
+
+#include "yasl/base/cpu_dispatch.h"
+#endif
+
+namespace yasl {
+
+namespace {
+
+constexpr size_t kBlockSize = sizeof(uint128_t);
+
+constexpr uint8_t kSbox[256] = {
+    0xd6, 0x90, 0xe9, 0xfe, 0xcc, 0xe1, 0x3d, 0xb7, 0x16, 0xb6, 0x14, 0xc2,
+    0x28, 0xfb, 0x2c, 0x05, 0x2b, 0x67, 0x9a, 0x76, 0x2a, 0xbe, 0x04, 0xc3,
+    0xaa, 0x44, 0x13, 0x26, 0x49, 0x86, 0x06, 0x99, 0x9c, 0x42, 0x50, 0xf4,
+    0x91, 0xef, 0x98, 0x7a, 0x33, 0x54, 0x0b, 0x43, 0xed, 0xcf, 0xac, 0x62,
+    0xe4, 0xb3, 0x1c, 0xa9, 0xc9, 0x08, 0xe8, 0x95, 0x80, 0xdf, 0x94, 0xfa,
+    0x75, 0x8f, 0x3f, 0xa6, 0x47, 0x07, 0xa7, 0xfc, 0xf3, 0x73, 0x17, 0xba,
+    0x83, 0x59, 0x3c, 0x19, 0xe6, 0x85, 0x4f, 0xa8, 0x68, 0x6b, 0x81, 0xb2,
+    0x71, 0x64, 0xda, 0x8b, 0xf8, 0xeb, 0x0f, 0x4b, 0x70, 0x56, 0x9d, 0x35,
+    0x1e, 0x24, 0x0e, 0x5e, 0x63, 0x58, 0xd1, 0xa2, 0x25, 0x22, 0x7c, 0x3b,
+    0x01, 0x21, 0x78, 0x87, 0xd4, 0x00, 0x46, 0x57, 0x9f, 0xd3, 0x27, 0x52,
+    0x4c, 0x36, 0x02, 0xe7, 0xa0, 0xc4, 0xc8, 0x9e, 0xea, 0xbf, 0x8a, 0xd2,
+    0x40, 0xc7, 0x38, 0xb5, 0xa3, 0xf7, 0xf2, 0xce, 0xf9, 0x61, 0x15, 0xa1,
+    0xe0, 0xae, 0x5d, 0xa4, 0x9b, 0x34, 0x1a, 0x55, 0xad, 0x93, 0x32, 0x30,
+    0xf5, 0x8c, 0xb1, 0xe3, 0x1d, 0xf6, 0xe2, 0x2e, 0x82, 0x66, 0xca, 0x60,
+    0xc0, 0x29, 0x23, 0xab, 0x0d, 0x53, 0x4e, 0x6f, 0xd5, 0xdb, 0x37, 0x45,
+    0xde, 0xfd, 0x8e, 0x2f, 0x03, 0xff, 0x6a, 0x72, 0x6d, 0x6c, 0x5b, 0x51,
+    0x8d, 0x1b, 0xaf, 0x92, 0xbb, 0xdd, 0xbc, 0x7f, 0x11, 0xd9, 0x5c, 0x41,
+    0x1f, 0x10, 0x5a, 0xd8, 0x0a, 0xc1, 0x31, 0x88, 0xa5, 0xcd, 0x7b, 0xbd,
+    0x2d, 0x74, 0xd0, 0x12, 0xb8, 0xe5, 0xb4, 0xb0, 0x89, 0x69, 0x97, 0x4a,
+    0x0c, 0x96, 0x77, 0x7e, 0x65, 0xb9, 0xf1, 0x09, 0xc5, 0x6e, 0xc6, 0x84,
+    0x18, 0xf0, 0x7d, 0xec, 0x3a, 0xdc, 0x4d, 0x20, 0x79, 0xee, 0x5f, 0x3e,
+    0xd7, 0xcb, 0x39, 0x48,
+};
+
+constexpr uint32_t kFk[4] = {0xa3b1bac6, 0x56aa3350, 0x677d9197, 0xb27022dc};
+
+inline uint32_t Rotl(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+inline uint32_t LoadBigEndian(const uint8_t* p) {
+  return (uint32_t{p[0]} << 24) | (uint32_t{p[1]} << 16) |
+         (uint32_t{p[2]} << 8) | uint32_t{p[3]};
+}
+
+#ifdef __x86_64
+// blocks per iteration of the kernels, 2 groups of 4 or 8 blocks in flight
+// to hide the latency of aesenclast.
+constexpr size_t kNiBlocks = 8;
+constexpr size_t kVaesBlocks = 16;
+
+const bool kCPUSupportsSm4Ni = CpuSupports(kIsaAes | kIsaSsse3);
+const bool kCPUSupportsSm4Vaes =
+    kCPUSupportsSm4Ni && CpuSupports(kIsaVaes | kIsaAvx2);
+
+// SM4_S(x) = A2(AES_S(A1(x))) for the affine maps A1 and A2 of GF(2)^8,
+// which are evaluated as lo[x & 0xf] ^ hi[x >> 4].
+constexpr uint8_t kPreLo[16] = {0x3e, 0xb2, 0x0e, 0x82, 0xbb, 0x37,
+                                0x8b, 0x07, 0xa1, 0x2d, 0x91, 0x1d,
+                                0x24, 0xa8, 0x14, 0x98};
+constexpr uint8_t kPreHi[16] = {0x00, 0xdc, 0x2e, 0xf2, 0xc5, 0x19,
+                                0xeb, 0x37, 0x08, 0xd4, 0x26, 0xfa,
+                                0xcd, 0x11, 0xe3, 0x3f};
+constexpr uint8_t kPostLo[16] = {0x6c, 0xd4, 0xa6, 0x1e, 0x52, 0xea,
+                                 0x98, 0x20, 0x0b, 0xb3, 0xc1, 0x79,
+                                 0x35, 0x8d, 0xff, 0x47};
+constexpr uint8_t kPostHi[16] = {0x00, 0xe0, 0x50, 0xb0, 0x9d, 0x7d,
+                                 0xcd, 0x2d, 0xc0, 0x20, 0x90, 0x70,
+                                 0x5d, 0xbd, 0x0d, 0xed};
+// aesenclast runs ShiftRows too, which is undone beforehand.
+constexpr uint8_t kInvShiftRows[16] = {0, 13, 10, 7, 4, 1, 14, 11,
+                                       8, 5,  2,  15, 12, 9, 6, 3};
+// the words of SM4 are big endian.
+constexpr uint8_t kByteSwap[16] = {3, 2, 1, 0, 7,  6,  5,  4,
+                                   11, 10, 9, 8, 15, 14, 13, 12};
+// rotations of the words by 8, 16 and 24 bits.
+constexpr uint8_t kRotl8[16] = {3, 0, 1, 2, 7,  4,  5,  6,
+                                11, 8, 9, 10, 15, 12, 13, 14};
+constexpr uint8_t kRotl16[16] = {2, 3, 0, 1, 6,  7,  4,  5,
+                                 10, 11, 8, 9, 14, 15, 12, 13};
+constexpr uint8_t kRotl24[16] = {1, 2, 3, 0, 5,  6,  7,  4,
+                                 9, 10, 11, 8, 13, 14, 15, 12};
+
+// The kernels below are the same on xmm and ymm registers, each 128-bit lane
+// holding word i of 4 blocks.
+
+__attribute__((target("ssse3"))) inline __m128i Load128(const uint8_t* p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+struct NiConsts {
+  __m128i pre_lo, pre_hi, post_lo, post_hi;
+  __m128i inv_shift_rows, nibble, rotl8, rotl16, rotl24;
+};
+
+__attribute__((target("aes,ssse3"))) inline __m128i NiT(__m128i x,
+                                                        const NiConsts& c) {
+  // S-box on each byte.
+  x = _mm_shuffle_epi8(x, c.inv_shift_rows);
+  x = _mm_xor_si128(
+      _mm_shuffle_epi8(c.pre_lo, _mm_and_si128(x, c.nibble)),
+      _mm_shuffle_epi8(c.pre_hi,
+                       _mm_and_si128(_mm_srli_epi32(x, 4), c.nibble)));
+  x = _mm_aesenclast_si128(x, _mm_setzero_si128());
+  x = _mm_xor_si128(
+      _mm_shuffle_epi8(c.post_lo, _mm_and_si128(x, c.nibble)),
+      _mm_shuffle_epi8(c.post_hi,
+                       _mm_and_si128(_mm_srli_epi32(x, 4), c.nibble)));
+  // L(x) = x ^ (x <<< 2) ^ (x <<< 10) ^ (x <<< 18) ^ (x <<< 24).
+  __m128i y = _mm_xor_si128(x, _mm_xor_si128(_mm_shuffle_epi8(x, c.rotl8),
+                                             _mm_shuffle_epi8(x, c.rotl16)));
+  y = _mm_or_si128(_mm_slli_epi32(y, 2), _mm_srli_epi32(y, 30));
+  return _mm_xor_si128(_mm_xor_si128(x, y), _mm_shuffle_epi8(x, c.rotl24));
+}
+
+// blocks <-> words of blocks, an involution.
+__attribute__((target("ssse3"))) inline void NiTranspose(__m128i x[4]) {
+  const __m128i t0 = _mm_unpacklo_epi32(x[0], x[1]);
+  const __m128i t1 = _mm_unpackhi_epi32(x[0], x[1]);
+  const __m128i t2 = _mm_unpacklo_epi32(x[2], x[3]);
+  const __m128i t3 = _mm_unpackhi_epi32(x[2], x[3]);
+  x[0] = _mm_unpacklo_epi64(t0, t2);
+  x[1] = _mm_unpackhi_epi64(t0, t2);
+  x[2] = _mm_unpacklo_epi64(t1, t3);
+  x[3] = _mm_unpackhi_epi64(t1, t3);
+}
+
+__attribute__((target("ssse3"))) inline NiConsts MakeNiConsts() {
+  return {Load128(kPreLo),        Load128(kPreHi),
+          Load128(kPostLo),       Load128(kPostHi),
+          Load128(kInvShiftRows), _mm_set1_epi8(0x0f),
+          Load128(kRotl8),        Load128(kRotl16),
+          Load128(kRotl24)};
+}
+
+// kNiBlocks blocks, in 2 groups of 4. `rks[g][r]` is round key r of the 4
+// blocks of group g, each in the lane of its block.
+__attribute__((target("aes,ssse3"))) inline void Sm4NiBatch(
+    const __m128i* const rks[kNiBlocks / 4], const NiConsts& c,
+    const uint8_t* in, uint8_t* out) {
+  constexpr size_t kGroups = kNiBlocks / 4;
+  const __m128i byte_swap = Load128(kByteSwap);
+  __m128i x[kGroups][4];
+#pragma GCC unroll 2
+  for (size_t g = 0; g < kGroups; ++g) {
+#pragma GCC unroll 4
+    for (size_t k = 0; k < 4; ++k) {
+      x[g][k] =
+          _mm_shuffle_epi8(Load128(in + (4 * g + k) * kBlockSize), byte_swap);
+    }
+    NiTranspose(x[g]);
+  }
+  // the loops are unrolled, so that x[][] is kept in registers at -O2.
+  for (size_t r = 0; r < 32; r += 4) {
+#pragma GCC unroll 4
+    for (size_t k = 0; k < 4; ++k) {
+#pragma GCC unroll 2
+      for (size_t g = 0; g < kGroups; ++g) {
+        const __m128i t = _mm_xor_si128(
+            _mm_xor_si128(x[g][(k + 1) % 4], x[g][(k + 2) % 4]),
+            _mm_xor_si128(x[g][(k + 3) % 4], rks[g][r + k]));
+        x[g][k] = _mm_xor_si128(x[g][k], NiT(t, c));
+      }
+    }
+  }
+#pragma GCC unroll 2
+  for (size_t g = 0; g < kGroups; ++g) {
+    // the output is the last 4 words in reverse.
+    __m128i y[4] = {x[g][3], x[g][2], x[g][1], x[g][0]};
+    NiTranspose(y);
+#pragma GCC unroll 4
+    for (size_t k = 0; k < 4; ++k) {
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(out + (4 * g + k) * kBlockSize),
+          _mm_shuffle_epi8(y[k], byte_swap));
+    }
+  }
+}
+
+// `n` is a multiple of kNiBlocks.
+__attribute__((target("aes,ssse3"))) void Sm4NiBlocks(
+    const Sm4RoundKeys& round_keys, const uint8_t* in, uint8_t* out,
+    size_t n) {
+  const NiConsts c = MakeNiConsts();
+  __m128i rk[32];
+  for (size_t r = 0; r < 32; ++r) {
+    rk[r] = _mm_set1_epi32(round_keys[r]);
+  }
+  const __m128i* const rks[] = {rk, rk};
+  for (size_t i = 0; i < n; i += kNiBlocks) {
+    Sm4NiBatch(rks, c, in + i * kBlockSize, out + i * kBlockSize);
+  }
+}
+
+// `n` is a multiple of kNiBlocks. The round keys of each 4 blocks are
+// transposed as the blocks are, 8 transposes per 32 rounds.
+__attribute__((target("aes,ssse3"))) void Sm4NiMultiKeyBlocks(
+    const Sm4RoundKeys* keys, const uint32_t* key_idx, const uint8_t* in,
+    uint8_t* out, size_t n) {
+  constexpr size_t kGroups = kNiBlocks / 4;
+  const NiConsts c = MakeNiConsts();
+  __m128i rk[kGroups][32];
+  const __m128i* const rks[] = {rk[0], rk[1]};
+  for (size_t i = 0; i < n; i += kNiBlocks) {
+    for (size_t g = 0; g < kGroups; ++g) {
+      const uint32_t* block_keys[4];
+      for (size_t k = 0; k < 4; ++k) {
+        block_keys[k] = keys[key_idx[i + 4 * g + k]].data();
+      }
+      for (size_t r = 0; r < 32; r += 4) {
+        __m128i* w = rk[g] + r;
+        for (size_t k = 0; k < 4; ++k) {
+          w[k] = Load128(reinterpret_cast<const uint8_t*>(block_keys[k] + r));
+        }
+        NiTranspose(w);
+      }
+    }
+    Sm4NiBatch(rks, c, in + i * kBlockSize, out + i * kBlockSize);
+  }
+}
+
+__attribute__((target("avx2"))) inline __m256i Load256(const uint8_t* p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+// a 16 byte table in both lanes.
+__attribute__((target("avx2"))) inline __m256i LoadTable(const uint8_t* p) {
+  return _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+struct VaesConsts {
+  __m256i pre_lo, pre_hi, post_lo, post_hi;
+  __m256i inv_shift_rows, nibble, rotl8, rotl16, rotl24;
+};
+
+__attribute__((target("vaes,avx2"))) inline __m256i VaesT(
+    __m256i x, const VaesConsts& c) {
+  x = _mm256_shuffle_epi8(x, c.inv_shift_rows);
+  x = _mm256_xor_si256(
+      _mm256_shuffle_epi8(c.pre_lo, _mm256_and_si256(x, c.nibble)),
+      _mm256_shuffle_epi8(c.pre_hi,
+                          _mm256_and_si256(_mm256_srli_epi32(x, 4), c.nibble)));
+  x = _mm256_aesenclast_epi128(x, _mm256_setzero_si256());
+  x = _mm256_xor_si256(
+      _mm256_shuffle_epi8(c.post_lo, _mm256_and_si256(x, c.nibble)),
+      _mm256_shuffle_epi8(c.post_hi,
+                          _mm256_and_si256(_mm256_srli_epi32(x, 4), c.nibble)));
+  __m256i y = _mm256_xor_si256(
+      x, _mm256_xor_si256(_mm256_shuffle_epi8(x, c.rotl8),
+                          _mm256_shuffle_epi8(x, c.rotl16)));
+  y = _mm256_or_si256(_mm256_slli_epi32(y, 2), _mm256_srli_epi32(y, 30));
+  return _mm256_xor_si256(_mm256_xor_si256(x, y),
+                          _mm256_shuffle_epi8(x, c.rotl24));
+}
+
+// per lane, so that the blocks of a lane go back where they came from.
+__attribute__((target("avx2"))) inline void VaesTranspose(__m256i x[4]) {
+  const __m256i t0 = _mm256_unpacklo_epi32(x[0], x[1]);
+  const __m256i t1 = _mm256_unpackhi_epi32(x[0], x[1]);
+  const __m256i t2 = _mm256_unpacklo_epi32(x[2], x[3]);
+  const __m256i t3 = _mm256_unpackhi_epi32(x[2], x[3]);
+  x[0] = _mm256_unpacklo_epi64(t0, t2);
+  x[1] = _mm256_unpackhi_epi64(t0, t2);
+  x[2] = _mm256_unpacklo_epi64(t1, t3);
+  x[3] = _mm256_unpackhi_epi64(t1, t3);
+}
+
+__attribute__((target("avx2"))) inline VaesConsts MakeVaesConsts() {
+  return {LoadTable(kPreLo),        LoadTable(kPreHi),
+          LoadTable(kPostLo),       LoadTable(kPostHi),
+          LoadTable(kInvShiftRows), _mm256_set1_epi8(0x0f),
+          LoadTable(kRotl8),        LoadTable(kRotl16),
+          LoadTable(kRotl24)};
+}
+
+// kVaesBlocks blocks, in 2 groups of 8, as Sm4NiBatch.
+__attribute__((target("vaes,avx2"))) inline void Sm4VaesBatch(
+    const __m256i* const rks[kVaesBlocks / 8], const VaesConsts& c,
+    const uint8_t* in, uint8_t* out) {
+  constexpr size_t kGroups = kVaesBlocks / 8;
+  const __m256i byte_swap = LoadTable(kByteSwap);
+  __m256i x[kGroups][4];
+#pragma GCC unroll 2
+  for (size_t g = 0; g < kGroups; ++g) {
+#pragma GCC unroll 4
+    for (size_t k = 0; k < 4; ++k) {
+      x[g][k] = _mm256_shuffle_epi8(Load256(in + (8 * g + 2 * k) * kBlockSize),
+                                    byte_swap);
+    }
+    VaesTranspose(x[g]);
+  }
+  for (size_t r = 0; r < 32; r += 4) {
+#pragma GCC unroll 4
+    for (size_t k = 0; k < 4; ++k) {
+#pragma GCC unroll 2
+      for (size_t g = 0; g < kGroups; ++g) {
+        const __m256i t = _mm256_xor_si256(
+            _mm256_xor_si256(x[g][(k + 1) % 4], x[g][(k + 2) % 4]),
+            _mm256_xor_si256(x[g][(k + 3) % 4], rks[g][r + k]));
+        x[g][k] = _mm256_xor_si256(x[g][k], VaesT(t, c));
+      }
+    }
+  }
+#pragma GCC unroll 2
+  for (size_t g = 0; g < kGroups; ++g) {
+    __m256i y[4] = {x[g][3], x[g][2], x[g][1], x[g][0]};
+    VaesTranspose(y);
+#pragma GCC unroll 4
+    for (size_t k = 0; k < 4; ++k) {
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(out + (8 * g + 2 * k) * kBlockSize),
+          _mm256_shuffle_epi8(y[k], byte_swap));
+    }
+  }
+}
+
+// `n` is a multiple of kVaesBlocks.
+__attribute__((target("vaes,avx2"))) void Sm4VaesBlocks(
+    const Sm4RoundKeys& round_keys, const uint8_t* in, uint8_t* out,
+    size_t n) {
+  const VaesConsts c = MakeVaesConsts();
+  __m256i rk[32];
+  for (size_t r = 0; r < 32; ++r) {
+    rk[r] = _mm256_set1_epi32(round_keys[r]);
+  }
+  const __m256i* const rks[] = {rk, rk};
+  for (size_t i = 0; i < n; i += kVaesBlocks) {
+    Sm4VaesBatch(rks, c, in + i * kBlockSize, out + i * kBlockSize);
+  }
+}
+
+// `n` is a multiple of kVaesBlocks, as Sm4NiMultiKeyBlocks. A lane holds
+// the even or the odd blocks of a group, so do their round keys.
+__attribute__((target("vaes,avx2"))) void Sm4VaesMultiKeyBlocks(
+    const Sm4RoundKeys* keys, const uint32_t* key_idx, const uint8_t* in,
+    uint8_t* out, size_t n) {
+  constexpr size_t kGroups = kVaesBlocks / 8;
+  const VaesConsts c = MakeVaesConsts();
+  __m256i rk[kGroups][32];
+  const __m256i* const rks[] = {rk[0], rk[1]};
+  for (size_t i = 0; i < n; i += kVaesBlocks) {
+    for (size_t g = 0; g < kGroups; ++g) {
+      const uint32_t* block_keys[8];
+      for (size_t k = 0; k < 8; ++k) {
+        block_keys[k] = keys[key_idx[i + 8 * g + k]].data();
+      }
+      for (size_t r = 0; r < 32; r += 4) {
+        __m256i* w = rk[g] + r;
+        for (size_t k = 0; k < 4; ++k) {
+          w[k] = _mm256_loadu2_m128i(
+              reinterpret_cast<const __m128i*>(block_keys[2 * k + 1] + r),
+              reinterpret_cast<const __m128i*>(block_keys[2 * k] + r));
+        }
+        VaesTranspose(w);
+      }
+    }
+    Sm4VaesBatch(rks, c, in + i * kBlockSize, out + i * kBlockSize);
+  }
+}
+#endif
+
+}  // namespace
+
+bool CpuSupportsSm4Ni() {
+#ifdef __x86_64
+  return kCPUSupportsSm4Ni;
+#else
+  return false;
+#endif
+}
+
+bool CpuSupportsSm4Vaes() {
+#ifdef __x86_64
+  return kCPUSupportsSm4Vaes;
+#else
+  return false;
+#endif
+}
+
+void Sm4KeySchedule(uint128_t key, Sm4RoundKeys* round_keys, bool decrypt) {
+  const auto* key_data = reinterpret_cast<const uint8_t*>(&key);
+  uint32_t k[4];
+  for (size_t i = 0; i < 4; ++i) {
+    k[i] = LoadBigEndian(key_data + 4 * i) ^ kFk[i];
+  }
+  for (size_t i = 0; i < 32; ++i) {
+    // CK_i, the bytes (4i + j) * 7 mod 256.
+    uint32_t ck = 0;
+    for (size_t j = 0; j < 4; ++j) {
+      ck = (ck << 8) | (((4 * i + j) * 7) & 0xff);
+    }
+    const uint32_t a = k[(i + 1) % 4] ^ k[(i + 2) % 4] ^ k[(i + 3) % 4] ^ ck;
+    const uint32_t b = (uint32_t{kSbox[a >> 24]} << 24) |
+                       (uint32_t{kSbox[(a >> 16) & 0xff]} << 16) |
+                       (uint32_t{kSbox[(a >> 8) & 0xff]} << 8) |
+                       uint32_t{kSbox[a & 0xff]};
+    k[i % 4] ^= b ^ Rotl(b, 13) ^ Rotl(b, 23);
+    (*round_keys)[decrypt ? 31 - i : i] = k[i % 4];
+  }
+}
+
+#ifdef __x86_64
+void Sm4EcbEncrypt(const Sm4RoundKeys& round_keys, const uint8_t* in,
+                   uint8_t* out, size_t nblock) {
+  YASL_ENFORCE(kCPUSupportsSm4Ni, "AES-NI is not supported");
+  size_t i = 0;
+  if (kCPUSupportsSm4Vaes) {
+    i = nblock / kVaesBlocks * kVaesBlocks;
+    Sm4VaesBlocks(round_keys, in, out, i);
+  }
+  const size_t n = (nblock - i) / kNiBlocks * kNiBlocks;
+  Sm4NiBlocks(round_keys, in + i * kBlockSize, out + i * kBlockSize, n);
+  i += n;
+  // the tail is padded on the stack.
+  if (i < nblock) {
+    uint8_t buf[kNiBlocks * kBlockSize] = {};
+    const size_t left = (nblock - i) * kBlockSize;
+    std::memcpy(buf, in + i * kBlockSize, left);
+    Sm4NiBlocks(round_keys, buf, buf, kNiBlocks);
+    std::memcpy(out + i * kBlockSize, buf, left);
+  }
+}
+
+void Sm4MultiKeyEcbEncrypt(const Sm4RoundKeys* keys, const uint32_t* key_idx,
+                           const uint8_t* in, uint8_t* out, size_t nblock) {
+  YASL_ENFORCE(kCPUSupportsSm4Ni, "AES-NI is not supported");
+  size_t n = 0;
+  if (kCPUSupportsSm4Vaes) {
+    n = nblock / kVaesBlocks * kVaesBlocks;
+    Sm4VaesMultiKeyBlocks(keys, key_idx, in, out, n);
+  }
+  const size_t m = (nblock - n) / kNiBlocks * kNiBlocks;
+  Sm4NiMultiKeyBlocks(keys, key_idx + n, in + n * kBlockSize,
+                      out + n * kBlockSize, m);
+  n += m;
+  // the tail is padded on the stack, by the key of its first block.
+  if (n < nblock) {
+    uint8_t buf[kNiBlocks * kBlockSize] = {};
+    uint32_t idx[kNiBlocks];
+    std::fill(idx, idx + kNiBlocks, key_idx[n]);
+    std::copy(key_idx + n, key_idx + nblock, idx);
+    const size_t left = (nblock - n) * kBlockSize;
+    std::memcpy(buf, in + n * kBlockSize, left);
+    Sm4NiMultiKeyBlocks(keys, idx, buf, buf, kNiBlocks);
+    std::memcpy(out + n * kBlockSize, buf, left);
+  }
+}
+
+void Sm4CtrEncrypt(const Sm4RoundKeys& round_keys, uint128_t counter,
+                   uint8_t* out, size_t nblock) {
+  // the counters are encrypted in place, a batch at a time so that they are
+  // still in cache.
+  constexpr size_t kBatchBlocks = 64;
+  for (size_t i = 0; i < nblock; i += kBatchBlocks) {
+    const size_t n = std::min(kBatchBlocks, nblock - i);
+    uint8_t* batch = out + i * kBlockSize;
+    for (size_t j = 0; j < n; ++j, ++counter) {
+      std::memcpy(batch + j * kBlockSize, &counter, kBlockSize);
+    }
+    Sm4EcbEncrypt(round_keys, batch, batch, n);
+  }
+}
+#else
+void Sm4EcbEncrypt(const Sm4RoundKeys&, const uint8_t*, uint8_t*, size_t) {
+  YASL_THROW("AES-NI is not supported");
+}
+
+void Sm4MultiKeyEcbEncrypt(const Sm4RoundKeys*, const uint32_t*,
+                           const uint8_t*, uint8_t*, size_t) {
+  YASL_THROW("AES-NI is not supported");
+}
+
+void Sm4CtrEncrypt(const Sm4RoundKeys&, uint128_t, uint8_t*, size_t) {
+  YASL_THROW("AES-NI is not supported");
+}
+#endif
+
+}  // namespace yasl
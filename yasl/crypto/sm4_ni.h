@@ -0,0 +1,62 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "yasl/base/int128.h"
+
+namespace yasl {
+
+// SM4 kernels on AES-NI. The S-box of SM4 is affine equivalent to that of
+// AES, so it is computed by aesenclast between two affine maps, each a pair
+// of pshufb nibble lookups, on 16 bytes per instruction. The blocks are
+// sliced by words, 8 blocks at a time, or 16 on VAES with AVX2. They are bit
+// compatible with SM4_ECB of SymmetricCrypto, uint128_t being loaded and
+// stored as its little endian bytes.
+
+using Sm4RoundKeys = std::array<uint32_t, 32>;
+
+// Whether the cpu runs the kernels below, false on other archs.
+bool CpuSupportsSm4Ni();
+// Whether the kernels run 16 blocks at a time, implies CpuSupportsSm4Ni().
+bool CpuSupportsSm4Vaes();
+
+// Expands `key` into the 32 round keys of SM4, reversed for `decrypt`.
+// Portable.
+void Sm4KeySchedule(uint128_t key, Sm4RoundKeys* round_keys,
+                    bool decrypt = false);
+
+// Encrypts, or decrypts by the reversed round keys, the `nblock` blocks of
+// `in` into `out`, which may be the same. No alignment is needed.
+void Sm4EcbEncrypt(const Sm4RoundKeys& round_keys, const uint8_t* in,
+                   uint8_t* out, size_t nblock);
+
+// Fixed key CTR keystream, the `nblock` blocks of `out` are SM4_key(counter),
+// SM4_key(counter + 1), ... `out` needs no alignment.
+void Sm4CtrEncrypt(const Sm4RoundKeys& round_keys, uint128_t counter,
+                   uint8_t* out, size_t nblock);
+
+// ECB by many keys, block i of `in` is encrypted, or decrypted by reversed
+// round keys, into block i of `out` by `keys[key_idx[i]]`. The round keys
+// are transposed into the lanes as the blocks are, so that blocks of
+// different keys run at about the speed of a single key. `in` and `out` may
+// be the same.
+void Sm4MultiKeyEcbEncrypt(const Sm4RoundKeys* keys, const uint32_t* key_idx,
+                           const uint8_t* in, uint8_t* out, size_t nblock);
+
+}  // namespace yasl
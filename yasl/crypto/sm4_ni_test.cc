@@ -0,0 +1,126 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/crypto/sm4_ni.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "openssl/evp.h"
+
+namespace yasl {
+
+namespace {
+
+constexpr uint128_t kKey = 0x0123456789abcdefULL;
+
+// SM4 ECB of openssl.
+std::vector<uint8_t> OpensslEncrypt(uint128_t key,
+                                    const std::vector<uint8_t>& in) {
+  EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+  EXPECT_TRUE(EVP_EncryptInit_ex(ctx, EVP_sm4_ecb(), nullptr,
+                                 reinterpret_cast<const uint8_t*>(&key),
+                                 nullptr));
+  EVP_CIPHER_CTX_set_padding(ctx, 0);
+  std::vector<uint8_t> out(in.size());
+  int outlen;
+  EXPECT_TRUE(
+      EVP_EncryptUpdate(ctx, out.data(), &outlen, in.data(), in.size()));
+  EVP_CIPHER_CTX_free(ctx);
+  return out;
+}
+
+std::vector<uint8_t> RandomBytes(size_t n) {
+  std::mt19937 rng(n);
+  std::vector<uint8_t> bytes(n);
+  for (auto& b : bytes) {
+    b = static_cast<uint8_t>(rng());
+  }
+  return bytes;
+}
+
+}  // namespace
+
+TEST(Sm4NiTest, StandardVector) {
+  if (!CpuSupportsSm4Ni()) {
+    GTEST_SKIP() << "AES-NI is not supported";
+  }
+  // GB/T 32907-2016 A.1, the key is the plaintext.
+  const std::vector<uint8_t> plaintext = {0x01, 0x23, 0x45, 0x67, 0x89, 0xab,
+                                          0xcd, 0xef, 0xfe, 0xdc, 0xba, 0x98,
+                                          0x76, 0x54, 0x32, 0x10};
+  const std::vector<uint8_t> ciphertext = {0x68, 0x1e, 0xdf, 0x34, 0xd2, 0x06,
+                                           0x96, 0x5e, 0x86, 0xb3, 0xe9, 0x4f,
+                                           0x53, 0x6e, 0x42, 0x46};
+  uint128_t key;
+  std::memcpy(&key, plaintext.data(), sizeof(key));
+  Sm4RoundKeys round_keys;
+  Sm4KeySchedule(key, &round_keys);
+  std::vector<uint8_t> out(16);
+  Sm4EcbEncrypt(round_keys, plaintext.data(), out.data(), 1);
+  EXPECT_EQ(out, ciphertext);
+
+  Sm4KeySchedule(key, &round_keys, true);
+  Sm4EcbEncrypt(round_keys, out.data(), out.data(), 1);
+  EXPECT_EQ(out, plaintext);
+}
+
+TEST(Sm4NiTest, EcbSameAsOpenssl) {
+  if (!CpuSupportsSm4Ni()) {
+    GTEST_SKIP() << "AES-NI is not supported";
+  }
+  Sm4RoundKeys enc_keys;
+  Sm4RoundKeys dec_keys;
+  Sm4KeySchedule(kKey, &enc_keys);
+  Sm4KeySchedule(kKey, &dec_keys, true);
+  for (size_t n : {0, 1, 7, 8, 9, 15, 16, 17, 24, 100, 1000}) {
+    const auto plaintext = RandomBytes(n * 16);
+    const auto expected = OpensslEncrypt(kKey, plaintext);
+    // unaligned output.
+    std::vector<uint8_t> out(n * 16 + 1);
+    Sm4EcbEncrypt(enc_keys, plaintext.data(), out.data() + 1, n);
+    EXPECT_EQ(std::vector<uint8_t>(out.begin() + 1, out.end()), expected)
+        << "n=" << n;
+
+    // in place.
+    std::vector<uint8_t> decrypted = expected;
+    Sm4EcbEncrypt(dec_keys, decrypted.data(), decrypted.data(), n);
+    EXPECT_EQ(decrypted, plaintext) << "n=" << n;
+  }
+}
+
+TEST(Sm4NiTest, CtrSameAsOpenssl) {
+  if (!CpuSupportsSm4Ni()) {
+    GTEST_SKIP() << "AES-NI is not supported";
+  }
+  Sm4RoundKeys round_keys;
+  Sm4KeySchedule(kKey, &round_keys);
+  for (uint128_t counter : {uint128_t(0), MakeUint128(7, ~uint64_t(0) - 20)}) {
+    for (size_t n : {0, 1, 9, 33, 200}) {
+      std::vector<uint128_t> ctrs(n);
+      for (size_t i = 0; i < n; ++i) {
+        ctrs[i] = counter + i;
+      }
+      std::vector<uint8_t> ctr_bytes(n * 16);
+      std::memcpy(ctr_bytes.data(), ctrs.data(), ctr_bytes.size());
+      std::vector<uint8_t> out(n * 16);
+      Sm4CtrEncrypt(round_keys, counter, out.data(), n);
+      EXPECT_EQ(out, OpensslEncrypt(kKey, ctr_bytes)) << "n=" << n;
+    }
+  }
+}
+
+}  // namespace yasl
@@ -16,7 +16,6 @@
 #include "yasl/crypto/ssl_hash.h"
 
 #include "yasl/base/exception.h"
-#include "yasl/utils/scope_guard.h"
 
 namespace yasl::crypto {
 
@@ -42,19 +41,32 @@ const EVP_MD* CreateEvpMD(HashAlgorithm hash_algo_) {
 
 SslHash::SslHash(HashAlgorithm hash_algo)
     : hash_algo_(hash_algo),
-      digest_size_(EVP_MD_size(CreateEvpMD(hash_algo))),
-      context_(CheckNotNull(EVP_MD_CTX_new())) {
+      digest_size_(EVP_MD_size(CreateEvpMD(hash_algo))) {
+  if (GetCryptoBackend() == CryptoBackend::kIppCrypto &&
+      IppHash::Supports(hash_algo_)) {
+    ipp_hash_ = std::make_unique<IppHash>(hash_algo_);
+    return;
+  }
+  context_ = CheckNotNull(EVP_MD_CTX_new());
+  snapshot_ = CheckNotNull(EVP_MD_CTX_new());
   Reset();
 }
 
-SslHash::~SslHash() { EVP_MD_CTX_free(context_); }
+SslHash::~SslHash() {
+  EVP_MD_CTX_free(context_);
+  EVP_MD_CTX_free(snapshot_);
+}
 
 HashAlgorithm SslHash::GetHashAlgorithm() const { return hash_algo_; }
 
 size_t SslHash::DigestSize() const { return digest_size_; }
 
 SslHash& SslHash::Reset() {
-  YASL_ENFORCE_EQ(EVP_MD_CTX_reset(context_), 1);
+  if (ipp_hash_) {
+    ipp_hash_->Reset();
+    return *this;
+  }
+  // the digest state of the same md is reinitialized in place.
   int res = 0;
   const EVP_MD* md = CreateEvpMD(hash_algo_);
   res = EVP_DigestInit_ex(context_, md, nullptr);
@@ -64,26 +76,34 @@ SslHash& SslHash::Reset() {
 }
 
 SslHash& SslHash::Update(ByteContainerView data) {
+  if (ipp_hash_) {
+    ipp_hash_->Update(data);
+    return *this;
+  }
   YASL_ENFORCE_EQ(EVP_DigestUpdate(context_, data.data(), data.size()), 1);
   return *this;
 }
 
 std::vector<uint8_t> SslHash::CumulativeHash() const {
+  std::vector<uint8_t> digest(DigestSize());
+  CumulativeHash(absl::MakeSpan(digest));
+  return digest;
+}
+
+void SslHash::CumulativeHash(absl::Span<uint8_t> digest) const {
+  YASL_ENFORCE_EQ(digest.size(), DigestSize());
+  if (ipp_hash_) {
+    ipp_hash_->CumulativeHash(digest);
+    return;
+  }
   // Do not finalize the internally stored hash context. Instead, finalize a
   // copy of the current context so that the current context can be updated in
-  // future calls to Update.
-  EVP_MD_CTX* context_snapshot = EVP_MD_CTX_new();
-  YASL_ENFORCE(context_snapshot != nullptr);
-  ON_SCOPE_EXIT([&] { EVP_MD_CTX_free(context_snapshot); });
-  EVP_MD_CTX_init(context_snapshot);
-  YASL_ENFORCE_EQ(EVP_MD_CTX_copy_ex(context_snapshot, context_), 1);
-  std::vector<uint8_t> digest(DigestSize());
+  // future calls to Update. The copy reuses the digest state of snapshot_.
+  YASL_ENFORCE_EQ(EVP_MD_CTX_copy_ex(snapshot_, context_), 1);
   unsigned int digest_len;
-  YASL_ENFORCE_EQ(
-      EVP_DigestFinal_ex(context_snapshot, digest.data(), &digest_len), 1);
+  YASL_ENFORCE_EQ(EVP_DigestFinal_ex(snapshot_, digest.data(), &digest_len),
+                  1);
   YASL_ENFORCE_EQ(digest_len, DigestSize());
-
-  return digest;
 }
 
 }  // namespace yasl::crypto
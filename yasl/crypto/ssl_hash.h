@@ -15,14 +15,18 @@
 
 #pragma once
 
+#include <memory>
+
 #include "openssl/evp.h"
 
 #include "yasl/base/byte_container_view.h"
 #include "yasl/crypto/hash_interface.h"
+#include "yasl/crypto/ipp_crypto.h"
 
 namespace yasl::crypto {
 
-// Abstract hash implements HashInterface.
+// Abstract hash implements HashInterface. SHA-256 and SM3 run on IPP-Crypto
+// if that is the CryptoBackend.
 class SslHash : public HashInterface {
  public:
   explicit SslHash(HashAlgorithm hash_algo);
@@ -34,11 +38,16 @@ class SslHash : public HashInterface {
   SslHash& Reset() override;
   SslHash& Update(ByteContainerView data) override;
   std::vector<uint8_t> CumulativeHash() const override;
+  void CumulativeHash(absl::Span<uint8_t> digest) const override;
 
  private:
   const HashAlgorithm hash_algo_;
   const size_t digest_size_;
-  EVP_MD_CTX* context_;
+  // nullptr on IPP-Crypto.
+  EVP_MD_CTX* context_ = nullptr;
+  // finalizes copies of context_, reused so that copying does not allocate.
+  EVP_MD_CTX* snapshot_ = nullptr;
+  std::unique_ptr<IppHash> ipp_hash_;
 };
 
 // Sm3Hash implements HashInterface for the SM3 hash function.
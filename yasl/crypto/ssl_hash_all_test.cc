@@ -132,4 +132,22 @@ TYPED_TEST(SslHashTest, MultipleUpdates) {
             this->Data().result2);
 }
 
+// The span overload keeps the state too, whatever it finalized before.
+TYPED_TEST(SslHashTest, CumulativeHashToSpan) {
+  TypeParam hash;
+  std::vector<uint8_t> digest(hash.DigestSize());
+  hash.Update(this->Data().vector1).CumulativeHash(absl::MakeSpan(digest));
+  EXPECT_EQ(absl::BytesToHexString(
+                absl::string_view((const char*)digest.data(), digest.size())),
+            this->Data().result1);
+
+  hash.Update(this->Data().suffix).CumulativeHash(absl::MakeSpan(digest));
+  EXPECT_EQ(absl::BytesToHexString(
+                absl::string_view((const char*)digest.data(), digest.size())),
+            this->Data().result2);
+
+  EXPECT_THROW(hash.CumulativeHash(absl::MakeSpan(digest).subspan(1)),
+               ::yasl::EnforceNotMet);
+}
+
 }  // namespace yasl::crypto
@@ -15,6 +15,8 @@
 
 #include "yasl/crypto/symmetric_crypto.h"
 
+#include <limits>
+
 #include "openssl/aes.h"
 #include "openssl/crypto.h"
 #include "openssl/err.h"
@@ -88,22 +90,89 @@ uint128_t CopyDataAsUint128(const uint8_t* data) {
   return ret;
 }
 
+crypto::IppBlockCipher::Algorithm GetIppAlgorithm(
+    SymmetricCrypto::CryptoType type) {
+  switch (type) {
+    case SymmetricCrypto::CryptoType::AES128_ECB:
+    case SymmetricCrypto::CryptoType::AES128_CBC:
+    case SymmetricCrypto::CryptoType::AES128_CTR:
+      return crypto::IppBlockCipher::Algorithm::kAes128;
+    case SymmetricCrypto::CryptoType::SM4_ECB:
+    case SymmetricCrypto::CryptoType::SM4_CBC:
+    case SymmetricCrypto::CryptoType::SM4_CTR:
+      return crypto::IppBlockCipher::Algorithm::kSm4;
+    default:
+      YASL_THROW("unknown crypto type: {}", static_cast<int>(type));
+  }
+}
+
+crypto::IppBlockCipher::Mode GetIppMode(SymmetricCrypto::CryptoType type) {
+  switch (type) {
+    case SymmetricCrypto::CryptoType::AES128_ECB:
+    case SymmetricCrypto::CryptoType::SM4_ECB:
+      return crypto::IppBlockCipher::Mode::kEcb;
+    case SymmetricCrypto::CryptoType::AES128_CBC:
+    case SymmetricCrypto::CryptoType::SM4_CBC:
+      return crypto::IppBlockCipher::Mode::kCbc;
+    case SymmetricCrypto::CryptoType::AES128_CTR:
+    case SymmetricCrypto::CryptoType::SM4_CTR:
+      return crypto::IppBlockCipher::Mode::kCtr;
+    default:
+      YASL_THROW("unknown crypto type: {}", static_cast<int>(type));
+  }
+}
+
+uint128_t ByteSwap(uint128_t x) {
+  return MakeUint128(__builtin_bswap64(static_cast<uint64_t>(x)),
+                     __builtin_bswap64(static_cast<uint64_t>(x >> 64)));
+}
+
+// SM4_CTR as openssl, the counter blocks are big endian from `iv`.
+void Sm4NiCtr(const Sm4RoundKeys& round_keys, uint128_t iv,
+              absl::Span<const uint8_t> in, absl::Span<uint8_t> out) {
+  constexpr size_t kBlockSize = SymmetricCrypto::BlockSize();
+  uint128_t counter = ByteSwap(iv);
+  uint8_t keystream[kBatchSize];
+  for (size_t i = 0; i < in.size(); i += kBatchSize) {
+    const size_t n = std::min(kBatchSize, in.size() - i);
+    const size_t nblock = (n + kBlockSize - 1) / kBlockSize;
+    for (size_t j = 0; j < nblock; ++j, ++counter) {
+      const uint128_t block = ByteSwap(counter);
+      std::memcpy(keystream + j * kBlockSize, &block, kBlockSize);
+    }
+    Sm4EcbEncrypt(round_keys, keystream, keystream, nblock);
+    for (size_t j = 0; j < n; ++j) {
+      out[i + j] = in[i + j] ^ keystream[j];
+    }
+  }
+}
+
 }  // namespace
 
 SymmetricCrypto::SymmetricCrypto(CryptoType type, uint128_t key, uint128_t iv)
     : type_(type), key_(key), initial_vector_(iv) {
+  if (crypto::GetCryptoBackend() == crypto::CryptoBackend::kIppCrypto) {
+    ipp_cipher_ = std::make_unique<crypto::IppBlockCipher>(
+        GetIppAlgorithm(type_), GetIppMode(type_),
+        ByteContainerView(&key_, sizeof(key_)));
+    return;
+  }
+  if ((type_ == SymmetricCrypto::CryptoType::SM4_ECB ||
+       type_ == SymmetricCrypto::CryptoType::SM4_CTR) &&
+      CpuSupportsSm4Ni()) {
+    use_sm4_ni_ = true;
+    Sm4KeySchedule(key_, &sm4_enc_keys_);
+    Sm4KeySchedule(key_, &sm4_dec_keys_, true);
+    return;
+  }
   enc_ctx_ = CreateEVPCipherCtx(type_, key_, initial_vector_, 1);
   dec_ctx_ = CreateEVPCipherCtx(type_, key_, initial_vector_, 0);
 }
 
 SymmetricCrypto::SymmetricCrypto(CryptoType type, ByteContainerView key,
                                  ByteContainerView iv)
-    : type_(type),
-      key_(CopyDataAsUint128(key.data())),
-      initial_vector_(CopyDataAsUint128(iv.data())) {
-  enc_ctx_ = CreateEVPCipherCtx(type_, key_, initial_vector_, 1);
-  dec_ctx_ = CreateEVPCipherCtx(type_, key_, initial_vector_, 0);
-}
+    : SymmetricCrypto(type, CopyDataAsUint128(key.data()),
+                      CopyDataAsUint128(iv.data())) {}
 
 void SymmetricCrypto::Decrypt(absl::Span<const uint8_t> ciphertext,
                               absl::Span<uint8_t> plaintext) const {
@@ -115,6 +184,22 @@ void SymmetricCrypto::Decrypt(absl::Span<const uint8_t> ciphertext,
   }
   YASL_ENFORCE(plaintext.size() == ciphertext.size());
 
+  if (ipp_cipher_) {
+    const ByteContainerView iv(&initial_vector_, sizeof(initial_vector_));
+    ipp_cipher_->Decrypt(iv, ciphertext, plaintext);
+    return;
+  }
+
+  if (use_sm4_ni_) {
+    if (type_ == SymmetricCrypto::CryptoType::SM4_ECB) {
+      Sm4EcbEncrypt(sm4_dec_keys_, ciphertext.data(), plaintext.data(),
+                    ciphertext.size() / BlockSize());
+    } else {
+      Sm4NiCtr(sm4_enc_keys_, initial_vector_, ciphertext, plaintext);
+    }
+    return;
+  }
+
   EVP_CIPHER_CTX* ctx;
   if ((type_ == SymmetricCrypto::CryptoType::AES128_ECB) ||
       (type_ == SymmetricCrypto::CryptoType::SM4_ECB)) {
@@ -157,6 +242,22 @@ void SymmetricCrypto::Encrypt(absl::Span<const uint8_t> plaintext,
   }
   YASL_ENFORCE(plaintext.size() == ciphertext.size());
 
+  if (ipp_cipher_) {
+    const ByteContainerView iv(&initial_vector_, sizeof(initial_vector_));
+    ipp_cipher_->Encrypt(iv, plaintext, ciphertext);
+    return;
+  }
+
+  if (use_sm4_ni_) {
+    if (type_ == SymmetricCrypto::CryptoType::SM4_ECB) {
+      Sm4EcbEncrypt(sm4_enc_keys_, plaintext.data(), ciphertext.data(),
+                    plaintext.size() / BlockSize());
+    } else {
+      Sm4NiCtr(sm4_enc_keys_, initial_vector_, plaintext, ciphertext);
+    }
+    return;
+  }
+
   EVP_CIPHER_CTX* ctx;
   if ((type_ == SymmetricCrypto::CryptoType::AES128_ECB) ||
       (type_ == SymmetricCrypto::CryptoType::SM4_ECB)) {
@@ -204,6 +305,204 @@ uint128_t SymmetricCrypto::Decrypt(uint128_t input) const {
   return ret;
 }
 
+MultiKeySymmetricCrypto::MultiKeySymmetricCrypto(
+    SymmetricCrypto::CryptoType type, absl::Span<const uint128_t> keys)
+    : type_(type) {
+  YASL_ENFORCE(type_ == SymmetricCrypto::CryptoType::AES128_ECB ||
+                   type_ == SymmetricCrypto::CryptoType::SM4_ECB,
+               "multi key crypto supports ECB only, type={}",
+               static_cast<int>(type_));
+  use_aes_ni_ =
+      type_ == SymmetricCrypto::CryptoType::AES128_ECB && CpuSupportsAesNi();
+  use_sm4_ni_ =
+      type_ == SymmetricCrypto::CryptoType::SM4_ECB && CpuSupportsSm4Ni();
+  for (uint128_t key : keys) {
+    AddKey(key);
+  }
+}
+
+uint32_t MultiKeySymmetricCrypto::AddKey(uint128_t key) {
+  YASL_ENFORCE(num_keys_ < std::numeric_limits<uint32_t>::max(),
+               "too many keys");
+  if (use_aes_ni_) {
+    AesNiKeySchedule(key, &aes_enc_keys_.emplace_back());
+    AesNiDecryptKeySchedule(aes_enc_keys_.back(),
+                            &aes_dec_keys_.emplace_back());
+  } else if (use_sm4_ni_) {
+    Sm4KeySchedule(key, &sm4_enc_keys_.emplace_back());
+    Sm4KeySchedule(key, &sm4_dec_keys_.emplace_back(), true);
+  } else {
+    ciphers_.push_back(std::make_unique<SymmetricCrypto>(type_, key));
+  }
+  return static_cast<uint32_t>(num_keys_++);
+}
+
+void MultiKeySymmetricCrypto::Run(bool decrypt,
+                                  absl::Span<const uint32_t> key_idx,
+                                  absl::Span<const uint8_t> in,
+                                  absl::Span<uint8_t> out) const {
+  constexpr size_t kBlockSize = SymmetricCrypto::BlockSize();
+  const size_t nblock = key_idx.size();
+  YASL_ENFORCE(in.size() == nblock * kBlockSize && out.size() == in.size(),
+               "sizes {} and {} mismatch {} blocks", in.size(), out.size(),
+               nblock);
+  for (uint32_t idx : key_idx) {
+    YASL_ENFORCE(idx < num_keys_, "key index {} out of range {}", idx,
+                 num_keys_);
+  }
+
+  if (use_aes_ni_) {
+    if (decrypt) {
+      AesNiMultiKeyDecrypt(aes_dec_keys_.data(), key_idx.data(), in.data(),
+                           out.data(), nblock);
+    } else {
+      AesNiMultiKeyEncrypt(aes_enc_keys_.data(), key_idx.data(), in.data(),
+                           out.data(), nblock);
+    }
+    return;
+  }
+  if (use_sm4_ni_) {
+    Sm4MultiKeyEcbEncrypt(decrypt ? sm4_dec_keys_.data()
+                                  : sm4_enc_keys_.data(),
+                          key_idx.data(), in.data(), out.data(), nblock);
+    return;
+  }
+  // the runs of a key go at once.
+  for (size_t i = 0; i < nblock;) {
+    size_t j = i + 1;
+    while (j < nblock && key_idx[j] == key_idx[i]) {
+      ++j;
+    }
+    const auto& cipher = ciphers_[key_idx[i]];
+    const auto src = in.subspan(i * kBlockSize, (j - i) * kBlockSize);
+    const auto dst = out.subspan(i * kBlockSize, (j - i) * kBlockSize);
+    if (decrypt) {
+      cipher->Decrypt(src, dst);
+    } else {
+      cipher->Encrypt(src, dst);
+    }
+    i = j;
+  }
+}
+
+void MultiKeySymmetricCrypto::Encrypt(absl::Span<const uint32_t> key_idx,
+                                      absl::Span<const uint8_t> plaintext,
+                                      absl::Span<uint8_t> ciphertext) const {
+  Run(false, key_idx, plaintext, ciphertext);
+}
+
+void MultiKeySymmetricCrypto::Decrypt(absl::Span<const uint32_t> key_idx,
+                                      absl::Span<const uint8_t> ciphertext,
+                                      absl::Span<uint8_t> plaintext) const {
+  Run(true, key_idx, ciphertext, plaintext);
+}
+
+void MultiKeySymmetricCrypto::Encrypt(absl::Span<const uint32_t> key_idx,
+                                      absl::Span<const uint128_t> plaintext,
+                                      absl::Span<uint128_t> ciphertext) const {
+  Run(false, key_idx,
+      absl::MakeConstSpan(reinterpret_cast<const uint8_t*>(plaintext.data()),
+                          plaintext.size() * sizeof(uint128_t)),
+      absl::MakeSpan(reinterpret_cast<uint8_t*>(ciphertext.data()),
+                     ciphertext.size() * sizeof(uint128_t)));
+}
+
+void MultiKeySymmetricCrypto::Decrypt(absl::Span<const uint32_t> key_idx,
+                                      absl::Span<const uint128_t> ciphertext,
+                                      absl::Span<uint128_t> plaintext) const {
+  Run(true, key_idx,
+      absl::MakeConstSpan(reinterpret_cast<const uint8_t*>(ciphertext.data()),
+                          ciphertext.size() * sizeof(uint128_t)),
+      absl::MakeSpan(reinterpret_cast<uint8_t*>(plaintext.data()),
+                     plaintext.size() * sizeof(uint128_t)));
+}
+
+uint128_t MultiKeySymmetricCrypto::Encrypt(uint32_t key_idx,
+                                           uint128_t input) const {
+  uint128_t ret;
+  Encrypt(absl::MakeConstSpan(&key_idx, 1), absl::MakeConstSpan(&input, 1),
+          absl::MakeSpan(&ret, 1));
+  return ret;
+}
+
+uint128_t MultiKeySymmetricCrypto::Decrypt(uint32_t key_idx,
+                                           uint128_t input) const {
+  uint128_t ret;
+  Decrypt(absl::MakeConstSpan(&key_idx, 1), absl::MakeConstSpan(&input, 1),
+          absl::MakeSpan(&ret, 1));
+  return ret;
+}
+
+CipherPrg::CipherPrg(SymmetricCrypto::CryptoType type, uint128_t seed,
+                     uint128_t iv)
+    : type_(type), seed_(seed), iv_(iv) {
+  if (type == SymmetricCrypto::CryptoType::AES128_ECB && CpuSupportsAesNi()) {
+    use_aes_ni_ = true;
+    AesNiKeySchedule(seed, &round_keys_);
+    return;
+  }
+  if (type == SymmetricCrypto::CryptoType::SM4_ECB && CpuSupportsSm4Ni()) {
+    use_sm4_ni_ = true;
+    Sm4KeySchedule(seed, &sm4_round_keys_);
+    return;
+  }
+  ctx_ = CreateEVPCipherCtx(type, seed, iv, 1);
+}
+
+uint128_t CipherPrg::Fill(uint128_t count, absl::Span<uint8_t> out) {
+  constexpr size_t kBlockSize = SymmetricCrypto::BlockSize();
+  if (use_aes_ni_ || use_sm4_ni_) {
+    auto kernel = [&](uint128_t counter, uint8_t* data, size_t nblock) {
+      if (use_aes_ni_) {
+        AesCtrEncrypt(round_keys_, counter, data, nblock);
+      } else {
+        Sm4CtrEncrypt(sm4_round_keys_, counter, data, nblock);
+      }
+    };
+    const size_t nfull = out.size() / kBlockSize;
+    kernel(count, out.data(), nfull);
+    if (const size_t left = out.size() % kBlockSize; left != 0) {
+      uint8_t block[kBlockSize];
+      kernel(count + nfull, block, 1);
+      std::memcpy(out.data() + nfull * kBlockSize, block, left);
+    }
+    return count + nfull + (out.size() % kBlockSize != 0 ? 1 : 0);
+  }
+  if ((type_ != SymmetricCrypto::CryptoType::AES128_ECB) &&
+      (type_ != SymmetricCrypto::CryptoType::SM4_ECB)) {
+    // restart the chain or the keystream, the key schedule is kept.
+    const auto* iv_data = reinterpret_cast<const uint8_t*>(&iv_);
+    YASL_ENFORCE(
+        EVP_CipherInit_ex(ctx_, nullptr, nullptr, nullptr, iv_data, 1));
+  }
+
+  uint128_t counter = count;
+  auto encrypt = [&](uint8_t* data, size_t nblock) {
+    for (size_t i = 0; i < nblock; ++i, ++counter) {
+      std::memcpy(data + i * kBlockSize, &counter, kBlockSize);
+    }
+    int outlen;
+    const int rc =
+        EVP_CipherUpdate(ctx_, data, &outlen, data, nblock * kBlockSize);
+    YASL_ENFORCE(rc, "Fail to encrypt, rc={}", rc);
+  };
+
+  // whole blocks in place, kBatchSize bytes at a time so that the counters
+  // are still in cache when encrypted.
+  const size_t nfull = out.size() / kBlockSize;
+  constexpr size_t kBatchBlocks = kBatchSize / kBlockSize;
+  for (size_t i = 0; i < nfull; i += kBatchBlocks) {
+    encrypt(out.data() + i * kBlockSize, std::min(kBatchBlocks, nfull - i));
+  }
+  // the partial block is encrypted on the stack.
+  if (const size_t left = out.size() % kBlockSize; left != 0) {
+    uint8_t block[kBlockSize];
+    encrypt(block, 1);
+    std::memcpy(out.data() + nfull * kBlockSize, block, left);
+  }
+  return counter;
+}
+
 void SymmetricCrypto::Encrypt(absl::Span<const uint128_t> plaintext,
                               absl::Span<uint128_t> ciphertext) const {
   auto in = absl::Span<const uint8_t>(
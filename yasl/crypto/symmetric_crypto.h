@@ -16,6 +16,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <numeric>
 #include <string>
 #include <vector>
@@ -25,20 +26,15 @@
 
 #include "yasl/base/byte_container_view.h"
 #include "yasl/base/int128.h"
+#include "yasl/crypto/aes_ni.h"
+#include "yasl/crypto/ipp_crypto.h"
+#include "yasl/crypto/sm4_ni.h"
 
 namespace yasl {
-namespace internal {
 
-inline std::vector<uint128_t> EcbMakeContentBlocks(uint128_t count,
-                                                   int nblocks) {
-  std::vector<uint128_t> ret(nblocks);
-  std::iota(ret.begin(), ret.end(), count);
-  return ret;
-}
-
-}  // namespace internal
-
-// This class implements Symmetric- crypto.
+// This class implements Symmetric- crypto. It runs on IPP-Crypto if that is
+// the crypto::CryptoBackend, otherwise SM4_ECB and SM4_CTR run on the SM4
+// kernels of sm4_ni.h where available.
 class SymmetricCrypto {
  public:
   enum class CryptoType : int {
@@ -90,8 +86,15 @@ class SymmetricCrypto {
   // Initial vector cbc mode need
   const uint128_t initial_vector_;
 
-  EVP_CIPHER_CTX* enc_ctx_;
-  EVP_CIPHER_CTX* dec_ctx_;
+  // nullptr on the SM4 kernels and on IPP-Crypto.
+  EVP_CIPHER_CTX* enc_ctx_ = nullptr;
+  EVP_CIPHER_CTX* dec_ctx_ = nullptr;
+
+  std::unique_ptr<crypto::IppBlockCipher> ipp_cipher_;
+
+  bool use_sm4_ni_ = false;
+  Sm4RoundKeys sm4_enc_keys_;
+  Sm4RoundKeys sm4_dec_keys_;
 };
 
 class AesCbcCrypto : public SymmetricCrypto {
@@ -106,30 +109,116 @@ class Sm4CbcCrypto : public SymmetricCrypto {
       : SymmetricCrypto(SymmetricCrypto::CryptoType::SM4_CBC, key, iv) {}
 };
 
+// MultiKeySymmetricCrypto holds the key schedules of many AES128_ECB or
+// SM4_ECB keys in a flat array, and runs batches of blocks each by a key of
+// its own, e.g. a key per row or per user, where a SymmetricCrypto per key
+// would cost more to set up than its few blocks cost to encrypt. On AES-NI
+// the blocks of different keys are interleaved as those of a single key,
+// see AesNiMultiKeyEncrypt and Sm4MultiKeyEcbEncrypt, elsewhere it falls
+// back to a SymmetricCrypto per key. Encrypt and Decrypt are thread safe,
+// AddKey is not.
+class MultiKeySymmetricCrypto {
+ public:
+  explicit MultiKeySymmetricCrypto(SymmetricCrypto::CryptoType type,
+                                   absl::Span<const uint128_t> keys = {});
+
+  // Appends `key`, returns its index.
+  uint32_t AddKey(uint128_t key);
+
+  size_t NumKeys() const { return num_keys_; }
+
+  // Block i of `plaintext` is encrypted into block i of `ciphertext` by the
+  // key of index `key_idx[i]`. Each span holds `key_idx.size()` blocks.
+  void Encrypt(absl::Span<const uint32_t> key_idx,
+               absl::Span<const uint8_t> plaintext,
+               absl::Span<uint8_t> ciphertext) const;
+  void Decrypt(absl::Span<const uint32_t> key_idx,
+               absl::Span<const uint8_t> ciphertext,
+               absl::Span<uint8_t> plaintext) const;
+
+  // Wrapper for span<uint128>.
+  void Encrypt(absl::Span<const uint32_t> key_idx,
+               absl::Span<const uint128_t> plaintext,
+               absl::Span<uint128_t> ciphertext) const;
+  void Decrypt(absl::Span<const uint32_t> key_idx,
+               absl::Span<const uint128_t> ciphertext,
+               absl::Span<uint128_t> plaintext) const;
+
+  // Wrapper for uint128.
+  uint128_t Encrypt(uint32_t key_idx, uint128_t input) const;
+  uint128_t Decrypt(uint32_t key_idx, uint128_t input) const;
+
+ private:
+  void Run(bool decrypt, absl::Span<const uint32_t> key_idx,
+           absl::Span<const uint8_t> in, absl::Span<uint8_t> out) const;
+
+  const SymmetricCrypto::CryptoType type_;
+  size_t num_keys_ = 0;
+
+  bool use_aes_ni_ = false;
+  std::vector<AesRoundKeys> aes_enc_keys_;
+  std::vector<AesRoundKeys> aes_dec_keys_;
+  bool use_sm4_ni_ = false;
+  std::vector<Sm4RoundKeys> sm4_enc_keys_;
+  std::vector<Sm4RoundKeys> sm4_dec_keys_;
+  // on neither kernel.
+  std::vector<std::unique_ptr<SymmetricCrypto>> ciphers_;
+};
+
+// CipherPrg encrypts the counters count, count + 1, ... by a fixed key, whose
+// output is that of FillPseudoRandom. The cipher context is set up once and
+// reused by each Fill, the counters are written into the output and encrypted
+// in place, so Fill allocates nothing. AES128_ECB runs on the AES-NI/VAES CTR
+// kernel where available, which generates the counters in registers and
+// skips openssl altogether, and SM4_ECB on the SM4 kernel. Not thread safe.
+class CipherPrg {
+ public:
+  CipherPrg(SymmetricCrypto::CryptoType type, uint128_t seed,
+            uint128_t iv = 0);
+  ~CipherPrg() { EVP_CIPHER_CTX_free(ctx_); }
+
+  CipherPrg(const CipherPrg&) = delete;
+  CipherPrg& operator=(const CipherPrg&) = delete;
+
+  SymmetricCrypto::CryptoType GetType() const { return type_; }
+  uint128_t GetSeed() const { return seed_; }
+
+  // Fills `out` with the blocks of counters from `count`, the last block is
+  // truncated to the bytes left. Chained modes restart from the iv. Returns
+  // the counter after the last block.
+  uint128_t Fill(uint128_t count, absl::Span<uint8_t> out);
+
+  template <typename T,
+            std::enable_if_t<std::is_standard_layout<T>::value, int> = 0>
+  uint128_t Fill(uint128_t count, absl::Span<T> out) {
+    return Fill(count, absl::MakeSpan(reinterpret_cast<uint8_t*>(out.data()),
+                                      out.size() * sizeof(T)));
+  }
+
+ private:
+  const SymmetricCrypto::CryptoType type_;
+  const uint128_t seed_;
+  const uint128_t iv_;
+  // nullptr on the kernels.
+  EVP_CIPHER_CTX* ctx_ = nullptr;
+
+  bool use_aes_ni_ = false;
+  AesRoundKeys round_keys_;
+  bool use_sm4_ni_ = false;
+  Sm4RoundKeys sm4_round_keys_;
+};
+
 // FillAesRandom generate pseudo random bytes and fill the `out`.
 // The pseudo random bytes are generated by using AES-CBC to encrypt a
 // continuous buffer with incremental counters as contents.
+// Callers filling repeatedly by the same seed should keep a CipherPrg.
 template <typename T,
           std::enable_if_t<std::is_standard_layout<T>::value, int> = 0>
 inline uint64_t FillPseudoRandom(SymmetricCrypto::CryptoType crypto_type,
                                  uint128_t seed, uint128_t iv, uint64_t count,
                                  absl::Span<T> out) {
-  const size_t nbytes = out.size() * sizeof(T);
-  const size_t nblock = (nbytes + sizeof(uint128_t) - 1) / sizeof(uint128_t);
-  if (nbytes % sizeof(uint128_t) == 0) {
-    // No padding, fast path
-    SymmetricCrypto(crypto_type, seed, iv)
-        .Encrypt(
-            internal::EcbMakeContentBlocks(count, nblock),
-            absl::MakeSpan(reinterpret_cast<uint128_t*>(out.data()), nblock));
-  } else {
-    std::vector<uint128_t> cipher(nblock);
-    SymmetricCrypto(crypto_type, seed, iv)
-        .Encrypt(internal::EcbMakeContentBlocks(count, nblock),
-                 absl::MakeSpan(cipher));
-    std::memcpy(out.data(), cipher.data(), nbytes);
-  }
-  return count + nblock;
+  return static_cast<uint64_t>(
+      CipherPrg(crypto_type, seed, iv).Fill(count, out));
 }
 
 template <typename T,
@@ -16,6 +16,7 @@
 #include "yasl/crypto/symmetric_crypto.h"
 
 #include <memory>
+#include <numeric>
 
 #include "gtest/gtest.h"
 
@@ -310,4 +311,119 @@ TEST(SymmetricCrypto, AesCtrExampleKey) {
   }
 }
 
+TEST(SymmetricCrypto, Sm4SameAsOpenssl) {
+  // the big endian counter carries across bytes.
+  const uint128_t iv = MakeUint128(0x1234, 0xfeffffffffffffffULL);
+  std::vector<uint8_t> plaintext(5000 + 7);
+  std::iota(plaintext.begin(), plaintext.end(), 0);
+  for (auto [type, cipher] :
+       {std::make_pair(SymmetricCrypto::CryptoType::SM4_ECB, EVP_sm4_ecb()),
+        std::make_pair(SymmetricCrypto::CryptoType::SM4_CTR, EVP_sm4_ctr())}) {
+    const size_t n = type == SymmetricCrypto::CryptoType::SM4_ECB
+                         ? plaintext.size() / 16 * 16
+                         : plaintext.size();
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    ASSERT_TRUE(EVP_EncryptInit_ex(ctx, cipher, nullptr,
+                                   reinterpret_cast<const uint8_t*>(&kKey1),
+                                   reinterpret_cast<const uint8_t*>(&iv)));
+    EVP_CIPHER_CTX_set_padding(ctx, 0);
+    std::vector<uint8_t> expected(n);
+    int outlen;
+    ASSERT_TRUE(
+        EVP_EncryptUpdate(ctx, expected.data(), &outlen, plaintext.data(), n));
+    EVP_CIPHER_CTX_free(ctx);
+
+    SymmetricCrypto crypto(type, kKey1, iv);
+    std::vector<uint8_t> encrypted(n);
+    crypto.Encrypt(absl::MakeConstSpan(plaintext.data(), n),
+                   absl::MakeSpan(encrypted));
+    EXPECT_EQ(encrypted, expected);
+    std::vector<uint8_t> decrypted(n);
+    crypto.Decrypt(absl::MakeConstSpan(encrypted), absl::MakeSpan(decrypted));
+    EXPECT_TRUE(std::equal(decrypted.begin(), decrypted.end(),
+                           plaintext.begin()));
+  }
+}
+
+TEST(CipherPrg, SameAsEncryptingCounters) {
+  for (auto type : {SymmetricCrypto::CryptoType::AES128_ECB,
+                    SymmetricCrypto::CryptoType::AES128_CBC,
+                    SymmetricCrypto::CryptoType::AES128_CTR,
+                    SymmetricCrypto::CryptoType::SM4_ECB}) {
+    CipherPrg prg(type, kKey1, kIv1);
+    uint64_t count = 3;
+    // partial blocks, and more blocks than a batch.
+    for (size_t nbytes : {0, 5, 16, 40, 1024, 5000}) {
+      const size_t nblock = (nbytes + 15) / 16;
+      std::vector<uint128_t> counters(nblock);
+      std::iota(counters.begin(), counters.end(), count);
+      std::vector<uint128_t> expected(nblock);
+      SymmetricCrypto(type, kKey1, kIv1)
+          .Encrypt(absl::MakeConstSpan(counters), absl::MakeSpan(expected));
+
+      std::vector<uint8_t> out(nbytes);
+      const uint64_t next = prg.Fill(count, absl::MakeSpan(out));
+      EXPECT_EQ(next, count + nblock);
+      EXPECT_EQ(std::memcmp(out.data(), expected.data(), nbytes), 0);
+      count = next;
+    }
+  }
+}
+
+TEST(MultiKeySymmetricCrypto, SameAsKeyByKey) {
+  for (auto type : {SymmetricCrypto::CryptoType::AES128_ECB,
+                    SymmetricCrypto::CryptoType::SM4_ECB}) {
+    std::vector<uint128_t> keys(37);
+    std::iota(keys.begin(), keys.end(), kKey1);
+    MultiKeySymmetricCrypto crypto(type, absl::MakeConstSpan(keys));
+    EXPECT_EQ(crypto.AddKey(kKey2), keys.size());
+    keys.push_back(kKey2);
+    EXPECT_EQ(crypto.NumKeys(), keys.size());
+
+    // the tails of the kernels, and runs of a key.
+    for (size_t nblock : {0, 1, 7, 8, 9, 33, 1000}) {
+      std::vector<uint32_t> key_idx(nblock);
+      std::vector<uint128_t> plaintext(nblock);
+      std::vector<uint128_t> expected(nblock);
+      for (size_t i = 0; i < nblock; ++i) {
+        key_idx[i] = (i % 5 == 0) ? key_idx[i / 2] : rand() % keys.size();
+        plaintext[i] = MakeUint128(rand(), i);
+        expected[i] = SymmetricCrypto(type, keys[key_idx[i]])
+                          .Encrypt(plaintext[i]);
+      }
+      std::vector<uint128_t> encrypted(nblock);
+      crypto.Encrypt(absl::MakeConstSpan(key_idx),
+                     absl::MakeConstSpan(plaintext),
+                     absl::MakeSpan(encrypted));
+      EXPECT_EQ(encrypted, expected) << "nblock=" << nblock;
+
+      // in place.
+      crypto.Decrypt(absl::MakeConstSpan(key_idx),
+                     absl::MakeConstSpan(encrypted),
+                     absl::MakeSpan(encrypted));
+      EXPECT_EQ(encrypted, plaintext) << "nblock=" << nblock;
+    }
+
+    EXPECT_EQ(crypto.Decrypt(3, crypto.Encrypt(3, kIv1)), kIv1);
+    EXPECT_EQ(crypto.Encrypt(3, kIv1),
+              SymmetricCrypto(type, keys[3]).Encrypt(kIv1));
+  }
+}
+
+TEST(MultiKeySymmetricCrypto, Throws) {
+  EXPECT_THROW(
+      MultiKeySymmetricCrypto(SymmetricCrypto::CryptoType::AES128_CBC),
+      Exception);
+
+  MultiKeySymmetricCrypto crypto(SymmetricCrypto::CryptoType::AES128_ECB);
+  crypto.AddKey(kKey1);
+  EXPECT_THROW(crypto.Encrypt(1, kIv1), Exception);
+  const std::vector<uint32_t> key_idx(2);
+  std::vector<uint128_t> blocks(1);
+  EXPECT_THROW(crypto.Encrypt(absl::MakeConstSpan(key_idx),
+                              absl::MakeConstSpan(blocks),
+                              absl::MakeSpan(blocks)),
+               Exception);
+}
+
 }  // namespace yasl
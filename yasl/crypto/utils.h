@@ -15,26 +15,31 @@
 
 #pragma once
 
-#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "absl/types/span.h"
+
+#include "yasl/base/bit_vector.h"
 #include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/utils/rand.h"
 
 namespace yasl {
 
-// Create vector<bool> random choices.
-inline std::vector<bool> CreateRandomChoices(size_t len) {
-  std::random_device rd;
-  PseudoRandomGenerator<unsigned> prg(rd());
-  const unsigned stride = sizeof(unsigned) * 8;
-  std::vector<bool> ret(len, false);
-  for (size_t i = 0; i < len; i += stride) {
-    unsigned rand = prg();
-    unsigned size = std::min(stride, static_cast<unsigned>(len - i));
-    for (unsigned j = 0; j < size; ++j) {
-      ret[i + j] = (rand & (1 << j)) ? true : false;
-    }
-  }
-  return ret;
+// Fills `out` with random bits under a fresh 128 bits seed, in one bulk Fill
+// of the prg, which is parallel on large outputs.
+template <typename T, std::enable_if_t<std::is_scalar<T>::value, int> = 0>
+inline void FillRandomBits(absl::Span<T> out) {
+  PseudoRandomGenerator<T> prg(RandSeed());
+  prg.Fill(out);
+}
+
+// Create random choices, the words filled in place.
+inline BitVector CreateRandomChoices(size_t len) {
+  std::vector<uint128_t> words(BitVector::NumWords(len));
+  FillRandomBits(absl::MakeSpan(words));
+  return BitVector(std::move(words), len);
 }
 
 // CreateRandomChoiceBits
@@ -45,12 +50,10 @@ inline std::vector<bool> CreateRandomChoices(size_t len) {
 // what GMW circuits wanted.
 template <typename T, std::enable_if_t<std::is_scalar<T>::value, int> = 0>
 inline std::vector<T> CreateRandomChoiceBits(size_t num) {
-  std::random_device rd;
-  PseudoRandomGenerator<T> prg(rd());
   // Align to sizeof(T).
   constexpr int kNumBits = sizeof(T) * 8;
   std::vector<T> ret((num + kNumBits - 1) / kNumBits);
-  std::generate(ret.begin(), ret.end(), [&] { return prg(); });
+  FillRandomBits(absl::MakeSpan(ret));
   return ret;
 }
 
@@ -0,0 +1,271 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/io/rw/batch_serialize.h"
+
+#include <cstring>
+#include <variant>
+
+namespace yasl::io {
+
+namespace {
+
+using internal::WireColumnKind;
+
+constexpr char kMagic[] = "YCVB";
+constexpr size_t kMagicSize = 4;
+constexpr uint32_t kVersion = 1;
+// magic + version + rows + cols.
+constexpr size_t kHeaderSize = 24;
+// kind + padding + payload size.
+constexpr size_t kColumnMetaSize = 16;
+constexpr size_t kPayloadAlignment = 16;
+
+size_t AlignUp(size_t n) {
+  return (n + kPayloadAlignment - 1) / kPayloadAlignment * kPayloadAlignment;
+}
+
+template <class T>
+void Put(T v, std::byte* out) {
+  std::memcpy(out, &v, sizeof(v));
+}
+
+template <class T>
+T Get(const std::byte* in) {
+  T v;
+  std::memcpy(&v, in, sizeof(v));
+  return v;
+}
+
+template <class C>
+WireColumnKind KindOf() {
+  if constexpr (kIsNumericColumn<C>) {
+    return internal::WireKindOf<typename C::value_type>();
+  } else {
+    return WireColumnKind::STRING;
+  }
+}
+
+template <class C>
+size_t PayloadSize(const C& col) {
+  if constexpr (std::is_same_v<C, StringArenaColumnVector>) {
+    return col.offsets().size() * sizeof(uint64_t) + col.arena().size();
+  } else if constexpr (std::is_same_v<C, StringColumnVector>) {
+    size_t size = (col.size() + 1) * sizeof(uint64_t);
+    for (const auto& s : col) {
+      size += s.size();
+    }
+    return size;
+  } else {
+    return col.size() * sizeof(typename C::value_type);
+  }
+}
+
+template <class C>
+void WritePayload(const C& col, std::byte* out) {
+  if constexpr (std::is_same_v<C, StringArenaColumnVector>) {
+    const size_t offsets_size = col.offsets().size() * sizeof(uint64_t);
+    std::memcpy(out, col.offsets().data(), offsets_size);
+    if (!col.arena().empty()) {
+      std::memcpy(out + offsets_size, col.arena().data(), col.arena().size());
+    }
+  } else if constexpr (std::is_same_v<C, StringColumnVector>) {
+    auto* offsets = out;
+    auto* values = out + (col.size() + 1) * sizeof(uint64_t);
+    uint64_t offset = 0;
+    Put(offset, offsets);
+    for (const auto& s : col) {
+      if (!s.empty()) {
+        std::memcpy(values + offset, s.data(), s.size());
+      }
+      offset += s.size();
+      offsets += sizeof(uint64_t);
+      Put(offset, offsets);
+    }
+  } else if (!col.empty()) {
+    std::memcpy(out, col.data(), PayloadSize(col));
+  }
+}
+
+size_t ElementSize(WireColumnKind kind) {
+  switch (kind) {
+    case WireColumnKind::FLOAT:
+    case WireColumnKind::INT32:
+      return 4;
+    case WireColumnKind::DOUBLE:
+    case WireColumnKind::INT64:
+    case WireColumnKind::UINT64:
+      return 8;
+    case WireColumnKind::UINT128:
+      return 16;
+    case WireColumnKind::STRING:
+      break;
+  }
+  return 0;
+}
+
+template <class S>
+ColumnType CopyColumn(const std::byte* data, size_t rows) {
+  const auto* begin = reinterpret_cast<const S*>(data);
+  return ColumnVector<S>(begin, begin + rows);
+}
+
+}  // namespace
+
+Buffer SerializeColumnBatch(const ColumnVectorBatch& batch) {
+  const auto shape = batch.Shape();
+  std::vector<size_t> payload_sizes(shape.cols);
+  size_t total = AlignUp(kHeaderSize + shape.cols * kColumnMetaSize);
+  for (size_t c = 0; c < shape.cols; c++) {
+    payload_sizes[c] = std::visit(
+        [](const auto& col) { return PayloadSize(col); }, batch.RawCol(c));
+    total += AlignUp(payload_sizes[c]);
+  }
+
+  Buffer buf(static_cast<int64_t>(total));
+  std::byte* out = buf.data<std::byte>();
+  std::memcpy(out, kMagic, kMagicSize);
+  Put(kVersion, out + kMagicSize);
+  Put(uint64_t{shape.rows}, out + 8);
+  Put(uint64_t{shape.cols}, out + 16);
+  size_t payload_pos = AlignUp(kHeaderSize + shape.cols * kColumnMetaSize);
+  // padding is zeroed so that equal batches serialize to equal bytes.
+  std::memset(out + kHeaderSize, 0, payload_pos - kHeaderSize);
+  for (size_t c = 0; c < shape.cols; c++) {
+    std::byte* meta = out + kHeaderSize + c * kColumnMetaSize;
+    std::visit(
+        [&](const auto& col) {
+          Put(KindOf<std::decay_t<decltype(col)>>(), meta);
+          WritePayload(col, out + payload_pos);
+        },
+        batch.RawCol(c));
+    Put(uint64_t{payload_sizes[c]}, meta + 8);
+    const size_t end = payload_pos + payload_sizes[c];
+    payload_pos = AlignUp(end);
+    std::memset(out + end, 0, payload_pos - end);
+  }
+  return buf;
+}
+
+ColumnBatchView::ColumnBatchView(Buffer buf) : buf_(std::move(buf)) {
+  if (reinterpret_cast<uintptr_t>(buf_.data()) % kPayloadAlignment != 0) {
+    buf_ = Buffer(buf_.data(), buf_.size());
+  }
+  const auto* data = buf_.data<std::byte>();
+  const size_t size = buf_.size();
+  if (size < kHeaderSize || std::memcmp(data, kMagic, kMagicSize) != 0) {
+    YASL_THROW_INVALID_FORMAT("not a serialized column batch");
+  }
+  const auto version = Get<uint32_t>(data + kMagicSize);
+  if (version != kVersion) {
+    YASL_THROW_INVALID_FORMAT("unsupported column batch version {}", version);
+  }
+  const auto rows = Get<uint64_t>(data + 8);
+  const auto cols = Get<uint64_t>(data + 16);
+  if (cols > (size - kHeaderSize) / kColumnMetaSize) {
+    YASL_THROW_INVALID_FORMAT("truncated column batch header, {} cols", cols);
+  }
+  rows_ = rows;
+
+  size_t payload_pos = AlignUp(kHeaderSize + cols * kColumnMetaSize);
+  cols_.reserve(cols);
+  for (size_t c = 0; c < cols; c++) {
+    const std::byte* meta = data + kHeaderSize + c * kColumnMetaSize;
+    const auto kind = Get<WireColumnKind>(meta);
+    const auto payload_size = Get<uint64_t>(meta + 8);
+    if (payload_pos > size || payload_size > size - payload_pos) {
+      YASL_THROW_INVALID_FORMAT("truncated payload of column {}", c);
+    }
+    const std::byte* payload = data + payload_pos;
+    if (kind == WireColumnKind::STRING) {
+      if (rows >= payload_size / sizeof(uint64_t)) {
+        YASL_THROW_INVALID_FORMAT("truncated offsets of column {}", c);
+      }
+      const uint64_t values_size =
+          payload_size - (rows + 1) * sizeof(uint64_t);
+      const auto* offsets = reinterpret_cast<const uint64_t*>(payload);
+      if (offsets[0] != 0 || offsets[rows] != values_size) {
+        YASL_THROW_INVALID_FORMAT("bad offsets of column {}", c);
+      }
+      for (size_t r = 0; r < rows; r++) {
+        if (offsets[r] > offsets[r + 1]) {
+          YASL_THROW_INVALID_FORMAT("bad offsets of column {}", c);
+        }
+      }
+    } else {
+      const size_t element_size = ElementSize(kind);
+      if (element_size == 0) {
+        YASL_THROW_INVALID_FORMAT("unknown kind {} of column {}",
+                                  static_cast<int>(kind), c);
+      }
+      if (payload_size / element_size != rows ||
+          payload_size % element_size != 0) {
+        YASL_THROW_INVALID_FORMAT("column {} has {} bytes, expect {} rows", c,
+                                  payload_size, rows);
+      }
+    }
+    cols_.push_back({kind, payload});
+    payload_pos += AlignUp(payload_size);
+  }
+}
+
+std::string_view ColumnBatchView::StringAt(size_t row, size_t col) const {
+  YASL_ENFORCE(IsString(col), "column {} is not a STRING column", col);
+  YASL_ENFORCE(row < rows_, "row {} out of range, {} rows", row, rows_);
+  const uint64_t* offsets = Offsets(col);
+  const auto* values = reinterpret_cast<const char*>(offsets + rows_ + 1);
+  return std::string_view(values + offsets[row],
+                          offsets[row + 1] - offsets[row]);
+}
+
+ColumnVectorBatch ColumnBatchView::ToBatch() const {
+  auto batch = ColumnVectorBatch::EmptyBatch(rows_);
+  batch.Reserve(cols_.size());
+  for (size_t c = 0; c < cols_.size(); c++) {
+    const std::byte* data = cols_[c].data;
+    switch (cols_[c].kind) {
+      case WireColumnKind::STRING: {
+        const uint64_t* offsets = Offsets(c);
+        StringArenaColumnVector col;
+        col.reserve(rows_, offsets[rows_]);
+        for (size_t r = 0; r < rows_; r++) {
+          col.push_back(StringAt(r, c));
+        }
+        batch.AppendCol(std::move(col));
+        break;
+      }
+      case WireColumnKind::FLOAT:
+        batch.AppendCol(CopyColumn<float>(data, rows_));
+        break;
+      case WireColumnKind::DOUBLE:
+        batch.AppendCol(CopyColumn<double>(data, rows_));
+        break;
+      case WireColumnKind::INT32:
+        batch.AppendCol(CopyColumn<int32_t>(data, rows_));
+        break;
+      case WireColumnKind::INT64:
+        batch.AppendCol(CopyColumn<int64_t>(data, rows_));
+        break;
+      case WireColumnKind::UINT64:
+        batch.AppendCol(CopyColumn<uint64_t>(data, rows_));
+        break;
+      case WireColumnKind::UINT128:
+        batch.AppendCol(CopyColumn<uint128_t>(data, rows_));
+        break;
+    }
+  }
+  return batch;
+}
+
+}  // namespace yasl::io
@@ -0,0 +1,126 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/exception.h"
+#include "yasl/io/rw/schema.h"
+
+namespace yasl::io {
+
+// wire format of a ColumnVectorBatch, for shipping features to a peer
+// without going through protobuf, little endian:
+//
+//   "YCVB" u32 version u64 rows u64 cols
+//   per col: u8 kind, 7 bytes padding, u64 payload size
+//   payloads, each starting at a multiple of 16 bytes
+//
+// numeric payloads are the values as in memory. STRING payloads are rows + 1
+// u64 offsets into the concatenated values that follow, the same as raw
+// columnar STRING chunks.
+//
+//   ctx->SendAsync(peer, SerializeColumnBatch(batch), "features");
+//   ColumnBatchView view(ctx->Recv(peer, "features"));
+//   absl::Span<const double> col = view.Col<double>(1);
+
+namespace internal {
+
+enum class WireColumnKind : uint8_t {
+  STRING = 0,
+  FLOAT = 1,
+  DOUBLE = 2,
+  INT32 = 3,
+  INT64 = 4,
+  UINT64 = 5,
+  UINT128 = 6,
+};
+
+template <class S>
+constexpr WireColumnKind WireKindOf() {
+  if constexpr (std::is_same_v<S, float>) {
+    return WireColumnKind::FLOAT;
+  } else if constexpr (std::is_same_v<S, double>) {
+    return WireColumnKind::DOUBLE;
+  } else if constexpr (std::is_same_v<S, int32_t>) {
+    return WireColumnKind::INT32;
+  } else if constexpr (std::is_same_v<S, int64_t>) {
+    return WireColumnKind::INT64;
+  } else if constexpr (std::is_same_v<S, uint64_t>) {
+    return WireColumnKind::UINT64;
+  } else {
+    static_assert(std::is_same_v<S, uint128_t>, "not a numeric column type");
+    return WireColumnKind::UINT128;
+  }
+}
+
+}  // namespace internal
+
+// serializes batch into one buffer, sized up front, that the link sends
+// as is. each column is copied once, straight into place.
+Buffer SerializeColumnBatch(const ColumnVectorBatch& batch);
+
+// a serialized batch, read in place. columns are views into the owned
+// buffer, so nothing is copied unless ToBatch is called.
+class ColumnBatchView {
+ public:
+  // validates buf, throws yasl::InvalidFormat if it is malformed. buf is
+  // copied once only if it is not 16 byte aligned.
+  explicit ColumnBatchView(Buffer buf);
+
+  ColumnVectorBatch::Dimension Shape() const { return {rows_, cols_.size()}; }
+
+  bool IsString(size_t index) const {
+    return cols_.at(index).kind == internal::WireColumnKind::STRING;
+  }
+
+  // values of a numeric column.
+  template <typename S>
+  absl::Span<const S> Col(size_t index) const {
+    const auto& col = cols_.at(index);
+    YASL_ENFORCE(col.kind == internal::WireKindOf<S>(),
+                 "column {} is not of the requested type", index);
+    return absl::MakeConstSpan(reinterpret_cast<const S*>(col.data), rows_);
+  }
+
+  std::string_view StringAt(size_t row, size_t col) const;
+
+  // copies the columns into an owning batch, STRING columns as
+  // StringArenaColumnVector.
+  ColumnVectorBatch ToBatch() const;
+
+ private:
+  struct ColumnView {
+    internal::WireColumnKind kind;
+    const std::byte* data;
+  };
+
+  const uint64_t* Offsets(size_t col) const {
+    return reinterpret_cast<const uint64_t*>(cols_.at(col).data);
+  }
+
+  Buffer buf_;
+  size_t rows_ = 0;
+  std::vector<ColumnView> cols_;
+};
+
+}  // namespace yasl::io
@@ -0,0 +1,118 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/io/rw/batch_serialize.h"
+
+#include <cstring>
+#include <string>
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+namespace yasl::io {
+
+namespace {
+
+ColumnVectorBatch MakeBatch(size_t rows) {
+  StringColumnVector ids;
+  FloatColumnVector f1;
+  DoubleColumnVector f2;
+  StringArenaColumnVector names;
+  Int32ColumnVector i32;
+  Uint128ColumnVector u128;
+  for (size_t i = 0; i < rows; i++) {
+    ids.push_back(i % 3 == 0 ? "" : fmt::format("u{}", i));
+    f1.push_back(i * 0.1f);
+    f2.push_back(-1.0 / (i + 1));
+    names.push_back(fmt::format("name-{}", i * 7));
+    i32.push_back(-static_cast<int32_t>(i));
+    u128.push_back(MakeUint128(i, ~i));
+  }
+  ColumnVectorBatch batch;
+  batch.AppendCol(std::move(ids));
+  batch.AppendCol(std::move(f1));
+  batch.AppendCol(std::move(f2));
+  batch.AppendCol(std::move(names));
+  batch.AppendCol(std::move(i32));
+  batch.AppendCol(std::move(u128));
+  return batch;
+}
+
+}  // namespace
+
+TEST(BatchSerialize, RoundTrip) {
+  for (size_t rows : {0, 1, 5, 1000}) {
+    const auto batch = MakeBatch(rows);
+    ColumnBatchView view(SerializeColumnBatch(batch));
+    ASSERT_EQ(view.Shape(), batch.Shape());
+    for (size_t r = 0; r < rows; r++) {
+      EXPECT_EQ(view.StringAt(r, 0), batch.StringAt(r, 0));
+      EXPECT_EQ(view.StringAt(r, 3), batch.StringAt(r, 3));
+    }
+    EXPECT_TRUE(view.IsString(0));
+    EXPECT_FALSE(view.IsString(1));
+    EXPECT_EQ(std::vector<float>(view.Col<float>(1).begin(),
+                                 view.Col<float>(1).end()),
+              batch.Col<float>(1));
+    EXPECT_EQ(std::vector<double>(view.Col<double>(2).begin(),
+                                  view.Col<double>(2).end()),
+              batch.Col<double>(2));
+    EXPECT_EQ(std::vector<int32_t>(view.Col<int32_t>(4).begin(),
+                                   view.Col<int32_t>(4).end()),
+              batch.Col<int32_t>(4));
+    EXPECT_EQ(std::vector<uint128_t>(view.Col<uint128_t>(5).begin(),
+                                     view.Col<uint128_t>(5).end()),
+              batch.Col<uint128_t>(5));
+    EXPECT_THROW(view.Col<double>(1), EnforceNotMet);
+
+    const auto copy = view.ToBatch();
+    ASSERT_EQ(copy.Shape(), batch.Shape());
+    for (size_t r = 0; r < rows; r++) {
+      EXPECT_EQ(copy.StringAt(r, 0), batch.StringAt(r, 0));
+    }
+    EXPECT_EQ(copy.Col<uint128_t>(5), batch.Col<uint128_t>(5));
+  }
+}
+
+TEST(BatchSerialize, ViewsIntoBuffer) {
+  Buffer buf = SerializeColumnBatch(MakeBatch(10));
+  const auto* begin = buf.data<std::byte>();
+  const auto* end = begin + buf.size();
+  ColumnBatchView view(std::move(buf));
+  const auto* col = reinterpret_cast<const std::byte*>(
+      view.Col<double>(2).data());
+  EXPECT_TRUE(col >= begin && col < end);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(view.Col<uint128_t>(5).data()) % 16,
+            0);
+}
+
+TEST(BatchSerialize, Malformed) {
+  const Buffer good = SerializeColumnBatch(MakeBatch(10));
+  EXPECT_THROW(ColumnBatchView(Buffer(std::string("YCVB"))), InvalidFormat);
+  EXPECT_THROW(ColumnBatchView(Buffer(std::string(64, 'x'))), InvalidFormat);
+
+  // truncated anywhere.
+  for (int64_t size : {int64_t{30}, good.size() / 2, good.size() - 1}) {
+    Buffer bad(good.data(), size);
+    EXPECT_THROW(ColumnBatchView(std::move(bad)), InvalidFormat) << size;
+  }
+
+  // rows no longer matching the payloads.
+  Buffer bad = good;
+  const uint64_t rows = 11;
+  std::memcpy(bad.data<char>() + 8, &rows, sizeof(rows));
+  EXPECT_THROW(ColumnBatchView(std::move(bad)), InvalidFormat);
+}
+
+}  // namespace yasl::io
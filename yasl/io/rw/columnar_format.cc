@@ -0,0 +1,215 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "yasl/io/rw/columnar_format.h"
+
+#include <cstring>
+#include <variant>
+
+#include "zlib.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl::io::columnar {
+
+namespace {
+
+template <class T>
+void Put(T v, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+// bounds checked reads of the footer.
+class FooterCursor {
+ public:
+  FooterCursor(absl::string_view data, const std::string& file_name)
+      : data_(data), file_name_(file_name) {}
+
+  template <class T>
+  T Get() {
+    T v;
+    std::memcpy(&v, GetBytes(sizeof(T)).data(), sizeof(T));
+    return v;
+  }
+
+  absl::string_view GetBytes(size_t size) {
+    if (size > data_.size() - pos_) {
+      YASL_THROW_INVALID_FORMAT(
+          "Input columnar file format error: truncated footer in file '{}'",
+          file_name_);
+    }
+    auto ret = data_.substr(pos_, size);
+    pos_ += size;
+    return ret;
+  }
+
+  bool Done() const { return pos_ == data_.size(); }
+
+ private:
+  const absl::string_view data_;
+  const std::string& file_name_;
+  size_t pos_ = 0;
+};
+
+// smallest raw chunk of rows values.
+uint64_t MinRawSize(Schema::Type type, uint64_t rows) {
+  if (type == Schema::STRING) {
+    return (rows + 1) * sizeof(uint64_t);
+  }
+  return rows * std::visit([](const auto& col) { return sizeof(col[0]); },
+                           MakeColumn(type, 0));
+}
+
+}  // namespace
+
+void AppendFooter(const Footer& footer, std::string* out) {
+  const size_t begin = out->size();
+  const auto& schema = footer.schema;
+  Put<uint32_t>(schema.feature_types.size(), out);
+  for (size_t c = 0; c < schema.feature_types.size(); c++) {
+    Put<uint8_t>(schema.feature_types[c], out);
+    Put<uint32_t>(schema.feature_names[c].size(), out);
+    out->append(schema.feature_names[c]);
+  }
+  Put<uint64_t>(footer.row_groups.size(), out);
+  for (const auto& group : footer.row_groups) {
+    Put<uint64_t>(group.rows, out);
+    for (const auto& chunk : group.chunks) {
+      Put<uint64_t>(chunk.offset, out);
+      Put<uint64_t>(chunk.stored_size, out);
+      Put<uint64_t>(chunk.raw_size, out);
+      Put<uint8_t>(static_cast<uint8_t>(chunk.compression), out);
+    }
+  }
+  Put<uint64_t>(out->size() - begin, out);
+  out->append(kMagic, kMagicSize);
+}
+
+Footer ParseFooter(absl::string_view file, const std::string& file_name,
+                   size_t* chunks_end) {
+  if (file.size() < kHeaderSize + kTrailerSize ||
+      file.substr(0, kMagicSize) != kMagic ||
+      file.substr(file.size() - kMagicSize) != kMagic) {
+    YASL_THROW_INVALID_FORMAT(
+        "Input columnar file format error: '{}' is not a columnar file",
+        file_name);
+  }
+  uint32_t version;
+  std::memcpy(&version, file.data() + kMagicSize, sizeof(version));
+  if (version != kVersion) {
+    YASL_THROW_INVALID_FORMAT(
+        "Input columnar file format error: unsupported version {} of file "
+        "'{}'",
+        version, file_name);
+  }
+  uint64_t footer_size;
+  std::memcpy(&footer_size, file.data() + file.size() - kTrailerSize,
+              sizeof(footer_size));
+  if (footer_size > file.size() - kHeaderSize - kTrailerSize) {
+    YASL_THROW_INVALID_FORMAT(
+        "Input columnar file format error: bad footer size {} of file '{}'",
+        footer_size, file_name);
+  }
+  *chunks_end = file.size() - kTrailerSize - footer_size;
+
+  FooterCursor cursor(file.substr(*chunks_end, footer_size), file_name);
+  Footer footer;
+  auto& schema = footer.schema;
+  const auto cols = cursor.Get<uint32_t>();
+  if (cols == 0) {
+    YASL_THROW_INVALID_FORMAT(
+        "Input columnar file format error: no column in file '{}'",
+        file_name);
+  }
+  for (size_t c = 0; c < cols; c++) {
+    const auto type = cursor.Get<uint8_t>();
+    if (type > Schema::FXP128) {
+      YASL_THROW_INVALID_FORMAT(
+          "Input columnar file format error: unknown type {} in file '{}'",
+          type, file_name);
+    }
+    schema.feature_types.push_back(static_cast<Schema::Type>(type));
+    schema.feature_names.emplace_back(
+        cursor.GetBytes(cursor.Get<uint32_t>()));
+  }
+  const auto groups = cursor.Get<uint64_t>();
+  for (size_t g = 0; g < groups; g++) {
+    auto& group = footer.row_groups.emplace_back();
+    group.rows = cursor.Get<uint64_t>();
+    for (size_t c = 0; c < cols; c++) {
+      auto& chunk = group.chunks.emplace_back();
+      chunk.offset = cursor.Get<uint64_t>();
+      chunk.stored_size = cursor.Get<uint64_t>();
+      chunk.raw_size = cursor.Get<uint64_t>();
+      const auto compression = cursor.Get<uint8_t>();
+      chunk.compression = static_cast<ColumnarCompression>(compression);
+      const bool bad_chunk =
+          chunk.offset < kHeaderSize || chunk.offset > *chunks_end ||
+          chunk.stored_size > *chunks_end - chunk.offset ||
+          compression > static_cast<uint8_t>(ColumnarCompression::ZLIB) ||
+          (chunk.compression == ColumnarCompression::NONE &&
+           chunk.stored_size != chunk.raw_size) ||
+          group.rows > chunk.raw_size ||
+          chunk.raw_size < MinRawSize(schema.feature_types[c], group.rows) ||
+          (schema.feature_types[c] != Schema::STRING &&
+           chunk.raw_size != MinRawSize(schema.feature_types[c], group.rows));
+      if (bad_chunk) {
+        YASL_THROW_INVALID_FORMAT(
+            "Input columnar file format error: bad chunk of column '{}' in "
+            "row group {} of file '{}'",
+            schema.feature_names[c], g, file_name);
+      }
+    }
+  }
+  if (!cursor.Done()) {
+    YASL_THROW_INVALID_FORMAT(
+        "Input columnar file format error: trailing bytes in footer of file "
+        "'{}'",
+        file_name);
+  }
+  return footer;
+}
+
+void Compress(ColumnarCompression compression, absl::string_view raw,
+              std::string* out) {
+  YASL_ENFORCE(compression == ColumnarCompression::ZLIB,
+               "unknown compression {}", static_cast<int>(compression));
+  uLongf size = compressBound(raw.size());
+  out->resize(size);
+  const int ret =
+      compress2(reinterpret_cast<Bytef*>(out->data()), &size,
+                reinterpret_cast<const Bytef*>(raw.data()), raw.size(),
+                Z_BEST_SPEED);
+  YASL_ENFORCE(ret == Z_OK, "zlib compress2 failed, ret {}", ret);
+  out->resize(size);
+}
+
+void Decompress(const ChunkMeta& chunk, absl::string_view stored,
+                const std::string& file_name, std::string* out) {
+  YASL_ENFORCE(chunk.compression == ColumnarCompression::ZLIB);
+  out->resize(chunk.raw_size);
+  uLongf size = chunk.raw_size;
+  const int ret =
+      uncompress(reinterpret_cast<Bytef*>(out->data()), &size,
+                 reinterpret_cast<const Bytef*>(stored.data()), stored.size());
+  if (ret != Z_OK || size != chunk.raw_size) {
+    YASL_THROW_INVALID_FORMAT(
+        "Input columnar file format error: corrupted chunk at offset {} of "
+        "file '{}', zlib ret {}",
+        chunk.offset, file_name, ret);
+  }
+}
+
+}  // namespace yasl::io::columnar
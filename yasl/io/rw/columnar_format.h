@@ -0,0 +1,97 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+#include "yasl/io/rw/schema.h"
+
+namespace yasl::io {
+
+enum class ColumnarCompression : uint8_t {
+  NONE = 0,
+  // zlib deflate, per column chunk.
+  ZLIB = 1,
+};
+
+// yasl columnar file, little endian:
+//
+//   "YCOL" u32 version
+//   column chunks, each starting at a multiple of 8 bytes
+//   footer
+//   u64 footer size, "YCOL"
+//
+// footer:
+//   u32 cols, per col: u8 type, u32 name size, name
+//   u64 row groups, per group: u64 rows, per col: u64 offset,
+//   u64 stored size, u64 raw size, u8 compression
+//
+// one row group per Writer::Add. raw chunks of numeric features are the
+// values as in memory, so uncompressed chunks of a mmapped file are copied
+// into column vectors as is. raw STRING chunks are rows + 1 u64 offsets
+// into the concatenated values that follow.
+namespace columnar {
+
+inline constexpr char kMagic[] = "YCOL";
+inline constexpr size_t kMagicSize = 4;
+inline constexpr uint32_t kVersion = 1;
+// magic + version.
+inline constexpr size_t kHeaderSize = 8;
+// footer size + magic.
+inline constexpr size_t kTrailerSize = 12;
+inline constexpr size_t kChunkAlignment = 8;
+
+struct ChunkMeta {
+  uint64_t offset;
+  uint64_t stored_size;
+  uint64_t raw_size;
+  ColumnarCompression compression;
+};
+
+struct RowGroupMeta {
+  uint64_t rows;
+  // one per column.
+  std::vector<ChunkMeta> chunks;
+};
+
+struct Footer {
+  Schema schema;
+  std::vector<RowGroupMeta> row_groups;
+};
+
+// appends the footer and the trailer to out.
+void AppendFooter(const Footer& footer, std::string* out);
+
+// parses and validates the footer of a whole file, the end of the chunks is
+// returned by chunks_end. file_name is for error messages.
+Footer ParseFooter(absl::string_view file, const std::string& file_name,
+                   size_t* chunks_end);
+
+// compresses raw into out.
+void Compress(ColumnarCompression compression, absl::string_view raw,
+              std::string* out);
+
+// decompresses a chunk into out, resized to chunk.raw_size.
+void Decompress(const ChunkMeta& chunk, absl::string_view stored,
+                const std::string& file_name, std::string* out);
+
+}  // namespace columnar
+
+}  // namespace yasl::io
@@ -0,0 +1,400 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "yasl/io/rw/columnar_reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+#include "yasl/base/exception.h"
+#include "yasl/io/rw/columnar_format.h"
+#include "yasl/io/rw/float.h"
+#include "yasl/io/rw/mmapped_file.h"
+#include "yasl/io/stream/file_io.h"
+#include "yasl/io/stream/mmap_io.h"
+
+namespace yasl::io {
+
+namespace {
+
+constexpr size_t kNoGroup = std::numeric_limits<size_t>::max();
+
+// copies n values of type S from the raw chunk, starting at value begin.
+template <class S, class T>
+void CopyValues(absl::string_view raw, size_t begin, size_t n, T* out) {
+  const char* src = raw.data() + begin * sizeof(S);
+  if constexpr (std::is_same_v<S, T>) {
+    std::memcpy(out, src, n * sizeof(S));
+  } else {
+    for (size_t i = 0; i < n; i++) {
+      S v;
+      std::memcpy(&v, src + i * sizeof(S), sizeof(S));
+      out[i] = FloatNormalization(static_cast<T>(v));
+    }
+  }
+}
+
+}  // namespace
+
+struct ColumnarReader::File {
+  std::unique_ptr<MmappedFile> mmap;
+  // inputs that are not local files.
+  std::string buffer;
+  absl::string_view data;
+  columnar::Footer footer;
+  size_t chunks_end = 0;
+  // first row of each row group, and the total rows at the back.
+  std::vector<uint64_t> group_begin;
+};
+
+ColumnarReader::ColumnarReader(ReaderOptions options,
+                               std::unique_ptr<InputStream> in)
+    : options_(std::move(options)),
+      inited_(false),
+      in_(std::move(in)),
+      current_index_(0),
+      total_rows_(0),
+      first_row_(0),
+      cached_group_(kNoGroup) {}
+
+void ColumnarReader::Init() {
+  YASL_ENFORCE(!inited_, "DO NOT call init multiply times");
+
+  auto file = std::make_shared<File>();
+  if (dynamic_cast<FileInputStream*>(in_.get()) != nullptr ||
+      dynamic_cast<MmapInputStream*>(in_.get()) != nullptr) {
+    file->mmap = std::make_unique<MmappedFile>(in_->GetName());
+    file->data = absl::string_view(file->mmap->data(), file->mmap->size());
+  } else {
+    const size_t length = in_->GetLength();
+    file->buffer.resize(length);
+    in_->Seekg(0);
+    size_t pos = 0;
+    while (pos < length) {
+      in_->Read(file->buffer.data() + pos, length - pos);
+      const size_t next = in_->Tellg();
+      if (next <= pos) {
+        break;
+      }
+      pos = next;
+    }
+    YASL_ENFORCE(pos == length, "read {} of {} bytes from '{}'", pos, length,
+                 in_->GetName());
+    file->data = file->buffer;
+  }
+  file->footer =
+      columnar::ParseFooter(file->data, in_->GetName(), &file->chunks_end);
+  file->group_begin.push_back(0);
+  for (const auto& group : file->footer.row_groups) {
+    file->group_begin.push_back(file->group_begin.back() + group.rows);
+  }
+
+  const auto& file_schema = file->footer.schema;
+  headers_ = file_schema.feature_names;
+  const auto& schema = options_.file_schema;
+  YASL_ENFORCE(schema.feature_names.size() == schema.feature_types.size());
+  const size_t f_size = schema.feature_names.size();
+  // col reader do not support empty feature.
+  YASL_ENFORCE(options_.column_reader == false || f_size > 0);
+
+  selected_features_.reserve(f_size);
+  for (size_t i = 0; i < f_size; i++) {
+    const auto& f_name = schema.feature_names[i];
+    auto it = std::find(headers_.begin(), headers_.end(), f_name);
+    if (it == headers_.end()) {
+      YASL_THROW_ARGUMENT_ERROR(
+          "Input columnar read options error: "
+          "can't find feature names '{}' in file '{}'",
+          f_name, in_->GetName());
+    }
+    size_t idx = std::distance(headers_.begin(), it);
+    const auto type = schema.feature_types[i];
+    const auto file_type = file_schema.feature_types[idx];
+    const bool is_float = type == Schema::FLOAT || type == Schema::DOUBLE;
+    const bool file_is_float =
+        file_type == Schema::FLOAT || file_type == Schema::DOUBLE;
+    if (type != file_type && !(is_float && file_is_float)) {
+      YASL_THROW_ARGUMENT_ERROR(
+          "Input columnar read options error: "
+          "feature '{}' of type {} is stored as type {} in file '{}'",
+          f_name, type, file_type, in_->GetName());
+    }
+    selected_features_.emplace_back(idx, schema.feature_types[i]);
+  }
+
+  if (options_.use_header_order) {
+    std::sort(selected_features_.begin(), selected_features_.end(),
+              [](auto& a, auto& b) { return a.first < b.first; });
+  }
+
+  total_rows_ = file->group_begin.back();
+  file_ = std::move(file);
+  cached_scratch_.resize(selected_features_.size());
+  cached_chunks_.resize(selected_features_.size());
+  current_index_ = 0;
+  inited_ = true;
+}
+
+absl::string_view ColumnarReader::RawChunk(size_t group, size_t file_col,
+                                           std::string* scratch) const {
+  const auto& chunk = file_->footer.row_groups[group].chunks[file_col];
+  const auto stored = file_->data.substr(chunk.offset, chunk.stored_size);
+  if (chunk.compression == ColumnarCompression::NONE) {
+    return stored;
+  }
+  columnar::Decompress(chunk, stored, in_->GetName(), scratch);
+  return *scratch;
+}
+
+void ColumnarReader::AppendRows(absl::string_view raw, size_t group,
+                                size_t file_col, size_t begin, size_t end,
+                                ColumnType* col) const {
+  const auto file_type = file_->footer.schema.feature_types[file_col];
+  const size_t n = end - begin;
+  std::visit(
+      [&](auto& vec) {
+        using T = typename std::decay_t<decltype(vec)>::value_type;
+        if constexpr (std::is_same_v<T, std::string> ||
+                      std::is_same_v<T, std::string_view>) {
+          const size_t rows = file_->footer.row_groups[group].rows;
+          const size_t values_begin = (rows + 1) * sizeof(uint64_t);
+          const size_t values_size = raw.size() - values_begin;
+          uint64_t offset;
+          std::memcpy(&offset, raw.data() + begin * sizeof(uint64_t),
+                      sizeof(offset));
+          for (size_t r = begin; r < end; r++) {
+            uint64_t next;
+            std::memcpy(&next, raw.data() + (r + 1) * sizeof(uint64_t),
+                        sizeof(next));
+            if (offset > next || next > values_size) {
+              YASL_THROW_INVALID_FORMAT(
+                  "Input columnar file format error: bad string offsets in "
+                  "row group {} of file '{}'",
+                  group, in_->GetName());
+            }
+            vec.push_back(T(raw.data() + values_begin + offset,
+                            next - offset));
+            offset = next;
+          }
+        } else {
+          const size_t old_size = vec.size();
+          vec.resize(old_size + n);
+          // only FLOAT and DOUBLE may differ from the file, see Init.
+          if constexpr (std::is_floating_point_v<T>) {
+            if (file_type == Schema::FLOAT) {
+              CopyValues<float>(raw, begin, n, vec.data() + old_size);
+            } else {
+              CopyValues<double>(raw, begin, n, vec.data() + old_size);
+            }
+          } else {
+            CopyValues<T>(raw, begin, n, vec.data() + old_size);
+          }
+        }
+      },
+      *col);
+}
+
+ColumnType ColumnarReader::EmptyCol(size_t selected, size_t reserve) const {
+  const auto type = selected_features_[selected].second;
+  if (type == Schema::STRING && options_.string_arena_columns) {
+    StringArenaColumnVector col;
+    col.reserve(reserve);
+    return col;
+  }
+  return MakeColumn(type, reserve);
+}
+
+bool ColumnarReader::Next(ColumnVectorBatch* data) {
+  YASL_ENFORCE(inited_, "Please Call Init before use reader");
+  if (options_.column_reader) {
+    data->Clear();
+    return NextCol(data);
+  } else {
+    return NextRow(data, options_.batch_size);
+  }
+}
+
+bool ColumnarReader::Next(size_t size, ColumnVectorBatch* data) {
+  YASL_ENFORCE(size != 0);
+  YASL_ENFORCE(inited_, "Please Call Init before use reader");
+  if (options_.column_reader) {
+    data->Clear();
+    size_t count = 0;
+    while (count < size) {
+      if (!NextCol(data)) {
+        break;
+      }
+      count++;
+    }
+    return count != 0;
+  } else {
+    return NextRow(data, size);
+  }
+}
+
+bool ColumnarReader::NextCol(ColumnVectorBatch* data) {
+  if (current_index_ == selected_features_.size()) {
+    return false;
+  }
+  const size_t col_index = current_index_++;
+  const size_t file_col = selected_features_[col_index].first;
+  ColumnType col = EmptyCol(col_index, total_rows_);
+  std::string scratch;
+  const auto& groups = file_->footer.row_groups;
+  for (size_t g = 0; g < groups.size(); g++) {
+    AppendRows(RawChunk(g, file_col, &scratch), g, file_col, 0,
+               groups[g].rows, &col);
+  }
+  data->AppendCol(std::move(col));
+  return true;
+}
+
+bool ColumnarReader::NextRow(ColumnVectorBatch* data, size_t batch_size) {
+  if (current_index_ >= total_rows_) {
+    // EOF
+    data->Clear();
+    return false;
+  }
+  const size_t count = std::min(batch_size, total_rows_ - current_index_);
+  if (selected_features_.empty()) {
+    current_index_ += count;
+    *data = ColumnVectorBatch::EmptyBatch(count);
+    return true;
+  }
+
+  // the columns of the last batch are refilled if they match.
+  std::vector<ColumnType> cols = data->ReleaseCols();
+  bool reuse = cols.size() == selected_features_.size();
+  for (size_t i = 0; reuse && i < cols.size(); i++) {
+    reuse = ColumnMatches(cols[i], selected_features_[i].second,
+                          options_.string_arena_columns);
+  }
+  if (reuse) {
+    for (auto& col : cols) {
+      ResetColumn(&col, count);
+    }
+  } else {
+    cols.clear();
+    cols.reserve(selected_features_.size());
+    for (size_t i = 0; i < selected_features_.size(); i++) {
+      cols.push_back(EmptyCol(i, count));
+    }
+  }
+  const auto& group_begin = file_->group_begin;
+  // rows of the file.
+  size_t row = first_row_ + current_index_;
+  const size_t end = row + count;
+  while (row < end) {
+    const size_t g = std::distance(group_begin.begin(),
+                                   std::upper_bound(group_begin.begin(),
+                                                    group_begin.end(), row)) -
+                     1;
+    if (g != cached_group_) {
+      for (size_t i = 0; i < selected_features_.size(); i++) {
+        cached_chunks_[i] =
+            RawChunk(g, selected_features_[i].first, &cached_scratch_[i]);
+      }
+      cached_group_ = g;
+    }
+    const size_t begin = row - group_begin[g];
+    const size_t group_end = std::min<size_t>(end, group_begin[g + 1]);
+    for (size_t i = 0; i < selected_features_.size(); i++) {
+      AppendRows(cached_chunks_[i], g, selected_features_[i].first, begin,
+                 group_end - group_begin[g], &cols[i]);
+    }
+    row = group_end;
+  }
+  current_index_ += count;
+
+  data->Reserve(selected_features_.size());
+  for (auto& c : cols) {
+    data->AppendCol(std::move(c));
+  }
+  return true;
+}
+
+void ColumnarReader::Seek(size_t index) {
+  YASL_ENFORCE(inited_, "Please Call Init before use reader");
+  if (options_.column_reader) {
+    YASL_ENFORCE(index < selected_features_.size(),
+                 "seek for col out of range, try {} max {}", index,
+                 selected_features_.size());
+  } else {
+    YASL_ENFORCE(index < total_rows_,
+                 "seek for row out of range, try {} max {}", index,
+                 total_rows_);
+  }
+  current_index_ = index;
+}
+
+size_t ColumnarReader::Tellg() {
+  YASL_ENFORCE(inited_, "Please Call Init before use reader");
+  YASL_ENFORCE(!options_.column_reader, "Not callable if read by column");
+  const size_t row = first_row_ + current_index_;
+  const auto& group_begin = file_->group_begin;
+  if (row >= group_begin.back()) {
+    return file_->chunks_end;
+  }
+  const size_t g = std::distance(group_begin.begin(),
+                                 std::upper_bound(group_begin.begin(),
+                                                  group_begin.end(), row)) -
+                   1;
+  return file_->footer.row_groups[g].chunks[0].offset;
+}
+
+std::unique_ptr<Reader> ColumnarReader::Spawn() {
+  YASL_ENFORCE(inited_, "CAN NOT Spawn before init");
+  std::unique_ptr<ColumnarReader> ret(
+      new ColumnarReader(options_, in_->Spawn()));
+  ret->inited_ = true;
+  ret->headers_ = headers_;
+  ret->selected_features_ = selected_features_;
+  ret->current_index_ = current_index_;
+  ret->total_rows_ = total_rows_;
+  ret->first_row_ = first_row_;
+  ret->file_ = file_;
+  ret->cached_scratch_.resize(selected_features_.size());
+  ret->cached_chunks_.resize(selected_features_.size());
+  return ret;
+}
+
+std::vector<std::unique_ptr<Reader>> ColumnarReader::Split(size_t n) {
+  YASL_ENFORCE(inited_, "CAN NOT Split before init");
+  YASL_ENFORCE(!options_.column_reader, "Not callable if read by column");
+  YASL_ENFORCE(n > 0);
+  std::vector<std::unique_ptr<Reader>> ret;
+  ret.reserve(n);
+  for (size_t k = 0; k < n; k++) {
+    const size_t begin = total_rows_ * k / n;
+    const size_t end = total_rows_ * (k + 1) / n;
+    std::unique_ptr<ColumnarReader> shard(
+        new ColumnarReader(options_, in_->Spawn()));
+    shard->inited_ = true;
+    shard->headers_ = headers_;
+    shard->selected_features_ = selected_features_;
+    shard->total_rows_ = end - begin;
+    shard->first_row_ = first_row_ + begin;
+    shard->file_ = file_;
+    shard->cached_scratch_.resize(selected_features_.size());
+    shard->cached_chunks_.resize(selected_features_.size());
+    ret.push_back(std::move(shard));
+  }
+  return ret;
+}
+
+}  // namespace yasl::io
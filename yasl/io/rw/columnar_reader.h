@@ -0,0 +1,115 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+#include "yasl/io/rw/reader.h"
+
+namespace yasl::io {
+
+// reads the yasl columnar format written by ColumnarWriter. local files are
+// mmapped, other inputs are loaded into memory by Init. FLOAT and DOUBLE
+// features may be read as either type, the row_reader_* and
+// column_reader_memory_budget options do not apply.
+class ColumnarReader : public Reader {
+ public:
+  ColumnarReader(ReaderOptions options, std::unique_ptr<InputStream> in);
+
+  ~ColumnarReader() override = default;
+
+  void Init() override;
+
+  const std::vector<std::string>& Headers() const override {
+    YASL_ENFORCE(inited_, "Please Call Init before use reader");
+    return headers_;
+  }
+
+  bool Next(ColumnVectorBatch* data) override;
+
+  bool Next(size_t size, ColumnVectorBatch* data) override;
+
+  size_t Tell() const override {
+    YASL_ENFORCE(inited_, "Please Call Init before use reader");
+    return current_index_;
+  }
+
+  void Seek(size_t index) override;
+
+  size_t Rows() const override {
+    YASL_ENFORCE(inited_, "Please Call Init before use reader");
+    return total_rows_;
+  }
+
+  size_t Cols() const override {
+    YASL_ENFORCE(inited_, "Please Call Init before use reader");
+    return selected_features_.size();
+  }
+
+  std::unique_ptr<Reader> Spawn() override;
+
+  std::vector<std::unique_ptr<Reader>> Split(size_t n) override;
+
+  size_t GetLength() const override {
+    YASL_ENFORCE(inited_, "Please Call Init before use reader");
+    return in_->GetLength();
+  }
+
+  /**
+   * offset of the row group holding the next row, the end of all chunks at
+   * EOF.
+   */
+  size_t Tellg() override;
+
+ private:
+  struct File;
+
+  bool NextCol(ColumnVectorBatch*);
+  bool NextRow(ColumnVectorBatch*, size_t);
+  // raw chunk of a file column in a row group, decompressed into scratch
+  // if needed.
+  absl::string_view RawChunk(size_t group, size_t file_col,
+                             std::string* scratch) const;
+  // appends rows [begin, end) of a raw chunk of a row group to col.
+  void AppendRows(absl::string_view raw, size_t group, size_t file_col,
+                  size_t begin, size_t end, ColumnType* col) const;
+  ColumnType EmptyCol(size_t selected, size_t reserve) const;
+
+  const ReaderOptions options_;
+  bool inited_;
+  std::unique_ptr<InputStream> in_;
+  std::vector<std::string> headers_;
+  // selected_features' index & type.
+  std::vector<std::pair<size_t, Schema::Type>> selected_features_;
+  // current row or col.
+  size_t current_index_;
+  size_t total_rows_;
+  // file row of row 0, not 0 for Split() readers.
+  size_t first_row_;
+  // shared by spawned readers.
+  std::shared_ptr<const File> file_;
+  // row reader: raw chunks of the row group last read.
+  size_t cached_group_;
+  std::vector<absl::string_view> cached_chunks_;
+  std::vector<std::string> cached_scratch_;
+};
+
+}  // namespace yasl::io
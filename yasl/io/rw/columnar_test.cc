@@ -0,0 +1,307 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <unistd.h>
+
+#include <filesystem>
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/io/rw/columnar_reader.h"
+#include "yasl/io/rw/columnar_writer.h"
+#include "yasl/io/stream/file_io.h"
+#include "yasl/io/stream/mem_io.h"
+
+namespace yasl::io {
+
+namespace {
+
+Schema TestSchema() {
+  Schema s;
+  s.feature_types = {Schema::STRING, Schema::FLOAT, Schema::DOUBLE};
+  s.feature_names = {"id", "f1", "f2"};
+  return s;
+}
+
+ColumnVectorBatch MakeBatch(size_t begin, size_t rows) {
+  std::vector<std::string> ids;
+  std::vector<float> f1;
+  std::vector<double> f2;
+  for (size_t i = begin; i < begin + rows; i++) {
+    ids.push_back(i % 3 == 0 ? "" : fmt::format("u{}", i));
+    f1.push_back(i * 0.1f);
+    f2.push_back(-1.0 / (i + 1));
+  }
+  ColumnVectorBatch batch;
+  batch.AppendCol(std::move(ids));
+  batch.AppendCol(std::move(f1));
+  batch.AppendCol(std::move(f2));
+  return batch;
+}
+
+// batches of 100, 0, 1 and 250 rows.
+std::string WriteFile(ColumnarCompression compression) {
+  std::string out_buf;
+  WriterOptions w_op;
+  w_op.file_schema = TestSchema();
+  ColumnarWriter writer(w_op, std::make_unique<MemOutputStream>(&out_buf),
+                        compression);
+  writer.Init();
+  EXPECT_EQ(writer.Tellp(), 8);
+  size_t begin = 0;
+  for (size_t rows : {100, 0, 1, 250}) {
+    writer.Add(MakeBatch(begin, rows));
+    begin += rows;
+  }
+  writer.Close();
+  return out_buf;
+}
+
+}  // namespace
+
+class ColumnarTest : public ::testing::TestWithParam<ColumnarCompression> {};
+
+INSTANTIATE_TEST_SUITE_P(Compression, ColumnarTest,
+                         testing::Values(ColumnarCompression::NONE,
+                                         ColumnarCompression::ZLIB));
+
+TEST_P(ColumnarTest, RowReader) {
+  const auto data = WriteFile(GetParam());
+  const auto expected = MakeBatch(0, 351);
+
+  ReaderOptions r_ops;
+  r_ops.file_schema = TestSchema();
+  r_ops.batch_size = 37;
+  ColumnarReader reader(r_ops, std::make_unique<MemInputStream>(data));
+  reader.Init();
+  EXPECT_EQ(reader.Headers(), TestSchema().feature_names);
+  EXPECT_EQ(reader.Rows(), 351);
+  EXPECT_EQ(reader.Cols(), 3);
+  EXPECT_EQ(reader.Tellg(), 8);
+
+  ColumnVectorBatch batch;
+  size_t row = 0;
+  const double* values = nullptr;
+  while (reader.Next(&batch)) {
+    ASSERT_EQ(batch.Shape().cols, 3);
+    // later batches refill the columns of the first one.
+    if (values == nullptr) {
+      values = batch.Col<double>(2).data();
+    }
+    EXPECT_EQ(batch.Col<double>(2).data(), values);
+    for (size_t r = 0; r < batch.Shape().rows; r++, row++) {
+      EXPECT_EQ(batch.At<std::string>(r, 0), expected.At<std::string>(row, 0));
+      EXPECT_EQ(batch.At<float>(r, 1), expected.At<float>(row, 1));
+      EXPECT_EQ(batch.At<double>(r, 2), expected.At<double>(row, 2));
+    }
+  }
+  EXPECT_EQ(row, 351);
+  EXPECT_EQ(reader.Tell(), 351);
+  EXPECT_FALSE(reader.Next(&batch));
+
+  reader.Seek(99);
+  auto spawned = reader.Spawn();
+  EXPECT_TRUE(reader.Next(3, &batch));
+  EXPECT_EQ(batch.Shape().rows, 3);
+  EXPECT_EQ(batch.At<std::string>(1, 0), "u100");
+  EXPECT_EQ(batch.At<std::string>(2, 0), "u101");
+  EXPECT_EQ(spawned->Tell(), 99);
+  EXPECT_TRUE(spawned->Next(1, &batch));
+  EXPECT_EQ(batch.At<double>(0, 2), -1.0 / 100);
+  EXPECT_THROW(reader.Seek(351), EnforceNotMet);
+}
+
+TEST_P(ColumnarTest, ColReader) {
+  const auto data = WriteFile(GetParam());
+  const auto expected = MakeBatch(0, 351);
+
+  const std::string file_name = fmt::format("columnar_test.{}.ycol", getpid());
+  {
+    FileOutputStream out(file_name);
+    out.Write(data);
+    out.Close();
+  }
+
+  // stored FLOAT read as DOUBLE and the other way round.
+  ReaderOptions r_ops;
+  r_ops.file_schema.feature_types = {Schema::FLOAT, Schema::STRING,
+                                     Schema::DOUBLE};
+  r_ops.file_schema.feature_names = {"f2", "id", "f1"};
+  r_ops.column_reader = true;
+  ColumnarReader reader(r_ops, std::make_unique<FileInputStream>(file_name));
+  reader.Init();
+  EXPECT_EQ(reader.Rows(), 351);
+  ColumnVectorBatch batch;
+  ASSERT_TRUE(reader.Next(&batch));
+  for (size_t r = 0; r < 351; r++) {
+    EXPECT_EQ(batch.At<float>(r, 0), static_cast<float>(-1.0 / (r + 1)));
+  }
+  ASSERT_TRUE(reader.Next(5, &batch));
+  ASSERT_EQ(batch.Shape().cols, 2);
+  EXPECT_EQ(batch.Col<std::string>(0), expected.Col<std::string>(0));
+  for (size_t r = 0; r < 351; r++) {
+    EXPECT_EQ(batch.At<double>(r, 1), r * 0.1f);
+  }
+  EXPECT_FALSE(reader.Next(&batch));
+  EXPECT_THROW(reader.Tellg(), EnforceNotMet);
+  std::filesystem::remove(file_name);
+}
+
+TEST_P(ColumnarTest, StringArenaColumns) {
+  ReaderOptions r_ops;
+  r_ops.file_schema = TestSchema();
+  r_ops.string_arena_columns = true;
+  r_ops.batch_size = 120;
+  const auto data = WriteFile(GetParam());
+  ColumnarReader reader(r_ops, std::make_unique<MemInputStream>(data));
+  reader.Init();
+  ColumnVectorBatch batch;
+  ASSERT_TRUE(reader.Next(&batch));
+  const auto& ids = std::get<StringArenaColumnVector>(batch.RawCol(0));
+  ASSERT_EQ(ids.size(), 120);
+  const auto expected = MakeBatch(0, 120);
+  for (size_t r = 0; r < 120; r++) {
+    EXPECT_EQ(ids[r], expected.At<std::string>(r, 0));
+  }
+
+  // and written back as they are.
+  std::string out_buf;
+  WriterOptions w_op;
+  w_op.file_schema = TestSchema();
+  ColumnarWriter writer(w_op, std::make_unique<MemOutputStream>(&out_buf),
+                        GetParam());
+  writer.Init();
+  writer.Add(batch);
+  writer.Close();
+  r_ops.string_arena_columns = false;
+  ColumnarReader round_trip(r_ops, std::make_unique<MemInputStream>(out_buf));
+  round_trip.Init();
+  ASSERT_TRUE(round_trip.Next(&batch));
+  EXPECT_EQ(batch.Col<std::string>(0), expected.Col<std::string>(0));
+}
+
+TEST_P(ColumnarTest, Split) {
+  const auto data = WriteFile(GetParam());
+  ReaderOptions r_ops;
+  r_ops.file_schema = TestSchema();
+  r_ops.batch_size = 37;
+  ColumnarReader reader(r_ops, std::make_unique<MemInputStream>(data));
+  reader.Init();
+  reader.Seek(1);
+  auto shards = reader.Split(4);
+  ASSERT_EQ(shards.size(), 4);
+  // splits all rows, not the ones after Tell().
+  std::vector<double> values;
+  for (auto& shard : shards) {
+    EXPECT_EQ(shard->Rows(), shard == shards[0] ? 87 : 88);
+    ColumnVectorBatch batch;
+    while (shard->Next(&batch)) {
+      const auto& col = batch.Col<double>(2);
+      values.insert(values.end(), col.begin(), col.end());
+    }
+  }
+  EXPECT_EQ(values, MakeBatch(0, 351).Col<double>(2));
+
+  // shards of a shard.
+  auto last = shards.back()->Split(2);
+  last[1]->Seek(0);
+  ColumnVectorBatch batch;
+  ASSERT_TRUE(last[1]->Next(1, &batch));
+  EXPECT_EQ(batch.At<std::string>(0, 0), "u307");
+  EXPECT_EQ(last[1]->Rows(), 44);
+  reader.Seek(308);
+  EXPECT_EQ(last[1]->Tellg(), reader.Tellg());
+  shards[0]->Seek(0);
+  EXPECT_EQ(shards[0]->Tellg(), 8);
+}
+
+TEST(Columnar, IntegerAndFixedPoint) {
+  Schema s;
+  s.feature_types = {Schema::INT32, Schema::INT64, Schema::UINT64,
+                     Schema::FXP64, Schema::FXP128};
+  s.feature_names = {"i32", "i64", "u64", "fxp64", "fxp128"};
+  ColumnVectorBatch batch;
+  batch.AppendCol(Int32ColumnVector{-1, 2, 3});
+  batch.AppendCol(Int64ColumnVector{int64_t(1) << 40, -5, 6});
+  batch.AppendCol(Uint64ColumnVector{uint64_t(-1), 8, 9});
+  batch.AppendCol(Uint64ColumnVector{10, 11, 12});
+  batch.AppendCol(Uint128ColumnVector{MakeUint128(1, 2), 14, 15});
+
+  std::string out_buf;
+  WriterOptions w_op;
+  w_op.file_schema = s;
+  ColumnarWriter writer(w_op, std::make_unique<MemOutputStream>(&out_buf));
+  writer.Init();
+  writer.Add(batch);
+  writer.Close();
+
+  ReaderOptions r_ops;
+  r_ops.file_schema = s;
+  ColumnarReader reader(r_ops, std::make_unique<MemInputStream>(out_buf));
+  reader.Init();
+  ColumnVectorBatch read;
+  ASSERT_TRUE(reader.Next(&read));
+  EXPECT_EQ(read.Col<int32_t>(0), batch.Col<int32_t>(0));
+  EXPECT_EQ(read.Col<int64_t>(1), batch.Col<int64_t>(1));
+  EXPECT_EQ(read.Col<uint64_t>(2), batch.Col<uint64_t>(2));
+  EXPECT_EQ(read.Col<uint64_t>(3), batch.Col<uint64_t>(3));
+  EXPECT_EQ(read.Col<uint128_t>(4), batch.Col<uint128_t>(4));
+
+  // integers are not converted.
+  r_ops.file_schema.feature_types[0] = Schema::INT64;
+  ColumnarReader mismatch(r_ops, std::make_unique<MemInputStream>(out_buf));
+  EXPECT_THROW(mismatch.Init(), yasl::ArgumentError);
+}
+
+TEST(Columnar, Compression) {
+  EXPECT_LT(WriteFile(ColumnarCompression::ZLIB).size(),
+            WriteFile(ColumnarCompression::NONE).size());
+}
+
+TEST(Columnar, Errors) {
+  const auto data = WriteFile(ColumnarCompression::ZLIB);
+  auto init = [](std::string data, Schema s) {
+    ReaderOptions r_ops;
+    r_ops.file_schema = std::move(s);
+    ColumnarReader reader(r_ops, std::make_unique<MemInputStream>(data));
+    reader.Init();
+  };
+
+  EXPECT_NO_THROW(init(data, TestSchema()));
+  EXPECT_THROW(init("id,f1,f2\n", TestSchema()), yasl::InvalidFormat);
+  EXPECT_THROW(init(data.substr(0, data.size() - 1), TestSchema()),
+               yasl::InvalidFormat);
+  {
+    // footer size that cuts the footer.
+    auto bad = data;
+    const size_t footer_size = bad.size() - 12 - 8;
+    bad.replace(bad.size() - 12, 8, std::string(8, '\0'));
+    bad.replace(bad.size() - 12, 1, 1, static_cast<char>(footer_size & 0xff));
+    EXPECT_THROW(init(bad, TestSchema()), yasl::InvalidFormat);
+  }
+
+  Schema missing;
+  missing.feature_types = {Schema::FLOAT};
+  missing.feature_names = {"f3"};
+  EXPECT_THROW(init(data, missing), yasl::ArgumentError);
+  Schema mismatch;
+  mismatch.feature_types = {Schema::STRING};
+  mismatch.feature_names = {"f1"};
+  EXPECT_THROW(init(data, mismatch), yasl::ArgumentError);
+}
+
+}  // namespace yasl::io
@@ -0,0 +1,149 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "yasl/io/rw/columnar_writer.h"
+
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "yasl/base/exception.h"
+
+namespace yasl::io {
+
+namespace {
+
+void AppendValues(Schema::Type type, const ColumnType& col,
+                  std::string* raw) {
+  YASL_ENFORCE(col.index() == MakeColumn(type, 0).index(),
+               "column does not hold Schema::type {}", type);
+  std::visit(
+      [raw](const auto& values) {
+        if constexpr (kIsNumericColumn<std::decay_t<decltype(values)>>) {
+          raw->append(reinterpret_cast<const char*>(values.data()),
+                      values.size() * sizeof(values[0]));
+        }
+      },
+      col);
+}
+
+void AppendStrings(const ColumnType& col, std::string* raw) {
+  if (const auto* arena = std::get_if<StringArenaColumnVector>(&col)) {
+    const auto& offsets = arena->offsets();
+    raw->append(reinterpret_cast<const char*>(offsets.data()),
+                offsets.size() * sizeof(uint64_t));
+    raw->append(arena->arena());
+    return;
+  }
+  const auto& strings = std::get<StringColumnVector>(col);
+  uint64_t offset = 0;
+  for (const auto& s : strings) {
+    raw->append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    offset += s.size();
+  }
+  raw->append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+  for (const auto& s : strings) {
+    raw->append(s);
+  }
+}
+
+}  // namespace
+
+ColumnarWriter::ColumnarWriter(WriterOptions op,
+                               std::unique_ptr<OutputStream> out,
+                               ColumnarCompression compression)
+    : options_(std::move(op)),
+      compression_(compression),
+      inited_(false),
+      closed_(false),
+      out_(std::move(out)),
+      offset_(0) {
+  YASL_ENFORCE(!options_.file_schema.feature_names.empty());
+  YASL_ENFORCE(options_.file_schema.feature_names.size() ==
+               options_.file_schema.feature_types.size());
+  YASL_ENFORCE(out_->Tellp() == 0);
+}
+
+void ColumnarWriter::Write(absl::string_view data) {
+  out_->Write(data.data(), data.size());
+  offset_ += data.size();
+}
+
+void ColumnarWriter::Init() {
+  YASL_ENFORCE(!inited_, "DO NOT call init multiply times");
+  footer_.schema = options_.file_schema;
+  std::string header(columnar::kMagic, columnar::kMagicSize);
+  header.append(reinterpret_cast<const char*>(&columnar::kVersion),
+                sizeof(columnar::kVersion));
+  Write(header);
+  inited_ = true;
+}
+
+bool ColumnarWriter::Add(const ColumnVectorBatch& data) {
+  YASL_ENFORCE(inited_, "Please Call Init before use writer");
+  YASL_ENFORCE(!closed_, "writer is closed");
+  const size_t rows = data.Shape().rows;
+  const size_t cols = data.Shape().cols;
+  YASL_ENFORCE(cols == options_.file_schema.feature_names.size());
+  if (rows == 0) {
+    return true;
+  }
+  const auto& types = options_.file_schema.feature_types;
+
+  columnar::RowGroupMeta group{rows, {}};
+  for (size_t c = 0; c < cols; c++) {
+    raw_.clear();
+    if (types[c] == Schema::STRING) {
+      AppendStrings(data.RawCol(c), &raw_);
+    } else {
+      AppendValues(types[c], data.RawCol(c), &raw_);
+    }
+
+    columnar::ChunkMeta chunk{offset_, raw_.size(), raw_.size(),
+                              ColumnarCompression::NONE};
+    const std::string* stored = &raw_;
+    if (compression_ != ColumnarCompression::NONE) {
+      columnar::Compress(compression_, raw_, &compressed_);
+      // chunks that do not shrink stay raw, they load by a plain copy.
+      if (compressed_.size() < raw_.size()) {
+        stored = &compressed_;
+        chunk.stored_size = compressed_.size();
+        chunk.compression = compression_;
+      }
+    }
+    Write(*stored);
+    const size_t padding = (columnar::kChunkAlignment -
+                            offset_ % columnar::kChunkAlignment) %
+                           columnar::kChunkAlignment;
+    Write(absl::string_view("\0\0\0\0\0\0\0", padding));
+    group.chunks.push_back(chunk);
+  }
+  footer_.row_groups.push_back(std::move(group));
+  return true;
+}
+
+void ColumnarWriter::Flush() { out_->Flush(); }
+
+void ColumnarWriter::Close() {
+  if (inited_ && !closed_) {
+    std::string footer;
+    columnar::AppendFooter(footer_, &footer);
+    Write(footer);
+    closed_ = true;
+  }
+  out_->Close();
+}
+
+}  // namespace yasl::io
@@ -0,0 +1,64 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+#include <memory>
+#include <string>
+
+#include "yasl/io/rw/columnar_format.h"
+#include "yasl/io/rw/schema.h"
+#include "yasl/io/rw/writer.h"
+
+namespace yasl::io {
+
+// writes the yasl columnar format, see columnar_format.h. each Add is
+// stored as one row group, float_precision is not used. the footer is
+// written by Close.
+class ColumnarWriter : public Writer {
+ public:
+  ColumnarWriter(WriterOptions, std::unique_ptr<OutputStream>,
+                 ColumnarCompression compression = ColumnarCompression::NONE);
+
+  ~ColumnarWriter() override = default;
+
+  void Init() override;
+
+  bool Add(const ColumnVectorBatch&) override;
+
+  void Flush() override;
+
+  void Close() override;
+
+  size_t Tellp() override {
+    YASL_ENFORCE(inited_, "Please Call Init before use writer");
+    return offset_;
+  }
+
+ private:
+  void Write(absl::string_view data);
+
+  const WriterOptions options_;
+  const ColumnarCompression compression_;
+  bool inited_;
+  bool closed_;
+  std::unique_ptr<OutputStream> out_;
+  size_t offset_;
+  columnar::Footer footer_;
+  // reused chunk buffers.
+  std::string raw_;
+  std::string compressed_;
+};
+
+}  // namespace yasl::io
@@ -24,6 +24,7 @@
 #include <random>
 #include <string>
 #include <utility>
+#include <variant>
 
 #include "absl/strings/ascii.h"
 #include "absl/strings/numbers.h"
@@ -31,13 +32,141 @@
 #include "fmt/format.h"
 
 #include "yasl/base/exception.h"
+#include "yasl/io/rw/csv_row_index.h"
+#include "yasl/io/rw/csv_tokenizer.h"
 #include "yasl/io/rw/float.h"
 #include "yasl/io/rw/mmapped_file.h"
 #include "yasl/io/stream/file_io.h"
+#include "yasl/io/stream/mmap_io.h"
+#include "yasl/utils/metrics.h"
+#include "yasl/utils/parallel.h"
 
 namespace yasl::io {
 
 static const size_t kUnknowTotalRow = size_t(-1);
+static const size_t kNoRangeEnd = size_t(-1);
+// bytes of the csv body indexed at a time by the column reader.
+static const size_t kIndexChunkBytes = 16 * 1024 * 1024;
+// bytes of a batch parsed by one task, see row_reader_parallel_parse.
+static const size_t kParseRangeBytes = 64 * 1024;
+
+static const char* TypeName(Schema::Type type) {
+  switch (type) {
+    case Schema::STRING:
+      return "string";
+    case Schema::FLOAT:
+      return "float";
+    case Schema::DOUBLE:
+      return "double";
+    case Schema::INT32:
+      return "int32";
+    case Schema::INT64:
+      return "int64";
+    case Schema::UINT64:
+      return "uint64";
+    case Schema::FXP64:
+      return "fxp64";
+    case Schema::FXP128:
+      return "fxp128";
+  }
+  return "unknown";
+}
+
+// parses a non STRING field and appends it to col, see MakeColumn.
+// false if field is not a valid value of type.
+static bool AppendNumber(absl::string_view field, Schema::Type type,
+                         int fxp_bits, ColumnType* col) {
+  switch (type) {
+    case Schema::FLOAT: {
+      float value = 0;
+      if (!FloatFromString(field, &value)) {
+        return false;
+      }
+      std::get<FloatColumnVector>(*col).push_back(value);
+      return true;
+    }
+    case Schema::DOUBLE: {
+      double value = 0;
+      if (!FloatFromString(field, &value)) {
+        return false;
+      }
+      std::get<DoubleColumnVector>(*col).push_back(value);
+      return true;
+    }
+    case Schema::INT32: {
+      int32_t value = 0;
+      if (!absl::SimpleAtoi(field, &value)) {
+        return false;
+      }
+      std::get<Int32ColumnVector>(*col).push_back(value);
+      return true;
+    }
+    case Schema::INT64: {
+      int64_t value = 0;
+      if (!absl::SimpleAtoi(field, &value)) {
+        return false;
+      }
+      std::get<Int64ColumnVector>(*col).push_back(value);
+      return true;
+    }
+    case Schema::UINT64: {
+      uint64_t value = 0;
+      if (!absl::SimpleAtoi(field, &value)) {
+        return false;
+      }
+      std::get<Uint64ColumnVector>(*col).push_back(value);
+      return true;
+    }
+    case Schema::FXP64: {
+      uint64_t value = 0;
+      if (!FxpFromString(field, fxp_bits, &value)) {
+        return false;
+      }
+      std::get<Uint64ColumnVector>(*col).push_back(value);
+      return true;
+    }
+    case Schema::FXP128: {
+      uint128_t value = 0;
+      if (!FxpFromString(field, fxp_bits, &value)) {
+        return false;
+      }
+      std::get<Uint128ColumnVector>(*col).push_back(value);
+      return true;
+    }
+    default:
+      YASL_THROW("unknow Schema::type {}", type);
+  }
+}
+
+// splits the first max_fields fields of line into fields, returns the
+// number of fields of the line.
+static size_t SplitFields(absl::string_view line, char delimiter,
+                          size_t max_fields,
+                          std::vector<absl::string_view>* fields) {
+  fields->clear();
+  size_t begin = 0;
+  while (fields->size() < max_fields) {
+    const size_t end = line.find(delimiter, begin);
+    if (end == absl::string_view::npos) {
+      fields->push_back(line.substr(begin));
+      return fields->size();
+    }
+    fields->push_back(line.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return max_fields + 1 +
+         std::count(line.begin() + begin, line.end(), delimiter);
+}
+
+// appends to either kind of string column.
+static void AppendString(absl::string_view value, ColumnType* col) {
+  if (auto* arena = std::get_if<StringArenaColumnVector>(col)) {
+    arena->push_back(std::string_view(value.data(), value.size()));
+  } else {
+    std::get<StringColumnVector>(*col).emplace_back(value.data(),
+                                                    value.size());
+  }
+}
 
 CsvReader::CsvReader(ReaderOptions options, std::unique_ptr<InputStream> in,
                      char field_delimiter, char line_delimiter)
@@ -47,7 +176,23 @@ CsvReader::CsvReader(ReaderOptions options, std::unique_ptr<InputStream> in,
       inited_(false),
       in_(std::move(in)),
       current_index_(0),
-      total_rows_(kUnknowTotalRow) {}
+      total_rows_(kUnknowTotalRow),
+      range_pos_(0),
+      range_end_(kNoRangeEnd) {}
+
+struct CsvReader::ColumnIndex {
+  std::unique_ptr<MmappedFile> mmap;
+  // body of inputs that are not local files.
+  std::string buffer;
+  // rows after the header.
+  absl::string_view body;
+  // per selected feature, FLOAT and DOUBLE decoded, STRING unused.
+  std::vector<ColumnType> values;
+  // per selected feature, STRING fields as (offset in body, size).
+  std::vector<std::vector<std::pair<uint64_t, uint32_t>>> strings;
+  // of buffer, values and strings, the mmap is not charged.
+  MemoryCharge memory{MemoryTag::Get("io.csv")};
+};
 
 CsvReader::MmapDirGuard::~MmapDirGuard() {
   if (!dir_.empty()) {
@@ -62,6 +207,8 @@ CsvReader::MmapDirGuard::~MmapDirGuard() {
 
 void CsvReader::Init() {
   YASL_ENFORCE(!inited_, "DO NOT call init multiply times");
+  YASL_ENFORCE(!options_.column_reader || !options_.row_reader_tail,
+               "Can't tail a file read by column");
 
   ParseHeader();
 
@@ -92,21 +239,34 @@ void CsvReader::Init() {
   }
 
   if (options_.column_reader) {
-    // split features into mmap files.
-    BuildMmapFiles();
+    if (in_->GetLength() <= options_.column_reader_memory_budget) {
+      BuildColumnIndex();
+    } else {
+      // split features into mmap files.
+      BuildMmapFiles();
+    }
   } else {
     // init rows_map_, in_->Tell() is point to ROW 0's start position.
     UpdateRowMap();
-    if (options_.row_reader_count_lines) {
+    if (options_.row_reader_tail) {
+      // rows known so far.
+      total_rows_ = 0;
+    }
+    if (!options_.row_index_path.empty()) {
+      LoadOrBuildRowIndex();
+    } else if (options_.row_reader_count_lines) {
       CountLines();
     }
   }
   inited_ = true;
-  Seek(0);
+  // a tailing reader resumes after the committed rows.
+  Seek(options_.row_reader_tail && !options_.row_index_path.empty()
+           ? total_rows_
+           : 0);
 }
 
 void CsvReader::CountLines() {
-  while (in_->GetLine(&current_line_, line_delimiter_)) {
+  while (NextLine(nullptr)) {
     current_index_++;
     if (current_index_ % options_.batch_size == 0) {
       UpdateRowMap();
@@ -115,10 +275,53 @@ void CsvReader::CountLines() {
   total_rows_ = current_index_;
 }
 
+void CsvReader::LoadOrBuildRowIndex() {
+  CsvRowIndex index;
+  const bool loaded =
+      LoadCsvRowIndex(options_.row_index_path, &index) &&
+      index.header_crc == header_crc_ &&
+      index.rows_map.begin()->second == rows_map_.begin()->second;
+  if (options_.row_reader_tail) {
+    // the file may have grown since the commit, but the committed rows must
+    // still end with a complete line.
+    if (loaded && index.file_length <= in_->GetLength()) {
+      std::string line;
+      in_->Seekg(index.file_length - 1);
+      in_->GetLine(&line, line_delimiter_);
+      if (line.empty() && !in_->Eof()) {
+        rows_map_ = std::move(index.rows_map);
+        total_rows_ = index.total_rows;
+      }
+    }
+    return;
+  }
+  if (loaded && index.file_length == in_->GetLength()) {
+    rows_map_ = std::move(index.rows_map);
+    total_rows_ = index.total_rows;
+    return;
+  }
+  CountLines();
+  index.file_length = in_->GetLength();
+  index.header_crc = header_crc_;
+  index.total_rows = total_rows_;
+  index.rows_map = rows_map_;
+  SaveCsvRowIndex(options_.row_index_path, index);
+}
+
 bool CsvReader::NextLine(std::vector<absl::string_view>* fields) {
-  if (!in_->GetLine(&current_line_, line_delimiter_)) {
+  if (range_pos_ >= range_end_) {
     return false;
   }
+  if (!in_->GetLine(&current_line_, line_delimiter_) ||
+      (options_.row_reader_tail && in_->Eof())) {
+    if (options_.row_reader_tail) {
+      // at the end, or in a line still being written. rewinds to the line
+      // and clears EOF, so that a later call reads it once complete.
+      in_->Seekg(range_pos_);
+    }
+    return false;
+  }
+  range_pos_ += current_line_.size() + 1;
   if (fields != nullptr) {
     *fields = absl::StrSplit(current_line_, field_delimiter_);
   }
@@ -129,6 +332,7 @@ void CsvReader::ParseHeader() {
   std::vector<absl::string_view> headers;
   YASL_ENFORCE(NextLine(&headers), "Can't get header from file '{}'",
                in_->GetName());
+  header_crc_ = CsvHeaderChecksum(current_line_);
   headers_.reserve(headers.size());
   for (auto& h : headers) {
     auto striped_h = static_cast<std::string>(absl::StripAsciiWhitespace(h));
@@ -174,13 +378,19 @@ void CsvReader::BuildMmapFiles() {
     cols_mmap_file_.push_back(mmap_name);
     oss.emplace_back(new FileOutputStream(mmap_name));
   }
+  // one value of each numeric feature.
+  std::vector<ColumnType> values;
+  InitBatchCols(&values, 1);
+  const size_t used_fields = UsedFields();
   size_t row_count = 0;
-  while (NextLine(&fields)) {
-    if (fields.size() != headers_.size()) {
+  while (NextLine(nullptr)) {
+    const size_t field_count =
+        SplitFields(current_line_, field_delimiter_, used_fields, &fields);
+    if (field_count != headers_.size()) {
       YASL_THROW_INVALID_FORMAT(
           "Input CSV file format error: "
           "Line#{} '{}' fields size '{}' != header's size '{}'",
-          row_count, current_line_, fields.size(), headers_.size());
+          row_count, current_line_, field_count, headers_.size());
     }
 
     row_count++;
@@ -202,37 +412,27 @@ void CsvReader::BuildMmapFiles() {
           oss[i]->Write(data, len);
           break;
         }
-        case Schema::FLOAT: {
-          // FLOAT mmap format:
-          // │ FLOAT │ FLOAT │ ...
-          float value = 0;
-          if (!FloatFromString(field, &value)) {
+        default: {
+          // numeric mmap format, the values as in memory:
+          // │ VALUE │ VALUE │ ...
+          auto& value = values[i];
+          std::visit([](auto& col) { col.clear(); }, value);
+          if (!AppendNumber(field, type, options_.fxp_bits, &value)) {
             YASL_THROW_INVALID_FORMAT(
                 "Input CSV file format error: Cannot convert '{}' to "
-                "float, column '{}', {} line '{}', file '{}'",
-                std::string(field), headers_[index], current_index_,
-                current_line_, in_->GetName());
+                "{}, column '{}', {} line '{}', file '{}'",
+                std::string(field), TypeName(type), headers_[index],
+                current_index_, current_line_, in_->GetName());
           }
-          oss[i]->Write(reinterpret_cast<char*>(&value), sizeof(float));
+          std::visit(
+              [&](auto& col) {
+                if constexpr (kIsNumericColumn<std::decay_t<decltype(col)>>) {
+                  oss[i]->Write(col.data(), sizeof(col[0]));
+                }
+              },
+              value);
           break;
         }
-        case Schema::DOUBLE: {
-          // DOUBLE mmap format:
-          // │ DOUBLE │ DOUBLE │ ...
-          double value = 0;
-          if (!FloatFromString(field, &value)) {
-            YASL_THROW_INVALID_FORMAT(
-                "Input CSV file format error: Cannot convert '{}' to "
-                "double, column '{}', {} line '{}', file '{}'",
-                std::string(field), headers_[index], current_index_,
-                current_line_, in_->GetName());
-          }
-
-          oss[i]->Write(reinterpret_cast<char*>(&value), sizeof(double));
-          break;
-        }
-        default:
-          YASL_THROW("unknow Schema::type {}", type);
       }
     }
   }
@@ -254,10 +454,116 @@ void CsvReader::BuildMmapFiles() {
   }
 }
 
+void CsvReader::BuildColumnIndex() {
+  static auto& time = GetHistogram("yasl_csv_column_index_us");
+  ScopedTimer timer(&time);
+  auto index = std::make_shared<ColumnIndex>();
+  if (dynamic_cast<FileInputStream*>(in_.get()) != nullptr ||
+      dynamic_cast<MmapInputStream*>(in_.get()) != nullptr) {
+    const size_t body_begin = in_->Tellg();
+    index->mmap = std::make_unique<MmappedFile>(in_->GetName());
+    index->body = absl::string_view(index->mmap->data(), index->mmap->size())
+                      .substr(std::min(body_begin, index->mmap->size()));
+  } else {
+    while (NextLine(nullptr)) {
+      index->buffer.append(current_line_);
+      index->buffer.push_back(line_delimiter_);
+    }
+    index->body = index->buffer;
+  }
+  InitBatchCols(&index->values, 0);
+  index->strings.resize(selected_features_.size());
+
+  const absl::string_view body = index->body;
+  size_t row_count = 0;
+  std::vector<uint32_t> structurals;
+  std::vector<absl::string_view> fields;
+  absl::string_view line;
+  const size_t used_fields = UsedFields();
+  size_t field_count;
+  std::string tail;
+  size_t pos = 0;
+  while (pos < body.size()) {
+    // chunks end after a line delimiter, lines longer than a chunk are
+    // taken whole.
+    size_t end = std::min(body.size(), pos + kIndexChunkBytes);
+    if (end < body.size()) {
+      size_t last = body.rfind(line_delimiter_, end - 1);
+      if (last == absl::string_view::npos || last < pos) {
+        last = body.find(line_delimiter_, end);
+      }
+      end = last == absl::string_view::npos ? body.size() : last + 1;
+    }
+    absl::string_view chunk = body.substr(pos, end - pos);
+    if (end == body.size() && body.back() != line_delimiter_) {
+      // the last line has no delimiter, the splitter wants one.
+      tail = std::string(chunk);
+      tail.push_back(line_delimiter_);
+      chunk = tail;
+    }
+
+    structurals.clear();
+    FindStructurals(chunk, field_delimiter_, line_delimiter_, &structurals);
+    CsvLineSplitter splitter(chunk, structurals, line_delimiter_);
+    while (splitter.Next(&fields, &line, used_fields, &field_count)) {
+      if (field_count != headers_.size()) {
+        YASL_THROW_INVALID_FORMAT(
+            "Input CSV file format error: "
+            "Line#{} '{}' fields size '{}' != header's size '{}'",
+            row_count, std::string(line), field_count, headers_.size());
+      }
+      for (size_t i = 0; i < selected_features_.size(); i++) {
+        auto index_in_row = selected_features_[i].first;
+        auto type = selected_features_[i].second;
+        auto& field = fields[index_in_row];
+        switch (type) {
+          case Schema::STRING: {
+            index->strings[i].emplace_back(pos + (field.data() - chunk.data()),
+                                           field.size());
+            break;
+          }
+          default: {
+            if (!AppendNumber(field, type, options_.fxp_bits,
+                              &index->values[i])) {
+              YASL_THROW_INVALID_FORMAT(
+                  "Input CSV file format error: Cannot convert '{}' to "
+                  "{}, column '{}', {} line '{}', file '{}'",
+                  std::string(field), TypeName(type), headers_[index_in_row],
+                  row_count, std::string(line), in_->GetName());
+            }
+            break;
+          }
+        }
+      }
+      row_count++;
+    }
+    pos = end;
+  }
+  size_t bytes = index->buffer.capacity();
+  for (const auto& col : index->values) {
+    bytes += std::visit(
+        [](const auto& c) -> size_t {
+          using Col = std::decay_t<decltype(c)>;
+          if constexpr (kIsNumericColumn<Col>) {
+            return c.capacity() * sizeof(typename Col::value_type);
+          } else {
+            return 0;
+          }
+        },
+        col);
+  }
+  for (const auto& col : index->strings) {
+    bytes += col.capacity() * sizeof(col[0]);
+  }
+  index->memory.Set(bytes);
+  total_rows_ = row_count;
+  column_index_ = std::move(index);
+}
+
 bool CsvReader::Next(ColumnVectorBatch* data) {
   YASL_ENFORCE(inited_, "Please Call Init before use reader");
-  data->Clear();
   if (options_.column_reader) {
+    data->Clear();
     return NextCol(data);
   } else {
     return NextRow(data, options_.batch_size);
@@ -267,8 +573,8 @@ bool CsvReader::Next(ColumnVectorBatch* data) {
 bool CsvReader::Next(size_t size, ColumnVectorBatch* data) {
   YASL_ENFORCE(size != 0);
   YASL_ENFORCE(inited_, "Please Call Init before use reader");
-  data->Clear();
   if (options_.column_reader) {
+    data->Clear();
     size_t count = 0;
     while (count < size) {
       if (!NextCol(data)) {
@@ -290,14 +596,31 @@ bool CsvReader::NextCol(ColumnVectorBatch* data) {
   auto col_index = current_index_++;
   auto type = selected_features_[col_index].second;
 
+  if (column_index_ != nullptr) {
+    if (type == Schema::STRING) {
+      const auto& strings = column_index_->strings[col_index];
+      size_t arena_bytes = 0;
+      for (const auto& string : strings) {
+        arena_bytes += string.second;
+      }
+      ColumnType col = EmptyStringCol(total_rows_, arena_bytes);
+      for (const auto& [offset, size] : strings) {
+        AppendString(column_index_->body.substr(offset, size), &col);
+      }
+      data->AppendCol(std::move(col));
+    } else {
+      data->AppendCol(ColumnType(column_index_->values[col_index]));
+    }
+    return true;
+  }
+
   MmappedFile mmap_col(cols_mmap_file_[col_index]);
   const char* mmap_data = mmap_col.data();
   const size_t mmap_size = mmap_col.size();
 
   switch (type) {
     case Schema::STRING: {
-      StringColumnVector col;
-      col.reserve(total_rows_);
+      ColumnType col = EmptyStringCol(total_rows_, mmap_size);
 
       size_t pos = 0;
       while (pos < mmap_size) {
@@ -310,150 +633,232 @@ bool CsvReader::NextCol(ColumnVectorBatch* data) {
         const char* str = mmap_data + pos;
         pos += len;
 
-        col.emplace_back(str, len);
-      }
-      YASL_ENFORCE(col.size() == total_rows_);
-      data->AppendCol(std::move(col));
-      break;
-    }
-    case Schema::FLOAT: {
-      FloatColumnVector col;
-      col.reserve(total_rows_);
-      YASL_ENFORCE(mmap_size == total_rows_ * sizeof(float));
-
-      size_t pos = 0;
-      while (pos < mmap_size) {
-        float value = *reinterpret_cast<const float*>(mmap_data + pos);
-        col.push_back(value);
-        pos += sizeof(float);
+        AppendString(absl::string_view(str, len), &col);
       }
-      YASL_ENFORCE(col.size() == total_rows_);
+      YASL_ENFORCE(std::visit([](auto& c) { return c.size(); }, col) ==
+                   total_rows_);
       data->AppendCol(std::move(col));
       break;
     }
-    case Schema::DOUBLE: {
-      DoubleColumnVector col;
-      col.reserve(total_rows_);
-      YASL_ENFORCE(mmap_size == total_rows_ * sizeof(double));
-
-      size_t pos = 0;
-      while (pos < mmap_size) {
-        double value = *reinterpret_cast<const double*>(mmap_data + pos);
-        col.push_back(value);
-        pos += sizeof(double);
-      }
-      YASL_ENFORCE(col.size() == total_rows_);
+    default: {
+      ColumnType col = MakeColumn(type, 0);
+      std::visit(
+          [&](auto& values) {
+            if constexpr (kIsNumericColumn<std::decay_t<decltype(values)>>) {
+              YASL_ENFORCE(mmap_size == total_rows_ * sizeof(values[0]));
+              values.resize(total_rows_);
+              if (mmap_size != 0) {
+                std::memcpy(values.data(), mmap_data, mmap_size);
+              }
+            }
+          },
+          col);
       data->AppendCol(std::move(col));
       break;
     }
-    default:
-      YASL_THROW("unknow Schema::type {}", type);
   }
 
   return true;
 }
 
+ColumnType CsvReader::EmptyStringCol(size_t size, size_t arena_bytes) const {
+  if (options_.string_arena_columns) {
+    StringArenaColumnVector col;
+    col.reserve(size, arena_bytes);
+    return col;
+  }
+  return MakeColumn(Schema::STRING, size);
+}
+
 void CsvReader::InitBatchCols(std::vector<ColumnType>* cols,
-                              size_t batch_size) {
+                              size_t batch_size) const {
+  bool reuse = cols->size() == selected_features_.size();
+  for (size_t i = 0; reuse && i < cols->size(); i++) {
+    reuse = ColumnMatches((*cols)[i], selected_features_[i].second,
+                          options_.string_arena_columns);
+  }
+  if (reuse) {
+    for (auto& col : *cols) {
+      ResetColumn(&col, batch_size);
+    }
+    return;
+  }
+  cols->clear();
   cols->reserve(selected_features_.size());
   for (auto& selected_feature : selected_features_) {
     auto type = selected_feature.second;
+    if (type == Schema::STRING) {
+      cols->emplace_back(EmptyStringCol(batch_size, 0));
+    } else {
+      cols->emplace_back(MakeColumn(type, batch_size));
+    }
+  }
+}
+
+size_t CsvReader::UsedFields() const {
+  size_t used = 0;
+  for (const auto& selected_feature : selected_features_) {
+    used = std::max(used, selected_feature.first + 1);
+  }
+  return used;
+}
+
+void CsvReader::ParseRow(const std::vector<absl::string_view>& fields,
+                         size_t field_count, absl::string_view line,
+                         size_t row_index,
+                         std::vector<ColumnType>* cols) const {
+  if (field_count != headers_.size()) {
+    YASL_THROW_INVALID_FORMAT(
+        "Input CSV file format error: "
+        "Line#{} '{}' fields size '{}' != header's size '{}'",
+        row_index, std::string(line), field_count, headers_.size());
+  }
+
+  for (size_t i = 0; i < selected_features_.size(); i++) {
+    auto index = selected_features_[i].first;
+    auto type = selected_features_[i].second;
+    auto& field = fields[index];
     switch (type) {
       case Schema::STRING: {
-        StringColumnVector col;
-        col.reserve(batch_size);
-        cols->emplace_back(std::move(col));
+        AppendString(field, &cols->at(i));
         break;
       }
-      case Schema::FLOAT: {
-        FloatColumnVector col;
-        col.reserve(batch_size);
-        cols->emplace_back(std::move(col));
-        break;
-      }
-      case Schema::DOUBLE: {
-        DoubleColumnVector col;
-        col.reserve(batch_size);
-        cols->emplace_back(std::move(col));
+      default: {
+        if (!AppendNumber(field, type, options_.fxp_bits, &cols->at(i))) {
+          YASL_THROW_INVALID_FORMAT(
+              "Input CSV file format error: Cannot convert '{}' to "
+              "{}, column '{}', {} line '{}', file '{}'",
+              std::string(field), TypeName(type), headers_[index], row_index,
+              std::string(line), in_->GetName());
+        }
         break;
       }
-      default:
-        YASL_THROW("unknow Schema::type {}", type);
     }
   }
 }
 
-bool CsvReader::NextRow(ColumnVectorBatch* data, size_t batch_size) {
-  if (in_->Eof()) {
-    // EOF
-    return false;
+size_t CsvReader::ParseRows(std::vector<ColumnType>* cols, size_t batch_size) {
+  // lines of the batch back to back, each with its delimiter, the stream is
+  // still read line by line so Tellg and the row map stay exact.
+  auto& block = parse_block_;
+  auto& line_ends = parse_line_ends_;
+  block.clear();
+  line_ends.clear();
+  while (line_ends.size() < batch_size && NextLine(nullptr)) {
+    block.append(current_line_);
+    block.push_back(line_delimiter_);
+    line_ends.push_back(block.size());
+  }
+  parse_memory_.Set(block.capacity() +
+                    line_ends.capacity() * sizeof(line_ends[0]));
+  const size_t count = line_ends.size();
+  if (count == 0) {
+    InitBatchCols(cols, 0);
+    return 0;
   }
 
-  std::vector<ColumnType> cols;
-  InitBatchCols(&cols, batch_size);
+  // in parallel mode, byte ranges of about kParseRangeBytes, cut after the
+  // last line ending in them.
+  const size_t num_ranges =
+      options_.row_reader_parallel_parse
+          ? std::min(count,
+                     (block.size() + kParseRangeBytes - 1) / kParseRangeBytes)
+          : 1;
+  std::vector<size_t> range_begins(num_ranges + 1, count);
+  range_begins[0] = 0;
+  for (size_t r = 1; r < num_ranges; r++) {
+    range_begins[r] = std::upper_bound(line_ends.begin(), line_ends.end(),
+                                       r * block.size() / num_ranges) -
+                      line_ends.begin();
+  }
 
-  size_t count = 0;
-  std::vector<absl::string_view> fields;
-  while (count < batch_size && NextLine(&fields)) {
-    if (fields.size() != headers_.size()) {
-      YASL_THROW_INVALID_FORMAT(
-          "Input CSV file format error: "
-          "Line#{} '{}' fields size '{}' != header's size '{}'",
-          current_index_, current_line_, fields.size(), headers_.size());
+  // each range is indexed by the simd tokenizer in one pass.
+  const size_t used_fields = UsedFields();
+  auto parse_range = [&](size_t r, std::vector<ColumnType>* part) {
+    const size_t first = range_begins[r];
+    const size_t last = range_begins[r + 1];
+    InitBatchCols(part, last - first);
+    if (first == last) {
+      return;
     }
+    const size_t begin = first == 0 ? 0 : line_ends[first - 1];
+    const auto range =
+        absl::string_view(block).substr(begin, line_ends[last - 1] - begin);
+    std::vector<uint32_t> structurals;
+    FindStructurals(range, field_delimiter_, line_delimiter_, &structurals);
+    CsvLineSplitter splitter(range, structurals, line_delimiter_);
+    std::vector<absl::string_view> fields;
+    absl::string_view line;
+    size_t field_count;
+    for (size_t l = first; l < last; l++) {
+      YASL_ENFORCE(splitter.Next(&fields, &line, used_fields, &field_count));
+      ParseRow(fields, field_count, line, current_index_ + l, part);
+    }
+  };
 
-    count++;
-    current_index_++;
+  if (num_ranges == 1) {
+    parse_range(0, cols);
+  } else {
+    auto& parts = parse_parts_;
+    parts.resize(num_ranges);
+    parallel_for(0, num_ranges, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t r = begin; r < end; r++) {
+        parse_range(r, &parts[r]);
+      }
+    });
+
+    InitBatchCols(cols, count);
+    for (size_t r = 0; r < num_ranges; r++) {
+      auto& part = parts[r];
+      for (size_t i = 0; i < cols->size(); i++) {
+        std::visit(
+            [&](auto& col) {
+              using Col = std::decay_t<decltype(col)>;
+              auto& src = std::get<Col>(part[i]);
+              if constexpr (std::is_same_v<Col, StringArenaColumnVector>) {
+                col.append(src);
+              } else {
+                col.insert(col.end(), std::make_move_iterator(src.begin()),
+                           std::make_move_iterator(src.end()));
+              }
+            },
+            (*cols)[i]);
+      }
+    }
+  }
+  current_index_ += count;
+  return count;
+}
 
-    for (size_t i = 0; i < selected_features_.size(); i++) {
-      auto index = selected_features_[i].first;
-      auto type = selected_features_[i].second;
-      auto& field = fields[index];
-      switch (type) {
-        case Schema::STRING: {
-          auto& col = std::get<StringColumnVector>(cols.at(i));
-          col.emplace_back(field.data(), field.size());
-          break;
-        }
-        case Schema::FLOAT: {
-          float value = 0;
-          if (!FloatFromString(field, &value)) {
-            YASL_THROW_INVALID_FORMAT(
-                "Input CSV file format error: Cannot convert '{}' to "
-                "float, column '{}', {} line '{}', file '{}'",
-                std::string(field), headers_[index], current_index_,
-                current_line_, in_->GetName());
-          }
+bool CsvReader::AtEnd() const {
+  return in_->Eof() || range_pos_ >= range_end_;
+}
 
-          auto& col = std::get<FloatColumnVector>(cols.at(i));
-          col.push_back(value);
-          break;
-        }
-        case Schema::DOUBLE: {
-          double value = 0;
-          if (!FloatFromString(field, &value)) {
-            YASL_THROW_INVALID_FORMAT(
-                "Input CSV file format error: Cannot convert '{}' to "
-                "double, column '{}', {} line '{}', file '{}'",
-                std::string(field), headers_[index], current_index_,
-                current_line_, in_->GetName());
-          }
+bool CsvReader::NextRow(ColumnVectorBatch* data, size_t batch_size) {
+  if (AtEnd()) {
+    // EOF
+    data->Clear();
+    return false;
+  }
 
-          auto& col = std::get<DoubleColumnVector>(cols.at(i));
-          col.push_back(value);
-          break;
-        }
-        default:
-          YASL_THROW("unknow Schema::type {}", type);
-      }
-    }
+  // the columns of the last batch are refilled if they match.
+  static auto& rows = GetCounter("yasl_csv_rows_total");
+  static auto& time = GetHistogram("yasl_csv_parse_us");
+  std::vector<ColumnType> cols = data->ReleaseCols();
+  size_t count;
+  {
+    ScopedTimer timer(&time);
+    count = ParseRows(&cols, batch_size);
   }
+  rows.Add(count);
 
   if (count == batch_size) {
     // for fast seek
     UpdateRowMap();
   }
-  if (in_->Eof()) {
+  if (options_.row_reader_tail) {
+    total_rows_ = std::max(total_rows_, current_index_);
+  } else if (AtEnd()) {
     // scan over, save rows.
     total_rows_ = current_index_;
   }
@@ -478,13 +883,16 @@ void CsvReader::Seek(size_t index) {
                  selected_features_.size());
     current_index_ = index;
   } else {
-    YASL_ENFORCE(total_rows_ == kUnknowTotalRow || index < total_rows_,
+    // a tailed file may have grown.
+    YASL_ENFORCE(total_rows_ == kUnknowTotalRow || options_.row_reader_tail ||
+                     index < total_rows_,
                  "seek for row out of range, try {} max {}", index,
                  total_rows_);
     auto it = rows_map_.upper_bound(index);
     YASL_ENFORCE(it != rows_map_.begin());
     std::advance(it, -1);
     in_->Seekg(it->second);
+    range_pos_ = it->second;
     current_index_ = it->first;
     while (current_index_ < index && NextLine(nullptr)) {
       current_index_++;
@@ -495,6 +903,21 @@ void CsvReader::Seek(size_t index) {
   }
 }
 
+void CsvReader::Commit() {
+  YASL_ENFORCE(inited_, "Please Call Init before use reader");
+  YASL_ENFORCE(options_.row_reader_tail && !options_.row_index_path.empty(),
+               "Commit needs row_reader_tail and row_index_path");
+  CsvRowIndex index;
+  index.file_length = range_pos_;
+  index.header_crc = header_crc_;
+  index.total_rows = current_index_;
+  index.rows_map.insert(rows_map_.begin(),
+                        rows_map_.upper_bound(current_index_));
+  // resumed without skipping lines.
+  index.rows_map[current_index_] = range_pos_;
+  SaveCsvRowIndex(options_.row_index_path, index);
+}
+
 std::unique_ptr<Reader> CsvReader::Spawn() {
   YASL_ENFORCE(inited_, "CAN NOT Spawn before init");
   auto in = in_->Spawn();
@@ -503,13 +926,84 @@ std::unique_ptr<Reader> CsvReader::Spawn() {
       options_, std::move(in), field_delimiter_, line_delimiter_));
   ret->inited_ = true;
   ret->headers_ = headers_;
+  ret->header_crc_ = header_crc_;
   ret->selected_features_ = selected_features_;
   ret->current_index_ = current_index_;
   ret->total_rows_ = total_rows_;
   ret->rows_map_ = rows_map_;
+  ret->range_pos_ = range_pos_;
+  ret->range_end_ = range_end_;
   ret->cols_mmap_file_ = cols_mmap_file_;
   // use shared_ptr as dir ref counter.
   ret->mmap_dir_ = mmap_dir_;
+  ret->column_index_ = column_index_;
+  return ret;
+}
+
+std::vector<std::unique_ptr<Reader>> CsvReader::Split(size_t n) {
+  YASL_ENFORCE(inited_, "CAN NOT Split before init");
+  YASL_ENFORCE(!options_.column_reader, "Not callable if read by column");
+  YASL_ENFORCE(!options_.row_reader_tail, "Can't split a tailed file");
+  YASL_ENFORCE(n > 0);
+  const size_t begin = rows_map_.begin()->second;
+  const size_t end = std::min(range_end_, in_->GetLength());
+  const bool rows_known = total_rows_ != kUnknowTotalRow;
+
+  // first row (if rows_known) and file position of each range, and the end.
+  std::vector<std::pair<size_t, size_t>> bounds;
+  bounds.emplace_back(0, begin);
+  auto in = in_->Spawn();
+  std::string line;
+  for (size_t k = 1; k < n; k++) {
+    size_t row = 0;
+    size_t pos = 0;
+    if (rows_known) {
+      // skips at most the lines between two entries of rows_map_.
+      row = total_rows_ * k / n;
+      auto it = std::prev(rows_map_.upper_bound(row));
+      size_t r = it->first;
+      pos = it->second;
+      in->Seekg(pos);
+      while (r < row && in->GetLine(&line, line_delimiter_)) {
+        pos += line.size() + 1;
+        r++;
+      }
+    } else {
+      // the first line starting at or after the cut.
+      pos = begin + (end - begin) * k / n;
+      if (pos > begin) {
+        in->Seekg(pos - 1);
+        pos = in->GetLine(&line, line_delimiter_) ? pos + line.size() : end;
+      }
+    }
+    pos = std::max(bounds.back().second, std::min(pos, end));
+    bounds.emplace_back(row, pos);
+  }
+  bounds.emplace_back(rows_known ? total_rows_ : 0, end);
+
+  std::vector<std::unique_ptr<Reader>> ret;
+  ret.reserve(n);
+  for (size_t k = 0; k < n; k++) {
+    const auto [first_row, first_pos] = bounds[k];
+    std::unique_ptr<CsvReader> shard(new CsvReader(
+        options_, in_->Spawn(), field_delimiter_, line_delimiter_));
+    shard->inited_ = true;
+    shard->headers_ = headers_;
+    shard->selected_features_ = selected_features_;
+    shard->rows_map_.emplace(0, first_pos);
+    if (rows_known) {
+      shard->total_rows_ = bounds[k + 1].first - first_row;
+      for (auto it = rows_map_.upper_bound(first_row);
+           it != rows_map_.end() && it->first < bounds[k + 1].first; ++it) {
+        shard->rows_map_.emplace(it->first - first_row, it->second);
+      }
+    }
+    shard->range_end_ = bounds[k + 1].second;
+    // not Seek(0), the range may be empty.
+    shard->in_->Seekg(first_pos);
+    shard->range_pos_ = first_pos;
+    ret.push_back(std::move(shard));
+  }
   return ret;
 }
 
@@ -21,6 +21,7 @@
 
 #include "absl/strings/string_view.h"
 
+#include "yasl/base/memory_tracker.h"
 #include "yasl/io/rw/reader.h"
 
 namespace yasl::io {
@@ -91,6 +92,8 @@ class CsvReader : public Reader {
 
   std::unique_ptr<Reader> Spawn() override;
 
+  std::vector<std::unique_ptr<Reader>> Split(size_t n) override;
+
   size_t GetLength() const override {
     YASL_ENFORCE(inited_, "Please Call Init before use reader");
     return in_->GetLength();
@@ -102,17 +105,41 @@ class CsvReader : public Reader {
     return in_->Tellg();
   }
 
+  /**
+   * Saves the rows read so far, i.e. the file position and count of the
+   * rows before Tell(), to row_index_path. The next Init() of the file
+   * resumes after them, see row_reader_tail.
+   */
+  void Commit();
+
  private:
   void CountLines();
+  // see row_index_path.
+  void LoadOrBuildRowIndex();
   void ParseHeader();
   void UpdateRowMap();
   bool NextLine(std::vector<absl::string_view>*);
+  // EOF, or the end of the range of a Split() reader.
+  bool AtEnd() const;
 
   void BuildMmapFiles();
+  void BuildColumnIndex();
 
   bool NextCol(ColumnVectorBatch*);
   bool NextRow(ColumnVectorBatch*, size_t);
-  void InitBatchCols(std::vector<ColumnType>*, size_t);
+  size_t ParseRows(std::vector<ColumnType>*, size_t);
+  // fields holds at least the UsedFields() first fields of the line, and
+  // field_count is the number of fields of the line.
+  void ParseRow(const std::vector<absl::string_view>& fields,
+                size_t field_count, absl::string_view line, size_t row_index,
+                std::vector<ColumnType>* cols) const;
+  // fields up to the last selected one, the rest of a line is not split.
+  size_t UsedFields() const;
+  // empty columns of the selected features with room for size rows. the
+  // columns already in cols are reused if they match.
+  void InitBatchCols(std::vector<ColumnType>*, size_t) const;
+  // StringColumnVector, or StringArenaColumnVector by string_arena_columns.
+  ColumnType EmptyStringCol(size_t size, size_t arena_bytes) const;
 
   const ReaderOptions options_;
   const char field_delimiter_;
@@ -120,6 +147,8 @@ class CsvReader : public Reader {
   bool inited_;
   std::unique_ptr<InputStream> in_;
   std::vector<std::string> headers_;
+  // see CsvHeaderChecksum.
+  uint32_t header_crc_ = 0;
   // selected_features' index & type.
   std::vector<std::pair<size_t, Schema::Type>> selected_features_;
   std::string current_line_;
@@ -130,10 +159,23 @@ class CsvReader : public Reader {
   // for ROW reader
   // rows -> file position.
   std::map<size_t, size_t> rows_map_;
+  // file position of the next line, and the end of the rows to read, see
+  // Split().
+  size_t range_pos_;
+  size_t range_end_;
   // for COL reader
   // index -> file name
   std::vector<std::string> cols_mmap_file_;
   std::shared_ptr<MmapDirGuard> mmap_dir_;
+  // or the columns in memory, see column_reader_memory_budget.
+  struct ColumnIndex;
+  std::shared_ptr<const ColumnIndex> column_index_;
+  // scratch of ParseRows, kept to reuse its capacity.
+  std::string parse_block_;
+  std::vector<size_t> parse_line_ends_;
+  std::vector<std::vector<ColumnType>> parse_parts_;
+  // of parse_block_ and parse_line_ends_.
+  MemoryCharge parse_memory_{MemoryTag::Get("io.csv")};
 };
 
 }  // namespace yasl::io
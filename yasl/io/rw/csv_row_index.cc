@@ -0,0 +1,130 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/io/rw/csv_row_index.h"
+
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <system_error>
+
+#include "fmt/format.h"
+#include "zlib.h"
+
+#include "yasl/io/stream/file_io.h"
+
+namespace yasl::io {
+
+namespace {
+
+constexpr char kMagic[] = "YRIX";
+constexpr size_t kMagicSize = 4;
+constexpr uint32_t kVersion = 1;
+// magic, version, file length, header crc, total rows, entries.
+constexpr size_t kFixedSize = 4 + 4 + 8 + 4 + 8 + 8;
+constexpr size_t kEntrySize = 16;
+
+template <class T>
+void Put(T v, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+template <class T>
+T Get(const std::string& data, size_t* pos) {
+  T v;
+  std::memcpy(&v, data.data() + *pos, sizeof(T));
+  *pos += sizeof(T);
+  return v;
+}
+
+}  // namespace
+
+uint32_t CsvHeaderChecksum(absl::string_view header_line) {
+  return crc32(crc32(0, nullptr, 0),
+               reinterpret_cast<const Bytef*>(header_line.data()),
+               header_line.size());
+}
+
+bool LoadCsvRowIndex(const std::string& path, CsvRowIndex* index) {
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(path, ec);
+  if (ec || size < kFixedSize || (size - kFixedSize) % kEntrySize != 0) {
+    return false;
+  }
+  std::string data(size, '\0');
+  FileInputStream in(path);
+  in.Read(data.data(), size);
+  in.Close();
+
+  size_t pos = 0;
+  if (data.compare(0, kMagicSize, kMagic) != 0) {
+    return false;
+  }
+  pos += kMagicSize;
+  if (Get<uint32_t>(data, &pos) != kVersion) {
+    return false;
+  }
+  CsvRowIndex ret;
+  ret.file_length = Get<uint64_t>(data, &pos);
+  ret.header_crc = Get<uint32_t>(data, &pos);
+  ret.total_rows = Get<uint64_t>(data, &pos);
+  const auto entries = Get<uint64_t>(data, &pos);
+  if (entries == 0 || entries != (size - kFixedSize) / kEntrySize) {
+    return false;
+  }
+  uint64_t last_row = 0;
+  uint64_t last_offset = 0;
+  for (size_t i = 0; i < entries; i++) {
+    const auto row = Get<uint64_t>(data, &pos);
+    const auto offset = Get<uint64_t>(data, &pos);
+    // rows and offsets strictly increase from row 0.
+    if ((i == 0 && row != 0) ||
+        (i != 0 && (row <= last_row || offset <= last_offset)) ||
+        row > ret.total_rows || offset > ret.file_length) {
+      return false;
+    }
+    ret.rows_map.emplace(row, offset);
+    last_row = row;
+    last_offset = offset;
+  }
+  *index = std::move(ret);
+  return true;
+}
+
+void SaveCsvRowIndex(const std::string& path, const CsvRowIndex& index) {
+  std::string data;
+  data.reserve(kFixedSize + index.rows_map.size() * kEntrySize);
+  data.append(kMagic, kMagicSize);
+  Put<uint32_t>(kVersion, &data);
+  Put<uint64_t>(index.file_length, &data);
+  Put<uint32_t>(index.header_crc, &data);
+  Put<uint64_t>(index.total_rows, &data);
+  Put<uint64_t>(index.rows_map.size(), &data);
+  for (const auto& [row, offset] : index.rows_map) {
+    Put<uint64_t>(row, &data);
+    Put<uint64_t>(offset, &data);
+  }
+
+  // readers of the same file may build its index concurrently.
+  const auto tmp = fmt::format("{}.{}.{}.tmp", path, getpid(),
+                               std::random_device()());
+  FileOutputStream out(tmp);
+  out.Write(data);
+  out.Close();
+  std::filesystem::rename(tmp, path);
+}
+
+}  // namespace yasl::io
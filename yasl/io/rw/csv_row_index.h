@@ -0,0 +1,50 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace yasl::io {
+
+// Sparse row index of a csv file, saved as a sidecar file so that later
+// opens know the rows and can seek without scanning the file. little
+// endian:
+//
+//   "YRIX" u32 version
+//   u64 file length, u32 crc32 of the header line, u64 total rows
+//   u64 entries, per entry: u64 row, u64 byte offset of the row
+//
+// the index is stale once the file length or the header line changes.
+struct CsvRowIndex {
+  uint64_t file_length = 0;
+  uint32_t header_crc = 0;
+  uint64_t total_rows = 0;
+  // row -> file position, row 0 included.
+  std::map<size_t, size_t> rows_map;
+};
+
+uint32_t CsvHeaderChecksum(absl::string_view header_line);
+
+// false if path does not exist or is not a valid index file.
+bool LoadCsvRowIndex(const std::string& path, CsvRowIndex* index);
+
+// replaces path atomically, by a rename of a temporary file next to it.
+void SaveCsvRowIndex(const std::string& path, const CsvRowIndex& index);
+
+}  // namespace yasl::io
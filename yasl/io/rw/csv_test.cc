@@ -13,16 +13,26 @@
 // limitations under the License.
 
 
+#include <unistd.h>
+
 #include <cstdint>
 #include <ctime>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <variant>
 
 #include "fmt/format.h"
 #include "gtest/gtest.h"
 
 #include "yasl/base/exception.h"
 #include "yasl/io/rw/csv_reader.h"
+#include "yasl/io/rw/csv_row_index.h"
 #include "yasl/io/rw/csv_writer.h"
+#include "yasl/io/rw/parallel_csv_writer.h"
+#include "yasl/io/rw/prefetch_reader.h"
 #include "yasl/io/rw/schema.h"
 #include "yasl/io/stream/file_io.h"
 #include "yasl/io/stream/mem_io.h"
@@ -444,6 +454,787 @@ u2, 22 , 23 , 24 , 25 , 0
   }
 }
 
+TEST(CSV, ParallelParse) {
+  std::string input = "id,f1,f2\n";
+  const size_t kRows = 20000;
+  for (size_t i = 0; i < kRows; i++) {
+    input += fmt::format("u{},{},{}\n", i, i * 0.5, -double(i));
+  }
+  Schema s;
+  s.feature_types = {Schema::STRING, Schema::FLOAT, Schema::DOUBLE};
+  s.feature_names = {"id", "f1", "f2"};
+
+  auto read_all = [&](bool parallel) {
+    std::unique_ptr<InputStream> in(new MemInputStream(input));
+    ReaderOptions r_ops;
+    r_ops.file_schema = s;
+    r_ops.batch_size = 7000;
+    r_ops.row_reader_parallel_parse = parallel;
+    CsvReader reader(r_ops, std::move(in));
+    reader.Init();
+    std::vector<ColumnVectorBatch> batches;
+    std::vector<size_t> tellgs;
+    ColumnVectorBatch batch;
+    while (reader.Next(&batch)) {
+      batches.push_back(std::move(batch));
+      tellgs.push_back(reader.Tellg());
+    }
+    EXPECT_EQ(reader.Rows(), kRows);
+    reader.Seek(kRows - 1);
+    EXPECT_TRUE(reader.Next(&batch));
+    EXPECT_EQ(batch.At<std::string>(0, 0), fmt::format("u{}", kRows - 1));
+    return std::make_pair(std::move(batches), tellgs);
+  };
+
+  auto [expected, expected_tellgs] = read_all(false);
+  auto [batches, tellgs] = read_all(true);
+  ASSERT_EQ(batches.size(), 3);
+  ASSERT_EQ(batches.size(), expected.size());
+  EXPECT_EQ(tellgs, expected_tellgs);
+  for (size_t b = 0; b < batches.size(); b++) {
+    ASSERT_EQ(batches[b].Shape(), expected[b].Shape());
+    for (size_t r = 0; r < batches[b].Shape().rows; r++) {
+      EXPECT_EQ(batches[b].At<std::string>(r, 0),
+                expected[b].At<std::string>(r, 0));
+      EXPECT_EQ(batches[b].At<float>(r, 1), expected[b].At<float>(r, 1));
+      EXPECT_EQ(batches[b].At<double>(r, 2), expected[b].At<double>(r, 2));
+    }
+  }
+  EXPECT_EQ(batches[1].At<std::string>(0, 0), "u7000");
+
+  {  // bad field in a late range
+    std::string bad = input + "u,x,1\n";
+    std::unique_ptr<InputStream> in(new MemInputStream(bad));
+    ReaderOptions r_ops;
+    r_ops.file_schema = s;
+    r_ops.batch_size = kRows + 1;
+    r_ops.row_reader_parallel_parse = true;
+    CsvReader reader(r_ops, std::move(in));
+    reader.Init();
+    ColumnVectorBatch data;
+    EXPECT_THROW(reader.Next(&data), yasl::InvalidFormat);
+  }
+}
+
+TEST(CSV, ColumnReaderInMemory) {
+  std::string input = "id,f1,f2,label\n";
+  for (size_t i = 0; i < 1000; i++) {
+    input += fmt::format("u{}, {} ,{},{}\n", i, i * 0.25, -double(i), i % 2);
+  }
+  // no delimiter after the last line.
+  input += "last,1,2,3";
+  Schema s;
+  s.feature_types = {Schema::DOUBLE, Schema::STRING, Schema::FLOAT};
+  s.feature_names = {"f2", "id", "f1"};
+
+  auto read_cols = [&](std::unique_ptr<InputStream> in, size_t budget) {
+    ReaderOptions r_ops;
+    r_ops.file_schema = s;
+    r_ops.column_reader = true;
+    r_ops.column_reader_memory_budget = budget;
+    CsvReader reader(r_ops, std::move(in));
+    reader.Init();
+    EXPECT_EQ(reader.Rows(), 1001);
+    ColumnVectorBatch batch;
+    EXPECT_TRUE(reader.Next(3, &batch));
+    ColumnVectorBatch end;
+    EXPECT_FALSE(reader.Next(&end));
+    return batch;
+  };
+
+  auto expected = read_cols(std::make_unique<MemInputStream>(input), 0);
+  auto in_memory =
+      read_cols(std::make_unique<MemInputStream>(input), input.size());
+
+  const std::string file_name = fmt::format("csv_test.{}.csv", getpid());
+  {
+    FileOutputStream out(file_name);
+    out.Write(input);
+    out.Close();
+  }
+  auto mmapped =
+      read_cols(std::make_unique<FileInputStream>(file_name), input.size());
+  std::filesystem::remove(file_name);
+
+  for (const auto* batch : {&in_memory, &mmapped}) {
+    ASSERT_EQ(batch->Shape(), expected.Shape());
+    EXPECT_EQ(batch->Col<double>(0), expected.Col<double>(0));
+    EXPECT_EQ(batch->Col<std::string>(1), expected.Col<std::string>(1));
+    EXPECT_EQ(batch->Col<float>(2), expected.Col<float>(2));
+  }
+  EXPECT_EQ(mmapped.At<std::string>(1000, 1), "last");
+  EXPECT_EQ(mmapped.At<float>(999, 2), 999 * 0.25f);
+
+  {  // bad fields are found by Init as before.
+    ReaderOptions r_ops;
+    r_ops.file_schema = s;
+    r_ops.column_reader = true;
+    r_ops.column_reader_memory_budget = size_t(1) << 20;
+    CsvReader reader(r_ops, std::make_unique<MemInputStream>(
+                                "id,f1,f2,label\nu1,s1,2,3\n"));
+    EXPECT_THROW(reader.Init(), yasl::InvalidFormat);
+  }
+}
+
+TEST(CSV, ParallelFormat) {
+  Schema s;
+  s.feature_types = {Schema::STRING, Schema::FLOAT, Schema::DOUBLE};
+  s.feature_names = {"id", "f1", "f2"};
+  const size_t kRows = 10000;
+  ColumnVectorBatch batch;
+  {
+    std::vector<std::string> ids;
+    std::vector<float> f1;
+    std::vector<double> f2;
+    for (size_t i = 0; i < kRows; i++) {
+      ids.push_back(fmt::format("u{}", i));
+      f1.push_back(i * 0.1f);
+      f2.push_back(-1.0 / (i + 1));
+    }
+    batch.AppendCol(std::move(ids));
+    batch.AppendCol(std::move(f1));
+    batch.AppendCol(std::move(f2));
+  }
+
+  auto write = [&](bool parallel, int precision) {
+    std::string out_buf;
+    WriterOptions w_op;
+    w_op.file_schema = s;
+    w_op.float_precision = precision;
+    w_op.parallel_format = parallel;
+    CsvWriter writer(w_op, std::make_unique<MemOutputStream>(&out_buf));
+    writer.Init();
+    writer.Add(batch);
+    writer.Close();
+    return out_buf;
+  };
+
+  const auto expected = write(false, 9);
+  EXPECT_EQ(write(true, 9), expected);
+  EXPECT_NE(expected.find("\nu1,0.100000001,-0.5\n"), std::string::npos);
+
+  // shortest round trip.
+  const auto shortest = write(true, 0);
+  EXPECT_EQ(shortest, write(false, 0));
+  EXPECT_NE(shortest.find("\nu1,0.1,-0.5\n"), std::string::npos);
+  ReaderOptions r_ops;
+  r_ops.file_schema = s;
+  r_ops.batch_size = kRows;
+  CsvReader reader(r_ops, std::make_unique<MemInputStream>(shortest));
+  reader.Init();
+  ColumnVectorBatch read;
+  ASSERT_TRUE(reader.Next(&read));
+  EXPECT_EQ(read.Col<std::string>(0), batch.Col<std::string>(0));
+  EXPECT_EQ(read.Col<float>(1), batch.Col<float>(1));
+  EXPECT_EQ(read.Col<double>(2), batch.Col<double>(2));
+}
+
+TEST(CSV, StringArenaColumns) {
+  std::string input = "id,f1,name\n";
+  for (size_t i = 0; i < 5000; i++) {
+    input += fmt::format("u{},{},{}\n", i, i * 0.5, i % 7 == 0 ? "" : "n");
+  }
+  Schema s;
+  s.feature_types = {Schema::STRING, Schema::FLOAT, Schema::STRING};
+  s.feature_names = {"id", "f1", "name"};
+
+  auto read = [&](bool arena, bool parallel, bool column, size_t budget) {
+    ReaderOptions r_ops;
+    r_ops.file_schema = s;
+    r_ops.batch_size = 10000;
+    r_ops.string_arena_columns = arena;
+    r_ops.row_reader_parallel_parse = parallel;
+    r_ops.column_reader = column;
+    r_ops.column_reader_memory_budget = budget;
+    CsvReader reader(r_ops, std::make_unique<MemInputStream>(input));
+    reader.Init();
+    ColumnVectorBatch batch;
+    // all columns, or all rows.
+    EXPECT_TRUE(column ? reader.Next(3, &batch) : reader.Next(&batch));
+    EXPECT_EQ(std::holds_alternative<StringArenaColumnVector>(batch.RawCol(0)),
+              arena);
+    return batch;
+  };
+
+  const auto expected = read(false, false, false, 0);
+  ASSERT_EQ(expected.Shape().rows, 5000);
+  for (const auto& [parallel, column, budget] :
+       {std::make_tuple(false, false, 0), std::make_tuple(true, false, 0),
+        std::make_tuple(false, true, 0),
+        std::make_tuple(false, true, 1 << 20)}) {
+    const auto batch = read(true, parallel, column, budget);
+    ASSERT_EQ(batch.Shape(), expected.Shape());
+    for (size_t r = 0; r < 5000; r++) {
+      EXPECT_EQ(batch.StringAt(r, 0), expected.At<std::string>(r, 0));
+      EXPECT_EQ(batch.StringAt(r, 2), expected.At<std::string>(r, 2));
+    }
+    EXPECT_EQ(batch.Col<float>(1), expected.Col<float>(1));
+  }
+
+  // arena batches are written the same.
+  auto write = [&](const ColumnVectorBatch& batch) {
+    std::string out_buf;
+    WriterOptions w_op;
+    w_op.file_schema = s;
+    CsvWriter writer(w_op, std::make_unique<MemOutputStream>(&out_buf));
+    writer.Init();
+    writer.Add(batch);
+    writer.Close();
+    return out_buf;
+  };
+  EXPECT_EQ(write(read(true, false, false, 0)), write(expected));
+}
+
+TEST(CSV, IntegerAndFixedPoint) {
+  std::string input = "id,i32,i64,u64,fxp64,fxp128\n";
+  for (int64_t i = 0; i < 1000; i++) {
+    input += fmt::format("u{},{},{},{},{},{}\n", i, -i, i << 40,
+                         uint64_t(-1) - i, i * -0.25, i * 1e10);
+  }
+  Schema s;
+  s.feature_types = {Schema::INT32, Schema::INT64, Schema::UINT64,
+                     Schema::FXP64, Schema::FXP128};
+  s.feature_names = {"i32", "i64", "u64", "fxp64", "fxp128"};
+
+  auto read = [&](bool column, size_t budget) {
+    ReaderOptions r_ops;
+    r_ops.file_schema = s;
+    r_ops.batch_size = 1000;
+    r_ops.column_reader = column;
+    r_ops.column_reader_memory_budget = budget;
+    CsvReader reader(r_ops, std::make_unique<MemInputStream>(input));
+    reader.Init();
+    ColumnVectorBatch batch;
+    EXPECT_TRUE(column ? reader.Next(5, &batch) : reader.Next(&batch));
+    return batch;
+  };
+
+  for (const auto& batch : {read(false, 0), read(true, 0),
+                            read(true, 1 << 20)}) {
+    ASSERT_EQ(batch.Shape().rows, 1000);
+    for (int64_t i = 0; i < 1000; i++) {
+      EXPECT_EQ(batch.At<int32_t>(i, 0), -i);
+      EXPECT_EQ(batch.At<int64_t>(i, 1), i << 40);
+      EXPECT_EQ(batch.At<uint64_t>(i, 2), uint64_t(-1) - i);
+      EXPECT_EQ(batch.At<uint64_t>(i, 3), uint64_t(-i * (1 << 16)));
+      EXPECT_EQ(batch.At<uint128_t>(i, 4),
+                static_cast<uint128_t>(i * 10000000000) << 18);
+    }
+  }
+
+  {  // written and read back.
+    std::string out_buf;
+    WriterOptions w_op;
+    w_op.file_schema = s;
+    w_op.float_precision = 0;
+    CsvWriter writer(w_op, std::make_unique<MemOutputStream>(&out_buf));
+    writer.Init();
+    const auto batch = read(false, 0);
+    writer.Add(batch);
+    writer.Close();
+    EXPECT_NE(out_buf.find("\n-1,1099511627776,18446744073709551614,-0.25,"
+                           "1e+10\n"),
+              std::string::npos);
+
+    ReaderOptions r_ops;
+    r_ops.file_schema = s;
+    r_ops.batch_size = 1000;
+    CsvReader reader(r_ops, std::make_unique<MemInputStream>(out_buf));
+    reader.Init();
+    ColumnVectorBatch back;
+    ASSERT_TRUE(reader.Next(&back));
+    EXPECT_EQ(back.Col<int32_t>(0), batch.Col<int32_t>(0));
+    EXPECT_EQ(back.Col<int64_t>(1), batch.Col<int64_t>(1));
+    EXPECT_EQ(back.Col<uint64_t>(2), batch.Col<uint64_t>(2));
+    EXPECT_EQ(back.Col<uint64_t>(3), batch.Col<uint64_t>(3));
+    EXPECT_EQ(back.Col<uint128_t>(4), batch.Col<uint128_t>(4));
+  }
+
+  for (const char* bad : {"1.5", "3000000000", "x", ""}) {
+    Schema bad_schema;
+    bad_schema.feature_types = {Schema::INT32};
+    bad_schema.feature_names = {"v"};
+    ReaderOptions r_ops;
+    r_ops.file_schema = bad_schema;
+    CsvReader reader(r_ops, std::make_unique<MemInputStream>(
+                                fmt::format("v\n{}\n", bad)));
+    reader.Init();
+    ColumnVectorBatch batch;
+    EXPECT_THROW(reader.Next(&batch), yasl::InvalidFormat) << bad;
+  }
+}
+
+TEST(CSV, RowIndex) {
+  std::string input = "id,x\n";
+  for (size_t i = 0; i < 1000; i++) {
+    input += fmt::format("u{},{}\n", i, i);
+  }
+  const std::string file_name = fmt::format("csv_test.{}.csv", getpid());
+  const std::string index_name = file_name + ".idx";
+  auto write = [&] {
+    FileOutputStream out(file_name);
+    out.Write(input);
+    out.Close();
+  };
+  write();
+
+  Schema s;
+  s.feature_types = {Schema::DOUBLE};
+  s.feature_names = {"x"};
+  ReaderOptions r_ops;
+  r_ops.file_schema = s;
+  r_ops.batch_size = 64;
+  r_ops.row_index_path = index_name;
+  auto check = [&](size_t rows) {
+    CsvReader reader(r_ops, std::make_unique<FileInputStream>(file_name));
+    reader.Init();
+    EXPECT_EQ(reader.Rows(), rows);
+    for (size_t row : {size_t(0), size_t(63), size_t(64), rows - 1,
+                       size_t(7)}) {
+      reader.Seek(row);
+      ColumnVectorBatch batch;
+      ASSERT_TRUE(reader.Next(1, &batch));
+      EXPECT_EQ(batch.At<double>(0, 0), row);
+    }
+  };
+
+  check(1000);
+  CsvRowIndex index;
+  ASSERT_TRUE(LoadCsvRowIndex(index_name, &index));
+  EXPECT_EQ(index.total_rows, 1000);
+  EXPECT_EQ(index.file_length, input.size());
+  EXPECT_EQ(index.rows_map.size(), 1000 / 64 + 1);
+  const auto saved = std::filesystem::last_write_time(index_name);
+
+  // reused by later opens.
+  check(1000);
+  EXPECT_EQ(std::filesystem::last_write_time(index_name), saved);
+
+  // rebuilt once stale.
+  input += "u1000,1000\n";
+  write();
+  check(1001);
+  ASSERT_TRUE(LoadCsvRowIndex(index_name, &index));
+  EXPECT_EQ(index.total_rows, 1001);
+
+  // or broken.
+  {
+    FileOutputStream out(index_name);
+    out.Write("YRIX garbage");
+    out.Close();
+  }
+  check(1001);
+  EXPECT_TRUE(LoadCsvRowIndex(index_name, &index));
+
+  std::filesystem::remove(file_name);
+  std::filesystem::remove(index_name);
+}
+
+TEST(CSV, Tail) {
+  const std::string file_name = fmt::format("csv_tail.{}.csv", getpid());
+  const std::string index_name = file_name + ".idx";
+  auto append = [&](const std::string& data) {
+    std::ofstream out(file_name, std::ios::binary | std::ios::app);
+    out << data;
+  };
+  std::filesystem::remove(file_name);
+  std::filesystem::remove(index_name);
+  append("id,x\n");
+  for (size_t i = 0; i < 10; i++) {
+    append(fmt::format("u{},{}\n", i, i));
+  }
+  // being written.
+  append("u10,1");
+
+  Schema s;
+  s.feature_types = {Schema::DOUBLE};
+  s.feature_names = {"x"};
+  ReaderOptions r_ops;
+  r_ops.file_schema = s;
+  r_ops.batch_size = 4;
+  r_ops.row_index_path = index_name;
+  r_ops.row_reader_tail = true;
+  // the x values returned by Next until it returns false.
+  auto read = [](CsvReader* reader) {
+    std::vector<double> ret;
+    ColumnVectorBatch batch;
+    while (reader->Next(&batch)) {
+      for (size_t i = 0; i < batch.Shape().rows; i++) {
+        ret.push_back(batch.At<double>(i, 0));
+      }
+    }
+    return ret;
+  };
+  auto range = [](size_t begin, size_t end) {
+    std::vector<double> ret;
+    for (size_t i = begin; i < end; i++) {
+      ret.push_back(i);
+    }
+    return ret;
+  };
+
+  {
+    CsvReader reader(r_ops, std::make_unique<FileInputStream>(file_name));
+    reader.Init();
+    EXPECT_EQ(reader.Rows(), 0);
+    EXPECT_EQ(read(&reader), range(0, 10));
+    EXPECT_EQ(reader.Rows(), 10);
+    EXPECT_TRUE(read(&reader).empty());
+
+    append("0\nu11,11\n");
+    EXPECT_EQ(read(&reader), range(10, 12));
+    EXPECT_EQ(reader.Rows(), 12);
+    reader.Commit();
+    EXPECT_THROW(reader.Split(2), yasl::EnforceNotMet);
+  }
+
+  // resumed after the committed rows.
+  for (size_t i = 12; i < 15; i++) {
+    append(fmt::format("u{},{}\n", i, i));
+  }
+  {
+    CsvReader reader(r_ops, std::make_unique<FileInputStream>(file_name));
+    reader.Init();
+    EXPECT_EQ(reader.Tell(), 12);
+    EXPECT_EQ(reader.Rows(), 12);
+    EXPECT_EQ(read(&reader), range(12, 15));
+    reader.Seek(3);
+    EXPECT_EQ(read(&reader), range(3, 15));
+  }
+
+  // read from the start once the file is rewritten.
+  {
+    FileOutputStream out(file_name);
+    out.Write("id,x\nu0,0\n");
+    out.Close();
+  }
+  {
+    CsvReader reader(r_ops, std::make_unique<FileInputStream>(file_name));
+    reader.Init();
+    EXPECT_EQ(reader.Tell(), 0);
+    EXPECT_EQ(read(&reader), range(0, 1));
+  }
+
+  std::filesystem::remove(file_name);
+  std::filesystem::remove(index_name);
+}
+
+TEST(CSV, Split) {
+  std::string input = "id,x\n";
+  for (size_t i = 0; i < 1000; i++) {
+    input += fmt::format("u{},{}\n", i, i);
+  }
+  Schema s;
+  s.feature_types = {Schema::DOUBLE};
+  s.feature_names = {"x"};
+
+  for (bool count_lines : {false, true}) {
+    for (size_t n : {1, 3, 7, 2000}) {
+      ReaderOptions r_ops;
+      r_ops.file_schema = s;
+      r_ops.batch_size = 64;
+      r_ops.row_reader_count_lines = count_lines;
+      CsvReader reader(r_ops, std::make_unique<MemInputStream>(input));
+      reader.Init();
+      auto shards = reader.Split(n);
+      ASSERT_EQ(shards.size(), n);
+
+      std::vector<double> values;
+      size_t max_rows = 0;
+      for (auto& shard : shards) {
+        ColumnVectorBatch batch;
+        size_t rows = 0;
+        while (shard->Next(&batch)) {
+          const auto& col = batch.Col<double>(0);
+          values.insert(values.end(), col.begin(), col.end());
+          rows += col.size();
+        }
+        if (count_lines || rows != 0) {
+          EXPECT_EQ(shard->Rows(), rows);
+        }
+        max_rows = std::max(max_rows, rows);
+        if (rows > 1) {
+          // rows count from the range begin.
+          shard->Seek(rows - 1);
+          ASSERT_TRUE(shard->Next(1, &batch));
+          EXPECT_EQ(batch.At<double>(0, 0), values.back());
+          EXPECT_FALSE(shard->Next(&batch));
+        }
+      }
+      ASSERT_EQ(values.size(), 1000);
+      for (size_t i = 0; i < values.size(); i++) {
+        EXPECT_EQ(values[i], i);
+      }
+      // byte ranges of lines of 6 to 10 bytes.
+      EXPECT_LE(max_rows, 1000 / n + 1 + (count_lines ? 0 : 1000 / n / 2));
+    }
+  }
+}
+
+TEST(CSV, Projection) {
+  // 200 columns, c3 and c7 selected.
+  std::string header;
+  for (size_t c = 0; c < 200; c++) {
+    header += fmt::format("{}c{}", c == 0 ? "" : ",", c);
+  }
+  std::string input = header + "\n";
+  for (size_t i = 0; i < 500; i++) {
+    for (size_t c = 0; c < 200; c++) {
+      // unselected fields are not numbers.
+      input += c == 3 || c == 7 ? fmt::format("{}", i * 1000 + c) : "x";
+      input.push_back(c == 199 ? '\n' : ',');
+    }
+  }
+  Schema s;
+  s.feature_types = {Schema::DOUBLE, Schema::STRING};
+  s.feature_names = {"c7", "c3"};
+
+  auto read = [&](const std::string& data, bool column, bool parallel) {
+    ReaderOptions r_ops;
+    r_ops.file_schema = s;
+    r_ops.batch_size = 1000;
+    r_ops.column_reader = column;
+    r_ops.row_reader_parallel_parse = parallel;
+    r_ops.column_reader_memory_budget = parallel ? 1 << 20 : 0;
+    CsvReader reader(r_ops, std::make_unique<MemInputStream>(data));
+    reader.Init();
+    ColumnVectorBatch batch;
+    EXPECT_TRUE(column ? reader.Next(2, &batch) : reader.Next(&batch));
+    return batch;
+  };
+  const size_t first_row = header.size() + 1;
+  const std::string first_line =
+      input.substr(first_row, input.find('\n', first_row) - first_row);
+  for (bool column : {false, true}) {
+    for (bool parallel : {false, true}) {
+      const auto batch = read(input, column, parallel);
+      ASSERT_EQ(batch.Shape().rows, 500);
+      for (size_t i = 0; i < 500; i++) {
+        EXPECT_EQ(batch.At<double>(i, 0), i * 1000 + 7);
+        EXPECT_EQ(batch.At<std::string>(i, 1), fmt::format("{}", i * 1000 + 3));
+      }
+      // fields after the last selected one still count.
+      EXPECT_THROW(read(input + "1,2,3,4,5,6,7,8\n", column, parallel),
+                   yasl::InvalidFormat);
+      EXPECT_THROW(read(input + first_line + ",x\n", column, parallel),
+                   yasl::InvalidFormat);
+    }
+  }
+}
+
+TEST(CSV, ParallelWriter) {
+  Schema s;
+  s.feature_types = {Schema::STRING, Schema::DOUBLE};
+  s.feature_names = {"id", "f1"};
+  WriterOptions w_op;
+  w_op.file_schema = s;
+  const size_t kBlocks = 40;
+  std::vector<ColumnVectorBatch> blocks(kBlocks);
+  for (size_t b = 0; b < kBlocks; b++) {
+    std::vector<std::string> ids;
+    std::vector<double> f1;
+    for (size_t i = 0; i < b % 7 * 10; i++) {
+      ids.push_back(fmt::format("u{}-{}", b, i));
+      f1.push_back(b + i * 0.5);
+    }
+    blocks[b].AppendCol(std::move(ids));
+    blocks[b].AppendCol(std::move(f1));
+  }
+
+  std::string expected;
+  {
+    CsvWriter writer(w_op, std::make_unique<MemOutputStream>(&expected));
+    writer.Init();
+    for (const auto& block : blocks) {
+      writer.Add(block);
+    }
+    writer.Close();
+  }
+  const std::string header = "id,f1\n";
+
+  // 4 threads adding every 4th block, last first.
+  auto add_all = [&](ParallelCsvWriter* writer) {
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; t++) {
+      threads.emplace_back([&, t] {
+        for (size_t b = kBlocks - 4 + t; b < kBlocks; b -= 4) {
+          writer->Add(b, blocks[b]);
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+  };
+
+  {
+    std::string out;
+    ParallelCsvWriter writer(w_op, std::make_unique<MemOutputStream>(&out));
+    writer.Init();
+    add_all(&writer);
+    EXPECT_THROW(writer.Add(3, blocks[3]), EnforceNotMet);
+    EXPECT_EQ(writer.Tellp(), expected.size());
+    writer.Close();
+    EXPECT_EQ(out, expected);
+  }
+
+  {  // a missing block.
+    std::string out;
+    ParallelCsvWriter writer(w_op, std::make_unique<MemOutputStream>(&out));
+    writer.Init();
+    writer.Add(1, blocks[1]);
+    EXPECT_THROW(writer.Close(), EnforceNotMet);
+  }
+
+  const std::string prefix = fmt::format("parallel_writer_{}", getpid());
+  {
+    ParallelCsvWriter writer(w_op, prefix);
+    writer.Init();
+    add_all(&writer);
+    writer.Close();
+  }
+  auto read_file = [](const std::string& file_name) {
+    std::ifstream in(file_name);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+  };
+  std::string manifest_expected = "part,rows\n";
+  std::string bodies = header;
+  for (size_t b = 0; b < kBlocks; b++) {
+    const auto part = ParallelCsvWriter::PartPath(prefix, b);
+    manifest_expected +=
+        fmt::format("{},{}\n", part, blocks[b].Shape().rows);
+    const auto content = read_file(part);
+    ASSERT_EQ(content.substr(0, header.size()), header);
+    bodies += content.substr(header.size());
+    std::filesystem::remove(part);
+  }
+  EXPECT_EQ(bodies, expected);
+  EXPECT_EQ(read_file(prefix + ".manifest"), manifest_expected);
+  std::filesystem::remove(prefix + ".manifest");
+}
+
+TEST(CSV, ReuseBatch) {
+  std::string input = "id,f1,name\n";
+  for (size_t i = 0; i < 1000; i++) {
+    input += fmt::format("u{},{},n{}\n", i, i * 0.5, i % 7);
+  }
+  Schema s;
+  s.feature_types = {Schema::STRING, Schema::DOUBLE};
+  s.feature_names = {"id", "f1"};
+  for (bool arena : {false, true}) {
+    ReaderOptions r_ops;
+    r_ops.file_schema = s;
+    r_ops.batch_size = 100;
+    r_ops.string_arena_columns = arena;
+    CsvReader reader(r_ops, std::make_unique<MemInputStream>(input));
+    reader.Init();
+    // a batch of another schema is replaced.
+    ColumnVectorBatch batch;
+    batch.AppendCol(Int32ColumnVector(5));
+    ASSERT_TRUE(reader.Next(&batch));
+    const double* values = batch.Col<double>(1).data();
+    size_t rows = batch.Shape().rows;
+    while (reader.Next(&batch)) {
+      ASSERT_EQ(batch.Shape(), ColumnVectorBatch::Dimension({100, 2}));
+      EXPECT_EQ(batch.Col<double>(1).data(), values);
+      EXPECT_EQ(batch.StringAt(0, 0), fmt::format("u{}", rows));
+      EXPECT_EQ(batch.At<double>(99, 1), (rows + 99) * 0.5);
+      rows += batch.Shape().rows;
+    }
+    EXPECT_EQ(rows, 1000);
+    EXPECT_EQ(batch.Shape().rows, 0);
+  }
+}
+
+TEST(CSV, Prefetch) {
+  std::string input = "id,x\n";
+  for (size_t i = 0; i < 1000; i++) {
+    input += fmt::format("u{},{}\n", i, i);
+  }
+  Schema s;
+  s.feature_types = {Schema::DOUBLE};
+  s.feature_names = {"x"};
+  ReaderOptions r_ops;
+  r_ops.file_schema = s;
+  r_ops.batch_size = 64;
+  auto make = [&](const std::string& data) {
+    return std::make_unique<CsvReader>(r_ops,
+                                       std::make_unique<MemInputStream>(data));
+  };
+  // the x values returned by Next until it returns false.
+  auto read = [](Reader* reader) {
+    std::vector<double> ret;
+    ColumnVectorBatch batch;
+    const size_t begin = reader->Tell();
+    while (reader->Next(&batch)) {
+      const auto& col = batch.Col<double>(0);
+      ret.insert(ret.end(), col.begin(), col.end());
+      EXPECT_EQ(reader->Tell(), begin + ret.size());
+    }
+    return ret;
+  };
+  auto range = [](size_t begin, size_t end) {
+    std::vector<double> ret;
+    for (size_t i = begin; i < end; i++) {
+      ret.push_back(i);
+    }
+    return ret;
+  };
+
+  for (size_t depth : {1, 4}) {
+    PrefetchReader reader(make(input), depth);
+    reader.Init();
+    EXPECT_EQ(reader.Headers(), std::vector<std::string>({"id", "x"}));
+    EXPECT_EQ(reader.Cols(), 1);
+    EXPECT_EQ(reader.Rows(), std::numeric_limits<size_t>::max());
+    EXPECT_EQ(read(&reader), range(0, 1000));
+    EXPECT_EQ(reader.Rows(), 1000);
+
+    // Tellg and Seek are those of the rows returned, not the prefetched.
+    auto direct = make(input);
+    direct->Init();
+    ColumnVectorBatch batch;
+    reader.Seek(100);
+    ASSERT_TRUE(reader.Next(&batch));
+    EXPECT_EQ(batch.At<double>(0, 0), 100);
+    ASSERT_TRUE(reader.Next(&batch));
+    direct->Seek(228);
+    EXPECT_EQ(reader.Tell(), 228);
+    EXPECT_EQ(reader.Tellg(), direct->Tellg());
+    // another size reads on from the rows returned.
+    ASSERT_TRUE(reader.Next(10, &batch));
+    EXPECT_EQ(batch.Shape().rows, 10);
+    EXPECT_EQ(batch.At<double>(0, 0), 228);
+    ASSERT_TRUE(reader.Next(&batch));
+    EXPECT_EQ(batch.At<double>(0, 0), 238);
+
+    auto spawned = reader.Spawn();
+    EXPECT_EQ(spawned->Tell(), 302);
+    EXPECT_EQ(read(spawned.get()), range(302, 1000));
+    EXPECT_EQ(read(&reader), range(302, 1000));
+
+    std::vector<double> values;
+    for (auto& shard : reader.Split(3)) {
+      auto shard_values = read(shard.get());
+      values.insert(values.end(), shard_values.begin(), shard_values.end());
+    }
+    EXPECT_EQ(values, range(0, 1000));
+  }
+
+  // an error is raised once the rows before it are returned.
+  std::string bad = input;
+  bad.replace(bad.find("u150,150"), 8, "u150,s150");
+  PrefetchReader reader(make(bad), 4);
+  reader.Init();
+  ColumnVectorBatch batch;
+  ASSERT_TRUE(reader.Next(&batch));
+  ASSERT_TRUE(reader.Next(&batch));
+  EXPECT_EQ(reader.Tell(), 128);
+  EXPECT_THROW(reader.Next(&batch), yasl::InvalidFormat);
+}
+
 TEST(BATCH, test) {
   {
     FloatColumnVector col;
@@ -475,6 +1266,54 @@ TEST(BATCH, test) {
     EXPECT_EQ(data_prt, poped.data());
     EXPECT_EQ(ColumnVectorBatch::Dimension({10, 0}), batch.Shape());
   }
+
+  {
+    ColumnVectorBatch batch;
+    batch.AppendCol(FloatColumnVector(10, 1));
+    StringArenaColumnVector strings;
+    for (size_t i = 0; i < 10; i++) {
+      strings.push_back("abc");
+    }
+    batch.AppendCol(std::move(strings));
+    const auto data_prt = batch.Col<float>(0).data();
+    batch.Reset(10);
+    EXPECT_EQ(ColumnVectorBatch::Dimension({0, 2}), batch.Shape());
+    EXPECT_TRUE(batch.Col<float>(0).empty());
+    EXPECT_EQ(data_prt, batch.Col<float>(0).data());
+    EXPECT_TRUE(std::holds_alternative<StringArenaColumnVector>(
+        batch.RawCol(1)));
+
+    auto cols = batch.ReleaseCols();
+    EXPECT_EQ(cols.size(), 2);
+    EXPECT_EQ(ColumnVectorBatch::Dimension({0, 0}), batch.Shape());
+  }
+}
+
+TEST(BATCH, ColSpans) {
+  ColumnVectorBatch batch;
+  batch.AppendCol(FloatColumnVector{1, 2, 3});
+  batch.AppendCol(StringColumnVector{"a", "b", "c"});
+
+  auto floats = batch.MutableColSpan<float>(0);
+  ASSERT_EQ(floats.size(), 3);
+  floats[1] = 42;
+  const auto& cbatch = batch;
+  EXPECT_EQ(cbatch.ColSpan<float>(0)[1], 42);
+  EXPECT_EQ(cbatch.ColSpan<std::string>(1)[2], "c");
+  EXPECT_THROW(cbatch.ColSpan<double>(0), EnforceNotMet);
+  EXPECT_THROW(batch.MutableColSpan<float>(1), EnforceNotMet);
+
+  size_t numeric = 0;
+  for (size_t c = 0; c < batch.Shape().cols; c++) {
+    cbatch.VisitCol(c, [&](const auto& col) {
+      using Col = std::decay_t<decltype(col)>;
+      if constexpr (kIsNumericColumn<Col>) {
+        numeric += col.size();
+      }
+    });
+  }
+  EXPECT_EQ(numeric, 3);
+  EXPECT_EQ(batch.VisitCol(1, [](auto& col) { return col.size(); }), 3);
 }
 
 }  // namespace yasl::io
\ No newline at end of file
@@ -0,0 +1,136 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/io/rw/csv_tokenizer.h"
+
+#include <limits>
+
+#include "absl/numeric/bits.h"
+
+#include "yasl/base/cpu_dispatch.h"
+#include "yasl/base/exception.h"
+
+#ifdef __x86_64
+#include <immintrin.h>
+#endif
+
+namespace yasl::io {
+
+namespace {
+
+// bit i of the mask is set if data[i] is a delimiter.
+using ClassifyFn = uint64_t (*)(const char* data, char field_delimiter,
+                                char line_delimiter);
+
+uint64_t ClassifyPortable(const char* data, char field_delimiter,
+                          char line_delimiter) {
+  uint64_t mask = 0;
+  for (size_t i = 0; i < 64; i++) {
+    const bool hit = data[i] == field_delimiter || data[i] == line_delimiter;
+    mask |= uint64_t{hit} << i;
+  }
+  return mask;
+}
+
+#ifdef __x86_64
+__attribute__((target("avx2"))) uint64_t ClassifyAvx2(const char* data,
+                                                      char field_delimiter,
+                                                      char line_delimiter) {
+  const __m256i f = _mm256_set1_epi8(field_delimiter);
+  const __m256i l = _mm256_set1_epi8(line_delimiter);
+  const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+  const __m256i hi =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32));
+  const uint32_t lo_mask = _mm256_movemask_epi8(_mm256_or_si256(
+      _mm256_cmpeq_epi8(lo, f), _mm256_cmpeq_epi8(lo, l)));
+  const uint32_t hi_mask = _mm256_movemask_epi8(_mm256_or_si256(
+      _mm256_cmpeq_epi8(hi, f), _mm256_cmpeq_epi8(hi, l)));
+  return (uint64_t{hi_mask} << 32) | lo_mask;
+}
+
+__attribute__((target("avx512f,avx512bw"))) uint64_t ClassifyAvx512(
+    const char* data, char field_delimiter, char line_delimiter) {
+  const __m512i v = _mm512_loadu_si512(data);
+  return _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(field_delimiter)) |
+         _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(line_delimiter));
+}
+#endif
+
+ClassifyFn SelectClassify() {
+  CpuDispatch<ClassifyFn> dispatch("csv.classify", ClassifyPortable);
+#ifdef __x86_64
+  dispatch.Add(kIsaAvx2, ClassifyAvx2)
+      .Add(kIsaAvx512f | kIsaAvx512bw, ClassifyAvx512);
+#endif
+  return dispatch.Bind();
+}
+
+// appends base + i for the set bits i of mask.
+inline void Flatten(uint64_t mask, uint32_t base, std::vector<uint32_t>* out) {
+  size_t n = out->size();
+  out->resize(n + absl::popcount(mask));
+  uint32_t* dst = out->data() + n;
+  while (mask != 0) {
+    *dst++ = base + absl::countr_zero(mask);
+    mask &= mask - 1;
+  }
+}
+
+}  // namespace
+
+void FindStructurals(absl::string_view block, char field_delimiter,
+                     char line_delimiter, std::vector<uint32_t>* structurals) {
+  YASL_ENFORCE(block.size() <= std::numeric_limits<uint32_t>::max(),
+               "csv block of {} bytes is too big to index", block.size());
+  static const ClassifyFn kClassify = SelectClassify();
+  const char* data = block.data();
+  size_t i = 0;
+  for (; i + 64 <= block.size(); i += 64) {
+    Flatten(kClassify(data + i, field_delimiter, line_delimiter), i,
+            structurals);
+  }
+  for (; i < block.size(); i++) {
+    if (data[i] == field_delimiter || data[i] == line_delimiter) {
+      structurals->push_back(i);
+    }
+  }
+}
+
+bool CsvLineSplitter::Next(std::vector<absl::string_view>* fields,
+                           absl::string_view* line, size_t max_fields,
+                           size_t* field_count) {
+  if (line_begin_ >= block_.size()) {
+    return false;
+  }
+  fields->clear();
+  size_t field_begin = line_begin_;
+  size_t count = 0;
+  while (true) {
+    YASL_ENFORCE(next_structural_ < structurals_.size(),
+                 "csv block does not end with a line delimiter");
+    const size_t pos = structurals_[next_structural_++];
+    if (count++ < max_fields) {
+      fields->push_back(block_.substr(field_begin, pos - field_begin));
+    }
+    field_begin = pos + 1;
+    if (block_[pos] == line_delimiter_) {
+      *line = block_.substr(line_begin_, pos - line_begin_);
+      line_begin_ = pos + 1;
+      *field_count = count;
+      return true;
+    }
+  }
+}
+
+}  // namespace yasl::io
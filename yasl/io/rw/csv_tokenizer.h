@@ -0,0 +1,67 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace yasl::io {
+
+// Structural index of a csv block, in the style of simdcsv: the delimiters
+// are classified 64 bytes at a time into a bit mask, by AVX-512BW or AVX2
+// compares when the cpu has them, and the set bits are flattened into
+// offsets. Quotes are not structural, fields are split on every
+// field_delimiter the same as absl::StrSplit.
+//
+// Appends the offsets of all field and line delimiters in `block` to
+// `structurals`, in increasing order. `block` must be shorter than 4 GiB.
+void FindStructurals(absl::string_view block, char field_delimiter,
+                     char line_delimiter, std::vector<uint32_t>* structurals);
+
+// Walks the lines of a block indexed by FindStructurals. Every line of the
+// block, the last one included, must end with line_delimiter.
+class CsvLineSplitter {
+ public:
+  CsvLineSplitter(absl::string_view block,
+                  const std::vector<uint32_t>& structurals,
+                  char line_delimiter)
+      : block_(block),
+        structurals_(structurals),
+        line_delimiter_(line_delimiter) {}
+
+  // fields of the next line into `fields`, and the line without its
+  // delimiter into `line`. false at the end of the block.
+  bool Next(std::vector<absl::string_view>* fields, absl::string_view* line) {
+    size_t field_count;
+    return Next(fields, line, SIZE_MAX, &field_count);
+  }
+
+  // same, but only the first max_fields fields go into `fields`, the rest
+  // are only counted. field_count is the number of fields of the line.
+  bool Next(std::vector<absl::string_view>* fields, absl::string_view* line,
+            size_t max_fields, size_t* field_count);
+
+ private:
+  const absl::string_view block_;
+  const std::vector<uint32_t>& structurals_;
+  const char line_delimiter_;
+  size_t next_structural_ = 0;
+  size_t line_begin_ = 0;
+};
+
+}  // namespace yasl::io
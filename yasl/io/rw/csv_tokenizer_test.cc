@@ -0,0 +1,98 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/io/rw/csv_tokenizer.h"
+
+#include <random>
+#include <string>
+
+#include "absl/strings/str_split.h"
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl::io {
+
+TEST(CsvTokenizer, Structurals) {
+  std::string block = "a,bb,,c\n\n1,2\n";
+  std::vector<uint32_t> structurals;
+  FindStructurals(block, ',', '\n', &structurals);
+  EXPECT_EQ(structurals, std::vector<uint32_t>({1, 4, 5, 7, 8, 10, 12}));
+}
+
+TEST(CsvTokenizer, MatchesStrSplit) {
+  std::mt19937 rng(42);
+  const std::string alphabet = "ab1.;\t, ";
+  std::string block;
+  std::vector<std::string> lines;
+  for (size_t l = 0; l < 500; l++) {
+    std::string line;
+    const size_t len = rng() % 150;
+    for (size_t i = 0; i < len; i++) {
+      line.push_back(alphabet[rng() % alphabet.size()]);
+    }
+    block += line + "\n";
+    lines.push_back(line);
+  }
+
+  for (char delim : {',', ';', '\t'}) {
+    std::vector<uint32_t> structurals;
+    FindStructurals(block, delim, '\n', &structurals);
+    CsvLineSplitter splitter(block, structurals, '\n');
+    std::vector<absl::string_view> fields;
+    absl::string_view line;
+    for (const auto& expected : lines) {
+      ASSERT_TRUE(splitter.Next(&fields, &line));
+      EXPECT_EQ(line, expected);
+      std::vector<absl::string_view> expected_fields =
+          absl::StrSplit(expected, delim);
+      EXPECT_EQ(fields, expected_fields);
+    }
+    EXPECT_FALSE(splitter.Next(&fields, &line));
+  }
+}
+
+TEST(CsvTokenizer, MaxFields) {
+  std::string block = "a,b,c,d\n\ne,f\n";
+  std::vector<uint32_t> structurals;
+  FindStructurals(block, ',', '\n', &structurals);
+  CsvLineSplitter splitter(block, structurals, '\n');
+  std::vector<absl::string_view> fields;
+  absl::string_view line;
+  size_t field_count = 0;
+  ASSERT_TRUE(splitter.Next(&fields, &line, 2, &field_count));
+  EXPECT_EQ(fields, std::vector<absl::string_view>({"a", "b"}));
+  EXPECT_EQ(line, "a,b,c,d");
+  EXPECT_EQ(field_count, 4);
+  ASSERT_TRUE(splitter.Next(&fields, &line, 0, &field_count));
+  EXPECT_TRUE(fields.empty());
+  EXPECT_EQ(field_count, 1);
+  ASSERT_TRUE(splitter.Next(&fields, &line, 3, &field_count));
+  EXPECT_EQ(fields, std::vector<absl::string_view>({"e", "f"}));
+  EXPECT_EQ(field_count, 2);
+  EXPECT_FALSE(splitter.Next(&fields, &line, 3, &field_count));
+}
+
+TEST(CsvTokenizer, MissingLineDelimiter) {
+  std::string block = "a,b\nc,d";
+  std::vector<uint32_t> structurals;
+  FindStructurals(block, ',', '\n', &structurals);
+  CsvLineSplitter splitter(block, structurals, '\n');
+  std::vector<absl::string_view> fields;
+  absl::string_view line;
+  EXPECT_TRUE(splitter.Next(&fields, &line));
+  EXPECT_THROW(splitter.Next(&fields, &line), EnforceNotMet);
+}
+
+}  // namespace yasl::io
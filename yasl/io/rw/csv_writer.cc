@@ -16,20 +16,43 @@
 #include "yasl/io/rw/csv_writer.h"
 
 #include <algorithm>
+#include <charconv>
 #include <cmath>
 #include <cstdio>
 #include <filesystem>
 #include <iterator>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "fmt/format.h"
 
 #include "yasl/base/exception.h"
 #include "yasl/io/rw/float.h"
+#include "yasl/utils/parallel.h"
 
 namespace yasl::io {
 
+namespace {
+
+// rows per parallel format task.
+constexpr size_t kFormatBlockRows = 4096;
+
+// writes v to buf, returns the size written.
+template <class T>
+size_t IntToChars(T v, char* buf) {
+  // 20 digits and a sign fit into the float buffer of FormatRows.
+  return std::to_chars(buf, buf + 21, v).ptr - buf;
+}
+
+// value r of numeric col c, see FormatRows.
+template <class T>
+const T& Cell(const std::vector<const void*>& values, size_t r, size_t c) {
+  return static_cast<const T*>(values[c])[r];
+}
+
+}  // namespace
+
 CsvWriter::CsvWriter(WriterOptions op, std::unique_ptr<OutputStream> out,
                      char field_delimiter, char line_delimiter)
     : options_(std::move(op)),
@@ -41,7 +64,7 @@ CsvWriter::CsvWriter(WriterOptions op, std::unique_ptr<OutputStream> out,
   YASL_ENFORCE(options_.file_schema.feature_names.size() ==
                options_.file_schema.feature_types.size());
   YASL_ENFORCE(out_->Tellp() == 0);
-  YASL_ENFORCE(options_.float_precision > 0 &&
+  YASL_ENFORCE(options_.float_precision >= 0 &&
                options_.float_precision <=
                    std::numeric_limits<double>::max_digits10);
 }
@@ -61,41 +84,110 @@ void CsvWriter::Init() {
   inited_ = true;
 }
 
-bool CsvWriter::Add(const ColumnVectorBatch& data) {
-  YASL_ENFORCE(inited_, "Please Call Init before use writer");
-  const size_t rows = data.Shape().rows;
+void CsvWriter::FormatRows(const ColumnVectorBatch& data, size_t begin,
+                           size_t end, std::string* out) const {
   const size_t cols = data.Shape().cols;
-  YASL_ENFORCE(cols == options_.file_schema.feature_names.size());
   const auto& types = options_.file_schema.feature_types;
-
-  for (size_t r = 0; r < rows; r++) {
+  // values of the numeric cols, whose types Add checked, so that a cell is
+  // a plain load.
+  std::vector<const void*> values(cols, nullptr);
+  for (size_t c = 0; c < cols; c++) {
+    data.VisitCol(c, [&](const auto& col) {
+      if constexpr (kIsNumericColumn<std::decay_t<decltype(col)>>) {
+        values[c] = col.data();
+      }
+    });
+  }
+  char buf[std::numeric_limits<double>::max_digits10 + 10];
+  for (size_t r = begin; r < end; r++) {
     for (size_t c = 0; c < cols; c++) {
       switch (types[c]) {
         case Schema::FLOAT: {
-          auto v =
-              FloatToString(data.At<float>(r, c), options_.float_precision);
-          out_->Write(v.c_str(), v.size());
+          char* last = FloatToChars(Cell<float>(values, r, c),
+                                    options_.float_precision, buf,
+                                    buf + sizeof(buf));
+          out->append(buf, last - buf);
           break;
         }
         case Schema::DOUBLE: {
-          auto v =
-              FloatToString(data.At<double>(r, c), options_.float_precision);
-          out_->Write(v.c_str(), v.size());
+          char* last = FloatToChars(Cell<double>(values, r, c),
+                                    options_.float_precision, buf,
+                                    buf + sizeof(buf));
+          out->append(buf, last - buf);
           break;
         }
         case Schema::STRING: {
-          const auto& v = data.At<std::string>(r, c);
-          out_->Write(v.c_str(), v.size());
+          out->append(data.StringAt(r, c));
+          break;
+        }
+        case Schema::INT32: {
+          out->append(buf, IntToChars(Cell<int32_t>(values, r, c), buf));
+          break;
+        }
+        case Schema::INT64: {
+          out->append(buf, IntToChars(Cell<int64_t>(values, r, c), buf));
+          break;
+        }
+        case Schema::UINT64: {
+          out->append(buf, IntToChars(Cell<uint64_t>(values, r, c), buf));
+          break;
+        }
+        case Schema::FXP64: {
+          char* last = FloatToChars(
+              FxpToDouble(Cell<uint64_t>(values, r, c), options_.fxp_bits),
+              options_.float_precision, buf, buf + sizeof(buf));
+          out->append(buf, last - buf);
+          break;
+        }
+        case Schema::FXP128: {
+          char* last = FloatToChars(
+              FxpToDouble(Cell<uint128_t>(values, r, c), options_.fxp_bits),
+              options_.float_precision, buf, buf + sizeof(buf));
+          out->append(buf, last - buf);
           break;
         }
         default:
           YASL_THROW("unknow Schema::type {}", types[c]);
       }
       if (c + 1 != cols) {
-        out_->Write(field_delimiter_.c_str(), field_delimiter_.size());
+        out->append(field_delimiter_);
       }
     }
-    out_->Write(line_delimiter_.c_str(), line_delimiter_.size());
+    out->append(line_delimiter_);
+  }
+}
+
+bool CsvWriter::Add(const ColumnVectorBatch& data) {
+  YASL_ENFORCE(inited_, "Please Call Init before use writer");
+  const size_t rows = data.Shape().rows;
+  const size_t cols = data.Shape().cols;
+  YASL_ENFORCE(cols == options_.file_schema.feature_names.size());
+  // once per batch, FormatRows loads values unchecked.
+  const auto& types = options_.file_schema.feature_types;
+  for (size_t c = 0; c < cols; c++) {
+    YASL_ENFORCE(ColumnMatches(data.RawCol(c), types[c], false) ||
+                     ColumnMatches(data.RawCol(c), types[c], true),
+                 "col {} of batch does not match schema type {}", c,
+                 types[c]);
+  }
+
+  if (!options_.parallel_format || rows <= kFormatBlockRows) {
+    buffer_.clear();
+    FormatRows(data, 0, rows, &buffer_);
+    out_->Write(buffer_);
+    return true;
+  }
+
+  const size_t blocks = (rows + kFormatBlockRows - 1) / kFormatBlockRows;
+  std::vector<std::string> formatted(blocks);
+  yasl::parallel_for(0, blocks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      FormatRows(data, b * kFormatBlockRows,
+                 std::min(rows, (b + 1) * kFormatBlockRows), &formatted[b]);
+    }
+  });
+  for (const auto& block : formatted) {
+    out_->Write(block);
   }
   return true;
 }
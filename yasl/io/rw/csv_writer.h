@@ -14,6 +14,8 @@
 
 #pragma once
 #include <memory>
+#include <string>
+#include <string_view>
 
 #include "yasl/io/rw/schema.h"
 #include "yasl/io/rw/writer.h"
@@ -40,12 +42,25 @@ class CsvWriter : public Writer {
     return out_->Tellp();
   }
 
+  // appends rows [begin, end) of data to out as csv lines. thread safe.
+  void FormatRows(const ColumnVectorBatch& data, size_t begin, size_t end,
+                  std::string* out) const;
+
+  // writes lines made by FormatRows.
+  void WriteFormatted(std::string_view lines) {
+    YASL_ENFORCE(inited_, "Please Call Init before use writer");
+    out_->Write(lines);
+  }
+
  private:
+
   const WriterOptions options_;
   const std::string field_delimiter_;
   const std::string line_delimiter_;
   bool inited_;
   std::unique_ptr<OutputStream> out_;
+  // formatted batch, kept to reuse its capacity.
+  std::string buffer_;
 };
 
 }  // namespace yasl::io
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <algorithm>
+#include <charconv>
 #include <cmath>
 #include <cstdio>
 #include <limits>
@@ -23,6 +24,8 @@
 
 #include "absl/strings/numbers.h"
 
+#include "yasl/base/int128.h"
+
 namespace yasl::io {
 
 #define YASL_UNLIKELY(x) __builtin_expect((x), 0)
@@ -37,24 +40,50 @@ S FloatNormalization(S v) {
   return v;
 }
 
+// formats v as printf("%.*g", precision, v) into [first, last), or as the
+// shortest string that parses back to v if precision is 0. returns the end
+// of the output, `last` should leave max_digits10 + 10 chars.
+template <class S>
+char* FloatToChars(S v, int precision, char* first, char* last) {
+  static_assert(std::is_floating_point_v<S>);
+  v = FloatNormalization(v);
+  if (precision == 0) {
+    return std::to_chars(first, last, v).ptr;
+  }
+  return std::to_chars(
+             first, last, v, std::chars_format::general,
+             std::min(std::numeric_limits<S>::max_digits10, precision))
+      .ptr;
+}
+
 template <class S>
 std::string FloatToString(S v, int precision) {
   static_assert(std::is_floating_point_v<S>);
   constexpr size_t max_len = std::numeric_limits<S>::max_digits10 + 10;
   std::string ret(max_len, '\0');
-  v = FloatNormalization(v);
-  auto n = std::snprintf(
-      ret.data(), max_len, "%.*g",
-      std::min(std::numeric_limits<S>::max_digits10, precision), v);
-  ret.resize(n);
+  ret.resize(FloatToChars(v, precision, ret.data(), ret.data() + max_len) -
+             ret.data());
   return ret;
 }
 
+namespace internal {
+
+// Parses decimal numbers the same as absl::SimpleAtod, surrounding ascii
+// whitespace and a leading '+' allowed, without its string_view round trips.
+// Significands of up to 19 digits take the Clinger fast path or the
+// Eisel-Lemire algorithm. false means "not handled here" rather than
+// invalid, e.g. for inf/nan, longer significands, subnormal or overflowing
+// results and malformed input, callers then fall back to SimpleAtod.
+bool FastAtod(absl::string_view str, double* out);
+
+}  // namespace internal
+
 template <class S>
 [[nodiscard]] bool FloatFromString(absl::string_view str, S* ret) {
   static_assert(std::is_floating_point_v<S>);
   double double_value = 0;
-  if (YASL_UNLIKELY(!absl::SimpleAtod(str, &double_value))) {
+  if (!internal::FastAtod(str, &double_value) &&
+      YASL_UNLIKELY(!absl::SimpleAtod(str, &double_value))) {
     return false;
   }
   if (YASL_UNLIKELY(std::isnan(double_value))) {
@@ -64,6 +93,39 @@ template <class S>
   return true;
 }
 
+// fixed point: v is encoded as round(v * 2^fxp_bits), two's complement in
+// uint64_t or uint128_t. false if str is no float or does not fit.
+template <class U>
+[[nodiscard]] bool FxpFromString(absl::string_view str, int fxp_bits, U* ret) {
+  static_assert(std::is_same_v<U, uint64_t> || std::is_same_v<U, uint128_t>);
+  double value = 0;
+  if (!FloatFromString(str, &value)) {
+    return false;
+  }
+  const double scaled = std::round(std::ldexp(value, fxp_bits));
+  const double bound = std::ldexp(1.0, sizeof(U) * 8 - 1);
+  if (YASL_UNLIKELY(!(scaled >= -bound && scaled < bound))) {
+    return false;
+  }
+  if constexpr (sizeof(U) == sizeof(uint64_t)) {
+    *ret = static_cast<U>(static_cast<int64_t>(scaled));
+  } else {
+    *ret = static_cast<U>(static_cast<int128_t>(scaled));
+  }
+  return true;
+}
+
+template <class U>
+double FxpToDouble(U v, int fxp_bits) {
+  static_assert(std::is_same_v<U, uint64_t> || std::is_same_v<U, uint128_t>);
+  if constexpr (sizeof(U) == sizeof(uint64_t)) {
+    return std::ldexp(static_cast<double>(static_cast<int64_t>(v)), -fxp_bits);
+  } else {
+    return std::ldexp(static_cast<double>(static_cast<int128_t>(v)),
+                      -fxp_bits);
+  }
+}
+
 #undef YASL_UNLIKELY
 
 }  // namespace yasl::io
\ No newline at end of file
@@ -0,0 +1,168 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/io/rw/float.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+namespace yasl::io {
+
+namespace {
+
+uint64_t Bits(double d) {
+  uint64_t bits;
+  std::memcpy(&bits, &d, sizeof(d));
+  return bits;
+}
+
+// FastAtod either leaves the input to SimpleAtod or agrees with it bit for
+// bit.
+void CheckSameAsSimpleAtod(const std::string& str) {
+  double expected = 0;
+  const bool expected_ok = absl::SimpleAtod(str, &expected);
+  double fast = 0;
+  if (internal::FastAtod(str, &fast)) {
+    EXPECT_TRUE(expected_ok) << str;
+    EXPECT_EQ(Bits(fast), Bits(expected)) << str;
+  }
+  double value = 0;
+  EXPECT_EQ(FloatFromString(str, &value), expected_ok && !std::isnan(expected))
+      << str;
+}
+
+}  // namespace
+
+TEST(FloatTest, Syntax) {
+  for (const char* str :
+       {"0", "-0", "+0", "1", "-1", "+1", "+-1", "-+1", "1.", ".5", "-.5", ".",
+        "-", "+", "", " ", " 2  ", "\t3.25\n", "1e", "1e+", "1e-2", "1E2",
+        "1e+308", "1e309", "-1e309", "1e-320", "1e-400", "-1e-400", "0e999",
+        "00012.5000", "1,5", "1.5.2", "0x10", "inf", "-inf", "nan",
+        "infinity", "1 2", "12345678901234567890", "1234567890123456789",
+        "9007199254740993", "0.1000000000000000055511151231257827",
+        "2.2250738585072014e-308", "2.2250738585072011e-308",
+        "1.7976931348623157e308", "1.7976931348623159e308", "4.9e-324"}) {
+    CheckSameAsSimpleAtod(str);
+  }
+}
+
+TEST(FloatTest, MatchesStrtod) {
+  std::mt19937_64 rng(7);
+  std::uniform_int_distribution<int> exp_dist(-330, 310);
+  for (size_t i = 0; i < 200000; i++) {
+    // random significands of 1 to 19 digits.
+    const uint64_t w = rng() % 10000000000000000000ULL;
+    const int digits = 1 + rng() % 19;
+    std::string str = fmt::format("{}", w).substr(0, digits);
+    if (rng() % 2) {
+      str.insert(1 + rng() % str.size(), ".");
+    }
+    str += fmt::format("e{}", exp_dist(rng));
+    double fast = 0;
+    if (internal::FastAtod(str, &fast)) {
+      EXPECT_EQ(Bits(fast), Bits(std::strtod(str.c_str(), nullptr))) << str;
+    }
+  }
+}
+
+TEST(FloatTest, RoundTrip) {
+  std::mt19937_64 rng(11);
+  size_t fast_count = 0;
+  for (size_t i = 0; i < 100000; i++) {
+    double d;
+    const uint64_t bits = rng();
+    std::memcpy(&d, &bits, sizeof(d));
+    // FloatToString prints subnormals as 0.
+    if (!std::isnormal(d)) {
+      continue;
+    }
+    const auto str = FloatToString(d, 17);
+    double fast = 0;
+    if (internal::FastAtod(str, &fast)) {
+      fast_count++;
+      EXPECT_EQ(Bits(fast), Bits(d)) << str;
+    }
+    CheckSameAsSimpleAtod(str);
+  }
+  // only subnormal and overflowing results are left to the slow path.
+  EXPECT_GT(fast_count, 90000);
+}
+
+TEST(FloatTest, ToCharsMatchesPrintf) {
+  std::mt19937_64 rng(13);
+  for (size_t i = 0; i < 100000; i++) {
+    double d;
+    const uint64_t bits = rng();
+    std::memcpy(&d, &bits, sizeof(d));
+    const int precision = 1 + i % 17;
+    char expected[64];
+    std::snprintf(expected, sizeof(expected), "%.*g", precision,
+                  FloatNormalization(d));
+    EXPECT_EQ(FloatToString(d, precision), expected);
+    const float f = static_cast<float>(d);
+    std::snprintf(expected, sizeof(expected), "%.*g", 1 + precision % 9,
+                  FloatNormalization(f));
+    EXPECT_EQ(FloatToString(f, 1 + precision % 9), expected);
+  }
+}
+
+TEST(FloatTest, ShortestRoundTrip) {
+  EXPECT_EQ(FloatToString(0.1f, 0), "0.1");
+  EXPECT_EQ(FloatToString(0.1, 0), "0.1");
+  EXPECT_EQ(FloatToString(1e-320, 0), "0");
+  std::mt19937_64 rng(17);
+  for (size_t i = 0; i < 100000; i++) {
+    double d;
+    const uint64_t bits = rng();
+    std::memcpy(&d, &bits, sizeof(d));
+    if (!std::isnormal(d)) {
+      continue;
+    }
+    double back = 0;
+    ASSERT_TRUE(FloatFromString(FloatToString(d, 0), &back));
+    EXPECT_EQ(Bits(back), Bits(d));
+  }
+}
+
+TEST(FloatTest, FixedPoint) {
+  uint64_t v64 = 0;
+  EXPECT_TRUE(FxpFromString("1.5", 18, &v64));
+  EXPECT_EQ(v64, 3 << 17);
+  EXPECT_TRUE(FxpFromString(" -0.25 ", 18, &v64));
+  EXPECT_EQ(v64, uint64_t(-(1 << 16)));
+  EXPECT_EQ(FxpToDouble(v64, 18), -0.25);
+  // rounds to the nearest.
+  EXPECT_TRUE(FxpFromString("1e-6", 18, &v64));
+  EXPECT_EQ(v64, 0);
+  EXPECT_TRUE(FxpFromString("3e-6", 18, &v64));
+  EXPECT_EQ(v64, 1);
+  EXPECT_FALSE(FxpFromString("1e14", 50, &v64));
+  EXPECT_FALSE(FxpFromString("inf", 18, &v64));
+  EXPECT_FALSE(FxpFromString("x", 18, &v64));
+
+  uint128_t v128 = 0;
+  EXPECT_TRUE(FxpFromString("-1e20", 40, &v128));
+  EXPECT_EQ(static_cast<int128_t>(v128),
+            -static_cast<int128_t>(100000000000000000000.0 * (1ULL << 40)));
+  EXPECT_EQ(FxpToDouble(v128, 40), -1e20);
+  EXPECT_FALSE(FxpFromString("1e30", 40, &v128));
+}
+
+}  // namespace yasl::io
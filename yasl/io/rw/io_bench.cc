@@ -0,0 +1,371 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+#include "yasl/io/rw/csv_reader.h"
+#include "yasl/io/rw/csv_writer.h"
+#include "yasl/io/stream/file_io.h"
+#include "yasl/io/stream/gzip_io.h"
+#include "yasl/io/stream/mem_io.h"
+#include "yasl/io/stream/mmap_io.h"
+#include "yasl/io/stream/readahead_io.h"
+
+namespace yasl::io {
+namespace {
+
+enum Shape : int64_t {
+  // 200k rows of 8 features.
+  kTall = 0,
+  // 2k rows of 800 features.
+  kWide = 1,
+};
+
+enum Stream : int64_t {
+  kFile = 0,
+  kMem = 1,
+  kMmap = 2,
+  kReadAhead = 3,
+  kGzip = 4,
+};
+
+// a synthetic csv with an "id" column and features f0, f1, ... of one
+// type, kept in memory and in plain and gzip files for the process.
+struct Dataset {
+  Schema schema;
+  std::string data;
+  std::string file_name;
+  std::string gzip_name;
+
+  ~Dataset() {
+    std::filesystem::remove(file_name);
+    std::filesystem::remove(gzip_name);
+  }
+};
+
+std::string RandomField(Schema::Type type, std::mt19937_64& rng) {
+  switch (type) {
+    case Schema::STRING:
+      return fmt::format("s{:x}", rng() >> (rng() % 48));
+    case Schema::INT32:
+      return fmt::format("{}", static_cast<int32_t>(rng()));
+    case Schema::INT64:
+      return fmt::format("{}", static_cast<int64_t>(rng()));
+    case Schema::UINT64:
+      return fmt::format("{}", rng());
+    default:
+      // FLOAT, DOUBLE and fixed point.
+      return fmt::format("{:.6g}", (static_cast<int64_t>(rng() >> 11) -
+                                    (int64_t{1} << 52)) *
+                                       0x1p-40);
+  }
+}
+
+const Dataset& GetDataset(Shape shape, Schema::Type type) {
+  static std::map<std::pair<Shape, Schema::Type>, std::unique_ptr<Dataset>>
+      cache;
+  auto& ret = cache[{shape, type}];
+  if (ret != nullptr) {
+    return *ret;
+  }
+  ret = std::make_unique<Dataset>();
+  const size_t rows = shape == kTall ? 200000 : 2000;
+  const size_t features = shape == kTall ? 8 : 800;
+  std::string header = "id";
+  for (size_t f = 0; f < features; f++) {
+    header += fmt::format(",f{}", f);
+    ret->schema.feature_names.push_back(fmt::format("f{}", f));
+    ret->schema.feature_types.push_back(type);
+  }
+  ret->data = header + "\n";
+  std::mt19937_64 rng(shape * 16 + type);
+  for (size_t r = 0; r < rows; r++) {
+    ret->data += fmt::format("u{}", r);
+    for (size_t f = 0; f < features; f++) {
+      ret->data.push_back(',');
+      ret->data += RandomField(type, rng);
+    }
+    ret->data.push_back('\n');
+  }
+
+  const auto dir = std::filesystem::temp_directory_path();
+  ret->file_name =
+      (dir / fmt::format("io_bench.{}.{}.{}.csv", getpid(), shape, type))
+          .string();
+  ret->gzip_name = ret->file_name + ".gz";
+  FileOutputStream out(ret->file_name);
+  out.Write(ret->data);
+  out.Close();
+  GzipOutputStream gzip_out(ret->gzip_name);
+  gzip_out.Write(ret->data);
+  gzip_out.Close();
+  return *ret;
+}
+
+std::unique_ptr<InputStream> Open(Stream stream, const Dataset& dataset) {
+  switch (stream) {
+    case kFile:
+      return std::make_unique<FileInputStream>(dataset.file_name);
+    case kMem:
+      return MemInputStream::View(dataset.data);
+    case kMmap:
+      return std::make_unique<MmapInputStream>(dataset.file_name);
+    case kReadAhead:
+      return std::make_unique<ReadAheadInputStream>(dataset.file_name);
+    case kGzip:
+      return std::make_unique<GzipInputStream>(dataset.gzip_name);
+  }
+  return nullptr;
+}
+
+void SetBytesProcessed(benchmark::State& state, const Dataset& dataset) {
+  state.SetBytesProcessed(state.iterations() * dataset.data.size());
+}
+
+}  // namespace
+
+// state.range(0) is the Stream.
+static void BM_GetLine(benchmark::State& state) {
+  const auto& dataset = GetDataset(kTall, Schema::DOUBLE);
+  std::string line;
+  for (auto _ : state) {
+    auto in = Open(static_cast<Stream>(state.range(0)), dataset);
+    size_t lines = 0;
+    while (in->GetLine(&line)) {
+      lines++;
+    }
+    benchmark::DoNotOptimize(lines);
+  }
+  SetBytesProcessed(state, dataset);
+}
+
+// state.range(0) is the Stream, state.range(1) the Shape,
+// state.range(2) the Schema::Type, state.range(3) 1 for parallel parsing.
+static void BM_RowReader(benchmark::State& state) {
+  const auto& dataset = GetDataset(static_cast<Shape>(state.range(1)),
+                                   static_cast<Schema::Type>(state.range(2)));
+  ReaderOptions options;
+  options.file_schema = dataset.schema;
+  options.batch_size = 10000;
+  options.row_reader_parallel_parse = state.range(3) != 0;
+  for (auto _ : state) {
+    CsvReader reader(options, Open(static_cast<Stream>(state.range(0)),
+                                   dataset));
+    reader.Init();
+    ColumnVectorBatch batch;
+    while (reader.Next(&batch)) {
+      benchmark::DoNotOptimize(batch);
+    }
+  }
+  SetBytesProcessed(state, dataset);
+}
+
+// state.range(0) is the Stream, state.range(1) the Shape, state.range(2)
+// 1 for the in memory column index instead of the mmap files.
+static void BM_ColumnReader(benchmark::State& state) {
+  const auto& dataset =
+      GetDataset(static_cast<Shape>(state.range(1)), Schema::DOUBLE);
+  ReaderOptions options;
+  options.file_schema = dataset.schema;
+  options.column_reader = true;
+  options.column_reader_memory_budget =
+      state.range(2) != 0 ? dataset.data.size() : 0;
+  for (auto _ : state) {
+    CsvReader reader(options, Open(static_cast<Stream>(state.range(0)),
+                                   dataset));
+    reader.Init();
+    ColumnVectorBatch batch;
+    while (reader.Next(&batch)) {
+      benchmark::DoNotOptimize(batch);
+    }
+  }
+  SetBytesProcessed(state, dataset);
+}
+
+// 2 of the 800 features of the wide dataset, state.range(0) is the Stream.
+static void BM_Projection(benchmark::State& state) {
+  const auto& dataset = GetDataset(kWide, Schema::DOUBLE);
+  ReaderOptions options;
+  options.file_schema.feature_names = {"f3", "f10"};
+  options.file_schema.feature_types = {Schema::DOUBLE, Schema::DOUBLE};
+  options.batch_size = 10000;
+  for (auto _ : state) {
+    CsvReader reader(options, Open(static_cast<Stream>(state.range(0)),
+                                   dataset));
+    reader.Init();
+    ColumnVectorBatch batch;
+    while (reader.Next(&batch)) {
+      benchmark::DoNotOptimize(batch);
+    }
+  }
+  SetBytesProcessed(state, dataset);
+}
+
+// random Seek of a reader Spawn()ed from one that knows its rows, then a
+// batch of 100 rows. state.range(0) is the Stream, state.range(1) 1 to load
+// a row index.
+static void BM_SpawnSeek(benchmark::State& state) {
+  const auto& dataset = GetDataset(kTall, Schema::DOUBLE);
+  ReaderOptions options;
+  options.file_schema = dataset.schema;
+  options.batch_size = 1000;
+  options.row_reader_count_lines = true;
+  if (state.range(1) != 0) {
+    options.row_index_path = dataset.file_name + ".idx";
+  }
+  CsvReader reader(options,
+                   Open(static_cast<Stream>(state.range(0)), dataset));
+  reader.Init();
+  std::mt19937_64 rng(1);
+  ColumnVectorBatch batch;
+  for (auto _ : state) {
+    auto spawned = reader.Spawn();
+    spawned->Seek(rng() % (reader.Rows() - 100));
+    spawned->Next(100, &batch);
+    benchmark::DoNotOptimize(batch);
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.range(1) != 0) {
+    std::filesystem::remove(options.row_index_path);
+  }
+}
+
+// Split(state.range(1)) of a fresh reader, one shard read by each thread
+// in turn. state.range(0) is the Stream.
+static void BM_Split(benchmark::State& state) {
+  const auto& dataset = GetDataset(kTall, Schema::DOUBLE);
+  ReaderOptions options;
+  options.file_schema = dataset.schema;
+  options.batch_size = 10000;
+  for (auto _ : state) {
+    CsvReader reader(options, Open(static_cast<Stream>(state.range(0)),
+                                   dataset));
+    reader.Init();
+    auto shards = reader.Split(state.range(1));
+    std::vector<std::thread> threads;
+    for (auto& shard : shards) {
+      threads.emplace_back([&shard] {
+        ColumnVectorBatch batch;
+        while (shard->Next(&batch)) {
+          benchmark::DoNotOptimize(batch);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  SetBytesProcessed(state, dataset);
+}
+
+// writes the tall dataset of Schema::Type state.range(0), read once into
+// batches of 10000 rows. state.range(1) is 0 for MemOutputStream, 1 for
+// FileOutputStream, 2 for GzipOutputStream, state.range(2) 1 for
+// parallel formatting.
+static void BM_CsvWriter(benchmark::State& state) {
+  const auto& dataset =
+      GetDataset(kTall, static_cast<Schema::Type>(state.range(0)));
+  std::vector<ColumnVectorBatch> batches;
+  {
+    ReaderOptions options;
+    options.file_schema = dataset.schema;
+    options.batch_size = 10000;
+    CsvReader reader(options, MemInputStream::View(dataset.data));
+    reader.Init();
+    ColumnVectorBatch batch;
+    while (reader.Next(&batch)) {
+      batches.push_back(std::move(batch));
+    }
+  }
+  WriterOptions options;
+  options.file_schema = dataset.schema;
+  options.parallel_format = state.range(2) != 0;
+  const std::string file_name = dataset.file_name + ".out";
+  size_t bytes = 0;
+  for (auto _ : state) {
+    std::unique_ptr<OutputStream> out;
+    switch (state.range(1)) {
+      case 0:
+        out = std::make_unique<MemOutputStream>();
+        break;
+      case 1:
+        out = std::make_unique<FileOutputStream>(file_name);
+        break;
+      default:
+        out = std::make_unique<GzipOutputStream>(file_name);
+        break;
+    }
+    CsvWriter writer(options, std::move(out));
+    writer.Init();
+    for (const auto& batch : batches) {
+      writer.Add(batch);
+    }
+    writer.Flush();
+    bytes += writer.Tellp();
+    writer.Close();
+  }
+  state.SetBytesProcessed(bytes);
+  std::filesystem::remove(file_name);
+}
+
+BENCHMARK(BM_GetLine)->DenseRange(kFile, kGzip);
+
+BENCHMARK(BM_RowReader)
+    ->ArgNames({"stream", "shape", "type", "parallel"})
+    ->ArgsProduct({{kFile, kMem, kMmap, kReadAhead, kGzip},
+                   {kTall, kWide},
+                   {Schema::DOUBLE},
+                   {0, 1}})
+    ->ArgsProduct({{kMmap},
+                   {kTall},
+                   {Schema::STRING, Schema::FLOAT, Schema::INT32,
+                    Schema::INT64, Schema::UINT64, Schema::FXP64,
+                    Schema::FXP128},
+                   {0}});
+
+BENCHMARK(BM_ColumnReader)
+    ->ArgNames({"stream", "shape", "in_memory"})
+    ->ArgsProduct({{kFile, kMem, kMmap}, {kTall, kWide}, {0, 1}});
+
+BENCHMARK(BM_Projection)->DenseRange(kFile, kGzip);
+
+BENCHMARK(BM_SpawnSeek)
+    ->ArgNames({"stream", "row_index"})
+    ->ArgsProduct({{kFile, kMem, kMmap, kReadAhead, kGzip}, {0, 1}});
+
+BENCHMARK(BM_Split)
+    ->ArgNames({"stream", "shards"})
+    ->ArgsProduct({{kMem, kMmap}, {1, 2, 4, 8}})
+    ->UseRealTime();
+
+BENCHMARK(BM_CsvWriter)
+    ->ArgNames({"type", "output", "parallel"})
+    ->ArgsProduct({{Schema::STRING, Schema::DOUBLE, Schema::INT64,
+                    Schema::FXP64},
+                   {0, 1, 2},
+                   {0, 1}});
+
+}  // namespace yasl::io
@@ -44,6 +44,11 @@ MmappedFile::MmappedFile(const std::string &path) {
 
   YASL_ENFORCE(fd != -1, "failed to open file {}", path);
 
+  // mmap of zero bytes fails with EINVAL, leave data_ as nullptr.
+  if (size_ == 0) {
+    return;
+  }
+
   // mmap whole file into memory
   data_ = absl::base_internal::DirectMmap(nullptr, size_, PROT_READ,
                                           MAP_PRIVATE, fd, 0);
@@ -0,0 +1,156 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/io/rw/parallel_csv_writer.h"
+
+#include <filesystem>
+#include <utility>
+
+#include "fmt/format.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/io/stream/file_io.h"
+
+namespace yasl::io {
+
+ParallelCsvWriter::ParallelCsvWriter(WriterOptions op,
+                                     std::unique_ptr<OutputStream> out,
+                                     char field_delimiter, char line_delimiter)
+    : options_(std::move(op)),
+      field_delimiter_(field_delimiter),
+      line_delimiter_(line_delimiter),
+      writer_(std::make_unique<CsvWriter>(options_, std::move(out),
+                                          field_delimiter, line_delimiter)) {}
+
+ParallelCsvWriter::ParallelCsvWriter(WriterOptions op, std::string part_prefix,
+                                     char field_delimiter, char line_delimiter)
+    : options_(std::move(op)),
+      field_delimiter_(field_delimiter),
+      line_delimiter_(line_delimiter),
+      part_prefix_(std::move(part_prefix)) {
+  YASL_ENFORCE(!part_prefix_.empty());
+  YASL_ENFORCE(!options_.file_schema.feature_names.empty());
+  YASL_ENFORCE(options_.file_schema.feature_names.size() ==
+               options_.file_schema.feature_types.size());
+}
+
+std::string ParallelCsvWriter::PartPath(const std::string& part_prefix,
+                                        size_t seq) {
+  return fmt::format("{}.part-{:05d}", part_prefix, seq);
+}
+
+void ParallelCsvWriter::Init() {
+  YASL_ENFORCE(!inited_, "DO NOT call init multiply times");
+  if (writer_) {
+    writer_->Init();
+  }
+  inited_ = true;
+}
+
+void ParallelCsvWriter::Add(size_t seq, const ColumnVectorBatch& data) {
+  YASL_ENFORCE(inited_, "Please Call Init before use writer");
+  YASL_ENFORCE(data.Shape().cols ==
+               options_.file_schema.feature_names.size());
+  if (!writer_) {
+    AddPart(seq, data);
+    return;
+  }
+
+  std::string block;
+  writer_->FormatRows(data, 0, data.Shape().rows, &block);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  YASL_ENFORCE(seq >= next_seq_ && pending_.count(seq) == 0,
+               "block {} is added twice", seq);
+  pending_.emplace(seq, std::move(block));
+  if (writing_) {
+    // the writing thread picks it up if it is next.
+    return;
+  }
+  writing_ = true;
+  try {
+    while (!pending_.empty() && pending_.begin()->first == next_seq_) {
+      auto next = pending_.extract(pending_.begin());
+      next_seq_++;
+      lock.unlock();
+      writer_->WriteFormatted(next.mapped());
+      lock.lock();
+    }
+  } catch (...) {
+    if (!lock.owns_lock()) {
+      lock.lock();
+    }
+    writing_ = false;
+    throw;
+  }
+  writing_ = false;
+}
+
+void ParallelCsvWriter::AddPart(size_t seq, const ColumnVectorBatch& data) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    YASL_ENFORCE(part_rows_.emplace(seq, data.Shape().rows).second,
+                 "block {} is added twice", seq);
+  }
+  CsvWriter writer(options_,
+                   std::make_unique<FileOutputStream>(
+                       PartPath(part_prefix_, seq)),
+                   field_delimiter_, line_delimiter_);
+  writer.Init();
+  writer.Add(data);
+  writer.Flush();
+  const size_t bytes = writer.Tellp();
+  writer.Close();
+  std::lock_guard<std::mutex> lock(mutex_);
+  part_bytes_ += bytes;
+}
+
+void ParallelCsvWriter::Close() {
+  YASL_ENFORCE(inited_, "Please Call Init before use writer");
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (writer_) {
+    YASL_ENFORCE(pending_.empty(), "block {} is missing, {} blocks after it",
+                 next_seq_, pending_.size());
+    writer_->Close();
+    return;
+  }
+
+  YASL_ENFORCE(part_rows_.empty() ||
+                   part_rows_.rbegin()->first + 1 == part_rows_.size(),
+               "{} parts are missing",
+               part_rows_.empty()
+                   ? 0
+                   : part_rows_.rbegin()->first + 1 - part_rows_.size());
+  std::string manifest = fmt::format("part{}rows{}", field_delimiter_,
+                                     line_delimiter_);
+  for (const auto& [seq, rows] : part_rows_) {
+    const auto part = std::filesystem::path(PartPath(part_prefix_, seq));
+    manifest += fmt::format("{}{}{}{}", part.filename().string(),
+                            field_delimiter_, rows, line_delimiter_);
+  }
+  FileOutputStream out(part_prefix_ + ".manifest");
+  out.Write(manifest);
+  out.Close();
+}
+
+size_t ParallelCsvWriter::Tellp() {
+  YASL_ENFORCE(inited_, "Please Call Init before use writer");
+  if (writer_) {
+    return writer_->Tellp();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  return part_bytes_;
+}
+
+}  // namespace yasl::io
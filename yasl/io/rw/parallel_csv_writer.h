@@ -0,0 +1,85 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "yasl/io/rw/csv_writer.h"
+#include "yasl/io/rw/schema.h"
+#include "yasl/io/rw/writer.h"
+
+namespace yasl::io {
+
+// csv writer for many producer threads. each thread adds its own blocks of
+// rows, numbered by seq from 0, and formats them on its own; no thread
+// waits for another to format.
+//
+// to a single stream, a block is written once all blocks before it are,
+// so the output is the same as adding the blocks to a CsvWriter in seq
+// order. out of order blocks are buffered until their turn.
+//
+// to part files, block seq goes to its own csv file PartPath(prefix, seq),
+// with the header line, as soon as it is formatted. Close writes the
+// manifest prefix + ".manifest", a csv listing "part,rows" in seq order.
+class ParallelCsvWriter {
+ public:
+  ParallelCsvWriter(WriterOptions, std::unique_ptr<OutputStream>,
+                    char field_delimiter = ',', char line_delimiter = '\n');
+
+  ParallelCsvWriter(WriterOptions, std::string part_prefix,
+                    char field_delimiter = ',', char line_delimiter = '\n');
+
+  void Init();
+
+  // thread safe. every seq from 0 up must be added exactly once.
+  void Add(size_t seq, const ColumnVectorBatch& data);
+
+  // call once all Add returned. throws if a block is missing.
+  void Close();
+
+  // written size in bytes, of all parts in part mode. call once all Add
+  // returned.
+  size_t Tellp();
+
+  static std::string PartPath(const std::string& part_prefix, size_t seq);
+
+ private:
+  void AddPart(size_t seq, const ColumnVectorBatch& data);
+
+  const WriterOptions options_;
+  const char field_delimiter_;
+  const char line_delimiter_;
+  // single stream mode.
+  std::unique_ptr<CsvWriter> writer_;
+  // part file mode.
+  const std::string part_prefix_;
+  bool inited_ = false;
+
+  std::mutex mutex_;
+  // next block to write to the single stream.
+  size_t next_seq_ = 0;
+  // formatted blocks waiting for their turn.
+  std::map<size_t, std::string> pending_;
+  // a thread is writing pending blocks, others only leave theirs.
+  bool writing_ = false;
+  // rows of the parts added so far.
+  std::map<size_t, size_t> part_rows_;
+  size_t part_bytes_ = 0;
+};
+
+}  // namespace yasl::io
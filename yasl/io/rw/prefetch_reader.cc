@@ -0,0 +1,198 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/io/rw/prefetch_reader.h"
+
+#include <utility>
+
+#include "yasl/base/exception.h"
+
+namespace yasl::io {
+
+PrefetchReader::PrefetchReader(std::unique_ptr<Reader> reader, size_t depth)
+    : reader_(std::move(reader)), depth_(depth) {
+  YASL_ENFORCE(reader_ != nullptr);
+  YASL_ENFORCE(depth_ > 0, "prefetch depth should be positive");
+}
+
+PrefetchReader::~PrefetchReader() { Stop(); }
+
+void PrefetchReader::Init() {
+  YASL_ENFORCE(!inited_, "DO NOT call init multiply times");
+  reader_->Init();
+  tell_ = reader_->Tell();
+  rows_ = reader_->Rows();
+  inited_ = true;
+}
+
+std::unique_ptr<PrefetchReader> PrefetchReader::Wrap(
+    std::unique_ptr<Reader> reader, size_t depth) {
+  auto ret = std::make_unique<PrefetchReader>(std::move(reader), depth);
+  ret->tell_ = ret->reader_->Tell();
+  ret->rows_ = ret->reader_->Rows();
+  ret->inited_ = true;
+  return ret;
+}
+
+bool PrefetchReader::Next(ColumnVectorBatch* data) {
+  return NextBatch(0, data);
+}
+
+bool PrefetchReader::Next(size_t size, ColumnVectorBatch* data) {
+  YASL_ENFORCE(size > 0, "batch size should be positive");
+  return NextBatch(size, data);
+}
+
+bool PrefetchReader::NextBatch(size_t size, ColumnVectorBatch* data) {
+  YASL_ENFORCE(inited_, "Please Call Init before use reader");
+  if (prefetch_thread_.joinable() && size != prefetch_size_) {
+    Rewind();
+  }
+  if (!prefetch_thread_.joinable()) {
+    Start(size);
+  }
+
+  Entry entry;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return !ready_.empty(); });
+    entry = std::move(ready_.front());
+    ready_.pop_front();
+    free_.push_back(std::move(*data));
+  }
+  cv_.notify_all();
+
+  if (!entry.ok || entry.error) {
+    // the thread exited after it.
+    prefetch_thread_.join();
+  }
+  if (entry.error) {
+    std::rethrow_exception(entry.error);
+  }
+  *data = std::move(entry.batch);
+  tell_ = entry.tell;
+  rows_ = entry.rows;
+  return entry.ok;
+}
+
+size_t PrefetchReader::Tell() const {
+  YASL_ENFORCE(inited_, "Please Call Init before use reader");
+  return tell_;
+}
+
+void PrefetchReader::Seek(size_t index) {
+  YASL_ENFORCE(inited_, "Please Call Init before use reader");
+  Stop();
+  reader_->Seek(index);
+  tell_ = reader_->Tell();
+  rows_ = reader_->Rows();
+}
+
+size_t PrefetchReader::Rows() const {
+  YASL_ENFORCE(inited_, "Please Call Init before use reader");
+  return rows_;
+}
+
+size_t PrefetchReader::Tellg() {
+  YASL_ENFORCE(inited_, "Please Call Init before use reader");
+  Rewind();
+  return reader_->Tellg();
+}
+
+std::unique_ptr<Reader> PrefetchReader::Spawn() {
+  YASL_ENFORCE(inited_, "CAN NOT Spawn before init");
+  Rewind();
+  return Wrap(reader_->Spawn(), depth_);
+}
+
+std::vector<std::unique_ptr<Reader>> PrefetchReader::Split(size_t n) {
+  YASL_ENFORCE(inited_, "CAN NOT Split before init");
+  Rewind();
+  auto shards = reader_->Split(n);
+  for (auto& shard : shards) {
+    shard = Wrap(std::move(shard), depth_);
+  }
+  return shards;
+}
+
+void PrefetchReader::Start(size_t size) {
+  prefetch_size_ = size;
+  prefetch_thread_ = std::thread([this, size] { PrefetchLoop(size); });
+}
+
+void PrefetchReader::Stop() {
+  if (!prefetch_thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  prefetch_thread_.join();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  stop_ = false;
+  for (auto& entry : ready_) {
+    free_.push_back(std::move(entry.batch));
+  }
+  ready_.clear();
+}
+
+void PrefetchReader::Rewind() {
+  Stop();
+  // the inner reader is ahead by the dropped batches.
+  if (reader_->Tell() != tell_) {
+    reader_->Seek(tell_);
+  }
+  rows_ = reader_->Rows();
+}
+
+void PrefetchReader::PrefetchLoop(size_t size) {
+  while (true) {
+    Entry entry;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [&] { return stop_ || ready_.size() < depth_; });
+      if (stop_) {
+        return;
+      }
+      if (!free_.empty()) {
+        entry.batch = std::move(free_.back());
+        free_.pop_back();
+      }
+    }
+
+    try {
+      entry.ok = size == 0 ? reader_->Next(&entry.batch)
+                           : reader_->Next(size, &entry.batch);
+      entry.tell = reader_->Tell();
+      entry.rows = reader_->Rows();
+    } catch (...) {
+      entry.error = std::current_exception();
+    }
+    const bool last = !entry.ok || entry.error;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ready_.push_back(std::move(entry));
+    }
+    cv_.notify_all();
+    if (last) {
+      return;
+    }
+  }
+}
+
+}  // namespace yasl::io
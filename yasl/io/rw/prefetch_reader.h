@@ -0,0 +1,119 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "yasl/io/rw/reader.h"
+#include "yasl/io/rw/schema.h"
+
+namespace yasl::io {
+
+// Reader over another one, whose next `depth` batches are read by a
+// background thread into a bounded queue, so that parsing the next batches
+// overlaps with what the caller does with the current one.
+//
+// Tell() and Rows() are those of the batches returned so far, as if the
+// inner reader was read directly. Seek() stops the thread. Tellg(),
+// Spawn(), Split() and Next() of another size than the last stop it too,
+// and seek the inner reader back to Tell() first. The thread exits once
+// the inner reader returns false, and the next Next() starts it again, so
+// that a tailed reader still sees the rows appended since.
+//
+// an error of the inner reader is raised by the Next() that reaches it.
+class PrefetchReader : public Reader {
+ public:
+  explicit PrefetchReader(std::unique_ptr<Reader> reader, size_t depth = 2);
+
+  ~PrefetchReader() override;
+
+  void Init() override;
+
+  const std::vector<std::string>& Headers() const override {
+    return reader_->Headers();
+  }
+
+  bool Next(ColumnVectorBatch* data) override;
+
+  bool Next(size_t size, ColumnVectorBatch* data) override;
+
+  size_t Tell() const override;
+
+  void Seek(size_t index) override;
+
+  size_t Rows() const override;
+
+  size_t Cols() const override { return reader_->Cols(); }
+
+  size_t GetLength() const override { return reader_->GetLength(); }
+
+  size_t Tellg() override;
+
+  std::unique_ptr<Reader> Spawn() override;
+
+  std::vector<std::unique_ptr<Reader>> Split(size_t n) override;
+
+ private:
+  struct Entry {
+    ColumnVectorBatch batch;
+    bool ok = false;
+    // of the inner reader after the batch.
+    size_t tell = 0;
+    size_t rows = 0;
+    std::exception_ptr error;
+  };
+
+  // wraps an inited reader.
+  static std::unique_ptr<PrefetchReader> Wrap(std::unique_ptr<Reader> reader,
+                                              size_t depth);
+
+  // size 0 for Next(data).
+  bool NextBatch(size_t size, ColumnVectorBatch* data);
+  // starts the prefetch thread reading batches of size.
+  void Start(size_t size);
+  // stops the prefetch thread and drops the batches not returned yet.
+  void Stop();
+  // Stop() and seeks the inner reader back to Tell().
+  void Rewind();
+  // body of the prefetch thread.
+  void PrefetchLoop(size_t size);
+
+  const std::unique_ptr<Reader> reader_;
+  const size_t depth_;
+  bool inited_ = false;
+  // of the batches returned so far.
+  size_t tell_ = 0;
+  size_t rows_ = 0;
+  // of the running prefetch thread.
+  size_t prefetch_size_ = 0;
+
+  // shared with the prefetch thread.
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Entry> ready_;
+  // batches returned by the caller, refilled by the thread.
+  std::vector<ColumnVectorBatch> free_;
+  bool stop_ = false;
+  std::thread prefetch_thread_;
+};
+
+}  // namespace yasl::io
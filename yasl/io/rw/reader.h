@@ -15,6 +15,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "yasl/io/rw/schema.h"
 #include "yasl/io/stream/interface.h"
@@ -35,6 +36,33 @@ struct ReaderOptions {
   // this option is heavy.
   // keep this false if you do not need get file lines before first full scan.
   bool row_reader_count_lines = false;
+  // row reader keeps a sparse index of the input rows in this file. Init()
+  // loads it if it matches the input, otherwise counts the lines and saves
+  // the index. Rows() is then known after Init(), and Seek() skips at most
+  // batch_size lines. empty for no index.
+  std::string row_index_path;
+  // row reader tails a file that is being appended to. Next() returns
+  // complete lines only, leaving a line still being written for a later
+  // call, and returns the lines appended since once it reached the end.
+  // with row_index_path, Init() resumes after the rows saved by the last
+  // CsvReader::Commit(), so that a job reading the new rows of the file
+  // costs O(new data). the index is then written by Commit() only.
+  // not for column readers, nor Split().
+  bool row_reader_tail = false;
+  // row reader parses each batch by yasl::parallel_for workers on byte
+  // ranges of the batch aligned to lines, rows keep their order.
+  // only pays off for big batches, see batch_size.
+  bool row_reader_parallel_parse = false;
+  // column reader keeps inputs of up to this many bytes in memory, local
+  // files mmapped, with numeric columns decoded once and string fields
+  // indexed by offset. bigger inputs are split into temporary mmap files.
+  // 0 always uses the files.
+  size_t column_reader_memory_budget = 0;
+  // STRING features are returned as StringArenaColumnVector instead of
+  // StringColumnVector, see ColumnVectorBatch::StringAt.
+  bool string_arena_columns = false;
+  // fraction bits of FXP64 and FXP128 features.
+  int fxp_bits = 18;
 };
 
 // NOT thread safe. see Spawn().
@@ -96,6 +124,9 @@ class Reader {
    * if read by ROW and row_reader_count_lines == false,
    * return size_t(-1) before first full scan.
    *
+   * if read by ROW and row_reader_tail, return the rows read or committed
+   * so far.
+   *
    * if read by COL, always return real rows.
    */
   virtual size_t Rows() const = 0;
@@ -121,6 +152,17 @@ class Reader {
    * Spawn() is not thread safe too. DO NOT call Spawn() parallel.
    */
   virtual std::unique_ptr<Reader> Spawn() = 0;
+
+  /**
+   * Splits the rows of this reader into n readers over disjoint, consecutive
+   * ranges, so n threads can read a shard each without coordination.
+   * Ranges have about the same rows when Rows() is known, otherwise about
+   * the same bytes cut at line ends. some may be empty.
+   * Each reader starts at the first row of its range, and Tell(), Seek()
+   * and Rows() count from there.
+   * Only callable if column_reader == false. not thread safe, like Spawn().
+   */
+  virtual std::vector<std::unique_ptr<Reader>> Split(size_t n) = 0;
 };
 
 }  // namespace yasl::io
\ No newline at end of file
@@ -16,12 +16,16 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "absl/types/span.h"
+
 #include "yasl/base/exception.h"
+#include "yasl/base/int128.h"
 
 namespace yasl::io {
 
@@ -35,8 +39,96 @@ using DoubleColumnVector = ColumnVector<double>;
 
 using StringColumnVector = ColumnVector<std::string>;
 
+using Int32ColumnVector = ColumnVector<int32_t>;
+
+using Int64ColumnVector = ColumnVector<int64_t>;
+
+// UINT64 and FXP64 features.
+using Uint64ColumnVector = ColumnVector<uint64_t>;
+
+// FXP128 features.
+using Uint128ColumnVector = ColumnVector<uint128_t>;
+
+// strings of a column back to back in one arena, value i is
+// arena[offsets[i], offsets[i + 1]). appending costs no allocation per
+// value, unlike StringColumnVector.
+class StringArenaColumnVector {
+ public:
+  using value_type = std::string_view;
+
+  StringArenaColumnVector() : offsets_(1, 0) {}
+
+  size_t size() const { return offsets_.size() - 1; }
+
+  bool empty() const { return offsets_.size() == 1; }
+
+  void reserve(size_t size, size_t arena_bytes = 0) {
+    offsets_.reserve(size + 1);
+    // std::string::reserve may shrink.
+    if (arena_bytes > arena_.capacity()) {
+      arena_.reserve(arena_bytes);
+    }
+  }
+
+  void clear() {
+    arena_.clear();
+    offsets_.resize(1);
+  }
+
+  void push_back(std::string_view value) {
+    arena_.append(value.data(), value.size());
+    offsets_.push_back(arena_.size());
+  }
+
+  // appends all values of other.
+  void append(const StringArenaColumnVector& other) {
+    const uint64_t base = arena_.size();
+    arena_.append(other.arena_);
+    offsets_.reserve(offsets_.size() + other.size());
+    for (size_t i = 1; i < other.offsets_.size(); i++) {
+      offsets_.push_back(base + other.offsets_[i]);
+    }
+  }
+
+  std::string_view operator[](size_t index) const {
+    return std::string_view(arena_.data() + offsets_[index],
+                            offsets_[index + 1] - offsets_[index]);
+  }
+
+  const std::string& arena() const { return arena_; }
+
+  // size() + 1 offsets, starting with 0.
+  const std::vector<uint64_t>& offsets() const { return offsets_; }
+
+  bool operator==(const StringArenaColumnVector& other) const {
+    return offsets_ == other.offsets_ && arena_ == other.arena_;
+  }
+
+ private:
+  std::string arena_;
+  std::vector<uint64_t> offsets_;
+};
+
 using ColumnType =
-    std::variant<FloatColumnVector, StringColumnVector, DoubleColumnVector>;
+    std::variant<FloatColumnVector, StringColumnVector, DoubleColumnVector,
+                 StringArenaColumnVector, Int32ColumnVector, Int64ColumnVector,
+                 Uint64ColumnVector, Uint128ColumnVector>;
+
+// true for the column vectors of all but STRING features.
+template <class C>
+inline constexpr bool kIsNumericColumn =
+    !std::is_same_v<C, StringColumnVector> &&
+    !std::is_same_v<C, StringArenaColumnVector>;
+
+// empties col but keeps its type and capacity, with room for rows values.
+inline void ResetColumn(ColumnType* col, size_t rows) {
+  std::visit(
+      [rows](auto& c) {
+        c.clear();
+        c.reserve(rows);
+      },
+      *col);
+}
 
 class ColumnVectorBatch {
  public:
@@ -58,6 +150,25 @@ class ColumnVectorBatch {
 
   void Reserve(size_t s) { data_.reserve(s); }
 
+  // empties every column but keeps its type and capacity, with room for
+  // rows values, so that refilling a batch of the same schema does not
+  // allocate.
+  void Reset(size_t rows) {
+    for (auto& col : data_) {
+      ResetColumn(&col, rows);
+    }
+    rows_ = 0;
+  }
+
+  // moves the columns out and leaves the batch empty. readers refill them
+  // and AppendCol them back, reusing their capacity.
+  std::vector<ColumnType> ReleaseCols() {
+    std::vector<ColumnType> ret = std::move(data_);
+    data_.clear();
+    rows_ = 0;
+    return ret;
+  }
+
   // col access.
   template <typename S>
   const ColumnVector<S>& Col(size_t index) const {
@@ -65,6 +176,34 @@ class ColumnVectorBatch {
     return std::get<ColumnVector<S>>(data_[index]);
   }
 
+  // the values of a col, its type checked once, so that loops over the
+  // span index plain memory. S is not std::string for arena cols.
+  template <typename S>
+  absl::Span<const S> ColSpan(size_t index) const {
+    return Col<S>(index);
+  }
+  template <typename S>
+  absl::Span<S> MutableColSpan(size_t index) {
+    auto* c = std::get_if<ColumnVector<S>>(&data_[index]);
+    YASL_ENFORCE(c != nullptr, "col {} is not of the type accessed", index);
+    return absl::MakeSpan(*c);
+  }
+
+  // calls f with the column vector of a col as its actual type, e.g.
+  //
+  //   batch.VisitCol(i, [](const auto& col) {
+  //     using Col = std::decay_t<decltype(col)>;
+  //     if constexpr (kIsNumericColumn<Col>) { ... }
+  //   });
+  template <typename F>
+  decltype(auto) VisitCol(size_t index, F&& f) const {
+    return std::visit(std::forward<F>(f), data_[index]);
+  }
+  template <typename F>
+  decltype(auto) VisitCol(size_t index, F&& f) {
+    return std::visit(std::forward<F>(f), data_[index]);
+  }
+
   // col delete & move able col
   template <typename S>
   ColumnVector<S> Pop(size_t index) {
@@ -77,16 +216,42 @@ class ColumnVectorBatch {
   // Scalar access.
   template <typename S>
   const S& At(size_t row, size_t col) const {
-    YASL_ENFORCE(std::holds_alternative<ColumnVector<S>>(data_[col]));
-    return std::get<ColumnVector<S>>(data_[col])[row];
+    const auto* c = std::get_if<ColumnVector<S>>(&data_[col]);
+    YASL_ENFORCE(c != nullptr, "col {} is not of the type accessed", col);
+    YASL_DEBUG_ENFORCE_LT(row, c->size());
+    return (*c)[row];
   }
   // Scalar modify.
   template <typename S>
   S& At(size_t row, size_t col) {
-    YASL_ENFORCE(std::holds_alternative<ColumnVector<S>>(data_[col]));
-    return std::get<ColumnVector<S>>(data_[col])[row];
+    auto* c = std::get_if<ColumnVector<S>>(&data_[col]);
+    YASL_ENFORCE(c != nullptr, "col {} is not of the type accessed", col);
+    YASL_DEBUG_ENFORCE_LT(row, c->size());
+    return (*c)[row];
+  }
+
+  // At without the type check but in debug builds, for loops over cols
+  // whose types were checked up front, e.g. by ColumnMatches.
+  template <typename S>
+  const S& UncheckedAt(size_t row, size_t col) const {
+    const auto* c = std::get_if<ColumnVector<S>>(&data_[col]);
+    YASL_DEBUG_ENFORCE(c != nullptr, "col {} is not of the type accessed",
+                       col);
+    YASL_DEBUG_ENFORCE_LT(row, c->size());
+    return (*c)[row];
   }
 
+  // string access for both StringColumnVector and StringArenaColumnVector.
+  std::string_view StringAt(size_t row, size_t col) const {
+    if (const auto* arena = std::get_if<StringArenaColumnVector>(&data_[col])) {
+      return (*arena)[row];
+    }
+    return At<std::string>(row, col);
+  }
+
+  // col access by variant.
+  const ColumnType& RawCol(size_t index) const { return data_[index]; }
+
   Dimension Shape() const { return {rows_, data_.size()}; }
 
   template <typename T>
@@ -120,9 +285,51 @@ struct Schema {
     STRING,
     FLOAT,
     DOUBLE,
+    INT32,
+    INT64,
+    UINT64,
+    // fixed point decimals, see ReaderOptions::fxp_bits.
+    FXP64,
+    FXP128,
   };
   std::vector<Type> feature_types;
   std::vector<std::string> feature_names;
 };
 
+// empty column vector holding features of type.
+inline ColumnType MakeColumn(Schema::Type type, size_t reserve) {
+  auto make = [reserve](auto col) -> ColumnType {
+    col.reserve(reserve);
+    return col;
+  };
+  switch (type) {
+    case Schema::STRING:
+      return make(StringColumnVector());
+    case Schema::FLOAT:
+      return make(FloatColumnVector());
+    case Schema::DOUBLE:
+      return make(DoubleColumnVector());
+    case Schema::INT32:
+      return make(Int32ColumnVector());
+    case Schema::INT64:
+      return make(Int64ColumnVector());
+    case Schema::UINT64:
+    case Schema::FXP64:
+      return make(Uint64ColumnVector());
+    case Schema::FXP128:
+      return make(Uint128ColumnVector());
+  }
+  YASL_THROW("unknow Schema::type {}", type);
+}
+
+// true if col is of the column vector MakeColumn makes for type, or a
+// StringArenaColumnVector for STRING if string_arena.
+inline bool ColumnMatches(const ColumnType& col, Schema::Type type,
+                          bool string_arena) {
+  if (type == Schema::STRING && string_arena) {
+    return std::holds_alternative<StringArenaColumnVector>(col);
+  }
+  return col.index() == MakeColumn(type, 0).index();
+}
+
 }  // namespace yasl::io
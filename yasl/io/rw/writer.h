@@ -25,7 +25,13 @@ struct WriterOptions {
   Schema file_schema;
   // precision for format float.
   // assert( float_precision <= max_digits10 )
+  // 0 writes the shortest string that round trips instead.
   int float_precision = std::numeric_limits<float>::max_digits10;
+  // csv writer formats blocks of rows by yasl::parallel_for workers, rows
+  // keep their order. only pays off for big batches.
+  bool parallel_format = false;
+  // fraction bits of FXP64 and FXP128 features.
+  int fxp_bits = 18;
 };
 
 // NOT thread safe and append only.
@@ -30,6 +30,12 @@
 
 namespace yasl::io {
 
+namespace {
+
+constexpr size_t kWriteBufferSize = 1 << 20;
+
+}  // namespace
+
 #define FILE_IO_THROW(msg_prefix)                                         \
   YASL_THROW_IO_ERROR(                                                    \
       msg_prefix                                                          \
@@ -124,7 +130,8 @@ std::unique_ptr<InputStream> FileInputStream::Spawn() {
 FileOutputStream::FileOutputStream(std::string file_name,
                                    bool exit_fail_in_destructor)
     : file_name_(std::move(file_name)),
-      exit_fail_in_destructor_(exit_fail_in_destructor) {
+      exit_fail_in_destructor_(exit_fail_in_destructor),
+      buffer_(new char[kWriteBufferSize]) {
   std::filesystem::path fp(file_name_);
   // empty if relative path to pwd.
   if (!fp.parent_path().empty() && !std::filesystem::exists(fp.parent_path())) {
@@ -132,6 +139,8 @@ FileOutputStream::FileOutputStream(std::string file_name,
                  "Failed to create dir ({})", fp.parent_path().string());
   }
   out_.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+  // must be set before open.
+  out_.rdbuf()->pubsetbuf(buffer_.get(), kWriteBufferSize);
   try {
     out_.open(file_name_, std::ios::binary | std::ios::trunc);
   } catch (const std::ofstream::failure& e) {
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <fstream>
+#include <memory>
 
 #include "yasl/io/stream/interface.h"
 
@@ -104,6 +105,9 @@ class FileOutputStream : public OutputStream {
  private:
   const std::string file_name_;
   const bool exit_fail_in_destructor_;
+  // replaces the few KiB default buffer of ofstream, small writes such as
+  // single csv fields then only cost a memcpy.
+  std::unique_ptr<char[]> buffer_;
   std::ofstream out_;
 };
 
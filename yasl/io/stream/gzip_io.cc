@@ -0,0 +1,408 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/io/stream/gzip_io.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+#include "zlib.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl::io {
+
+namespace {
+
+constexpr size_t kUnknownLength = std::numeric_limits<size_t>::max();
+// decompressed bytes per buffer.
+constexpr size_t kGzipBufferSize = 1 << 20;
+// buffers inflated ahead of the reader.
+constexpr size_t kGzipBufferCount = 4;
+// compressed bytes per read.
+constexpr size_t kGzipReadSize = 256 * 1024;
+
+}  // namespace
+
+GzipInputStream::GzipInputStream(std::string file_name)
+    : file_name_(std::move(file_name)), length_(kUnknownLength) {
+  fd_ = open(file_name_.c_str(), O_RDONLY);
+  if (fd_ == -1) {
+    YASL_THROW_IO_ERROR(
+        "Open for read error on file '{}', error msg '{}', error code {}",
+        file_name_, std::strerror(errno), errno);
+  }
+  posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+  Start();
+}
+
+GzipInputStream::~GzipInputStream() {
+  Stop();
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+void GzipInputStream::Start() {
+  pos_ = 0;
+  stop_ = false;
+  done_ = false;
+  error_.clear();
+  format_error_ = false;
+  inflate_thread_ = std::thread(&GzipInputStream::InflateLoop, this);
+}
+
+void GzipInputStream::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (inflate_thread_.joinable()) {
+    inflate_thread_.join();
+  }
+  for (auto& buf : filled_) {
+    free_.push_back(std::move(buf));
+  }
+  filled_.clear();
+  if (cur_.capacity() != 0) {
+    free_.push_back(std::move(cur_));
+  }
+  cur_ = std::string();
+  cur_pos_ = 0;
+}
+
+void GzipInputStream::InflateLoop() {
+  z_stream zs;
+  std::memset(&zs, 0, sizeof(zs));
+  // 32: detect gzip or zlib headers.
+  if (inflateInit2(&zs, 15 + 32) != Z_OK) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = "inflateInit2 failed";
+    done_ = true;
+    cv_.notify_all();
+    return;
+  }
+  std::string input(kGzipReadSize, '\0');
+  size_t offset = 0;
+  bool input_eof = false;
+  // between two gzip members, where the input may end.
+  bool at_member_end = true;
+  std::string error;
+  bool format_error = false;
+
+  bool done = false;
+  while (!done) {
+    std::string buf;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock,
+               [&] { return stop_ || filled_.size() < kGzipBufferCount; });
+      if (stop_) {
+        break;
+      }
+      if (!free_.empty()) {
+        buf = std::move(free_.back());
+        free_.pop_back();
+      }
+    }
+    buf.resize(kGzipBufferSize);
+    zs.next_out = reinterpret_cast<Bytef*>(buf.data());
+    zs.avail_out = buf.size();
+
+    while (zs.avail_out > 0) {
+      if (zs.avail_in == 0 && !input_eof) {
+        const ssize_t n = pread(fd_, input.data(), input.size(), offset);
+        if (n < 0) {
+          const int err = errno;
+          if (err == EINTR) {
+            continue;
+          }
+          error = fmt::format("error msg '{}', error code {}",
+                              std::strerror(err), err);
+          break;
+        }
+        offset += n;
+        input_eof = n == 0;
+        zs.next_in = reinterpret_cast<Bytef*>(input.data());
+        zs.avail_in = n;
+      }
+      if (zs.avail_in == 0) {
+        if (!at_member_end) {
+          error = "unexpected end of compressed data";
+          format_error = true;
+        }
+        break;
+      }
+      const int ret = inflate(&zs, Z_NO_FLUSH);
+      if (ret == Z_STREAM_END) {
+        // another member may follow.
+        at_member_end = true;
+        inflateReset(&zs);
+      } else if (ret == Z_OK || ret == Z_BUF_ERROR) {
+        at_member_end = false;
+      } else {
+        error = fmt::format("inflate error '{}', code {}",
+                            zs.msg != nullptr ? zs.msg : "", ret);
+        format_error = true;
+        break;
+      }
+    }
+    buf.resize(buf.size() - zs.avail_out);
+    done = zs.avail_out > 0 || !error.empty();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error.empty()) {
+        error_ = error;
+        format_error_ = format_error;
+      }
+      if (!buf.empty() && error.empty()) {
+        filled_.push_back(std::move(buf));
+      } else {
+        free_.push_back(std::move(buf));
+      }
+      done_ = done;
+    }
+    cv_.notify_all();
+  }
+  inflateEnd(&zs);
+}
+
+bool GzipInputStream::NextBuffer() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (cur_.capacity() != 0) {
+      free_.push_back(std::move(cur_));
+    }
+    cur_ = std::string();
+    cur_pos_ = 0;
+    cv_.wait(lock, [&] { return !filled_.empty() || done_ || stop_; });
+    if (filled_.empty()) {
+      if (format_error_) {
+        YASL_THROW_INVALID_FORMAT("Gzip format error on file '{}', {}",
+                                  file_name_, error_);
+      }
+      if (!error_.empty()) {
+        YASL_THROW_IO_ERROR("Read error on file '{}', {}", file_name_,
+                            error_);
+      }
+      length_ = pos_;
+      return false;
+    }
+    cur_ = std::move(filled_.front());
+    filled_.pop_front();
+  }
+  cv_.notify_all();
+  return true;
+}
+
+bool GzipInputStream::operator!() const { return fail_; }
+
+GzipInputStream::operator bool() const { return !fail_; }
+
+bool GzipInputStream::Eof() const { return eof_; }
+
+InputStream& GzipInputStream::GetLine(std::string* ret, char delim) {
+  // like std::getline, a stream already at eof fails without touching ret.
+  if (eof_ || fail_) {
+    fail_ = true;
+    return *this;
+  }
+  ret->clear();
+  while (true) {
+    const size_t avail = cur_.size() - cur_pos_;
+    if (avail > 0) {
+      const char* begin = cur_.data() + cur_pos_;
+      const void* hit = std::memchr(begin, delim, avail);
+      const size_t len =
+          hit == nullptr ? avail : static_cast<const char*>(hit) - begin;
+      ret->append(begin, len);
+      if (hit != nullptr) {
+        cur_pos_ += len + 1;
+        pos_ += len + 1;
+        return *this;
+      }
+      cur_pos_ += len;
+      pos_ += len;
+    }
+    if (!NextBuffer()) {
+      eof_ = true;
+      fail_ = ret->empty();
+      return *this;
+    }
+  }
+}
+
+InputStream& GzipInputStream::Read(void* buf, size_t length) {
+  auto* dst = static_cast<char*>(buf);
+  while (length > 0) {
+    const size_t n = std::min(length, cur_.size() - cur_pos_);
+    if (n > 0) {
+      std::memcpy(dst, cur_.data() + cur_pos_, n);
+      dst += n;
+      length -= n;
+      cur_pos_ += n;
+      pos_ += n;
+    } else if (!NextBuffer()) {
+      break;
+    }
+  }
+  return *this;
+}
+
+size_t GzipInputStream::Skip(size_t n) {
+  size_t skipped = 0;
+  while (skipped < n) {
+    const size_t step = std::min(n - skipped, cur_.size() - cur_pos_);
+    if (step > 0) {
+      skipped += step;
+      cur_pos_ += step;
+      pos_ += step;
+    } else if (!NextBuffer()) {
+      break;
+    }
+  }
+  return skipped;
+}
+
+InputStream& GzipInputStream::Seekg(size_t pos) {
+  // clear EOF/FAIL bit
+  eof_ = false;
+  fail_ = false;
+  if (pos < pos_) {
+    Stop();
+    Start();
+  }
+  Skip(pos - pos_);
+  return *this;
+}
+
+size_t GzipInputStream::Tellg() { return pos_; }
+
+size_t GzipInputStream::GetLength() const {
+  if (length_ == kUnknownLength) {
+    GzipInputStream counter(file_name_);
+    length_ = counter.Skip(kUnknownLength);
+  }
+  return length_;
+}
+
+const std::string& GzipInputStream::GetName() const { return file_name_; }
+
+void GzipInputStream::Close() {
+  Stop();
+  free_.clear();
+  if (fd_ != -1) {
+    close(fd_);
+    fd_ = -1;
+  }
+  eof_ = true;
+  fail_ = true;
+}
+
+std::unique_ptr<InputStream> GzipInputStream::Spawn() {
+  std::unique_ptr<GzipInputStream> ret(new GzipInputStream(file_name_));
+  ret->length_ = length_;
+  ret->Seekg(Tellg());
+  return ret;
+}
+
+GzipOutputStream::GzipOutputStream(std::string file_name, int level)
+    : out_(std::move(file_name)),
+      zs_(new z_stream_s()),
+      buffer_(kGzipReadSize, '\0') {
+  // 16: gzip header and trailer.
+  const int ret = deflateInit2(zs_.get(), level, Z_DEFLATED, 15 + 16, 8,
+                               Z_DEFAULT_STRATEGY);
+  YASL_ENFORCE(ret == Z_OK, "deflateInit2 failed with code {} for file '{}'",
+               ret, out_.GetName());
+}
+
+GzipOutputStream::~GzipOutputStream() {
+  try {
+    Close();
+  } catch (const std::exception& e) {
+    SPDLOG_ERROR("IO error in destructor: < {} >", e.what());
+  }
+  // no-op if Close() got there.
+  deflateEnd(zs_.get());
+}
+
+void GzipOutputStream::Deflate(int flush) {
+  while (true) {
+    zs_->next_out = reinterpret_cast<Bytef*>(buffer_.data());
+    zs_->avail_out = buffer_.size();
+    const int ret = deflate(zs_.get(), flush);
+    YASL_ENFORCE(ret == Z_OK || ret == Z_STREAM_END || ret == Z_BUF_ERROR,
+                 "deflate failed with code {} for file '{}'", ret,
+                 out_.GetName());
+    out_.Write(buffer_.data(), buffer_.size() - zs_->avail_out);
+    // deflate has no more output once it leaves room in the buffer.
+    if (zs_->avail_out != 0) {
+      return;
+    }
+  }
+}
+
+void GzipOutputStream::Write(const void* buf, size_t length) {
+  YASL_ENFORCE(!closed_, "Write to closed file '{}'", out_.GetName());
+  const auto* src = static_cast<const Bytef*>(buf);
+  pos_ += length;
+  while (length > 0) {
+    // avail_in is 32 bits.
+    const size_t n = std::min<size_t>(length, 1 << 30);
+    zs_->next_in = const_cast<Bytef*>(src);
+    zs_->avail_in = n;
+    Deflate(Z_NO_FLUSH);
+    src += n;
+    length -= n;
+  }
+}
+
+void GzipOutputStream::Write(std::string_view buf) {
+  Write(buf.data(), buf.size());
+}
+
+const std::string& GzipOutputStream::GetName() const {
+  return out_.GetName();
+}
+
+size_t GzipOutputStream::Tellp() { return pos_; }
+
+void GzipOutputStream::Flush() {
+  YASL_ENFORCE(!closed_, "Flush closed file '{}'", out_.GetName());
+  Deflate(Z_SYNC_FLUSH);
+  out_.Flush();
+}
+
+void GzipOutputStream::Close() {
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+  Deflate(Z_FINISH);
+  deflateEnd(zs_.get());
+  out_.Close();
+}
+
+}  // namespace yasl::io
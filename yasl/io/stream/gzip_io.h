@@ -0,0 +1,150 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "yasl/io/stream/file_io.h"
+#include "yasl/io/stream/interface.h"
+
+struct z_stream_s;
+
+namespace yasl::io {
+
+// InputStream over the decompressed content of a local gzip (or zlib)
+// file, concatenated gzip members included. A background thread reads and
+// inflates the next `kGzipBufferCount` buffers while the current one is
+// parsed. Offsets of Seekg, Tellg and GetLength are in decompressed bytes:
+// seeking backwards inflates again from the start, and GetLength inflates
+// the whole file once unless the stream already reached its end.
+class GzipInputStream : public InputStream {
+ public:
+  /**
+   * open {file_name} for read.
+   * raise exception if any error happend.
+   */
+  explicit GzipInputStream(std::string file_name);
+
+  ~GzipInputStream() override;
+
+  bool operator!() const override;
+
+  explicit operator bool() const override;
+
+  bool Eof() const override;
+
+  using InputStream::GetLine;
+  InputStream& GetLine(std::string* ret, char delim) override;
+
+  InputStream& Read(void* buf, size_t length) override;
+
+  InputStream& Seekg(size_t pos) override;
+
+  size_t Tellg() override;
+
+  size_t GetLength() const override;
+
+  const std::string& GetName() const override;
+
+  void Close() override;
+
+  bool IsStreaming() override { return false; }
+
+  std::unique_ptr<InputStream> Spawn() override;
+
+ private:
+  // starts inflating from the beginning of the file.
+  void Start();
+  // stops the inflate thread and drops all filled buffers.
+  void Stop();
+  // body of the inflate thread.
+  void InflateLoop();
+  // swaps the next filled buffer into cur_. false at the end of file.
+  bool NextBuffer();
+  // drops up to n bytes, returns the bytes dropped.
+  size_t Skip(size_t n);
+
+  const std::string file_name_;
+  int fd_ = -1;
+  // decompressed length, once known.
+  mutable size_t length_;
+
+  // owned by the reading thread.
+  std::string cur_;
+  size_t cur_pos_ = 0;
+  size_t pos_ = 0;
+  bool eof_ = false;
+  bool fail_ = false;
+
+  // shared with the inflate thread.
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::string> filled_;
+  std::vector<std::string> free_;
+  bool stop_ = false;
+  bool done_ = false;
+  std::string error_;
+  // error_ is about the data, not the io.
+  bool format_error_ = false;
+  std::thread inflate_thread_;
+};
+
+// OutputStream writing gzip compressed data to a local file, readable by
+// GzipInputStream and the gzip tool. Tellp counts uncompressed bytes.
+// Always trunc file if target file exist.
+class GzipOutputStream : public OutputStream {
+ public:
+  /**
+   * open {file_name} for write, level from 1 (fast) to 9 (small), -1 for
+   * zlib's default.
+   * raise exception if any error happend.
+   */
+  explicit GzipOutputStream(std::string file_name, int level = -1);
+
+  ~GzipOutputStream() override;
+
+  void Write(const void* buf, size_t length) override;
+  void Write(std::string_view buf) override;
+
+  const std::string& GetName() const override;
+
+  size_t Tellp() override;
+
+  // flushes all the data written so far to the file, at the cost of a
+  // worse compression ratio.
+  void Flush() override;
+
+  void Close() override;
+
+  bool IsStreaming() override { return false; }
+
+ private:
+  // deflates the pending input with flush, writing full buffers out.
+  void Deflate(int flush);
+
+  FileOutputStream out_;
+  std::unique_ptr<z_stream_s> zs_;
+  std::string buffer_;
+  size_t pos_ = 0;
+  bool closed_ = false;
+};
+
+}  // namespace yasl::io
@@ -0,0 +1,109 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/io/stream/http_range_source.h"
+
+#include "absl/strings/numbers.h"
+#include "fmt/format.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl::io {
+
+namespace {
+
+constexpr int kPartialContent = 206;
+constexpr int kRangeNotSatisfiable = 416;
+
+// "scheme://host[:port]" of url.
+std::string ServerOf(const std::string& url) {
+  const size_t scheme_end = url.find("://");
+  YASL_ENFORCE(scheme_end != std::string::npos, "bad url '{}'", url);
+  const size_t host_end = url.find_first_of("/?#", scheme_end + 3);
+  return url.substr(0, host_end);
+}
+
+}  // namespace
+
+HttpRangeSource::HttpRangeSource(std::string url,
+                                 HttpRangeSourceOptions options)
+    : url_(std::move(url)), options_(std::move(options)) {
+  brpc::ChannelOptions channel_options;
+  channel_options.protocol = brpc::PROTOCOL_HTTP;
+  channel_options.timeout_ms = options_.timeout_ms;
+  channel_options.max_retry = options_.max_retry;
+  // https urls turn on ssl.
+  if (channel_.Init(ServerOf(url_).c_str(), &channel_options) != 0) {
+    YASL_THROW_IO_ERROR("Init http channel error on '{}'", url_);
+  }
+}
+
+void HttpRangeSource::Get(size_t first, size_t last, brpc::Controller* cntl) {
+  cntl->http_request().uri() = url_;
+  cntl->http_request().set_method(brpc::HTTP_METHOD_GET);
+  cntl->http_request().SetHeader("Range",
+                                 fmt::format("bytes={}-{}", first, last));
+  for (const auto& [name, value] : options_.headers) {
+    cntl->http_request().SetHeader(name, value);
+  }
+  channel_.CallMethod(nullptr, cntl, nullptr, nullptr, nullptr);
+  const int status = cntl->http_response().status_code();
+  if (cntl->Failed() && status != kRangeNotSatisfiable) {
+    YASL_THROW_IO_ERROR("Read error on '{}' bytes {}-{}, status {}, {}", url_,
+                        first, last, status, cntl->ErrorText());
+  }
+}
+
+size_t HttpRangeSource::GetLength() {
+  brpc::Controller cntl;
+  Get(0, 0, &cntl);
+  const int status = cntl.http_response().status_code();
+  if (status == kRangeNotSatisfiable) {
+    // an empty object has no byte 0.
+    return 0;
+  }
+  if (status != kPartialContent) {
+    // Range ignored, the whole object came back.
+    return cntl.response_attachment().size();
+  }
+  // "bytes 0-0/<length>".
+  const std::string* range = cntl.http_response().GetHeader("Content-Range");
+  size_t length = 0;
+  const size_t slash =
+      range == nullptr ? std::string::npos : range->rfind('/');
+  if (slash == std::string::npos ||
+      !absl::SimpleAtoi(range->substr(slash + 1), &length)) {
+    YASL_THROW_IO_ERROR("No object length in the response of '{}'", url_);
+  }
+  return length;
+}
+
+void HttpRangeSource::ReadRange(size_t offset, size_t length, char* buf) {
+  if (length == 0) {
+    return;
+  }
+  brpc::Controller cntl;
+  Get(offset, offset + length - 1, &cntl);
+  const auto& body = cntl.response_attachment();
+  if (cntl.http_response().status_code() != kPartialContent ||
+      body.size() != length) {
+    YASL_THROW_IO_ERROR(
+        "Read error on '{}' bytes {}-{}, status {} with {} bytes", url_,
+        offset, offset + length - 1, cntl.http_response().status_code(),
+        body.size());
+  }
+  body.copy_to(buf, length);
+}
+
+}  // namespace yasl::io
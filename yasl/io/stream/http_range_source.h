@@ -0,0 +1,59 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "brpc/channel.h"
+
+#include "yasl/io/stream/ranged_io.h"
+
+namespace yasl::io {
+
+struct HttpRangeSourceOptions {
+  int32_t timeout_ms = 60 * 1000;
+  int max_retry = 3;
+  // extra request headers, e.g. an authorization token.
+  std::vector<std::pair<std::string, std::string>> headers;
+};
+
+// object at an http(s) url that serves Range requests, like a presigned s3
+// or oss url. the length is taken from the Content-Range of a one byte
+// request.
+//
+//   RangedInputStream in(std::make_shared<HttpRangeSource>(url));
+class HttpRangeSource : public RangeSource {
+ public:
+  explicit HttpRangeSource(std::string url,
+                           HttpRangeSourceOptions options = {});
+
+  size_t GetLength() override;
+
+  void ReadRange(size_t offset, size_t length, char* buf) override;
+
+  const std::string& GetName() const override { return url_; }
+
+ private:
+  // GET of bytes [first, last] into cntl.
+  void Get(size_t first, size_t last, brpc::Controller* cntl);
+
+  const std::string url_;
+  const HttpRangeSourceOptions options_;
+  brpc::Channel channel_;
+};
+
+}  // namespace yasl::io
@@ -1,4 +1,4 @@
-// Copyright 2022 Ant Group Co., Ltd.
+// Copyright 2019 Ant Group Co., Ltd.
 //
 // Licensed under the Apache License, Version 2.0 (the "License");
 // you may not use this file except in compliance with the License.
@@ -15,52 +15,96 @@
 
 #include "yasl/io/stream/mem_io.h"
 
-#include <fstream>
-#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <utility>
 
+#include "yasl/base/exception.h"
+
 namespace yasl::io {
 
-MemInputStream::MemInputStream(const std::string& input_data)
-    : input_data_(input_data), total_len_(input_data.size()) {
-  input_data_.exceptions(std::ifstream::badbit);
-}
+MemInputStream::MemInputStream(std::string input_data)
+    : owner_(std::make_shared<const std::string>(std::move(input_data))),
+      data_(*owner_) {}
+
+MemInputStream::MemInputStream(std::shared_ptr<const std::string> owner,
+                               std::string_view data)
+    : owner_(std::move(owner)), data_(data) {}
 
-bool MemInputStream::operator!() const {
-  return !static_cast<bool>(input_data_);
+std::unique_ptr<MemInputStream> MemInputStream::View(
+    ByteContainerView input_data) {
+  return std::unique_ptr<MemInputStream>(
+      new MemInputStream(nullptr, input_data));
 }
 
-MemInputStream::operator bool() const { return static_cast<bool>(input_data_); }
+bool MemInputStream::operator!() const { return fail_; }
+
+MemInputStream::operator bool() const { return !fail_; }
+
+bool MemInputStream::Eof() const { return eof_; }
 
-bool MemInputStream::Eof() const { return input_data_.eof(); }
+bool MemInputStream::GetLineView(std::string_view* ret, char delim) {
+  // like std::getline, a stream already at eof fails without touching ret.
+  if (eof_ || fail_) {
+    fail_ = true;
+    return false;
+  }
+  if (pos_ >= data_.size()) {
+    *ret = std::string_view();
+    eof_ = fail_ = true;
+    return false;
+  }
+  const size_t end = data_.find(delim, pos_);
+  if (end == std::string_view::npos) {
+    *ret = data_.substr(pos_);
+    pos_ = data_.size();
+    eof_ = true;
+  } else {
+    *ret = data_.substr(pos_, end - pos_);
+    pos_ = end + 1;
+  }
+  return true;
+}
 
 InputStream& MemInputStream::GetLine(std::string* ret, char delim) {
-  std::getline(input_data_, *ret, delim);
+  if (eof_ || fail_) {
+    fail_ = true;
+    return *this;
+  }
+  std::string_view line;
+  if (GetLineView(&line, delim)) {
+    ret->assign(line.data(), line.size());
+  } else {
+    ret->clear();
+  }
   return *this;
 }
 
 InputStream& MemInputStream::Read(void* buf, size_t length) {
-  input_data_.readsome(static_cast<char*>(buf), length);
+  // readsome semantics: copy what is left, never set eof.
+  const size_t n = std::min(length, data_.size() - pos_);
+  if (n > 0) {
+    std::memcpy(buf, data_.data() + pos_, n);
+    pos_ += n;
+  }
   return *this;
 }
 
 InputStream& MemInputStream::Seekg(size_t pos) {
   // clear EOF/FAIL bit
-  input_data_.clear();
-  input_data_.seekg(pos);
+  eof_ = fail_ = false;
+  if (pos > data_.size()) {
+    fail_ = true;
+    return *this;
+  }
+  pos_ = pos;
   return *this;
 }
 
-size_t MemInputStream::Tellg() {
-  auto backup = input_data_.rdstate();
-  input_data_.clear();
-  // tellg fail if eofbit is set.
-  auto ret = input_data_.tellg();
-  input_data_.setstate(backup);
-  return ret;
-}
+size_t MemInputStream::Tellg() { return pos_; }
 
-size_t MemInputStream::GetLength() const { return total_len_; }
+size_t MemInputStream::GetLength() const { return data_.size(); }
 
 const std::string& MemInputStream::GetName() const {
   static const std::string mem_io_name("MemInputStream");
@@ -68,41 +112,79 @@ const std::string& MemInputStream::GetName() const {
 }
 
 void MemInputStream::Close() {
-  input_data_.str(std::string());
-  total_len_ = 0;
+  owner_.reset();
+  data_ = std::string_view();
+  pos_ = 0;
+}
+
+std::unique_ptr<InputStream> MemInputStream::Spawn() {
+  std::unique_ptr<InputStream> ret(new MemInputStream(owner_, data_));
+  ret->Seekg(Tellg());
+  return ret;
 }
 
+MemOutputStream::MemOutputStream(std::string* out) : out_(out) {
+  YASL_ENFORCE(out_ != nullptr);
+  out_->clear();
+}
+
+MemOutputStream::MemOutputStream() : out_(nullptr) {}
+
+MemOutputStream::~MemOutputStream() { std::free(data_); }
+
 void MemOutputStream::Write(const void* buf, size_t length) {
-  out_buffer_ << std::string(static_cast<const char*>(buf), length);
+  YASL_ENFORCE(!closed_, "Write to closed MemOutputStream");
+  if (out_ != nullptr) {
+    out_->append(static_cast<const char*>(buf), length);
+    return;
+  }
+  if (size_ + length > capacity_) {
+    const size_t capacity = std::max({size_ + length, 2 * capacity_,
+                                      static_cast<size_t>(4096)});
+    auto* data = static_cast<char*>(std::realloc(data_, capacity));
+    YASL_ENFORCE(data != nullptr, "out of memory, {} bytes", capacity);
+    data_ = data;
+    capacity_ = capacity;
+  }
+  if (length > 0) {
+    std::memcpy(data_ + size_, buf, length);
+    size_ += length;
+  }
 }
 
-void MemOutputStream::Write(std::string_view buf) { out_buffer_ << buf; }
+void MemOutputStream::Write(std::string_view buf) {
+  Write(buf.data(), buf.size());
+}
 
 const std::string& MemOutputStream::GetName() const {
   static const std::string mem_io_name("MemOutputStream");
   return mem_io_name;
 }
 
-size_t MemOutputStream::Tellp() { return out_buffer_.tellp(); }
-
-void MemOutputStream::Flush() {
-  if (out_ != nullptr) {
-    *out_ = out_buffer_.str();
-  }
+size_t MemOutputStream::Tellp() {
+  return out_ != nullptr ? out_->size() : size_;
 }
 
-void MemOutputStream::Close() {
-  if (out_ != nullptr) {
-    *out_ = out_buffer_.str();
-    out_buffer_.str(std::string());
-    out_ = nullptr;
-  }
-}
+// writes go straight to their target, nothing is pending.
+void MemOutputStream::Flush() {}
 
-std::unique_ptr<InputStream> MemInputStream::Spawn() {
-  std::unique_ptr<InputStream> ret(new MemInputStream(input_data_.str()));
-  ret->Seekg(Tellg());
+void MemOutputStream::Close() { closed_ = true; }
+
+Buffer MemOutputStream::Release() {
+  YASL_ENFORCE(out_ == nullptr, "Release of a MemOutputStream to a string");
+  if (size_ == 0) {
+    return Buffer();
+  }
+  // shrinking keeps the block in place.
+  auto* data = static_cast<char*>(std::realloc(data_, size_));
+  if (data == nullptr) {
+    data = data_;
+  }
+  Buffer ret(data, size_, [](void* p) { std::free(p); });
+  data_ = nullptr;
+  size_ = 0;
+  capacity_ = 0;
   return ret;
 }
 
-}  // namespace yasl::io
\ No newline at end of file
+}  // namespace yasl::io
@@ -14,15 +14,25 @@
 
 #pragma once
 
-#include <sstream>
+#include <memory>
+#include <string>
+#include <string_view>
 
+#include "yasl/base/buffer.h"
+#include "yasl/base/byte_container_view.h"
 #include "yasl/io/stream/interface.h"
 
 namespace yasl::io {
 
+// reads the data in place, Spawn() shares it.
 class MemInputStream : public InputStream {
  public:
-  explicit MemInputStream(const std::string& input_data);
+  // owns a copy of input_data, or input_data itself if moved in.
+  explicit MemInputStream(std::string input_data);
+
+  // reads input_data without a copy, it must outlive this stream and its
+  // spawns.
+  static std::unique_ptr<MemInputStream> View(ByteContainerView input_data);
 
   ~MemInputStream() override = default;
 
@@ -32,8 +42,12 @@ class MemInputStream : public InputStream {
 
   bool Eof() const override;
 
+  using InputStream::GetLine;
   InputStream& GetLine(std::string* ret, char delim) override;
 
+  // same as GetLine, but ret points into the input.
+  bool GetLineView(std::string_view* ret, char delim = '\n');
+
   InputStream& Read(void* buf, size_t length) override;
 
   InputStream& Seekg(size_t pos) override;
@@ -51,15 +65,29 @@ class MemInputStream : public InputStream {
   std::unique_ptr<InputStream> Spawn() override;
 
  private:
-  std::istringstream input_data_;
-  size_t total_len_;
+  MemInputStream(std::shared_ptr<const std::string> owner,
+                 std::string_view data);
+
+  // null for View() streams.
+  std::shared_ptr<const std::string> owner_;
+  std::string_view data_;
+  size_t pos_ = 0;
+  bool eof_ = false;
+  bool fail_ = false;
 };
 
 class MemOutputStream : public OutputStream {
  public:
-  explicit MemOutputStream(std::string* out) : out_(out) {}
+  // appends to *out, which is cleared first.
+  explicit MemOutputStream(std::string* out);
+
+  // appends to a buffer owned by the stream, see Release().
+  MemOutputStream();
+
+  MemOutputStream(const MemOutputStream&) = delete;
+  MemOutputStream& operator=(const MemOutputStream&) = delete;
 
-  ~MemOutputStream() override { Close(); }
+  ~MemOutputStream() override;
 
   /**
    * Write/Append length bytes pointed by buf to the file stream
@@ -91,9 +119,20 @@ class MemOutputStream : public OutputStream {
   // true for network streaming like stream from oss.
   bool IsStreaming() override { return false; }
 
+  /**
+   * moves the bytes written so far out of a stream made by
+   * MemOutputStream(), without a copy. the stream starts over empty.
+   */
+  Buffer Release();
+
  private:
-  std::ostringstream out_buffer_;
   std::string* out_;
+  bool closed_ = false;
+  // the stream's own buffer, malloc()ed so Release() can shrink it in
+  // place.
+  char* data_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
 };
 
 }  // namespace yasl::io
@@ -0,0 +1,122 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "yasl/io/stream/mmap_io.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "yasl/base/exception.h"
+
+namespace yasl::io {
+
+MmapInputStream::MmapInputStream(std::string file_name)
+    : MmapInputStream(file_name, std::make_shared<MmappedFile>(file_name)) {
+  if (!data_.empty()) {
+    // only a hint, readahead is still done without it.
+    madvise(const_cast<char*>(data_.data()), data_.size(), MADV_SEQUENTIAL);
+  }
+}
+
+MmapInputStream::MmapInputStream(std::string file_name,
+                                 std::shared_ptr<const MmappedFile> file)
+    : file_name_(std::move(file_name)),
+      file_(std::move(file)),
+      data_(file_->data(), file_->size()) {}
+
+bool MmapInputStream::operator!() const { return fail_; }
+
+MmapInputStream::operator bool() const { return !fail_; }
+
+bool MmapInputStream::Eof() const { return eof_; }
+
+bool MmapInputStream::GetLineView(std::string_view* ret, char delim) {
+  // like std::getline, a stream already at eof fails without touching ret.
+  if (eof_ || fail_) {
+    fail_ = true;
+    return false;
+  }
+  if (pos_ >= data_.size()) {
+    *ret = std::string_view();
+    eof_ = fail_ = true;
+    return false;
+  }
+  const size_t end = data_.find(delim, pos_);
+  if (end == std::string_view::npos) {
+    *ret = data_.substr(pos_);
+    pos_ = data_.size();
+    eof_ = true;
+  } else {
+    *ret = data_.substr(pos_, end - pos_);
+    pos_ = end + 1;
+  }
+  return true;
+}
+
+InputStream& MmapInputStream::GetLine(std::string* ret, char delim) {
+  if (eof_ || fail_) {
+    fail_ = true;
+    return *this;
+  }
+  std::string_view line;
+  GetLineView(&line, delim);
+  ret->assign(line.data(), line.size());
+  return *this;
+}
+
+InputStream& MmapInputStream::Read(void* buf, size_t length) {
+  // readsome semantics: copy what is left, never set eof.
+  const size_t n = std::min(length, data_.size() - pos_);
+  if (n > 0) {
+    std::memcpy(buf, data_.data() + pos_, n);
+    pos_ += n;
+  }
+  return *this;
+}
+
+InputStream& MmapInputStream::Seekg(size_t pos) {
+  eof_ = fail_ = false;
+  if (pos > data_.size()) {
+    fail_ = true;
+    return *this;
+  }
+  pos_ = pos;
+  return *this;
+}
+
+size_t MmapInputStream::Tellg() { return pos_; }
+
+size_t MmapInputStream::GetLength() const { return data_.size(); }
+
+const std::string& MmapInputStream::GetName() const { return file_name_; }
+
+void MmapInputStream::Close() {
+  file_.reset();
+  data_ = std::string_view();
+  pos_ = 0;
+  eof_ = fail_ = true;
+}
+
+std::unique_ptr<InputStream> MmapInputStream::Spawn() {
+  YASL_ENFORCE(file_ != nullptr, "Spawn on closed file '{}'", file_name_);
+  std::unique_ptr<InputStream> ret(new MmapInputStream(file_name_, file_));
+  ret->Seekg(Tellg());
+  return ret;
+}
+
+}  // namespace yasl::io
@@ -0,0 +1,85 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "yasl/io/rw/mmapped_file.h"
+#include "yasl/io/stream/interface.h"
+
+namespace yasl::io {
+
+// InputStream over a read only mapping of a local file. GetLine copies no
+// more than the line itself, GetLineView copies nothing. The state after
+// each call is the same as FileInputStream's, i.e. std::getline's.
+class MmapInputStream : public InputStream {
+ public:
+  /**
+   * map {file_name} for read.
+   * raise exception if any error happend.
+   */
+  explicit MmapInputStream(std::string file_name);
+
+  ~MmapInputStream() override = default;
+
+  bool operator!() const override;
+
+  explicit operator bool() const override;
+
+  bool Eof() const override;
+
+  using InputStream::GetLine;
+  InputStream& GetLine(std::string* ret, char delim) override;
+
+  /**
+   * same as GetLine, but `ret` points into the mapping and stays valid
+   * as long as this stream or one spawned from it is alive.
+   * return false where GetLine would leave the stream failed.
+   */
+  bool GetLineView(std::string_view* ret, char delim = '\n');
+
+  InputStream& Read(void* buf, size_t length) override;
+
+  InputStream& Seekg(size_t pos) override;
+
+  size_t Tellg() override;
+
+  size_t GetLength() const override;
+
+  const std::string& GetName() const override;
+
+  void Close() override;
+
+  bool IsStreaming() override { return false; }
+
+  // the spawned stream shares the mapping.
+  std::unique_ptr<InputStream> Spawn() override;
+
+ private:
+  MmapInputStream(std::string file_name,
+                  std::shared_ptr<const MmappedFile> file);
+
+  const std::string file_name_;
+  std::shared_ptr<const MmappedFile> file_;
+  std::string_view data_;
+  size_t pos_ = 0;
+  bool eof_ = false;
+  bool fail_ = false;
+};
+
+}  // namespace yasl::io
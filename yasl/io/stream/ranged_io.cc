@@ -0,0 +1,247 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/io/stream/ranged_io.h"
+
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "yasl/base/exception.h"
+
+namespace yasl::io {
+
+// blocks of one object, least recently used evicted first.
+class RangedInputStream::BlockCache {
+ public:
+  BlockCache(std::shared_ptr<RangeSource> source,
+             const RangedReadOptions& options)
+      : source_(std::move(source)), options_(options) {
+    YASL_ENFORCE(source_ != nullptr);
+    YASL_ENFORCE(options_.block_size > 0, "block_size should be positive");
+    YASL_ENFORCE(options_.cache_blocks > options_.prefetch_blocks,
+                 "cache_blocks {} should be more than prefetch_blocks {}",
+                 options_.cache_blocks, options_.prefetch_blocks);
+    length_ = source_->GetLength();
+  }
+
+  size_t Length() const { return length_; }
+
+  size_t BlockSize() const { return options_.block_size; }
+
+  const std::string& Name() const { return source_->GetName(); }
+
+  // block `index`, fetching it and the prefetch window after it if they
+  // are not cached.
+  std::shared_future<std::string> Get(size_t index) {
+    // evicted blocks still in flight wait for their fetch when destroyed,
+    // so that is done after unlocking.
+    std::vector<std::shared_future<std::string>> evicted;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t blocks = (length_ + BlockSize() - 1) / BlockSize();
+    const size_t window_end =
+        std::min(blocks, index + 1 + options_.prefetch_blocks);
+    // touched last to first, so the window ends up most recently used.
+    for (size_t i = window_end; i > index + 1; i--) {
+      Touch(i - 1);
+    }
+    auto ret = Touch(index);
+    while (blocks_.size() > options_.cache_blocks) {
+      auto it = blocks_.find(lru_.back());
+      evicted.push_back(std::move(it->second.data));
+      blocks_.erase(it);
+      lru_.pop_back();
+    }
+    return ret;
+  }
+
+  // forgets a block whose fetch failed, so that it is fetched again.
+  void Drop(size_t index) {
+    std::shared_future<std::string> dropped;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = blocks_.find(index);
+    if (it != blocks_.end()) {
+      dropped = std::move(it->second.data);
+      lru_.erase(it->second.lru);
+      blocks_.erase(it);
+    }
+  }
+
+ private:
+  struct Entry {
+    std::shared_future<std::string> data;
+    std::list<size_t>::iterator lru;
+  };
+
+  std::shared_future<std::string> Touch(size_t index) {
+    auto it = blocks_.find(index);
+    if (it != blocks_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second.lru);
+      return it->second.data;
+    }
+    const size_t offset = index * BlockSize();
+    const size_t size = std::min(BlockSize(), length_ - offset);
+    auto data = std::async(std::launch::async,
+                           [source = source_, offset, size] {
+                             std::string block(size, '\0');
+                             source->ReadRange(offset, size, block.data());
+                             return block;
+                           })
+                    .share();
+    lru_.push_front(index);
+    blocks_.emplace(index, Entry{data, lru_.begin()});
+    return data;
+  }
+
+  const std::shared_ptr<RangeSource> source_;
+  const RangedReadOptions options_;
+  size_t length_ = 0;
+
+  std::mutex mutex_;
+  // block indexes, most recently used first.
+  std::list<size_t> lru_;
+  std::unordered_map<size_t, Entry> blocks_;
+};
+
+RangedInputStream::RangedInputStream(std::shared_ptr<RangeSource> source,
+                                     const RangedReadOptions& options)
+    : RangedInputStream(
+          std::make_shared<BlockCache>(std::move(source), options)) {}
+
+RangedInputStream::RangedInputStream(std::shared_ptr<BlockCache> cache)
+    : cache_(std::move(cache)),
+      name_(cache_->Name()),
+      length_(cache_->Length()) {}
+
+RangedInputStream::~RangedInputStream() = default;
+
+bool RangedInputStream::NextBlock() {
+  if (cache_ == nullptr || pos_ >= length_) {
+    return false;
+  }
+  const size_t index = pos_ / cache_->BlockSize();
+  cur_block_ = cache_->Get(index);
+  try {
+    cur_ = &cur_block_.get();
+  } catch (const std::exception& e) {
+    cur_block_ = {};
+    cur_ = nullptr;
+    cache_->Drop(index);
+    fail_ = true;
+    YASL_THROW_IO_ERROR("Read error on '{}' at {}, {}", name_, pos_,
+                        e.what());
+  }
+  cur_pos_ = pos_ - index * cache_->BlockSize();
+  return true;
+}
+
+bool RangedInputStream::operator!() const { return fail_; }
+
+RangedInputStream::operator bool() const { return !fail_; }
+
+bool RangedInputStream::Eof() const { return eof_; }
+
+InputStream& RangedInputStream::GetLine(std::string* ret, char delim) {
+  // like std::getline, a stream already at eof fails without touching ret.
+  if (eof_ || fail_) {
+    fail_ = true;
+    return *this;
+  }
+  ret->clear();
+  while (true) {
+    const size_t avail = cur_ == nullptr ? 0 : cur_->size() - cur_pos_;
+    if (avail > 0) {
+      const char* begin = cur_->data() + cur_pos_;
+      const void* hit = std::memchr(begin, delim, avail);
+      const size_t len =
+          hit == nullptr ? avail : static_cast<const char*>(hit) - begin;
+      ret->append(begin, len);
+      if (hit != nullptr) {
+        cur_pos_ += len + 1;
+        pos_ += len + 1;
+        return *this;
+      }
+      cur_pos_ += len;
+      pos_ += len;
+    }
+    if (!NextBlock()) {
+      eof_ = true;
+      fail_ = ret->empty();
+      return *this;
+    }
+  }
+}
+
+InputStream& RangedInputStream::Read(void* buf, size_t length) {
+  auto* dst = static_cast<char*>(buf);
+  while (length > 0) {
+    const size_t avail = cur_ == nullptr ? 0 : cur_->size() - cur_pos_;
+    const size_t n = std::min(length, avail);
+    if (n > 0) {
+      std::memcpy(dst, cur_->data() + cur_pos_, n);
+      dst += n;
+      length -= n;
+      cur_pos_ += n;
+      pos_ += n;
+    } else if (!NextBlock()) {
+      break;
+    }
+  }
+  return *this;
+}
+
+InputStream& RangedInputStream::Seekg(size_t pos) {
+  // clear EOF/FAIL bit
+  eof_ = false;
+  fail_ = false;
+  // stays in the current block if it can.
+  if (cur_ != nullptr && pos >= pos_ - cur_pos_ &&
+      pos - (pos_ - cur_pos_) < cur_->size()) {
+    cur_pos_ = pos - (pos_ - cur_pos_);
+  } else {
+    cur_block_ = {};
+    cur_ = nullptr;
+    cur_pos_ = 0;
+  }
+  pos_ = pos;
+  return *this;
+}
+
+size_t RangedInputStream::Tellg() { return pos_; }
+
+size_t RangedInputStream::GetLength() const { return length_; }
+
+const std::string& RangedInputStream::GetName() const { return name_; }
+
+void RangedInputStream::Close() {
+  cur_block_ = {};
+  cur_ = nullptr;
+  cache_.reset();
+  length_ = 0;
+  eof_ = true;
+  fail_ = true;
+}
+
+std::unique_ptr<InputStream> RangedInputStream::Spawn() {
+  YASL_ENFORCE(cache_ != nullptr, "Spawn of closed stream '{}'", name_);
+  std::unique_ptr<InputStream> ret(new RangedInputStream(cache_));
+  ret->Seekg(Tellg());
+  return ret;
+}
+
+}  // namespace yasl::io
@@ -0,0 +1,109 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <future>
+#include <memory>
+#include <string>
+
+#include "yasl/io/stream/interface.h"
+
+namespace yasl::io {
+
+// a remote object read by byte ranges, like an object in s3 or oss.
+class RangeSource {
+ public:
+  virtual ~RangeSource() = default;
+
+  // size of the object in bytes, from its metadata.
+  virtual size_t GetLength() = 0;
+
+  // reads [offset, offset + length) into buf. thread safe, called by many
+  // threads at once. raise exception if any error happend.
+  virtual void ReadRange(size_t offset, size_t length, char* buf) = 0;
+
+  // name of the object for error messages.
+  virtual const std::string& GetName() const = 0;
+};
+
+struct RangedReadOptions {
+  // bytes per ranged read.
+  size_t block_size = 8 << 20;
+  // blocks after the current one fetched in parallel with it.
+  size_t prefetch_blocks = 4;
+  // blocks kept in memory, shared by a stream and all its spawns. must be
+  // more than prefetch_blocks.
+  size_t cache_blocks = 16;
+};
+
+// InputStream over a RangeSource. the object is read in blocks of
+// block_size; reaching a block starts the fetches of the next
+// prefetch_blocks, so that many ranged reads are in flight while the
+// current block is parsed. Spawned streams share the block cache, so
+// readers of nearby ranges fetch each block once.
+class RangedInputStream : public InputStream {
+ public:
+  explicit RangedInputStream(std::shared_ptr<RangeSource> source,
+                             const RangedReadOptions& options = {});
+
+  ~RangedInputStream() override;
+
+  bool operator!() const override;
+
+  explicit operator bool() const override;
+
+  bool Eof() const override;
+
+  using InputStream::GetLine;
+  InputStream& GetLine(std::string* ret, char delim) override;
+
+  InputStream& Read(void* buf, size_t length) override;
+
+  InputStream& Seekg(size_t pos) override;
+
+  size_t Tellg() override;
+
+  size_t GetLength() const override;
+
+  const std::string& GetName() const override;
+
+  void Close() override;
+
+  bool IsStreaming() override { return true; }
+
+  std::unique_ptr<InputStream> Spawn() override;
+
+ private:
+  class BlockCache;
+
+  explicit RangedInputStream(std::shared_ptr<BlockCache> cache);
+
+  // makes the block at pos_ current. false at the end of the object.
+  bool NextBlock();
+
+  std::shared_ptr<BlockCache> cache_;
+  std::string name_;
+  size_t length_ = 0;
+
+  // keeps the current block alive while it is read.
+  std::shared_future<std::string> cur_block_;
+  const std::string* cur_ = nullptr;
+  size_t cur_pos_ = 0;
+  size_t pos_ = 0;
+  bool eof_ = false;
+  bool fail_ = false;
+};
+
+}  // namespace yasl::io
@@ -0,0 +1,295 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "yasl/io/stream/readahead_io.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "fmt/format.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl::io {
+
+namespace {
+
+// offset, size and address alignment required by O_DIRECT.
+constexpr size_t kAlignment = 4096;
+
+size_t AlignUp(size_t n) {
+  return (n + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+}  // namespace
+
+ReadAheadInputStream::ReadAheadInputStream(std::string file_name,
+                                           const ReadAheadOptions& options)
+    : file_name_(std::move(file_name)),
+      options_(options),
+      buffer_size_(AlignUp(std::max<size_t>(options.buffer_size, 1))) {
+  YASL_ENFORCE(options_.buffer_count > 0, "buffer_count should be positive");
+  if (options_.direct_io) {
+    fd_ = open(file_name_.c_str(), O_RDONLY | O_DIRECT);
+    direct_ = fd_ != -1;
+  }
+  if (fd_ == -1) {
+    fd_ = open(file_name_.c_str(), O_RDONLY);
+  }
+  if (fd_ == -1) {
+    YASL_THROW_IO_ERROR(
+        "Open for read error on file '{}', error msg '{}', error code {}",
+        file_name_, std::strerror(errno), errno);
+  }
+  struct stat st;
+  if (fstat(fd_, &st) != 0) {
+    const int err = errno;
+    close(fd_);
+    YASL_THROW_IO_ERROR(
+        "Stat error on file '{}', error msg '{}', error code {}", file_name_,
+        std::strerror(err), err);
+  }
+  file_len_ = st.st_size;
+  if (!direct_) {
+    posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+  Start(0);
+}
+
+ReadAheadInputStream::~ReadAheadInputStream() {
+  Stop();
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+void ReadAheadInputStream::Start(size_t pos) {
+  const size_t offset = direct_ ? pos / kAlignment * kAlignment : pos;
+  skip_ = pos - offset;
+  pos_ = pos;
+  stop_ = false;
+  done_ = false;
+  error_.clear();
+  read_ahead_thread_ = std::thread(&ReadAheadInputStream::ReadLoop, this,
+                                   offset);
+}
+
+void ReadAheadInputStream::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (read_ahead_thread_.joinable()) {
+    read_ahead_thread_.join();
+  }
+  for (auto& buf : filled_) {
+    free_.push_back(std::move(buf));
+  }
+  filled_.clear();
+  if (cur_.data != nullptr) {
+    free_.push_back(std::move(cur_));
+  }
+  cur_ = Buffer();
+  cur_pos_ = 0;
+}
+
+void ReadAheadInputStream::ReadLoop(size_t offset) {
+  while (true) {
+    Buffer buf;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [&] {
+        return stop_ || filled_.size() < options_.buffer_count;
+      });
+      if (stop_) {
+        return;
+      }
+      if (!free_.empty()) {
+        buf = std::move(free_.back());
+        free_.pop_back();
+      }
+    }
+    if (buf.data == nullptr) {
+      buf.data.reset(
+          static_cast<char*>(std::aligned_alloc(kAlignment, buffer_size_)));
+      YASL_ENFORCE(buf.data != nullptr, "out of memory");
+    }
+
+    // with O_DIRECT only the read hitting the end of file may be short, so
+    // stop there instead of reading again from an unaligned offset.
+    size_t n = 0;
+    int err = 0;
+    while (n < buffer_size_ && offset + n < file_len_) {
+      const ssize_t ret =
+          pread(fd_, buf.data.get() + n, buffer_size_ - n, offset + n);
+      if (ret < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        err = errno;
+        break;
+      }
+      if (ret == 0) {
+        break;
+      }
+      n += ret;
+    }
+    buf.size = n;
+    offset += n;
+    const bool done = err != 0 || n < buffer_size_ || offset >= file_len_;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (err != 0) {
+        error_ = fmt::format("error msg '{}', error code {}",
+                             std::strerror(err), err);
+      }
+      if (n > 0 && err == 0) {
+        filled_.push_back(std::move(buf));
+      } else {
+        free_.push_back(std::move(buf));
+      }
+      done_ = done;
+    }
+    cv_.notify_all();
+    if (done) {
+      return;
+    }
+  }
+}
+
+bool ReadAheadInputStream::NextBuffer() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (cur_.data != nullptr) {
+      free_.push_back(std::move(cur_));
+    }
+    cur_ = Buffer();
+    cur_pos_ = 0;
+    cv_.wait(lock, [&] { return !filled_.empty() || done_ || stop_; });
+    if (filled_.empty()) {
+      if (!error_.empty()) {
+        YASL_THROW_IO_ERROR("Read error on file '{}', {}", file_name_,
+                            error_);
+      }
+      return false;
+    }
+    cur_ = std::move(filled_.front());
+    filled_.pop_front();
+  }
+  cv_.notify_all();
+  cur_pos_ = std::min(skip_, cur_.size);
+  skip_ -= cur_pos_;
+  return true;
+}
+
+bool ReadAheadInputStream::operator!() const { return fail_; }
+
+ReadAheadInputStream::operator bool() const { return !fail_; }
+
+bool ReadAheadInputStream::Eof() const { return eof_; }
+
+InputStream& ReadAheadInputStream::GetLine(std::string* ret, char delim) {
+  // like std::getline, a stream already at eof fails without touching ret.
+  if (eof_ || fail_) {
+    fail_ = true;
+    return *this;
+  }
+  ret->clear();
+  while (true) {
+    const size_t avail = cur_.size - cur_pos_;
+    if (avail > 0) {
+      const char* begin = cur_.data.get() + cur_pos_;
+      const void* hit = std::memchr(begin, delim, avail);
+      const size_t len =
+          hit == nullptr ? avail : static_cast<const char*>(hit) - begin;
+      ret->append(begin, len);
+      if (hit != nullptr) {
+        cur_pos_ += len + 1;
+        pos_ += len + 1;
+        return *this;
+      }
+      cur_pos_ += len;
+      pos_ += len;
+    }
+    if (!NextBuffer()) {
+      eof_ = true;
+      fail_ = ret->empty();
+      return *this;
+    }
+  }
+}
+
+InputStream& ReadAheadInputStream::Read(void* buf, size_t length) {
+  auto* dst = static_cast<char*>(buf);
+  while (length > 0) {
+    const size_t n = std::min(length, cur_.size - cur_pos_);
+    if (n > 0) {
+      std::memcpy(dst, cur_.data.get() + cur_pos_, n);
+      dst += n;
+      length -= n;
+      cur_pos_ += n;
+      pos_ += n;
+    } else if (!NextBuffer()) {
+      break;
+    }
+  }
+  return *this;
+}
+
+InputStream& ReadAheadInputStream::Seekg(size_t pos) {
+  // clear EOF/FAIL bit
+  eof_ = false;
+  fail_ = false;
+  Stop();
+  Start(pos);
+  return *this;
+}
+
+size_t ReadAheadInputStream::Tellg() { return pos_; }
+
+size_t ReadAheadInputStream::GetLength() const { return file_len_; }
+
+const std::string& ReadAheadInputStream::GetName() const {
+  return file_name_;
+}
+
+void ReadAheadInputStream::Close() {
+  Stop();
+  free_.clear();
+  if (fd_ != -1) {
+    close(fd_);
+    fd_ = -1;
+  }
+  file_len_ = 0;
+  eof_ = true;
+  fail_ = true;
+}
+
+std::unique_ptr<InputStream> ReadAheadInputStream::Spawn() {
+  std::unique_ptr<InputStream> ret(
+      new ReadAheadInputStream(file_name_, options_));
+  ret->Seekg(Tellg());
+  return ret;
+}
+
+}  // namespace yasl::io
@@ -0,0 +1,126 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "yasl/io/stream/interface.h"
+
+namespace yasl::io {
+
+struct ReadAheadOptions {
+  // bytes per read, rounded up to 4 KiB.
+  size_t buffer_size = 1 << 20;
+  // buffers filled ahead of the reader.
+  size_t buffer_count = 4;
+  // open with O_DIRECT, bypassing the page cache. silently falls back to
+  // buffered io if the file system does not support it.
+  bool direct_io = false;
+};
+
+// InputStream over a local file that is read sequentially by a background
+// thread, so that the io of the next `buffer_count` buffers overlaps with
+// the parsing of the current one. Behaves like FileInputStream otherwise.
+class ReadAheadInputStream : public InputStream {
+ public:
+  /**
+   * open {file_name} for read.
+   * raise exception if any error happend.
+   */
+  explicit ReadAheadInputStream(std::string file_name,
+                                const ReadAheadOptions& options = {});
+
+  ~ReadAheadInputStream() override;
+
+  bool operator!() const override;
+
+  explicit operator bool() const override;
+
+  bool Eof() const override;
+
+  using InputStream::GetLine;
+  InputStream& GetLine(std::string* ret, char delim) override;
+
+  InputStream& Read(void* buf, size_t length) override;
+
+  InputStream& Seekg(size_t pos) override;
+
+  size_t Tellg() override;
+
+  size_t GetLength() const override;
+
+  const std::string& GetName() const override;
+
+  void Close() override;
+
+  bool IsStreaming() override { return false; }
+
+  std::unique_ptr<InputStream> Spawn() override;
+
+ private:
+  struct FreeDeleter {
+    void operator()(char* p) const { std::free(p); }
+  };
+
+  struct Buffer {
+    std::unique_ptr<char, FreeDeleter> data;
+    size_t size = 0;
+  };
+
+  // starts the read ahead thread at pos.
+  void Start(size_t pos);
+  // stops the read ahead thread and drops all filled buffers.
+  void Stop();
+  // body of the read ahead thread.
+  void ReadLoop(size_t offset);
+  // swaps the next filled buffer into cur_. false at the end of file.
+  bool NextBuffer();
+
+  const std::string file_name_;
+  const ReadAheadOptions options_;
+  size_t buffer_size_;
+  int fd_ = -1;
+  bool direct_ = false;
+  size_t file_len_ = 0;
+
+  // owned by the reading thread.
+  Buffer cur_;
+  size_t cur_pos_ = 0;
+  // bytes to drop from the first buffer after an aligned start.
+  size_t skip_ = 0;
+  size_t pos_ = 0;
+  bool eof_ = false;
+  bool fail_ = false;
+
+  // shared with the read ahead thread.
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Buffer> filled_;
+  std::vector<Buffer> free_;
+  bool stop_ = false;
+  bool done_ = false;
+  std::string error_;
+  std::thread read_ahead_thread_;
+};
+
+}  // namespace yasl::io
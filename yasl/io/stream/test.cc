@@ -13,15 +13,22 @@
 // limitations under the License.
 
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <ctime>
 #include <filesystem>
+#include <thread>
 
 #include "gtest/gtest.h"
 
 #include "yasl/base/exception.h"
 #include "yasl/io/stream/file_io.h"
+#include "yasl/io/stream/gzip_io.h"
 #include "yasl/io/stream/mem_io.h"
+#include "yasl/io/stream/mmap_io.h"
+#include "yasl/io/stream/ranged_io.h"
+#include "yasl/io/stream/readahead_io.h"
 
 namespace yasl::io {
 
@@ -86,6 +93,45 @@ TEST_P(IOTest, MemIO) {
   }
 }
 
+TEST(MemIO, ViewAndRelease) {
+  const std::string input = "aaa\nbbb\nccc";
+  auto in = MemInputStream::View(input);
+  std::string_view line;
+  ASSERT_TRUE(in->GetLineView(&line));
+  EXPECT_EQ(line, "aaa");
+  EXPECT_EQ(line.data(), input.data());
+  auto spawned = in->Spawn();
+  ASSERT_TRUE(in->GetLineView(&line));
+  ASSERT_TRUE(in->GetLineView(&line));
+  EXPECT_EQ(line, "ccc");
+  EXPECT_TRUE(in->Eof());
+  EXPECT_FALSE(in->GetLineView(&line));
+  std::string copy;
+  EXPECT_TRUE(spawned->GetLine(&copy));
+  EXPECT_EQ(copy, "bbb");
+
+  MemOutputStream out;
+  std::string expected;
+  for (size_t i = 0; i < 10000; i++) {
+    const auto str = fmt::format("{},", i);
+    out.Write(str);
+    expected += str;
+  }
+  EXPECT_EQ(out.Tellp(), expected.size());
+  Buffer buf = out.Release();
+  EXPECT_EQ(std::string_view(buf), expected);
+  EXPECT_EQ(out.Tellp(), 0);
+  out.Write("x", 1);
+  EXPECT_EQ(std::string_view(out.Release()), "x");
+  EXPECT_EQ(out.Release().size(), 0);
+
+  std::string str;
+  MemOutputStream to_str(&str);
+  EXPECT_THROW(to_str.Release(), EnforceNotMet);
+  to_str.Close();
+  EXPECT_THROW(to_str.Write("x", 1), EnforceNotMet);
+}
+
 TEST_P(IOTest, FileIO) {
   auto param = GetParam();
   std::filesystem::current_path(std::filesystem::temp_directory_path());
@@ -130,4 +176,417 @@ TEST_P(IOTest, FileIO) {
   }
 }
 
-}  // namespace yasl::io
\ No newline at end of file
+TEST_P(IOTest, MmapIO) {
+  auto param = GetParam();
+  std::filesystem::current_path(std::filesystem::temp_directory_path());
+  std::string file_name(fmt::format("{}.mmap.test", std::time(nullptr)));
+  {
+    FileOutputStream out(file_name);
+    out.Write(param.data, strlen(param.data));
+  }
+  {
+    std::unique_ptr<InputStream> in(new MmapInputStream(file_name));
+    EXPECT_EQ(strlen(param.data), in->GetLength());
+    int count = 0;
+    std::string line;
+    EXPECT_EQ(in->Eof(), false);
+    while (in->GetLine(&line)) {
+      count++;
+    };
+    EXPECT_EQ(count, param.while_count);
+    EXPECT_EQ(line, param.last_line);
+    EXPECT_EQ(in->Tellg(), strlen(param.data));
+    EXPECT_EQ(in->operator bool(), false);
+    EXPECT_EQ(in->operator!(), true);
+    EXPECT_EQ(in->Eof(), true);
+
+    in->Seekg(1);
+    auto spawned = in->Spawn();
+    count = 0;
+    EXPECT_EQ(in->Eof(), false);
+    while (in->GetLine(&line)) {
+      count++;
+    };
+    EXPECT_EQ(count, param.while_count);
+    EXPECT_EQ(line, param.last_line);
+    EXPECT_EQ(in->Tellg(), strlen(param.data));
+    EXPECT_EQ(in->Eof(), true);
+
+    // the spawned stream keeps the mapping after the parent closes.
+    in.reset();
+    EXPECT_EQ(spawned->Tellg(), 1);
+    spawned->GetLine(&line);
+    EXPECT_EQ(line, "aa");
+    char buf[4] = {};
+    spawned->Read(buf, 3);
+    EXPECT_EQ(std::string(buf), "bbb");
+    EXPECT_EQ(spawned->Tellg(), 7);
+  }
+  {
+    MmapInputStream in(file_name);
+    int count = 0;
+    std::string_view line;
+    while (in.GetLineView(&line)) {
+      EXPECT_EQ(line.size(), 3);
+      count++;
+    }
+    EXPECT_EQ(count, param.while_count);
+    EXPECT_EQ(in.Eof(), true);
+  }
+  std::filesystem::remove(file_name);
+}
+
+TEST(MmapIO, EmptyFile) {
+  std::filesystem::current_path(std::filesystem::temp_directory_path());
+  std::string file_name(fmt::format("{}.empty.test", std::time(nullptr)));
+  { FileOutputStream out(file_name); }
+  MmapInputStream in(file_name);
+  EXPECT_EQ(in.GetLength(), 0);
+  std::string line;
+  EXPECT_FALSE(in.GetLine(&line));
+  EXPECT_TRUE(in.Eof());
+  std::filesystem::remove(file_name);
+}
+
+TEST_P(IOTest, ReadAheadIO) {
+  auto param = GetParam();
+  std::filesystem::current_path(std::filesystem::temp_directory_path());
+  std::string file_name(fmt::format("{}.readahead.test", std::time(nullptr)));
+  {
+    FileOutputStream out(file_name);
+    out.Write(param.data, strlen(param.data));
+  }
+  {
+    std::unique_ptr<InputStream> in(new ReadAheadInputStream(file_name));
+    EXPECT_EQ(strlen(param.data), in->GetLength());
+    int count = 0;
+    std::string line;
+    EXPECT_EQ(in->Eof(), false);
+    while (in->GetLine(&line)) {
+      count++;
+    };
+    EXPECT_EQ(count, param.while_count);
+    EXPECT_EQ(line, param.last_line);
+    EXPECT_EQ(in->Tellg(), strlen(param.data));
+    EXPECT_EQ(in->operator bool(), false);
+    EXPECT_EQ(in->operator!(), true);
+    EXPECT_EQ(in->Eof(), true);
+
+    in->Seekg(1);
+    count = 0;
+    EXPECT_EQ(in->Eof(), false);
+    while (in->GetLine(&line)) {
+      count++;
+    };
+    EXPECT_EQ(count, param.while_count);
+    EXPECT_EQ(line, param.last_line);
+    EXPECT_EQ(in->Tellg(), strlen(param.data));
+    EXPECT_EQ(in->Eof(), true);
+  }
+  std::filesystem::remove(file_name);
+}
+
+TEST_P(IOTest, GzipIO) {
+  auto param = GetParam();
+  std::filesystem::current_path(std::filesystem::temp_directory_path());
+  std::string file_name(fmt::format("{}.gzip.test.gz", std::time(nullptr)));
+  {
+    GzipOutputStream out(file_name);
+    out.Write(param.data, strlen(param.data));
+    EXPECT_EQ(out.Tellp(), strlen(param.data));
+  }
+  {
+    std::unique_ptr<InputStream> in(new GzipInputStream(file_name));
+    EXPECT_EQ(strlen(param.data), in->GetLength());
+    int count = 0;
+    std::string line;
+    EXPECT_EQ(in->Eof(), false);
+    while (in->GetLine(&line)) {
+      count++;
+    };
+    EXPECT_EQ(count, param.while_count);
+    EXPECT_EQ(line, param.last_line);
+    EXPECT_EQ(in->Tellg(), strlen(param.data));
+    EXPECT_EQ(in->operator bool(), false);
+    EXPECT_EQ(in->operator!(), true);
+    EXPECT_EQ(in->Eof(), true);
+
+    in->Seekg(1);
+    count = 0;
+    EXPECT_EQ(in->Eof(), false);
+    while (in->GetLine(&line)) {
+      count++;
+    };
+    EXPECT_EQ(count, param.while_count);
+    EXPECT_EQ(line, param.last_line);
+    EXPECT_EQ(in->Tellg(), strlen(param.data));
+    EXPECT_EQ(in->Eof(), true);
+  }
+  std::filesystem::remove(file_name);
+}
+
+// concatenated members spanning many buffers, and broken files.
+TEST(GzipIO, Members) {
+  std::filesystem::current_path(std::filesystem::temp_directory_path());
+  std::string file_name(fmt::format("{}.gzip.test.gz", std::time(nullptr)));
+  std::string data;
+  std::string compressed;
+  for (size_t member = 0; member < 3; member++) {
+    {
+      GzipOutputStream out(file_name, member + 1);
+      for (size_t i = 0; i < 100000; i++) {
+        const auto line = fmt::format("{},{}\n", member, i * 7919);
+        out.Write(line);
+        data += line;
+        if (i == 500) {
+          out.Flush();
+        }
+      }
+    }
+    FileInputStream in(file_name);
+    std::string part(in.GetLength(), '\0');
+    in.Read(part.data(), part.size());
+    compressed += part;
+  }
+  {
+    FileOutputStream out(file_name);
+    out.Write(compressed);
+  }
+
+  GzipInputStream in(file_name);
+  EXPECT_EQ(in.GetLength(), data.size());
+  std::string buf(data.size() / 2, 0);
+  in.Read(buf.data(), buf.size());
+  EXPECT_EQ(buf, data.substr(0, buf.size()));
+  auto spawned = in.Spawn();
+  in.Seekg(3);
+  std::string rest;
+  std::string line;
+  while (in.GetLine(&line)) {
+    rest += line + "\n";
+  }
+  EXPECT_EQ(rest, data.substr(3));
+  EXPECT_EQ(spawned->Tellg(), buf.size());
+  spawned->Read(buf.data(), buf.size());
+  EXPECT_EQ(buf, data.substr(data.size() / 2, buf.size()));
+
+  {
+    FileOutputStream out(file_name);
+    out.Write(compressed.substr(0, compressed.size() - 100));
+  }
+  GzipInputStream truncated(file_name);
+  EXPECT_THROW(truncated.GetLength(), yasl::InvalidFormat);
+  {
+    FileOutputStream out(file_name);
+    out.Write("not gzip at all");
+  }
+  GzipInputStream garbage(file_name);
+  EXPECT_THROW(garbage.GetLine(&line), yasl::InvalidFormat);
+  std::filesystem::remove(file_name);
+}
+
+class ReadAheadIOTest : public ::testing::TestWithParam<bool> {};
+
+INSTANTIATE_TEST_SUITE_P(DirectIO, ReadAheadIOTest, testing::Bool());
+
+// lines and reads crossing many small buffers.
+TEST_P(ReadAheadIOTest, SmallBuffers) {
+  std::filesystem::current_path(std::filesystem::temp_directory_path());
+  std::string file_name(fmt::format("{}.readahead.test", std::time(nullptr)));
+  std::vector<std::string> lines;
+  std::string data;
+  for (size_t i = 0; i < 3000; i++) {
+    lines.push_back(std::string(i % 37, 'a' + i % 26));
+    data += lines.back() + "\n";
+  }
+  {
+    FileOutputStream out(file_name);
+    out.Write(data);
+  }
+
+  ReadAheadOptions options;
+  options.buffer_size = 4096;
+  options.buffer_count = 2;
+  options.direct_io = GetParam();
+  ReadAheadInputStream in(file_name, options);
+  EXPECT_EQ(in.GetLength(), data.size());
+  std::string line;
+  for (const auto& expected : lines) {
+    ASSERT_TRUE(in.GetLine(&line));
+    EXPECT_EQ(line, expected);
+  }
+  EXPECT_FALSE(in.GetLine(&line));
+  EXPECT_TRUE(in.Eof());
+
+  // unaligned seek, then a read spanning several buffers.
+  const size_t pos = 5000;
+  in.Seekg(pos);
+  auto spawned = in.Spawn();
+  std::string buf(10000, 0);
+  in.Read(buf.data(), buf.size());
+  EXPECT_EQ(buf, data.substr(pos, buf.size()));
+  EXPECT_EQ(in.Tellg(), pos + buf.size());
+
+  EXPECT_EQ(spawned->Tellg(), pos);
+  std::string rest;
+  while (spawned->GetLine(&line)) {
+    rest += line + "\n";
+  }
+  EXPECT_EQ(rest, data.substr(pos));
+  std::filesystem::remove(file_name);
+}
+
+namespace {
+
+// in memory object, counting the ranged reads.
+class FakeRangeSource : public RangeSource {
+ public:
+  explicit FakeRangeSource(std::string data) : data_(std::move(data)) {}
+
+  size_t GetLength() override { return data_.size(); }
+
+  void ReadRange(size_t offset, size_t length, char* buf) override {
+    const size_t in_flight = ++in_flight_;
+    size_t max = max_in_flight_;
+    while (in_flight > max &&
+           !max_in_flight_.compare_exchange_weak(max, in_flight)) {
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    --in_flight_;
+    reads_++;
+    if (fail_) {
+      YASL_THROW_IO_ERROR("injected failure");
+    }
+    ASSERT_LE(offset + length, data_.size());
+    std::memcpy(buf, data_.data() + offset, length);
+  }
+
+  const std::string& GetName() const override { return name_; }
+
+  std::atomic<size_t> reads_{0};
+  std::atomic<size_t> max_in_flight_{0};
+  std::atomic<bool> fail_{false};
+
+ private:
+  const std::string data_;
+  const std::string name_ = "fake";
+  std::atomic<size_t> in_flight_{0};
+};
+
+}  // namespace
+
+TEST_P(IOTest, RangedIO) {
+  auto param = GetParam();
+  RangedReadOptions options;
+  options.block_size = 2;
+  options.prefetch_blocks = 1;
+  options.cache_blocks = 2;
+  std::unique_ptr<InputStream> in(new RangedInputStream(
+      std::make_shared<FakeRangeSource>(param.data), options));
+  EXPECT_EQ(strlen(param.data), in->GetLength());
+  int count = 0;
+  std::string line;
+  EXPECT_EQ(in->Eof(), false);
+  while (in->GetLine(&line)) {
+    count++;
+  };
+  EXPECT_EQ(count, param.while_count);
+  EXPECT_EQ(line, param.last_line);
+  EXPECT_EQ(in->Tellg(), strlen(param.data));
+  EXPECT_EQ(in->operator bool(), false);
+  EXPECT_EQ(in->Eof(), true);
+
+  in->Seekg(1);
+  count = 0;
+  EXPECT_EQ(in->Eof(), false);
+  while (in->GetLine(&line)) {
+    count++;
+  };
+  EXPECT_EQ(count, param.while_count);
+  EXPECT_EQ(line, param.last_line);
+  EXPECT_EQ(in->Tellg(), strlen(param.data));
+  EXPECT_EQ(in->Eof(), true);
+}
+
+TEST(RangedIO, PrefetchAndCache) {
+  std::vector<std::string> lines;
+  std::string data;
+  for (size_t i = 0; i < 3000; i++) {
+    lines.push_back(std::string(i % 37, 'a' + i % 26));
+    data += lines.back() + "\n";
+  }
+  auto source = std::make_shared<FakeRangeSource>(data);
+  RangedReadOptions options;
+  options.block_size = 1000;
+  options.prefetch_blocks = 4;
+  options.cache_blocks = 64;
+  const size_t blocks = (data.size() + 999) / 1000;
+  ASSERT_LE(blocks, options.cache_blocks);
+
+  RangedInputStream in(source, options);
+  EXPECT_TRUE(in.IsStreaming());
+  std::string line;
+  for (const auto& expected : lines) {
+    ASSERT_TRUE(in.GetLine(&line));
+    EXPECT_EQ(line, expected);
+  }
+  EXPECT_FALSE(in.GetLine(&line));
+  // every block once, several at a time.
+  EXPECT_EQ(source->reads_, blocks);
+  EXPECT_GT(source->max_in_flight_, 1);
+
+  // spawns and seeks are served by the shared cache.
+  const size_t pos = 5000;
+  in.Seekg(pos);
+  auto spawned = in.Spawn();
+  std::string buf(10000, 0);
+  in.Read(buf.data(), buf.size());
+  EXPECT_EQ(buf, data.substr(pos, buf.size()));
+  EXPECT_EQ(in.Tellg(), pos + buf.size());
+  std::string rest;
+  while (spawned->GetLine(&line)) {
+    rest += line + "\n";
+  }
+  EXPECT_EQ(rest, data.substr(pos));
+  EXPECT_EQ(source->reads_, blocks);
+}
+
+TEST(RangedIO, Eviction) {
+  std::string data(100000, 'x');
+  auto source = std::make_shared<FakeRangeSource>(data);
+  RangedReadOptions options;
+  options.block_size = 1000;
+  options.prefetch_blocks = 2;
+  options.cache_blocks = 4;
+  RangedInputStream in(source, options);
+  std::string buf(data.size(), 0);
+  in.Read(buf.data(), buf.size());
+  EXPECT_EQ(buf, data);
+  EXPECT_EQ(source->reads_, 100);
+  // block 0 was evicted long ago.
+  in.Seekg(0);
+  in.Read(buf.data(), 10);
+  EXPECT_GT(source->reads_, 100);
+
+  options.cache_blocks = 2;
+  EXPECT_THROW(RangedInputStream(source, options), EnforceNotMet);
+}
+
+TEST(RangedIO, ReadError) {
+  auto source = std::make_shared<FakeRangeSource>("aaa\nbbb\nccc\n");
+  RangedReadOptions options;
+  options.block_size = 4;
+  options.prefetch_blocks = 0;
+  options.cache_blocks = 1;
+  RangedInputStream in(source, options);
+  source->fail_ = true;
+  std::string line;
+  EXPECT_THROW(in.GetLine(&line), IoError);
+  // the failed block is fetched again.
+  source->fail_ = false;
+  in.Seekg(0);
+  ASSERT_TRUE(in.GetLine(&line));
+  EXPECT_EQ(line, "aaa");
+}
+
+}  // namespace yasl::io
@@ -14,15 +14,73 @@
 
 #include "yasl/link/algorithm/allgather.h"
 
+#include <algorithm>
+
 #include "fmt/format.h"
 
 #include "yasl/base/exception.h"
+#include "yasl/base/shared_buffer.h"
 #include "yasl/link/trace.h"
 #include "yasl/utils/serialize.h"
 
 namespace yasl::link {
 namespace {
 const char* kType = "ALLGATHER";
+
+// worlds this large gather in log rounds instead of sending to all directly.
+constexpr size_t kBruckMinWorldSize = 4;
+
+// Bruck's allgather impl.
+// see: "Efficient algorithms for all-to-all communications in multiport
+// message-passing systems", Bruck et al.
+//
+// blocks are kept in virtual rank space, which take self as rank 0. in the
+// round of `stride`, each rank holds blocks [0, stride) and sends them to
+// rank - stride, while receiving blocks [stride, 2 * stride) from rank +
+// stride. every block is forwarded once, so each rank sends n-1 blocks in
+// total, in ceil(log2(n)) rounds.
+//
+// |-0-|-1-|-2-|-3-|-4-| nodes
+// |-A-|-B-|-C-|-D-|-E-| init
+// |-AB|-BC|-CD|-DE|-EA| stride 1
+// |ABCD|BCDE|CDEA|DEAB|EABC| stride 2
+// |ABCDE|BCDEA|CDEAB|DEABC|EABCD| stride 4, only one block left to send
+std::vector<Buffer> BruckAllGather(const std::shared_ptr<Context>& ctx,
+                                   Buffer&& input, const std::string& event) {
+  const size_t world_size = ctx->WorldSize();
+
+  // received blocks are slices of the msgs they came in, they are copied
+  // out once at the end rather than every time they are unpacked.
+  std::vector<SharedBuffer> blocks;
+  blocks.reserve(world_size);
+  blocks.emplace_back(std::move(input));
+  for (size_t stride = 1; stride < world_size; stride <<= 1) {
+    const size_t count = std::min(stride, world_size - stride);
+    // the blocks are forwarded as they are, behind a header of their sizes.
+    Buffer header;
+    ctx->SendAsyncInternal(
+        ctx->PrevRank(stride), event,
+        SerializeArrayOfBuffers({blocks.begin(), blocks.begin() + count},
+                                &header));
+
+    auto received = DeserializeArrayOfSharedBuffers(
+        ctx->RecvInternal(ctx->NextRank(stride), event));
+    YASL_ENFORCE(received.size() == count, "expect {} blocks, got {}", count,
+                 received.size());
+    for (auto& block : received) {
+      blocks.push_back(std::move(block));
+    }
+  }
+
+  // back to physical rank space.
+  std::vector<Buffer> outputs(world_size);
+  for (size_t idx = 0; idx < world_size; idx++) {
+    outputs[(ctx->Rank() + idx) % world_size] =
+        std::move(blocks[idx]).ToBuffer();
+  }
+  return outputs;
+}
+
 }  // namespace
 
 template <class ValueType>
@@ -32,6 +90,10 @@ std::vector<Buffer> AllGatherImpl(const std::shared_ptr<Context>& ctx,
 
   TraceLogger::LinkTrace(event, tag, input);
 
+  if (ctx->WorldSize() >= kBruckMinWorldSize) {
+    return BruckAllGather(ctx, Buffer(std::forward<ValueType>(input)), event);
+  }
+
   // broadcast to all
   for (size_t idx = 0; idx < ctx->WorldSize(); idx++) {
     if (idx == ctx->Rank()) {
@@ -41,15 +103,22 @@ std::vector<Buffer> AllGatherImpl(const std::shared_ptr<Context>& ctx,
     ctx->SendAsyncInternal(idx, event, input);
   }
 
-  // gather all
+  // gather all, in arrival order, so that a slow party never delays taking
+  // msgs which are already there.
   std::vector<Buffer> outputs(ctx->WorldSize());
+  std::vector<std::pair<size_t, std::string>> sources;
   for (size_t idx = 0; idx < ctx->WorldSize(); idx++) {
     if (idx == ctx->Rank()) {
       outputs[idx] = Buffer(std::forward<ValueType>(input));
       continue;
     }
 
-    outputs[idx] = ctx->RecvInternal(idx, event);
+    sources.emplace_back(idx, event);
+  }
+  while (!sources.empty()) {
+    auto [idx, value] = ctx->RecvAnyInternal(sources);
+    outputs[sources[idx].first] = std::move(value);
+    sources.erase(sources.begin() + idx);
   }
 
   return outputs;
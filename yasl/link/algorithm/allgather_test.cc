@@ -98,6 +98,8 @@ TEST_P(AllGatherTest, VectorWorks) {
 INSTANTIATE_TEST_SUITE_P(Works_Instances, AllGatherTest,
                          testing::Values(TestParams{2, 20},  //
                                          TestParams{3, 20},  //
+                                         TestParams{4, 20},  //
+                                         TestParams{5, 20},  //
                                          TestParams{9, 20}   //
                                          ));
 
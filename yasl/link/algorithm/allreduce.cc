@@ -0,0 +1,147 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/algorithm/allreduce.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "fmt/format.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/link/trace.h"
+
+namespace yasl::link {
+namespace {
+
+const char* kType = "ALLREDUCE";
+const char* kReduceScatterType = "REDUCESCATTER";
+
+// the payload is cut into world_size segments of whole elements.
+class Segments {
+ public:
+  Segments(size_t size, size_t elem_size, size_t world_size)
+      : size_(size),
+        segment_size_((size / elem_size + world_size - 1) / world_size *
+                      elem_size) {}
+
+  size_t Begin(size_t idx) const {
+    return std::min(idx * segment_size_, size_);
+  }
+
+  size_t Size(size_t idx) const { return Begin(idx + 1) - Begin(idx); }
+
+ private:
+  const size_t size_;
+  const size_t segment_size_;
+};
+
+// ring reduce-scatter in place, in round r, each party passes its partial
+// sum of segment (rank - r - 1) to the next party, which combines it into
+// its own. after n-1 rounds, party of rank i holds the sum of segment i.
+void RingReduceScatter(const std::shared_ptr<Context>& ctx,
+                       const std::string& event, const Segments& segments,
+                       const ReduceFn& fn, Buffer* data) {
+  const size_t world_size = ctx->WorldSize();
+  auto* ptr = data->data<uint8_t>();
+  for (size_t round = 0; round + 1 < world_size; round++) {
+    // one key per round, since all rounds talk to the same peers.
+    const auto round_event = fmt::format("{}:RS{}", event, round);
+
+    const size_t send_seg =
+        (ctx->Rank() + 2 * world_size - round - 1) % world_size;
+    ctx->SendAsyncInternal(ctx->NextRank(), round_event,
+                           ByteContainerView(ptr + segments.Begin(send_seg),
+                                             segments.Size(send_seg)));
+
+    const size_t recv_seg =
+        (ctx->Rank() + 2 * world_size - round - 2) % world_size;
+    auto partial = ctx->RecvInternal(ctx->PrevRank(), round_event);
+    YASL_ENFORCE(
+        partial.size() == static_cast<int64_t>(segments.Size(recv_seg)),
+        "segment size mismatch, expect {}, got {}", segments.Size(recv_seg),
+        partial.size());
+    fn(ByteContainerView(partial),
+       absl::MakeSpan(ptr + segments.Begin(recv_seg), segments.Size(recv_seg)));
+  }
+}
+
+// ring allgather in place, in round r, each party passes segment (rank - r)
+// to the next party.
+void RingAllGather(const std::shared_ptr<Context>& ctx,
+                   const std::string& event, const Segments& segments,
+                   Buffer* data) {
+  const size_t world_size = ctx->WorldSize();
+  auto* ptr = data->data<uint8_t>();
+  for (size_t round = 0; round + 1 < world_size; round++) {
+    const auto round_event = fmt::format("{}:AG{}", event, round);
+
+    const size_t send_seg = (ctx->Rank() + world_size - round) % world_size;
+    ctx->SendAsyncInternal(ctx->NextRank(), round_event,
+                           ByteContainerView(ptr + segments.Begin(send_seg),
+                                             segments.Size(send_seg)));
+
+    const size_t recv_seg = (ctx->Rank() + world_size - round - 1) % world_size;
+    auto segment = ctx->RecvInternal(ctx->PrevRank(), round_event);
+    YASL_ENFORCE(
+        segment.size() == static_cast<int64_t>(segments.Size(recv_seg)),
+        "segment size mismatch, expect {}, got {}", segments.Size(recv_seg),
+        segment.size());
+    if (segment.size() > 0) {
+      std::memcpy(ptr + segments.Begin(recv_seg), segment.data(),
+                  segment.size());
+    }
+  }
+}
+
+}  // namespace
+
+Buffer AllReduce(const std::shared_ptr<Context>& ctx, ByteContainerView input,
+                 size_t elem_size, const ReduceFn& fn, std::string_view tag) {
+  YASL_ENFORCE(elem_size > 0 && input.size() % elem_size == 0,
+               "input size={} is not a multiple of elem size={}", input.size(),
+               elem_size);
+
+  const auto event = fmt::format("{}:{}", ctx->NextId(), kType);
+
+  TraceLogger::LinkTrace(event, tag, input);
+
+  Buffer output(input.data(), input.size());
+  const Segments segments(input.size(), elem_size, ctx->WorldSize());
+  RingReduceScatter(ctx, event, segments, fn, &output);
+  RingAllGather(ctx, event, segments, &output);
+
+  return output;
+}
+
+Buffer ReduceScatter(const std::shared_ptr<Context>& ctx,
+                     ByteContainerView input, size_t elem_size,
+                     const ReduceFn& fn, std::string_view tag) {
+  YASL_ENFORCE(elem_size > 0 && input.size() % elem_size == 0,
+               "input size={} is not a multiple of elem size={}", input.size(),
+               elem_size);
+
+  const auto event = fmt::format("{}:{}", ctx->NextId(), kReduceScatterType);
+
+  TraceLogger::LinkTrace(event, tag, input);
+
+  Buffer data(input.data(), input.size());
+  const Segments segments(input.size(), elem_size, ctx->WorldSize());
+  RingReduceScatter(ctx, event, segments, fn, &data);
+
+  return Buffer(data.data<uint8_t>() + segments.Begin(ctx->Rank()),
+                segments.Size(ctx->Rank()));
+}
+
+}  // namespace yasl::link
@@ -0,0 +1,99 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/byte_container_view.h"
+#include "yasl/link/context.h"
+
+namespace yasl::link {
+
+// combines `in` into `inout`, both hold the same number of elements.
+using ReduceFn =
+    std::function<void(ByteContainerView in, absl::Span<uint8_t> inout)>;
+
+// Reduce the inputs of all parties element-wise, by ring reduce-scatter then
+// ring allgather, each party sends 2(n-1)/n of the payload.
+//
+// input: of the same size on every party, a multiple of `elem_size`.
+Buffer AllReduce(const std::shared_ptr<Context>& ctx, ByteContainerView input,
+                 size_t elem_size, const ReduceFn& fn, std::string_view tag);
+
+// Reduce the inputs of all parties element-wise, each party only gets a
+// segment of the result, party of rank i gets elements [i * k, (i + 1) * k),
+// k = ceil(num_elems / world_size), the last segments may be shorter or
+// empty. each party sends (n-1)/n of the payload.
+Buffer ReduceScatter(const std::shared_ptr<Context>& ctx,
+                     ByteContainerView input, size_t elem_size,
+                     const ReduceFn& fn, std::string_view tag);
+
+namespace internal {
+
+template <typename T, typename Op>
+ReduceFn MakeReduceFn(Op&& op) {
+  return [op = std::forward<Op>(op)](ByteContainerView in,
+                                     absl::Span<uint8_t> inout) {
+    const auto* lhs = reinterpret_cast<const T*>(in.data());
+    auto* rhs = reinterpret_cast<T*>(inout.data());
+    for (size_t idx = 0; idx < inout.size() / sizeof(T); idx++) {
+      rhs[idx] = op(lhs[idx], rhs[idx]);
+    }
+  };
+}
+
+template <typename T>
+std::vector<T> ToVector(const Buffer& buf) {
+  std::vector<T> result(buf.size() / sizeof(T));
+  if (!result.empty()) {
+    std::memcpy(result.data(), buf.data(), buf.size());
+  }
+  return result;
+}
+
+}  // namespace internal
+
+// typed AllReduce, e.g. share reconstruction
+//   AllReduce<uint128_t>(ctx, shares, std::plus<uint128_t>(), "tag");
+//   AllReduce<uint64_t>(ctx, shares, std::bit_xor<uint64_t>(), "tag");
+template <typename T, typename Op>
+std::vector<T> AllReduce(const std::shared_ptr<Context>& ctx,
+                         absl::Span<const T> input, Op&& op,
+                         std::string_view tag) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  auto output = AllReduce(
+      ctx, ByteContainerView(input.data(), input.size() * sizeof(T)),
+      sizeof(T), internal::MakeReduceFn<T>(std::forward<Op>(op)), tag);
+  return internal::ToVector<T>(output);
+}
+
+template <typename T, typename Op>
+std::vector<T> ReduceScatter(const std::shared_ptr<Context>& ctx,
+                             absl::Span<const T> input, Op&& op,
+                             std::string_view tag) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  auto output = ReduceScatter(
+      ctx, ByteContainerView(input.data(), input.size() * sizeof(T)),
+      sizeof(T), internal::MakeReduceFn<T>(std::forward<Op>(op)), tag);
+  return internal::ToVector<T>(output);
+}
+
+}  // namespace yasl::link
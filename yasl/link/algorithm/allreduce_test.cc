@@ -0,0 +1,116 @@
+// Copyright 2019 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/algorithm/allreduce.h"
+
+#include <functional>
+#include <future>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/int128.h"
+#include "yasl/link/test_util.h"
+
+namespace yasl::link::test {
+
+struct TestParams {
+  size_t world_size;
+  size_t num_elems;
+};
+
+class AllReduceTest : public ::testing::TestWithParam<TestParams> {};
+
+static std::vector<uint128_t> MakeInput(size_t rank, size_t num_elems) {
+  std::vector<uint128_t> input(num_elems);
+  for (size_t idx = 0; idx < num_elems; idx++) {
+    input[idx] = MakeUint128(rank * 7 + idx, ~(rank + idx * 3));
+  }
+  return input;
+}
+
+TEST_P(AllReduceTest, AddWorks) {
+  const size_t world_size = GetParam().world_size;
+  const size_t num_elems = GetParam().num_elems;
+  auto contexts = SetupWorld(world_size);
+
+  std::vector<uint128_t> expected(num_elems, 0);
+  for (size_t rank = 0; rank < world_size; rank++) {
+    auto input = MakeInput(rank, num_elems);
+    for (size_t idx = 0; idx < num_elems; idx++) {
+      expected[idx] += input[idx];
+    }
+  }
+
+  auto proc = [&](const std::shared_ptr<Context>& ctx) {
+    const auto input = MakeInput(ctx->Rank(), num_elems);
+    auto output = AllReduce<uint128_t>(ctx, input, std::plus<uint128_t>(),
+                                       "test");
+    EXPECT_EQ(output, expected);
+  };
+
+  std::vector<std::future<void>> jobs(world_size);
+  for (size_t rank = 0; rank < world_size; rank++) {
+    jobs[rank] = std::async(proc, contexts[rank]);
+  }
+
+  for (size_t rank = 0; rank < world_size; rank++) {
+    jobs[rank].get();
+  }
+}
+
+TEST_P(AllReduceTest, ReduceScatterXorWorks) {
+  const size_t world_size = GetParam().world_size;
+  const size_t num_elems = GetParam().num_elems;
+  auto contexts = SetupWorld(world_size);
+
+  std::vector<uint128_t> expected(num_elems, 0);
+  for (size_t rank = 0; rank < world_size; rank++) {
+    auto input = MakeInput(rank, num_elems);
+    for (size_t idx = 0; idx < num_elems; idx++) {
+      expected[idx] ^= input[idx];
+    }
+  }
+
+  auto proc = [&](const std::shared_ptr<Context>& ctx) {
+    const auto input = MakeInput(ctx->Rank(), num_elems);
+    auto output = ReduceScatter<uint128_t>(
+        ctx, input, std::bit_xor<uint128_t>(), "test");
+
+    const size_t segment = (num_elems + world_size - 1) / world_size;
+    const size_t begin = std::min(ctx->Rank() * segment, num_elems);
+    const size_t end = std::min(begin + segment, num_elems);
+    EXPECT_EQ(output, std::vector<uint128_t>(expected.begin() + begin,
+                                             expected.begin() + end));
+  };
+
+  std::vector<std::future<void>> jobs(world_size);
+  for (size_t rank = 0; rank < world_size; rank++) {
+    jobs[rank] = std::async(proc, contexts[rank]);
+  }
+
+  for (size_t rank = 0; rank < world_size; rank++) {
+    jobs[rank].get();
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Works_Instances, AllReduceTest,
+                         testing::Values(TestParams{2, 0},     //
+                                         TestParams{2, 1},     //
+                                         TestParams{3, 2},     //
+                                         TestParams{3, 1000},  //
+                                         TestParams{9, 7},     //
+                                         TestParams{9, 1001}   //
+                                         ));
+
+}  // namespace yasl::link::test
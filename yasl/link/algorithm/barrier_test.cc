@@ -64,9 +64,37 @@ TEST_P(BarrierTest, Works) {
   }
 }
 
+TEST_P(BarrierTest, LogRounds) {
+  const size_t world_size = GetParam().world_size;
+  auto contexts = SetupWorld(world_size);
+
+  size_t rounds = 0;
+  while ((size_t(1) << rounds) < world_size) {
+    rounds++;
+  }
+
+  auto proc = [&](const std::shared_ptr<Context>& ctx) {
+    const size_t sent_before = ctx->GetStats()->sent_actions;
+    Barrier(ctx, "test_tag");
+    // one msg per round, n * ceil(log2(n)) msgs in total.
+    EXPECT_EQ(ctx->GetStats()->sent_actions - sent_before, rounds);
+  };
+
+  std::vector<std::future<void>> jobs(world_size);
+  for (size_t rank = 0; rank < world_size; rank++) {
+    jobs[rank] = std::async(proc, contexts[rank]);
+  }
+
+  for (size_t rank = 0; rank < world_size; rank++) {
+    jobs[rank].get();
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(Works_Instances, BarrierTest,
                          testing::Values(TestParams{2, 20},  //
                                          TestParams{3, 20},  //
+                                         TestParams{5, 20},  //
+                                         TestParams{8, 20},  //
                                          TestParams{9, 20}   //
                                          ));
 
@@ -14,6 +14,9 @@
 
 #include "yasl/link/algorithm/broadcast.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "absl/numeric/bits.h"
 #include "fmt/format.h"
 
@@ -25,10 +28,42 @@ namespace {
 
 const char* kType = "BCAST";
 
+// payloads this large are scattered down the tree, then gathered by a ring,
+// so that no rank sends more than about twice the payload.
+constexpr size_t kScatterMinSize = 512 * 1024;
+
+enum class Mode : uint8_t {
+  kWhole = 0,
+  kScatter = 1,
+};
+
+// every tree msg ends with a trailer, [u64 total_size][u8 mode], which tells
+// receivers how the payload is broadcast.
+constexpr size_t kTrailerSize = sizeof(uint64_t) + sizeof(uint8_t);
+
+Buffer WithTrailer(ByteContainerView data, Mode mode, size_t total_size) {
+  Buffer msg(static_cast<int64_t>(data.size() + kTrailerSize));
+  auto* ptr = msg.data<uint8_t>();
+  if (!data.empty()) {
+    std::memcpy(ptr, data.data(), data.size());
+  }
+  const uint64_t total = total_size;
+  std::memcpy(ptr + data.size(), &total, sizeof(total));
+  ptr[data.size() + sizeof(total)] = static_cast<uint8_t>(mode);
+  return msg;
+}
+
 size_t RingOffset(size_t begin, size_t end, size_t size) {
   return (end - begin + size) % size;
 }
 
+// byte offset of the segment of `vrank`, the payload is cut into world_size
+// nearly equal segments.
+size_t SegmentBegin(size_t vrank, size_t total_size, size_t world_size) {
+  const size_t segment_size = (total_size + world_size - 1) / world_size;
+  return std::min(vrank * segment_size, total_size);
+}
+
 }  // namespace
 
 Buffer Broadcast(const std::shared_ptr<Context>& ctx, ByteContainerView input,
@@ -41,34 +76,104 @@ Buffer Broadcast(const std::shared_ptr<Context>& ctx, ByteContainerView input,
   // |-A-|---|---|---|-A-|---| level 1, 0=>4
   // |-A-|---|-B-|---|-A-|---| level 2, 0=>2, (4=>6)
   // |-A-|-C-|-B-|-C-|-A-|-C-| level 3, 0=>1, 2=>3, 4=>5
+  //
+  // Large payloads are cut into one segment per node, and each node only
+  // receives the segments of its own subtree, then the segments are gathered
+  // by a ring. (see: van de Geijn, scatter-allgather broadcast)
 
   const auto event = fmt::format("{}:{}", ctx->NextId(), kType);
-  Buffer output = input;
+  const size_t world_size = ctx->WorldSize();
 
   TraceLogger::LinkTrace(event, tag, input);
 
   // The algorithm writes in virtual rank space, (which take root as rank 0).
   // But the actual Send/Recv rank is constructed in physical rank space.
-  const size_t vrank = RingOffset(root, ctx->Rank(), ctx->WorldSize());
+  const size_t vrank = RingOffset(root, ctx->Rank(), world_size);
+
+  // the payload this node holds, root holds all, other nodes hold the
+  // segments of its subtree, starting from its own segment.
+  Buffer msg;
+  ByteContainerView payload = input;
+  Mode mode = Mode::kWhole;
+  size_t total_size = input.size();
+  if (vrank == 0 && world_size > 2 && input.size() >= kScatterMinSize) {
+    mode = Mode::kScatter;
+  }
+
   bool received = (vrank == 0);
-  for (size_t stride = absl::bit_floor(ctx->WorldSize()); stride > 0;
+  for (size_t stride = absl::bit_floor(world_size); stride > 0;
        stride >>= 1) {
     if (!received) {
       if (vrank % stride) {
         // waiting for my turn.
         continue;
       }
-      output = ctx->RecvInternal(ctx->PrevRank(stride), event);
+      msg = ctx->RecvInternal(ctx->PrevRank(stride), event);
+      YASL_ENFORCE(msg.size() >= static_cast<int64_t>(kTrailerSize));
+      const auto* trailer = msg.data<uint8_t>() + msg.size() - kTrailerSize;
+      uint64_t total = 0;
+      std::memcpy(&total, trailer, sizeof(total));
+      total_size = total;
+      mode = static_cast<Mode>(trailer[sizeof(total)]);
+      payload = ByteContainerView(msg.data<uint8_t>(),
+                                  msg.size() - kTrailerSize);
       received = true;
 
-    } else {
-      if (vrank + stride < ctx->WorldSize()) {
-        ctx->SendAsyncInternal(ctx->NextRank(stride), event, output);
+    } else if (vrank + stride < world_size) {
+      if (mode == Mode::kWhole) {
+        if (msg.size() == 0) {
+          // msg of root, received msgs are forwarded as is.
+          msg = WithTrailer(payload, mode, total_size);
+        }
+        ctx->SendAsyncInternal(ctx->NextRank(stride), event, msg);
+        continue;
       }
+
+      // segments of the child's subtree, [child, child + stride).
+      const size_t child = vrank + stride;
+      const size_t begin = SegmentBegin(child, total_size, world_size);
+      const size_t end = SegmentBegin(std::min(child + stride, world_size),
+                                      total_size, world_size);
+      const size_t offset = SegmentBegin(vrank, total_size, world_size);
+      ctx->SendAsyncInternal(
+          ctx->NextRank(stride), event,
+          WithTrailer(payload.subspan(begin - offset, end - begin), mode,
+                      total_size));
     }
   }
 
+  if (mode == Mode::kWhole) {
+    return Buffer(payload.data(), payload.size());
+  }
+
+  Buffer output(static_cast<int64_t>(total_size));
+  auto* output_ptr = output.data<uint8_t>();
+  std::memcpy(output_ptr + SegmentBegin(vrank, total_size, world_size),
+              payload.data(), payload.size());
+
+  // ring allgather of segments, in round r, each node passes the segment
+  // of (vrank - r) to the next node.
+  for (size_t round = 0; round + 1 < world_size; round++) {
+    // one key per round, since all rounds talk to the same peers.
+    const auto round_event = fmt::format("{}:{}", event, round);
+    const size_t send_seg = (vrank + world_size - round) % world_size;
+    const size_t send_begin = SegmentBegin(send_seg, total_size, world_size);
+    const size_t send_end = SegmentBegin(send_seg + 1, total_size, world_size);
+    ctx->SendAsyncInternal(
+        ctx->NextRank(), round_event,
+        ByteContainerView(output_ptr + send_begin, send_end - send_begin));
+
+    const size_t recv_seg = (vrank + world_size - round - 1) % world_size;
+    const size_t recv_begin = SegmentBegin(recv_seg, total_size, world_size);
+    const size_t recv_end = SegmentBegin(recv_seg + 1, total_size, world_size);
+    auto segment = ctx->RecvInternal(ctx->PrevRank(), round_event);
+    YASL_ENFORCE(segment.size() == static_cast<int64_t>(recv_end - recv_begin),
+                 "segment size mismatch, expect {}, got {}",
+                 recv_end - recv_begin, segment.size());
+    std::memcpy(output_ptr + recv_begin, segment.data(), segment.size());
+  }
+
   return output;
-}  // namespace link
+}
 
 }  // namespace yasl::link
@@ -54,6 +54,37 @@ TEST_P(BroadcastTest, Works) {
   }
 }
 
+TEST_P(BroadcastTest, LargeWorks) {
+  const size_t world_size = GetParam().world_size;
+  auto contexts = SetupWorld(world_size);
+
+  // large enough to be scattered, and not a multiple of world size.
+  std::string data(1024 * 1024 + 7, 0);
+  for (size_t idx = 0; idx < data.size(); idx++) {
+    data[idx] = static_cast<char>(idx * 31 + idx / 256);
+  }
+
+  auto proc = [&](const std::shared_ptr<Context>& ctx) {
+    for (size_t root : {size_t(0), world_size - 1}) {
+      auto input = ctx->Rank() == root ? Buffer(data.data(), data.size())
+                                       : Buffer();
+
+      auto output = Broadcast(ctx, input, root, "test");
+
+      EXPECT_EQ(std::string_view(output), data);
+    }
+  };
+
+  std::vector<std::future<void>> jobs(world_size);
+  for (size_t rank = 0; rank < world_size; rank++) {
+    jobs[rank] = std::async(proc, contexts[rank]);
+  }
+
+  for (size_t rank = 0; rank < world_size; rank++) {
+    jobs[rank].get();
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(Works_Instances, BroadcastTest,
                          testing::Values(TestParams{2},  //
                                          TestParams{3},  //
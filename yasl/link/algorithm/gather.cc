@@ -36,13 +36,20 @@ std::vector<Buffer> GatherImpl(const std::shared_ptr<Context>& ctx,
 
   if (root == ctx->Rank()) {
     res.resize(ctx->WorldSize());
+    std::vector<std::pair<size_t, std::string>> sources;
     for (size_t idx = 0; idx < ctx->WorldSize(); idx++) {
       if (idx == ctx->Rank()) {
         res[idx] = Buffer(std::forward<ValueType>(input));
       } else {
-        res[idx] = ctx->RecvInternal(idx, event);
+        sources.emplace_back(idx, event);
       }
     }
+    // in arrival order, stragglers never delay taking arrived msgs.
+    while (!sources.empty()) {
+      auto [idx, value] = ctx->RecvAnyInternal(sources);
+      res[sources[idx].first] = std::move(value);
+      sources.erase(sources.begin() + idx);
+    }
   } else {
     ctx->SendAsyncInternal(root, event, std::forward<ValueType>(input));
   }
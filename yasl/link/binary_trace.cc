@@ -0,0 +1,263 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/binary_trace.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "fmt/format.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/utils/hash.h"
+
+namespace yasl::link {
+namespace {
+
+constexpr char kMagic[4] = {'Y', 'L', 'T', 'R'};
+constexpr uint32_t kVersion = 1;
+
+struct FileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t reserved;
+};
+
+std::atomic<uint64_t> gLoggerId = 0;
+
+size_t RoundUpPowerOf2(size_t n) {
+  size_t p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return {};
+  }
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+std::string JsonEscape(std::string_view str) {
+  std::string out;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+      out.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out += fmt::format("\\u{:04x}", static_cast<int>(c));
+    } else {
+      out.push_back(c);
+    }
+  }
+  return out;
+}
+
+}  // namespace
+
+// single producer, the owner thread, and single consumer, the flusher.
+struct BinaryTraceLogger::Ring {
+  Ring(size_t capacity, uint32_t _thread_id)
+      : records(new BinaryTraceRecord[capacity]),
+        mask(capacity - 1),
+        thread_id(_thread_id) {}
+
+  std::unique_ptr<BinaryTraceRecord[]> records;
+  const size_t mask;
+  const uint32_t thread_id;
+  std::atomic<size_t> head = 0;
+  std::atomic<size_t> tail = 0;
+  // tags whose names are written, touched by the owner thread only.
+  std::unordered_set<uint64_t> named_tags;
+};
+
+BinaryTraceLogger::BinaryTraceLogger(const std::string& path, uint32_t rank,
+                                     size_t ring_capacity,
+                                     size_t flush_interval_ms)
+    : id_(++gLoggerId),
+      rank_(rank),
+      ring_capacity_(RoundUpPowerOf2(ring_capacity)),
+      flush_interval_ms_(flush_interval_ms) {
+  records_file_ = std::fopen(path.c_str(), "wb");
+  names_file_ = std::fopen((path + ".names").c_str(), "wb");
+  if (records_file_ == nullptr || names_file_ == nullptr) {
+    if (records_file_ != nullptr) {
+      std::fclose(records_file_);
+    }
+    if (names_file_ != nullptr) {
+      std::fclose(names_file_);
+    }
+    YASL_THROW_IO_ERROR("open trace file {} failed, errno={}", path, errno);
+  }
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.record_size = sizeof(BinaryTraceRecord);
+  std::fwrite(&header, sizeof(header), 1, records_file_);
+
+  flusher_ = std::thread([this] { FlushLoop(); });
+}
+
+BinaryTraceLogger::~BinaryTraceLogger() {
+  {
+    std::unique_lock lock(mutex_);
+    stopped_ = true;
+  }
+  stop_cond_.notify_all();
+  flusher_.join();
+  Flush();
+  std::fclose(records_file_);
+  std::fclose(names_file_);
+}
+
+BinaryTraceLogger::Ring* BinaryTraceLogger::ThreadRing() {
+  thread_local uint64_t cached_id = 0;
+  thread_local Ring* cached_ring = nullptr;
+  if (cached_id != id_) {
+    std::unique_lock lock(mutex_);
+    rings_.push_back(std::make_unique<Ring>(
+        ring_capacity_, static_cast<uint32_t>(rings_.size())));
+    cached_ring = rings_.back().get();
+    cached_id = id_;
+  }
+  return cached_ring;
+}
+
+void BinaryTraceLogger::LinkTraceImpl(std::string_view event,
+                                      std::string_view tag,
+                                      std::string_view content) {
+  auto* ring = ThreadRing();
+  const uint64_t tag_hash = utils::fnv1a_hash(tag);
+  if (ring->named_tags.insert(tag_hash).second) {
+    std::unique_lock lock(mutex_);
+    const auto length = static_cast<uint32_t>(tag.size());
+    std::fwrite(&tag_hash, sizeof(tag_hash), 1, names_file_);
+    std::fwrite(&length, sizeof(length), 1, names_file_);
+    std::fwrite(tag.data(), 1, tag.size(), names_file_);
+  }
+
+  const size_t head = ring->head.load(std::memory_order_relaxed);
+  if (head - ring->tail.load(std::memory_order_acquire) > ring->mask) {
+    dropped_++;
+    return;
+  }
+  auto& record = ring->records[head & ring->mask];
+  record.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+  record.event_hash = utils::fnv1a_hash(event);
+  record.tag_hash = tag_hash;
+  record.size = content.size();
+  record.rank = rank_;
+  record.thread_id = ring->thread_id;
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+void BinaryTraceLogger::Flush() {
+  std::vector<Ring*> rings;
+  {
+    std::unique_lock lock(mutex_);
+    for (const auto& ring : rings_) {
+      rings.push_back(ring.get());
+    }
+    std::fflush(names_file_);
+  }
+
+  std::unique_lock lock(flush_mutex_);
+  for (auto* ring : rings) {
+    const size_t tail = ring->tail.load(std::memory_order_relaxed);
+    const size_t head = ring->head.load(std::memory_order_acquire);
+    // the ready records may wrap around the end of the ring.
+    for (size_t pos = tail; pos < head;) {
+      const size_t begin = pos & ring->mask;
+      const size_t count = std::min(head - pos, ring->mask + 1 - begin);
+      std::fwrite(&ring->records[begin], sizeof(BinaryTraceRecord), count,
+                  records_file_);
+      pos += count;
+    }
+    ring->tail.store(head, std::memory_order_release);
+  }
+  std::fflush(records_file_);
+}
+
+void BinaryTraceLogger::FlushLoop() {
+  std::unique_lock lock(mutex_);
+  while (!stopped_) {
+    stop_cond_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms_),
+                        [this] { return stopped_; });
+    lock.unlock();
+    Flush();
+    lock.lock();
+  }
+}
+
+std::string DecodeBinaryTrace(const std::vector<std::string>& paths) {
+  std::string out = "{\"traceEvents\":[";
+  bool first = true;
+  for (const auto& path : paths) {
+    std::unordered_map<uint64_t, std::string> names;
+    const auto names_data = ReadFile(path + ".names");
+    for (size_t pos = 0; pos + 12 <= names_data.size();) {
+      uint64_t hash = 0;
+      uint32_t length = 0;
+      std::memcpy(&hash, names_data.data() + pos, sizeof(hash));
+      std::memcpy(&length, names_data.data() + pos + 8, sizeof(length));
+      pos += 12;
+      if (pos + length > names_data.size()) {
+        break;
+      }
+      names.emplace(hash, names_data.substr(pos, length));
+      pos += length;
+    }
+
+    const auto data = ReadFile(path);
+    FileHeader header{};
+    YASL_ENFORCE(data.size() >= sizeof(header), "invalid trace file {}", path);
+    std::memcpy(&header, data.data(), sizeof(header));
+    YASL_ENFORCE(std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                     header.version == kVersion &&
+                     header.record_size == sizeof(BinaryTraceRecord),
+                 "invalid trace file {}", path);
+
+    for (size_t pos = sizeof(header);
+         pos + sizeof(BinaryTraceRecord) <= data.size();
+         pos += sizeof(BinaryTraceRecord)) {
+      BinaryTraceRecord record;
+      std::memcpy(&record, data.data() + pos, sizeof(record));
+      auto itr = names.find(record.tag_hash);
+      const std::string name = itr == names.end()
+                                   ? fmt::format("{:016x}", record.tag_hash)
+                                   : JsonEscape(itr->second);
+      out += fmt::format(
+          "{}{{\"name\":\"{}\",\"ph\":\"i\",\"s\":\"t\",\"ts\":{:.3f},"
+          "\"pid\":{},\"tid\":{},\"args\":{{\"key\":\"{:016x}\","
+          "\"size\":{}}}}}",
+          first ? "" : ",", name,
+          static_cast<double>(record.timestamp_ns) / 1000, record.rank,
+          record.thread_id, record.event_hash, record.size);
+      first = false;
+    }
+  }
+  out += "]}\n";
+  return out;
+}
+
+}  // namespace yasl::link
@@ -0,0 +1,109 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "yasl/link/trace.h"
+
+namespace yasl::link {
+
+// A fixed size trace record, written to disk as is.
+struct BinaryTraceRecord {
+  // system clock, so that traces of parties can be merged.
+  uint64_t timestamp_ns;
+  // fnv1a hash of the msg key, which is the same on both ends of a msg.
+  uint64_t event_hash;
+  // fnv1a hash of the tag, names are written aside, see BinaryTraceLogger.
+  uint64_t tag_hash;
+  uint64_t size;
+  uint32_t rank;
+  // sequence number of the writer thread inside the process.
+  uint32_t thread_id;
+};
+static_assert(sizeof(BinaryTraceRecord) == 40);
+
+// Writes link events as binary records into per-thread lock-free rings, a
+// background thread flushes them into `path`, so that tracing costs a few
+// hundred nanoseconds per msg. Events are dropped if a ring is full.
+//
+// `path` holds a small header followed by the records, and tag names are
+// appended to `path`.names on first sight, decode them by
+// DecodeBinaryTrace or the binary_trace_decode tool.
+class BinaryTraceLogger : public TraceLogger {
+ public:
+  // `ring_capacity` is the number of records of each ring, rounded up to a
+  // power of 2.
+  BinaryTraceLogger(const std::string& path, uint32_t rank,
+                    size_t ring_capacity = 1 << 16,
+                    size_t flush_interval_ms = 100);
+
+  ~BinaryTraceLogger() override;
+
+  // records lost due to full rings.
+  size_t DroppedRecords() const { return dropped_; }
+
+  // flush all rings now.
+  void Flush();
+
+ protected:
+  void LinkTraceImpl(std::string_view event, std::string_view tag,
+                     std::string_view content) override;
+
+ private:
+  struct Ring;
+
+  Ring* ThreadRing();
+
+  void FlushLoop();
+
+  // unique id of this logger, to tell apart the thread local rings of
+  // loggers which happen to share an address.
+  const uint64_t id_;
+  const uint32_t rank_;
+  const size_t ring_capacity_;
+  const size_t flush_interval_ms_;
+
+  std::FILE* records_file_ = nullptr;
+  std::FILE* names_file_ = nullptr;
+
+  // guards rings_ registration and the names file.
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Ring>> rings_;
+  // serializes flushes of the loop thread and callers of Flush.
+  std::mutex flush_mutex_;
+
+  std::atomic<size_t> dropped_ = 0;
+
+  bool stopped_ = false;
+  std::condition_variable stop_cond_;
+  std::thread flusher_;
+};
+
+// Chrome trace (chrome://tracing, perfetto) json of traces written by
+// BinaryTraceLogger, possibly of several parties. records are instant
+// events, named by tag, with party rank as pid and writer thread as tid.
+std::string DecodeBinaryTrace(const std::vector<std::string>& paths);
+
+}  // namespace yasl::link
@@ -0,0 +1,36 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Decodes traces of BinaryTraceLogger into a chrome trace json.
+//
+// usage: binary_trace_decode <output.json> <trace_file>...
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "yasl/link/binary_trace.h"
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " <output.json> <trace_file>..."
+              << std::endl;
+    return 1;
+  }
+  std::vector<std::string> paths(argv + 2, argv + argc);
+  std::ofstream out(argv[1]);
+  out << yasl::link::DecodeBinaryTrace(paths);
+  return out.good() ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/binary_trace.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+namespace yasl::link::test {
+
+class BinaryTraceLoggerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const auto* test = ::testing::UnitTest::GetInstance()->current_test_info();
+    path_ = (std::filesystem::temp_directory_path() /
+             fmt::format("{}-{}.trace", test->name(), getpid()))
+                .string();
+  }
+
+  void TearDown() override {
+    std::filesystem::remove(path_);
+    std::filesystem::remove(path_ + ".names");
+  }
+
+  static size_t CountOf(const std::string& str, const std::string& part) {
+    size_t count = 0;
+    for (size_t pos = str.find(part); pos != std::string::npos;
+         pos = str.find(part, pos + 1)) {
+      count++;
+    }
+    return count;
+  }
+
+  std::string path_;
+};
+
+class TestableBinaryTraceLogger : public BinaryTraceLogger {
+ public:
+  using BinaryTraceLogger::BinaryTraceLogger;
+
+  void Trace(std::string_view event, std::string_view tag,
+             std::string_view content) {
+    LinkTraceImpl(event, tag, content);
+  }
+};
+
+TEST_F(BinaryTraceLoggerTest, DecodeShouldOk) {
+  // GIVEN
+  {
+    TestableBinaryTraceLogger logger(path_, 3, 1024, 1);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 2; t++) {
+      threads.emplace_back([&, t] {
+        for (size_t i = 0; i < 100; i++) {
+          logger.Trace(fmt::format("root:{}", i), t == 0 ? "IKNP" : "tag\"x",
+                       "value");
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(logger.DroppedRecords(), 0);
+  }
+
+  // WHEN
+  const auto json = DecodeBinaryTrace({path_});
+
+  // THEN
+  EXPECT_EQ(json.rfind("{\"traceEvents\":[", 0), 0);
+  EXPECT_EQ(CountOf(json, "\"name\":\"IKNP\""), 100);
+  EXPECT_EQ(CountOf(json, "\"name\":\"tag\\\"x\""), 100);
+  EXPECT_EQ(CountOf(json, "\"pid\":3"), 200);
+  EXPECT_EQ(CountOf(json, "\"size\":5"), 200);
+}
+
+TEST_F(BinaryTraceLoggerTest, FullRingShouldDrop) {
+  // GIVEN
+  TestableBinaryTraceLogger logger(path_, 0, 8, 1000000);
+
+  // WHEN
+  for (size_t i = 0; i < 20; i++) {
+    logger.Trace(fmt::format("root:{}", i), "tag", "");
+  }
+  logger.Flush();
+  logger.Trace("root:20", "tag", "");
+  logger.Flush();
+
+  // THEN
+  EXPECT_EQ(logger.DroppedRecords(), 12);
+  EXPECT_EQ(CountOf(DecodeBinaryTrace({path_}), "\"name\":\"tag\""), 9);
+}
+
+}  // namespace yasl::link::test
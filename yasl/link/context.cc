@@ -14,29 +14,193 @@
 
 #include "yasl/link/context.h"
 
+#include <algorithm>
 #include <chrono>
+#include <future>
 #include <iostream>
+#include <random>
+#include <set>
 #include <thread>
 
 #include "fmt/format.h"
 #include "spdlog/spdlog.h"
 
 #include "yasl/base/exception.h"
+#include "yasl/base/memory_tracker.h"
 #include "yasl/link/trace.h"
+#include "yasl/utils/profiler.h"
 
 namespace yasl::link {
+namespace {
+
+uint64_t ElapsedUs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// bytes of the salt each party contributes to the session keys.
+constexpr size_t kLinkSaltSize = 16;
+
+// leading byte of compact keys, never used by formatted or reserved keys.
+constexpr char kCompactCollectiveKey = '\xfc';
+constexpr char kCompactP2PKey = '\xfd';
+
+// kind byte, little endian id hash, then varint counter. fits into the short
+// string buffer for counters below 2^42.
+std::string CompactKey(char kind, uint64_t id_hash, uint64_t counter) {
+  std::string key(1, kind);
+  for (size_t i = 0; i < sizeof(id_hash); i++) {
+    key.push_back(static_cast<char>(id_hash >> (8 * i)));
+  }
+  while (counter >= 0x80) {
+    key.push_back(static_cast<char>(counter | 0x80));
+    counter >>= 7;
+  }
+  key.push_back(static_cast<char>(counter));
+  return key;
+}
+
+// owns the notifier of a wait on keys of many channels, and unregisters it
+// from them when the wait is over, returned or thrown, so that the channels
+// do not keep it until the other keys arrive.
+class RecvWatch {
+ public:
+  RecvWatch() : notifier_(std::make_shared<RecvNotifier>()) {}
+
+  ~RecvWatch() {
+    for (const auto& [channel, key] : watched_) {
+      channel->Unwatch(*key, notifier_);
+    }
+  }
+
+  RecvWatch(const RecvWatch&) = delete;
+  RecvWatch& operator=(const RecvWatch&) = delete;
+
+  // IChannel::TryRecv, key must outlive the watch.
+  bool TryRecv(IChannel* channel, const std::string& key, Buffer* value) {
+    if (channel->TryRecv(key, value, notifier_)) {
+      return true;
+    }
+    watched_.emplace(channel, &key);
+    return false;
+  }
+
+  RecvNotifier& Notifier() { return *notifier_; }
+
+ private:
+  const std::shared_ptr<RecvNotifier> notifier_;
+  std::set<std::pair<IChannel*, const std::string*>> watched_;
+};
+
+}  // namespace
 
 std::ostream& operator<<(std::ostream& os, const Statistics& st) {
   os << "sent_bytes=" << st.sent_bytes       //
      << ",sent_actions=" << st.sent_actions  //
      << ",recv_bytes=" << st.recv_bytes      //
-     << ",recv_actions=" << st.recv_actions << std::endl;
+     << ",recv_actions=" << st.recv_actions        //
+     << ",throttled_sends=" << st.throttled_sends  //
+     << ",throttled_ms=" << st.throttled_ms        //
+     << ",unread_bytes=" << st.unread_bytes        //
+     << ",peak_unread_bytes=" << st.peak_unread_bytes << std::endl;
   return os;
 }
 
-void Context::PrintStats() { std::cout << *stats_; }
+void Context::PrintStats() {
+  std::cout << *GetStats() << MemoryUsageString() << std::endl;
+}
 
-std::shared_ptr<const Statistics> Context::GetStats() const { return stats_; }
+std::shared_ptr<const Statistics> Context::GetStats() const {
+  // channel side numbers, sub contexts share both channels and stats.
+  ChannelStats total;
+  for (const auto& l : channels_) {
+    if (l) {
+      const auto stats = l->GetStats();
+      total.throttled_sends += stats.throttled_sends;
+      total.throttled_ms += stats.throttled_ms;
+      total.unread_bytes += stats.unread_bytes;
+      total.peak_unread_bytes += stats.peak_unread_bytes;
+    }
+  }
+  stats_->throttled_sends = total.throttled_sends;
+  stats_->throttled_ms = total.throttled_ms;
+  stats_->unread_bytes = total.unread_bytes;
+  stats_->peak_unread_bytes = total.peak_unread_bytes;
+  return stats_;
+}
+
+StatisticsSnapshot Context::SnapshotStats() const {
+  auto copy = [](const Statistics::Traffic& traffic) {
+    return StatisticsSnapshot::Traffic{traffic.sent_size.Snapshot(),
+                                       traffic.recv_size.Snapshot(),
+                                       traffic.recv_wait_us.Snapshot()};
+  };
+  StatisticsSnapshot snapshot;
+  for (size_t rank = 0; rank < WorldSize(); rank++) {
+    if (rank == rank_) {
+      continue;
+    }
+    StatisticsSnapshot::Peer peer;
+    peer.rank = rank;
+    peer.traffic = copy(stats_->peers[rank]);
+    peer.channel = channels_[rank]->GetStats();
+    snapshot.peers.push_back(std::move(peer));
+  }
+  std::unique_lock lock(stats_->tags_mutex);
+  for (const auto& [prefix, traffic] : stats_->tags) {
+    snapshot.tags.emplace(prefix, copy(*traffic));
+  }
+  return snapshot;
+}
+
+std::string StatisticsSnapshot::ToPrometheus() const {
+  std::string out;
+  auto export_metric = [&](std::string_view name, auto&& get) {
+    out += fmt::format("# TYPE yasl_link_{} histogram\n", name);
+    for (const auto& peer : peers) {
+      out += get(peer).ToPrometheus(fmt::format("yasl_link_{}", name),
+                                    fmt::format("peer=\"{}\"", peer.rank));
+    }
+  };
+  auto export_traffic = [&](std::string_view name, auto member) {
+    export_metric(name,
+                  [&](const Peer& peer) { return peer.traffic.*member; });
+    for (const auto& [prefix, traffic] : tags) {
+      out += (traffic.*member)
+                 .ToPrometheus(fmt::format("yasl_link_{}", name),
+                               fmt::format("tag=\"{}\"", prefix));
+    }
+  };
+  export_traffic("sent_size_bytes", &Traffic::sent_size);
+  export_traffic("recv_size_bytes", &Traffic::recv_size);
+  export_traffic("recv_wait_us", &Traffic::recv_wait_us);
+  export_metric("ack_latency_us",
+                [](const Peer& peer) { return peer.channel.ack_latency_us; });
+  export_metric("throttle_wait_us", [](const Peer& peer) {
+    return peer.channel.throttle_wait_us;
+  });
+  export_metric("recv_chunks",
+                [](const Peer& peer) { return peer.channel.recv_chunks; });
+  return out;
+}
+
+Statistics::Traffic* Context::TagStats(std::string_view tag) {
+  if (!desc_.stats_by_tag) {
+    return nullptr;
+  }
+  const auto prefix = tag.substr(0, tag.find(':'));
+  std::unique_lock lock(stats_->tags_mutex);
+  auto itr = stats_->tags.find(prefix);
+  if (itr == stats_->tags.end()) {
+    itr = stats_->tags
+              .emplace(std::string(prefix),
+                       std::make_unique<Statistics::Traffic>())
+              .first;
+  }
+  // never erased, safe to use without the lock.
+  return itr->second.get();
+}
 
 Context::Context(ContextDesc desc, size_t rank,
                  std::vector<std::shared_ptr<IChannel>> channels,
@@ -55,13 +219,11 @@ Context::Context(ContextDesc desc, size_t rank,
                "channels lenth={} does not match world_size={}",
                channels_.size(), world_size);
 
-  for (size_t src = 0; src < world_size; ++src) {
-    for (size_t dst = 0; dst < world_size; ++dst) {
-      p2p_counter_[std::make_pair(src, dst)] = 0U;
-    }
-  }
+  p2p_counter_.resize(world_size * world_size, 0);
+  id_hash_ = utils::fnv1a_hash(desc_.id);
 
   stats_ = std::make_shared<Statistics>();
+  stats_->peers = std::vector<Statistics::Traffic>(world_size);
 }
 
 std::string Context::Id() const { return desc_.id; }
@@ -86,9 +248,74 @@ void Context::SetThrottleWindowSize(size_t w) {
   }
 }
 
+void Context::SetAckBatchSize(size_t n) {
+  for (const auto& l : channels_) {
+    if (l) {
+      l->SetAckBatchSize(n);
+    }
+  }
+}
+
+void Context::SetThrottleWindowBytes(size_t bytes) {
+  for (const auto& l : channels_) {
+    if (l) {
+      l->SetThrottleWindowBytes(bytes);
+    }
+  }
+}
+
+void Context::SetRecvBufferLimit(size_t bytes) {
+  for (const auto& l : channels_) {
+    if (l) {
+      l->SetRecvBufferLimit(bytes);
+    }
+  }
+}
+
+void Context::BeginBatch() {
+  batching_ = true;
+  batch_msgs_.resize(WorldSize());
+}
+
+void Context::FlushBatch() {
+  batching_ = false;
+  for (size_t rank = 0; rank < batch_msgs_.size(); rank++) {
+    if (!batch_msgs_[rank].empty()) {
+      channels_[rank]->SendAsyncBatch(std::move(batch_msgs_[rank]));
+      batch_msgs_[rank].clear();
+    }
+  }
+}
+
+BatchGuard::BatchGuard(std::shared_ptr<Context> ctx)
+    : ctx_(std::move(ctx)), owned_(!ctx_->IsBatching()) {
+  if (owned_) {
+    ctx_->BeginBatch();
+  }
+}
+
+BatchGuard::~BatchGuard() {
+  if (!owned_) {
+    return;
+  }
+  try {
+    ctx_->FlushBatch();
+  } catch (const std::exception& e) {
+    SPDLOG_ERROR("flush batch failed: {}", e.what());
+  }
+}
+
+void BatchGuard::Flush() {
+  if (owned_) {
+    ctx_->FlushBatch();
+    ctx_->BeginBatch();
+  }
+}
+
 void Context::WaitLinkTaskFinish() {
   YASL_ENFORCE(is_sub_world_ == false,
                "DO NOT call WaitLinkTaskFinish on sub world link");
+  FlushBatch();
   for (const auto& l : channels_) {
     if (l) {
       l->WaitLinkTaskFinish();
@@ -101,45 +328,80 @@ void Context::ConnectToMesh() {
 
   SPDLOG_DEBUG("connecting to mesh, id={}, self={}", Id(), Rank());
 
-  auto try_connect = [&](size_t rank, const std::string& event,
-                         size_t /*attempt*/) {
-    try {
-      SendInternal(rank, event, {});
-    } catch (const NetworkError& e) {
-      SPDLOG_DEBUG("attempt={} to connect to rank={} error={}", attempt, rank,
-                   e.what());
-      return false;
-    }
-    return true;
-  };
-
-  // broadcast to all
-  for (size_t idx = 0; idx < WorldSize(); idx++) {
-    if (idx == Rank()) {
-      continue;
+  // the connect msg carries our salt of the session keys if links are
+  // encrypted, salts are public but should never repeat.
+  std::string salt;
+  if (!desc_.link_psk.empty()) {
+    std::random_device rd;
+    salt.resize(kLinkSaltSize);
+    for (auto& c : salt) {
+      c = static_cast<char>(rd());
     }
+  }
 
-    bool succeed = false;
+  using Clock = std::chrono::steady_clock;
+  const auto start = Clock::now();
+  const auto deadline =
+      desc_.connect_timeout_ms == 0
+          ? Clock::time_point::max()
+          : start + std::chrono::milliseconds(desc_.connect_timeout_ms);
+
+  // returns whether peer is ready, retried with jittered exponential backoff.
+  auto try_connect = [&](size_t rank) {
+    std::mt19937 rng(std::random_device{}());
+    size_t interval_ms = desc_.connect_retry_interval_ms;
     for (size_t attempt = 0; attempt < desc_.connect_retry_times + 1;
          attempt++) {
       if (attempt != 0) {
-        // sleep and retry.
+        // sleep a random time of [interval/2, interval], so that parties
+        // started together do not retry in lockstep.
+        const size_t sleep_ms = std::uniform_int_distribution<size_t>(
+            interval_ms / 2, interval_ms)(rng);
+        if (Clock::now() + std::chrono::milliseconds(sleep_ms) > deadline) {
+          break;
+        }
         SPDLOG_DEBUG(
             "try_connect to rank {} not succeed, sleep_for {}ms and retry.",
-            idx, desc_.connect_retry_interval_ms);
-        std::this_thread::sleep_for(
-            std::chrono::milliseconds(desc_.connect_retry_interval_ms));
+            rank, sleep_ms);
+        std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+        interval_ms = std::min<size_t>(interval_ms * 2,
+                                       desc_.connect_max_retry_interval_ms);
       }
-      if (try_connect(idx, event, attempt)) {
-        succeed = true;
-        break;
+      try {
+        SendInternal(rank, event, salt);
+      } catch (const NetworkError& e) {
+        SPDLOG_DEBUG("attempt={} to connect to rank={} error={}", attempt,
+                     rank, e.what());
+        continue;
       }
+      SPDLOG_DEBUG("rank={} ready after attempts={}, elapsed={}ms", rank,
+                   attempt + 1,
+                   std::chrono::duration_cast<std::chrono::milliseconds>(
+                       Clock::now() - start)
+                       .count());
+      return true;
     }
+    return false;
+  };
 
-    if (!succeed) {
-      YASL_THROW(
-          "connect to mesh failed, failed to setup connection to rank={}", idx);
+  // broadcast to all, startup time is bounded by the slowest peer.
+  std::vector<std::future<bool>> futures(WorldSize());
+  for (size_t idx = 0; idx < WorldSize(); idx++) {
+    if (idx == Rank()) {
+      continue;
     }
+    futures[idx] = std::async(std::launch::async, try_connect, idx);
+  }
+  std::vector<size_t> failed_ranks;
+  for (size_t idx = 0; idx < WorldSize(); idx++) {
+    if (futures[idx].valid() && !futures[idx].get()) {
+      failed_ranks.push_back(idx);
+    }
+  }
+  if (!failed_ranks.empty()) {
+    YASL_THROW(
+        "connect to mesh failed, failed to setup connection to rank={}",
+        fmt::join(failed_ranks, ","));
   }
   SPDLOG_DEBUG("connecting to mesh, all partners launched");
 
@@ -150,7 +412,17 @@ void Context::ConnectToMesh() {
     }
 
     std::string key = fmt::format("connect_{}", idx);
-    (void)RecvInternal(idx, key);  // ignore the received value.
+    const auto peer_salt = RecvInternal(idx, key);
+    if (!desc_.link_psk.empty()) {
+      YASL_ENFORCE(peer_salt.size() == kLinkSaltSize,
+                   "rank={} sent no salt, is link_psk set by all parties?",
+                   idx);
+      const auto session_key =
+          ChannelCipher::DeriveKey(desc_.link_psk, Id(), Rank(), salt, idx,
+                                   ByteContainerView(peer_salt));
+      channels_[idx]->SetCipher(
+          std::make_shared<ChannelCipher>(session_key, Rank(), idx));
+    }
   }
   SPDLOG_DEBUG("connected to mesh, id={}, self={}", Id(), Rank());
 }
@@ -162,6 +434,9 @@ void Context::SendAsync(size_t dst_rank, ByteContainerView value,
 
   TraceLogger::LinkTrace(event, tag, value);
 
+  if (auto* traffic = TagStats(tag)) {
+    traffic->sent_size.Add(value.size());
+  }
   SendAsyncInternal(dst_rank, event, value);
 }
 
@@ -170,15 +445,35 @@ void Context::SendAsync(size_t dst_rank, Buffer&& value, std::string_view tag) {
 
   TraceLogger::LinkTrace(event, tag, value);
 
+  if (auto* traffic = TagStats(tag)) {
+    traffic->sent_size.Add(value.size());
+  }
   SendAsyncInternal(dst_rank, event, std::move(value));
 }
 
+void Context::SendAsync(size_t dst_rank, ByteChainView value,
+                        std::string_view tag) {
+  const auto event = NextP2PId(rank_, dst_rank);
+
+#ifdef ENABLE_LINK_TRACE
+  TraceLogger::LinkTrace(event, tag, ByteContainerView(value.Flatten()));
+#endif
+
+  if (auto* traffic = TagStats(tag)) {
+    traffic->sent_size.Add(value.size());
+  }
+  SendAsyncInternal(dst_rank, event, value);
+}
+
 void Context::Send(size_t dst_rank, ByteContainerView value,
                    std::string_view tag) {
   const auto event = NextP2PId(rank_, dst_rank);
 
   TraceLogger::LinkTrace(event, tag, value);
 
+  if (auto* traffic = TagStats(tag)) {
+    traffic->sent_size.Add(value.size());
+  }
   SendInternal(dst_rank, event, value);
 }
 
@@ -187,7 +482,57 @@ Buffer Context::Recv(size_t src_rank, std::string_view tag) {
 
   TraceLogger::LinkTrace(event, tag, "");
 
-  return RecvInternal(src_rank, event);
+  auto* traffic = TagStats(tag);
+  if (traffic == nullptr) {
+    return RecvInternal(src_rank, event);
+  }
+  const auto start = std::chrono::steady_clock::now();
+  auto value = RecvInternal(src_rank, event);
+  traffic->recv_size.Add(value.size());
+  traffic->recv_wait_us.Add(ElapsedUs(start));
+  return value;
+}
+
+std::future<Buffer> Context::RecvAsync(size_t src_rank, std::string_view tag) {
+  // RecvCallback must be copyable, share the promise.
+  auto promise = std::make_shared<std::promise<Buffer>>();
+  auto future = promise->get_future();
+  RecvAsync(src_rank, tag, [promise](Buffer&& value) {
+    promise->set_value(std::move(value));
+  });
+  return future;
+}
+
+void Context::RecvAsync(size_t src_rank, std::string_view tag,
+                        RecvCallback callback) {
+  const auto event = NextP2PId(src_rank, rank_);
+
+  TraceLogger::LinkTrace(event, tag, "");
+
+  if (auto* traffic = TagStats(tag)) {
+    callback = [traffic, callback = std::move(callback)](Buffer&& value) {
+      traffic->recv_size.Add(value.size());
+      callback(std::move(value));
+    };
+  }
+  RecvAsyncInternal(src_rank, event, std::move(callback));
+}
+
+void Context::RecvAsync(size_t src_rank, std::string_view tag,
+                        ThreadPool* executor, RecvCallback callback) {
+  YASL_ENFORCE(executor != nullptr);
+  RecvAsync(src_rank, tag,
+            [executor, callback = std::move(callback)](Buffer&& value) {
+              // RecvCallback must be copyable, share the value.
+              auto shared = std::make_shared<Buffer>(std::move(value));
+              executor->Submit([callback, shared] {
+                try {
+                  callback(std::move(*shared));
+                } catch (const std::exception& e) {
+                  SPDLOG_ERROR("RecvAsync continuation failed: {}", e.what());
+                }
+              });
+            });
 }
 
 void Context::SendAsyncInternal(size_t dst_rank, const std::string& key,
@@ -195,10 +540,16 @@ void Context::SendAsyncInternal(size_t dst_rank, const std::string& key,
   YASL_ENFORCE(dst_rank < static_cast<size_t>(channels_.size()),
                "rank={} out of range={}", dst_rank, channels_.size());
 
-  channels_[dst_rank]->SendAsync(key, value);
+  if (batching_) {
+    batch_msgs_[dst_rank].emplace_back(ChannelKey(dst_rank, key),
+                                       Buffer(value.data(), value.size()));
+  } else {
+    channels_[dst_rank]->SendAsync(ChannelKey(dst_rank, key), value);
+  }
 
   stats_->sent_actions++;
   stats_->sent_bytes += value.size();
+  stats_->peers[dst_rank].sent_size.Add(value.size());
 }
 
 void Context::SendAsyncInternal(size_t dst_rank, const std::string& key,
@@ -208,10 +559,34 @@ void Context::SendAsyncInternal(size_t dst_rank, const std::string& key,
 
   const size_t value_length = value.size();
 
-  channels_[dst_rank]->SendAsync(key, std::move(value));
+  if (batching_) {
+    batch_msgs_[dst_rank].emplace_back(ChannelKey(dst_rank, key),
+                                       std::move(value));
+  } else {
+    channels_[dst_rank]->SendAsync(ChannelKey(dst_rank, key),
+                                   std::move(value));
+  }
 
   stats_->sent_actions++;
   stats_->sent_bytes += value_length;
+  stats_->peers[dst_rank].sent_size.Add(value_length);
+}
+
+void Context::SendAsyncInternal(size_t dst_rank, const std::string& key,
+                                ByteChainView value) {
+  YASL_ENFORCE(dst_rank < channels_.size(), "rank={} out of range={}", dst_rank,
+               channels_.size());
+
+  if (batching_) {
+    batch_msgs_[dst_rank].emplace_back(ChannelKey(dst_rank, key),
+                                       value.Flatten());
+  } else {
+    channels_[dst_rank]->SendAsync(ChannelKey(dst_rank, key), value);
+  }
+
+  stats_->sent_actions++;
+  stats_->sent_bytes += value.size();
+  stats_->peers[dst_rank].sent_size.Add(value.size());
 }
 
 void Context::SendInternal(size_t dst_rank, const std::string& key,
@@ -219,24 +594,130 @@ void Context::SendInternal(size_t dst_rank, const std::string& key,
   YASL_ENFORCE(dst_rank < static_cast<size_t>(channels_.size()),
                "rank={} out of range={}", dst_rank, channels_.size());
 
-  channels_[dst_rank]->Send(key, value);
+  channels_[dst_rank]->Send(ChannelKey(dst_rank, key), value);
 
   stats_->sent_actions++;
   stats_->sent_bytes += value.size();
+  stats_->peers[dst_rank].sent_size.Add(value.size());
 }
 
 Buffer Context::RecvInternal(size_t src_rank, const std::string& key) {
   YASL_ENFORCE(src_rank < static_cast<size_t>(channels_.size()),
                "rank={} out of range={}", src_rank, channels_.size());
 
-  auto value = channels_[src_rank]->Recv(key);
+  if (batching_) {
+    // peer may wait for buffered msgs before sending what we wait for.
+    FlushBatch();
+    BeginBatch();
+  }
+
+  YASL_PROFILE_SCOPE("link.recv_wait");
+  const auto start = std::chrono::steady_clock::now();
+  auto value = channels_[src_rank]->Recv(ChannelKey(src_rank, key));
 
   stats_->recv_actions++;
   stats_->recv_bytes += value.size();
+  auto& traffic = stats_->peers[src_rank];
+  traffic.recv_size.Add(value.size());
+  traffic.recv_wait_us.Add(ElapsedUs(start));
 
   return value;
 }
 
+std::pair<size_t, Buffer> Context::RecvAny(
+    const std::vector<size_t>& src_ranks, std::string_view tag) {
+  // peek the next p2p id of each rank, only the received one is taken.
+  std::vector<std::pair<size_t, std::string>> sources;
+  for (size_t src_rank : src_ranks) {
+    sources.emplace_back(
+        src_rank, P2PId(src_rank, rank_, P2PCounter(src_rank, rank_) + 1));
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  auto [idx, value] = RecvAnyInternal(sources);
+  const auto& [src_rank, event] = sources[idx];
+  P2PCounter(src_rank, rank_)++;
+
+  TraceLogger::LinkTrace(event, tag, "");
+
+  if (auto* traffic = TagStats(tag)) {
+    traffic->recv_size.Add(value.size());
+    traffic->recv_wait_us.Add(ElapsedUs(start));
+  }
+
+  return {src_rank, std::move(value)};
+}
+
+std::pair<size_t, Buffer> Context::RecvAnyInternal(
+    const std::vector<std::pair<size_t, std::string>>& sources) {
+  YASL_ENFORCE(!sources.empty(), "nothing to receive");
+  for (const auto& [src_rank, key] : sources) {
+    YASL_ENFORCE(src_rank < channels_.size() && src_rank != rank_,
+                 "invalid src rank={}, key={}", src_rank, key);
+  }
+
+  if (batching_) {
+    // peer may wait for buffered msgs before sending what we wait for.
+    FlushBatch();
+    BeginBatch();
+  }
+
+  std::vector<std::string> keys;
+  if (!lanes_.empty()) {
+    for (const auto& [src_rank, key] : sources) {
+      keys.push_back(ChannelKey(src_rank, key));
+    }
+  }
+
+  YASL_PROFILE_SCOPE("link.recv_wait");
+  RecvWatch watch;
+  const auto start = std::chrono::steady_clock::now();
+  const auto deadline = start + std::chrono::milliseconds(recv_timeout_ms_);
+  while (true) {
+    // arrivals after this point wake us up, nothing is missed.
+    const auto seq = watch.Notifier().Seq();
+    for (size_t idx = 0; idx < sources.size(); idx++) {
+      const auto& [src_rank, key] = sources[idx];
+      Buffer value;
+      if (watch.TryRecv(channels_[src_rank].get(),
+                        keys.empty() ? key : keys[idx], &value)) {
+        stats_->recv_actions++;
+        stats_->recv_bytes += value.size();
+        auto& traffic = stats_->peers[src_rank];
+        traffic.recv_size.Add(value.size());
+        traffic.recv_wait_us.Add(ElapsedUs(start));
+        return {idx, std::move(value)};
+      }
+    }
+
+    if (!watch.Notifier().WaitUntil(seq, deadline)) {
+      YASL_THROW_IO_ERROR("Get data timeout, first key={}, num keys={}",
+                          sources.front().second, sources.size());
+    }
+  }
+}
+
+void Context::RecvAsyncInternal(size_t src_rank, const std::string& key,
+                                RecvCallback callback) {
+  YASL_ENFORCE(src_rank < static_cast<size_t>(channels_.size()),
+               "rank={} out of range={}", src_rank, channels_.size());
+
+  if (batching_) {
+    // the caller is likely to wait for it soon.
+    FlushBatch();
+    BeginBatch();
+  }
+
+  channels_[src_rank]->RecvAsync(
+      ChannelKey(src_rank, key), [stats = stats_, src_rank,
+            callback = std::move(callback)](Buffer&& value) {
+        stats->recv_actions++;
+        stats->recv_bytes += value.size();
+        stats->peers[src_rank].recv_size.Add(value.size());
+        callback(std::move(value));
+      });
+}
+
 std::unique_ptr<Context> Context::Spawn() {
   ContextDesc sub_desc = desc_;
   sub_desc.id = fmt::format("{}-{}", desc_.id, child_counter_++);
@@ -247,10 +728,34 @@ std::unique_ptr<Context> Context::Spawn() {
 
   // share statistics with parent.
   sub_ctx->stats_ = this->stats_;
+  sub_ctx->lanes_ = lanes_;
 
   return sub_ctx;
 }
 
+std::vector<std::unique_ptr<Context>> Context::SpawnSessions(size_t n) {
+  std::vector<std::unique_ptr<Context>> sessions;
+  for (size_t i = 0; i < n; i++) {
+    auto session = Spawn();
+    session->lanes_.assign(WorldSize(), 0);
+    for (size_t rank = 0; rank < WorldSize(); rank++) {
+      if (rank != rank_) {
+        session->lanes_[rank] = channels_[rank]->NewLane();
+      }
+    }
+    sessions.push_back(std::move(session));
+  }
+  return sessions;
+}
+
+const std::string& Context::ChannelKey(size_t rank, const std::string& key) {
+  if (lanes_.empty() || lanes_[rank] == 0) {
+    return key;
+  }
+  lane_key_ = LaneKey(lanes_[rank], key);
+  return lane_key_;
+}
+
 std::unique_ptr<Context> Context::SubWorld(
     std::string_view id_suffix, const std::vector<std::string>& sub_party_ids) {
   size_t new_rank = sub_party_ids.size();
@@ -292,18 +797,36 @@ std::unique_ptr<Context> Context::SubWorld(
   }
 
   // sub-world context share the same channel & event-loop with parent.
-  return std::make_unique<Context>(sub_desc, new_rank, channels, receiver_loop_,
-                                   true);
+  auto sub_ctx = std::make_unique<Context>(sub_desc, new_rank, channels,
+                                           receiver_loop_, true);
+  if (!lanes_.empty()) {
+    sub_ctx->lanes_.resize(sub_party_ids.size());
+    for (size_t i = 0; i < sub_party_ids.size(); i++) {
+      sub_ctx->lanes_[i] = lanes_[orig_ranks[i]];
+    }
+  }
+  return sub_ctx;
 }
 
 std::string Context::NextId() {
+  if (desc_.compact_msg_keys) {
+    return CompactKey(kCompactCollectiveKey, id_hash_, ++counter_);
+  }
   return fmt::format("{}:{}", desc_.id, ++counter_);
 }
 
+std::string Context::P2PId(size_t src_rank, size_t dst_rank,
+                           int counter) const {
+  if (desc_.compact_msg_keys) {
+    // each direction has its own channel, ranks are implied.
+    return CompactKey(kCompactP2PKey, id_hash_, counter);
+  }
+  return fmt::format("{}:P2P-{}:{}->{}", desc_.id, counter, src_rank,
+                     dst_rank);
+}
+
 std::string Context::NextP2PId(size_t src_rank, size_t dst_rank) {
-  return fmt::format("{}:P2P-{}:{}->{}", desc_.id,
-                     ++p2p_counter_[std::make_pair(src_rank, dst_rank)],
-                     src_rank, dst_rank);
+  return P2PId(src_rank, dst_rank, ++P2PCounter(src_rank, dst_rank));
 }
 
 std::shared_ptr<IChannel> Context::GetChannel(size_t src_rank) const {
@@ -15,14 +15,21 @@
 #pragma once
 
 #include <atomic>
+#include <future>
 #include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "yasl/base/byte_container_view.h"
 #include "yasl/link/transport/channel.h"
 #include "yasl/utils/hash.h"
+#include "yasl/utils/histogram.h"
+#include "yasl/utils/thread_pool.h"
 
 namespace yasl::link {
 
@@ -46,9 +53,16 @@ struct ContextDesc {
   // connect to mesh retry time.
   uint32_t connect_retry_times = 10;
 
-  // connect to mesh retry interval.
+  // connect to mesh retry interval, the first one. following intervals are
+  // doubled up to `connect_max_retry_interval_ms`, and jittered.
   uint32_t connect_retry_interval_ms = 1000;  // 1 second.
 
+  // connect to mesh max retry interval.
+  uint32_t connect_max_retry_interval_ms = 10000;  // 10 seconds.
+
+  // connect to mesh total deadline, 0 means bounded by retry times only.
+  uint32_t connect_timeout_ms = 0;
+
   // recv timeout in milliseconds.
   //
   // 'recv time' is the max time that a party will wait for a given event.
@@ -72,6 +86,10 @@ struct ContextDesc {
   // limit, it will be unpacked into small chunks then reassembled.
   uint32_t http_max_payload_size = 32 * 1024;  // 32k byte
 
+  // max number of chunk requests in flight when a large message is sent in
+  // chunks. on high bandwidth-delay links, a larger window keeps the pipe busy.
+  uint32_t chunk_parallel_send_size = 10;
+
   // a single http request timetout.
   uint32_t http_timeout_ms = 20 * 1000;  // 20 seconds.
 
@@ -81,6 +99,74 @@ struct ContextDesc {
   // BRPC client channel connection type.
   std::string brpc_channel_connection_type = "single";
 
+  // BRPC payload compression, "none" or "zlib". payload shorter than
+  // `brpc_compress_min_size` or not shrunk by compression is sent as is.
+  std::string brpc_compress_type = "none";
+  uint32_t brpc_compress_min_size = 1024;
+
+  // BRPC over RDMA (RoCE / InfiniBand), both the server and the channels to
+  // peers. requires brpc built with BRPC_WITH_RDMA.
+  bool brpc_use_rdma = false;
+
+  // BRPC connections per peer, large msgs are striped across them.
+  uint32_t brpc_num_connections = 1;
+
+  // BRPC msgs longer than it are sent over a brpc stream with flow control
+  // by `brpc_stream_window_size`, instead of chunked rpcs. 0 disables it.
+  uint32_t brpc_stream_threshold = 0;
+  uint32_t brpc_stream_window_size = 2 * 1024 * 1024;  // 2M byte
+
+  // BRPC msgs of at most it are sent over a connection of their own, ahead
+  // of bulk transfers on the others. 0 disables it.
+  uint32_t brpc_priority_threshold = 0;
+
+  // BRPC pushes failed by the network are resent with exponential backoff,
+  // duplicates are dropped by receiver. 0 disables resending.
+  uint32_t brpc_max_resend_times = 3;
+  uint32_t brpc_resend_interval_ms = 100;
+
+  // BRPC tunes the chunk size, chunks in flight and connections of bulk msgs
+  // to each peer from the measured latency and throughput, starting from the
+  // static values above and kept within the bounds below. see LinkTuner.
+  bool brpc_adaptive = false;
+  uint32_t brpc_adaptive_min_chunk_size = 256 * 1024;       // 256k byte
+  uint32_t brpc_adaptive_max_chunk_size = 8 * 1024 * 1024;  // 8M byte
+  uint32_t brpc_adaptive_max_window = 64;
+  uint32_t brpc_adaptive_max_connections = 8;
+
+  // capacity of each shared memory ring, for FactoryShm only.
+  uint32_t shm_ring_capacity = 4 * 1024 * 1024;  // 4M byte
+
+  // a received msg whose key and value are longer than it in total breaks
+  // its connection, for FactoryTcp only.
+  uint64_t tcp_max_frame_size = uint64_t{1} << 31;  // 2G byte
+
+  // network emulated by FactoryMem, applied to each direction, see
+  // ChannelMem::NetworkOptions. per direction options could be set on the
+  // channels before any msg is sent.
+  uint32_t mem_latency_ms = 0;
+  uint32_t mem_jitter_ms = 0;
+  uint64_t mem_bandwidth_bytes = 0;  // per second, 0 means unlimited.
+
+  // pre-shared key of all parties. if set, normal msgs are encrypted and
+  // authenticated by AES-128-GCM, with a session key per pair of parties
+  // derived from it and random salts exchanged by ConnectToMesh.
+  std::string link_psk;
+
+  // use compact binary msg keys, made of a hash of the context id and the
+  // counters, instead of formatted strings. they are cheaper to build and to
+  // look up, but unreadable in traces. all parties must agree on it.
+  bool compact_msg_keys = false;
+
+  // also collect histograms per tag prefix, the part of a tag before the
+  // first ':', which costs a map lookup per msg.
+  bool stats_by_tag = false;
+
+  // record the msgs this party receives into this dir, one file per peer,
+  // so that the party can be run alone later by FactoryReplay. empty for
+  // no recording.
+  std::string record_dir;
+
   bool operator==(const ContextDesc& other) const {
     return (id == other.id) && (parties == other.parties);
   }
@@ -97,8 +183,21 @@ struct ContextDescHasher {
 
     utils::hash_combine(
         seed, desc.connect_retry_times, desc.connect_retry_interval_ms,
-        desc.recv_timeout_ms, desc.http_max_payload_size, desc.http_timeout_ms,
-        desc.brpc_channel_protocol, desc.brpc_channel_connection_type);
+        desc.connect_max_retry_interval_ms, desc.connect_timeout_ms,
+        desc.recv_timeout_ms, desc.http_max_payload_size,
+        desc.chunk_parallel_send_size, desc.http_timeout_ms,
+        desc.brpc_channel_protocol, desc.brpc_channel_connection_type,
+        desc.brpc_compress_type, desc.brpc_compress_min_size,
+        desc.brpc_use_rdma, desc.brpc_num_connections,
+        desc.brpc_stream_threshold, desc.brpc_stream_window_size,
+        desc.brpc_priority_threshold, desc.brpc_max_resend_times,
+        desc.brpc_resend_interval_ms, desc.brpc_adaptive,
+        desc.brpc_adaptive_min_chunk_size, desc.brpc_adaptive_max_chunk_size,
+        desc.brpc_adaptive_max_window, desc.brpc_adaptive_max_connections,
+        desc.shm_ring_capacity, desc.tcp_max_frame_size,
+        desc.compact_msg_keys, desc.stats_by_tag, desc.mem_latency_ms,
+        desc.mem_jitter_ms, desc.mem_bandwidth_bytes, desc.link_psk,
+        desc.record_dir);
 
     return seed;
   }
@@ -116,6 +215,53 @@ struct Statistics {
 
   // total number of recv actions, chuncked mode is treated as a single action.
   std::atomic<size_t> recv_actions = 0U;
+
+  // sends blocked by throttle windows, and the total time blocked, of all
+  // channels, refreshed by GetStats.
+  std::atomic<size_t> throttled_sends = 0U;
+  std::atomic<size_t> throttled_ms = 0U;
+
+  // bytes received but not read yet, and the peak of each channel summed up,
+  // refreshed by GetStats.
+  std::atomic<size_t> unread_bytes = 0U;
+  std::atomic<size_t> peak_unread_bytes = 0U;
+
+  // histograms of msgs to/from one peer, or of one tag prefix.
+  struct Traffic {
+    Histogram sent_size;
+    Histogram recv_size;
+    // time blocked in Recv, in microseconds.
+    Histogram recv_wait_us;
+  };
+
+  // indexed by peer rank.
+  std::vector<Traffic> peers;
+
+  // by tag prefix, if ContextDesc::stats_by_tag.
+  std::mutex tags_mutex;
+  std::map<std::string, std::unique_ptr<Traffic>, std::less<>> tags;
+};
+
+// A copy of all histograms, see Context::SnapshotStats.
+struct StatisticsSnapshot {
+  struct Traffic {
+    HistogramSnapshot sent_size;
+    HistogramSnapshot recv_size;
+    HistogramSnapshot recv_wait_us;
+  };
+
+  struct Peer {
+    size_t rank = 0;
+    Traffic traffic;
+    // channel side histograms, ack latency, throttle waits and chunks.
+    ChannelStats channel;
+  };
+
+  std::vector<Peer> peers;
+  std::map<std::string, Traffic> tags;
+
+  // prometheus text format, histograms are labeled by `peer` or `tag`.
+  std::string ToPrometheus() const;
 };
 
 // Threading: link context could only be used in one thread, since
@@ -145,14 +291,53 @@ class Context {
 
   void SendAsync(size_t dst_rank, Buffer&& value, std::string_view tag);
 
+  // sends the concatenation of the parts as a single msg, received by a
+  // plain Recv, without assembling it first, e.g.
+  //   ctx->SendAsync(1, ByteChainView{header, shares0, shares1}, "tag");
+  // the parts need to live until this returns only.
+  void SendAsync(size_t dst_rank, ByteChainView value, std::string_view tag);
+
   void Send(size_t dst_rank, ByteContainerView value, std::string_view tag);
 
   Buffer Recv(size_t src_rank, std::string_view tag);
 
+  // returns at once, the future is ready when the msg arrives. msgs are
+  // matched in call order, as if Recv were called here.
+  std::future<Buffer> RecvAsync(size_t src_rank, std::string_view tag);
+
+  // same as above, but `callback` is fired by the receiver loop thread, it
+  // should be light and never call back into this context.
+  void RecvAsync(size_t src_rank, std::string_view tag, RecvCallback callback);
+
+  // same as above, but `callback` runs on `executor`, so it may do real work
+  // and call back into this context, e.g. send a reply and RecvAsync the
+  // next msg. a session written as such a chain of continuations holds no
+  // thread while it waits, thousands of them share the executor's threads.
+  // the continuations of one chain run one at a time, so the chain may own
+  // its context. an exception of callback is logged and dropped, a chain
+  // should catch its own errors.
+  void RecvAsync(size_t src_rank, std::string_view tag, ThreadPool* executor,
+                 RecvCallback callback);
+
+  // receive the next msg of whichever rank in `src_ranks` arrives first,
+  // returns its rank and value. msgs of the other ranks are left for later
+  // receives, as if they were never waited.
+  std::pair<size_t, Buffer> RecvAny(const std::vector<size_t>& src_ranks,
+                                    std::string_view tag);
+
+  // connect to all peers concurrently, each one retried with backoff until
+  // it is ready, raise if any of them is not ready in time.
   void ConnectToMesh();
 
   std::unique_ptr<Context> Spawn();
 
+  // spawn `n` contexts for concurrent sessions, each one is used by its own
+  // thread. their msgs with each peer go through a lane of the shared
+  // channel, so that receivers of one session never contend with the others
+  // on the channel's msg database. all parties should call it in the same
+  // order, the channel lanes are allocated in call order and never reused.
+  std::vector<std::unique_ptr<Context>> SpawnSessions(size_t n);
+
   // Create a new Context from a subset of original parities.
   // Party which not in `sub_parties` should not call the SubWorld() method.
   // `id_suffix` will append to original context id as new context id
@@ -168,14 +353,42 @@ class Context {
 
   void SetThrottleWindowSize(size_t);
 
+  // how many received msgs are acknowledged by a single ack msg.
+  void SetAckBatchSize(size_t);
+
+  // bytes sent to each peer but not read by it, see
+  // IChannel::SetThrottleWindowBytes.
+  void SetThrottleWindowBytes(size_t);
+
+  // bytes buffered from each peer but not read yet, peers are throttled to
+  // keep under it. should be called after ConnectToMesh.
+  void SetRecvBufferLimit(size_t);
+
+  // SendAsync msgs between BeginBatch and FlushBatch are buffered, and sent
+  // to each peer by a single transport msg, for protocols sending many small
+  // msgs back to back. Buffered msgs are also flushed before Recv blocks.
+  // Prefer BatchGuard, which flushes on exceptions too.
+  void BeginBatch();
+
+  void FlushBatch();
+
+  bool IsBatching() const { return batching_; }
+
   // for internal algorithms.
   void SendAsyncInternal(size_t dst_rank, const std::string& key,
                          ByteContainerView value);
   void SendAsyncInternal(size_t dst_rank, const std::string& key,
                          Buffer&& value);
+  void SendAsyncInternal(size_t dst_rank, const std::string& key,
+                         ByteChainView value);
   void SendInternal(size_t dst_rank, const std::string& key,
                     ByteContainerView value);
   Buffer RecvInternal(size_t src_rank, const std::string& key);
+  void RecvAsyncInternal(size_t src_rank, const std::string& key,
+                         RecvCallback callback);
+  // `sources` are (rank, key) pairs, returns the index of the one received.
+  std::pair<size_t, Buffer> RecvAnyInternal(
+      const std::vector<std::pair<size_t, std::string>>& sources);
 
   // next collective algorithm id.
   std::string NextId();
@@ -194,8 +407,21 @@ class Context {
   // get statistics
   std::shared_ptr<const Statistics> GetStats() const;
 
+  // copy histograms of each peer and each tag prefix.
+  StatisticsSnapshot SnapshotStats() const;
+
  protected:
-  using P2PDirection = std::pair<int, int>;
+  std::string P2PId(size_t src_rank, size_t dst_rank, int counter) const;
+
+  // histograms of tag's prefix, nullptr unless ContextDesc::stats_by_tag.
+  Statistics::Traffic* TagStats(std::string_view tag);
+
+  // channel key of `key` on the lane to `rank`, valid until the next call.
+  const std::string& ChannelKey(size_t rank, const std::string& key);
+
+  int& P2PCounter(size_t src_rank, size_t dst_rank) {
+    return p2p_counter_[src_rank * WorldSize() + dst_rank];
+  }
 
   const ContextDesc desc_;  // world description.
   const size_t rank_;       // my rank.
@@ -204,12 +430,23 @@ class Context {
 
   // stateful properties.
   size_t counter_ = 0U;  // collective algorithm counter.
-  std::map<P2PDirection, int> p2p_counter_;
+  // p2p counter of each (src, dst) direction, indexed by src * world + dst.
+  std::vector<int> p2p_counter_;
+  // hash of the context id, prefix of compact msg keys.
+  uint64_t id_hash_ = 0U;
 
   size_t child_counter_ = 0U;
 
   uint32_t recv_timeout_ms_;
 
+  // buffered msgs of each peer, see BeginBatch.
+  bool batching_ = false;
+  std::vector<std::vector<std::pair<std::string, Buffer>>> batch_msgs_;
+
+  // channel lane to each peer, empty if all on the default lane.
+  std::vector<size_t> lanes_;
+  std::string lane_key_;
+
   // sub-context will shared statistics with parent
   std::shared_ptr<Statistics> stats_;
 
@@ -244,4 +481,32 @@ class RecvTimeoutGuard {
   uint32_t recv_timeout_ms_;
 };
 
+// a BatchGuard batches the msgs sent during its scope, see
+// Context::BeginBatch. for example:
+// {
+//  BatchGuard guard(ctx);
+//  for (...) ctx->SendAsync(...);
+// }
+// the buffered msgs are flushed when it goes out of scope, by an exception
+// too, so that the context is not left batching. a guard nested in another
+// one, or in a BeginBatch, leaves the flush to the outer one.
+class BatchGuard {
+ public:
+  explicit BatchGuard(std::shared_ptr<Context> ctx);
+  // errors of the flush are logged, call Flush to get them.
+  ~BatchGuard();
+
+  BatchGuard(const BatchGuard&) = delete;
+  BatchGuard& operator=(const BatchGuard&) = delete;
+
+  // flushes the msgs buffered so far and keeps batching, if it began the
+  // batch.
+  void Flush();
+
+ private:
+  const std::shared_ptr<Context> ctx_;
+  // whether it began the batch.
+  const bool owned_;
+};
+
 }  // namespace yasl::link
@@ -14,8 +14,12 @@
 
 #include "yasl/link/context.h"
 
+#include <unistd.h>
+
+#include <chrono>
 #include <future>
 #include <limits>
+#include <thread>
 
 #include "fmt/format.h"
 #include "gmock/gmock.h"
@@ -33,17 +37,32 @@ class MockChannel : public IChannel {
   MOCK_METHOD2(SendAsync,
                void(const std::string &key, ByteContainerView value));
   MOCK_METHOD2(SendAsync, void(const std::string &key, Buffer &&value));
+  MOCK_METHOD2(SendAsync, void(const std::string &key, ByteChainView value));
+  MOCK_METHOD1(SendAsyncBatch,
+               void(std::vector<std::pair<std::string, Buffer>> &&msgs));
   MOCK_METHOD2(Send, void(const std::string &key, ByteContainerView value));
   MOCK_METHOD1(Recv, Buffer(const std::string &key));
+  MOCK_METHOD2(RecvAsync, void(const std::string &key, RecvCallback callback));
+  MOCK_METHOD3(TryRecv,
+               bool(const std::string &key, Buffer *value,
+                    const std::shared_ptr<RecvNotifier> &notifier));
   MOCK_METHOD2(OnMessage,
                void(const std::string &key, ByteContainerView value));
-  MOCK_METHOD4(OnChunkedMessage,
+  MOCK_METHOD2(OnMessage, void(const std::string &key, Buffer &&value));
+  MOCK_METHOD6(OnChunkedMessage,
                void(const std::string &key, ByteContainerView value,
-                    size_t chunk_idx, size_t num_chunks));
+                    size_t chunk_idx, size_t num_chunks, size_t offset,
+                    size_t message_length));
   void SetRecvTimeout(uint32_t timeout_ms) override { timeout_ = timeout_ms; }
   uint32_t GetRecvTimeout() const override { return timeout_; }
   void WaitLinkTaskFinish() override {}
   void SetThrottleWindowSize(size_t) override {}
+  void SetAckBatchSize(size_t) override {}
+  void SetThrottleWindowBytes(size_t) override {}
+  void SetRecvBufferLimit(size_t) override {}
+  ChannelStats GetStats() const override { return {}; }
+  void SetCipher(std::shared_ptr<ChannelCipher>) override {}
+  size_t NewLane() override { return 0; }
 
  private:
   std::uint32_t timeout_{std::numeric_limits<std::uint32_t>::max()};
@@ -99,6 +118,7 @@ TEST_F(ContextConnectToMeshTest, ThrowExceptionIfNetworkError) {
   auto msg_loop = std::make_shared<ReceiverLoopMem>();
   ContextDesc ctx_desc;
   ctx_desc.connect_retry_interval_ms = 100;
+  ctx_desc.connect_max_retry_interval_ms = 200;
   for (size_t rank = 0; rank < world_size_; rank++) {
     const auto id = fmt::format("id-{}", rank);
     const auto host = fmt::format("host-{}", rank);
@@ -115,6 +135,40 @@ TEST_F(ContextConnectToMeshTest, ThrowExceptionIfNetworkError) {
   EXPECT_THROW(ctx.ConnectToMesh(), ::yasl::RuntimeError);
 }
 
+TEST_F(ContextConnectToMeshTest, ConnectTimeoutShouldThrowInTime) {
+  // GIVEN
+  auto msg_loop = std::make_shared<ReceiverLoopMem>();
+  ContextDesc ctx_desc;
+  ctx_desc.connect_retry_interval_ms = 100;
+  ctx_desc.connect_retry_times = 1000;
+  ctx_desc.connect_timeout_ms = 500;
+  for (size_t rank = 0; rank < world_size_; rank++) {
+    const auto id = fmt::format("id-{}", rank);
+    const auto host = fmt::format("host-{}", rank);
+    ctx_desc.parties.push_back({id, host});
+  }
+  Context ctx(ctx_desc, self_rank_, channels_, msg_loop);
+
+  std::string event = fmt::format("connect_{}", self_rank_);
+  ON_CALL(*std::static_pointer_cast<MockChannel>(channels_[0]),
+          Send(event, ByteContainerView{}))
+      .WillByDefault(ThrowNetworkErrorException());
+
+  // WHEN
+  const auto start = std::chrono::steady_clock::now();
+  std::string error;
+  try {
+    ctx.ConnectToMesh();
+  } catch (const ::yasl::RuntimeError& e) {
+    error = e.what();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  // THEN
+  EXPECT_NE(error.find("rank=0"), std::string::npos) << error;
+  EXPECT_LT(elapsed, std::chrono::milliseconds(2000));
+}
+
 TEST_F(ContextConnectToMeshTest, SetRecvTimeoutShouldOk) {
   // GIVEN
   auto msg_loop = std::make_shared<ReceiverLoopMem>();
@@ -225,6 +279,521 @@ TEST_F(ContextTest, SendRecvShouldOk) {
   EXPECT_EQ(send_buffer_, receive_buffer);
 }
 
+TEST_F(ContextTest, SendAsyncMovedBufferShouldNotCopy) {
+  // GIVEN
+  Buffer sent(std::string("moved buffer"));
+  const void *sent_ptr = sent.data();
+
+  // WHEN
+  ctxs_[0]->SendAsync(1, std::move(sent), "tag");
+  auto received = ctxs_[1]->Recv(0, "tag");
+
+  // THEN
+  // the very same memory reaches the peer, no allocation or copy on the way.
+  EXPECT_EQ(received.data(), sent_ptr);
+  EXPECT_EQ(std::string_view(received), "moved buffer");
+}
+
+TEST_F(ContextTest, ConcurrentRecvOnDifferentKeysShouldOk) {
+  // GIVEN
+  const size_t kNumReceivers = 8;
+  const size_t kMsgPerReceiver = 50;
+
+  // p2p ids of context are allocated in order, use channel keys directly.
+  auto sender = ctxs_[0]->GetChannel(1);
+  auto receiver = ctxs_[1]->GetChannel(0);
+
+  // WHEN
+  std::vector<std::future<std::vector<std::string>>> receivers;
+  for (size_t r = 0; r < kNumReceivers; r++) {
+    receivers.push_back(std::async(std::launch::async, [&, r] {
+      std::vector<std::string> received;
+      for (size_t i = 0; i < kMsgPerReceiver; i++) {
+        received.emplace_back(
+            receiver->Recv(fmt::format("concurrent:{}:{}", r, i)));
+      }
+      return received;
+    }));
+  }
+  // send in reverse order, receivers wait for keys arriving late.
+  for (size_t i = kMsgPerReceiver; i-- > 0;) {
+    for (size_t r = 0; r < kNumReceivers; r++) {
+      sender->SendAsync(fmt::format("concurrent:{}:{}", r, i),
+                        ByteContainerView(fmt::format("{}-{}", r, i)));
+    }
+  }
+
+  // THEN
+  for (size_t r = 0; r < kNumReceivers; r++) {
+    auto received = receivers[r].get();
+    for (size_t i = 0; i < kMsgPerReceiver; i++) {
+      EXPECT_EQ(received[i], fmt::format("{}-{}", r, i));
+    }
+  }
+}
+
+TEST_F(ContextTest, SendAsyncChainShouldOk) {
+  // GIVEN
+  const std::string head = "head:";
+  const std::string body(10000, 'x');
+
+  // WHEN
+  for (size_t rank = 1; rank < world_size_; rank++) {
+    ctxs_[0]->SendAsync(rank, ByteChainView{head, body}, "chain");
+  }
+  ctxs_[0]->BeginBatch();
+  ctxs_[0]->SendAsync(1, ByteChainView{body, head}, "chain");
+  ctxs_[0]->FlushBatch();
+
+  // THEN
+  for (size_t rank = 1; rank < world_size_; rank++) {
+    EXPECT_EQ(std::string(ctxs_[rank]->Recv(0, "chain")), head + body);
+  }
+  EXPECT_EQ(std::string(ctxs_[1]->Recv(0, "chain")), body + head);
+}
+
+TEST_F(ContextTest, SendAsyncInBatchShouldOk) {
+  // GIVEN
+  const size_t kMsgCount = 20;
+  ctxs_[0]->SetThrottleWindowSize(4);
+
+  // WHEN
+  {
+    BatchGuard guard(ctxs_[0]);
+    for (size_t i = 0; i < kMsgCount; i++) {
+      for (size_t rank = 1; rank < world_size_; rank++) {
+        const auto value = fmt::format("{}-{}", rank, i);
+        ctxs_[0]->SendAsync(rank, ByteContainerView(value), "batch");
+      }
+    }
+  }
+
+  // THEN
+  for (size_t i = 0; i < kMsgCount; i++) {
+    for (size_t rank = 1; rank < world_size_; rank++) {
+      EXPECT_EQ(std::string(ctxs_[rank]->Recv(0, "batch")),
+                fmt::format("{}-{}", rank, i));
+    }
+  }
+  ctxs_[0]->SetThrottleWindowSize(0);
+}
+
+TEST_F(ContextTest, RecvInBatchShouldFlushBufferedMsgs) {
+  // GIVEN
+  auto echo = std::async([&] {
+    auto value = ctxs_[1]->Recv(0, "ping");
+    ctxs_[1]->SendAsync(0, std::move(value), "pong");
+  });
+
+  // WHEN
+  ctxs_[0]->BeginBatch();
+  ctxs_[0]->SendAsync(1, ByteContainerView("hello"), "ping");
+  auto value = ctxs_[0]->Recv(1, "pong");
+  ctxs_[0]->FlushBatch();
+  echo.get();
+
+  // THEN
+  EXPECT_EQ(std::string(value), "hello");
+}
+
+TEST_F(ContextTest, BatchGuardShouldFlushOnException) {
+  // WHEN
+  try {
+    BatchGuard guard(ctxs_[0]);
+    ctxs_[0]->SendAsync(1, ByteContainerView("hello"), "guard");
+    {
+      // nested, the outer guard flushes.
+      BatchGuard inner(ctxs_[0]);
+      ctxs_[0]->SendAsync(1, ByteContainerView("world"), "guard");
+    }
+    EXPECT_TRUE(ctxs_[0]->IsBatching());
+    YASL_THROW("abort");
+  } catch (const ::yasl::RuntimeError&) {
+  }
+
+  // THEN
+  EXPECT_FALSE(ctxs_[0]->IsBatching());
+  EXPECT_EQ(std::string(ctxs_[1]->Recv(0, "guard")), "hello");
+  EXPECT_EQ(std::string(ctxs_[1]->Recv(0, "guard")), "world");
+}
+
+TEST_F(ContextTest, ThrottleWindowWithBatchedAckShouldOk) {
+  // GIVEN
+  const size_t kMsgCount = 100;
+  ctxs_[0]->SetThrottleWindowSize(2);
+  ctxs_[1]->SetAckBatchSize(16);
+
+  // WHEN
+  auto sender = std::async([&] {
+    for (size_t i = 0; i < kMsgCount; i++) {
+      ctxs_[0]->SendAsync(1, ByteContainerView(std::to_string(i)),
+                          fmt::format("tag:{}", i));
+    }
+  });
+  std::vector<std::string> received;
+  for (size_t i = 0; i < kMsgCount; i++) {
+    received.emplace_back(ctxs_[1]->Recv(0, fmt::format("tag:{}", i)));
+  }
+  sender.get();
+
+  // THEN
+  for (size_t i = 0; i < kMsgCount; i++) {
+    EXPECT_EQ(received[i], std::to_string(i));
+  }
+  ctxs_[0]->SetThrottleWindowSize(0);
+}
+
+TEST_F(ContextTest, RecvAsyncShouldOk) {
+  // GIVEN
+  ctxs_[0]->SendAsync(1, ByteContainerView("arrived"), "tag");
+
+  // WHEN
+  auto arrived = ctxs_[1]->RecvAsync(0, "tag");
+  auto pending = ctxs_[1]->RecvAsync(0, "tag");
+  EXPECT_EQ(pending.wait_for(std::chrono::milliseconds(10)),
+            std::future_status::timeout);
+  ctxs_[0]->SendAsync(1, ByteContainerView("pending"), "tag");
+
+  // THEN
+  EXPECT_EQ(std::string(arrived.get()), "arrived");
+  EXPECT_EQ(std::string(pending.get()), "pending");
+}
+
+TEST_F(ContextTest, RecvAsyncCallbackShouldAckInThrottleWindow) {
+  // GIVEN
+  const size_t kMsgCount = 100;
+  ctxs_[0]->SetThrottleWindowSize(2);
+  std::vector<std::string> received(kMsgCount);
+  std::atomic<size_t> num_received = 0;
+  std::promise<void> done;
+
+  // WHEN
+  for (size_t i = 0; i < kMsgCount; i++) {
+    ctxs_[1]->RecvAsync(0, "tag", [&, i](Buffer &&value) {
+      received[i] = std::string(value);
+      if (++num_received == kMsgCount) {
+        done.set_value();
+      }
+    });
+  }
+  // the sender is blocked unless callbacks ack the msgs.
+  for (size_t i = 0; i < kMsgCount; i++) {
+    ctxs_[0]->SendAsync(1, ByteContainerView(std::to_string(i)), "tag");
+  }
+  done.get_future().get();
+
+  // THEN
+  for (size_t i = 0; i < kMsgCount; i++) {
+    EXPECT_EQ(received[i], std::to_string(i));
+  }
+  ctxs_[0]->SetThrottleWindowSize(0);
+}
+
+TEST_F(ContextTest, RecvAnyShouldReturnFirstArrived) {
+  // GIVEN
+  ctxs_[2]->SendAsync(0, ByteContainerView("2-a"), "tag");
+  ctxs_[2]->SendAsync(0, ByteContainerView("2-b"), "tag");
+
+  // WHEN
+  auto [first_rank, first] = ctxs_[0]->RecvAny({1, 2}, "tag");
+  auto pending = std::async([&] { return ctxs_[0]->RecvAny({1}, "tag"); });
+  ctxs_[1]->SendAsync(0, ByteContainerView("1-a"), "tag");
+  auto [second_rank, second] = pending.get();
+
+  // THEN
+  EXPECT_EQ(first_rank, 2);
+  EXPECT_EQ(std::string(first), "2-a");
+  EXPECT_EQ(second_rank, 1);
+  EXPECT_EQ(std::string(second), "1-a");
+  // msgs not taken by RecvAny are left in order.
+  EXPECT_EQ(std::string(ctxs_[0]->Recv(2, "tag")), "2-b");
+}
+
+TEST_F(ContextTest, RecvAnyTimeoutShouldThrow) {
+  ctxs_[0]->SetRecvTimeout(200);
+  EXPECT_THROW(ctxs_[0]->RecvAny({1, 2}, "tag"), IoError);
+}
+
+static std::vector<std::shared_ptr<Context>> CreateMemContexts(
+    const std::string& id) {
+  ContextDesc ctx_desc;
+  ctx_desc.id = id;
+  ctx_desc.recv_timeout_ms = 2000;
+  for (size_t rank = 0; rank < 2; rank++) {
+    ctx_desc.parties.push_back(
+        {fmt::format("id-{}", rank), fmt::format("host-{}", rank)});
+  }
+  std::vector<std::shared_ptr<Context>> ctxs;
+  for (size_t rank = 0; rank < 2; rank++) {
+    ctxs.push_back(FactoryMem().CreateContext(ctx_desc, rank));
+  }
+  return ctxs;
+}
+
+TEST(ContextThrottleTest, ThrottleWindowBytesShouldBoundUnreadBytes) {
+  // GIVEN
+  // mem sessions are shared by equal descs, use a fresh one to count bytes.
+  auto ctxs = CreateMemContexts("ThrottleWindowBytesShouldBoundUnreadBytes");
+  const size_t kMsgCount = 20;
+  const std::string value(1000, 'x');
+  ctxs[0]->SetThrottleWindowBytes(3000);
+
+  // WHEN
+  auto sender = std::async([&] {
+    for (size_t i = 0; i < kMsgCount; i++) {
+      ctxs[0]->SendAsync(1, ByteContainerView(value), "tag");
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  for (size_t i = 0; i < kMsgCount; i++) {
+    EXPECT_EQ(std::string(ctxs[1]->Recv(0, "tag")), value);
+  }
+  sender.get();
+
+  // THEN
+  EXPECT_LE(ctxs[1]->GetStats()->peak_unread_bytes, 3000);
+  EXPECT_GT(ctxs[0]->GetStats()->throttled_sends, 0);
+  EXPECT_EQ(ctxs[1]->GetStats()->unread_bytes, 0);
+}
+
+TEST(ContextThrottleTest, RecvBufferLimitShouldThrottlePeer) {
+  // GIVEN
+  // mem sessions are shared by equal descs, use a fresh one to count bytes.
+  auto ctxs = CreateMemContexts("RecvBufferLimitShouldThrottlePeer");
+  const size_t kMsgCount = 20;
+  const std::string value(1000, 'x');
+  ctxs[1]->SetRecvBufferLimit(2000);
+
+  // WHEN
+  auto sender = std::async([&] {
+    for (size_t i = 0; i < kMsgCount; i++) {
+      ctxs[0]->SendAsync(1, ByteContainerView(value), "tag");
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  for (size_t i = 0; i < kMsgCount; i++) {
+    EXPECT_EQ(std::string(ctxs[1]->Recv(0, "tag")), value);
+  }
+  sender.get();
+
+  // THEN
+  EXPECT_LE(ctxs[1]->GetStats()->peak_unread_bytes, 2000);
+  EXPECT_GT(ctxs[0]->GetStats()->throttled_sends, 0);
+}
+
+TEST(ContextCompactKeyTest, SendRecvShouldOk) {
+  // GIVEN
+  ContextDesc ctx_desc;
+  ctx_desc.id = "compact_key_test";
+  ctx_desc.compact_msg_keys = true;
+  for (size_t rank = 0; rank < 3; rank++) {
+    ctx_desc.parties.push_back(
+        {fmt::format("id-{}", rank), fmt::format("host-{}", rank)});
+  }
+  std::vector<std::shared_ptr<Context>> ctxs;
+  for (size_t rank = 0; rank < 3; rank++) {
+    ctxs.push_back(FactoryMem().CreateContext(ctx_desc, rank));
+  }
+
+  // WHEN
+  for (size_t i = 0; i < 300; i++) {
+    ctxs[0]->SendAsync(1, ByteContainerView(std::to_string(i)), "tag");
+    ctxs[2]->SendAsync(1, ByteContainerView(std::to_string(i + 1)), "tag");
+  }
+
+  // THEN
+  for (size_t i = 0; i < 300; i++) {
+    EXPECT_EQ(std::string_view(ctxs[1]->Recv(0, "tag")), std::to_string(i));
+    EXPECT_EQ(std::string_view(ctxs[1]->Recv(2, "tag")),
+              std::to_string(i + 1));
+  }
+  // short enough to skip heap allocations.
+  EXPECT_LE(ctxs[1]->NextId().size(), std::string().capacity());
+  EXPECT_NE(ctxs[1]->NextId(), ctxs[1]->NextId());
+}
+
+TEST(ContextSessionsTest, ConcurrentSessionsShouldOk) {
+  // GIVEN
+  const size_t kNumSessions = 8;
+  const size_t kRounds = 50;
+  ContextDesc ctx_desc;
+  ctx_desc.id = "sessions_test";
+  for (size_t rank = 0; rank < 2; rank++) {
+    ctx_desc.parties.push_back(
+        {fmt::format("id-{}", rank), fmt::format("host-{}", rank)});
+  }
+  std::vector<std::vector<std::unique_ptr<Context>>> sessions;
+  for (size_t rank = 0; rank < 2; rank++) {
+    auto ctx = FactoryMem().CreateContext(ctx_desc, rank);
+    sessions.push_back(ctx->SpawnSessions(kNumSessions));
+  }
+
+  // WHEN
+  // ping-pong in every session concurrently, each one in its own thread.
+  std::vector<std::future<void>> futures;
+  for (size_t rank = 0; rank < 2; rank++) {
+    for (size_t s = 0; s < kNumSessions; s++) {
+      futures.push_back(std::async(std::launch::async, [&, rank, s] {
+        auto& ctx = sessions[rank][s];
+        for (size_t i = 0; i < kRounds; i++) {
+          const auto value = fmt::format("{}-{}-{}", rank, s, i);
+          ctx->SendAsync(1 - rank, ByteContainerView(value), "ping");
+          EXPECT_EQ(std::string_view(ctx->Recv(1 - rank, "ping")),
+                    fmt::format("{}-{}-{}", 1 - rank, s, i));
+        }
+      }));
+    }
+  }
+
+  // THEN
+  for (auto& f : futures) {
+    f.get();
+  }
+  // lanes are inherited by sub contexts.
+  auto sub_0 = sessions[0][0]->SubWorld("sub", {"id-0", "id-1"});
+  auto sub_1 = sessions[1][0]->SubWorld("sub", {"id-0", "id-1"});
+  sub_0->SendAsync(1, ByteContainerView("sub"), "tag");
+  EXPECT_EQ(std::string_view(sub_1->Recv(0, "tag")), "sub");
+}
+
+TEST(ContextSessionsTest, ContinuationSessionsShouldOk) {
+  // GIVEN
+  const size_t kNumSessions = 200;
+  const size_t kRounds = 20;
+  ContextDesc ctx_desc;
+  ctx_desc.id = "continuation_test";
+  for (size_t rank = 0; rank < 2; rank++) {
+    ctx_desc.parties.push_back(
+        {fmt::format("id-{}", rank), fmt::format("host-{}", rank)});
+  }
+  std::vector<std::vector<std::unique_ptr<Context>>> sessions;
+  for (size_t rank = 0; rank < 2; rank++) {
+    auto ctx = FactoryMem().CreateContext(ctx_desc, rank);
+    sessions.push_back(ctx->SpawnSessions(kNumSessions));
+  }
+  // far fewer threads than pending receives.
+  ThreadPool executor(2);
+
+  // WHEN
+  // ping-pong in every session, each round is a continuation of the last.
+  std::atomic<size_t> num_done = 0;
+  std::atomic<size_t> num_errors = 0;
+  std::promise<void> done;
+  std::function<void(size_t, size_t, size_t)> step = [&](size_t rank,
+                                                          size_t s,
+                                                          size_t i) {
+    auto& ctx = sessions[rank][s];
+    ctx->SendAsync(1 - rank,
+                   ByteContainerView(fmt::format("{}-{}-{}", rank, s, i)),
+                   "ping");
+    ctx->RecvAsync(1 - rank, "ping", &executor, [&, rank, s, i](Buffer&& v) {
+      if (std::string_view(v) != fmt::format("{}-{}-{}", 1 - rank, s, i)) {
+        num_errors++;
+      }
+      if (i + 1 < kRounds) {
+        step(rank, s, i + 1);
+      } else if (++num_done == 2 * kNumSessions) {
+        done.set_value();
+      }
+    });
+  };
+  for (size_t rank = 0; rank < 2; rank++) {
+    for (size_t s = 0; s < kNumSessions; s++) {
+      step(rank, s, 0);
+    }
+  }
+
+  // THEN
+  done.get_future().get();
+  EXPECT_EQ(num_errors.load(), 0);
+}
+
+TEST(ContextLinkPskTest, EncryptedSendRecvShouldOk) {
+  // GIVEN
+  ContextDesc ctx_desc;
+  ctx_desc.id = "link_psk_test";
+  ctx_desc.link_psk = "pre-shared key";
+  for (size_t rank = 0; rank < 3; rank++) {
+    ctx_desc.parties.push_back(
+        {fmt::format("id-{}", rank), fmt::format("host-{}", rank)});
+  }
+  std::vector<std::shared_ptr<Context>> ctxs;
+  for (size_t rank = 0; rank < 3; rank++) {
+    ctxs.push_back(FactoryMem().CreateContext(ctx_desc, rank));
+  }
+
+  // WHEN
+  std::vector<std::future<void>> futures;
+  for (size_t rank = 0; rank < 3; rank++) {
+    futures.push_back(
+        std::async([&, rank] { ctxs[rank]->ConnectToMesh(); }));
+  }
+  for (auto& f : futures) {
+    f.get();
+  }
+  const std::string large(100000, 'x');
+  ctxs[0]->SendAsync(1, ByteContainerView(large), "tag");
+  ctxs[2]->Send(1, ByteContainerView("from 2"), "tag");
+  ctxs[1]->SendAsync(0, ByteContainerView("from 1"), "tag");
+
+  // THEN
+  EXPECT_EQ(std::string_view(ctxs[1]->Recv(0, "tag")), large);
+  EXPECT_EQ(std::string_view(ctxs[1]->Recv(2, "tag")), "from 2");
+  EXPECT_EQ(std::string_view(ctxs[0]->Recv(1, "tag")), "from 1");
+}
+
+TEST(ContextStatsTest, SnapshotStatsShouldOk) {
+  // GIVEN
+  ContextDesc ctx_desc;
+  ctx_desc.id = "stats_snapshot_test";
+  ctx_desc.stats_by_tag = true;
+  for (size_t rank = 0; rank < 2; rank++) {
+    ctx_desc.parties.push_back(
+        {fmt::format("id-{}", rank), fmt::format("host-{}", rank)});
+  }
+  std::vector<std::shared_ptr<Context>> ctxs;
+  for (size_t rank = 0; rank < 2; rank++) {
+    ctxs.push_back(FactoryMem().CreateContext(ctx_desc, rank));
+  }
+
+  // WHEN
+  for (size_t i = 0; i < 20; i++) {
+    ctxs[0]->SendAsync(1, ByteContainerView(std::string(100, 'x')),
+                       fmt::format("IKNP:{}", i));
+    ctxs[1]->Recv(0, fmt::format("IKNP:{}", i));
+  }
+  ctxs[0]->SendAsync(1, ByteContainerView("y"), "other");
+  ctxs[1]->Recv(0, "other");
+  // flush the pending acks.
+  auto finish = std::async([&] { ctxs[1]->WaitLinkTaskFinish(); });
+  ctxs[0]->WaitLinkTaskFinish();
+  finish.get();
+
+  // THEN
+  auto sender = ctxs[0]->SnapshotStats();
+  ASSERT_EQ(sender.peers.size(), 1);
+  EXPECT_EQ(sender.peers[0].rank, 1);
+  EXPECT_EQ(sender.peers[0].traffic.sent_size.count, 21);
+  EXPECT_EQ(sender.peers[0].traffic.sent_size.sum, 2001);
+  EXPECT_EQ(sender.peers[0].channel.ack_latency_us.count, 21);
+  ASSERT_EQ(sender.tags.size(), 2);
+  EXPECT_EQ(sender.tags["IKNP"].sent_size.count, 20);
+  EXPECT_EQ(sender.tags["other"].sent_size.count, 1);
+
+  auto receiver = ctxs[1]->SnapshotStats();
+  EXPECT_EQ(receiver.peers[0].traffic.recv_size.count, 21);
+  EXPECT_EQ(receiver.peers[0].traffic.recv_wait_us.count, 21);
+  EXPECT_EQ(receiver.tags["IKNP"].recv_wait_us.count, 20);
+
+  const auto text = sender.ToPrometheus();
+  EXPECT_NE(text.find("# TYPE yasl_link_sent_size_bytes histogram\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("yasl_link_sent_size_bytes_count{peer=\"1\"} 21\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("yasl_link_sent_size_bytes_count{tag=\"IKNP\"} 20\n"),
+            std::string::npos);
+}
+
 TEST_F(ContextTest, SubWorldShouldOk) {
   // GIVEN
   // original party ["id-1", "id-2"] will makeup new sub context
@@ -258,4 +827,36 @@ TEST_F(ContextTest, SubWorldShouldOk) {
   EXPECT_EQ(send_buf, value_recieve);
 }
 
+TEST(FactoryShmTest, SendRecvShouldOk) {
+  // GIVEN
+  const size_t kWorldSize = 3;
+  ContextDesc ctx_desc;
+  ctx_desc.id = fmt::format("factory_shm_test-{}", getpid());
+  ctx_desc.connect_retry_interval_ms = 100;
+  for (size_t rank = 0; rank < kWorldSize; rank++) {
+    ctx_desc.parties.push_back({fmt::format("id-{}", rank), ""});
+  }
+
+  // WHEN
+  auto proc = [&](size_t rank) {
+    auto ctx = FactoryShm().CreateContext(ctx_desc, rank);
+    ctx->ConnectToMesh();
+    ctx->SendAsync(ctx->NextRank(), ByteContainerView(std::to_string(rank)),
+                   "ring");
+    auto value = ctx->Recv(ctx->PrevRank(), "ring");
+    ctx->WaitLinkTaskFinish();
+    return std::string(value);
+  };
+  std::vector<std::future<std::string>> futures;
+  for (size_t rank = 0; rank < kWorldSize; rank++) {
+    futures.push_back(std::async(std::launch::async, proc, rank));
+  }
+
+  // THEN
+  for (size_t rank = 0; rank < kWorldSize; rank++) {
+    EXPECT_EQ(futures[rank].get(),
+              std::to_string((rank + kWorldSize - 1) % kWorldSize));
+  }
+}
+
 }  // namespace yasl::link::test
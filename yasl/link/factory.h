@@ -15,6 +15,7 @@
 #pragma once
 
 #include "yasl/link/context.h"
+#include "yasl/link/transport/channel_replay.h"
 
 namespace yasl::link {
 
@@ -41,4 +42,36 @@ class FactoryBrpc : public ILinkFactory {
                                          size_t self_rank) override;
 };
 
+/// builtin link context type, shared memory link context for parties running
+/// on the same host.
+class FactoryShm : public ILinkFactory {
+ public:
+  std::shared_ptr<Context> CreateContext(const ContextDesc& desc,
+                                         size_t self_rank) override;
+};
+
+/// builtin link context type, plain tcp link context, msgs are streamed on
+/// one connection per peer without any rpc framing.
+class FactoryTcp : public ILinkFactory {
+ public:
+  std::shared_ptr<Context> CreateContext(const ContextDesc& desc,
+                                         size_t self_rank) override;
+};
+
+/// replays the msgs recorded by a party with ContextDesc::record_dir, so
+/// that the party runs alone, see ReplayChannel.
+class FactoryReplay : public ILinkFactory {
+ public:
+  explicit FactoryReplay(std::string dir,
+                         ReplayTiming timing = ReplayTiming::kRecorded)
+      : dir_(std::move(dir)), timing_(timing) {}
+
+  std::shared_ptr<Context> CreateContext(const ContextDesc& desc,
+                                         size_t self_rank) override;
+
+ private:
+  const std::string dir_;
+  const ReplayTiming timing_;
+};
+
 }  // namespace yasl::link
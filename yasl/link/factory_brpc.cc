@@ -36,8 +36,23 @@ std::shared_ptr<Context> FactoryBrpc::CreateContext(const ContextDesc& desc,
     ChannelBrpc::Options opts;
     opts.http_timeout_ms = desc.http_timeout_ms;
     opts.http_max_payload_size = desc.http_max_payload_size;
+    opts.chunk_parallel_send_size = desc.chunk_parallel_send_size;
     opts.channel_protocol = desc.brpc_channel_protocol;
     opts.channel_connection_type = desc.brpc_channel_connection_type;
+    opts.compress_type = desc.brpc_compress_type;
+    opts.compress_min_size = desc.brpc_compress_min_size;
+    opts.use_rdma = desc.brpc_use_rdma;
+    opts.num_connections = desc.brpc_num_connections;
+    opts.stream_threshold = desc.brpc_stream_threshold;
+    opts.stream_window_size = desc.brpc_stream_window_size;
+    opts.priority_threshold = desc.brpc_priority_threshold;
+    opts.max_resend_times = desc.brpc_max_resend_times;
+    opts.resend_interval_ms = desc.brpc_resend_interval_ms;
+    opts.adaptive = desc.brpc_adaptive;
+    opts.adaptive_min_chunk_size = desc.brpc_adaptive_min_chunk_size;
+    opts.adaptive_max_chunk_size = desc.brpc_adaptive_max_chunk_size;
+    opts.adaptive_max_window = desc.brpc_adaptive_max_window;
+    opts.adaptive_max_connections = desc.brpc_adaptive_max_connections;
     auto channel = std::make_shared<ChannelBrpc>(self_rank, rank,
                                                  desc.recv_timeout_ms, opts);
     channel->SetPeerHost(desc.parties[rank].host);
@@ -48,8 +63,9 @@ std::shared_ptr<Context> FactoryBrpc::CreateContext(const ContextDesc& desc,
 
   // start receiver loop.
   const auto self_host = desc.parties[self_rank].host;
-  msg_loop->Start(self_host);
+  msg_loop->Start(self_host, desc.brpc_use_rdma);
 
+  RecordChannels(desc.record_dir, self_rank, &channels);
   return std::make_shared<Context>(desc, self_rank, std::move(channels),
                                    std::move(msg_loop));
 }
@@ -48,6 +48,11 @@ std::shared_ptr<MemSession> CreateSession(const ContextDesc& desc) {
         }
         channels[peer_rank] = std::make_shared<ChannelMem>(
             self_rank, peer_rank, desc.recv_timeout_ms);
+        ChannelMem::NetworkOptions options;
+        options.latency_ms = desc.mem_latency_ms;
+        options.jitter_ms = desc.mem_jitter_ms;
+        options.bandwidth_bytes = desc.mem_bandwidth_bytes;
+        channels[peer_rank]->SetNetworkOptions(options);
       }
     }
 
@@ -70,6 +75,7 @@ std::shared_ptr<MemSession> CreateSession(const ContextDesc& desc) {
     for (size_t peer_rank = 0; peer_rank < world_size; peer_rank++) {
       channels[peer_rank] = all_channels[self_rank][peer_rank];
     }
+    RecordChannels(desc.record_dir, self_rank, &channels);
     auto msg_loop = std::make_unique<ReceiverLoopMem>();
     ctxs[self_rank] = std::make_shared<Context>(
         desc, self_rank, std::move(channels), std::move(msg_loop));
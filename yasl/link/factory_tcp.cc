@@ -0,0 +1,53 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/base/exception.h"
+#include "yasl/link/factory.h"
+#include "yasl/link/transport/channel_tcp.h"
+
+namespace yasl::link {
+
+std::shared_ptr<Context> FactoryTcp::CreateContext(const ContextDesc& desc,
+                                                   size_t self_rank) {
+  const size_t world_size = desc.parties.size();
+  if (self_rank >= world_size) {
+    YASL_THROW_LOGIC_ERROR("invalid self rank={}, world_size={}", self_rank,
+                           world_size);
+  }
+
+  auto msg_loop = std::make_unique<ReceiverLoopTcp>(desc.tcp_max_frame_size);
+  std::vector<std::shared_ptr<IChannel>> channels(world_size);
+  for (size_t rank = 0; rank < world_size; rank++) {
+    if (rank == self_rank) {
+      continue;
+    }
+
+    // the peer is connected lazily, ConnectToMesh waits for peers.
+    auto channel = std::make_shared<ChannelTcp>(self_rank, rank,
+                                                desc.recv_timeout_ms);
+    channel->SetPeerHost(desc.parties[rank].host);
+    msg_loop->AddListener(rank, channel);
+    channels[rank] = std::move(channel);
+  }
+
+  // start receiver loop.
+  const auto self_host = desc.parties[self_rank].host;
+  msg_loop->Start(self_host);
+
+  RecordChannels(desc.record_dir, self_rank, &channels);
+  return std::make_shared<Context>(desc, self_rank, std::move(channels),
+                                   std::move(msg_loop));
+}
+
+}  // namespace yasl::link
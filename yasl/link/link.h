@@ -15,6 +15,7 @@
 #pragma once
 
 #include "yasl/link/algorithm/allgather.h"
+#include "yasl/link/algorithm/allreduce.h"
 #include "yasl/link/algorithm/barrier.h"
 #include "yasl/link/algorithm/broadcast.h"
 #include "yasl/link/algorithm/gather.h"
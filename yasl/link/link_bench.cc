@@ -0,0 +1,239 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of link, over FactoryMem and FactoryBrpc in loopback.
+//
+// The first argument of each benchmark is the factory, 0 for mem and 1 for
+// brpc. Worlds are created on first use and kept for the whole run.
+
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+#include "yasl/link/algorithm/allgather.h"
+#include "yasl/link/algorithm/barrier.h"
+#include "yasl/link/algorithm/broadcast.h"
+#include "yasl/link/algorithm/gather.h"
+#include "yasl/link/algorithm/scatter.h"
+#include "yasl/link/context.h"
+#include "yasl/link/factory.h"
+
+namespace {
+
+using yasl::link::Context;
+
+enum FactoryType : int64_t { kMem = 0, kBrpc = 1 };
+
+using World = std::vector<std::shared_ptr<Context>>;
+
+// worlds are keyed by (factory, world size, brpc max payload size).
+const World& GetWorld(int64_t factory, size_t world_size,
+                      uint32_t max_payload_size = 32 * 1024) {
+  static std::map<std::tuple<int64_t, size_t, uint32_t>, World> worlds;
+  static uint16_t next_port = 19300;
+
+  auto& world = worlds[{factory, world_size, max_payload_size}];
+  if (!world.empty()) {
+    return world;
+  }
+
+  yasl::link::ContextDesc desc;
+  desc.id = fmt::format("link_bench-{}-{}-{}", factory, world_size,
+                        max_payload_size);
+  desc.http_max_payload_size = max_payload_size;
+  for (size_t rank = 0; rank < world_size; rank++) {
+    desc.parties.push_back(
+        {fmt::format("party-{}", rank),
+         fmt::format("127.0.0.1:{}", factory == kBrpc ? next_port++ : 0)});
+  }
+
+  world.resize(world_size);
+  for (size_t rank = 0; rank < world_size; rank++) {
+    if (factory == kBrpc) {
+      world[rank] = yasl::link::FactoryBrpc().CreateContext(desc, rank);
+    } else {
+      world[rank] = yasl::link::FactoryMem().CreateContext(desc, rank);
+    }
+  }
+  std::vector<std::future<void>> jobs;
+  for (const auto& ctx : world) {
+    jobs.push_back(
+        std::async(std::launch::async, [&] { ctx->ConnectToMesh(); }));
+  }
+  for (auto& job : jobs) {
+    job.get();
+  }
+  return world;
+}
+
+// run `fn(ctx)` on all parties of `world` concurrently.
+template <typename Fn>
+void RunAll(const World& world, Fn&& fn) {
+  std::vector<std::future<void>> jobs;
+  for (size_t rank = 1; rank < world.size(); rank++) {
+    jobs.push_back(std::async(std::launch::async, [&, rank] {
+      fn(world[rank]);
+    }));
+  }
+  fn(world[0]);
+  for (auto& job : jobs) {
+    job.get();
+  }
+}
+
+constexpr size_t kRoundTrips = 100;
+
+// args: factory, msg size.
+void BM_PingPong(benchmark::State& state) {
+  const auto& world = GetWorld(state.range(0), 2);
+  const std::string msg(state.range(1), 'x');
+  for (auto _ : state) {
+    auto echo = std::async(std::launch::async, [&] {
+      for (size_t i = 0; i < kRoundTrips; i++) {
+        world[1]->SendAsync(0, world[1]->Recv(0, "ping"), "pong");
+      }
+    });
+    for (size_t i = 0; i < kRoundTrips; i++) {
+      world[0]->SendAsync(1, yasl::ByteContainerView(msg), "ping");
+      benchmark::DoNotOptimize(world[0]->Recv(1, "pong"));
+    }
+    echo.get();
+  }
+  // one item is one round trip.
+  state.SetItemsProcessed(state.iterations() * kRoundTrips);
+}
+
+constexpr size_t kStreamMsgs = 64;
+
+// args: factory, msg size, throttle window size, brpc max payload size.
+void BM_Throughput(benchmark::State& state) {
+  const auto& world = GetWorld(state.range(0), 2, state.range(3));
+  const std::string msg(state.range(1), 'x');
+  world[0]->SetThrottleWindowSize(state.range(2));
+  for (auto _ : state) {
+    auto recv = std::async(std::launch::async, [&] {
+      for (size_t i = 0; i < kStreamMsgs; i++) {
+        benchmark::DoNotOptimize(world[1]->Recv(0, "stream"));
+      }
+    });
+    for (size_t i = 0; i < kStreamMsgs; i++) {
+      world[0]->SendAsync(1, yasl::ByteContainerView(msg), "stream");
+    }
+    recv.get();
+  }
+  world[0]->SetThrottleWindowSize(0);
+  state.SetBytesProcessed(state.iterations() * kStreamMsgs * msg.size());
+}
+
+// args of collectives: factory, world size, msg size.
+void BM_AllGather(benchmark::State& state) {
+  const auto& world = GetWorld(state.range(0), state.range(1));
+  const std::string msg(state.range(2), 'x');
+  for (auto _ : state) {
+    RunAll(world, [&](const std::shared_ptr<Context>& ctx) {
+      benchmark::DoNotOptimize(yasl::link::AllGather(ctx, msg, "bench"));
+    });
+  }
+  state.SetBytesProcessed(state.iterations() * msg.size() * world.size());
+}
+
+void BM_Broadcast(benchmark::State& state) {
+  const auto& world = GetWorld(state.range(0), state.range(1));
+  const std::string msg(state.range(2), 'x');
+  for (auto _ : state) {
+    RunAll(world, [&](const std::shared_ptr<Context>& ctx) {
+      benchmark::DoNotOptimize(yasl::link::Broadcast(
+          ctx, ctx->Rank() == 0 ? msg : std::string_view(), 0, "bench"));
+    });
+  }
+  state.SetBytesProcessed(state.iterations() * msg.size());
+}
+
+void BM_Gather(benchmark::State& state) {
+  const auto& world = GetWorld(state.range(0), state.range(1));
+  const std::string msg(state.range(2), 'x');
+  for (auto _ : state) {
+    RunAll(world, [&](const std::shared_ptr<Context>& ctx) {
+      benchmark::DoNotOptimize(yasl::link::Gather(ctx, msg, 0, "bench"));
+    });
+  }
+  state.SetBytesProcessed(state.iterations() * msg.size() * world.size());
+}
+
+void BM_Scatter(benchmark::State& state) {
+  const auto& world = GetWorld(state.range(0), state.range(1));
+  const std::string msg(state.range(2), 'x');
+  const std::vector<yasl::ByteContainerView> inputs(world.size(), msg);
+  for (auto _ : state) {
+    RunAll(world, [&](const std::shared_ptr<Context>& ctx) {
+      benchmark::DoNotOptimize(yasl::link::Scatter(
+          ctx,
+          ctx->Rank() == 0 ? inputs : std::vector<yasl::ByteContainerView>(),
+          0, "bench"));
+    });
+  }
+  state.SetBytesProcessed(state.iterations() * msg.size() * world.size());
+}
+
+// args: factory, world size.
+void BM_Barrier(benchmark::State& state) {
+  const auto& world = GetWorld(state.range(0), state.range(1));
+  for (auto _ : state) {
+    RunAll(world, [&](const std::shared_ptr<Context>& ctx) {
+      yasl::link::Barrier(ctx, "bench");
+    });
+  }
+}
+
+const std::vector<int64_t> kFactories = {kMem, kBrpc};
+const std::vector<int64_t> kWorldSizes = {2, 4, 8};
+const std::vector<int64_t> kCollectiveSizes = {1 << 10, 1 << 20};
+
+}  // namespace
+
+BENCHMARK(BM_PingPong)
+    ->ArgNames({"factory", "size"})
+    ->ArgsProduct({kFactories, {8, 1 << 10, 1 << 16, 1 << 20}})
+    ->UseRealTime();
+BENCHMARK(BM_Throughput)
+    ->ArgNames({"factory", "size", "window", "payload"})
+    ->ArgsProduct({kFactories, {1 << 10, 1 << 20}, {0, 4, 16},
+                   {32 * 1024, 1024 * 1024}})
+    ->UseRealTime();
+BENCHMARK(BM_AllGather)
+    ->ArgNames({"factory", "world", "size"})
+    ->ArgsProduct({kFactories, kWorldSizes, kCollectiveSizes})
+    ->UseRealTime();
+BENCHMARK(BM_Broadcast)
+    ->ArgNames({"factory", "world", "size"})
+    ->ArgsProduct({kFactories, kWorldSizes, kCollectiveSizes})
+    ->UseRealTime();
+BENCHMARK(BM_Gather)
+    ->ArgNames({"factory", "world", "size"})
+    ->ArgsProduct({kFactories, kWorldSizes, kCollectiveSizes})
+    ->UseRealTime();
+BENCHMARK(BM_Scatter)
+    ->ArgNames({"factory", "world", "size"})
+    ->ArgsProduct({kFactories, kWorldSizes, kCollectiveSizes})
+    ->UseRealTime();
+BENCHMARK(BM_Barrier)
+    ->ArgNames({"factory", "world"})
+    ->ArgsProduct({kFactories, kWorldSizes})
+    ->UseRealTime();
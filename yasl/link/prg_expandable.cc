@@ -0,0 +1,45 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/prg_expandable.h"
+
+#include <cstring>
+
+namespace yasl::link {
+
+void SendPrgSeed(const std::shared_ptr<Context>& ctx, size_t dst_rank,
+                 uint128_t seed, ByteContainerView correction,
+                 std::string_view tag) {
+  Buffer buf(static_cast<int64_t>(sizeof(seed) + correction.size()));
+  std::memcpy(buf.data(), &seed, sizeof(seed));
+  if (!correction.empty()) {
+    std::memcpy(buf.data<uint8_t>() + sizeof(seed), correction.data(),
+                correction.size());
+  }
+  ctx->SendAsync(dst_rank, std::move(buf), tag);
+}
+
+std::pair<uint128_t, Buffer> RecvPrgSeed(const std::shared_ptr<Context>& ctx,
+                                         size_t src_rank,
+                                         std::string_view tag) {
+  const auto buf = ctx->Recv(src_rank, tag);
+  YASL_ENFORCE(static_cast<size_t>(buf.size()) >= sizeof(uint128_t),
+               "prg seed msg of {} bytes is too short", buf.size());
+  uint128_t seed;
+  std::memcpy(&seed, buf.data(), sizeof(seed));
+  return {seed, Buffer(buf.data<uint8_t>() + sizeof(seed),
+                      buf.size() - sizeof(seed))};
+}
+
+}  // namespace yasl::link
@@ -0,0 +1,75 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <utility>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/byte_container_view.h"
+#include "yasl/base/exception.h"
+#include "yasl/base/int128.h"
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/link/context.h"
+#include "yasl/utils/rand.h"
+
+namespace yasl::link {
+
+// Transfers of correlated randomness whose bulk is prg output, which peer
+// regenerates from its 16 byte seed instead of receiving it. A msg is the
+// seed and a correction, the part of the values that is not random, e.g.
+// the c share of a dealt triple. Both sides expand the seed by
+// PseudoRandomGenerator<uint128_t> in the default mode, with the same Fill
+// calls in the same order, so the random part costs 16 bytes whatever its
+// size.
+//
+// The seed is the whole secret of the values it expands to, so it must be
+// fresh, as RandSeed, and must only go to the party meant to hold them.
+
+// Sends `seed`, and `correction` if any, to `dst_rank`.
+void SendPrgSeed(const std::shared_ptr<Context>& ctx, size_t dst_rank,
+                 uint128_t seed, ByteContainerView correction,
+                 std::string_view tag);
+
+// Receives the seed and the correction of SendPrgSeed, the correction is
+// empty if none was sent.
+std::pair<uint128_t, Buffer> RecvPrgSeed(const std::shared_ptr<Context>& ctx,
+                                         size_t src_rank,
+                                         std::string_view tag);
+
+// Fills `out` with fresh random values, which `dst_rank` gets into its
+// `out` by RecvPrgExpandable, for the cost of the seed.
+template <typename T>
+void SendPrgExpandable(const std::shared_ptr<Context>& ctx, size_t dst_rank,
+                       absl::Span<T> out, std::string_view tag) {
+  const uint128_t seed = RandSeed();
+  PseudoRandomGenerator<uint128_t>(seed).Fill(out);
+  SendPrgSeed(ctx, dst_rank, seed, {}, tag);
+}
+
+template <typename T>
+void RecvPrgExpandable(const std::shared_ptr<Context>& ctx, size_t src_rank,
+                       absl::Span<T> out, std::string_view tag) {
+  const auto [seed, correction] = RecvPrgSeed(ctx, src_rank, tag);
+  YASL_ENFORCE(correction.size() == 0,
+               "expected a bare seed, got a correction of {} bytes",
+               correction.size());
+  PseudoRandomGenerator<uint128_t>(seed).Fill(out);
+}
+
+}  // namespace yasl::link
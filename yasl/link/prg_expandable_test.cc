@@ -0,0 +1,64 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/prg_expandable.h"
+
+#include <future>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/link/test_util.h"
+
+namespace yasl::link {
+
+TEST(PrgExpandableTest, PeerGetsSameValues) {
+  auto ctxs = test::SetupWorld("prg_expandable", 2);
+  std::vector<uint64_t> sent(100000);
+  std::vector<uint64_t> received(sent.size());
+
+  auto f = std::async([&] {
+    RecvPrgExpandable(ctxs[1], 0, absl::MakeSpan(received), "values");
+  });
+  SendPrgExpandable(ctxs[0], 1, absl::MakeSpan(sent), "values");
+  f.get();
+
+  EXPECT_EQ(sent, received);
+  EXPECT_NE(sent, std::vector<uint64_t>(sent.size()));
+  // the seed is all that was sent.
+  EXPECT_EQ(ctxs[0]->GetStats()->sent_bytes, sizeof(uint128_t));
+}
+
+TEST(PrgExpandableTest, SeedWithCorrection) {
+  auto ctxs = test::SetupWorld("prg_seed", 2);
+  const std::string correction = "not random";
+
+  SendPrgSeed(ctxs[0], 1, 42, correction, "with");
+  SendPrgSeed(ctxs[0], 1, 43, {}, "without");
+  const auto [seed, got] = RecvPrgSeed(ctxs[1], 0, "with");
+  EXPECT_EQ(seed, 42);
+  EXPECT_EQ(std::string_view(got), correction);
+  const auto [bare_seed, none] = RecvPrgSeed(ctxs[1], 0, "without");
+  EXPECT_EQ(bare_seed, 43);
+  EXPECT_EQ(none.size(), 0);
+
+  // a correction where a bare seed is expected.
+  SendPrgSeed(ctxs[0], 1, 44, correction, "unexpected");
+  std::vector<uint128_t> out(4);
+  EXPECT_THROW(RecvPrgExpandable(ctxs[1], 0, absl::MakeSpan(out), "x"),
+               EnforceNotMet);
+}
+
+}  // namespace yasl::link
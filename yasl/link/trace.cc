@@ -66,11 +66,13 @@ DefaultLogger::DefaultLogger() {
 void DefaultLogger::LinkTraceImpl(std::string_view event, std::string_view tag,
                                   std::string_view content) {
   // trace this action anyway.
-  SPDLOG_TRACE("[LINK] key={},tag={}", event, tag);
+  // keys may be binary, see ContextDesc::compact_msg_keys.
+  SPDLOG_TRACE("[LINK] key={},tag={}", absl::CEscape(event), tag);
 
   // write to link file trace if enabled.
   if (logger_) {
-    SPDLOG_LOGGER_INFO(logger_, "[link] key={},tag={},value={}", event, tag,
+    SPDLOG_LOGGER_INFO(logger_, "[link] key={},tag={},value={}",
+                       absl::CEscape(event), tag,
                        absl::BytesToHexString(content));
   }
 }
@@ -14,10 +14,15 @@
 
 #include "yasl/link/transport/channel.h"
 
+#include <algorithm>
+#include <exception>
+#include <utility>
+
 #include "spdlog/spdlog.h"
 
 #include "yasl/base/byte_container_view.h"
 #include "yasl/base/exception.h"
+#include "yasl/utils/metrics.h"
 
 namespace yasl::link {
 
@@ -25,25 +30,138 @@ namespace yasl::link {
 // avoid conflict to normal msg key.
 static const std::string kAckKey{'A', 'C', 'K', '\x01', '\x00'};
 static const std::string kFinKey{'F', 'I', 'N', '\x01', '\x00'};
+// sent by a sender blocked in throttle window, asks peer for pending acks.
+static const std::string kAckReqKey{'A', 'R', 'Q', '\x01', '\x00'};
+// announces the recv buffer limit, peer applies it as its byte window.
+static const std::string kRecvLimitKey{'R', 'L', 'M', '\x01', '\x00'};
+// prefix of batch msg key, followed by a sequence number of the sender.
+static const std::string kBatchKeyPrefix{'B', 'A', 'T', '\x01', '\x00'};
+// prefix of encrypted msg key, followed by the original key.
+static const std::string kSealedKeyPrefix{'S', 'E', 'L', '\x01', '\x00'};
+
+// process wide metrics, summed over all channels. they are looked up on
+// first use, not during static initialization, where the registry may not be
+// constructed yet.
+static Counter& SentMsgs() {
+  static auto& counter = GetCounter("yasl_channel_sent_msgs_total");
+  return counter;
+}
+
+static Counter& SentBytes() {
+  static auto& counter = GetCounter("yasl_channel_sent_bytes_total");
+  return counter;
+}
+
+static Counter& RecvMsgs() {
+  static auto& counter = GetCounter("yasl_channel_recv_msgs_total");
+  return counter;
+}
+
+static Counter& RecvBytes() {
+  static auto& counter = GetCounter("yasl_channel_recv_bytes_total");
+  return counter;
+}
+
+static MetricHistogram& RecvWait() {
+  static auto& histogram = GetHistogram("yasl_channel_recv_wait_us");
+  return histogram;
+}
+
+static int64_t NowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static bool IsBatchKey(const std::string& key) {
+  return key.compare(0, kBatchKeyPrefix.size(), kBatchKeyPrefix) == 0;
+}
+
+static bool IsSealedKey(const std::string& key) {
+  return key.compare(0, kSealedKeyPrefix.size(), kSealedKeyPrefix) == 0;
+}
+
+// prefix of keys on a lane other than the default one, followed by the lane.
+static constexpr char kLaneKeyPrefix = '\xfb';
+
+std::string LaneKey(size_t lane, std::string_view key) {
+  YASL_ENFORCE(lane < ChannelBase::kMaxLanes, "invalid lane {}", lane);
+  if (lane == 0) {
+    return std::string(key);
+  }
+  std::string lane_key;
+  lane_key.reserve(key.size() + 2);
+  lane_key.push_back(kLaneKeyPrefix);
+  lane_key.push_back(static_cast<char>(lane));
+  lane_key.append(key);
+  return lane_key;
+}
+
+const std::string& AckMsgKey() { return kAckKey; }
+
+const std::string& AckRequestMsgKey() { return kAckReqKey; }
+
+static bool IsReservedKey(const std::string& key) {
+  return key == kAckKey || key == kFinKey || key == kAckReqKey ||
+         key == kRecvLimitKey || IsBatchKey(key) || IsSealedKey(key);
+}
 
 class ChunkedMessage {
  public:
   explicit ChunkedMessage(size_t num_chunks)
       : num_chunks_(num_chunks), message_size_(0) {}
 
-  void AddChunk(size_t index, ByteContainerView data) {
-    std::unique_lock lock(mutex_);
-    chunks_.emplace(index, data);
-    message_size_ += data.size();
+  // preallocated mode, chunks are written to their final offset on arrival.
+  ChunkedMessage(size_t num_chunks, size_t message_length)
+      : num_chunks_(num_chunks),
+        message_size_(message_length),
+        preallocated_(true),
+        message_(static_cast<int64_t>(message_length)),
+        received_(new std::atomic<bool>[num_chunks]) {
+    for (size_t idx = 0; idx < num_chunks; idx++) {
+      received_[idx] = false;
+    }
   }
 
-  size_t NumChunks() const { return num_chunks_; }
+  // returns true if the message is fully filled by this chunk, only one
+  // caller will see it.
+  bool AddChunk(size_t index, size_t offset, ByteContainerView data) {
+    YASL_ENFORCE(index < num_chunks_, "chunk index={} out of num_chunks={}",
+                 index, num_chunks_);
+    if (!preallocated_) {
+      std::unique_lock lock(mutex_);
+      if (!chunks_.emplace(index, data).second) {
+        return false;
+      }
+      message_size_ += data.size();
+      return chunks_.size() == num_chunks_;
+    }
 
-  size_t NumFilled() const { return chunks_.size(); }
+    YASL_ENFORCE(offset <= message_size_ &&
+                     data.size() <= message_size_ - offset,
+                 "chunk out of range, offset={}, size={}, message_length={}",
+                 offset, data.size(), message_size_);
+    if (received_[index].exchange(true)) {
+      // duplicated chunk, brpc may resend it on broken connection.
+      return false;
+    }
+    if (!data.empty()) {
+      std::memcpy(message_.data<uint8_t>() + offset, data.data(), data.size());
+    }
+    // acq_rel makes all chunk writes visible to the one who fills the last.
+    return filled_.fetch_add(1, std::memory_order_acq_rel) + 1 == num_chunks_;
+  }
 
-  bool IsFullyFilled() const { return chunks_.size() == num_chunks_; }
+  size_t NumChunks() const { return num_chunks_; }
+
+  // 0 for the map mode.
+  size_t MessageLength() const { return preallocated_ ? message_size_ : 0; }
 
   Buffer Reassemble() {
+    if (preallocated_) {
+      return std::move(message_);
+    }
+
     Buffer out(message_size_);
     size_t bytes_written = 0;
     for (auto& itr : chunks_) {
@@ -59,74 +177,451 @@ class ChunkedMessage {
  protected:
   const size_t num_chunks_;
 
+  // map mode, for peers which do not tell the message length.
   std::mutex mutex_;
   // chunk index to value.
   std::map<size_t, Buffer> chunks_;
   size_t message_size_;
+
+  // preallocated mode.
+  const bool preallocated_ = false;
+  Buffer message_;
+  std::unique_ptr<std::atomic<bool>[]> received_;
+  std::atomic<size_t> filled_ = 0;
 };
 
+uint64_t RecvNotifier::Seq() const {
+  std::unique_lock lock(mutex_);
+  return seq_;
+}
+
+void RecvNotifier::Notify() {
+  std::unique_lock lock(mutex_);
+  seq_++;
+  cond_.notify_all();
+}
+
+bool RecvNotifier::WaitUntil(uint64_t seq,
+                             std::chrono::steady_clock::time_point deadline) {
+  std::unique_lock lock(mutex_);
+  return cond_.wait_until(lock, deadline, [&] { return seq_ != seq; });
+}
+
+bool MessageDatabase::Put(const std::string& key, Buffer* value,
+                          RecvCallback* subscriber) {
+  auto& shard = GetShard(key);
+  std::unique_lock lock(shard.mutex);
+  auto sub_itr = shard.subscribers.find(key);
+  if (sub_itr != shard.subscribers.end()) {
+    *subscriber = std::move(sub_itr->second);
+    shard.subscribers.erase(sub_itr);
+    return true;
+  }
+  const size_t size = value->size();
+  if (!shard.values.emplace(key, std::move(*value)).second) {
+    return false;
+  }
+  const size_t unread_bytes = unread_bytes_ += size;
+  memory_->Add(size);
+  size_t peak = peak_unread_bytes_;
+  while (unread_bytes > peak &&
+         !peak_unread_bytes_.compare_exchange_weak(peak, unread_bytes)) {
+  }
+  auto itr = shard.waiters.find(key);
+  if (itr != shard.waiters.end()) {
+    itr->second.cond.notify_all();
+  }
+  auto watcher_itr = shard.watchers.find(key);
+  if (watcher_itr != shard.watchers.end()) {
+    watcher_itr->second->Notify();
+    shard.watchers.erase(watcher_itr);
+  }
+  return true;
+}
+
+bool MessageDatabase::TryPop(const std::string& key, Buffer* value) {
+  auto& shard = GetShard(key);
+  std::unique_lock lock(shard.mutex);
+  auto itr = shard.values.find(key);
+  if (itr == shard.values.end()) {
+    return false;
+  }
+  OnPop(itr->second);
+  *value = std::move(itr->second);
+  shard.values.erase(itr);
+  return true;
+}
+
+bool MessageDatabase::PopOrSubscribe(const std::string& key,
+                                     RecvCallback* callback, Buffer* value) {
+  auto& shard = GetShard(key);
+  std::unique_lock lock(shard.mutex);
+  auto itr = shard.values.find(key);
+  if (itr == shard.values.end()) {
+    YASL_ENFORCE(shard.subscribers.emplace(key, std::move(*callback)).second,
+                 "key={} is already subscribed", key);
+    return false;
+  }
+  OnPop(itr->second);
+  *value = std::move(itr->second);
+  shard.values.erase(itr);
+  return true;
+}
+
+bool MessageDatabase::PopOrWatch(
+    const std::string& key, Buffer* value,
+    const std::shared_ptr<RecvNotifier>& notifier) {
+  auto& shard = GetShard(key);
+  std::unique_lock lock(shard.mutex);
+  auto itr = shard.values.find(key);
+  if (itr == shard.values.end()) {
+    // a stale watcher of an earlier wait is replaced.
+    shard.watchers[key] = notifier;
+    return false;
+  }
+  OnPop(itr->second);
+  *value = std::move(itr->second);
+  shard.values.erase(itr);
+  return true;
+}
+
+void MessageDatabase::Unwatch(
+    const std::string& key, const std::shared_ptr<RecvNotifier>& notifier) {
+  auto& shard = GetShard(key);
+  std::unique_lock lock(shard.mutex);
+  auto itr = shard.watchers.find(key);
+  if (itr != shard.watchers.end() && itr->second == notifier) {
+    shard.watchers.erase(itr);
+  }
+}
+
+bool MessageDatabase::Pop(const std::string& key,
+                          std::chrono::milliseconds timeout, Buffer* value) {
+  auto& shard = GetShard(key);
+  std::unique_lock lock(shard.mutex);
+  auto& waiter = shard.waiters[key];
+  waiter.num_waiting++;
+  const bool arrived = waiter.cond.wait_for(lock, timeout, [&] {
+    return shard.values.find(key) != shard.values.end();
+  });
+  if (--waiter.num_waiting == 0) {
+    shard.waiters.erase(key);
+  }
+  if (!arrived) {
+    return false;
+  }
+  auto itr = shard.values.find(key);
+  OnPop(itr->second);
+  *value = std::move(itr->second);
+  shard.values.erase(itr);
+  return true;
+}
+
+std::vector<std::string> MessageDatabase::Clear(size_t* cleared_bytes) {
+  std::vector<std::string> keys;
+  *cleared_bytes = 0;
+  for (auto& shard : shards_) {
+    std::unique_lock lock(shard.mutex);
+    for (const auto& value : shard.values) {
+      keys.push_back(value.first);
+      *cleared_bytes += value.second.size();
+      OnPop(value.second);
+    }
+    shard.values.clear();
+    // never fired, futures waiting on them see a broken promise.
+    shard.subscribers.clear();
+    shard.watchers.clear();
+  }
+  return keys;
+}
+
+ChannelBase::~ChannelBase() {
+  for (auto& db : lane_dbs_) {
+    delete db.load();
+  }
+}
+
+size_t ChannelBase::NewLane() {
+  const size_t lane = ++lane_counter_;
+  YASL_ENFORCE(lane < kMaxLanes, "too many lanes, max={}", kMaxLanes - 1);
+  return lane;
+}
+
+MessageDatabase& ChannelBase::DbOf(const std::string& key) {
+  if (key.size() < 2 || key[0] != kLaneKeyPrefix || key[1] == 0) {
+    return msg_db_;
+  }
+  auto& slot = lane_dbs_[static_cast<uint8_t>(key[1])];
+  auto* db = slot.load(std::memory_order_acquire);
+  if (db == nullptr) {
+    auto fresh = std::make_unique<MessageDatabase>();
+    if (slot.compare_exchange_strong(db, fresh.get(),
+                                     std::memory_order_acq_rel)) {
+      db = fresh.release();
+    }
+  }
+  return *db;
+}
+
 Buffer ChannelBase::Recv(const std::string& key) {
-  YASL_ENFORCE(key != kAckKey && key != kFinKey,
+  YASL_ENFORCE(!IsReservedKey(key),
                "For developer: pls use another key for normal message.");
 
   Buffer value;
-  {
-    std::unique_lock lock(msg_mutex_);
-    const auto& duration = std::chrono::milliseconds(recv_timeout_ms_);
-    if (!msg_db_cond_.wait_for(lock, duration, [&] {
-          auto itr = this->msg_db_.find(key);
-          if (itr == this->msg_db_.end()) {
-            return false;
-          } else {
-            value = std::move(itr->second);
-            this->msg_db_.erase(itr);
-            return true;
-          }
-        })) {
+  if (!DbOf(key).TryPop(key, &value)) {
+    // we are going to block, the peer may be blocked by our pending acks
+    // too, flush them first.
+    FlushPendingAck();
+
+    ScopedTimer wait(&RecvWait());
+    if (!DbOf(key).Pop(key, std::chrono::milliseconds(recv_timeout_ms_),
+                       &value)) {
       YASL_THROW_IO_ERROR("Get data timeout, key={}", key);
     }
   }
-  SendAsyncImpl(kAckKey, ByteContainerView{});
+
+  AckOnRead(value.size());
 
   return value;
 }
 
+void ChannelBase::RecvAsync(const std::string& key, RecvCallback callback) {
+  YASL_ENFORCE(!IsReservedKey(key),
+               "For developer: pls use another key for normal message.");
+
+  Buffer value;
+  if (!DbOf(key).PopOrSubscribe(key, &callback, &value)) {
+    // peer may be blocked by our pending acks while we are not going to
+    // block in Recv, flush them.
+    FlushPendingAck();
+    return;
+  }
+
+  AckOnRead(value.size());
+  callback(std::move(value));
+}
+
+bool ChannelBase::TryRecv(const std::string& key, Buffer* value,
+                          const std::shared_ptr<RecvNotifier>& notifier) {
+  YASL_ENFORCE(!IsReservedKey(key),
+               "For developer: pls use another key for normal message.");
+
+  if (!DbOf(key).PopOrWatch(key, value, notifier)) {
+    // the caller is likely to block on the notifier, flush like Recv.
+    FlushPendingAck();
+    return false;
+  }
+
+  AckOnRead(value->size());
+  return true;
+}
+
+void ChannelBase::Unwatch(const std::string& key,
+                          const std::shared_ptr<RecvNotifier>& notifier) {
+  DbOf(key).Unwatch(key, notifier);
+}
+
+void ChannelBase::AckOnRead(size_t bytes) {
+  RecvMsgs().Add(1);
+  RecvBytes().Add(bytes);
+  pending_ack_bytes_ += bytes;
+  // ack at once if peer is blocked in throttle window waiting for it.
+  // concurrent receivers may both get here, the later one acks the rest.
+  if (pending_ack_count_.fetch_add(1) + 1 >= ack_batch_size_ ||
+      sent_ack_count_ < peer_ack_target_) {
+    FlushPendingAck();
+  }
+}
+
+void ChannelBase::FireRecvCallbacks() {
+  std::vector<std::pair<RecvCallback, Buffer>> ready;
+  {
+    std::unique_lock lock(msg_mutex_);
+    ready.swap(ready_callbacks_);
+  }
+  for (auto& [callback, value] : ready) {
+    AckOnRead(value.size());
+    try {
+      callback(std::move(value));
+    } catch (const std::exception& e) {
+      SPDLOG_ERROR("recv callback error={}", e.what());
+    }
+  }
+}
+
+// ack msg is (count, bytes), an empty one stands for a single msg.
+void ChannelBase::SendAck(size_t ack_count, size_t ack_bytes) {
+  if (ack_count == 0) {
+    return;
+  }
+  const size_t ack[2] = {ack_count, ack_bytes};
+  SendAsyncImpl(kAckKey, ByteContainerView{ack, sizeof(ack)});
+}
+
+std::pair<size_t, size_t> ChannelBase::TakePendingAck() {
+  const size_t ack_count = pending_ack_count_.exchange(0);
+  const size_t ack_bytes = pending_ack_bytes_.exchange(0);
+  sent_ack_count_ += ack_count;
+  return {ack_count, ack_bytes};
+}
+
+void ChannelBase::FlushPendingAck() {
+  const auto [ack_count, ack_bytes] = TakePendingAck();
+  SendAck(ack_count, ack_bytes);
+}
+
+// should be called with msg_mutex_ held.
 template <typename T>
 void ChannelBase::OnNormalMessage(const std::string& key, T&& v) {
   received_msg_count_++;
   if (!waiting_finish_) {
-    if (!msg_db_.emplace(key, std::forward<T>(v)).second) {
-      SendAsyncImpl(kAckKey, ByteContainerView{});
+    Buffer value(std::forward<T>(v));
+    RecvCallback subscriber;
+    if (!DbOf(key).Put(key, &value, &subscriber)) {
+      // bytes of the msg are acked by the first copy.
+      sent_ack_count_++;
+      SendAck(1, 0);
       SPDLOG_WARN("Duplicate key {}", key);
+    } else if (subscriber) {
+      ready_callbacks_.emplace_back(std::move(subscriber), std::move(value));
     }
   } else {
-    SendAsyncImpl(kAckKey, ByteContainerView{});
+    sent_ack_count_++;
+    SendAck(1, v.size());
     SPDLOG_WARN("Asymmetric logic exist, auto ack key {}", key);
   }
-  msg_db_cond_.notify_all();
+  if (received_fin_) {
+    recv_msg_cond_.notify_all();
+  }
 }
 
-void ChannelBase::OnMessage(const std::string& key, ByteContainerView value) {
+template <typename T>
+void ChannelBase::OnDataMessage(std::unique_lock<std::mutex>& lock,
+                                const std::string& key, T&& value) {
+  if (IsBatchKey(key)) {
+    OnBatchMessage(ByteContainerView(value));
+  } else {
+    OnNormalMessage(key, std::forward<T>(value));
+  }
+  if (!ready_callbacks_.empty()) {
+    lock.unlock();
+    FireRecvCallbacks();
+  }
+}
+
+template <typename T>
+void ChannelBase::OnSealedMessage(const std::string& sealed_key, T&& sealed) {
+  if (!encrypted_.load(std::memory_order_acquire)) {
+    std::unique_lock lock(msg_mutex_);
+    // check again under the lock, which SetCipher replays parked msgs with.
+    if (!encrypted_) {
+      parked_sealed_msgs_.emplace_back(sealed_key,
+                                       Buffer(std::forward<T>(sealed)));
+      return;
+    }
+  }
+
+  const std::string key = sealed_key.substr(kSealedKeyPrefix.size());
+  YASL_ENFORCE(!IsReservedKey(key) || IsBatchKey(key),
+               "invalid key of sealed msg");
+  auto value = cipher_->Open(key, std::forward<T>(sealed));
+  std::unique_lock lock(msg_mutex_);
+  OnDataMessage(lock, key, std::move(value));
+}
+
+template <typename T>
+void ChannelBase::OnMessageImpl(const std::string& key, T&& value) {
+  if (IsSealedKey(key)) {
+    OnSealedMessage(key, std::forward<T>(value));
+    return;
+  }
+
   std::unique_lock lock(msg_mutex_);
   if (key == kAckKey) {
-    ack_msg_count_++;
+    // acks are cumulative, an empty one stands for a single message.
+    size_t ack[2] = {1, 0};
+    if (value.size() != 0) {
+      YASL_ENFORCE(static_cast<size_t>(value.size()) == sizeof(ack));
+      std::memcpy(ack, value.data(), sizeof(ack));
+    }
+    const int64_t now_us = NowUs();
+    for (size_t order = ack_msg_count_ + 1; order <= ack_msg_count_ + ack[0];
+         order++) {
+      const auto& slot = send_slots_[order % kNumSendSlots];
+      if (slot.order.load(std::memory_order_acquire) == order) {
+        ack_latency_us_.Add(
+            now_us - slot.sent_us.load(std::memory_order_relaxed));
+      }
+    }
+    ack_msg_count_ += ack[0];
+    ack_msg_bytes_ += ack[1];
+    ack_fin_cond_.notify_all();
+  } else if (key == kAckReqKey) {
+    YASL_ENFORCE(static_cast<size_t>(value.size()) == sizeof(size_t));
+    size_t ack_target = 0;
+    std::memcpy(&ack_target, value.data(), sizeof(size_t));
+    if (ack_target > peer_ack_target_) {
+      peer_ack_target_ = ack_target;
+    }
+    if (sent_ack_count_ < ack_target) {
+      // never call into transport with msg_mutex_ held.
+      lock.unlock();
+      FlushPendingAck();
+    }
+  } else if (key == kRecvLimitKey) {
+    YASL_ENFORCE(static_cast<size_t>(value.size()) == sizeof(size_t));
+    size_t limit = 0;
+    std::memcpy(&limit, value.data(), sizeof(size_t));
+    peer_recv_limit_ = limit;
+    // a raised limit may open the window.
     ack_fin_cond_.notify_all();
   } else if (key == kFinKey) {
-    YASL_ENFORCE(value.size() == sizeof(size_t));
+    YASL_ENFORCE(static_cast<size_t>(value.size()) == sizeof(size_t));
     if (!received_fin_) {
       received_fin_ = true;
       std::memcpy(&peer_sent_msg_count_, value.data(), sizeof(size_t));
       ack_fin_cond_.notify_all();
     }
   } else {
-    OnNormalMessage(key, value);
+    YASL_ENFORCE(!encrypted_, "plain msg refused by encrypted link, key={}",
+                 key);
+    OnDataMessage(lock, key, std::forward<T>(value));
+  }
+}
+
+// batch msg is a sequence of (key length, key, value length, value).
+void ChannelBase::OnBatchMessage(ByteContainerView batch) {
+  size_t pos = 0;
+  auto read_field = [&]() {
+    size_t length = 0;
+    YASL_ENFORCE(pos + sizeof(size_t) <= batch.size(), "broken batch msg");
+    std::memcpy(&length, batch.data() + pos, sizeof(size_t));
+    pos += sizeof(size_t);
+    YASL_ENFORCE(length <= batch.size() - pos, "broken batch msg");
+    ByteContainerView field(batch.data() + pos, length);
+    pos += length;
+    return field;
+  };
+  while (pos < batch.size()) {
+    const auto key = read_field();
+    const auto value = read_field();
+    OnNormalMessage(std::string(key.begin(), key.end()), value);
   }
 }
 
+void ChannelBase::OnMessage(const std::string& key, ByteContainerView value) {
+  OnMessageImpl(key, value);
+}
+
+void ChannelBase::OnMessage(const std::string& key, Buffer&& value) {
+  OnMessageImpl(key, std::move(value));
+}
+
 void ChannelBase::OnChunkedMessage(const std::string& key,
                                    ByteContainerView value, size_t chunk_idx,
-                                   size_t num_chunks) {
-  YASL_ENFORCE(key != kAckKey && key != kFinKey,
+                                   size_t num_chunks, size_t offset,
+                                   size_t message_length) {
+  YASL_ENFORCE(!IsReservedKey(key) || IsBatchKey(key) || IsSealedKey(key),
                "For developer: pls use another key for normal message.");
   if (chunk_idx >= num_chunks) {
     YASL_THROW_LOGIC_ERROR("invalid chunk info, index={}, size={}", chunk_idx,
@@ -138,37 +633,40 @@ void ChannelBase::OnChunkedMessage(const std::string& key,
     std::unique_lock lock(chunked_values_mutex_);
     auto itr = chunked_values_.find(key);
     if (itr == chunked_values_.end()) {
-      itr = chunked_values_
-                .emplace(key, std::make_shared<ChunkedMessage>(num_chunks))
-                .first;
+      auto message = message_length == 0
+                         ? std::make_shared<ChunkedMessage>(num_chunks)
+                         : std::make_shared<ChunkedMessage>(num_chunks,
+                                                            message_length);
+      itr = chunked_values_.emplace(key, std::move(message)).first;
     }
     data = itr->second;
   }
-
-  data->AddChunk(chunk_idx, value);
-  {
-    bool should_reassemble = false;
-    if (data->IsFullyFilled()) {
-      // two threads may arrive here at same time.
+  // all chunks of a msg must agree on its shape.
+  YASL_ENFORCE(data->NumChunks() == num_chunks &&
+                   data->MessageLength() == message_length,
+               "inconsistent chunk info, key={}, num_chunks={}, "
+               "message_length={}, expect {} and {}",
+               key, num_chunks, message_length, data->NumChunks(),
+               data->MessageLength());
+
+  if (data->AddChunk(chunk_idx, offset, value)) {
+    // only the thread which fills the last chunk reaches here.
+    {
       std::unique_lock lock(chunked_values_mutex_);
-      auto const& itr = chunked_values_.find(key);
-      if (itr == chunked_values_.end()) {
-        // this data block is handled by another chunk, just return.
-        return;
-      }
-
       chunked_values_.erase(key);
-
-      // only one thread do the reassemble
-      should_reassemble = true;
     }
+    recv_chunks_.Add(num_chunks);
 
-    if (should_reassemble) {
-      // notify new value arrived.
-      auto reassembled_data = data->Reassemble();
-      std::unique_lock lock(msg_mutex_);
-      OnNormalMessage(key, std::move(reassembled_data));
+    // notify new value arrived.
+    auto reassembled_data = data->Reassemble();
+    if (IsSealedKey(key)) {
+      OnSealedMessage(key, std::move(reassembled_data));
+      return;
     }
+    YASL_ENFORCE(!encrypted_, "plain msg refused by encrypted link, key={}",
+                 key);
+    std::unique_lock lock(msg_mutex_);
+    OnDataMessage(lock, key, std::move(reassembled_data));
   }
 }
 
@@ -179,24 +677,140 @@ void ChannelBase::SetRecvTimeout(uint32_t recv_timeout_ms) {
 uint32_t ChannelBase::GetRecvTimeout() const { return recv_timeout_ms_; }
 
 void ChannelBase::SendAsync(const std::string& key, ByteContainerView value) {
-  YASL_ENFORCE(key != kAckKey && key != kFinKey,
+  YASL_ENFORCE(!IsReservedKey(key),
                "For developer: pls use another key for normal message.");
-  SendAsyncImpl(key, value);
-  ThrottleWindowWait(sent_msg_count_.fetch_add(1) + 1);
+  ByteWindowWait(value.size());
+  const int64_t sent_us = NowUs();
+  if (encrypted_.load(std::memory_order_acquire)) {
+    SendAsyncImpl(kSealedKeyPrefix + key, cipher_->Seal(key, value));
+  } else {
+    SendAsyncImpl(key, value);
+  }
+  sent_msg_bytes_ += value.size();
+  SentBytes().Add(value.size());
+  ThrottleWindowWait(OnMsgSent(1, sent_us));
 }
 
 void ChannelBase::SendAsync(const std::string& key, Buffer&& value) {
-  YASL_ENFORCE(key != kAckKey && key != kFinKey,
+  YASL_ENFORCE(!IsReservedKey(key),
+               "For developer: pls use another key for normal message.");
+  const size_t bytes = value.size();
+  ByteWindowWait(bytes);
+  const int64_t sent_us = NowUs();
+  if (encrypted_.load(std::memory_order_acquire)) {
+    SendAsyncImpl(kSealedKeyPrefix + key,
+                  cipher_->Seal(key, ByteContainerView(value)));
+  } else {
+    SendAsyncImpl(key, std::move(value));
+  }
+  sent_msg_bytes_ += bytes;
+  SentBytes().Add(bytes);
+  ThrottleWindowWait(OnMsgSent(1, sent_us));
+}
+
+void ChannelBase::SendAsync(const std::string& key, ByteChainView value) {
+  YASL_ENFORCE(!IsReservedKey(key),
                "For developer: pls use another key for normal message.");
-  SendAsyncImpl(key, value);
-  ThrottleWindowWait(sent_msg_count_.fetch_add(1) + 1);
+  const size_t bytes = value.size();
+  ByteWindowWait(bytes);
+  const int64_t sent_us = NowUs();
+  if (encrypted_.load(std::memory_order_acquire)) {
+    // the cipher seals a single range.
+    SendAsyncImpl(kSealedKeyPrefix + key,
+                  cipher_->Seal(key, ByteContainerView(value.Flatten())));
+  } else {
+    SendAsyncImpl(key, value);
+  }
+  sent_msg_bytes_ += bytes;
+  SentBytes().Add(bytes);
+  ThrottleWindowWait(OnMsgSent(1, sent_us));
+}
+
+void ChannelBase::SendAsyncImpl(const std::string& key, ByteChainView value) {
+  SendAsyncImpl(key, value.Flatten());
+}
+
+void ChannelBase::SendAsyncBatch(
+    std::vector<std::pair<std::string, Buffer>>&& msgs) {
+  if (msgs.empty()) {
+    return;
+  }
+  size_t batch_size = 0;
+  size_t value_bytes = 0;
+  for (const auto& msg : msgs) {
+    YASL_ENFORCE(!IsReservedKey(msg.first),
+                 "For developer: pls use another key for normal message.");
+    batch_size += 2 * sizeof(size_t) + msg.first.size() + msg.second.size();
+    value_bytes += msg.second.size();
+  }
+
+  Buffer batch(static_cast<int64_t>(batch_size));
+  auto* pos = batch.data<char>();
+  auto write_field = [&](const void* data, size_t length) {
+    std::memcpy(pos, &length, sizeof(size_t));
+    pos += sizeof(size_t);
+    if (length != 0) {
+      std::memcpy(pos, data, length);
+      pos += length;
+    }
+  };
+  for (const auto& msg : msgs) {
+    write_field(msg.first.data(), msg.first.size());
+    write_field(msg.second.data(), msg.second.size());
+  }
+
+  ByteWindowWait(value_bytes);
+  const int64_t sent_us = NowUs();
+  // distinct keys so that big batches in flight never mix up their chunks.
+  // the batch is sealed as a whole, by a single pass of the cipher.
+  const auto batch_key = kBatchKeyPrefix + std::to_string(batch_seq_++);
+  if (encrypted_.load(std::memory_order_acquire)) {
+    SendAsyncImpl(kSealedKeyPrefix + batch_key,
+                  cipher_->Seal(batch_key, ByteContainerView(batch)));
+  } else {
+    SendAsyncImpl(batch_key, std::move(batch));
+  }
+  sent_msg_bytes_ += value_bytes;
+  SentBytes().Add(value_bytes);
+  // every msg inside the batch is acked on its own, but the batch is throttled
+  // as a whole, by the order of its first msg.
+  ThrottleWindowWait(OnMsgSent(msgs.size(), sent_us));
 }
 
 void ChannelBase::Send(const std::string& key, ByteContainerView value) {
-  YASL_ENFORCE(key != kAckKey && key != kFinKey,
+  YASL_ENFORCE(!IsReservedKey(key),
                "For developer: pls use another key for normal message.");
-  SendImpl(key, value);
-  ThrottleWindowWait(sent_msg_count_.fetch_add(1) + 1);
+  ByteWindowWait(value.size());
+  const int64_t sent_us = NowUs();
+  if (encrypted_.load(std::memory_order_acquire)) {
+    const auto sealed = cipher_->Seal(key, value);
+    SendImpl(kSealedKeyPrefix + key, ByteContainerView(sealed));
+  } else {
+    SendImpl(key, value);
+  }
+  sent_msg_bytes_ += value.size();
+  SentBytes().Add(value.size());
+  ThrottleWindowWait(OnMsgSent(1, sent_us));
+}
+
+size_t ChannelBase::OnMsgSent(size_t num_msgs, int64_t sent_us) {
+  const size_t first = sent_msg_count_.fetch_add(num_msgs) + 1;
+  SentMsgs().Add(num_msgs);
+  for (size_t order = first; order < first + num_msgs; order++) {
+    auto& slot = send_slots_[order % kNumSendSlots];
+    slot.sent_us.store(sent_us, std::memory_order_relaxed);
+    slot.order.store(order, std::memory_order_release);
+  }
+  return first;
+}
+
+size_t ChannelBase::ByteWindow() const {
+  const size_t own = throttle_window_bytes_;
+  const size_t peer = peer_recv_limit_;
+  if (own == 0 || peer == 0) {
+    return std::max(own, peer);
+  }
+  return std::min(own, peer);
 }
 
 // all sender thread wait on it's send order.
@@ -204,16 +818,96 @@ void ChannelBase::ThrottleWindowWait(size_t wait_count) {
   if (throttle_window_size_ == 0) {
     return;
   }
+  auto window_open = [&] {
+    return (throttle_window_size_ == 0) ||
+           (ack_msg_count_ + throttle_window_size_ > wait_count);
+  };
+  WaitForAcks(window_open, wait_count + 1 - throttle_window_size_);
+}
+
+// a msg waits before it is sent, so that bytes in flight never exceed the
+// window, unless the msg is larger than the window, which goes once all msgs
+// before it are acked. concurrent senders may pass the check together.
+void ChannelBase::ByteWindowWait(size_t bytes) {
+  if (ByteWindow() == 0) {
+    return;
+  }
+  auto window_open = [&] {
+    const size_t window = ByteWindow();
+    const size_t sent = sent_msg_bytes_;
+    return (window == 0) || (sent <= ack_msg_bytes_) ||
+           (sent + bytes <= ack_msg_bytes_ + window);
+  };
+  // acks of all msgs sent so far surely open the window.
+  WaitForAcks(window_open, sent_msg_count_);
+}
+
+template <typename Pred>
+void ChannelBase::WaitForAcks(Pred window_open, size_t ack_target) {
   std::unique_lock<std::mutex> lock(msg_mutex_);
+  if (window_open()) {
+    return;
+  }
+  // peer may also wait for our acks to send more, flush before blocking.
+  lock.unlock();
+  FlushPendingAck();
+  // ask peer for the acks we are waiting for, it may hold them in batch.
+  SendAsyncImpl(kAckReqKey,
+                ByteContainerView{reinterpret_cast<const char*>(&ack_target),
+                                  sizeof(size_t)});
+  lock.lock();
+  const int64_t start_us = NowUs();
   const auto& duration = std::chrono::milliseconds(recv_timeout_ms_);
-  if (!ack_fin_cond_.wait_for(lock, duration, [&] {
-        return (throttle_window_size_ == 0) ||
-               (ack_msg_count_ + throttle_window_size_ > wait_count);
-      })) {
+  const bool opened = ack_fin_cond_.wait_for(lock, duration, window_open);
+  const int64_t wait_us = NowUs() - start_us;
+  throttled_sends_++;
+  throttled_ms_ += wait_us / 1000;
+  throttle_wait_us_.Add(wait_us);
+  if (!opened) {
     YASL_THROW_IO_ERROR("Throttle window wait timeout");
   }
 }
 
+void ChannelBase::SetRecvBufferLimit(size_t bytes) {
+  SendAsyncImpl(kRecvLimitKey,
+                ByteContainerView{reinterpret_cast<const char*>(&bytes),
+                                  sizeof(size_t)});
+}
+
+void ChannelBase::SetCipher(std::shared_ptr<ChannelCipher> cipher) {
+  YASL_ENFORCE(cipher != nullptr, "cipher should not be null");
+  std::vector<std::pair<std::string, Buffer>> parked;
+  {
+    std::unique_lock lock(msg_mutex_);
+    YASL_ENFORCE(!encrypted_, "cipher is already set");
+    cipher_ = std::move(cipher);
+    encrypted_.store(true, std::memory_order_release);
+    parked.swap(parked_sealed_msgs_);
+  }
+  for (auto& [key, value] : parked) {
+    OnSealedMessage(key, std::move(value));
+  }
+}
+
+ChannelStats ChannelBase::GetStats() const {
+  ChannelStats stats;
+  stats.throttled_sends = throttled_sends_;
+  stats.throttled_ms = throttled_ms_;
+  stats.unread_bytes = msg_db_.UnreadBytes();
+  // sum of peaks of all lanes, an upper bound of the channel peak.
+  stats.peak_unread_bytes = msg_db_.PeakUnreadBytes();
+  for (const auto& slot : lane_dbs_) {
+    if (const auto* db = slot.load(std::memory_order_acquire)) {
+      stats.unread_bytes += db->UnreadBytes();
+      stats.peak_unread_bytes += db->PeakUnreadBytes();
+    }
+  }
+  stats.ack_latency_us = ack_latency_us_.Snapshot();
+  stats.throttle_wait_us = throttle_wait_us_.Snapshot();
+  stats.recv_chunks = recv_chunks_.Snapshot();
+  return stats;
+}
+
 void ChannelBase::WaitForFinAndFlyingMsg() {
   size_t sent_msg_count = sent_msg_count_;
   SendAsyncImpl(
@@ -225,7 +919,7 @@ void ChannelBase::WaitForFinAndFlyingMsg() {
   }
   {
     std::unique_lock<std::mutex> lock(msg_mutex_);
-    msg_db_cond_.wait(
+    recv_msg_cond_.wait(
         lock, [&] { return received_msg_count_ >= peer_sent_msg_count_; });
     if (received_msg_count_ > peer_sent_msg_count_) {
       // brpc will reply msg if connection is break (not timeout!), may cause
@@ -238,13 +932,30 @@ void ChannelBase::WaitForFinAndFlyingMsg() {
 }
 
 void ChannelBase::StopReceivingAndAckUnreadMsgs() {
-  std::unique_lock<std::mutex> lock(msg_mutex_);
-  waiting_finish_ = true;
-  for (auto& msg : msg_db_) {
-    SPDLOG_WARN("Asymmetric logic exist, clear unread key {}", msg.first);
-    SendAsyncImpl(kAckKey, ByteContainerView{});
+  std::pair<size_t, size_t> ack;
+  {
+    std::unique_lock<std::mutex> lock(msg_mutex_);
+    waiting_finish_ = true;
+    size_t unread_bytes = 0;
+    auto unread_keys = msg_db_.Clear(&unread_bytes);
+    for (auto& slot : lane_dbs_) {
+      if (auto* db = slot.load(std::memory_order_acquire)) {
+        size_t lane_bytes = 0;
+        auto lane_keys = db->Clear(&lane_bytes);
+        unread_bytes += lane_bytes;
+        unread_keys.insert(unread_keys.end(), lane_keys.begin(),
+                           lane_keys.end());
+      }
+    }
+    for (const auto& key : unread_keys) {
+      SPDLOG_WARN("Asymmetric logic exist, clear unread key {}", key);
+    }
+    // ack both the read-but-not-acked and the unread msgs at once.
+    pending_ack_count_ += unread_keys.size();
+    pending_ack_bytes_ += unread_bytes;
+    ack = TakePendingAck();
   }
-  msg_db_.clear();
+  SendAck(ack.first, ack.second);
 }
 
 void ChannelBase::WaitForFlyingAck() {
@@ -14,18 +14,68 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "yasl/base/buffer.h"
 #include "yasl/base/byte_container_view.h"
+#include "yasl/base/exception.h"
+#include "yasl/base/memory_tracker.h"
+#include "yasl/link/transport/channel_cipher.h"
+#include "yasl/utils/hash.h"
+#include "yasl/utils/histogram.h"
 
 namespace yasl::link {
 
+// fired with the value of a key once it arrives, see IChannel::RecvAsync.
+using RecvCallback = std::function<void(Buffer&&)>;
+
+// Wakes up a thread waiting for msgs of many keys, which may live in many
+// channels, see IChannel::TryRecv.
+class RecvNotifier {
+ public:
+  // sequence of arrivals so far.
+  uint64_t Seq() const;
+
+  void Notify();
+
+  // wait for any arrival after `seq`, returns false on timeout.
+  bool WaitUntil(uint64_t seq, std::chrono::steady_clock::time_point deadline);
+
+ private:
+  mutable std::mutex mutex_;
+  std::condition_variable cond_;
+  uint64_t seq_ = 0;
+};
+
+// runtime statistics of a channel.
+struct ChannelStats {
+  // sends blocked by the throttle window, and the total time blocked.
+  size_t throttled_sends = 0;
+  size_t throttled_ms = 0;
+  // bytes received but not read yet, and the peak of it.
+  size_t unread_bytes = 0;
+  size_t peak_unread_bytes = 0;
+  // from sending a msg to its ack, which includes the time peer takes to
+  // read it, in microseconds.
+  HistogramSnapshot ack_latency_us;
+  // each wait of the throttle windows, in microseconds.
+  HistogramSnapshot throttle_wait_us;
+  // chunks of each received chunked msg.
+  HistogramSnapshot recv_chunks;
+};
+
 // A channel is basic interface for p2p communicator.
 class IChannel {
  public:
@@ -37,6 +87,15 @@ class IChannel {
 
   virtual void SendAsync(const std::string& key, Buffer&& value) = 0;
 
+  // SendAsync of the concatenation of the parts, received as a single msg.
+  // transports write the parts out one by one, no assembled copy is made.
+  virtual void SendAsync(const std::string& key, ByteChainView value) = 0;
+
+  // SendAsync many msgs by a single transport msg, each msg is still received
+  // and acknowledged by its own key.
+  virtual void SendAsyncBatch(
+      std::vector<std::pair<std::string, Buffer>>&& msgs) = 0;
+
   // SendAsync synchronously.
   // return when the message is successfully pushed into the send buffer.
   // raise when push buffer overflow.
@@ -46,12 +105,33 @@ class IChannel {
   // block waiting message.
   virtual Buffer Recv(const std::string& key) = 0;
 
+  // returns at once, `callback` is fired by the receiver loop thread when the
+  // message arrives, or by the calling thread if it is already there. no
+  // thread is parked for it, so callback should be light.
+  virtual void RecvAsync(const std::string& key, RecvCallback callback) = 0;
+
+  // pop the msg of key if it is already there, otherwise `notifier` is
+  // notified once it arrives. never blocks, for waiting on many keys.
+  virtual bool TryRecv(const std::string& key, Buffer* value,
+                       const std::shared_ptr<RecvNotifier>& notifier) = 0;
+
+  // stops notifying `notifier` of key once the wait of TryRecv is over. noop
+  // for channels keeping no watchers.
+  virtual void Unwatch(const std::string& key,
+                       const std::shared_ptr<RecvNotifier>& notifier) {}
+
   // called by an async dispatcher.
   virtual void OnMessage(const std::string& key, ByteContainerView value) = 0;
 
+  // called by an async dispatcher, which hands over the ownership of value.
+  virtual void OnMessage(const std::string& key, Buffer&& value) = 0;
+
   // called by an async dispatcher.
+  // `offset` is the position of this chunk inside the whole message, and
+  // `message_length` is the total length of the message, or zero if unknown.
   virtual void OnChunkedMessage(const std::string& key, ByteContainerView value,
-                                size_t chunk_idx, size_t num_chunks) = 0;
+                                size_t chunk_idx, size_t num_chunks,
+                                size_t offset, size_t message_length) = 0;
   // set receive timeout ms
   virtual void SetRecvTimeout(uint32_t timeout_ms) = 0;
 
@@ -63,11 +143,120 @@ class IChannel {
 
   // set send throttle window size
   virtual void SetThrottleWindowSize(size_t) = 0;
+
+  // set how many received msgs are acknowledged by a single ack msg.
+  virtual void SetAckBatchSize(size_t) = 0;
+
+  // set send throttle window in bytes, bytes sent but not read by peer are
+  // kept under it, a single larger msg is still sent alone. 0 means no limit.
+  virtual void SetThrottleWindowBytes(size_t) = 0;
+
+  // cap the bytes received from peer but not read yet, it is announced to
+  // peer and applied as peer's byte window. 0 means no limit.
+  // Note: call it once connected.
+  virtual void SetRecvBufferLimit(size_t) = 0;
+
+  virtual ChannelStats GetStats() const = 0;
+
+  // encrypt normal msgs to peer and decrypt the ones from peer by `cipher`,
+  // once set plain msgs from peer are refused. msgs sealed by peer before it
+  // is set are kept until then. control msgs of the channel itself, e.g.
+  // acks, are not encrypted.
+  virtual void SetCipher(std::shared_ptr<ChannelCipher> cipher) = 0;
+
+  // allocate a new lane, whose msgs are kept and waited apart from the other
+  // lanes. both sides must allocate lanes in the same order, see LaneKey.
+  virtual size_t NewLane() = 0;
 };
 
+// key of `key` on `lane`, lane 0 is the default one and keeps keys as is.
+std::string LaneKey(size_t lane, std::string_view key);
+
+// keys of the ack msgs of a channel, for transports which carry them out of
+// band, see ChannelShm. an ack value is two size_t, the count and bytes of
+// the msgs acked, an ack request value is the size_t count asked for.
+const std::string& AckMsgKey();
+const std::string& AckRequestMsgKey();
+
 // forward declaractions.
 class ChunkedMessage;
 
+// MessageDatabase holds received but unread messages. Keys are hashed to
+// shards, and every key being waited has its own condition variable, so that
+// an arrival only wakes up the receiver waiting for that very key.
+class MessageDatabase {
+ public:
+  ~MessageDatabase() { memory_->Add(-static_cast<int64_t>(unread_bytes_)); }
+
+  // returns false if the key already exists. if a callback is subscribed to
+  // the key, the value is not stored but left in place, and the callback is
+  // moved to `subscriber` for the caller to fire without locks.
+  bool Put(const std::string& key, Buffer* value, RecvCallback* subscriber);
+
+  // pop the value of key if it exists.
+  bool TryPop(const std::string& key, Buffer* value);
+
+  // pop the value of key if it exists, otherwise `callback` is moved in and
+  // handed out by the Put of the key.
+  bool PopOrSubscribe(const std::string& key, RecvCallback* callback,
+                      Buffer* value);
+
+  // pop the value of key if it exists, otherwise `notifier` is notified by
+  // the Put of the key, which still stores the value.
+  bool PopOrWatch(const std::string& key, Buffer* value,
+                  const std::shared_ptr<RecvNotifier>& notifier);
+
+  // removes the watcher of key if it is `notifier`.
+  void Unwatch(const std::string& key,
+               const std::shared_ptr<RecvNotifier>& notifier);
+
+  // block until the key arrives or timeout, returns false on timeout.
+  bool Pop(const std::string& key, std::chrono::milliseconds timeout,
+           Buffer* value);
+
+  // remove all messages and subscribers, and return keys of the messages.
+  std::vector<std::string> Clear(size_t* cleared_bytes);
+
+  size_t UnreadBytes() const { return unread_bytes_; }
+
+  size_t PeakUnreadBytes() const { return peak_unread_bytes_; }
+
+ private:
+  struct Waiter {
+    std::condition_variable cond;
+    size_t num_waiting = 0;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    utils::FastHashMap<std::string, Buffer> values;
+    // unordered_map never invalidates references to its elements.
+    std::unordered_map<std::string, Waiter, utils::FastHasher> waiters;
+    utils::FastHashMap<std::string, RecvCallback> subscribers;
+    utils::FastHashMap<std::string, std::shared_ptr<RecvNotifier>> watchers;
+  };
+
+  static constexpr size_t kNumShards = 16;
+
+  // by the high bits, the maps of a shard tell keys apart by the low ones.
+  Shard& GetShard(const std::string& key) {
+    return shards_[(utils::FastHash(key) >> 32) % kNumShards];
+  }
+
+  // called with the shard lock of the popped value held.
+  void OnPop(const Buffer& value) {
+    unread_bytes_ -= value.size();
+    memory_->Add(-value.size());
+  }
+
+  std::array<Shard, kNumShards> shards_;
+
+  std::atomic<size_t> unread_bytes_ = 0;
+  std::atomic<size_t> peak_unread_bytes_ = 0;
+  // unread bytes of all channels.
+  MemoryTag* const memory_ = MemoryTag::Get("link.msg_db");
+};
+
 class ChannelBase : public IChannel {
  public:
   ChannelBase(size_t self_rank, size_t peer_rank)
@@ -78,18 +267,36 @@ class ChannelBase : public IChannel {
         peer_rank_(peer_rank),
         recv_timeout_ms_(recv_timeout_ms) {}
 
+  ~ChannelBase() override;
+
   void SendAsync(const std::string& key, ByteContainerView value) final;
 
   void SendAsync(const std::string& key, Buffer&& value) final;
 
+  void SendAsync(const std::string& key, ByteChainView value) final;
+
+  void SendAsyncBatch(
+      std::vector<std::pair<std::string, Buffer>>&& msgs) final;
+
   void Send(const std::string& key, ByteContainerView value) final;
 
   Buffer Recv(const std::string& key) override;
 
+  void RecvAsync(const std::string& key, RecvCallback callback) override;
+
+  bool TryRecv(const std::string& key, Buffer* value,
+               const std::shared_ptr<RecvNotifier>& notifier) override;
+
+  void Unwatch(const std::string& key,
+               const std::shared_ptr<RecvNotifier>& notifier) override;
+
   void OnMessage(const std::string& key, ByteContainerView value) override;
 
+  void OnMessage(const std::string& key, Buffer&& value) override;
+
   void OnChunkedMessage(const std::string& key, ByteContainerView value,
-                        size_t chunk_idx, size_t num_chunks) override;
+                        size_t chunk_idx, size_t num_chunks, size_t offset,
+                        size_t message_length) override;
 
   void SetRecvTimeout(uint32_t recv_timeout_ms) override;
 
@@ -101,6 +308,25 @@ class ChannelBase : public IChannel {
     throttle_window_size_ = size;
   }
 
+  void SetAckBatchSize(size_t size) final {
+    YASL_ENFORCE(size > 0, "ack batch size should be positive");
+    ack_batch_size_ = size;
+  }
+
+  void SetThrottleWindowBytes(size_t bytes) final {
+    throttle_window_bytes_ = bytes;
+  }
+
+  void SetRecvBufferLimit(size_t bytes) final;
+
+  ChannelStats GetStats() const final;
+
+  void SetCipher(std::shared_ptr<ChannelCipher> cipher) final;
+
+  size_t NewLane() final;
+
+  static constexpr size_t kMaxLanes = 256;
+
   // wait for all SendAsync Done.
   virtual void WaitAsyncSendToFinish() = 0;
 
@@ -110,30 +336,88 @@ class ChannelBase : public IChannel {
 
   virtual void SendAsyncImpl(const std::string& key, Buffer&& value) = 0;
 
+  // flattens the chain by default, for transports which copy it anyway.
+  virtual void SendAsyncImpl(const std::string& key, ByteChainView value);
+
   virtual void SendImpl(const std::string& key, ByteContainerView value) = 0;
 
  private:
-  void ThrottleWindowWait(size_t);
+  // count `num_msgs` msgs sent at `sent_us`, returns the order of the first.
+  size_t OnMsgSent(size_t num_msgs, int64_t sent_us);
+
+  void ThrottleWindowWait(size_t wait_count);
+
+  // wait until a msg of `bytes` long fits into the byte window.
+  void ByteWindowWait(size_t bytes);
+
+  // block until `window_open`, asking peer for acks up to `ack_target`.
+  template <typename Pred>
+  void WaitForAcks(Pred window_open, size_t ack_target);
+
+  // the byte window to apply, the smaller one of ours and peer's limit.
+  size_t ByteWindow() const;
 
   void StopReceivingAndAckUnreadMsgs();
 
+  // send a cumulative ack for `ack_count` msgs of `ack_bytes` in total, do
+  // nothing if `ack_count` is zero.
+  void SendAck(size_t ack_count, size_t ack_bytes);
+
+  // take all pending acks to send, and account them as sent, returns the
+  // count and bytes of them.
+  std::pair<size_t, size_t> TakePendingAck();
+
+  // send all pending acks, should not be called with msg_mutex_ held.
+  void FlushPendingAck();
+
+  // account a msg of `bytes` read by user, and ack if needed.
+  void AckOnRead(size_t bytes);
+
+  // fire callbacks of arrived msgs, should not be called with msg_mutex_ held.
+  void FireRecvCallbacks();
+
   void WaitForFinAndFlyingMsg();
 
   void WaitForFlyingAck();
 
+  template <typename T>
+  void OnMessageImpl(const std::string&, T&&);
+
+  // should be called with msg_mutex_ held.
+  void OnBatchMessage(ByteContainerView batch);
+
   template <typename T>
   void OnNormalMessage(const std::string&, T&&);
 
+  // dispatch a normal or batch msg, should be called with msg_mutex_ held by
+  // `lock`, which is released to fire callbacks.
+  template <typename T>
+  void OnDataMessage(std::unique_lock<std::mutex>& lock, const std::string&,
+                     T&&);
+
+  template <typename T>
+  void OnSealedMessage(const std::string&, T&&);
+
+  // the msg database of the lane `key` belongs to.
+  MessageDatabase& DbOf(const std::string& key);
+
  protected:
   const size_t self_rank_;
   const size_t peer_rank_;
 
   uint32_t recv_timeout_ms_ = 3 * 60 * 1000;  // 3 minites
 
-  // message database related.
+  // protects the ack/fin related states below, msg_db_ has its own locks.
+  // lock order: msg_mutex_ first, then the locks inside msg_db_.
   std::mutex msg_mutex_;
-  std::condition_variable msg_db_cond_;
-  std::map<std::string, Buffer> msg_db_;
+  // notified on normal msg arrival once peer's fin is received, for fin wait.
+  std::condition_variable recv_msg_cond_;
+  MessageDatabase msg_db_;
+  // msg databases of the other lanes, created on their first msg.
+  std::array<std::atomic<MessageDatabase*>, kMaxLanes> lane_dbs_{};
+  std::atomic<size_t> lane_counter_ = 0;
+  // arrived msgs of RecvAsync, to be fired once msg_mutex_ is released.
+  std::vector<std::pair<RecvCallback, Buffer>> ready_callbacks_;
 
   // if WaitLinkTaskFinish is called.
   // auto ack all normal msg if true.
@@ -142,10 +426,43 @@ class ChannelBase : public IChannel {
   std::atomic<size_t> throttle_window_size_ = 0;
   // count for normal msg sent to peer.
   std::atomic<size_t> sent_msg_count_ = 0;
+  // for byte window, bytes of normal msg sent to peer.
+  std::atomic<size_t> throttle_window_bytes_ = 0;
+  std::atomic<size_t> sent_msg_bytes_ = 0;
+  // the recv buffer limit announced by peer.
+  std::atomic<size_t> peer_recv_limit_ = 0;
+  std::atomic<size_t> throttled_sends_ = 0;
+  std::atomic<size_t> throttled_ms_ = 0;
+  Histogram ack_latency_us_;
+  Histogram throttle_wait_us_;
+  Histogram recv_chunks_;
+  // send time of recent msgs by their order modulo the slot count, to
+  // measure ack latency. a slot overwritten before its ack is skipped.
+  struct SendSlot {
+    std::atomic<size_t> order = 0;
+    std::atomic<int64_t> sent_us = 0;
+  };
+  static constexpr size_t kNumSendSlots = 1024;
+  std::array<SendSlot, kNumSendSlots> send_slots_;
+  // sequence number for batch msg keys.
+  std::atomic<size_t> batch_seq_ = 0;
   // count for received normal msg from peer.
   size_t received_msg_count_ = 0;
-  // count for received ack msg from peer.
+  // count and bytes of msgs acknowledged by peer.
   size_t ack_msg_count_ = 0;
+  size_t ack_msg_bytes_ = 0;
+  // acks are coalesced, one ack msg per `ack_batch_size_` received msgs.
+  // pending acks are also flushed before this side blocks, in Recv or in
+  // ThrottleWindowWait, or when a blocked peer asks for them.
+  std::atomic<size_t> ack_batch_size_ = 16;
+  // count and bytes of read msgs not acknowledged yet.
+  std::atomic<size_t> pending_ack_count_ = 0;
+  std::atomic<size_t> pending_ack_bytes_ = 0;
+  // count for msgs acknowledged to peer.
+  std::atomic<size_t> sent_ack_count_ = 0;
+  // a sender blocked in throttle window asks for acks up to this count,
+  // which are sent without batching until it is reached.
+  std::atomic<size_t> peer_ack_target_ = 0;
   // if peer's fin msg is received.
   bool received_fin_ = false;
   // and how many normal msg sent by peer.
@@ -153,6 +470,12 @@ class ChannelBase : public IChannel {
   // cond for ack/fin wait.
   std::condition_variable ack_fin_cond_;
 
+  // set once by SetCipher before `encrypted_`, never changed after.
+  std::shared_ptr<ChannelCipher> cipher_;
+  std::atomic<bool> encrypted_ = false;
+  // sealed msgs arrived before the cipher is set.
+  std::vector<std::pair<std::string, Buffer>> parked_sealed_msgs_;
+
   // chunking related.
   std::mutex chunked_values_mutex_;
   std::map<std::string, std::shared_ptr<ChunkedMessage>> chunked_values_;
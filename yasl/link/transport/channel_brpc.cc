@@ -14,9 +14,17 @@
 
 #include "yasl/link/transport/channel_brpc.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <type_traits>
 
+#include "bthread/bthread.h"
 #include "spdlog/spdlog.h"
+#include "zlib.h"
 
 #include "yasl/base/exception.h"
 
@@ -25,69 +33,295 @@
 namespace yasl::link {
 namespace internal {
 
+// Takes over the bytes held by `iobuf` as a Buffer. A payload that lives in a
+// single, properly aligned block is wrapped in place, otherwise it is
+// flattened with exactly one copy.
+Buffer IOBufToBuffer(butil::IOBuf* iobuf) {
+  const size_t size = iobuf->size();
+  if (size == 0) {
+    return {};
+  }
+
+  if (iobuf->backing_block_num() == 1) {
+    const auto block = iobuf->backing_block(0);
+    if (reinterpret_cast<uintptr_t>(block.data()) % 16 == 0) {
+      auto* holder = new butil::IOBuf();
+      holder->swap(*iobuf);
+      return {const_cast<char*>(block.data()), size,
+              [holder](void* /*ptr*/) { delete holder; }};
+    }
+  }
+
+  Buffer buf(static_cast<int64_t>(size));
+  iobuf->copy_to(buf.data(), size);
+  iobuf->clear();
+  return buf;
+}
+
+// Returns a view of the payload carried by the request. The attachment is
+// viewed in place if it is contiguous, otherwise flattened into `holder`.
+ByteContainerView PayloadView(const pb::PushRequest* request,
+                              butil::IOBuf* attachment, Buffer* holder) {
+  if (!request->value().empty()) {
+    return ByteContainerView(request->value());
+  }
+  if (attachment->backing_block_num() <= 1) {
+    const auto block = attachment->backing_block(0);
+    return ByteContainerView(block.data(), block.size());
+  }
+  *holder = IOBufToBuffer(attachment);
+  return ByteContainerView(*holder);
+}
+
+Buffer Decompress(const pb::PushRequest* request, ByteContainerView value) {
+  if (request->compress_type() != pb::CompressType::COMPRESS_ZLIB) {
+    YASL_THROW_LOGIC_ERROR("unsupported compress type={}",
+                           request->compress_type());
+  }
+  Buffer raw(static_cast<int64_t>(request->raw_length()));
+  uLongf raw_length = request->raw_length();
+  const int ret = uncompress(raw.data<Bytef>(), &raw_length,
+                             reinterpret_cast<const Bytef*>(value.data()),
+                             value.size());
+  YASL_ENFORCE(ret == Z_OK && raw_length == request->raw_length(),
+               "zlib uncompress failed, ret={}, length={}, expected={}", ret,
+               raw_length, request->raw_length());
+  return raw;
+}
+
+// Header of a msg on the bulk stream, followed by the key and the value. The
+// stream is parsed as a byte stream, regardless of how it is segmented.
+struct StreamMsgHeader {
+  uint32_t key_length;
+  uint64_t value_length;
+} __attribute__((packed));
+
+// Reassembles the msgs of one sender's stream and dispatches them to the
+// listener. It is owned by the stream and released once the stream closes.
+class StreamReceiver : public brpc::StreamInputHandler {
+ public:
+  StreamReceiver(size_t sender_rank, std::shared_ptr<IChannel> listener)
+      : sender_rank_(sender_rank), listener_(std::move(listener)) {}
+
+  int on_received_messages(brpc::StreamId /*id*/,
+                           butil::IOBuf* const messages[],
+                           size_t size) override {
+    for (size_t idx = 0; idx < size; idx++) {
+      pending_.append(butil::IOBuf::Movable(*messages[idx]));
+    }
+
+    try {
+      while (Dispatch()) {
+      }
+    } catch (const std::exception& e) {
+      SPDLOG_ERROR("stream dispatch error, from rank={}, key={}, error={}",
+                   sender_rank_, key_, e.what());
+    }
+    return 0;
+  }
+
+  void on_idle_timeout(brpc::StreamId /*id*/) override {}
+
+  void on_closed(brpc::StreamId /*id*/) override {
+    if (has_header_ || !pending_.empty()) {
+      SPDLOG_WARN("stream from rank={} closed with a partial msg, key={}",
+                  sender_rank_, key_);
+    }
+    delete this;
+  }
+
+ private:
+  // dispatch the next msg if it is complete, returns false otherwise.
+  bool Dispatch() {
+    if (!has_header_) {
+      if (pending_.size() < sizeof(StreamMsgHeader)) {
+        return false;
+      }
+      StreamMsgHeader header;
+      pending_.copy_to(&header, sizeof(header));
+      if (pending_.size() < sizeof(header) + header.key_length) {
+        return false;
+      }
+      pending_.pop_front(sizeof(header));
+      key_.resize(header.key_length);
+      pending_.cutn(key_.data(), header.key_length);
+      value_length_ = header.value_length;
+      has_header_ = true;
+    }
+
+    if (pending_.size() < value_length_) {
+      return false;
+    }
+    butil::IOBuf value;
+    pending_.cutn(&value, value_length_);
+    has_header_ = false;
+    listener_->OnMessage(key_, IOBufToBuffer(&value));
+    return true;
+  }
+
+  const size_t sender_rank_;
+  const std::shared_ptr<IChannel> listener_;
+
+  // received bytes not dispatched yet.
+  butil::IOBuf pending_;
+  // the msg being received.
+  bool has_header_ = false;
+  std::string key_;
+  size_t value_length_ = 0;
+};
+
 class ReceiverServiceImpl : public pb::ReceiverService {
  public:
   explicit ReceiverServiceImpl(
       std::map<size_t, std::shared_ptr<IChannel>> listener)
       : listeners_(std::move(listener)) {}
 
-  void Push(::google::protobuf::RpcController* /*cntl_base*/,
+  void Push(::google::protobuf::RpcController* cntl_base,
             const pb::PushRequest* request, pb::PushResponse* response,
             ::google::protobuf::Closure* done) override {
     brpc::ClosureGuard done_guard(done);
+    auto* cntl = static_cast<brpc::Controller*>(cntl_base);
+
+    const size_t sender_rank = request->sender_rank();
+    const uint64_t seq = request->seq();
+    auto seq_channel = seq != 0 ? BrpcListener(sender_rank) : nullptr;
+    if (seq_channel != nullptr) {
+      switch (seq_channel->AcceptPushSeq(seq)) {
+        case ChannelBrpc::PushSeqState::kDelivered:
+          // a resent request whose first copy was delivered, ack it again.
+          response->set_error_code(pb::ErrorCode::SUCCESS);
+          return;
+        case ChannelBrpc::PushSeqState::kDropped:
+          response->set_error_code(pb::ErrorCode::INVALID_REQUEST);
+          response->set_error_msg(
+              fmt::format("push seq={} from rank={} was given up, key={}", seq,
+                          sender_rank, request->key()));
+          return;
+        case ChannelBrpc::PushSeqState::kAccepted:
+          break;
+      }
+    }
 
+    bool delivered = false;
     try {
-      const size_t sender_rank = request->sender_rank();
       const auto& trans_type = request->trans_type();
 
+      // payload is carried by the attachment, the `value` field is only used
+      // by protocols without attachment support.
+      auto& attachment = cntl->request_attachment();
+
+      const bool compressed =
+          request->compress_type() != pb::CompressType::COMPRESS_NONE;
+
       // dispatch the message
       if (trans_type == pb::TransType::MONO) {
-        OnRpcCall(sender_rank, request->key(), request->value());
+        if (compressed) {
+          Buffer holder;
+          OnRpcCall(sender_rank, request->key(),
+                    Decompress(request, PayloadView(request, &attachment,
+                                                    &holder)));
+        } else if (request->value().empty()) {
+          OnRpcCall(sender_rank, request->key(), IOBufToBuffer(&attachment));
+        } else {
+          OnRpcCall(sender_rank, request->key(),
+                    ByteContainerView(request->value()));
+        }
       } else if (trans_type == pb::TransType::CHUNKED) {
         const auto& chunk = request->chunk_info();
-        OnRpcCall(sender_rank, request->key(), request->value(),
-                  chunk.chunk_index(), chunk.num_chunks());
+        // a chunk is copied into the reassembled message anyway, avoid
+        // flattening it when it is already contiguous.
+        Buffer holder;
+        auto value = PayloadView(request, &attachment, &holder);
+        if (compressed) {
+          holder = Decompress(request, value);
+          value = ByteContainerView(holder);
+        }
+        OnRpcCall(sender_rank, request->key(), value, chunk);
       } else {
-        response->set_error_code(pb::ErrorCode::INVALID_REQUEST);
-        response->set_error_msg(
-            fmt::format("unrecongnized trans type={}, from rank={}", trans_type,
-                        sender_rank));
+        YASL_THROW_INVALID_FORMAT("unrecongnized trans type={}, from rank={}",
+                                  trans_type, sender_rank);
       }
+      delivered = true;
       response->set_error_code(pb::ErrorCode::SUCCESS);
       response->set_error_msg("");
+    } catch (const ::yasl::InvalidFormat& e) {
+      response->set_error_code(pb::ErrorCode::INVALID_REQUEST);
+      response->set_error_msg(e.what());
     } catch (const std::exception& e) {
       response->set_error_code(pb::ErrorCode::UNEXPECTED_ERROR);
       response->set_error_msg(fmt::format("dispatch error, key={}, error={}",
                                           request->key(), e.what()));
     }
+    // a request failed to dispatch stays open for its resend.
+    if (seq_channel != nullptr) {
+      seq_channel->FinishPushSeq(seq, delivered);
+    }
+  }
+
+  void OpenStream(::google::protobuf::RpcController* cntl_base,
+                  const pb::OpenStreamRequest* request,
+                  pb::PushResponse* response,
+                  ::google::protobuf::Closure* done) override {
+    brpc::ClosureGuard done_guard(done);
+    auto* cntl = static_cast<brpc::Controller*>(cntl_base);
+
+    const size_t sender_rank = request->sender_rank();
+    auto itr = listeners_.find(sender_rank);
+    if (itr == listeners_.end()) {
+      response->set_error_code(pb::ErrorCode::INVALID_REQUEST);
+      response->set_error_msg(fmt::format(
+          "open stream error, listener rank={} not found", sender_rank));
+      return;
+    }
+
+    auto* handler = new StreamReceiver(sender_rank, itr->second);
+    brpc::StreamOptions options;
+    options.handler = handler;
+    brpc::StreamId stream_id;
+    if (brpc::StreamAccept(&stream_id, *cntl, &options) != 0) {
+      delete handler;
+      response->set_error_code(pb::ErrorCode::NETWORK_ERROR);
+      response->set_error_msg(fmt::format(
+          "open stream error, failed to accept, from rank={}", sender_rank));
+      return;
+    }
+    response->set_error_code(pb::ErrorCode::SUCCESS);
   }
 
  protected:
   std::map<size_t, std::shared_ptr<IChannel>> listeners_;
 
  private:
-  void OnRpcCall(size_t src_rank, const std::string& key,
-                 const std::string& value) {
+  // the listener of src_rank if it tracks push seqs.
+  std::shared_ptr<ChannelBrpc> BrpcListener(size_t src_rank) const {
+    auto itr = listeners_.find(src_rank);
+    if (itr == listeners_.end()) {
+      return nullptr;
+    }
+    return std::dynamic_pointer_cast<ChannelBrpc>(itr->second);
+  }
+
+  template <typename ValueType>
+  void OnRpcCall(size_t src_rank, const std::string& key, ValueType&& value) {
     auto itr = listeners_.find(src_rank);
     if (itr == listeners_.end()) {
       YASL_THROW_LOGIC_ERROR("dispatch error, listener rank={} not found",
                              src_rank);
     }
-    // TODO: maybe need std::string_view interface to avoid memcpy
-    return itr->second->OnMessage(key, value);
+    return itr->second->OnMessage(key, std::forward<ValueType>(value));
   }
 
   void OnRpcCall(size_t src_rank, const std::string& key,
-                 const std::string& value, size_t chunk_idx,
-                 size_t num_chunks) {
+                 ByteContainerView value, const pb::ChunkInfo& chunk) {
     auto itr = listeners_.find(src_rank);
     if (itr == listeners_.end()) {
       YASL_THROW_LOGIC_ERROR("dispatch error, listener rank={} not found",
                              src_rank);
     }
     auto comm_brpc = std::dynamic_pointer_cast<ChannelBrpc>(itr->second);
-    // TODO: maybe need std::string_view interface to avoid memcpy
-    comm_brpc->OnChunkedMessage(key, value, chunk_idx, num_chunks);
+    comm_brpc->OnChunkedMessage(key, value, chunk.chunk_index(),
+                                chunk.num_chunks(), chunk.chunk_offset(),
+                                chunk.message_length());
   }
 };
 
@@ -102,7 +336,7 @@ ReceiverLoopBrpc::~ReceiverLoopBrpc() { StopImpl(); }
 
 void ReceiverLoopBrpc::Stop() { StopImpl(); }
 
-std::string ReceiverLoopBrpc::Start(const std::string& host) {
+std::string ReceiverLoopBrpc::Start(const std::string& host, bool use_rdma) {
   if (server_.IsRunning()) {
     YASL_THROW_LOGIC_ERROR("brpc server is already running");
   }
@@ -117,8 +351,10 @@ std::string ReceiverLoopBrpc::Start(const std::string& host) {
 
   // Start the server.
   brpc::ServerOptions options;
+  options.use_rdma = use_rdma;
   if (server_.Start(host.data(), &options) != 0) {
-    YASL_THROW_IO_ERROR("brpc server failed start");
+    YASL_THROW_IO_ERROR("brpc server failed start, host={}, use_rdma={}", host,
+                        use_rdma);
   }
 
   return butil::endpoint2str(server_.listen_address()).c_str();
@@ -126,34 +362,6 @@ std::string ReceiverLoopBrpc::Start(const std::string& host) {
 
 namespace {
 
-// TODO: move this to somewhere-else.
-class BatchDesc {
- protected:
-  size_t batch_idx_;
-  size_t batch_size_;
-  size_t total_size_;
-
- public:
-  BatchDesc(size_t batch_idx, size_t batch_size, size_t total_size)
-      : batch_idx_(batch_idx),
-        batch_size_(batch_size),
-        total_size_(total_size) {}
-
-  // return the index of this batch.
-  size_t Index() const { return batch_idx_; }
-
-  // return the offset of the first element in this batch.
-  size_t Begin() const { return batch_idx_ * batch_size_; }
-
-  // return the offset after last element in this batch.
-  size_t End() const { return std::min(Begin() + batch_size_, total_size_); }
-
-  // return the size of this batch.
-  size_t Size() const { return End() - Begin(); }
-
-  std::string ToString() const { return "B:" + std::to_string(batch_idx_); };
-};
-
 class OnPushDone : public google::protobuf::Closure {
  public:
   explicit OnPushDone(std::shared_ptr<ChannelBrpc> channel)
@@ -169,26 +377,56 @@ class OnPushDone : public google::protobuf::Closure {
     }
   }
 
+  // push the request, it is kept for resends.
+  void Push(brpc::Channel* rpc_channel) {
+    rpc_channel_ = rpc_channel;
+    attachment_ = cntl_.request_attachment();
+    pb::ReceiverService::Stub stub(rpc_channel_);
+    stub.Push(&cntl_, &request_, &response_, this);
+  }
+
   void Run() override {
     std::unique_ptr<OnPushDone> self_guard(this);
 
+    if (channel_->WaitToResend(cntl_, resend_attempt_)) {
+      SPDLOG_WARN("resend key={}, attempt={}, rpc failed={}, message={}",
+                  request_.key(), resend_attempt_ + 1, cntl_.ErrorCode(),
+                  cntl_.ErrorText());
+      resend_attempt_++;
+      cntl_.Reset();
+      response_.Clear();
+      cntl_.request_attachment() = attachment_;
+      pb::ReceiverService::Stub stub(rpc_channel_);
+      stub.Push(&cntl_, &request_, &response_, self_guard.release());
+      return;
+    }
+
     if (cntl_.Failed()) {
       SPDLOG_WARN("send, rpc failed={}, message={}", cntl_.ErrorCode(),
                   cntl_.ErrorText());
     } else if (response_.error_code() != pb::ErrorCode::SUCCESS) {
       SPDLOG_WARN("send, peer failed message={}", response_.error_msg());
+    } else {
+      channel_->OnPushLatency(cntl_.latency_us());
     }
   }
 
+  pb::PushRequest request_;
   pb::PushResponse response_;
   brpc::Controller cntl_;
   std::shared_ptr<ChannelBrpc> channel_;
+
+ private:
+  // shares the blocks with the sent one, no copy.
+  butil::IOBuf attachment_;
+  // owned by `channel_`.
+  brpc::Channel* rpc_channel_ = nullptr;
+  size_t resend_attempt_ = 0;
 };
 
 }  // namespace
 
 void ChannelBrpc::SetPeerHost(const std::string& peer_host) {
-  auto brpc_channel = std::make_unique<brpc::Channel>();
   const auto load_balancer = "";
   brpc::ChannelOptions options;
   {
@@ -198,17 +436,106 @@ void ChannelBrpc::SetPeerHost(const std::string& peer_host) {
     options.timeout_ms = options_.http_timeout_ms;
     options.max_retry = 3;
     // options.retry_policy = DefaultRpcRetryPolicy();
+    if (options_.use_rdma) {
+      // brpc only carries baidu_std over RDMA.
+      YASL_ENFORCE(options_.channel_protocol == "baidu_std",
+                   "rdma requires baidu_std protocol, got={}",
+                   options_.channel_protocol);
+      options.use_rdma = true;
+    }
+  }
+
+  size_t num_connections = std::max<size_t>(1, options_.num_connections);
+  if (options_.adaptive) {
+    LinkTunerOptions tuner_options;
+    tuner_options.min_chunk_size = options_.adaptive_min_chunk_size;
+    tuner_options.max_chunk_size = options_.adaptive_max_chunk_size;
+    tuner_options.max_window = options_.adaptive_max_window;
+    tuner_options.max_connections = options_.adaptive_max_connections;
+    LinkParams initial;
+    initial.chunk_size = options_.http_max_payload_size;
+    initial.window = options_.chunk_parallel_send_size;
+    initial.connections = num_connections;
+    tuner_ = std::make_unique<LinkTuner>(tuner_options, initial);
+    num_connections = std::max(num_connections, tuner_options.max_connections);
   }
-  int res = brpc_channel->Init(peer_host.c_str(), load_balancer, &options);
-  if (res != 0) {
-    YASL_THROW_NETWORK_ERROR("Fail to initialize channel, host={}, err_code={}",
-                             peer_host, res);
+  std::vector<std::shared_ptr<brpc::Channel>> channels;
+  for (size_t idx = 0; idx < num_connections; idx++) {
+    // brpc shares one connection among channels to the same host, unless
+    // they are in different connection groups.
+    if (num_connections > 1) {
+      options.connection_group = fmt::format("yasl-{}-{}", self_rank_, idx);
+    }
+    auto brpc_channel = std::make_shared<brpc::Channel>();
+    int res = brpc_channel->Init(peer_host.c_str(), load_balancer, &options);
+    if (res != 0) {
+      YASL_THROW_NETWORK_ERROR(
+          "Fail to initialize channel, host={}, connection={}, err_code={}",
+          peer_host, idx, res);
+    }
+    channels.push_back(std::move(brpc_channel));
+  }
+
+  if (options_.priority_threshold > 0) {
+    options.connection_group = fmt::format("yasl-{}-priority", self_rank_);
+    auto brpc_channel = std::make_shared<brpc::Channel>();
+    int res = brpc_channel->Init(peer_host.c_str(), load_balancer, &options);
+    if (res != 0) {
+      YASL_THROW_NETWORK_ERROR(
+          "Fail to initialize priority channel, host={}, err_code={}",
+          peer_host, res);
+    }
+    priority_channel_ = std::move(brpc_channel);
   }
 
-  channel_ = std::move(brpc_channel);
+  channels_ = std::move(channels);
   peer_host_ = peer_host;
 }
 
+ChannelBrpc::~ChannelBrpc() {
+  if (stream_id_ != brpc::INVALID_STREAM_ID) {
+    brpc::StreamClose(stream_id_);
+  }
+}
+
+brpc::Channel* ChannelBrpc::NextChannel() {
+  YASL_ENFORCE(!channels_.empty(), "peer host is not set");
+  if (channels_.size() == 1) {
+    return channels_[0].get();
+  }
+  const size_t num_connections =
+      tuner_ ? tuner_->Get().connections : channels_.size();
+  const size_t idx = next_channel_.fetch_add(1, std::memory_order_relaxed);
+  return channels_[idx % num_connections].get();
+}
+
+brpc::Channel* ChannelBrpc::MonoChannel(size_t size) {
+  if (priority_channel_ && size <= options_.priority_threshold) {
+    return priority_channel_.get();
+  }
+  return NextChannel();
+}
+
+brpc::Channel* ChannelBrpc::ChunkChannel(size_t chunk_idx,
+                                         size_t num_connections) const {
+  YASL_ENFORCE(!channels_.empty(), "peer host is not set");
+  return channels_[chunk_idx %
+                   std::min(std::max<size_t>(num_connections, 1),
+                            channels_.size())]
+      .get();
+}
+
+LinkParams ChannelBrpc::GetLinkParams() const {
+  if (tuner_) {
+    return tuner_->Get();
+  }
+  LinkParams params;
+  params.chunk_size = options_.http_max_payload_size;
+  params.window = options_.chunk_parallel_send_size;
+  params.connections = channels_.size();
+  return params;
+}
+
 namespace {
 
 struct SendChunckedBrpcTask {
@@ -237,13 +564,77 @@ struct SendChunckedBrpcTask {
     std::unique_ptr<SendChunckedBrpcTask> task(
         static_cast<SendChunckedBrpcTask*>(args));
 
-    task->channel->SendChunked(task->key, task->value);
+    task->channel->SendBulk(task->key, task->value);
     return nullptr;
   }
 };
 
 }  // namespace
 
+bool ChannelBrpc::UseAttachment() const {
+  // only these protocols carry attachments besides the protobuf body.
+  return options_.channel_protocol == "baidu_std" ||
+         options_.channel_protocol == "hulu_pbrpc" ||
+         options_.channel_protocol == "sofa_pbrpc";
+}
+
+void ChannelBrpc::SetPayload(pb::PushRequest* request, brpc::Controller* cntl,
+                             const void* data, size_t size) const {
+  if (UseAttachment()) {
+    cntl->request_attachment().append(data, size);
+  } else {
+    request->set_value(data, size);
+  }
+}
+
+void ChannelBrpc::SetPayload(pb::PushRequest* request, brpc::Controller* cntl,
+                             Buffer&& value) const {
+  // a buffer with user provided deleter could not be handed over to brpc,
+  // since brpc only accepts a plain function as deleter.
+  if (!UseAttachment() || value.has_deleter() || value.size() == 0) {
+    SetPayload(request, cntl, value.data(), value.size());
+    return;
+  }
+
+  const size_t size = value.size();
+  void* data = value.release();
+  // brpc takes the ownership, the memory is released once it is written out.
+  if (cntl->request_attachment().append_user_data(data, size, &Buffer::Free) !=
+      0) {
+    Buffer::Free(data);
+    YASL_THROW("failed to append user data to brpc attachment, size={}", size);
+  }
+}
+
+bool ChannelBrpc::SetCompressedPayload(pb::PushRequest* request,
+                                       brpc::Controller* cntl,
+                                       const void* data, size_t size) const {
+  if (options_.compress_type == "none" || size < options_.compress_min_size) {
+    return false;
+  }
+  if (options_.compress_type != "zlib") {
+    YASL_THROW_LOGIC_ERROR("unsupported compress type={}",
+                           options_.compress_type);
+  }
+
+  uLongf compressed_length = compressBound(size);
+  Buffer compressed(static_cast<int64_t>(compressed_length));
+  const int ret =
+      compress2(compressed.data<Bytef>(), &compressed_length,
+                static_cast<const Bytef*>(data), size, Z_BEST_SPEED);
+  YASL_ENFORCE(ret == Z_OK, "zlib compress failed, ret={}", ret);
+  if (compressed_length >= size) {
+    // incompressible, e.g. random bytes of OT, send it as is.
+    return false;
+  }
+
+  compressed.resize(static_cast<int64_t>(compressed_length));
+  request->set_compress_type(pb::CompressType::COMPRESS_ZLIB);
+  request->set_raw_length(size);
+  SetPayload(request, cntl, std::move(compressed));
+  return true;
+}
+
 void ChannelBrpc::AddAsyncCount() {
   std::unique_lock<std::mutex> lock(wait_async_mutex_);
   running_async_count_++;
@@ -265,7 +656,7 @@ void ChannelBrpc::WaitAsyncSendToFinish() {
 
 template <class ValueType>
 void ChannelBrpc::SendAsyncInternal(const std::string& key, ValueType&& value) {
-  if (value.size() > options_.http_max_payload_size) {
+  if (value.size() > MaxMonoSize() || UseStream(value.size())) {
     auto btask = std::make_unique<SendChunckedBrpcTask>(
         this->shared_from_this(), key, Buffer(std::forward<ValueType>(value)));
 
@@ -282,18 +673,26 @@ void ChannelBrpc::SendAsyncInternal(const std::string& key, ValueType&& value) {
     return;
   }
 
-  pb::PushRequest request;
+  // the value may be moved into the request below.
+  const size_t value_size = value.size();
+  OnPushDone* done = new OnPushDone(shared_from_this());
+  auto& request = done->request_;
   {
     request.set_sender_rank(self_rank_);
     request.set_key(key);
-    request.set_value(reinterpret_cast<const char*>(value.data()),
-                      value.size());
+    if (!SetCompressedPayload(&request, &done->cntl_, value.data(),
+                              value.size())) {
+      if constexpr (std::is_same_v<ValueType, Buffer>) {
+        SetPayload(&request, &done->cntl_, std::move(value));
+      } else {
+        SetPayload(&request, &done->cntl_, value.data(), value.size());
+      }
+    }
     request.set_trans_type(pb::TransType::MONO);
+    request.set_seq(NextPushSeq());
   }
 
-  OnPushDone* done = new OnPushDone(shared_from_this());
-  pb::ReceiverService::Stub stub(channel_.get());
-  stub.Push(&done->cntl_, &request, &done->response_, done);
+  done->Push(MonoChannel(value_size));
 }
 
 void ChannelBrpc::SendAsyncImpl(const std::string& key, Buffer&& value) {
@@ -305,24 +704,65 @@ void ChannelBrpc::SendAsyncImpl(const std::string& key,
   SendAsyncInternal(key, value);
 }
 
-void ChannelBrpc::SendImpl(const std::string& key, ByteContainerView value) {
-  if (value.size() > options_.http_max_payload_size) {
-    SendChunked(key, value);
+void ChannelBrpc::SendAsyncImpl(const std::string& key, ByteChainView value) {
+  // bulk and compressed msgs, and protocols without attachment, need a
+  // single range.
+  const size_t value_size = value.size();
+  if (!UseAttachment() || value_size > MaxMonoSize() ||
+      UseStream(value_size) ||
+      (options_.compress_type != "none" &&
+       value_size >= options_.compress_min_size)) {
+    SendAsyncInternal(key, value.Flatten());
     return;
   }
 
-  pb::PushRequest request;
+  OnPushDone* done = new OnPushDone(shared_from_this());
+  auto& request = done->request_;
   {
     request.set_sender_rank(self_rank_);
     request.set_key(key);
-    request.set_value(value.data(), value.size());
+    // the parts are appended to the attachment IOBuf one by one.
+    for (const auto& part : value.parts()) {
+      done->cntl_.request_attachment().append(part.data(), part.size());
+    }
     request.set_trans_type(pb::TransType::MONO);
+    request.set_seq(NextPushSeq());
+  }
+
+  done->Push(MonoChannel(value_size));
+}
+
+void ChannelBrpc::SendImpl(const std::string& key, ByteContainerView value) {
+  if (value.size() > MaxMonoSize() || UseStream(value.size())) {
+    SendBulk(key, value);
+    return;
   }
 
   pb::PushResponse response;
   brpc::Controller cntl;
-  pb::ReceiverService::Stub stub(channel_.get());
+  pb::PushRequest request;
+  {
+    request.set_sender_rank(self_rank_);
+    request.set_key(key);
+    if (!SetCompressedPayload(&request, &cntl, value.data(), value.size())) {
+      SetPayload(&request, &cntl, value.data(), value.size());
+    }
+    request.set_trans_type(pb::TransType::MONO);
+    request.set_seq(NextPushSeq());
+  }
+
+  // shares the blocks with the sent one, for resends.
+  const butil::IOBuf attachment = cntl.request_attachment();
+  pb::ReceiverService::Stub stub(MonoChannel(value.size()));
   stub.Push(&cntl, &request, &response, nullptr);
+  for (size_t attempt = 0; WaitToResend(cntl, attempt); attempt++) {
+    SPDLOG_WARN("resend key={}, attempt={}, rpc failed={}, message={}", key,
+                attempt + 1, cntl.ErrorCode(), cntl.ErrorText());
+    cntl.Reset();
+    response.Clear();
+    cntl.request_attachment() = attachment;
+    stub.Push(&cntl, &request, &response, nullptr);
+  }
 
   // handle failures.
   if (cntl.Failed()) {
@@ -334,6 +774,7 @@ void ChannelBrpc::SendImpl(const std::string& key, ByteContainerView value) {
     YASL_THROW_NETWORK_ERROR("send, peer failed message={}",
                              response.error_msg());
   }
+  OnPushLatency(cntl.latency_us());
 }
 
 // See: chunked streamming
@@ -341,63 +782,287 @@ void ChannelBrpc::SendImpl(const std::string& key, ByteContainerView value) {
 // See: Brpc does NOT support POST chunked.
 //   https://github.com/apache/incubator-brpc/blob/master/docs/en/http_client.md
 void ChannelBrpc::SendChunked(const std::string& key, ByteContainerView value) {
-  const size_t bytes_per_chunk = options_.http_max_payload_size;
+  const auto params = GetLinkParams();
+  const size_t bytes_per_chunk = params.chunk_size;
   const size_t num_bytes = value.size();
   const size_t num_chunks = (num_bytes + bytes_per_chunk - 1) / bytes_per_chunk;
 
-  constexpr uint32_t kParallelSize = 10;
-  const size_t batch_size = kParallelSize;
-  const size_t num_batches = (num_chunks + batch_size - 1) / batch_size;
-
-  for (size_t batch_idx = 0; batch_idx < num_batches; batch_idx++) {
-    const BatchDesc batch(batch_idx, batch_size, num_chunks);
-
-    // See: "半同步“ from
-    // https://github.com/apache/incubator-brpc/blob/master/docs/cn/client.md
-    std::vector<brpc::Controller> cntls(batch.Size());
-    std::vector<pb::PushResponse> responses(batch.Size());
-
-    // fire batched chunk requests.
-    for (size_t idx = 0; idx < batch.Size(); idx++) {
-      const size_t chunk_idx = batch.Begin() + idx;
-      const size_t chunk_offset = chunk_idx * bytes_per_chunk;
-
-      pb::PushRequest request;
-      {
-        request.set_sender_rank(self_rank_);
-        request.set_key(key);
-        request.set_value(
-            value.data() + chunk_offset,
-            std::min(bytes_per_chunk, value.size() - chunk_offset));
-        request.set_trans_type(pb::TransType::CHUNKED);
-        request.mutable_chunk_info()->set_num_chunks(num_chunks);
-        request.mutable_chunk_info()->set_chunk_index(chunk_idx);
+  // Sliding window: chunk `i` is sent through slot `i % window_size`, which is
+  // reused once the previous chunk in this slot is done. So that there are at
+  // most `window_size` chunk requests in flight.
+  // the window covers at least one chunk per connection, so that every
+  // connection carries its stripe.
+  const size_t window_size = std::max<size_t>(
+      1, std::min<size_t>(std::max<size_t>(params.window, params.connections),
+                          num_chunks));
+  const auto start = std::chrono::steady_clock::now();
+
+  // See: "半同步“ from
+  // https://github.com/apache/incubator-brpc/blob/master/docs/cn/client.md
+  std::vector<brpc::Controller> cntls(window_size);
+  std::vector<pb::PushResponse> responses(window_size);
+
+  // push chunk `chunk_idx` through its slot, which should be free. a resent
+  // chunk keeps its seq.
+  std::vector<uint64_t> seqs(window_size);
+  auto push_chunk = [&](size_t chunk_idx, bool resend) {
+    auto& cntl = cntls[chunk_idx % window_size];
+    auto& response = responses[chunk_idx % window_size];
+    auto& seq = seqs[chunk_idx % window_size];
+    cntl.Reset();
+    response.Clear();
+    if (!resend) {
+      seq = NextPushSeq();
+    }
+
+    const size_t chunk_offset = chunk_idx * bytes_per_chunk;
+    const size_t chunk_size =
+        std::min(bytes_per_chunk, value.size() - chunk_offset);
+    pb::PushRequest request;
+    {
+      request.set_sender_rank(self_rank_);
+      request.set_key(key);
+      if (!SetCompressedPayload(&request, &cntl, value.data() + chunk_offset,
+                                chunk_size)) {
+        SetPayload(&request, &cntl, value.data() + chunk_offset, chunk_size);
       }
+      request.set_trans_type(pb::TransType::CHUNKED);
+      request.mutable_chunk_info()->set_num_chunks(num_chunks);
+      request.mutable_chunk_info()->set_chunk_index(chunk_idx);
+      request.mutable_chunk_info()->set_message_length(num_bytes);
+      request.mutable_chunk_info()->set_chunk_offset(chunk_offset);
+      request.set_seq(seq);
+    }
+
+    pb::ReceiverService::Stub stub(
+        ChunkChannel(chunk_idx, params.connections));
+    stub.Push(&cntl, &request, &response, brpc::DoNothing());
+  };
+
+  // wait for the request of chunk_idx, return the error message if it failed.
+  auto join_chunk = [&](size_t chunk_idx) -> std::string {
+    const auto& cntl = cntls[chunk_idx % window_size];
+    const auto& response = responses[chunk_idx % window_size];
+    brpc::Join(cntl.call_id());
+    for (size_t attempt = 0; WaitToResend(cntl, attempt); attempt++) {
+      SPDLOG_WARN(
+          "resend key={} (chunked {} out of {}), attempt={}, rpc failed={}, "
+          "message={}",
+          key, chunk_idx + 1, num_chunks, attempt + 1, cntl.ErrorCode(),
+          cntl.ErrorText());
+      push_chunk(chunk_idx, true);
+      brpc::Join(cntl.call_id());
+    }
+    if (cntl.Failed()) {
+      return fmt::format(
+          "send key={} (chunked {} out of {}) rpc failed: {}, message={}", key,
+          chunk_idx + 1, num_chunks, cntl.ErrorCode(), cntl.ErrorText());
+    }
+    if (response.error_code() != pb::ErrorCode::SUCCESS) {
+      return fmt::format(
+          "send key={} (chunked {} out of {}) response failed, message={}",
+          key, chunk_idx + 1, num_chunks, response.error_msg());
+    }
+    OnPushLatency(cntl.latency_us());
+    return {};
+  };
+
+  // join all flying requests in [begin, end), return the first error.
+  auto join_range = [&](size_t begin, size_t end) -> std::string {
+    std::string first_error;
+    for (size_t chunk_idx = begin; chunk_idx < end; chunk_idx++) {
+      auto error = join_chunk(chunk_idx);
+      if (first_error.empty()) {
+        first_error = std::move(error);
+      }
+    }
+    return first_error;
+  };
+
+  for (size_t chunk_idx = 0; chunk_idx < num_chunks; chunk_idx++) {
+    if (chunk_idx >= window_size) {
+      // the slot is occupied, wait for it before reuse.
+      const size_t prev_idx = chunk_idx - window_size;
+      auto error = join_chunk(prev_idx);
+      if (!error.empty()) {
+        // never leave requests flying on controllers we are going to release.
+        static_cast<void>(join_range(prev_idx + 1, chunk_idx));
+        YASL_THROW_NETWORK_ERROR("{}", error);
+      }
+    }
+
+    push_chunk(chunk_idx, false);
+  }
+
+  auto error = join_range(num_chunks - std::min(num_chunks, window_size),
+                          num_chunks);
+  if (!error.empty()) {
+    YASL_THROW_NETWORK_ERROR("{}", error);
+  }
+  if (tuner_) {
+    tuner_->OnTransfer(num_bytes,
+                       std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count());
+  }
+}
+
+bool ChannelBrpc::WaitToResend(const brpc::Controller& cntl,
+                               size_t attempt) const {
+  if (!cntl.Failed() || attempt >= options_.max_resend_times) {
+    return false;
+  }
+  // doubled after each attempt, capped to keep the shift sane.
+  const uint64_t interval_ms = uint64_t{options_.resend_interval_ms}
+                               << std::min<size_t>(attempt, 16);
+  bthread_usleep(interval_ms * 1000);
+  return true;
+}
 
-      auto& cntl = cntls[idx];
-      auto& response = responses[idx];
-      pb::ReceiverService::Stub stub(channel_.get());
-      stub.Push(&cntl, &request, &response, brpc::DoNothing());
+ChannelBrpc::PushSeqState ChannelBrpc::AcceptPushSeq(uint64_t seq) {
+  std::unique_lock lock(delivered_mutex_);
+  // a copy being delivered decides whether this one is needed.
+  delivered_cv_.wait(lock, [&] { return delivering_.count(seq) == 0; });
+  if (seq <= skipped_floor_ || skipped_.count(seq) > 0) {
+    return PushSeqState::kDropped;
+  }
+  if (seq <= delivered_seq_ || delivered_ahead_.count(seq) > 0) {
+    return PushSeqState::kDelivered;
+  }
+  delivering_.insert(seq);
+  return PushSeqState::kAccepted;
+}
+
+void ChannelBrpc::FinishPushSeq(uint64_t seq, bool delivered) {
+  {
+    std::unique_lock lock(delivered_mutex_);
+    delivering_.erase(seq);
+    if (!delivered) {
+      // a gap skipped meanwhile can not be delivered any more.
+      if (seq <= delivered_seq_) {
+        SkipPushSeq(seq);
+      }
+    } else if (seq > delivered_seq_) {
+      delivered_ahead_.insert(seq);
     }
+    // advance over the seqs delivered without gaps.
+    while (!delivered_ahead_.empty()) {
+      const uint64_t next = *delivered_ahead_.begin();
+      if (next != delivered_seq_ + 1) {
+        if (delivered_ahead_.size() <= kMaxDeliveredAhead) {
+          break;
+        }
+        // a gap left by a request given up by peer is skipped once too many
+        // requests are ahead of it, its late resend is refused.
+        for (uint64_t gap = delivered_seq_ + 1; gap < next; ++gap) {
+          if (delivering_.count(gap) == 0) {
+            SkipPushSeq(gap);
+          }
+        }
+      }
+      delivered_seq_ = next;
+      delivered_ahead_.erase(delivered_ahead_.begin());
+    }
+  }
+  delivered_cv_.notify_all();
+}
+
+void ChannelBrpc::SkipPushSeq(uint64_t seq) {
+  skipped_.insert(seq);
+  if (skipped_.size() > kMaxDeliveredAhead) {
+    skipped_floor_ = std::max(skipped_floor_, *skipped_.begin());
+    skipped_.erase(skipped_.begin());
+  }
+}
+
+void ChannelBrpc::SendBulk(const std::string& key, ByteContainerView value) {
+  if (UseStream(value.size())) {
+    SendStream(key, value);
+  } else {
+    SendChunked(key, value);
+  }
+}
 
-    for (size_t idx = 0; idx < batch.Size(); idx++) {
-      brpc::Join(cntls[idx].call_id());
+void ChannelBrpc::OpenStream() {
+  YASL_ENFORCE(options_.channel_protocol == "baidu_std",
+               "stream requires baidu_std protocol, got={}",
+               options_.channel_protocol);
+  YASL_ENFORCE(!channels_.empty(), "peer host is not set");
+
+  brpc::Controller cntl;
+  brpc::StreamOptions stream_options;
+  stream_options.max_buf_size = options_.stream_window_size;
+  brpc::StreamId stream_id;
+  if (brpc::StreamCreate(&stream_id, cntl, &stream_options) != 0) {
+    YASL_THROW_NETWORK_ERROR("failed to create stream to peer={}",
+                             peer_host_);
+  }
+
+  pb::OpenStreamRequest request;
+  request.set_sender_rank(self_rank_);
+  pb::PushResponse response;
+  pb::ReceiverService::Stub stub(channels_[0].get());
+  stub.OpenStream(&cntl, &request, &response, nullptr);
+
+  if (cntl.Failed() || response.error_code() != pb::ErrorCode::SUCCESS) {
+    brpc::StreamClose(stream_id);
+    if (cntl.Failed()) {
+      YASL_THROW_NETWORK_ERROR("open stream, rpc failed={}, message={}",
+                               cntl.ErrorCode(), cntl.ErrorText());
     }
+    YASL_THROW_NETWORK_ERROR("open stream, peer failed message={}",
+                             response.error_msg());
+  }
+  stream_id_ = stream_id;
+}
+
+// See: streaming rpc
+//   https://github.com/apache/incubator-brpc/blob/master/docs/en/streaming_rpc.md
+void ChannelBrpc::SendStream(const std::string& key, ByteContainerView value) {
+  // bytes per stream write, the window is checked between writes.
+  constexpr size_t kSegmentSize = 128 * 1024;
 
-    for (size_t idx = 0; idx < batch.Size(); idx++) {
-      const size_t chunk_idx = batch.Begin() + idx;
-      const auto& cntl = cntls[idx];
-      const auto& response = responses[idx];
-      if (cntl.Failed()) {
-        YASL_THROW_NETWORK_ERROR(
-            "send key={} (chunked {} out of {}) rpc failed: {}, message={}",
-            key, chunk_idx + 1, num_chunks, cntl.ErrorCode(), cntl.ErrorText());
-      } else if (response.error_code() != pb::ErrorCode::SUCCESS) {
-        YASL_THROW_NETWORK_ERROR(
-            "send key={} (chunked {} out of {}) response failed, message={}",
-            key, chunk_idx + 1, num_chunks, response.error_msg());
+  std::unique_lock<bthread::Mutex> lock(stream_mutex_);
+  if (stream_id_ == brpc::INVALID_STREAM_ID) {
+    OpenStream();
+  }
+
+  // writes a segment, waits for peer to consume once the window is full.
+  auto write = [&](const butil::IOBuf& segment) {
+    while (true) {
+      int ret = brpc::StreamWrite(stream_id_, segment);
+      if (ret == EAGAIN) {
+        const auto due = butil::milliseconds_from_now(options_.http_timeout_ms);
+        ret = brpc::StreamWait(stream_id_, &due);
+        if (ret == 0) {
+          continue;
+        }
+      }
+      if (ret == 0) {
+        return;
       }
+      // the stream is broken, the partial msg is dropped by peer. reopen it
+      // for the following msgs.
+      brpc::StreamClose(stream_id_);
+      stream_id_ = brpc::INVALID_STREAM_ID;
+      YASL_THROW_NETWORK_ERROR("send key={} by stream failed, error={}", key,
+                               ret);
     }
+  };
+
+  internal::StreamMsgHeader header;
+  header.key_length = key.size();
+  header.value_length = value.size();
+  butil::IOBuf head;
+  head.append(&header, sizeof(header));
+  head.append(key);
+  write(head);
+
+  for (size_t offset = 0; offset < value.size(); offset += kSegmentSize) {
+    butil::IOBuf segment;
+    segment.append(value.data() + offset,
+                   std::min(kSegmentSize, value.size() - offset));
+    write(segment);
   }
 }
 
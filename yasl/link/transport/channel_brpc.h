@@ -14,18 +14,28 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <utility>
+#include <vector>
 
 #include "brpc/channel.h"
 #include "brpc/server.h"
+#include "brpc/stream.h"
+#include "bthread/mutex.h"
 
 #include "yasl/link/transport/channel.h"
+#include "yasl/link/transport/link_tuner.h"
 
 namespace yasl::link {
 
+namespace pb {
+class PushRequest;
+}  // namespace pb
+
 class ReceiverLoopBrpc final : public ReceiverLoopBase {
  public:
   ~ReceiverLoopBrpc() override;
@@ -40,7 +50,10 @@ class ReceiverLoopBrpc final : public ReceiverLoopBase {
   //
   // Note: brpc support "ip:0" listen mode, in which brpc will try to find a
   // free port to listen.
-  std::string Start(const std::string& host);
+  //
+  // use_rdma: accept peers over RDMA, brpc must be built with
+  // BRPC_WITH_RDMA.
+  std::string Start(const std::string& host, bool use_rdma = false);
 
  protected:
   brpc::Server server_;
@@ -55,14 +68,52 @@ class ChannelBrpc final : public ChannelBase,
   struct Options {
     uint32_t http_timeout_ms = 10 * 1000;         // 10 seconds
     uint32_t http_max_payload_size = 512 * 1024;  // 512k bytes
+    // max number of chunk requests in flight when sending a large message.
+    uint32_t chunk_parallel_send_size = 10;
     std::string channel_protocol = "baidu_std";
     std::string channel_connection_type = "single";
+    // "none" or "zlib", payload shorter than `compress_min_size` or not shrunk
+    // by compression is sent as is.
+    std::string compress_type = "none";
+    uint32_t compress_min_size = 1024;
+    // talk to peer over RDMA, payloads are posted from brpc's registered
+    // memory pool. requires "baidu_std" and brpc built with BRPC_WITH_RDMA.
+    bool use_rdma = false;
+    // number of connections opened to the peer. small msgs are balanced over
+    // them round robin, chunks of a large msg are striped across all of them.
+    // msgs are reassembled by key, so no ordering among connections is needed.
+    uint32_t num_connections = 1;
+    // msgs longer than `stream_threshold` bytes are sent over a brpc stream
+    // instead of chunked unary rpcs, 0 disables it. requires "baidu_std".
+    uint32_t stream_threshold = 0;
+    // max bytes written to the stream but not consumed by peer yet, writers
+    // wait once it is full.
+    uint32_t stream_window_size = 2 * 1024 * 1024;  // 2M bytes
+    // msgs of at most `priority_threshold` bytes, e.g. acks and protocol
+    // control rounds, are sent over a connection of their own, so that they
+    // never queue behind bulk transfers. 0 disables it.
+    uint32_t priority_threshold = 0;
+    // a push failed by the network is resent up to `max_resend_times` times,
+    // waiting `resend_interval_ms` before the first one and doubling it
+    // after each. receiver drops the duplicates by the request seq.
+    uint32_t max_resend_times = 3;
+    uint32_t resend_interval_ms = 100;
+    // tune the chunk size (`http_max_payload_size` above is the start),
+    // `chunk_parallel_send_size` and `num_connections` to the link at
+    // runtime, within the bounds below. see LinkTuner.
+    bool adaptive = false;
+    uint32_t adaptive_min_chunk_size = 256 * 1024;       // 256k bytes
+    uint32_t adaptive_max_chunk_size = 8 * 1024 * 1024;  // 8M bytes
+    uint32_t adaptive_max_window = 64;
+    uint32_t adaptive_max_connections = 8;
   };
 
  private:
   // from IChannel
   void SendAsyncImpl(const std::string& key, ByteContainerView value) override;
   void SendAsyncImpl(const std::string& key, Buffer&& value) override;
+  // small msgs append the parts to the attachment IOBuf.
+  void SendAsyncImpl(const std::string& key, ByteChainView value) override;
 
   void SendImpl(const std::string& key, ByteContainerView value) override;
 
@@ -75,6 +126,8 @@ class ChannelBrpc final : public ChannelBase,
       : ChannelBase(self_rank, peer_rank, recv_timeout_ms),
         options_(std::move(options)) {}
 
+  ~ChannelBrpc() override;
+
   void SetPeerHost(const std::string& peer_host);
 
   void AddAsyncCount();
@@ -92,19 +145,150 @@ class ChannelBrpc final : public ChannelBase,
     options_.http_max_payload_size = max_payload_size;
   }
 
+  uint32_t GetChunkParallelSendSize() const {
+    return options_.chunk_parallel_send_size;
+  }
+
+  void SetChunkParallelSendSize(uint32_t parallel_size) {
+    options_.chunk_parallel_send_size = parallel_size;
+  }
+
+  void SetCompressType(const std::string& compress_type) {
+    options_.compress_type = compress_type;
+  }
+
+  void SetCompressMinSize(uint32_t min_size) {
+    options_.compress_min_size = min_size;
+  }
+
+  void SetStreamThreshold(uint32_t threshold) {
+    options_.stream_threshold = threshold;
+  }
+
   // send chunked, synchronized.
   void SendChunked(const std::string& key, ByteContainerView value);
 
+  // send over the stream to peer, which is opened on first use. returns once
+  // the msg is written into the stream window, not when peer received it.
+  void SendStream(const std::string& key, ByteContainerView value);
+
+  // sends a msg too long for a single rpc, by stream or in chunks.
+  void SendBulk(const std::string& key, ByteContainerView value);
+
+  // seq of the next push request to peer.
+  uint64_t NextPushSeq() { return ++push_seq_; }
+
+  // whether a push failed as `cntl` should be resent, for the `attempt`th
+  // time counted from 0. sleeps for the backoff before returning true.
+  bool WaitToResend(const brpc::Controller& cntl, size_t attempt) const;
+
+  // of a push request from peer when it arrives.
+  enum class PushSeqState {
+    // not delivered yet, the caller delivers it then calls FinishPushSeq.
+    kAccepted,
+    // delivered by an earlier copy.
+    kDelivered,
+    // skipped as a gap, or too old to tell.
+    kDropped,
+  };
+
+  // waits while another copy of `seq` is being delivered.
+  PushSeqState AcceptPushSeq(uint64_t seq);
+
+  // the accepted `seq` is delivered, or failed and stays open for a resend.
+  void FinishPushSeq(uint64_t seq, bool delivered);
+
+  // a push request was acked after `latency_us`, feeds the tuner if any.
+  void OnPushLatency(int64_t latency_us) {
+    if (tuner_) {
+      tuner_->OnRequest(latency_us);
+    }
+  }
+
+  // how the next bulk msg is sent, the static options unless adaptive.
+  LinkParams GetLinkParams() const;
+
  private:
   template <class ValueType>
   void SendAsyncInternal(const std::string& key, ValueType&& value);
 
+  // whether the payload should be carried by brpc attachment, which saves the
+  // copy into/out of the protobuf `bytes` field.
+  bool UseAttachment() const;
+
+  void SetPayload(pb::PushRequest* request, brpc::Controller* cntl,
+                  const void* data, size_t size) const;
+
+  // moves the buffer into the request without copy if possible.
+  void SetPayload(pb::PushRequest* request, brpc::Controller* cntl,
+                  Buffer&& value) const;
+
+  // sets the compressed payload if compression is enabled and worthwhile,
+  // returns false and leaves the request untouched otherwise.
+  bool SetCompressedPayload(pb::PushRequest* request, brpc::Controller* cntl,
+                            const void* data, size_t size) const;
+
+  // msgs longer than it are sent in chunks.
+  size_t MaxMonoSize() const {
+    return tuner_ ? tuner_->Get().chunk_size : options_.http_max_payload_size;
+  }
+
+  bool UseStream(size_t size) const {
+    return options_.stream_threshold > 0 && size > options_.stream_threshold;
+  }
+
+  // should be called with stream_mutex_ held.
+  void OpenStream();
+
+  // the connection for the next mono msg, round robin.
+  brpc::Channel* NextChannel();
+
+  // the connection for a mono msg of `size` bytes, the priority one for
+  // small msgs if enabled.
+  brpc::Channel* MonoChannel(size_t size);
+
+  // the connection carrying chunk `chunk_idx` of a chunked msg striped
+  // across the first `num_connections` ones.
+  brpc::Channel* ChunkChannel(size_t chunk_idx, size_t num_connections) const;
+
  protected:
   Options options_;
 
   // brpc channel related.
   std::string peer_host_;
-  std::shared_ptr<brpc::Channel> channel_;
+  // one per connection, see Options::num_connections. if adaptive, as many
+  // as the max are set up, but only the tuned number of them is used. brpc
+  // connects on first use, so the others cost nothing.
+  std::vector<std::shared_ptr<brpc::Channel>> channels_;
+  std::atomic<size_t> next_channel_ = 0;
+  // carries small msgs only, see Options::priority_threshold.
+  std::shared_ptr<brpc::Channel> priority_channel_;
+  // set by SetPeerHost if Options::adaptive.
+  std::unique_ptr<LinkTuner> tuner_;
+
+  // bulk stream to peer, msgs are written as a whole under the mutex so that
+  // they never interleave. a bthread mutex, since writers may wait for the
+  // stream window inside bthreads.
+  bthread::Mutex stream_mutex_;
+  brpc::StreamId stream_id_ = brpc::INVALID_STREAM_ID;
+
+  std::atomic<uint64_t> push_seq_ = 0;
+
+  // should be called with delivered_mutex_ held.
+  void SkipPushSeq(uint64_t seq);
+
+  // seqs of delivered push requests from peer, all seqs up to
+  // `delivered_seq_` but the skipped ones, and the ones in
+  // `delivered_ahead_`. the last kMaxDeliveredAhead skipped seqs are kept,
+  // the ones up to `skipped_floor_` are forgotten.
+  static constexpr size_t kMaxDeliveredAhead = 1 << 16;
+  std::mutex delivered_mutex_;
+  std::condition_variable delivered_cv_;
+  uint64_t delivered_seq_ = 0;
+  std::set<uint64_t> delivered_ahead_;
+  std::set<uint64_t> delivering_;
+  std::set<uint64_t> skipped_;
+  uint64_t skipped_floor_ = 0;
 
   // WaitAsyncSendToFinish
   std::condition_variable wait_async_cv_;
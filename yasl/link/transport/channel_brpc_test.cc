@@ -19,6 +19,7 @@
 #include <ctime>
 #include <future>
 #include <string>
+#include <vector>
 
 #include "fmt/format.h"
 #include "gmock/gmock.h"
@@ -275,6 +276,44 @@ TEST_P(ChannelBrpcWithLimitTest, Send) {
   EXPECT_EQ(sent, std::string_view(received));
 }
 
+TEST_P(ChannelBrpcWithLimitTest, ChunkParallelSendSize) {
+  const size_t size_limit_per_call = std::get<0>(GetParam());
+  const size_t size_to_send = std::get<1>(GetParam());
+
+  sender_->SetHttpMaxPayloadSize(size_limit_per_call);
+
+  for (uint32_t parallel_size : {1, 3, 64}) {
+    sender_->SetChunkParallelSendSize(parallel_size);
+
+    const std::string key = fmt::format("key_{}", parallel_size);
+    const std::string sent = RandStr(size_to_send);
+    sender_->Send(key, sent);
+    auto received = receiver_->Recv(key);
+
+    EXPECT_EQ(sent, std::string_view(received));
+  }
+}
+
+TEST_P(ChannelBrpcWithLimitTest, Compression) {
+  const size_t size_limit_per_call = std::get<0>(GetParam());
+  const size_t size_to_send = std::get<1>(GetParam());
+
+  sender_->SetHttpMaxPayloadSize(size_limit_per_call);
+  sender_->SetCompressType("zlib");
+  sender_->SetCompressMinSize(1);
+
+  // compressible and incompressible payloads.
+  const std::string repeated(size_to_send, 'a');
+  const std::string random = RandStr(size_to_send);
+  sender_->SendAsync("repeated", ByteContainerView{repeated});
+  sender_->Send("random", random);
+  sender_->SendAsync("moved", Buffer(repeated.data(), repeated.size()));
+
+  EXPECT_EQ(repeated, std::string_view(receiver_->Recv("repeated")));
+  EXPECT_EQ(random, std::string_view(receiver_->Recv("random")));
+  EXPECT_EQ(repeated, std::string_view(receiver_->Recv("moved")));
+}
+
 INSTANTIATE_TEST_SUITE_P(
     Normal_Instances, ChannelBrpcWithLimitTest,
     testing::Combine(testing::Values(9, 17),
@@ -286,4 +325,168 @@ INSTANTIATE_TEST_SUITE_P(
       return name;
     });
 
+class ChannelBrpcMultiConnTest : public ChannelBrpcTest {
+ protected:
+  void SetUp() override {
+    options_.num_connections = 3;
+    ChannelBrpcTest::SetUp();
+  }
+};
+
+TEST_F(ChannelBrpcMultiConnTest, StripedShouldOk) {
+  sender_->SetHttpMaxPayloadSize(17);
+
+  // small msgs are balanced over connections, large ones striped.
+  std::vector<std::string> sent;
+  for (size_t size : {1, 10, 17, 18, 100, 1001}) {
+    sent.push_back(RandStr(size));
+    sender_->SendAsync(fmt::format("async_{}", size),
+                       ByteContainerView{sent.back()});
+    sender_->Send(fmt::format("sync_{}", size), sent.back());
+  }
+
+  size_t idx = 0;
+  for (size_t size : {1, 10, 17, 18, 100, 1001}) {
+    EXPECT_EQ(sent[idx], std::string_view(
+                             receiver_->Recv(fmt::format("async_{}", size))));
+    EXPECT_EQ(sent[idx],
+              std::string_view(receiver_->Recv(fmt::format("sync_{}", size))));
+    idx++;
+  }
+}
+
+class ChannelBrpcPriorityTest : public ChannelBrpcTest {
+ protected:
+  void SetUp() override {
+    options_.priority_threshold = 64;
+    ChannelBrpcTest::SetUp();
+  }
+};
+
+TEST_F(ChannelBrpcPriorityTest, SmallMsgsShouldNotWaitForBulk) {
+  sender_->SetHttpMaxPayloadSize(1024);
+
+  // a bulk msg in flight, small msgs go ahead over the priority connection.
+  const std::string bulk = RandStr(10 * 1024 * 1024);
+  sender_->SendAsync("bulk", ByteContainerView{bulk});
+  std::vector<std::string> sent;
+  for (size_t size : {0, 1, 64, 65, 1000}) {
+    sent.push_back(RandStr(size));
+    sender_->SendAsync(fmt::format("async_{}", size),
+                       ByteContainerView{sent.back()});
+    sender_->Send(fmt::format("sync_{}", size), sent.back());
+  }
+
+  size_t idx = 0;
+  for (size_t size : {0, 1, 64, 65, 1000}) {
+    EXPECT_EQ(sent[idx], std::string_view(
+                             receiver_->Recv(fmt::format("async_{}", size))));
+    EXPECT_EQ(sent[idx],
+              std::string_view(receiver_->Recv(fmt::format("sync_{}", size))));
+    idx++;
+  }
+  EXPECT_EQ(bulk, std::string_view(receiver_->Recv("bulk")));
+}
+
+class ChannelBrpcStreamTest : public ChannelBrpcTest {
+ protected:
+  void SetUp() override {
+    options_.stream_threshold = 100;
+    // a tiny window, so that writers wait for peer to consume.
+    options_.stream_window_size = 1024;
+    ChannelBrpcTest::SetUp();
+  }
+};
+
+TEST_F(ChannelBrpcStreamTest, StreamShouldOk) {
+  std::vector<std::string> sent;
+  for (size_t size : {0, 100, 101, 4096, 1000000}) {
+    sent.push_back(RandStr(size));
+    sender_->SendAsync(fmt::format("async_{}", size),
+                       ByteContainerView{sent.back()});
+    sender_->SendAsync(fmt::format("moved_{}", size),
+                       Buffer(sent.back().data(), sent.back().size()));
+    sender_->Send(fmt::format("sync_{}", size), sent.back());
+  }
+
+  size_t idx = 0;
+  for (size_t size : {0, 100, 101, 4096, 1000000}) {
+    for (const auto* prefix : {"async", "moved", "sync"}) {
+      EXPECT_EQ(sent[idx], std::string_view(receiver_->Recv(
+                               fmt::format("{}_{}", prefix, size))));
+    }
+    idx++;
+  }
+}
+
+TEST(ChannelBrpcStreamOptionsTest, StreamWithoutBaiduStdShouldThrow) {
+  ChannelBrpc::Options options;
+  options.channel_protocol = "http";
+  auto channel = std::make_shared<ChannelBrpc>(0, 1, options);
+  channel->SetPeerHost("127.0.0.1:12345");
+
+  EXPECT_THROW(channel->SendStream("key", "value"), EnforceNotMet);
+}
+
+TEST(ChannelBrpcResendTest, DuplicatedPushSeqShouldBeDropped) {
+  using State = ChannelBrpc::PushSeqState;
+  auto channel = std::make_shared<ChannelBrpc>(0, 1, ChannelBrpc::Options{});
+  auto deliver = [&](uint64_t seq) {
+    auto state = channel->AcceptPushSeq(seq);
+    if (state == State::kAccepted) {
+      channel->FinishPushSeq(seq, true);
+    }
+    return state;
+  };
+
+  EXPECT_EQ(deliver(2), State::kAccepted);
+  EXPECT_EQ(deliver(1), State::kAccepted);
+  EXPECT_EQ(deliver(1), State::kDelivered);
+  EXPECT_EQ(deliver(2), State::kDelivered);
+  EXPECT_EQ(deliver(4), State::kAccepted);
+  EXPECT_EQ(deliver(4), State::kDelivered);
+  // a gap is kept open until it is filled.
+  EXPECT_EQ(deliver(3), State::kAccepted);
+  EXPECT_EQ(deliver(3), State::kDelivered);
+}
+
+TEST(ChannelBrpcResendTest, FailedPushSeqShouldStayOpen) {
+  using State = ChannelBrpc::PushSeqState;
+  auto channel = std::make_shared<ChannelBrpc>(0, 1, ChannelBrpc::Options{});
+
+  ASSERT_EQ(channel->AcceptPushSeq(1), State::kAccepted);
+  // a resend waits for the copy being delivered.
+  auto resend = std::async(std::launch::async,
+                           [&] { return channel->AcceptPushSeq(1); });
+  EXPECT_EQ(resend.wait_for(std::chrono::milliseconds(50)),
+            std::future_status::timeout);
+  channel->FinishPushSeq(1, false);
+  ASSERT_EQ(resend.get(), State::kAccepted);
+  channel->FinishPushSeq(1, true);
+  EXPECT_EQ(channel->AcceptPushSeq(1), State::kDelivered);
+}
+
+TEST(ChannelBrpcResendTest, LateResendOfSkippedSeqShouldBeRefused) {
+  using State = ChannelBrpc::PushSeqState;
+  auto channel = std::make_shared<ChannelBrpc>(0, 1, ChannelBrpc::Options{});
+
+  // seq 1 is given up by peer, the ones after it pile up ahead until the gap
+  // is skipped.
+  for (uint64_t seq = 2; seq <= (1 << 16) + 2; ++seq) {
+    ASSERT_EQ(channel->AcceptPushSeq(seq), State::kAccepted);
+    channel->FinishPushSeq(seq, true);
+  }
+  EXPECT_EQ(channel->AcceptPushSeq(1), State::kDropped);
+  EXPECT_EQ(channel->AcceptPushSeq(2), State::kDelivered);
+}
+
+TEST(ChannelBrpcRdmaTest, RdmaWithoutBaiduStdShouldThrow) {
+  ChannelBrpc::Options options;
+  options.channel_protocol = "http";
+  options.use_rdma = true;
+  auto channel = std::make_shared<ChannelBrpc>(0, 1, options);
+
+  EXPECT_THROW(channel->SetPeerHost("127.0.0.1:12345"), EnforceNotMet);
+}
+
 }  // namespace yasl::link::test
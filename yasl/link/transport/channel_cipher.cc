@@ -0,0 +1,129 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/transport/channel_cipher.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/crypto/hmac_sha256.h"
+
+namespace yasl::link {
+
+namespace {
+
+using Iv = std::array<uint8_t, sizeof(uint32_t) + sizeof(uint64_t)>;
+
+Iv MakeIv(uint32_t sender_rank, uint64_t counter) {
+  Iv iv;
+  std::memcpy(iv.data(), &sender_rank, sizeof(sender_rank));
+  std::memcpy(iv.data() + sizeof(sender_rank), &counter, sizeof(counter));
+  return iv;
+}
+
+ByteContainerView AsView(std::string_view str) {
+  return ByteContainerView(str.data(), str.size());
+}
+
+}  // namespace
+
+ChannelCipher::ChannelCipher(ByteContainerView key, size_t self_rank,
+                             size_t peer_rank)
+    : self_rank_(static_cast<uint32_t>(self_rank)),
+      peer_rank_(static_cast<uint32_t>(peer_rank)),
+      ctx_(crypto::GcmCryptoSchema::AES128_GCM, key) {
+  YASL_ENFORCE(self_rank != peer_rank, "cipher to self, rank={}", self_rank);
+}
+
+std::vector<uint8_t> ChannelCipher::DeriveKey(ByteContainerView psk,
+                                              std::string_view session_id,
+                                              size_t rank,
+                                              ByteContainerView salt,
+                                              size_t peer_rank,
+                                              ByteContainerView peer_salt) {
+  YASL_ENFORCE(!psk.empty(), "empty pre-shared key");
+  if (rank > peer_rank) {
+    std::swap(rank, peer_rank);
+    std::swap(salt, peer_salt);
+  }
+
+  crypto::HmacSha256 hmac(psk);
+  const uint64_t ranks[2] = {rank, peer_rank};
+  hmac.Update("yasl-link-aead")
+      .Update(AsView(session_id))
+      .Update(ByteContainerView(ranks, sizeof(ranks)))
+      .Update(salt)
+      .Update(peer_salt);
+  auto key = hmac.CumulativeMac();
+  key.resize(kKeySize);
+  return key;
+}
+
+Buffer ChannelCipher::Seal(std::string_view aad, ByteContainerView value) {
+  Buffer sealed(static_cast<int64_t>(value.size() + kOverhead));
+  auto* data = sealed.data<uint8_t>();
+
+  std::unique_lock lock(seal_mutex_);
+  const uint64_t counter = counter_++;
+  const auto iv = MakeIv(self_rank_, counter);
+  ctx_.Encrypt(iv, value, AsView(aad), absl::MakeSpan(data, value.size()),
+               absl::MakeSpan(data + value.size(), kMacSize));
+  lock.unlock();
+
+  std::memcpy(data + value.size() + kMacSize, &counter, sizeof(counter));
+  return sealed;
+}
+
+void ChannelCipher::OpenTo(std::string_view aad, ByteContainerView sealed,
+                           uint8_t* out) {
+  YASL_ENFORCE(sealed.size() >= kOverhead, "sealed msg too short, size={}",
+               sealed.size());
+  const size_t size = sealed.size() - kOverhead;
+  uint64_t counter = 0;
+  std::memcpy(&counter, sealed.data() + size + kMacSize, sizeof(counter));
+  const auto iv = MakeIv(peer_rank_, counter);
+
+  std::unique_lock lock(open_mutex_);
+  ctx_.Decrypt(iv, ByteContainerView(sealed.data(), size), AsView(aad),
+               ByteContainerView(sealed.data() + size, kMacSize),
+               absl::MakeSpan(out, size));
+}
+
+Buffer ChannelCipher::Open(std::string_view aad, Buffer&& sealed) {
+  OpenTo(aad, ByteContainerView(sealed), sealed.data<uint8_t>());
+  const size_t size = sealed.size() - kOverhead;
+  if (size == 0) {
+    return {};
+  }
+  // trim the mac and counter without copy, the whole block is released with
+  // the value.
+  auto holder = std::make_shared<Buffer>(std::move(sealed));
+  void* data = holder->data();
+  return Buffer(data, size, [holder](void* /*ptr*/) {});
+}
+
+Buffer ChannelCipher::Open(std::string_view aad, ByteContainerView sealed) {
+  YASL_ENFORCE(sealed.size() >= kOverhead, "sealed msg too short, size={}",
+               sealed.size());
+  Buffer value(static_cast<int64_t>(sealed.size() - kOverhead));
+  OpenTo(aad, sealed, value.data<uint8_t>());
+  return value;
+}
+
+}  // namespace yasl::link
@@ -0,0 +1,78 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/byte_container_view.h"
+#include "yasl/crypto/gcm_crypto.h"
+
+namespace yasl::link {
+
+// Authenticated encryption of the msgs between a pair of parties, by
+// AES-128-GCM with a session key of the pair. The key of a msg is
+// authenticated as aad, so that a value can not be replayed under another key.
+//
+// The iv of a msg is made of the sender rank and a counter of the sender,
+// which is carried in the clear along with the mac:
+//
+//   | ciphertext | mac (16 bytes) | counter (8 bytes) |
+//
+// so that msgs can be opened in any order.
+class ChannelCipher {
+ public:
+  static constexpr size_t kKeySize = 16;
+  static constexpr size_t kMacSize = 16;
+  static constexpr size_t kOverhead = kMacSize + sizeof(uint64_t);
+
+  ChannelCipher(ByteContainerView key, size_t self_rank, size_t peer_rank);
+
+  // derives the session key of a pair from the pre-shared key, and the salts
+  // contributed by both sides, it does not depend on which side calls it.
+  static std::vector<uint8_t> DeriveKey(ByteContainerView psk,
+                                        std::string_view session_id,
+                                        size_t rank, ByteContainerView salt,
+                                        size_t peer_rank,
+                                        ByteContainerView peer_salt);
+
+  // encrypts the value in a single pass into the sealed msg.
+  Buffer Seal(std::string_view aad, ByteContainerView value);
+
+  // decrypts in place, the returned value takes over the memory of `sealed`.
+  // raise if the msg is not authentic.
+  Buffer Open(std::string_view aad, Buffer&& sealed);
+
+  Buffer Open(std::string_view aad, ByteContainerView sealed);
+
+ private:
+  // decrypts `sealed` into `out`, which may be the same memory.
+  void OpenTo(std::string_view aad, ByteContainerView sealed, uint8_t* out);
+
+  const uint32_t self_rank_;
+  const uint32_t peer_rank_;
+
+  crypto::GcmCipherContext ctx_;
+
+  // one seal and one open may run at the same time, see GcmCipherContext.
+  std::mutex seal_mutex_;
+  uint64_t counter_ = 0;
+  std::mutex open_mutex_;
+};
+
+}  // namespace yasl::link
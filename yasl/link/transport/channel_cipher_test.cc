@@ -0,0 +1,83 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/transport/channel_cipher.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl::link::test {
+
+class ChannelCipherTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const std::string psk = "pre-shared key";
+    key_ = ChannelCipher::DeriveKey(psk, "session", 0, "salt-0", 1, "salt-1");
+    alice_ = std::make_unique<ChannelCipher>(key_, 0, 1);
+    bob_ = std::make_unique<ChannelCipher>(key_, 1, 0);
+  }
+
+  std::vector<uint8_t> key_;
+  std::unique_ptr<ChannelCipher> alice_;
+  std::unique_ptr<ChannelCipher> bob_;
+};
+
+TEST_F(ChannelCipherTest, DeriveKeyShouldBeSymmetric) {
+  const std::string psk = "pre-shared key";
+  EXPECT_EQ(key_.size(), ChannelCipher::kKeySize);
+  EXPECT_EQ(key_, ChannelCipher::DeriveKey(psk, "session", 1, "salt-1", 0,
+                                           "salt-0"));
+  EXPECT_NE(key_, ChannelCipher::DeriveKey(psk, "session", 0, "salt-0", 1,
+                                           "salt-2"));
+  EXPECT_NE(key_, ChannelCipher::DeriveKey("another key", "session", 0,
+                                           "salt-0", 1, "salt-1"));
+}
+
+TEST_F(ChannelCipherTest, SealOpenInAnyOrderShouldOk) {
+  std::vector<std::string> values = {"", "a", std::string(10000, 'b')};
+  std::vector<Buffer> sealed;
+  for (const auto& value : values) {
+    sealed.push_back(alice_->Seal("key", value));
+    EXPECT_EQ(sealed.back().size(), value.size() + ChannelCipher::kOverhead);
+  }
+
+  for (size_t idx = values.size(); idx-- > 0;) {
+    EXPECT_EQ(values[idx], std::string_view(bob_->Open(
+                               "key", ByteContainerView(sealed[idx]))));
+    EXPECT_EQ(values[idx],
+              std::string_view(bob_->Open("key", std::move(sealed[idx]))));
+  }
+}
+
+TEST_F(ChannelCipherTest, TamperedShouldThrow) {
+  auto sealed = alice_->Seal("key", "value");
+
+  // wrong key of the msg.
+  EXPECT_ANY_THROW(bob_->Open("another", ByteContainerView(sealed)));
+  // a msg sealed by self is not accepted as peer's.
+  EXPECT_ANY_THROW(alice_->Open("key", ByteContainerView(sealed)));
+  // flipped bit.
+  sealed.data<uint8_t>()[0] ^= 1;
+  EXPECT_ANY_THROW(bob_->Open("key", ByteContainerView(sealed)));
+  // truncated.
+  EXPECT_THROW(bob_->Open("key", ByteContainerView(sealed.data(), 3)),
+               EnforceNotMet);
+}
+
+}  // namespace yasl::link::test
@@ -14,6 +14,10 @@
 
 #include "yasl/link/transport/channel_mem.h"
 
+#include <algorithm>
+
+#include "spdlog/spdlog.h"
+
 #include "yasl/base/exception.h"
 
 namespace yasl::link {
@@ -21,12 +25,119 @@ namespace yasl::link {
 ChannelMem::ChannelMem(size_t self_rank, size_t peer_rank, size_t timeout_ms)
     : ChannelBase(self_rank, peer_rank, timeout_ms) {}
 
+ChannelMem::~ChannelMem() {
+  if (network_thread_.joinable()) {
+    {
+      std::unique_lock lock(network_mutex_);
+      stop_network_ = true;
+    }
+    network_cond_.notify_all();
+    network_thread_.join();
+  }
+}
+
 void ChannelMem::SetPeer(const std::shared_ptr<ChannelMem>& peer_task) {
   peer_channel_ = peer_task;
 }
 
+void ChannelMem::SetNetworkOptions(const NetworkOptions& options) {
+  YASL_ENFORCE(!network_thread_.joinable(),
+               "network options could only be set once");
+  options_ = options;
+  emulated_ = options.latency_ms != 0 || options.jitter_ms != 0 ||
+              options.bandwidth_bytes != 0;
+  if (!emulated_) {
+    return;
+  }
+  tokens_ = static_cast<double>(options_.burst_bytes);
+  tokens_time_ = Clock::now();
+  last_deliver_at_ = tokens_time_;
+  rng_.seed(std::random_device{}());
+  network_thread_ = std::thread([this] { NetworkLoop(); });
+}
+
+void ChannelMem::Deliver(const std::string& key, Buffer&& value) {
+  if (auto ptr = peer_channel_.lock()) {
+    ptr->OnMessage(key, std::move(value));
+  } else {
+    YASL_THROW_IO_ERROR("Peer's memory channel released");
+  }
+}
+
+void ChannelMem::Emulate(const std::string& key, Buffer&& value) {
+  std::unique_lock lock(network_mutex_);
+  const auto now = Clock::now();
+  auto deliver_at = now;
+  if (options_.bandwidth_bytes != 0) {
+    const auto rate = static_cast<double>(options_.bandwidth_bytes);
+    const std::chrono::duration<double> idle = now - tokens_time_;
+    tokens_ = std::min(tokens_ + idle.count() * rate,
+                       static_cast<double>(options_.burst_bytes));
+    tokens_time_ = now;
+    tokens_ -= static_cast<double>(value.size());
+    if (tokens_ < 0) {
+      // the msg leaves once the link has sent out the bytes owed.
+      deliver_at += std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(-tokens_ / rate));
+    }
+  }
+  deliver_at += std::chrono::milliseconds(options_.latency_ms);
+  if (options_.jitter_ms != 0) {
+    deliver_at += std::chrono::microseconds(
+        std::uniform_int_distribution<int64_t>(0, options_.jitter_ms * 1000)(
+            rng_));
+  }
+  deliver_at = std::max(deliver_at, last_deliver_at_);
+  last_deliver_at_ = deliver_at;
+  flying_.push_back({deliver_at, key, std::move(value)});
+  network_cond_.notify_all();
+}
+
+void ChannelMem::NetworkLoop() {
+  std::unique_lock lock(network_mutex_);
+  while (true) {
+    if (flying_.empty()) {
+      if (stop_network_) {
+        return;
+      }
+      network_cond_.wait(lock);
+      continue;
+    }
+    if (Clock::now() < flying_.front().deliver_at && !stop_network_) {
+      network_cond_.wait_until(lock, flying_.front().deliver_at);
+      continue;
+    }
+    auto msg = std::move(flying_.front());
+    flying_.pop_front();
+    delivering_ = true;
+    lock.unlock();
+    try {
+      Deliver(msg.key, std::move(msg.value));
+    } catch (const std::exception& e) {
+      SPDLOG_ERROR("deliver msg key={} failed, error={}", msg.key, e.what());
+    }
+    lock.lock();
+    delivering_ = false;
+    // wakes up WaitAsyncSendToFinish.
+    network_cond_.notify_all();
+  }
+}
+
+void ChannelMem::WaitAsyncSendToFinish() {
+  if (!emulated_) {
+    return;
+  }
+  std::unique_lock lock(network_mutex_);
+  network_cond_.wait(lock,
+                     [this] { return flying_.empty() && !delivering_; });
+}
+
 void ChannelMem::SendAsyncImpl(const std::string& key,
                                ByteContainerView value) {
+  if (emulated_) {
+    Emulate(key, Buffer(value.data(), value.size()));
+    return;
+  }
   if (auto ptr = peer_channel_.lock()) {
     ptr->OnMessage(key, value);
   } else {
@@ -35,7 +146,11 @@ void ChannelMem::SendAsyncImpl(const std::string& key,
 }
 
 void ChannelMem::SendAsyncImpl(const std::string& key, Buffer&& value) {
-  SendAsyncImpl(key, value);
+  if (emulated_) {
+    Emulate(key, std::move(value));
+    return;
+  }
+  Deliver(key, std::move(value));
 }
 
 void ChannelMem::SendImpl(const std::string& key, ByteContainerView value) {
@@ -14,9 +14,14 @@
 
 #pragma once
 
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <random>
+#include <string>
+#include <thread>
 
 #include "yasl/link/transport/channel.h"
 
@@ -38,17 +43,68 @@ class ChannelMem final : public ChannelBase {
   void SendImpl(const std::string& key, ByteContainerView value) override;
 
  public:
-  ~ChannelMem() override = default;
+  // emulated network of the direction from this channel to peer, msgs are
+  // delivered instantly if all of them are 0.
+  struct NetworkOptions {
+    // one way latency.
+    uint32_t latency_ms = 0;
+    // extra latency of each msg, uniformly random in [0, jitter_ms]. msgs
+    // are still delivered in order, like a stream transport.
+    uint32_t jitter_ms = 0;
+    // token bucket rate in bytes per second, 0 means unlimited.
+    uint64_t bandwidth_bytes = 0;
+    // token bucket size, bytes may go at once after the link is idle.
+    uint64_t burst_bytes = 64 * 1024;
+  };
+
+  ~ChannelMem() override;
 
   ChannelMem(size_t self_rank, size_t peer_rank, size_t timeout_ms = 20000U);
 
   void SetPeer(const std::shared_ptr<ChannelMem>& peer_task);
 
-  void WaitAsyncSendToFinish() override {}
+  // should be called before any msg is sent.
+  void SetNetworkOptions(const NetworkOptions& options);
+
+  // waits until the emulated network delivered all msgs.
+  void WaitAsyncSendToFinish() override;
 
  protected:
   // Note: we should never manage peer's lifetime.
   std::weak_ptr<ChannelMem> peer_channel_;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Flying {
+    Clock::time_point deliver_at;
+    std::string key;
+    Buffer value;
+  };
+
+  void Deliver(const std::string& key, Buffer&& value);
+
+  // queue a msg to be delivered by the network thread.
+  void Emulate(const std::string& key, Buffer&& value);
+
+  void NetworkLoop();
+
+  NetworkOptions options_;
+  bool emulated_ = false;
+
+  std::mutex network_mutex_;
+  std::condition_variable network_cond_;
+  std::deque<Flying> flying_;
+  // a msg is taken out of flying_ but not delivered yet.
+  bool delivering_ = false;
+  bool stop_network_ = false;
+  // token bucket, negative tokens are owed by the msgs queued on the link.
+  double tokens_ = 0;
+  Clock::time_point tokens_time_;
+  // delivery time of the last msg, later msgs never overtake it.
+  Clock::time_point last_deliver_at_;
+  std::mt19937 rng_;
+  std::thread network_thread_;
 };
 
 }  // namespace yasl::link
@@ -0,0 +1,226 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/transport/channel_mem.h"
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+namespace yasl::link::test {
+
+class ChannelMemTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    sender_ = std::make_shared<ChannelMem>(0, 1, 2000);
+    receiver_ = std::make_shared<ChannelMem>(1, 0, 2000);
+    sender_->SetPeer(receiver_);
+    receiver_->SetPeer(sender_);
+  }
+
+  void TearDown() override {
+    auto f_s = std::async([&] { sender_->WaitLinkTaskFinish(); });
+    auto f_r = std::async([&] { receiver_->WaitLinkTaskFinish(); });
+    f_s.get();
+    f_r.get();
+  }
+
+  std::shared_ptr<ChannelMem> sender_;
+  std::shared_ptr<ChannelMem> receiver_;
+};
+
+TEST_F(ChannelMemTest, LatencyShouldDelay) {
+  // GIVEN
+  ChannelMem::NetworkOptions options;
+  options.latency_ms = 50;
+  sender_->SetNetworkOptions(options);
+
+  // WHEN
+  const auto start = std::chrono::steady_clock::now();
+  sender_->SendAsync("key", ByteContainerView("value"));
+  auto received = receiver_->Recv("key");
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  // THEN
+  EXPECT_EQ(std::string_view(received), "value");
+  EXPECT_GE(elapsed, std::chrono::milliseconds(50));
+}
+
+TEST_F(ChannelMemTest, BandwidthShouldLimit) {
+  // GIVEN
+  ChannelMem::NetworkOptions options;
+  options.bandwidth_bytes = 10 * 1024 * 1024;
+  options.burst_bytes = 0;
+  sender_->SetNetworkOptions(options);
+  const std::string value(100 * 1024, 'x');
+
+  // WHEN
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < 10; i++) {
+    sender_->SendAsync(fmt::format("key_{}", i), ByteContainerView(value));
+  }
+  for (size_t i = 0; i < 10; i++) {
+    EXPECT_EQ(receiver_->Recv(fmt::format("key_{}", i)).size(), value.size());
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  // THEN 1MB at 10MB/s.
+  EXPECT_GE(elapsed, std::chrono::milliseconds(95));
+}
+
+TEST_F(ChannelMemTest, JitterShouldKeepOrder) {
+  // GIVEN
+  ChannelMem::NetworkOptions options;
+  options.jitter_ms = 5;
+  sender_->SetNetworkOptions(options);
+  std::mutex mutex;
+  std::vector<size_t> arrived;
+  for (size_t i = 0; i < 50; i++) {
+    receiver_->RecvAsync(fmt::format("key_{}", i), [&, i](Buffer&&) {
+      std::unique_lock lock(mutex);
+      arrived.push_back(i);
+    });
+  }
+
+  // WHEN
+  for (size_t i = 0; i < 50; i++) {
+    sender_->SendAsync(fmt::format("key_{}", i), ByteContainerView("value"));
+  }
+  sender_->WaitAsyncSendToFinish();
+
+  // THEN
+  std::unique_lock lock(mutex);
+  ASSERT_EQ(arrived.size(), 50);
+  for (size_t i = 0; i < 50; i++) {
+    EXPECT_EQ(arrived[i], i);
+  }
+}
+
+TEST_F(ChannelMemTest, CipherShouldSealAndOpen) {
+  // GIVEN
+  const auto key = ChannelCipher::DeriveKey("psk", "session", 0, "salt-0", 1,
+                                            "salt-1");
+  sender_->SetCipher(std::make_shared<ChannelCipher>(key, 0, 1));
+
+  // WHEN
+  // sealed msgs arrive before receiver sets its cipher, they are parked.
+  sender_->SendAsync("async", ByteContainerView("value"));
+  sender_->SendAsync("moved", Buffer("moved", 5));
+  sender_->Send("sync", "sync value");
+  sender_->SendAsync("chain", ByteChainView{"ch", "ain"});
+  std::vector<std::pair<std::string, Buffer>> batch;
+  batch.emplace_back("batch_0", Buffer("b0", 2));
+  batch.emplace_back("batch_1", Buffer());
+  sender_->SendAsyncBatch(std::move(batch));
+  receiver_->SetCipher(std::make_shared<ChannelCipher>(key, 1, 0));
+  receiver_->SendAsync("back", ByteContainerView("back value"));
+
+  // THEN
+  EXPECT_EQ(std::string_view(receiver_->Recv("async")), "value");
+  EXPECT_EQ(std::string_view(receiver_->Recv("moved")), "moved");
+  EXPECT_EQ(std::string_view(receiver_->Recv("sync")), "sync value");
+  EXPECT_EQ(std::string_view(receiver_->Recv("chain")), "chain");
+  EXPECT_EQ(std::string_view(receiver_->Recv("batch_0")), "b0");
+  EXPECT_EQ(receiver_->Recv("batch_1").size(), 0);
+  EXPECT_EQ(std::string_view(sender_->Recv("back")), "back value");
+  // plain msgs are refused once encrypted.
+  EXPECT_THROW(receiver_->OnMessage("plain", ByteContainerView("value")),
+               EnforceNotMet);
+}
+
+TEST_F(ChannelMemTest, LanesShouldKeepKeysApart) {
+  // GIVEN
+  const size_t lane = sender_->NewLane();
+  EXPECT_EQ(receiver_->NewLane(), lane);
+  EXPECT_NE(lane, 0);
+
+  // WHEN
+  sender_->SendAsync("key", ByteContainerView("default"));
+  sender_->SendAsync(LaneKey(lane, "key"), ByteContainerView("lane"));
+  sender_->Send(LaneKey(0, "other"), "other");
+
+  // THEN
+  EXPECT_EQ(std::string_view(receiver_->Recv(LaneKey(lane, "key"))), "lane");
+  EXPECT_EQ(receiver_->GetStats().unread_bytes, 12);
+  EXPECT_EQ(std::string_view(receiver_->Recv("key")), "default");
+  EXPECT_EQ(std::string_view(receiver_->Recv("other")), "other");
+}
+
+TEST_F(ChannelMemTest, ChunksShouldReassemble) {
+  const std::string value = "0123456789";
+  // map mode, peer does not tell the length.
+  receiver_->OnChunkedMessage("map", ByteContainerView(value.data() + 5, 5),
+                              1, 2, 5, 0);
+  receiver_->OnChunkedMessage("map", ByteContainerView(value.data() + 5, 5),
+                              1, 2, 5, 0);
+  receiver_->OnChunkedMessage("map", ByteContainerView(value.data(), 5), 0, 2,
+                              0, 0);
+  // preallocated mode, written in place.
+  receiver_->OnChunkedMessage("pre", ByteContainerView(value.data() + 4, 6),
+                              1, 2, 4, value.size());
+  receiver_->OnChunkedMessage("pre", ByteContainerView(value.data(), 4), 0, 2,
+                              0, value.size());
+
+  EXPECT_EQ(std::string_view(receiver_->Recv("map")), value);
+  EXPECT_EQ(std::string_view(receiver_->Recv("pre")), value);
+}
+
+TEST_F(ChannelMemTest, MalformedChunksShouldThrow) {
+  const std::string value = "0123456789";
+  auto add = [&](const std::string& key, size_t idx, size_t num_chunks,
+                 size_t offset, size_t size, size_t length) {
+    receiver_->OnChunkedMessage(key, ByteContainerView(value.data(), size),
+                                idx, num_chunks, offset, length);
+  };
+
+  EXPECT_ANY_THROW(add("index", 2, 2, 0, 5, 10));
+  EXPECT_ANY_THROW(add("offset", 0, 2, 8, 5, 10));
+  // wraps around in offset + size.
+  EXPECT_ANY_THROW(add("offset", 0, 2, ~size_t(0) - 2, 5, 10));
+  // a later chunk can not reshape the msg.
+  add("shape", 0, 2, 0, 5, 10);
+  EXPECT_ANY_THROW(add("shape", 3, 4, 5, 5, 10));
+  EXPECT_ANY_THROW(add("shape", 1, 2, 5, 5, 20));
+  EXPECT_ANY_THROW(add("shape", 1, 2, 5, 5, 0));
+  add("shape", 1, 2, 5, 5, 10);
+  EXPECT_EQ(std::string_view(receiver_->Recv("shape")), "0123401234");
+}
+
+TEST_F(ChannelMemTest, UnwatchShouldReleaseNotifier) {
+  // GIVEN
+  auto notifier = std::make_shared<RecvNotifier>();
+  auto other = std::make_shared<RecvNotifier>();
+  Buffer value;
+  EXPECT_FALSE(receiver_->TryRecv("key", &value, notifier));
+  EXPECT_EQ(notifier.use_count(), 2);
+
+  // WHEN
+  // the watcher of another notifier is kept.
+  receiver_->Unwatch("key", other);
+  EXPECT_EQ(notifier.use_count(), 2);
+  receiver_->Unwatch("key", notifier);
+  sender_->SendAsync("key", ByteContainerView("value"));
+
+  // THEN
+  EXPECT_EQ(notifier.use_count(), 1);
+  EXPECT_EQ(std::string_view(receiver_->Recv("key")), "value");
+  EXPECT_EQ(notifier->Seq(), 0);
+}
+
+}  // namespace yasl::link::test
@@ -0,0 +1,332 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/transport/channel_replay.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+
+#include "fmt/format.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl::link {
+namespace {
+
+constexpr char kMagic[4] = {'Y', 'R', 'P', 'L'};
+constexpr uint32_t kVersion = 1;
+
+template <class T>
+void Put(T v, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+template <class T>
+bool Get(std::ifstream* in, T* v) {
+  return static_cast<bool>(in->read(reinterpret_cast<char*>(v), sizeof(T)));
+}
+
+}  // namespace
+
+std::string ReplayFilePath(const std::string& dir, size_t self_rank,
+                           size_t peer_rank) {
+  return fmt::format("{}/{}_from_{}.yrpl", dir, self_rank, peer_rank);
+}
+
+class RecordingChannel::Writer {
+ public:
+  Writer(const std::string& path, size_t self_rank, size_t peer_rank)
+      : path_(path), start_(std::chrono::steady_clock::now()) {
+    const auto parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) {
+      std::filesystem::create_directories(parent);
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+      YASL_THROW_IO_ERROR("open {} for recording failed, error={}", path,
+                          std::strerror(errno));
+    }
+    std::string header(kMagic, sizeof(kMagic));
+    Put<uint32_t>(kVersion, &header);
+    Put<uint64_t>(self_rank, &header);
+    Put<uint64_t>(peer_rank, &header);
+    std::lock_guard<std::mutex> lock(mutex_);
+    WriteLocked(header);
+    std::fflush(file_);
+  }
+
+  ~Writer() { std::fclose(file_); }
+
+  void Write(const std::string& key, std::string_view value) {
+    const auto arrival_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_)
+            .count();
+    std::string head;
+    Put<uint64_t>(arrival_ns, &head);
+    Put<uint32_t>(key.size(), &head);
+    Put<uint64_t>(value.size(), &head);
+    head += key;
+    // a msg is written as a whole, receivers of lanes may race.
+    std::lock_guard<std::mutex> lock(mutex_);
+    WriteLocked(head);
+    WriteLocked(value);
+    // flushed per msg, so a run which crashes is still replayable up to it.
+    if (std::fflush(file_) != 0) {
+      YASL_THROW_IO_ERROR("flush recording {} failed, error={}", path_,
+                          std::strerror(errno));
+    }
+  }
+
+ private:
+  void WriteLocked(std::string_view data) {
+    if (!data.empty() &&
+        std::fwrite(data.data(), 1, data.size(), file_) != data.size()) {
+      YASL_THROW_IO_ERROR("write recording {} failed, error={}", path_,
+                          std::strerror(errno));
+    }
+  }
+
+  const std::string path_;
+  const std::chrono::steady_clock::time_point start_;
+  std::mutex mutex_;
+  std::FILE* file_ = nullptr;
+};
+
+RecordingChannel::RecordingChannel(std::shared_ptr<IChannel> channel,
+                                   const std::string& dir, size_t self_rank,
+                                   size_t peer_rank)
+    : channel_(std::move(channel)),
+      writer_(std::make_shared<Writer>(
+          ReplayFilePath(dir, self_rank, peer_rank), self_rank, peer_rank)) {}
+
+Buffer RecordingChannel::Recv(const std::string& key) {
+  auto value = channel_->Recv(key);
+  writer_->Write(key, value);
+  return value;
+}
+
+void RecordingChannel::RecvAsync(const std::string& key,
+                                 RecvCallback callback) {
+  channel_->RecvAsync(key, [writer = writer_, key,
+                            callback = std::move(callback)](Buffer&& value) {
+    writer->Write(key, value);
+    callback(std::move(value));
+  });
+}
+
+bool RecordingChannel::TryRecv(const std::string& key, Buffer* value,
+                               const std::shared_ptr<RecvNotifier>& notifier) {
+  if (!channel_->TryRecv(key, value, notifier)) {
+    return false;
+  }
+  writer_->Write(key, *value);
+  return true;
+}
+
+void RecordChannels(const std::string& dir, size_t self_rank,
+                    std::vector<std::shared_ptr<IChannel>>* channels) {
+  if (dir.empty()) {
+    return;
+  }
+  for (size_t rank = 0; rank < channels->size(); rank++) {
+    auto& channel = (*channels)[rank];
+    if (channel) {
+      channel = std::make_shared<RecordingChannel>(std::move(channel), dir,
+                                                   self_rank, rank);
+    }
+  }
+}
+
+ReplayChannel::ReplayChannel(const std::string& dir, size_t self_rank,
+                             size_t peer_rank, ReplayTiming timing)
+    : peer_rank_(peer_rank) {
+  const auto path = ReplayFilePath(dir, self_rank, peer_rank);
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    YASL_THROW_IO_ERROR("open recording {} failed", path);
+  }
+  char magic[sizeof(kMagic)];
+  uint32_t version = 0;
+  uint64_t self = 0;
+  uint64_t peer = 0;
+  if (!in.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      !Get(&in, &version) || version != kVersion || !Get(&in, &self) ||
+      !Get(&in, &peer) || self != self_rank || peer != peer_rank) {
+    YASL_THROW_INVALID_FORMAT("{} is not a recording of rank={} from rank={}",
+                              path, self_rank, peer_rank);
+  }
+
+  const auto start = Clock::now();
+  uint64_t arrival_ns = 0;
+  while (Get(&in, &arrival_ns)) {
+    uint32_t key_size = 0;
+    uint64_t value_size = 0;
+    std::string key;
+    Msg msg;
+    bool ok = Get(&in, &key_size) && Get(&in, &value_size);
+    if (ok) {
+      key.resize(key_size);
+      msg.value = Buffer(static_cast<int64_t>(value_size));
+      ok = in.read(key.data(), key_size) &&
+           in.read(msg.value.data<char>(), value_size);
+    }
+    if (!ok) {
+      YASL_THROW_INVALID_FORMAT("recording {} is truncated at msg {}", path,
+                                remaining_);
+    }
+    msg.ready_at = timing == ReplayTiming::kRecorded
+                       ? start + std::chrono::nanoseconds(arrival_ns)
+                       : start;
+    msgs_[key].push_back(std::move(msg));
+    remaining_++;
+  }
+
+  timer_thread_ = std::thread([this] { TimerLoop(); });
+}
+
+ReplayChannel::~ReplayChannel() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_timer_ = true;
+  }
+  timer_cond_.notify_all();
+  timer_thread_.join();
+}
+
+bool ReplayChannel::Pop(const std::string& key, Msg* msg) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = msgs_.find(key);
+  if (it == msgs_.end()) {
+    return false;
+  }
+  *msg = std::move(it->second.front());
+  it->second.pop_front();
+  if (it->second.empty()) {
+    msgs_.erase(it);
+  }
+  remaining_--;
+  return true;
+}
+
+Buffer ReplayChannel::Recv(const std::string& key) {
+  Msg msg;
+  if (!Pop(key, &msg)) {
+    YASL_THROW_IO_ERROR("key={} from rank={} is not in the recording", key,
+                        peer_rank_);
+  }
+  std::this_thread::sleep_until(msg.ready_at);
+  return std::move(msg.value);
+}
+
+void ReplayChannel::RecvAsync(const std::string& key, RecvCallback callback) {
+  Msg msg;
+  if (!Pop(key, &msg)) {
+    // never arrives, like a msg peer never sent.
+    return;
+  }
+  if (msg.ready_at <= Clock::now()) {
+    callback(std::move(msg.value));
+    return;
+  }
+  RunAt(msg.ready_at, [callback = std::move(callback),
+                       value = std::move(msg.value)]() mutable {
+    callback(std::move(value));
+  });
+}
+
+bool ReplayChannel::TryRecv(const std::string& key, Buffer* value,
+                            const std::shared_ptr<RecvNotifier>& notifier) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = msgs_.find(key);
+  if (it == msgs_.end()) {
+    return false;
+  }
+  const auto ready_at = it->second.front().ready_at;
+  if (ready_at > Clock::now()) {
+    lock.unlock();
+    RunAt(ready_at, [notifier] { notifier->Notify(); });
+    return false;
+  }
+  lock.unlock();
+  Msg msg;
+  // the front msg may be taken by another receiver meanwhile, then this one
+  // is ready as well.
+  if (!Pop(key, &msg)) {
+    return false;
+  }
+  *value = std::move(msg.value);
+  return true;
+}
+
+void ReplayChannel::OnMessage(const std::string& key, ByteContainerView) {
+  YASL_THROW_LOGIC_ERROR("replay channel got a msg of key={}", key);
+}
+
+void ReplayChannel::OnMessage(const std::string& key, Buffer&&) {
+  YASL_THROW_LOGIC_ERROR("replay channel got a msg of key={}", key);
+}
+
+void ReplayChannel::OnChunkedMessage(const std::string& key,
+                                     ByteContainerView, size_t, size_t,
+                                     size_t, size_t) {
+  YASL_THROW_LOGIC_ERROR("replay channel got a msg of key={}", key);
+}
+
+size_t ReplayChannel::NewLane() {
+  // as ChannelBase, so that lane keys match the recorded ones.
+  const size_t lane = ++lane_counter_;
+  YASL_ENFORCE(lane < ChannelBase::kMaxLanes, "too many lanes, max={}",
+               ChannelBase::kMaxLanes - 1);
+  return lane;
+}
+
+size_t ReplayChannel::Remaining() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return remaining_;
+}
+
+void ReplayChannel::RunAt(Clock::time_point at, std::function<void()> fn) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timers_.emplace(at, std::move(fn));
+  }
+  timer_cond_.notify_all();
+}
+
+void ReplayChannel::TimerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_timer_) {
+    if (timers_.empty()) {
+      timer_cond_.wait(lock);
+      continue;
+    }
+    auto it = timers_.begin();
+    if (it->first > Clock::now()) {
+      timer_cond_.wait_until(lock, it->first);
+      continue;
+    }
+    auto fn = std::move(it->second);
+    timers_.erase(it);
+    lock.unlock();
+    fn();
+    lock.lock();
+  }
+}
+
+}  // namespace yasl::link
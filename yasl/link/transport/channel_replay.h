@@ -0,0 +1,263 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "yasl/link/transport/channel.h"
+
+namespace yasl::link {
+
+// Record and replay of the msgs a party receives, so that the compute of a
+// single party can be profiled with the network, and the other parties,
+// taken out of the measurement.
+//
+// A recording is a file per (self, peer) channel, little endian:
+//
+//   "YRPL" u32 version, u64 self rank, u64 peer rank
+//   per msg: u64 arrival ns, u32 key size, u64 value size, key, value
+//
+// arrival is the time the msg was handed to the receiver, since the channel
+// was created. values are the plain ones, after decryption if the link is
+// encrypted.
+
+// the recording of msgs from `peer_rank` to `self_rank` in `dir`.
+std::string ReplayFilePath(const std::string& dir, size_t self_rank,
+                           size_t peer_rank);
+
+// Forwards everything to `channel`, and appends each msg received from it
+// to its recording in `dir`, see ReplayFilePath.
+class RecordingChannel final : public IChannel {
+ public:
+  RecordingChannel(std::shared_ptr<IChannel> channel, const std::string& dir,
+                   size_t self_rank, size_t peer_rank);
+
+  void SendAsync(const std::string& key, ByteContainerView value) override {
+    channel_->SendAsync(key, value);
+  }
+
+  void SendAsync(const std::string& key, Buffer&& value) override {
+    channel_->SendAsync(key, std::move(value));
+  }
+
+  void SendAsync(const std::string& key, ByteChainView value) override {
+    channel_->SendAsync(key, value);
+  }
+
+  void SendAsyncBatch(
+      std::vector<std::pair<std::string, Buffer>>&& msgs) override {
+    channel_->SendAsyncBatch(std::move(msgs));
+  }
+
+  void Send(const std::string& key, ByteContainerView value) override {
+    channel_->Send(key, value);
+  }
+
+  Buffer Recv(const std::string& key) override;
+
+  void RecvAsync(const std::string& key, RecvCallback callback) override;
+
+  bool TryRecv(const std::string& key, Buffer* value,
+               const std::shared_ptr<RecvNotifier>& notifier) override;
+
+  void Unwatch(const std::string& key,
+               const std::shared_ptr<RecvNotifier>& notifier) override {
+    channel_->Unwatch(key, notifier);
+  }
+
+  void OnMessage(const std::string& key, ByteContainerView value) override {
+    channel_->OnMessage(key, value);
+  }
+
+  void OnMessage(const std::string& key, Buffer&& value) override {
+    channel_->OnMessage(key, std::move(value));
+  }
+
+  void OnChunkedMessage(const std::string& key, ByteContainerView value,
+                        size_t chunk_idx, size_t num_chunks, size_t offset,
+                        size_t message_length) override {
+    channel_->OnChunkedMessage(key, value, chunk_idx, num_chunks, offset,
+                               message_length);
+  }
+
+  void SetRecvTimeout(uint32_t timeout_ms) override {
+    channel_->SetRecvTimeout(timeout_ms);
+  }
+
+  uint32_t GetRecvTimeout() const override {
+    return channel_->GetRecvTimeout();
+  }
+
+  void WaitLinkTaskFinish() override { channel_->WaitLinkTaskFinish(); }
+
+  void SetThrottleWindowSize(size_t size) override {
+    channel_->SetThrottleWindowSize(size);
+  }
+
+  void SetAckBatchSize(size_t size) override {
+    channel_->SetAckBatchSize(size);
+  }
+
+  void SetThrottleWindowBytes(size_t bytes) override {
+    channel_->SetThrottleWindowBytes(bytes);
+  }
+
+  void SetRecvBufferLimit(size_t bytes) override {
+    channel_->SetRecvBufferLimit(bytes);
+  }
+
+  ChannelStats GetStats() const override { return channel_->GetStats(); }
+
+  void SetCipher(std::shared_ptr<ChannelCipher> cipher) override {
+    channel_->SetCipher(std::move(cipher));
+  }
+
+  size_t NewLane() override { return channel_->NewLane(); }
+
+ private:
+  // shared with the pending RecvAsync callbacks.
+  class Writer;
+
+  const std::shared_ptr<IChannel> channel_;
+  const std::shared_ptr<Writer> writer_;
+};
+
+// wraps each channel of `channels` but the null one of self by a
+// RecordingChannel, if `dir` is not empty.
+void RecordChannels(const std::string& dir, size_t self_rank,
+                    std::vector<std::shared_ptr<IChannel>>* channels);
+
+enum class ReplayTiming {
+  // a msg is ready at its recorded arrival time, since the channel was
+  // created, so the receiver waits as long as it did when recorded.
+  kRecorded,
+  // all msgs are ready at once, the network is removed.
+  kZero,
+};
+
+// Serves the msgs of a recording in `dir`, see ReplayFilePath, to the
+// receivers. msgs are matched by key, so the party must run the same
+// protocol with the same keys as recorded, and with the same randomness if
+// the values it computes should be meaningful. Sends are dropped. A Recv of
+// a key which is not recorded raises at once, instead of waiting for the
+// timeout.
+class ReplayChannel final : public IChannel {
+ public:
+  ReplayChannel(const std::string& dir, size_t self_rank, size_t peer_rank,
+                ReplayTiming timing);
+
+  ~ReplayChannel() override;
+
+  void SendAsync(const std::string&, ByteContainerView) override {}
+
+  void SendAsync(const std::string&, Buffer&&) override {}
+
+  void SendAsync(const std::string&, ByteChainView) override {}
+
+  void SendAsyncBatch(std::vector<std::pair<std::string, Buffer>>&&) override {
+  }
+
+  void Send(const std::string&, ByteContainerView) override {}
+
+  Buffer Recv(const std::string& key) override;
+
+  void RecvAsync(const std::string& key, RecvCallback callback) override;
+
+  bool TryRecv(const std::string& key, Buffer* value,
+               const std::shared_ptr<RecvNotifier>& notifier) override;
+
+  void OnMessage(const std::string& key, ByteContainerView value) override;
+
+  void OnMessage(const std::string& key, Buffer&& value) override;
+
+  void OnChunkedMessage(const std::string& key, ByteContainerView value,
+                        size_t chunk_idx, size_t num_chunks, size_t offset,
+                        size_t message_length) override;
+
+  void SetRecvTimeout(uint32_t timeout_ms) override {
+    recv_timeout_ms_ = timeout_ms;
+  }
+
+  uint32_t GetRecvTimeout() const override { return recv_timeout_ms_; }
+
+  void WaitLinkTaskFinish() override {}
+
+  void SetThrottleWindowSize(size_t) override {}
+
+  void SetAckBatchSize(size_t) override {}
+
+  void SetThrottleWindowBytes(size_t) override {}
+
+  void SetRecvBufferLimit(size_t) override {}
+
+  ChannelStats GetStats() const override { return {}; }
+
+  // values are recorded in plain.
+  void SetCipher(std::shared_ptr<ChannelCipher>) override {}
+
+  size_t NewLane() override;
+
+  // msgs of the recording not received yet.
+  size_t Remaining() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Msg {
+    Clock::time_point ready_at;
+    Buffer value;
+  };
+
+  // pops the first msg of key, false if there is none.
+  bool Pop(const std::string& key, Msg* msg);
+
+  // runs `fn` at `at` on the timer thread.
+  void RunAt(Clock::time_point at, std::function<void()> fn);
+
+  void TimerLoop();
+
+  const size_t peer_rank_;
+  uint32_t recv_timeout_ms_ = 3 * 60 * 1000;
+  std::atomic<size_t> lane_counter_ = 0;
+
+  mutable std::mutex mutex_;
+  std::map<std::string, std::deque<Msg>, std::less<>> msgs_;
+  size_t remaining_ = 0;
+
+  // delayed RecvAsync callbacks and TryRecv notifies, by time.
+  std::multimap<Clock::time_point, std::function<void()>> timers_;
+  std::condition_variable timer_cond_;
+  bool stop_timer_ = false;
+  std::thread timer_thread_;
+};
+
+// ReplayChannels have nothing to listen to.
+class ReceiverLoopReplay final : public ReceiverLoopBase {
+ public:
+  void Stop() override {}
+};
+
+}  // namespace yasl::link
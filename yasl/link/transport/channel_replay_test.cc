@@ -0,0 +1,158 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/transport/channel_replay.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/link/transport/channel_mem.h"
+
+namespace yasl::link::test {
+
+class ChannelReplayTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = (std::filesystem::temp_directory_path() /
+            ("channel_replay_test_" + std::to_string(getpid())))
+               .string();
+    sender_ = std::make_shared<ChannelMem>(0, 1, 2000);
+    auto receiver = std::make_shared<ChannelMem>(1, 0, 2000);
+    sender_->SetPeer(receiver);
+    receiver->SetPeer(sender_);
+    receiver_ = std::make_shared<RecordingChannel>(receiver, dir_, 1, 0);
+  }
+
+  void TearDown() override {
+    auto f_s = std::async([&] { sender_->WaitLinkTaskFinish(); });
+    auto f_r = std::async([&] { receiver_->WaitLinkTaskFinish(); });
+    f_s.get();
+    f_r.get();
+    std::filesystem::remove_all(dir_);
+  }
+
+  // records "a", then "b" after `delay`, then "a" again.
+  void Record(std::chrono::milliseconds delay) {
+    sender_->SendAsync("a", ByteContainerView("first"));
+    EXPECT_EQ(std::string_view(receiver_->Recv("a")), "first");
+
+    std::promise<std::string> b;
+    receiver_->RecvAsync(
+        "b", [&](Buffer&& value) { b.set_value(std::string(value)); });
+    std::this_thread::sleep_for(delay);
+    sender_->SendAsync("b", ByteContainerView("second"));
+    EXPECT_EQ(b.get_future().get(), "second");
+
+    sender_->SendAsync("a", ByteContainerView("third"));
+    auto notifier = std::make_shared<RecvNotifier>();
+    Buffer value;
+    while (!receiver_->TryRecv("a", &value, notifier)) {
+      notifier->WaitUntil(notifier->Seq(), std::chrono::steady_clock::now() +
+                                               std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(std::string_view(value), "third");
+  }
+
+  std::string dir_;
+  std::shared_ptr<ChannelMem> sender_;
+  std::shared_ptr<IChannel> receiver_;
+};
+
+TEST_F(ChannelReplayTest, ZeroTimingShouldServeAtOnce) {
+  // GIVEN
+  Record(std::chrono::milliseconds(100));
+  ReplayChannel replay(dir_, 1, 0, ReplayTiming::kZero);
+  EXPECT_EQ(replay.Remaining(), 3);
+
+  // WHEN
+  const auto start = std::chrono::steady_clock::now();
+  auto first = replay.Recv("a");
+  std::promise<std::string> b;
+  replay.RecvAsync("b",
+                   [&](Buffer&& value) { b.set_value(std::string(value)); });
+  Buffer third;
+  EXPECT_TRUE(
+      replay.TryRecv("a", &third, std::make_shared<RecvNotifier>()));
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  // THEN
+  EXPECT_EQ(std::string_view(first), "first");
+  EXPECT_EQ(b.get_future().get(), "second");
+  EXPECT_EQ(std::string_view(third), "third");
+  EXPECT_LT(elapsed, std::chrono::milliseconds(50));
+  EXPECT_EQ(replay.Remaining(), 0);
+  // sends go nowhere.
+  replay.SendAsync("c", ByteContainerView("ignored"));
+}
+
+TEST_F(ChannelReplayTest, RecordedTimingShouldDelay) {
+  // GIVEN
+  Record(std::chrono::milliseconds(100));
+  ReplayChannel replay(dir_, 1, 0, ReplayTiming::kRecorded);
+
+  // WHEN
+  const auto start = std::chrono::steady_clock::now();
+  replay.Recv("a");
+  std::promise<std::string> b;
+  replay.RecvAsync("b",
+                   [&](Buffer&& value) { b.set_value(std::string(value)); });
+  auto notifier = std::make_shared<RecvNotifier>();
+  const auto seq = notifier->Seq();
+  Buffer third;
+  const bool ready = replay.TryRecv("a", &third, notifier);
+
+  // THEN
+  EXPECT_EQ(b.get_future().get(), "second");
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(90));
+  if (!ready) {
+    EXPECT_TRUE(notifier->WaitUntil(
+        seq, std::chrono::steady_clock::now() + std::chrono::seconds(1)));
+    EXPECT_TRUE(replay.TryRecv("a", &third, notifier));
+  }
+  EXPECT_EQ(std::string_view(third), "third");
+}
+
+TEST_F(ChannelReplayTest, MissingKeyShouldThrow) {
+  Record(std::chrono::milliseconds(0));
+  ReplayChannel replay(dir_, 1, 0, ReplayTiming::kZero);
+
+  EXPECT_THROW(replay.Recv("not_recorded"), IoError);
+  // a msg is served once.
+  replay.Recv("b");
+  EXPECT_THROW(replay.Recv("b"), IoError);
+}
+
+TEST_F(ChannelReplayTest, BadRecordingShouldThrow) {
+  Record(std::chrono::milliseconds(0));
+  // recorded by rank 1 from rank 0 only.
+  EXPECT_THROW(ReplayChannel(dir_, 0, 1, ReplayTiming::kZero), IoError);
+
+  const auto path = ReplayFilePath(dir_, 1, 0);
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+  EXPECT_THROW(ReplayChannel(dir_, 1, 0, ReplayTiming::kZero), InvalidFormat);
+
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << "not a recording";
+  EXPECT_THROW(ReplayChannel(dir_, 1, 0, ReplayTiming::kZero), InvalidFormat);
+}
+
+}  // namespace yasl::link::test
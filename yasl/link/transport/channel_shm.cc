@@ -0,0 +1,487 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/transport/channel_shm.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <utility>
+
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl::link {
+
+namespace {
+
+constexpr uint64_t kShmRingMagic = 0x32676e52'6d687359;  // "YshmRng2"
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "futex needs a plain 32 bit word");
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "atomics shared between processes must be lock free");
+
+void FutexWait(std::atomic<uint32_t>* word, uint32_t expected,
+               std::chrono::milliseconds timeout) {
+  const auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  const auto nsecs =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - secs);
+  timespec ts{static_cast<time_t>(secs.count()),
+              static_cast<long>(nsecs.count())};
+  // not FUTEX_PRIVATE_FLAG, the word is shared between processes.
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected,
+          &ts, nullptr, 0);
+}
+
+void FutexWake(std::atomic<uint32_t>* word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX,
+          nullptr, nullptr, 0);
+}
+
+bool ProcessAlive(int64_t pid) {
+  return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+}
+
+// both frame fields are followed by its bytes.
+struct FrameHeader {
+  uint64_t key_length;
+  uint64_t value_length;
+};
+
+}  // namespace
+
+struct ShmRing::Header {
+  uint64_t magic;
+  uint64_t capacity;
+  // a segment whose creator is gone is a stale one of a crashed run.
+  int64_t owner_pid;
+  // set by the creator once the header is initialized.
+  std::atomic<uint32_t> ready;
+
+  // total bytes written, only changed by the writer.
+  alignas(64) std::atomic<uint64_t> write_pos;
+  // bumped by the writer if reader is waiting, reader sleeps on it.
+  std::atomic<uint32_t> data_seq;
+  std::atomic<uint32_t> reader_waiting;
+
+  // total bytes read, only changed by the reader.
+  alignas(64) std::atomic<uint64_t> read_pos;
+  // bumped by the reader if writer is waiting, writer sleeps on it.
+  std::atomic<uint32_t> space_seq;
+  std::atomic<uint32_t> writer_waiting;
+
+  // cumulative acks, posted by the writer, see ShmRing::PostAck.
+  alignas(64) std::atomic<uint64_t> ack_count;
+  std::atomic<uint64_t> ack_bytes;
+  std::atomic<uint64_t> ack_request;
+};
+
+namespace {
+
+// sleep on `seq` until `ready` returns true or deadline, `waiting` tells the
+// other side to wake us.
+template <typename Pred>
+bool WaitOn(std::atomic<uint32_t>* seq, std::atomic<uint32_t>* waiting,
+            Pred&& ready, std::chrono::steady_clock::time_point deadline) {
+  while (true) {
+    const uint32_t observed = seq->load();
+    waiting->store(1);
+    // seq_cst pairs with the other side's "update pos, then check waiting".
+    if (ready()) {
+      waiting->store(0);
+      return true;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      waiting->store(0);
+      return false;
+    }
+    // sleep in slices, so that a missed wake up never hangs us for long.
+    FutexWait(seq, observed,
+              std::min<std::chrono::milliseconds>(
+                  std::chrono::duration_cast<std::chrono::milliseconds>(
+                      deadline - now) +
+                      std::chrono::milliseconds(1),
+                  std::chrono::milliseconds(1000)));
+    waiting->store(0);
+  }
+}
+
+}  // namespace
+
+std::string ShmRingName(std::string_view session_id, size_t src_rank,
+                        size_t dst_rank) {
+  // shm names allow no '/' except the leading one.
+  std::string id(session_id.substr(0, 128));
+  std::replace_if(
+      id.begin(), id.end(),
+      [](unsigned char c) {
+        return !(std::isalnum(c) || c == '-' || c == '_');
+      },
+      '.');
+  return fmt::format("/yasl.{}.{}.{}", id, src_rank, dst_rank);
+}
+
+ShmRing::ShmRing(std::string name, void* addr, size_t mapped_size, bool owner)
+    : name_(std::move(name)),
+      addr_(addr),
+      mapped_size_(mapped_size),
+      owner_(owner),
+      header_(static_cast<Header*>(addr)),
+      data_(static_cast<std::byte*>(addr) + sizeof(Header)) {}
+
+ShmRing::~ShmRing() {
+  munmap(addr_, mapped_size_);
+  if (owner_) {
+    shm_unlink(name_.c_str());
+  }
+}
+
+std::unique_ptr<ShmRing> ShmRing::Create(const std::string& name,
+                                         size_t capacity) {
+  YASL_ENFORCE(capacity > 0, "shm ring capacity should be positive");
+  const size_t mapped_size = sizeof(Header) + capacity;
+
+  // remove the stale segment left by a crashed run.
+  shm_unlink(name.c_str());
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    YASL_THROW_IO_ERROR("shm_open {} failed, errno={}", name, errno);
+  }
+  if (ftruncate(fd, static_cast<off_t>(mapped_size)) != 0) {
+    const int err = errno;
+    close(fd);
+    shm_unlink(name.c_str());
+    YASL_THROW_IO_ERROR("ftruncate {} failed, errno={}", name, err);
+  }
+  void* addr =
+      mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    YASL_THROW_IO_ERROR("mmap {} failed, errno={}", name, errno);
+  }
+
+  auto* header = new (addr) Header();
+  header->magic = kShmRingMagic;
+  header->capacity = capacity;
+  header->owner_pid = getpid();
+  header->ready.store(1);
+
+  return std::unique_ptr<ShmRing>(
+      new ShmRing(name, addr, mapped_size, /*owner*/ true));
+}
+
+std::unique_ptr<ShmRing> ShmRing::Open(const std::string& name) {
+  const int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(Header)) {
+    // not truncated by the creator yet.
+    close(fd);
+    return nullptr;
+  }
+  const auto mapped_size = static_cast<size_t>(st.st_size);
+  void* addr =
+      mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+
+  auto* header = static_cast<Header*>(addr);
+  if (header->ready.load() != 1 || header->magic != kShmRingMagic ||
+      header->capacity + sizeof(Header) != mapped_size ||
+      !ProcessAlive(header->owner_pid)) {
+    // the creator unlinks a stale one once it starts.
+    munmap(addr, mapped_size);
+    return nullptr;
+  }
+  return std::unique_ptr<ShmRing>(
+      new ShmRing(name, addr, mapped_size, /*owner*/ false));
+}
+
+void ShmRing::Write(const void* data, size_t size,
+                    std::chrono::milliseconds timeout) {
+  const uint64_t capacity = header_->capacity;
+  const auto* src = static_cast<const std::byte*>(data);
+  while (size > 0) {
+    const uint64_t write_pos = header_->write_pos.load();
+    const uint64_t read_pos = header_->read_pos.load();
+    const uint64_t free_space = capacity - (write_pos - read_pos);
+    if (free_space == 0) {
+      const bool progressed = WaitOn(
+          &header_->space_seq, &header_->writer_waiting,
+          [&] { return header_->read_pos.load() != read_pos; },
+          std::chrono::steady_clock::now() + timeout);
+      if (!progressed) {
+        YASL_THROW_IO_ERROR("shm ring {} write timeout", name_);
+      }
+      continue;
+    }
+
+    const size_t length = std::min<uint64_t>(size, free_space);
+    const size_t offset = write_pos % capacity;
+    const size_t first = std::min<size_t>(length, capacity - offset);
+    std::memcpy(data_ + offset, src, first);
+    std::memcpy(data_, src + first, length - first);
+
+    header_->write_pos.store(write_pos + length);
+    if (header_->reader_waiting.load() != 0) {
+      header_->data_seq.fetch_add(1);
+      FutexWake(&header_->data_seq);
+    }
+    src += length;
+    size -= length;
+  }
+}
+
+bool ShmRing::Read(void* data, size_t size,
+                   const std::function<void()>& on_wait) {
+  const uint64_t capacity = header_->capacity;
+  auto* dst = static_cast<std::byte*>(data);
+  while (size > 0) {
+    const uint64_t read_pos = header_->read_pos.load();
+    const uint64_t write_pos = header_->write_pos.load();
+    if (write_pos == read_pos) {
+      if (on_wait) {
+        on_wait();
+      }
+      WaitOn(
+          &header_->data_seq, &header_->reader_waiting,
+          [&] {
+            return stopped_ || header_->write_pos.load() != read_pos ||
+                   (on_wait && HasNewAcks());
+          },
+          std::chrono::steady_clock::time_point::max());
+      if (stopped_) {
+        return false;
+      }
+      continue;
+    }
+
+    const size_t length = std::min<uint64_t>(size, write_pos - read_pos);
+    const size_t offset = read_pos % capacity;
+    const size_t first = std::min<size_t>(length, capacity - offset);
+    std::memcpy(dst, data_ + offset, first);
+    std::memcpy(dst + first, data_, length - first);
+
+    header_->read_pos.store(read_pos + length);
+    if (header_->writer_waiting.load() != 0) {
+      header_->space_seq.fetch_add(1);
+      FutexWake(&header_->space_seq);
+    }
+    dst += length;
+    size -= length;
+  }
+  return !stopped_;
+}
+
+void ShmRing::NotifyReader() {
+  if (header_->reader_waiting.load() != 0) {
+    header_->data_seq.fetch_add(1);
+    FutexWake(&header_->data_seq);
+  }
+}
+
+void ShmRing::PostAck(uint64_t count, uint64_t bytes) {
+  header_->ack_count.fetch_add(count);
+  header_->ack_bytes.fetch_add(bytes);
+  NotifyReader();
+}
+
+void ShmRing::PostAckRequest(uint64_t target) {
+  uint64_t request = header_->ack_request.load();
+  while (request < target &&
+         !header_->ack_request.compare_exchange_weak(request, target)) {
+  }
+  NotifyReader();
+}
+
+bool ShmRing::HasNewAcks() const {
+  return header_->ack_count.load() != taken_acks_.count ||
+         header_->ack_bytes.load() != taken_acks_.bytes ||
+         header_->ack_request.load() != taken_acks_.request;
+}
+
+ShmRing::Acks ShmRing::TakeAcks() {
+  Acks acks;
+  const uint64_t count = header_->ack_count.load();
+  const uint64_t bytes = header_->ack_bytes.load();
+  const uint64_t request = header_->ack_request.load();
+  acks.count = count - taken_acks_.count;
+  acks.bytes = bytes - taken_acks_.bytes;
+  if (request != taken_acks_.request) {
+    acks.request = request;
+  }
+  taken_acks_ = {count, bytes, request};
+  return acks;
+}
+
+void ShmRing::Stop() {
+  stopped_ = true;
+  header_->data_seq.fetch_add(1);
+  FutexWake(&header_->data_seq);
+}
+
+ReceiverLoopShm::~ReceiverLoopShm() { Stop(); }
+
+void ReceiverLoopShm::Stop() {
+  for (auto& ring : rings_) {
+    ring->Stop();
+  }
+  for (auto& thread : threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  threads_.clear();
+  rings_.clear();
+}
+
+void ReceiverLoopShm::Start(std::string_view session_id, size_t self_rank,
+                            size_t ring_capacity) {
+  YASL_ENFORCE(threads_.empty(), "shm receiver loop is already running");
+
+  std::vector<std::pair<ShmRing*, IChannel*>> inbounds;
+  for (const auto& [rank, listener] : listeners_) {
+    rings_.push_back(ShmRing::Create(
+        ShmRingName(session_id, rank, self_rank), ring_capacity));
+    inbounds.emplace_back(rings_.back().get(), listener.get());
+  }
+
+  for (const auto& [ring, listener] : inbounds) {
+    threads_.emplace_back([ring = ring, listener = listener] {
+      const std::function<void()> dispatch_acks = [&] {
+        const auto acks = ring->TakeAcks();
+        try {
+          if (acks.count != 0 || acks.bytes != 0) {
+            const size_t ack[2] = {acks.count, acks.bytes};
+            listener->OnMessage(AckMsgKey(),
+                                ByteContainerView{ack, sizeof(ack)});
+          }
+          if (acks.request != 0) {
+            const size_t target = acks.request;
+            listener->OnMessage(AckRequestMsgKey(),
+                                ByteContainerView{&target, sizeof(target)});
+          }
+        } catch (const std::exception& e) {
+          SPDLOG_ERROR("dispatch acks error, error={}", e.what());
+        }
+      };
+      while (true) {
+        FrameHeader frame;
+        if (!ring->Read(&frame, sizeof(frame), dispatch_acks)) {
+          return;
+        }
+        std::string key(frame.key_length, '\0');
+        Buffer value(static_cast<int64_t>(frame.value_length));
+        if (!ring->Read(key.data(), key.size(), dispatch_acks) ||
+            !ring->Read(value.data(), frame.value_length, dispatch_acks)) {
+          return;
+        }
+        try {
+          listener->OnMessage(key, std::move(value));
+        } catch (const std::exception& e) {
+          SPDLOG_ERROR("dispatch error, key={}, error={}", key, e.what());
+        }
+        dispatch_acks();
+      }
+    });
+  }
+}
+
+ChannelShm::ChannelShm(size_t self_rank, size_t peer_rank,
+                       std::string_view session_id, size_t recv_timeout_ms)
+    : ChannelBase(self_rank, peer_rank, recv_timeout_ms),
+      ring_name_(ShmRingName(session_id, self_rank, peer_rank)) {}
+
+ShmRing* ChannelShm::Ring() {
+  std::lock_guard lock(open_mutex_);
+  if (!ring_) {
+    ring_ = ShmRing::Open(ring_name_);
+    if (!ring_) {
+      YASL_THROW_NETWORK_ERROR("shm ring {} is not ready", ring_name_);
+    }
+  }
+  return ring_.get();
+}
+
+void ChannelShm::Write(const std::string& key, ByteChainView value) {
+  auto* ring = Ring();
+  if (key == AckMsgKey() || key == AckRequestMsgKey()) {
+    // acks go beside the ring and never wait for its space.
+    size_t fields[2] = {1, 0};
+    YASL_ENFORCE(value.size() <= sizeof(fields), "invalid ack of {} bytes",
+                 value.size());
+    auto* dst = reinterpret_cast<std::byte*>(fields);
+    for (const auto& part : value.parts()) {
+      std::memcpy(dst, part.data(), part.size());
+      dst += part.size();
+    }
+    if (key == AckMsgKey()) {
+      ring->PostAck(fields[0], fields[1]);
+    } else {
+      YASL_ENFORCE(value.size() == sizeof(size_t));
+      ring->PostAckRequest(fields[0]);
+    }
+    return;
+  }
+
+  std::unique_lock lock(send_mutex_);
+  const FrameHeader frame{key.size(), value.size()};
+  const std::chrono::milliseconds timeout(recv_timeout_ms_);
+  ring->Write(&frame, sizeof(frame), timeout);
+  ring->Write(key.data(), key.size(), timeout);
+  for (const auto& part : value.parts()) {
+    ring->Write(part.data(), part.size(), timeout);
+  }
+}
+
+void ChannelShm::SendAsyncImpl(const std::string& key,
+                               ByteContainerView value) {
+  Write(key, ByteChainView{value});
+}
+
+void ChannelShm::SendAsyncImpl(const std::string& key, Buffer&& value) {
+  Write(key, ByteChainView{ByteContainerView(value)});
+}
+
+void ChannelShm::SendAsyncImpl(const std::string& key, ByteChainView value) {
+  Write(key, value);
+}
+
+void ChannelShm::SendImpl(const std::string& key, ByteContainerView value) {
+  Write(key, ByteChainView{value});
+}
+
+}  // namespace yasl::link
@@ -0,0 +1,158 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "yasl/link/transport/channel.h"
+
+namespace yasl::link {
+
+// name of the shared memory segment carrying msgs from src_rank to dst_rank.
+std::string ShmRingName(std::string_view session_id, size_t src_rank,
+                        size_t dst_rank);
+
+// A single producer, single consumer byte ring inside a POSIX shared memory
+// segment. The receiver creates the segment and the sender opens it, both
+// sides sleep on futex words inside the segment when it is empty or full.
+//
+// Beside the ring the segment holds cumulative ack counters, which the
+// writer posts without ever waiting for ring space. So a receiver thread
+// acking msgs never blocks on a ring the peer may be blocked on in turn.
+class ShmRing {
+ public:
+  // acks carried beside the ring, see PostAck.
+  struct Acks {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    // the highest ack request, 0 if none.
+    uint64_t request = 0;
+  };
+
+  // create and own a new segment, a stale one with the same name is removed.
+  static std::unique_ptr<ShmRing> Create(const std::string& name,
+                                         size_t capacity);
+
+  // open the segment created by peer, returns nullptr if it is not ready,
+  // or if it is a stale one whose creator is gone.
+  static std::unique_ptr<ShmRing> Open(const std::string& name);
+
+  ~ShmRing();
+
+  ShmRing(const ShmRing&) = delete;
+  ShmRing& operator=(const ShmRing&) = delete;
+
+  // blocks until all bytes are written, raise if the reader makes no
+  // progress within `timeout`.
+  void Write(const void* data, size_t size, std::chrono::milliseconds timeout);
+
+  // blocks until `size` bytes are read, returns false once stopped.
+  // `on_wait` is called before each wait for data, and whenever acks are
+  // posted meanwhile.
+  bool Read(void* data, size_t size,
+            const std::function<void()>& on_wait = nullptr);
+
+  // writer side, never blocks. thread safe.
+  void PostAck(uint64_t count, uint64_t bytes);
+  void PostAckRequest(uint64_t target);
+
+  // reader side, the acks posted since the last call; request is only set
+  // if it was raised.
+  Acks TakeAcks();
+
+  // wake up the reader and make all following reads fail.
+  void Stop();
+
+ private:
+  struct Header;
+
+  ShmRing(std::string name, void* addr, size_t mapped_size, bool owner);
+
+  bool HasNewAcks() const;
+  // wake the reader if it waits.
+  void NotifyReader();
+
+  const std::string name_;
+  void* const addr_;
+  const size_t mapped_size_;
+  // the creator unlinks the segment on destruction.
+  const bool owner_;
+
+  Header* header_;
+  std::byte* data_;
+
+  std::atomic<bool> stopped_ = false;
+  // acks taken so far by the reader.
+  Acks taken_acks_;
+};
+
+class ReceiverLoopShm final : public ReceiverLoopBase {
+ public:
+  ~ReceiverLoopShm() override;
+
+  void Stop() override;
+
+  // create inbound rings of all listeners, and dispatch their msgs and
+  // acks in one thread per peer.
+  void Start(std::string_view session_id, size_t self_rank,
+             size_t ring_capacity);
+
+ private:
+  std::vector<std::unique_ptr<ShmRing>> rings_;
+  std::vector<std::thread> threads_;
+};
+
+class ChannelShm final : public ChannelBase {
+ private:
+  void SendAsyncImpl(const std::string& key, ByteContainerView value) override;
+  void SendAsyncImpl(const std::string& key, Buffer&& value) override;
+  // the parts are copied into the ring one by one.
+  void SendAsyncImpl(const std::string& key, ByteChainView value) override;
+
+  void SendImpl(const std::string& key, ByteContainerView value) override;
+
+ public:
+  ChannelShm(size_t self_rank, size_t peer_rank, std::string_view session_id,
+             size_t recv_timeout_ms);
+
+  // msgs are written into the ring in place, nothing is left flying.
+  void WaitAsyncSendToFinish() override {}
+
+ private:
+  void Write(const std::string& key, ByteChainView value);
+
+  // opened on first use, raise NetworkError before peer created it, so
+  // that ConnectToMesh retries.
+  ShmRing* Ring();
+
+  const std::string ring_name_;
+
+  // protects the ring, which only allows a single writer. acks are posted
+  // beside it without this lock, the receiver thread must not wait for a
+  // sender blocked on a full ring.
+  std::mutex send_mutex_;
+  std::mutex open_mutex_;
+  std::unique_ptr<ShmRing> ring_;
+};
+
+}  // namespace yasl::link
@@ -0,0 +1,210 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/transport/channel_shm.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <future>
+#include <string>
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+#include "yasl/base/byte_container_view.h"
+#include "yasl/base/exception.h"
+
+namespace yasl::link::test {
+
+static std::string RandStr(size_t length) {
+  std::string str(length, 0);
+  for (auto& c : str) {
+    c = static_cast<char>('a' + rand() % 26);
+  }
+  return str;
+}
+
+class ChannelShmTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  void SetUp() override {
+    const auto* test = ::testing::UnitTest::GetInstance()->current_test_info();
+    session_id_ = fmt::format("{}-{}-{}", test->test_suite_name(),
+                              test->name(), getpid());
+    const size_t ring_capacity = GetParam();
+
+    sender_ = std::make_shared<ChannelShm>(0, 1, session_id_, 2000);
+    receiver_ = std::make_shared<ChannelShm>(1, 0, session_id_, 2000);
+
+    receiver_loop_ = std::make_unique<ReceiverLoopShm>();
+    receiver_loop_->AddListener(0, receiver_);
+    receiver_loop_->Start(session_id_, 1, ring_capacity);
+
+    sender_loop_ = std::make_unique<ReceiverLoopShm>();
+    sender_loop_->AddListener(1, sender_);
+    sender_loop_->Start(session_id_, 0, ring_capacity);
+  }
+
+  void TearDown() override {
+    auto wait = [](std::shared_ptr<ChannelShm>& l) {
+      if (l) {
+        l->WaitLinkTaskFinish();
+      }
+    };
+    auto f_s = std::async(wait, std::ref(sender_));
+    auto f_r = std::async(wait, std::ref(receiver_));
+    f_s.get();
+    f_r.get();
+  }
+
+  std::string session_id_;
+  std::shared_ptr<ChannelShm> sender_;
+  std::shared_ptr<ChannelShm> receiver_;
+  std::unique_ptr<ReceiverLoopShm> receiver_loop_;
+  std::unique_ptr<ReceiverLoopShm> sender_loop_;
+};
+
+TEST_P(ChannelShmTest, Normal_Empty) {
+  const std::string key = "key";
+  const std::string sent;
+  sender_->SendAsync(key, ByteContainerView{sent});
+  auto received = receiver_->Recv(key);
+
+  EXPECT_EQ(sent, std::string_view(received));
+}
+
+TEST_P(ChannelShmTest, Timeout) {
+  receiver_->SetRecvTimeout(500U);
+  EXPECT_THROW(receiver_->Recv("key"), IoError);
+}
+
+TEST_P(ChannelShmTest, SendAsync) {
+  for (size_t size : {1, 100, 10000, 100000}) {
+    const auto key = fmt::format("key_{}", size);
+    const std::string sent = RandStr(size);
+    sender_->SendAsync(key, ByteContainerView{sent});
+    auto received = receiver_->Recv(key);
+
+    EXPECT_EQ(sent, std::string_view(received));
+  }
+}
+
+TEST_P(ChannelShmTest, SendAsyncChain) {
+  const std::string head = RandStr(10);
+  const std::string body = RandStr(100000);
+  sender_->SendAsync("chain",
+                     ByteChainView{head, ByteContainerView(), body, head});
+  auto received = receiver_->Recv("chain");
+
+  EXPECT_EQ(head + body + head, std::string_view(received));
+}
+
+TEST_P(ChannelShmTest, Send) {
+  const std::string sent = RandStr(10000);
+  sender_->Send("key", sent);
+  auto received = receiver_->Recv("key");
+
+  EXPECT_EQ(sent, std::string_view(received));
+}
+
+TEST_P(ChannelShmTest, ConcurrentSenders) {
+  const size_t kNumSenders = 4;
+  const size_t kMsgPerSender = 50;
+
+  std::vector<std::future<void>> senders;
+  for (size_t s = 0; s < kNumSenders; s++) {
+    senders.push_back(std::async(std::launch::async, [&, s] {
+      for (size_t i = 0; i < kMsgPerSender; i++) {
+        const auto value = fmt::format("{}-{}", s, i);
+        sender_->SendAsync(fmt::format("{}:{}", s, i),
+                           Buffer(value.data(), value.size()));
+      }
+    }));
+  }
+  for (auto& sender : senders) {
+    sender.get();
+  }
+
+  for (size_t s = 0; s < kNumSenders; s++) {
+    for (size_t i = 0; i < kMsgPerSender; i++) {
+      auto received = receiver_->Recv(fmt::format("{}:{}", s, i));
+      EXPECT_EQ(std::string_view(received), fmt::format("{}-{}", s, i));
+    }
+  }
+}
+
+TEST_P(ChannelShmTest, ThrottleWindow) {
+  sender_->SetThrottleWindowSize(2);
+  auto recv = std::async([&] {
+    for (size_t i = 0; i < 20; i++) {
+      EXPECT_EQ(std::string_view(receiver_->Recv(fmt::format("key_{}", i))),
+                fmt::format("value_{}", i));
+    }
+  });
+  for (size_t i = 0; i < 20; i++) {
+    sender_->SendAsync(fmt::format("key_{}", i),
+                       ByteContainerView(fmt::format("value_{}", i)));
+  }
+  recv.get();
+  sender_->SetThrottleWindowSize(0);
+}
+
+TEST_P(ChannelShmTest, BothSidesFull) {
+  // duplicate keys are acked by the receiver threads, while both rings are
+  // kept full. the acks must not wait for ring space.
+  const size_t kNumMsgs = 300;
+  const std::string value = RandStr(1000);
+  auto run = [&](const std::shared_ptr<ChannelShm>& channel) {
+    for (size_t i = 0; i < kNumMsgs; i++) {
+      channel->SendAsync("key", ByteContainerView(value));
+    }
+    EXPECT_EQ(std::string_view(channel->Recv("key")), value);
+  };
+  auto f_s = std::async(std::launch::async, run, sender_);
+  auto f_r = std::async(std::launch::async, run, receiver_);
+  f_s.get();
+  f_r.get();
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Normal_Instances, ChannelShmTest, testing::Values(7, 4096, 1 << 20),
+    [](const testing::TestParamInfo<ChannelShmTest::ParamType>& info) {
+      return fmt::format("Capacity_{}", info.param);
+    });
+
+TEST(ChannelShmNotReadyTest, SendBeforePeerStartsShouldThrowNetworkError) {
+  auto channel = std::make_shared<ChannelShm>(
+      0, 1, fmt::format("not_ready-{}", getpid()), 2000);
+
+  EXPECT_THROW(channel->Send("key", "value"), NetworkError);
+}
+
+TEST(ShmRingTest, StaleSegmentShouldNotOpen) {
+  const auto name = ShmRingName(fmt::format("stale-{}", getpid()), 0, 1);
+  // a crashed run leaves its segment behind.
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    ShmRing::Create(name, 4096).release();
+    _exit(0);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+
+  EXPECT_EQ(ShmRing::Open(name), nullptr);
+  auto ring = ShmRing::Create(name, 4096);
+  EXPECT_NE(ShmRing::Open(name), nullptr);
+}
+
+}  // namespace yasl::link::test
@@ -0,0 +1,528 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/transport/channel_tcp.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/inlined_vector.h"
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl::link {
+
+namespace {
+
+// both frame fields are followed by its bytes.
+struct FrameHeader {
+  uint64_t key_length;
+  uint64_t value_length;
+};
+
+// split "host:port".
+std::pair<std::string, std::string> SplitHost(const std::string& host) {
+  const auto pos = host.rfind(':');
+  YASL_ENFORCE(pos != std::string::npos, "invalid host={}, expect addr:port",
+               host);
+  return {host.substr(0, pos), host.substr(pos + 1)};
+}
+
+struct AddrInfoDeleter {
+  void operator()(addrinfo* info) const { freeaddrinfo(info); }
+};
+
+std::unique_ptr<addrinfo, AddrInfoDeleter> Resolve(const std::string& host,
+                                                   bool passive) {
+  const auto [addr, port] = SplitHost(host);
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = passive ? AI_PASSIVE : 0;
+  addrinfo* result = nullptr;
+  const int ret = getaddrinfo(addr.empty() ? nullptr : addr.c_str(),
+                              port.c_str(), &hints, &result);
+  if (ret != 0) {
+    YASL_THROW_NETWORK_ERROR("resolve host={} failed, error={}", host,
+                             gai_strerror(ret));
+  }
+  return std::unique_ptr<addrinfo, AddrInfoDeleter>(result);
+}
+
+// read state of an inbound connection, msgs are parsed in stages.
+class Connection {
+ public:
+  Connection(int fd, uint64_t max_frame_size)
+      : fd_(fd), max_frame_size_(max_frame_size) {}
+
+  ~Connection() { close(fd_); }
+
+  // read all available bytes, returns false once the connection is closed.
+  bool ReadAvailable(
+      const std::map<size_t, std::shared_ptr<IChannel>>& listeners) {
+    while (true) {
+      ssize_t n = 0;
+      if (stage_ == Stage::kValue && remaining_ >= sizeof(staging_)) {
+        // large value, read into place without staging.
+        n = read(fd_, target_, remaining_);
+        if (n > 0) {
+          target_ += n;
+          remaining_ -= n;
+          if (remaining_ == 0) {
+            Advance(listeners);
+          }
+        }
+      } else {
+        n = read(fd_, staging_, sizeof(staging_));
+        if (n > 0) {
+          Consume(staging_, static_cast<size_t>(n), listeners);
+        }
+      }
+
+      if (n == 0) {
+        return false;
+      }
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+      }
+    }
+  }
+
+ private:
+  enum class Stage { kRank, kHeader, kKey, kValue };
+
+  void Consume(const char* data, size_t size,
+               const std::map<size_t, std::shared_ptr<IChannel>>& listeners) {
+    while (size > 0) {
+      const size_t length = std::min(size, remaining_);
+      std::memcpy(target_, data, length);
+      target_ += length;
+      remaining_ -= length;
+      data += length;
+      size -= length;
+      if (remaining_ == 0) {
+        Advance(listeners);
+      }
+    }
+  }
+
+  // current stage is filled, move on, empty stages are skipped.
+  void Advance(const std::map<size_t, std::shared_ptr<IChannel>>& listeners) {
+    while (remaining_ == 0) {
+      switch (stage_) {
+        case Stage::kRank: {
+          auto itr = listeners.find(static_cast<size_t>(rank_));
+          YASL_ENFORCE(itr != listeners.end(), "listener rank={} not found",
+                       rank_);
+          listener_ = itr->second.get();
+          Expect(Stage::kHeader, &header_, sizeof(header_));
+          break;
+        }
+        case Stage::kHeader:
+          YASL_ENFORCE(header_.key_length <= max_frame_size_ &&
+                           header_.value_length <=
+                               max_frame_size_ - header_.key_length,
+                       "frame of key_length={}, value_length={} from rank={} "
+                       "exceeds max_frame_size={}",
+                       header_.key_length, header_.value_length, rank_,
+                       max_frame_size_);
+          key_.resize(header_.key_length);
+          Expect(Stage::kKey, key_.data(), key_.size());
+          break;
+        case Stage::kKey:
+          value_ = Buffer(static_cast<int64_t>(header_.value_length));
+          Expect(Stage::kValue, value_.data(), header_.value_length);
+          break;
+        case Stage::kValue:
+          try {
+            listener_->OnMessage(key_, std::move(value_));
+          } catch (const std::exception& e) {
+            SPDLOG_ERROR("dispatch error, key={}, error={}", key_, e.what());
+          }
+          Expect(Stage::kHeader, &header_, sizeof(header_));
+          // a header is never empty, stop here.
+          return;
+      }
+    }
+  }
+
+  void Expect(Stage stage, void* target, size_t size) {
+    stage_ = stage;
+    target_ = static_cast<char*>(target);
+    remaining_ = size;
+  }
+
+  const int fd_;
+  const uint64_t max_frame_size_;
+
+  Stage stage_ = Stage::kRank;
+  char* target_ = reinterpret_cast<char*>(&rank_);
+  size_t remaining_ = sizeof(rank_);
+
+  uint64_t rank_ = 0;
+  IChannel* listener_ = nullptr;
+  FrameHeader header_;
+  std::string key_;
+  Buffer value_;
+
+  char staging_[64 * 1024];
+};
+
+// write all iovecs, raise NetworkError on failure.
+void WriteFully(int fd, iovec* iov, size_t iovcnt) {
+  while (iovcnt > 0) {
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    // long chains are written IOV_MAX parts at a time.
+    msg.msg_iovlen = std::min<size_t>(iovcnt, IOV_MAX);
+    // never raise SIGPIPE when peer is gone.
+    const ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      YASL_THROW_NETWORK_ERROR("tcp send failed, errno={}, error={}", errno,
+                               std::strerror(errno));
+    }
+    // skip what is written.
+    auto written = static_cast<size_t>(n);
+    while (iovcnt > 0 && written >= iov->iov_len) {
+      written -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+      iov->iov_len -= written;
+    }
+  }
+}
+
+}  // namespace
+
+ReceiverLoopTcp::~ReceiverLoopTcp() { Stop(); }
+
+void ReceiverLoopTcp::Stop() {
+  if (thread_.joinable()) {
+    const uint64_t one = 1;
+    static_cast<void>(write(stop_fd_, &one, sizeof(one)));
+    thread_.join();
+  }
+  for (int* fd : {&listen_fd_, &epoll_fd_, &stop_fd_}) {
+    if (*fd >= 0) {
+      close(*fd);
+      *fd = -1;
+    }
+  }
+}
+
+std::string ReceiverLoopTcp::Start(const std::string& host) {
+  if (thread_.joinable()) {
+    YASL_THROW_LOGIC_ERROR("tcp receiver loop is already running");
+  }
+
+  const auto info = Resolve(host, /*passive*/ true);
+  listen_fd_ = socket(info->ai_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  if (listen_fd_ < 0) {
+    YASL_THROW_IO_ERROR("create socket failed, errno={}", errno);
+  }
+  const int on = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  if (bind(listen_fd_, info->ai_addr, info->ai_addrlen) != 0 ||
+      listen(listen_fd_, SOMAXCONN) != 0) {
+    const int err = errno;
+    Stop();
+    YASL_THROW_IO_ERROR("listen on {} failed, errno={}, error={}", host, err,
+                        std::strerror(err));
+  }
+
+  epoll_fd_ = epoll_create1(0);
+  stop_fd_ = eventfd(0, EFD_NONBLOCK);
+  YASL_ENFORCE(epoll_fd_ >= 0 && stop_fd_ >= 0, "epoll setup failed, errno={}",
+               errno);
+  for (int fd : {listen_fd_, stop_fd_}) {
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    YASL_ENFORCE(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == 0,
+                 "epoll_ctl failed, errno={}", errno);
+  }
+
+  thread_ = std::thread([this] { Run(); });
+
+  // the actual listening addr:port.
+  sockaddr_storage addr;
+  socklen_t addr_len = sizeof(addr);
+  getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &addr_len);
+  char ip[INET6_ADDRSTRLEN] = {0};
+  uint16_t port = 0;
+  if (addr.ss_family == AF_INET6) {
+    const auto* addr6 = reinterpret_cast<const sockaddr_in6*>(&addr);
+    inet_ntop(AF_INET6, &addr6->sin6_addr, ip, sizeof(ip));
+    port = ntohs(addr6->sin6_port);
+  } else {
+    const auto* addr4 = reinterpret_cast<const sockaddr_in*>(&addr);
+    inet_ntop(AF_INET, &addr4->sin_addr, ip, sizeof(ip));
+    port = ntohs(addr4->sin_port);
+  }
+  return fmt::format("{}:{}", ip, port);
+}
+
+void ReceiverLoopTcp::Run() {
+  std::map<int, std::unique_ptr<Connection>> connections;
+  std::vector<epoll_event> events(64);
+  while (true) {
+    const int num_events =
+        epoll_wait(epoll_fd_, events.data(), events.size(), -1);
+    if (num_events < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      SPDLOG_ERROR("epoll_wait failed, errno={}", errno);
+      return;
+    }
+
+    for (int idx = 0; idx < num_events; idx++) {
+      const int fd = events[idx].data.fd;
+      if (fd == stop_fd_) {
+        return;
+      }
+
+      if (fd == listen_fd_) {
+        int conn_fd = -1;
+        while ((conn_fd = accept4(listen_fd_, nullptr, nullptr,
+                                  SOCK_NONBLOCK)) >= 0) {
+          epoll_event event;
+          event.events = EPOLLIN;
+          event.data.fd = conn_fd;
+          if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, conn_fd, &event) != 0) {
+            close(conn_fd);
+            continue;
+          }
+          connections.emplace(
+              conn_fd, std::make_unique<Connection>(conn_fd, max_frame_size_));
+        }
+        continue;
+      }
+
+      auto itr = connections.find(fd);
+      if (itr == connections.end()) {
+        continue;
+      }
+      bool alive = false;
+      try {
+        alive = itr->second->ReadAvailable(listeners_);
+      } catch (const std::exception& e) {
+        SPDLOG_ERROR("tcp connection broken, error={}", e.what());
+      }
+      if (!alive) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        connections.erase(itr);
+      }
+    }
+  }
+}
+
+ChannelTcp::ChannelTcp(size_t self_rank, size_t peer_rank,
+                       size_t recv_timeout_ms)
+    : ChannelBase(self_rank, peer_rank, recv_timeout_ms) {}
+
+ChannelTcp::~ChannelTcp() {
+  {
+    std::unique_lock lock(ack_mutex_);
+    ack_stop_ = true;
+  }
+  ack_cv_.notify_all();
+  if (ack_thread_.joinable()) {
+    ack_thread_.join();
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+void ChannelTcp::SetPeerHost(const std::string& peer_host) {
+  std::unique_lock lock(send_mutex_);
+  peer_host_ = peer_host;
+}
+
+void ChannelTcp::Connect() {
+  const auto info = Resolve(peer_host_, /*passive*/ false);
+  const int fd = socket(info->ai_family, SOCK_STREAM, 0);
+  if (fd < 0) {
+    YASL_THROW_NETWORK_ERROR("create socket failed, errno={}", errno);
+  }
+  if (connect(fd, info->ai_addr, info->ai_addrlen) != 0) {
+    const int err = errno;
+    close(fd);
+    YASL_THROW_NETWORK_ERROR("connect to {} failed, errno={}, error={}",
+                             peer_host_, err, std::strerror(err));
+  }
+
+  // msgs are small and latency matters, never wait for more to send.
+  const int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  // a peer which stops reading fails the send instead of hanging it.
+  timeval timeout{static_cast<time_t>(recv_timeout_ms_ / 1000),
+                  static_cast<suseconds_t>(recv_timeout_ms_ % 1000 * 1000)};
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  uint64_t rank = self_rank_;
+  iovec iov{&rank, sizeof(rank)};
+  try {
+    WriteFully(fd, &iov, 1);
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+  fd_ = fd;
+}
+
+void ChannelTcp::Write(const std::string& key, ByteChainView value) {
+  const bool is_ack = key == AckMsgKey();
+  if (!is_ack && key != AckRequestMsgKey()) {
+    WriteFrame(key, value);
+    return;
+  }
+
+  size_t fields[2] = {0, 0};
+  YASL_ENFORCE(value.size() <= sizeof(fields), "invalid ack size={}",
+               value.size());
+  value.CopyTo(fields);
+  {
+    std::unique_lock lock(ack_mutex_);
+    if (!is_ack) {
+      ack_request_ = std::max(ack_request_, fields[0]);
+    } else if (value.size() == 0) {
+      // an empty ack stands for a single msg.
+      ack_count_ += 1;
+    } else {
+      ack_count_ += fields[0];
+      ack_bytes_ += fields[1];
+    }
+    if (!ack_thread_.joinable()) {
+      ack_thread_ = std::thread([this] { AckLoop(); });
+    }
+  }
+  ack_cv_.notify_all();
+}
+
+void ChannelTcp::AckLoop() {
+  std::unique_lock lock(ack_mutex_);
+  while (true) {
+    ack_cv_.wait(lock, [&] {
+      return ack_stop_ || ack_count_ > 0 || ack_request_ > 0;
+    });
+    if (ack_count_ == 0 && ack_request_ == 0) {
+      return;
+    }
+    const size_t ack[2] = {ack_count_, ack_bytes_};
+    const size_t request = ack_request_;
+    ack_count_ = 0;
+    ack_bytes_ = 0;
+    ack_request_ = 0;
+    ack_writing_ = true;
+    lock.unlock();
+
+    try {
+      if (ack[0] > 0) {
+        WriteFrame(AckMsgKey(),
+                   ByteChainView{ByteContainerView{ack, sizeof(ack)}});
+      }
+      if (request > 0) {
+        WriteFrame(AckRequestMsgKey(),
+                   ByteChainView{ByteContainerView{&request, sizeof(request)}});
+      }
+    } catch (const std::exception& e) {
+      SPDLOG_ERROR("tcp ack send failed, error={}", e.what());
+    }
+
+    lock.lock();
+    ack_writing_ = false;
+    ack_cv_.notify_all();
+  }
+}
+
+void ChannelTcp::WaitAsyncSendToFinish() {
+  std::unique_lock lock(ack_mutex_);
+  ack_cv_.wait(lock, [&] {
+    return !ack_writing_ && ack_count_ == 0 && ack_request_ == 0;
+  });
+}
+
+void ChannelTcp::WriteFrame(const std::string& key, ByteChainView value) {
+  std::unique_lock lock(send_mutex_);
+  if (fd_ < 0) {
+    Connect();
+  }
+
+  FrameHeader header{key.size(), value.size()};
+  absl::InlinedVector<iovec, 8> iov = {
+      {&header, sizeof(header)},
+      {const_cast<char*>(key.data()), key.size()},
+  };
+  for (const auto& part : value.parts()) {
+    iov.push_back({const_cast<uint8_t*>(part.data()), part.size()});
+  }
+  try {
+    WriteFully(fd_, iov.data(), iov.size());
+  } catch (...) {
+    // the stream may be broken at any byte, never reuse it.
+    close(fd_);
+    fd_ = -1;
+    throw;
+  }
+}
+
+void ChannelTcp::SendAsyncImpl(const std::string& key,
+                               ByteContainerView value) {
+  Write(key, ByteChainView{value});
+}
+
+void ChannelTcp::SendAsyncImpl(const std::string& key, Buffer&& value) {
+  Write(key, ByteChainView{ByteContainerView(value)});
+}
+
+void ChannelTcp::SendAsyncImpl(const std::string& key, ByteChainView value) {
+  Write(key, value);
+}
+
+void ChannelTcp::SendImpl(const std::string& key, ByteContainerView value) {
+  Write(key, ByteChainView{value});
+}
+
+}  // namespace yasl::link
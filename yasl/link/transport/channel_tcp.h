@@ -0,0 +1,115 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "yasl/link/transport/channel.h"
+
+namespace yasl::link {
+
+// Receives msgs of all peers on one listening socket, by a single epoll
+// thread. Each peer connects once and tells its rank first, then streams
+// length prefixed msgs. A frame whose key and value are longer than
+// `max_frame_size` in total breaks its connection before anything is
+// allocated for it.
+class ReceiverLoopTcp final : public ReceiverLoopBase {
+ public:
+  static constexpr uint64_t kDefaultMaxFrameSize = uint64_t{1} << 31;
+
+  explicit ReceiverLoopTcp(uint64_t max_frame_size = kDefaultMaxFrameSize)
+      : max_frame_size_(max_frame_size) {}
+
+  ~ReceiverLoopTcp() override;
+
+  void Stop() override;
+
+  // start the receiver loop.
+  //
+  // host: the desired listen addr:port pair, port 0 picks a free one.
+  // returns: the actual listening addr:port pair.
+  std::string Start(const std::string& host);
+
+ private:
+  void Run();
+
+  const uint64_t max_frame_size_;
+
+  int listen_fd_ = -1;
+  int epoll_fd_ = -1;
+  // wakes up the loop thread to stop.
+  int stop_fd_ = -1;
+
+  std::thread thread_;
+};
+
+class ChannelTcp final : public ChannelBase {
+ private:
+  void SendAsyncImpl(const std::string& key, ByteContainerView value) override;
+  void SendAsyncImpl(const std::string& key, Buffer&& value) override;
+  // the parts are gathered by sendmsg.
+  void SendAsyncImpl(const std::string& key, ByteChainView value) override;
+
+  void SendImpl(const std::string& key, ByteContainerView value) override;
+
+ public:
+  ChannelTcp(size_t self_rank, size_t peer_rank, size_t recv_timeout_ms);
+
+  ~ChannelTcp() override;
+
+  // peer is connected on first send, raise NetworkError before peer starts
+  // listening, so that ConnectToMesh retries.
+  void SetPeerHost(const std::string& peer_host);
+
+  // msgs are written into the socket in place, only the queued acks may be
+  // left flying.
+  void WaitAsyncSendToFinish() override;
+
+ private:
+  void Connect();
+
+  // acks are queued for the ack thread, other msgs are written in place.
+  void Write(const std::string& key, ByteChainView value);
+
+  void WriteFrame(const std::string& key, ByteChainView value);
+
+  // acks are mostly sent by the receiver loop thread, which would stop
+  // reading all peers while blocked on a full socket, and peer may be
+  // blocked the same way on us. so they are merged and written by this
+  // thread instead, started on the first ack.
+  void AckLoop();
+
+  std::string peer_host_;
+
+  // protects the socket, msgs of concurrent senders must not interleave.
+  std::mutex send_mutex_;
+  int fd_ = -1;
+
+  std::mutex ack_mutex_;
+  std::condition_variable ack_cv_;
+  // acks not written yet, and the largest ack request.
+  size_t ack_count_ = 0;
+  size_t ack_bytes_ = 0;
+  size_t ack_request_ = 0;
+  bool ack_writing_ = false;
+  bool ack_stop_ = false;
+  std::thread ack_thread_;
+};
+
+}  // namespace yasl::link
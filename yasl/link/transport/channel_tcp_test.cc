@@ -0,0 +1,214 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/transport/channel_tcp.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <future>
+#include <string>
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+#include "yasl/base/byte_container_view.h"
+#include "yasl/base/exception.h"
+
+namespace yasl::link::test {
+
+static std::string RandStr(size_t length) {
+  std::string str(length, 0);
+  for (auto& c : str) {
+    c = static_cast<char>('a' + rand() % 26);
+  }
+  return str;
+}
+
+class ChannelTcpTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    sender_ = std::make_shared<ChannelTcp>(0, 1, 2000);
+    receiver_ = std::make_shared<ChannelTcp>(1, 0, 2000);
+
+    receiver_loop_ = std::make_unique<ReceiverLoopTcp>();
+    receiver_loop_->AddListener(0, receiver_);
+    sender_->SetPeerHost(receiver_loop_->Start("127.0.0.1:0"));
+
+    sender_loop_ = std::make_unique<ReceiverLoopTcp>();
+    sender_loop_->AddListener(1, sender_);
+    receiver_->SetPeerHost(sender_loop_->Start("127.0.0.1:0"));
+  }
+
+  void TearDown() override {
+    auto wait = [](std::shared_ptr<ChannelTcp>& l) {
+      if (l) {
+        l->WaitLinkTaskFinish();
+      }
+    };
+    auto f_s = std::async(wait, std::ref(sender_));
+    auto f_r = std::async(wait, std::ref(receiver_));
+    f_s.get();
+    f_r.get();
+  }
+
+  std::shared_ptr<ChannelTcp> sender_;
+  std::shared_ptr<ChannelTcp> receiver_;
+  std::unique_ptr<ReceiverLoopTcp> receiver_loop_;
+  std::unique_ptr<ReceiverLoopTcp> sender_loop_;
+};
+
+TEST_F(ChannelTcpTest, Normal_Empty) {
+  const std::string key = "key";
+  const std::string sent;
+  sender_->SendAsync(key, ByteContainerView{sent});
+  auto received = receiver_->Recv(key);
+
+  EXPECT_EQ(sent, std::string_view(received));
+}
+
+TEST_F(ChannelTcpTest, Timeout) {
+  receiver_->SetRecvTimeout(500U);
+  EXPECT_THROW(receiver_->Recv("key"), IoError);
+}
+
+TEST_F(ChannelTcpTest, SendAsync) {
+  for (size_t size : {1, 100, 10000, 100000, 10000000}) {
+    const auto key = fmt::format("key_{}", size);
+    const std::string sent = RandStr(size);
+    sender_->SendAsync(key, ByteContainerView{sent});
+    auto received = receiver_->Recv(key);
+
+    EXPECT_EQ(sent, std::string_view(received));
+  }
+}
+
+TEST_F(ChannelTcpTest, SendAsyncChain) {
+  const std::string head = RandStr(10);
+  const std::string body = RandStr(100000);
+  sender_->SendAsync("chain",
+                     ByteChainView{head, ByteContainerView(), body, head});
+  auto received = receiver_->Recv("chain");
+
+  EXPECT_EQ(head + body + head, std::string_view(received));
+}
+
+TEST_F(ChannelTcpTest, Send) {
+  const std::string sent = RandStr(10000);
+  sender_->Send("key", sent);
+  auto received = receiver_->Recv("key");
+
+  EXPECT_EQ(sent, std::string_view(received));
+}
+
+TEST_F(ChannelTcpTest, ConcurrentSenders) {
+  const size_t kNumSenders = 4;
+  const size_t kMsgPerSender = 50;
+
+  std::vector<std::future<void>> senders;
+  for (size_t s = 0; s < kNumSenders; s++) {
+    senders.push_back(std::async(std::launch::async, [&, s] {
+      for (size_t i = 0; i < kMsgPerSender; i++) {
+        const auto value = fmt::format("{}-{}", s, i);
+        sender_->SendAsync(fmt::format("{}:{}", s, i),
+                           Buffer(value.data(), value.size()));
+      }
+    }));
+  }
+  for (auto& sender : senders) {
+    sender.get();
+  }
+
+  for (size_t s = 0; s < kNumSenders; s++) {
+    for (size_t i = 0; i < kMsgPerSender; i++) {
+      auto received = receiver_->Recv(fmt::format("{}:{}", s, i));
+      EXPECT_EQ(std::string_view(received), fmt::format("{}-{}", s, i));
+    }
+  }
+}
+
+TEST_F(ChannelTcpTest, ThrottleWindow) {
+  sender_->SetThrottleWindowSize(2);
+  auto recv = std::async([&] {
+    for (size_t i = 0; i < 20; i++) {
+      EXPECT_EQ(std::string_view(receiver_->Recv(fmt::format("key_{}", i))),
+                fmt::format("value_{}", i));
+    }
+  });
+  for (size_t i = 0; i < 20; i++) {
+    sender_->SendAsync(fmt::format("key_{}", i),
+                       ByteContainerView(fmt::format("value_{}", i)));
+  }
+  recv.get();
+  sender_->SetThrottleWindowSize(0);
+}
+
+TEST_F(ChannelTcpTest, BothSidesFull) {
+  // both receiver loops ack the duplicated msgs while both sockets are full,
+  // which must not block them.
+  const std::string value = RandStr(64 * 1024);
+  auto send = [&](std::shared_ptr<ChannelTcp>& channel) {
+    for (size_t i = 0; i < 300; i++) {
+      channel->SendAsync("key", ByteContainerView{value});
+    }
+  };
+  auto f_s = std::async(std::launch::async, send, std::ref(sender_));
+  auto f_r = std::async(std::launch::async, send, std::ref(receiver_));
+  f_s.get();
+  f_r.get();
+
+  EXPECT_EQ(value, std::string_view(receiver_->Recv("key")));
+  EXPECT_EQ(value, std::string_view(sender_->Recv("key")));
+}
+
+TEST(ChannelTcpFrameTest, OversizedFrameShouldBreakConnection) {
+  auto channel = std::make_shared<ChannelTcp>(1, 0, 2000);
+  ReceiverLoopTcp loop(/*max_frame_size*/ 1024);
+  loop.AddListener(0, channel);
+  const auto host = loop.Start("127.0.0.1:0");
+  const int port = std::stoi(host.substr(host.rfind(':') + 1));
+
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(fd, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  // rank, then a header of key_length and value_length.
+  const uint64_t frame[3] = {0, 3, uint64_t{1} << 40};
+  ASSERT_EQ(write(fd, frame, sizeof(frame)), sizeof(frame));
+
+  // closed by the loop, nothing is allocated for the value.
+  char c;
+  EXPECT_EQ(read(fd, &c, 1), 0);
+  close(fd);
+}
+
+TEST(ChannelTcpNotReadyTest, SendBeforePeerStartsShouldThrowNetworkError) {
+  // grab a free port, and close it before sending.
+  std::string host;
+  {
+    ReceiverLoopTcp loop;
+    host = loop.Start("127.0.0.1:0");
+  }
+  auto channel = std::make_shared<ChannelTcp>(0, 1, 2000);
+  channel->SetPeerHost(host);
+
+  EXPECT_THROW(channel->Send("key", "value"), NetworkError);
+}
+
+}  // namespace yasl::link::test
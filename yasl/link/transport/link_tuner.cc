@@ -0,0 +1,145 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/transport/link_tuner.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "spdlog/spdlog.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl::link {
+
+namespace {
+
+size_t Clamp(double v, size_t lo, size_t hi) {
+  if (!(v > static_cast<double>(lo))) {
+    return lo;
+  }
+  if (v >= static_cast<double>(hi)) {
+    return hi;
+  }
+  return static_cast<size_t>(v);
+}
+
+// the largest power of 2 not above v, at least 1.
+size_t FloorPow2(size_t v) {
+  size_t p = 1;
+  while (p <= v / 2) {
+    p *= 2;
+  }
+  return p;
+}
+
+}  // namespace
+
+LinkTuner::LinkTuner(const LinkTunerOptions& options,
+                     const LinkParams& initial)
+    : options_(options) {
+  YASL_ENFORCE(options_.min_chunk_size > 0 &&
+                   options_.min_chunk_size <= options_.max_chunk_size,
+               "invalid chunk size bounds [{}, {}]", options_.min_chunk_size,
+               options_.max_chunk_size);
+  YASL_ENFORCE(options_.max_window > 0 && options_.max_connections > 0,
+               "max_window={}, max_connections={} should be positive",
+               options_.max_window, options_.max_connections);
+  params_.chunk_size = Clamp(initial.chunk_size, options_.min_chunk_size,
+                             options_.max_chunk_size);
+  params_.connections = Clamp(initial.connections, 1, options_.max_connections);
+  params_.window = Clamp(initial.window, params_.connections,
+                         std::max(params_.connections, options_.max_window));
+}
+
+LinkParams LinkTuner::Get() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return params_;
+}
+
+void LinkTuner::OnRequest(int64_t latency_us) {
+  if (latency_us <= 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  latencies_[num_latencies_++ % kLatencySamples] = latency_us;
+}
+
+void LinkTuner::OnTransfer(size_t bytes, int64_t elapsed_us) {
+  if (elapsed_us <= 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  rates_[num_rates_++ % kRateSamples] =
+      static_cast<double>(bytes) * 1e6 / static_cast<double>(elapsed_us);
+  Update();
+}
+
+int64_t LinkTuner::MinLatencyUs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const size_t n = std::min(num_latencies_, kLatencySamples);
+  return n == 0 ? 0 : *std::min_element(latencies_.begin(),
+                                        latencies_.begin() + n);
+}
+
+double LinkTuner::MaxBytesPerSecond() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const size_t n = std::min(num_rates_, kRateSamples);
+  return n == 0 ? 0 : *std::max_element(rates_.begin(), rates_.begin() + n);
+}
+
+void LinkTuner::Update() {
+  const size_t num_latencies = std::min(num_latencies_, kLatencySamples);
+  const size_t num_rates = std::min(num_rates_, kRateSamples);
+  if (num_latencies == 0 || num_rates == 0) {
+    return;
+  }
+  const int64_t latency_us = *std::min_element(
+      latencies_.begin(), latencies_.begin() + num_latencies);
+  const double rate =
+      *std::max_element(rates_.begin(), rates_.begin() + num_rates);
+  const double target = kInflightGain * rate * latency_us / 1e6;
+
+  LinkParams params;
+  params.connections =
+      Clamp(std::ceil(target / kBytesPerConnection), 1,
+            options_.max_connections);
+  params.chunk_size = Clamp(
+      FloorPow2(Clamp(target / (params.connections * kChunksPerConnection), 1,
+                      options_.max_chunk_size)),
+      options_.min_chunk_size, options_.max_chunk_size);
+  const size_t max_window =
+      std::max(params.connections, options_.max_window);
+  params.window = Clamp(std::ceil(target / params.chunk_size),
+                        params.connections, max_window);
+  if (params.window == max_window) {
+    // out of window, take larger chunks instead.
+    params.chunk_size =
+        Clamp(std::ceil(target / max_window), params.chunk_size,
+              options_.max_chunk_size);
+  }
+
+  if (params.chunk_size != params_.chunk_size ||
+      params.window != params_.window ||
+      params.connections != params_.connections) {
+    SPDLOG_DEBUG(
+        "link tuned, latency={}us, rate={}B/s, chunk_size={}, window={}, "
+        "connections={}",
+        latency_us, rate, params.chunk_size, params.window,
+        params.connections);
+  }
+  params_ = params;
+}
+
+}  // namespace yasl::link
@@ -0,0 +1,101 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace yasl::link {
+
+// how bulk msgs to a peer are cut and sent.
+struct LinkParams {
+  // bytes per chunk request.
+  size_t chunk_size = 0;
+  // max chunk requests in flight.
+  size_t window = 1;
+  // connections the chunks are striped across.
+  size_t connections = 1;
+};
+
+// bounds the tuned params are kept in.
+struct LinkTunerOptions {
+  size_t min_chunk_size = 256 * 1024;       // 256k bytes
+  size_t max_chunk_size = 8 * 1024 * 1024;  // 8M bytes
+  size_t max_window = 64;
+  size_t max_connections = 8;
+};
+
+// LinkTuner adapts LinkParams to the link to a peer, from the latency of the
+// requests and the throughput of the bulk msgs sent so far.
+//
+// A link carries at most `chunk_size * window` bytes per round trip, so the
+// bytes in flight must cover the bandwidth-delay product (bdp) for bulk msgs
+// to run at link speed. The tuner estimates bdp as the max recent throughput
+// times the min recent latency, and keeps twice that in flight. While the
+// window is the bottleneck the measured throughput, hence the target, grows
+// with each msg, so the params ramp up like a slow start. Once the link is
+// the bottleneck they settle, and they shrink again if the link gets slower,
+// so that LAN peers keep small chunks.
+//
+// The target is split as: one connection per `kBytesPerConnection` in
+// flight, since a single tcp connection rarely carries more than its socket
+// buffer per round trip; then `kChunksPerConnection` chunks per connection,
+// so that each one is pipelined; then as many chunks as needed.
+//
+// Thread safe.
+class LinkTuner {
+ public:
+  static constexpr double kInflightGain = 2.0;
+  static constexpr size_t kBytesPerConnection = 4 * 1024 * 1024;
+  static constexpr size_t kChunksPerConnection = 4;
+
+  // `initial` is used until the first bulk msg is measured, it is clamped
+  // into the bounds.
+  LinkTuner(const LinkTunerOptions& options, const LinkParams& initial);
+
+  // the params for the next bulk msg.
+  LinkParams Get() const;
+
+  // a request, of a chunk or a whole msg, was acked after `latency_us`.
+  void OnRequest(int64_t latency_us);
+
+  // a bulk msg of `bytes` was sent in `elapsed_us`.
+  void OnTransfer(size_t bytes, int64_t elapsed_us);
+
+  // current estimates, 0 before the first sample.
+  int64_t MinLatencyUs() const;
+  double MaxBytesPerSecond() const;
+
+ private:
+  // min/max over the last N samples.
+  static constexpr size_t kLatencySamples = 256;
+  static constexpr size_t kRateSamples = 8;
+
+  // should be called with mutex_ held.
+  void Update();
+
+  const LinkTunerOptions options_;
+
+  mutable std::mutex mutex_;
+  LinkParams params_;
+  std::array<int64_t, kLatencySamples> latencies_{};
+  size_t num_latencies_ = 0;
+  std::array<double, kRateSamples> rates_{};
+  size_t num_rates_ = 0;
+};
+
+}  // namespace yasl::link
@@ -0,0 +1,155 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/link/transport/link_tuner.h"
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+namespace yasl::link {
+
+namespace {
+
+// a link of `rtt_us` and `bytes_per_second`, each connection carries at most
+// `connection_bytes` per round trip.
+struct FakeLink {
+  int64_t rtt_us;
+  double bytes_per_second;
+  size_t connection_bytes = 4 * 1024 * 1024;
+
+  double Rate(const LinkParams& params) const {
+    const double inflight =
+        std::min(params.chunk_size * params.window,
+                 params.connections * connection_bytes);
+    return std::min(bytes_per_second, inflight * 1e6 / rtt_us);
+  }
+
+  // sends a bulk msg of `bytes` with the tuned params, returns its rate.
+  double Send(LinkTuner* tuner, size_t bytes) const {
+    const auto params = tuner->Get();
+    const double rate = Rate(params);
+    const size_t num_chunks =
+        (bytes + params.chunk_size - 1) / params.chunk_size;
+    for (size_t i = 0; i < num_chunks; ++i) {
+      // the first chunk goes alone, the others queue behind the window.
+      const double queued = i == 0 ? 1 : std::min(i + 1, params.window);
+      tuner->OnRequest(rtt_us + static_cast<int64_t>(
+                                    queued * params.chunk_size * 1e6 /
+                                    bytes_per_second));
+    }
+    const auto elapsed_us = rtt_us + static_cast<int64_t>(bytes * 1e6 / rate);
+    tuner->OnTransfer(bytes, elapsed_us);
+    return bytes * 1e6 / elapsed_us;
+  }
+};
+
+LinkParams StaticParams() {
+  LinkParams params;
+  params.chunk_size = 512 * 1024;
+  params.window = 10;
+  params.connections = 1;
+  return params;
+}
+
+}  // namespace
+
+TEST(LinkTunerTest, InitialParamsAreClamped) {
+  LinkTunerOptions options;
+  options.max_window = 4;
+  LinkParams initial;
+  initial.chunk_size = 1024;
+  initial.window = 100;
+  initial.connections = 100;
+  LinkTuner tuner(options, initial);
+
+  const auto params = tuner.Get();
+  EXPECT_EQ(params.chunk_size, options.min_chunk_size);
+  EXPECT_EQ(params.connections, options.max_connections);
+  // at least one chunk per connection.
+  EXPECT_EQ(params.window, options.max_connections);
+  EXPECT_EQ(tuner.MinLatencyUs(), 0);
+  EXPECT_EQ(tuner.MaxBytesPerSecond(), 0);
+
+  options.min_chunk_size = 0;
+  EXPECT_ANY_THROW(LinkTuner(options, initial));
+}
+
+TEST(LinkTunerTest, LanKeepsSmallChunks) {
+  const FakeLink lan{100, 1.25e9};
+  LinkTuner tuner(LinkTunerOptions{}, StaticParams());
+  for (int i = 0; i < 10; ++i) {
+    lan.Send(&tuner, 64 * 1024 * 1024);
+  }
+
+  const auto params = tuner.Get();
+  EXPECT_EQ(params.chunk_size, LinkTunerOptions{}.min_chunk_size);
+  EXPECT_LE(params.window, 4);
+  EXPECT_EQ(params.connections, 1);
+  EXPECT_GT(lan.Rate(params), 0.99 * lan.bytes_per_second);
+}
+
+TEST(LinkTunerTest, WanRampsUp) {
+  const FakeLink wan{100 * 1000, 125e6};
+  LinkTuner tuner(LinkTunerOptions{}, StaticParams());
+  // static params are stuck at a single connection.
+  EXPECT_LT(wan.Rate(tuner.Get()), 0.4 * wan.bytes_per_second);
+
+  for (int i = 0; i < 10; ++i) {
+    wan.Send(&tuner, 256 * 1024 * 1024);
+  }
+  const auto params = tuner.Get();
+  EXPECT_GT(params.connections, 1);
+  EXPECT_GT(params.chunk_size * params.window, 12.5e6);
+  EXPECT_GT(wan.Rate(params), 0.99 * wan.bytes_per_second);
+  EXPECT_GT(wan.Send(&tuner, 256 * 1024 * 1024),
+            0.9 * wan.bytes_per_second);
+}
+
+TEST(LinkTunerTest, StaysInBounds) {
+  const FakeLink wan{200 * 1000, 1.25e9};
+  LinkTunerOptions options;
+  options.max_window = 4;
+  options.max_connections = 2;
+  options.max_chunk_size = 2 * 1024 * 1024;
+  LinkTuner tuner(options, StaticParams());
+  for (int i = 0; i < 10; ++i) {
+    wan.Send(&tuner, 256 * 1024 * 1024);
+  }
+
+  const auto params = tuner.Get();
+  EXPECT_EQ(params.chunk_size, options.max_chunk_size);
+  EXPECT_EQ(params.window, options.max_window);
+  EXPECT_EQ(params.connections, options.max_connections);
+}
+
+TEST(LinkTunerTest, ShrinksOnFasterLink) {
+  const FakeLink wan{100 * 1000, 125e6};
+  const FakeLink lan{100, 1.25e9};
+  LinkTuner tuner(LinkTunerOptions{}, StaticParams());
+  for (int i = 0; i < 10; ++i) {
+    wan.Send(&tuner, 256 * 1024 * 1024);
+  }
+  ASSERT_GT(tuner.Get().connections, 1);
+
+  for (int i = 0; i < 3; ++i) {
+    lan.Send(&tuner, 64 * 1024 * 1024);
+  }
+  const auto params = tuner.Get();
+  EXPECT_EQ(params.chunk_size, LinkTunerOptions{}.min_chunk_size);
+  EXPECT_EQ(params.connections, 1);
+  EXPECT_LT(tuner.MinLatencyUs(), 10 * 1000);
+}
+
+}  // namespace yasl::link
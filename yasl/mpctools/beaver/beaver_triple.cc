@@ -0,0 +1,388 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/beaver/beaver_triple.h"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <type_traits>
+#include <utility>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/exception.h"
+#include "yasl/crypto/hash_util.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/link/prg_expandable.h"
+#include "yasl/utils/parallel.h"
+
+namespace yasl {
+
+namespace {
+
+constexpr size_t kBlockBits = 128;
+// triples of a task of the local work.
+constexpr int64_t kGrainSize = 1024;
+
+// base ot keys of a round, as the ones of a CorrelatedOtPool refill.
+uint128_t Rekey(uint128_t key, uint64_t epoch) {
+  std::array<uint8_t, sizeof(key) + sizeof(epoch)> buf;
+  std::memcpy(buf.data(), &key, sizeof(key));
+  std::memcpy(buf.data() + sizeof(key), &epoch, sizeof(epoch));
+  const auto digest = crypto::Sha256Fixed(buf);
+  uint128_t ret;
+  std::memcpy(&ret, digest.data(), sizeof(ret));
+  return ret;
+}
+
+// offsets of the corrections of a multiplication triple, the one of ot l
+// takes the bytes [offsets[l], offsets[l + 1]), enough for its low k - l
+// bits. the last offset is the bytes of a triple.
+template <typename T>
+std::array<size_t, sizeof(T) * 8 + 1> CorrectionOffsets() {
+  constexpr size_t kBits = sizeof(T) * 8;
+  std::array<size_t, kBits + 1> offsets{};
+  for (size_t l = 0; l < kBits; ++l) {
+    offsets[l + 1] = offsets[l] + (kBits - l + 7) / 8;
+  }
+  return offsets;
+}
+
+// the sender half of Gilboa's product of a_peer * b over the k ots `rots`,
+// writes the corrections of peer to `out` and returns the share of the
+// sender, -sum(m0 << l).
+template <typename T>
+T SendProduct(const std::array<uint128_t, 2>* rots, T b,
+              const std::array<size_t, sizeof(T) * 8 + 1>& offsets,
+              uint8_t* out) {
+  constexpr size_t kBits = sizeof(T) * 8;
+  T share = 0;
+  for (size_t l = 0; l < kBits; ++l) {
+    const auto m0 = static_cast<T>(rots[l][0]);
+    const T d = m0 - static_cast<T>(rots[l][1]) + b;
+    std::memcpy(out + offsets[l], &d, offsets[l + 1] - offsets[l]);
+    share -= m0 << l;
+  }
+  return share;
+}
+
+// the receiver half, m_a + a * d = m0 + a * b_peer for each bit l of a, and
+// returns the share of the receiver, the sum of them shifted by l.
+template <typename T>
+T RecvProduct(const uint128_t* rots, T a,
+              const std::array<size_t, sizeof(T) * 8 + 1>& offsets,
+              const uint8_t* in) {
+  constexpr size_t kBits = sizeof(T) * 8;
+  T share = 0;
+  for (size_t l = 0; l < kBits; ++l) {
+    T d = 0;
+    std::memcpy(&d, in + offsets[l], offsets[l + 1] - offsets[l]);
+    const T mask = T(0) - ((a >> l) & 1);
+    share += (static_cast<T>(rots[l]) + (d & mask)) << l;
+  }
+  return share;
+}
+
+// the shares of a dealt party expanded from its seed, c too if `with_c`.
+// and triples keep the bits from `size` on zero, as generated ones.
+void ExpandAndTriples(uint128_t seed, bool with_c, AndTriples* triples) {
+  const size_t num_blocks = (triples->size + kBlockBits - 1) / kBlockBits;
+  PseudoRandomGenerator<uint128_t> prg(seed);
+  for (auto* share : {&triples->a, &triples->b, &triples->c}) {
+    share->resize(num_blocks);
+    if (share != &triples->c || with_c) {
+      prg.Fill(absl::MakeSpan(*share));
+    }
+    if (triples->size % kBlockBits != 0) {
+      share->back() &= (uint128_t(1) << (triples->size % kBlockBits)) - 1;
+    }
+  }
+}
+
+template <typename T>
+void ExpandMulTriples(uint128_t seed, size_t n, bool with_c,
+                      MulTriples<T>* triples) {
+  PseudoRandomGenerator<uint128_t> prg(seed);
+  for (auto* share : {&triples->a, &triples->b, &triples->c}) {
+    share->resize(n);
+    if (share != &triples->c || with_c) {
+      prg.Fill(absl::MakeSpan(*share));
+    }
+  }
+}
+
+template <typename T>
+ByteContainerView AsBytes(const std::vector<T>& v) {
+  return ByteContainerView(v.data(), v.size() * sizeof(T));
+}
+
+}  // namespace
+
+BeaverTripleGenerator::BeaverTripleGenerator(
+    std::shared_ptr<link::Context> ctx, BaseRecvOptions send_base,
+    BaseSendOptions recv_base, const BeaverTripleOptions& options)
+    : ctx_(std::move(ctx)),
+      options_(options),
+      send_base_(std::move(send_base)),
+      recv_base_(std::move(recv_base)) {
+  YASL_ENFORCE(ctx_->WorldSize() == 2);
+  YASL_ENFORCE(options_.batch_size > 0);
+  // both parties spawn in the same order, so that sessions pair up.
+  for (auto& session : sessions_) {
+    session = ctx_->Spawn();
+  }
+}
+
+BeaverTripleGenerator::BeaverTripleGenerator(
+    std::shared_ptr<link::Context> ctx,
+    std::shared_ptr<CorrelatedOtPool> send_pool,
+    std::shared_ptr<CorrelatedOtPool> recv_pool,
+    const BeaverTripleOptions& options)
+    : ctx_(std::move(ctx)),
+      options_(options),
+      send_pool_(std::move(send_pool)),
+      recv_pool_(std::move(recv_pool)) {
+  YASL_ENFORCE(ctx_->WorldSize() == 2);
+  YASL_ENFORCE(options_.batch_size > 0);
+  YASL_ENFORCE(send_pool_ != nullptr && send_pool_->IsSender(),
+               "send_pool must be a sender pool");
+  YASL_ENFORCE(recv_pool_ != nullptr && !recv_pool_->IsSender(),
+               "recv_pool must be a receiver pool");
+}
+
+BeaverTripleGenerator::Rots BeaverTripleGenerator::GenRots(size_t n) {
+  Rots rots;
+  if (send_pool_ != nullptr) {
+    rots.send = send_pool_->TakeRot(n);
+    rots.recv = recv_pool_->TakeRot(n, &rots.choices);
+    return rots;
+  }
+
+  BaseRecvOptions send_base = send_base_;
+  for (auto& block : send_base.blocks) {
+    block = Rekey(block, epoch_);
+  }
+  BaseSendOptions recv_base = recv_base_;
+  for (auto& blocks : recv_base.blocks) {
+    blocks = {Rekey(blocks[0], epoch_), Rekey(blocks[1], epoch_)};
+  }
+  epoch_++;
+
+  rots.send.resize(n);
+  rots.recv.resize(n);
+  rots.choices = CreateRandomChoiceBits<uint128_t>(n);
+  const size_t rank = ctx_->Rank();
+  auto sending = std::async(std::launch::async, [&] {
+    IknpRotSend(sessions_[rank], send_base, absl::MakeSpan(rots.send),
+                options_.batches_per_msg);
+  });
+  IknpRotRecv(sessions_[1 - rank], recv_base, rots.choices,
+              absl::MakeSpan(rots.recv), options_.batches_per_msg);
+  sending.get();
+  return rots;
+}
+
+AndTriples BeaverTripleGenerator::GenAndTriples(size_t n) {
+  AndTriples triples;
+  triples.size = n;
+  const size_t num_blocks = (n + kBlockBits - 1) / kBlockBits;
+  triples.a.resize(num_blocks);
+  triples.b.resize(num_blocks);
+  triples.c.resize(num_blocks);
+
+  // rounds start on a block.
+  const size_t batch_size =
+      (options_.batch_size + kBlockBits - 1) / kBlockBits * kBlockBits;
+  for (size_t begin = 0; begin < n; begin += batch_size) {
+    const size_t round = std::min(batch_size, n - begin);
+    const auto rots = GenRots(round);
+    const size_t first = begin / kBlockBits;
+    const auto round_blocks =
+        static_cast<int64_t>((round + kBlockBits - 1) / kBlockBits);
+    parallel_for(0, round_blocks, kGrainSize / kBlockBits,
+                 [&](int64_t wbegin, int64_t wend) {
+                   for (int64_t w = wbegin; w < wend; ++w) {
+                     const size_t offset = w * kBlockBits;
+                     const size_t limit =
+                         std::min(kBlockBits, round - offset);
+                     // a & b_peer = u ^ v_peer, a_peer & b = u_peer ^ v.
+                     uint128_t b = 0;
+                     uint128_t u = 0;
+                     uint128_t v = 0;
+                     for (size_t i = 0; i < limit; ++i) {
+                       const auto& m = rots.send[offset + i];
+                       b |= ((m[0] ^ m[1]) & 1) << i;
+                       v |= (m[0] & 1) << i;
+                       u |= (rots.recv[offset + i] & 1) << i;
+                     }
+                     const uint128_t mask =
+                         limit == kBlockBits
+                             ? ~uint128_t(0)
+                             : (uint128_t(1) << limit) - 1;
+                     const uint128_t a = rots.choices[w] & mask;
+                     triples.a[first + w] = a;
+                     triples.b[first + w] = b;
+                     triples.c[first + w] = (a & b) ^ u ^ v;
+                   }
+                 });
+  }
+  return triples;
+}
+
+template <typename T>
+MulTriples<T> BeaverTripleGenerator::GenMulTriples(size_t n) {
+  static_assert(std::is_same_v<T, uint64_t> || std::is_same_v<T, uint128_t>,
+                "T must be uint64_t or uint128_t");
+  constexpr size_t kBits = sizeof(T) * 8;
+  static const auto offsets = CorrectionOffsets<T>();
+  const size_t triple_bytes = offsets[kBits];
+
+  MulTriples<T> triples;
+  triples.a.resize(n);
+  triples.b.resize(n);
+  triples.c.resize(n);
+  FillRandomBits(absl::MakeSpan(triples.b));
+
+  const size_t batch_size = std::max<size_t>(options_.batch_size / kBits, 1);
+  for (size_t begin = 0; begin < n; begin += batch_size) {
+    const size_t round = std::min(batch_size, n - begin);
+    const auto rots = GenRots(round * kBits);
+    // a of a triple is the choices of its ots.
+    std::memcpy(&triples.a[begin], rots.choices.data(), round * sizeof(T));
+
+    Buffer corrections(static_cast<int64_t>(round * triple_bytes));
+    auto* out = corrections.data<uint8_t>();
+    parallel_for(0, round, kGrainSize / kBits,
+                 [&](int64_t tbegin, int64_t tend) {
+                   for (int64_t t = tbegin; t < tend; ++t) {
+                     triples.c[begin + t] = SendProduct<T>(
+                         &rots.send[t * kBits], triples.b[begin + t],
+                         offsets, out + t * triple_bytes);
+                   }
+                 });
+    ctx_->SendAsync(ctx_->NextRank(), std::move(corrections),
+                    "BEAVER:CORRECTIONS");
+
+    auto buf = ctx_->Recv(ctx_->NextRank(), "BEAVER:CORRECTIONS");
+    YASL_ENFORCE(static_cast<size_t>(buf.size()) == round * triple_bytes,
+                 "unexpected corrections size={}, num_triples={}",
+                 buf.size(), round);
+    const auto* in = buf.data<uint8_t>();
+    parallel_for(0, round, kGrainSize / kBits,
+                 [&](int64_t tbegin, int64_t tend) {
+                   for (int64_t t = tbegin; t < tend; ++t) {
+                     const T a = triples.a[begin + t];
+                     triples.c[begin + t] +=
+                         a * triples.b[begin + t] +
+                         RecvProduct<T>(&rots.recv[t * kBits], a, offsets,
+                                        in + t * triple_bytes);
+                   }
+                 });
+  }
+  return triples;
+}
+
+template MulTriples<uint64_t> BeaverTripleGenerator::GenMulTriples(size_t n);
+template MulTriples<uint128_t> BeaverTripleGenerator::GenMulTriples(size_t n);
+
+void DealAndTriples(const std::shared_ptr<link::Context>& ctx, size_t n,
+                    size_t party0, size_t party1) {
+  const uint128_t seed0 = RandSeed();
+  const uint128_t seed1 = RandSeed();
+  AndTriples t0;
+  AndTriples t1;
+  t0.size = t1.size = n;
+  ExpandAndTriples(seed0, true, &t0);
+  ExpandAndTriples(seed1, false, &t1);
+  parallel_for(0, t1.c.size(), kGrainSize / kBlockBits,
+               [&](int64_t begin, int64_t end) {
+                 for (int64_t w = begin; w < end; ++w) {
+                   t1.c[w] = ((t0.a[w] ^ t1.a[w]) & (t0.b[w] ^ t1.b[w])) ^
+                             t0.c[w];
+                 }
+               });
+  link::SendPrgSeed(ctx, party0, seed0, {}, "BEAVER:DEAL_AND");
+  link::SendPrgSeed(ctx, party1, seed1, AsBytes(t1.c), "BEAVER:DEAL_AND");
+}
+
+template <typename T>
+void DealMulTriples(const std::shared_ptr<link::Context>& ctx, size_t n,
+                    size_t party0, size_t party1) {
+  static_assert(std::is_same_v<T, uint64_t> || std::is_same_v<T, uint128_t>,
+                "T must be uint64_t or uint128_t");
+  const uint128_t seed0 = RandSeed();
+  const uint128_t seed1 = RandSeed();
+  MulTriples<T> t0;
+  MulTriples<T> t1;
+  ExpandMulTriples(seed0, n, true, &t0);
+  ExpandMulTriples(seed1, n, false, &t1);
+  parallel_for(0, n, kGrainSize, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      t1.c[i] = (t0.a[i] + t1.a[i]) * (t0.b[i] + t1.b[i]) - t0.c[i];
+    }
+  });
+  link::SendPrgSeed(ctx, party0, seed0, {}, "BEAVER:DEAL_MUL");
+  link::SendPrgSeed(ctx, party1, seed1, AsBytes(t1.c), "BEAVER:DEAL_MUL");
+}
+
+AndTriples RecvAndTriples(const std::shared_ptr<link::Context>& ctx, size_t n,
+                          size_t dealer) {
+  const auto [seed, correction] =
+      link::RecvPrgSeed(ctx, dealer, "BEAVER:DEAL_AND");
+  AndTriples triples;
+  triples.size = n;
+  const bool with_c = correction.size() == 0;
+  ExpandAndTriples(seed, with_c, &triples);
+  if (!with_c) {
+    YASL_ENFORCE(static_cast<size_t>(correction.size()) ==
+                     triples.c.size() * sizeof(uint128_t),
+                 "dealt {} bytes for {} and triples", correction.size(), n);
+    std::memcpy(triples.c.data(), correction.data(), correction.size());
+  }
+  return triples;
+}
+
+template <typename T>
+MulTriples<T> RecvMulTriples(const std::shared_ptr<link::Context>& ctx,
+                             size_t n, size_t dealer) {
+  static_assert(std::is_same_v<T, uint64_t> || std::is_same_v<T, uint128_t>,
+                "T must be uint64_t or uint128_t");
+  const auto [seed, correction] =
+      link::RecvPrgSeed(ctx, dealer, "BEAVER:DEAL_MUL");
+  MulTriples<T> triples;
+  const bool with_c = correction.size() == 0;
+  ExpandMulTriples(seed, n, with_c, &triples);
+  if (!with_c) {
+    YASL_ENFORCE(static_cast<size_t>(correction.size()) == n * sizeof(T),
+                 "dealt {} bytes for {} multiplication triples",
+                 correction.size(), n);
+    std::memcpy(triples.c.data(), correction.data(), correction.size());
+  }
+  return triples;
+}
+
+template void DealMulTriples<uint64_t>(
+    const std::shared_ptr<link::Context>& ctx, size_t n, size_t party0,
+    size_t party1);
+template void DealMulTriples<uint128_t>(
+    const std::shared_ptr<link::Context>& ctx, size_t n, size_t party0,
+    size_t party1);
+template MulTriples<uint64_t> RecvMulTriples(
+    const std::shared_ptr<link::Context>& ctx, size_t n, size_t dealer);
+template MulTriples<uint128_t> RecvMulTriples(
+    const std::shared_ptr<link::Context>& ctx, size_t n, size_t dealer);
+
+}  // namespace yasl
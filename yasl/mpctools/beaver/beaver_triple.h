@@ -0,0 +1,147 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "yasl/base/int128.h"
+#include "yasl/link/link.h"
+#include "yasl/mpctools/ot/correlated_ot_pool.h"
+#include "yasl/mpctools/ot/iknp_ot_extension.h"
+#include "yasl/mpctools/ot/options.h"
+
+namespace yasl {
+
+// AND triples of `size` bits, bit i in a[i / 128], so that
+// (a0 ^ a1) & (b0 ^ b1) == c0 ^ c1 over the shares of both parties.
+struct AndTriples {
+  size_t size = 0;
+  std::vector<uint128_t> a;
+  std::vector<uint128_t> b;
+  std::vector<uint128_t> c;
+};
+
+// multiplication triples over Z_2^k, k the bits of T, so that
+// (a0 + a1) * (b0 + b1) == c0 + c1 mod 2^k.
+template <typename T>
+struct MulTriples {
+  std::vector<T> a;
+  std::vector<T> b;
+  std::vector<T> c;
+};
+
+struct BeaverTripleOptions {
+  // ots per direction of a round, bounds the memory of a generation.
+  size_t batch_size = size_t(1) << 20;
+  // see IknpRotSend, ignored by pools.
+  size_t batches_per_msg = kIknpBatchesPerMsg;
+};
+
+// BeaverTripleGenerator generates the triples of two parties on random OTs,
+// each party is the OT sender of one direction and the receiver of the
+// other one. AND triples are as in https://eprint.iacr.org/2013/552.pdf,
+// multiplication triples by Gilboa's product as in MASCOT,
+// https://eprint.iacr.org/2016/505.pdf, without its sacrifice.
+//
+//  * an AND triple takes one random ot per direction, a is the choice bit
+//    and b the lsb of m0 ^ m1, so that a_i & b_j is shared by the lsbs of m0
+//    and m_a.
+//  * a multiplication triple takes k random ots per direction, the Gilboa
+//    product of the bits of a_i by b_j. The sender corrects ot l to
+//    m0 - m1 + b_j, of which only the low k - l bits are sent, rounded up to
+//    bytes, as the rest is shifted out of the product.
+//
+// Ots are either extended by IKNP on demand, both directions at once, or
+// taken from correlated ot pools which extend them in the background, so
+// that generating triples is off the critical path of the online phase.
+// Generations are split into rounds of `batch_size` ots per direction,
+// local work of a round runs across parallel_for.
+//
+// NOTE both parties must call the same generations in the same order.
+class BeaverTripleGenerator {
+ public:
+  // extends ots by IKNP. `send_base` are the base ots of this party as the
+  // sender of IKNP, of which peer holds the `recv_base`, and vice versa.
+  // base ots are re-keyed each round, so that IKNP prgs never repeat.
+  BeaverTripleGenerator(std::shared_ptr<link::Context> ctx,
+                        BaseRecvOptions send_base, BaseSendOptions recv_base,
+                        const BeaverTripleOptions& options = {});
+
+  // takes ots from pools, `send_pool` is a sender one, paired with a
+  // receiver one of peer, and vice versa.
+  BeaverTripleGenerator(std::shared_ptr<link::Context> ctx,
+                        std::shared_ptr<CorrelatedOtPool> send_pool,
+                        std::shared_ptr<CorrelatedOtPool> recv_pool,
+                        const BeaverTripleOptions& options = {});
+
+  AndTriples GenAndTriples(size_t n);
+
+  // T is uint64_t or uint128_t.
+  template <typename T>
+  MulTriples<T> GenMulTriples(size_t n);
+
+ private:
+  // random ots of a round, this party being the sender of `send` and the
+  // receiver of `recv` by `choices`, bit i in choices[i / 128].
+  struct Rots {
+    std::vector<std::array<uint128_t, 2>> send;
+    std::vector<uint128_t> recv;
+    std::vector<uint128_t> choices;
+  };
+
+  Rots GenRots(size_t n);
+
+  const std::shared_ptr<link::Context> ctx_;
+  const BeaverTripleOptions options_;
+
+  // of IKNP, sessions[r] carries the ots of which party r is the sender.
+  BaseRecvOptions send_base_;
+  BaseSendOptions recv_base_;
+  std::array<std::shared_ptr<link::Context>, 2> sessions_;
+  uint64_t epoch_ = 0;
+
+  std::shared_ptr<CorrelatedOtPool> send_pool_;
+  std::shared_ptr<CorrelatedOtPool> recv_pool_;
+};
+
+// Triples dealt by a trusted third party, e.g. a dealer rank of a 3 party
+// link. The dealer draws the shares of `party0` and the a, b shares of
+// `party1` from prg seeds, which are all it sends of them, and sends the c
+// share of party1 in full as the correction, see link::SendPrgSeed. So
+// dealing n triples costs a seed to party0 and a third of the triples to
+// party1, instead of all of them to both.
+//
+// NOTE the dealer and both parties must call the same dealings in the same
+// order.
+void DealAndTriples(const std::shared_ptr<link::Context>& ctx, size_t n,
+                    size_t party0, size_t party1);
+
+// T is uint64_t or uint128_t.
+template <typename T>
+void DealMulTriples(const std::shared_ptr<link::Context>& ctx, size_t n,
+                    size_t party0, size_t party1);
+
+// The triples of a party, dealt by `dealer`.
+AndTriples RecvAndTriples(const std::shared_ptr<link::Context>& ctx, size_t n,
+                          size_t dealer);
+
+template <typename T>
+MulTriples<T> RecvMulTriples(const std::shared_ptr<link::Context>& ctx,
+                             size_t n, size_t dealer);
+
+}  // namespace yasl
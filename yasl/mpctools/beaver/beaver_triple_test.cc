@@ -0,0 +1,221 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/beaver/beaver_triple.h"
+
+#include <future>
+#include <random>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/link/test_util.h"
+
+namespace yasl {
+namespace {
+
+std::pair<BaseSendOptions, BaseRecvOptions> MakeBaseOptions(size_t num) {
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  recv_opts.choices = CreateRandomChoices(num);
+  std::random_device rd;
+  PseudoRandomGenerator<uint128_t> gen(rd());
+  for (size_t i = 0; i < num; ++i) {
+    send_opts.blocks.push_back({gen(), gen()});
+    recv_opts.blocks.push_back(send_opts.blocks[i][recv_opts.choices[i]]);
+  }
+  return {std::move(send_opts), std::move(recv_opts)};
+}
+
+// the generators of both parties, on IKNP or on pools.
+class BeaverTripleTest : public ::testing::TestWithParam<bool> {
+ protected:
+  void SetUp() override {
+    contexts_ = link::test::SetupWorld(2);
+    // rank 0 is the IKNP sender of the first base ots, rank 1 of the second.
+    auto [send0, recv0] = MakeBaseOptions(128);
+    auto [send1, recv1] = MakeBaseOptions(128);
+    // several rounds of each generation.
+    BeaverTripleOptions options;
+    options.batch_size = 1000;
+
+    if (!GetParam()) {
+      generators_[0] = std::make_unique<BeaverTripleGenerator>(
+          contexts_[0], recv0, send1, options);
+      generators_[1] = std::make_unique<BeaverTripleGenerator>(
+          contexts_[1], recv1, send0, options);
+      return;
+    }
+
+    CorrelatedOtPool::Options pool_options;
+    pool_options.depth = 4096;
+    pool_options.batch_size = 4096;
+    // pools of both parties are created in the same order of pairs, so that
+    // their refill sessions pair up.
+    auto f = std::async([&] {
+      auto send_pool =
+          std::make_shared<CorrelatedOtPool>(contexts_[0], recv0, pool_options);
+      auto recv_pool =
+          std::make_shared<CorrelatedOtPool>(contexts_[0], send1, pool_options);
+      return std::make_unique<BeaverTripleGenerator>(contexts_[0], send_pool,
+                                                     recv_pool, options);
+    });
+    auto recv_pool =
+        std::make_shared<CorrelatedOtPool>(contexts_[1], send0, pool_options);
+    auto send_pool =
+        std::make_shared<CorrelatedOtPool>(contexts_[1], recv1, pool_options);
+    generators_[1] = std::make_unique<BeaverTripleGenerator>(
+        contexts_[1], send_pool, recv_pool, options);
+    generators_[0] = f.get();
+  }
+
+  void TearDown() override {
+    // pools wait for their peers on destruction.
+    auto f = std::async([&] { generators_[0].reset(); });
+    generators_[1].reset();
+    f.get();
+  }
+
+  // runs `gen` on the generators of both parties.
+  template <typename F>
+  auto Run(const F& gen) {
+    auto f = std::async([&] { return gen(generators_[0].get()); });
+    auto r1 = gen(generators_[1].get());
+    return std::make_pair(f.get(), std::move(r1));
+  }
+
+  std::vector<std::shared_ptr<link::Context>> contexts_;
+  std::array<std::unique_ptr<BeaverTripleGenerator>, 2> generators_;
+};
+
+TEST_P(BeaverTripleTest, AndTriplesWork) {
+  for (size_t n : {1, 127, 3000}) {
+    // WHEN
+    auto [t0, t1] = Run([&](BeaverTripleGenerator* g) {
+      return g->GenAndTriples(n);
+    });
+
+    // THEN
+    ASSERT_EQ(t0.size, n);
+    ASSERT_EQ(t0.c.size(), (n + 127) / 128);
+    uint128_t ones = 0;
+    for (size_t i = 0; i < t0.c.size(); ++i) {
+      const uint128_t a = t0.a[i] ^ t1.a[i];
+      const uint128_t b = t0.b[i] ^ t1.b[i];
+      EXPECT_EQ(a & b, t0.c[i] ^ t1.c[i]) << i;
+      ones |= a & b;
+    }
+    // the triples are not all zero.
+    if (n > 100) {
+      EXPECT_NE(ones, 0);
+    }
+  }
+}
+
+template <typename T>
+void CheckMulTriples(const MulTriples<T>& t0, const MulTriples<T>& t1,
+                     size_t n) {
+  ASSERT_EQ(t0.c.size(), n);
+  ASSERT_EQ(t1.c.size(), n);
+  for (size_t i = 0; i < n; ++i) {
+    const T a = t0.a[i] + t1.a[i];
+    const T b = t0.b[i] + t1.b[i];
+    EXPECT_TRUE(a * b == t0.c[i] + t1.c[i]) << i;
+    // shares are random.
+    EXPECT_TRUE(t0.a[i] != t1.a[i]) << i;
+  }
+}
+
+TEST_P(BeaverTripleTest, MulTriplesWork) {
+  for (size_t n : {1, 100}) {
+    auto [r0, r1] = Run([&](BeaverTripleGenerator* g) {
+      return g->GenMulTriples<uint64_t>(n);
+    });
+    CheckMulTriples(r0, r1, n);
+
+    auto [s0, s1] = Run([&](BeaverTripleGenerator* g) {
+      return g->GenMulTriples<uint128_t>(n);
+    });
+    CheckMulTriples(s0, s1, n);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Iknp_Pool, BeaverTripleTest,
+                         testing::Values(false, true));
+
+// rank 2 deals to ranks 0 and 1.
+template <typename Deal, typename Recv>
+auto RunDealt(Deal&& deal, Recv&& recv) {
+  auto contexts = link::test::SetupWorld("beaver_dealt", 3);
+  const auto sent = [&](size_t rank) {
+    return contexts[2]->GetStats()->peers[rank].sent_size.Snapshot().sum;
+  };
+  const auto sent0 = sent(0);
+  const auto sent1 = sent(1);
+  auto f0 = std::async([&] { return recv(contexts[0]); });
+  auto f1 = std::async([&] { return recv(contexts[1]); });
+  deal(contexts[2]);
+  auto t0 = f0.get();
+  auto t1 = f1.get();
+  // a seed to party 0, and the c shares to party 1.
+  EXPECT_EQ(sent(0) - sent0, sizeof(uint128_t));
+  EXPECT_EQ(sent(1) - sent1,
+            sizeof(uint128_t) + t1.c.size() * sizeof(t1.c[0]));
+  return std::make_pair(std::move(t0), std::move(t1));
+}
+
+TEST(BeaverTripleDealTest, AndTriplesWork) {
+  for (size_t n : {0, 1, 127, 3000}) {
+    auto [t0, t1] = RunDealt(
+        [&](const auto& ctx) { DealAndTriples(ctx, n, 0, 1); },
+        [&](const auto& ctx) { return RecvAndTriples(ctx, n, 2); });
+
+    ASSERT_EQ(t0.size, n);
+    ASSERT_EQ(t1.c.size(), (n + 127) / 128);
+    uint128_t ones = 0;
+    for (size_t i = 0; i < t0.c.size(); ++i) {
+      const uint128_t a = t0.a[i] ^ t1.a[i];
+      const uint128_t b = t0.b[i] ^ t1.b[i];
+      EXPECT_EQ(a & b, t0.c[i] ^ t1.c[i]) << i;
+      ones |= a & b;
+    }
+    if (n > 100) {
+      EXPECT_NE(ones, 0);
+    }
+    // bits from n on are zero, as generated ones.
+    if (n % 128 != 0) {
+      EXPECT_EQ(t0.a.back() >> (n % 128), 0);
+      EXPECT_EQ(t1.c.back() >> (n % 128), 0);
+    }
+  }
+}
+
+TEST(BeaverTripleDealTest, MulTriplesWork) {
+  for (size_t n : {1, 1000}) {
+    auto [r0, r1] = RunDealt(
+        [&](const auto& ctx) { DealMulTriples<uint64_t>(ctx, n, 0, 1); },
+        [&](const auto& ctx) { return RecvMulTriples<uint64_t>(ctx, n, 2); });
+    CheckMulTriples(r0, r1, n);
+
+    auto [s0, s1] = RunDealt(
+        [&](const auto& ctx) { DealMulTriples<uint128_t>(ctx, n, 0, 1); },
+        [&](const auto& ctx) { return RecvMulTriples<uint128_t>(ctx, n, 2); });
+    CheckMulTriples(s0, s1, n);
+  }
+}
+
+}  // namespace
+}  // namespace yasl
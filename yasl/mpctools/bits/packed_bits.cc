@@ -0,0 +1,196 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/bits/packed_bits.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "absl/numeric/bits.h"
+
+#include "yasl/mpctools/ot/utils.h"
+#include "yasl/utils/bitwise.h"
+#include "yasl/utils/parallel.h"
+
+namespace yasl {
+
+namespace {
+
+// words of a task of a parallel gate.
+constexpr size_t kParallelGrainWords =
+    PackedBits::kParallelBytes / 4 / sizeof(uint128_t);
+
+// calls `f(begin, end)` over the word ranges of `num_words`, in one go below
+// kParallelBytes.
+template <typename F>
+void ForEachWords(size_t num_words, const F& f) {
+  if (num_words * sizeof(uint128_t) < PackedBits::kParallelBytes) {
+    f(0, num_words);
+    return;
+  }
+  parallel_for(0, num_words, kParallelGrainWords,
+               [&](int64_t begin, int64_t end) { f(begin, end); });
+}
+
+}  // namespace
+
+PackedBits::PackedBits(size_t size, bool value)
+    : size_(size),
+      words_(NumWords(size), value ? ~uint128_t(0) : uint128_t(0)) {
+  ClearUnusedBits();
+}
+
+PackedBits::PackedBits(absl::Span<const uint128_t> words, size_t size)
+    : size_(size) {
+  YASL_ENFORCE_GE(words.size(), NumWords(size));
+  words_.assign(words.begin(), words.begin() + NumWords(size));
+  ClearUnusedBits();
+}
+
+PackedBits::PackedBits(std::vector<uint128_t>&& words, size_t size)
+    : size_(size), words_(std::move(words)) {
+  YASL_ENFORCE_GE(words_.size(), NumWords(size));
+  words_.resize(NumWords(size));
+  ClearUnusedBits();
+}
+
+PackedBits::PackedBits(const BitVector& bits)
+    : size_(bits.size()), words_(bits.words().begin(), bits.words().end()) {}
+
+PackedBits& PackedBits::operator^=(const PackedBits& other) {
+  YASL_ENFORCE_EQ(size_, other.size_);
+  ForEachWords(words_.size(), [&](size_t begin, size_t end) {
+    XorInto(absl::MakeSpan(&words_[begin], end - begin),
+            absl::MakeConstSpan(&other.words_[begin], end - begin));
+  });
+  return *this;
+}
+
+PackedBits& PackedBits::operator&=(const PackedBits& other) {
+  YASL_ENFORCE_EQ(size_, other.size_);
+  ForEachWords(words_.size(), [&](size_t begin, size_t end) {
+    AndInto(absl::MakeSpan(&words_[begin], end - begin),
+            absl::MakeConstSpan(&other.words_[begin], end - begin));
+  });
+  return *this;
+}
+
+PackedBits& PackedBits::XorAnd(const PackedBits& a, const PackedBits& b) {
+  YASL_ENFORCE_EQ(size_, a.size_);
+  YASL_ENFORCE_EQ(size_, b.size_);
+  ForEachWords(words_.size(), [&](size_t begin, size_t end) {
+    yasl::XorAnd(absl::MakeSpan(&words_[begin], end - begin),
+                 absl::MakeConstSpan(&a.words_[begin], end - begin),
+                 absl::MakeConstSpan(&b.words_[begin], end - begin));
+  });
+  return *this;
+}
+
+PackedBits& PackedBits::Flip() {
+  ForEachWords(words_.size(), [&](size_t begin, size_t end) {
+    NotInto(absl::MakeSpan(&words_[begin], end - begin));
+  });
+  ClearUnusedBits();
+  return *this;
+}
+
+size_t PackedBits::Count() const {
+  size_t count = 0;
+  for (const auto word : words_) {
+    count += absl::popcount(static_cast<uint64_t>(word)) +
+             absl::popcount(static_cast<uint64_t>(word >> 64));
+  }
+  return count;
+}
+
+PackedBits PackedBits::FromBytes(ByteContainerView bytes, size_t size) {
+  YASL_ENFORCE_EQ(bytes.size(), (size + 7) / 8);
+  PackedBits bits(size);
+  if (!bytes.empty()) {
+    std::memcpy(bits.words_.data(), bytes.data(), bytes.size());
+  }
+  bits.ClearUnusedBits();
+  return bits;
+}
+
+Buffer PackedBits::Serialize() const {
+  const uint64_t size = size_;
+  const auto view = bytes();
+  Buffer buf(static_cast<int64_t>(sizeof(size) + view.size()));
+  std::memcpy(buf.data(), &size, sizeof(size));
+  if (!view.empty()) {
+    std::memcpy(buf.data<uint8_t>() + sizeof(size), view.data(), view.size());
+  }
+  return buf;
+}
+
+PackedBits PackedBits::Deserialize(ByteContainerView buf) {
+  uint64_t size = 0;
+  YASL_ENFORCE_GE(buf.size(), sizeof(size));
+  std::memcpy(&size, buf.data(), sizeof(size));
+  return FromBytes(buf.subspan(sizeof(size)), size);
+}
+
+void PackedBits::ClearUnusedBits() {
+  if (size_ % kWordBits != 0) {
+    words_.back() &= (uint128_t(1) << (size_ % kWordBits)) - 1;
+  }
+}
+
+std::vector<PackedBits> BitSliceRows(absl::Span<const uint128_t> rows,
+                                     size_t width) {
+  YASL_ENFORCE(width <= 128, "width={} is beyond 128", width);
+  const size_t n = rows.size();
+  const size_t k = PackedBits::NumWords(n);
+  std::vector<PackedBits> slices;
+  if (n == 0) {
+    slices.resize(width);
+    return slices;
+  }
+  // the rows padded to 128 * k, transposed into 128 slices of k words.
+  std::vector<uint128_t> matrix(128 * k);
+  std::copy(rows.begin(), rows.end(), matrix.begin());
+  std::vector<uint128_t> transposed(matrix.size());
+  MatrixTranspose(matrix, absl::MakeSpan(transposed), k, 1);
+  slices.reserve(width);
+  for (size_t j = 0; j < width; ++j) {
+    slices.emplace_back(absl::MakeConstSpan(&transposed[j * k], k), n);
+  }
+  return slices;
+}
+
+std::vector<uint128_t> UnsliceRows(absl::Span<const PackedBits> slices) {
+  YASL_ENFORCE(slices.size() <= 128, "{} slices are beyond 128",
+               slices.size());
+  if (slices.empty()) {
+    return {};
+  }
+  const size_t n = slices[0].size();
+  const size_t k = PackedBits::NumWords(n);
+  if (n == 0) {
+    return {};
+  }
+  std::vector<uint128_t> matrix(128 * k);
+  for (size_t j = 0; j < slices.size(); ++j) {
+    YASL_ENFORCE_EQ(slices[j].size(), n);
+    std::copy_n(slices[j].words().begin(), k, &matrix[j * k]);
+  }
+  std::vector<uint128_t> rows(matrix.size());
+  MatrixTranspose(matrix, absl::MakeSpan(rows), 1, k);
+  rows.resize(n);
+  return rows;
+}
+
+}  // namespace yasl
@@ -0,0 +1,157 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/bit_vector.h"
+#include "yasl/base/buffer.h"
+#include "yasl/base/byte_container_view.h"
+#include "yasl/base/exception.h"
+#include "yasl/base/int128.h"
+
+namespace yasl {
+
+// PackedBits holds a vector of boolean shares, e.g. the xor shares of a
+// layer of a GMW circuit, packed into 128 bits words the way BitVector and
+// the OT apis do: bit i is the (i % 128)th bit of word i / 128. Bits beyond
+// size are always 0.
+//
+// Gates run over whole words by the SIMD kernels of yasl/utils/bitwise.h,
+// and vectors of more than kParallelBytes are split across parallel_for,
+// so that a layer of gates runs at memory bandwidth.
+class PackedBits {
+ public:
+  static constexpr size_t kWordBits = BitVector::kWordBits;
+  // vectors of more bytes are split across parallel_for.
+  static constexpr size_t kParallelBytes = size_t(1) << 20;
+
+  PackedBits() = default;
+  explicit PackedBits(size_t size, bool value = false);
+  // take the first `size` bits of `words`.
+  PackedBits(absl::Span<const uint128_t> words, size_t size);
+  // the same, taking over `words` without a copy.
+  PackedBits(std::vector<uint128_t>&& words, size_t size);
+  explicit PackedBits(const BitVector& bits);
+
+  static size_t NumWords(size_t size) { return BitVector::NumWords(size); }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  bool operator[](size_t idx) const {
+    return (words_[idx / kWordBits] >> (idx % kWordBits)) & 1;
+  }
+
+  void Set(size_t idx, bool value) {
+    const uint128_t mask = uint128_t(1) << (idx % kWordBits);
+    auto& word = words_[idx / kWordBits];
+    word = value ? (word | mask) : (word & ~mask);
+  }
+
+  absl::Span<const uint128_t> words() const { return words_; }
+  // bits beyond size must be left 0.
+  absl::Span<uint128_t> mutable_words() { return absl::MakeSpan(words_); }
+
+  // gates of shares, both sides must have the same size.
+  PackedBits& operator^=(const PackedBits& other);
+  PackedBits& operator&=(const PackedBits& other);
+  // this ^= a & b, e.g. the cross terms of an AND gate on beaver triples.
+  PackedBits& XorAnd(const PackedBits& a, const PackedBits& b);
+  // this = ~this, a NOT gate is the flip of the share of one party.
+  PackedBits& Flip();
+
+  PackedBits operator^(const PackedBits& other) const {
+    PackedBits ret = *this;
+    ret ^= other;
+    return ret;
+  }
+  PackedBits operator&(const PackedBits& other) const {
+    PackedBits ret = *this;
+    ret &= other;
+    return ret;
+  }
+  PackedBits operator~() const {
+    PackedBits ret = *this;
+    ret.Flip();
+    return ret;
+  }
+
+  // number of 1 bits.
+  size_t Count() const;
+
+  bool operator==(const PackedBits& other) const {
+    return size_ == other.size_ && words_ == other.words_;
+  }
+  bool operator!=(const PackedBits& other) const { return !(*this == other); }
+
+  BitVector ToBitVector() const { return BitVector(words_, size_); }
+
+  // the bits in ceil(size / 8) bytes, a view to send the shares as they are
+  // when peer knows the size.
+  ByteContainerView bytes() const {
+    return ByteContainerView(words_.data(), (size_ + 7) / 8);
+  }
+  static PackedBits FromBytes(ByteContainerView bytes, size_t size);
+
+  // 8 bytes of size, then the bytes(), written straight into the buffer.
+  Buffer Serialize() const;
+  static PackedBits Deserialize(ByteContainerView buf);
+
+ private:
+  // zero bits beyond size in the last word.
+  void ClearUnusedBits();
+
+  size_t size_ = 0;
+  std::vector<uint128_t> words_;
+};
+
+// BitSlice Unslice
+//
+// Transposes between the word layout, n values of T, and the bit-sliced one,
+// `width` PackedBits of n bits where slice j holds bit j of all values, so
+// that a boolean circuit over values evaluates a gate on all of them at once.
+// Values are the rows of a 128-bit wide bit matrix, transposed by
+// MatrixTranspose 128x128 tiles a time.
+
+std::vector<PackedBits> BitSliceRows(absl::Span<const uint128_t> rows,
+                                     size_t width);
+
+// rows of the values of `slices`, of the same size, at most 128 of them.
+std::vector<uint128_t> UnsliceRows(absl::Span<const PackedBits> slices);
+
+template <typename T>
+std::vector<PackedBits> BitSlice(absl::Span<const T> values,
+                                 size_t width = sizeof(T) * 8) {
+  static_assert(std::is_unsigned_v<T> || std::is_same_v<T, uint128_t>);
+  YASL_ENFORCE(width <= sizeof(T) * 8, "width={} is beyond T", width);
+  std::vector<uint128_t> rows(values.begin(), values.end());
+  return BitSliceRows(rows, width);
+}
+
+template <typename T>
+std::vector<T> Unslice(absl::Span<const PackedBits> slices) {
+  static_assert(std::is_unsigned_v<T> || std::is_same_v<T, uint128_t>);
+  YASL_ENFORCE(slices.size() <= sizeof(T) * 8, "{} slices are beyond T",
+               slices.size());
+  const auto rows = UnsliceRows(slices);
+  return std::vector<T>(rows.begin(), rows.end());
+}
+
+}  // namespace yasl
@@ -0,0 +1,139 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/bits/packed_bits.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace yasl {
+
+namespace {
+
+PackedBits RandomBits(size_t n, uint32_t seed) {
+  std::mt19937 rng(seed);
+  PackedBits bits(n);
+  for (size_t i = 0; i < n; ++i) {
+    bits.Set(i, rng() & 1);
+  }
+  return bits;
+}
+
+}  // namespace
+
+class PackedBitsTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(PackedBitsTest, Gates) {
+  const size_t n = GetParam();
+  const auto a = RandomBits(n, 1);
+  const auto b = RandomBits(n, 2);
+  const auto c = RandomBits(n, 3);
+
+  const auto x = a ^ b;
+  const auto y = a & b;
+  const auto z = ~a;
+  auto w = c;
+  w.XorAnd(a, b);
+
+  size_t ones = 0;
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(x[i], a[i] ^ b[i]) << i;
+    EXPECT_EQ(y[i], a[i] && b[i]) << i;
+    EXPECT_EQ(z[i], !a[i]) << i;
+    EXPECT_EQ(w[i], c[i] ^ (a[i] && b[i])) << i;
+    ones += a[i];
+  }
+  // bits beyond size are kept 0.
+  EXPECT_EQ(z.Count(), n - ones);
+  EXPECT_EQ(~z, a);
+}
+
+TEST_P(PackedBitsTest, Serialize) {
+  const size_t n = GetParam();
+  const auto a = RandomBits(n, 4);
+
+  EXPECT_EQ(PackedBits::Deserialize(a.Serialize()), a);
+  EXPECT_EQ(a.bytes().size(), (n + 7) / 8);
+  EXPECT_EQ(PackedBits::FromBytes(a.bytes(), n), a);
+  EXPECT_EQ(PackedBits(a.ToBitVector()), a);
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, PackedBitsTest,
+                         testing::Values(0, 1, 127, 128, 129, 1000,
+                                         // across parallel_for.
+                                         (size_t(1) << 24) + 3));
+
+TEST(PackedBits, BitSlice) {
+  std::mt19937_64 rng(5);
+  for (size_t n : {0, 1, 100, 128, 1000}) {
+    std::vector<uint64_t> values(n);
+    for (auto& v : values) {
+      v = rng();
+    }
+
+    const auto slices = BitSlice<uint64_t>(values);
+    ASSERT_EQ(slices.size(), 64);
+    for (size_t j = 0; j < 64; ++j) {
+      ASSERT_EQ(slices[j].size(), n);
+      for (size_t i = 0; i < n; ++i) {
+        EXPECT_EQ(slices[j][i], (values[i] >> j) & 1) << i << " " << j;
+      }
+    }
+    EXPECT_EQ(Unslice<uint64_t>(slices), values);
+  }
+}
+
+TEST(PackedBits, BitSliceAdder) {
+  // a ripple carry adder on bit slices adds all pairs of values at once.
+  std::mt19937 rng(6);
+  const size_t n = 300;
+  std::vector<uint8_t> a(n);
+  std::vector<uint8_t> b(n);
+  for (size_t i = 0; i < n; ++i) {
+    a[i] = rng();
+    b[i] = rng();
+  }
+  const auto as = BitSlice<uint8_t>(a);
+  const auto bs = BitSlice<uint8_t>(b);
+  std::vector<PackedBits> sums;
+  PackedBits carry(n);
+  for (size_t j = 0; j < 8; ++j) {
+    auto t = as[j] ^ bs[j];
+    sums.push_back(t ^ carry);
+    // carry = a & b ^ carry & (a ^ b)
+    auto next = as[j] & bs[j];
+    next.XorAnd(carry, t);
+    carry = std::move(next);
+  }
+
+  const auto c = Unslice<uint8_t>(sums);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(c[i], static_cast<uint8_t>(a[i] + b[i])) << i;
+  }
+}
+
+TEST(PackedBits, Mismatch) {
+  PackedBits a(10);
+  PackedBits b(11);
+  EXPECT_THROW(a ^= b, EnforceNotMet);
+  EXPECT_THROW(a &= b, EnforceNotMet);
+  EXPECT_THROW(a.XorAnd(a, b), EnforceNotMet);
+  EXPECT_THROW(PackedBits::FromBytes(PackedBits(17).bytes(), 10),
+               EnforceNotMet);
+  EXPECT_THROW(BitSlice<uint8_t>(std::vector<uint8_t>(3), 9), EnforceNotMet);
+}
+
+}  // namespace yasl
@@ -0,0 +1,307 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/dpf/dcf.h"
+
+#include <algorithm>
+#include <array>
+
+#include "yasl/mpctools/dpf/dpf_prg.h"
+#include "yasl/mpctools/dpf/serializable.pb.h"
+#include "yasl/utils/parallel.h"
+
+namespace yasl::mpctools {
+
+namespace {
+
+using internal::BatchDpfPRG;
+using internal::kExpandChunk;
+
+// the bit of x deciding the child at `level`, from the most significant one.
+bool GetLevelBit(DpfInStore x, size_t in_bitnum, size_t level) {
+  return (x >> (in_bitnum - 1 - level)) & 1;
+}
+
+// (-1)^t * x
+DpfOutStore Negate(DpfOutStore x, bool t) { return t ? -x : x; }
+
+// the left and right values of a split are the halves of its 4th block.
+DpfOutStore SplitValue(uint128_t block, bool right) {
+  return right ? block >> 64 : static_cast<uint64_t>(block);
+}
+
+}  // namespace
+
+void DcfContext::GenBatch(absl::Span<const DpfInStore> alphas,
+                          absl::Span<const DpfOutStore> betas,
+                          absl::Span<const uint128_t> first_mks,
+                          absl::Span<const uint128_t> second_mks,
+                          absl::Span<DcfKey> first_keys,
+                          absl::Span<DcfKey> second_keys) {
+  YASL_ENFORCE(in_bitnum_ > 0 && in_bitnum_ < 64);
+  YASL_ENFORCE(ss_bitnum_ > 0 && ss_bitnum_ <= 64);
+  const size_t num = alphas.size();
+  YASL_ENFORCE(betas.size() == num && first_mks.size() == num &&
+                   second_mks.size() == num && first_keys.size() == num &&
+                   second_keys.size() == num,
+               "size mismatch, {} alphas", num);
+  for (const auto& alpha : alphas) {
+    YASL_ENFORCE((alpha >> in_bitnum_) == 0, "alpha exceeds {} bits",
+                 in_bitnum_);
+  }
+  const DpfOutStore ss_mask = GetSsMask();
+
+  // as DpfContext::GenBatch, seeds of the two parties of key k are at 2k and
+  // 2k + 1.
+  constexpr size_t kKeysPerTask = kExpandChunk / 2;
+  parallel_for(0, num, kKeysPerTask, [&](int64_t begin, int64_t end) {
+    std::array<uint128_t, kExpandChunk> seeds_working;
+    std::array<bool, kExpandChunk> t_working;
+    // the value of the path of alpha, accumulated by party 1 minus party 0.
+    std::array<DpfOutStore, kKeysPerTask> v_alpha;
+    std::array<uint128_t, kExpandChunk * 4> prgs;
+
+    for (int64_t first = begin; first < end; first += kKeysPerTask) {
+      const size_t n = std::min<int64_t>(kKeysPerTask, end - first);
+      auto* first_key = &first_keys[first];
+      auto* second_key = &second_keys[first];
+
+      for (size_t k = 0; k < n; k++) {
+        first_key[k] =
+            DcfKey(false, in_bitnum_, ss_bitnum_, first_mks[first + k]);
+        second_key[k] =
+            DcfKey(true, in_bitnum_, ss_bitnum_, second_mks[first + k]);
+        first_key[k].cws_vec.resize(in_bitnum_);
+        first_key[k].v_cws_vec.resize(in_bitnum_);
+        seeds_working[2 * k] = first_mks[first + k];
+        seeds_working[2 * k + 1] = second_mks[first + k];
+        t_working[2 * k] = false;     // default by definition
+        t_working[2 * k + 1] = true;  // default by definition
+        v_alpha[k] = 0;
+      }
+
+      for (size_t i = 0; i < in_bitnum_; i++) {
+        BatchDpfPRG<4>(seeds_working.data(), 2 * n, prgs.data());
+
+        for (size_t k = 0; k < n; k++) {
+          const bool alpha_bit = GetLevelBit(alphas[first + k], in_bitnum_, i);
+          const std::array<const uint128_t*, 2> prg = {&prgs[8 * k],
+                                                       &prgs[8 * k + 4]};
+          // keep the child of alpha_bit, lose the other one.
+          const uint128_t cw_seed = prg[0][!alpha_bit] ^ prg[1][!alpha_bit];
+          const bool t1 = t_working[2 * k + 1];
+          DpfOutStore v_cw =
+              Negate(SplitValue(prg[1][3], !alpha_bit) -
+                         SplitValue(prg[0][3], !alpha_bit) - v_alpha[k],
+                     t1);
+          if (alpha_bit) {
+            // the lost left child is below alpha.
+            v_cw += Negate(betas[first + k], t1);
+          }
+          v_alpha[k] = v_alpha[k] - SplitValue(prg[1][3], alpha_bit) +
+                       SplitValue(prg[0][3], alpha_bit) + Negate(v_cw, t1);
+
+          const bool cw_t_left = ((prg[0][2] >> 1) & 1) ^
+                                 ((prg[1][2] >> 1) & 1) ^ alpha_bit ^ 1;
+          const bool cw_t_right =
+              ((prg[0][2] >> 2) & 1) ^ ((prg[1][2] >> 2) & 1) ^ alpha_bit;
+          const bool cw_t_keep = alpha_bit ? cw_t_right : cw_t_left;
+
+          // get the seeds_working and t_working for next level
+          for (size_t j = 0; j < 2; j++) {
+            auto& seed = seeds_working[2 * k + j];
+            auto& t = t_working[2 * k + j];
+            const bool t_keep = (prg[j][2] >> (1 + alpha_bit)) & 1;
+            seed = t ? prg[j][alpha_bit] ^ cw_seed : prg[j][alpha_bit];
+            t = t_keep ^ (t && cw_t_keep);
+          }
+
+          first_key[k].cws_vec[i].SetSeed(cw_seed);
+          first_key[k].cws_vec[i].SetTLeft(cw_t_left);
+          first_key[k].cws_vec[i].SetTRight(cw_t_right);
+          first_key[k].v_cws_vec[i] = v_cw & ss_mask;
+        }
+      }
+
+      // Convert the final seeds, as DPF does.
+      BatchDpfPRG<1>(seeds_working.data(), 2 * n, prgs.data());
+      for (size_t k = 0; k < n; k++) {
+        first_key[k].last_cw =
+            Negate(prgs[2 * k + 1] - prgs[2 * k] - v_alpha[k],
+                   t_working[2 * k + 1]) &
+            ss_mask;
+        second_key[k].cws_vec = first_key[k].cws_vec;
+        second_key[k].v_cws_vec = first_key[k].v_cws_vec;
+        second_key[k].last_cw = first_key[k].last_cw;
+      }
+    }
+  });
+}
+
+std::vector<DpfOutStore> DcfContext::EvalBatch(
+    absl::Span<const DcfKey> keys, absl::Span<const DpfInStore> inputs) {
+  YASL_ENFORCE_EQ(keys.size(), inputs.size());
+  for (size_t k = 0; k < keys.size(); k++) {
+    YASL_ENFORCE_EQ(keys[k].cws_vec.size(), in_bitnum_);
+    YASL_ENFORCE_EQ(keys[k].v_cws_vec.size(), in_bitnum_);
+    YASL_ENFORCE((inputs[k] >> in_bitnum_) == 0, "input exceeds {} bits",
+                 in_bitnum_);
+  }
+  std::vector<DpfOutStore> result(keys.size());
+
+  const DpfOutStore ss_mask = GetSsMask();
+  parallel_for(0, keys.size(), kExpandChunk, [&](int64_t begin, int64_t end) {
+    std::array<uint128_t, kExpandChunk> seeds_working;
+    std::array<bool, kExpandChunk> t_working;
+    std::array<DpfOutStore, kExpandChunk> v_working;
+    std::array<uint128_t, kExpandChunk * 4> prgs;
+
+    for (int64_t first = begin; first < end; first += kExpandChunk) {
+      const size_t n = std::min<int64_t>(kExpandChunk, end - first);
+      for (size_t k = 0; k < n; k++) {
+        seeds_working[k] = keys[first + k].GetSeed();
+        t_working[k] = keys[first + k].GetRank();
+        v_working[k] = 0;
+      }
+
+      for (size_t i = 0; i < in_bitnum_; i++) {
+        BatchDpfPRG<4>(seeds_working.data(), n, prgs.data());
+        for (size_t k = 0; k < n; k++) {
+          const auto& key = keys[first + k];
+          const auto& cw = key.cws_vec[i];
+          const bool bit = GetLevelBit(inputs[first + k], in_bitnum_, i);
+          const auto* prg = &prgs[4 * k];
+          const bool t = t_working[k];
+
+          v_working[k] += Negate(
+              SplitValue(prg[3], bit) + (t ? key.v_cws_vec[i] : 0),
+              key.GetRank());
+          seeds_working[k] = t ? prg[bit] ^ cw.GetSeed() : prg[bit];
+          t_working[k] = ((prg[2] >> (1 + bit)) & 1) ^
+                         (t && (bit ? cw.GetTRight() : cw.GetTLeft()));
+        }
+      }
+
+      BatchDpfPRG<1>(seeds_working.data(), n, prgs.data());
+      for (size_t k = 0; k < n; k++) {
+        const auto& key = keys[first + k];
+        result[first + k] =
+            (v_working[k] + Negate(prgs[k] + t_working[k] * key.last_cw,
+                                   key.GetRank())) &
+            ss_mask;
+      }
+    }
+  });
+  return result;
+}
+
+std::vector<DpfOutStore> DcfContext::EvalAll(const DcfKey& key) {
+  YASL_ENFORCE(in_bitnum_ <= 25);  // only support in_bin_num < 25
+  YASL_ENFORCE_EQ(key.cws_vec.size(), in_bitnum_);
+  YASL_ENFORCE_EQ(key.v_cws_vec.size(), in_bitnum_);
+
+  // node p of level l is the top l bits of the inputs, its children are 2p
+  // and 2p + 1. nodes are expanded from the last one, so children overwrite
+  // nodes expanded already, and result keeps the seeds in place.
+  const uint64_t num = 1ULL << in_bitnum_;
+  std::vector<DpfOutStore> result(num);
+  std::vector<uint8_t> ts(num);
+  std::vector<uint64_t> vs(num);
+  result[0] = key.GetSeed();
+  ts[0] = key.GetRank();
+
+  std::array<uint128_t, kExpandChunk * 4> prgs;
+  for (size_t i = 0; i < in_bitnum_; i++) {
+    const auto& cw = key.cws_vec[i];
+    const std::array<bool, 2> cw_ts = {cw.GetTLeft(), cw.GetTRight()};
+    for (uint64_t end = 1ULL << i; end > 0;) {
+      const uint64_t begin = end > kExpandChunk ? end - kExpandChunk : 0;
+      BatchDpfPRG<4>(&result[begin], end - begin, prgs.data());
+      for (uint64_t p = end; p-- > begin;) {
+        const auto* prg = &prgs[4 * (p - begin)];
+        const bool t = ts[p];
+        const DpfOutStore v = vs[p];
+        for (size_t bit = 0; bit < 2; bit++) {
+          const uint64_t child = 2 * p + bit;
+          result[child] = t ? prg[bit] ^ cw.GetSeed() : prg[bit];
+          ts[child] = ((prg[2] >> (1 + bit)) & 1) ^ (t && cw_ts[bit]);
+          vs[child] = static_cast<uint64_t>(
+              v + Negate(SplitValue(prg[3], bit) + (t ? key.v_cws_vec[i] : 0),
+                         key.GetRank()));
+        }
+      }
+      end = begin;
+    }
+  }
+
+  const DpfOutStore ss_mask = GetSsMask();
+  for (uint64_t begin = 0; begin < num; begin += kExpandChunk) {
+    const size_t n = std::min<uint64_t>(kExpandChunk, num - begin);
+    BatchDpfPRG<1>(&result[begin], n, prgs.data());
+    for (size_t k = 0; k < n; k++) {
+      const uint64_t p = begin + k;
+      result[p] = (vs[p] + Negate(prgs[k] + ts[p] * key.last_cw,
+                                  key.GetRank())) &
+                  ss_mask;
+    }
+  }
+  return result;
+}
+
+std::string DcfKey::Serialize() const {
+  DcfKeyProto proto;
+  for (const auto& cws : cws_vec) {
+    auto* cws_proto = proto.add_cws_vec();
+    auto i128_parts = DecomposeUInt128(cws.GetSeed());
+    cws_proto->mutable_seed()->set_hi(i128_parts.first);
+    cws_proto->mutable_seed()->set_lo(i128_parts.second);
+    cws_proto->set_t_store(cws.GetTStore());
+  }
+  for (const auto& v_cw : v_cws_vec) {
+    proto.add_v_cws_vec(static_cast<uint64_t>(v_cw));
+  }
+  proto.set_last_cw(static_cast<uint64_t>(last_cw));
+  proto.set_rank(rank_);
+  proto.set_in_bitnum(in_bitnum_);
+  proto.set_ss_bitnum(ss_bitnum_);
+
+  auto i128_parts = DecomposeUInt128(mseed_);
+  proto.mutable_mseed()->set_hi(i128_parts.first);
+  proto.mutable_mseed()->set_lo(i128_parts.second);
+
+  return proto.SerializeAsString();
+}
+
+void DcfKey::Deserialize(const std::string& s) {
+  DcfKeyProto proto;
+  YASL_ENFORCE(proto.ParseFromString(s), "invalid dcf key");
+
+  cws_vec.clear();
+  for (const auto& cws_proto : proto.cws_vec()) {
+    cws_vec.emplace_back(
+        MakeUint128(cws_proto.seed().hi(), cws_proto.seed().lo()),
+        cws_proto.t_store());
+  }
+  v_cws_vec.assign(proto.v_cws_vec().begin(), proto.v_cws_vec().end());
+  YASL_ENFORCE_EQ(v_cws_vec.size(), cws_vec.size(), "malformed dcf key");
+  last_cw = proto.last_cw();
+
+  rank_ = proto.rank();
+  in_bitnum_ = proto.in_bitnum();
+  ss_bitnum_ = proto.ss_bitnum();
+
+  mseed_ = MakeUint128(proto.mseed().hi(), proto.mseed().lo());
+}
+
+}  // namespace yasl::mpctools
@@ -0,0 +1,148 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/base/int128.h"
+#include "yasl/mpctools/dpf/dpf.h"
+
+namespace yasl::mpctools {
+
+// Implementation of Distributed Comparison Function (DCF)
+// title : Function Secret Sharing for Mixed-Mode and Fixed-Point Secure
+//         Computation
+// eprint: https://eprint.iacr.org/2020/1392
+//
+// Assume we have a function F(*), where F(x)=beta for x < alpha, otherwise
+// F(x)=0. DCF splits the function into two parts F1 and F2, and ensures
+// F1(x)+F2(x)=F(x) for all x.
+//
+// The tree is walked from the most significant bit of the input, each level
+// has a value correction word besides the seed and t correction words of
+// DPF. Keys are about the size of a DPF key.
+// Note: result is A-share
+
+class DcfKey {
+ public:
+  std::vector<DpfCW> cws_vec;          // correlated words for each level
+  std::vector<DpfOutStore> v_cws_vec;  // value correlated words of levels
+  DpfOutStore last_cw = 0;             // the final correlation word
+
+  DcfKey() = default;
+
+  DcfKey(bool rank, size_t in_bitnum, size_t ss_bitnum, const uint128_t mseed)
+      : rank_(rank),
+        in_bitnum_(in_bitnum),
+        ss_bitnum_(ss_bitnum),
+        mseed_(mseed){};
+
+  bool GetRank() const { return rank_; }
+  uint128_t GetSeed() const { return mseed_; }
+  size_t GetInBitNum() const { return in_bitnum_; }
+  size_t GetSsBitNum() const { return ss_bitnum_; }
+
+  std::string Serialize() const;
+  void Deserialize(const std::string& s);
+
+ private:
+  bool rank_{};            // only support two parties (0/1), compulsory param
+  size_t in_bitnum_ = 64;  // bit number (for point), default = 64
+  size_t ss_bitnum_ = 64;  // bit number (for output value), default = 64
+  uint128_t mseed_ = 0;    // the master seed (the default is not secure)
+};
+
+class DcfContext {
+ public:
+  DcfContext() = default;
+
+  DcfContext(size_t in_bitnum, size_t ss_bitnum)
+      : in_bitnum_(in_bitnum), ss_bitnum_(ss_bitnum){};
+
+  void SetInBitNum(size_t in_bitnum) {
+    YASL_ENFORCE(in_bitnum <= 64);
+    in_bitnum_ = in_bitnum;
+  }
+  size_t GetInBitNum() const { return in_bitnum_; }
+
+  void SetSsBitNum(size_t ss_bitnum) {
+    YASL_ENFORCE(ss_bitnum <= 64);
+    ss_bitnum_ = ss_bitnum;
+  }
+  size_t GetSsBitNum() const { return ss_bitnum_; }
+
+  DpfOutStore GetSsMask() const {
+    YASL_ENFORCE(ss_bitnum_ <= 64);
+    if (ss_bitnum_ == 64) {
+      return 0xFFFFFFFFFFFFFFFF;
+    }
+    return (static_cast<uint64_t>(1) << ss_bitnum_) - 1;
+  }
+
+  std::pair<DcfKey, DcfKey> Gen(DpfInStore alpha, DpfOutStore beta,
+                                uint128_t first_mk, uint128_t second_mk) {
+    DcfKey k0;
+    DcfKey k1;
+    GenBatch(absl::MakeConstSpan(&alpha, 1), absl::MakeConstSpan(&beta, 1),
+             absl::MakeConstSpan(&first_mk, 1),
+             absl::MakeConstSpan(&second_mk, 1), absl::MakeSpan(&k0, 1),
+             absl::MakeSpan(&k1, 1));
+    return {std::move(k0), std::move(k1)};
+  }
+
+  // Generates the key pairs of many points, the PRG calls of the keys at each
+  // level are batched and the keys are spread among threads.
+  std::pair<std::vector<DcfKey>, std::vector<DcfKey>> GenBatch(
+      absl::Span<const DpfInStore> alphas, absl::Span<const DpfOutStore> betas,
+      absl::Span<const uint128_t> first_mks,
+      absl::Span<const uint128_t> second_mks) {
+    std::vector<DcfKey> first_keys(alphas.size());
+    std::vector<DcfKey> second_keys(alphas.size());
+    GenBatch(alphas, betas, first_mks, second_mks, absl::MakeSpan(first_keys),
+             absl::MakeSpan(second_keys));
+    return {std::move(first_keys), std::move(second_keys)};
+  }
+
+  void GenBatch(absl::Span<const DpfInStore> alphas,
+                absl::Span<const DpfOutStore> betas,
+                absl::Span<const uint128_t> first_mks,
+                absl::Span<const uint128_t> second_mks,
+                absl::Span<DcfKey> first_keys, absl::Span<DcfKey> second_keys);
+
+  DpfOutStore Eval(const DcfKey& key, DpfInStore input) {
+    return EvalBatch(absl::MakeConstSpan(&key, 1),
+                     absl::MakeConstSpan(&input, 1))[0];
+  }
+
+  // result[k] = Eval(keys[k], inputs[k]), the PRG calls of the keys are
+  // batched at each level.
+  std::vector<DpfOutStore> EvalBatch(absl::Span<const DcfKey> keys,
+                                     absl::Span<const DpfInStore> inputs);
+
+  // Full domain evaluation, in_bitnum <= 25.
+  std::vector<DpfOutStore> EvalAll(const DcfKey& key);
+
+ private:
+  size_t in_bitnum_ = 64;
+  size_t ss_bitnum_ = 64;
+};
+
+}  // namespace yasl::mpctools
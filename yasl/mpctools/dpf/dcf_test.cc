@@ -0,0 +1,131 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/dpf/dcf.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace yasl::mpctools {
+
+struct DcfTestParams {
+  DpfInStore alpha;
+  DpfOutStore beta;
+  uint32_t in_bitnum;
+  uint32_t ss_bitnum;
+};
+
+class DcfTest : public testing::TestWithParam<DcfTestParams> {};
+
+TEST_P(DcfTest, EvalWorks) {
+  auto params = GetParam();
+  DcfContext context(params.in_bitnum, params.ss_bitnum);
+
+  DcfKey k0;
+  DcfKey k1;
+  std::tie(k0, k1) = context.Gen(params.alpha, params.beta, 0, 1);
+
+  DcfKey k1_copy;
+  k1_copy.Deserialize(k1.Serialize());
+
+  const size_t range = 1 << params.in_bitnum;
+  for (size_t x = 0; x < range; x++) {
+    const auto result =
+        (context.Eval(k0, x) + context.Eval(k1_copy, x)) & context.GetSsMask();
+    EXPECT_EQ(result, x < params.alpha ? params.beta : 0) << "x " << x;
+  }
+}
+
+TEST_P(DcfTest, EvalAllWorks) {
+  auto params = GetParam();
+  DcfContext context(params.in_bitnum, params.ss_bitnum);
+
+  DcfKey k0;
+  DcfKey k1;
+  std::tie(k0, k1) = context.Gen(params.alpha, params.beta, 2, 3);
+
+  const auto r0 = context.EvalAll(k0);
+  const auto r1 = context.EvalAll(k1);
+  ASSERT_EQ(r0.size(), 1U << params.in_bitnum);
+  for (size_t x = 0; x < r0.size(); x++) {
+    EXPECT_EQ(r0[x], context.Eval(k0, x));
+    EXPECT_EQ((r0[x] + r1[x]) & context.GetSsMask(),
+              x < params.alpha ? params.beta : 0);
+  }
+}
+
+TEST_P(DcfTest, BatchWorks) {
+  auto params = GetParam();
+  DcfContext context(params.in_bitnum, params.ss_bitnum);
+
+  // more keys than a task takes at a time.
+  const size_t num = 300;
+  const uint64_t range = 1ULL << params.in_bitnum;
+  std::vector<DpfInStore> alphas(num);
+  std::vector<DpfOutStore> betas(num);
+  std::vector<uint128_t> first_mks(num);
+  std::vector<uint128_t> second_mks(num);
+  std::vector<DpfInStore> inputs(num);
+  for (size_t i = 0; i < num; i++) {
+    alphas[i] = (params.alpha + i) % range;
+    betas[i] = (params.beta + i) & context.GetSsMask();
+    first_mks[i] = 2 * i;
+    second_mks[i] = 2 * i + 1;
+    inputs[i] = (i * 7) % range;
+  }
+
+  std::vector<DcfKey> k0s;
+  std::vector<DcfKey> k1s;
+  std::tie(k0s, k1s) = context.GenBatch(alphas, betas, first_mks, second_mks);
+  const auto r0 = context.EvalBatch(k0s, inputs);
+  const auto r1 = context.EvalBatch(k1s, inputs);
+  for (size_t i = 0; i < num; i++) {
+    DcfKey k0;
+    DcfKey k1;
+    std::tie(k0, k1) =
+        context.Gen(alphas[i], betas[i], first_mks[i], second_mks[i]);
+    EXPECT_EQ(k0s[i].Serialize(), k0.Serialize());
+    EXPECT_EQ(k1s[i].Serialize(), k1.Serialize());
+    EXPECT_EQ((r0[i] + r1[i]) & context.GetSsMask(),
+              inputs[i] < alphas[i] ? betas[i] : 0);
+  }
+}
+
+TEST(DcfTest, ShouldThrowOnBadInputs) {
+  DcfContext context(4, 8);
+  EXPECT_ANY_THROW(context.Gen(16, 1, 0, 1));
+
+  DcfKey k0;
+  DcfKey k1;
+  std::tie(k0, k1) = context.Gen(3, 1, 0, 1);
+  EXPECT_ANY_THROW(context.Eval(k0, 16));
+  context.SetInBitNum(5);
+  EXPECT_ANY_THROW(context.Eval(k0, 1));
+
+  DcfKey copy;
+  k0.v_cws_vec.pop_back();
+  EXPECT_ANY_THROW(copy.Deserialize(k0.Serialize()));
+}
+
+INSTANTIATE_TEST_SUITE_P(Works_Instances, DcfTest,
+                         testing::Values(DcfTestParams{0, 1, 1, 1},    //
+                                         DcfTestParams{1, 1, 2, 1},    //
+                                         DcfTestParams{5, 3, 4, 4},    //
+                                         DcfTestParams{100, 7, 8, 8},  //
+                                         DcfTestParams{255, 9, 8, 16},
+                                         DcfTestParams{1000, 5, 10, 32},
+                                         DcfTestParams{4000, 12345, 12, 64}));
+
+}  // namespace yasl::mpctools
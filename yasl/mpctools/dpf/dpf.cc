@@ -12,18 +12,24 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-
 #include "dpf.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstring>
 #include <future>
+#include <limits>
 #include <sstream>
 
+#include "absl/numeric/bits.h"
 #include "spdlog/spdlog.h"
 
-#include "yasl/crypto/pseudo_random_generator.h"
-
+#include "yasl/base/huge_page.h"
+#include "yasl/mpctools/dpf/dpf_prg.h"
 #include "yasl/mpctools/dpf/serializable.pb.h"
+#include "yasl/utils/metrics.h"
+#include "yasl/utils/parallel.h"
 
 namespace yasl::mpctools {
 
@@ -35,31 +41,207 @@ uint8_t GetBit(DpfInStore x, uint32_t i) {
   return x >> i & 1;
 }
 
-DpfOutStore DpfPRG(uint128_t seed) {
-  PseudoRandomGenerator<uint128_t, sizeof(uint128_t)> prng(seed);
-  return prng();
+using internal::kAesBatch;
+using internal::kExpandChunk;
+
+// out[i * N + c] is block c of seeds[i] expanded by `prg`, see dpf_prg.h.
+template <int N>
+void BatchPRG(DpfPrgType prg, const uint128_t* seeds, size_t n,
+              uint128_t* out) {
+  switch (prg) {
+    case DpfPrgType::kAes:
+      internal::BatchDpfPRG<N>(seeds, n, out);
+      return;
+    case DpfPrgType::kFixedKeyAes:
+      internal::BatchFixedKeyPRG<N>(seeds, n, out);
+      return;
+    case DpfPrgType::kSm4:
+      internal::BatchSm4PRG<N>(seeds, n, out);
+      return;
+  }
+  YASL_THROW("unknown dpf prg {}", static_cast<int>(prg));
 }
 
-std::tuple<uint128_t, bool, uint128_t, bool> SplitDpfSeed(uint128_t seed) {
-  uint128_t seed_left = 0;
-  uint128_t seed_right = 0;
-  bool t_left;
-  bool t_right;
+// expands n nodes of one level by the cw of that level, the left children
+// may overwrite the nodes.
+void ExpandNodes(DpfPrgType prg, const DpfCW& cw, const uint128_t* seeds,
+                 const uint8_t* ts, size_t n, uint128_t* left_seeds,
+                 uint8_t* left_ts, uint128_t* right_seeds, uint8_t* right_ts) {
+  const auto cw_seed = cw.GetSeed();
+  const auto cw_t_left = cw.GetTLeft();
+  const auto cw_t_right = cw.GetTRight();
+  std::array<uint128_t, kExpandChunk * 3> prgs;
+  for (size_t offset = 0; offset < n; offset += kExpandChunk) {
+    const size_t chunk = std::min(kExpandChunk, n - offset);
+    BatchPRG<3>(prg, seeds + offset, chunk, prgs.data());
+    for (size_t i = 0; i < chunk; ++i) {
+      const size_t p = offset + i;
+      const bool t = ts[p];
+      // split of the seed, corrected by the cw of this level.
+      const uint128_t mask = t ? cw_seed : 0;
+      left_seeds[p] = prgs[3 * i] ^ mask;
+      right_seeds[p] = prgs[3 * i + 1] ^ mask;
+      left_ts[p] = ((prgs[3 * i + 2] >> 1) & 1) ^ (t & cw_t_left);
+      right_ts[p] = ((prgs[3 * i + 2] >> 2) & 1) ^ (t & cw_t_right);
+    }
+  }
+}
 
-  // TODO: check if this implementation is secure and efficient
-  PseudoRandomGenerator<uint128_t, 3 * sizeof(uint128_t)> prng(seed);
+// bytes of a last cw of ss_bitnum bits in the compact key format.
+size_t LastCWBytes(size_t ss_bitnum) { return (ss_bitnum + 7) / 8; }
 
-  seed_left = prng();
-  seed_right = prng();
+// bytes of the t bits of num_cws cws in the compact key format.
+size_t TBitsBytes(size_t num_cws) { return (2 * num_cws + 7) / 8; }
 
-  uint128_t tmp = prng();
+// bit i of x goes to bit 63 - i.
+uint64_t ReverseBits(uint64_t x) {
+  x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+  x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+  x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+  return __builtin_bswap64(x);
+}
 
-  t_left = tmp >> 1 & 1;
-  t_right = tmp >> 2 & 1;
+// keys are read unchecked below, they must have exactly the cws of all
+// levels and the last cws of the context.
+template <typename Key>
+void EnforceKeyShape(const Key& key, DpfPrgType prg, bool enable_evalall,
+                     size_t num_cws, size_t num_last_cws) {
+  YASL_ENFORCE(key.IsEvalAllEnabled() == enable_evalall);
+  YASL_ENFORCE(key.GetPrgType() == prg, "dpf key of prg {}, expect {}",
+               static_cast<int>(key.GetPrgType()), static_cast<int>(prg));
+  YASL_ENFORCE(key.GetNumCWs() == num_cws &&
+                   key.GetNumLastCWs() == num_last_cws,
+               "malformed dpf key, {} cws and {} last cws, expect {} and {}",
+               key.GetNumCWs(), key.GetNumLastCWs(), num_cws, num_last_cws);
+}
 
-  return {seed_left, t_left, seed_right, t_right};
+// output share of a leaf whose seed is converted e + 1 times.
+template <typename Key>
+DpfOutStore LeafOutput(const Key& key, uint128_t prg, bool t, uint32_t e,
+                       DpfOutStore ss_mask) {
+  const DpfOutStore v = (prg + t * key.GetLastCW(e)) & ss_mask;
+  // ReverseSs for rank 1.
+  return key.GetRank() ? (ss_mask - v + 1) & ss_mask : v;
 }
 
+// Walks the tree depth first below the level of the chunk, so that the
+// frontiers of a single path are kept only. As in EvalAll, node p of level l
+// covers the inputs whose lower l bits are p. The frontier of the chunk level
+// is expanded once and shared, each frontier below it is the nodes sharing
+// the bits chosen on the path, i.e. 2^chunk_level nodes with consecutive
+// lower bits. Frontiers of the term level are numbered in depth first order.
+template <typename Key>
+class DpfTreeWalker {
+ public:
+  DpfTreeWalker(const Key& key, DpfPrgType prg, size_t term_level,
+                size_t chunk_bitnum, DpfOutStore ss_mask)
+      : key_(key),
+        prg_(prg),
+        term_level_(term_level),
+        chunk_level_(std::min(chunk_bitnum, term_level)),
+        chunk_bitnum_(chunk_bitnum),
+        ss_mask_(ss_mask),
+        width_(1ULL << chunk_level_),
+        seeds_(width_),
+        ts_(width_) {
+    seeds_[0] = key.GetSeed();
+    ts_[0] = key.GetRank();
+    for (size_t level = 0; level < chunk_level_; ++level) {
+      const uint64_t n = 1ULL << level;
+      ExpandNodes(prg_, key.GetCW(level), seeds_.data(), ts_.data(), n,
+                  seeds_.data(), ts_.data(), &seeds_[n], &ts_[n]);
+    }
+  }
+
+  uint64_t NumFrontiers() const {
+    return 1ULL << (term_level_ - chunk_level_);
+  }
+
+  // calls emit(begin, outputs) with the outputs of 2^chunk_bitnum consecutive
+  // inputs, for all the leaves of frontiers [begin, end).
+  template <typename F>
+  void Walk(uint64_t begin, uint64_t end, F&& emit) const {
+    State state;
+    state.seeds.resize(2 * width_ * (term_level_ - chunk_level_));
+    state.ts.resize(state.seeds.size());
+    state.chained.resize(width_);
+    state.outputs.resize(1ULL << chunk_bitnum_);
+    Visit(chunk_level_, 0, 0, seeds_.data(), ts_.data(), begin, end, state,
+          emit);
+  }
+
+ private:
+  struct State {
+    // children of level l are kept at slot l - chunk_level_, left then right.
+    std::vector<uint128_t> seeds;
+    std::vector<uint8_t> ts;
+    std::vector<uint128_t> chained;
+    std::vector<uint64_t> outputs;
+  };
+
+  // visits the frontier of `level` whose bits chosen above are `prefix`, it is
+  // the parent of frontiers [lo, lo + 2^(term_level_ - level)).
+  template <typename F>
+  void Visit(size_t level, uint64_t prefix, uint64_t lo,
+             const uint128_t* seeds, const uint8_t* ts, uint64_t begin,
+             uint64_t end, State& state, F& emit) const {
+    if (level == term_level_) {
+      EmitLeaves(prefix, seeds, ts, state, emit);
+      return;
+    }
+    const uint64_t half = 1ULL << (term_level_ - level - 1);
+    auto* left_seeds = &state.seeds[2 * width_ * (level - chunk_level_)];
+    auto* left_ts = &state.ts[2 * width_ * (level - chunk_level_)];
+    ExpandNodes(prg_, key_.GetCW(level), seeds, ts, width_, left_seeds,
+                left_ts, left_seeds + width_, left_ts + width_);
+    if (begin < lo + half) {
+      Visit(level + 1, prefix, lo, left_seeds, left_ts, begin, end, state,
+            emit);
+    }
+    if (end > lo + half) {
+      Visit(level + 1, prefix | (1ULL << level), lo + half,
+            left_seeds + width_, left_ts + width_, begin, end, state, emit);
+    }
+  }
+
+  // leaf p yields the outputs at prefix + p + (e << term_level_). when the
+  // chunk is wider than the term level, the outputs of consecutive e are
+  // emitted together.
+  template <typename F>
+  void EmitLeaves(uint64_t prefix, const uint128_t* seeds, const uint8_t* ts,
+                  State& state, F& emit) const {
+    const uint32_t expand_num = static_cast<uint32_t>(1)
+                                << (key_.GetInBitNum() - term_level_);
+    const uint32_t group = static_cast<uint32_t>(1)
+                           << (chunk_bitnum_ - chunk_level_);
+    std::copy_n(seeds, width_, state.chained.data());
+    for (uint32_t e = 0; e < expand_num; e++) {
+      BatchPRG<1>(prg_, state.chained.data(), width_, state.chained.data());
+      auto* outputs = &state.outputs[(e % group) * width_];
+      for (uint64_t p = 0; p < width_; ++p) {
+        outputs[p] = static_cast<uint64_t>(
+            LeafOutput(key_, state.chained[p], ts[p], e, ss_mask_));
+      }
+      if (e % group == group - 1) {
+        const uint64_t first = e + 1 - group;
+        emit(prefix + (static_cast<uint64_t>(first) << term_level_),
+             absl::MakeConstSpan(state.outputs));
+      }
+    }
+  }
+
+  const Key& key_;
+  const DpfPrgType prg_;
+  const size_t term_level_;
+  const size_t chunk_level_;
+  const size_t chunk_bitnum_;
+  const DpfOutStore ss_mask_;
+  const uint64_t width_;
+  // frontier of chunk_level_.
+  std::vector<uint128_t> seeds_;
+  std::vector<uint8_t> ts_;
+};
+
 }  // namespace
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -69,229 +251,495 @@ std::tuple<uint128_t, bool, uint128_t, bool> SplitDpfSeed(uint128_t seed) {
 void DpfContext::Gen(DpfKey& first_key, DpfKey& second_key, DpfInStore alpha,
                      DpfOutStore beta, uint128_t first_mk, uint128_t second_mk,
                      bool enable_evalall) {
+  GenBatch(absl::MakeConstSpan(&alpha, 1), absl::MakeConstSpan(&beta, 1),
+           absl::MakeConstSpan(&first_mk, 1),
+           absl::MakeConstSpan(&second_mk, 1), absl::MakeSpan(&first_key, 1),
+           absl::MakeSpan(&second_key, 1), enable_evalall);
+}
+
+void DpfContext::GenBatch(absl::Span<const DpfInStore> alphas,
+                          absl::Span<const DpfOutStore> betas,
+                          absl::Span<const uint128_t> first_mks,
+                          absl::Span<const uint128_t> second_mks,
+                          absl::Span<DpfKey> first_keys,
+                          absl::Span<DpfKey> second_keys,
+                          bool enable_evalall) {
   YASL_ENFORCE(this->in_bitnum_ > 0);
-  YASL_ENFORCE(this->in_bitnum_ > log(alpha));
   YASL_ENFORCE(this->in_bitnum_ < 64);
   YASL_ENFORCE(this->ss_bitnum_ > 0);
-  YASL_ENFORCE(this->ss_bitnum_ <= 64);
-
-  // enable the early termination
-  uint32_t term_level = GetTerminateLevel(enable_evalall);
-
-  // set up the return keys
-  first_key = DpfKey(false, GetInBitNum(), GetSsBitNum(), sec_param_, first_mk);
-  second_key =
-      DpfKey(true, GetInBitNum(), GetSsBitNum(), sec_param_, second_mk);
-  first_key.cws_vec.resize(term_level);
-  second_key.cws_vec.resize(term_level);
-
-  std::array<uint128_t, 2> seeds_working;
-  seeds_working[0] = first_mk;
-  seeds_working[1] = second_mk;
-
-  std::array<bool, 2> t_working;
-  t_working[0] = false;  // default by definition
-  t_working[1] = true;   // default by definition
-
-  for (uint32_t i = 0; i < term_level; i++) {
-    std::array<uint128_t, 2> seed_left;
-    std::array<uint128_t, 2> seed_right;
-    std::array<bool, 2> t_left;
-    std::array<bool, 2> t_right;
-
-    bool alpha_bit = (GetBit(alpha, i) != 0U);
-
-    // Use working seed to generate seeds
-    // Note: this is the most time-consuming process
-    // [TODO]: Make this parallel
-    std::tie(seed_left[0], t_left[0], seed_right[0], t_right[0]) =
-        SplitDpfSeed(seeds_working[0]);
-    std::tie(seed_left[1], t_left[1], seed_right[1], t_right[1]) =
-        SplitDpfSeed(seeds_working[1]);
-
-    const auto keep_seed = alpha_bit ? seed_right : seed_left;
-    const auto lose_seed = alpha_bit ? seed_left : seed_right;
-    const auto t_keep = alpha_bit ? t_right : t_left;
-
-    uint128_t cw_seed = lose_seed[0] ^ lose_seed[1];
-    bool cw_t_left;
-    bool cw_t_right;
-
-    cw_t_left = t_left[0] ^ t_left[1] ^ alpha_bit ^ 1;
-    cw_t_right = t_right[0] ^ t_right[1] ^ alpha_bit;
-    const auto& cw_t_keep = alpha_bit ? cw_t_right : cw_t_left;
-
-    // get the seeds_working and t_working for next level
-    seeds_working[0] = t_working[0] ? keep_seed[0] ^ cw_seed : keep_seed[0];
-    seeds_working[1] = t_working[1] ? keep_seed[1] ^ cw_seed : keep_seed[1];
-
-    t_working[0] = t_keep[0] ^ t_working[0] * cw_t_keep;
-    t_working[1] = t_keep[1] ^ t_working[1] * cw_t_keep;
-
-    first_key.cws_vec[i].SetSeed(cw_seed);
-    first_key.cws_vec[i].SetTLeft(cw_t_left);
-    first_key.cws_vec[i].SetTRight(cw_t_right);
+  YASL_ENFORCE(this->ss_bitnum_ <= 128);
+  const size_t num = alphas.size();
+  const size_t vector_size = GetVectorSize();
+  static auto& gens = GetCounter("yasl_dpf_gen_keys_total");
+  static auto& time = GetHistogram("yasl_dpf_gen_us");
+  ScopedTimer timer(&time);
+  gens.Add(num);
+  YASL_ENFORCE(betas.size() == num * vector_size && first_mks.size() == num &&
+                   second_mks.size() == num && first_keys.size() == num &&
+                   second_keys.size() == num,
+               "size mismatch, {} alphas, {} betas of vector size {}", num,
+               betas.size(), vector_size);
+  for (const auto& alpha : alphas) {
+    YASL_ENFORCE(this->in_bitnum_ > log(alpha));
   }
 
-  // Expand final seed_working
-  // get the final correlation words (has the same length as seeds)
-  // notice the notation is `somewhat' incorrect in the original paper
-  //
-  // First, we get the Convert(S_0 ^ key_block) and Convert(S_1 ^ key_block)
-  //
-  DpfOutStore prg0 = DpfPRG(seeds_working[0]);
-  DpfOutStore prg1 = DpfPRG(seeds_working[1]);
-
-  // if enable_evalall, we have only one last_cw_vec, otherwise, we
-  // have multiple last_cw_vec
-  YASL_ENFORCE(first_key.last_cw_vec.empty());
-  YASL_ENFORCE(second_key.last_cw_vec.empty());
-
-  if (!enable_evalall) {
-    first_key.last_cw_vec.push_back(TruncateSs(beta + ReverseSs(prg0) + prg1));
-    if (t_working[1]) {
-      first_key.last_cw_vec[0] = ReverseSs(first_key.last_cw_vec[0]);
-    }
-    second_key.cws_vec = first_key.cws_vec;
-    second_key.last_cw_vec.push_back(first_key.last_cw_vec[0]);
-  } else {
-    first_key.EnableEvalAll();
-    second_key.EnableEvalAll();
-
-    uint32_t alpha_pos_term_level = alpha >> term_level;
-    uint32_t expand_num = static_cast<uint32_t>(1)
-                          << (GetInBitNum() - term_level);
-
-    for (uint32_t i = 0; i < expand_num; i++) {
-      DpfOutStore last_cw = 0;
-      if (i == alpha_pos_term_level) {
-        last_cw = TruncateSs(beta + ReverseSs(prg0) + TruncateSs(prg1));
-      } else {
-        last_cw = TruncateSs(ReverseSs(prg0) + TruncateSs(prg1));
+  // enable the early termination
+  const uint32_t term_level = GetTerminateLevel(enable_evalall);
+  // if enable_evalall, each key has expand_num last cws per output, otherwise,
+  // one
+  const uint32_t expand_num =
+      enable_evalall ? static_cast<uint32_t>(1) << (GetInBitNum() - term_level)
+                     : 1;
+
+  // the seeds of the keys of a task are split together, seeds of the two
+  // parties of key k are at 2k and 2k + 1.
+  constexpr size_t kKeysPerTask = kExpandChunk / 2;
+  parallel_for(0, num, kKeysPerTask, [&](int64_t begin, int64_t end) {
+    std::array<uint128_t, kExpandChunk> seeds_working;
+    std::array<bool, kExpandChunk> t_working;
+    std::array<uint128_t, kExpandChunk * 3> prgs;
+
+    for (int64_t first = begin; first < end; first += kKeysPerTask) {
+      const size_t n = std::min<int64_t>(kKeysPerTask, end - first);
+      auto* first_key = &first_keys[first];
+      auto* second_key = &second_keys[first];
+
+      // set up the return keys
+      for (size_t k = 0; k < n; k++) {
+        first_key[k] = DpfKey(false, GetInBitNum(), GetSsBitNum(), sec_param_,
+                              first_mks[first + k]);
+        second_key[k] = DpfKey(true, GetInBitNum(), GetSsBitNum(), sec_param_,
+                               second_mks[first + k]);
+        first_key[k].SetPrgType(prg_type_);
+        second_key[k].SetPrgType(prg_type_);
+        first_key[k].cws_vec.resize(term_level);
+        seeds_working[2 * k] = first_mks[first + k];
+        seeds_working[2 * k + 1] = second_mks[first + k];
+        t_working[2 * k] = false;     // default by definition
+        t_working[2 * k + 1] = true;  // default by definition
       }
 
-      if (t_working[1]) {
-        first_key.last_cw_vec.push_back(ReverseSs(last_cw));
-      } else {
-        first_key.last_cw_vec.push_back(last_cw);
+      for (uint32_t i = 0; i < term_level; i++) {
+        // Use working seeds to generate seeds
+        // Note: this is the most time-consuming process
+        BatchPRG<3>(prg_type_, seeds_working.data(), 2 * n, prgs.data());
+
+        for (size_t k = 0; k < n; k++) {
+          const bool alpha_bit = (GetBit(alphas[first + k], i) != 0U);
+          const auto* prg = &prgs[6 * k];
+          std::array<uint128_t, 2> seed_left = {prg[0], prg[3]};
+          std::array<uint128_t, 2> seed_right = {prg[1], prg[4]};
+          std::array<bool, 2> t_left = {
+              static_cast<bool>(prg[2] >> 1 & 1),
+              static_cast<bool>(prg[5] >> 1 & 1)};
+          std::array<bool, 2> t_right = {
+              static_cast<bool>(prg[2] >> 2 & 1),
+              static_cast<bool>(prg[5] >> 2 & 1)};
+
+          const auto& keep_seed = alpha_bit ? seed_right : seed_left;
+          const auto& lose_seed = alpha_bit ? seed_left : seed_right;
+          const auto& t_keep = alpha_bit ? t_right : t_left;
+
+          uint128_t cw_seed = lose_seed[0] ^ lose_seed[1];
+          bool cw_t_left = t_left[0] ^ t_left[1] ^ alpha_bit ^ 1;
+          bool cw_t_right = t_right[0] ^ t_right[1] ^ alpha_bit;
+          const auto& cw_t_keep = alpha_bit ? cw_t_right : cw_t_left;
+
+          // get the seeds_working and t_working for next level
+          for (size_t j = 0; j < 2; j++) {
+            auto& seed = seeds_working[2 * k + j];
+            auto& t = t_working[2 * k + j];
+            seed = t ? keep_seed[j] ^ cw_seed : keep_seed[j];
+            t = t_keep[j] ^ (t && cw_t_keep);
+          }
+
+          first_key[k].cws_vec[i].SetSeed(cw_seed);
+          first_key[k].cws_vec[i].SetTLeft(cw_t_left);
+          first_key[k].cws_vec[i].SetTRight(cw_t_right);
+        }
       }
 
-      second_key.cws_vec = first_key.cws_vec;
-      second_key.last_cw_vec.push_back(first_key.last_cw_vec[i]);
+      // Expand final seed_working
+      // get the final correlation words (has the same length as seeds)
+      // notice the notation is `somewhat' incorrect in the original paper
+      //
+      // First, we get the Convert(S_0 ^ key_block) and Convert(S_1 ^
+      // key_block), then convert again for the following last cws. Last cw
+      // w is output w % vector_size of the leaf's inputs w / vector_size.
+      BatchPRG<1>(prg_type_, seeds_working.data(), 2 * n, prgs.data());
+      for (uint32_t w = 0; w < expand_num * vector_size; w++) {
+        if (w > 0) {
+          BatchPRG<1>(prg_type_, prgs.data(), 2 * n, prgs.data());
+        }
+        const uint32_t e = w / vector_size;
+        for (size_t k = 0; k < n; k++) {
+          const DpfOutStore prg0 = prgs[2 * k];
+          const DpfOutStore prg1 = prgs[2 * k + 1];
+          DpfOutStore last_cw = TruncateSs(ReverseSs(prg0) + TruncateSs(prg1));
+          if (!enable_evalall || e == alphas[first + k] >> term_level) {
+            const auto& beta =
+                betas[(first + k) * vector_size + w % vector_size];
+            last_cw = TruncateSs(beta + last_cw);
+          }
+          if (t_working[2 * k + 1]) {
+            last_cw = ReverseSs(last_cw);
+          }
+          first_key[k].last_cw_vec.push_back(last_cw);
+        }
+      }
 
-      prg0 = DpfPRG(prg0);
-      prg1 = DpfPRG(prg1);
+      for (size_t k = 0; k < n; k++) {
+        if (enable_evalall) {
+          first_key[k].EnableEvalAll();
+          second_key[k].EnableEvalAll();
+        }
+        second_key[k].cws_vec = first_key[k].cws_vec;
+        second_key[k].last_cw_vec = first_key[k].last_cw_vec;
+      }
     }
-  }
-  // return {std::move(first_key), std::move(second_key)};
-}  // namespace flcrypto
+  });
+}
 
 DpfOutStore DpfContext::Eval(DpfKey& key, DpfInStore x) {
-  YASL_ENFORCE(this->in_bitnum_ > log(x));
-  YASL_ENFORCE(key.enable_evalall == false);
+  YASL_ENFORCE(GetVectorSize() == 1, "vector size {}, use EvalVector",
+               GetVectorSize());
+  return EvalMultiKeyImpl(absl::MakeConstSpan(&key, 1), x)[0];
+}
+
+DpfOutStore DpfContext::Eval(const DpfKeyView& key, DpfInStore x) {
+  YASL_ENFORCE(GetVectorSize() == 1, "vector size {}, use EvalVector",
+               GetVectorSize());
+  return EvalMultiKeyImpl(absl::MakeConstSpan(&key, 1), x)[0];
+}
+
+std::vector<DpfOutStore> DpfContext::EvalVector(const DpfKey& key,
+                                                DpfInStore x) {
+  return EvalMultiKeyImpl(absl::MakeConstSpan(&key, 1), x);
+}
+
+std::vector<DpfOutStore> DpfContext::EvalVector(const DpfKeyView& key,
+                                                DpfInStore x) {
+  return EvalMultiKeyImpl(absl::MakeConstSpan(&key, 1), x);
+}
+
+std::vector<DpfOutStore> DpfContext::EvalBatch(
+    const DpfKey& key, absl::Span<const DpfInStore> inputs) {
+  return EvalBatchImpl(key, inputs);
+}
+
+std::vector<DpfOutStore> DpfContext::EvalBatch(
+    const DpfKeyView& key, absl::Span<const DpfInStore> inputs) {
+  return EvalBatchImpl(key, inputs);
+}
+
+std::vector<DpfOutStore> DpfContext::EvalMultiKey(absl::Span<const DpfKey> keys,
+                                                  DpfInStore x) {
+  return EvalMultiKeyImpl(keys, x);
+}
+
+std::vector<DpfOutStore> DpfContext::EvalMultiKey(
+    absl::Span<const DpfKeyView> keys, DpfInStore x) {
+  return EvalMultiKeyImpl(keys, x);
+}
+
+std::vector<DpfOutStore> DpfContext::EvalAll(DpfKey& key) {
+  return EvalAllImpl(key);
+}
+
+std::vector<DpfOutStore> DpfContext::EvalAll(const DpfKeyView& key) {
+  return EvalAllImpl(key);
+}
+
+void DpfContext::EvalAll(DpfKey& key, size_t chunk_size,
+                         const EvalAllCallback& callback) {
+  EvalAllImpl(key, chunk_size, callback);
+}
+
+void DpfContext::EvalAll(const DpfKeyView& key, size_t chunk_size,
+                         const EvalAllCallback& callback) {
+  EvalAllImpl(key, chunk_size, callback);
+}
 
-  uint128_t seed_working = key.GetSeed();  // the initial value
-  bool t_working = key.GetRank();          // the initial value
+template <typename Key>
+std::vector<DpfOutStore> DpfContext::EvalBatchImpl(
+    const Key& key, absl::Span<const DpfInStore> inputs) {
+  const size_t vector_size = GetVectorSize();
+  EnforceKeyShape(key, prg_type_, false, GetInBitNum(), vector_size);
+  for (const auto& x : inputs) {
+    YASL_ENFORCE(this->in_bitnum_ > log(x));
+  }
+  const size_t num = inputs.size();
+  static auto& evals = GetCounter("yasl_dpf_evals_total");
+  evals.Add(num);
+  std::vector<DpfOutStore> result(num * vector_size);
+  if (num == 0) {
+    return result;
+  }
 
+  // sort the inputs by their bits from the lowest one, which is the order of
+  // the leaves, so the inputs under a node of any level are consecutive.
+  std::vector<std::pair<uint64_t, size_t>> order(num);
+  for (size_t j = 0; j < num; j++) {
+    order[j] = {ReverseBits(static_cast<uint64_t>(inputs[j])), j};
+  }
+  std::sort(order.begin(), order.end());
+
+  // the nodes on the paths of the inputs, level by level. node k covers the
+  // inputs order[los[k]], ..., order[los[k + 1] - 1].
+  std::vector<uint128_t> seeds = {key.GetSeed()};
+  std::vector<uint8_t> ts = {key.GetRank()};
+  std::vector<size_t> los = {0, num};
+  std::vector<uint128_t> children_seeds;
+  std::vector<uint8_t> children_ts;
   for (uint32_t i = 0; i < GetInBitNum(); i++) {
-    const auto cw_seed = key.cws_vec[i].GetSeed();
-    const auto cw_t_left = key.cws_vec[i].GetTLeft();
-    const auto cw_t_right = key.cws_vec[i].GetTRight();
-
-    uint128_t seed_left;
-    uint128_t seed_right;
-    bool t_left;
-    bool t_right;
-
-    std::tie(seed_left, t_left, seed_right, t_right) =
-        SplitDpfSeed(seed_working);
-
-    seed_left = t_working ? seed_left ^ cw_seed : seed_left;
-    t_left = t_left ^ (t_working * cw_t_left);
-    seed_right = t_working ? seed_right ^ cw_seed : seed_right;
-    t_right = t_right ^ (t_working * cw_t_right);
-
-    if (GetBit(x, i) != 0U) {
-      seed_working = seed_right;
-      t_working = t_right;
-    } else {
-      seed_working = seed_left;
-      t_working = t_left;
+    const size_t n = seeds.size();
+    children_seeds.resize(2 * n);
+    children_ts.resize(2 * n);
+    ExpandNodes(prg_type_, key.GetCW(i), seeds.data(), ts.data(), n,
+                children_seeds.data(), children_ts.data(), &children_seeds[n],
+                &children_ts[n]);
+
+    // keep the children having inputs, the left ones come first.
+    seeds.clear();
+    ts.clear();
+    std::vector<size_t> next_los;
+    for (size_t k = 0; k < n; k++) {
+      const auto begin = order.begin() + los[k];
+      const auto end = order.begin() + los[k + 1];
+      const auto mid = std::partition_point(begin, end, [&](const auto& o) {
+        return GetBit(inputs[o.second], i) == 0;
+      });
+      if (begin != mid) {
+        seeds.push_back(children_seeds[k]);
+        ts.push_back(children_ts[k]);
+        next_los.push_back(begin - order.begin());
+      }
+      if (mid != end) {
+        seeds.push_back(children_seeds[n + k]);
+        ts.push_back(children_ts[n + k]);
+        next_los.push_back(mid - order.begin());
+      }
     }
+    next_los.push_back(num);
+    los = std::move(next_los);
   }
 
-  DpfOutStore prg = TruncateSs(DpfPRG(seed_working));
-
-  DpfOutStore result = key.GetRank()
-                           ? ReverseSs(prg + t_working * key.last_cw_vec[0])
-                           : TruncateSs(prg + t_working * key.last_cw_vec[0]);
-
-  return TruncateSs(result);
-}
-
-void DpfContext::Traverse(DpfKey& key, std::vector<DpfOutStore>& result,
-                          size_t current_level, uint64_t current_pos,
-                          uint128_t seed_working, bool t_working,
-                          size_t term_level) {
-  if (current_level < term_level) {
-    uint128_t seed_left;
-    uint128_t seed_right;
-    bool t_left;
-    bool t_right;
-    const auto cw_seed = key.cws_vec[current_level].GetSeed();
-    const auto cw_t_left = key.cws_vec[current_level].GetTLeft();
-    const auto cw_t_right = key.cws_vec[current_level].GetTRight();
-
-    std::tie(seed_left, t_left, seed_right, t_right) =
-        SplitDpfSeed(seed_working);
-
-    seed_left = t_working ? seed_left ^ cw_seed : seed_left;
-    t_left = t_left ^ (t_working * cw_t_left);
-    seed_right = t_working ? seed_right ^ cw_seed : seed_right;
-    t_right = t_right ^ (t_working * cw_t_right);
-
-    uint64_t next_left_pos = current_pos;
-    uint64_t next_right_pos = (1ULL << current_level) + current_pos;
-
-    Traverse(key, result, current_level + 1, next_left_pos, seed_left, t_left,
-             term_level);
-    Traverse(key, result, current_level + 1, next_right_pos, seed_right,
-             t_right, term_level);
-
-  } else {
-    DpfOutStore prg = DpfPRG(seed_working);
-    uint32_t expand_num = static_cast<uint32_t>(1)
-                          << (GetInBitNum() - term_level);
-
-    for (uint32_t i = 0; i < expand_num; i++) {
-      result[current_pos + (i << term_level)] =
-          key.GetRank()
-              ? ReverseSs(TruncateSs(prg) + t_working * key.last_cw_vec[i])
-              : TruncateSs(TruncateSs(prg) + t_working * key.last_cw_vec[i]);
-      prg = DpfPRG(prg);
+  const DpfOutStore ss_mask = GetSsMask();
+  for (size_t w = 0; w < vector_size; w++) {
+    BatchPRG<1>(prg_type_, seeds.data(), seeds.size(), seeds.data());
+    for (size_t k = 0; k < seeds.size(); k++) {
+      const auto output = LeafOutput(key, seeds[k], ts[k], w, ss_mask);
+      for (size_t j = los[k]; j < los[k + 1]; j++) {
+        result[order[j].second * vector_size + w] = output;
+      }
     }
   }
+  return result;
 }
 
-std::vector<DpfOutStore> DpfContext::EvalAll(DpfKey& key) {
-  YASL_ENFORCE(key.enable_evalall == true);
+template <typename Key>
+std::vector<DpfOutStore> DpfContext::EvalMultiKeyImpl(
+    absl::Span<const Key> keys, DpfInStore x) {
+  YASL_ENFORCE(this->in_bitnum_ > log(x));
+  static auto& evals = GetCounter("yasl_dpf_evals_total");
+  evals.Add(keys.size());
+  const size_t vector_size = GetVectorSize();
+  for (const auto& key : keys) {
+    EnforceKeyShape(key, prg_type_, false, GetInBitNum(), vector_size);
+  }
+  std::vector<DpfOutStore> result(keys.size() * vector_size);
+
+  // the keys walk the same path, a chunk of keys goes down a level by one
+  // batched split.
+  const DpfOutStore ss_mask = GetSsMask();
+  parallel_for(0, keys.size(), kExpandChunk, [&](int64_t begin, int64_t end) {
+    std::array<uint128_t, kExpandChunk> seeds_working;
+    std::array<bool, kExpandChunk> t_working;
+    std::array<uint128_t, kExpandChunk * 3> prgs;
+
+    for (int64_t first = begin; first < end; first += kExpandChunk) {
+      const size_t n = std::min<int64_t>(kExpandChunk, end - first);
+      for (size_t k = 0; k < n; k++) {
+        seeds_working[k] = keys[first + k].GetSeed();  // the initial value
+        t_working[k] = keys[first + k].GetRank();      // the initial value
+      }
 
-  uint128_t seed_working = key.GetSeed();  // the initial value
-  bool t_working = key.GetRank();          // the initial value
-  uint32_t term_level = GetTerminateLevel(true);
+      for (uint32_t i = 0; i < GetInBitNum(); i++) {
+        const bool bit = GetBit(x, i) != 0U;
+        BatchPRG<3>(prg_type_, seeds_working.data(), n, prgs.data());
+        for (size_t k = 0; k < n; k++) {
+          const auto& cw = keys[first + k].GetCW(i);
+          const bool cw_t = bit ? cw.GetTRight() : cw.GetTLeft();
+          // the child of bit.
+          const uint128_t seed = prgs[3 * k + bit];
+          const bool t = (prgs[3 * k + 2] >> (1 + bit)) & 1;
+          seeds_working[k] = t_working[k] ? seed ^ cw.GetSeed() : seed;
+          t_working[k] = t ^ (t_working[k] && cw_t);
+        }
+      }
+
+      BatchPRG<1>(prg_type_, seeds_working.data(), n, prgs.data());
+      for (size_t w = 0; w < vector_size; w++) {
+        if (w > 0) {
+          BatchPRG<1>(prg_type_, prgs.data(), n, prgs.data());
+        }
+        for (size_t k = 0; k < n; k++) {
+          result[(first + k) * vector_size + w] =
+              LeafOutput(keys[first + k], prgs[k], t_working[k], w, ss_mask);
+        }
+      }
+    }
+  });
+  return result;
+}
+
+template <typename Key>
+std::vector<DpfOutStore> DpfContext::EvalAllImpl(const Key& key) {
+  static auto& evalalls = GetCounter("yasl_dpf_evalall_total");
+  static auto& time = GetHistogram("yasl_dpf_evalall_us");
+  ScopedTimer timer(&time);
+  evalalls.Add();
+  const size_t term_level = GetTerminateLevel(true);
 
   YASL_ENFORCE(GetInBitNum() <= 25);  // only support in_bin_num < 25
+  const size_t vector_size = GetVectorSize();
+  const uint32_t expand_num = static_cast<uint32_t>(1)
+                              << (GetInBitNum() - term_level);
+  EnforceKeyShape(key, prg_type_, true, term_level, expand_num * vector_size);
 
   uint64_t num = 1ULL << GetInBitNum();
-  std::vector<DpfOutStore> result(num);
+  std::vector<DpfOutStore> result(num * vector_size);
+
+  // the tree is expanded level by level. node p of level l is the prefix of
+  // the inputs whose lower l bits are p, its seed is kept in seeds[p] and its
+  // children go to p and p + 2^l, so the frontier grows in place. seeds is
+  // result itself for a vector size of 1, then the outputs of leaf p go to
+  // p + (e << term_level) and overwrite no other seed.
+  HugePageVector<uint128_t> tree;
+  uint128_t* seeds = result.data();
+  if (vector_size > 1) {
+    tree.resize(1ULL << term_level);
+    seeds = tree.data();
+  }
+  HugePageVector<uint8_t> ts(1ULL << term_level);
+  seeds[0] = key.GetSeed();
+  ts[0] = key.GetRank();
+
+  // expands nodes [begin, begin + n) of `level` into their children.
+  auto expand = [&](size_t level, uint64_t begin, uint64_t n) {
+    const uint64_t width = 1ULL << level;
+    ExpandNodes(prg_type_, key.GetCW(level), &seeds[begin], &ts[begin], n,
+                &seeds[begin], &ts[begin], &seeds[begin + width],
+                &ts[begin + width]);
+  };
+
+  // leaf p yields the outputs at p + (e << term_level) by chained converts,
+  // the vector of an input is consecutive.
+  const DpfOutStore ss_mask = GetSsMask();
+  auto convert = [&](uint64_t begin, uint64_t n) {
+    std::array<uint128_t, kExpandChunk> prgs;
+    for (uint64_t offset = 0; offset < n; offset += kExpandChunk) {
+      const size_t chunk = std::min<uint64_t>(kExpandChunk, n - offset);
+      std::copy_n(&seeds[begin + offset], chunk, prgs.data());
+      for (uint32_t w = 0; w < expand_num * vector_size; w++) {
+        BatchPRG<1>(prg_type_, prgs.data(), chunk, prgs.data());
+        const uint64_t e = w / vector_size;
+        for (size_t i = 0; i < chunk; ++i) {
+          const uint64_t p = begin + offset + i;
+          result[(p + (e << term_level)) * vector_size + w % vector_size] =
+              LeafOutput(key, prgs[i], ts[p], w, ss_mask);
+        }
+      }
+    }
+  };
+
+  // the top levels are expanded by this thread, then the subtrees rooted at
+  // `root_level` are split among workers. the nodes of the roots in
+  // [begin, end) are those whose lower root_level bits are in [begin, end),
+  // so workers write disjoint parts of result and ts.
+  const size_t root_level = std::min(evalall_parallel_level_, term_level);
+  for (size_t level = 0; level < root_level; ++level) {
+    expand(level, 0, 1ULL << level);
+  }
+  const uint64_t num_subtree_nodes = 1ULL << (term_level - root_level);
+  parallel_for(0, 1LL << root_level, kAesBatch,
+               [&](int64_t begin, int64_t end) {
+                 for (size_t level = root_level; level < term_level; ++level) {
+                   const uint64_t num_nodes = 1ULL << (level - root_level);
+                   for (uint64_t j = 0; j < num_nodes; ++j) {
+                     expand(level, (j << root_level) + begin, end - begin);
+                   }
+                 }
+                 for (uint64_t j = 0; j < num_subtree_nodes; ++j) {
+                   convert((j << root_level) + begin, end - begin);
+                 }
+               });
 
-  uint64_t current_pos = 0;
-  uint64_t current_level = 0;  // we start from the top level
+  return result;
+}
 
-  Traverse(key, result, current_level, current_pos, seed_working, t_working,
-           term_level);
+template <typename T>
+void DpfContext::EvalAll(DpfKey& key, absl::Span<T> out) {
+  static auto& evalalls = GetCounter("yasl_dpf_evalall_total");
+  static auto& time = GetHistogram("yasl_dpf_evalall_us");
+  ScopedTimer timer(&time);
+  evalalls.Add();
+  YASL_ENFORCE(GetSsBitNum() <= sizeof(T) * 8,
+               "ss_bitnum {} does not fit in {} bytes", GetSsBitNum(),
+               sizeof(T));
+  YASL_ENFORCE(GetInBitNum() < 64);
+  YASL_ENFORCE(GetVectorSize() == 1);
+  const size_t term_level = GetTerminateLevel(true);
+  EnforceKeyShape(key, prg_type_, true, term_level,
+                  1ULL << (GetInBitNum() - term_level));
+  YASL_ENFORCE_EQ(out.size(), 1ULL << GetInBitNum());
+
+  // frontiers of the walker are split among threads, each of them yields
+  // disjoint chunks of out.
+  constexpr size_t kChunkBitNum = 8;
+  constexpr int64_t kGrainSize = 16;
+  DpfTreeWalker<DpfKey> walker(key, prg_type_, term_level,
+                               std::min(kChunkBitNum, GetInBitNum()),
+                               GetSsMask());
+  parallel_for(0, walker.NumFrontiers(), kGrainSize,
+               [&](int64_t begin, int64_t end) {
+                 walker.Walk(begin, end,
+                             [&](uint64_t first,
+                                 absl::Span<const uint64_t> outputs) {
+                               std::copy(outputs.begin(), outputs.end(),
+                                         out.begin() + first);
+                             });
+               });
+}
 
-  return result;
+template void DpfContext::EvalAll(DpfKey& key, absl::Span<uint8_t> out);
+template void DpfContext::EvalAll(DpfKey& key, absl::Span<uint16_t> out);
+template void DpfContext::EvalAll(DpfKey& key, absl::Span<uint32_t> out);
+template void DpfContext::EvalAll(DpfKey& key, absl::Span<uint64_t> out);
+
+template <typename Key>
+void DpfContext::EvalAllImpl(const Key& key, size_t chunk_size,
+                             const EvalAllCallback& callback) {
+  static auto& evalalls = GetCounter("yasl_dpf_evalall_total");
+  static auto& time = GetHistogram("yasl_dpf_evalall_us");
+  ScopedTimer timer(&time);
+  evalalls.Add();
+  YASL_ENFORCE(GetInBitNum() < 64);
+  YASL_ENFORCE(GetVectorSize() == 1);
+  YASL_ENFORCE(GetSsBitNum() <= 64, "ss_bitnum {} does not fit in uint64_t",
+               GetSsBitNum());
+  const size_t term_level = GetTerminateLevel(true);
+  EnforceKeyShape(key, prg_type_, true, term_level,
+                  1ULL << (GetInBitNum() - term_level));
+  YASL_ENFORCE(absl::has_single_bit(chunk_size),
+               "chunk_size {} is not a power of 2", chunk_size);
+  const size_t chunk_bitnum = absl::countr_zero(chunk_size);
+  YASL_ENFORCE(chunk_bitnum <= GetInBitNum(),
+               "chunk_size {} exceeds the domain", chunk_size);
+
+  DpfTreeWalker<Key> walker(key, prg_type_, term_level, chunk_bitnum,
+                            GetSsMask());
+  walker.Walk(0, walker.NumFrontiers(), callback);
 }
 
 std::string DpfKey::Serialize() const {
@@ -315,6 +763,7 @@ std::string DpfKey::Serialize() const {
   proto.set_in_bitnum(in_bitnum_);
   proto.set_ss_bitnum(ss_bitnum_);
   proto.set_sec_param(sec_param_);
+  proto.set_prg_type(static_cast<uint32_t>(prg_type_));
 
   auto i128_parts = DecomposeUInt128(mseed_);
   proto.mutable_mseed()->set_hi(i128_parts.first);
@@ -345,10 +794,127 @@ void DpfKey::Deserialize(const std::string& s) {
   in_bitnum_ = proto.in_bitnum();
   ss_bitnum_ = proto.ss_bitnum();
   sec_param_ = proto.sec_param();
+  YASL_ENFORCE(proto.prg_type() <= static_cast<uint32_t>(DpfPrgType::kSm4),
+               "unknown dpf prg {}", proto.prg_type());
+  prg_type_ = static_cast<DpfPrgType>(proto.prg_type());
 
   mseed_ = MakeUint128(proto.mseed().hi(), proto.mseed().lo());
 
   SPDLOG_DEBUG("Got seed {}", GetSeed());
 }
 
+Buffer DpfKey::SerializeCompact() const {
+  YASL_ENFORCE(in_bitnum_ <= 64 && ss_bitnum_ <= 128);
+  YASL_ENFORCE(cws_vec.size() <= std::numeric_limits<uint8_t>::max());
+  YASL_ENFORCE(sec_param_ <= std::numeric_limits<uint16_t>::max());
+  const size_t num_cws = cws_vec.size();
+  const size_t last_cw_bytes = LastCWBytes(ss_bitnum_);
+  const size_t size = DpfKeyView::kHeaderSize + num_cws * sizeof(uint128_t) +
+                      TBitsBytes(num_cws) +
+                      last_cw_vec.size() * last_cw_bytes;
+  Buffer buf(static_cast<int64_t>(size));
+  auto* p = buf.data<uint8_t>();
+  std::memset(p, 0, size);
+
+  p[0] = DpfKeyView::kVersion;
+  p[1] = static_cast<uint8_t>(rank_) | (enable_evalall << 1);
+  p[2] = static_cast<uint8_t>(in_bitnum_);
+  p[3] = static_cast<uint8_t>(ss_bitnum_);
+  const auto sec_param = static_cast<uint16_t>(sec_param_);
+  std::memcpy(p + 4, &sec_param, sizeof(sec_param));
+  p[6] = static_cast<uint8_t>(num_cws);
+  p[7] = static_cast<uint8_t>(prg_type_);
+  const auto num_last_cws = static_cast<uint32_t>(last_cw_vec.size());
+  std::memcpy(p + 8, &num_last_cws, sizeof(num_last_cws));
+  std::memcpy(p + 12, &mseed_, sizeof(mseed_));
+  p += DpfKeyView::kHeaderSize;
+
+  for (const auto& cw : cws_vec) {
+    const uint128_t seed = cw.GetSeed();
+    std::memcpy(p, &seed, sizeof(seed));
+    p += sizeof(seed);
+  }
+  for (size_t i = 0; i < num_cws; i++) {
+    p[i / 4] |= (cws_vec[i].GetTStore() & 3) << (2 * (i % 4));
+  }
+  p += TBitsBytes(num_cws);
+  for (const auto& last_cw : last_cw_vec) {
+    // truncated to ss_bitnum, which Gen has done.
+    std::memcpy(p, &last_cw, last_cw_bytes);
+    p += last_cw_bytes;
+  }
+  return buf;
+}
+
+void DpfKey::DeserializeCompact(ByteContainerView data) {
+  *this = DpfKeyView(data).ToKey();
+}
+
+DpfKeyView::DpfKeyView(ByteContainerView data) : data_(data.data()) {
+  YASL_ENFORCE(data.size() >= kHeaderSize, "dpf key of {} bytes is too short",
+               data.size());
+  YASL_ENFORCE(data_[0] == kVersion, "unsupported dpf key version {}",
+               data_[0]);
+  flags_ = data_[1];
+  in_bitnum_ = data_[2];
+  ss_bitnum_ = data_[3];
+  uint16_t sec_param;
+  std::memcpy(&sec_param, data_ + 4, sizeof(sec_param));
+  sec_param_ = sec_param;
+  num_cws_ = data_[6];
+  YASL_ENFORCE(data_[7] <= static_cast<uint8_t>(DpfPrgType::kSm4),
+               "unknown dpf prg {}", data_[7]);
+  prg_type_ = static_cast<DpfPrgType>(data_[7]);
+  uint32_t num_last_cws;
+  std::memcpy(&num_last_cws, data_ + 8, sizeof(num_last_cws));
+  num_last_cws_ = num_last_cws;
+  YASL_ENFORCE(flags_ <= 3 && in_bitnum_ <= 64 && ss_bitnum_ <= 128,
+               "malformed dpf key header");
+  last_cw_bytes_ = LastCWBytes(ss_bitnum_);
+
+  seeds_ = data_ + kHeaderSize;
+  t_bits_ = seeds_ + num_cws_ * sizeof(uint128_t);
+  last_cws_ = t_bits_ + TBitsBytes(num_cws_);
+  size_ = (last_cws_ - data_) + num_last_cws_ * last_cw_bytes_;
+  // trailing bytes are left to the caller, e.g. the next key.
+  YASL_ENFORCE(data.size() >= size_, "dpf key of {} bytes, expect {}",
+               data.size(), size_);
+}
+
+uint128_t DpfKeyView::GetSeed() const {
+  uint128_t seed;
+  std::memcpy(&seed, data_ + 12, sizeof(seed));
+  return seed;
+}
+
+DpfCW DpfKeyView::GetCW(size_t level) const {
+  uint128_t seed;
+  std::memcpy(&seed, seeds_ + level * sizeof(uint128_t), sizeof(seed));
+  const auto t_store = (t_bits_[level / 4] >> (2 * (level % 4))) & 3;
+  return {seed, static_cast<uint8_t>(t_store)};
+}
+
+DpfOutStore DpfKeyView::GetLastCW(size_t i) const {
+  uint128_t last_cw = 0;
+  std::memcpy(&last_cw, last_cws_ + i * last_cw_bytes_, last_cw_bytes_);
+  return last_cw;
+}
+
+DpfKey DpfKeyView::ToKey() const {
+  DpfKey key(GetRank(), in_bitnum_, ss_bitnum_, sec_param_, GetSeed());
+  key.SetPrgType(prg_type_);
+  if (IsEvalAllEnabled()) {
+    key.EnableEvalAll();
+  }
+  key.cws_vec.reserve(num_cws_);
+  for (size_t i = 0; i < num_cws_; i++) {
+    key.cws_vec.push_back(GetCW(i));
+  }
+  key.last_cw_vec.reserve(num_last_cws_);
+  for (size_t i = 0; i < num_last_cws_; i++) {
+    key.last_cw_vec.push_back(GetLastCW(i));
+  }
+  return key;
+}
+
 }  // namespace yasl::mpctools
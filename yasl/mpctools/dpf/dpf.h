@@ -12,10 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <random>
 #include <thread>
@@ -23,6 +23,10 @@
 #include <type_traits>
 #include <vector>
 
+#include "absl/types/span.h"
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/byte_container_view.h"
 #include "yasl/base/exception.h"
 #include "yasl/base/int128.h"
 
@@ -39,10 +43,22 @@ namespace yasl::mpctools {
 // alpha : arbitrary length mapping input
 // beta  : 128bit mapping output
 // Note: result is A-share
+//
+// With a vector size of k, beta is k words and a point maps to k outputs. The
+// tree is the same, the seed of a leaf is converted k times in a chain and
+// there are k times the last cws.
 
 using DpfInStore = uint128_t;   // the input room
 using DpfOutStore = uint128_t;  // the secret sharing room
 
+// PRG expanding the seeds of the tree, the two keys of a pair are generated
+// and evaluated by the same one.
+enum class DpfPrgType : uint8_t {
+  kAes = 0,          // AES keyed by the seed in counter mode (default)
+  kFixedKeyAes = 1,  // fixed key AES in MMO mode, the fastest
+  kSm4 = 2,          // SM4 keyed by the seed in counter mode, GM compliant
+};
+
 struct DpfCW {
  public:
   DpfCW() = default;
@@ -96,15 +112,83 @@ class DpfKey {
 
   uint32_t GetSecParam() const { return sec_param_; }
 
+  DpfPrgType GetPrgType() const { return prg_type_; }
+  void SetPrgType(DpfPrgType prg_type) { prg_type_ = prg_type; }
+
+  bool IsEvalAllEnabled() const { return enable_evalall; }
+  size_t GetNumCWs() const { return cws_vec.size(); }
+  const DpfCW& GetCW(size_t level) const { return cws_vec[level]; }
+  size_t GetNumLastCWs() const { return last_cw_vec.size(); }
+  DpfOutStore GetLastCW(size_t i) const { return last_cw_vec[i]; }
+
   std::string Serialize() const;
   void Deserialize(const std::string& s);
 
+  // Compact binary format, see DpfKeyView. Much smaller and faster to parse
+  // than Serialize, which goes through protobuf.
+  Buffer SerializeCompact() const;
+  void DeserializeCompact(ByteContainerView data);
+
  private:
   bool rank_{};            // only support two parties (0/1), compulsory param
   size_t in_bitnum_ = 64;  // bit number (for point), default = 64
   size_t ss_bitnum_ = 64;  // bit number (for output value), default = 64
   uint32_t sec_param_ = 128;  // we assume 128 bit security (fixed)
   uint128_t mseed_ = 0;       // the master seed (the default is not secure)
+  DpfPrgType prg_type_ = DpfPrgType::kAes;
+};
+
+// Read-only view of a key in the compact format, it refers to the bytes
+// without copying them, so the bytes must outlive the view. DpfContext
+// evaluates views as keys.
+//
+// The format is little endian and versioned by its first byte:
+//   u8 version, u8 flags (bit 0 rank, bit 1 enable_evalall), u8 in_bitnum,
+//   u8 ss_bitnum, u16 sec_param, u8 number of cws, u8 DpfPrgType,
+//   u32 number of last cws, u128 master seed,
+//   u128 seed of each cw,
+//   t bits of the cws, 2 bits per level (t_left, t_right) packed from the
+//   lowest bit of each byte,
+//   last cws of ceil(ss_bitnum / 8) bytes each.
+class DpfKeyView {
+ public:
+  static constexpr uint8_t kVersion = 1;
+  static constexpr size_t kHeaderSize = 28;
+
+  explicit DpfKeyView(ByteContainerView data);
+
+  bool GetRank() const { return flags_ & 1; }
+  bool IsEvalAllEnabled() const { return (flags_ >> 1) & 1; }
+  uint128_t GetSeed() const;
+  size_t GetInBitNum() const { return in_bitnum_; }
+  size_t GetSsBitNum() const { return ss_bitnum_; }
+  uint32_t GetSecParam() const { return sec_param_; }
+  DpfPrgType GetPrgType() const { return prg_type_; }
+
+  size_t GetNumCWs() const { return num_cws_; }
+  DpfCW GetCW(size_t level) const;
+  size_t GetNumLastCWs() const { return num_last_cws_; }
+  DpfOutStore GetLastCW(size_t i) const;
+
+  // total bytes of the key, keys packed back to back are split by it.
+  size_t size() const { return size_; }
+
+  DpfKey ToKey() const;
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  uint8_t flags_;
+  size_t in_bitnum_;
+  size_t ss_bitnum_;
+  uint32_t sec_param_;
+  DpfPrgType prg_type_;
+  size_t num_cws_;
+  size_t num_last_cws_;
+  size_t last_cw_bytes_;
+  const uint8_t* seeds_;
+  const uint8_t* t_bits_;
+  const uint8_t* last_cws_;
 };
 
 class DpfContext {
@@ -124,11 +208,29 @@ class DpfContext {
   size_t GetInBitNum() const { return in_bitnum_; }
 
   void SetSsBitNum(size_t ss_bitnum) {
-    YASL_ENFORCE(ss_bitnum <= 64);
+    YASL_ENFORCE(ss_bitnum <= 128);
     ss_bitnum_ = ss_bitnum;
   }
   size_t GetSsBitNum() const { return ss_bitnum_; }
 
+  // number of outputs of a point, each of ss_bitnum bits.
+  void SetVectorSize(size_t vector_size) {
+    YASL_ENFORCE(vector_size > 0);
+    vector_size_ = vector_size;
+  }
+  size_t GetVectorSize() const { return vector_size_; }
+
+  // EvalAll splits the subtrees rooted at this level among threads, the
+  // levels above are expanded by the calling thread. 0 disables threading.
+  void SetEvalAllParallelLevel(size_t level) {
+    evalall_parallel_level_ = level;
+  }
+  size_t GetEvalAllParallelLevel() const { return evalall_parallel_level_; }
+
+  // Gen stamps the PRG into the keys, the keys evaluated must have the same.
+  void SetPrgType(DpfPrgType prg_type) { prg_type_ = prg_type; }
+  DpfPrgType GetPrgType() const { return prg_type_; }
+
   /////////////////////////////////////////////////////////////////////////////////////
   // Original key generation and evaluation
   /////////////////////////////////////////////////////////////////////////////////////
@@ -145,46 +247,137 @@ class DpfContext {
            DpfOutStore beta, uint128_t first_mk, uint128_t second_mk,
            bool enable_evalall = false);
 
+  // Gen of a vector of outputs, beta has vector size words.
+  std::pair<DpfKey, DpfKey> GenVector(DpfInStore alpha,
+                                      absl::Span<const DpfOutStore> beta,
+                                      uint128_t first_mk, uint128_t second_mk,
+                                      bool enable_evalall = false) {
+    DpfKey k0;
+    DpfKey k1;
+    GenBatch(absl::MakeConstSpan(&alpha, 1), beta,
+             absl::MakeConstSpan(&first_mk, 1),
+             absl::MakeConstSpan(&second_mk, 1), absl::MakeSpan(&k0, 1),
+             absl::MakeSpan(&k1, 1), enable_evalall);
+    return {std::move(k0), std::move(k1)};
+  }
+
+  // Generates the key pairs of many points in one pass, the PRG calls of
+  // the keys at each level are batched and the keys are spread among
+  // threads. Pair k equals Gen(alphas[k], betas[k], first_mks[k],
+  // second_mks[k], enable_evalall). With a vector size of m, betas has m
+  // words per point, those of point k are betas[k * m], ...
+  std::pair<std::vector<DpfKey>, std::vector<DpfKey>> GenBatch(
+      absl::Span<const DpfInStore> alphas, absl::Span<const DpfOutStore> betas,
+      absl::Span<const uint128_t> first_mks,
+      absl::Span<const uint128_t> second_mks, bool enable_evalall = false) {
+    std::vector<DpfKey> first_keys(alphas.size());
+    std::vector<DpfKey> second_keys(alphas.size());
+    GenBatch(alphas, betas, first_mks, second_mks, absl::MakeSpan(first_keys),
+             absl::MakeSpan(second_keys), enable_evalall);
+    return {std::move(first_keys), std::move(second_keys)};
+  }
+
+  void GenBatch(absl::Span<const DpfInStore> alphas,
+                absl::Span<const DpfOutStore> betas,
+                absl::Span<const uint128_t> first_mks,
+                absl::Span<const uint128_t> second_mks,
+                absl::Span<DpfKey> first_keys, absl::Span<DpfKey> second_keys,
+                bool enable_evalall = false);
+
+  // Eval of a vector size of 1.
   DpfOutStore Eval(DpfKey& key, DpfInStore input);
 
+  // the vector size outputs of `input`.
+  std::vector<DpfOutStore> EvalVector(const DpfKey& key, DpfInStore input);
+
+  // Evaluates many inputs on one key, result[j] = Eval(key, inputs[j]). The
+  // inputs are sorted so that each node on their paths is expanded once.
+  // With a vector size of m, the outputs of input j are result[j * m], ...
+  std::vector<DpfOutStore> EvalBatch(const DpfKey& key,
+                                     absl::Span<const DpfInStore> inputs);
+
+  // Evaluates one input on many keys, result[k] = Eval(keys[k], input). The
+  // PRG calls of the keys are batched at each level. With a vector size of m,
+  // the outputs of key k are result[k * m], ...
+  std::vector<DpfOutStore> EvalMultiKey(absl::Span<const DpfKey> keys,
+                                        DpfInStore input);
+
+  // With a vector size of m, the outputs of input x are result[x * m], ...
   std::vector<DpfOutStore> EvalAll(DpfKey& key);
 
+  // Full domain evaluation into `out` of 2^in_bitnum outputs, packed in T
+  // which holds ss_bitnum bits. T is uint8_t, uint16_t, uint32_t or uint64_t.
+  // The vector size is 1, so is it for the streaming one below.
+  template <typename T>
+  void EvalAll(DpfKey& key, absl::Span<T> out);
+
+  // Streaming full domain evaluation. `callback` gets the outputs of inputs
+  // [begin, begin + chunk_size) per call, chunks are not in input order. It
+  // runs in the calling thread and keeps O(chunk_size * in_bitnum) seeds, so
+  // the domain is not bounded by memory. chunk_size is a power of 2.
+  using EvalAllCallback =
+      std::function<void(uint64_t begin, absl::Span<const uint64_t> outputs)>;
+  void EvalAll(DpfKey& key, size_t chunk_size, const EvalAllCallback& callback);
+
+  // The same evaluations on keys in the compact format.
+  DpfOutStore Eval(const DpfKeyView& key, DpfInStore input);
+  std::vector<DpfOutStore> EvalVector(const DpfKeyView& key, DpfInStore input);
+  std::vector<DpfOutStore> EvalBatch(const DpfKeyView& key,
+                                     absl::Span<const DpfInStore> inputs);
+  std::vector<DpfOutStore> EvalMultiKey(absl::Span<const DpfKeyView> keys,
+                                        DpfInStore input);
+  std::vector<DpfOutStore> EvalAll(const DpfKeyView& key);
+  void EvalAll(const DpfKeyView& key, size_t chunk_size,
+               const EvalAllCallback& callback);
+
   DpfOutStore GetSsMask() const {
-    YASL_ENFORCE(ss_bitnum_ <= 64);
-    if (ss_bitnum_ == 64) {
-      return 0xFFFFFFFFFFFFFFFF;
+    YASL_ENFORCE(ss_bitnum_ <= 128);
+    if (ss_bitnum_ == 128) {
+      return ~static_cast<DpfOutStore>(0);
     }
-    return (static_cast<uint64_t>(1) << ss_bitnum_) - 1;
+    return (static_cast<DpfOutStore>(1) << ss_bitnum_) - 1;
   }
 
   DpfOutStore TruncateSs(DpfOutStore input) const {
-    YASL_ENFORCE(ss_bitnum_ <= 64);
     return input & GetSsMask();
   }
 
   DpfOutStore ReverseSs(DpfOutStore input) const {
-    YASL_ENFORCE(ss_bitnum_ <= 64);
     return TruncateSs(GetSsMask() - TruncateSs(input) + 1);
   }
 
  private:
-  void Traverse(DpfKey& key, std::vector<DpfOutStore>& result,
-                size_t current_level, uint64_t current_pos,
-                uint128_t seed_working, bool t_working, size_t term_level);
+  // shared by DpfKey and DpfKeyView.
+  template <typename Key>
+  std::vector<DpfOutStore> EvalBatchImpl(const Key& key,
+                                         absl::Span<const DpfInStore> inputs);
+  template <typename Key>
+  std::vector<DpfOutStore> EvalMultiKeyImpl(absl::Span<const Key> keys,
+                                            DpfInStore input);
+  template <typename Key>
+  std::vector<DpfOutStore> EvalAllImpl(const Key& key);
+  template <typename Key>
+  void EvalAllImpl(const Key& key, size_t chunk_size,
+                   const EvalAllCallback& callback);
 
   // Note that for the case of sec_param = 128 and ss_bitnum = 64, we
-  // always have term_level = in_bitnum
+  // always have term_level = in_bitnum. The outputs of a point are counted
+  // together.
   size_t GetTerminateLevel(bool enable_evalall) const {
-    if (!enable_evalall) {
+    const size_t out_bitnum = ss_bitnum_ * vector_size_;
+    if (!enable_evalall || out_bitnum >= sec_param_) {
       return in_bitnum_;
     }
     size_t n = in_bitnum_;
-    size_t x = ceil(n - log(sec_param_ / ss_bitnum_));
+    size_t x = ceil(n - log(sec_param_ / out_bitnum));
     return std::min(n, x);
   }
 
   size_t in_bitnum_ = 64;
   size_t ss_bitnum_ = 64;
+  size_t vector_size_ = 1;
   uint32_t sec_param_ = 128;  // we assume 128 bit security (fixed)
+  size_t evalall_parallel_level_ = 12;  // 4096 subtrees
+  DpfPrgType prg_type_ = DpfPrgType::kAes;
 };
 }  // namespace yasl::mpctools
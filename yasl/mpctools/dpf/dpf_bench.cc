@@ -0,0 +1,258 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "yasl/mpctools/dpf/dpf.h"
+#include "yasl/utils/parallel.h"
+
+// Each benchmark reports its rate as keys/s (Gen) or points/s (Eval), and
+// key_bytes, the size of a key in the compact format. The sweeps are named
+// by in_bitnum, ss_bitnum and threads, the threads of yasl::parallel_for.
+
+namespace {
+
+using yasl::mpctools::DpfContext;
+using yasl::mpctools::DpfInStore;
+using yasl::mpctools::DpfKey;
+using yasl::mpctools::DpfOutStore;
+using yasl::mpctools::DpfPrgType;
+
+// keys of the batched variants per iteration.
+constexpr size_t kBatchSize = 1024;
+
+// in_bitnum = state.range(0), ss_bitnum = state.range(1), threads =
+// state.range(2).
+DpfContext MakeContext(const benchmark::State& state) {
+  yasl::set_num_threads(state.range(2));
+  return DpfContext(state.range(0), state.range(1));
+}
+
+std::vector<DpfInStore> RandomInputs(const DpfContext& context, size_t n) {
+  std::mt19937_64 rng(n);
+  std::vector<DpfInStore> inputs(n);
+  for (auto& x : inputs) {
+    x = rng() & ((1ULL << context.GetInBitNum()) - 1);
+  }
+  return inputs;
+}
+
+std::pair<DpfKey, DpfKey> RandomKeys(DpfContext& context,
+                                     bool enable_evalall) {
+  const auto alpha = RandomInputs(context, 1)[0];
+  return context.Gen(alpha, context.TruncateSs(0x12345678), 1, 2,
+                     enable_evalall);
+}
+
+void SetRate(benchmark::State& state, const char* name, int64_t per_iter,
+             const DpfKey& key) {
+  state.counters[name] = benchmark::Counter(
+      static_cast<double>(state.iterations() * per_iter),
+      benchmark::Counter::kIsRate);
+  state.counters["key_bytes"] = key.SerializeCompact().size();
+}
+
+// in_bitnum 10..30 and ss_bitnum 1..128, single and all threads if the
+// benchmark runs parallel_for.
+void DomainSweep(benchmark::internal::Benchmark* b, int64_t max_in_bitnum,
+                 int64_t max_ss_bitnum, bool parallel) {
+  std::vector<int64_t> in_bitnums;
+  for (int64_t in = 10; in <= max_in_bitnum; in += 5) {
+    in_bitnums.push_back(in);
+  }
+  std::vector<int64_t> ss_bitnums;
+  for (int64_t ss : {1, 8, 32, 64, 128}) {
+    if (ss <= max_ss_bitnum) {
+      ss_bitnums.push_back(ss);
+    }
+  }
+  std::vector<int64_t> threads = {1};
+  const int64_t hw = std::thread::hardware_concurrency();
+  if (parallel && hw > 1) {
+    threads.push_back(hw);
+  }
+  b->ArgNames({"in_bitnum", "ss_bitnum", "threads"})
+      ->ArgsProduct({in_bitnums, ss_bitnums, threads});
+}
+
+void PointSweep(benchmark::internal::Benchmark* b) {
+  DomainSweep(b, 30, 128, false);
+}
+
+void BatchSweep(benchmark::internal::Benchmark* b) {
+  DomainSweep(b, 30, 128, true);
+}
+
+// the outputs are held in memory, which bounds the domain.
+void EvalAllSweep(benchmark::internal::Benchmark* b) {
+  DomainSweep(b, 25, 128, true);
+  b->Unit(benchmark::kMillisecond);
+}
+
+// streamed outputs are uint64_t.
+void StreamSweep(benchmark::internal::Benchmark* b) {
+  DomainSweep(b, 30, 64, false);
+  b->Unit(benchmark::kMillisecond);
+}
+
+// DpfPrgType = state.range(0), in_bitnum = state.range(1), ss_bitnum = 64.
+DpfContext MakePrgContext(const benchmark::State& state) {
+  yasl::set_num_threads(1);
+  DpfContext context(state.range(1), 64);
+  context.SetPrgType(static_cast<DpfPrgType>(state.range(0)));
+  return context;
+}
+
+}  // namespace
+
+static void BM_DpfGen(benchmark::State& state) {
+  auto context = MakeContext(state);
+  DpfKey k0;
+  DpfKey k1;
+  for (auto _ : state) {
+    std::tie(k0, k1) = RandomKeys(context, false);
+  }
+  SetRate(state, "keys/s", 1, k0);
+}
+
+static void BM_DpfGenBatch(benchmark::State& state) {
+  auto context = MakeContext(state);
+  const auto alphas = RandomInputs(context, kBatchSize);
+  const std::vector<DpfOutStore> betas(kBatchSize, 1);
+  std::vector<uint128_t> first_mks(kBatchSize);
+  std::vector<uint128_t> second_mks(kBatchSize);
+  for (size_t i = 0; i < kBatchSize; i++) {
+    first_mks[i] = 2 * i;
+    second_mks[i] = 2 * i + 1;
+  }
+  std::vector<DpfKey> k0s(kBatchSize);
+  std::vector<DpfKey> k1s(kBatchSize);
+  for (auto _ : state) {
+    context.GenBatch(alphas, betas, first_mks, second_mks,
+                     absl::MakeSpan(k0s), absl::MakeSpan(k1s));
+  }
+  SetRate(state, "keys/s", kBatchSize, k0s[0]);
+}
+
+static void BM_DpfEval(benchmark::State& state) {
+  auto context = MakeContext(state);
+  auto [k0, k1] = RandomKeys(context, false);
+  const auto inputs = RandomInputs(context, kBatchSize);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(context.Eval(k0, inputs[i++ % kBatchSize]));
+  }
+  SetRate(state, "points/s", 1, k0);
+}
+
+static void BM_DpfEvalBatch(benchmark::State& state) {
+  auto context = MakeContext(state);
+  auto [k0, k1] = RandomKeys(context, false);
+  const auto inputs = RandomInputs(context, kBatchSize);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(context.EvalBatch(k0, inputs));
+  }
+  SetRate(state, "points/s", kBatchSize, k0);
+}
+
+static void BM_DpfEvalMultiKey(benchmark::State& state) {
+  auto context = MakeContext(state);
+  std::vector<DpfKey> keys(kBatchSize);
+  for (auto& key : keys) {
+    key = RandomKeys(context, false).first;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(context.EvalMultiKey(keys, 3));
+  }
+  SetRate(state, "points/s", kBatchSize, keys[0]);
+}
+
+static void BM_DpfEvalAll(benchmark::State& state) {
+  auto context = MakeContext(state);
+  auto [k0, k1] = RandomKeys(context, true);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(context.EvalAll(k0));
+  }
+  SetRate(state, "points/s", 1LL << context.GetInBitNum(), k0);
+}
+
+static void BM_DpfEvalAllStream(benchmark::State& state) {
+  auto context = MakeContext(state);
+  auto [k0, k1] = RandomKeys(context, true);
+  uint64_t sum = 0;
+  for (auto _ : state) {
+    context.EvalAll(k0, 1 << 10,
+                    [&](uint64_t, absl::Span<const uint64_t> outputs) {
+                      sum += outputs[0];
+                    });
+  }
+  benchmark::DoNotOptimize(sum);
+  SetRate(state, "points/s", 1LL << context.GetInBitNum(), k0);
+}
+
+BENCHMARK(BM_DpfGen)->Apply(PointSweep);
+BENCHMARK(BM_DpfGenBatch)->Apply(BatchSweep);
+BENCHMARK(BM_DpfEval)->Apply(PointSweep);
+BENCHMARK(BM_DpfEvalBatch)->Apply(PointSweep);
+BENCHMARK(BM_DpfEvalMultiKey)->Apply(BatchSweep);
+BENCHMARK(BM_DpfEvalAll)->Apply(EvalAllSweep);
+BENCHMARK(BM_DpfEvalAllStream)->Apply(StreamSweep);
+
+static void BM_DpfPrgGen(benchmark::State& state) {
+  auto context = MakePrgContext(state);
+  DpfKey k0;
+  DpfKey k1;
+  for (auto _ : state) {
+    std::tie(k0, k1) = context.Gen(1, 1, 0, 1);
+  }
+  SetRate(state, "keys/s", 1, k0);
+}
+
+static void BM_DpfPrgEval(benchmark::State& state) {
+  auto context = MakePrgContext(state);
+  DpfKey k0;
+  DpfKey k1;
+  std::tie(k0, k1) = context.Gen(1, 1, 0, 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(context.Eval(k0, 3));
+  }
+  SetRate(state, "points/s", 1, k0);
+}
+
+static void BM_DpfPrgEvalAll(benchmark::State& state) {
+  auto context = MakePrgContext(state);
+  DpfKey k0;
+  DpfKey k1;
+  std::tie(k0, k1) = context.Gen(1, 1, 0, 1, true);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(context.EvalAll(k0));
+  }
+  SetRate(state, "points/s", 1LL << context.GetInBitNum(), k0);
+}
+
+// one benchmark per prg.
+#define DPF_PRG_ARGS(in_bitnum)                                           \
+  ArgNames({"prg", "in_bitnum"})                                          \
+      ->Args({static_cast<int64_t>(DpfPrgType::kAes), in_bitnum})         \
+      ->Args({static_cast<int64_t>(DpfPrgType::kFixedKeyAes), in_bitnum}) \
+      ->Args({static_cast<int64_t>(DpfPrgType::kSm4), in_bitnum})
+
+BENCHMARK(BM_DpfPrgGen)->DPF_PRG_ARGS(32);
+BENCHMARK(BM_DpfPrgEval)->DPF_PRG_ARGS(32);
+BENCHMARK(BM_DpfPrgEvalAll)->DPF_PRG_ARGS(16)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,123 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <numeric>
+
+#include "emp-tool/utils/aes_opt.h"
+#include "emp-tool/utils/block.h"
+
+#include "yasl/base/int128.h"
+#include "yasl/crypto/symmetric_crypto.h"
+
+// The seed expansion shared by DPF and DCF, the tree of both is expanded by
+// a PRG keyed by the seed of each node. DPF may pick the fixed key AES or the
+// SM4 PRG below instead, they have the same layout of outputs.
+
+namespace yasl::mpctools::internal {
+
+// seeds expanded by one multi-key aes call, the rounds of all of them are
+// interleaved.
+constexpr size_t kAesBatch = 8;
+// nodes of a frontier expanded at a time, their blocks stay in L1.
+constexpr size_t kExpandChunk = 256;
+static_assert(kExpandChunk % kAesBatch == 0);
+
+// out[i * N + c] = AES(key = seeds[i], c) for c < N, the first N blocks of
+// PseudoRandomGenerator(seeds[i]). A seed is split by its 3 blocks into the
+// left seed, the right seed and the t bits (bit 1 left, bit 2 right), DCF
+// takes a 4th block for the left (low half) and right (high half) values. A
+// seed is converted to the next seed or an output by its first block
+// (N = 1). `out` may alias `seeds` when N = 1.
+template <int N>
+void BatchDpfPRG(const uint128_t* seeds, size_t n, uint128_t* out) {
+  for (size_t i = 0; i < n; i += kAesBatch) {
+    const size_t m = std::min(kAesBatch, n - i);
+    emp::block keys[kAesBatch];
+    for (size_t k = 0; k < kAesBatch; ++k) {
+      keys[k] = emp::block(k < m ? seeds[i + k] : 0);
+    }
+    emp::AES_KEY aes_keys[kAesBatch];
+    emp::AES_opt_key_schedule<kAesBatch>(keys, aes_keys);
+
+    // ParaEnc encrypts blocks [k * N, (k + 1) * N) by key k.
+    emp::block blocks[kAesBatch * N];
+    for (size_t k = 0; k < kAesBatch; ++k) {
+      for (int c = 0; c < N; ++c) {
+        blocks[k * N + c] = emp::makeBlock(0, c);
+      }
+    }
+    emp::ParaEnc<kAesBatch, N>(blocks, aes_keys);
+    for (size_t k = 0; k < m; ++k) {
+      for (int c = 0; c < N; ++c) {
+        out[(i + k) * N + c] = (uint128_t)blocks[k * N + c];
+      }
+    }
+  }
+}
+
+// out[i * N + c] = AES(key = K_c, seeds[i]) ^ seeds[i], the Matyas-Meyer-Oseas
+// construction over N public fixed keys. The key schedules are computed once,
+// so a seed costs N aes calls without a key schedule of its own.
+template <int N>
+void BatchFixedKeyPRG(const uint128_t* seeds, size_t n, uint128_t* out) {
+  static std::array<emp::AES_KEY, N> aes_keys = [] {
+    // K_c = (digits of pi, c).
+    emp::block keys[N];
+    for (int c = 0; c < N; ++c) {
+      keys[c] = emp::makeBlock(0x243F6A8885A308D3ULL, c);
+    }
+    std::array<emp::AES_KEY, N> ret;
+    emp::AES_opt_key_schedule<N>(keys, ret.data());
+    return ret;
+  }();
+
+  for (size_t i = 0; i < n; i += kAesBatch) {
+    const size_t m = std::min(kAesBatch, n - i);
+    // ParaEnc encrypts blocks [c * kAesBatch, (c + 1) * kAesBatch) by key c.
+    emp::block blocks[N * kAesBatch];
+    for (int c = 0; c < N; ++c) {
+      for (size_t k = 0; k < kAesBatch; ++k) {
+        blocks[c * kAesBatch + k] = emp::block(k < m ? seeds[i + k] : 0);
+      }
+    }
+    emp::ParaEnc<N, kAesBatch>(blocks, aes_keys.data());
+    for (size_t k = 0; k < m; ++k) {
+      const uint128_t seed = seeds[i + k];
+      for (int c = 0; c < N; ++c) {
+        out[(i + k) * N + c] = (uint128_t)blocks[c * kAesBatch + k] ^ seed;
+      }
+    }
+  }
+}
+
+// out[i * N + c] = SM4(key = seeds[i], c), BatchDpfPRG by SM4 for GM
+// compliance. It goes through openssl once per seed and is much slower.
+template <int N>
+void BatchSm4PRG(const uint128_t* seeds, size_t n, uint128_t* out) {
+  std::array<uint128_t, N> counters;
+  std::iota(counters.begin(), counters.end(), 0);
+  std::array<uint128_t, N> blocks;
+  for (size_t i = 0; i < n; ++i) {
+    SymmetricCrypto(SymmetricCrypto::CryptoType::SM4_ECB, seeds[i])
+        .Encrypt(absl::MakeConstSpan(counters), absl::MakeSpan(blocks));
+    std::copy(blocks.begin(), blocks.end(), out + i * N);
+  }
+}
+
+}  // namespace yasl::mpctools::internal
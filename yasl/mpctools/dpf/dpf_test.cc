@@ -12,11 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-
 #include "yasl/mpctools/dpf/dpf.h"
 
+#include <algorithm>
 #include <future>
 #include <iostream>
+#include <numeric>
 
 #include "gtest/gtest.h"
 
@@ -49,6 +50,41 @@ TEST_P(FssDpfGenTest, Works) {
       context.Gen(params.alpha, params.beta, first_mk, second_mk, false);
 }
 
+TEST_P(FssDpfGenTest, Batch) {
+  auto params = GetParam();
+  DpfContext context(params.InBitnum, params.SsBitnum);
+
+  // more keys than a task takes at a time.
+  const size_t num = 300;
+  std::vector<DpfInStore> alphas(num);
+  std::vector<DpfOutStore> betas(num);
+  std::vector<uint128_t> first_mks(num);
+  std::vector<uint128_t> second_mks(num);
+  for (size_t i = 0; i < num; i++) {
+    alphas[i] = (params.alpha + i) % (1ULL << params.InBitnum);
+    betas[i] = context.TruncateSs(params.beta + i);
+    first_mks[i] = 2 * i;
+    second_mks[i] = 2 * i + 1;
+  }
+
+  for (bool enable_evalall : {false, true}) {
+    std::vector<DpfKey> k0s;
+    std::vector<DpfKey> k1s;
+    std::tie(k0s, k1s) =
+        context.GenBatch(alphas, betas, first_mks, second_mks, enable_evalall);
+    ASSERT_EQ(k0s.size(), num);
+    ASSERT_EQ(k1s.size(), num);
+    for (size_t i = 0; i < num; i++) {
+      DpfKey k0;
+      DpfKey k1;
+      std::tie(k0, k1) = context.Gen(alphas[i], betas[i], first_mks[i],
+                                     second_mks[i], enable_evalall);
+      EXPECT_EQ(k0s[i].Serialize(), k0.Serialize());
+      EXPECT_EQ(k1s[i].Serialize(), k1.Serialize());
+    }
+  }
+}
+
 TEST_P(FssDpfEvalTest, Works) {
   auto params = GetParam();
   DpfKey k0;
@@ -92,6 +128,52 @@ TEST_P(FssDpfEvalTest, Works) {
   }
 }
 
+TEST_P(FssDpfEvalTest, Batch) {
+  auto params = GetParam();
+  DpfContext context(params.InBitnum, params.SsBitnum);
+
+  DpfKey k0;
+  DpfKey k1;
+  std::tie(k0, k1) = context.Gen(params.alpha, params.beta, 0, 1, false);
+
+  // unsorted inputs with duplicates.
+  const size_t range = 1 << context.GetInBitNum();
+  std::vector<DpfInStore> inputs;
+  for (size_t i = 0; i < 3 * range; i++) {
+    inputs.push_back((i * 7 + 3) % range);
+  }
+  const auto outputs = context.EvalBatch(k1, inputs);
+  ASSERT_EQ(outputs.size(), inputs.size());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    EXPECT_EQ(outputs[i], context.Eval(k1, inputs[i]));
+  }
+  EXPECT_TRUE(context.EvalBatch(k1, {}).empty());
+}
+
+TEST_P(FssDpfEvalTest, MultiKey) {
+  auto params = GetParam();
+  DpfContext context(params.InBitnum, params.SsBitnum);
+
+  // more keys than a task takes at a time.
+  std::vector<DpfKey> keys;
+  for (size_t i = 0; i < 300; i++) {
+    DpfKey k0;
+    DpfKey k1;
+    std::tie(k0, k1) = context.Gen(params.alpha, params.beta, 2 * i, 2 * i + 1);
+    keys.push_back(std::move(k0));
+    keys.push_back(std::move(k1));
+  }
+
+  const size_t range = 1 << context.GetInBitNum();
+  for (size_t x = 0; x < range; x++) {
+    const auto outputs = context.EvalMultiKey(keys, x);
+    ASSERT_EQ(outputs.size(), keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      EXPECT_EQ(outputs[i], context.Eval(keys[i], x));
+    }
+  }
+}
+
 TEST_P(FssDpfEvalAllTest, Works) {
   auto params = GetParam();
   DpfKey k0;
@@ -142,6 +224,307 @@ TEST_P(FssDpfEvalAllTest, Works) {
   }
 }
 
+TEST_P(FssDpfEvalAllTest, ParallelLevels) {
+  auto params = GetParam();
+  DpfContext context;
+  context.SetInBitNum(params.InBitnum);
+  context.SetSsBitNum(params.SsBitnum);
+
+  DpfKey k0;
+  DpfKey k1;
+  std::tie(k0, k1) = context.Gen(params.alpha, params.beta, 0, 1, true);
+
+  context.SetEvalAllParallelLevel(0);
+  const auto expected = context.EvalAll(k0);
+  for (size_t level : {1, 3, 12, 64}) {
+    context.SetEvalAllParallelLevel(level);
+    EXPECT_EQ(context.EvalAll(k0), expected) << "level " << level;
+  }
+}
+
+TEST_P(FssDpfEvalAllTest, SpanOutputs) {
+  auto params = GetParam();
+  DpfContext context(params.InBitnum, params.SsBitnum);
+
+  DpfKey k0;
+  DpfKey k1;
+  std::tie(k0, k1) = context.Gen(params.alpha, params.beta, 0, 1, true);
+  const auto expected = context.EvalAll(k1);
+
+  std::vector<uint64_t> out64(expected.size());
+  context.EvalAll(k1, absl::MakeSpan(out64));
+  std::vector<uint8_t> out8(expected.size());
+  if (params.SsBitnum <= 8) {
+    context.EvalAll(k1, absl::MakeSpan(out8));
+  } else {
+    EXPECT_ANY_THROW(context.EvalAll(k1, absl::MakeSpan(out8)));
+  }
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(out64[i], expected[i]);
+    if (params.SsBitnum <= 8) {
+      EXPECT_EQ(out8[i], expected[i]);
+    }
+  }
+}
+
+TEST_P(FssDpfEvalAllTest, Streaming) {
+  auto params = GetParam();
+  DpfContext context(params.InBitnum, params.SsBitnum);
+
+  DpfKey k0;
+  DpfKey k1;
+  std::tie(k0, k1) = context.Gen(params.alpha, params.beta, 0, 1, true);
+  const auto expected = context.EvalAll(k0);
+
+  for (size_t chunk_size : {size_t(1), size_t(16), expected.size()}) {
+    if (chunk_size > expected.size()) {
+      continue;
+    }
+    std::vector<uint64_t> out(expected.size());
+    std::vector<bool> visited(expected.size());
+    context.EvalAll(k0, chunk_size,
+                    [&](uint64_t begin, absl::Span<const uint64_t> outputs) {
+                      ASSERT_EQ(outputs.size(), chunk_size);
+                      for (size_t i = 0; i < outputs.size(); i++) {
+                        EXPECT_FALSE(visited[begin + i]);
+                        visited[begin + i] = true;
+                        out[begin + i] = outputs[i];
+                      }
+                    });
+    EXPECT_EQ(std::count(visited.begin(), visited.end(), true),
+              static_cast<int64_t>(expected.size()));
+    for (size_t i = 0; i < expected.size(); i++) {
+      EXPECT_EQ(out[i], expected[i]) << "chunk " << chunk_size;
+    }
+  }
+
+  EXPECT_ANY_THROW(context.EvalAll(
+      k0, 3, [](uint64_t, absl::Span<const uint64_t>) {}));
+}
+
+TEST_P(FssDpfGenTest, CompactFormat) {
+  auto params = GetParam();
+  DpfContext context(params.InBitnum, params.SsBitnum);
+
+  for (bool enable_evalall : {false, true}) {
+    DpfKey k0;
+    DpfKey k1;
+    // full width master seeds, as random ones are.
+    const uint128_t mk = MakeUint128(0x0123456789abcdef, 0xfedcba9876543210);
+    std::tie(k0, k1) =
+        context.Gen(params.alpha, params.beta, mk, ~mk, enable_evalall);
+
+    // keys back to back, as a dealer sends them.
+    auto b0 = k0.SerializeCompact();
+    auto b1 = k1.SerializeCompact();
+    EXPECT_LT(b0.size(), static_cast<int64_t>(k0.Serialize().size()));
+    std::string packed(b0.data<char>(), b0.size());
+    packed.append(b1.data<char>(), b1.size());
+
+    DpfKeyView v0(packed);
+    DpfKeyView v1(ByteContainerView(packed).subspan(v0.size()));
+    EXPECT_EQ(v0.size() + v1.size(), packed.size());
+    EXPECT_EQ(v0.ToKey().Serialize(), k0.Serialize());
+    EXPECT_EQ(v1.ToKey().Serialize(), k1.Serialize());
+
+    DpfKey k1_copy;
+    k1_copy.DeserializeCompact(b1);
+    EXPECT_EQ(k1_copy.Serialize(), k1.Serialize());
+
+    const size_t range = 1 << params.InBitnum;
+    if (enable_evalall) {
+      EXPECT_EQ(context.EvalAll(v0), context.EvalAll(k0));
+      EXPECT_EQ(context.EvalAll(v1), context.EvalAll(k1));
+    } else {
+      for (size_t i = 0; i < range; i++) {
+        EXPECT_EQ(context.Eval(v0, i), context.Eval(k0, i));
+        EXPECT_EQ(context.Eval(v1, i), context.Eval(k1, i));
+      }
+    }
+  }
+}
+
+TEST(FssDpfKeyViewTest, ShouldThrowOnMalformedData) {
+  DpfContext context(8, 16);
+  DpfKey k0;
+  DpfKey k1;
+  std::tie(k0, k1) = context.Gen(3, 5, 0, 1);
+  auto buf = k0.SerializeCompact();
+  std::string data(buf.data<char>(), buf.size());
+
+  EXPECT_ANY_THROW(DpfKeyView(ByteContainerView(data).subspan(0, 10)));
+  EXPECT_ANY_THROW(
+      DpfKeyView(ByteContainerView(data).subspan(0, data.size() - 1)));
+  std::string bad_version = data;
+  bad_version[0] = 0;
+  EXPECT_ANY_THROW(DpfKeyView{bad_version});
+  // a key with too few cws is refused by the evaluations.
+  std::string short_key = data;
+  short_key[6] = 1;
+  EXPECT_ANY_THROW(context.Eval(DpfKeyView(short_key), 3));
+  // so is a key of a larger domain.
+  DpfContext larger(10, 16);
+  std::tie(k0, k1) = larger.Gen(3, 5, 0, 1);
+  EXPECT_ANY_THROW(context.Eval(k0, 3));
+}
+
+TEST(FssDpfOutputTest, Uint128Outputs) {
+  DpfContext context(10, 128);
+  const DpfInStore alpha = 1000;
+  const DpfOutStore beta = MakeUint128(0x0123456789abcdef, 0xfedcba9876543210);
+  const size_t range = 1 << context.GetInBitNum();
+
+  for (bool enable_evalall : {false, true}) {
+    DpfKey k0;
+    DpfKey k1;
+    std::tie(k0, k1) = context.Gen(alpha, beta, 0, 1, enable_evalall);
+    // a compact key keeps the whole last cws.
+    auto buf = k1.SerializeCompact();
+    DpfKeyView v1(buf);
+    if (enable_evalall) {
+      auto r0 = context.EvalAll(k0);
+      auto r1 = context.EvalAll(v1);
+      for (size_t i = 0; i < range; i++) {
+        EXPECT_EQ(r0[i] + r1[i], i == alpha ? beta : 0);
+      }
+    } else {
+      for (size_t i = 0; i < range; i++) {
+        EXPECT_EQ(context.Eval(k0, i) + context.Eval(v1, i),
+                  i == alpha ? beta : 0);
+      }
+    }
+  }
+}
+
+TEST(FssDpfOutputTest, VectorOutputs) {
+  const DpfInStore alpha = 333;
+  // 3 words of 8 bits let EvalAll terminate early, 4 of 32 bits do not.
+  for (auto [ss_bitnum, vector_size] :
+       std::vector<std::pair<size_t, size_t>>{{8, 3}, {32, 4}, {128, 2}}) {
+    DpfContext context(12, ss_bitnum);
+    context.SetVectorSize(vector_size);
+    const size_t range = 1 << context.GetInBitNum();
+    std::vector<DpfOutStore> beta(vector_size);
+    for (size_t j = 0; j < vector_size; j++) {
+      beta[j] = context.TruncateSs(0x1234567 * (j + 1));
+    }
+    auto expected = [&](size_t i, size_t j) {
+      return i == alpha ? beta[j] : 0;
+    };
+
+    DpfKey k0;
+    DpfKey k1;
+    std::tie(k0, k1) = context.GenVector(alpha, beta, 0, 1);
+    // one tree, k last cws.
+    EXPECT_EQ(k0.GetNumCWs(), context.GetInBitNum());
+    EXPECT_EQ(k0.GetNumLastCWs(), vector_size);
+    EXPECT_ANY_THROW(context.Eval(k0, alpha));
+    EXPECT_ANY_THROW(context.Gen(alpha, beta[0], 0, 1));
+
+    std::vector<DpfInStore> inputs(range);
+    std::iota(inputs.begin(), inputs.end(), 0);
+    auto b0 = context.EvalBatch(k0, inputs);
+    auto b1 = context.EvalBatch(k1, inputs);
+    ASSERT_EQ(b0.size(), range * vector_size);
+    for (size_t i = 0; i < range; i++) {
+      auto v0 = context.EvalVector(k0, i);
+      auto v1 = context.EvalVector(k1, i);
+      ASSERT_EQ(v0.size(), vector_size);
+      for (size_t j = 0; j < vector_size; j++) {
+        EXPECT_EQ(context.TruncateSs(v0[j] + v1[j]), expected(i, j));
+        EXPECT_EQ(b0[i * vector_size + j], v0[j]);
+        EXPECT_EQ(b1[i * vector_size + j], v1[j]);
+      }
+    }
+    auto m = context.EvalMultiKey(std::vector<DpfKey>{k0, k1}, alpha);
+    ASSERT_EQ(m.size(), 2 * vector_size);
+    for (size_t j = 0; j < vector_size; j++) {
+      EXPECT_EQ(context.TruncateSs(m[j] + m[vector_size + j]), beta[j]);
+    }
+
+    std::tie(k0, k1) = context.GenVector(alpha, beta, 0, 1, true);
+    auto a0 = context.EvalAll(k0);
+    auto a1 = context.EvalAll(k1);
+    ASSERT_EQ(a0.size(), range * vector_size);
+    for (size_t i = 0; i < range; i++) {
+      for (size_t j = 0; j < vector_size; j++) {
+        EXPECT_EQ(context.TruncateSs(a0[i * vector_size + j] +
+                                     a1[i * vector_size + j]),
+                  expected(i, j));
+      }
+    }
+    std::vector<uint64_t> out(range);
+    EXPECT_ANY_THROW(context.EvalAll(k0, absl::MakeSpan(out)));
+  }
+}
+
+class FssDpfPrgTest : public testing::TestWithParam<DpfPrgType> {};
+
+TEST_P(FssDpfPrgTest, Works) {
+  DpfContext context(10, 32);
+  context.SetPrgType(GetParam());
+  const DpfInStore alpha = 777;
+  const DpfOutStore beta = 12345;
+  const size_t range = 1 << context.GetInBitNum();
+
+  DpfKey k0;
+  DpfKey k1;
+  std::tie(k0, k1) = context.Gen(alpha, beta, 0, 1);
+  EXPECT_EQ(k0.GetPrgType(), GetParam());
+  EXPECT_EQ(k1.GetPrgType(), GetParam());
+  std::vector<DpfInStore> inputs(range);
+  std::iota(inputs.begin(), inputs.end(), 0);
+  auto r0 = context.EvalBatch(k0, inputs);
+  auto r1 = context.EvalBatch(k1, inputs);
+  for (size_t i = 0; i < range; i++) {
+    EXPECT_EQ(r0[i], context.Eval(k0, i));
+    EXPECT_EQ(context.TruncateSs(r0[i] + r1[i]), i == alpha ? beta : 0);
+  }
+
+  std::tie(k0, k1) = context.Gen(alpha, beta, 0, 1, true);
+  auto a0 = context.EvalAll(k0);
+  auto a1 = context.EvalAll(k1);
+  for (size_t i = 0; i < range; i++) {
+    EXPECT_EQ(context.TruncateSs(a0[i] + a1[i]), i == alpha ? beta : 0);
+  }
+
+  // the prg goes with the key in both formats.
+  DpfKey k1_copy;
+  k1_copy.Deserialize(k1.Serialize());
+  EXPECT_EQ(k1_copy.GetPrgType(), GetParam());
+  auto buf = k1.SerializeCompact();
+  EXPECT_EQ(DpfKeyView(buf).GetPrgType(), GetParam());
+  EXPECT_EQ(context.EvalAll(DpfKeyView(buf)), a1);
+}
+
+TEST_P(FssDpfPrgTest, ShouldThrowOnOtherPrg) {
+  DpfContext context(8, 16);
+  context.SetPrgType(GetParam());
+  DpfKey k0;
+  DpfKey k1;
+  std::tie(k0, k1) = context.Gen(3, 5, 0, 1);
+
+  for (auto prg : {DpfPrgType::kAes, DpfPrgType::kFixedKeyAes,
+                   DpfPrgType::kSm4}) {
+    if (prg == GetParam()) {
+      continue;
+    }
+    DpfContext other(8, 16);
+    other.SetPrgType(prg);
+    EXPECT_ANY_THROW(other.Eval(k0, 3));
+    // the keys differ, the prg is not only a label.
+    DpfKey other_k0;
+    DpfKey other_k1;
+    std::tie(other_k0, other_k1) = other.Gen(3, 5, 0, 1);
+    EXPECT_NE(other_k0.GetCW(0).GetSeed(), k0.GetCW(0).GetSeed());
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Works_Instances, FssDpfPrgTest,
+                         testing::Values(DpfPrgType::kAes,
+                                         DpfPrgType::kFixedKeyAes,
+                                         DpfPrgType::kSm4));
+
 INSTANTIATE_TEST_SUITE_P(Works_Instances, FssDpfGenTest,
                          testing::Values(TestParams{1, 1, 2, 1},   //
                                          TestParams{1, 2, 2, 4},   //
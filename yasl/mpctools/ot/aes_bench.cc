@@ -16,16 +16,20 @@
 #include <future>
 #include <iostream>
 #include <random>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "emp-tool/utils/aes_opt.h"
+#include "openssl/evp.h"
 
 #ifdef __x86_64
 #include "crypto_mb/sm4.h"  // ipp-crypto multi-buffer
 #include "ippcp.h"          // ipp-crypto
 #endif
 
+#include "yasl/crypto/aes_ni.h"
 #include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/sm4_ni.h"
 
 constexpr uint128_t kIv1 = 1;
 
@@ -182,6 +186,119 @@ static void BM_IppcpSm4(benchmark::State& state) {
 }
 #endif
 
+// Keystream of fixed key AES on counters, state.range(0) bytes per iteration.
+// BM_OpensslAesCtr encrypts counters written to memory by openssl, as
+// CipherPrg did before the AES-NI kernel.
+
+static void BM_OpensslAesCtr(benchmark::State& state) {
+  const size_t n = state.range(0) / sizeof(uint128_t);
+  yasl::SymmetricCrypto crypto(yasl::SymmetricCrypto::CryptoType::AES128_ECB,
+                               kIv1);
+  std::vector<uint128_t> out(n);
+  uint128_t counter = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < n; i++) {
+      out[i] = counter++;
+    }
+    crypto.Encrypt(absl::MakeConstSpan(out), absl::MakeSpan(out));
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+template <void (*kernel)(const yasl::AesRoundKeys&, uint128_t, uint8_t*,
+                         size_t)>
+static void BM_AesCtrKernel(benchmark::State& state) {
+  if (!yasl::CpuSupportsAesNi() ||
+      (kernel == &yasl::VaesCtrEncrypt && !yasl::CpuSupportsVaes())) {
+    state.SkipWithError("not supported by the cpu");
+    return;
+  }
+  yasl::AesRoundKeys round_keys;
+  yasl::AesNiKeySchedule(kIv1, &round_keys);
+  std::vector<uint8_t> out(state.range(0));
+  uint128_t counter = 0;
+  for (auto _ : state) {
+    kernel(round_keys, counter, out.data(), out.size() / sizeof(uint128_t));
+    counter += out.size() / sizeof(uint128_t);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_PrgAesEcbFill(benchmark::State& state) {
+  yasl::PseudoRandomGenerator<uint128_t> prg(kIv1, yasl::PRG_MODE::kAesEcb);
+  std::vector<uint8_t> out(state.range(0));
+  for (auto _ : state) {
+    prg.Fill(absl::MakeSpan(out));
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// The same for SM4, BM_OpensslSm4Ctr on the table based SM4 of openssl, as
+// CipherPrg did before the SM4 kernel.
+
+static void BM_OpensslSm4Ctr(benchmark::State& state) {
+  const size_t n = state.range(0) / sizeof(uint128_t);
+  EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+  YASL_ENFORCE(EVP_EncryptInit_ex(ctx, EVP_sm4_ecb(), nullptr,
+                                  reinterpret_cast<const uint8_t*>(&kIv1),
+                                  nullptr));
+  EVP_CIPHER_CTX_set_padding(ctx, 0);
+  std::vector<uint128_t> out(n);
+  uint128_t counter = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < n; i++) {
+      out[i] = counter++;
+    }
+    auto* data = reinterpret_cast<uint8_t*>(out.data());
+    int outlen;
+    EVP_EncryptUpdate(ctx, data, &outlen, data, state.range(0));
+    benchmark::DoNotOptimize(out.data());
+  }
+  EVP_CIPHER_CTX_free(ctx);
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_Sm4CtrKernel(benchmark::State& state) {
+  if (!yasl::CpuSupportsSm4Ni()) {
+    state.SkipWithError("not supported by the cpu");
+    return;
+  }
+  yasl::Sm4RoundKeys round_keys;
+  yasl::Sm4KeySchedule(kIv1, &round_keys);
+  std::vector<uint8_t> out(state.range(0));
+  uint128_t counter = 0;
+  for (auto _ : state) {
+    yasl::Sm4CtrEncrypt(round_keys, counter, out.data(),
+                        out.size() / sizeof(uint128_t));
+    counter += out.size() / sizeof(uint128_t);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_PrgSm4EcbFill(benchmark::State& state) {
+  yasl::PseudoRandomGenerator<uint128_t> prg(kIv1, yasl::PRG_MODE::KSm4Ecb);
+  std::vector<uint8_t> out(state.range(0));
+  for (auto _ : state) {
+    prg.Fill(absl::MakeSpan(out));
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_OpensslAesCtr)->Range(1 << 12, 1 << 24);
+BENCHMARK_TEMPLATE(BM_AesCtrKernel, yasl::AesNiCtrEncrypt)
+    ->Range(1 << 12, 1 << 24);
+BENCHMARK_TEMPLATE(BM_AesCtrKernel, yasl::VaesCtrEncrypt)
+    ->Range(1 << 12, 1 << 24);
+BENCHMARK(BM_PrgAesEcbFill)->Range(1 << 12, 1 << 24);
+BENCHMARK(BM_OpensslSm4Ctr)->Range(1 << 12, 1 << 24);
+BENCHMARK(BM_Sm4CtrKernel)->Range(1 << 12, 1 << 24);
+BENCHMARK(BM_PrgSm4EcbFill)->Range(1 << 12, 1 << 24);
+
 BENCHMARK(BM_OpensslAes)
     ->Unit(benchmark::kMillisecond)
     ->Arg(1024)
@@ -15,42 +15,237 @@
 
 #include "yasl/mpctools/ot/base_ot.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <map>
+#include <mutex>
+
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "fmt/format.h"
+
 #if defined (__linux__) && defined (__x86_64)
-#include "cpu_features/cpuinfo_x86.h"
+#include "yasl/base/cpu_dispatch.h"
 
 #include "yasl/mpctools/ot/x86_asm_ot_interface.h"
 #endif
 
 #include "yasl/base/exception.h"
 #include "yasl/mpctools/ot/portable_ot_interface.h"
+#include "yasl/mpctools/ot/sodium_ot_interface.h"
 
 namespace yasl {
 namespace {
 
-std::unique_ptr<BaseOTInterface> GetOtInterface() {
-#if defined (__linux__) && defined (__x86_64)
-  // x86 asm ot does not support macOS
-  static const auto features = cpu_features::GetX86Info().features;
-  if (features.avx) {
-    return std::make_unique<X86AsmOtInterface>();
+// separates the backend names the receiver has.
+constexpr char kBackendSeparator = ',';
+
+// base ots per backend when probing for the fastest one.
+constexpr size_t kProbeNumOt = 32;
+constexpr size_t kProbeRounds = 2;
+
+class BaseOtRegistry {
+ public:
+  static BaseOtRegistry& Get() {
+    static BaseOtRegistry registry;
+    return registry;
+  }
+
+  void Register(const std::string& name, BaseOtFactory factory) {
+    YASL_ENFORCE(!name.empty() && name != kAutoBaseOtBackend &&
+                     name.find(kBackendSeparator) == std::string::npos,
+                 "invalid base ot backend name={}", name);
+    std::lock_guard<std::mutex> lock(mutex_);
+    backends_[name] = Backend{std::move(factory), nullptr};
+  }
+
+  std::vector<std::string> List() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> names;
+    for (const auto& [name, backend] : backends_) {
+      names.push_back(name);
+    }
+    return names;
   }
+
+  void Select(std::string_view name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    YASL_ENFORCE(name == kAutoBaseOtBackend || backends_.count(name) > 0,
+                 "unknown base ot backend={}", name);
+    selected_ = name;
+  }
+
+  std::string Selected() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (selected_ != kAutoBaseOtBackend) {
+        return selected_;
+      }
+    }
+    std::call_once(probe_once_, [&] { fastest_ = Probe(); });
+    return fastest_;
+  }
+
+  // the backend of sender among the ones `peer` has. a set backend must be
+  // there, auto falls back to a common one if the fastest is not.
+  std::string Negotiate(const std::vector<std::string>& peer) {
+    const bool is_auto = [&] {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return selected_ == kAutoBaseOtBackend;
+    }();
+    auto has = [&](const std::string& name) {
+      return std::find(peer.begin(), peer.end(), name) != peer.end();
+    };
+    const auto selected = Selected();
+    if (has(selected)) {
+      return selected;
+    }
+    if (is_auto) {
+      for (const auto& name : List()) {
+        if (has(name)) {
+          return name;
+        }
+      }
+    }
+    return {};
+  }
+
+  std::shared_ptr<BaseOTInterface> Instance(std::string_view name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = backends_.find(name);
+    YASL_ENFORCE(it != backends_.end(), "unknown base ot backend={}", name);
+    if (!it->second.instance) {
+      it->second.instance = it->second.factory();
+    }
+    return it->second.instance;
+  }
+
+ private:
+  struct Backend {
+    BaseOtFactory factory;
+    std::shared_ptr<BaseOTInterface> instance;
+  };
+
+  BaseOtRegistry() {
+#if defined (__linux__) && defined (__x86_64)
+    // x86 asm ot does not support macOS
+    if (CpuSupports(kIsaAvx)) {
+      backends_["x86_asm"] = {
+          [] { return std::make_unique<X86AsmOtInterface>(); }, nullptr};
+    }
 #endif
-  return std::make_unique<PortableOtInterface>();
-}
+    backends_["portable"] = {
+        [] { return std::make_unique<PortableOtInterface>(); }, nullptr};
+    backends_["ristretto"] = {
+        [] { return std::make_unique<SodiumOtInterface>(); }, nullptr};
+    if (const char* name = std::getenv("YASL_BASE_OT_BACKEND")) {
+      YASL_ENFORCE(name == kAutoBaseOtBackend || backends_.count(name) > 0,
+                   "unknown base ot backend={} of YASL_BASE_OT_BACKEND", name);
+      selected_ = name;
+    }
+  }
+
+  // the backend of the least time of kProbeNumOt loopback base ots, backends
+  // that fail on this host are skipped.
+  std::string Probe() {
+    std::string fastest;
+    auto fastest_time = std::chrono::steady_clock::duration::max();
+    for (const auto& name : List()) {
+      try {
+        const auto time = ProbeTime(name);
+        if (time < fastest_time) {
+          fastest = name;
+          fastest_time = time;
+        }
+      } catch (const std::exception&) {
+        continue;
+      }
+    }
+    YASL_ENFORCE(!fastest.empty(), "no base ot backend works on this host");
+    return fastest;
+  }
+
+  std::chrono::steady_clock::duration ProbeTime(const std::string& name) {
+    const auto ot = Instance(name);
+    link::ContextDesc desc;
+    desc.id = fmt::format("base_ot_probe_{}", name);
+    for (size_t rank = 0; rank < 2; rank++) {
+      desc.parties.push_back({fmt::format("probe:{}", rank), "probe_host"});
+    }
+    std::vector<std::shared_ptr<link::Context>> ctxs(2);
+    auto connect = std::async(std::launch::async, [&] {
+      ctxs[1] = link::FactoryMem().CreateContext(desc, 1);
+      ctxs[1]->ConnectToMesh();
+    });
+    ctxs[0] = link::FactoryMem().CreateContext(desc, 0);
+    ctxs[0]->ConnectToMesh();
+    connect.get();
+
+    std::vector<std::array<Block, 2>> send_blocks(kProbeNumOt);
+    std::vector<Block> recv_blocks(kProbeNumOt);
+    const BitVector choices(kProbeNumOt);
+    auto best = std::chrono::steady_clock::duration::max();
+    for (size_t round = 0; round < kProbeRounds; round++) {
+      const auto start = std::chrono::steady_clock::now();
+      auto recv = std::async(std::launch::async, [&] {
+        ot->Recv(ctxs[1], choices, absl::MakeSpan(recv_blocks));
+      });
+      ot->Send(ctxs[0], absl::MakeSpan(send_blocks));
+      recv.get();
+      best = std::min(best, std::chrono::steady_clock::now() - start);
+    }
+    return best;
+  }
+
+  std::mutex mutex_;
+  std::map<std::string, Backend, std::less<>> backends_;
+  std::string selected_{kAutoBaseOtBackend};
+
+  std::once_flag probe_once_;
+  std::string fastest_;
+};
 
 }  // namespace
 
 // Abstract class anchor
 BaseOTInterface::~BaseOTInterface() = default;
 
+void RegisterBaseOtBackend(const std::string& name, BaseOtFactory factory) {
+  BaseOtRegistry::Get().Register(name, std::move(factory));
+}
+
+std::vector<std::string> ListBaseOtBackends() {
+  return BaseOtRegistry::Get().List();
+}
+
+void SetBaseOtBackend(std::string_view name) {
+  BaseOtRegistry::Get().Select(name);
+}
+
+std::string GetBaseOtBackend() { return BaseOtRegistry::Get().Selected(); }
+
 void BaseOtRecv(const std::shared_ptr<link::Context>& ctx,
-                const std::vector<bool>& choices,
+                const BitVector& choices,
                 absl::Span<Block> recv_blocks) {
   YASL_ENFORCE_EQ(ctx->WorldSize(), 2u);
   YASL_ENFORCE_EQ(choices.size(), recv_blocks.size());
   YASL_ENFORCE(!choices.empty(), "empty choices");
 
-  auto ot_interface = GetOtInterface();
+  // the sender decides the backend among the ones of receiver, an empty
+  // name if there is none.
+  const auto available =
+      absl::StrJoin(ListBaseOtBackends(), std::string(1, kBackendSeparator));
+  ctx->SendAsync(ctx->NextRank(),
+                 ByteContainerView(available.data(), available.size()),
+                 "BASE_OT:AVAILABLE");
+  auto buf = ctx->Recv(ctx->NextRank(), "BASE_OT:BACKEND");
+  const std::string name(buf.data<char>(), buf.size());
+  YASL_ENFORCE(!name.empty(),
+               "base ot backend of peer is not available here, available={}",
+               available);
+  auto ot_interface = BaseOtRegistry::Get().Instance(name);
   ot_interface->Recv(ctx, choices, recv_blocks);
 }
 
@@ -58,7 +253,18 @@ void BaseOtSend(const std::shared_ptr<link::Context>& ctx,
                 absl::Span<std::array<Block, 2>> send_blocks) {
   YASL_ENFORCE(!send_blocks.empty(), "empty inputs");
 
-  auto ot_interface = GetOtInterface();
+  auto buf = ctx->Recv(ctx->NextRank(), "BASE_OT:AVAILABLE");
+  const std::string available(buf.data<char>(), buf.size());
+  const std::vector<std::string> peer =
+      absl::StrSplit(available, kBackendSeparator);
+  const auto name = BaseOtRegistry::Get().Negotiate(peer);
+  // an empty name fails the receiver too.
+  ctx->SendAsync(ctx->NextRank(), ByteContainerView(name.data(), name.size()),
+                 "BASE_OT:BACKEND");
+  YASL_ENFORCE(!name.empty(),
+               "base ot backend={} is not available on peer, available={}",
+               GetBaseOtBackend(), available);
+  auto ot_interface = BaseOtRegistry::Get().Instance(name);
   ot_interface->Send(ctx, send_blocks);
 }
 
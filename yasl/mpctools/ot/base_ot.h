@@ -15,24 +15,55 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include "absl/types/span.h"
 
+#include "yasl/base/bit_vector.h"
 #include "yasl/base/int128.h"
 #include "yasl/link/link.h"
+#include "yasl/mpctools/ot/base_ot_interface.h"
 
 namespace yasl {
 
-using Block = uint128_t;
+// Base OT backends are registered by name: "x86_asm" on linux x86_64 with
+// AVX, "portable" and "ristretto" everywhere. One instance of each backend is
+// created on first use and shared by all later calls of this process.
+//
+// The receiver tells the backends it has, and the sender picks one of them
+// and announces it, so peers always agree on it. Unless set by
+// SetBaseOtBackend or the env var YASL_BASE_OT_BACKEND, the backend is
+// "auto": the fastest one on this host, measured once per process by a few
+// loopback base ots of each backend, or another one if the receiver lacks
+// it. A backend set explicitly but missing on the receiver fails both sides.
+inline constexpr std::string_view kAutoBaseOtBackend = "auto";
+
+using BaseOtFactory = std::function<std::unique_ptr<BaseOTInterface>()>;
+
+// registers or replaces the backend `name`.
+void RegisterBaseOtBackend(const std::string& name, BaseOtFactory factory);
+
+std::vector<std::string> ListBaseOtBackends();
+
+// `name` is a registered backend or kAutoBaseOtBackend.
+void SetBaseOtBackend(std::string_view name);
+
+// the backend preferred by BaseOtSend, "auto" is resolved.
+std::string GetBaseOtBackend();
 
 void BaseOtRecv(const std::shared_ptr<link::Context>& ctx,
-                const std::vector<bool>& choices,
+                const BitVector& choices,
                 absl::Span<Block> recv_blocks);
 
 void BaseOtSend(const std::shared_ptr<link::Context>& ctx,
                 absl::Span<std::array<Block, 2>> send_blocks);
 
 inline std::vector<Block> BaseOtRecv(const std::shared_ptr<link::Context>& ctx,
-                                     const std::vector<bool>& choices) {
+                                     const BitVector& choices) {
   std::vector<Block> blocks(choices.size());
   BaseOtRecv(ctx, choices, absl::MakeSpan(blocks));
   return blocks;
@@ -0,0 +1,182 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/base_ot_cache.h"
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/exception.h"
+#include "yasl/crypto/crhash.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/mpctools/ot/base_ot.h"
+#include "yasl/mpctools/snapshot/snapshot_store.h"
+#include "yasl/utils/rand.h"
+
+namespace yasl {
+
+namespace {
+
+constexpr char kFilePrefix[] = "base_ot_";
+constexpr char kFileSuffix[] = ".snap";
+
+}  // namespace
+
+BaseOtCache::BaseOtCache(std::string dir) : dir_(std::move(dir)) {
+  YASL_ENFORCE(!dir_.empty());
+  std::filesystem::create_directories(dir_);
+}
+
+std::string BaseOtCache::Key(const std::shared_ptr<link::Context>& ctx,
+                             bool is_sender, size_t num_ot) const {
+  return fmt::format("{}_{}_{}_{}", is_sender ? "send" : "recv",
+                     ctx->PartyIdByRank(ctx->Rank()),
+                     ctx->PartyIdByRank(ctx->NextRank()), num_ot);
+}
+
+std::string BaseOtCache::Path(const std::string& key) const {
+  return fmt::format("{}/{}{}{}", dir_, kFilePrefix, key, kFileSuffix);
+}
+
+BaseOtCache::Entry BaseOtCache::Lookup(const std::string& key,
+                                       bool is_sender) {
+  std::unique_lock lock(mutex_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    return it->second;
+  }
+  Entry entry;
+  const auto path = Path(key);
+  if (dir_.empty() || !std::filesystem::exists(path)) {
+    return entry;
+  }
+  // a broken file is a miss, the session runs fresh base ots and replaces
+  // it.
+  try {
+    SnapshotReader reader(path);
+    reader.Verify();
+    const auto id = reader.GetBlocks("id");
+    YASL_ENFORCE(id.size() == 1);
+    if (is_sender) {
+      entry.send = reader.GetBaseSendOptions("base");
+    } else {
+      entry.recv = reader.GetBaseRecvOptions("base");
+    }
+    entry.id = id[0];
+  } catch (const yasl::Exception& e) {
+    SPDLOG_WARN("ignore base ot cache {}: {}", path, e.what());
+    return Entry();
+  }
+  entries_.emplace(key, entry);
+  return entry;
+}
+
+void BaseOtCache::Store(const std::string& key, const Entry& entry) {
+  std::unique_lock lock(mutex_);
+  entries_[key] = entry;
+  if (dir_.empty()) {
+    return;
+  }
+  SnapshotWriter writer(Path(key));
+  writer.PutBlocks("id", {entry.id});
+  if (entry.send.blocks.empty()) {
+    writer.PutBaseOptions("base", entry.recv);
+  } else {
+    writer.PutBaseOptions("base", entry.send);
+  }
+  writer.Commit();
+}
+
+bool BaseOtCache::Hello(const std::shared_ptr<link::Context>& ctx,
+                        uint128_t id, uint128_t* sid) {
+  const std::array<uint128_t, 2> mine = {id, RandSeed()};
+  ctx->SendAsync(ctx->NextRank(), Buffer(mine.data(), sizeof(mine)),
+                 "BASE_OT_CACHE:HELLO");
+  const auto buf = ctx->Recv(ctx->NextRank(), "BASE_OT_CACHE:HELLO");
+  YASL_ENFORCE(static_cast<size_t>(buf.size()) == sizeof(mine),
+               "unexpected hello size={}", buf.size());
+  std::array<uint128_t, 2> peer;
+  std::memcpy(peer.data(), buf.data(), sizeof(peer));
+  *sid = mine[1] ^ peer[1];
+  return id != 0 && id == peer[0];
+}
+
+BaseSendOptions BaseOtCache::Send(const std::shared_ptr<link::Context>& ctx,
+                                  size_t num_ot) {
+  const auto key = Key(ctx, true, num_ot);
+  auto entry = Lookup(key, true);
+  uint128_t sid;
+  if (!Hello(ctx, entry.id, &sid) || entry.send.blocks.size() != num_ot) {
+    entry.send.blocks = BaseOtSend(ctx, num_ot);
+    do {
+      entry.id = RandSeed();
+    } while (entry.id == 0);
+    ctx->SendAsync(ctx->NextRank(), Buffer(&entry.id, sizeof(entry.id)),
+                   "BASE_OT_CACHE:ID");
+    Store(key, entry);
+  }
+
+  BaseSendOptions options;
+  options.blocks.resize(num_ot);
+  for (size_t i = 0; i < num_ot; ++i) {
+    options.blocks[i] = {TccrHash(entry.send.blocks[i][0], sid + i),
+                         TccrHash(entry.send.blocks[i][1], sid + i)};
+  }
+  return options;
+}
+
+BaseRecvOptions BaseOtCache::Recv(const std::shared_ptr<link::Context>& ctx,
+                                  size_t num_ot) {
+  const auto key = Key(ctx, false, num_ot);
+  auto entry = Lookup(key, false);
+  uint128_t sid;
+  if (!Hello(ctx, entry.id, &sid) || entry.recv.blocks.size() != num_ot) {
+    entry.recv.choices = CreateRandomChoices(num_ot);
+    entry.recv.blocks = BaseOtRecv(ctx, entry.recv.choices);
+    const auto buf = ctx->Recv(ctx->NextRank(), "BASE_OT_CACHE:ID");
+    YASL_ENFORCE(static_cast<size_t>(buf.size()) == sizeof(entry.id),
+                 "unexpected id size={}", buf.size());
+    std::memcpy(&entry.id, buf.data(), sizeof(entry.id));
+    Store(key, entry);
+  }
+
+  BaseRecvOptions options;
+  options.choices = entry.recv.choices;
+  options.blocks.resize(num_ot);
+  TccrHash(entry.recv.blocks, sid, absl::MakeSpan(options.blocks));
+  return options;
+}
+
+void BaseOtCache::Clear() {
+  std::unique_lock lock(mutex_);
+  entries_.clear();
+  if (dir_.empty()) {
+    return;
+  }
+  for (const auto& file : std::filesystem::directory_iterator(dir_)) {
+    const auto name = file.path().filename().string();
+    if (name.rfind(kFilePrefix, 0) == 0) {
+      std::filesystem::remove(file.path());
+    }
+  }
+}
+
+}  // namespace yasl
@@ -0,0 +1,90 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "yasl/base/int128.h"
+#include "yasl/link/link.h"
+#include "yasl/mpctools/ot/options.h"
+
+namespace yasl {
+
+// Base ots of a pair of parties, run once and re-randomized per session, so
+// that sessions after the first one extend ots without public key
+// operations.
+//
+// An entry is keyed by the party ids of both sides, the role and the number
+// of ots, and carries an id picked by the base ot sender. A session starts
+// by one exchange of the ids held by both sides and of a nonce of each:
+//   * the same id, the base ots of the session are TccrHash(k_i, sid + i)
+//     of the cached keys k_i, sid the xor of the nonces.
+//   * otherwise, e.g. a side restarted without its cache, fresh base ots are
+//     run and cached, then derived likewise.
+// The choice bits, so the delta of IKNP, are kept across sessions, as a
+// CorrelatedOtPool keeps them across refills.
+//
+// Sessions with the same peer may run concurrently. Entries of concurrent
+// first sessions may end different on both sides, the next session runs
+// fresh base ots then.
+class BaseOtCache {
+ public:
+  // entries kept in memory.
+  BaseOtCache() = default;
+  // entries also kept in snapshot files of dir, see SnapshotWriter, so that
+  // they survive restarts.
+  explicit BaseOtCache(std::string dir);
+
+  // base ots of a session with the next rank of ctx, this party is the base
+  // ot sender, i.e. the receiver of an ot extension, peer calls Recv.
+  BaseSendOptions Send(const std::shared_ptr<link::Context>& ctx,
+                       size_t num_ot);
+  BaseRecvOptions Recv(const std::shared_ptr<link::Context>& ctx,
+                       size_t num_ot);
+
+  // drops all entries, files included.
+  void Clear();
+
+ private:
+  struct Entry {
+    // 0 for none.
+    uint128_t id = 0;
+    BaseSendOptions send;
+    BaseRecvOptions recv;
+  };
+
+  std::string Key(const std::shared_ptr<link::Context>& ctx, bool is_sender,
+                  size_t num_ot) const;
+  std::string Path(const std::string& key) const;
+
+  // the entry of key, loaded from dir if not in memory.
+  Entry Lookup(const std::string& key, bool is_sender);
+  void Store(const std::string& key, const Entry& entry);
+
+  // sends our id and nonce, returns whether peer holds the same id, and the
+  // sid.
+  static bool Hello(const std::shared_ptr<link::Context>& ctx, uint128_t id,
+                    uint128_t* sid);
+
+  const std::string dir_;
+  std::mutex mutex_;
+  std::map<std::string, Entry> entries_;
+};
+
+}  // namespace yasl
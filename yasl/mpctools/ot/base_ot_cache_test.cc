@@ -0,0 +1,125 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/base_ot_cache.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <future>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+#include "yasl/link/test_util.h"
+
+namespace yasl {
+namespace {
+
+void CheckBaseOts(const BaseSendOptions& send, const BaseRecvOptions& recv) {
+  ASSERT_EQ(send.blocks.size(), recv.blocks.size());
+  ASSERT_EQ(recv.choices.size(), recv.blocks.size());
+  for (size_t i = 0; i < send.blocks.size(); ++i) {
+    EXPECT_EQ(send.blocks[i][recv.choices[i]], recv.blocks[i]);
+    EXPECT_NE(send.blocks[i][!recv.choices[i]], recv.blocks[i]);
+  }
+}
+
+std::pair<BaseSendOptions, BaseRecvOptions> RunSession(
+    const std::vector<std::shared_ptr<link::Context>>& contexts,
+    BaseOtCache* sender_cache, BaseOtCache* receiver_cache, size_t num_ot) {
+  auto sender = std::async(
+      [&] { return sender_cache->Send(contexts[0], num_ot); });
+  auto receiver = std::async(
+      [&] { return receiver_cache->Recv(contexts[1], num_ot); });
+  return {sender.get(), receiver.get()};
+}
+
+TEST(BaseOtCacheTest, SessionsAreFresh) {
+  auto contexts = link::test::SetupWorld(2);
+  BaseOtCache sender_cache;
+  BaseOtCache receiver_cache;
+
+  auto [send1, recv1] =
+      RunSession(contexts, &sender_cache, &receiver_cache, 128);
+  CheckBaseOts(send1, recv1);
+  const auto sent = contexts[0]->GetStats()->sent_actions.load();
+
+  auto [send2, recv2] =
+      RunSession(contexts, &sender_cache, &receiver_cache, 128);
+  CheckBaseOts(send2, recv2);
+  // the delta is kept, the keys are not.
+  EXPECT_EQ(recv1.choices, recv2.choices);
+  EXPECT_NE(send1.blocks[0][0], send2.blocks[0][0]);
+  // no base ots, a hello msg only.
+  EXPECT_EQ(contexts[0]->GetStats()->sent_actions.load(), sent + 1);
+}
+
+TEST(BaseOtCacheTest, PeerLostItsCache) {
+  auto contexts = link::test::SetupWorld(2);
+  BaseOtCache sender_cache;
+  BaseOtCache receiver_cache;
+  RunSession(contexts, &sender_cache, &receiver_cache, 128);
+
+  receiver_cache.Clear();
+  auto [send, recv] = RunSession(contexts, &sender_cache, &receiver_cache, 128);
+  CheckBaseOts(send, recv);
+  // and the new entries agree.
+  auto [send2, recv2] =
+      RunSession(contexts, &sender_cache, &receiver_cache, 128);
+  CheckBaseOts(send2, recv2);
+  EXPECT_EQ(recv.choices, recv2.choices);
+}
+
+TEST(BaseOtCacheTest, RolesAndSizesAreApart) {
+  auto contexts = link::test::SetupWorld(2);
+  BaseOtCache cache0;
+  BaseOtCache cache1;
+  auto [send, recv] = RunSession(contexts, &cache0, &cache1, 128);
+  CheckBaseOts(send, recv);
+  auto [send512, recv512] = RunSession(contexts, &cache0, &cache1, 512);
+  CheckBaseOts(send512, recv512);
+
+  // party 1 as the sender.
+  auto sender = std::async([&] { return cache1.Send(contexts[1], 128); });
+  auto receiver = std::async([&] { return cache0.Recv(contexts[0], 128); });
+  CheckBaseOts(sender.get(), receiver.get());
+}
+
+TEST(BaseOtCacheTest, SurvivesRestarts) {
+  const auto dir = std::filesystem::temp_directory_path() /
+                   ("base_ot_cache_test_" + std::to_string(getpid()));
+  auto contexts = link::test::SetupWorld(2);
+  BaseRecvOptions first;
+  {
+    BaseOtCache sender_cache(dir / "0");
+    BaseOtCache receiver_cache(dir / "1");
+    first = RunSession(contexts, &sender_cache, &receiver_cache, 128).second;
+  }
+  BaseOtCache sender_cache(dir / "0");
+  BaseOtCache receiver_cache(dir / "1");
+  const auto sent = contexts[0]->GetStats()->sent_actions.load();
+  auto [send, recv] = RunSession(contexts, &sender_cache, &receiver_cache, 128);
+  CheckBaseOts(send, recv);
+  EXPECT_EQ(recv.choices, first.choices);
+  EXPECT_EQ(contexts[0]->GetStats()->sent_actions.load(), sent + 1);
+
+  sender_cache.Clear();
+  EXPECT_TRUE(std::filesystem::is_empty(dir / "0"));
+  std::filesystem::remove_all(dir);
+}
+
+}  // namespace
+}  // namespace yasl
@@ -17,6 +17,7 @@
 
 #include "absl/types/span.h"
 
+#include "yasl/base/bit_vector.h"
 #include "yasl/base/int128.h"
 #include "yasl/link/link.h"
 
@@ -30,7 +31,7 @@ class BaseOTInterface {
   virtual void Send(const std::shared_ptr<link::Context>& ctx,
                     absl::Span<std::array<Block, 2>> send_blocks) = 0;
   virtual void Recv(const std::shared_ptr<link::Context>& ctx,
-                    const std::vector<bool>& choices,
+                    const BitVector& choices,
                     absl::Span<Block> recv_blocks) = 0;
 };
 
@@ -15,6 +15,7 @@
 
 #include "yasl/mpctools/ot/base_ot.h"
 
+#include <algorithm>
 #include <future>
 #include <thread>
 
@@ -46,7 +47,7 @@ TEST_P(BaseOtTest, Works) {
   recv_blocks.resize(params.num_ot);
 
   // WHEN
-  std::vector<bool> choices = CreateRandomChoices(params.num_ot);
+  BitVector choices = CreateRandomChoices(params.num_ot);
   std::future<void> sender =
       std::async([&] { BaseOtSend(contexts[0], absl::MakeSpan(send_blocks)); });
   std::future<void> receiver = std::async(
@@ -72,7 +73,7 @@ TEST(BaseOtEdgeTest, Test) {
   // GIVEN
   std::vector<std::array<Block, 2>> send_blocks;
   std::vector<Block> recv_blocks;
-  std::vector<bool> choices;
+  BitVector choices;
 
   auto contexts = link::test::SetupWorld(2);
 
@@ -83,4 +84,79 @@ TEST(BaseOtEdgeTest, Test) {
                ::yasl::Exception);
 }
 
+TEST(BaseOtBackendTest, AllBackendsWork) {
+  auto contexts = link::test::SetupWorld(2);
+  const size_t num_ot = 77;
+  const auto choices = CreateRandomChoices(num_ot);
+
+  // later tests run on the default backend.
+  struct ResetBackend {
+    ~ResetBackend() { SetBaseOtBackend(kAutoBaseOtBackend); }
+  } reset;
+
+  const auto backends = ListBaseOtBackends();
+  EXPECT_NE(std::find(backends.begin(), backends.end(), "portable"),
+            backends.end());
+  for (const auto& backend : backends) {
+    SetBaseOtBackend(backend);
+    EXPECT_EQ(GetBaseOtBackend(), backend);
+
+    std::vector<std::array<Block, 2>> send_blocks(num_ot);
+    std::vector<Block> recv_blocks(num_ot);
+    auto sender = std::async(
+        [&] { BaseOtSend(contexts[0], absl::MakeSpan(send_blocks)); });
+    auto receiver = std::async(
+        [&] { BaseOtRecv(contexts[1], choices, absl::MakeSpan(recv_blocks)); });
+    sender.get();
+    receiver.get();
+    for (size_t i = 0; i < num_ot; ++i) {
+      EXPECT_EQ(send_blocks[i][choices[i]], recv_blocks[i]) << backend;
+      EXPECT_NE(send_blocks[i][0], send_blocks[i][1]) << backend;
+    }
+  }
+
+  SetBaseOtBackend(kAutoBaseOtBackend);
+  const auto fastest = GetBaseOtBackend();
+  EXPECT_NE(std::find(backends.begin(), backends.end(), fastest),
+            backends.end());
+}
+
+TEST(BaseOtBackendTest, ShouldThrowOnUnknownBackend) {
+  EXPECT_THROW(SetBaseOtBackend("unknown"), ::yasl::Exception);
+  EXPECT_THROW(RegisterBaseOtBackend("auto", nullptr), ::yasl::Exception);
+}
+
+TEST(BaseOtBackendTest, ShouldThrowOnBackendMissingOnPeer) {
+  auto contexts = link::test::SetupWorld(2);
+  struct ResetBackend {
+    ~ResetBackend() { SetBaseOtBackend(kAutoBaseOtBackend); }
+  } reset;
+  SetBaseOtBackend("portable");
+
+  // a receiver without the backend of sender.
+  auto receiver = std::async(std::launch::async, [&] {
+    contexts[1]->SendAsync(0, ByteContainerView("other,ristretto"),
+                           "BASE_OT:AVAILABLE");
+    return contexts[1]->Recv(0, "BASE_OT:BACKEND");
+  });
+  std::vector<std::array<Block, 2>> send_blocks(8);
+  EXPECT_THROW(BaseOtSend(contexts[0], absl::MakeSpan(send_blocks)),
+               ::yasl::Exception);
+  // which is told to fail too.
+  EXPECT_EQ(receiver.get().size(), 0);
+}
+
+TEST(BaseOtBackendTest, ReceiverShouldThrowWithoutCommonBackend) {
+  auto contexts = link::test::SetupWorld(2);
+  auto sender = std::async(std::launch::async, [&] {
+    contexts[0]->Recv(1, "BASE_OT:AVAILABLE");
+    contexts[0]->SendAsync(1, ByteContainerView(), "BASE_OT:BACKEND");
+  });
+  const auto choices = CreateRandomChoices(8);
+  std::vector<Block> recv_blocks(8);
+  EXPECT_THROW(BaseOtRecv(contexts[1], choices, absl::MakeSpan(recv_blocks)),
+               ::yasl::Exception);
+  sender.get();
+}
+
 }  // namespace yasl
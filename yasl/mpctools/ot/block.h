@@ -126,4 +126,85 @@ inline block toBlock(const std::uint8_t* data) {
   return toBlock(((std::uint64_t*)data)[1], ((std::uint64_t*)data)[0]);
 }
 
+// N consecutive blocks as one value, operators work lane by lane. Lanes are
+// plain sse blocks so that the type builds on every target, compilers fuse
+// them into ymm/zmm registers when allowed. Bulk ops over spans that pick
+// avx2/avx512 at runtime are in utils.h.
+template <size_t N>
+struct alignas(16 * N) wide_block {
+  std::array<block, N> mData;
+
+  wide_block() = default;
+  wide_block(const wide_block&) = default;
+  wide_block(const std::array<block, N>& x) : mData(x) {}
+
+  wide_block& operator=(const wide_block&) = default;
+
+  block& operator[](size_t i) { return mData[i]; }
+  const block& operator[](size_t i) const { return mData[i]; }
+
+  inline wide_block operator^(const wide_block& rhs) const {
+    wide_block r;
+    for (size_t i = 0; i < N; ++i) r.mData[i] = mData[i] ^ rhs.mData[i];
+    return r;
+  }
+  inline wide_block operator+(const wide_block& rhs) const {
+    wide_block r;
+    for (size_t i = 0; i < N; ++i) r.mData[i] = mData[i] + rhs.mData[i];
+    return r;
+  }
+  inline wide_block operator&(const wide_block& rhs) const {
+    wide_block r;
+    for (size_t i = 0; i < N; ++i) r.mData[i] = mData[i] & rhs.mData[i];
+    return r;
+  }
+  inline wide_block operator|(const wide_block& rhs) const {
+    wide_block r;
+    for (size_t i = 0; i < N; ++i) r.mData[i] = mData[i] | rhs.mData[i];
+    return r;
+  }
+  inline wide_block operator<<(const std::uint8_t& rhs) const {
+    wide_block r;
+    for (size_t i = 0; i < N; ++i) r.mData[i] = mData[i] << rhs;
+    return r;
+  }
+  inline wide_block operator>>(const std::uint8_t& rhs) const {
+    wide_block r;
+    for (size_t i = 0; i < N; ++i) r.mData[i] = mData[i] >> rhs;
+    return r;
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_trivially_copyable_v<T> &&
+                              (sizeof(T) <= 16 * N) &&
+                              (16 * N % sizeof(T) == 0),
+                          std::array<T, 16 * N / sizeof(T)>&>::type
+  as() {
+    return *(std::array<T, 16 * N / sizeof(T)>*)this;
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_trivially_copyable_v<T> &&
+                              (sizeof(T) <= 16 * N) &&
+                              (16 * N % sizeof(T) == 0),
+                          const std::array<T, 16 * N / sizeof(T)>&>::type
+  as() const {
+    return *(const std::array<T, 16 * N / sizeof(T)>*)this;
+  }
+};
+
+using block256 = wide_block<2>;
+using block512 = wide_block<4>;
+
+static_assert(sizeof(block256) == 32);
+static_assert(sizeof(block512) == 64);
+
+// view blocks as wide blocks, the span is cut to whole wide blocks. the data
+// should be aligned to the wide block.
+template <size_t N>
+inline absl::Span<wide_block<N>> AsWideBlocks(absl::Span<block> blocks) {
+  return absl::MakeSpan(reinterpret_cast<wide_block<N>*>(blocks.data()),
+                        blocks.size() / N);
+}
+
 }  // namespace yasl
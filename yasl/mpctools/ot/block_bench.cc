@@ -274,6 +274,64 @@ static void BM_Uint128LShift(benchmark::State& state) {
   }
 }
 
+static void BM_Block256Xor(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t n = state.range(0);
+    std::vector<yasl::block> a = GenerateRandomBlock(n);
+    std::vector<yasl::block> b = GenerateRandomBlock(n);
+    auto wa = yasl::AsWideBlocks<2>(absl::MakeSpan(a));
+    auto wb = yasl::AsWideBlocks<2>(absl::MakeSpan(b));
+
+    state.ResumeTiming();
+    for (size_t i = 0; i < wa.size(); i++) {
+      benchmark::DoNotOptimize(wa[i] = wa[i] ^ wb[i]);
+    }
+  }
+}
+
+static void BM_Block512Xor(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t n = state.range(0);
+    std::vector<yasl::block> a = GenerateRandomBlock(n);
+    std::vector<yasl::block> b = GenerateRandomBlock(n);
+    auto wa = yasl::AsWideBlocks<4>(absl::MakeSpan(a));
+    auto wb = yasl::AsWideBlocks<4>(absl::MakeSpan(b));
+
+    state.ResumeTiming();
+    for (size_t i = 0; i < wa.size(); i++) {
+      benchmark::DoNotOptimize(wa[i] = wa[i] ^ wb[i]);
+    }
+  }
+}
+
+static void BM_XorBlocks(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t n = state.range(0);
+    std::vector<yasl::block> a = GenerateRandomBlock(n);
+    std::vector<yasl::block> b = GenerateRandomBlock(n);
+
+    state.ResumeTiming();
+    yasl::XorBlocks(absl::MakeSpan(a), absl::MakeConstSpan(b));
+    benchmark::DoNotOptimize(a.data());
+  }
+}
+
+static void BM_AndBlocks(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t n = state.range(0);
+    std::vector<yasl::block> a = GenerateRandomBlock(n);
+    std::vector<yasl::block> b = GenerateRandomBlock(n);
+
+    state.ResumeTiming();
+    yasl::AndBlocks(absl::MakeSpan(a), absl::MakeConstSpan(b));
+    benchmark::DoNotOptimize(a.data());
+  }
+}
+
 namespace {
 std::vector<std::vector<yasl::block>> GenerateMatrixBlock(size_t n) {
   std::random_device rd;
@@ -499,4 +557,40 @@ BENCHMARK(BM_Uint128LShift)
     ->Arg(8192000)
     ->Arg(16384000);
 
+BENCHMARK(BM_Block256Xor)
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(g_interations)
+    ->Arg(1024000)
+    ->Arg(2048000)
+    ->Arg(4096000)
+    ->Arg(8192000)
+    ->Arg(16384000);
+
+BENCHMARK(BM_Block512Xor)
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(g_interations)
+    ->Arg(1024000)
+    ->Arg(2048000)
+    ->Arg(4096000)
+    ->Arg(8192000)
+    ->Arg(16384000);
+
+BENCHMARK(BM_XorBlocks)
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(g_interations)
+    ->Arg(1024000)
+    ->Arg(2048000)
+    ->Arg(4096000)
+    ->Arg(8192000)
+    ->Arg(16384000);
+
+BENCHMARK(BM_AndBlocks)
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(g_interations)
+    ->Arg(1024000)
+    ->Arg(2048000)
+    ->Arg(4096000)
+    ->Arg(8192000)
+    ->Arg(16384000);
+
 BENCHMARK_MAIN();
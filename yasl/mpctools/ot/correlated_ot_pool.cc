@@ -0,0 +1,453 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/correlated_ot_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <utility>
+
+#include "fmt/format.h"
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/exception.h"
+#include "yasl/crypto/hash_util.h"
+#include "yasl/crypto/random_oracle.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/io/stream/file_io.h"
+#include "yasl/mpctools/ot/iknp_ot_extension.h"
+
+namespace yasl {
+
+namespace {
+
+constexpr size_t kKappa = 128;
+
+constexpr char kBatchPrefix[] = "batch_";
+constexpr char kCursorName[] = "cursor";
+constexpr char kTmpSuffix[] = ".tmp";
+
+// a batch file is the header, m0 or m_c of all COTs, and then choice bits of
+// receiver.
+struct BatchHeader {
+  uint64_t size;
+  uint64_t epoch;
+};
+
+// the cursor file, where the front batch is taken to.
+struct Cursor {
+  uint64_t epoch;
+  uint64_t offset;
+  uint64_t next_epoch;
+};
+
+size_t NumChoiceBlocks(size_t n) { return (n + kKappa - 1) / kKappa; }
+
+bool GetBit(const uint8_t* bits, size_t idx) {
+  return (bits[idx / 8] >> (idx % 8)) & 1;
+}
+
+void SetBit(std::vector<uint128_t>* bits, size_t idx) {
+  (*bits)[idx / kKappa] |= uint128_t(1) << (idx % kKappa);
+}
+
+// base ot keys of a refill, so that IKNP prgs never repeat across refills,
+// while the base choices, and so delta, are kept.
+uint128_t Rekey(uint128_t key, uint64_t epoch) {
+  std::array<uint8_t, sizeof(key) + sizeof(epoch)> buf;
+  std::memcpy(buf.data(), &key, sizeof(key));
+  std::memcpy(buf.data() + sizeof(key), &epoch, sizeof(epoch));
+  const auto digest = crypto::Sha256Fixed(buf);
+  uint128_t ret;
+  std::memcpy(&ret, digest.data(), sizeof(ret));
+  return ret;
+}
+
+// write the file by a rename, so that a crash never leaves half of it.
+void WriteFile(const std::string& path,
+               std::initializer_list<std::pair<const void*, size_t>> parts) {
+  const std::string tmp_path = path + kTmpSuffix;
+  {
+    io::FileOutputStream out(tmp_path);
+    for (const auto& [data, size] : parts) {
+      out.Write(data, size);
+    }
+    out.Close();
+  }
+  std::filesystem::rename(tmp_path, path);
+}
+
+}  // namespace
+
+CorrelatedOtPool::CorrelatedOtPool(std::shared_ptr<link::Context> ctx,
+                                   bool is_sender, Options options)
+    : ctx_(std::move(ctx)),
+      refill_ctx_(ctx_->Spawn()),
+      is_sender_(is_sender),
+      options_(std::move(options)) {
+  YASL_ENFORCE(options_.batch_size > 0);
+  YASL_ENFORCE(options_.first_batch_size <= options_.batch_size,
+               "first_batch_size={} over batch_size={}",
+               options_.first_batch_size, options_.batch_size);
+}
+
+CorrelatedOtPool::CorrelatedOtPool(std::shared_ptr<link::Context> ctx,
+                                   BaseRecvOptions base_options,
+                                   Options options)
+    : CorrelatedOtPool(std::move(ctx), true, std::move(options)) {
+  YASL_ENFORCE(base_options.choices.size() == kKappa &&
+               base_options.blocks.size() == kKappa);
+  recv_base_ = std::move(base_options);
+  delta_ = recv_base_.choices.words()[0];
+  Start();
+}
+
+CorrelatedOtPool::CorrelatedOtPool(std::shared_ptr<link::Context> ctx,
+                                   BaseSendOptions base_options,
+                                   Options options)
+    : CorrelatedOtPool(std::move(ctx), false, std::move(options)) {
+  YASL_ENFORCE(base_options.blocks.size() == kKappa);
+  send_base_ = std::move(base_options);
+  Start();
+}
+
+CorrelatedOtPool::~CorrelatedOtPool() {
+  {
+    std::unique_lock lock(mutex_);
+    stopped_ = true;
+    if (!options_.dir.empty()) {
+      SaveCursor();
+    }
+  }
+  cond_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+uint128_t CorrelatedOtPool::Delta() const {
+  YASL_ENFORCE(is_sender_, "delta is held by sender only");
+  return delta_;
+}
+
+size_t CorrelatedOtPool::Stock() const {
+  std::unique_lock lock(mutex_);
+  return stock_;
+}
+
+std::string CorrelatedOtPool::BatchPath(uint64_t epoch) const {
+  return fmt::format("{}/{}{}", options_.dir, kBatchPrefix, epoch);
+}
+
+std::string CorrelatedOtPool::CursorPath() const {
+  return fmt::format("{}/{}", options_.dir, kCursorName);
+}
+
+void CorrelatedOtPool::LoadBatches() {
+  std::filesystem::create_directories(options_.dir);
+
+  Cursor cursor{0, 0, 0};
+  if (std::filesystem::exists(CursorPath())) {
+    io::FileInputStream in(CursorPath());
+    YASL_ENFORCE(in.GetLength() == sizeof(cursor), "corrupted cursor {}",
+                 CursorPath());
+    in.Read(&cursor, sizeof(cursor));
+  }
+
+  std::map<uint64_t, std::string> paths;
+  for (const auto& entry : std::filesystem::directory_iterator(options_.dir)) {
+    const std::string name = entry.path().filename().string();
+    if (name.rfind(kBatchPrefix, 0) != 0 ||
+        name.find(kTmpSuffix) != std::string::npos) {
+      continue;
+    }
+    const uint64_t epoch = std::stoull(name.substr(sizeof(kBatchPrefix) - 1));
+    paths.emplace(epoch, entry.path().string());
+  }
+
+  for (const auto& [epoch, path] : paths) {
+    if (epoch < cursor.epoch) {
+      // taken up before the last run stopped, but not removed yet.
+      std::filesystem::remove(path);
+      continue;
+    }
+    BatchHeader header;
+    io::FileInputStream in(path);
+    YASL_ENFORCE(in.GetLength() >= sizeof(header), "corrupted batch {}", path);
+    in.Read(&header, sizeof(header));
+    const size_t choices_size =
+        is_sender_ ? 0 : NumChoiceBlocks(header.size) * sizeof(uint128_t);
+    YASL_ENFORCE(header.epoch == epoch &&
+                     in.GetLength() == sizeof(header) +
+                                           header.size * sizeof(uint128_t) +
+                                           choices_size,
+                 "corrupted batch {}", path);
+
+    Batch batch;
+    batch.epoch = epoch;
+    batch.size = header.size;
+    batch.path = path;
+    stock_ += batch.size;
+    batches_.push_back(std::move(batch));
+    next_epoch_ = epoch + 1;
+  }
+
+  if (!batches_.empty() && batches_.front().epoch == cursor.epoch) {
+    YASL_ENFORCE(cursor.offset < batches_.front().size);
+    offset_ = cursor.offset;
+    stock_ -= offset_;
+  }
+  next_epoch_ = std::max<uint64_t>(next_epoch_, cursor.next_epoch);
+}
+
+void CorrelatedOtPool::SaveCursor() {
+  Cursor cursor{batches_.empty() ? next_epoch_ : batches_.front().epoch,
+                offset_, next_epoch_};
+  WriteFile(CursorPath(), {{&cursor, sizeof(cursor)}});
+}
+
+void CorrelatedOtPool::Start() {
+  if (!options_.dir.empty()) {
+    LoadBatches();
+  }
+  thread_ = std::thread([this] { Refill(); });
+}
+
+void CorrelatedOtPool::Refill() {
+  // both sides refill in the same order, so agree on the sizes.
+  size_t batch_size = options_.first_batch_size == 0
+                          ? options_.batch_size
+                          : options_.first_batch_size;
+  while (true) {
+    uint64_t epoch;
+    {
+      // stock is topped up to depth even if stopped, so that the peer never
+      // waits for a refill that is given up by this side.
+      std::unique_lock lock(mutex_);
+      auto needs_refill = [&] {
+        return stock_ < std::max(options_.depth, wanted_);
+      };
+      cond_.wait(lock, [&] { return stopped_ || needs_refill(); });
+      if (!needs_refill()) {
+        return;
+      }
+      epoch = next_epoch_;
+    }
+
+    Batch batch;
+    batch.epoch = epoch;
+    batch.size = batch_size;
+    batch_size = std::min(batch_size * 2, options_.batch_size);
+    batch.blocks.resize(batch.size);
+    try {
+      if (is_sender_) {
+        BaseRecvOptions base = recv_base_;
+        for (auto& block : base.blocks) {
+          block = Rekey(block, epoch);
+        }
+        IknpCotSend(refill_ctx_, base, absl::MakeSpan(batch.blocks));
+      } else {
+        BaseSendOptions base = send_base_;
+        for (auto& blocks : base.blocks) {
+          blocks = {Rekey(blocks[0], epoch), Rekey(blocks[1], epoch)};
+        }
+        batch.choices = CreateRandomChoiceBits<uint128_t>(batch.size);
+        IknpCotRecv(refill_ctx_, base, batch.choices,
+                    absl::MakeSpan(batch.blocks));
+      }
+
+      if (!options_.dir.empty()) {
+        BatchHeader header{batch.size, epoch};
+        batch.path = BatchPath(epoch);
+        WriteFile(batch.path, {{&header, sizeof(header)},
+                               {batch.blocks.data(),
+                                batch.blocks.size() * sizeof(uint128_t)},
+                               {batch.choices.data(),
+                                batch.choices.size() * sizeof(uint128_t)}});
+        batch.blocks = {};
+        batch.choices = {};
+      }
+    } catch (...) {
+      std::unique_lock lock(mutex_);
+      error_ = std::current_exception();
+      cond_.notify_all();
+      return;
+    }
+
+    std::unique_lock lock(mutex_);
+    stock_ += batch.size;
+    batches_.push_back(std::move(batch));
+    next_epoch_ = epoch + 1;
+    if (!options_.dir.empty()) {
+      SaveCursor();
+    }
+    cond_.notify_all();
+  }
+}
+
+void CorrelatedOtPool::Take(size_t n, std::vector<uint128_t>* blocks,
+                            std::vector<uint128_t>* choices) {
+  blocks->resize(n);
+  if (choices != nullptr) {
+    choices->assign(NumChoiceBlocks(n), 0);
+  }
+
+  std::unique_lock lock(mutex_);
+  wanted_ = n;
+  cond_.notify_all();
+  cond_.wait(lock, [&] { return error_ || stock_ >= n; });
+  wanted_ = 0;
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+
+  std::vector<std::string> taken_paths;
+  for (size_t pos = 0; pos < n;) {
+    Batch& batch = batches_.front();
+    const auto* data = reinterpret_cast<const uint8_t*>(batch.blocks.data());
+    const auto* bits = reinterpret_cast<const uint8_t*>(batch.choices.data());
+    if (!batch.path.empty()) {
+      if (!batch.file) {
+        batch.file = std::make_unique<io::MmappedFile>(batch.path);
+      }
+      data = reinterpret_cast<const uint8_t*>(batch.file->data()) +
+             sizeof(BatchHeader);
+      bits = data + batch.size * sizeof(uint128_t);
+    }
+
+    const size_t len = std::min(n - pos, batch.size - offset_);
+    std::memcpy(blocks->data() + pos, data + offset_ * sizeof(uint128_t),
+                len * sizeof(uint128_t));
+    if (choices != nullptr) {
+      for (size_t i = 0; i < len; ++i) {
+        if (GetBit(bits, offset_ + i)) {
+          SetBit(choices, pos + i);
+        }
+      }
+    }
+    pos += len;
+    offset_ += len;
+
+    if (offset_ == batch.size) {
+      if (!batch.path.empty()) {
+        taken_paths.push_back(std::move(batch.path));
+      }
+      batches_.pop_front();
+      offset_ = 0;
+    }
+  }
+  stock_ -= n;
+  // persisted before the ots are returned, so that a crash never serves
+  // them again. taken batches are removed after, LoadBatches skips them.
+  if (!options_.dir.empty()) {
+    SaveCursor();
+    for (const auto& path : taken_paths) {
+      std::filesystem::remove(path);
+    }
+  }
+  cond_.notify_all();
+}
+
+std::vector<uint128_t> CorrelatedOtPool::TakeCot(size_t n) {
+  YASL_ENFORCE(is_sender_, "receiver takes COTs with choices");
+  std::vector<uint128_t> blocks;
+  Take(n, &blocks, nullptr);
+  return blocks;
+}
+
+std::vector<uint128_t> CorrelatedOtPool::TakeCot(
+    size_t n, std::vector<uint128_t>* choices) {
+  YASL_ENFORCE(!is_sender_, "sender takes COTs without choices");
+  YASL_ENFORCE(choices != nullptr);
+  std::vector<uint128_t> blocks;
+  Take(n, &blocks, choices);
+  return blocks;
+}
+
+std::vector<std::array<uint128_t, 2>> CorrelatedOtPool::TakeRot(size_t n) {
+  auto h0 = TakeCot(n);
+  std::vector<uint128_t> h1(n);
+  for (size_t i = 0; i < n; ++i) {
+    h1[i] = h0[i] ^ delta_;
+  }
+  RandomOracle::GetDefault().Gen(h0, absl::MakeSpan(h0));
+  RandomOracle::GetDefault().Gen(h1, absl::MakeSpan(h1));
+  std::vector<std::array<uint128_t, 2>> ret(n);
+  for (size_t i = 0; i < n; ++i) {
+    ret[i] = {h0[i], h1[i]};
+  }
+  return ret;
+}
+
+std::vector<uint128_t> CorrelatedOtPool::TakeRot(
+    size_t n, std::vector<uint128_t>* choices) {
+  auto blocks = TakeCot(n, choices);
+  RandomOracle::GetDefault().Gen(blocks, absl::MakeSpan(blocks));
+  return blocks;
+}
+
+void CorrelatedOtPool::SendOt(absl::Span<const std::array<uint128_t, 2>> msgs) {
+  YASL_ENFORCE(!msgs.empty());
+  const size_t n = msgs.size();
+  const auto rots = TakeRot(n);
+
+  // d = c ^ r of receiver, so that y_b = m_b ^ H(k_{b ^ d}) is unmasked by
+  // H(k_r) of the chosen one.
+  auto buf = ctx_->Recv(ctx_->NextRank(), "OT_POOL:CHOICES");
+  YASL_ENFORCE(static_cast<size_t>(buf.size()) ==
+                   NumChoiceBlocks(n) * sizeof(uint128_t),
+               "unexpected choices size={}, num_ot={}", buf.size(), n);
+  const auto* flips = buf.data<uint8_t>();
+
+  Buffer corrections(static_cast<int64_t>(n * sizeof(msgs[0])));
+  auto* y = corrections.data<std::array<uint128_t, 2>>();
+  for (size_t i = 0; i < n; ++i) {
+    const int d = GetBit(flips, i) ? 1 : 0;
+    y[i] = {msgs[i][0] ^ rots[i][d], msgs[i][1] ^ rots[i][1 ^ d]};
+  }
+  ctx_->SendAsync(ctx_->NextRank(), std::move(corrections),
+                  "OT_POOL:CORRECTIONS");
+}
+
+void CorrelatedOtPool::RecvOt(absl::Span<const uint128_t> choices,
+                              absl::Span<uint128_t> recv_msgs) {
+  YASL_ENFORCE(!recv_msgs.empty());
+  const size_t n = recv_msgs.size();
+  YASL_ENFORCE(choices.size() == NumChoiceBlocks(n),
+               "unexpected choices size={}, num_ot={}", choices.size(), n);
+
+  std::vector<uint128_t> rand_choices;
+  const auto keys = TakeRot(n, &rand_choices);
+  for (size_t i = 0; i < rand_choices.size(); ++i) {
+    rand_choices[i] ^= choices[i];
+  }
+  ctx_->SendAsync(ctx_->NextRank(),
+                  ByteContainerView(rand_choices.data(),
+                                    rand_choices.size() * sizeof(uint128_t)),
+                  "OT_POOL:CHOICES");
+
+  auto buf = ctx_->Recv(ctx_->NextRank(), "OT_POOL:CORRECTIONS");
+  YASL_ENFORCE(static_cast<size_t>(buf.size()) ==
+                   n * sizeof(std::array<uint128_t, 2>),
+               "unexpected corrections size={}, num_ot={}", buf.size(), n);
+  const auto* y = buf.data<std::array<uint128_t, 2>>();
+  const auto* bits = reinterpret_cast<const uint8_t*>(choices.data());
+  for (size_t i = 0; i < n; ++i) {
+    recv_msgs[i] = y[i][GetBit(bits, i) ? 1 : 0] ^ keys[i];
+  }
+}
+
+}  // namespace yasl
@@ -0,0 +1,161 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/io/rw/mmapped_file.h"
+#include "yasl/link/link.h"
+#include "yasl/mpctools/ot/options.h"
+
+namespace yasl {
+
+// CorrelatedOtPool pre-generates IKNP COTs in the background, so that the
+// OT extension is off the critical path of online queries.
+//
+// COTs share the global delta of sender, m1 = m0 ^ delta, random OTs are
+// hashed from them locally, and chosen OTs only take the two correction
+// msgs online. Each refill extends `batch_size` COTs with base ots re-keyed
+// by its epoch, so that the IKNP prgs are never repeated.
+//
+// NOTE
+//  * both sides must be created with the same options, and take the same
+//    number of ots in the same order.
+//  * destruction waits for the stock to be refilled to depth, which takes
+//    the peer, so destroy both sides after their last take.
+class CorrelatedOtPool {
+ public:
+  struct Options {
+    // COTs kept in stock ahead of takes, refilled whenever the stock drops
+    // below it.
+    size_t depth = size_t(1) << 22;
+    // COTs extended per refill.
+    size_t batch_size = size_t(1) << 20;
+    // COTs of the first refill, 0 for batch_size. refills double it up to
+    // batch_size, so that the first takes wait for a small batch only.
+    size_t first_batch_size = 0;
+    // if not empty, batches are kept in files of this directory instead of
+    // memory, and mapped back once they are taken. batches left by a former
+    // pool in the directory are served first, so that precomputed ots
+    // survive restarts of both sides.
+    std::string dir;
+  };
+
+  // the sender side, holding delta.
+  CorrelatedOtPool(std::shared_ptr<link::Context> ctx,
+                   BaseRecvOptions base_options, Options options);
+
+  // the receiver side, holding random choice bits.
+  CorrelatedOtPool(std::shared_ptr<link::Context> ctx,
+                   BaseSendOptions base_options, Options options);
+
+  ~CorrelatedOtPool();
+
+  bool IsSender() const { return is_sender_; }
+
+  // sender only.
+  uint128_t Delta() const;
+
+  // COTs in stock.
+  size_t Stock() const;
+
+  // take `n` COTs, both take ones block until there are enough in stock.
+  //
+  // sender gets m0.
+  std::vector<uint128_t> TakeCot(size_t n);
+  // receiver gets m_c of random choice bits, bit i in (*choices)[i / 128].
+  std::vector<uint128_t> TakeCot(size_t n, std::vector<uint128_t>* choices);
+
+  // take `n` random OTs, sender gets (H(m0), H(m1)).
+  std::vector<std::array<uint128_t, 2>> TakeRot(size_t n);
+  // receiver gets H(m_c) of random choice bits.
+  std::vector<uint128_t> TakeRot(size_t n, std::vector<uint128_t>* choices);
+
+  // chosen message OTs, on random OTs taken from the pool.
+  void SendOt(absl::Span<const std::array<uint128_t, 2>> msgs);
+  // `choices` are bits, bit i in choices[i / 128].
+  void RecvOt(absl::Span<const uint128_t> choices,
+              absl::Span<uint128_t> recv_msgs);
+
+ private:
+  // COTs of one refill, kept in memory or in a file.
+  struct Batch {
+    uint64_t epoch;
+    size_t size;
+    // m0 of sender or m_c of receiver.
+    std::vector<uint128_t> blocks;
+    // choice bits of receiver.
+    std::vector<uint128_t> choices;
+    // the file of a persisted batch, mapped once it is taken.
+    std::string path;
+    std::unique_ptr<io::MmappedFile> file;
+  };
+
+  CorrelatedOtPool(std::shared_ptr<link::Context> ctx, bool is_sender,
+                   Options options);
+
+  std::string BatchPath(uint64_t epoch) const;
+  std::string CursorPath() const;
+
+  // load batches left in `dir`.
+  void LoadBatches();
+  void SaveCursor();
+
+  // start the refill thread.
+  void Start();
+  void Refill();
+
+  // take n COTs into `blocks`, and choice bits of receiver into `choices`.
+  void Take(size_t n, std::vector<uint128_t>* blocks,
+            std::vector<uint128_t>* choices);
+
+  const std::shared_ptr<link::Context> ctx_;
+  // refills run on their own context, apart from the online msgs.
+  std::shared_ptr<link::Context> refill_ctx_;
+  const bool is_sender_;
+  const Options options_;
+
+  BaseRecvOptions recv_base_;
+  BaseSendOptions send_base_;
+  uint128_t delta_ = 0;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<Batch> batches_;
+  // COTs of the front batch already taken.
+  size_t offset_ = 0;
+  size_t stock_ = 0;
+  // COTs a blocked take is waiting for, refills go beyond depth for it.
+  size_t wanted_ = 0;
+  uint64_t next_epoch_ = 0;
+  bool stopped_ = false;
+  // the error of the refill thread, raised by takes.
+  std::exception_ptr error_;
+
+  std::thread thread_;
+};
+
+}  // namespace yasl
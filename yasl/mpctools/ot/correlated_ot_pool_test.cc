@@ -0,0 +1,288 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/correlated_ot_pool.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <future>
+#include <set>
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/link/test_util.h"
+
+namespace yasl {
+
+namespace {
+
+int GetBit(const std::vector<uint128_t>& choices, size_t idx) {
+  uint128_t mask = uint128_t(1) << (idx & 127);
+  return (choices[idx / 128] & mask) ? 1 : 0;
+}
+
+std::pair<BaseSendOptions, BaseRecvOptions> MakeBaseOptions(size_t num) {
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  recv_opts.choices = CreateRandomChoices(num);
+  std::random_device rd;
+  PseudoRandomGenerator<uint128_t> gen(rd());
+  for (size_t i = 0; i < num; ++i) {
+    send_opts.blocks.push_back({gen(), gen()});
+    recv_opts.blocks.push_back(send_opts.blocks[i][recv_opts.choices[i]]);
+  }
+  return {std::move(send_opts), std::move(recv_opts)};
+}
+
+}  // namespace
+
+class CorrelatedOtPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::tie(send_opts_, recv_opts_) = MakeBaseOptions(128);
+    // takes span over batches, and run ahead of refills.
+    options_.depth = 3000;
+    options_.batch_size = 1000;
+  }
+
+  // run `sender` and `receiver` on pools of both sides.
+  void Run(const std::function<void(CorrelatedOtPool*)>& sender,
+           const std::function<void(CorrelatedOtPool*)>& receiver) {
+    auto contexts = link::test::SetupWorld(2);
+    auto f = std::async([&] {
+      CorrelatedOtPool pool(contexts[0], recv_opts_, options_);
+      sender(&pool);
+    });
+    CorrelatedOtPool pool(contexts[1], send_opts_, options_);
+    receiver(&pool);
+    f.get();
+  }
+
+  BaseSendOptions send_opts_;
+  BaseRecvOptions recv_opts_;
+  CorrelatedOtPool::Options options_;
+};
+
+TEST_F(CorrelatedOtPoolTest, CotWorks) {
+  // GIVEN
+  const std::vector<size_t> takes = {1, 999, 1000, 4097, 128};
+  uint128_t delta = 0;
+  std::vector<std::vector<uint128_t>> send_out;
+  std::vector<std::vector<uint128_t>> recv_out;
+  std::vector<std::vector<uint128_t>> choices(takes.size());
+
+  // WHEN
+  Run(
+      [&](CorrelatedOtPool* pool) {
+        delta = pool->Delta();
+        for (size_t n : takes) {
+          send_out.push_back(pool->TakeCot(n));
+        }
+      },
+      [&](CorrelatedOtPool* pool) {
+        for (size_t t = 0; t < takes.size(); ++t) {
+          recv_out.push_back(pool->TakeCot(takes[t], &choices[t]));
+        }
+      });
+
+  // THEN
+  EXPECT_NE(delta, 0);
+  for (size_t t = 0; t < takes.size(); ++t) {
+    ASSERT_EQ(send_out[t].size(), takes[t]);
+    ASSERT_EQ(recv_out[t].size(), takes[t]);
+    for (size_t i = 0; i < takes[t]; ++i) {
+      EXPECT_EQ(send_out[t][i] ^ (GetBit(choices[t], i) ? delta : 0),
+                recv_out[t][i]);
+    }
+  }
+}
+
+TEST_F(CorrelatedOtPoolTest, GrowingBatchesWork) {
+  // GIVEN
+  options_.first_batch_size = 100;
+  const std::vector<size_t> takes = {1, 150, 700, 2000};
+  uint128_t delta = 0;
+  std::vector<std::vector<uint128_t>> send_out;
+  std::vector<std::vector<uint128_t>> recv_out;
+  std::vector<std::vector<uint128_t>> choices(takes.size());
+
+  // WHEN
+  Run(
+      [&](CorrelatedOtPool* pool) {
+        delta = pool->Delta();
+        for (size_t n : takes) {
+          send_out.push_back(pool->TakeCot(n));
+        }
+      },
+      [&](CorrelatedOtPool* pool) {
+        for (size_t t = 0; t < takes.size(); ++t) {
+          recv_out.push_back(pool->TakeCot(takes[t], &choices[t]));
+        }
+      });
+
+  // THEN
+  for (size_t t = 0; t < takes.size(); ++t) {
+    for (size_t i = 0; i < takes[t]; ++i) {
+      EXPECT_EQ(send_out[t][i] ^ (GetBit(choices[t], i) ? delta : 0),
+                recv_out[t][i]);
+    }
+  }
+}
+
+TEST_F(CorrelatedOtPoolTest, RotAndOtWork) {
+  // GIVEN
+  const size_t num_ot = 2500;
+  std::vector<std::array<uint128_t, 2>> send_rot;
+  std::vector<uint128_t> recv_rot;
+  std::vector<uint128_t> rot_choices;
+  std::vector<std::array<uint128_t, 2>> msgs(num_ot);
+  std::vector<uint128_t> recv_msgs(num_ot);
+  auto choices = CreateRandomChoiceBits<uint128_t>(num_ot);
+  PseudoRandomGenerator<uint128_t> prg;
+  for (auto& msg : msgs) {
+    msg = {prg(), prg()};
+  }
+
+  // WHEN
+  Run(
+      [&](CorrelatedOtPool* pool) {
+        send_rot = pool->TakeRot(num_ot);
+        pool->SendOt(msgs);
+      },
+      [&](CorrelatedOtPool* pool) {
+        recv_rot = pool->TakeRot(num_ot, &rot_choices);
+        pool->RecvOt(choices, absl::MakeSpan(recv_msgs));
+      });
+
+  // THEN
+  for (size_t i = 0; i < num_ot; ++i) {
+    EXPECT_EQ(send_rot[i][GetBit(rot_choices, i)], recv_rot[i]);
+    EXPECT_NE(send_rot[i][0], send_rot[i][1]);
+    EXPECT_EQ(msgs[i][GetBit(choices, i)], recv_msgs[i]);
+  }
+}
+
+TEST_F(CorrelatedOtPoolTest, PersistedBatchesShouldSurviveRestarts) {
+  // GIVEN
+  const std::string dir =
+      fmt::format("{}/correlated_ot_pool_{}",
+                  std::filesystem::temp_directory_path().string(), getpid());
+  std::filesystem::remove_all(dir);
+  auto sender_options = options_;
+  sender_options.dir = dir + "/sender";
+  auto receiver_options = options_;
+  receiver_options.dir = dir + "/receiver";
+
+  const size_t num_ot = 1500;
+  uint128_t delta = 0;
+  std::vector<uint128_t> send_out;
+  std::vector<uint128_t> recv_out;
+  std::vector<uint128_t> choices;
+  auto run = [&] {
+    auto contexts = link::test::SetupWorld(2);
+    auto f = std::async([&] {
+      CorrelatedOtPool pool(contexts[0], recv_opts_, sender_options);
+      delta = pool.Delta();
+      auto out = pool.TakeCot(num_ot);
+      send_out.insert(send_out.end(), out.begin(), out.end());
+    });
+    CorrelatedOtPool pool(contexts[1], send_opts_, receiver_options);
+    std::vector<uint128_t> c;
+    auto out = pool.TakeCot(num_ot, &c);
+    recv_out.insert(recv_out.end(), out.begin(), out.end());
+    for (size_t i = 0; i < num_ot; ++i) {
+      choices.push_back(GetBit(c, i));
+    }
+    f.get();
+  };
+
+  // WHEN
+  run();
+  EXPECT_FALSE(std::filesystem::is_empty(sender_options.dir));
+  run();
+
+  // THEN
+  ASSERT_EQ(send_out.size(), 2 * num_ot);
+  for (size_t i = 0; i < send_out.size(); ++i) {
+    EXPECT_EQ(send_out[i] ^ (choices[i] ? delta : 0), recv_out[i]);
+  }
+  // COTs are never served twice.
+  EXPECT_NE(send_out[0], send_out[num_ot]);
+  std::filesystem::remove_all(dir);
+}
+
+TEST_F(CorrelatedOtPoolTest, TakesShouldBePersistedBeforeCrash) {
+  // GIVEN
+  const std::string dir =
+      fmt::format("{}/correlated_ot_pool_crash_{}",
+                  std::filesystem::temp_directory_path().string(), getpid());
+  std::filesystem::remove_all(dir);
+  // refill only for the takes, so that no refill saves the cursor after.
+  options_.depth = 0;
+  auto sender_options = options_;
+  sender_options.dir = dir + "/sender";
+  auto receiver_options = options_;
+  receiver_options.dir = dir + "/receiver";
+
+  const size_t num_ot = 1500;
+  uint128_t delta = 0;
+  std::vector<uint128_t> send_out;
+  std::vector<uint128_t> recv_out;
+  std::vector<uint128_t> choices;
+  // the dirs are copied right after the takes, as a crash leaves them.
+  auto run = [&](const std::string& suffix) {
+    auto contexts = link::test::SetupWorld(2);
+    auto f = std::async(std::launch::async, [&] {
+      CorrelatedOtPool pool(contexts[0], recv_opts_, sender_options);
+      delta = pool.Delta();
+      auto out = pool.TakeCot(num_ot);
+      send_out.insert(send_out.end(), out.begin(), out.end());
+      std::filesystem::copy(sender_options.dir, sender_options.dir + suffix);
+    });
+    CorrelatedOtPool pool(contexts[1], send_opts_, receiver_options);
+    std::vector<uint128_t> c;
+    auto out = pool.TakeCot(num_ot, &c);
+    recv_out.insert(recv_out.end(), out.begin(), out.end());
+    for (size_t i = 0; i < num_ot; ++i) {
+      choices.push_back(GetBit(c, i));
+    }
+    std::filesystem::copy(receiver_options.dir,
+                          receiver_options.dir + suffix);
+    f.get();
+  };
+
+  // WHEN
+  run("_crashed");
+  sender_options.dir += "_crashed";
+  receiver_options.dir += "_crashed";
+  run("_again");
+
+  // THEN
+  ASSERT_EQ(send_out.size(), 2 * num_ot);
+  for (size_t i = 0; i < send_out.size(); ++i) {
+    EXPECT_EQ(send_out[i] ^ (choices[i] ? delta : 0), recv_out[i]);
+  }
+  // COTs taken before the crash are never served again.
+  std::set<uint128_t> taken(send_out.begin(), send_out.begin() + num_ot);
+  for (size_t i = num_ot; i < send_out.size(); ++i) {
+    EXPECT_EQ(taken.count(send_out[i]), 0) << i;
+  }
+  std::filesystem::remove_all(dir);
+}
+
+}  // namespace yasl
@@ -0,0 +1,258 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/ferret_ot_extension.h"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <vector>
+
+#include "yasl/base/byte_container_view.h"
+#include "yasl/base/exception.h"
+#include "yasl/base/huge_page.h"
+#include "yasl/base/int128.h"
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/random_oracle.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/mpctools/ot/iknp_ot_extension.h"
+#include "yasl/mpctools/ot/punctured_rand_ot.h"
+#include "yasl/utils/parallel.h"
+#include "yasl/utils/rand.h"
+
+namespace yasl {
+namespace {
+
+// non-zero columns per row of the local linear code.
+constexpr size_t kLpnWeight = 10;
+// row i takes its columns from AES blocks [3 * i, 3 * i + 3) of the code prg.
+constexpr size_t kLpnIdxsPerRow = 12;
+static_assert(kLpnWeight <= kLpnIdxsPerRow);
+static_assert(kLpnIdxsPerRow * sizeof(uint32_t) % sizeof(uint128_t) == 0);
+// the code is public, both sides expand it from the same seed.
+constexpr uint128_t kLpnSeed =
+    MakeUint128(0x0123456789ABCDEF, 0xFEDCBA9876543210);
+// rows are expanded in parallel by groups of 128, so that choice bits of a
+// group are written by a single thread.
+constexpr size_t kRowsPerGroup = 128;
+// rows expanded per code prg fill.
+constexpr size_t kRowsPerFill = 1024;
+
+void CheckOptions(const FerretOptions& options, size_t num_ot) {
+  YASL_ENFORCE(options.num_base_cot > 0);
+  YASL_ENFORCE(options.num_bins > 0);
+  // punctured ROTs need bins of at least 4 ots.
+  YASL_ENFORCE(options.log_bin_size >= 2 && options.log_bin_size < 32,
+               "invalid log_bin_size={}", options.log_bin_size);
+  YASL_ENFORCE(options.num_sessions > 0);
+  YASL_ENFORCE(num_ot > 0 && num_ot <= options.NumOt(),
+               "num_ot={} is out of (0, {}]", num_ot, options.NumOt());
+}
+
+// base COTs of the LPN secret are kept in [0, k), and those of the punctured
+// ROTs of bin b in [k + b * log_bin_size, k + (b + 1) * log_bin_size).
+size_t NumIknpOt(const FerretOptions& options) {
+  return options.num_base_cot + options.num_bins * options.log_bin_size;
+}
+
+bool GetBit(absl::Span<const uint128_t> bits, size_t idx) {
+  return (bits[idx / 128] >> (idx % 128)) & 1;
+}
+
+// calls `f(i, idxs)` for rows i in [0, num_rows) in parallel, where
+// idxs[0, kLpnWeight) are the columns of row i in [0, k).
+template <typename F>
+void ForEachLpnRow(size_t num_rows, size_t k, const F& f) {
+  const size_t num_groups = (num_rows + kRowsPerGroup - 1) / kRowsPerGroup;
+  const int64_t grain_size = kRowsPerFill / kRowsPerGroup;
+  parallel_for(0, num_groups, grain_size, [&](int64_t g_begin, int64_t g_end) {
+    const size_t end = std::min<size_t>(g_end * kRowsPerGroup, num_rows);
+    std::vector<uint32_t> idxs(kRowsPerFill * kLpnIdxsPerRow);
+    for (size_t begin = g_begin * kRowsPerGroup; begin < end;
+         begin += kRowsPerFill) {
+      const size_t n = std::min(kRowsPerFill, end - begin);
+      PseudoRandomGenerator<uint32_t> prg(kLpnSeed);
+      prg.Skip(begin * kLpnIdxsPerRow * sizeof(uint32_t));
+      prg.Fill(absl::MakeSpan(idxs.data(), n * kLpnIdxsPerRow));
+      for (size_t i = 0; i < n; ++i) {
+        uint32_t* row = &idxs[i * kLpnIdxsPerRow];
+        for (size_t w = 0; w < kLpnWeight; ++w) {
+          row[w] %= k;
+        }
+        f(begin + i, row);
+      }
+    }
+  });
+}
+
+// calls `f(session, b)` for all bins, bin b is handled by session
+// b % num_sessions in order. each session is a spawned context on its own
+// thread, so that round trips of the punctured ROTs overlap.
+template <typename F>
+void ForEachBin(const std::shared_ptr<link::Context>& ctx,
+                const FerretOptions& options, const F& f) {
+  const size_t num_sessions = std::min(options.num_bins, options.num_sessions);
+  std::vector<std::shared_ptr<link::Context>> sessions;
+  for (size_t s = 0; s < num_sessions; ++s) {
+    sessions.push_back(ctx->Spawn());
+  }
+  std::vector<std::future<void>> futures;
+  for (size_t s = 0; s < num_sessions; ++s) {
+    futures.push_back(std::async(std::launch::async, [&, s] {
+      for (size_t b = s; b < options.num_bins; b += num_sessions) {
+        f(sessions[s], b);
+      }
+    }));
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+}
+
+}  // namespace
+
+uint128_t FerretCotSend(const std::shared_ptr<link::Context>& ctx,
+                        const BaseRecvOptions& base_options,
+                        const FerretOptions& options,
+                        absl::Span<uint128_t> send_blocks) {
+  CheckOptions(options, send_blocks.size());
+  const size_t k = options.num_base_cot;
+  const size_t bin_size = size_t(1) << options.log_bin_size;
+
+  std::vector<uint128_t> base_cots(NumIknpOt(options));
+  const uint128_t delta =
+      IknpCotSend(ctx, base_options, absl::MakeSpan(base_cots));
+
+  std::vector<uint128_t> master_seeds(options.num_bins);
+  PseudoRandomGenerator<uint128_t> prg(RandSeed());
+  std::generate(master_seeds.begin(), master_seeds.end(),
+                [&] { return prg(); });
+
+  // single point COTs: v of bin b are the leaves of its GGM tree, kept in
+  // v[b * bin_size, (b + 1) * bin_size).
+  HugePageVector<uint128_t> v(options.NumOt());
+  // c_b = delta ^ sum of v of bin b, so that receiver learns v ^ delta at
+  // its punctured point.
+  std::vector<uint128_t> corrections(options.num_bins);
+  ForEachBin(ctx, options, [&](const std::shared_ptr<link::Context>& session,
+                               size_t b) {
+    // ROT (H(q), H(q ^ delta)) from COT.
+    OTSendOptions rots;
+    for (size_t l = 0; l < options.log_bin_size; ++l) {
+      const uint128_t q = base_cots[k + b * options.log_bin_size + l];
+      rots.blocks.push_back({RandomOracle::GetDefault().Gen(q),
+                             RandomOracle::GetDefault().Gen(q ^ delta)});
+    }
+    auto leaves = absl::MakeSpan(&v[b * bin_size], bin_size);
+    PuncturedROTSend(session, rots, bin_size, master_seeds[b], leaves);
+    uint128_t c = delta;
+    for (const auto leaf : leaves) {
+      c ^= leaf;
+    }
+    corrections[b] = c;
+  });
+  ctx->SendAsync(ctx->NextRank(),
+                 ByteContainerView{
+                     reinterpret_cast<const std::byte*>(corrections.data()),
+                     corrections.size() * sizeof(uint128_t)},
+                 "FERRET:CORRECTION");
+
+  // z = A * v_base + v
+  ForEachLpnRow(send_blocks.size(), k, [&](size_t i, const uint32_t* idxs) {
+    uint128_t z = v[i];
+    for (size_t w = 0; w < kLpnWeight; ++w) {
+      z ^= base_cots[idxs[w]];
+    }
+    send_blocks[i] = z;
+  });
+  return delta;
+}
+
+void FerretCotRecv(const std::shared_ptr<link::Context>& ctx,
+                   const BaseSendOptions& base_options,
+                   const FerretOptions& options,
+                   absl::Span<uint128_t> choices,
+                   absl::Span<uint128_t> recv_blocks) {
+  CheckOptions(options, recv_blocks.size());
+  YASL_ENFORCE(choices.size() == (recv_blocks.size() + 127) / 128);
+  const size_t k = options.num_base_cot;
+  const size_t bin_size = size_t(1) << options.log_bin_size;
+
+  // u, choices of the base COTs.
+  const auto base_choices =
+      CreateRandomChoiceBits<uint128_t>(NumIknpOt(options));
+  std::vector<uint128_t> base_cots(NumIknpOt(options));
+  IknpCotRecv(ctx, base_options, absl::MakeConstSpan(base_choices),
+              absl::MakeSpan(base_cots));
+
+  // noise e of bin b is at its alphas[b]th ot.
+  std::vector<uint32_t> alphas(options.num_bins);
+  PseudoRandomGenerator<uint32_t> prg(RandSeed());
+  for (auto& alpha : alphas) {
+    alpha = prg() & (bin_size - 1);
+  }
+
+  // w of bin b, its punctured point is filled by the correction.
+  HugePageVector<uint128_t> w(options.NumOt());
+  // sums of the known leaves of bins.
+  std::vector<uint128_t> sums(options.num_bins);
+  ForEachBin(ctx, options, [&](const std::shared_ptr<link::Context>& session,
+                               size_t b) {
+    // ROT H(q ^ u * delta) of choice u from COT.
+    OTRecvOptions rots;
+    for (size_t l = 0; l < options.log_bin_size; ++l) {
+      const size_t j = k + b * options.log_bin_size + l;
+      rots.choices.push_back(GetBit(base_choices, j));
+      rots.blocks.push_back(RandomOracle::GetDefault().Gen(base_cots[j]));
+    }
+    std::vector<uint128_t> punctured(bin_size - 1);
+    PuncturedROTRecv(session, rots, bin_size, alphas[b],
+                     absl::MakeSpan(punctured));
+    auto* leaves = &w[b * bin_size];
+    std::copy(punctured.begin(), punctured.begin() + alphas[b], leaves);
+    std::copy(punctured.begin() + alphas[b], punctured.end(),
+              leaves + alphas[b] + 1);
+    uint128_t sum = 0;
+    for (const auto leaf : punctured) {
+      sum ^= leaf;
+    }
+    sums[b] = sum;
+  });
+
+  auto buf = ctx->Recv(ctx->NextRank(), "FERRET:CORRECTION");
+  YASL_ENFORCE(static_cast<size_t>(buf.size()) ==
+                   options.num_bins * sizeof(uint128_t),
+               "unexpected corrections size={}", buf.size());
+  for (size_t b = 0; b < options.num_bins; ++b) {
+    uint128_t c;
+    std::memcpy(&c, buf.data<std::byte>() + b * sizeof(uint128_t), sizeof(c));
+    // v ^ delta at the punctured point.
+    w[b * bin_size + alphas[b]] = c ^ sums[b];
+  }
+
+  // x = A * u + e, w = A * w_base + w
+  std::fill(choices.begin(), choices.end(), 0);
+  ForEachLpnRow(recv_blocks.size(), k, [&](size_t i, const uint32_t* idxs) {
+    uint128_t z = w[i];
+    bool x = (i % bin_size) == alphas[i / bin_size];
+    for (size_t l = 0; l < kLpnWeight; ++l) {
+      z ^= base_cots[idxs[l]];
+      x ^= GetBit(base_choices, idxs[l]);
+    }
+    recv_blocks[i] = z;
+    choices[i / 128] |= uint128_t(x) << (i % 128);
+  });
+}
+
+}  // namespace yasl
@@ -0,0 +1,78 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+
+#include "absl/types/span.h"
+
+#include "yasl/link/link.h"
+#include "yasl/mpctools/ot/options.h"
+
+namespace yasl {
+
+// FerretCotSend FerretCotRecv
+//
+// Silent correlated OT extension from LPN, Ferret with regular noise.
+// See https://eprint.iacr.org/2020/924.pdf
+//
+// IKNP spends 128 bits of communication per OT, while Ferret extends only
+// k + t * log2(n / t) IKNP COTs into n COTs:
+//  * t single point COTs, one per bin of n / t ots, build the sparse noise
+//    e of weight t. each of them is a punctured ROT, i.e. a GGM tree, plus
+//    one block of correction.
+//  * k base COTs u are expanded by a public local linear code A, every row
+//    of which has 10 non-zero columns, into A * u + e.
+// Besides the small IKNP and the punctured ROTs, both sides only compute
+// locally, so that a job bound by bandwidth gets far more OTs per byte.
+//
+// The choices of receiver are random, one bit per ot is enough to turn them
+// into chosen ones later.
+//
+// NOTE
+//  * semi-honest only.
+//  * base ots of IKNP are consumed, they must not be used by another
+//    extension, which would repeat the IKNP prgs.
+
+struct FerretOptions {
+  // k, the number of base COTs, i.e. the LPN secret.
+  size_t num_base_cot = 589760;
+  // t, the weight of the regular noise, one noise per bin.
+  size_t num_bins = 1319;
+  // each bin holds 2^log_bin_size ots.
+  size_t log_bin_size = 13;
+  // punctured ROTs handled concurrently, each one of them is a round trip.
+  size_t num_sessions = 8;
+
+  // n, 10805248 ots by the defaults, the LPN parameters of the paper.
+  size_t NumOt() const { return num_bins << log_bin_size; }
+};
+
+// Sender gets m0 in `send_blocks` and returns the global delta, so that
+// m1 = m0 ^ delta for all ots. at most options.NumOt() ots are extended.
+uint128_t FerretCotSend(const std::shared_ptr<link::Context>& ctx,
+                        const BaseRecvOptions& base_options,
+                        const FerretOptions& options,
+                        absl::Span<uint128_t> send_blocks);
+
+// Receiver gets random choice bits, bit i in choices[i / 128], and m_c of
+// choice bit c in `recv_blocks`.
+void FerretCotRecv(const std::shared_ptr<link::Context>& ctx,
+                   const BaseSendOptions& base_options,
+                   const FerretOptions& options,
+                   absl::Span<uint128_t> choices,
+                   absl::Span<uint128_t> recv_blocks);
+
+}  // namespace yasl
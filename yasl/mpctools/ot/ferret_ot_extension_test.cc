@@ -0,0 +1,129 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/ferret_ot_extension.h"
+
+#include <future>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/link/test_util.h"
+
+namespace yasl {
+
+namespace {
+
+std::pair<BaseSendOptions, BaseRecvOptions> MakeBaseOptions(size_t num) {
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  recv_opts.choices = CreateRandomChoices(num);
+  std::random_device rd;
+  PseudoRandomGenerator<uint128_t> gen(rd());
+  for (size_t i = 0; i < num; ++i) {
+    send_opts.blocks.push_back({gen(), gen()});
+    recv_opts.blocks.push_back(send_opts.blocks[i][recv_opts.choices[i]]);
+  }
+  return {std::move(send_opts), std::move(recv_opts)};
+}
+
+int GetBit(const std::vector<uint128_t>& choices, size_t idx) {
+  return (choices[idx / 128] >> (idx % 128)) & 1;
+}
+
+}  // namespace
+
+struct TestParams {
+  size_t num_ot;
+  size_t num_sessions;
+};
+
+class FerretCotTest : public ::testing::TestWithParam<TestParams> {};
+
+TEST_P(FerretCotTest, Works) {
+  // GIVEN
+  auto contexts = link::test::SetupWorld(2);
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  std::tie(send_opts, recv_opts) = MakeBaseOptions(128);
+
+  FerretOptions options;
+  options.num_base_cot = 1000;
+  options.num_bins = 10;
+  options.log_bin_size = 9;
+  options.num_sessions = GetParam().num_sessions;
+  const size_t num_ot = GetParam().num_ot;
+  std::vector<uint128_t> send_out(num_ot);
+  std::vector<uint128_t> recv_out(num_ot);
+  std::vector<uint128_t> choices((num_ot + 127) / 128);
+
+  // WHEN
+  std::future<uint128_t> sender = std::async([&] {
+    return FerretCotSend(contexts[0], recv_opts, options,
+                         absl::MakeSpan(send_out));
+  });
+  FerretCotRecv(contexts[1], send_opts, options, absl::MakeSpan(choices),
+                absl::MakeSpan(recv_out));
+  const uint128_t delta = sender.get();
+
+  // THEN
+  size_t num_ones = 0;
+  for (size_t i = 0; i < num_ot; ++i) {
+    const int choice = GetBit(choices, i);
+    num_ones += choice;
+    EXPECT_EQ(send_out[i] ^ (choice ? delta : 0), recv_out[i]) << i;
+  }
+  // choices are random.
+  EXPECT_GT(num_ones, num_ot / 4);
+  EXPECT_LT(num_ones, num_ot * 3 / 4);
+}
+
+INSTANTIATE_TEST_SUITE_P(Works_Instances, FerretCotTest,
+                         testing::Values(TestParams{5120, 1},  //
+                                         TestParams{5120, 3},  //
+                                         TestParams{4097, 8}   //
+                                         ));
+
+TEST(FerretCotEdgeTest, Test) {
+  auto contexts = link::test::SetupWorld(2);
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  std::tie(send_opts, recv_opts) = MakeBaseOptions(128);
+
+  FerretOptions options;
+  options.num_base_cot = 1000;
+  options.num_bins = 4;
+  options.log_bin_size = 4;
+  {
+    // More ots than the options extend.
+    std::vector<uint128_t> send_out(options.NumOt() + 1);
+    EXPECT_THROW(FerretCotSend(contexts[0], recv_opts, options,
+                               absl::MakeSpan(send_out)),
+                 ::yasl::Exception);
+  }
+  {
+    // Mismatched choices.
+    std::vector<uint128_t> recv_out(64);
+    std::vector<uint128_t> choices(2);
+    EXPECT_THROW(FerretCotRecv(contexts[1], send_opts, options,
+                               absl::MakeSpan(choices),
+                               absl::MakeSpan(recv_out)),
+                 ::yasl::Exception);
+  }
+}
+
+}  // namespace yasl
@@ -0,0 +1,135 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/gf128.h"
+
+#include "yasl/base/exception.h"
+
+#ifdef __x86_64
+#include <immintrin.h>
+
+#include "yasl/base/cpu_dispatch.h"
+#endif
+
+namespace yasl {
+
+namespace {
+
+#ifdef __x86_64
+static const bool kCPUSupportsPCLMUL = CpuSupports(kIsaPclmul);
+#endif
+
+// 256 bits carry-less product, before reduction.
+struct GfProduct {
+  uint128_t lo = 0;
+  uint128_t hi = 0;
+
+  GfProduct& operator^=(const GfProduct& rhs) {
+    lo ^= rhs.lo;
+    hi ^= rhs.hi;
+    return *this;
+  }
+};
+
+// x^128 = x^7 + x^2 + x + 1, so hi is folded into lo by that. `over`, the bits
+// of the fold beyond x^128, is at most 7 bits and folded along with it.
+uint128_t Reduce(const GfProduct& p) {
+  const uint128_t over = (p.hi >> 127) ^ (p.hi >> 126) ^ (p.hi >> 121);
+  const uint128_t hi = p.hi ^ over;
+  return p.lo ^ hi ^ (hi << 1) ^ (hi << 2) ^ (hi << 7);
+}
+
+uint128_t ClMul64(uint64_t a, uint64_t b) {
+  uint128_t r = 0;
+  for (size_t i = 0; i < 64; ++i) {
+    // branchless, so that the time does not depend on the secrets.
+    r ^= (uint128_t(a) << i) & (uint128_t(0) - ((b >> i) & 1));
+  }
+  return r;
+}
+
+GfProduct PortableClMul128(uint128_t a, uint128_t b) {
+  const auto [a1, a0] = DecomposeUInt128(a);
+  const auto [b1, b0] = DecomposeUInt128(b);
+  // karatsuba
+  const uint128_t lo = ClMul64(a0, b0);
+  const uint128_t hi = ClMul64(a1, b1);
+  const uint128_t mid = ClMul64(a0 ^ a1, b0 ^ b1) ^ lo ^ hi;
+  return {lo ^ (mid << 64), hi ^ (mid >> 64)};
+}
+
+#ifdef __x86_64
+
+__attribute__((target("pclmul,sse2"))) inline GfProduct PclmulClMul128(
+    uint128_t a, uint128_t b) {
+  const __m128i x = (__m128i)a;
+  const __m128i y = (__m128i)b;
+  const __m128i lo = _mm_clmulepi64_si128(x, y, 0x00);
+  const __m128i hi = _mm_clmulepi64_si128(x, y, 0x11);
+  const __m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(x, y, 0x01),
+                                    _mm_clmulepi64_si128(x, y, 0x10));
+  return {(uint128_t)_mm_xor_si128(lo, _mm_slli_si128(mid, 8)),
+          (uint128_t)_mm_xor_si128(hi, _mm_srli_si128(mid, 8))};
+}
+
+// karatsuba is linear in the sums, so only the three partial products are
+// accumulated and the middle one is fixed up once at the end.
+__attribute__((target("pclmul,sse2"))) uint128_t PclmulInnerProduct(
+    const uint128_t* a, const uint128_t* b, size_t n) {
+  __m128i lo = _mm_setzero_si128();
+  __m128i hi = _mm_setzero_si128();
+  __m128i mid = _mm_setzero_si128();
+  for (size_t i = 0; i < n; ++i) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    const __m128i xx = _mm_xor_si128(x, _mm_srli_si128(x, 8));
+    const __m128i yy = _mm_xor_si128(y, _mm_srli_si128(y, 8));
+    lo = _mm_xor_si128(lo, _mm_clmulepi64_si128(x, y, 0x00));
+    hi = _mm_xor_si128(hi, _mm_clmulepi64_si128(x, y, 0x11));
+    mid = _mm_xor_si128(mid, _mm_clmulepi64_si128(xx, yy, 0x00));
+  }
+  mid = _mm_xor_si128(mid, _mm_xor_si128(lo, hi));
+  return Reduce({(uint128_t)_mm_xor_si128(lo, _mm_slli_si128(mid, 8)),
+                 (uint128_t)_mm_xor_si128(hi, _mm_srli_si128(mid, 8))});
+}
+
+#endif
+
+}  // namespace
+
+uint128_t GfMul128(uint128_t a, uint128_t b) {
+#ifdef __x86_64
+  if (kCPUSupportsPCLMUL) {
+    return Reduce(PclmulClMul128(a, b));
+  }
+#endif
+  return Reduce(PortableClMul128(a, b));
+}
+
+uint128_t GfMulInnerProduct(absl::Span<const uint128_t> a,
+                            absl::Span<const uint128_t> b) {
+  YASL_ENFORCE_EQ(a.size(), b.size());
+#ifdef __x86_64
+  if (kCPUSupportsPCLMUL) {
+    return PclmulInnerProduct(a.data(), b.data(), a.size());
+  }
+#endif
+  GfProduct sum;
+  for (size_t i = 0; i < a.size(); ++i) {
+    sum ^= PortableClMul128(a[i], b[i]);
+  }
+  return Reduce(sum);
+}
+
+}  // namespace yasl
@@ -0,0 +1,35 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "absl/types/span.h"
+
+#include "yasl/base/int128.h"
+
+namespace yasl {
+
+// Arithmetic of GF(2^128) = GF(2)[x] / (x^128 + x^7 + x^2 + x + 1), bit i of
+// an uint128_t is the coefficient of x^i (i.e. not the bit reflected order of
+// GCM). Uses pclmulqdq when the cpu supports it, a portable carry-less
+// multiply otherwise.
+
+// a * b
+uint128_t GfMul128(uint128_t a, uint128_t b);
+
+// sum of a[i] * b[i]. products are accumulated unreduced and reduced once.
+uint128_t GfMulInnerProduct(absl::Span<const uint128_t> a,
+                            absl::Span<const uint128_t> b);
+
+}  // namespace yasl
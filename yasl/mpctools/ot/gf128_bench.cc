@@ -0,0 +1,73 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "yasl/mpctools/ot/gf128.h"
+
+namespace {
+std::vector<uint128_t> GenerateRandomUint128(size_t n) {
+  std::random_device rd;
+  std::mt19937_64 random(rd());
+  std::vector<uint128_t> rand_vec(n);
+  for (size_t i = 0; i < n; i++) {
+    rand_vec[i] = yasl::MakeUint128(random(), random());
+  }
+  return rand_vec;
+}
+}  // namespace
+
+static void BM_GfMul128(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t n = state.range(0);
+    std::vector<uint128_t> a = GenerateRandomUint128(n);
+    std::vector<uint128_t> b = GenerateRandomUint128(n);
+
+    state.ResumeTiming();
+    for (size_t i = 0; i < n; i++) {
+      benchmark::DoNotOptimize(a[i] = yasl::GfMul128(a[i], b[i]));
+    }
+  }
+}
+
+static void BM_GfMulInnerProduct(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t n = state.range(0);
+    std::vector<uint128_t> a = GenerateRandomUint128(n);
+    std::vector<uint128_t> b = GenerateRandomUint128(n);
+
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(yasl::GfMulInnerProduct(a, b));
+  }
+}
+
+BENCHMARK(BM_GfMul128)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(1024000)
+    ->Arg(4096000)
+    ->Arg(16384000);
+
+BENCHMARK(BM_GfMulInnerProduct)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(8192)
+    ->Arg(1024000)
+    ->Arg(4096000)
+    ->Arg(16384000);
+
+BENCHMARK_MAIN();
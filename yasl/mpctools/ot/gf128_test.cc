@@ -0,0 +1,79 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/gf128.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace yasl {
+namespace {
+
+std::vector<uint128_t> MakeRandom(size_t n) {
+  std::random_device rd;
+  std::mt19937_64 rng(rd());
+  std::vector<uint128_t> ret(n);
+  for (auto& v : ret) {
+    v = MakeUint128(rng(), rng());
+  }
+  return ret;
+}
+
+}  // namespace
+
+TEST(Gf128Test, KnownValues) {
+  EXPECT_EQ(GfMul128(1, 1), 1);
+  EXPECT_EQ(GfMul128(2, 3), 6);
+  // x^127 * x = x^7 + x^2 + x + 1
+  EXPECT_EQ(GfMul128(MakeUint128(uint64_t{1} << 63, 0), 2), 0x87);
+}
+
+TEST(Gf128Test, FieldProperties) {
+  auto a = MakeRandom(100);
+  auto b = MakeRandom(100);
+  auto c = MakeRandom(100);
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(GfMul128(a[i], 1), a[i]);
+    EXPECT_EQ(GfMul128(a[i], 0), 0);
+    EXPECT_EQ(GfMul128(a[i], b[i]), GfMul128(b[i], a[i]));
+    EXPECT_EQ(GfMul128(GfMul128(a[i], b[i]), c[i]),
+              GfMul128(a[i], GfMul128(b[i], c[i])));
+    EXPECT_EQ(GfMul128(a[i], b[i] ^ c[i]),
+              GfMul128(a[i], b[i]) ^ GfMul128(a[i], c[i]));
+  }
+
+  // a^(2^128) = a
+  uint128_t x = a[0];
+  for (size_t i = 0; i < 128; ++i) {
+    x = GfMul128(x, x);
+  }
+  EXPECT_EQ(x, a[0]);
+}
+
+TEST(Gf128Test, InnerProduct) {
+  const size_t n = 1001;
+  auto a = MakeRandom(n);
+  auto b = MakeRandom(n);
+
+  uint128_t expected = 0;
+  for (size_t i = 0; i < n; ++i) {
+    expected ^= GfMul128(a[i], b[i]);
+  }
+  EXPECT_EQ(GfMulInnerProduct(a, b), expected);
+  EXPECT_EQ(GfMulInnerProduct({}, {}), 0);
+}
+
+}  // namespace yasl
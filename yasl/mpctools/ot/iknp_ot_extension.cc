@@ -17,129 +17,395 @@
 
 #include <sys/types.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <cstddef>
+#include <cstring>
 #include <random>
 
+#include "yasl/base/buffer.h"
 #include "yasl/base/byte_container_view.h"
 #include "yasl/base/exception.h"
 #include "yasl/base/int128.h"
+#include "yasl/crypto/crhash.h"
 #include "yasl/crypto/pseudo_random_generator.h"
-#include "yasl/crypto/random_oracle.h"
 #include "yasl/crypto/utils.h"
 #include "yasl/mpctools/ot/utils.h"
+#include "yasl/utils/bitwise.h"
+#include "yasl/utils/metrics.h"
+#include "yasl/utils/parallel.h"
 
 namespace yasl {
 namespace {
 
 constexpr size_t kBatchSize = 128;
 constexpr size_t kKappa = 128;
+// batches transposed together by a 128x1024 transpose.
+constexpr size_t kBatchesPerTranspose = 8;
 constexpr uint128_t kAllOneMask = uint128_t(-1);
 
-}  // namespace
+// column j holds batch j of a group, row `offset` of column j is the row of
+// its `offset`th OT after transposed.
+using TransposedBatches =
+    std::array<std::array<uint128_t, kBatchesPerTranspose>, kKappa>;
 
-void IknpOtExtSend(const std::shared_ptr<link::Context>& ctx,
-                   const BaseRecvOptions& base_options,
-                   absl::Span<std::array<uint128_t, 2>> send_blocks) {
+// G(seed) of batches [first, first + out.size()), a base PRG yields one block
+// per batch, so that any range can be generated without the former ones.
+void GenBatchBlocks(uint128_t seed, size_t first, absl::Span<uint128_t> out) {
+  PseudoRandomGenerator<uint128_t> prg(seed);
+  prg.SetStatus(seed, first);
+  prg.Fill(out);
+}
+
+// calls `f(chunk_first, chunk_end)` over chunks of batches in [0, num_batches)
+// in parallel, chunks are aligned to groups of transposed batches.
+template <typename F>
+void ParallelForBatches(size_t num_batches, const F& f) {
+  const size_t num_groups =
+      (num_batches + kBatchesPerTranspose - 1) / kBatchesPerTranspose;
+  parallel_for(0, num_groups, 1, [&](int64_t g_begin, int64_t g_end) {
+    f(g_begin * kBatchesPerTranspose,
+      std::min<size_t>(g_end * kBatchesPerTranspose, num_batches));
+  });
+}
+
+// returns S = choice_mask, the global delta of sender.
+uint128_t ChoiceMask(const BaseRecvOptions& base_options) {
+  return base_options.choices.words()[0];
+}
+
+// The sender half of IKNP extension of `num_ot` correlated OTs, it calls
+// `f(begin, limit, matrix, j)` in parallel, where matrix[offset][j] is Q of
+// ot `begin + offset`, for offset in [0, limit).
+template <typename F>
+void IknpSendRows(const std::shared_ptr<link::Context>& ctx,
+                  const BaseRecvOptions& base_options, size_t num_ot,
+                  size_t batches_per_msg, const F& f) {
   YASL_ENFORCE(ctx->WorldSize() == 2);
+  YASL_ENFORCE(batches_per_msg > 0);
   YASL_ENFORCE(base_options.choices.size() == base_options.blocks.size());
   // k == 128, can be extended to any |l| >= k by AES encryption.
   YASL_ENFORCE(base_options.choices.size() == kKappa);
-  YASL_ENFORCE(!send_blocks.empty());
+  YASL_ENFORCE(num_ot > 0);
+  static auto& ots = GetCounter("yasl_iknp_send_ots_total");
+  static auto& time = GetHistogram("yasl_iknp_send_us");
+  ScopedTimer timer(&time);
+  ots.Add(num_ot);
 
-  std::vector<PseudoRandomGenerator<uint128_t>> prgs;
-  for (size_t s = 0; s < kKappa; ++s) {
-    prgs.emplace_back(base_options.blocks[s]);
-  }
+  const size_t kNumBatch = (num_ot + kBatchSize - 1) / kBatchSize;
 
-  // Build S = choice_mask.
-  uint128_t choice_mask = 0;
-  for (size_t i = 0; i < base_options.choices.size(); i++) {
-    choice_mask |= base_options.choices[i] ? (uint128_t(1) << i) : uint128_t(0);
-  }
+  const size_t kNumMsg = (kNumBatch + batches_per_msg - 1) / batches_per_msg;
 
-  const size_t kNumBatch = (send_blocks.size() + kBatchSize - 1) / kBatchSize;
-
-  for (size_t i = 0; i < kNumBatch; ++i) {
-    std::array<uint128_t, kBatchSize> batch;
-    auto buf = ctx->Recv(ctx->NextRank(), fmt::format("IKNP:{}", i));
-    YASL_ENFORCE(buf.size() == batch.size() * sizeof(uint128_t));
-    std::memcpy(batch.data(), buf.data(), buf.size());
-    // Q = (u & s) ^ G(K_s) = ((G(K_0) ^ G(K_1) ^ r)) & s) ^ G(K_s)
-    // Q = G(K_0) when s is 0
-    // Q = G(K_0) ^ r when s is 1
-    // Hence we get the wanted behavior in IKNP, that is:
-    //  s == 0, the sender receives T = G(K_0)
-    //  s == 1, the sender receives U = G(K_0) ^ r = T ^ r
-    for (size_t k = 0; k < kKappa; ++k) {
-      const uint128_t s = base_options.choices[k] ? kAllOneMask : 0;
-      const uint128_t gen_ks = prgs[k]();
-      batch[k] &= s;
-      batch[k] ^= gen_ks;
-    }
-    // Transpose.
-    NaiveTranspose(&batch);
-    // Build Q & Q^S
-    // Break correlation.
-    size_t limit = std::min(kBatchSize, send_blocks.size() - i * kBatchSize);
-    for (size_t offset = 0; offset < limit; ++offset) {
-      send_blocks[i * kBatchSize + offset][0] =
-          RandomOracle::GetDefault().Gen(batch[offset]);
-      send_blocks[i * kBatchSize + offset][1] =
-          RandomOracle::GetDefault().Gen(batch[offset] ^ choice_mask);
-    }
+  for (size_t m = 0; m < kNumMsg; ++m) {
+    // batches [first, first + num_msg_batches) are carried by msg m, which
+    // is consumed as it arrives while peer computes the next ones.
+    const size_t first = m * batches_per_msg;
+    const size_t num_msg_batches = std::min(batches_per_msg, kNumBatch - first);
+    auto buf = ctx->Recv(ctx->NextRank(), fmt::format("IKNP:{}", m));
+    YASL_ENFORCE(static_cast<size_t>(buf.size()) ==
+                     num_msg_batches * kKappa * sizeof(uint128_t),
+                 "unexpected msg size={}, batches per msg={}", buf.size(),
+                 batches_per_msg);
+    const auto* rows = buf.data<std::byte>();
+
+    ParallelForBatches(num_msg_batches, [&](size_t chunk_first,
+                                            size_t chunk_end) {
+      const size_t chunk_batches = chunk_end - chunk_first;
+      // G(K_s) of batch `first + chunk_first + b` is kept in
+      // gen_ks[k * chunk_batches + b], each chunk seeks prgs to its own
+      // batches.
+      std::vector<uint128_t> gen_ks(kKappa * chunk_batches);
+      for (size_t k = 0; k < kKappa; ++k) {
+        GenBatchBlocks(base_options.blocks[k], first + chunk_first,
+                       absl::MakeSpan(&gen_ks[k * chunk_batches],
+                                      chunk_batches));
+      }
+      for (size_t i = chunk_first; i < chunk_end; i += kBatchesPerTranspose) {
+        const size_t num_batches =
+            std::min(kBatchesPerTranspose, chunk_end - i);
+        // column j holds batch i + j, columns past the last batch are zero.
+        TransposedBatches matrix{};
+        for (size_t k = 0; k < kKappa; ++k) {
+          const uint128_t s = base_options.choices[k] ? kAllOneMask : 0;
+          const size_t idx = k * chunk_batches + (i - chunk_first);
+          for (size_t j = 0; j < num_batches; ++j) {
+            // Q = (u & s) ^ G(K_s) = ((G(K_0) ^ G(K_1) ^ r)) & s) ^ G(K_s)
+            // Q = G(K_0) when s is 0
+            // Q = G(K_0) ^ r when s is 1
+            // Hence we get the wanted behavior in IKNP, that is:
+            //  s == 0, the sender receives T = G(K_0)
+            //  s == 1, the sender receives U = G(K_0) ^ r = T ^ r
+            uint128_t u;
+            std::memcpy(&u, rows + ((i + j) * kKappa + k) * sizeof(uint128_t),
+                        sizeof(u));
+            matrix[k][j] = (u & s) ^ gen_ks[idx + j];
+          }
+        }
+        // Transpose, row `offset` of column j is Q of its `offset`th OT.
+        MatrixTranspose128x1024(&matrix);
+        for (size_t j = 0; j < num_batches; ++j) {
+          const size_t begin = (first + i + j) * kBatchSize;
+          f(begin, std::min(kBatchSize, num_ot - begin), matrix, j);
+        }
+      }
+    });
   }
 }
 
-void IknpOtExtRecv(const std::shared_ptr<link::Context>& ctx,
-                   const BaseSendOptions& base_options,
-                   absl::Span<const uint128_t> choices,
-                   absl::Span<uint128_t> recv_blocks) {
+// The receiver half of IKNP extension of `num_ot` correlated OTs, it calls
+// `f(begin, limit, matrix, j)` in parallel, where matrix[offset][j] is T of
+// ot `begin + offset`, for offset in [0, limit).
+template <typename F>
+void IknpRecvRows(const std::shared_ptr<link::Context>& ctx,
+                  const BaseSendOptions& base_options,
+                  absl::Span<const uint128_t> choices, size_t num_ot,
+                  size_t batches_per_msg, const F& f) {
   YASL_ENFORCE(ctx->WorldSize() == 2);
+  YASL_ENFORCE(batches_per_msg > 0);
   // k == 128, can be extended to any |l| >= k by AES encryption.
   YASL_ENFORCE(base_options.blocks.size() == kKappa);
-  YASL_ENFORCE(!recv_blocks.empty());
+  YASL_ENFORCE(num_ot > 0);
+  static auto& ots = GetCounter("yasl_iknp_recv_ots_total");
+  static auto& time = GetHistogram("yasl_iknp_recv_us");
+  ScopedTimer timer(&time);
+  ots.Add(num_ot);
+
+  const size_t kNumBatch = (num_ot + kBatchSize - 1) / kBatchSize;
+  YASL_ENFORCE(choices.size() == kNumBatch);
+
+  const size_t kNumMsg = (kNumBatch + batches_per_msg - 1) / batches_per_msg;
+
+  for (size_t m = 0; m < kNumMsg; ++m) {
+    const size_t first = m * batches_per_msg;
+    const size_t num_msg_batches = std::min(batches_per_msg, kNumBatch - first);
 
-  std::vector<PseudoRandomGenerator<uint128_t>> prgs0;
-  std::vector<PseudoRandomGenerator<uint128_t>> prgs1;
-  for (size_t k = 0; k < kKappa; ++k) {
-    // Build PRG from seed K0.
-    prgs0.emplace_back(base_options.blocks[k][0]);
-    // Build PRG from seed K1.
-    prgs1.emplace_back(base_options.blocks[k][1]);
+    // u of all batches in msg m first, so that it is in flight while we
+    // transpose t below.
+    Buffer msg(static_cast<int64_t>(num_msg_batches * kKappa *
+                                    sizeof(uint128_t)));
+    auto* rows = msg.data<std::byte>();
+    // t = G(K_0) of batch i is kept in t[i * kKappa, (i + 1) * kKappa).
+    std::vector<uint128_t> t(num_msg_batches * kKappa);
+    ParallelForBatches(num_msg_batches, [&](size_t chunk_first,
+                                            size_t chunk_end) {
+      const size_t chunk_batches = chunk_end - chunk_first;
+      std::vector<uint128_t> gen_k0(chunk_batches);
+      std::vector<uint128_t> gen_k1(chunk_batches);
+      for (size_t k = 0; k < kKappa; ++k) {
+        // G(K_0)
+        GenBatchBlocks(base_options.blocks[k][0], first + chunk_first,
+                       absl::MakeSpan(gen_k0));
+        // G(K_1)
+        GenBatchBlocks(base_options.blocks[k][1], first + chunk_first,
+                       absl::MakeSpan(gen_k1));
+        for (size_t b = 0; b < chunk_batches; ++b) {
+          const size_t i = chunk_first + b;
+          // Build u = G(K_0) ^ G(K_1) ^ r
+          const uint128_t u = gen_k0[b] ^ gen_k1[b] ^ choices[first + i];
+          std::memcpy(rows + (i * kKappa + k) * sizeof(uint128_t), &u,
+                      sizeof(u));
+          t[i * kKappa + k] = gen_k0[b];
+        }
+      }
+    });
+    ctx->SendAsync(ctx->NextRank(), std::move(msg), fmt::format("IKNP:{}", m));
+
+    ParallelForBatches(num_msg_batches, [&](size_t chunk_first,
+                                            size_t chunk_end) {
+      for (size_t i = chunk_first; i < chunk_end; i += kBatchesPerTranspose) {
+        const size_t num_batches =
+            std::min(kBatchesPerTranspose, chunk_end - i);
+        // column j holds t of batch i + j, columns past the last batch are
+        // zero.
+        TransposedBatches matrix{};
+        for (size_t j = 0; j < num_batches; ++j) {
+          for (size_t k = 0; k < kKappa; ++k) {
+            matrix[k][j] = t[(i + j) * kKappa + k];
+          }
+        }
+        // Transpose.
+        MatrixTranspose128x1024(&matrix);
+        for (size_t j = 0; j < num_batches; ++j) {
+          const size_t begin = (first + i + j) * kBatchSize;
+          f(begin, std::min(kBatchSize, num_ot - begin), matrix, j);
+        }
+      }
+    });
   }
+}
 
-  const size_t kNumBatch = (recv_blocks.size() + kBatchSize - 1) / kBatchSize;
-  YASL_ENFORCE(choices.size() == kNumBatch);
+// H(matrix[offset][j] ^ mask) of the `limit` ots of a batch, hashed in a
+// single call by the fixed key ccr hash.
+std::array<uint128_t, kBatchSize> HashBatch(const TransposedBatches& matrix,
+                                            size_t j, size_t limit,
+                                            uint128_t mask = 0) {
+  std::array<uint128_t, kBatchSize> blocks;
+  for (size_t offset = 0; offset < limit; ++offset) {
+    blocks[offset] = matrix[offset][j] ^ mask;
+  }
+  auto span = absl::MakeSpan(blocks.data(), limit);
+  CcrHash(span, span);
+  return blocks;
+}
 
-  for (size_t i = 0; i < kNumBatch; ++i) {
-    std::array<uint128_t, kBatchSize> batch;
-    std::array<uint128_t, kBatchSize> t;
-    for (size_t k = 0; k < kKappa; ++k) {
-      // G(K_0)
-      uint128_t gen_k0 = prgs0[k]();
-      // G(K_1)
-      uint128_t gen_k1 = prgs1[k]();
-      // Build u = G(K_0) ^ G(K_1) ^ r
-      batch[k] = gen_k0 ^ gen_k1 ^ choices[i];
-      // t = G(K_0)
-      t[k] = gen_k0;
-    }
-    ctx->SendAsync(
-        ctx->NextRank(),
-        ByteContainerView(reinterpret_cast<const std::byte*>(batch.data()),
-                          batch.size() * sizeof(uint128_t)),
-        fmt::format("IKNP:{}", i));
-    // Transpose.
-    NaiveTranspose(&t);
-    // Break correlation.
-    // Output t0 as recv_block.
-    size_t limit = std::min(kBatchSize, recv_blocks.size() - i * kBatchSize);
-    for (size_t offset = 0; offset < limit; ++offset) {
-      recv_blocks[i * kBatchSize + offset] =
-          RandomOracle::GetDefault().Gen(t[offset]);
-    }
+// out ^= pad expanded from `key`, keys are used as is for messages up to one
+// block.
+void XorPad(uint128_t key, absl::Span<uint8_t> out) {
+  if (out.size() <= sizeof(uint128_t)) {
+    XorInto(out, absl::MakeConstSpan(reinterpret_cast<const uint8_t*>(&key),
+                                     out.size()));
+    return;
   }
+  std::vector<uint8_t> pad(out.size());
+  PseudoRandomGenerator<uint8_t>(key).Fill(absl::MakeSpan(pad));
+  XorInto(out, pad);
+}
+
+}  // namespace
+
+uint128_t IknpCotSend(const std::shared_ptr<link::Context>& ctx,
+                      const BaseRecvOptions& base_options,
+                      absl::Span<uint128_t> send_blocks,
+                      size_t batches_per_msg) {
+  YASL_ENFORCE(!send_blocks.empty());
+  IknpSendRows(ctx, base_options, send_blocks.size(), batches_per_msg,
+               [&](size_t begin, size_t limit, const TransposedBatches& matrix,
+                   size_t j) {
+                 for (size_t offset = 0; offset < limit; ++offset) {
+                   send_blocks[begin + offset] = matrix[offset][j];
+                 }
+               });
+  return ChoiceMask(base_options);
+}
+
+void IknpCotRecv(const std::shared_ptr<link::Context>& ctx,
+                 const BaseSendOptions& base_options,
+                 absl::Span<const uint128_t> choices,
+                 absl::Span<uint128_t> recv_blocks, size_t batches_per_msg) {
+  YASL_ENFORCE(!recv_blocks.empty());
+  IknpRecvRows(ctx, base_options, choices, recv_blocks.size(), batches_per_msg,
+               [&](size_t begin, size_t limit, const TransposedBatches& matrix,
+                   size_t j) {
+                 for (size_t offset = 0; offset < limit; ++offset) {
+                   recv_blocks[begin + offset] = matrix[offset][j];
+                 }
+               });
+}
+
+void IknpRotSend(const std::shared_ptr<link::Context>& ctx,
+                 const BaseRecvOptions& base_options,
+                 absl::Span<std::array<uint128_t, 2>> send_blocks,
+                 size_t batches_per_msg) {
+  YASL_ENFORCE(!send_blocks.empty());
+  // Build S = choice_mask.
+  const uint128_t choice_mask = ChoiceMask(base_options);
+  IknpSendRows(ctx, base_options, send_blocks.size(), batches_per_msg,
+               [&](size_t begin, size_t limit, const TransposedBatches& matrix,
+                   size_t j) {
+                 // Build Q & Q^S
+                 // Break correlation.
+                 const auto h0 = HashBatch(matrix, j, limit);
+                 const auto h1 = HashBatch(matrix, j, limit, choice_mask);
+                 for (size_t offset = 0; offset < limit; ++offset) {
+                   send_blocks[begin + offset] = {h0[offset], h1[offset]};
+                 }
+               });
+}
+
+void IknpRotRecv(const std::shared_ptr<link::Context>& ctx,
+                 const BaseSendOptions& base_options,
+                 absl::Span<const uint128_t> choices,
+                 absl::Span<uint128_t> recv_blocks, size_t batches_per_msg) {
+  YASL_ENFORCE(!recv_blocks.empty());
+  IknpRecvRows(ctx, base_options, choices, recv_blocks.size(), batches_per_msg,
+               [&](size_t begin, size_t limit, const TransposedBatches& matrix,
+                   size_t j) {
+                 // Break correlation.
+                 // Output t0 as recv_block.
+                 const auto h = HashBatch(matrix, j, limit);
+                 std::copy_n(h.begin(), limit, &recv_blocks[begin]);
+               });
+}
+
+void IknpOtSend(const std::shared_ptr<link::Context>& ctx,
+                const BaseRecvOptions& base_options, size_t msg_len,
+                absl::Span<const uint8_t> msgs0,
+                absl::Span<const uint8_t> msgs1, size_t batches_per_msg) {
+  YASL_ENFORCE(msg_len > 0);
+  YASL_ENFORCE(msgs0.size() == msgs1.size() && !msgs0.empty());
+  YASL_ENFORCE(msgs0.size() % msg_len == 0);
+  const size_t num_ot = msgs0.size() / msg_len;
+
+  // y_b = m_b ^ H(q ^ b * S) of ot i is kept in
+  // corrections[(2 * i + b) * msg_len, (2 * i + b + 1) * msg_len).
+  Buffer corrections(static_cast<int64_t>(2 * msgs0.size()));
+  auto* y = corrections.data<uint8_t>();
+  const uint128_t choice_mask = ChoiceMask(base_options);
+  IknpSendRows(ctx, base_options, num_ot, batches_per_msg,
+               [&](size_t begin, size_t limit, const TransposedBatches& matrix,
+                   size_t j) {
+                 const auto h0 = HashBatch(matrix, j, limit);
+                 const auto h1 = HashBatch(matrix, j, limit, choice_mask);
+                 for (size_t offset = 0; offset < limit; ++offset) {
+                   const size_t i = begin + offset;
+                   auto y0 = absl::MakeSpan(y + 2 * i * msg_len, msg_len);
+                   auto y1 = absl::MakeSpan(y + (2 * i + 1) * msg_len, msg_len);
+                   std::memcpy(y0.data(), &msgs0[i * msg_len], msg_len);
+                   std::memcpy(y1.data(), &msgs1[i * msg_len], msg_len);
+                   XorPad(h0[offset], y0);
+                   XorPad(h1[offset], y1);
+                 }
+               });
+  ctx->SendAsync(ctx->NextRank(), std::move(corrections), "IKNP_OT");
+}
+
+void IknpOtRecv(const std::shared_ptr<link::Context>& ctx,
+                const BaseSendOptions& base_options,
+                absl::Span<const uint128_t> choices, size_t msg_len,
+                absl::Span<uint8_t> recv_msgs, size_t batches_per_msg) {
+  YASL_ENFORCE(msg_len > 0);
+  YASL_ENFORCE(!recv_msgs.empty() && recv_msgs.size() % msg_len == 0);
+  const size_t num_ot = recv_msgs.size() / msg_len;
+
+  // H(t) of all ots, the keys of the chosen messages.
+  std::vector<uint128_t> keys(num_ot);
+  IknpRecvRows(ctx, base_options, choices, num_ot, batches_per_msg,
+               [&](size_t begin, size_t limit, const TransposedBatches& matrix,
+                   size_t j) {
+                 const auto h = HashBatch(matrix, j, limit);
+                 std::copy_n(h.begin(), limit, &keys[begin]);
+               });
+
+  auto buf = ctx->Recv(ctx->NextRank(), "IKNP_OT");
+  YASL_ENFORCE(static_cast<size_t>(buf.size()) == 2 * recv_msgs.size(),
+               "unexpected corrections size={}, msg_len={}", buf.size(),
+               msg_len);
+  const auto* y = buf.data<uint8_t>();
+  parallel_for(0, num_ot, kBatchSize, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const auto b = static_cast<size_t>(
+          (choices[i / kBatchSize] >> (i % kBatchSize)) & 1);
+      auto out = recv_msgs.subspan(i * msg_len, msg_len);
+      std::memcpy(out.data(), y + (2 * i + b) * msg_len, msg_len);
+      XorPad(keys[i], out);
+    }
+  });
+}
+
+void IknpOtExtSend(const std::shared_ptr<link::Context>& ctx,
+                   const BaseRecvOptions& base_options,
+                   absl::Span<std::array<uint128_t, 2>> send_blocks,
+                   size_t batches_per_msg) {
+  IknpRotSend(ctx, base_options, send_blocks, batches_per_msg);
+}
+
+void IknpOtExtRecv(const std::shared_ptr<link::Context>& ctx,
+                   const BaseSendOptions& base_options,
+                   absl::Span<const uint128_t> choices,
+                   absl::Span<uint128_t> recv_blocks,
+                   size_t batches_per_msg) {
+  IknpRotRecv(ctx, base_options, choices, recv_blocks, batches_per_msg);
 }
 
 }  // namespace yasl
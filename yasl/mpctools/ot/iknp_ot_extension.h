@@ -47,14 +47,70 @@ namespace yasl {
 // or 128.
 //
 // NOTE |choices| need to be round up to 128.
+//
+// OTs are extended in batches of 128, `batches_per_msg` batches are carried
+// by a single msg, 64 by default (128x8192 bits, 128KB per msg). Receiver
+// sends a msg before it finishes its own part of it, and sender consumes the
+// msgs as they arrive, so the two sides are pipelined. both sides must agree
+// on `batches_per_msg`.
+inline constexpr size_t kIknpBatchesPerMsg = 64;
+
+// Correlated OT, the cheapest variant since no random oracle is applied.
+// Sender gets m0 in `send_blocks` and returns the global delta, so that
+// m1 = m0 ^ delta for all ots, receiver gets m_c for choice bit c.
+//
+// NOTE delta is S, the choices of base ots, and the outputs are correlation
+// robust only, break the correlation by a hash if they are used as keys.
+uint128_t IknpCotSend(const std::shared_ptr<link::Context>& ctx,
+                      const BaseRecvOptions& base_options,
+                      absl::Span<uint128_t> send_blocks,
+                      size_t batches_per_msg = kIknpBatchesPerMsg);
+
+void IknpCotRecv(const std::shared_ptr<link::Context>& ctx,
+                 const BaseSendOptions& base_options,
+                 absl::Span<const uint128_t> choices,
+                 absl::Span<uint128_t> recv_blocks,
+                 size_t batches_per_msg = kIknpBatchesPerMsg);
+
+// Random OT, sender gets random and independent pairs (H(q), H(q ^ delta)),
+// receiver gets the one of its choice bit.
+void IknpRotSend(const std::shared_ptr<link::Context>& ctx,
+                 const BaseRecvOptions& base_options,
+                 absl::Span<std::array<uint128_t, 2>> send_blocks,
+                 size_t batches_per_msg = kIknpBatchesPerMsg);
+
+void IknpRotRecv(const std::shared_ptr<link::Context>& ctx,
+                 const BaseSendOptions& base_options,
+                 absl::Span<const uint128_t> choices,
+                 absl::Span<uint128_t> recv_blocks,
+                 size_t batches_per_msg = kIknpBatchesPerMsg);
+
+// Chosen message OT of `msg_len` bytes messages, message i of sender is
+// msgs_b[i * msg_len, (i + 1) * msg_len). It is a random OT followed by one
+// msg of corrections m_b ^ G(H(q ^ b * delta)), 2 * msg_len bytes per ot.
+void IknpOtSend(const std::shared_ptr<link::Context>& ctx,
+                const BaseRecvOptions& base_options, size_t msg_len,
+                absl::Span<const uint8_t> msgs0,
+                absl::Span<const uint8_t> msgs1,
+                size_t batches_per_msg = kIknpBatchesPerMsg);
+
+void IknpOtRecv(const std::shared_ptr<link::Context>& ctx,
+                const BaseSendOptions& base_options,
+                absl::Span<const uint128_t> choices, size_t msg_len,
+                absl::Span<uint8_t> recv_msgs,
+                size_t batches_per_msg = kIknpBatchesPerMsg);
+
+// Same as IknpRotSend and IknpRotRecv.
 void IknpOtExtSend(const std::shared_ptr<link::Context>& ctx,
                    const BaseRecvOptions& base_options,
-                   absl::Span<std::array<uint128_t, 2>> send_blocks);
+                   absl::Span<std::array<uint128_t, 2>> send_blocks,
+                   size_t batches_per_msg = kIknpBatchesPerMsg);
 
 // TODO(shuyan.ycf): replaces `choices` with strong-typed bit vector.
 void IknpOtExtRecv(const std::shared_ptr<link::Context>& ctx,
                    const BaseSendOptions& base_options,
                    absl::Span<const uint128_t> choices,
-                   absl::Span<uint128_t> recv_blocks);
+                   absl::Span<uint128_t> recv_blocks,
+                   size_t batches_per_msg = kIknpBatchesPerMsg);
 
 }  // namespace yasl
\ No newline at end of file
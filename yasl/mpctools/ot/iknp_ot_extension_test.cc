@@ -94,6 +94,136 @@ INSTANTIATE_TEST_SUITE_P(Works_Instances, IknpOtExtTest,
                                          TestParams{65536}  //
                                          ));
 
+TEST(IknpOtExtBatchesPerMsgTest, Works) {
+  // GIVEN
+  auto contexts = link::test::SetupWorld(2);
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  std::tie(send_opts, recv_opts) = MakeBaseOptions(128);
+
+  // batches of msgs are not aligned to the transposes, nor the last one.
+  const size_t num_ot = 4097;
+  const size_t batches_per_msg = 3;
+  std::vector<std::array<uint128_t, 2>> send_out(num_ot);
+  std::vector<uint128_t> recv_out(num_ot);
+  std::vector<uint128_t> choices = CreateRandomChoiceBits<uint128_t>(num_ot);
+
+  // WHEN
+  std::future<void> sender = std::async([&] {
+    IknpOtExtSend(contexts[0], recv_opts, absl::MakeSpan(send_out),
+                  batches_per_msg);
+  });
+  IknpOtExtRecv(contexts[1], send_opts, absl::MakeConstSpan(choices),
+                absl::MakeSpan(recv_out), batches_per_msg);
+  sender.get();
+
+  // THEN
+  for (size_t i = 0; i < num_ot; ++i) {
+    EXPECT_EQ(send_out[i][GetBit(choices, i)], recv_out[i]);
+  }
+}
+
+TEST(IknpOtExtBatchesPerMsgTest, OutputShouldNotDependOnChunks) {
+  // GIVEN
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  std::tie(send_opts, recv_opts) = MakeBaseOptions(128);
+
+  // msgs of one batch are never split across threads, while the bigger ones
+  // are, each thread seeks prgs to its own batches.
+  const size_t num_ot = 128 * 1000;
+  std::vector<uint128_t> choices = CreateRandomChoiceBits<uint128_t>(num_ot);
+  auto run = [&](size_t batches_per_msg) {
+    auto contexts = link::test::SetupWorld(2);
+    std::vector<std::array<uint128_t, 2>> send_out(num_ot);
+    std::vector<uint128_t> recv_out(num_ot);
+    std::future<void> sender = std::async([&] {
+      IknpOtExtSend(contexts[0], recv_opts, absl::MakeSpan(send_out),
+                    batches_per_msg);
+    });
+    IknpOtExtRecv(contexts[1], send_opts, absl::MakeConstSpan(choices),
+                  absl::MakeSpan(recv_out), batches_per_msg);
+    sender.get();
+    return std::make_pair(send_out, recv_out);
+  };
+
+  // WHEN
+  auto serial = run(1);
+  auto chunked = run(kIknpBatchesPerMsg);
+
+  // THEN
+  EXPECT_EQ(serial.first, chunked.first);
+  EXPECT_EQ(serial.second, chunked.second);
+}
+
+TEST(IknpCotTest, Works) {
+  // GIVEN
+  auto contexts = link::test::SetupWorld(2);
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  std::tie(send_opts, recv_opts) = MakeBaseOptions(128);
+
+  const size_t num_ot = 4097;
+  std::vector<uint128_t> send_out(num_ot);
+  std::vector<uint128_t> recv_out(num_ot);
+  std::vector<uint128_t> choices = CreateRandomChoiceBits<uint128_t>(num_ot);
+
+  // WHEN
+  std::future<uint128_t> sender = std::async([&] {
+    return IknpCotSend(contexts[0], recv_opts, absl::MakeSpan(send_out));
+  });
+  IknpCotRecv(contexts[1], send_opts, absl::MakeConstSpan(choices),
+              absl::MakeSpan(recv_out));
+  const uint128_t delta = sender.get();
+
+  // THEN
+  EXPECT_NE(delta, 0);
+  for (size_t i = 0; i < num_ot; ++i) {
+    EXPECT_EQ(send_out[i] ^ (GetBit(choices, i) ? delta : 0), recv_out[i]);
+  }
+}
+
+class IknpOtTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(IknpOtTest, Works) {
+  // GIVEN
+  auto contexts = link::test::SetupWorld(2);
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  std::tie(send_opts, recv_opts) = MakeBaseOptions(128);
+
+  const size_t num_ot = 1000;
+  const size_t msg_len = GetParam();
+  std::vector<uint8_t> msgs0(num_ot * msg_len);
+  std::vector<uint8_t> msgs1(num_ot * msg_len);
+  for (size_t i = 0; i < msgs0.size(); ++i) {
+    msgs0[i] = rand();
+    msgs1[i] = rand();
+  }
+  std::vector<uint8_t> recv_msgs(num_ot * msg_len);
+  std::vector<uint128_t> choices = CreateRandomChoiceBits<uint128_t>(num_ot);
+
+  // WHEN
+  std::future<void> sender = std::async([&] {
+    IknpOtSend(contexts[0], recv_opts, msg_len, absl::MakeConstSpan(msgs0),
+               absl::MakeConstSpan(msgs1));
+  });
+  IknpOtRecv(contexts[1], send_opts, absl::MakeConstSpan(choices), msg_len,
+             absl::MakeSpan(recv_msgs));
+  sender.get();
+
+  // THEN
+  for (size_t i = 0; i < num_ot; ++i) {
+    const auto& msgs = GetBit(choices, i) ? msgs1 : msgs0;
+    EXPECT_EQ(std::memcmp(&recv_msgs[i * msg_len], &msgs[i * msg_len],
+                          msg_len),
+              0);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Works_Instances, IknpOtTest,
+                         testing::Values(1, 16, 33));
+
 TEST(IknpOtExtEdgeTest, Test) {
   // GIVEN
   const int kWorldSize = 2;
@@ -15,15 +15,22 @@
 
 #include "yasl/mpctools/ot/kkrt_ot_extension.h"
 
+#include <algorithm>
+#include <future>
+
 #include "c/blake3.h"
 #include "emp-tool/utils/aes_opt.h"
 #include "emp-tool/utils/block.h"
 
+#include "yasl/base/buffer.h"
 #include "yasl/base/byte_container_view.h"
 #include "yasl/crypto/hash_util.h"
 #include "yasl/crypto/pseudo_random_generator.h"
 #include "yasl/crypto/random_oracle.h"
 #include "yasl/mpctools/ot/utils.h"
+#include "yasl/utils/bitwise.h"
+#include "yasl/utils/metrics.h"
+#include "yasl/utils/parallel.h"
 
 namespace yasl {
 namespace {
@@ -42,6 +49,20 @@ constexpr int kBatchSize1024 = 1024;
 constexpr int kNumBlockPerBatch1024 = kBatchSize1024 / kKappa;
 static_assert(kBatchSize1024 % kKappa == 0);
 
+// In lazy mode, the receiver expands at least this many batches at a time.
+constexpr uint64_t kLazyWindowBatches = 16;
+// KkrtOtExtRecv expands and sends this many batches at a time.
+constexpr size_t kRecvWindowBatches = 256;
+
+// base ot PRG seeked to `counter`, so that batches can be expanded by
+// parallel workers without generating the former ones.
+template <typename T>
+PseudoRandomGenerator<T> SeekedPrg(uint128_t seed, uint128_t counter) {
+  PseudoRandomGenerator<T> prg(seed);
+  prg.SetStatus(seed, counter);
+  return prg;
+}
+
 uint128_t KkrtRandomOracle(const KkrtRow& row) {
   // auto sha_bytes = crypto::Sha256(
   auto sha_bytes = crypto::Blake3(
@@ -93,6 +114,42 @@ inline void AesEncrypt(emp::AES_KEY* aes_key, uint128_t input, KkrtRow* prc) {
   }
 }
 
+// rows [0, n) as one span of words, for the bulk xor kernels.
+inline absl::Span<uint128_t> RowWords(KkrtRow* rows, size_t n) {
+  return absl::MakeSpan(rows->data(), n * kKkrtWidth);
+}
+
+inline absl::Span<const uint128_t> RowWords(const KkrtRow* rows, size_t n) {
+  return absl::MakeConstSpan(rows->data(), n * kKkrtWidth);
+}
+
+// inputs encrypted by all keys at a time, for batches.
+constexpr size_t kAesBatch = 8;
+// inputs of a parallel task.
+constexpr int64_t kEncodeGrain = 1024;
+
+// PRC of inputs[j] for j < n, the rounds of all N inputs and all keys are
+// interleaved.
+template <size_t N>
+inline void AesEncrypt(emp::AES_KEY* aes_key, const uint128_t* inputs,
+                       size_t n, std::array<KkrtRow, N>* prcs) {
+  // ParaEnc encrypts blocks [i * N, (i + 1) * N) by key i.
+  emp::block enc_block[kKkrtWidth * N];
+  for (size_t i = 0; i < kKkrtWidth; i++) {
+    for (size_t j = 0; j < N; j++) {
+      enc_block[i * N + j] = emp::block(j < n ? inputs[j] : 0);
+    }
+  }
+
+  emp::ParaEnc<kKkrtWidth, N>(enc_block, aes_key);
+  for (size_t j = 0; j < n; j++) {
+    for (size_t i = 0; i < kKkrtWidth; i++) {
+      // aes(x) xor x, Correlation Roustness Hash
+      (*prcs)[j][i] = (uint128_t)(emp::block(inputs[j]) ^ enc_block[i * N + j]);
+    }
+  }
+}
+
 class KkrtGroupPRF : public IGroupPRF {
  public:
   explicit KkrtGroupPRF(size_t n, const KkrtRow& s)
@@ -136,6 +193,43 @@ class KkrtGroupPRF : public IGroupPRF {
     KkrtRandomOracle(prc, outbuf, bufsize);
   }
 
+  void Eval(absl::Span<const size_t> group_idxes,
+            absl::Span<const uint128_t> inputs,
+            absl::Span<uint128_t> outputs) override {
+    YASL_ENFORCE_EQ(outputs.size(), inputs.size());
+    Eval(group_idxes, inputs,
+         absl::MakeSpan(reinterpret_cast<uint8_t*>(outputs.data()),
+                        outputs.size() * sizeof(uint128_t)),
+         sizeof(uint128_t));
+  }
+
+  void Eval(absl::Span<const size_t> group_idxes,
+            absl::Span<const uint128_t> inputs, absl::Span<uint8_t> outbuf,
+            size_t bufsize) override {
+    YASL_ENFORCE_EQ(group_idxes.size(), inputs.size());
+    YASL_ENFORCE_EQ(outbuf.size(), inputs.size() * bufsize);
+    for (const auto group_idx : group_idxes) {
+      YASL_ENFORCE_LT(group_idx, size_);
+    }
+    parallel_for(0, inputs.size(), kEncodeGrain, [&](int64_t begin,
+                                                     int64_t end) {
+      for (int64_t i = begin; i < end; i += kAesBatch) {
+        const size_t n = std::min<size_t>(kAesBatch, end - i);
+        std::array<KkrtRow, kAesBatch> prcs;
+        AesEncrypt(aes_key_, &inputs[i], n, &prcs);
+        for (size_t j = 0; j < n; ++j) {
+          auto& prc = prcs[j];
+          const auto& q = q_[group_idxes[i + j]];
+          for (size_t w = 0; w < kKkrtWidth; ++w) {
+            prc[w] &= s_[w];
+            prc[w] ^= q[w];
+          }
+          KkrtRandomOracle(prc, &outbuf[(i + j) * bufsize], bufsize);
+        }
+      }
+    });
+  }
+
   template <size_t N>
   void SetQ(const std::array<KkrtRow, N>& q, size_t offset, size_t num_valid) {
     YASL_ENFORCE(num_valid <= q.size() && offset + num_valid <= this->Size());
@@ -172,7 +266,7 @@ class KkrtGroupPRF : public IGroupPRF {
   // Group size.
   const size_t size_;
   // Q, received from receiver.
-  std::vector<KkrtRow> q_;
+  HugePageVector<KkrtRow> q_;
   // Sender base ot choice bits: `s`
   KkrtRow s_;
 
@@ -181,49 +275,80 @@ class KkrtGroupPRF : public IGroupPRF {
 
 }  // namespace
 
+void IGroupPRF::Eval(absl::Span<const size_t> group_idxes,
+                     absl::Span<const uint128_t> inputs,
+                     absl::Span<uint128_t> outputs) {
+  YASL_ENFORCE_EQ(group_idxes.size(), inputs.size());
+  YASL_ENFORCE_EQ(outputs.size(), inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    outputs[i] = Eval(group_idxes[i], inputs[i]);
+  }
+}
+
+void IGroupPRF::Eval(absl::Span<const size_t> group_idxes,
+                     absl::Span<const uint128_t> inputs,
+                     absl::Span<uint8_t> buf, size_t bufsize) {
+  YASL_ENFORCE_EQ(group_idxes.size(), inputs.size());
+  YASL_ENFORCE_EQ(buf.size(), inputs.size() * bufsize);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    Eval(group_idxes[i], inputs[i], &buf[i * bufsize], bufsize);
+  }
+}
+
 std::unique_ptr<IGroupPRF> KkrtOtExtSend(
     const std::shared_ptr<link::Context>& ctx,
     const BaseRecvOptions& base_options, size_t num_ot) {
   YASL_ENFORCE_EQ(base_options.blocks.size(), base_options.choices.size());
   YASL_ENFORCE(kIknpWidth == base_options.choices.size());
   YASL_ENFORCE(num_ot > 0);
+  static auto& ots = GetCounter("yasl_kkrt_send_ots_total");
+  static auto& time = GetHistogram("yasl_kkrt_send_us");
+  ScopedTimer timer(&time);
+  ots.Add(num_ot);
 
   // Build S for sender.
   KkrtRow S{0};
-  for (size_t w = 0; w < kKkrtWidth; ++w) {
-    for (size_t k = 0; k < kKappa; ++k) {
-      S[w] |= uint128_t(base_options.choices[w * kKappa + k] ? 1 : 0) << k;
-    }
-  }
-  // Build PRG from seed Ks.
-  std::vector<PseudoRandomGenerator<uint128_t>> prgs;
-  for (size_t k = 0; k < kIknpWidth; ++k) {
-    prgs.emplace_back(base_options.blocks[k]);
-  }
-
+  std::copy_n(base_options.choices.words().begin(), kKkrtWidth, S.begin());
   // Build PRF.
   auto prf = std::make_unique<KkrtGroupPRF>(num_ot, S);
 
   const size_t num_batch = (num_ot + kBatchSize - 1) / kBatchSize;
+  // Q = G(ks) of all batches does not depend on peer, expand them in
+  // parallel while peer is computing U.
+  parallel_for(0, num_batch, 1, [&](int64_t begin, int64_t end) {
+    // Build PRG from seed Ks.
+    std::vector<PseudoRandomGenerator<uint128_t>> prgs;
+    for (size_t k = 0; k < kIknpWidth; ++k) {
+      prgs.push_back(SeekedPrg<uint128_t>(base_options.blocks[k],
+                                          begin * kNumBlockPerBatch));
+    }
+    for (int64_t batch_idx = begin; batch_idx < end; ++batch_idx) {
+      const size_t num_this_batch =
+          std::min<size_t>(num_ot - batch_idx * kBatchSize, kBatchSize);
+      std::array<KkrtRow, kBatchSize> Q;
+      for (size_t w = 0; w < kKkrtWidth; ++w) {
+        std::array<uint128_t, kBatchSize> q;
+        for (size_t k = 0; k < kKappa; ++k) {
+          const size_t col_idx = w * kKappa + k;
+          for (size_t b = 0; b < kNumBlockPerBatch; ++b) {
+            q[k * kNumBlockPerBatch + b] = prgs[col_idx]();
+          }
+        }
+        MatrixTranspose128(&q);
+        for (size_t i = 0; i < num_this_batch; ++i) {
+          // Q = G(ks)
+          Q[i][w] = q[i];
+        }
+      }
+      // Set to PRF.
+      prf->SetQ(Q, batch_idx * kBatchSize, num_this_batch);
+    }
+  });
+
   for (size_t batch_idx = 0; batch_idx < num_batch; ++batch_idx) {
     const size_t num_this_batch =
         std::min<size_t>(num_ot - batch_idx * kBatchSize, kBatchSize);
-    std::array<KkrtRow, kBatchSize> Q;
     std::array<KkrtRow, kBatchSize> U;
-    for (size_t w = 0; w < kKkrtWidth; ++w) {
-      std::array<uint128_t, kBatchSize> q;
-      for (size_t k = 0; k < kKappa; ++k) {
-        const size_t col_idx = w * kKappa + k;
-        for (size_t b = 0; b < kNumBlockPerBatch; ++b) {
-          q[k * kNumBlockPerBatch + b] = prgs[col_idx]();
-        }
-      }
-      MatrixTranspose128(&q);
-      for (size_t i = 0; i < num_this_batch; ++i) {
-        // Q = G(ks)
-        Q[i][w] = q[i];
-      }
-    }
 
     // Receive U.
     auto buf = ctx->Recv(ctx->NextRank(), fmt::format("KKRT:{}", batch_idx));
@@ -231,15 +356,7 @@ std::unique_ptr<IGroupPRF> KkrtOtExtSend(
     std::memcpy(U.data(), buf.data(), sizeof(U));
 
     // Build Q = (U & S) ^ G(ks)
-    for (size_t i = 0; i < num_this_batch; ++i) {
-      for (size_t w = 0; w < kKkrtWidth; ++w) {
-        U[i][w] &= S[w];
-        Q[i][w] ^= U[i][w];
-      }
-    }
-
-    // Set to PRF.
-    prf->SetQ(Q, batch_idx * kBatchSize, num_this_batch);
+    prf->CalcQ(U, batch_idx * kBatchSize, num_this_batch);
   }
 
   return prf;
@@ -251,69 +368,89 @@ void KkrtOtExtRecv(const std::shared_ptr<link::Context>& ctx,
                    absl::Span<uint128_t> recv_blocks) {
   YASL_ENFORCE(base_options.blocks.size() == kIknpWidth);
   YASL_ENFORCE(inputs.size() == recv_blocks.size() && !inputs.empty());
+  static auto& ots = GetCounter("yasl_kkrt_recv_ots_total");
+  static auto& time = GetHistogram("yasl_kkrt_recv_us");
+  ScopedTimer timer(&time);
 
   const size_t num_ot = inputs.size();
+  ots.Add(num_ot);
   const size_t num_batch = (num_ot + kBatchSize - 1) / kBatchSize;
 
-  std::vector<PseudoRandomGenerator<uint128_t>> prgs0;
-  std::vector<PseudoRandomGenerator<uint128_t>> prgs1;
-  for (size_t k = 0; k < kIknpWidth; ++k) {
-    // Build PRG from seed K0.
-    prgs0.emplace_back(base_options.blocks[k][0]);
-    // Build PRG from seed K1.
-    prgs1.emplace_back(base_options.blocks[k][1]);
-  }
   emp::AES_KEY aes_key[kKkrtWidth];
   AesInit(aes_key);
 
-  // Let us do it streaming way.
-  for (size_t batch_idx = 0; batch_idx < num_batch; ++batch_idx) {
-    const size_t num_this_batch =
-        std::min<size_t>(num_ot - batch_idx * kBatchSize, kBatchSize);
-    // KKRT can be viewed as a wider IKNP OT EXTENSION.
-    std::array<KkrtRow, kBatchSize> T;
-    std::array<KkrtRow, kBatchSize> U;
-    for (size_t w = 0; w < kKkrtWidth; ++w) {
-      std::array<uint128_t, kBatchSize> t;
-      std::array<uint128_t, kBatchSize> u;
-      for (size_t k = 0; k < kKappa; ++k) {
-        const size_t col_idx = w * kKappa + k;
-        for (size_t b = 0; b < kNumBlockPerBatch; ++b) {
-          t[k * kNumBlockPerBatch + b] = prgs0[col_idx]();
-          u[k * kNumBlockPerBatch + b] = prgs1[col_idx]();
+  // batches are expanded in parallel by windows, and the U of a window are
+  // sent before the next one is expanded, so that only a window of them is
+  // kept and the peer starts folding them in early.
+  for (size_t window = 0; window < num_batch; window += kRecvWindowBatches) {
+    const size_t window_end =
+        std::min<size_t>(window + kRecvWindowBatches, num_batch);
+    // U of batch window + i, rows past the last ot are zero.
+    std::vector<Buffer> us(window_end - window);
+    // batches are independent, each worker seeks its own prgs to its first
+    // batch.
+    parallel_for(window, window_end, 1, [&](int64_t begin, int64_t end) {
+      std::vector<PseudoRandomGenerator<uint128_t>> prgs0;
+      std::vector<PseudoRandomGenerator<uint128_t>> prgs1;
+      for (size_t k = 0; k < kIknpWidth; ++k) {
+        // Build PRG from seed K0.
+        prgs0.push_back(SeekedPrg<uint128_t>(base_options.blocks[k][0],
+                                             begin * kNumBlockPerBatch));
+        // Build PRG from seed K1.
+        prgs1.push_back(SeekedPrg<uint128_t>(base_options.blocks[k][1],
+                                             begin * kNumBlockPerBatch));
+      }
+      for (int64_t batch_idx = begin; batch_idx < end; ++batch_idx) {
+        const size_t num_this_batch =
+            std::min<size_t>(num_ot - batch_idx * kBatchSize, kBatchSize);
+        // KKRT can be viewed as a wider IKNP OT EXTENSION.
+        std::array<KkrtRow, kBatchSize> T;
+        auto& buf = us[batch_idx - window];
+        buf = Buffer(kBatchSize * sizeof(KkrtRow));
+        std::memset(buf.data(), 0, buf.size());
+        auto* U = buf.data<KkrtRow>();
+        for (size_t w = 0; w < kKkrtWidth; ++w) {
+          std::array<uint128_t, kBatchSize> t;
+          std::array<uint128_t, kBatchSize> u;
+          for (size_t k = 0; k < kKappa; ++k) {
+            const size_t col_idx = w * kKappa + k;
+            for (size_t b = 0; b < kNumBlockPerBatch; ++b) {
+              t[k * kNumBlockPerBatch + b] = prgs0[col_idx]();
+              u[k * kNumBlockPerBatch + b] = prgs1[col_idx]();
+            }
+          }
+
+          MatrixTranspose128(&t);
+          MatrixTranspose128(&u);
+          for (size_t i = 0; i < num_this_batch; ++i) {
+            // T = G(k0)
+            T[i][w] = t[i];
+            // U = G(k1)
+            U[i][w] = u[i];
+          }
+        }
+        // Construct U.
+        // U = G(k1) ^ G(k0) ^ PRC(r)
+        for (size_t i = 0; i < num_this_batch; i += kAesBatch) {
+          const size_t n = std::min<size_t>(kAesBatch, num_this_batch - i);
+          std::array<KkrtRow, kAesBatch> prcs;
+          AesEncrypt(aes_key, &inputs[batch_idx * kBatchSize + i], n, &prcs);
+          XorThree(RowWords(U + i, n), RowWords(&T[i], n),
+                   RowWords(prcs.data(), n));
+        }
+        for (size_t i = 0; i < num_this_batch; ++i) {
+          // TODO(shuyan.ycf): make correlation break RO plugable. BTW: libOTe
+          // use blake2 and takes 128 bits.
+          // It is enough to just take first 128 bits of sha256 results for PSI
+          // now.
+          recv_blocks[batch_idx * kBatchSize + i] = KkrtRandomOracle(T[i]);
         }
       }
+    });
 
-      MatrixTranspose128(&t);
-      MatrixTranspose128(&u);
-      for (size_t i = 0; i < num_this_batch; ++i) {
-        // T = G(k0)
-        T[i][w] = t[i];
-        // U = G(k1)
-        U[i][w] = u[i];
-      }
-    }
-    // Construct U.
-    // U = G(k1) ^ G(k0) ^ PRC(r)
-    for (size_t i = 0; i < num_this_batch; ++i) {
-      // KkrtRow prc = RandomOracle::GetDefault().Gen<kKkrtWidth>(
-      //    inputs[batch_idx * kBatchSize + i]);
-      KkrtRow prc;
-      AesEncrypt(aes_key, inputs[batch_idx * kBatchSize + i], &prc);
-      for (size_t w = 0; w < kKkrtWidth; ++w) {
-        U[i][w] ^= T[i][w];
-        U[i][w] ^= prc[w];
-      }
-    }
-    ctx->SendAsync(ctx->NextRank(),
-                   ByteContainerView{
-                       reinterpret_cast<const std::byte*>(U.data()), sizeof(U)},
-                   fmt::format("KKRT:{}", batch_idx));
-    for (size_t i = 0; i < num_this_batch; ++i) {
-      // TODO(shuyan.ycf): make correlation break RO plugable. BTW: libOTe use
-      // blake2 and takes 128 bits.
-      // It is enough to just take first 128 bits of sha256 results for PSI now.
-      recv_blocks[batch_idx * kBatchSize + i] = KkrtRandomOracle(T[i]);
+    for (size_t i = 0; i < us.size(); ++i) {
+      ctx->SendAsync(ctx->NextRank(), std::move(us[i]),
+                     fmt::format("KKRT:{}", window + i));
     }
   }
 }
@@ -324,59 +461,60 @@ void KkrtOtExtSender::Init(const std::shared_ptr<link::Context>& ctx,
   YASL_ENFORCE_EQ(base_options.blocks.size(), base_options.choices.size());
   YASL_ENFORCE(kIknpWidth == base_options.choices.size());
   YASL_ENFORCE(num_ot > 0);
+  static auto& ots = GetCounter("yasl_kkrt_send_ots_total");
+  ots.Add(num_ot);
 
   correction_idx_ = 0;
 
   // Build S for sender.
   KkrtRow S{0};
-  for (size_t w = 0; w < kKkrtWidth; ++w) {
-    for (size_t k = 0; k < kKappa; ++k) {
-      S[w] |= uint128_t(base_options.choices[w * kKappa + k] ? 1 : 0) << k;
-    }
-  }
-  // Build PRG from seed Ks.
-  std::vector<PseudoRandomGenerator<block>> prgs;
-
-  for (size_t k = 0; k < kIknpWidth; ++k) {
-    prgs.emplace_back(base_options.blocks[k]);
-  }
-
+  std::copy_n(base_options.choices.words().begin(), kKkrtWidth, S.begin());
   // Build PRF.
   auto kkrt_oprf = std::make_shared<KkrtGroupPRF>(num_ot, S);
   oprf_ = kkrt_oprf;
 
   const size_t num_batch = (num_ot + kBatchSize1024 - 1) / kBatchSize1024;
-  for (size_t batch_idx = 0; batch_idx < num_batch; ++batch_idx) {
-    const size_t num_this_batch =
-        std::min<size_t>(num_ot - batch_idx * kBatchSize1024, kBatchSize1024);
-    std::array<KkrtRow, kBatchSize1024> Q;
-    for (size_t w = 0; w < kKkrtWidth; ++w) {
-      std::array<std::array<block, kNumBlockPerBatch1024>, kKappa> q;
-      for (size_t k = 0; k < kKappa; ++k) {
-        const size_t col_idx = w * kKappa + k;
-
-        for (size_t j = 0; j < kNumBlockPerBatch1024; ++j) {
-          q[k][j] = prgs[col_idx]();
-        }
-      }
-      SseTranspose128x1024(q);
+  parallel_for(0, num_batch, 1, [&](int64_t begin, int64_t end) {
+    // Build PRG from seed Ks, seeked to the first batch of this worker.
+    std::vector<PseudoRandomGenerator<block>> prgs;
+    for (size_t k = 0; k < kIknpWidth; ++k) {
+      prgs.push_back(SeekedPrg<block>(base_options.blocks[k],
+                                      begin * kNumBlockPerBatch1024));
+    }
 
-      for (size_t i = 0; i < kNumBlockPerBatch1024; ++i) {
-        size_t q_idx = i * kKappa;
-        size_t q_batch_num = std::min((size_t)kKappa, num_this_batch - q_idx);
+    for (int64_t batch_idx = begin; batch_idx < end; ++batch_idx) {
+      const size_t num_this_batch = std::min<size_t>(
+          num_ot - batch_idx * kBatchSize1024, kBatchSize1024);
+      std::array<KkrtRow, kBatchSize1024> Q;
+      for (size_t w = 0; w < kKkrtWidth; ++w) {
+        std::array<std::array<block, kNumBlockPerBatch1024>, kKappa> q;
+        for (size_t k = 0; k < kKappa; ++k) {
+          const size_t col_idx = w * kKappa + k;
 
-        for (size_t j = 0; j < q_batch_num; ++j) {
-          Q[q_idx + j][w] = (uint128_t)(q[j][i].mData);
+          for (size_t j = 0; j < kNumBlockPerBatch1024; ++j) {
+            q[k][j] = prgs[col_idx]();
+          }
         }
-        if (q_batch_num < kKappa) {
-          break;
+        MatrixTranspose128x1024(q);
+
+        for (size_t i = 0; i < kNumBlockPerBatch1024; ++i) {
+          size_t q_idx = i * kKappa;
+          size_t q_batch_num =
+              std::min((size_t)kKappa, num_this_batch - q_idx);
+
+          for (size_t j = 0; j < q_batch_num; ++j) {
+            Q[q_idx + j][w] = (uint128_t)(q[j][i].mData);
+          }
+          if (q_batch_num < kKappa) {
+            break;
+          }
         }
       }
-    }
 
-    // Set to PRF.
-    kkrt_oprf->SetQ(Q, batch_idx * kBatchSize1024, num_this_batch);
-  }
+      // Set to PRF.
+      kkrt_oprf->SetQ(Q, batch_idx * kBatchSize1024, num_this_batch);
+    }
+  });
 }
 
 void KkrtOtExtSender::RecvCorrection(const std::shared_ptr<link::Context>& ctx,
@@ -413,123 +551,275 @@ void KkrtOtExtSender::SetCorrection(const yasl::Buffer& recvceived_correction,
   correction_idx_ += recv_count;
 }
 
+void KkrtOtExtSender::StreamRecvCorrection(
+    const std::shared_ptr<link::Context>& ctx, uint64_t recv_count,
+    const std::function<void(uint64_t, uint64_t)>& on_window) {
+  const uint64_t end = correction_idx_ + recv_count;
+  YASL_ENFORCE_LE(end, oprf_->Size());
+  auto recv_window = [&](uint64_t begin) {
+    return ctx->RecvAsync(ctx->NextRank(),
+                          fmt::format("KKRT_STREAM:{}", begin));
+  };
+
+  // double buffered, the next window is received while this one is applied.
+  // window sizes are decided by the receiver, so take them from the buffer.
+  std::future<Buffer> next;
+  if (correction_idx_ < end) {
+    next = recv_window(correction_idx_);
+  }
+  while (correction_idx_ < end) {
+    const uint64_t begin = correction_idx_;
+    Buffer buf = next.get();
+    YASL_ENFORCE(buf.size() > 0 && buf.size() % sizeof(KkrtRow) == 0);
+    const uint64_t count = buf.size() / sizeof(KkrtRow);
+    YASL_ENFORCE_LE(begin + count, end);
+    if (begin + count < end) {
+      next = recv_window(begin + count);
+    }
+    SetCorrection(buf, count);
+    on_window(begin, count);
+  }
+}
+
 void KkrtOtExtSender::Encode(uint64_t ot_idx, const uint128_t input, void* dest,
                              uint64_t dest_size) {
   oprf_->Eval(ot_idx, input, (uint8_t*)dest, dest_size);
 }
 
+void KkrtOtExtSender::BatchEncode(absl::Span<const size_t> ot_idxes,
+                                  absl::Span<const uint128_t> inputs,
+                                  absl::Span<uint8_t> dest,
+                                  uint64_t dest_size) {
+  oprf_->Eval(ot_idxes, inputs, dest, dest_size);
+}
+
 void KkrtOtExtReceiver::Init(const std::shared_ptr<link::Context>& ctx,
                              const BaseSendOptions& base_options,
-                             uint64_t num_ot) {
-  const size_t num_batch = (num_ot + kBatchSize1024 - 1) / kBatchSize1024;
-
+                             uint64_t num_ot, bool lazy) {
+  static auto& ots = GetCounter("yasl_kkrt_recv_ots_total");
+  ots.Add(num_ot);
   AesInit(aes_key_);
 
-  std::vector<PseudoRandomGenerator<block>> prgs0;
-  std::vector<PseudoRandomGenerator<block>> prgs1;
+  base_options_ = base_options;
+  num_ot_ = num_ot;
+  lazy_ = lazy;
+  row_begin_ = 0;
+  T_.clear();
+  U_.clear();
+  correction_idx_ = 0;
 
-  for (size_t k = 0; k < kIknpWidth; ++k) {
-    // Build PRG from seed K0.
-    prgs0.emplace_back(base_options.blocks[k][0]);
-    // Build PRG from seed K1.
-    prgs1.emplace_back(base_options.blocks[k][1]);
+  if (!lazy_) {
+    ExpandRows((num_ot + kBatchSize1024 - 1) / kBatchSize1024);
   }
+}
 
-  T_.resize(num_ot);
-  U_.resize(num_ot);
-  correction_idx_ = 0;
+void KkrtOtExtReceiver::ExpandRows(uint64_t num_batch) {
+  static auto& time = GetHistogram("yasl_kkrt_expand_rows_us");
+  ScopedTimer timer(&time);
+  YASL_ENFORCE(row_begin_ % kBatchSize1024 == 0);
+  const uint64_t first_batch = (row_begin_ + T_.size()) / kBatchSize1024;
+  const uint64_t rows_begin = first_batch * kBatchSize1024;
+  const uint64_t rows_end =
+      std::min<uint64_t>(num_ot_, (first_batch + num_batch) * kBatchSize1024);
+  if (rows_begin >= rows_end) {
+    return;
+  }
+  const uint64_t end_batch = (rows_end + kBatchSize1024 - 1) / kBatchSize1024;
+  T_.resize(rows_end - row_begin_);
+  U_.resize(rows_end - row_begin_);
+  rows_memory_.Set((T_.capacity() + U_.capacity()) * sizeof(KkrtRow));
+
+  // batches are independent, each worker seeks its own prgs to its first
+  // batch.
+  parallel_for(first_batch, end_batch, 1, [&](int64_t begin, int64_t end) {
+    std::vector<PseudoRandomGenerator<block>> prgs0;
+    std::vector<PseudoRandomGenerator<block>> prgs1;
+    for (size_t k = 0; k < kIknpWidth; ++k) {
+      // Build PRG from seed K0.
+      prgs0.push_back(SeekedPrg<block>(base_options_.blocks[k][0],
+                                       begin * kNumBlockPerBatch1024));
+      // Build PRG from seed K1.
+      prgs1.push_back(SeekedPrg<block>(base_options_.blocks[k][1],
+                                       begin * kNumBlockPerBatch1024));
+    }
 
-  // Let us do it streaming way.
-  for (size_t batch_idx = 0; batch_idx < num_batch; ++batch_idx) {
-    const size_t num_this_batch =
-        std::min<size_t>(num_ot - batch_idx * kBatchSize1024, kBatchSize1024);
-    // KKRT can be viewed as a wider IKNP OT EXTENSION.
-    for (size_t w = 0; w < kKkrtWidth; ++w) {
-      std::array<std::array<block, kNumBlockPerBatch1024>, kKappa> t;
-      std::array<std::array<block, kNumBlockPerBatch1024>, kKappa> u;
-      for (size_t k = 0; k < kKappa; ++k) {
-        const size_t col_idx = w * kKappa + k;
-        for (size_t j = 0; j < kNumBlockPerBatch1024; ++j) {
-          t[k][j] = prgs0[col_idx]();
-          u[k][j] = prgs1[col_idx]();
-        }
-      }
-      SseTranspose128x1024(t);
-      SseTranspose128x1024(u);
-
-      size_t batch_start = batch_idx * kBatchSize1024;
-      for (size_t i = 0; i < kNumBlockPerBatch1024; ++i) {
-        size_t tu_idx = i * kKappa;
-        size_t tu_batch_num = std::min((size_t)kKappa, num_this_batch - tu_idx);
-
-        for (size_t j = 0; j < tu_batch_num; ++j) {
-          // T = G(k0)
-          T_[batch_start + tu_idx + j][w] = (uint128_t)t[j][i].mData;
-          // U = G(k1)
-          U_[batch_start + tu_idx + j][w] = (uint128_t)u[j][i].mData;
+    for (int64_t batch_idx = begin; batch_idx < end; ++batch_idx) {
+      const size_t num_this_batch = std::min<size_t>(
+          rows_end - batch_idx * kBatchSize1024, kBatchSize1024);
+      // KKRT can be viewed as a wider IKNP OT EXTENSION.
+      for (size_t w = 0; w < kKkrtWidth; ++w) {
+        std::array<std::array<block, kNumBlockPerBatch1024>, kKappa> t;
+        std::array<std::array<block, kNumBlockPerBatch1024>, kKappa> u;
+        for (size_t k = 0; k < kKappa; ++k) {
+          const size_t col_idx = w * kKappa + k;
+          for (size_t j = 0; j < kNumBlockPerBatch1024; ++j) {
+            t[k][j] = prgs0[col_idx]();
+            u[k][j] = prgs1[col_idx]();
+          }
         }
-        if (tu_batch_num < kKappa) {
-          break;
+        MatrixTranspose128x1024(t);
+        MatrixTranspose128x1024(u);
+
+        size_t batch_start = batch_idx * kBatchSize1024 - row_begin_;
+        for (size_t i = 0; i < kNumBlockPerBatch1024; ++i) {
+          size_t tu_idx = i * kKappa;
+          size_t tu_batch_num =
+              std::min((size_t)kKappa, num_this_batch - tu_idx);
+
+          for (size_t j = 0; j < tu_batch_num; ++j) {
+            // T = G(k0)
+            T_[batch_start + tu_idx + j][w] = (uint128_t)t[j][i].mData;
+            // U = G(k1)
+            U_[batch_start + tu_idx + j][w] = (uint128_t)u[j][i].mData;
+          }
+          if (tu_batch_num < kKappa) {
+            break;
+          }
         }
       }
     }
+  });
+}
+
+void KkrtOtExtReceiver::EnsureRows(uint64_t begin, uint64_t end) {
+  YASL_ENFORCE_LE(end, num_ot_);
+  YASL_ENFORCE(begin >= row_begin_,
+               "kkrt rows of ot {} are discarded, window begins at {}", begin,
+               row_begin_);
+  const uint64_t rows_end = row_begin_ + T_.size();
+  if (end > rows_end) {
+    const uint64_t need =
+        (end - rows_end + kBatchSize1024 - 1) / kBatchSize1024;
+    ExpandRows(std::max<uint64_t>(need, kLazyWindowBatches));
   }
 }
 
+void KkrtOtExtReceiver::DiscardRows() {
+  if (!lazy_) {
+    return;
+  }
+  // keep the batch of correction_idx_, so that rows stay batch aligned.
+  const uint64_t new_begin =
+      correction_idx_ / kBatchSize1024 * kBatchSize1024;
+  if (new_begin <= row_begin_) {
+    return;
+  }
+  const uint64_t n = std::min<uint64_t>(new_begin - row_begin_, T_.size());
+  T_.erase(T_.begin(), T_.begin() + n);
+  U_.erase(U_.begin(), U_.begin() + n);
+  row_begin_ += n;
+  rows_memory_.Set((T_.capacity() + U_.capacity()) * sizeof(KkrtRow));
+}
+
 void KkrtOtExtReceiver::Encode(uint64_t ot_idx,
                                absl::Span<const uint128_t> inputs,
                                absl::Span<uint8_t> dest_encode) {
   YASL_ENFORCE(dest_encode.size() <= sizeof(uint128_t));
+  EnsureRows(ot_idx, ot_idx + 1);
   // KkrtRow prc = RandomOracle::GetDefault().Gen<kKkrtWidth>(inputs[ot_idx]);
   KkrtRow prc;
   AesEncrypt(aes_key_, inputs[ot_idx], &prc);
 
+  const uint64_t row = ot_idx - row_begin_;
   for (size_t w = 0; w < kKkrtWidth; ++w) {
-    U_[ot_idx][w] ^= T_[ot_idx][w];
-    U_[ot_idx][w] ^= prc[w];
+    U_[row][w] ^= T_[row][w];
+    U_[row][w] ^= prc[w];
   }
 
-  KkrtRandomOracle(T_[ot_idx], dest_encode.data(),
+  KkrtRandomOracle(T_[row], dest_encode.data(),
                    std::min(dest_encode.size(), sizeof(uint128_t)));
 }
 
 void KkrtOtExtReceiver::Encode(uint64_t ot_idx, const uint128_t input,
                                absl::Span<uint8_t> dest_encode) {
   YASL_ENFORCE(dest_encode.size() <= sizeof(uint128_t));
+  EnsureRows(ot_idx, ot_idx + 1);
   // KkrtRow prc = RandomOracle::GetDefault().Gen<kKkrtWidth>(input);
   KkrtRow prc;
   AesEncrypt(aes_key_, input, &prc);
 
+  const uint64_t row = ot_idx - row_begin_;
   for (size_t w = 0; w < kKkrtWidth; ++w) {
-    U_[ot_idx][w] ^= T_[ot_idx][w];
-    U_[ot_idx][w] ^= prc[w];
+    U_[row][w] ^= T_[row][w];
+    U_[row][w] ^= prc[w];
   }
 
-  KkrtRandomOracle(T_[ot_idx], dest_encode.data(),
+  KkrtRandomOracle(T_[row], dest_encode.data(),
                    std::min(dest_encode.size(), sizeof(uint128_t)));
 }
 
+void KkrtOtExtReceiver::BatchEncode(uint64_t begin,
+                                    absl::Span<const uint128_t> inputs,
+                                    absl::Span<uint8_t> dest_encode,
+                                    uint64_t dest_size) {
+  YASL_ENFORCE(dest_size <= sizeof(uint128_t));
+  YASL_ENFORCE_EQ(dest_encode.size(), inputs.size() * dest_size);
+  EnsureRows(begin, begin + inputs.size());
+  parallel_for(0, inputs.size(), kEncodeGrain, [&](int64_t b, int64_t e) {
+    for (int64_t i = b; i < e; i += kAesBatch) {
+      const size_t n = std::min<size_t>(kAesBatch, e - i);
+      std::array<KkrtRow, kAesBatch> prcs;
+      AesEncrypt(aes_key_, &inputs[i], n, &prcs);
+      const size_t row = begin - row_begin_ + i;
+      XorThree(RowWords(&U_[row], n), RowWords(&T_[row], n),
+               RowWords(prcs.data(), n));
+      for (size_t j = 0; j < n; ++j) {
+        KkrtRandomOracle(T_[row + j], &dest_encode[(i + j) * dest_size],
+                         dest_size);
+      }
+    }
+  });
+}
+
+void KkrtOtExtReceiver::StreamEncode(const std::shared_ptr<link::Context>& ctx,
+                                     absl::Span<const uint128_t> inputs,
+                                     absl::Span<uint8_t> dest_encode,
+                                     uint64_t dest_size) {
+  YASL_ENFORCE(batch_size_ > 0);
+  YASL_ENFORCE_EQ(dest_encode.size(), inputs.size() * dest_size);
+  for (uint64_t i = 0; i < inputs.size(); i += batch_size_) {
+    const uint64_t count = std::min<uint64_t>(batch_size_, inputs.size() - i);
+    BatchEncode(correction_idx_, inputs.subspan(i, count),
+                dest_encode.subspan(i * dest_size, count * dest_size),
+                dest_size);
+    ctx->SendAsync(ctx->NextRank(),
+                   ByteContainerView{reinterpret_cast<const char*>(
+                                         &U_[correction_idx_ - row_begin_]),
+                                     count * sizeof(KkrtRow)},
+                   fmt::format("KKRT_STREAM:{}", correction_idx_));
+    correction_idx_ += count;
+    DiscardRows();
+  }
+}
+
 void KkrtOtExtReceiver::ZeroEncode(uint64_t ot_idx) {
+  EnsureRows(ot_idx, ot_idx + 1);
+  const uint64_t row = ot_idx - row_begin_;
   for (size_t w = 0; w < kKkrtWidth; ++w) {
-    U_[ot_idx][w] ^= T_[ot_idx][w];
+    U_[row][w] ^= T_[row][w];
   }
 }
 
 void KkrtOtExtReceiver::SendCorrection(
     const std::shared_ptr<link::Context>& ctx, uint64_t send_count) {
-  ctx->SendAsync(ctx->NextRank(),
-                 ByteContainerView{reinterpret_cast<const char*>(U_.data()) +
-                                       (correction_idx_ * sizeof(KkrtRow)),
-                                   send_count * sizeof(KkrtRow)},
-                 fmt::format("KKRT:{}", send_count));
+  EnsureRows(correction_idx_, correction_idx_ + send_count);
+  ctx->SendAsync(
+      ctx->NextRank(),
+      ByteContainerView{reinterpret_cast<const char*>(U_.data()) +
+                            ((correction_idx_ - row_begin_) * sizeof(KkrtRow)),
+                        send_count * sizeof(KkrtRow)},
+      fmt::format("KKRT:{}", send_count));
   correction_idx_ += send_count;
+  DiscardRows();
 }
 
 yasl::Buffer KkrtOtExtReceiver::ShiftCorrection(uint64_t send_count) {
+  EnsureRows(correction_idx_, correction_idx_ + send_count);
   yasl::Buffer buf(reinterpret_cast<const char*>(U_.data()) +
-                       (correction_idx_ * sizeof(KkrtRow)),
+                       ((correction_idx_ - row_begin_) * sizeof(KkrtRow)),
                    send_count * sizeof(KkrtRow));
   correction_idx_ += send_count;
+  DiscardRows();
   return buf;
 }
 
@@ -15,9 +15,13 @@
 
 #pragma once
 
+#include <functional>
+
 #include "absl/types/span.h"
 #include "emp-tool/utils/aes_opt.h"
 
+#include "yasl/base/huge_page.h"
+#include "yasl/base/memory_tracker.h"
 #include "yasl/link/link.h"
 #include "yasl/mpctools/ot/options.h"
 
@@ -38,6 +42,16 @@ class IGroupPRF {
   virtual void Eval(size_t group_idx, uint128_t input, uint8_t* buf,
                     size_t bufsize) = 0;
 
+  // Batch of Eval(group_idxes[i], inputs[i]). By default, the scalar Eval
+  // is called one by one, the KKRT PRFs evaluate the batch in parallel.
+  virtual void Eval(absl::Span<const size_t> group_idxes,
+                    absl::Span<const uint128_t> inputs,
+                    absl::Span<uint128_t> outputs);
+  // Output i is buf[i * bufsize, (i + 1) * bufsize).
+  virtual void Eval(absl::Span<const size_t> group_idxes,
+                    absl::Span<const uint128_t> inputs,
+                    absl::Span<uint8_t> buf, size_t bufsize);
+
   virtual size_t Size() const = 0;
 };
 
@@ -103,7 +117,20 @@ class KkrtOtExtSender {
   void SetCorrection(const yasl::Buffer& recvceived_correction,
                      uint64_t recv_count);
 
+  // pipelined version of RecvCorrection, for corrections streamed by
+  // KkrtOtExtReceiver::StreamEncode. corrections of `recv_count` ots arrive
+  // in the receiver's windows, `on_window(begin, count)` is called as soon as
+  // a window is applied, while the next one is being received.
+  void StreamRecvCorrection(
+      const std::shared_ptr<link::Context>& ctx, uint64_t recv_count,
+      const std::function<void(uint64_t, uint64_t)>& on_window);
+
   void Encode(uint64_t ot_idx, uint128_t input, void* dest, uint64_t dest_ize);
+  // Encode inputs[i] by ot ot_idxes[i] into
+  // dest[i * dest_size, (i + 1) * dest_size), in parallel.
+  void BatchEncode(absl::Span<const size_t> ot_idxes,
+                   absl::Span<const uint128_t> inputs, absl::Span<uint8_t> dest,
+                   uint64_t dest_size);
 
   std::shared_ptr<IGroupPRF> GetOprf() { return oprf_; }
 
@@ -120,15 +147,30 @@ class KkrtOtExtReceiver {
  public:
   KkrtOtExtReceiver() = default;
 
+  // When `lazy` is set, T/U rows are expanded from the base ot seeds on demand
+  // and discarded once their correction is sent, so memory is bounded by the
+  // unsent window instead of `num_ot`. OTs must then be encoded and corrected
+  // in (roughly) increasing order.
   void Init(const std::shared_ptr<link::Context>& ctx,
-            const BaseSendOptions& base_options, uint64_t num_ot);
+            const BaseSendOptions& base_options, uint64_t num_ot,
+            bool lazy = false);
 
   void Encode(uint64_t ot_idx, absl::Span<const uint128_t> inputs,
               absl::Span<uint8_t> dest_encode);
   void Encode(uint64_t ot_idx, uint128_t input,
               absl::Span<uint8_t> dest_encode);
+  // Encode inputs[i] by ot `begin + i` into
+  // dest_encode[i * dest_size, (i + 1) * dest_size), in parallel.
+  void BatchEncode(uint64_t begin, absl::Span<const uint128_t> inputs,
+                   absl::Span<uint8_t> dest_encode, uint64_t dest_size);
   void ZeroEncode(uint64_t ot_idx);
 
+  // encode inputs by the next ots in windows of batch size, the correction of
+  // each window is sent in background while the next one is being encoded.
+  void StreamEncode(const std::shared_ptr<link::Context>& ctx,
+                    absl::Span<const uint128_t> inputs,
+                    absl::Span<uint8_t> dest_encode, uint64_t dest_size);
+
   void SendCorrection(const std::shared_ptr<link::Context>& ctx,
                       uint64_t send_count);
   yasl::Buffer ShiftCorrection(uint64_t send_count);
@@ -137,8 +179,23 @@ class KkrtOtExtReceiver {
   void SetBatchSize(uint64_t batch_size) { batch_size_ = batch_size; }
 
  private:
-  std::vector<KkrtRow> T_;
-  std::vector<KkrtRow> U_;
+  // expand the next `num_batch` batches of rows after the current ones.
+  void ExpandRows(uint64_t num_batch);
+  // make sure rows of ots [begin, end) are available.
+  void EnsureRows(uint64_t begin, uint64_t end);
+  // in lazy mode, drop rows whose correction has been sent.
+  void DiscardRows();
+
+  BaseSendOptions base_options_;
+  uint64_t num_ot_ = 0;
+  bool lazy_ = false;
+
+  // T_[i] and U_[i] are rows of ot `row_begin_ + i`.
+  HugePageVector<KkrtRow> T_;
+  HugePageVector<KkrtRow> U_;
+  uint64_t row_begin_ = 0;
+  // of T_ and U_.
+  MemoryCharge rows_memory_{MemoryTag::Get("ot.kkrt")};
 
   uint64_t batch_size_ = 128;
   uint64_t correction_idx_ = 0;
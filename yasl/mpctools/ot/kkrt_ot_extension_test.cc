@@ -19,7 +19,9 @@
 #include <gtest/gtest.h>
 #include <spdlog/spdlog.h>
 
+#include <cstring>
 #include <future>
+#include <numeric>
 #include <thread>
 
 #include "yasl/base/exception.h"
@@ -211,4 +213,179 @@ INSTANTIATE_TEST_SUITE_P(Works_Instances2, KkrtOtExtTest2,
                                          TestParams{65536}  //
                                          ));
 
+TEST(KkrtOtExtBatchEncodeTest, ShouldMatchEncode) {
+  // GIVEN
+  auto contexts = link::test::SetupWorld(2);
+  auto [send_opts, recv_opts] = MakeBaseOptions(512);
+
+  // not aligned to the aes batches, nor to the parallel tasks.
+  const size_t num_ot = 4099;
+  const size_t encode_size = 9;
+  std::vector<uint128_t> inputs(num_ot);
+  PseudoRandomGenerator<uint128_t> prg;
+  std::generate(inputs.begin(), inputs.end(),
+                [&]() -> uint128_t { return prg(); });
+
+  KkrtOtExtSender kkrt_sender;
+  KkrtOtExtReceiver kkrt_receiver;
+  kkrt_sender.Init(contexts[0], recv_opts, num_ot);
+  kkrt_receiver.Init(contexts[1], send_opts, num_ot);
+  kkrt_sender.SetBatchSize(num_ot);
+  kkrt_receiver.SetBatchSize(num_ot);
+
+  // WHEN
+  std::vector<uint8_t> recv_out(num_ot * encode_size);
+  kkrt_receiver.BatchEncode(0, absl::MakeConstSpan(inputs),
+                            absl::MakeSpan(recv_out), encode_size);
+  kkrt_receiver.SendCorrection(contexts[1], num_ot);
+  kkrt_sender.RecvCorrection(contexts[0], num_ot);
+
+  std::vector<size_t> ot_idxes(num_ot);
+  std::iota(ot_idxes.begin(), ot_idxes.end(), 0);
+  std::vector<uint8_t> send_out(num_ot * encode_size);
+  kkrt_sender.BatchEncode(absl::MakeConstSpan(ot_idxes),
+                          absl::MakeConstSpan(inputs), absl::MakeSpan(send_out),
+                          encode_size);
+  std::vector<uint128_t> send_out128(num_ot);
+  kkrt_sender.GetOprf()->Eval(absl::MakeConstSpan(ot_idxes),
+                              absl::MakeConstSpan(inputs),
+                              absl::MakeSpan(send_out128));
+
+  // THEN
+  EXPECT_EQ(send_out, recv_out);
+  auto encoder = kkrt_sender.GetOprf();
+  for (size_t i = 0; i < num_ot; ++i) {
+    std::vector<uint8_t> encoded(encode_size);
+    encoder->Eval(i, inputs[i], encoded.data(), encode_size);
+    EXPECT_EQ(std::memcmp(encoded.data(), &send_out[i * encode_size],
+                          encode_size),
+              0);
+    EXPECT_EQ(send_out128[i], encoder->Eval(i, inputs[i]));
+  }
+}
+
+// implements the scalar Evals only.
+class ScalarPrf : public IGroupPRF {
+ public:
+  uint128_t Eval(size_t group_idx, uint128_t input) override {
+    return input * 3 + group_idx;
+  }
+
+  void Eval(size_t group_idx, uint128_t input, uint8_t* buf,
+            size_t bufsize) override {
+    std::fill_n(buf, bufsize, static_cast<uint8_t>(Eval(group_idx, input)));
+  }
+
+  size_t Size() const override { return 4; }
+};
+
+TEST(KkrtOtExtBatchEncodeTest, DefaultBatchShouldMatchScalar) {
+  ScalarPrf prf;
+  IGroupPRF& base = prf;
+  const std::vector<size_t> idxes = {3, 0, 2};
+  const std::vector<uint128_t> inputs = {5, 7, 11};
+  std::vector<uint128_t> outputs(3);
+  std::vector<uint8_t> buf(3 * 2);
+  base.Eval(idxes, inputs, absl::MakeSpan(outputs));
+  base.Eval(idxes, inputs, absl::MakeSpan(buf), 2);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    EXPECT_EQ(outputs[i], prf.Eval(idxes[i], inputs[i]));
+    EXPECT_EQ(buf[2 * i], static_cast<uint8_t>(outputs[i]));
+    EXPECT_EQ(buf[2 * i + 1], static_cast<uint8_t>(outputs[i]));
+  }
+  EXPECT_ANY_THROW(base.Eval(idxes, inputs, absl::MakeSpan(buf), 3));
+}
+
+TEST(KkrtOtExtStreamTest, Works) {
+  // GIVEN
+  auto contexts = link::test::SetupWorld(2);
+  auto [send_opts, recv_opts] = MakeBaseOptions(512);
+
+  const size_t num_ot = 4099;
+  std::vector<uint128_t> inputs(num_ot);
+  PseudoRandomGenerator<uint128_t> prg;
+  std::generate(inputs.begin(), inputs.end(),
+                [&]() -> uint128_t { return prg(); });
+
+  KkrtOtExtSender kkrt_sender;
+  KkrtOtExtReceiver kkrt_receiver;
+  kkrt_sender.Init(contexts[0], recv_opts, num_ot);
+  kkrt_receiver.Init(contexts[1], send_opts, num_ot);
+  kkrt_receiver.SetBatchSize(896);
+
+  // WHEN
+  // streamed by two calls, the sender follows the receiver's windows.
+  std::vector<uint128_t> recv_out(num_ot);
+  std::future<void> receiver = std::async([&] {
+    const size_t half = num_ot / 2;
+    auto dest = absl::MakeSpan(reinterpret_cast<uint8_t*>(recv_out.data()),
+                               num_ot * sizeof(uint128_t));
+    kkrt_receiver.StreamEncode(
+        contexts[1], absl::MakeConstSpan(inputs).subspan(0, half),
+        dest.subspan(0, half * sizeof(uint128_t)), sizeof(uint128_t));
+    kkrt_receiver.StreamEncode(contexts[1],
+                               absl::MakeConstSpan(inputs).subspan(half),
+                               dest.subspan(half * sizeof(uint128_t)),
+                               sizeof(uint128_t));
+  });
+
+  std::vector<uint128_t> send_out(num_ot);
+  size_t next_begin = 0;
+  kkrt_sender.StreamRecvCorrection(
+      contexts[0], num_ot, [&](uint64_t begin, uint64_t count) {
+        EXPECT_EQ(begin, next_begin);
+        next_begin = begin + count;
+        for (size_t i = begin; i < begin + count; ++i) {
+          send_out[i] = kkrt_sender.GetOprf()->Eval(i, inputs[i]);
+        }
+      });
+  receiver.get();
+
+  // THEN
+  EXPECT_EQ(next_begin, num_ot);
+  EXPECT_EQ(send_out, recv_out);
+}
+
+TEST(KkrtOtExtLazyTest, Works) {
+  // GIVEN
+  auto contexts = link::test::SetupWorld(2);
+  auto [send_opts, recv_opts] = MakeBaseOptions(512);
+
+  // spans several lazy windows, and ends in the middle of a batch.
+  const size_t num_ot = 40001;
+  const size_t batch_size = 3000;
+  std::vector<uint128_t> inputs(num_ot);
+  PseudoRandomGenerator<uint128_t> prg;
+  std::generate(inputs.begin(), inputs.end(),
+                [&]() -> uint128_t { return prg(); });
+
+  KkrtOtExtSender kkrt_sender;
+  KkrtOtExtReceiver kkrt_receiver;
+  kkrt_sender.Init(contexts[0], recv_opts, num_ot);
+  kkrt_receiver.Init(contexts[1], send_opts, num_ot, true);
+
+  // WHEN
+  std::vector<uint128_t> recv_out(num_ot);
+  for (size_t begin = 0; begin < num_ot; begin += batch_size) {
+    const size_t n = std::min(batch_size, num_ot - begin);
+    kkrt_receiver.BatchEncode(
+        begin, absl::MakeConstSpan(inputs).subspan(begin, n),
+        absl::MakeSpan(reinterpret_cast<uint8_t*>(&recv_out[begin]),
+                       n * sizeof(uint128_t)),
+        sizeof(uint128_t));
+    kkrt_receiver.SendCorrection(contexts[1], n);
+    kkrt_sender.RecvCorrection(contexts[0], n);
+  }
+
+  // THEN
+  auto encoder = kkrt_sender.GetOprf();
+  for (size_t i = 0; i < num_ot; ++i) {
+    EXPECT_EQ(encoder->Eval(i, inputs[i]), recv_out[i]);
+  }
+  // rows of corrected ots are gone.
+  std::vector<uint8_t> dest(sizeof(uint128_t));
+  EXPECT_THROW(kkrt_receiver.Encode(0, inputs[0], absl::MakeSpan(dest)),
+               ::yasl::Exception);
+}
+
 }  // namespace yasl
@@ -0,0 +1,145 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/kos_ot_extension.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include "yasl/base/byte_container_view.h"
+#include "yasl/base/exception.h"
+#include "yasl/base/huge_page.h"
+#include "yasl/base/int128.h"
+#include "yasl/crypto/crhash.h"
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/mpctools/ot/gf128.h"
+#include "yasl/utils/parallel.h"
+#include "yasl/utils/rand.h"
+
+namespace yasl {
+namespace {
+
+// extra ots which hide the choices leaked by the check, kappa + s of KOS15.
+constexpr size_t kKappa = 128;
+constexpr size_t kStatSecurity = 40;
+constexpr size_t kNumCheckOt = kKappa + kStatSecurity;
+constexpr size_t kBatchSize = 128;
+
+// chi_i of all ots, expanded from the seed of sender.
+std::vector<uint128_t> ExpandChallenge(uint128_t seed, size_t num) {
+  std::vector<uint128_t> chi(num);
+  PseudoRandomGenerator<uint128_t>(seed).Fill(absl::MakeSpan(chi));
+  return chi;
+}
+
+}  // namespace
+
+void KosRotSend(const std::shared_ptr<link::Context>& ctx,
+                const BaseRecvOptions& base_options,
+                absl::Span<std::array<uint128_t, 2>> send_blocks,
+                size_t batches_per_msg) {
+  YASL_ENFORCE(!send_blocks.empty());
+  const size_t num_ot = send_blocks.size();
+
+  HugePageVector<uint128_t> q(num_ot + kNumCheckOt);
+  const uint128_t delta =
+      IknpCotSend(ctx, base_options, absl::MakeSpan(q), batches_per_msg);
+
+  // all of u has been received, the challenge can be sent now.
+  const uint128_t seed = RandSeed();
+  ctx->SendAsync(ctx->NextRank(),
+                 ByteContainerView{reinterpret_cast<const char*>(&seed),
+                                   sizeof(seed)},
+                 "KOS:SEED");
+  const auto chi = ExpandChallenge(seed, q.size());
+
+  auto buf = ctx->Recv(ctx->NextRank(), "KOS:CHECK");
+  YASL_ENFORCE(static_cast<size_t>(buf.size()) == 2 * sizeof(uint128_t),
+               "unexpected check size={}", buf.size());
+  std::array<uint128_t, 2> xt;
+  std::memcpy(xt.data(), buf.data(), sizeof(xt));
+  YASL_ENFORCE(GfMulInnerProduct(chi, q) == (xt[1] ^ GfMul128(xt[0], delta)),
+               "kos consistency check failed");
+
+  // Break correlation, tweaked by the ot index.
+  parallel_for(0, num_ot, kBatchSize, [&](int64_t begin, int64_t end) {
+    std::vector<uint128_t> h0(q.begin() + begin, q.begin() + end);
+    std::vector<uint128_t> h1(h0.size());
+    for (size_t i = 0; i < h0.size(); ++i) {
+      h1[i] = h0[i] ^ delta;
+    }
+    TccrHash(absl::MakeConstSpan(h0), begin, absl::MakeSpan(h0));
+    TccrHash(absl::MakeConstSpan(h1), begin, absl::MakeSpan(h1));
+    for (size_t i = 0; i < h0.size(); ++i) {
+      send_blocks[begin + i] = {h0[i], h1[i]};
+    }
+  });
+}
+
+void KosRotRecv(const std::shared_ptr<link::Context>& ctx,
+                const BaseSendOptions& base_options,
+                absl::Span<const uint128_t> choices,
+                absl::Span<uint128_t> recv_blocks, size_t batches_per_msg) {
+  YASL_ENFORCE(!recv_blocks.empty());
+  const size_t num_ot = recv_blocks.size();
+  YASL_ENFORCE(choices.size() == (num_ot + kBatchSize - 1) / kBatchSize);
+
+  // choices of the check ots are random.
+  const size_t num_total = num_ot + kNumCheckOt;
+  std::vector<uint128_t> ext_choices((num_total + kBatchSize - 1) /
+                                     kBatchSize);
+  std::copy(choices.begin(), choices.end(), ext_choices.begin());
+  std::vector<uint128_t> pad((kNumCheckOt + kBatchSize - 1) / kBatchSize);
+  PseudoRandomGenerator<uint128_t>(RandSeed()).Fill(absl::MakeSpan(pad));
+  for (size_t j = 0; j < kNumCheckOt; ++j) {
+    const size_t i = num_ot + j;
+    const uint128_t bit = uint128_t(1) << (i % kBatchSize);
+    ext_choices[i / kBatchSize] &= ~bit;
+    if ((pad[j / kBatchSize] >> (j % kBatchSize)) & 1) {
+      ext_choices[i / kBatchSize] |= bit;
+    }
+  }
+
+  HugePageVector<uint128_t> t(num_total);
+  IknpCotRecv(ctx, base_options, ext_choices, absl::MakeSpan(t),
+              batches_per_msg);
+
+  auto buf = ctx->Recv(ctx->NextRank(), "KOS:SEED");
+  YASL_ENFORCE(static_cast<size_t>(buf.size()) == sizeof(uint128_t),
+               "unexpected seed size={}", buf.size());
+  uint128_t seed;
+  std::memcpy(&seed, buf.data(), sizeof(seed));
+  const auto chi = ExpandChallenge(seed, num_total);
+
+  // x = sum chi_i * r_i, t = sum chi_i * t_i
+  std::array<uint128_t, 2> xt = {0, GfMulInnerProduct(chi, t)};
+  for (size_t i = 0; i < num_total; ++i) {
+    const auto r = (ext_choices[i / kBatchSize] >> (i % kBatchSize)) & 1;
+    xt[0] ^= chi[i] & (uint128_t(0) - r);
+  }
+  ctx->SendAsync(ctx->NextRank(),
+                 ByteContainerView{reinterpret_cast<const char*>(xt.data()),
+                                   sizeof(xt)},
+                 "KOS:CHECK");
+
+  // Break correlation, tweaked by the ot index.
+  parallel_for(0, num_ot, kBatchSize, [&](int64_t begin, int64_t end) {
+    auto in = absl::MakeConstSpan(&t[begin], end - begin);
+    TccrHash(in, begin, recv_blocks.subspan(begin, end - begin));
+  });
+}
+
+}  // namespace yasl
@@ -0,0 +1,59 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+
+#include "absl/types/span.h"
+
+#include "yasl/link/link.h"
+#include "yasl/mpctools/ot/iknp_ot_extension.h"
+#include "yasl/mpctools/ot/options.h"
+
+namespace yasl {
+
+// KosRotSend KosRotRecv
+//
+// Random OT extension secure against a malicious receiver, KOS15.
+// See https://eprint.iacr.org/2015/546.pdf
+//
+// The correlated OTs are extended by the IKNP pipeline as is, for
+// kappa + s = 128 + 40 more ots than asked whose choices are random and never
+// output. Then the receiver proves its columns are consistent with one choice
+// bit per ot by a single random linear combination over GF(2^128):
+//  * sender picks a seed after all of u has arrived, both sides expand it to
+//    chi_i for all ots.
+//  * receiver sends x = sum chi_i * r_i and t = sum chi_i * t_i.
+//  * sender checks sum chi_i * q_i == t ^ x * delta, or throws.
+// It costs one round trip of two blocks and an inner product, on top of the
+// semi-honest IKNP.
+//
+// NOTE |choices| need to be round up to 128, same as IKNP.
+
+// Sender gets random pairs (H(q_i, i), H(q_i ^ delta, i)) of TccrHash, throws
+// if the check fails.
+void KosRotSend(const std::shared_ptr<link::Context>& ctx,
+                const BaseRecvOptions& base_options,
+                absl::Span<std::array<uint128_t, 2>> send_blocks,
+                size_t batches_per_msg = kIknpBatchesPerMsg);
+
+// Receiver gets the one of its choice bit.
+void KosRotRecv(const std::shared_ptr<link::Context>& ctx,
+                const BaseSendOptions& base_options,
+                absl::Span<const uint128_t> choices,
+                absl::Span<uint128_t> recv_blocks,
+                size_t batches_per_msg = kIknpBatchesPerMsg);
+
+}  // namespace yasl
@@ -0,0 +1,135 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/kos_ot_extension.h"
+
+#include <future>
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/byte_container_view.h"
+#include "yasl/base/exception.h"
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/mpctools/ot/iknp_ot_extension.h"
+#include "yasl/link/test_util.h"
+
+namespace yasl {
+
+namespace {
+
+std::pair<BaseSendOptions, BaseRecvOptions> MakeBaseOptions(size_t num) {
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  recv_opts.choices = CreateRandomChoices(num);
+  std::random_device rd;
+  PseudoRandomGenerator<uint128_t> gen(rd());
+  for (size_t i = 0; i < num; ++i) {
+    send_opts.blocks.push_back({gen(), gen()});
+    recv_opts.blocks.push_back(send_opts.blocks[i][recv_opts.choices[i]]);
+  }
+  return {std::move(send_opts), std::move(recv_opts)};
+}
+
+}  // namespace
+
+class KosRotTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(KosRotTest, Works) {
+  // GIVEN
+  auto contexts = link::test::SetupWorld(2);
+  auto [send_opts, recv_opts] = MakeBaseOptions(128);
+  const size_t num_ot = GetParam();
+  auto choices = CreateRandomChoiceBits<uint128_t>(num_ot);
+  std::vector<std::array<uint128_t, 2>> send_out(num_ot);
+  std::vector<uint128_t> recv_out(num_ot);
+
+  // WHEN
+  std::future<void> sender = std::async([&] {
+    KosRotSend(contexts[0], recv_opts, absl::MakeSpan(send_out));
+  });
+  std::future<void> receiver = std::async([&] {
+    KosRotRecv(contexts[1], send_opts, choices, absl::MakeSpan(recv_out));
+  });
+  sender.get();
+  receiver.get();
+
+  // THEN
+  for (size_t i = 0; i < num_ot; ++i) {
+    const auto c = (choices[i / 128] >> (i % 128)) & 1;
+    EXPECT_EQ(send_out[i][c], recv_out[i]) << i;
+    EXPECT_NE(send_out[i][1 - c], recv_out[i]) << i;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Works_Instances, KosRotTest,
+                         testing::Values(1, 128, 129, 4095, 8192 * 3 + 5));
+
+TEST(KosRotTest, ShouldThrowOnInconsistentReceiver) {
+  // GIVEN
+  auto contexts = link::test::SetupWorld(2);
+  auto [send_opts, recv_opts] = MakeBaseOptions(128);
+  // receiver builds column k from a K_1 the sender does not hold.
+  size_t k = 0;
+  while (!recv_opts.choices[k]) {
+    ++k;
+  }
+  send_opts.blocks[k][1] ^= 1;
+
+  const size_t num_ot = 1024;
+  auto choices = CreateRandomChoiceBits<uint128_t>(num_ot);
+  std::vector<std::array<uint128_t, 2>> send_out(num_ot);
+  std::vector<uint128_t> recv_out(num_ot);
+
+  // WHEN THEN
+  std::future<void> sender = std::async([&] {
+    EXPECT_THROW(KosRotSend(contexts[0], recv_opts, absl::MakeSpan(send_out)),
+                 ::yasl::Exception);
+  });
+  KosRotRecv(contexts[1], send_opts, choices, absl::MakeSpan(recv_out));
+  sender.get();
+}
+
+TEST(KosRotTest, ShouldThrowOnForgedCheck) {
+  // GIVEN
+  auto contexts = link::test::SetupWorld(2);
+  auto [send_opts, recv_opts] = MakeBaseOptions(128);
+  // kappa + s check ots of the sender.
+  const size_t num_ot = 1024;
+  const size_t num_total = num_ot + 128 + 40;
+  auto choices = CreateRandomChoiceBits<uint128_t>(num_total);
+  std::vector<std::array<uint128_t, 2>> send_out(num_ot);
+
+  // WHEN THEN
+  std::future<void> sender = std::async(std::launch::async, [&] {
+    EXPECT_THROW(KosRotSend(contexts[0], recv_opts, absl::MakeSpan(send_out)),
+                 ::yasl::Exception);
+  });
+  // receiver runs honest iknp, then answers the challenge with random blocks
+  // instead of x and t.
+  std::vector<uint128_t> t(num_total);
+  IknpCotRecv(contexts[1], send_opts, choices, absl::MakeSpan(t));
+  contexts[1]->Recv(contexts[1]->NextRank(), "KOS:SEED");
+  std::random_device rd;
+  PseudoRandomGenerator<uint128_t> gen(rd());
+  std::array<uint128_t, 2> xt = {gen(), gen()};
+  contexts[1]->SendAsync(
+      contexts[1]->NextRank(),
+      ByteContainerView{reinterpret_cast<const char*>(xt.data()), sizeof(xt)},
+      "KOS:CHECK");
+  sender.get();
+}
+
+}  // namespace yasl
@@ -15,6 +15,7 @@
 
 #include <future>
 #include <iostream>
+#include <memory>
 #include <random>
 
 #include "benchmark/benchmark.h"
@@ -115,6 +116,51 @@ static void BM_SseTrans1024(benchmark::State& state) {
   }
 }
 
+// dispatched at runtime, avx2 if the cpu supports it.
+static void BM_MatrixTrans(benchmark::State& state) {
+  std::array<uint128_t, 128> matrix;
+  GenerateRandomMatrix(&matrix);
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t n = state.range(0);
+    state.ResumeTiming();
+    for (size_t i = 0; i < n; i++) {
+      yasl::MatrixTranspose128(&matrix);
+    }
+  }
+}
+
+static void BM_MatrixTrans1024(benchmark::State& state) {
+  std::array<std::array<uint128_t, 8>, 128> matrix;
+  GenerateRandomMatrix1024(&matrix);
+  for (auto _ : state) {
+    state.PauseTiming();
+    size_t n = state.range(0);
+    state.ResumeTiming();
+    for (size_t i = 0; i < n; i++) {
+      yasl::MatrixTranspose128x1024(&matrix);
+    }
+  }
+}
+
+// the (128 * K) x (128 * M) matrix, tiles are transposed by the fastest
+// kernel, matrices of MBs show whether it runs at memory bandwidth.
+template <size_t K, size_t M>
+static void BM_MatrixTransKxM(benchmark::State& state) {
+  using Matrix = std::array<uint128_t, 128 * K * M>;
+  auto in = std::make_unique<Matrix>();
+  auto out = std::make_unique<Matrix>();
+  yasl::PseudoRandomGenerator<uint128_t> prg;
+  for (auto& x : *in) {
+    x = prg();
+  }
+  for (auto _ : state) {
+    yasl::MatrixTranspose<K, M>(*in, out.get());
+    benchmark::DoNotOptimize(out->data());
+  }
+  state.SetBytesProcessed(state.iterations() * sizeof(Matrix));
+}
+
 BENCHMARK(BM_NaiveTrans)
     ->Unit(benchmark::kMillisecond)
     ->Arg(1024)
@@ -162,4 +208,28 @@ BENCHMARK(BM_SseTrans1024)
     ->Arg(10240)
     ->Arg(1 << 21);
 
+BENCHMARK(BM_MatrixTrans)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(1024)
+    ->Arg(5120)
+    ->Arg(10240)
+    ->Arg(20480)
+    ->Arg(40960)
+    ->Arg(81920);
+
+BENCHMARK(BM_MatrixTrans1024)
+    ->Unit(benchmark::kMillisecond)
+    ->Arg(128)
+    ->Arg(640)
+    ->Arg(1280)
+    ->Arg(2560)
+    ->Arg(5120)
+    ->Arg(10240);
+
+BENCHMARK_TEMPLATE(BM_MatrixTransKxM, 1, 8);
+BENCHMARK_TEMPLATE(BM_MatrixTransKxM, 8, 8);
+BENCHMARK_TEMPLATE(BM_MatrixTransKxM, 64, 64);
+BENCHMARK_TEMPLATE(BM_MatrixTransKxM, 8, 512);
+BENCHMARK_TEMPLATE(BM_MatrixTransKxM, 512, 8);
+
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,254 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// End to end benchmarks of OT protocols, both parties run in this process
+// over FactoryMem or FactoryBrpc in loopback.
+//
+// Args of each benchmark are the factory, 0 for mem and 1 for brpc, and log2
+// of the number of OTs. Extensions take pre-generated base OTs, so base OTs
+// are measured by BM_BaseOt only. Reported counters:
+//  - items_per_second: OTs per second of wall time.
+//  - bytes_per_ot: bytes sent by both parties per OT.
+//  - rounds: msgs sent by both parties per run, batched msgs count as one.
+//  - peak_rss_mb: peak resident set size of the process so far, it never
+//    decreases, so run one benchmark per process with --benchmark_filter to
+//    get the peak of a single size.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <future>
+#include <map>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/link/context.h"
+#include "yasl/link/factory.h"
+#include "yasl/mpctools/ot/base_ot.h"
+#include "yasl/mpctools/ot/iknp_ot_extension.h"
+#include "yasl/mpctools/ot/kkrt_ot_extension.h"
+#include "yasl/mpctools/ot/punctured_rand_ot.h"
+
+namespace {
+
+using yasl::link::Context;
+
+enum FactoryType : int64_t { kMem = 0, kBrpc = 1 };
+
+using World = std::vector<std::shared_ptr<Context>>;
+
+// worlds of two parties, one per factory, kept for the whole run.
+const World& GetWorld(int64_t factory) {
+  static std::map<int64_t, World> worlds;
+  static uint16_t next_port = 19400;
+
+  auto& world = worlds[factory];
+  if (!world.empty()) {
+    return world;
+  }
+
+  yasl::link::ContextDesc desc;
+  desc.id = fmt::format("ot_bench-{}", factory);
+  for (size_t rank = 0; rank < 2; rank++) {
+    desc.parties.push_back(
+        {fmt::format("party-{}", rank),
+         fmt::format("127.0.0.1:{}", factory == kBrpc ? next_port++ : 0)});
+  }
+
+  world.resize(2);
+  for (size_t rank = 0; rank < 2; rank++) {
+    if (factory == kBrpc) {
+      world[rank] = yasl::link::FactoryBrpc().CreateContext(desc, rank);
+    } else {
+      world[rank] = yasl::link::FactoryMem().CreateContext(desc, rank);
+    }
+  }
+  std::vector<std::future<void>> jobs;
+  for (const auto& ctx : world) {
+    jobs.push_back(
+        std::async(std::launch::async, [&] { ctx->ConnectToMesh(); }));
+  }
+  for (auto& job : jobs) {
+    job.get();
+  }
+  return world;
+}
+
+std::pair<yasl::BaseSendOptions, yasl::BaseRecvOptions> MakeBaseOptions(
+    size_t num) {
+  yasl::BaseSendOptions send_opts;
+  yasl::BaseRecvOptions recv_opts;
+  recv_opts.choices = yasl::CreateRandomChoices(num);
+  std::random_device rd;
+  yasl::PseudoRandomGenerator<uint128_t> gen(rd());
+  for (size_t i = 0; i < num; ++i) {
+    send_opts.blocks.push_back({gen(), gen()});
+    recv_opts.blocks.push_back(send_opts.blocks[i][recv_opts.choices[i]]);
+  }
+  return {std::move(send_opts), std::move(recv_opts)};
+}
+
+// runs `send(world[0])` and `recv(world[1])` concurrently for each iteration
+// and sets the counters of `num_ot` OTs per run.
+template <typename SendFn, typename RecvFn>
+void RunOt(benchmark::State& state, const World& world, size_t num_ot,
+           SendFn&& send, RecvFn&& recv) {
+  const auto bytes_before =
+      world[0]->GetStats()->sent_bytes + world[1]->GetStats()->sent_bytes;
+  const auto actions_before =
+      world[0]->GetStats()->sent_actions + world[1]->GetStats()->sent_actions;
+  for (auto _ : state) {
+    auto receiver = std::async(std::launch::async, [&] { recv(world[1]); });
+    send(world[0]);
+    receiver.get();
+  }
+  const auto bytes =
+      world[0]->GetStats()->sent_bytes + world[1]->GetStats()->sent_bytes -
+      bytes_before;
+  const auto actions = world[0]->GetStats()->sent_actions +
+                       world[1]->GetStats()->sent_actions - actions_before;
+
+  const double runs = static_cast<double>(state.iterations());
+  state.SetItemsProcessed(state.iterations() * num_ot);
+  state.counters["bytes_per_ot"] = bytes / runs / num_ot;
+  state.counters["rounds"] = actions / runs;
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  state.counters["peak_rss_mb"] = usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+  state.counters["peak_rss_mb"] = usage.ru_maxrss / 1024.0;
+#endif
+}
+
+void BM_BaseOt(benchmark::State& state) {
+  const auto& world = GetWorld(state.range(0));
+  const size_t num_ot = size_t(1) << state.range(1);
+  const auto choices = yasl::CreateRandomChoices(num_ot);
+  std::vector<std::array<yasl::Block, 2>> send_blocks(num_ot);
+  std::vector<yasl::Block> recv_blocks(num_ot);
+  RunOt(
+      state, world, num_ot,
+      [&](const std::shared_ptr<Context>& ctx) {
+        yasl::BaseOtSend(ctx, absl::MakeSpan(send_blocks));
+      },
+      [&](const std::shared_ptr<Context>& ctx) {
+        yasl::BaseOtRecv(ctx, choices, absl::MakeSpan(recv_blocks));
+      });
+}
+
+void BM_Iknp(benchmark::State& state) {
+  const auto& world = GetWorld(state.range(0));
+  const size_t num_ot = size_t(1) << state.range(1);
+  yasl::BaseSendOptions send_opts;
+  yasl::BaseRecvOptions recv_opts;
+  std::tie(send_opts, recv_opts) = MakeBaseOptions(128);
+  const auto choices = yasl::CreateRandomChoiceBits<uint128_t>(num_ot);
+  std::vector<std::array<uint128_t, 2>> send_blocks(num_ot);
+  std::vector<uint128_t> recv_blocks(num_ot);
+  RunOt(
+      state, world, num_ot,
+      [&](const std::shared_ptr<Context>& ctx) {
+        yasl::IknpOtExtSend(ctx, recv_opts, absl::MakeSpan(send_blocks));
+      },
+      [&](const std::shared_ptr<Context>& ctx) {
+        yasl::IknpOtExtRecv(ctx, send_opts, absl::MakeConstSpan(choices),
+                            absl::MakeSpan(recv_blocks));
+      });
+}
+
+void BM_Kkrt(benchmark::State& state) {
+  const auto& world = GetWorld(state.range(0));
+  const size_t num_ot = size_t(1) << state.range(1);
+  // KKRT requires 512 width.
+  yasl::BaseSendOptions send_opts;
+  yasl::BaseRecvOptions recv_opts;
+  std::tie(send_opts, recv_opts) = MakeBaseOptions(512);
+  std::vector<uint128_t> inputs(num_ot);
+  yasl::PseudoRandomGenerator<uint128_t> prg;
+  std::generate(inputs.begin(), inputs.end(), [&] { return prg(); });
+  std::vector<uint128_t> recv_blocks(num_ot);
+  RunOt(
+      state, world, num_ot,
+      [&](const std::shared_ptr<Context>& ctx) {
+        benchmark::DoNotOptimize(yasl::KkrtOtExtSend(ctx, recv_opts, num_ot));
+      },
+      [&](const std::shared_ptr<Context>& ctx) {
+        yasl::KkrtOtExtRecv(ctx, send_opts, absl::MakeConstSpan(inputs),
+                            absl::MakeSpan(recv_blocks));
+      });
+}
+
+// num_ot leaves in total, as punctured ROTs of 2^kPuncturedLogN leaves each.
+constexpr uint32_t kPuncturedLogN = 10;
+
+void BM_PuncturedRot(benchmark::State& state) {
+  const auto& world = GetWorld(state.range(0));
+  const size_t num_ot = size_t(1) << state.range(1);
+  const uint32_t n = 1U << kPuncturedLogN;
+  const size_t num = num_ot / n;
+  yasl::BaseSendOptions send_opts;
+  yasl::BaseRecvOptions recv_opts;
+  std::tie(send_opts, recv_opts) = MakeBaseOptions(num * kPuncturedLogN);
+  std::vector<uint32_t> indexes(num);
+  std::vector<yasl::PuncturedOTSeed> master_seeds(num);
+  yasl::PseudoRandomGenerator<uint32_t> prg;
+  for (size_t k = 0; k < num; ++k) {
+    indexes[k] = prg() % n;
+    master_seeds[k] = prg();
+  }
+  std::vector<yasl::PuncturedOTSeed> entire_seeds(num * n);
+  std::vector<yasl::PuncturedOTSeed> punctured_seeds(num * (n - 1));
+  RunOt(
+      state, world, num_ot,
+      [&](const std::shared_ptr<Context>& ctx) {
+        yasl::BatchPuncturedROTSend(ctx, send_opts, n,
+                                    absl::MakeConstSpan(master_seeds),
+                                    absl::MakeSpan(entire_seeds));
+      },
+      [&](const std::shared_ptr<Context>& ctx) {
+        yasl::BatchPuncturedROTRecv(ctx, recv_opts, n,
+                                    absl::MakeConstSpan(indexes),
+                                    absl::MakeSpan(punctured_seeds));
+      });
+}
+
+}  // namespace
+
+// base OTs are public key operations, they stop at 2^14.
+BENCHMARK(BM_BaseOt)
+    ->ArgsProduct({{kMem, kBrpc}, {10, 12, 14}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_Iknp)
+    ->ArgsProduct({{kMem, kBrpc}, {10, 14, 18, 22, 26}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+// KKRT keeps 512 bits rows of all OTs on both sides, 2^26 does not fit in
+// memory of common machines.
+BENCHMARK(BM_Kkrt)
+    ->ArgsProduct({{kMem, kBrpc}, {10, 14, 18, 22}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_PuncturedRot)
+    ->ArgsProduct({{kMem, kBrpc}, {10, 14, 18, 22, 26}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
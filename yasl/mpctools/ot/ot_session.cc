@@ -0,0 +1,110 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/ot_session.h"
+
+#include <utility>
+
+#include "yasl/base/exception.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/mpctools/ot/base_ot.h"
+#include "yasl/utils/metrics.h"
+
+namespace yasl {
+
+namespace {
+
+constexpr size_t kKappa = 128;
+
+}  // namespace
+
+std::unique_ptr<OtSession> OtSession::CreateSender(
+    const std::shared_ptr<link::Context>& ctx, OtSessionOptions options) {
+  return std::unique_ptr<OtSession>(
+      new OtSession(ctx, true, std::move(options)));
+}
+
+std::unique_ptr<OtSession> OtSession::CreateReceiver(
+    const std::shared_ptr<link::Context>& ctx, OtSessionOptions options) {
+  return std::unique_ptr<OtSession>(
+      new OtSession(ctx, false, std::move(options)));
+}
+
+OtSession::OtSession(const std::shared_ptr<link::Context>& ctx,
+                     bool is_sender, OtSessionOptions options)
+    : is_sender_(is_sender), options_(std::move(options)) {
+  YASL_ENFORCE(options_.first_batch_size <= options_.batch_size,
+               "first_batch_size={} over batch_size={}",
+               options_.first_batch_size, options_.batch_size);
+  // spawned here, so that both sides spawn it in the same order.
+  std::shared_ptr<link::Context> setup_ctx = ctx->Spawn();
+  setup_ = std::async(std::launch::async, [this, setup_ctx] {
+             Setup(setup_ctx);
+           }).share();
+}
+
+OtSession::~OtSession() { setup_.wait(); }
+
+void OtSession::Setup(const std::shared_ptr<link::Context>& ctx) {
+  static auto& time = GetHistogram("yasl_ot_session_setup_us");
+  ScopedTimer timer(&time);
+  CorrelatedOtPool::Options pool_options;
+  pool_options.depth = options_.depth;
+  pool_options.batch_size = options_.batch_size;
+  pool_options.first_batch_size = options_.first_batch_size;
+
+  // ot sender is the base ot receiver.
+  if (is_sender_) {
+    BaseRecvOptions base;
+    if (options_.base_ot_cache != nullptr) {
+      base = options_.base_ot_cache->Recv(ctx, kKappa);
+    } else {
+      base.choices = CreateRandomChoices(kKappa);
+      base.blocks = BaseOtRecv(ctx, base.choices);
+    }
+    pool_ = std::make_unique<CorrelatedOtPool>(ctx, std::move(base),
+                                               pool_options);
+  } else {
+    BaseSendOptions base;
+    if (options_.base_ot_cache != nullptr) {
+      base = options_.base_ot_cache->Send(ctx, kKappa);
+    } else {
+      base.blocks = BaseOtSend(ctx, kKappa);
+    }
+    pool_ = std::make_unique<CorrelatedOtPool>(ctx, std::move(base),
+                                               pool_options);
+  }
+}
+
+void OtSession::WaitReady() { setup_.get(); }
+
+std::vector<std::array<uint128_t, 2>> OtSession::Next(size_t n) {
+  YASL_ENFORCE(is_sender_, "receiver takes ots with choices");
+  WaitReady();
+  return pool_->TakeRot(n);
+}
+
+std::vector<uint128_t> OtSession::Next(size_t n,
+                                       std::vector<uint128_t>* choices) {
+  YASL_ENFORCE(!is_sender_, "sender takes ots without choices");
+  WaitReady();
+  return pool_->TakeRot(n, choices);
+}
+
+uint128_t OtSession::Delta() {
+  WaitReady();
+  return pool_->Delta();
+}
+
+}  // namespace yasl
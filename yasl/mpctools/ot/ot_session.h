@@ -0,0 +1,92 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "yasl/link/link.h"
+#include "yasl/mpctools/ot/base_ot_cache.h"
+#include "yasl/mpctools/ot/correlated_ot_pool.h"
+
+namespace yasl {
+
+// options of an OtSession, both sides must agree on them.
+struct OtSessionOptions {
+  // COTs kept in stock and extended per refill, see CorrelatedOtPool.
+  size_t depth = size_t(1) << 22;
+  size_t batch_size = size_t(1) << 20;
+  // the first refill, small so that the first Next returns early.
+  size_t first_batch_size = size_t(1) << 14;
+  // base ots are re-randomized from the cache if set, so that sessions
+  // after the first one run no public key operations.
+  BaseOtCache* base_ot_cache = nullptr;
+};
+
+// OtSession streams random OTs with the next rank of ctx, base ots included.
+//
+// Setup is not a step of its own: the constructor returns at once, base ots
+// run in the background and the IKNP extension starts as soon as they are
+// done. Extension then runs ahead of the takes by CorrelatedOtPool, whose
+// refills re-key the base ots instead of running new ones. So the first Next
+// waits for the base ots and one small batch only, later ones are served
+// from stock.
+//
+// NOTE
+//  * both sides must take the same number of ots in the same order.
+//  * the session runs on a context spawned from ctx by the constructor, so
+//    ctx is free for other msgs once it returns.
+class OtSession {
+ public:
+  // the ot sender, i.e. the base ot receiver.
+  static std::unique_ptr<OtSession> CreateSender(
+      const std::shared_ptr<link::Context>& ctx,
+      OtSessionOptions options = {});
+  static std::unique_ptr<OtSession> CreateReceiver(
+      const std::shared_ptr<link::Context>& ctx,
+      OtSessionOptions options = {});
+
+  // waits for the setup, see ~CorrelatedOtPool.
+  ~OtSession();
+
+  bool IsSender() const { return is_sender_; }
+
+  // blocks until base ots are done, raises their error.
+  void WaitReady();
+
+  // the next `n` random OTs, sender gets (H(m0), H(m1)).
+  std::vector<std::array<uint128_t, 2>> Next(size_t n);
+  // receiver gets H(m_c) of random choice bits, bit i in (*choices)[i / 128].
+  std::vector<uint128_t> Next(size_t n, std::vector<uint128_t>* choices);
+
+  // sender only.
+  uint128_t Delta();
+
+ private:
+  OtSession(const std::shared_ptr<link::Context>& ctx, bool is_sender,
+            OtSessionOptions options);
+
+  void Setup(const std::shared_ptr<link::Context>& ctx);
+
+  const bool is_sender_;
+  const OtSessionOptions options_;
+
+  std::unique_ptr<CorrelatedOtPool> pool_;
+  std::shared_future<void> setup_;
+};
+
+}  // namespace yasl
@@ -0,0 +1,130 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/ot_session.h"
+
+#include <future>
+
+#include "gtest/gtest.h"
+
+#include "yasl/link/test_util.h"
+
+namespace yasl {
+
+namespace {
+
+int GetBit(const std::vector<uint128_t>& choices, size_t idx) {
+  return (choices[idx / 128] >> (idx % 128)) & 1;
+}
+
+// takes `takes` ots from sessions of both sides and checks them.
+void RunSessions(
+    const std::vector<std::shared_ptr<link::Context>>& contexts,
+    const OtSessionOptions& options, const std::vector<size_t>& takes) {
+  std::vector<std::array<uint128_t, 2>> send_out;
+  std::vector<uint128_t> recv_out;
+  std::vector<int> choices;
+  auto f = std::async([&] {
+    auto session = OtSession::CreateSender(contexts[0], options);
+    EXPECT_TRUE(session->IsSender());
+    for (size_t n : takes) {
+      auto out = session->Next(n);
+      send_out.insert(send_out.end(), out.begin(), out.end());
+    }
+  });
+  auto session = OtSession::CreateReceiver(contexts[1], options);
+  for (size_t n : takes) {
+    std::vector<uint128_t> c;
+    auto out = session->Next(n, &c);
+    recv_out.insert(recv_out.end(), out.begin(), out.end());
+    for (size_t i = 0; i < n; ++i) {
+      choices.push_back(GetBit(c, i));
+    }
+  }
+  session.reset();
+  f.get();
+
+  EXPECT_EQ(send_out.size(), recv_out.size());
+  for (size_t i = 0; i < send_out.size(); ++i) {
+    EXPECT_EQ(send_out[i][choices[i]], recv_out[i]);
+    EXPECT_NE(send_out[i][1 - choices[i]], recv_out[i]);
+  }
+}
+
+OtSessionOptions SmallOptions() {
+  OtSessionOptions options;
+  options.depth = 3000;
+  options.batch_size = 1000;
+  options.first_batch_size = 128;
+  return options;
+}
+
+}  // namespace
+
+TEST(OtSessionTest, NextWorks) {
+  auto contexts = link::test::SetupWorld(2);
+  RunSessions(contexts, SmallOptions(), {1, 127, 1000, 4097});
+}
+
+TEST(OtSessionTest, ContextIsFreeAfterCreation) {
+  auto contexts = link::test::SetupWorld(2);
+  auto f = std::async([&] {
+    auto session = OtSession::CreateSender(contexts[0], SmallOptions());
+    contexts[0]->SendAsync(1, ByteContainerView("hello"), "tag");
+    EXPECT_EQ(session->Next(10).size(), 10);
+    EXPECT_NE(session->Delta(), 0);
+  });
+  auto session = OtSession::CreateReceiver(contexts[1], SmallOptions());
+  EXPECT_EQ(std::string_view(contexts[1]->Recv(0, "tag")), "hello");
+  std::vector<uint128_t> choices;
+  EXPECT_EQ(session->Next(10, &choices).size(), 10);
+  EXPECT_THROW(session->Next(10), EnforceNotMet);
+  session.reset();
+  f.get();
+}
+
+TEST(OtSessionTest, CachedBaseOtsWork) {
+  auto contexts = link::test::SetupWorld(2);
+  BaseOtCache sender_cache;
+  BaseOtCache receiver_cache;
+  auto sender_options = SmallOptions();
+  sender_options.base_ot_cache = &sender_cache;
+  auto receiver_options = SmallOptions();
+  receiver_options.base_ot_cache = &receiver_cache;
+
+  std::vector<std::array<uint128_t, 2>> first;
+  for (int session = 0; session < 2; ++session) {
+    std::vector<std::array<uint128_t, 2>> send_out;
+    auto f = std::async([&] {
+      auto s = OtSession::CreateSender(contexts[0], sender_options);
+      send_out = s->Next(500);
+    });
+    auto s = OtSession::CreateReceiver(contexts[1], receiver_options);
+    std::vector<uint128_t> choices;
+    const auto recv_out = s->Next(500, &choices);
+    s.reset();
+    f.get();
+    for (size_t i = 0; i < recv_out.size(); ++i) {
+      EXPECT_EQ(send_out[i][GetBit(choices, i)], recv_out[i]);
+    }
+    if (session == 0) {
+      first = send_out;
+    } else {
+      // base ots are re-randomized per session.
+      EXPECT_NE(first[0], send_out[0]);
+    }
+  }
+}
+
+}  // namespace yasl
@@ -18,13 +18,14 @@
 #include "simplest_ot_portable/ot_receiver.h"
 #include "simplest_ot_portable/ot_sender.h"
 
+#include "yasl/base/buffer.h"
 #include "yasl/base/exception.h"
 #include "yasl/crypto/random_oracle.h"
 
 namespace yasl {
 
 void PortableOtInterface::Recv(const std::shared_ptr<link::Context> &ctx,
-                               const std::vector<bool> &choices,
+                               const BitVector &choices,
                                absl::Span<Block> recv_blocks) {
   const int kNumOt = choices.size();
   SIMPLEOT_RECEIVER receiver;
@@ -38,19 +39,22 @@ void PortableOtInterface::Recv(const std::shared_ptr<link::Context> &ctx,
     YASL_THROW("simplest-ot receiver_procS failed");
   }
 
+  // all points are packed into one msg, so that base ots take a constant
+  // number of rounds.
+  Buffer rs_packs(static_cast<int64_t>(kNumOt) * PACKBYTES);
   for (int i = 0; i < kNumOt; i++) {
     const int batch_size = std::min(1, kNumOt - i);
 
     unsigned char messages[1][HASHBYTES];
-    unsigned char rs_pack[PACKBYTES];
     unsigned char batch_choices[1] = {0};
 
     for (int j = 0; j < batch_size; j++) {
       batch_choices[j] = choices[i + j] ? 1 : 0;
     }
 
-    portable_receiver_rsgen(&receiver, rs_pack, batch_choices);
-    ctx->Send(ctx->NextRank(), rs_pack, fmt::format("BASE_OT:{}", i));
+    portable_receiver_rsgen(&receiver,
+                            rs_packs.data<unsigned char>() + i * PACKBYTES,
+                            batch_choices);
 
     portable_receiver_keygen(&receiver, &messages[0]);
     for (int j = 0; j < batch_size; ++j) {
@@ -66,6 +70,7 @@ void PortableOtInterface::Recv(const std::shared_ptr<link::Context> &ctx,
           recv_blocks[i + j] ^ (i + j));  // output size = 128 bit
     }
   }
+  ctx->SendAsync(ctx->NextRank(), std::move(rs_packs), "BASE_OT:RS_PACK");
 }
 
 void PortableOtInterface::Send(const std::shared_ptr<link::Context> &ctx,
@@ -76,18 +81,17 @@ void PortableOtInterface::Send(const std::shared_ptr<link::Context> &ctx,
   // Send S_pack.
   unsigned char S_pack[PACKBYTES];
   portable_sender_genS(&sender, S_pack);
-  ctx->Send(ctx->NextRank(), S_pack, "BASE_OT:S_PACK");
+  ctx->SendAsync(ctx->NextRank(), S_pack, "BASE_OT:S_PACK");
 
+  auto buffer = ctx->Recv(ctx->NextRank(), "BASE_OT:RS_PACK");
+  YASL_ENFORCE_EQ(buffer.size(), static_cast<int64_t>(kNumOt) * PACKBYTES);
   for (int i = 0; i < kNumOt; i++) {
     const int batch_size = std::min(1, kNumOt - i);
 
-    unsigned char rs_pack[PACKBYTES];
     unsigned char messages[2][1][HASHBYTES];
 
-    auto buffer = ctx->Recv(ctx->NextRank(), fmt::format("BASE_OT:{}", i));
-    YASL_ENFORCE_EQ(buffer.size(), static_cast<int64_t>(sizeof(rs_pack)));
-    std::memcpy(rs_pack, buffer.data(), buffer.size());
-    if (!portable_sender_keygen_check(&sender, rs_pack, messages)) {
+    if (!portable_sender_keygen_check(
+            &sender, buffer.data<unsigned char>() + i * PACKBYTES, messages)) {
       YASL_THROW("simplest-ot: sender_keygen failed");
     }
 
@@ -27,7 +27,7 @@ class PortableOtInterface : public BaseOTInterface {
             absl::Span<std::array<Block, 2>> send_blocks) override;
 
   void Recv(const std::shared_ptr<link::Context>& ctx,
-            const std::vector<bool>& choices,
+            const BitVector& choices,
             absl::Span<Block> recv_blocks) override;
 };
 
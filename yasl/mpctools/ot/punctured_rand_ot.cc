@@ -17,9 +17,16 @@
 
 #include <math.h>
 
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+#include "yasl/base/bit_vector.h"
 #include "yasl/base/byte_container_view.h"
 #include "yasl/base/exception.h"
 #include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/utils/metrics.h"
+#include "yasl/utils/parallel.h"
 
 // #include <bitset>
 
@@ -34,43 +41,10 @@ std::pair<PuncturedOTSeed, PuncturedOTSeed> SplitSeed(PuncturedOTSeed seed) {
   return {prg(), prg()};
 }
 
-// 1st 4 bytes: the length of vector<bool>
-// other bytes: contents of vector<bool> (padding with 0s)
-inline Buffer BufferFromVectorBool(const std::vector<bool>& vector) {
-  YASL_ENFORCE_GT(sizeof(uint32_t) * 16, vector.size());
-  YASL_ENFORCE_GT(vector.size(), (uint32_t)1);
-
-  uint32_t size = vector.size();
-  Buffer buf(((size - 1) / 8) + 5);
-  memcpy(buf.data(), &size, sizeof(uint32_t));
-
-  auto* out = buf.data<char>() + 4;
-  int shift = 0;
-  for (bool bit : vector) {
-    *out |= bit << shift;
-    if (++shift == 8) {
-      ++out;
-      shift = 0;
-    }
-  }
-  return buf;
-}
-
-// convert a string to std::vector<bool>
-inline std::vector<bool> VectorBoolFromBuffer(const Buffer& str) {
-  uint32_t ret_size = 0;
-  memcpy(&ret_size, str.data<char>(), sizeof(uint32_t));
-  std::vector<bool> ret(ret_size, 0);
-  uint32_t str_counter = 0;
-  for (uint32_t i = 4; i < str.size(); i++) {
-    uint8_t temp = str.data<char>()[i];
-    for (uint32_t j = 0; j < 8 && str_counter < ret_size; j++) {
-      ret.at(str_counter) = temp & 1;
-      temp >>= 1;
-      str_counter++;
-    }
-  }
-  return ret;
+// number of tree levels, i.e. 1-2 ROTs per instance.
+uint32_t CheckTreeSize(uint32_t n) {
+  YASL_ENFORCE(n > 1 && (n & (n - 1)) == 0, "n={} is not a power of 2", n);
+  return log2(n);
 }
 
 }  // namespace
@@ -79,122 +53,147 @@ void PuncturedROTRecv(const std::shared_ptr<link::Context>& ctx,
                       const OTRecvOptions& ot_options, uint32_t n,
                       uint32_t index,
                       absl::Span<PuncturedOTSeed> punctured_seeds) {
-  uint32_t ot_num = log2(n);
-  YASL_ENFORCE_GT(n, (uint32_t)1);
-  YASL_ENFORCE_GE(ot_options.choices.size(), ot_num);
-  YASL_ENFORCE_GE(ot_options.blocks.size(), ot_num);
-
-  std::vector<bool> choices(ot_num);  // most significant bit first
-  for (uint32_t i = 0; i < ot_num; i++) {
-    choices.at(ot_num - i - 1) = (index >> i & 1);
-  }
+  BatchPuncturedROTRecv(ctx, ot_options, n, absl::MakeConstSpan(&index, 1),
+                        punctured_seeds);
+}
 
-  // we need log(n) 1-2 OTs from log(n) ROTs
-  {
-    std::vector<bool> masked_choices(ot_num);
+void PuncturedROTSend(const std::shared_ptr<link::Context>& ctx,
+                      const OTSendOptions& ot_options, uint32_t n,
+                      PuncturedOTSeed master_seed,
+                      absl::Span<PuncturedOTSeed> entire_seeds) {
+  BatchPuncturedROTSend(ctx, ot_options, n,
+                        absl::MakeConstSpan(&master_seed, 1), entire_seeds);
+}
+
+void BatchPuncturedROTRecv(const std::shared_ptr<link::Context>& ctx,
+                           const OTRecvOptions& ot_options, uint32_t n,
+                           absl::Span<const uint32_t> indexes,
+                           absl::Span<PuncturedOTSeed> punctured_seeds) {
+  const uint32_t ot_num = CheckTreeSize(n);
+  const size_t num = indexes.size();
+  YASL_ENFORCE_GE(ot_options.choices.size(), num * ot_num);
+  YASL_ENFORCE_GE(ot_options.blocks.size(), num * ot_num);
+  YASL_ENFORCE_GE(punctured_seeds.size(), num * (n - 1));
+  static auto& trees = GetCounter("yasl_punctured_rot_recv_trees_total");
+  static auto& time = GetHistogram("yasl_punctured_rot_recv_us");
+  ScopedTimer timer(&time);
+  trees.Add(num);
+
+  // choices of instance k are bits [k * ot_num, (k + 1) * ot_num), most
+  // significant bit of its index first.
+  BitVector choices(num * ot_num);
+  for (size_t k = 0; k < num; ++k) {
+    YASL_ENFORCE_LT(indexes[k], n);
     for (uint32_t i = 0; i < ot_num; i++) {
-      masked_choices.at(i) = (!choices.at(i)) ^ ot_options.choices.at(i);
+      choices.Set(k * ot_num + ot_num - i - 1, indexes[k] >> i & 1);
     }
+  }
+
+  // we need log(n) 1-2 OTs from log(n) ROTs per instance
+  {
+    // masked choices are !choices ^ choices of ROTs.
+    BitVector masked_choices(num * ot_num, true);
+    masked_choices ^= choices;
+    masked_choices ^= BitVector(ot_options.choices.words(), num * ot_num);
     // send masked_choices to sender
-    ctx->SendAsync(ctx->NextRank(), BufferFromVectorBool(masked_choices),
+    ctx->SendAsync(ctx->NextRank(), masked_choices.Serialize(),
                    fmt::format("PUNC_ROT:SEND:{}", 0));
   }
 
-  std::vector<PuncturedOTSeed> temp_seed_vec;
-  for (uint32_t i = 0, empty_pos = 0; i < ot_num; i++) {
-    bool ot_choice = !choices.at(i);
-    uint32_t insert_pos = (empty_pos << 1);
-    empty_pos = (empty_pos << 1) + choices.at(i);
-
-    // unmask and get the seed for this level
-    PuncturedOTSeed current_seed;
-    {
-      auto recv_string =
-          ctx->Recv(ctx->NextRank(), fmt::format("PUNC_ROT:RECV:{}", i + 1));
-      std::memcpy(
-          &current_seed,
-          recv_string.data<char>() + ot_choice * sizeof(PuncturedOTSeed),
-          sizeof(PuncturedOTSeed));
-      current_seed ^= ot_options.blocks.at(i);
-    }
-
-    // generate all already knows seeds for this level
-    uint32_t iter_num = pow(2, i) - 1;
-    for (uint32_t j = 0; j < iter_num; j++) {
-      PuncturedOTSeed left, right;
-      YASL_ENFORCE_EQ(temp_seed_vec.empty(), 0);
-      std::tie(left, right) = SplitSeed(temp_seed_vec.at(j));
-      temp_seed_vec.push_back(left);
-      temp_seed_vec.push_back(right);
-      current_seed ^= ot_choice * right + (1 - ot_choice) * left;
+  // level sums of all instances, in one message.
+  auto recv_buf =
+      ctx->Recv(ctx->NextRank(), fmt::format("PUNC_ROT:RECV:{}", 1));
+  YASL_ENFORCE_EQ(static_cast<size_t>(recv_buf.size()),
+                  num * ot_num * 2 * sizeof(PuncturedOTSeed));
+  std::vector<std::array<PuncturedOTSeed, 2>> ot_message_vec(num * ot_num);
+  std::memcpy(ot_message_vec.data(), recv_buf.data(), recv_buf.size());
+
+  parallel_for(0, num, 1, [&](int64_t begin, int64_t end) {
+    // nodes of the current level, the punctured one is left as zero.
+    std::vector<PuncturedOTSeed> nodes(n);
+    for (int64_t k = begin; k < end; ++k) {
+      uint32_t punctured_pos = 0;
+      for (uint32_t i = 0; i < ot_num; i++) {
+        const bool choice = choices[k * ot_num + i];
+        const bool ot_choice = !choice;
+
+        // unmask and get the sum of ot_choice children for this level
+        PuncturedOTSeed current_seed =
+            ot_message_vec[k * ot_num + i][ot_choice] ^
+            ot_options.blocks[k * ot_num + i];
+
+        // expand all already known seeds, backwards so that it is in place.
+        for (int64_t j = (int64_t{1} << i) - 1; j >= 0; --j) {
+          if (static_cast<uint32_t>(j) == punctured_pos) {
+            nodes[2 * j] = nodes[2 * j + 1] = 0;
+            continue;
+          }
+          std::tie(nodes[2 * j], nodes[2 * j + 1]) = SplitSeed(nodes[j]);
+          current_seed ^= nodes[2 * j + ot_choice];
+        }
+
+        // the unmasked seed is the sibling of the punctured node.
+        nodes[2 * punctured_pos + ot_choice] = current_seed;
+        punctured_pos = 2 * punctured_pos + choice;
+      }
+
+      auto* out = &punctured_seeds[k * (n - 1)];
+      std::copy(nodes.begin(), nodes.begin() + punctured_pos, out);
+      std::copy(nodes.begin() + punctured_pos + 1, nodes.end(),
+                out + punctured_pos);
     }
-
-    // delete seeds for previous level
-    if (!temp_seed_vec.empty())
-      temp_seed_vec.erase(temp_seed_vec.begin(),
-                          temp_seed_vec.begin() + iter_num);
-
-    // insert the unmasked seed to the correct position
-    if (insert_pos == temp_seed_vec.size())
-      temp_seed_vec.push_back(current_seed);
-    else
-      temp_seed_vec.insert(temp_seed_vec.begin() + insert_pos, current_seed);
-  }
-
-  memcpy(punctured_seeds.data(), temp_seed_vec.data(),
-         temp_seed_vec.size() * sizeof(PuncturedOTSeed));
+  });
 }
 
-void PuncturedROTSend(const std::shared_ptr<link::Context>& ctx,
-                      const OTSendOptions& ot_options, uint32_t n,
-                      PuncturedOTSeed master_seed,
-                      absl::Span<PuncturedOTSeed> entire_seeds) {
-  uint32_t ot_num = log2(n);
-  YASL_ENFORCE_GE(ot_options.blocks.size(), ot_num);
-  YASL_ENFORCE_GT(n, (uint32_t)1);
-
-  std::vector<PuncturedOTSeed> temp_seed_vec;
-  std::vector<std::array<PuncturedOTSeed, 2>> ot_message_vec(ot_num);
-  temp_seed_vec.push_back(master_seed);
-
-  // generate the final level seeds based on master_seed
-  for (uint32_t i = 0; i < ot_num; i++) {
-    //  for each seeds in level i
-    uint32_t iter_num = pow(2, i);
-    for (uint32_t j = 0; j < iter_num; j++) {
-      PuncturedOTSeed left, right;
-      std::tie(left, right) = SplitSeed(temp_seed_vec.at(j));
-      ot_message_vec.at(i).at(0) ^= left;
-      ot_message_vec.at(i).at(1) ^= right;
-      temp_seed_vec.push_back(left);
-      temp_seed_vec.push_back(right);
+void BatchPuncturedROTSend(const std::shared_ptr<link::Context>& ctx,
+                           const OTSendOptions& ot_options, uint32_t n,
+                           absl::Span<const PuncturedOTSeed> master_seeds,
+                           absl::Span<PuncturedOTSeed> entire_seeds) {
+  const uint32_t ot_num = CheckTreeSize(n);
+  const size_t num = master_seeds.size();
+  YASL_ENFORCE_GE(ot_options.blocks.size(), num * ot_num);
+  YASL_ENFORCE_GE(entire_seeds.size(), num * n);
+  static auto& trees = GetCounter("yasl_punctured_rot_send_trees_total");
+  static auto& time = GetHistogram("yasl_punctured_rot_send_us");
+  ScopedTimer timer(&time);
+  trees.Add(num);
+
+  // generate the final level seeds based on master_seeds, in place in
+  // entire_seeds, with the xor of left/right seeds of each level.
+  std::vector<std::array<PuncturedOTSeed, 2>> ot_message_vec(num * ot_num);
+  parallel_for(0, num, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k < end; ++k) {
+      auto* nodes = &entire_seeds[k * n];
+      nodes[0] = master_seeds[k];
+      for (uint32_t i = 0; i < ot_num; i++) {
+        auto& sums = ot_message_vec[k * ot_num + i];
+        // backwards so that children do not overwrite unexpanded seeds.
+        for (int64_t j = (int64_t{1} << i) - 1; j >= 0; --j) {
+          std::tie(nodes[2 * j], nodes[2 * j + 1]) = SplitSeed(nodes[j]);
+          sums[0] ^= nodes[2 * j];
+          sums[1] ^= nodes[2 * j + 1];
+        }
+      }
     }
-    temp_seed_vec.erase(temp_seed_vec.begin(),
-                        temp_seed_vec.begin() + iter_num);
-  }
+  });
 
   // receive the masked choices from receiver
   auto recv_string =
       ctx->Recv(ctx->NextRank(), fmt::format("PUNC_ROT:RECV:{}", 0));
-  std::vector<bool> masked_choices = VectorBoolFromBuffer(recv_string);
-
-  // mask the ROT messages and send back
-  for (uint32_t i = 0; i < ot_num; i++) {
-    std::array<PuncturedOTSeed, 2> send_message;
-    send_message.at(0) = ot_message_vec.at(i).at(0) ^
-                         ot_options.blocks.at(i).at(masked_choices.at(i));
-    send_message.at(1) = ot_message_vec.at(i).at(1) ^
-                         ot_options.blocks.at(i).at(1 - masked_choices.at(i));
-    ctx->SendAsync(
-        ctx->NextRank(),
-        ByteContainerView{reinterpret_cast<const char*>(send_message.data()),
-                          send_message.size() * sizeof(PuncturedOTSeed)},
-        fmt::format("PUNC_ROT:SEND:{}", i + 1));
+  auto masked_choices = BitVector::Deserialize(ByteContainerView(recv_string));
+  YASL_ENFORCE_EQ(masked_choices.size(), num * ot_num);
+
+  // mask the ROT messages of all instances and send back in one message.
+  for (size_t j = 0; j < num * ot_num; j++) {
+    const bool masked = masked_choices[j];
+    ot_message_vec[j][0] ^= ot_options.blocks[j][masked];
+    ot_message_vec[j][1] ^= ot_options.blocks[j][1 - masked];
   }
-
-  // output the result
-  memcpy(entire_seeds.data(), temp_seed_vec.data(),
-         temp_seed_vec.size() * sizeof(PuncturedOTSeed));
+  ctx->SendAsync(
+      ctx->NextRank(),
+      ByteContainerView{reinterpret_cast<const char*>(ot_message_vec.data()),
+                        ot_message_vec.size() * 2 * sizeof(PuncturedOTSeed)},
+      fmt::format("PUNC_ROT:SEND:{}", 1));
 }
 
-}  // namespace yasl
\ No newline at end of file
+}  // namespace yasl
@@ -73,4 +73,35 @@ void PuncturedROTSend(const std::shared_ptr<link::Context>& ctx,
                       PuncturedOTSeed master_seed,
                       absl::Span<PuncturedOTSeed> entire_seeds);
 
+/**
+ * @param ctx context
+ * @param ot_options pre-generated 1-2 Random OTs, instance k uses the OTs
+ *                   [k * log2(n), (k + 1) * log2(n))
+ * @param n XD this is (n-1)-out-of-n ROT
+ * @param indexes punctured index of each instance
+ * @param punctured_seeds n-1 random seeds of instance k are kept in
+ *                        [k * (n - 1), (k + 1) * (n - 1))
+ * @brief batch of indexes.size() (n-1)-out-of-n Random OT Receivers, all
+ * instances share one message per direction, trees are expanded in parallel.
+ */
+void BatchPuncturedROTRecv(const std::shared_ptr<link::Context>& ctx,
+                           const OTRecvOptions& ot_options, uint32_t n,
+                           absl::Span<const uint32_t> indexes,
+                           absl::Span<PuncturedOTSeed> punctured_seeds);
+
+/**
+ * @param ctx context
+ * @param ot_options pre-generated 1-2 Random OTs, instance k uses the OTs
+ *                   [k * log2(n), (k + 1) * log2(n))
+ * @param n XD this is (n-1)-out-of-n ROT
+ * @param master_seeds master seed of each instance
+ * @param entire_seeds n random seeds of instance k are kept in
+ *                     [k * n, (k + 1) * n)
+ * @brief batch of master_seeds.size() (n-1)-out-of-n Random OT Senders
+ */
+void BatchPuncturedROTSend(const std::shared_ptr<link::Context>& ctx,
+                           const OTSendOptions& ot_options, uint32_t n,
+                           absl::Span<const PuncturedOTSeed> master_seeds,
+                           absl::Span<PuncturedOTSeed> entire_seeds);
+
 }  // namespace yasl
\ No newline at end of file
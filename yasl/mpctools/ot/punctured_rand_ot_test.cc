@@ -136,4 +136,46 @@ TEST(RotFuncTest, Test) {
   }
 }
 
+TEST(BatchRotTest, Works) {
+  const uint32_t n = 1 << 6;
+  const uint32_t log_n = 6;
+  const size_t num = 100;
+  std::vector<uint32_t> indexes(num);
+  std::vector<PuncturedOTSeed> master_seeds(num);
+  for (size_t k = 0; k < num; ++k) {
+    indexes[k] = GetRandValue(n);
+    master_seeds[k] = k;
+  }
+
+  // mock many base OTs
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  std::tie(send_opts, recv_opts) = MakeOTOptions(num * log_n);
+
+  std::vector<PuncturedOTSeed> entire_seeds(num * n);
+  std::vector<PuncturedOTSeed> punctured_seeds(num * (n - 1));
+
+  auto contexts = link::test::SetupWorld(2);
+  std::future<void> receiver = std::async([&] {
+    BatchPuncturedROTRecv(contexts[0], recv_opts, n,
+                          absl::MakeConstSpan(indexes),
+                          absl::MakeSpan(punctured_seeds));
+  });
+  std::future<void> sender = std::async([&] {
+    BatchPuncturedROTSend(contexts[1], send_opts, n,
+                          absl::MakeConstSpan(master_seeds),
+                          absl::MakeSpan(entire_seeds));
+  });
+  receiver.get();
+  sender.get();
+
+  for (size_t k = 0; k < num; ++k) {
+    for (uint32_t i = 0; i < n - 1; i++) {
+      const uint32_t leaf = i < indexes[k] ? i : i + 1;
+      EXPECT_EQ(entire_seeds[k * n + leaf], punctured_seeds[k * (n - 1) + i])
+          << k << " " << i;
+    }
+  }
+}
+
 }  // namespace yasl::crypto
\ No newline at end of file
@@ -0,0 +1,373 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/silent_vole.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/exception.h"
+#include "yasl/crypto/crhash.h"
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/mpctools/ot/iknp_ot_extension.h"
+#include "yasl/mpctools/ot/punctured_rand_ot.h"
+#include "yasl/utils/parallel.h"
+#include "yasl/utils/rand.h"
+
+namespace yasl {
+namespace {
+
+// positions of the accumulated vector summed by an output.
+constexpr size_t kExpanderWeight = 7;
+// output i takes its positions from AES blocks [2 * i, 2 * i + 2) of the
+// code prg.
+constexpr size_t kIdxsPerRow = 8;
+static_assert(kExpanderWeight <= kIdxsPerRow);
+static_assert(kIdxsPerRow * sizeof(uint32_t) % sizeof(uint128_t) == 0);
+// the code is public, both sides expand it from the same seed.
+constexpr uint128_t kCodeSeed =
+    MakeUint128(0x5EC0DE0F5EC0DE0F, 0xEA0C0DE5EA0C0DE5);
+// outputs encoded per code prg fill.
+constexpr size_t kRowsPerFill = 1024;
+// entries of a block of the parallel suffix sums.
+constexpr size_t kAccumulateBlock = size_t(1) << 16;
+
+void CheckOptions(const SilentVoleOptions& options) {
+  YASL_ENFORCE(options.num_bins > 0);
+  // punctured ROTs need bins of at least 4 entries.
+  YASL_ENFORCE(options.log_bin_size >= 2 && options.log_bin_size < 32,
+               "invalid log_bin_size={}", options.log_bin_size);
+  YASL_ENFORCE((options.num_bins << options.log_bin_size) < (size_t(1) << 32),
+               "noisy vector of {} bins of 2^{} is too large",
+               options.num_bins, options.log_bin_size);
+}
+
+// base ots of a chunk, so that IKNP prgs never repeat across chunks.
+BaseRecvOptions ChunkBaseOptions(const BaseRecvOptions& base, uint64_t chunk) {
+  BaseRecvOptions derived;
+  derived.choices = base.choices;
+  derived.blocks.resize(base.blocks.size());
+  TccrHash(base.blocks, std::vector<uint128_t>(base.blocks.size(), chunk),
+           absl::MakeSpan(derived.blocks));
+  return derived;
+}
+
+BaseSendOptions ChunkBaseOptions(const BaseSendOptions& base, uint64_t chunk) {
+  BaseSendOptions derived;
+  derived.blocks.resize(base.blocks.size());
+  for (size_t i = 0; i < base.blocks.size(); ++i) {
+    derived.blocks[i] = {TccrHash(base.blocks[i][0], chunk),
+                         TccrHash(base.blocks[i][1], chunk)};
+  }
+  return derived;
+}
+
+// x[i] = x[i] + x[i + 1] + ... + x[N - 1], the accumulator of the code, by
+// blocks in parallel.
+template <typename T>
+void Accumulate(absl::Span<T> x) {
+  const size_t num_blocks =
+      (x.size() + kAccumulateBlock - 1) / kAccumulateBlock;
+  auto block_end = [&](size_t b) {
+    return std::min((b + 1) * kAccumulateBlock, x.size());
+  };
+  std::vector<T> sums(num_blocks);
+  parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; ++b) {
+      T acc = 0;
+      for (size_t i = block_end(b); i-- > b * kAccumulateBlock;) {
+        acc += x[i];
+        x[i] = acc;
+      }
+      sums[b] = acc;
+    }
+  });
+  // sums of the blocks after each block.
+  T carry = 0;
+  for (size_t b = num_blocks; b-- > 0;) {
+    const T sum = sums[b];
+    sums[b] = carry;
+    carry += sum;
+  }
+  parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; ++b) {
+      for (size_t i = b * kAccumulateBlock; i < block_end(b); ++i) {
+        x[i] += sums[b];
+      }
+    }
+  });
+}
+
+// y = B * A * x of the first y.size() outputs of the code, A the
+// accumulator and B the expander, x is accumulated in place.
+template <typename T>
+void Encode(absl::Span<T> x, absl::Span<T> y) {
+  Accumulate(x);
+  const size_t n = x.size();
+  const size_t num_fills = (y.size() + kRowsPerFill - 1) / kRowsPerFill;
+  parallel_for(0, num_fills, 1, [&](int64_t begin, int64_t end) {
+    std::vector<uint32_t> idxs(kRowsPerFill * kIdxsPerRow);
+    for (int64_t f = begin; f < end; ++f) {
+      const size_t first = f * kRowsPerFill;
+      const size_t rows = std::min(kRowsPerFill, y.size() - first);
+      PseudoRandomGenerator<uint32_t> prg(kCodeSeed);
+      prg.Skip(first * kIdxsPerRow * sizeof(uint32_t));
+      prg.Fill(absl::MakeSpan(idxs.data(), rows * kIdxsPerRow));
+      for (size_t i = 0; i < rows; ++i) {
+        const uint32_t* row = &idxs[i * kIdxsPerRow];
+        T sum = 0;
+        for (size_t w = 0; w < kExpanderWeight; ++w) {
+          sum += x[row[w] % n];
+        }
+        y[first + i] = sum;
+      }
+    }
+  });
+}
+
+// the sender half of the base VOLE of a noise value, Gilboa's product of its
+// bits by delta over the k random ots `rots`. writes the k corrections of
+// peer, m0 - m1 + delta, and returns v = sum(m0 << l).
+template <typename T>
+T SendBaseVole(const std::array<uint128_t, 2>* rots, T delta,
+               T* corrections) {
+  constexpr size_t kBits = sizeof(T) * 8;
+  T v = 0;
+  for (size_t l = 0; l < kBits; ++l) {
+    const auto m0 = static_cast<T>(rots[l][0]);
+    corrections[l] = m0 - static_cast<T>(rots[l][1]) + delta;
+    v += m0 << l;
+  }
+  return v;
+}
+
+// the receiver half, m_c + c * correction = m0 + c * delta for each bit c
+// of beta, returns w = v + beta * delta.
+template <typename T>
+T RecvBaseVole(const uint128_t* rots, T beta, const T* corrections) {
+  constexpr size_t kBits = sizeof(T) * 8;
+  T w = 0;
+  for (size_t l = 0; l < kBits; ++l) {
+    const T mask = T(0) - ((beta >> l) & 1);
+    w += (static_cast<T>(rots[l]) + (corrections[l] & mask)) << l;
+  }
+  return w;
+}
+
+}  // namespace
+
+template <typename T>
+SilentVoleSender<T>::SilentVoleSender(std::shared_ptr<link::Context> ctx,
+                                      BaseRecvOptions base_options,
+                                      const SilentVoleOptions& options)
+    : ctx_(std::move(ctx)),
+      base_options_(std::move(base_options)),
+      options_(options) {
+  static_assert(std::is_same_v<T, uint64_t> || std::is_same_v<T, uint128_t>,
+                "T must be uint64_t or uint128_t");
+  YASL_ENFORCE(ctx_->WorldSize() == 2);
+  CheckOptions(options_);
+  PseudoRandomGenerator<T> prg(RandSeed());
+  delta_ = prg();
+}
+
+template <typename T>
+void SilentVoleSender<T>::Generate(absl::Span<T> v) {
+  const size_t chunk_size = options_.ChunkSize();
+  for (size_t offset = 0; offset < v.size(); offset += chunk_size) {
+    GenerateChunk(v.subspan(offset, chunk_size));
+  }
+}
+
+template <typename T>
+void SilentVoleSender<T>::Stream(
+    size_t n, const std::function<void(size_t, absl::Span<const T>)>& f) {
+  std::vector<T> v(std::min(n, options_.ChunkSize()));
+  for (size_t offset = 0; offset < n; offset += v.size()) {
+    auto chunk = absl::MakeSpan(v).subspan(0, n - offset);
+    GenerateChunk(chunk);
+    f(offset, chunk);
+  }
+}
+
+template <typename T>
+void SilentVoleSender<T>::GenerateChunk(absl::Span<T> v) {
+  constexpr size_t kBits = sizeof(T) * 8;
+  const size_t t = options_.num_bins;
+  const size_t bin_size = size_t(1) << options_.log_bin_size;
+
+  // ots [0, t * k) are of the base voles, the rest of the punctured ROTs.
+  std::vector<std::array<uint128_t, 2>> rots(
+      t * (kBits + options_.log_bin_size));
+  IknpRotSend(ctx_, ChunkBaseOptions(base_options_, chunk_++),
+              absl::MakeSpan(rots));
+
+  // corrections of the base voles, then of the punctured points.
+  std::vector<T> corrections(t * kBits + t);
+  std::vector<T> base_v(t);
+  parallel_for(0, t, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; ++b) {
+      base_v[b] = SendBaseVole<T>(&rots[b * kBits], delta_,
+                                  &corrections[b * kBits]);
+    }
+  });
+
+  OTSendOptions tree_rots;
+  tree_rots.blocks.assign(rots.begin() + t * kBits, rots.end());
+  std::vector<uint128_t> master_seeds(t);
+  PseudoRandomGenerator<uint128_t> prg(RandSeed());
+  std::generate(master_seeds.begin(), master_seeds.end(),
+                [&] { return prg(); });
+  std::vector<uint128_t> leaves(t * bin_size);
+  BatchPuncturedROTSend(ctx_, tree_rots, bin_size, master_seeds,
+                        absl::MakeSpan(leaves));
+
+  // x are the leaves, c_b = sum of x of bin b - v_b, so that receiver gets
+  // x + beta * delta at its punctured point.
+  std::vector<T> x(t * bin_size);
+  parallel_for(0, t, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; ++b) {
+      T sum = 0;
+      for (size_t j = b * bin_size; j < (b + 1) * bin_size; ++j) {
+        x[j] = static_cast<T>(leaves[j]);
+        sum += x[j];
+      }
+      corrections[t * kBits + b] = sum - base_v[b];
+    }
+  });
+  ctx_->SendAsync(
+      ctx_->NextRank(),
+      ByteContainerView(corrections.data(), corrections.size() * sizeof(T)),
+      "VOLE:CORRECTIONS");
+
+  Encode(absl::MakeSpan(x), v);
+}
+
+template <typename T>
+SilentVoleReceiver<T>::SilentVoleReceiver(std::shared_ptr<link::Context> ctx,
+                                          BaseSendOptions base_options,
+                                          const SilentVoleOptions& options)
+    : ctx_(std::move(ctx)),
+      base_options_(std::move(base_options)),
+      options_(options) {
+  static_assert(std::is_same_v<T, uint64_t> || std::is_same_v<T, uint128_t>,
+                "T must be uint64_t or uint128_t");
+  YASL_ENFORCE(ctx_->WorldSize() == 2);
+  CheckOptions(options_);
+}
+
+template <typename T>
+void SilentVoleReceiver<T>::Generate(absl::Span<T> u, absl::Span<T> w) {
+  YASL_ENFORCE(u.size() == w.size());
+  const size_t chunk_size = options_.ChunkSize();
+  for (size_t offset = 0; offset < u.size(); offset += chunk_size) {
+    GenerateChunk(u.subspan(offset, chunk_size),
+                  w.subspan(offset, chunk_size));
+  }
+}
+
+template <typename T>
+void SilentVoleReceiver<T>::Stream(
+    size_t n, const std::function<void(size_t, absl::Span<const T>,
+                                       absl::Span<const T>)>& f) {
+  std::vector<T> u(std::min(n, options_.ChunkSize()));
+  std::vector<T> w(u.size());
+  for (size_t offset = 0; offset < n; offset += u.size()) {
+    auto u_chunk = absl::MakeSpan(u).subspan(0, n - offset);
+    auto w_chunk = absl::MakeSpan(w).subspan(0, n - offset);
+    GenerateChunk(u_chunk, w_chunk);
+    f(offset, u_chunk, w_chunk);
+  }
+}
+
+template <typename T>
+void SilentVoleReceiver<T>::GenerateChunk(absl::Span<T> u, absl::Span<T> w) {
+  constexpr size_t kBits = sizeof(T) * 8;
+  const size_t t = options_.num_bins;
+  const size_t bin_size = size_t(1) << options_.log_bin_size;
+  const size_t num_tree_ots = t * options_.log_bin_size;
+
+  // choices of the base voles are the bits of the noise values, which are
+  // units by their lowest bit, so that the noise of the lowest bits of the
+  // correlations keeps its weight.
+  auto choices = CreateRandomChoiceBits<uint128_t>(t * kBits + num_tree_ots);
+  for (size_t b = 0; b < t; ++b) {
+    choices[b * kBits / 128] |= uint128_t(1) << (b * kBits % 128);
+  }
+  std::vector<uint128_t> rots(t * kBits + num_tree_ots);
+  IknpRotRecv(ctx_, ChunkBaseOptions(base_options_, chunk_++), choices,
+              absl::MakeSpan(rots));
+  std::vector<T> betas(t);
+  std::memcpy(betas.data(), choices.data(), t * sizeof(T));
+
+  OTRecvOptions tree_rots;
+  tree_rots.choices = BitVector(num_tree_ots);
+  for (size_t i = 0; i < num_tree_ots; ++i) {
+    const size_t j = t * kBits + i;
+    tree_rots.choices.Set(i, (choices[j / 128] >> (j % 128)) & 1);
+  }
+  tree_rots.blocks.assign(rots.begin() + t * kBits, rots.end());
+  std::vector<uint32_t> alphas(t);
+  PseudoRandomGenerator<uint32_t> prg(RandSeed());
+  for (auto& alpha : alphas) {
+    alpha = prg() & (bin_size - 1);
+  }
+  std::vector<uint128_t> punctured(t * (bin_size - 1));
+  BatchPuncturedROTRecv(ctx_, tree_rots, bin_size, alphas,
+                        absl::MakeSpan(punctured));
+
+  auto buf = ctx_->Recv(ctx_->NextRank(), "VOLE:CORRECTIONS");
+  std::vector<T> corrections(t * kBits + t);
+  YASL_ENFORCE(static_cast<size_t>(buf.size()) ==
+                   corrections.size() * sizeof(T),
+               "unexpected corrections size={}", buf.size());
+  std::memcpy(corrections.data(), buf.data(), buf.size());
+
+  // x + e * delta, and the noise e.
+  std::vector<T> x(t * bin_size);
+  std::vector<T> e(t * bin_size);
+  parallel_for(0, t, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; ++b) {
+      const uint128_t* known = &punctured[b * (bin_size - 1)];
+      T* bin = &x[b * bin_size];
+      const size_t alpha = alphas[b];
+      T sum = 0;
+      for (size_t j = 0; j + 1 < bin_size; ++j) {
+        const size_t pos = j < alpha ? j : j + 1;
+        bin[pos] = static_cast<T>(known[j]);
+        sum += bin[pos];
+      }
+      bin[alpha] = corrections[t * kBits + b] - sum +
+                   RecvBaseVole<T>(&rots[b * kBits], betas[b],
+                                   &corrections[b * kBits]);
+      e[b * bin_size + alpha] = betas[b];
+    }
+  });
+
+  Encode(absl::MakeSpan(x), w);
+  Encode(absl::MakeSpan(e), u);
+}
+
+template class SilentVoleSender<uint64_t>;
+template class SilentVoleSender<uint128_t>;
+template class SilentVoleReceiver<uint64_t>;
+template class SilentVoleReceiver<uint128_t>;
+
+}  // namespace yasl
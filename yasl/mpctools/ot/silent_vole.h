@@ -0,0 +1,121 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/int128.h"
+#include "yasl/link/link.h"
+#include "yasl/mpctools/ot/options.h"
+
+namespace yasl {
+
+// SilentVoleSender SilentVoleReceiver
+//
+// Silent random vector OLE over Z_2^k from dual LPN, k the bits of T. Sender
+// holds a global delta and gets v, receiver gets u and w = v + u * delta for
+// each correlation, all mod 2^k.
+//
+// Correlations are generated by chunks. For a chunk, both sides build a
+// noisy vector of N = t * 2^log_bin_size entries, x of sender and
+// x + e * delta of receiver, where the noise e is regular, one random unit
+// per bin:
+//  * the noise value of bin b is shared by a base VOLE, Gilboa's product of
+//    its bits by delta over k random OTs.
+//  * its position is the punctured point of a GGM tree, the other leaves
+//    are known to both sides, see BatchPuncturedROTSend.
+// Both vectors are then compressed into N / 2 correlations by the public
+// Expand-Accumulate code of https://eprint.iacr.org/2022/1014.pdf, i.e. the
+// suffix sums of the vector, of which each output takes the sum of 7 at
+// random positions. Encoding is linear time and runs across parallel_for.
+//
+// A chunk takes t * (k + log_bin_size) IKNP random OTs, the base ots
+// re-keyed by the chunk, plus t * (k + 1) ring elements of corrections, a
+// few bits per correlation instead of the k IKNP OTs of a Gilboa product.
+//
+// NOTE
+//  * semi-honest only.
+//  * both sides must generate the same numbers of correlations in the same
+//    order, correlations of a chunk left over by a generation are dropped.
+//  * base ots of IKNP must not be used by another extension.
+
+struct SilentVoleOptions {
+  // t, the weight of the regular noise, one noise per bin.
+  size_t num_bins = 256;
+  // each bin holds 2^log_bin_size noisy entries.
+  size_t log_bin_size = 13;
+
+  // N / 2, 1 << 20 correlations by the defaults.
+  size_t ChunkSize() const { return (num_bins << log_bin_size) / 2; }
+};
+
+template <typename T>
+class SilentVoleSender {
+ public:
+  // base ots of this side as the sender of IKNP.
+  SilentVoleSender(std::shared_ptr<link::Context> ctx,
+                   BaseRecvOptions base_options,
+                   const SilentVoleOptions& options = {});
+
+  T Delta() const { return delta_; }
+
+  // v of `v.size()` correlations.
+  void Generate(absl::Span<T> v);
+
+  // calls `f(offset, v)` of each chunk of the next `n` correlations, in
+  // order, so that no more than a chunk is kept in memory.
+  void Stream(size_t n,
+              const std::function<void(size_t, absl::Span<const T>)>& f);
+
+ private:
+  // v of the next chunk into `v`, at most ChunkSize() of them.
+  void GenerateChunk(absl::Span<T> v);
+
+  const std::shared_ptr<link::Context> ctx_;
+  const BaseRecvOptions base_options_;
+  const SilentVoleOptions options_;
+  T delta_;
+  uint64_t chunk_ = 0;
+};
+
+template <typename T>
+class SilentVoleReceiver {
+ public:
+  // base ots of this side as the receiver of IKNP.
+  SilentVoleReceiver(std::shared_ptr<link::Context> ctx,
+                     BaseSendOptions base_options,
+                     const SilentVoleOptions& options = {});
+
+  // u and w of `u.size()` correlations.
+  void Generate(absl::Span<T> u, absl::Span<T> w);
+
+  // calls `f(offset, u, w)` of each chunk of the next `n` correlations.
+  void Stream(size_t n, const std::function<void(size_t, absl::Span<const T>,
+                                                 absl::Span<const T>)>& f);
+
+ private:
+  void GenerateChunk(absl::Span<T> u, absl::Span<T> w);
+
+  const std::shared_ptr<link::Context> ctx_;
+  const BaseSendOptions base_options_;
+  const SilentVoleOptions options_;
+  uint64_t chunk_ = 0;
+};
+
+}  // namespace yasl
@@ -0,0 +1,130 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/silent_vole.h"
+
+#include <future>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/link/test_util.h"
+
+namespace yasl {
+
+namespace {
+
+std::pair<BaseSendOptions, BaseRecvOptions> MakeBaseOptions(size_t num) {
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  recv_opts.choices = CreateRandomChoices(num);
+  std::random_device rd;
+  PseudoRandomGenerator<uint128_t> gen(rd());
+  for (size_t i = 0; i < num; ++i) {
+    send_opts.blocks.push_back({gen(), gen()});
+    recv_opts.blocks.push_back(send_opts.blocks[i][recv_opts.choices[i]]);
+  }
+  return {std::move(send_opts), std::move(recv_opts)};
+}
+
+}  // namespace
+
+template <typename T>
+class SilentVoleTest : public ::testing::Test {};
+
+using RingTypes = ::testing::Types<uint64_t, uint128_t>;
+TYPED_TEST_SUITE(SilentVoleTest, RingTypes);
+
+TYPED_TEST(SilentVoleTest, Works) {
+  using T = TypeParam;
+  // one block of the accumulator, and several ones.
+  for (size_t log_bin_size : {9, 14}) {
+    // GIVEN
+    auto contexts = link::test::SetupWorld(2);
+    auto [send_opts, recv_opts] = MakeBaseOptions(128);
+    SilentVoleOptions options;
+    options.num_bins = 10;
+    options.log_bin_size = log_bin_size;
+    // two chunks and a partial one.
+    const size_t n = options.ChunkSize() * 2 + 100;
+    std::vector<T> v(n);
+    std::vector<T> u(n);
+    std::vector<T> w(n);
+
+    // WHEN
+    auto sender = std::async([&] {
+      SilentVoleSender<T> vole(contexts[0], recv_opts, options);
+      vole.Generate(absl::MakeSpan(v));
+      return vole.Delta();
+    });
+    SilentVoleReceiver<T> vole(contexts[1], send_opts, options);
+    vole.Generate(absl::MakeSpan(u), absl::MakeSpan(w));
+    const T delta = sender.get();
+
+    // THEN
+    std::set<T> distinct;
+    for (size_t i = 0; i < n; ++i) {
+      ASSERT_TRUE(w[i] == v[i] + u[i] * delta) << i;
+      distinct.insert(u[i]);
+    }
+    // u takes at most C(t + 7, 7) values for t noises, which is large
+    // enough for real ones only.
+    EXPECT_GT(distinct.size(), 1000);
+  }
+}
+
+TYPED_TEST(SilentVoleTest, Streams) {
+  using T = TypeParam;
+  // GIVEN
+  auto contexts = link::test::SetupWorld(2);
+  auto [send_opts, recv_opts] = MakeBaseOptions(128);
+  SilentVoleOptions options;
+  options.num_bins = 8;
+  options.log_bin_size = 8;
+  const size_t n = 2500;
+  std::vector<T> v(n);
+  std::vector<T> u(n);
+  std::vector<T> w(n);
+  std::vector<size_t> offsets;
+
+  // WHEN
+  auto sender = std::async([&] {
+    SilentVoleSender<T> vole(contexts[0], recv_opts, options);
+    vole.Stream(n, [&](size_t offset, absl::Span<const T> chunk) {
+      std::copy(chunk.begin(), chunk.end(), v.begin() + offset);
+    });
+    return vole.Delta();
+  });
+  SilentVoleReceiver<T> vole(contexts[1], send_opts, options);
+  vole.Stream(n, [&](size_t offset, absl::Span<const T> u_chunk,
+                     absl::Span<const T> w_chunk) {
+    offsets.push_back(offset);
+    EXPECT_LE(u_chunk.size(), options.ChunkSize());
+    std::copy(u_chunk.begin(), u_chunk.end(), u.begin() + offset);
+    std::copy(w_chunk.begin(), w_chunk.end(), w.begin() + offset);
+  });
+  const T delta = sender.get();
+
+  // THEN
+  EXPECT_EQ(offsets, std::vector<size_t>({0, 1024, 2048}));
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_TRUE(w[i] == v[i] + u[i] * delta) << i;
+  }
+}
+
+}  // namespace yasl
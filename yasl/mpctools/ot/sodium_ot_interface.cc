@@ -0,0 +1,125 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/ot/sodium_ot_interface.h"
+
+#include <cstring>
+
+#include "sodium.h"
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/exception.h"
+#include "yasl/utils/parallel.h"
+
+namespace yasl {
+namespace {
+
+constexpr size_t kPointBytes = crypto_core_ristretto255_BYTES;
+constexpr size_t kScalarBytes = crypto_core_ristretto255_SCALARBYTES;
+// public key ops are heavy, a few of them are enough per task.
+constexpr int64_t kGrainSize = 16;
+
+void InitSodium() { YASL_ENFORCE(sodium_init() >= 0, "sodium_init failed"); }
+
+// key of the ith ot, the transcript (A, B) is hashed together with the shared
+// point, as in the paper.
+Block HashKey(uint64_t i, const unsigned char* a, const unsigned char* b,
+              const unsigned char* point) {
+  crypto_generichash_state state;
+  crypto_generichash_init(&state, nullptr, 0, sizeof(Block));
+  crypto_generichash_update(&state, reinterpret_cast<unsigned char*>(&i),
+                            sizeof(i));
+  crypto_generichash_update(&state, a, kPointBytes);
+  crypto_generichash_update(&state, b, kPointBytes);
+  crypto_generichash_update(&state, point, kPointBytes);
+  Block key;
+  crypto_generichash_final(&state, reinterpret_cast<unsigned char*>(&key),
+                           sizeof(key));
+  return key;
+}
+
+}  // namespace
+
+void SodiumOtInterface::Recv(const std::shared_ptr<link::Context>& ctx,
+                             const BitVector& choices,
+                             absl::Span<Block> recv_blocks) {
+  InitSodium();
+  const int64_t num_ot = choices.size();
+
+  // Wait for sender A = a * G.
+  auto buffer = ctx->Recv(ctx->NextRank(), "BASE_OT:S_PACK");
+  YASL_ENFORCE_EQ(buffer.size(), static_cast<int64_t>(kPointBytes));
+  unsigned char a_point[kPointBytes];
+  std::memcpy(a_point, buffer.data(), kPointBytes);
+  YASL_ENFORCE(crypto_core_ristretto255_is_valid_point(a_point) == 1,
+               "invalid sender point");
+
+  // B = b * G for choice 0, A + b * G for choice 1, the key is b * A.
+  Buffer b_points(num_ot * static_cast<int64_t>(kPointBytes));
+  parallel_for(0, num_ot, kGrainSize, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      auto* b_point = b_points.data<unsigned char>() + i * kPointBytes;
+      unsigned char b[kScalarBytes];
+      unsigned char point[kPointBytes];
+      crypto_core_ristretto255_scalar_random(b);
+      YASL_ENFORCE(crypto_scalarmult_ristretto255_base(b_point, b) == 0);
+      YASL_ENFORCE(crypto_core_ristretto255_add(point, a_point, b_point) == 0);
+      // select A + b * G by a mask, without branching on the choice.
+      const auto mask = static_cast<unsigned char>(-int{choices[i]});
+      for (size_t j = 0; j < kPointBytes; ++j) {
+        b_point[j] ^= mask & (b_point[j] ^ point[j]);
+      }
+      YASL_ENFORCE(crypto_scalarmult_ristretto255(point, b, a_point) == 0);
+      recv_blocks[i] = HashKey(i, a_point, b_point, point);
+      sodium_memzero(b, sizeof(b));
+    }
+  });
+  ctx->SendAsync(ctx->NextRank(), std::move(b_points), "BASE_OT:RS_PACK");
+}
+
+void SodiumOtInterface::Send(const std::shared_ptr<link::Context>& ctx,
+                             absl::Span<std::array<Block, 2>> send_blocks) {
+  InitSodium();
+  const int64_t num_ot = send_blocks.size();
+
+  // Send A = a * G.
+  unsigned char a[kScalarBytes];
+  unsigned char a_point[kPointBytes];
+  crypto_core_ristretto255_scalar_random(a);
+  YASL_ENFORCE(crypto_scalarmult_ristretto255_base(a_point, a) == 0);
+  ctx->SendAsync(ctx->NextRank(), ByteContainerView(a_point, kPointBytes),
+                 "BASE_OT:S_PACK");
+  // a * A, so that the key of choice 1 is a * B - a * A.
+  unsigned char aa_point[kPointBytes];
+  YASL_ENFORCE(crypto_scalarmult_ristretto255(aa_point, a, a_point) == 0);
+
+  auto buffer = ctx->Recv(ctx->NextRank(), "BASE_OT:RS_PACK");
+  YASL_ENFORCE_EQ(buffer.size(), num_ot * static_cast<int64_t>(kPointBytes));
+  parallel_for(0, num_ot, kGrainSize, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const auto* b_point = buffer.data<unsigned char>() + i * kPointBytes;
+      unsigned char k0[kPointBytes];
+      unsigned char k1[kPointBytes];
+      // fails on invalid encodings of B too.
+      YASL_ENFORCE(crypto_scalarmult_ristretto255(k0, a, b_point) == 0,
+                   "invalid receiver point of ot {}", i);
+      YASL_ENFORCE(crypto_core_ristretto255_sub(k1, k0, aa_point) == 0);
+      send_blocks[i][0] = HashKey(i, a_point, b_point, k0);
+      send_blocks[i][1] = HashKey(i, a_point, b_point, k1);
+    }
+  });
+  sodium_memzero(a, sizeof(a));
+}
+
+}  // namespace yasl
@@ -0,0 +1,36 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "yasl/mpctools/ot/base_ot_interface.h"
+
+namespace yasl {
+
+// Simplest OT (https://eprint.iacr.org/2015/267) over the ristretto255 group
+// of libsodium, portable and constant time, the points of all ots are packed
+// into one msg per direction.
+class SodiumOtInterface : public BaseOTInterface {
+ public:
+  ~SodiumOtInterface() override = default;
+
+  void Send(const std::shared_ptr<link::Context>& ctx,
+            absl::Span<std::array<Block, 2>> send_blocks) override;
+
+  void Recv(const std::shared_ptr<link::Context>& ctx,
+            const BitVector& choices,
+            absl::Span<Block> recv_blocks) override;
+};
+
+}  // namespace yasl
@@ -18,6 +18,7 @@
 #include <array>
 #include <iostream>
 #include <random>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -153,4 +154,122 @@ TEST(MatrixTranspose, MatrixTransposeBlock128x1024) {
             0);
 }
 
+TEST(MatrixTranspose, MatrixTransposeTest) {
+  auto matrix = MakeMatrix128();
+
+  std::array<uint128_t, 128> matrixTranspose = matrix;
+  MatrixTranspose128(&matrixTranspose);
+
+  std::array<uint128_t, 128> matrixT2 = matrix;
+  NaiveTranspose(&matrixT2);
+
+  EXPECT_EQ(matrixTranspose, matrixT2);
+}
+
+TEST(MatrixTranspose, MatrixTransposeUint128x1024) {
+  auto matrix = MakeMatrix128x1024();
+
+  auto matrixTranspose = matrix;
+  MatrixTranspose128x1024(&matrixTranspose);
+
+  auto matrixT2 = matrix;
+  EklundhTranspose128x1024(&matrixT2);
+
+  EXPECT_EQ(matrixTranspose, matrixT2);
+}
+
+TEST(MatrixTranspose, MatrixTransposeKxM) {
+  constexpr size_t kK = 3;
+  constexpr size_t kM = 6;
+  std::random_device rd;
+  std::mt19937 rng(rd());
+  std::array<uint128_t, 128 * kK * kM> matrix;
+  for (auto& x : matrix) {
+    x = MakeUint128(rng(), rng());
+  }
+
+  std::array<uint128_t, 128 * kK * kM> transposed;
+  MatrixTranspose<kK, kM>(matrix, &transposed);
+  for (size_t r = 0; r < 128 * kK; ++r) {
+    for (size_t c = 0; c < 128 * kM; ++c) {
+      ASSERT_EQ(GetBit(matrix[r * kM + c / 128], c % 128),
+                GetBit(transposed[c * kK + r / 128], r % 128))
+          << r << " " << c;
+    }
+  }
+
+  std::array<uint128_t, 128 * kK * kM> back;
+  MatrixTranspose<kM, kK>(transposed, &back);
+  EXPECT_EQ(matrix, back);
+}
+
+TEST(MatrixTranspose, MatrixTransposeLongRows) {
+  // output rows longer than 16 words are buffered.
+  const size_t k = 18;
+  const size_t m = 5;
+  std::random_device rd;
+  std::mt19937 rng(rd());
+  std::vector<uint128_t> matrix(128 * k * m);
+  for (auto& x : matrix) {
+    x = MakeUint128(rng(), rng());
+  }
+
+  std::vector<uint128_t> transposed(matrix.size());
+  MatrixTranspose(matrix, absl::MakeSpan(transposed), k, m);
+  for (size_t r = 0; r < 128 * k; ++r) {
+    for (size_t c = 0; c < 128 * m; ++c) {
+      ASSERT_EQ(GetBit(matrix[r * m + c / 128], c % 128),
+                GetBit(transposed[c * k + r / 128], r % 128))
+          << r << " " << c;
+    }
+  }
+}
+
+TEST(MatrixTranspose, NaiveTransposeN) {
+  std::random_device rd;
+  std::mt19937 rng(rd());
+  std::array<uint128_t, 128 * 2> matrix;
+  for (auto& x : matrix) {
+    x = MakeUint128(rng(), rng());
+  }
+
+  std::array<uint128_t, 128 * 2> transposed;
+  MatrixTranspose<2, 1>(matrix, &transposed);
+  NaiveTranspose<2>(&matrix);
+  EXPECT_EQ(matrix, transposed);
+}
+
 }  // end namespace yasl
+
+TEST(BlockOps, XorAndBlocks) {
+  std::random_device rd;
+  std::mt19937 rng(rd());
+  // not a multiple of the 512 bits lanes.
+  const size_t n = 1027;
+  std::vector<uint128_t> a(n);
+  std::vector<uint128_t> b(n);
+  for (size_t i = 0; i < n; ++i) {
+    a[i] = yasl::MakeUint128(rng(), rng());
+    b[i] = yasl::MakeUint128(rng(), rng());
+  }
+
+  auto x = a;
+  yasl::XorBlocks(absl::MakeSpan(x), absl::MakeConstSpan(b));
+  auto y = a;
+  yasl::AndBlocks(absl::MakeSpan(y), absl::MakeConstSpan(b));
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(x[i], a[i] ^ b[i]);
+    EXPECT_EQ(y[i], a[i] & b[i]);
+  }
+
+  yasl::block512 w(
+      {yasl::block(a[0]), yasl::block(a[1]), yasl::block(a[2]),
+       yasl::block(a[3])});
+  yasl::block512 v(
+      {yasl::block(b[0]), yasl::block(b[1]), yasl::block(b[2]),
+       yasl::block(b[3])});
+  auto wv = w ^ v;
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(wv.as<uint128_t>()[i], a[i] ^ b[i]);
+  }
+}
@@ -15,27 +15,31 @@
 
 #include "utils.h"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <string>
 #include <type_traits>
 
 #include "block.h"
 
+#include "yasl/base/cpu_dispatch.h"
+#include "yasl/base/exception.h"
+#include "yasl/utils/bitwise.h"
+
 #ifdef __x86_64
-#include "cpu_features/cpuinfo_x86.h"
+#include <immintrin.h>
+#endif
+
+#ifdef __aarch64__
+#include <arm_neon.h>
 #endif
 
 namespace yasl {
 
 namespace {
 
-#ifdef __x86_64
-static const auto kCPUSupportsSSE2 = cpu_features::GetX86Info().features.sse2;
-#else
-static const auto kCPUSupportsSSE2 = true;
-#endif
-
 /**
  * Paper:
  * A Fast Computer Method for Matrix Transposing
@@ -337,20 +341,301 @@ void SseTranspose128x1024(std::array<std::array<uint128_t, 8>, 128>* inout) {
   }
 }
 
-void MatrixTranspose128(std::array<uint128_t, 128>* inout) {
-  if (kCPUSupportsSSE2) {
-    return SseTranspose128(inout);
+#ifdef __x86_64
+
+namespace {
+
+// transpose the 128x128 bit matrix of rows `in[j * in_stride]` into rows
+// `out[i * out_stride]`, which should not overlap.
+//
+// rows are taken 32 at a time, the lower 16 in the lower lane and the upper
+// 16 in the upper lane. 4 rounds of unpacks transpose the 16x16 bytes of each
+// lane, which gives a byte column of the 32 rows per register. loading rows
+// in bit reversed order makes the columns come out in order.
+__attribute__((target("avx2"))) void Avx2TransposeSquare(const uint128_t* in,
+                                                         size_t in_stride,
+                                                         uint128_t* out,
+                                                         size_t out_stride) {
+  constexpr std::array<size_t, 16> kBitReversed = {
+      0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15};
+
+  for (size_t g = 0; g < 4; g++) {
+    __m256i x[16];
+    __m256i y[16];
+    for (size_t i = 0; i < 16; i++) {
+      const auto* lo = in + (32 * g + kBitReversed[i]) * in_stride;
+      const auto* hi = lo + 16 * in_stride;
+      x[i] = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(
+              _mm_loadu_si128(reinterpret_cast<const __m128i*>(lo))),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(hi)), 1);
+    }
+    for (size_t i = 0; i < 8; i++) {
+      y[2 * i] = _mm256_unpacklo_epi8(x[i], x[i + 8]);
+      y[2 * i + 1] = _mm256_unpackhi_epi8(x[i], x[i + 8]);
+    }
+    for (size_t i = 0; i < 8; i++) {
+      x[2 * i] = _mm256_unpacklo_epi16(y[i], y[i + 8]);
+      x[2 * i + 1] = _mm256_unpackhi_epi16(y[i], y[i + 8]);
+    }
+    for (size_t i = 0; i < 8; i++) {
+      y[2 * i] = _mm256_unpacklo_epi32(x[i], x[i + 8]);
+      y[2 * i + 1] = _mm256_unpackhi_epi32(x[i], x[i + 8]);
+    }
+    for (size_t i = 0; i < 8; i++) {
+      x[2 * i] = _mm256_unpacklo_epi64(y[i], y[i + 8]);
+      x[2 * i + 1] = _mm256_unpackhi_epi64(y[i], y[i + 8]);
+    }
+
+    // x[c] holds byte c of the 32 rows, bit b of it goes to row 8 * c + b.
+    for (size_t c = 0; c < 16; c++) {
+      __m256i column = x[c];
+      for (size_t b = 8; b-- > 0;) {
+        const auto bits = static_cast<uint32_t>(_mm256_movemask_epi8(column));
+        auto* row =
+            reinterpret_cast<std::byte*>(out + (8 * c + b) * out_stride);
+        std::memcpy(row + 4 * g, &bits, sizeof(bits));
+        column = _mm256_slli_epi64(column, 1);
+      }
+    }
   }
+}
+
+}  // namespace
 
-  return EklundhTranspose128(inout);
+void Avx2Transpose128(std::array<uint128_t, 128>* inout) {
+  std::array<uint128_t, 128> out;
+  Avx2TransposeSquare(inout->data(), 1, out.data(), 1);
+  *inout = out;
 }
 
-void MatrixTranspose128x1024(std::array<std::array<block, 8>, 128>& inout) {
-  if (kCPUSupportsSSE2) {
-    return SseTranspose128x1024(inout);
+void Avx2Transpose128x1024(std::array<std::array<uint128_t, 8>, 128>* inout) {
+  std::array<std::array<uint128_t, 8>, 128> out;
+  for (size_t i = 0; i < 8; ++i) {
+    Avx2TransposeSquare(&(*inout)[0][i], 8, &out[0][i], 8);
+  }
+  *inout = out;
+}
+
+#endif
+
+#ifdef __aarch64__
+
+namespace {
+
+// transpose the 8x8 bit matrix of each 64-bit lane, byte r bit c goes to
+// byte c bit r.
+inline uint64x2_t NeonTranspose8x8(uint64x2_t x) {
+  uint64x2_t t;
+  t = vandq_u64(veorq_u64(x, vshrq_n_u64(x, 7)),
+                vdupq_n_u64(0x00AA00AA00AA00AAULL));
+  x = veorq_u64(x, veorq_u64(t, vshlq_n_u64(t, 7)));
+  t = vandq_u64(veorq_u64(x, vshrq_n_u64(x, 14)),
+                vdupq_n_u64(0x0000CCCC0000CCCCULL));
+  x = veorq_u64(x, veorq_u64(t, vshlq_n_u64(t, 14)));
+  t = vandq_u64(veorq_u64(x, vshrq_n_u64(x, 28)),
+                vdupq_n_u64(0x00000000F0F0F0F0ULL));
+  x = veorq_u64(x, veorq_u64(t, vshlq_n_u64(t, 28)));
+  return x;
+}
+
+// same as Avx2TransposeSquare, by 16 rows at a time. 4 rounds of zips
+// transpose the 16x16 bytes, so that x[c] holds byte c of the 16 rows, then
+// the 8x8 bit matrices of its two lanes are transposed in place instead of
+// the movemasks, which neon does not have.
+void NeonTransposeSquare(const uint128_t* in, size_t in_stride, uint128_t* out,
+                         size_t out_stride) {
+  constexpr std::array<size_t, 16> kBitReversed = {
+      0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15};
+  // pairs byte b of the low lane with byte b of the high lane.
+  const uint8x16_t kInterleave = {0, 8,  1, 9,  2, 10, 3, 11,
+                                  4, 12, 5, 13, 6, 14, 7, 15};
+
+  for (size_t g = 0; g < 8; g++) {
+    uint8x16_t x[16];
+    uint8x16_t y[16];
+    for (size_t i = 0; i < 16; i++) {
+      x[i] = vld1q_u8(reinterpret_cast<const uint8_t*>(
+          in + (16 * g + kBitReversed[i]) * in_stride));
+    }
+    for (size_t i = 0; i < 8; i++) {
+      y[2 * i] = vzip1q_u8(x[i], x[i + 8]);
+      y[2 * i + 1] = vzip2q_u8(x[i], x[i + 8]);
+    }
+    for (size_t i = 0; i < 8; i++) {
+      const auto a = vreinterpretq_u16_u8(y[i]);
+      const auto b = vreinterpretq_u16_u8(y[i + 8]);
+      x[2 * i] = vreinterpretq_u8_u16(vzip1q_u16(a, b));
+      x[2 * i + 1] = vreinterpretq_u8_u16(vzip2q_u16(a, b));
+    }
+    for (size_t i = 0; i < 8; i++) {
+      const auto a = vreinterpretq_u32_u8(x[i]);
+      const auto b = vreinterpretq_u32_u8(x[i + 8]);
+      y[2 * i] = vreinterpretq_u8_u32(vzip1q_u32(a, b));
+      y[2 * i + 1] = vreinterpretq_u8_u32(vzip2q_u32(a, b));
+    }
+    for (size_t i = 0; i < 8; i++) {
+      const auto a = vreinterpretq_u64_u8(y[i]);
+      const auto b = vreinterpretq_u64_u8(y[i + 8]);
+      x[2 * i] = vreinterpretq_u8_u64(vzip1q_u64(a, b));
+      x[2 * i + 1] = vreinterpretq_u8_u64(vzip2q_u64(a, b));
+    }
+
+    // byte b of lane l of the transposed x[c] holds bit b of byte c of rows
+    // 16 * g + 8 * l + [0, 8), i.e. byte 2 * g + l of row 8 * c + b.
+    for (size_t c = 0; c < 16; c++) {
+      const uint8x16_t t = vqtbl1q_u8(
+          vreinterpretq_u8_u64(NeonTranspose8x8(vreinterpretq_u64_u8(x[c]))),
+          kInterleave);
+      std::array<uint16_t, 8> bits;
+      vst1q_u16(bits.data(), vreinterpretq_u16_u8(t));
+      for (size_t b = 0; b < 8; b++) {
+        auto* row =
+            reinterpret_cast<std::byte*>(out + (8 * c + b) * out_stride);
+        std::memcpy(row + 2 * g, &bits[b], sizeof(uint16_t));
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void NeonTranspose128(std::array<uint128_t, 128>* inout) {
+  std::array<uint128_t, 128> out;
+  NeonTransposeSquare(inout->data(), 1, out.data(), 1);
+  *inout = out;
+}
+
+void NeonTranspose128x1024(std::array<std::array<uint128_t, 8>, 128>* inout) {
+  std::array<std::array<uint128_t, 8>, 128> out;
+  for (size_t i = 0; i < 8; ++i) {
+    NeonTransposeSquare(&(*inout)[0][i], 8, &out[0][i], 8);
   }
+  *inout = out;
+}
+
+#endif
+
+void XorBlocks(absl::Span<block> dst, absl::Span<const block> src) {
+  XorInto(absl::MakeSpan(reinterpret_cast<uint128_t*>(dst.data()), dst.size()),
+          absl::MakeConstSpan(reinterpret_cast<const uint128_t*>(src.data()),
+                              src.size()));
+}
 
-  return EklundhTranspose128x1024(inout);
+void AndBlocks(absl::Span<block> dst, absl::Span<const block> src) {
+  AndInto(absl::MakeSpan(reinterpret_cast<uint128_t*>(dst.data()), dst.size()),
+          absl::MakeConstSpan(reinterpret_cast<const uint128_t*>(src.data()),
+                              src.size()));
+}
+
+void XorBlocks(absl::Span<uint128_t> dst, absl::Span<const uint128_t> src) {
+  XorInto(dst, src);
+}
+
+void AndBlocks(absl::Span<uint128_t> dst, absl::Span<const uint128_t> src) {
+  AndInto(dst, src);
+}
+
+namespace {
+
+using TransposeTileFn = void (*)(const uint128_t* in, size_t in_stride,
+                                 uint128_t* out, size_t out_stride);
+
+// a square transpose of a contiguous tile, on a copy of the strided one.
+template <void (*kTranspose)(std::array<uint128_t, 128>*)>
+void TransposeTileCopy(const uint128_t* in, size_t in_stride, uint128_t* out,
+                       size_t out_stride) {
+  std::array<uint128_t, 128> tile;
+  for (size_t i = 0; i < 128; ++i) {
+    tile[i] = in[i * in_stride];
+  }
+  kTranspose(&tile);
+  for (size_t i = 0; i < 128; ++i) {
+    out[i * out_stride] = tile[i];
+  }
+}
+
+TransposeTileFn SelectTransposeTile() {
+  CpuDispatch<TransposeTileFn> dispatch(
+      "ot.transpose128", TransposeTileCopy<EklundhTranspose128>);
+#ifdef __x86_64
+  dispatch.Add(kIsaSse2, TransposeTileCopy<SseTranspose128>)
+      .Add(kIsaAvx2, Avx2TransposeSquare);
+#endif
+#ifdef __aarch64__
+  dispatch.Add(kIsaNeon, NeonTransposeSquare);
+#endif
+  return dispatch.Bind();
+}
+
+}  // namespace
+
+void TransposeTile128(const uint128_t* in, size_t in_stride, uint128_t* out,
+                      size_t out_stride) {
+  static const TransposeTileFn kTranspose = SelectTransposeTile();
+  kTranspose(in, in_stride, out, out_stride);
+}
+
+void MatrixTranspose(absl::Span<const uint128_t> in, absl::Span<uint128_t> out,
+                     size_t k, size_t m) {
+  YASL_ENFORCE(in.size() == 128 * k * m && out.size() == in.size(),
+               "sizes of in={} and out={} are not 128 * {} * {}", in.size(),
+               out.size(), k, m);
+  constexpr size_t kGroup = 4;
+  // output rows of up to this many words are written in place. lines of
+  // longer rows would evict each other before the tiles of a group fill them
+  // up, so tiles are buffered and their lines written at once instead.
+  constexpr size_t kMaxDirectWords = 16;
+  const bool buffered = k > kMaxDirectWords;
+  // row c of tile (i, j) of the group at tiles[(j * 128 + c) * kGroup + i].
+  std::array<uint128_t, 128 * kGroup * kGroup> tiles;
+  for (size_t i0 = 0; i0 < k; i0 += kGroup) {
+    const size_t ni = std::min(kGroup, k - i0);
+    for (size_t j0 = 0; j0 < m; j0 += kGroup) {
+      const size_t nj = std::min(kGroup, m - j0);
+      for (size_t i = 0; i < ni; ++i) {
+        for (size_t j = 0; j < nj; ++j) {
+          const uint128_t* src = &in[(i0 + i) * 128 * m + j0 + j];
+          if (buffered) {
+            TransposeTile128(src, m, &tiles[j * 128 * kGroup + i], kGroup);
+          } else {
+            TransposeTile128(src, m, &out[(j0 + j) * 128 * k + i0 + i], k);
+          }
+        }
+      }
+      if (!buffered) {
+        continue;
+      }
+      for (size_t j = 0; j < nj; ++j) {
+        uint128_t* dst = &out[(j0 + j) * 128 * k + i0];
+        for (size_t c = 0; c < 128; ++c) {
+          std::memcpy(dst + c * k, &tiles[(j * 128 + c) * kGroup],
+                      ni * sizeof(uint128_t));
+        }
+      }
+    }
+  }
+}
+
+void MatrixTranspose128(std::array<uint128_t, 128>* inout) {
+  std::array<uint128_t, 128> out;
+  TransposeTile128(inout->data(), 1, out.data(), 1);
+  *inout = out;
+}
+
+void MatrixTranspose128x1024(std::array<std::array<block, 8>, 128>& inout) {
+  static_assert(sizeof(std::array<std::array<block, 8>, 128>) ==
+                sizeof(std::array<std::array<uint128_t, 8>, 128>));
+  MatrixTranspose128x1024(
+      reinterpret_cast<std::array<std::array<uint128_t, 8>, 128>*>(&inout));
+}
+
+void MatrixTranspose128x1024(std::array<std::array<uint128_t, 8>, 128>* inout) {
+  std::array<std::array<uint128_t, 8>, 128> out;
+  for (size_t j = 0; j < 8; ++j) {
+    TransposeTile128(&(*inout)[0][j], 8, &out[0][j], 8);
+  }
+  *inout = out;
 }
 
 }  // namespace yasl
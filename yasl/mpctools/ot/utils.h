@@ -20,6 +20,8 @@
 #include <string>
 #include <type_traits>
 
+#include "absl/types/span.h"
+
 #include "yasl/base/byte_container_view.h"
 #include "yasl/base/int128.h"
 #include "yasl/mpctools/ot/block.h"
@@ -31,16 +33,17 @@ inline constexpr uint128_t GetBit(uint128_t i, size_t pos) {
 }
 
 // TODO(shuyan): check MP-SPDZ implementation of `EklundhTranspose128`
-// TODO(shuyan): consider introduce 1024x128 SSE transpose in the future.
+//
+// bit by bit reference of MatrixTranspose<N, 1>, the (128 * N) x 128 matrix of
+// rows `inout[i]` into 128 rows of N words.
 template <size_t N = 1>
 inline void NaiveTranspose(std::array<uint128_t, 128 * N>* inout) {
   std::array<uint128_t, 128 * N> in = *inout;
-  for (size_t i = 0; i < 128 * N; ++i) {
-    uint128_t t = 0;
-    for (size_t j = 0; j < 128; ++j) {
-      t |= GetBit(in[j], i) << j;
+  inout->fill(0);
+  for (size_t i = 0; i < 128; ++i) {
+    for (size_t j = 0; j < 128 * N; ++j) {
+      (*inout)[i * N + j / 128] |= GetBit(in[j], i) << (j % 128);
     }
-    (*inout)[i] = t;
   }
 }
 
@@ -72,7 +75,55 @@ void SseTranspose128x1024(std::array<std::array<uint128_t, 8>, 128>* inout);
 void EklundhTranspose128x1024(std::array<std::array<block, 8>, 128>& inout);
 void EklundhTranspose128x1024(std::array<std::array<uint128_t, 8>, 128>* inout);
 
+#ifdef __x86_64
+// byte columns are gathered by shuffles in both 128-bit lanes, then each
+// movemask emits 32 bits of a transposed row. requires a cpu with avx2.
+void Avx2Transpose128(std::array<uint128_t, 128>* inout);
+
+void Avx2Transpose128x1024(std::array<std::array<uint128_t, 8>, 128>* inout);
+#endif
+
+#ifdef __aarch64__
+// same layout as the avx2 ones, 8x8 bit blocks are transposed in neon
+// registers instead of by movemasks, which sse2neon emulates slowly.
+void NeonTranspose128(std::array<uint128_t, 128>* inout);
+
+void NeonTranspose128x1024(std::array<std::array<uint128_t, 8>, 128>* inout);
+#endif
+
+// dst[i] ^= src[i], dst[i] &= src[i] over spans of the same size, by the
+// XorInto and AndInto kernels of yasl/utils/bitwise.h.
+void XorBlocks(absl::Span<block> dst, absl::Span<const block> src);
+void AndBlocks(absl::Span<block> dst, absl::Span<const block> src);
+void XorBlocks(absl::Span<uint128_t> dst, absl::Span<const uint128_t> src);
+void AndBlocks(absl::Span<uint128_t> dst, absl::Span<const uint128_t> src);
+
+// transpose the 128x128 bit matrix of rows `in[j * in_stride]` into rows
+// `out[i * out_stride]`, which should not overlap. dispatch to the fastest
+// kernel supported by the cpu, at runtime.
+void TransposeTile128(const uint128_t* in, size_t in_stride, uint128_t* out,
+                      size_t out_stride);
+
+// transpose the (128 * k) x (128 * m) bit matrix `in` into the
+// (128 * m) x (128 * k) one `out`, rows are kept in m and k words
+// respectively, i.e. bit c of row r is bit c % 128 of in[r * m + c / 128].
+//
+// tiles are transposed by groups of 4x4, 4 words being a cache line, and
+// buffered when output rows are long, so that lines of the output are written
+// as a whole.
+void MatrixTranspose(absl::Span<const uint128_t> in, absl::Span<uint128_t> out,
+                     size_t k, size_t m);
+
+template <size_t K, size_t M>
+void MatrixTranspose(const std::array<uint128_t, 128 * K * M>& in,
+                     std::array<uint128_t, 128 * K * M>* out) {
+  MatrixTranspose(absl::MakeConstSpan(in), absl::MakeSpan(*out), K, M);
+}
+
+// thin wrappers of TransposeTile128, the 128x1024 ones transpose each 128x128
+// column tile in place, so row i of tile j ends up in inout[i][j].
 void MatrixTranspose128(std::array<uint128_t, 128>* inout);
 void MatrixTranspose128x1024(std::array<std::array<block, 8>, 128>& inout);
+void MatrixTranspose128x1024(std::array<std::array<uint128_t, 8>, 128>* inout);
 
 }  // namespace yasl
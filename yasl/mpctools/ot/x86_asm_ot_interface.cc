@@ -18,6 +18,7 @@
 #include "simplest_ot_x86_asm/ot_receiver.h"
 #include "simplest_ot_x86_asm/ot_sender.h"
 
+#include "yasl/base/buffer.h"
 #include "yasl/base/exception.h"
 #include "yasl/crypto/random_oracle.h"
 
@@ -26,7 +27,7 @@
 namespace yasl {
 
 void X86AsmOtInterface::Recv(const std::shared_ptr<link::Context> &ctx,
-                             const std::vector<bool> &choices,
+                             const BitVector &choices,
                              absl::Span<Block> recv_blocks) {
   const int kNumOt = choices.size();
   auto receiver = std::make_unique<SIMPLEOT_RECEIVER>();
@@ -42,19 +43,22 @@ void X86AsmOtInterface::Recv(const std::shared_ptr<link::Context> &ctx,
 
   receiver_maketable(receiver.get());
 
+  // all points are packed into one msg, so that base ots take a constant
+  // number of rounds.
+  Buffer rs_packs(static_cast<int64_t>((kNumOt + 3) / 4) * 4 * PACKBYTES);
   for (int i = 0; i < kNumOt; i += 4) {
     const int batch_size = std::min(4, kNumOt - i);
 
     unsigned char messages[4][HASHBYTES];
-    unsigned char rs_pack[4 * PACKBYTES];
     unsigned char batch_choices[4] = {0, 0, 0, 0};
 
     for (int j = 0; j < batch_size; j++) {
       batch_choices[j] = choices[i + j] ? 1 : 0;
     }
 
-    receiver_rsgen(receiver.get(), rs_pack, batch_choices);
-    ctx->Send(ctx->NextRank(), rs_pack, fmt::format("BASE_OT:{}", i));
+    receiver_rsgen(receiver.get(),
+                   rs_packs.data<unsigned char>() + i * PACKBYTES,
+                   batch_choices);
 
     receiver_keygen(receiver.get(), &messages[0]);
     for (int j = 0; j < batch_size; ++j) {
@@ -70,6 +74,7 @@ void X86AsmOtInterface::Recv(const std::shared_ptr<link::Context> &ctx,
           recv_blocks[i + j] ^ (i + j));  // output size = 128 bit
     }
   }
+  ctx->SendAsync(ctx->NextRank(), std::move(rs_packs), "BASE_OT:RS_PACK");
 }
 
 void X86AsmOtInterface::Send(const std::shared_ptr<link::Context> &ctx,
@@ -80,18 +85,19 @@ void X86AsmOtInterface::Send(const std::shared_ptr<link::Context> &ctx,
   // Send S_pack.
   unsigned char S_pack[PACKBYTES];
   sender_genS(sender.get(), S_pack);
-  ctx->Send(ctx->NextRank(), S_pack, "BASE_OT:S_PACK");
+  ctx->SendAsync(ctx->NextRank(), S_pack, "BASE_OT:S_PACK");
 
+  auto buffer = ctx->Recv(ctx->NextRank(), "BASE_OT:RS_PACK");
+  YASL_ENFORCE_EQ(buffer.size(),
+                  static_cast<int64_t>((kNumOt + 3) / 4) * 4 * PACKBYTES);
   for (int i = 0; i < kNumOt; i += 4) {
     const int batch_size = std::min(4, kNumOt - i);
 
-    unsigned char rs_pack[4 * PACKBYTES];
     unsigned char messages[2][4][HASHBYTES];
 
-    auto buffer = ctx->Recv(ctx->NextRank(), fmt::format("BASE_OT:{}", i));
-    YASL_ENFORCE_EQ(buffer.size(), static_cast<int64_t>(sizeof(rs_pack)));
-    std::memcpy(rs_pack, buffer.data(), static_cast<int64_t>(buffer.size()));
-    if (!sender_keygen_check(sender.get(), rs_pack, messages)) {
+    if (!sender_keygen_check(sender.get(),
+                             buffer.data<unsigned char>() + i * PACKBYTES,
+                             messages)) {
       YASL_THROW("simplest-ot: sender_keygen failed");
     }
 
@@ -26,7 +26,7 @@ class X86AsmOtInterface : public BaseOTInterface {
             absl::Span<std::array<Block, 2>> send_blocks) override;
 
   void Recv(const std::shared_ptr<link::Context>& ctx,
-            const std::vector<bool>& choices,
+            const BitVector& choices,
             absl::Span<Block> recv_blocks) override;
 };
 
@@ -0,0 +1,488 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/psi/kkrt_psi.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <utility>
+
+#include "absl/numeric/bits.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/crypto/crhash.h"
+#include "yasl/crypto/cuckoo_hash.h"
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/mpctools/ot/kkrt_ot_extension.h"
+#include "yasl/utils/hash.h"
+#include "yasl/utils/parallel.h"
+#include "yasl/utils/rand.h"
+
+namespace yasl {
+namespace {
+
+// items of a parallel task.
+constexpr int64_t kGrainSize = 4096;
+
+// msg of the session parameters, which both parties must agree on, but for
+// the set size.
+struct Header {
+  uint64_t num_items;
+  uint64_t bucket_size;
+  uint64_t num_hashes;
+  uint64_t stat_sec;
+  uint64_t reveal_to_sender;
+  double scale_factor;
+
+  bool SameOptions(const Header& other) const {
+    return bucket_size == other.bucket_size &&
+           num_hashes == other.num_hashes && stat_sec == other.stat_sec &&
+           reveal_to_sender == other.reveal_to_sender &&
+           scale_factor == other.scale_factor;
+  }
+};
+
+// msg of the receiver's cuckoo table of a bucket.
+struct BucketMeta {
+  uint64_t num_bins;
+  uint64_t stash_size;
+};
+
+template <class T>
+void SendPod(const std::shared_ptr<link::Context>& ctx, const T& value,
+             std::string_view tag) {
+  ctx->SendAsync(ctx->NextRank(), ByteContainerView(&value, sizeof(value)),
+                 tag);
+}
+
+template <class T>
+T RecvPod(const std::shared_ptr<link::Context>& ctx, std::string_view tag) {
+  auto buf = ctx->Recv(ctx->NextRank(), tag);
+  YASL_ENFORCE_EQ(buf.size(), static_cast<int64_t>(sizeof(T)));
+  T value;
+  std::memcpy(&value, buf.data(), sizeof(T));
+  return value;
+}
+
+void SendU64s(const std::shared_ptr<link::Context>& ctx,
+              const std::vector<uint64_t>& values, std::string_view tag) {
+  ctx->SendAsync(ctx->NextRank(),
+                 ByteContainerView(values.data(),
+                                   values.size() * sizeof(uint64_t)),
+                 tag);
+}
+
+std::vector<uint64_t> RecvU64s(const std::shared_ptr<link::Context>& ctx,
+                               std::string_view tag) {
+  auto buf = ctx->Recv(ctx->NextRank(), tag);
+  YASL_ENFORCE(buf.size() % sizeof(uint64_t) == 0);
+  std::vector<uint64_t> values(buf.size() / sizeof(uint64_t));
+  std::memcpy(values.data(), buf.data(), buf.size());
+  return values;
+}
+
+// items are split into buckets by a hash of both halves. FastHash of
+// integers involves no byte order, so both parties agree on it.
+size_t BucketOf(uint128_t item, size_t num_buckets) {
+  const uint64_t hash = utils::FastHash(static_cast<uint64_t>(item),
+                                        static_cast<uint64_t>(item >> 64));
+  return static_cast<size_t>(
+      (static_cast<unsigned __int128>(hash) * num_buckets) >> 64);
+}
+
+// the items of bucket b are items[order[begin[b]]], ...,
+// items[order[begin[b + 1] - 1]].
+struct Buckets {
+  std::vector<size_t> begin;
+  std::vector<size_t> order;
+
+  size_t Size(size_t b) const { return begin[b + 1] - begin[b]; }
+
+  absl::Span<const size_t> Indices(size_t b) const {
+    return absl::MakeConstSpan(order).subspan(begin[b], Size(b));
+  }
+
+  std::vector<uint64_t> Sizes() const {
+    std::vector<uint64_t> sizes(begin.size() - 1);
+    for (size_t b = 0; b < sizes.size(); ++b) {
+      sizes[b] = Size(b);
+    }
+    return sizes;
+  }
+};
+
+// a counting sort of the items by bucket.
+Buckets SplitBuckets(absl::Span<const uint128_t> items, size_t num_buckets) {
+  std::vector<uint32_t> bucket_of(items.size());
+  parallel_for(0, items.size(), kGrainSize, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      bucket_of[i] = static_cast<uint32_t>(BucketOf(items[i], num_buckets));
+    }
+  });
+  Buckets buckets;
+  buckets.begin.assign(num_buckets + 1, 0);
+  for (uint32_t b : bucket_of) {
+    ++buckets.begin[b + 1];
+  }
+  for (size_t b = 0; b < num_buckets; ++b) {
+    buckets.begin[b + 1] += buckets.begin[b];
+  }
+  std::vector<size_t> next(buckets.begin.begin(), buckets.begin.end() - 1);
+  buckets.order.resize(items.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    buckets.order[next[bucket_of[i]]++] = i;
+  }
+  return buckets;
+}
+
+// the buckets of a session, of this party and of the peer.
+struct Session {
+  Buckets buckets;
+  std::vector<uint64_t> peer_sizes;
+  uint64_t peer_items = 0;
+
+  size_t NumBuckets() const { return peer_sizes.size(); }
+
+  // an empty bucket of either party has no ots.
+  bool Skip(size_t b) const {
+    return buckets.Size(b) == 0 || peer_sizes[b] == 0;
+  }
+};
+
+// agrees on the options and the bucket sizes with the peer.
+Session Handshake(const std::shared_ptr<link::Context>& ctx,
+                  absl::Span<const uint128_t> items,
+                  const KkrtPsiOptions& options) {
+  YASL_ENFORCE(options.bucket_size > 0);
+  YASL_ENFORCE(options.num_hashes > 0 &&
+                   options.num_hashes <= kMaxCuckooHashes,
+               "{} hashes out of [1, {}]", options.num_hashes,
+               kMaxCuckooHashes);
+  YASL_ENFORCE(options.ot_window > 0 && options.chunk_size > 0);
+
+  Header header;
+  header.num_items = items.size();
+  header.bucket_size = options.bucket_size;
+  header.num_hashes = options.num_hashes;
+  header.stat_sec = options.stat_sec;
+  header.reveal_to_sender = options.reveal_to_sender;
+  header.scale_factor = options.scale_factor;
+  SendPod(ctx, header, "KKRT_PSI:HEADER");
+  const auto peer = RecvPod<Header>(ctx, "KKRT_PSI:HEADER");
+  YASL_ENFORCE(header.SameOptions(peer),
+               "kkrt psi options differ from the peer's");
+
+  Session session;
+  session.peer_items = peer.num_items;
+  const size_t num_items = std::max<uint64_t>(items.size(), peer.num_items);
+  const size_t num_buckets =
+      std::max<size_t>(1, (num_items + options.bucket_size - 1) /
+                              options.bucket_size);
+  YASL_ENFORCE(num_buckets <= std::numeric_limits<uint32_t>::max());
+  session.buckets = SplitBuckets(items, num_buckets);
+  SendU64s(ctx, session.buckets.Sizes(), "KKRT_PSI:BUCKETS");
+  session.peer_sizes = RecvU64s(ctx, "KKRT_PSI:BUCKETS");
+  YASL_ENFORCE_EQ(session.peer_sizes.size(), num_buckets);
+  return session;
+}
+
+size_t Log2Ceil(uint64_t n) { return n <= 1 ? 0 : absl::bit_width(n - 1); }
+
+// bytes of an encoding, so that all comparisons of the session, of the
+// encodings of the sender's items by their hashes and the stash with those
+// of the receiver's, have false positives with a probability of at most
+// 2^-stat_sec.
+size_t EncodingSize(const KkrtPsiOptions& options, uint64_t sender_items,
+                    uint64_t receiver_items, uint64_t stash_size) {
+  const size_t bits = options.stat_sec +
+                      Log2Ceil(sender_items * (options.num_hashes +
+                                               stash_size)) +
+                      Log2Ceil(receiver_items);
+  return std::min(sizeof(uint128_t), (bits + 7) / 8);
+}
+
+uint128_t LoadEncoding(const uint8_t* data, size_t size) {
+  uint128_t value = 0;
+  std::memcpy(&value, data, size);
+  return value;
+}
+
+// the ots of the buckets are as many sessions of KKRT, each on its own base
+// ots, which are derived from the given ones by a hash tweaked by the
+// bucket.
+BaseSendOptions BucketBaseOptions(const BaseSendOptions& base, size_t bucket) {
+  BaseSendOptions derived;
+  derived.blocks.resize(base.blocks.size());
+  for (size_t k = 0; k < base.blocks.size(); ++k) {
+    for (size_t c = 0; c < 2; ++c) {
+      derived.blocks[k][c] = TccrHash(base.blocks[k][c], bucket);
+    }
+  }
+  return derived;
+}
+
+BaseRecvOptions BucketBaseOptions(const BaseRecvOptions& base, size_t bucket) {
+  BaseRecvOptions derived;
+  derived.choices = base.choices;
+  derived.blocks.resize(base.blocks.size());
+  TccrHash(base.blocks, std::vector<uint128_t>(base.blocks.size(), bucket),
+           absl::MakeSpan(derived.blocks));
+  return derived;
+}
+
+std::vector<uint128_t> Gather(absl::Span<const uint128_t> items,
+                              absl::Span<const size_t> indices) {
+  std::vector<uint128_t> gathered(indices.size());
+  parallel_for(0, indices.size(), kGrainSize, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      gathered[i] = items[indices[i]];
+    }
+  });
+  return gathered;
+}
+
+// intersects a bucket, returns the positions in the bucket of the items
+// found.
+std::vector<size_t> RecvBucket(const std::shared_ptr<link::Context>& ctx,
+                               const BaseSendOptions& base_options,
+                               size_t bucket, absl::Span<const uint128_t> ys,
+                               uint64_t sender_items,
+                               uint64_t total_sender_items,
+                               uint64_t total_receiver_items,
+                               const KkrtPsiOptions& options) {
+  CuckooHashTable table(ys.size(), options.num_hashes, options.scale_factor);
+  table.Insert(ys);
+  const size_t num_bins = table.num_bins();
+  const auto& stash = table.stash();
+  const size_t num_ot = num_bins + stash.size();
+  SendPod(ctx, BucketMeta{num_bins, stash.size()}, "KKRT_PSI:META");
+
+  // ot inputs, by the hash function which placed the item, or random for
+  // empty bins.
+  std::vector<uint128_t> inputs(num_ot);
+  std::vector<uint128_t> tweaks(num_ot, 0);
+  PseudoRandomGenerator<uint128_t> prg(RandSeed());
+  for (size_t i = 0; i < num_bins; ++i) {
+    const auto& bin = table.bins()[i];
+    if (bin.item == CuckooHashTable::kEmpty) {
+      inputs[i] = prg();
+    } else {
+      inputs[i] = ys[bin.item];
+      tweaks[i] = bin.hash_index;
+    }
+  }
+  for (size_t s = 0; s < stash.size(); ++s) {
+    inputs[num_bins + s] = ys[stash[s]];
+    tweaks[num_bins + s] = options.num_hashes;
+  }
+  TccrHash(inputs, tweaks, absl::MakeSpan(inputs));
+
+  const size_t encoding_size = EncodingSize(
+      options, total_sender_items, total_receiver_items, stash.size());
+  std::vector<uint8_t> encodings(num_ot * encoding_size);
+  {
+    KkrtOtExtReceiver receiver;
+    receiver.Init(ctx, BucketBaseOptions(base_options, bucket), num_ot,
+                  /*lazy=*/true);
+    receiver.SetBatchSize(options.ot_window);
+    receiver.StreamEncode(ctx, inputs, absl::MakeSpan(encodings),
+                          encoding_size);
+  }
+
+  // encodings of the items to their positions.
+  utils::FastHashMap<uint128_t, uint64_t> lookup;
+  lookup.reserve(ys.size());
+  for (size_t i = 0; i < num_ot; ++i) {
+    const uint64_t item =
+        i < num_bins ? table.bins()[i].item : stash[i - num_bins];
+    if (item != CuckooHashTable::kEmpty) {
+      lookup.emplace(
+          LoadEncoding(&encodings[i * encoding_size], encoding_size), item);
+    }
+  }
+  encodings = {};
+
+  // the sender's encodings, each item of it has one per hash function and
+  // one per stash item in a row.
+  const uint64_t per_item = options.num_hashes + stash.size();
+  const uint64_t expected = sender_items * per_item;
+  std::vector<size_t> found;
+  std::vector<uint64_t> sender_found;
+  std::vector<uint64_t> hits;
+  for (uint64_t received = 0; received < expected;) {
+    auto chunk = ctx->Recv(ctx->NextRank(), "KKRT_PSI:ENCODINGS");
+    YASL_ENFORCE(chunk.size() > 0 && chunk.size() % encoding_size == 0);
+    const size_t n = chunk.size() / encoding_size;
+    YASL_ENFORCE_LE(received + n, expected);
+    hits.assign(n, CuckooHashTable::kEmpty);
+    const auto* data = chunk.data<uint8_t>();
+    parallel_for(0, n, kGrainSize, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        auto it =
+            lookup.find(LoadEncoding(&data[i * encoding_size], encoding_size));
+        if (it != lookup.end()) {
+          hits[i] = it->second;
+        }
+      }
+    });
+    for (size_t i = 0; i < n; ++i) {
+      if (hits[i] != CuckooHashTable::kEmpty) {
+        found.push_back(hits[i]);
+        sender_found.push_back((received + i) / per_item);
+      }
+    }
+    received += n;
+  }
+  if (options.reveal_to_sender) {
+    SendU64s(ctx, sender_found, "KKRT_PSI:RESULT");
+  }
+  return found;
+}
+
+// encodes the items of a bucket in a random order, returns the positions in
+// the bucket of the items found by the receiver, if they are revealed.
+std::vector<size_t> SendBucket(const std::shared_ptr<link::Context>& ctx,
+                               const BaseRecvOptions& base_options,
+                               size_t bucket, absl::Span<const uint128_t> xs,
+                               uint64_t total_sender_items,
+                               uint64_t total_receiver_items,
+                               const KkrtPsiOptions& options) {
+  const auto meta = RecvPod<BucketMeta>(ctx, "KKRT_PSI:META");
+  YASL_ENFORCE(meta.num_bins > 0 &&
+               meta.num_bins < std::numeric_limits<uint32_t>::max());
+  const uint64_t num_ot = meta.num_bins + meta.stash_size;
+  const size_t encoding_size = EncodingSize(
+      options, total_sender_items, total_receiver_items, meta.stash_size);
+
+  KkrtOtExtSender sender;
+  sender.Init(ctx, BucketBaseOptions(base_options, bucket), num_ot);
+
+  // a random order of the items, so that the receiver can not tell them
+  // from their positions.
+  std::vector<size_t> order(xs.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  PseudoRandomGenerator<uint64_t> prg(RandSeed());
+  for (size_t i = order.size(); i > 1; --i) {
+    std::swap(order[i - 1], order[prg() % i]);
+  }
+
+  sender.StreamRecvCorrection(ctx, num_ot, [](uint64_t, uint64_t) {});
+
+  const size_t per_item = options.num_hashes + meta.stash_size;
+  const size_t chunk_items = std::max<size_t>(1, options.chunk_size / per_item);
+  std::vector<uint128_t> chunk_xs;
+  std::vector<uint32_t> bins;
+  std::vector<size_t> ot_idxes;
+  std::vector<uint128_t> inputs;
+  std::vector<uint128_t> tweaks;
+  for (size_t first = 0; first < xs.size(); first += chunk_items) {
+    const size_t n = std::min(chunk_items, xs.size() - first);
+    chunk_xs.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      chunk_xs[i] = xs[order[first + i]];
+    }
+    bins.resize(n * options.num_hashes);
+    CuckooHashToBins(chunk_xs, options.num_hashes,
+                     static_cast<uint32_t>(meta.num_bins),
+                     absl::MakeSpan(bins));
+    ot_idxes.resize(n * per_item);
+    inputs.resize(n * per_item);
+    tweaks.resize(n * per_item);
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < per_item; ++j) {
+        const size_t k = i * per_item + j;
+        if (j < options.num_hashes) {
+          ot_idxes[k] = bins[i * options.num_hashes + j];
+          tweaks[k] = j;
+        } else {
+          ot_idxes[k] = meta.num_bins + (j - options.num_hashes);
+          tweaks[k] = options.num_hashes;
+        }
+        inputs[k] = chunk_xs[i];
+      }
+    }
+    TccrHash(inputs, tweaks, absl::MakeSpan(inputs));
+    Buffer encodings(static_cast<int64_t>(n * per_item * encoding_size));
+    sender.BatchEncode(
+        ot_idxes, inputs,
+        absl::MakeSpan(encodings.data<uint8_t>(), encodings.size()),
+        encoding_size);
+    ctx->SendAsync(ctx->NextRank(), std::move(encodings),
+                   "KKRT_PSI:ENCODINGS");
+  }
+
+  std::vector<size_t> found;
+  if (options.reveal_to_sender) {
+    for (uint64_t pos : RecvU64s(ctx, "KKRT_PSI:RESULT")) {
+      YASL_ENFORCE_LT(pos, order.size());
+      found.push_back(order[pos]);
+    }
+  }
+  return found;
+}
+
+std::vector<size_t> SortedUnique(std::vector<size_t> indices) {
+  std::sort(indices.begin(), indices.end());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+  return indices;
+}
+
+}  // namespace
+
+std::vector<size_t> KkrtPsiRecv(const std::shared_ptr<link::Context>& ctx,
+                                const BaseSendOptions& base_options,
+                                absl::Span<const uint128_t> items,
+                                const KkrtPsiOptions& options) {
+  const auto session = Handshake(ctx, items, options);
+
+  std::vector<size_t> intersection;
+  for (size_t b = 0; b < session.NumBuckets(); ++b) {
+    if (session.Skip(b)) {
+      continue;
+    }
+    const auto indices = session.buckets.Indices(b);
+    for (size_t pos : RecvBucket(ctx, base_options, b, Gather(items, indices),
+                                 session.peer_sizes[b], session.peer_items,
+                                 items.size(), options)) {
+      intersection.push_back(indices[pos]);
+    }
+  }
+  return SortedUnique(std::move(intersection));
+}
+
+std::vector<size_t> KkrtPsiSend(const std::shared_ptr<link::Context>& ctx,
+                                const BaseRecvOptions& base_options,
+                                absl::Span<const uint128_t> items,
+                                const KkrtPsiOptions& options) {
+  const auto session = Handshake(ctx, items, options);
+
+  std::vector<size_t> intersection;
+  for (size_t b = 0; b < session.NumBuckets(); ++b) {
+    if (session.Skip(b)) {
+      continue;
+    }
+    const auto indices = session.buckets.Indices(b);
+    for (size_t pos : SendBucket(ctx, base_options, b, Gather(items, indices),
+                                 items.size(), session.peer_items, options)) {
+      intersection.push_back(indices[pos]);
+    }
+  }
+  return SortedUnique(std::move(intersection));
+}
+
+}  // namespace yasl
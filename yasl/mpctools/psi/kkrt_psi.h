@@ -0,0 +1,84 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/int128.h"
+#include "yasl/link/link.h"
+#include "yasl/mpctools/ot/options.h"
+
+namespace yasl {
+
+// Two party PSI on the KKRT OPRF, https://eprint.iacr.org/2016/799.pdf
+// (Section 3).
+//
+// Both sets are split into buckets by a hash of the items, and the buckets
+// are intersected one after another, so that the memory of either party is
+// linear in the size of a bucket rather than of a set. In a bucket:
+//   1. the receiver cuckoo hashes its items into bins, see CuckooHashTable,
+//      an item of the stash gets an ot of its own.
+//   2. the receiver encodes item y of a bin by the KKRT ot of the bin, with
+//      input TccrHash(y, j) for the hash function j which put it there. The
+//      corrections are streamed in windows of `ot_window` ots.
+//   3. the sender encodes each of its items x by the ots of its bins h_j(x)
+//      and of the stash, in a random order of the items, and sends them in
+//      chunks while it encodes the next ones.
+//   4. the receiver looks the chunks up among the encodings of its items.
+//
+// Encodings are truncated to stat_sec + log2(comparisons) bits. Besides the
+// set sizes, the number of items of each bucket is revealed to the peer.
+//
+// Items are 128 bits, items of bytes may be reduced by crypto::Blake3_128.
+// Items of a set should be distinct.
+struct KkrtPsiOptions {
+  // the sets are split into buckets of about as many items of the larger
+  // set.
+  size_t bucket_size = size_t{1} << 20;
+  // hash functions of the cuckoo table, and its bins per item.
+  size_t num_hashes = 3;
+  double scale_factor = 1.27;
+  // ots of a correction window, see KkrtOtExtReceiver::StreamEncode.
+  size_t ot_window = size_t{1} << 14;
+  // encodings of a msg of the sender.
+  size_t chunk_size = size_t{1} << 16;
+  // a false positive has a probability of at most 2^-stat_sec.
+  size_t stat_sec = 40;
+  // the receiver also tells the sender which of its items are in the
+  // intersection, at the cost of a round trip per bucket.
+  bool reveal_to_sender = false;
+};
+
+// Returns the indices of the items of the receiver which are in the
+// intersection, in increasing order. base_options are of 512 base ots,
+// KKRT's width, with the sender's ones of KkrtPsiSend.
+std::vector<size_t> KkrtPsiRecv(const std::shared_ptr<link::Context>& ctx,
+                                const BaseSendOptions& base_options,
+                                absl::Span<const uint128_t> items,
+                                const KkrtPsiOptions& options = {});
+
+// Returns the indices of the items of the sender which are in the
+// intersection, in increasing order, if reveal_to_sender is set. Empty
+// otherwise.
+std::vector<size_t> KkrtPsiSend(const std::shared_ptr<link::Context>& ctx,
+                                const BaseRecvOptions& base_options,
+                                absl::Span<const uint128_t> items,
+                                const KkrtPsiOptions& options = {});
+
+}  // namespace yasl
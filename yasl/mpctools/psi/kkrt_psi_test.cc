@@ -0,0 +1,141 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/psi/kkrt_psi.h"
+
+#include <algorithm>
+#include <future>
+#include <random>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/link/test_util.h"
+
+namespace yasl {
+namespace {
+
+std::pair<BaseSendOptions, BaseRecvOptions> MakeBaseOptions(size_t num) {
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  recv_opts.choices = CreateRandomChoices(num);
+  std::random_device rd;
+  PseudoRandomGenerator<uint128_t> gen(rd());
+  for (size_t i = 0; i < num; ++i) {
+    send_opts.blocks.push_back({gen(), gen()});
+    recv_opts.blocks.push_back(send_opts.blocks[i][recv_opts.choices[i]]);
+  }
+  return {std::move(send_opts), std::move(recv_opts)};
+}
+
+struct TestParams {
+  size_t sender_size;
+  size_t receiver_size;
+  size_t common_size;
+  size_t bucket_size;
+  bool reveal_to_sender;
+};
+
+class KkrtPsiTest : public ::testing::TestWithParam<TestParams> {};
+
+TEST_P(KkrtPsiTest, Works) {
+  // GIVEN
+  const auto params = GetParam();
+  auto contexts = link::test::SetupWorld(2);
+  // KKRT requires 512 width.
+  auto [send_opts, recv_opts] = MakeBaseOptions(512);
+
+  // the first common_size items of both sets are the same, placed at odd
+  // indices of the receiver's set.
+  PseudoRandomGenerator<uint128_t> prg;
+  std::vector<uint128_t> sender_items(params.sender_size);
+  std::vector<uint128_t> receiver_items(params.receiver_size);
+  std::vector<size_t> expected_sender;
+  std::vector<size_t> expected_receiver;
+  for (size_t i = 0; i < params.common_size; ++i) {
+    sender_items[i] = prg();
+    receiver_items[2 * i + 1] = sender_items[i];
+    expected_sender.push_back(i);
+    expected_receiver.push_back(2 * i + 1);
+  }
+  for (size_t i = params.common_size; i < params.sender_size; ++i) {
+    sender_items[i] = prg();
+  }
+  for (size_t i = 0; i < params.receiver_size; ++i) {
+    if (i % 2 == 0 || i >= 2 * params.common_size) {
+      receiver_items[i] = prg();
+    }
+  }
+  std::sort(expected_receiver.begin(), expected_receiver.end());
+
+  KkrtPsiOptions options;
+  options.bucket_size = params.bucket_size;
+  options.reveal_to_sender = params.reveal_to_sender;
+  // several windows and chunks per bucket.
+  options.ot_window = 100;
+  options.chunk_size = 1000;
+
+  // WHEN
+  auto sender = std::async([&] {
+    return KkrtPsiSend(contexts[0], recv_opts, sender_items, options);
+  });
+  auto receiver = std::async([&] {
+    return KkrtPsiRecv(contexts[1], send_opts, receiver_items, options);
+  });
+
+  // THEN
+  EXPECT_EQ(receiver.get(), expected_receiver);
+  if (params.reveal_to_sender) {
+    EXPECT_EQ(sender.get(), expected_sender);
+  } else {
+    EXPECT_TRUE(sender.get().empty());
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Works_Instances, KkrtPsiTest,
+                         testing::Values(TestParams{1, 2, 1, 1 << 20, true},
+                                         TestParams{100, 300, 50, 1 << 20,
+                                                    false},
+                                         TestParams{3000, 2000, 1000, 1 << 20,
+                                                    true},
+                                         // many buckets.
+                                         TestParams{5000, 4000, 2000, 100,
+                                                    true},
+                                         TestParams{4000, 5000, 0, 1000, true},
+                                         // no ots at all.
+                                         TestParams{0, 1000, 0, 100, true}));
+
+TEST(KkrtPsiEdgeTest, MismatchedOptions) {
+  auto contexts = link::test::SetupWorld(2);
+  auto [send_opts, recv_opts] = MakeBaseOptions(512);
+  std::vector<uint128_t> items(10, 1);
+
+  KkrtPsiOptions sender_options;
+  KkrtPsiOptions receiver_options;
+  receiver_options.num_hashes = 2;
+  auto sender = std::async([&] {
+    return KkrtPsiSend(contexts[0], recv_opts, items, sender_options);
+  });
+  auto receiver = std::async([&] {
+    return KkrtPsiRecv(contexts[1], send_opts, items, receiver_options);
+  });
+  EXPECT_THROW(sender.get(), EnforceNotMet);
+  EXPECT_THROW(receiver.get(), EnforceNotMet);
+}
+
+}  // namespace
+}  // namespace yasl
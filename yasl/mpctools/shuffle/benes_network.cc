@@ -0,0 +1,141 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/shuffle/benes_network.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "absl/numeric/bits.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl {
+namespace {
+
+// bit j of bits from sides[2j].
+void SetBits(absl::Span<const int8_t> sides, BitVector* bits) {
+  const int64_t num_words = BitVector::NumWords(bits->size());
+  parallel_for(0, num_words, 64, [&](int64_t begin, int64_t end) {
+    const size_t last = std::min<size_t>(end * BitVector::kWordBits,
+                                         bits->size());
+    for (size_t j = begin * BitVector::kWordBits; j < last; ++j) {
+      bits->Set(j, sides[2 * j] != 0);
+    }
+  });
+}
+
+}  // namespace
+
+BenesNetwork::BenesNetwork(size_t n) {
+  num_wires_ = absl::bit_ceil(std::max<size_t>(n, 1));
+  log_wires_ = absl::countr_zero(num_wires_);
+  num_layers_ = log_wires_ == 0 ? 0 : 2 * log_wires_ - 1;
+}
+
+BenesNetwork::Switch BenesNetwork::GetSwitch(size_t layer,
+                                             size_t index) const {
+  YASL_ENFORCE(layer < num_layers_ && index < NumSwitchesPerLayer());
+  const size_t middle = log_wires_ - 1;
+  if (layer == middle) {
+    return {2 * index, 2 * index + 1, 2 * index, 2 * index + 1};
+  }
+  const size_t depth = layer < middle ? layer : num_layers_ - 1 - layer;
+  const size_t half = num_wires_ >> (depth + 1);
+  const size_t block = index / half * 2 * half;
+  const size_t j = index % half;
+  const size_t paired = block + 2 * j;
+  const size_t split = block + j;
+  if (layer < middle) {
+    return {paired, paired + 1, split, split + half};
+  }
+  return {split, split + half, paired, paired + 1};
+}
+
+// the looping algorithm, https://doi.org/10.1145/321724.321726, on all
+// blocks of a depth at once. perm holds the permutation of each block, of
+// its own wires, and is replaced by the ones of its halves.
+std::vector<BitVector> BenesNetwork::Route(
+    absl::Span<const size_t> perm) const {
+  YASL_ENFORCE(perm.size() <= num_wires_, "perm of {} > {} wires",
+               perm.size(), num_wires_);
+  std::vector<size_t> cur(num_wires_);
+  std::vector<bool> seen(num_wires_, false);
+  for (size_t i = 0; i < num_wires_; ++i) {
+    cur[i] = i < perm.size() ? perm[i] : i;
+    YASL_ENFORCE(cur[i] < num_wires_ && !seen[cur[i]], "not a permutation");
+    seen[cur[i]] = true;
+  }
+
+  std::vector<BitVector> bits(num_layers_,
+                              BitVector(NumSwitchesPerLayer(), false));
+  if (num_layers_ == 0) {
+    return bits;
+  }
+  std::vector<size_t> inv(num_wires_);
+  std::vector<size_t> next(num_wires_);
+  // sides of the outputs and of the inputs of a block, 0 for its top half.
+  std::vector<int8_t> out_side(num_wires_);
+  std::vector<int8_t> in_side(num_wires_);
+  const size_t middle = log_wires_ - 1;
+  for (size_t depth = 0; depth < middle; ++depth) {
+    const size_t size = num_wires_ >> depth;
+    const size_t half = size / 2;
+    parallel_for(
+        0, num_wires_ / size, std::max<size_t>(kGrainSize / size, 1),
+        [&](int64_t begin, int64_t end) {
+          for (int64_t b = begin; b < end; ++b) {
+            const size_t base = b * size;
+            size_t* p = cur.data() + base;
+            size_t* q = inv.data() + base;
+            int8_t* out = out_side.data() + base;
+            int8_t* in = in_side.data() + base;
+            for (size_t o = 0; o < size; ++o) {
+              q[p[o]] = o;
+              out[o] = -1;
+            }
+            for (size_t start = 0; start < size; start += 2) {
+              // output o comes from the top half, so does its input, and
+              // the sibling of that input goes through the bottom one,
+              // until the loop closes.
+              size_t o = start;
+              while (out[o] < 0) {
+                out[o] = 0;
+                out[o ^ 1] = 1;
+                const size_t i = p[o ^ 1];
+                in[i] = 1;
+                in[i ^ 1] = 0;
+                o = q[i ^ 1];
+              }
+            }
+            for (size_t o = 0; o < size; ++o) {
+              next[base + out[o] * half + o / 2] = p[o] / 2;
+            }
+          }
+        });
+    // switch j of a block swaps if wire 2j of the block is of the bottom
+    // half, set by words so that threads never share one.
+    SetBits(absl::MakeSpan(in_side), &bits[depth]);
+    SetBits(absl::MakeSpan(out_side), &bits[num_layers_ - 1 - depth]);
+    std::swap(cur, next);
+  }
+  // blocks of 2 wires swap if wire 0 takes input 1.
+  for (size_t i = 0; i < num_wires_; i += 2) {
+    in_side[i] = cur[i] == 1;
+  }
+  SetBits(absl::MakeSpan(in_side), &bits[middle]);
+  return bits;
+}
+
+}  // namespace yasl
@@ -0,0 +1,89 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/bit_vector.h"
+#include "yasl/utils/parallel.h"
+
+namespace yasl {
+
+// A Benes network of N = 2^k wires, the size rounded up to a power of 2,
+// of 2k - 1 layers of N / 2 switches, which realizes any permutation of the
+// wires by the control bits of its switches.
+//
+// The network is recursive: at depth d the wires are split into 2^d blocks
+// of s = N / 2^d wires, each one a subnetwork. Layer d < k - 1 is the input
+// layer of depth d, its switch j of a block takes wires 2j and 2j + 1 of
+// the block to wire j of its top half and wire j of its bottom half. Layer
+// k - 1 swaps pairs of wires in place, and layer 2k - 2 - d is the output
+// layer of depth d, the mirror of the input one. So that switches of a
+// layer are independent, and a layer is evaluated in one go by all of its
+// switches.
+class BenesNetwork {
+ public:
+  // wires of a switch, out0 and out1 take in0 and in1, or in1 and in0 if its
+  // control bit is set.
+  struct Switch {
+    size_t in0;
+    size_t in1;
+    size_t out0;
+    size_t out1;
+  };
+
+  // a network of at least n wires.
+  explicit BenesNetwork(size_t n);
+
+  size_t NumWires() const { return num_wires_; }
+  size_t NumLayers() const { return num_layers_; }
+  size_t NumSwitchesPerLayer() const { return num_wires_ / 2; }
+
+  Switch GetSwitch(size_t layer, size_t index) const;
+
+  // control bits of the layers, bit j of layer l for its switch j, so that
+  // wire i of the output carries wire perm[i] of the input. perm of less
+  // than N wires is extended by the identity.
+  std::vector<BitVector> Route(absl::Span<const size_t> perm) const;
+
+  // evaluates layer `layer` in the clear, out[out0], out[out1] of each switch
+  // from in[in0], in[in1].
+  template <typename T>
+  void Apply(size_t layer, const BitVector& bits, absl::Span<const T> in,
+             absl::Span<T> out) const {
+    parallel_for(0, NumSwitchesPerLayer(), kGrainSize,
+                 [&](int64_t begin, int64_t end) {
+                   for (int64_t j = begin; j < end; ++j) {
+                     const auto w = GetSwitch(layer, j);
+                     const bool swap = bits[j];
+                     out[w.out0] = in[swap ? w.in1 : w.in0];
+                     out[w.out1] = in[swap ? w.in0 : w.in1];
+                   }
+                 });
+  }
+
+  // switches of a parallel_for chunk.
+  static constexpr int64_t kGrainSize = 1 << 14;
+
+ private:
+  size_t num_wires_;
+  size_t log_wires_;
+  size_t num_layers_;
+};
+
+}  // namespace yasl
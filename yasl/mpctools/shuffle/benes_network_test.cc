@@ -0,0 +1,97 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/shuffle/benes_network.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl {
+namespace {
+
+std::vector<size_t> Evaluate(const BenesNetwork& network,
+                             const std::vector<BitVector>& bits) {
+  std::vector<size_t> wires(network.NumWires());
+  std::iota(wires.begin(), wires.end(), 0);
+  std::vector<size_t> next(network.NumWires());
+  for (size_t layer = 0; layer < network.NumLayers(); ++layer) {
+    network.Apply<size_t>(layer, bits[layer], wires, absl::MakeSpan(next));
+    std::swap(wires, next);
+  }
+  return wires;
+}
+
+class BenesNetworkTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(BenesNetworkTest, RoutesRandomPermutations) {
+  const size_t n = GetParam();
+  BenesNetwork network(n);
+  EXPECT_GE(network.NumWires(), n);
+  EXPECT_LT(network.NumWires(), 2 * std::max<size_t>(n, 1));
+
+  std::mt19937_64 rng(n);
+  for (int round = 0; round < 3; ++round) {
+    std::vector<size_t> perm(n);
+    std::iota(perm.begin(), perm.end(), 0);
+    std::shuffle(perm.begin(), perm.end(), rng);
+
+    const auto bits = network.Route(perm);
+    ASSERT_EQ(bits.size(), network.NumLayers());
+    const auto out = Evaluate(network, bits);
+    for (size_t i = 0; i < network.NumWires(); ++i) {
+      // padding wires stay in place.
+      EXPECT_EQ(out[i], i < n ? perm[i] : i) << "wire " << i;
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, BenesNetworkTest,
+                         testing::Values(0, 1, 2, 3, 4, 7, 8, 100, 128, 1000,
+                                         (1 << 16) + 3));
+
+TEST(BenesNetworkEdgeTest, SwitchesCoverAllWires) {
+  BenesNetwork network(64);
+  EXPECT_EQ(network.NumLayers(), 11);
+  for (size_t layer = 0; layer < network.NumLayers(); ++layer) {
+    std::vector<int> ins(64);
+    std::vector<int> outs(64);
+    for (size_t j = 0; j < network.NumSwitchesPerLayer(); ++j) {
+      const auto w = network.GetSwitch(layer, j);
+      ins[w.in0]++;
+      ins[w.in1]++;
+      outs[w.out0]++;
+      outs[w.out1]++;
+    }
+    EXPECT_EQ(ins, std::vector<int>(64, 1));
+    EXPECT_EQ(outs, std::vector<int>(64, 1));
+  }
+}
+
+TEST(BenesNetworkEdgeTest, NotAPermutation) {
+  BenesNetwork network(4);
+  std::vector<size_t> dup = {0, 1, 1, 3};
+  std::vector<size_t> out_of_range = {0, 1, 2, 4};
+  EXPECT_THROW(network.Route(dup), EnforceNotMet);
+  EXPECT_THROW(network.Route(out_of_range), EnforceNotMet);
+  EXPECT_THROW(network.Route(std::vector<size_t>(5)), EnforceNotMet);
+}
+
+}  // namespace
+}  // namespace yasl
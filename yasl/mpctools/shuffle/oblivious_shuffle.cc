@@ -0,0 +1,205 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/shuffle/oblivious_shuffle.h"
+
+#include <array>
+#include <cstring>
+#include <utility>
+
+#include "yasl/base/buffer.h"
+#include "yasl/base/exception.h"
+#include "yasl/crypto/crhash.h"
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/mpctools/ot/iknp_ot_extension.h"
+#include "yasl/mpctools/shuffle/benes_network.h"
+#include "yasl/utils/parallel.h"
+#include "yasl/utils/rand.h"
+
+namespace yasl {
+namespace {
+
+// the ot message of a switch, the masks of its two outputs.
+using SwitchMsg = std::array<uint128_t, 2>;
+
+// base ots of a layer of a run, so that IKNP prgs never repeat across
+// layers nor runs. The sender picks the nonce of a run.
+BaseRecvOptions LayerBaseOptions(const BaseRecvOptions& base, uint64_t nonce,
+                                 uint64_t layer) {
+  BaseRecvOptions derived;
+  derived.choices = base.choices;
+  derived.blocks.resize(base.blocks.size());
+  TccrHash(base.blocks,
+           std::vector<uint128_t>(base.blocks.size(),
+                                  MakeUint128(nonce, layer)),
+           absl::MakeSpan(derived.blocks));
+  return derived;
+}
+
+BaseSendOptions LayerBaseOptions(const BaseSendOptions& base, uint64_t nonce,
+                                 uint64_t layer) {
+  const uint128_t tweak = MakeUint128(nonce, layer);
+  BaseSendOptions derived;
+  derived.blocks.resize(base.blocks.size());
+  for (size_t i = 0; i < base.blocks.size(); ++i) {
+    derived.blocks[i] = {TccrHash(base.blocks[i][0], tweak),
+                         TccrHash(base.blocks[i][1], tweak)};
+  }
+  return derived;
+}
+
+// y[i] = x[perm[i]].
+std::vector<uint128_t> Permute(absl::Span<const size_t> perm,
+                               absl::Span<const uint128_t> x) {
+  std::vector<uint128_t> y(perm.size());
+  parallel_for(0, perm.size(), BenesNetwork::kGrainSize,
+               [&](int64_t begin, int64_t end) {
+                 for (int64_t i = begin; i < end; ++i) {
+                   y[i] = x[perm[i]];
+                 }
+               });
+  return y;
+}
+
+std::vector<size_t> RandomPermutation(size_t n) {
+  std::vector<size_t> perm(n);
+  for (size_t i = 0; i < n; ++i) {
+    perm[i] = i;
+  }
+  // Fisher-Yates, a 128 bits draw makes the modulo bias negligible.
+  PseudoRandomGenerator<uint128_t> prg(RandSeed());
+  for (size_t i = n; i > 1; --i) {
+    std::swap(perm[i - 1], perm[static_cast<size_t>(prg() % i)]);
+  }
+  return perm;
+}
+
+}  // namespace
+
+std::vector<uint128_t> OblivPermuteRecv(
+    const std::shared_ptr<link::Context>& ctx,
+    const BaseSendOptions& base_options, absl::Span<const size_t> perm) {
+  const BenesNetwork network(perm.size());
+  const auto bits = network.Route(perm);
+  const size_t num_wires = network.NumWires();
+  const size_t num_switches = network.NumSwitchesPerLayer();
+
+  // the nonce of the run, then x ^ r of the input wires.
+  auto buf = ctx->Recv(ctx->NextRank(), "SHUFFLE:INPUT");
+  YASL_ENFORCE(static_cast<size_t>(buf.size()) ==
+                   sizeof(uint64_t) + num_wires * sizeof(uint128_t),
+               "unexpected input size={}, wires={}", buf.size(), num_wires);
+  uint64_t nonce;
+  std::memcpy(&nonce, buf.data(), sizeof(nonce));
+  std::vector<uint128_t> wires(num_wires);
+  std::memcpy(wires.data(), buf.data<uint8_t>() + sizeof(nonce),
+              num_wires * sizeof(uint128_t));
+
+  std::vector<uint128_t> next(num_wires);
+  std::vector<SwitchMsg> msgs(num_switches);
+  for (size_t layer = 0; layer < network.NumLayers(); ++layer) {
+    IknpOtRecv(ctx, LayerBaseOptions(base_options, nonce, layer),
+               bits[layer].words(), sizeof(SwitchMsg),
+               absl::MakeSpan(reinterpret_cast<uint8_t*>(msgs.data()),
+                              num_switches * sizeof(SwitchMsg)));
+    parallel_for(0, num_switches, BenesNetwork::kGrainSize,
+                 [&](int64_t begin, int64_t end) {
+                   for (int64_t j = begin; j < end; ++j) {
+                     const auto w = network.GetSwitch(layer, j);
+                     const bool swap = bits[layer][j];
+                     next[w.out0] = wires[swap ? w.in1 : w.in0] ^ msgs[j][0];
+                     next[w.out1] = wires[swap ? w.in0 : w.in1] ^ msgs[j][1];
+                   }
+                 });
+    std::swap(wires, next);
+  }
+  wires.resize(perm.size());
+  return wires;
+}
+
+std::vector<uint128_t> OblivPermuteSend(
+    const std::shared_ptr<link::Context>& ctx,
+    const BaseRecvOptions& base_options, absl::Span<const uint128_t> x) {
+  const BenesNetwork network(x.size());
+  const size_t num_wires = network.NumWires();
+  const size_t num_switches = network.NumSwitchesPerLayer();
+
+  PseudoRandomGenerator<uint128_t> prg(RandSeed());
+  const auto nonce = static_cast<uint64_t>(prg());
+  std::vector<uint128_t> masks(num_wires);
+  prg.Fill(absl::MakeSpan(masks));
+  {
+    // padding wires carry zeros.
+    Buffer buf(sizeof(nonce) + num_wires * sizeof(uint128_t));
+    std::memcpy(buf.data(), &nonce, sizeof(nonce));
+    std::vector<uint128_t> input(masks);
+    for (size_t i = 0; i < x.size(); ++i) {
+      input[i] ^= x[i];
+    }
+    std::memcpy(buf.data<uint8_t>() + sizeof(nonce), input.data(),
+                num_wires * sizeof(uint128_t));
+    ctx->SendAsync(ctx->NextRank(), std::move(buf), "SHUFFLE:INPUT");
+  }
+
+  std::vector<uint128_t> next(num_wires);
+  std::vector<SwitchMsg> msgs0(num_switches);
+  std::vector<SwitchMsg> msgs1(num_switches);
+  for (size_t layer = 0; layer < network.NumLayers(); ++layer) {
+    prg.Fill(absl::MakeSpan(next));
+    parallel_for(0, num_switches, BenesNetwork::kGrainSize,
+                 [&](int64_t begin, int64_t end) {
+                   for (int64_t j = begin; j < end; ++j) {
+                     const auto w = network.GetSwitch(layer, j);
+                     msgs0[j] = {masks[w.in0] ^ next[w.out0],
+                                 masks[w.in1] ^ next[w.out1]};
+                     msgs1[j] = {masks[w.in1] ^ next[w.out0],
+                                 masks[w.in0] ^ next[w.out1]};
+                   }
+                 });
+    const auto as_bytes = [&](const std::vector<SwitchMsg>& msgs) {
+      return absl::MakeConstSpan(reinterpret_cast<const uint8_t*>(msgs.data()),
+                                 num_switches * sizeof(SwitchMsg));
+    };
+    IknpOtSend(ctx, LayerBaseOptions(base_options, nonce, layer),
+               sizeof(SwitchMsg), as_bytes(msgs0), as_bytes(msgs1));
+    std::swap(masks, next);
+  }
+  masks.resize(x.size());
+  return masks;
+}
+
+std::vector<uint128_t> OblivShuffle(const std::shared_ptr<link::Context>& ctx,
+                                    const BaseRecvOptions& send_base,
+                                    const BaseSendOptions& recv_base,
+                                    absl::Span<const uint128_t> share) {
+  const auto perm = RandomPermutation(share.size());
+  // of the first permutation, by rank 0, then of the second by rank 1.
+  if (ctx->Rank() == 0) {
+    auto mine = OblivPermuteRecv(ctx, recv_base, perm);
+    const auto permuted = Permute(perm, share);
+    for (size_t i = 0; i < mine.size(); ++i) {
+      mine[i] ^= permuted[i];
+    }
+    return OblivPermuteSend(ctx, send_base, mine);
+  }
+  const auto mine = OblivPermuteSend(ctx, send_base, share);
+  auto out = OblivPermuteRecv(ctx, recv_base, perm);
+  const auto permuted = Permute(perm, mine);
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i] ^= permuted[i];
+  }
+  return out;
+}
+
+}  // namespace yasl
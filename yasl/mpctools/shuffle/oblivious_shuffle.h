@@ -0,0 +1,64 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/int128.h"
+#include "yasl/link/link.h"
+#include "yasl/mpctools/ot/options.h"
+
+namespace yasl {
+
+// Oblivious switching network, the permutation of Mohassel and Sadeghian,
+// "How to Hide Circuits in MPC", Section 5: the receiver holds a
+// permutation perm and the sender a vector x, they end with xor shares of
+// y, y[i] = x[perm[i]], and learn nothing else but the size.
+//
+// The receiver programs a BenesNetwork by perm. The sender masks each wire
+// of the network, so that the receiver only sees x ^ r on a wire, and gets
+// (r[in0] ^ r'[out0], r[in1] ^ r'[out1]), or the pair of the swapped inputs,
+// for each switch by a chosen message IKNP ot of its control bit. All
+// switches of a layer are evaluated by one batch of ots, so one round trip
+// per layer, and the local work of a layer runs across parallel_for. The
+// masks of the output wires are the share of the sender.
+//
+// Sizes which are not a power of 2 are padded by the identity, at the cost
+// of up to twice the switches.
+std::vector<uint128_t> OblivPermuteRecv(
+    const std::shared_ptr<link::Context>& ctx,
+    const BaseSendOptions& base_options, absl::Span<const size_t> perm);
+
+std::vector<uint128_t> OblivPermuteSend(
+    const std::shared_ptr<link::Context>& ctx,
+    const BaseRecvOptions& base_options, absl::Span<const uint128_t> x);
+
+// Secret shared shuffle, of Chase, Ghosh and Poburinnaya, "Secret Shared
+// Shuffle": x is xor shared between the parties, each one picks a random
+// permutation and permutes the shares by an OblivPermute of its own, so
+// that the parties end with shares of x shuffled by a permutation neither
+// of them knows. Rank 0 permutes first. `send_base` are the base ots of
+// this party as the ot sender, of which peer holds the `recv_base`, and
+// vice versa.
+std::vector<uint128_t> OblivShuffle(const std::shared_ptr<link::Context>& ctx,
+                                    const BaseRecvOptions& send_base,
+                                    const BaseSendOptions& recv_base,
+                                    absl::Span<const uint128_t> share);
+
+}  // namespace yasl
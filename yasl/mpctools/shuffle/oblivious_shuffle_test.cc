@@ -0,0 +1,121 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/shuffle/oblivious_shuffle.h"
+
+#include <algorithm>
+#include <future>
+#include <numeric>
+#include <random>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/link/test_util.h"
+
+namespace yasl {
+namespace {
+
+std::pair<BaseSendOptions, BaseRecvOptions> MakeBaseOptions(size_t num) {
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  recv_opts.choices = CreateRandomChoices(num);
+  std::random_device rd;
+  PseudoRandomGenerator<uint128_t> gen(rd());
+  for (size_t i = 0; i < num; ++i) {
+    send_opts.blocks.push_back({gen(), gen()});
+    recv_opts.blocks.push_back(send_opts.blocks[i][recv_opts.choices[i]]);
+  }
+  return {std::move(send_opts), std::move(recv_opts)};
+}
+
+class OblivShuffleTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(OblivShuffleTest, PermuteWorks) {
+  // GIVEN
+  const size_t n = GetParam();
+  auto contexts = link::test::SetupWorld(2);
+  auto [send_opts, recv_opts] = MakeBaseOptions(128);
+  PseudoRandomGenerator<uint128_t> prg;
+  std::vector<uint128_t> x(n);
+  prg.Fill(absl::MakeSpan(x));
+  std::vector<size_t> perm(n);
+  std::iota(perm.begin(), perm.end(), 0);
+  std::shuffle(perm.begin(), perm.end(), std::mt19937_64(n));
+
+  // WHEN
+  auto sender = std::async(
+      [&] { return OblivPermuteSend(contexts[0], recv_opts, x); });
+  auto receiver = std::async(
+      [&] { return OblivPermuteRecv(contexts[1], send_opts, perm); });
+  const auto share0 = sender.get();
+  const auto share1 = receiver.get();
+
+  // THEN
+  ASSERT_EQ(share0.size(), n);
+  ASSERT_EQ(share1.size(), n);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(share0[i] ^ share1[i], x[perm[i]]) << "i " << i;
+    if (n > 1) {
+      // shares are masked.
+      EXPECT_NE(share1[i], x[perm[i]]);
+    }
+  }
+}
+
+TEST_P(OblivShuffleTest, ShuffleWorks) {
+  // GIVEN
+  const size_t n = GetParam();
+  auto contexts = link::test::SetupWorld(2);
+  // base ots of each party as the sender.
+  auto [send_opts0, recv_opts0] = MakeBaseOptions(128);
+  auto [send_opts1, recv_opts1] = MakeBaseOptions(128);
+  PseudoRandomGenerator<uint128_t> prg;
+  std::vector<uint128_t> x(n);
+  std::vector<uint128_t> x0(n);
+  std::vector<uint128_t> x1(n);
+  for (size_t i = 0; i < n; ++i) {
+    x[i] = i;
+    x0[i] = prg();
+    x1[i] = x0[i] ^ x[i];
+  }
+
+  // WHEN
+  auto party0 = std::async([&] {
+    return OblivShuffle(contexts[0], recv_opts0, send_opts1, x0);
+  });
+  auto party1 = std::async([&] {
+    return OblivShuffle(contexts[1], recv_opts1, send_opts0, x1);
+  });
+  const auto y0 = party0.get();
+  const auto y1 = party1.get();
+
+  // THEN a permutation of x.
+  ASSERT_EQ(y0.size(), n);
+  ASSERT_EQ(y1.size(), n);
+  std::vector<uint128_t> y(n);
+  for (size_t i = 0; i < n; ++i) {
+    y[i] = y0[i] ^ y1[i];
+  }
+  std::sort(y.begin(), y.end());
+  EXPECT_EQ(y, x);
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, OblivShuffleTest,
+                         testing::Values(0, 1, 2, 5, 128, 1000, 20000));
+
+}  // namespace
+}  // namespace yasl
@@ -0,0 +1,351 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/snapshot/snapshot_store.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+#include "zlib.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl {
+
+namespace {
+
+constexpr char kMagic[] = "YSNP";
+constexpr size_t kMagicSize = 4;
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 64;
+// sections start at multiples of it, so blocks of a mapping are aligned.
+constexpr size_t kAlignment = 64;
+constexpr size_t kNameSize = 32;
+// name, type, crc, offset, size, count.
+constexpr size_t kEntrySize = kNameSize + 4 + 4 + 8 + 8 + 8;
+// table offset, sections, table crc, magic.
+constexpr size_t kFooterSize = 8 + 8 + 4 + kMagicSize;
+
+constexpr uint32_t kBaseSend = 1;
+constexpr uint32_t kBaseRecv = 2;
+constexpr uint32_t kBlocks = 3;
+constexpr uint32_t kDpfKeys = 4;
+
+uint32_t Crc32(uint32_t crc, const void* data, size_t size) {
+  // crc32 takes sizes of 32 bits.
+  const auto* p = static_cast<const Bytef*>(data);
+  while (size > 0) {
+    const auto n = static_cast<uInt>(std::min<size_t>(size, 1 << 30));
+    crc = crc32(crc, p, n);
+    p += n;
+    size -= n;
+  }
+  return crc;
+}
+
+template <class T>
+void Put(T v, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+// makes the contents of a file, or the entries of a dir, durable.
+void SyncPath(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    YASL_THROW_IO_ERROR("open {} failed, errno={}, error={}", path, errno,
+                        std::strerror(errno));
+  }
+  const int ret = ::fsync(fd);
+  const int err = errno;
+  ::close(fd);
+  if (ret != 0) {
+    YASL_THROW_IO_ERROR("fsync {} failed, errno={}, error={}", path, err,
+                        std::strerror(err));
+  }
+}
+
+template <class T>
+T Get(const uint8_t* data, size_t* pos) {
+  T v;
+  std::memcpy(&v, data + *pos, sizeof(T));
+  *pos += sizeof(T);
+  return v;
+}
+
+}  // namespace
+
+SnapshotWriter::SnapshotWriter(std::string path)
+    : path_(std::move(path)), tmp_path_(path_ + ".tmp") {
+  out_ = std::make_unique<io::FileOutputStream>(tmp_path_);
+  std::string header(kMagic, kMagicSize);
+  Put<uint32_t>(kVersion, &header);
+  header.resize(kHeaderSize, '\0');
+  out_->Write(header);
+  offset_ = kHeaderSize;
+}
+
+SnapshotWriter::~SnapshotWriter() {
+  if (!committed_) {
+    out_.reset();
+    std::error_code ec;
+    std::filesystem::remove(tmp_path_, ec);
+  }
+}
+
+void SnapshotWriter::BeginSection(const std::string& name, uint32_t type,
+                                  uint64_t count) {
+  YASL_ENFORCE(!committed_, "snapshot {} is committed", path_);
+  YASL_ENFORCE(!name.empty() && name.size() < kNameSize,
+               "invalid section name {}", name);
+  YASL_ENFORCE(names_.insert(name).second, "duplicated section {}", name);
+  const std::string padding((kAlignment - offset_ % kAlignment) % kAlignment,
+                            '\0');
+  out_->Write(padding);
+  offset_ += padding.size();
+  name_ = name;
+  type_ = type;
+  count_ = count;
+  begin_ = offset_;
+  crc_ = 0;
+}
+
+void SnapshotWriter::Append(const void* data, size_t size) {
+  out_->Write(data, size);
+  offset_ += size;
+  crc_ = Crc32(crc_, data, size);
+}
+
+void SnapshotWriter::EndSection() {
+  std::string name(kNameSize, '\0');
+  std::memcpy(name.data(), name_.data(), name_.size());
+  table_ += name;
+  Put<uint32_t>(type_, &table_);
+  Put<uint32_t>(crc_, &table_);
+  Put<uint64_t>(begin_, &table_);
+  Put<uint64_t>(offset_ - begin_, &table_);
+  Put<uint64_t>(count_, &table_);
+}
+
+void SnapshotWriter::PutBaseOptions(const std::string& name,
+                                    const BaseSendOptions& options) {
+  BeginSection(name, kBaseSend, options.blocks.size());
+  Append(options.blocks.data(),
+         options.blocks.size() * sizeof(options.blocks[0]));
+  EndSection();
+}
+
+void SnapshotWriter::PutBaseOptions(const std::string& name,
+                                    const BaseRecvOptions& options) {
+  YASL_ENFORCE(options.choices.size() == options.blocks.size(),
+               "choices {} != blocks {}", options.choices.size(),
+               options.blocks.size());
+  BeginSection(name, kBaseRecv, options.blocks.size());
+  Append(options.blocks.data(), options.blocks.size() * sizeof(uint128_t));
+  const auto words = options.choices.words();
+  Append(words.data(), words.size() * sizeof(uint128_t));
+  EndSection();
+}
+
+void SnapshotWriter::PutBlocks(const std::string& name,
+                               absl::Span<const uint128_t> blocks) {
+  BeginSection(name, kBlocks, blocks.size());
+  Append(blocks.data(), blocks.size() * sizeof(uint128_t));
+  EndSection();
+}
+
+void SnapshotWriter::PutDpfKeys(const std::string& name,
+                                absl::Span<const mpctools::DpfKey> keys) {
+  std::vector<Buffer> bufs;
+  bufs.reserve(keys.size());
+  std::vector<uint64_t> offsets(1, 0);
+  for (const auto& key : keys) {
+    bufs.push_back(key.SerializeCompact());
+    offsets.push_back(offsets.back() + bufs.back().size());
+  }
+  BeginSection(name, kDpfKeys, keys.size());
+  Append(offsets.data(), offsets.size() * sizeof(uint64_t));
+  for (const auto& buf : bufs) {
+    Append(buf.data(), buf.size());
+  }
+  EndSection();
+}
+
+void SnapshotWriter::Commit() {
+  YASL_ENFORCE(!committed_, "snapshot {} is committed", path_);
+  const uint64_t table_offset = offset_;
+  std::string footer;
+  Put<uint64_t>(table_offset, &footer);
+  Put<uint64_t>(names_.size(), &footer);
+  Put<uint32_t>(Crc32(0, table_.data(), table_.size()),
+                &footer);
+  footer.append(kMagic, kMagicSize);
+  out_->Write(table_);
+  out_->Write(footer);
+  out_->Close();
+  // a crash after the rename must not leave a snapshot of missing data, nor
+  // lose the rename.
+  SyncPath(tmp_path_);
+  std::filesystem::rename(tmp_path_, path_);
+  auto dir = std::filesystem::path(path_).parent_path();
+  SyncPath(dir.empty() ? "." : dir.string());
+  committed_ = true;
+}
+
+SnapshotReader::SnapshotReader(const std::string& path) : file_(path) {
+  const auto* data = reinterpret_cast<const uint8_t*>(file_.data());
+  const size_t size = file_.size();
+  YASL_ENFORCE(size >= kHeaderSize + kFooterSize &&
+                   std::memcmp(data, kMagic, kMagicSize) == 0 &&
+                   std::memcmp(data + size - kMagicSize, kMagic,
+                               kMagicSize) == 0,
+               "{} is not a snapshot", path);
+  size_t pos = kMagicSize;
+  const auto version = Get<uint32_t>(data, &pos);
+  YASL_ENFORCE(version == kVersion, "unsupported snapshot version {} of {}",
+               version, path);
+
+  pos = size - kFooterSize;
+  const auto table_offset = Get<uint64_t>(data, &pos);
+  const auto num_sections = Get<uint64_t>(data, &pos);
+  const auto table_crc = Get<uint32_t>(data, &pos);
+  // the table fills [table_offset, size - kFooterSize).
+  YASL_ENFORCE(table_offset >= kHeaderSize &&
+                   table_offset <= size - kFooterSize &&
+                   (size - kFooterSize - table_offset) % kEntrySize == 0 &&
+                   (size - kFooterSize - table_offset) / kEntrySize ==
+                       num_sections,
+               "corrupted snapshot table of {}", path);
+  YASL_ENFORCE(Crc32(0, data + table_offset,
+                     num_sections * kEntrySize) == table_crc,
+               "corrupted snapshot table of {}", path);
+
+  pos = table_offset;
+  for (uint64_t i = 0; i < num_sections; ++i) {
+    const auto* name = reinterpret_cast<const char*>(data + pos);
+    std::string key(name, strnlen(name, kNameSize));
+    pos += kNameSize;
+    Section section;
+    section.type = Get<uint32_t>(data, &pos);
+    section.crc = Get<uint32_t>(data, &pos);
+    const auto offset = Get<uint64_t>(data, &pos);
+    section.size = Get<uint64_t>(data, &pos);
+    section.count = Get<uint64_t>(data, &pos);
+    YASL_ENFORCE(offset % kAlignment == 0 && offset <= table_offset &&
+                     section.size <= table_offset - offset,
+                 "corrupted section {} of {}", key, path);
+    section.data = data + offset;
+    sections_.emplace(std::move(key), section);
+  }
+}
+
+bool SnapshotReader::Has(const std::string& name) const {
+  return sections_.count(name) > 0;
+}
+
+const SnapshotReader::Section& SnapshotReader::Find(
+    const std::string& name, uint32_t type) const {
+  auto it = sections_.find(name);
+  YASL_ENFORCE(it != sections_.end(), "no section {}", name);
+  YASL_ENFORCE(it->second.type == type, "section {} is of type {}, not {}",
+               name, it->second.type, type);
+  return it->second;
+}
+
+BaseSendOptions SnapshotReader::GetBaseSendOptions(
+    const std::string& name) const {
+  const auto& section = Find(name, kBaseSend);
+  BaseSendOptions options;
+  constexpr size_t kItemSize = sizeof(options.blocks[0]);
+  YASL_ENFORCE(section.size % kItemSize == 0 &&
+                   section.size / kItemSize == section.count,
+               "corrupted section {}", name);
+  options.blocks.resize(section.count);
+  std::memcpy(options.blocks.data(), section.data, section.size);
+  return options;
+}
+
+BaseRecvOptions SnapshotReader::GetBaseRecvOptions(
+    const std::string& name) const {
+  const auto& section = Find(name, kBaseRecv);
+  // blocks then choice words, each of a uint128_t.
+  YASL_ENFORCE(section.size % sizeof(uint128_t) == 0 &&
+                   section.count <= section.size / sizeof(uint128_t),
+               "corrupted section {}", name);
+  const size_t num_words = BitVector::NumWords(section.count);
+  YASL_ENFORCE(section.size / sizeof(uint128_t) == section.count + num_words,
+               "corrupted section {}", name);
+  BaseRecvOptions options;
+  options.blocks.resize(section.count);
+  std::memcpy(options.blocks.data(), section.data,
+              section.count * sizeof(uint128_t));
+  std::vector<uint128_t> words(num_words);
+  std::memcpy(words.data(), section.data + section.count * sizeof(uint128_t),
+              num_words * sizeof(uint128_t));
+  options.choices = BitVector(std::move(words), section.count);
+  return options;
+}
+
+absl::Span<const uint128_t> SnapshotReader::GetBlocks(
+    const std::string& name) const {
+  const auto& section = Find(name, kBlocks);
+  YASL_ENFORCE(section.size % sizeof(uint128_t) == 0 &&
+                   section.size / sizeof(uint128_t) == section.count,
+               "corrupted section {}", name);
+  return {reinterpret_cast<const uint128_t*>(section.data), section.count};
+}
+
+const SnapshotReader::Section& SnapshotReader::FindDpfKeys(
+    const std::string& name) const {
+  const auto& section = Find(name, kDpfKeys);
+  // count + 1 offsets then the keys.
+  YASL_ENFORCE(section.count < section.size / sizeof(uint64_t),
+               "corrupted section {}", name);
+  return section;
+}
+
+size_t SnapshotReader::NumDpfKeys(const std::string& name) const {
+  return FindDpfKeys(name).count;
+}
+
+mpctools::DpfKeyView SnapshotReader::GetDpfKey(const std::string& name,
+                                               size_t index) const {
+  const auto& section = FindDpfKeys(name);
+  YASL_ENFORCE(index < section.count, "key {} of {} keys", index,
+               section.count);
+  const size_t keys_offset = (section.count + 1) * sizeof(uint64_t);
+  size_t pos = index * sizeof(uint64_t);
+  const auto begin = Get<uint64_t>(section.data, &pos);
+  const auto end = Get<uint64_t>(section.data, &pos);
+  YASL_ENFORCE(begin <= end && end <= section.size - keys_offset,
+               "corrupted section {}", name);
+  return mpctools::DpfKeyView(
+      ByteContainerView(section.data + keys_offset + begin, end - begin));
+}
+
+void SnapshotReader::Verify() const {
+  for (const auto& [name, section] : sections_) {
+    YASL_ENFORCE(Crc32(0, section.data, section.size) ==
+                     section.crc,
+                 "crc mismatch of section {}", name);
+  }
+}
+
+}  // namespace yasl
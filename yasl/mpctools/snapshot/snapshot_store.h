@@ -0,0 +1,135 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/int128.h"
+#include "yasl/io/rw/mmapped_file.h"
+#include "yasl/io/stream/file_io.h"
+#include "yasl/mpctools/dpf/dpf.h"
+#include "yasl/mpctools/ot/options.h"
+
+namespace yasl {
+
+// Snapshots of offline material, so that a job restarted during its online
+// phase reloads base ots, extended ots and dpf keys instead of generating
+// them again. little endian:
+//
+//   "YSNP" u32 version, zeros up to 64 bytes
+//   sections, each one at a multiple of 64 bytes
+//   per section: char name[32], u32 type, u32 crc32, u64 offset, u64 size,
+//     u64 count
+//   u64 offset of the sections table, u64 sections, u32 crc32 of the table,
+//     "YSNP"
+//
+// A section is one of:
+//   base send options  count pairs of blocks.
+//   base recv options  count blocks, then the words of count choice bits.
+//   blocks             count blocks, e.g. COTs taken from a
+//                      CorrelatedOtPool and their choice bits. A pool with
+//                      a `dir` persists its own stock.
+//   dpf keys           count + 1 u64 offsets of the keys, relative to the
+//                      end of the offsets, then the keys in the compact
+//                      format of DpfKeyView.
+//
+// The writer streams sections to a temporary file and renames it once the
+// table is written, so that a crash never leaves half of a snapshot.
+class SnapshotWriter {
+ public:
+  explicit SnapshotWriter(std::string path);
+  // drops the snapshot unless it was committed.
+  ~SnapshotWriter();
+
+  SnapshotWriter(const SnapshotWriter&) = delete;
+  SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+  // names are unique, of at most 31 bytes.
+  void PutBaseOptions(const std::string& name, const BaseSendOptions& options);
+  void PutBaseOptions(const std::string& name, const BaseRecvOptions& options);
+  void PutBlocks(const std::string& name, absl::Span<const uint128_t> blocks);
+  void PutDpfKeys(const std::string& name,
+                  absl::Span<const mpctools::DpfKey> keys);
+
+  // writes the table and replaces the file at path.
+  void Commit();
+
+ private:
+  // pads to the next section, of `type` holding `count` items.
+  void BeginSection(const std::string& name, uint32_t type, uint64_t count);
+  void Append(const void* data, size_t size);
+  void EndSection();
+
+  const std::string path_;
+  const std::string tmp_path_;
+  std::unique_ptr<io::FileOutputStream> out_;
+  uint64_t offset_ = 0;
+  std::set<std::string> names_;
+  // entries of the sections, and the one being written.
+  std::string table_;
+  std::string name_;
+  uint32_t type_ = 0;
+  uint64_t count_ = 0;
+  uint64_t begin_ = 0;
+  uint32_t crc_ = 0;
+  bool committed_ = false;
+};
+
+// A snapshot mapped into memory. Opening it reads the table only, so takes
+// the same time whatever the size of the material, and blocks and dpf keys
+// are views of the mapping which must not outlive the reader. Sections are
+// checked against their crc32 by Verify only, which reads all of them.
+class SnapshotReader {
+ public:
+  explicit SnapshotReader(const std::string& path);
+
+  bool Has(const std::string& name) const;
+
+  // throws if a section is missing or of another type.
+  BaseSendOptions GetBaseSendOptions(const std::string& name) const;
+  BaseRecvOptions GetBaseRecvOptions(const std::string& name) const;
+  absl::Span<const uint128_t> GetBlocks(const std::string& name) const;
+  size_t NumDpfKeys(const std::string& name) const;
+  mpctools::DpfKeyView GetDpfKey(const std::string& name,
+                                 size_t index) const;
+
+  // throws on the first section whose crc32 does not match.
+  void Verify() const;
+
+ private:
+  struct Section {
+    uint32_t type;
+    uint32_t crc;
+    const uint8_t* data;
+    uint64_t size;
+    uint64_t count;
+  };
+
+  const Section& Find(const std::string& name, uint32_t type) const;
+  // Find() of a dpf keys section, whose offsets fit in it.
+  const Section& FindDpfKeys(const std::string& name) const;
+
+  io::MmappedFile file_;
+  std::map<std::string, Section> sections_;
+};
+
+}  // namespace yasl
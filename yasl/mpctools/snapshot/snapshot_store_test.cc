@@ -0,0 +1,221 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/mpctools/snapshot/snapshot_store.h"
+
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "zlib.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/io/stream/file_io.h"
+
+namespace yasl {
+namespace {
+
+class SnapshotStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = std::filesystem::temp_directory_path() /
+           ("snapshot_store_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir_);
+    path_ = (dir_ / "offline.snap").string();
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  std::filesystem::path dir_;
+  std::string path_;
+};
+
+TEST_F(SnapshotStoreTest, RoundTrip) {
+  // GIVEN
+  PseudoRandomGenerator<uint128_t> prg;
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  recv_opts.choices = CreateRandomChoices(128);
+  for (size_t i = 0; i < 128; ++i) {
+    send_opts.blocks.push_back({prg(), prg()});
+    recv_opts.blocks.push_back(send_opts.blocks[i][recv_opts.choices[i]]);
+  }
+  std::vector<uint128_t> cots(1000);
+  prg.Fill(absl::MakeSpan(cots));
+  mpctools::DpfContext dpf(16, 64);
+  std::vector<mpctools::DpfKey> keys;
+  for (uint64_t i = 0; i < 5; ++i) {
+    auto [k0, k1] = dpf.Gen(i * 100, i + 1, prg(), prg());
+    keys.push_back(std::move(k0));
+    keys.push_back(std::move(k1));
+  }
+
+  // WHEN
+  {
+    SnapshotWriter writer(path_);
+    writer.PutBaseOptions("base_send", send_opts);
+    writer.PutBaseOptions("base_recv", recv_opts);
+    writer.PutBlocks("cots", cots);
+    writer.PutBlocks("empty", {});
+    writer.PutDpfKeys("dpf", keys);
+    writer.Commit();
+  }
+  SnapshotReader reader(path_);
+  reader.Verify();
+
+  // THEN
+  EXPECT_TRUE(reader.Has("cots"));
+  EXPECT_FALSE(reader.Has("none"));
+  EXPECT_EQ(reader.GetBaseSendOptions("base_send").blocks, send_opts.blocks);
+  const auto recv = reader.GetBaseRecvOptions("base_recv");
+  EXPECT_EQ(recv.blocks, recv_opts.blocks);
+  EXPECT_EQ(recv.choices, recv_opts.choices);
+  const auto blocks = reader.GetBlocks("cots");
+  EXPECT_EQ(std::vector<uint128_t>(blocks.begin(), blocks.end()), cots);
+  // zero copy, blocks of the mapping are aligned.
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(blocks.data()) % alignof(uint128_t),
+            0);
+  EXPECT_TRUE(reader.GetBlocks("empty").empty());
+  ASSERT_EQ(reader.NumDpfKeys("dpf"), keys.size());
+  for (size_t i = 0; i < keys.size(); i += 2) {
+    const uint64_t alpha = i / 2 * 100;
+    auto v0 = reader.GetDpfKey("dpf", i);
+    auto v1 = reader.GetDpfKey("dpf", i + 1);
+    EXPECT_EQ(v0.GetSeed(), keys[i].GetSeed());
+    // shares of 64 bits.
+    EXPECT_EQ(uint64_t(dpf.Eval(v0, alpha) + dpf.Eval(v1, alpha)), i / 2 + 1);
+    EXPECT_EQ(uint64_t(dpf.Eval(v0, alpha + 1) + dpf.Eval(v1, alpha + 1)),
+              0);
+  }
+}
+
+TEST_F(SnapshotStoreTest, UncommittedIsDropped) {
+  {
+    SnapshotWriter writer(path_);
+    writer.PutBlocks("cots", std::vector<uint128_t>(10));
+  }
+  EXPECT_TRUE(std::filesystem::is_empty(dir_));
+}
+
+TEST_F(SnapshotStoreTest, BadAccess) {
+  SnapshotWriter writer(path_);
+  writer.PutBlocks("cots", std::vector<uint128_t>(10));
+  EXPECT_THROW(writer.PutBlocks("cots", {}), EnforceNotMet);
+  EXPECT_THROW(writer.PutBlocks(std::string(32, 'a'), {}), EnforceNotMet);
+  writer.Commit();
+
+  SnapshotReader reader(path_);
+  EXPECT_THROW(reader.GetBlocks("none"), EnforceNotMet);
+  EXPECT_THROW(reader.GetBaseSendOptions("cots"), EnforceNotMet);
+  EXPECT_THROW(reader.GetDpfKey("cots", 0), EnforceNotMet);
+}
+
+TEST_F(SnapshotStoreTest, DetectsCorruption) {
+  {
+    SnapshotWriter writer(path_);
+    writer.PutBlocks("cots", std::vector<uint128_t>(10, 7));
+    writer.Commit();
+  }
+  std::string data(std::filesystem::file_size(path_), '\0');
+  {
+    io::FileInputStream in(path_);
+    in.Read(data.data(), data.size());
+  }
+  const auto rewrite = [&](const std::string& bytes) {
+    io::FileOutputStream out(path_);
+    out.Write(bytes);
+    out.Close();
+  };
+
+  // a flipped bit of a section is found by Verify.
+  auto flipped = data;
+  flipped[64] ^= 1;
+  rewrite(flipped);
+  {
+    SnapshotReader reader(path_);
+    EXPECT_THROW(reader.Verify(), EnforceNotMet);
+  }
+  // one of the table, or a truncated file, on open.
+  flipped = data;
+  flipped[data.size() - 40] ^= 1;
+  rewrite(flipped);
+  EXPECT_THROW(SnapshotReader{path_}, EnforceNotMet);
+  rewrite(data.substr(0, data.size() - 1));
+  EXPECT_THROW(SnapshotReader{path_}, EnforceNotMet);
+}
+
+TEST_F(SnapshotStoreTest, RejectsForgedTable) {
+  mpctools::DpfContext dpf(16, 64);
+  std::vector<mpctools::DpfKey> keys(2);
+  std::tie(keys[0], keys[1]) = dpf.Gen(1, 1, 2, 3);
+  {
+    SnapshotWriter writer(path_);
+    writer.PutBlocks("cots", std::vector<uint128_t>(10, 7));
+    writer.PutDpfKeys("dpf", keys);
+    writer.Commit();
+  }
+  std::string data(std::filesystem::file_size(path_), '\0');
+  {
+    io::FileInputStream in(path_);
+    in.Read(data.data(), data.size());
+  }
+  const auto rewrite = [&](const std::string& bytes) {
+    io::FileOutputStream out(path_);
+    out.Write(bytes);
+    out.Close();
+  };
+  // table offset, sections, table crc, magic.
+  const size_t footer = data.size() - 24;
+  uint64_t table_offset;
+  std::memcpy(&table_offset, &data[footer], sizeof(table_offset));
+  // sets the count of section i, the last field of its 64 bytes entry, with
+  // a valid table crc.
+  const auto forge_count = [&](size_t i, uint64_t count) {
+    auto forged = data;
+    std::memcpy(&forged[table_offset + i * 64 + 56], &count, sizeof(count));
+    const uint32_t crc =
+        crc32(0, reinterpret_cast<const Bytef*>(&forged[table_offset]),
+              footer - table_offset);
+    std::memcpy(&forged[footer + 16], &crc, sizeof(crc));
+    rewrite(forged);
+  };
+
+  // sizes computed from the counts wrap around to those of the sections.
+  forge_count(0, (1ULL << 60) + 10);
+  {
+    SnapshotReader reader(path_);
+    EXPECT_THROW(reader.GetBlocks("cots"), EnforceNotMet);
+  }
+  forge_count(1, (1ULL << 61) - 1);
+  {
+    SnapshotReader reader(path_);
+    EXPECT_THROW(reader.NumDpfKeys("dpf"), EnforceNotMet);
+    EXPECT_THROW(reader.GetDpfKey("dpf", 0), EnforceNotMet);
+  }
+  // so does the table size of a forged number of sections.
+  auto forged = data;
+  const uint64_t num_sections = (1ULL << 58) + 2;
+  std::memcpy(&forged[footer + 8], &num_sections, sizeof(num_sections));
+  rewrite(forged);
+  EXPECT_THROW(SnapshotReader{path_}, EnforceNotMet);
+}
+
+}  // namespace
+}  // namespace yasl
@@ -0,0 +1,109 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Runs the standard scenarios and checks them against baselines, exits 1 on
+// a regression.
+//
+//   bazel run -c opt //yasl/perf:perf_suite_main --
+//       --baselines=$PWD/yasl/perf/baselines.json --output=/tmp/perf.json
+//
+// Baselines of a new machine are recorded by --update_baselines.
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "gflags/gflags.h"
+#include "spdlog/spdlog.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/perf/perf_suite.h"
+#include "yasl/perf/scenarios.h"
+
+DEFINE_string(baselines, "", "json baselines, none if empty");
+DEFINE_bool(update_baselines, false,
+            "records the medians of this run into --baselines");
+DEFINE_string(output, "", "json report, stdout if empty");
+DEFINE_string(filter, "", "runs scenarios whose name contains it");
+DEFINE_double(tolerance, 0.1, "relative slowdown allowed over a baseline");
+DEFINE_uint64(repetitions, 3, "runs of each scenario");
+DEFINE_uint64(scale_shift, 0, "divides the sizes by 2^scale_shift");
+DEFINE_string(work_dir, "/tmp", "scratch files of the scenarios");
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path);
+  YASL_ENFORCE(in.is_open(), "can not open {}", path);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+void WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream out(path, std::ios::trunc);
+  YASL_ENFORCE(out.is_open(), "can not open {}", path);
+  out << content;
+  YASL_ENFORCE(out.good(), "write {} failed", path);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  yasl::perf::PerfOptions options;
+  options.repetitions = FLAGS_repetitions;
+  options.scale_shift = FLAGS_scale_shift;
+  options.work_dir = FLAGS_work_dir;
+
+  std::map<std::string, double> baselines;
+  if (!FLAGS_baselines.empty() &&
+      (!FLAGS_update_baselines || std::ifstream(FLAGS_baselines).good())) {
+    baselines = yasl::perf::ParseBaselines(ReadFile(FLAGS_baselines));
+  }
+
+  const auto results = yasl::perf::RunScenarios(
+      yasl::perf::StandardScenarios(options), options, FLAGS_filter);
+  const auto checks =
+      yasl::perf::CheckBaselines(results, baselines, FLAGS_tolerance);
+
+  const auto report =
+      yasl::perf::ReportToJson(results, checks, FLAGS_tolerance);
+  if (FLAGS_output.empty()) {
+    std::cout << report;
+  } else {
+    WriteFile(FLAGS_output, report);
+  }
+  if (FLAGS_update_baselines) {
+    YASL_ENFORCE(!FLAGS_baselines.empty(), "update_baselines needs baselines");
+    // scenarios out of the filter keep their baselines.
+    for (const auto& result : results) {
+      baselines[result.name] = result.MedianSeconds();
+    }
+    WriteFile(FLAGS_baselines, yasl::perf::BaselinesToJson(baselines));
+    return 0;
+  }
+
+  int ret = 0;
+  for (const auto& check : checks) {
+    if (check.status == yasl::perf::PerfCheck::kRegressed) {
+      SPDLOG_ERROR("perf {} regressed: {:.3f}s over baseline {:.3f}s",
+                   check.name, check.seconds, *check.baseline);
+      ret = 1;
+    }
+  }
+  return ret;
+}
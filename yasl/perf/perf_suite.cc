@@ -0,0 +1,231 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/perf/perf_suite.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "absl/strings/numbers.h"
+#include "fmt/format.h"
+#include "spdlog/spdlog.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl::perf {
+
+namespace {
+
+// parser of a flat json object of numbers, the whole format of baselines.
+class BaselineParser {
+ public:
+  explicit BaselineParser(std::string_view json) : json_(json) {}
+
+  std::map<std::string, double> Parse() {
+    std::map<std::string, double> baselines;
+    Expect('{');
+    if (!TryConsume('}')) {
+      do {
+        std::string name = ParseString();
+        Expect(':');
+        const double seconds = ParseNumber();
+        if (!baselines.emplace(std::move(name), seconds).second) {
+          YASL_THROW_INVALID_FORMAT("duplicated baseline at {}", pos_);
+        }
+      } while (TryConsume(','));
+      Expect('}');
+    }
+    SkipSpaces();
+    if (pos_ != json_.size()) {
+      YASL_THROW_INVALID_FORMAT("trailing chars of baselines at {}", pos_);
+    }
+    return baselines;
+  }
+
+ private:
+  void SkipSpaces() {
+    while (pos_ < json_.size() &&
+           std::isspace(static_cast<unsigned char>(json_[pos_]))) {
+      pos_++;
+    }
+  }
+
+  bool TryConsume(char c) {
+    SkipSpaces();
+    if (pos_ < json_.size() && json_[pos_] == c) {
+      pos_++;
+      return true;
+    }
+    return false;
+  }
+
+  void Expect(char c) {
+    if (!TryConsume(c)) {
+      YASL_THROW_INVALID_FORMAT("expect '{}' of baselines at {}", c, pos_);
+    }
+  }
+
+  std::string ParseString() {
+    Expect('"');
+    std::string s;
+    while (pos_ < json_.size() && json_[pos_] != '"') {
+      if (json_[pos_] == '\\' && pos_ + 1 < json_.size()) {
+        pos_++;
+      }
+      s.push_back(json_[pos_++]);
+    }
+    Expect('"');
+    return s;
+  }
+
+  double ParseNumber() {
+    SkipSpaces();
+    const size_t begin = pos_;
+    while (pos_ < json_.size() && json_[pos_] != ',' && json_[pos_] != '}' &&
+           !std::isspace(static_cast<unsigned char>(json_[pos_]))) {
+      pos_++;
+    }
+    double value;
+    if (!absl::SimpleAtod(absl::string_view(json_.data() + begin,
+                                            pos_ - begin),
+                          &value) ||
+        !(value > 0)) {
+      YASL_THROW_INVALID_FORMAT("expect seconds of baselines at {}", begin);
+    }
+    return value;
+  }
+
+  std::string_view json_;
+  size_t pos_ = 0;
+};
+
+}  // namespace
+
+double PerfResult::MedianSeconds() const {
+  YASL_ENFORCE(!seconds.empty());
+  std::vector<double> sorted = seconds;
+  std::sort(sorted.begin(), sorted.end());
+  const size_t mid = sorted.size() / 2;
+  return sorted.size() % 2 == 1 ? sorted[mid]
+                                : (sorted[mid - 1] + sorted[mid]) / 2;
+}
+
+double PerfResult::ItemsPerSecond() const {
+  const double median = MedianSeconds();
+  return median > 0 ? items / median : 0;
+}
+
+std::vector<PerfResult> RunScenarios(const std::vector<PerfScenario>& scenarios,
+                                     const PerfOptions& options,
+                                     std::string_view filter) {
+  YASL_ENFORCE(options.repetitions > 0);
+  std::vector<PerfResult> results;
+  for (const auto& scenario : scenarios) {
+    if (scenario.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    PerfResult result;
+    result.name = scenario.name;
+    for (size_t i = 0; i < options.repetitions; i++) {
+      const PerfSample sample = scenario.run(options);
+      result.items = sample.items;
+      result.bytes_sent = sample.bytes_sent;
+      result.seconds.push_back(sample.seconds);
+      SPDLOG_INFO("perf {} run {}: {:.3f}s", scenario.name, i,
+                  sample.seconds);
+    }
+    results.push_back(std::move(result));
+  }
+  return results;
+}
+
+std::string_view PerfStatusName(PerfCheck::Status status) {
+  switch (status) {
+    case PerfCheck::kNew:
+      return "new";
+    case PerfCheck::kOk:
+      return "ok";
+    case PerfCheck::kFaster:
+      return "faster";
+    case PerfCheck::kRegressed:
+      return "regressed";
+  }
+  YASL_THROW_LOGIC_ERROR("unknown perf status {}", static_cast<int>(status));
+}
+
+std::vector<PerfCheck> CheckBaselines(
+    const std::vector<PerfResult>& results,
+    const std::map<std::string, double>& baselines, double tolerance) {
+  YASL_ENFORCE(tolerance >= 0 && tolerance < 1, "tolerance={}", tolerance);
+  std::vector<PerfCheck> checks;
+  for (const auto& result : results) {
+    PerfCheck check;
+    check.name = result.name;
+    check.seconds = result.MedianSeconds();
+    auto it = baselines.find(result.name);
+    if (it != baselines.end()) {
+      check.baseline = it->second;
+      if (check.seconds > it->second * (1 + tolerance)) {
+        check.status = PerfCheck::kRegressed;
+      } else if (check.seconds < it->second * (1 - tolerance)) {
+        check.status = PerfCheck::kFaster;
+      } else {
+        check.status = PerfCheck::kOk;
+      }
+    }
+    checks.push_back(std::move(check));
+  }
+  return checks;
+}
+
+std::map<std::string, double> ParseBaselines(std::string_view json) {
+  return BaselineParser(json).Parse();
+}
+
+std::string BaselinesToJson(const std::map<std::string, double>& baselines) {
+  std::vector<std::string> entries;
+  for (const auto& [name, seconds] : baselines) {
+    entries.push_back(fmt::format("  \"{}\": {:.6g}", name, seconds));
+  }
+  return fmt::format("{{\n{}\n}}\n", fmt::join(entries, ",\n"));
+}
+
+std::string ReportToJson(const std::vector<PerfResult>& results,
+                         const std::vector<PerfCheck>& checks,
+                         double tolerance) {
+  YASL_ENFORCE(results.size() == checks.size());
+  std::vector<std::string> entries;
+  size_t regressions = 0;
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto& result = results[i];
+    const auto& check = checks[i];
+    regressions += check.status == PerfCheck::kRegressed ? 1 : 0;
+    entries.push_back(fmt::format(
+        "    {{\"name\": \"{}\", \"items\": {}, \"bytes_sent\": {}, "
+        "\"seconds\": [{:.6g}], \"median_seconds\": {:.6g}, "
+        "\"items_per_second\": {:.6g}, \"baseline_seconds\": {}, "
+        "\"status\": \"{}\"}}",
+        result.name, result.items, result.bytes_sent,
+        fmt::join(result.seconds, ", "), check.seconds,
+        result.ItemsPerSecond(),
+        check.baseline ? fmt::format("{:.6g}", *check.baseline) : "null",
+        PerfStatusName(check.status)));
+  }
+  return fmt::format(
+      "{{\n  \"tolerance\": {}, \"regressions\": {},\n  \"results\": "
+      "[\n{}\n  ]\n}}\n",
+      tolerance, regressions, fmt::join(entries, ",\n"));
+}
+
+}  // namespace yasl::perf
@@ -0,0 +1,115 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Brief: end to end performance scenarios checked against stored baselines.
+//
+// A scenario runs a whole protocol or pipeline at a fixed size, e.g. 2^24
+// IKNP ots, and is repeated; its median wall time is compared to the
+// baseline of its name. A name carries the size, so baselines of a scaled
+// down run, see PerfOptions::scale_shift, never mix with full runs.
+//
+// Baselines are a json object of median seconds by scenario name:
+//   {"iknp_ot/2^24": 1.52, "dpf_evalall/2^24": 0.31}
+// and are only meaningful on the machine which recorded them.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yasl::perf {
+
+struct PerfOptions {
+  // runs of each scenario, the median is checked.
+  size_t repetitions = 3;
+  // sizes are divided by 2^scale_shift, for smoke runs of the suite.
+  size_t scale_shift = 0;
+  // scratch files of scenarios, e.g. the input of csv ingest, are kept
+  // here and reused by later runs.
+  std::string work_dir = "/tmp";
+};
+
+// one run of a scenario, setup excluded from seconds.
+struct PerfSample {
+  double seconds = 0;
+  // ots, points, rows... of the scenario.
+  size_t items = 0;
+  // sent by all parties.
+  size_t bytes_sent = 0;
+};
+
+struct PerfScenario {
+  std::string name;
+  std::function<PerfSample(const PerfOptions&)> run;
+};
+
+struct PerfResult {
+  std::string name;
+  size_t items = 0;
+  size_t bytes_sent = 0;
+  std::vector<double> seconds;
+
+  double MedianSeconds() const;
+  double ItemsPerSecond() const;
+};
+
+// runs the scenarios whose name contains `filter`, all of them if empty.
+std::vector<PerfResult> RunScenarios(const std::vector<PerfScenario>& scenarios,
+                                     const PerfOptions& options,
+                                     std::string_view filter = {});
+
+struct PerfCheck {
+  enum Status {
+    // no baseline of the name.
+    kNew,
+    kOk,
+    // faster than the baseline by more than the tolerance, the baseline is
+    // likely stale.
+    kFaster,
+    kRegressed,
+  };
+
+  std::string name;
+  double seconds = 0;
+  std::optional<double> baseline;
+  Status status = kNew;
+};
+
+std::string_view PerfStatusName(PerfCheck::Status status);
+
+// a result regresses if its median exceeds baseline * (1 + tolerance).
+std::vector<PerfCheck> CheckBaselines(
+    const std::vector<PerfResult>& results,
+    const std::map<std::string, double>& baselines, double tolerance);
+
+// throws on malformed input.
+std::map<std::string, double> ParseBaselines(std::string_view json);
+
+// the inverse of ParseBaselines.
+std::string BaselinesToJson(const std::map<std::string, double>& baselines);
+
+// {"tolerance": t, "regressions": n, "results": [{"name", "items",
+//  "bytes_sent", "seconds": [...], "median_seconds", "items_per_second",
+//  "baseline_seconds", "status"}, ...]}, results and checks in the same
+// order.
+std::string ReportToJson(const std::vector<PerfResult>& results,
+                         const std::vector<PerfCheck>& checks,
+                         double tolerance);
+
+}  // namespace yasl::perf
@@ -0,0 +1,94 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/perf/perf_suite.h"
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/perf/scenarios.h"
+
+namespace yasl::perf {
+namespace {
+
+PerfScenario FixedScenario(std::string name, std::vector<double> seconds) {
+  auto runs = std::make_shared<size_t>(0);
+  return {std::move(name), [=](const PerfOptions&) {
+            return PerfSample{seconds[(*runs)++ % seconds.size()], 100, 10};
+          }};
+}
+
+TEST(PerfSuiteTest, RunsAndChecks) {
+  PerfOptions options;
+  options.repetitions = 3;
+  std::vector<PerfScenario> scenarios = {
+      FixedScenario("a/2^4", {3, 1, 2}), FixedScenario("b/2^4", {4}),
+      FixedScenario("c/2^4", {1}), FixedScenario("d/2^4", {1}),
+      FixedScenario("skipped", {1})};
+
+  const auto results = RunScenarios(scenarios, options, "/2^4");
+  ASSERT_EQ(results.size(), 4);
+  EXPECT_EQ(results[0].seconds, std::vector<double>({3, 1, 2}));
+  EXPECT_DOUBLE_EQ(results[0].MedianSeconds(), 2);
+  EXPECT_DOUBLE_EQ(results[0].ItemsPerSecond(), 50);
+
+  const std::map<std::string, double> baselines = {
+      {"a/2^4", 2.1}, {"b/2^4", 2}, {"c/2^4", 2}};
+  const auto checks = CheckBaselines(results, baselines, 0.1);
+  ASSERT_EQ(checks.size(), 4);
+  EXPECT_EQ(checks[0].status, PerfCheck::kOk);
+  EXPECT_EQ(checks[1].status, PerfCheck::kRegressed);
+  EXPECT_EQ(checks[2].status, PerfCheck::kFaster);
+  EXPECT_EQ(checks[3].status, PerfCheck::kNew);
+  EXPECT_FALSE(checks[3].baseline.has_value());
+
+  const auto report = ReportToJson(results, checks, 0.1);
+  EXPECT_NE(report.find("\"regressions\": 1"), std::string::npos);
+  EXPECT_NE(report.find("\"status\": \"regressed\""), std::string::npos);
+  EXPECT_NE(report.find("\"baseline_seconds\": null"), std::string::npos);
+}
+
+TEST(PerfSuiteTest, Baselines) {
+  const std::map<std::string, double> baselines = {{"iknp_ot/2^24", 1.5},
+                                                    {"csv_ingest/10MiB", 0.25}};
+  EXPECT_EQ(ParseBaselines(BaselinesToJson(baselines)), baselines);
+  EXPECT_TRUE(ParseBaselines(" {\n} ").empty());
+  EXPECT_TRUE(ParseBaselines(BaselinesToJson({})).empty());
+
+  EXPECT_THROW(ParseBaselines(""), InvalidFormat);
+  EXPECT_THROW(ParseBaselines("{\"a\": }"), InvalidFormat);
+  EXPECT_THROW(ParseBaselines("{\"a\": -1}"), InvalidFormat);
+  EXPECT_THROW(ParseBaselines("{\"a\": 1,}"), InvalidFormat);
+  EXPECT_THROW(ParseBaselines("{\"a\": 1, \"a\": 2}"), InvalidFormat);
+  EXPECT_THROW(ParseBaselines("{\"a\": 1} x"), InvalidFormat);
+}
+
+// every standard scenario at a tiny scale.
+TEST(PerfSuiteTest, StandardScenarios) {
+  PerfOptions options;
+  options.repetitions = 1;
+  options.scale_shift = 16;
+  options.work_dir = testing::TempDir();
+
+  const auto results = RunScenarios(StandardScenarios(options), options);
+  ASSERT_EQ(results.size(), 5);
+  for (const auto& result : results) {
+    EXPECT_GT(result.items, 0) << result.name;
+  }
+  EXPECT_EQ(results[0].name, "iknp_ot/2^8");
+  EXPECT_GT(results[0].bytes_sent, 0);
+}
+
+}  // namespace
+}  // namespace yasl::perf
@@ -0,0 +1,300 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/perf/scenarios.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "fmt/format.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/base/int128.h"
+#include "yasl/crypto/pseudo_random_generator.h"
+#include "yasl/crypto/utils.h"
+#include "yasl/io/rw/csv_reader.h"
+#include "yasl/io/stream/file_io.h"
+#include "yasl/link/algorithm/allgather.h"
+#include "yasl/link/context.h"
+#include "yasl/link/factory.h"
+#include "yasl/mpctools/dpf/dpf.h"
+#include "yasl/mpctools/ot/iknp_ot_extension.h"
+#include "yasl/mpctools/psi/kkrt_psi.h"
+
+namespace yasl::perf {
+
+namespace {
+
+using World = std::vector<std::shared_ptr<link::Context>>;
+
+class Stopwatch {
+ public:
+  Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+
+  double Seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start_)
+        .count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+// a fresh world of FactoryMem per run, so that bytes_sent is of the run.
+World MakeWorld(size_t world_size, uint32_t latency_ms = 0,
+                uint64_t bandwidth_bytes = 0) {
+  static std::atomic<size_t> counter{0};
+  link::ContextDesc desc;
+  desc.id = fmt::format("perf-{}", counter++);
+  desc.mem_latency_ms = latency_ms;
+  desc.mem_bandwidth_bytes = bandwidth_bytes;
+  for (size_t rank = 0; rank < world_size; rank++) {
+    desc.parties.push_back({fmt::format("party-{}", rank), "dummy_host"});
+  }
+  World world(world_size);
+  for (size_t rank = 0; rank < world_size; rank++) {
+    world[rank] = link::FactoryMem().CreateContext(desc, rank);
+  }
+  return world;
+}
+
+size_t BytesSent(const World& world) {
+  size_t bytes = 0;
+  for (const auto& ctx : world) {
+    bytes += ctx->GetStats()->sent_bytes;
+  }
+  return bytes;
+}
+
+// runs fn(rank) by every party at once, rethrows the first failure.
+template <class Fn>
+void RunParties(const World& world, Fn&& fn) {
+  std::vector<std::future<void>> jobs;
+  for (size_t rank = 0; rank < world.size(); rank++) {
+    jobs.push_back(std::async(std::launch::async, [&, rank] { fn(rank); }));
+  }
+  for (auto& job : jobs) {
+    job.get();
+  }
+}
+
+std::pair<BaseSendOptions, BaseRecvOptions> DealBaseOts(size_t num) {
+  BaseSendOptions send_opts;
+  BaseRecvOptions recv_opts;
+  recv_opts.choices = CreateRandomChoices(num);
+  std::random_device rd;
+  PseudoRandomGenerator<uint128_t> gen(rd());
+  for (size_t i = 0; i < num; ++i) {
+    send_opts.blocks.push_back({gen(), gen()});
+    recv_opts.blocks.push_back(send_opts.blocks[i][recv_opts.choices[i]]);
+  }
+  return {std::move(send_opts), std::move(recv_opts)};
+}
+
+size_t Scaled(size_t n, const PerfOptions& options) {
+  return std::max<size_t>(n >> options.scale_shift, 1);
+}
+
+// "10GiB", "160KiB"..., by the largest unit which divides bytes.
+std::string SizeLabel(size_t bytes) {
+  for (const auto& [shift, unit] : {std::pair<size_t, const char*>{30, "GiB"},
+                                    {20, "MiB"},
+                                    {10, "KiB"}}) {
+    if (bytes % (size_t{1} << shift) == 0) {
+      return fmt::format("{}{}", bytes >> shift, unit);
+    }
+  }
+  return fmt::format("{}B", bytes);
+}
+
+size_t ScaledLog(size_t log_n, const PerfOptions& options) {
+  YASL_ENFORCE(options.scale_shift < log_n, "scale_shift={} too large",
+               options.scale_shift);
+  return log_n - options.scale_shift;
+}
+
+PerfSample IknpOt(size_t log_n) {
+  const size_t n = size_t{1} << log_n;
+  auto world = MakeWorld(2);
+  auto [send_opts, recv_opts] = DealBaseOts(128);
+  std::vector<std::array<uint128_t, 2>> send_blocks(n);
+  std::vector<uint128_t> recv_blocks(n);
+  const auto choices = CreateRandomChoiceBits<uint128_t>(n);
+
+  Stopwatch watch;
+  RunParties(world, [&](size_t rank) {
+    if (rank == 0) {
+      IknpOtExtSend(world[0], recv_opts, absl::MakeSpan(send_blocks));
+    } else {
+      IknpOtExtRecv(world[1], send_opts, absl::MakeConstSpan(choices),
+                    absl::MakeSpan(recv_blocks));
+    }
+  });
+  return {watch.Seconds(), n, BytesSent(world)};
+}
+
+PerfSample KkrtPsi(size_t log_n) {
+  const size_t n = size_t{1} << log_n;
+  auto world = MakeWorld(2);
+  auto [send_opts, recv_opts] = DealBaseOts(512);
+  PseudoRandomGenerator<uint128_t> prg;
+  std::vector<uint128_t> sender_items(n);
+  std::vector<uint128_t> receiver_items(n);
+  for (size_t i = 0; i < n; i++) {
+    sender_items[i] = prg();
+    receiver_items[i] = i % 2 == 0 ? sender_items[i] : prg();
+  }
+
+  Stopwatch watch;
+  RunParties(world, [&](size_t rank) {
+    if (rank == 0) {
+      KkrtPsiSend(world[0], recv_opts, sender_items);
+    } else {
+      const auto common = KkrtPsiRecv(world[1], send_opts, receiver_items);
+      YASL_ENFORCE(common.size() == (n + 1) / 2, "psi of {} common items",
+                   common.size());
+    }
+  });
+  return {watch.Seconds(), n, BytesSent(world)};
+}
+
+PerfSample DpfEvalAll(size_t log_n) {
+  mpctools::DpfContext context(log_n, 64);
+  auto [key, peer_key] =
+      context.Gen(1, context.TruncateSs(0x12345678), 1, 2, true);
+  std::vector<uint64_t> out(size_t{1} << log_n);
+
+  Stopwatch watch;
+  context.EvalAll<uint64_t>(key, absl::MakeSpan(out));
+  return {watch.Seconds(), out.size(), 0};
+}
+
+constexpr size_t kCsvFeatures = 8;
+
+// a csv of at least `bytes`, of an int64 id and kCsvFeatures doubles per
+// row. written once and reused while its size matches.
+std::string CsvInput(const std::string& work_dir, size_t bytes) {
+  const auto path =
+      std::filesystem::path(work_dir) / fmt::format("perf_csv_{}.csv", bytes);
+  std::error_code ec;
+  if (std::filesystem::file_size(path, ec) >= bytes && !ec) {
+    return path.string();
+  }
+  const auto tmp_path = path.string() + ".tmp";
+  {
+    io::FileOutputStream out(tmp_path);
+    fmt::memory_buffer line;
+    fmt::format_to(std::back_inserter(line), "id");
+    for (size_t i = 0; i < kCsvFeatures; i++) {
+      fmt::format_to(std::back_inserter(line), ",x{}", i);
+    }
+    line.push_back('\n');
+    out.Write(line.data(), line.size());
+    size_t written = line.size();
+    std::mt19937_64 rng(bytes);
+    std::uniform_real_distribution<double> dist(-1000, 1000);
+    for (size_t row = 0; written < bytes; row++) {
+      line.clear();
+      fmt::format_to(std::back_inserter(line), "{}", row);
+      for (size_t i = 0; i < kCsvFeatures; i++) {
+        fmt::format_to(std::back_inserter(line), ",{:.6f}", dist(rng));
+      }
+      line.push_back('\n');
+      out.Write(line.data(), line.size());
+      written += line.size();
+    }
+    out.Close();
+  }
+  std::filesystem::rename(tmp_path, path);
+  return path.string();
+}
+
+PerfSample CsvIngest(const std::string& work_dir, size_t bytes) {
+  const auto path = CsvInput(work_dir, bytes);
+  io::ReaderOptions options;
+  options.batch_size = size_t{1} << 16;
+  options.row_reader_parallel_parse = true;
+  options.file_schema.feature_names.push_back("id");
+  options.file_schema.feature_types.push_back(io::Schema::INT64);
+  for (size_t i = 0; i < kCsvFeatures; i++) {
+    options.file_schema.feature_names.push_back(fmt::format("x{}", i));
+    options.file_schema.feature_types.push_back(io::Schema::DOUBLE);
+  }
+
+  Stopwatch watch;
+  io::CsvReader reader(options, std::make_unique<io::FileInputStream>(path));
+  reader.Init();
+  io::ColumnVectorBatch batch;
+  size_t rows = 0;
+  while (reader.Next(&batch)) {
+    rows += batch.Shape().rows;
+  }
+  return {watch.Seconds(), rows, 0};
+}
+
+constexpr size_t kAllGatherRounds = 16;
+
+PerfSample AllGatherWan(size_t world_size, size_t msg_bytes) {
+  // 20ms one way and 1Gbps per direction, cross region links.
+  auto world = MakeWorld(world_size, 20, 125'000'000);
+  const std::string msg(msg_bytes, 'x');
+
+  Stopwatch watch;
+  RunParties(world, [&](size_t rank) {
+    for (size_t round = 0; round < kAllGatherRounds; round++) {
+      const auto all = link::AllGather(world[rank], msg, "perf");
+      YASL_ENFORCE(all.size() == world_size);
+    }
+  });
+  return {watch.Seconds(), kAllGatherRounds, BytesSent(world)};
+}
+
+}  // namespace
+
+std::vector<PerfScenario> StandardScenarios(const PerfOptions& options) {
+  const size_t iknp_log = ScaledLog(24, options);
+  const size_t psi_log = ScaledLog(20, options);
+  const size_t dpf_log = ScaledLog(24, options);
+  const size_t csv_bytes = Scaled(size_t{10} << 30, options);
+  const size_t gather_bytes = Scaled(size_t{1} << 20, options);
+  const std::string work_dir = options.work_dir;
+
+  std::vector<PerfScenario> scenarios;
+  scenarios.push_back({fmt::format("iknp_ot/2^{}", iknp_log),
+                       [=](const PerfOptions&) { return IknpOt(iknp_log); }});
+  scenarios.push_back({fmt::format("kkrt_psi/2^{}", psi_log),
+                       [=](const PerfOptions&) { return KkrtPsi(psi_log); }});
+  scenarios.push_back(
+      {fmt::format("dpf_evalall/2^{}", dpf_log),
+       [=](const PerfOptions&) { return DpfEvalAll(dpf_log); }});
+  scenarios.push_back(
+      {fmt::format("csv_ingest/{}", SizeLabel(csv_bytes)),
+       [=](const PerfOptions&) { return CsvIngest(work_dir, csv_bytes); }});
+  scenarios.push_back(
+      {fmt::format("allgather_wan/8p/{}", SizeLabel(gather_bytes)),
+       [=](const PerfOptions&) { return AllGatherWan(8, gather_bytes); }});
+  return scenarios;
+}
+
+}  // namespace yasl::perf
@@ -0,0 +1,34 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <vector>
+
+#include "yasl/perf/perf_suite.h"
+
+namespace yasl::perf {
+
+// The standard scenarios, at full scale:
+//   iknp_ot/2^24          random ots by IKNP, two parties over FactoryMem.
+//   kkrt_psi/2^20         KKRT PSI of two sets of 2^20 items, half common.
+//   dpf_evalall/2^24      full domain evaluation of a 64 bits output key.
+//   csv_ingest/10GiB      row reader over a csv file of 10 GiB, parsed in
+//                         parallel, the file is written once to work_dir.
+//   allgather_wan/8p/1MiB 16 AllGather of 1 MiB msgs among 8 parties, on a
+//                         link of 20ms latency and 1Gbps per direction.
+// Base ots are dealt locally and not measured.
+std::vector<PerfScenario> StandardScenarios(const PerfOptions& options);
+
+}  // namespace yasl::perf
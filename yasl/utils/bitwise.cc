@@ -0,0 +1,344 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/bitwise.h"
+
+#include <cstring>
+
+#include "yasl/base/cpu_dispatch.h"
+#include "yasl/base/exception.h"
+
+#ifdef __x86_64
+#include <immintrin.h>
+#endif
+
+#ifdef __aarch64__
+#include <arm_neon.h>
+#endif
+
+namespace yasl {
+
+namespace {
+
+// d ^= (a ^ b) & mask, b is null for d ^= a & mask.
+using XorFn = void (*)(uint8_t* d, const uint8_t* a, const uint8_t* b,
+                       uint8_t mask, size_t n);
+// d &= a
+using AndFn = void (*)(uint8_t* d, const uint8_t* a, size_t n);
+// d ^= a & b
+using XorAndFn = void (*)(uint8_t* d, const uint8_t* a, const uint8_t* b,
+                          size_t n);
+// d = ~d
+using NotFn = void (*)(uint8_t* d, size_t n);
+
+inline uint64_t LoadWord(const uint8_t* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline void StoreWord(uint8_t* p, uint64_t v) {
+  std::memcpy(p, &v, sizeof(v));
+}
+
+void XorPortable(uint8_t* d, const uint8_t* a, const uint8_t* b, uint8_t mask,
+                 size_t n) {
+  const uint64_t wide_mask = uint64_t{mask} * 0x0101010101010101;
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    uint64_t v = LoadWord(a + i);
+    if (b != nullptr) {
+      v ^= LoadWord(b + i);
+    }
+    StoreWord(d + i, LoadWord(d + i) ^ (v & wide_mask));
+  }
+  for (; i < n; ++i) {
+    const uint8_t v = b == nullptr ? a[i] : a[i] ^ b[i];
+    d[i] ^= v & mask;
+  }
+}
+
+void AndPortable(uint8_t* d, const uint8_t* a, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    StoreWord(d + i, LoadWord(d + i) & LoadWord(a + i));
+  }
+  for (; i < n; ++i) {
+    d[i] &= a[i];
+  }
+}
+
+void XorAndPortable(uint8_t* d, const uint8_t* a, const uint8_t* b,
+                    size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    StoreWord(d + i, LoadWord(d + i) ^ (LoadWord(a + i) & LoadWord(b + i)));
+  }
+  for (; i < n; ++i) {
+    d[i] ^= a[i] & b[i];
+  }
+}
+
+void NotPortable(uint8_t* d, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    StoreWord(d + i, ~LoadWord(d + i));
+  }
+  for (; i < n; ++i) {
+    d[i] = ~d[i];
+  }
+}
+
+#ifdef __x86_64
+__attribute__((target("avx2"))) void XorAvx2(uint8_t* d, const uint8_t* a,
+                                             const uint8_t* b, uint8_t mask,
+                                             size_t n) {
+  const __m256i m = _mm256_set1_epi8(static_cast<char>(mask));
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    if (b != nullptr) {
+      v = _mm256_xor_si256(
+          v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    }
+    auto* p = reinterpret_cast<__m256i*>(d + i);
+    _mm256_storeu_si256(
+        p, _mm256_xor_si256(_mm256_loadu_si256(p), _mm256_and_si256(v, m)));
+  }
+  XorPortable(d + i, a + i, b == nullptr ? nullptr : b + i, mask, n - i);
+}
+
+__attribute__((target("avx2"))) void AndAvx2(uint8_t* d, const uint8_t* a,
+                                             size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    auto* p = reinterpret_cast<__m256i*>(d + i);
+    _mm256_storeu_si256(
+        p, _mm256_and_si256(_mm256_loadu_si256(p),
+                            _mm256_loadu_si256(
+                                reinterpret_cast<const __m256i*>(a + i))));
+  }
+  AndPortable(d + i, a + i, n - i);
+}
+
+__attribute__((target("avx2"))) void XorAndAvx2(uint8_t* d, const uint8_t* a,
+                                                const uint8_t* b, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    auto* p = reinterpret_cast<__m256i*>(d + i);
+    const __m256i v = _mm256_and_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), v));
+  }
+  XorAndPortable(d + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2"))) void NotAvx2(uint8_t* d, size_t n) {
+  const __m256i ones = _mm256_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    auto* p = reinterpret_cast<__m256i*>(d + i);
+    _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), ones));
+  }
+  NotPortable(d + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void XorAvx512(uint8_t* d,
+                                                  const uint8_t* a,
+                                                  const uint8_t* b,
+                                                  uint8_t mask, size_t n) {
+  const __m512i m = _mm512_set1_epi32(
+      static_cast<int>(uint32_t{mask} * 0x01010101));
+  size_t i = 0;
+  for (; i + 64 <= n; i += 64) {
+    __m512i v = _mm512_loadu_si512(a + i);
+    if (b != nullptr) {
+      v = _mm512_xor_si512(v, _mm512_loadu_si512(b + i));
+    }
+    _mm512_storeu_si512(
+        d + i,
+        _mm512_xor_si512(_mm512_loadu_si512(d + i), _mm512_and_si512(v, m)));
+  }
+  XorPortable(d + i, a + i, b == nullptr ? nullptr : b + i, mask, n - i);
+}
+
+__attribute__((target("avx512f"))) void AndAvx512(uint8_t* d,
+                                                  const uint8_t* a,
+                                                  size_t n) {
+  size_t i = 0;
+  for (; i + 64 <= n; i += 64) {
+    _mm512_storeu_si512(d + i, _mm512_and_si512(_mm512_loadu_si512(d + i),
+                                                _mm512_loadu_si512(a + i)));
+  }
+  AndPortable(d + i, a + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void XorAndAvx512(uint8_t* d,
+                                                     const uint8_t* a,
+                                                     const uint8_t* b,
+                                                     size_t n) {
+  size_t i = 0;
+  for (; i + 64 <= n; i += 64) {
+    // d ^ (a & b) is the ternary logic function 0x78 of (d, a, b).
+    _mm512_storeu_si512(
+        d + i, _mm512_ternarylogic_epi64(_mm512_loadu_si512(d + i),
+                                         _mm512_loadu_si512(a + i),
+                                         _mm512_loadu_si512(b + i), 0x78));
+  }
+  XorAndPortable(d + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void NotAvx512(uint8_t* d, size_t n) {
+  const __m512i ones = _mm512_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + 64 <= n; i += 64) {
+    _mm512_storeu_si512(d + i,
+                        _mm512_xor_si512(_mm512_loadu_si512(d + i), ones));
+  }
+  NotPortable(d + i, n - i);
+}
+#endif
+
+#ifdef __aarch64__
+void XorNeon(uint8_t* d, const uint8_t* a, const uint8_t* b, uint8_t mask,
+             size_t n) {
+  const uint8x16_t m = vdupq_n_u8(mask);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t v = vld1q_u8(a + i);
+    if (b != nullptr) {
+      v = veorq_u8(v, vld1q_u8(b + i));
+    }
+    vst1q_u8(d + i, veorq_u8(vld1q_u8(d + i), vandq_u8(v, m)));
+  }
+  XorPortable(d + i, a + i, b == nullptr ? nullptr : b + i, mask, n - i);
+}
+
+void AndNeon(uint8_t* d, const uint8_t* a, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    vst1q_u8(d + i, vandq_u8(vld1q_u8(d + i), vld1q_u8(a + i)));
+  }
+  AndPortable(d + i, a + i, n - i);
+}
+
+void XorAndNeon(uint8_t* d, const uint8_t* a, const uint8_t* b, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    vst1q_u8(d + i, veorq_u8(vld1q_u8(d + i),
+                             vandq_u8(vld1q_u8(a + i), vld1q_u8(b + i))));
+  }
+  XorAndPortable(d + i, a + i, b + i, n - i);
+}
+
+void NotNeon(uint8_t* d, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    vst1q_u8(d + i, vmvnq_u8(vld1q_u8(d + i)));
+  }
+  NotPortable(d + i, n - i);
+}
+#endif
+
+XorFn SelectXor() {
+  CpuDispatch<XorFn> dispatch("bitwise.xor", XorPortable);
+#ifdef __x86_64
+  dispatch.Add(kIsaAvx2, XorAvx2).Add(kIsaAvx512f, XorAvx512);
+#endif
+#ifdef __aarch64__
+  dispatch.Add(kIsaNeon, XorNeon);
+#endif
+  return dispatch.Bind();
+}
+
+AndFn SelectAnd() {
+  CpuDispatch<AndFn> dispatch("bitwise.and", AndPortable);
+#ifdef __x86_64
+  dispatch.Add(kIsaAvx2, AndAvx2).Add(kIsaAvx512f, AndAvx512);
+#endif
+#ifdef __aarch64__
+  dispatch.Add(kIsaNeon, AndNeon);
+#endif
+  return dispatch.Bind();
+}
+
+XorAndFn SelectXorAnd() {
+  CpuDispatch<XorAndFn> dispatch("bitwise.xor_and", XorAndPortable);
+#ifdef __x86_64
+  dispatch.Add(kIsaAvx2, XorAndAvx2).Add(kIsaAvx512f, XorAndAvx512);
+#endif
+#ifdef __aarch64__
+  dispatch.Add(kIsaNeon, XorAndNeon);
+#endif
+  return dispatch.Bind();
+}
+
+NotFn SelectNot() {
+  CpuDispatch<NotFn> dispatch("bitwise.not", NotPortable);
+#ifdef __x86_64
+  dispatch.Add(kIsaAvx2, NotAvx2).Add(kIsaAvx512f, NotAvx512);
+#endif
+#ifdef __aarch64__
+  dispatch.Add(kIsaNeon, NotNeon);
+#endif
+  return dispatch.Bind();
+}
+
+void DoXor(absl::Span<uint8_t> dst, absl::Span<const uint8_t> a,
+           const uint8_t* b, uint8_t mask) {
+  static const XorFn kXor = SelectXor();
+  kXor(dst.data(), a.data(), b, mask, dst.size());
+}
+
+}  // namespace
+
+void XorInto(absl::Span<uint8_t> dst, absl::Span<const uint8_t> src) {
+  YASL_ENFORCE_EQ(dst.size(), src.size());
+  DoXor(dst, src, nullptr, 0xff);
+}
+
+void XorThree(absl::Span<uint8_t> dst, absl::Span<const uint8_t> a,
+              absl::Span<const uint8_t> b) {
+  YASL_ENFORCE_EQ(dst.size(), a.size());
+  YASL_ENFORCE_EQ(dst.size(), b.size());
+  DoXor(dst, a, b.data(), 0xff);
+}
+
+void AndInto(absl::Span<uint8_t> dst, absl::Span<const uint8_t> src) {
+  YASL_ENFORCE_EQ(dst.size(), src.size());
+  static const AndFn kAnd = SelectAnd();
+  kAnd(dst.data(), src.data(), dst.size());
+}
+
+void XorAnd(absl::Span<uint8_t> dst, absl::Span<const uint8_t> a,
+            absl::Span<const uint8_t> b) {
+  YASL_ENFORCE_EQ(dst.size(), a.size());
+  YASL_ENFORCE_EQ(dst.size(), b.size());
+  static const XorAndFn kXorAnd = SelectXorAnd();
+  kXorAnd(dst.data(), a.data(), b.data(), dst.size());
+}
+
+void NotInto(absl::Span<uint8_t> dst) {
+  static const NotFn kNot = SelectNot();
+  kNot(dst.data(), dst.size());
+}
+
+void SelectMask(absl::Span<uint8_t> dst, absl::Span<const uint8_t> src,
+                bool choice) {
+  YASL_ENFORCE_EQ(dst.size(), src.size());
+  DoXor(dst, src, nullptr, static_cast<uint8_t>(0 - uint8_t{choice}));
+}
+
+}  // namespace yasl
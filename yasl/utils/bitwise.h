@@ -0,0 +1,90 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/int128.h"
+
+namespace yasl {
+
+// Bulk masking over byte buffers. The kernels run 64 bytes a time on
+// AVX-512, 32 on AVX2 and 16 on NEON, picked once at runtime, and the
+// running time depends only on the sizes, never on the data or on `choice`.
+// All the spans must have the same size; they may alias only when equal.
+
+// dst ^= src
+void XorInto(absl::Span<uint8_t> dst, absl::Span<const uint8_t> src);
+
+// dst ^= a ^ b
+void XorThree(absl::Span<uint8_t> dst, absl::Span<const uint8_t> a,
+              absl::Span<const uint8_t> b);
+
+// dst &= src
+void AndInto(absl::Span<uint8_t> dst, absl::Span<const uint8_t> src);
+
+// dst ^= a & b, the cross terms of an AND gate on xor shares.
+void XorAnd(absl::Span<uint8_t> dst, absl::Span<const uint8_t> a,
+            absl::Span<const uint8_t> b);
+
+// dst = ~dst
+void NotInto(absl::Span<uint8_t> dst);
+
+// dst ^= choice ? src : 0, `choice` is turned into an all ones or all zeros
+// mask, there is no branch on it.
+void SelectMask(absl::Span<uint8_t> dst, absl::Span<const uint8_t> src,
+                bool choice);
+
+inline absl::Span<uint8_t> AsBytes(absl::Span<uint128_t> x) {
+  return absl::MakeSpan(reinterpret_cast<uint8_t*>(x.data()),
+                        x.size() * sizeof(uint128_t));
+}
+
+inline absl::Span<const uint8_t> AsBytes(absl::Span<const uint128_t> x) {
+  return absl::MakeConstSpan(reinterpret_cast<const uint8_t*>(x.data()),
+                             x.size() * sizeof(uint128_t));
+}
+
+inline void XorInto(absl::Span<uint128_t> dst,
+                    absl::Span<const uint128_t> src) {
+  XorInto(AsBytes(dst), AsBytes(src));
+}
+
+inline void XorThree(absl::Span<uint128_t> dst, absl::Span<const uint128_t> a,
+                     absl::Span<const uint128_t> b) {
+  XorThree(AsBytes(dst), AsBytes(a), AsBytes(b));
+}
+
+inline void AndInto(absl::Span<uint128_t> dst,
+                    absl::Span<const uint128_t> src) {
+  AndInto(AsBytes(dst), AsBytes(src));
+}
+
+inline void XorAnd(absl::Span<uint128_t> dst, absl::Span<const uint128_t> a,
+                   absl::Span<const uint128_t> b) {
+  XorAnd(AsBytes(dst), AsBytes(a), AsBytes(b));
+}
+
+inline void NotInto(absl::Span<uint128_t> dst) { NotInto(AsBytes(dst)); }
+
+inline void SelectMask(absl::Span<uint128_t> dst,
+                       absl::Span<const uint128_t> src, bool choice) {
+  SelectMask(AsBytes(dst), AsBytes(src), choice);
+}
+
+}  // namespace yasl
@@ -0,0 +1,118 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/bitwise.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl {
+
+namespace {
+
+std::vector<uint8_t> RandomBytes(size_t n, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> out(n);
+  for (auto& b : out) {
+    b = static_cast<uint8_t>(rng());
+  }
+  return out;
+}
+
+}  // namespace
+
+class BitwiseTest : public ::testing::TestWithParam<size_t> {};
+
+TEST_P(BitwiseTest, MatchesBytewise) {
+  const size_t n = GetParam();
+  const auto a = RandomBytes(n, 1);
+  const auto b = RandomBytes(n, 2);
+  const auto c = RandomBytes(n, 3);
+
+  auto x = a;
+  XorInto(absl::MakeSpan(x), b);
+  auto y = a;
+  XorThree(absl::MakeSpan(y), b, c);
+  auto z = a;
+  AndInto(absl::MakeSpan(z), b);
+  auto xa = a;
+  XorAnd(absl::MakeSpan(xa), b, c);
+  auto na = a;
+  NotInto(absl::MakeSpan(na));
+  auto on = a;
+  SelectMask(absl::MakeSpan(on), b, true);
+  auto off = a;
+  SelectMask(absl::MakeSpan(off), b, false);
+
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(x[i], a[i] ^ b[i]) << i;
+    EXPECT_EQ(y[i], a[i] ^ b[i] ^ c[i]) << i;
+    EXPECT_EQ(z[i], a[i] & b[i]) << i;
+    EXPECT_EQ(xa[i], a[i] ^ (b[i] & c[i])) << i;
+    EXPECT_EQ(na[i], static_cast<uint8_t>(~a[i])) << i;
+    EXPECT_EQ(on[i], a[i] ^ b[i]) << i;
+    EXPECT_EQ(off[i], a[i]) << i;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, BitwiseTest,
+                         testing::Values(0, 1, 7, 8, 15, 31, 32, 33, 63, 64,
+                                         65, 127, 200, 4099));
+
+TEST(Bitwise, Uint128) {
+  std::vector<uint128_t> a(37);
+  std::vector<uint128_t> b(37);
+  for (size_t i = 0; i < a.size(); ++i) {
+    a[i] = MakeUint128(i * 0x9e3779b97f4a7c15, ~i);
+    b[i] = MakeUint128(~i, i * 0xc2b2ae3d27d4eb4f);
+  }
+
+  auto x = a;
+  XorInto(absl::MakeSpan(x), b);
+  auto y = a;
+  XorThree(absl::MakeSpan(y), b, b);
+  auto z = a;
+  AndInto(absl::MakeSpan(z), b);
+  auto xa = a;
+  XorAnd(absl::MakeSpan(xa), a, b);
+  auto na = a;
+  NotInto(absl::MakeSpan(na));
+  auto s = a;
+  SelectMask(absl::MakeSpan(s), b, true);
+
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(x[i], a[i] ^ b[i]);
+    EXPECT_EQ(y[i], a[i]);
+    EXPECT_EQ(z[i], a[i] & b[i]);
+    EXPECT_EQ(xa[i], a[i] & ~b[i]);
+    EXPECT_EQ(na[i], ~a[i]);
+    EXPECT_EQ(s[i], a[i] ^ b[i]);
+  }
+}
+
+TEST(Bitwise, SizeMismatch) {
+  std::vector<uint8_t> a(16);
+  std::vector<uint8_t> b(15);
+  EXPECT_THROW(XorInto(absl::MakeSpan(a), b), EnforceNotMet);
+  EXPECT_THROW(XorThree(absl::MakeSpan(a), a, b), EnforceNotMet);
+  EXPECT_THROW(AndInto(absl::MakeSpan(a), b), EnforceNotMet);
+  EXPECT_THROW(XorAnd(absl::MakeSpan(a), a, b), EnforceNotMet);
+  EXPECT_THROW(SelectMask(absl::MakeSpan(a), b, true), EnforceNotMet);
+}
+
+}  // namespace yasl
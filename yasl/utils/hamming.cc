@@ -0,0 +1,274 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/hamming.h"
+
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+#include "yasl/base/cpu_dispatch.h"
+#include "yasl/utils/parallel.h"
+
+#ifdef __x86_64
+#include <immintrin.h>
+#endif
+
+namespace yasl {
+
+namespace {
+
+// y is null for the weight of x.
+using PopcountFn = size_t (*)(const uint64_t* x, const uint64_t* y,
+                              size_t n);
+
+inline uint64_t LoadWord(const uint64_t* x, const uint64_t* y, size_t i) {
+  return y == nullptr ? x[i] : x[i] ^ y[i];
+}
+
+size_t PopcountPortable(const uint64_t* x, const uint64_t* y, size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++i) {
+    count += absl::popcount(LoadWord(x, y, i));
+  }
+  return count;
+}
+
+#ifdef __x86_64
+__attribute__((target("popcnt"))) size_t PopcountScalar(const uint64_t* x,
+                                                        const uint64_t* y,
+                                                        size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++i) {
+    count += _mm_popcnt_u64(LoadWord(x, y, i));
+  }
+  return count;
+}
+
+__attribute__((target("avx2"))) inline __m256i Load256(const uint64_t* x,
+                                                       const uint64_t* y,
+                                                       size_t i) {
+  const __m256i v =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + 4 * i));
+  if (y == nullptr) {
+    return v;
+  }
+  return _mm256_xor_si256(
+      v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + 4 * i)));
+}
+
+// the counts of the 4 words, by nibble lookups.
+__attribute__((target("avx2"))) inline __m256i Popcount256(__m256i v) {
+  const __m256i lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1,
+                       1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  const __m256i lo = _mm256_and_si256(v, low_mask);
+  const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+  const __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                         _mm256_shuffle_epi8(lookup, hi));
+  return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+// carry-save adder, h:l = a + b + c bitwise.
+__attribute__((target("avx2"))) inline void Csa(__m256i* h, __m256i* l,
+                                                __m256i a, __m256i b,
+                                                __m256i c) {
+  const __m256i u = _mm256_xor_si256(a, b);
+  *h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+  *l = _mm256_xor_si256(u, c);
+}
+
+__attribute__((target("avx2,popcnt"))) size_t PopcountAvx2(const uint64_t* x,
+                                                           const uint64_t* y,
+                                                           size_t n) {
+  const size_t vectors = n / 4;
+  __m256i total = _mm256_setzero_si256();
+  __m256i ones = _mm256_setzero_si256();
+  __m256i twos = _mm256_setzero_si256();
+  __m256i fours = _mm256_setzero_si256();
+  __m256i eights = _mm256_setzero_si256();
+  __m256i sixteens;
+  __m256i twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+  // 16 vectors in, one popcount out.
+  size_t i = 0;
+  for (; i + 16 <= vectors; i += 16) {
+    Csa(&twos_a, &ones, ones, Load256(x, y, i), Load256(x, y, i + 1));
+    Csa(&twos_b, &ones, ones, Load256(x, y, i + 2), Load256(x, y, i + 3));
+    Csa(&fours_a, &twos, twos, twos_a, twos_b);
+    Csa(&twos_a, &ones, ones, Load256(x, y, i + 4), Load256(x, y, i + 5));
+    Csa(&twos_b, &ones, ones, Load256(x, y, i + 6), Load256(x, y, i + 7));
+    Csa(&fours_b, &twos, twos, twos_a, twos_b);
+    Csa(&eights_a, &fours, fours, fours_a, fours_b);
+    Csa(&twos_a, &ones, ones, Load256(x, y, i + 8), Load256(x, y, i + 9));
+    Csa(&twos_b, &ones, ones, Load256(x, y, i + 10), Load256(x, y, i + 11));
+    Csa(&fours_a, &twos, twos, twos_a, twos_b);
+    Csa(&twos_a, &ones, ones, Load256(x, y, i + 12), Load256(x, y, i + 13));
+    Csa(&twos_b, &ones, ones, Load256(x, y, i + 14), Load256(x, y, i + 15));
+    Csa(&fours_b, &twos, twos, twos_a, twos_b);
+    Csa(&eights_b, &fours, fours, fours_a, fours_b);
+    Csa(&sixteens, &eights, eights, eights_a, eights_b);
+    total = _mm256_add_epi64(total, Popcount256(sixteens));
+  }
+  total = _mm256_slli_epi64(total, 4);
+  total = _mm256_add_epi64(total,
+                           _mm256_slli_epi64(Popcount256(eights), 3));
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(Popcount256(fours), 2));
+  total = _mm256_add_epi64(total, _mm256_slli_epi64(Popcount256(twos), 1));
+  total = _mm256_add_epi64(total, Popcount256(ones));
+  for (; i < vectors; ++i) {
+    total = _mm256_add_epi64(total, Popcount256(Load256(x, y, i)));
+  }
+
+  size_t count = _mm256_extract_epi64(total, 0) +
+                 _mm256_extract_epi64(total, 1) +
+                 _mm256_extract_epi64(total, 2) +
+                 _mm256_extract_epi64(total, 3);
+  for (size_t j = 4 * vectors; j < n; ++j) {
+    count += _mm_popcnt_u64(LoadWord(x, y, j));
+  }
+  return count;
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq"))) inline __m512i Load512(
+    const uint64_t* x, const uint64_t* y, size_t i) {
+  const __m512i v = _mm512_loadu_si512(x + 8 * i);
+  return y == nullptr ? v : _mm512_xor_si512(v, _mm512_loadu_si512(y + 8 * i));
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq"))) size_t PopcountAvx512(
+    const uint64_t* x, const uint64_t* y, size_t n) {
+  const size_t vectors = n / 8;
+  // 4 accumulators hide the latency of the adds.
+  __m512i acc0 = _mm512_setzero_si512();
+  __m512i acc1 = _mm512_setzero_si512();
+  __m512i acc2 = _mm512_setzero_si512();
+  __m512i acc3 = _mm512_setzero_si512();
+  size_t i = 0;
+  for (; i + 4 <= vectors; i += 4) {
+    acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(Load512(x, y, i)));
+    acc1 = _mm512_add_epi64(acc1, _mm512_popcnt_epi64(Load512(x, y, i + 1)));
+    acc2 = _mm512_add_epi64(acc2, _mm512_popcnt_epi64(Load512(x, y, i + 2)));
+    acc3 = _mm512_add_epi64(acc3, _mm512_popcnt_epi64(Load512(x, y, i + 3)));
+  }
+  for (; i < vectors; ++i) {
+    acc0 = _mm512_add_epi64(acc0, _mm512_popcnt_epi64(Load512(x, y, i)));
+  }
+  // the last words through a mask, no scalar tail.
+  const size_t rest = n - 8 * vectors;
+  if (rest > 0) {
+    const __mmask8 mask = static_cast<__mmask8>((1u << rest) - 1);
+    __m512i v = _mm512_maskz_loadu_epi64(mask, x + 8 * vectors);
+    if (y != nullptr) {
+      v = _mm512_xor_si512(v, _mm512_maskz_loadu_epi64(mask, y + 8 * vectors));
+    }
+    acc1 = _mm512_add_epi64(acc1, _mm512_popcnt_epi64(v));
+  }
+  acc0 = _mm512_add_epi64(_mm512_add_epi64(acc0, acc1),
+                          _mm512_add_epi64(acc2, acc3));
+  alignas(64) uint64_t lanes[8];
+  _mm512_store_si512(lanes, acc0);
+  size_t count = 0;
+  for (uint64_t lane : lanes) {
+    count += lane;
+  }
+  return count;
+}
+#endif
+
+PopcountFn SelectPopcount() {
+  CpuDispatch<PopcountFn> dispatch("hamming.popcount", PopcountPortable);
+#ifdef __x86_64
+  dispatch.Add(kIsaPopcnt, PopcountScalar)
+      .Add(kIsaAvx2 | kIsaPopcnt, PopcountAvx2)
+      .Add(kIsaAvx512f | kIsaAvx512Vpopcntdq, PopcountAvx512);
+#endif
+  return dispatch.Bind();
+}
+
+PopcountFn GetPopcount() {
+  static const PopcountFn popcount = SelectPopcount();
+  return popcount;
+}
+
+// queries scanned by one task at least.
+constexpr int64_t kTopKGrainSize = 4;
+// records scanned by all queries of a task before moving on, about L2 size.
+constexpr size_t kTopKTileBytes = 256 * 1024;
+
+}  // namespace
+
+size_t HammingWeight(absl::Span<const uint64_t> x) {
+  return GetPopcount()(x.data(), nullptr, x.size());
+}
+
+size_t HammingDistance(absl::Span<const uint64_t> x,
+                       absl::Span<const uint64_t> y) {
+  YASL_ENFORCE_EQ(x.size(), y.size());
+  return GetPopcount()(x.data(), y.data(), x.size());
+}
+
+std::vector<std::vector<HammingNeighbor>> HammingTopK(
+    absl::Span<const uint64_t> queries, absl::Span<const uint64_t> records,
+    size_t words, size_t k) {
+  YASL_ENFORCE_GT(words, 0u);
+  YASL_ENFORCE_EQ(queries.size() % words, 0u);
+  YASL_ENFORCE_EQ(records.size() % words, 0u);
+  const size_t num_queries = queries.size() / words;
+  const size_t num_records = records.size() / words;
+  const size_t tile = std::max<size_t>(1, kTopKTileBytes / (8 * words));
+  const size_t top = std::min(k, num_records);
+  const PopcountFn popcount = GetPopcount();
+
+  std::vector<std::vector<HammingNeighbor>> result(num_queries);
+  if (top == 0) {
+    return result;
+  }
+  parallel_for(0, num_queries, kTopKGrainSize, [&](int64_t begin,
+                                                   int64_t end) {
+    // max heaps of (distance, index), the worst neighbor on top.
+    std::vector<std::priority_queue<std::pair<size_t, size_t>>> heaps(
+        end - begin);
+    for (size_t r0 = 0; r0 < num_records; r0 += tile) {
+      const size_t r1 = std::min(r0 + tile, num_records);
+      for (int64_t q = begin; q < end; ++q) {
+        const uint64_t* query = queries.data() + q * words;
+        auto& heap = heaps[q - begin];
+        for (size_t r = r0; r < r1; ++r) {
+          const std::pair<size_t, size_t> candidate(
+              popcount(query, records.data() + r * words, words), r);
+          if (heap.size() < top) {
+            heap.push(candidate);
+          } else if (candidate < heap.top()) {
+            heap.pop();
+            heap.push(candidate);
+          }
+        }
+      }
+    }
+    for (int64_t q = begin; q < end; ++q) {
+      auto& heap = heaps[q - begin];
+      auto& neighbors = result[q];
+      neighbors.resize(heap.size());
+      for (size_t i = heap.size(); i > 0; --i) {
+        neighbors[i - 1] = {heap.top().second, heap.top().first};
+        heap.pop();
+      }
+    }
+  });
+  return result;
+}
+
+}  // namespace yasl
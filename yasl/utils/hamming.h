@@ -12,6 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include "absl/numeric/bits.h"
 #include "absl/types/span.h"
@@ -40,4 +45,44 @@ inline constexpr size_t HammingDistance(T x, T y) {
   return HammingWeight(x ^ y);
 }
 
+// Bit vectors as spans of words. The kernels take 8 words a time with
+// VPOPCNTQ on AVX-512, or 64 words a time by the Harley-Seal carry-save adder
+// tree over AVX2 lookup popcounts, "Faster Population Counts Using AVX2
+// Instructions" (Mula, Kurz and Lemire), so long vectors run at memory
+// bandwidth. The kernel is picked once at runtime.
+size_t HammingWeight(absl::Span<const uint64_t> x);
+size_t HammingDistance(absl::Span<const uint64_t> x,
+                       absl::Span<const uint64_t> y);
+
+inline size_t HammingWeight(absl::Span<const uint128_t> x) {
+  return HammingWeight(absl::MakeConstSpan(
+      reinterpret_cast<const uint64_t*>(x.data()), 2 * x.size()));
+}
+
+inline size_t HammingDistance(absl::Span<const uint128_t> x,
+                              absl::Span<const uint128_t> y) {
+  return HammingDistance(
+      absl::MakeConstSpan(reinterpret_cast<const uint64_t*>(x.data()),
+                          2 * x.size()),
+      absl::MakeConstSpan(reinterpret_cast<const uint64_t*>(y.data()),
+                          2 * y.size()));
+}
+
+struct HammingNeighbor {
+  size_t index;
+  size_t distance;
+
+  bool operator==(const HammingNeighbor& other) const {
+    return index == other.index && distance == other.distance;
+  }
+};
+
+// All pairs search. `queries` and `records` are back to back bit vectors of
+// `words` words each, the result holds for each query the min(k, #records)
+// records nearest to it, nearest first and ties by index. Queries run on the
+// thread pool, each scanning the records a tile of L2 size at a time.
+std::vector<std::vector<HammingNeighbor>> HammingTopK(
+    absl::Span<const uint64_t> queries, absl::Span<const uint64_t> records,
+    size_t words, size_t k);
+
 }  // namespace yasl
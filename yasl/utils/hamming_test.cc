@@ -15,6 +15,10 @@
 
 #include "yasl/utils/hamming.h"
 
+#include <algorithm>
+#include <random>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 namespace yasl {
@@ -39,4 +43,72 @@ TEST(Hamming, Distance) {
   EXPECT_EQ(HammingDistance(x, y), 12);
 }
 
+TEST(Hamming, Spans) {
+  std::mt19937_64 rng(42);
+  for (size_t n : {0, 1, 3, 4, 7, 8, 63, 64, 65, 200, 1000}) {
+    std::vector<uint64_t> x(n);
+    std::vector<uint64_t> y(n);
+    size_t weight = 0;
+    size_t distance = 0;
+    for (size_t i = 0; i < n; ++i) {
+      x[i] = rng();
+      y[i] = rng();
+      weight += HammingWeight(x[i]);
+      distance += HammingDistance(x[i], y[i]);
+    }
+    EXPECT_EQ(HammingWeight(x), weight) << n;
+    EXPECT_EQ(HammingDistance(x, y), distance) << n;
+  }
+
+  std::vector<uint128_t> a(100, std::numeric_limits<uint128_t>::max());
+  std::vector<uint128_t> b(100, 0);
+  EXPECT_EQ(HammingWeight(absl::MakeConstSpan(a)), 128 * 100);
+  EXPECT_EQ(HammingDistance(absl::MakeConstSpan(a), absl::MakeConstSpan(b)),
+            128 * 100);
+
+  std::vector<uint64_t> c(3);
+  std::vector<uint64_t> d(4);
+  EXPECT_ANY_THROW(HammingDistance(c, d));
+}
+
+TEST(Hamming, TopK) {
+  constexpr size_t kWords = 5;
+  constexpr size_t kQueries = 7;
+  constexpr size_t kRecords = 300;
+  std::mt19937_64 rng(7);
+  std::vector<uint64_t> queries(kQueries * kWords);
+  std::vector<uint64_t> records(kRecords * kWords);
+  for (auto& word : queries) {
+    word = rng();
+  }
+  for (auto& word : records) {
+    // sparse words, so distances tie.
+    word = rng() & rng() & rng();
+  }
+
+  const auto result = HammingTopK(queries, records, kWords, 10);
+  ASSERT_EQ(result.size(), kQueries);
+  for (size_t q = 0; q < kQueries; ++q) {
+    std::vector<HammingNeighbor> all;
+    for (size_t r = 0; r < kRecords; ++r) {
+      all.push_back({r, HammingDistance(
+                            absl::MakeConstSpan(&queries[q * kWords], kWords),
+                            absl::MakeConstSpan(&records[r * kWords],
+                                                kWords))});
+    }
+    std::sort(all.begin(), all.end(), [](const auto& lhs, const auto& rhs) {
+      return std::make_pair(lhs.distance, lhs.index) <
+             std::make_pair(rhs.distance, rhs.index);
+    });
+    all.resize(10);
+    EXPECT_EQ(result[q], all);
+  }
+
+  // fewer records than k.
+  const auto few = HammingTopK(queries, absl::MakeConstSpan(records).first(
+                                            2 * kWords),
+                               kWords, 10);
+  EXPECT_EQ(few[0].size(), 2);
+}
+
 }  // namespace yasl
\ No newline at end of file
@@ -15,17 +15,159 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <string_view>
+#include <type_traits>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 
 namespace yasl::utils {
 
-// This is a copy of boost hash_combine
-// See
-// https://www.boost.org/doc/libs/1_49_0/doc/html/hash/reference.html#boost.hash_combine
+namespace internal {
+
+inline constexpr uint64_t kHashSecret[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL,
+    0x589965cc75374cc3ULL};
+
+// the low and high halves of the 128 bits product of a and b.
+inline void HashMum(uint64_t* a, uint64_t* b) {
+  const unsigned __int128 r = static_cast<unsigned __int128>(*a) * *b;
+  *a = static_cast<uint64_t>(r);
+  *b = static_cast<uint64_t>(r >> 64);
+}
+
+// xor of the halves of the product, the mixing step of wyhash.
+inline uint64_t HashMix(uint64_t a, uint64_t b) {
+  HashMum(&a, &b);
+  return a ^ b;
+}
+
+inline uint64_t HashRead64(const uint8_t* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t HashRead32(const uint8_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+}  // namespace internal
+
+// wyhash (final 4) of len bytes, 48 bytes per round of three independent
+// multiplies, a single multiply for up to 16 bytes. It passes SMHasher and
+// is several times faster than std::hash on long keys.
+//
+// Bytes are read in native order, so like std::hash it is only stable
+// within a process. Use fnv1a_hash for ids exchanged between parties.
+inline uint64_t FastHash(const void* data, size_t len, uint64_t seed = 0) {
+  using internal::HashMix;
+  using internal::HashRead32;
+  using internal::HashRead64;
+  using internal::kHashSecret;
+  const auto* p = static_cast<const uint8_t*>(data);
+  seed ^= HashMix(seed ^ kHashSecret[0], kHashSecret[1]);
+  uint64_t a;
+  uint64_t b;
+  if (len <= 16) {
+    if (len >= 4) {
+      const size_t mid = (len >> 3) << 2;
+      a = (HashRead32(p) << 32) | HashRead32(p + mid);
+      b = (HashRead32(p + len - 4) << 32) | HashRead32(p + len - 4 - mid);
+    } else if (len > 0) {
+      a = (uint64_t{p[0]} << 16) | (uint64_t{p[len >> 1]} << 8) | p[len - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      uint64_t see1 = seed;
+      uint64_t see2 = seed;
+      do {
+        seed = HashMix(HashRead64(p) ^ kHashSecret[1],
+                       HashRead64(p + 8) ^ seed);
+        see1 = HashMix(HashRead64(p + 16) ^ kHashSecret[2],
+                       HashRead64(p + 24) ^ see1);
+        see2 = HashMix(HashRead64(p + 32) ^ kHashSecret[3],
+                       HashRead64(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = HashMix(HashRead64(p) ^ kHashSecret[1], HashRead64(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = HashRead64(p + i - 16);
+    b = HashRead64(p + i - 8);
+  }
+  a ^= kHashSecret[1];
+  b ^= seed;
+  internal::HashMum(&a, &b);
+  return HashMix(a ^ kHashSecret[0] ^ len, b ^ kHashSecret[1]);
+}
+
+inline uint64_t FastHash(std::string_view str, uint64_t seed = 0) {
+  return FastHash(str.data(), str.size(), seed);
+}
+
+// wyhash64 of an integer and the seed, two multiplies.
+inline uint64_t FastHash(uint64_t v, uint64_t seed = 0) {
+  constexpr uint64_t kA = 0x2d358dccaa6c78a5ULL;
+  constexpr uint64_t kB = 0x8bb84b93962eacc9ULL;
+  v ^= kA;
+  seed ^= kB;
+  internal::HashMum(&v, &seed);
+  return internal::HashMix(v ^ kA, seed ^ kB);
+}
+
+// Hasher of strings and integers, 128 bits ones included, by FastHash, for
+// absl and std containers. It is transparent, so maps keyed by std::string
+// are looked up by a std::string_view or a literal without a copy.
+struct FastHasher {
+  using is_transparent = void;
+
+  size_t operator()(std::string_view str) const { return FastHash(str); }
+
+  size_t operator()(unsigned __int128 v) const {
+    return FastHash(static_cast<uint64_t>(v), static_cast<uint64_t>(v >> 64));
+  }
+
+  template <class T, std::enable_if_t<std::is_integral_v<T> ||
+                                          std::is_enum_v<T>,
+                                      int> = 0>
+  size_t operator()(T v) const {
+    return FastHash(static_cast<uint64_t>(v));
+  }
+};
+
+// Swiss tables hashed by FastHasher, for the hot internal maps keyed by
+// strings or integers. Unlike std::unordered_map, an insert or erase may
+// move the elements, keep a std::unordered_map where references to them
+// must stay valid.
+template <class K, class V>
+using FastHashMap = absl::flat_hash_map<K, V, FastHasher, std::equal_to<>>;
+
+template <class K>
+using FastHashSet = absl::flat_hash_set<K, FastHasher, std::equal_to<>>;
+
+// Mixes the std::hash of v into seed by one wide multiply, which unlike the
+// shifts and adds of boost's hash_combine spreads every bit of an identity
+// std::hash, say of an integer, over the whole result.
 template <class T>
 inline void hash_combine(std::size_t& seed, const T& v) {
   std::hash<T> hasher;
-  seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  seed = internal::HashMix(seed ^ internal::kHashSecret[0],
+                           hasher(v) ^ internal::kHashSecret[1]);
 }
 
 // A helper function to make hashing multiply values easier
@@ -35,4 +177,14 @@ inline void hash_combine(std::size_t& seed, const T& v, const MoreT&... args) {
   hash_combine(seed, args...);
 }
 
+// 64 bits FNV-1a, which unlike std::hash is the same across processes and
+// platforms, for ids exchanged between parties.
+inline uint64_t fnv1a_hash(std::string_view str) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (char c : str) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
 }  // namespace yasl::utils
@@ -0,0 +1,83 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/hash.h"
+
+#include <set>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace yasl::utils {
+
+TEST(HashTest, FastHashBytes) {
+  // every length up to a few rounds of 48 bytes, and a flipped bit of each
+  // byte, hash apart.
+  std::string data(200, 'x');
+  std::set<uint64_t> hashes;
+  for (size_t len = 0; len <= data.size(); ++len) {
+    EXPECT_TRUE(hashes.insert(FastHash(data.data(), len)).second) << len;
+  }
+  for (size_t i = 0; i < data.size(); ++i) {
+    std::string flipped = data;
+    flipped[i] ^= 1;
+    EXPECT_TRUE(hashes.insert(FastHash(flipped)).second) << i;
+  }
+  EXPECT_EQ(FastHash(std::string_view(data)), FastHash(data));
+  EXPECT_NE(FastHash(data, 1), FastHash(data));
+}
+
+TEST(HashTest, FastHashInts) {
+  std::set<uint64_t> hashes;
+  std::set<uint64_t> low_bits;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(hashes.insert(FastHash(i)).second) << i;
+    low_bits.insert(FastHash(i) & 0xff);
+  }
+  // consecutive keys spread over the buckets of a table.
+  EXPECT_GT(low_bits.size(), 240);
+  EXPECT_NE(FastHash(uint64_t{7}, 1), FastHash(uint64_t{7}));
+}
+
+TEST(HashTest, FastHashMap) {
+  FastHashMap<std::string, int> map;
+  map.emplace("a", 1);
+  map["bb"] = 2;
+  // looked up without building a std::string.
+  EXPECT_EQ(map.find(std::string_view("bb"))->second, 2);
+  EXPECT_EQ(map.count("c"), 0);
+
+  FastHashSet<int64_t> set;
+  for (int64_t i = -100; i < 100; ++i) {
+    set.insert(i);
+  }
+  EXPECT_EQ(set.size(), 200);
+  EXPECT_TRUE(set.contains(-100));
+}
+
+TEST(HashTest, HashCombine) {
+  size_t ab = 0;
+  hash_combine(ab, 1, 2);
+  size_t ba = 0;
+  hash_combine(ba, 2, 1);
+  EXPECT_NE(ab, ba);
+
+  size_t s1 = 0;
+  hash_combine(s1, std::string("x"), 3);
+  size_t s2 = 0;
+  hash_combine(s2, std::string("x"), 4);
+  EXPECT_NE(s1, s2);
+}
+
+}  // namespace yasl::utils
@@ -0,0 +1,106 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/histogram.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "fmt/format.h"
+
+namespace yasl {
+
+size_t Histogram::BucketOf(uint64_t value) {
+  return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+uint64_t Histogram::BucketUpperBound(size_t idx) {
+  if (idx == 0) {
+    return 0;
+  }
+  if (idx >= 64) {
+    return std::numeric_limits<uint64_t>::max();
+  }
+  return (uint64_t{1} << idx) - 1;
+}
+
+void Histogram::Add(uint64_t value) {
+  buckets_[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+HistogramSnapshot Histogram::Snapshot() const {
+  HistogramSnapshot snapshot;
+  snapshot.count = count_.load(std::memory_order_relaxed);
+  snapshot.sum = sum_.load(std::memory_order_relaxed);
+  snapshot.buckets.resize(kNumBuckets);
+  for (size_t idx = 0; idx < kNumBuckets; idx++) {
+    snapshot.buckets[idx] = buckets_[idx].load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+void Histogram::Reset() {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+}
+
+void HistogramSnapshot::Merge(const HistogramSnapshot& other) {
+  count += other.count;
+  sum += other.sum;
+  buckets.resize(std::max(buckets.size(), other.buckets.size()));
+  for (size_t idx = 0; idx < other.buckets.size(); idx++) {
+    buckets[idx] += other.buckets[idx];
+  }
+}
+
+uint64_t HistogramSnapshot::Quantile(double q) const {
+  const auto rank = static_cast<uint64_t>(q * static_cast<double>(count));
+  uint64_t seen = 0;
+  for (size_t idx = 0; idx < buckets.size(); idx++) {
+    seen += buckets[idx];
+    if (seen > rank || (seen == count && seen != 0)) {
+      return Histogram::BucketUpperBound(idx);
+    }
+  }
+  return 0;
+}
+
+std::string HistogramSnapshot::ToPrometheus(std::string_view name,
+                                            std::string_view labels) const {
+  const std::string sep = labels.empty() ? "" : ",";
+  std::string out;
+  uint64_t cumulative = 0;
+  for (size_t idx = 0; idx < buckets.size(); idx++) {
+    if (buckets[idx] == 0) {
+      continue;
+    }
+    cumulative += buckets[idx];
+    out += fmt::format("{}_bucket{{{}{}le=\"{}\"}} {}\n", name, labels, sep,
+                       Histogram::BucketUpperBound(idx), cumulative);
+  }
+  out += fmt::format("{}_bucket{{{}{}le=\"+Inf\"}} {}\n", name, labels, sep,
+                     count);
+  const std::string braces =
+      labels.empty() ? "" : fmt::format("{{{}}}", labels);
+  out += fmt::format("{}_sum{} {}\n", name, braces, sum);
+  out += fmt::format("{}_count{} {}\n", name, braces, count);
+  return out;
+}
+
+}  // namespace yasl
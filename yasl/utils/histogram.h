@@ -0,0 +1,69 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yasl {
+
+// Counts of a Histogram at some moment, which can be merged and exported.
+struct HistogramSnapshot {
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  // see Histogram::BucketOf.
+  std::vector<uint64_t> buckets;
+
+  void Merge(const HistogramSnapshot& other);
+
+  // upper bound of the bucket holding the `q` quantile, q in [0, 1].
+  uint64_t Quantile(double q) const;
+
+  // prometheus text format of histogram `name`, `labels` is either empty or
+  // like `peer="1"`. empty buckets are skipped, they are cumulative anyway.
+  std::string ToPrometheus(std::string_view name,
+                           std::string_view labels) const;
+};
+
+// A lock free histogram of non-negative integers in power of 2 buckets,
+// cheap enough to record every msg.
+class Histogram {
+ public:
+  // bucket 0 holds 0, bucket i holds [2^(i-1), 2^i).
+  static constexpr size_t kNumBuckets = 65;
+
+  static size_t BucketOf(uint64_t value);
+
+  // inclusive upper bound of bucket `idx`.
+  static uint64_t BucketUpperBound(size_t idx);
+
+  void Add(uint64_t value);
+
+  HistogramSnapshot Snapshot() const;
+
+  // not atomic with concurrent adds, which may be lost or partly kept.
+  void Reset();
+
+ private:
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_{};
+  std::atomic<uint64_t> count_ = 0;
+  std::atomic<uint64_t> sum_ = 0;
+};
+
+}  // namespace yasl
@@ -0,0 +1,79 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/histogram.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace yasl {
+
+TEST(HistogramTest, BucketShouldOk) {
+  EXPECT_EQ(Histogram::BucketOf(0), 0);
+  EXPECT_EQ(Histogram::BucketOf(1), 1);
+  EXPECT_EQ(Histogram::BucketOf(2), 2);
+  EXPECT_EQ(Histogram::BucketOf(3), 2);
+  EXPECT_EQ(Histogram::BucketOf(1024), 11);
+  EXPECT_EQ(Histogram::BucketOf(UINT64_MAX), 64);
+  EXPECT_EQ(Histogram::BucketUpperBound(2), 3);
+  EXPECT_EQ(Histogram::BucketUpperBound(64), UINT64_MAX);
+}
+
+TEST(HistogramTest, ConcurrentAddShouldOk) {
+  Histogram histogram;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; t++) {
+    threads.emplace_back([&] {
+      for (uint64_t i = 0; i < 1000; i++) {
+        histogram.Add(i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto snapshot = histogram.Snapshot();
+  EXPECT_EQ(snapshot.count, 4000);
+  EXPECT_EQ(snapshot.sum, 4 * 999 * 1000 / 2);
+  EXPECT_EQ(snapshot.buckets[0], 4);
+  EXPECT_EQ(snapshot.Quantile(0.5), 511);
+  EXPECT_EQ(snapshot.Quantile(1), 1023);
+}
+
+TEST(HistogramTest, MergeAndExportShouldOk) {
+  Histogram a;
+  Histogram b;
+  a.Add(1);
+  b.Add(5);
+  b.Add(6);
+
+  auto snapshot = a.Snapshot();
+  snapshot.Merge(b.Snapshot());
+
+  EXPECT_EQ(snapshot.count, 3);
+  EXPECT_EQ(snapshot.sum, 12);
+  EXPECT_EQ(snapshot.ToPrometheus("size", "peer=\"1\""),
+            "size_bucket{peer=\"1\",le=\"1\"} 1\n"
+            "size_bucket{peer=\"1\",le=\"7\"} 3\n"
+            "size_bucket{peer=\"1\",le=\"+Inf\"} 3\n"
+            "size_sum{peer=\"1\"} 12\n"
+            "size_count{peer=\"1\"} 3\n");
+  EXPECT_EQ(HistogramSnapshot().ToPrometheus("size", ""),
+            "size_bucket{le=\"+Inf\"} 0\nsize_sum 0\nsize_count 0\n");
+}
+
+}  // namespace yasl
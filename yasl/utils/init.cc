@@ -0,0 +1,72 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "yasl/utils/init.h"
+
+#include <future>
+#include <mutex>
+
+#include "yasl/base/cpu_dispatch.h"
+#include "yasl/crypto/drbg/nist_aes_drbg.h"
+#include "yasl/crypto/random_oracle.h"
+#include "yasl/utils/parallel.h"
+
+namespace yasl {
+
+namespace {
+
+std::mutex warm_up_mutex;
+std::shared_future<void> warm_up;
+
+void WarmUp(const InitOptions& options) {
+  if (options.warm_up_pool) {
+    warm_up_intraop_pool();
+  }
+  if (options.warm_up_crypto) {
+    static_cast<void>(RandomOracle::GetDefault());
+    static_cast<void>(crypto::NistAesDrbg::AppDataIndex());
+  }
+}
+
+}  // namespace
+
+void Init(const InitOptions& options) {
+  static_cast<void>(GetCpuIsa());
+  if (!options.thread_affinity.empty()) {
+    set_thread_affinity(options.thread_affinity);
+  }
+  if (options.num_threads > 0) {
+    set_num_threads(options.num_threads);
+  }
+
+  if (!options.background) {
+    WarmUp(options);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(warm_up_mutex);
+  warm_up =
+      std::async(std::launch::async, [options] { WarmUp(options); }).share();
+}
+
+void WaitForInit() {
+  std::shared_future<void> pending;
+  {
+    std::lock_guard<std::mutex> lock(warm_up_mutex);
+    pending = warm_up;
+  }
+  if (pending.valid()) {
+    pending.get();
+  }
+}
+
+}  // namespace yasl
@@ -0,0 +1,55 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// Brief: optional setup of a process. Library state, e.g. the intra-op pool,
+// the default random oracle and the openssl drbg state, is otherwise created
+// on first use, which lands on the latency of the first protocol run. Short
+// lived workers call Init at start, possibly in the background, to make that
+// latency predictable:
+//
+//   yasl::InitOptions options;
+//   options.background = true;
+//   yasl::Init(options);
+//   ... parse inputs, connect links ...
+//   yasl::WaitForInit();
+
+#pragma once
+
+#include <string>
+
+namespace yasl {
+
+struct InitOptions {
+  // threads of the intra-op pool, 0 keeps the default.
+  int num_threads = 0;
+  // cpu binding of the intra-op pool, see set_thread_affinity. empty keeps
+  // the default.
+  std::string thread_affinity;
+  // starts the intra-op pool.
+  bool warm_up_pool = true;
+  // sets up the default random oracle and the openssl drbg state.
+  bool warm_up_crypto = true;
+  // runs the warm ups on a background thread, see WaitForInit.
+  bool background = false;
+};
+
+// probes the cpu features and applies the pool options on the calling thread,
+// then runs the warm ups. it must be called before parallel work has started
+// if a thread affinity is given.
+void Init(const InitOptions& options = {});
+
+// waits for the background warm ups of Init, if any, and rethrows their
+// failure.
+void WaitForInit();
+
+}  // namespace yasl
@@ -0,0 +1,54 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "yasl/utils/init.h"
+
+#include <mutex>
+
+#include "gtest/gtest.h"
+
+#include "yasl/utils/parallel.h"
+
+namespace yasl {
+
+TEST(InitTest, Foreground) {
+  InitOptions options;
+  options.num_threads = 2;
+  Init(options);
+  WaitForInit();
+
+  EXPECT_EQ(get_num_threads(), 2);
+}
+
+TEST(InitTest, Background) {
+  InitOptions options;
+  options.num_threads = 3;
+  options.background = true;
+  Init(options);
+  WaitForInit();
+  // waiting again is a no-op.
+  WaitForInit();
+
+  EXPECT_EQ(get_num_threads(), 3);
+  int64_t sum = 0;
+  std::mutex mutex;
+  parallel_for(0, 100, 1, [&](int64_t begin, int64_t end) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int64_t i = begin; i < end; i++) {
+      sum += i;
+    }
+  });
+  EXPECT_EQ(sum, 4950);
+}
+
+}  // namespace yasl
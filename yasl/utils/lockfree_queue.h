@@ -0,0 +1,331 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Brief: bounded lock free queues for hand-offs between busy threads.
+//
+//   SpscQueue  one producer and one consumer thread, a ring buffer.
+//   MpmcQueue  any number of both, Dmitry Vyukov's bounded queue.
+//
+// Both have the api of BoundedQueue in pipeline.h, plus TryPush and TryPop
+// which never block. A blocked Push or Pop spins, then yields, and never
+// sleeps on a condition variable, so a hand-off costs tens of nanoseconds
+// rather than a futex wake up. A thread which may wait for long, e.g. for
+// the network, should rather use a BoundedQueue.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "absl/numeric/bits.h"
+
+#include "yasl/base/exception.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace yasl {
+
+inline constexpr size_t kCacheLineSize = 64;
+
+namespace internal {
+
+// waits of a blocked Push or Pop, spins first as the other side is usually
+// just about to make progress, unless it can not run meanwhile.
+class QueueBackoff {
+ public:
+  void Wait() {
+    static const int max_spins =
+        std::thread::hardware_concurrency() > 1 ? kSpins : 0;
+    if (spins_ < max_spins) {
+      spins_++;
+#if defined(__x86_64__)
+      _mm_pause();
+#endif
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+ private:
+  static constexpr int kSpins = 256;
+  int spins_ = 0;
+};
+
+// raw storage of a queue slot, the queues construct and destroy the item.
+template <class T>
+struct QueueSlot {
+  T* item() { return std::launder(reinterpret_cast<T*>(&storage)); }
+
+  std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+};
+
+}  // namespace internal
+
+// A queue of at most capacity items, rounded up to a power of 2, of one
+// producer thread and one consumer thread. The indices of both sides are on
+// cache lines of their own, an aligned queue is padded to a whole line.
+template <class T>
+class SpscQueue {
+ public:
+  explicit SpscQueue(size_t capacity) {
+    YASL_ENFORCE(capacity > 0, "capacity must > 0");
+    mask_ = absl::bit_ceil(capacity) - 1;
+    slots_ = std::make_unique<internal::QueueSlot<T>[]>(mask_ + 1);
+  }
+
+  ~SpscQueue() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    for (size_t i = head_.load(std::memory_order_relaxed); i != tail; i++) {
+      slots_[i & mask_].item()->~T();
+    }
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // false if the queue is full, the item is left untouched then.
+  bool TryPush(T&& item) { return Emplace(std::move(item)); }
+  bool TryPush(const T& item) { return Emplace(item); }
+
+  // nullopt if the queue is empty.
+  std::optional<T> TryPop() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return std::nullopt;
+      }
+    }
+    T* slot = slots_[head & mask_].item();
+    std::optional<T> item(std::move(*slot));
+    slot->~T();
+    head_.store(head + 1, std::memory_order_release);
+    return item;
+  }
+
+  // blocks while the queue is full. false if the queue was closed, the item
+  // is dropped then.
+  bool Push(T item) {
+    internal::QueueBackoff backoff;
+    while (!closed_.load(std::memory_order_relaxed)) {
+      if (TryPush(std::move(item))) {
+        return true;
+      }
+      backoff.Wait();
+    }
+    return false;
+  }
+
+  // blocks while the queue is empty. nullopt once it is closed and drained.
+  std::optional<T> Pop() {
+    internal::QueueBackoff backoff;
+    while (true) {
+      // items pushed before Close are seen by the pop after it.
+      const bool closed = closed_.load(std::memory_order_acquire);
+      if (auto item = TryPop()) {
+        return item;
+      }
+      if (closed) {
+        return std::nullopt;
+      }
+      backoff.Wait();
+    }
+  }
+
+  // no more pushes, pops drain what is left.
+  void Close() { closed_.store(true, std::memory_order_release); }
+
+  // approximate unless called by the producer or the consumer with the
+  // other one idle.
+  size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  template <class U>
+  bool Emplace(U&& item) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ > mask_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ > mask_) {
+        return false;
+      }
+    }
+    new (&slots_[tail & mask_].storage) T(std::forward<U>(item));
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t mask_;
+  std::unique_ptr<internal::QueueSlot<T>[]> slots_;
+  std::atomic<bool> closed_{false};
+
+  // of the consumer, with its copy of the tail to read the shared one only
+  // when the queue looks empty.
+  alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+  size_t cached_tail_ = 0;
+  // of the producer, likewise.
+  alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+  size_t cached_head_ = 0;
+};
+
+// A queue of at most capacity items, rounded up to a power of 2, of any
+// number of producer and consumer threads. Each slot has a sequence number
+// telling whether it is free for the push of a lap or full for its pop, so
+// that a push or pop claims its slot by one compare and swap.
+template <class T>
+class MpmcQueue {
+ public:
+  explicit MpmcQueue(size_t capacity) {
+    YASL_ENFORCE(capacity > 0, "capacity must > 0");
+    // a queue of 1 slot can not tell full from empty by sequence numbers.
+    mask_ = absl::bit_ceil(std::max<size_t>(capacity, 2)) - 1;
+    cells_ = std::make_unique<Cell[]>(mask_ + 1);
+    for (size_t i = 0; i <= mask_; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~MpmcQueue() {
+    while (TryPop()) {
+    }
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  // false if the queue is full, the item is left untouched then.
+  bool TryPush(T&& item) { return Emplace(std::move(item)); }
+  bool TryPush(const T& item) { return Emplace(item); }
+
+  // nullopt if the queue is empty.
+  std::optional<T> TryPop() {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq) -
+                        static_cast<std::ptrdiff_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return std::nullopt;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    T* slot = cell->slot.item();
+    std::optional<T> item(std::move(*slot));
+    slot->~T();
+    // free for the push of the next lap.
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return item;
+  }
+
+  // blocks while the queue is full. false if the queue was closed, the item
+  // is dropped then.
+  bool Push(T item) {
+    internal::QueueBackoff backoff;
+    while (!closed_.load(std::memory_order_relaxed)) {
+      if (TryPush(std::move(item))) {
+        return true;
+      }
+      backoff.Wait();
+    }
+    return false;
+  }
+
+  // blocks while the queue is empty. nullopt once it is closed and drained.
+  std::optional<T> Pop() {
+    internal::QueueBackoff backoff;
+    while (true) {
+      const bool closed = closed_.load(std::memory_order_acquire);
+      if (auto item = TryPop()) {
+        return item;
+      }
+      if (closed) {
+        return std::nullopt;
+      }
+      backoff.Wait();
+    }
+  }
+
+  // no more pushes, pops drain what is left.
+  void Close() { closed_.store(true, std::memory_order_release); }
+
+  // approximate while others push or pop.
+  size_t size() const {
+    const size_t enqueued = enqueue_pos_.load(std::memory_order_acquire);
+    const size_t dequeued = dequeue_pos_.load(std::memory_order_acquire);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    internal::QueueSlot<T> slot;
+  };
+
+  template <class U>
+  bool Emplace(U&& item) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[pos & mask_];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const auto diff =
+          static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    new (&cell->slot.storage) T(std::forward<U>(item));
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  std::atomic<bool> closed_{false};
+
+  alignas(kCacheLineSize) std::atomic<size_t> enqueue_pos_{0};
+  alignas(kCacheLineSize) std::atomic<size_t> dequeue_pos_{0};
+};
+
+}  // namespace yasl
@@ -0,0 +1,142 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/lockfree_queue.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace yasl {
+
+template <class Q>
+class LockfreeQueueTest : public ::testing::Test {};
+
+using Queues = ::testing::Types<SpscQueue<std::unique_ptr<int>>,
+                                MpmcQueue<std::unique_ptr<int>>>;
+TYPED_TEST_SUITE(LockfreeQueueTest, Queues);
+
+TYPED_TEST(LockfreeQueueTest, TryPushAndPop) {
+  TypeParam queue(3);
+  EXPECT_EQ(queue.capacity(), 4);
+  EXPECT_FALSE(queue.TryPop());
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(queue.TryPush(std::make_unique<int>(i)));
+  }
+  auto extra = std::make_unique<int>(4);
+  EXPECT_FALSE(queue.TryPush(std::move(extra)));
+  // left untouched by the failed push.
+  ASSERT_NE(extra, nullptr);
+  EXPECT_EQ(queue.size(), 4);
+  for (int i = 0; i < 4; i++) {
+    auto item = queue.TryPop();
+    ASSERT_TRUE(item);
+    EXPECT_EQ(**item, i);
+  }
+  EXPECT_FALSE(queue.TryPop());
+  // wraps around.
+  for (int lap = 0; lap < 10; lap++) {
+    EXPECT_TRUE(queue.TryPush(std::make_unique<int>(lap)));
+    EXPECT_EQ(**queue.TryPop(), lap);
+  }
+}
+
+TYPED_TEST(LockfreeQueueTest, Close) {
+  TypeParam queue(4);
+  EXPECT_TRUE(queue.Push(std::make_unique<int>(1)));
+  queue.Close();
+  EXPECT_FALSE(queue.Push(std::make_unique<int>(2)));
+  // drains what was pushed before.
+  EXPECT_EQ(**queue.Pop(), 1);
+  EXPECT_FALSE(queue.Pop());
+}
+
+TEST(LockfreeQueueTest, DestroysLeftItems) {
+  auto item = std::make_shared<int>(1);
+  {
+    SpscQueue<std::shared_ptr<int>> spsc(4);
+    MpmcQueue<std::shared_ptr<int>> mpmc(4);
+    spsc.TryPush(item);
+    spsc.TryPush(item);
+    mpmc.TryPush(item);
+    EXPECT_EQ(item.use_count(), 4);
+    spsc.TryPop();
+    EXPECT_EQ(item.use_count(), 3);
+  }
+  EXPECT_EQ(item.use_count(), 1);
+}
+
+TEST(SpscQueueTest, ProducerConsumer) {
+  constexpr int64_t kItems = 200000;
+  SpscQueue<int64_t> queue(64);
+  std::thread producer([&] {
+    for (int64_t i = 0; i < kItems; i++) {
+      ASSERT_TRUE(queue.Push(i));
+    }
+    queue.Close();
+  });
+  int64_t expected = 0;
+  while (auto item = queue.Pop()) {
+    ASSERT_EQ(*item, expected);
+    expected++;
+  }
+  producer.join();
+  EXPECT_EQ(expected, kItems);
+}
+
+TEST(MpmcQueueTest, ProducersConsumers) {
+  constexpr int kThreads = 4;
+  constexpr int64_t kItemsPerProducer = 50000;
+  MpmcQueue<int64_t> queue(16);
+  std::vector<std::thread> producers;
+  for (int t = 0; t < kThreads; t++) {
+    producers.emplace_back([&, t] {
+      for (int64_t i = 0; i < kItemsPerProducer; i++) {
+        queue.Push(t * kItemsPerProducer + i);
+      }
+    });
+  }
+  std::vector<int64_t> sums(kThreads, 0);
+  std::vector<int64_t> counts(kThreads, 0);
+  std::vector<std::thread> consumers;
+  for (int t = 0; t < kThreads; t++) {
+    consumers.emplace_back([&, t] {
+      while (auto item = queue.Pop()) {
+        sums[t] += *item;
+        counts[t]++;
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  queue.Close();
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+  int64_t sum = 0;
+  int64_t count = 0;
+  for (int t = 0; t < kThreads; t++) {
+    sum += sums[t];
+    count += counts[t];
+  }
+  const int64_t n = kThreads * kItemsPerProducer;
+  EXPECT_EQ(count, n);
+  EXPECT_EQ(sum, n * (n - 1) / 2);
+}
+
+}  // namespace yasl
@@ -0,0 +1,172 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/metrics.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "fmt/format.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl {
+
+namespace internal {
+
+size_t MetricStripe() {
+  static std::atomic<size_t> next_stripe = 0;
+  thread_local const size_t stripe =
+      next_stripe.fetch_add(1, std::memory_order_relaxed) % kMetricStripes;
+  return stripe;
+}
+
+}  // namespace internal
+
+namespace {
+
+struct Registry {
+  std::mutex mutex;
+  std::map<std::string, std::unique_ptr<Counter>, std::less<>> counters;
+  std::map<std::string, std::unique_ptr<Gauge>, std::less<>> gauges;
+  std::map<std::string, std::unique_ptr<MetricHistogram>, std::less<>>
+      histograms;
+
+  template <class T>
+  T& Get(std::map<std::string, std::unique_ptr<T>, std::less<>>* metrics,
+         std::string_view name) {
+    std::unique_lock lock(mutex);
+    auto it = metrics->find(name);
+    if (it != metrics->end()) {
+      return *it->second;
+    }
+    YASL_ENFORCE(!name.empty() && name.find_first_not_of(
+                                      "abcdefghijklmnopqrstuvwxyz"
+                                      "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                      "0123456789_:") == std::string::npos,
+                 "invalid metric name {}", name);
+    const int kinds = counters.count(name) + gauges.count(name) +
+                      histograms.count(name);
+    YASL_ENFORCE(kinds == 0, "metric {} is of another kind", name);
+    return *metrics->emplace(name, std::make_unique<T>()).first->second;
+  }
+};
+
+// never destroyed, metrics may be used by threads outliving main.
+Registry& GetRegistry() {
+  static auto* registry = new Registry;
+  return *registry;
+}
+
+}  // namespace
+
+uint64_t Counter::Value() const {
+  uint64_t value = 0;
+  for (const auto& stripe : stripes_) {
+    value += stripe.value.load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+void Counter::Reset() {
+  for (auto& stripe : stripes_) {
+    stripe.value.store(0, std::memory_order_relaxed);
+  }
+}
+
+HistogramSnapshot MetricHistogram::Snapshot() const {
+  HistogramSnapshot snapshot;
+  for (const auto& stripe : stripes_) {
+    snapshot.Merge(stripe.Snapshot());
+  }
+  return snapshot;
+}
+
+void MetricHistogram::Reset() {
+  for (auto& stripe : stripes_) {
+    stripe.Reset();
+  }
+}
+
+Counter& GetCounter(std::string_view name) {
+  auto& registry = GetRegistry();
+  return registry.Get(&registry.counters, name);
+}
+
+Gauge& GetGauge(std::string_view name) {
+  auto& registry = GetRegistry();
+  return registry.Get(&registry.gauges, name);
+}
+
+MetricHistogram& GetHistogram(std::string_view name) {
+  auto& registry = GetRegistry();
+  return registry.Get(&registry.histograms, name);
+}
+
+std::string MetricsToPrometheus() {
+  auto& registry = GetRegistry();
+  std::unique_lock lock(registry.mutex);
+  std::string out;
+  for (const auto& [name, counter] : registry.counters) {
+    out += fmt::format("# TYPE {} counter\n{} {}\n", name, name,
+                       counter->Value());
+  }
+  for (const auto& [name, gauge] : registry.gauges) {
+    out += fmt::format("# TYPE {} gauge\n{} {}\n", name, name, gauge->Value());
+  }
+  for (const auto& [name, histogram] : registry.histograms) {
+    out += fmt::format("# TYPE {} histogram\n", name);
+    out += histogram->Snapshot().ToPrometheus(name, "");
+  }
+  return out;
+}
+
+std::string MetricsToJson() {
+  auto& registry = GetRegistry();
+  std::unique_lock lock(registry.mutex);
+  // names need no escaping, see Registry::Get.
+  const auto join = [](const auto& metrics, auto&& format) {
+    std::string out;
+    for (const auto& [name, metric] : metrics) {
+      out += fmt::format("{}\"{}\": {}", out.empty() ? "" : ", ", name,
+                         format(*metric));
+    }
+    return out;
+  };
+  return fmt::format(
+      "{{\"counters\": {{{}}}, \"gauges\": {{{}}}, \"histograms\": {{{}}}}}",
+      join(registry.counters, [](const Counter& c) { return c.Value(); }),
+      join(registry.gauges, [](const Gauge& g) { return g.Value(); }),
+      join(registry.histograms, [](const MetricHistogram& h) {
+        const auto snapshot = h.Snapshot();
+        return fmt::format(
+            "{{\"count\": {}, \"sum\": {}, \"p50\": {}, \"p99\": {}}}",
+            snapshot.count, snapshot.sum, snapshot.Quantile(0.5),
+            snapshot.Quantile(0.99));
+      }));
+}
+
+void ResetMetrics() {
+  auto& registry = GetRegistry();
+  std::unique_lock lock(registry.mutex);
+  for (auto& [name, counter] : registry.counters) {
+    counter->Reset();
+  }
+  for (auto& [name, histogram] : registry.histograms) {
+    histogram->Reset();
+  }
+}
+
+}  // namespace yasl
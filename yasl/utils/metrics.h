@@ -0,0 +1,139 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Brief: process wide metrics of the protocols, so that a regression shows
+// which phase of which protocol it is in, beyond the byte counts of the
+// link.
+//
+//   void IknpRotSend(...) {
+//     static auto& ots = GetCounter("yasl_iknp_send_ots_total");
+//     static auto& time = GetHistogram("yasl_iknp_send_us");
+//     ScopedTimer timer(&time);
+//     ots.Add(n);
+//     ...
+//   }
+//
+// Metrics are created on first use and live as long as the process, so a
+// call site looks its metric up once. Counters and histograms are split in
+// stripes which threads pick round robin, so that threads rarely share a
+// cache line, and are summed when read. Names follow prometheus, snake
+// case, counters end with _total and times with their unit.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "yasl/utils/histogram.h"
+
+namespace yasl {
+
+namespace internal {
+
+inline constexpr size_t kMetricStripes = 16;
+
+// the stripe of the calling thread.
+size_t MetricStripe();
+
+}  // namespace internal
+
+class Counter {
+ public:
+  void Add(uint64_t n = 1) {
+    stripes_[internal::MetricStripe()].value.fetch_add(
+        n, std::memory_order_relaxed);
+  }
+
+  uint64_t Value() const;
+
+  void Reset();
+
+ private:
+  struct alignas(64) Stripe {
+    std::atomic<uint64_t> value = 0;
+  };
+
+  std::array<Stripe, internal::kMetricStripes> stripes_;
+};
+
+// a value which goes up and down, like bytes in flight.
+class Gauge {
+ public:
+  void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+  void Add(int64_t delta) {
+    value_.fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_ = 0;
+};
+
+// a Histogram per stripe.
+class MetricHistogram {
+ public:
+  void Add(uint64_t value) {
+    stripes_[internal::MetricStripe()].Add(value);
+  }
+
+  HistogramSnapshot Snapshot() const;
+
+  void Reset();
+
+ private:
+  std::array<Histogram, internal::kMetricStripes> stripes_;
+};
+
+// the metric `name`, created on first use. A name is of one kind only.
+Counter& GetCounter(std::string_view name);
+Gauge& GetGauge(std::string_view name);
+MetricHistogram& GetHistogram(std::string_view name);
+
+// all metrics, ordered by name, in the prometheus text format, or as json:
+//   {"counters": {name: value}, "gauges": {name: value},
+//    "histograms": {name: {"count", "sum", "p50", "p99"}}}
+// quantiles are upper bounds of power of 2 buckets.
+std::string MetricsToPrometheus();
+std::string MetricsToJson();
+
+// zeros counters and histograms, gauges are kept as they track a state.
+void ResetMetrics();
+
+// adds the microseconds of its lifetime to a histogram.
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(MetricHistogram* histogram)
+      : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+  ~ScopedTimer() {
+    histogram_->Add(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start_)
+                        .count());
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  MetricHistogram* const histogram_;
+  const std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace yasl
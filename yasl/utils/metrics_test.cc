@@ -0,0 +1,116 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/metrics.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl {
+
+TEST(MetricsTest, CounterShouldSumThreads) {
+  auto& counter = GetCounter("test_counter_total");
+  counter.Reset();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 8; t++) {
+    threads.emplace_back([] {
+      // looked up again, the same metric.
+      auto& c = GetCounter("test_counter_total");
+      for (size_t i = 0; i < 10000; i++) {
+        c.Add();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counter.Value(), 80000);
+  counter.Add(5);
+  EXPECT_EQ(counter.Value(), 80005);
+}
+
+TEST(MetricsTest, GaugeAndHistogramShouldOk) {
+  auto& gauge = GetGauge("test_gauge");
+  gauge.Set(10);
+  gauge.Add(-3);
+  EXPECT_EQ(gauge.Value(), 7);
+
+  auto& histogram = GetHistogram("test_histogram_us");
+  histogram.Reset();
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < 4; t++) {
+    threads.emplace_back([&] {
+      for (uint64_t i = 0; i < 100; i++) {
+        histogram.Add(i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto snapshot = histogram.Snapshot();
+  EXPECT_EQ(snapshot.count, 400);
+  EXPECT_EQ(snapshot.sum, 4 * 4950);
+  EXPECT_EQ(snapshot.Quantile(0.99), 127);
+
+  {
+    ScopedTimer timer(&histogram);
+  }
+  EXPECT_EQ(histogram.Snapshot().count, 401);
+}
+
+TEST(MetricsTest, NamesShouldBeChecked) {
+  GetCounter("test_kind_total");
+  EXPECT_THROW(GetGauge("test_kind_total"), EnforceNotMet);
+  EXPECT_THROW(GetHistogram("test_kind_total"), EnforceNotMet);
+  EXPECT_THROW(GetCounter("bad name"), EnforceNotMet);
+  EXPECT_THROW(GetCounter(""), EnforceNotMet);
+}
+
+TEST(MetricsTest, ExportShouldOk) {
+  GetCounter("test_export_total").Reset();
+  GetCounter("test_export_total").Add(3);
+  GetGauge("test_export_gauge").Set(-2);
+  auto& histogram = GetHistogram("test_export_us");
+  histogram.Reset();
+  histogram.Add(5);
+
+  const auto text = MetricsToPrometheus();
+  EXPECT_NE(text.find("# TYPE test_export_total counter\n"
+                      "test_export_total 3\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("test_export_gauge -2\n"), std::string::npos);
+  EXPECT_NE(text.find("test_export_us_bucket{le=\"7\"} 1\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("test_export_us_count 1\n"), std::string::npos);
+
+  const auto json = MetricsToJson();
+  EXPECT_EQ(json.front(), '{');
+  EXPECT_NE(json.find("\"test_export_total\": 3"), std::string::npos);
+  EXPECT_NE(json.find("\"test_export_gauge\": -2"), std::string::npos);
+  EXPECT_NE(json.find("\"test_export_us\": {\"count\": 1, \"sum\": 5, "
+                      "\"p50\": 7, \"p99\": 7}"),
+            std::string::npos);
+
+  ResetMetrics();
+  EXPECT_EQ(GetCounter("test_export_total").Value(), 0);
+  EXPECT_EQ(GetGauge("test_export_gauge").Value(), -2);
+  EXPECT_EQ(histogram.Snapshot().count, 0);
+}
+
+}  // namespace yasl
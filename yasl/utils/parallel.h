@@ -1,9 +1,14 @@
 // Copyright (c) 2016 Facebook Inc.
 #pragma once
 
+#include <memory>
+#include <string>
+
 #include "yasl/base/exception.h"
 
 namespace yasl {
+
+class ThreadPool;
 namespace internal {
 // This parameter is heuristically chosen to determine the minimum number of
 // work that warrants parallelism. For example, when summing an array, it is
@@ -15,15 +20,70 @@ constexpr int64_t GRAIN_SIZE = 32768;
 
 inline int64_t divup(int64_t x, int64_t y) { return (x + y - 1) / y; }
 
+// How parallel_for hands out the chunks of the range.
+enum class Schedule {
+  // one contiguous chunk per thread. cheapest for uniform bodies.
+  kStatic,
+  // chunks of grain_size, taken from a shared counter by whichever thread
+  // is free.
+  kDynamic,
+  // like kDynamic, but a chunk is 1 / (2 * tasks) of what is left, down to
+  // grain_size. fewer claims than kDynamic, still no stragglers.
+  kGuided,
+};
+
+// grain_size of parallel_for that is calibrated on the range: the calling
+// thread runs growing probe chunks until one is long enough to time, then
+// picks chunks of about 50us for the rest.
+constexpr int64_t kAutoGrainSize = -1;
+
 // Called during new thread initialization
 void init_num_threads();
 
-// Sets the number of threads to be used in parallel region
+// Sets the number of threads of the global intra-op pool. Once the pool is
+// running, it is replaced by one of the new size; regions running meanwhile
+// finish on the old one.
 void set_num_threads(int);
 
-// Returns the number of threads used in parallel region
+// Returns the number of threads used in parallel region, of the pool of the
+// ThreadPoolScope if any.
 int get_num_threads();
 
+// Starts the global intra-op pool now instead of at the first parallel
+// region, so that spawning its threads is off the latency of that region.
+void warm_up_intraop_pool();
+
+// Sets the cpu binding of the intra-op pool threads, a spec of
+// ParseThreadAffinity like "cores" or "node:1". Defaults to the
+// YASL_THREAD_AFFINITY environment variable, else no binding. It must be
+// called before parallel work has started.
+void set_thread_affinity(const std::string& spec);
+
+// A pool for parallel regions of nthreads threads, the calling thread
+// included, bound by an affinity spec like set_thread_affinity takes. nullptr
+// for a single thread, which needs no pool. For ThreadPoolScope, so that
+// several jobs of one process each get a share of the cores.
+std::shared_ptr<ThreadPool> MakeIntraopPool(int nthreads,
+                                            const std::string& affinity = "");
+
+// Parallel regions started by the calling thread run on pool instead of the
+// global intra-op pool for the lifetime of the scope, nested regions run on
+// the pool of the outer one. A null pool runs them on the calling thread.
+// Scopes nest, each restores the pool of the one around it.
+class ThreadPoolScope {
+ public:
+  explicit ThreadPoolScope(std::shared_ptr<ThreadPool> pool);
+  ~ThreadPoolScope();
+
+  ThreadPoolScope(const ThreadPoolScope&) = delete;
+  ThreadPoolScope& operator=(const ThreadPoolScope&) = delete;
+
+ private:
+  const std::shared_ptr<ThreadPool> pool_;
+  const bool prev_active_;
+  ThreadPool* const prev_pool_;
+};
+
 // Returns the current thread number (starting from 0)
 // in the current parallel region, or 0 in the sequential region
 int get_thread_num();
@@ -43,6 +103,9 @@ grain_size: number of elements per chunk. impacts the degree of parallelization
 f: user function applied in parallel to the chunks, signature:
   void f(int64_t begin, int64_t end)
 
+Nested calls split onto the same pool as the outer one. A thread waiting for
+its chunks runs other queued tasks meanwhile, so it never blocks a worker.
+
 Warning: parallel_for does NOT copy thread local
 states from the current thread to the worker threads.
 This means for example that Tensor operations CANNOT be used in the
@@ -52,6 +115,12 @@ template <class F>
 inline void parallel_for(int64_t begin, int64_t end, int64_t grain_size,
                          const F& f);
 
+// parallel_for with a schedule, for irregular bodies where a static split
+// leaves stragglers. grain_size may be kAutoGrainSize.
+template <class F>
+inline void parallel_for(int64_t begin, int64_t end, int64_t grain_size,
+                         Schedule schedule, const F& f);
+
 /*
 parallel_reduce
 
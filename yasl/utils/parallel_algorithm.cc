@@ -0,0 +1,97 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/parallel_algorithm.h"
+
+#include <array>
+
+namespace yasl {
+
+namespace {
+
+// the top bits scatter the keys into this many buckets, which are sorted
+// independently.
+constexpr int kTopBits = 11;
+// below this, std::sort beats the radix passes.
+constexpr int64_t kMinRadixSize = 256;
+
+// LSD radix sort of n keys at src by their low `bits` bits, a byte per
+// pass, ping-ponging with dst. returns which of the two holds the result.
+template <class Key>
+Key* LsdRadixSort(Key* src, Key* dst, int64_t n, int bits) {
+  for (int shift = 0; shift < bits; shift += 8) {
+    std::array<int64_t, 256> offsets{};
+    for (int64_t i = 0; i < n; ++i) {
+      offsets[static_cast<uint8_t>(src[i] >> shift)]++;
+    }
+    // every key has the same byte here, the pass would not move anything.
+    if (offsets[static_cast<uint8_t>(src[0] >> shift)] == n) {
+      continue;
+    }
+    int64_t pos = 0;
+    for (auto& offset : offsets) {
+      const int64_t count = offset;
+      offset = pos;
+      pos += count;
+    }
+    for (int64_t i = 0; i < n; ++i) {
+      dst[offsets[static_cast<uint8_t>(src[i] >> shift)]++] = src[i];
+    }
+    std::swap(src, dst);
+  }
+  return src;
+}
+
+template <class Key>
+void RadixSort(absl::Span<Key> keys) {
+  constexpr int kKeyBits = sizeof(Key) * 8;
+  const int64_t n = keys.size();
+  if (n < kMinRadixSize * 2) {
+    std::sort(keys.begin(), keys.end());
+    return;
+  }
+  std::vector<Key> scratch(n);
+  const auto starts = internal::_parallel_bucket_scatter(
+      keys, scratch.data(), size_t{1} << kTopBits,
+      [](Key key) { return static_cast<size_t>(key >> (kKeyBits - kTopBits)); },
+      internal::GRAIN_SIZE);
+  parallel_for(0, int64_t{1} << kTopBits, 1, Schedule::kDynamic,
+               [&](int64_t begin, int64_t end) {
+                 for (int64_t b = begin; b < end; ++b) {
+                   Key* src = scratch.data() + starts[b];
+                   Key* dst = keys.data() + starts[b];
+                   const int64_t size = starts[b + 1] - starts[b];
+                   if (size == 0) {
+                     continue;
+                   }
+                   if (size < kMinRadixSize) {
+                     std::sort(src, src + size);
+                   } else {
+                     // the top bits are the same in a bucket.
+                     src = LsdRadixSort(src, dst, size, kKeyBits - kTopBits);
+                   }
+                   if (src != dst) {
+                     std::copy(src, src + size, dst);
+                   }
+                 }
+               });
+}
+
+}  // namespace
+
+void parallel_radix_sort(absl::Span<uint64_t> keys) { RadixSort(keys); }
+
+void parallel_radix_sort(absl::Span<uint128_t> keys) { RadixSort(keys); }
+
+}  // namespace yasl
@@ -0,0 +1,220 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Brief: scan, partition and sort on top of parallel_for.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "absl/types/span.h"
+
+#include "yasl/base/exception.h"
+#include "yasl/base/int128.h"
+#include "yasl/utils/parallel.h"
+
+namespace yasl {
+
+// out[i] = sf(...sf(sf(ident, in[0]), in[1])..., in[i]), the inclusive
+// prefix "sums" of in. sf must be associative. out may be in.
+template <class T, class SF>
+void parallel_scan(absl::Span<const T> in, absl::Span<T> out, const T& ident,
+                   const SF& sf, int64_t grain_size = internal::GRAIN_SIZE);
+
+// stably moves the elements of data for which pred holds in front of the
+// others, returns how many there are. pred is called twice per element.
+template <class T, class Pred>
+size_t parallel_stable_partition(absl::Span<T> data, const Pred& pred,
+                                 int64_t grain_size = internal::GRAIN_SIZE);
+
+// sorts data by comp, not stable. a sample sort: the elements are scattered
+// into buckets between sampled splitters, then the buckets are sorted in
+// parallel. needs a copy of data as scratch.
+template <class T, class Compare = std::less<T>>
+void parallel_sort(absl::Span<T> data, const Compare& comp = Compare(),
+                   int64_t grain_size = internal::GRAIN_SIZE);
+
+// sorts integer keys, such as hashes, in increasing order. the keys are
+// scattered into 2048 buckets by their top bits, then every bucket is radix
+// sorted a byte at a time. needs a copy of keys as scratch.
+void parallel_radix_sort(absl::Span<uint64_t> keys);
+void parallel_radix_sort(absl::Span<uint128_t> keys);
+
+namespace internal {
+
+// chunks of at least grain_size, a few per thread so that dynamic
+// scheduling can even out slow chunks.
+inline int64_t _algorithm_chunk_size(int64_t n, int64_t grain_size) {
+  YASL_ENFORCE(grain_size > 0);
+  return std::max(grain_size, divup(n, 4 * get_num_threads()));
+}
+
+// runs f(c, begin, end) for the chunks [begin, end) of [0, n), dynamically
+// scheduled.
+template <class F>
+void _parallel_for_chunks(int64_t n, int64_t chunk, const F& f) {
+  parallel_for(0, divup(n, chunk), 1, Schedule::kDynamic,
+               [&](int64_t begin, int64_t end) {
+                 for (int64_t c = begin; c < end; ++c) {
+                   f(c, c * chunk, std::min(n, c * chunk + chunk));
+                 }
+               });
+}
+
+// moves data into out ordered by bucket_of(x) in [0, num_buckets), keeping
+// the order within a bucket. returns where every bucket starts in out, and
+// data.size() at the end.
+template <class T, class BucketOf>
+std::vector<int64_t> _parallel_bucket_scatter(absl::Span<T> data, T* out,
+                                              size_t num_buckets,
+                                              const BucketOf& bucket_of,
+                                              int64_t grain_size) {
+  const int64_t n = data.size();
+  const int64_t chunk = _algorithm_chunk_size(n, grain_size);
+  const int64_t num_chunks = divup(n, chunk);
+  // counts of chunk c are at c * num_buckets, then their offsets in out.
+  std::vector<int64_t> offsets(num_chunks * num_buckets);
+  _parallel_for_chunks(n, chunk, [&](int64_t c, int64_t begin, int64_t end) {
+    int64_t* count = &offsets[c * num_buckets];
+    for (int64_t i = begin; i < end; ++i) {
+      count[bucket_of(data[i])]++;
+    }
+  });
+  std::vector<int64_t> starts(num_buckets + 1);
+  int64_t pos = 0;
+  for (size_t b = 0; b < num_buckets; ++b) {
+    starts[b] = pos;
+    for (int64_t c = 0; c < num_chunks; ++c) {
+      const int64_t count = offsets[c * num_buckets + b];
+      offsets[c * num_buckets + b] = pos;
+      pos += count;
+    }
+  }
+  starts[num_buckets] = n;
+  _parallel_for_chunks(n, chunk, [&](int64_t c, int64_t begin, int64_t end) {
+    int64_t* next = &offsets[c * num_buckets];
+    for (int64_t i = begin; i < end; ++i) {
+      out[next[bucket_of(data[i])]++] = std::move(data[i]);
+    }
+  });
+  return starts;
+}
+
+}  // namespace internal
+
+template <class T, class SF>
+void parallel_scan(absl::Span<const T> in, absl::Span<T> out, const T& ident,
+                   const SF& sf, int64_t grain_size) {
+  YASL_ENFORCE_EQ(in.size(), out.size());
+  const int64_t n = in.size();
+  const int64_t chunk = internal::_algorithm_chunk_size(n, grain_size);
+  const int64_t num_chunks = divup(n, chunk);
+  if (num_chunks <= 1) {
+    T acc = ident;
+    for (int64_t i = 0; i < n; ++i) {
+      acc = sf(acc, in[i]);
+      out[i] = acc;
+    }
+    return;
+  }
+  // the total of every chunk, then the total of the chunks before it.
+  std::vector<T> carries(num_chunks, ident);
+  internal::_parallel_for_chunks(
+      n, chunk, [&](int64_t c, int64_t begin, int64_t end) {
+        T acc = ident;
+        for (int64_t i = begin; i < end; ++i) {
+          acc = sf(acc, in[i]);
+        }
+        carries[c] = acc;
+      });
+  T carry = ident;
+  for (auto& total : carries) {
+    T next = sf(carry, total);
+    total = carry;
+    carry = std::move(next);
+  }
+  internal::_parallel_for_chunks(
+      n, chunk, [&](int64_t c, int64_t begin, int64_t end) {
+        T acc = carries[c];
+        for (int64_t i = begin; i < end; ++i) {
+          acc = sf(acc, in[i]);
+          out[i] = acc;
+        }
+      });
+}
+
+template <class T, class Pred>
+size_t parallel_stable_partition(absl::Span<T> data, const Pred& pred,
+                                 int64_t grain_size) {
+  std::vector<T> scratch(data.size());
+  const auto starts = internal::_parallel_bucket_scatter(
+      data, scratch.data(), 2,
+      [&pred](const T& x) { return pred(x) ? 0 : 1; }, grain_size);
+  parallel_for(0, data.size(), grain_size, [&](int64_t begin, int64_t end) {
+    std::move(scratch.begin() + begin, scratch.begin() + end,
+              data.begin() + begin);
+  });
+  return starts[1];
+}
+
+template <class T, class Compare>
+void parallel_sort(absl::Span<T> data, const Compare& comp,
+                   int64_t grain_size) {
+  YASL_ENFORCE(grain_size > 0);
+  const int64_t n = data.size();
+  const int64_t num_buckets =
+      std::min<int64_t>(4 * get_num_threads(), n / grain_size);
+  if (num_buckets <= 1) {
+    std::sort(data.begin(), data.end(), comp);
+    return;
+  }
+
+  // splitters from a sorted random sample, oversampled so that the buckets
+  // come out of similar sizes.
+  constexpr int64_t kOversample = 32;
+  std::mt19937_64 rng(n);
+  std::vector<T> sample(num_buckets * kOversample);
+  for (auto& x : sample) {
+    x = data[rng() % n];
+  }
+  std::sort(sample.begin(), sample.end(), comp);
+  std::vector<T> splitters(num_buckets - 1);
+  for (int64_t b = 1; b < num_buckets; ++b) {
+    splitters[b - 1] = sample[b * kOversample];
+  }
+
+  std::vector<T> scratch(n);
+  const auto starts = internal::_parallel_bucket_scatter(
+      data, scratch.data(), num_buckets,
+      [&](const T& x) {
+        return std::upper_bound(splitters.begin(), splitters.end(), x, comp) -
+               splitters.begin();
+      },
+      grain_size);
+  parallel_for(0, num_buckets, 1, Schedule::kDynamic,
+               [&](int64_t begin, int64_t end) {
+                 for (int64_t b = begin; b < end; ++b) {
+                   auto first = scratch.begin() + starts[b];
+                   auto last = scratch.begin() + starts[b + 1];
+                   std::sort(first, last, comp);
+                   std::move(first, last, data.begin() + starts[b]);
+                 }
+               });
+}
+
+}  // namespace yasl
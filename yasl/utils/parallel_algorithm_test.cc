@@ -0,0 +1,132 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/parallel_algorithm.h"
+
+#include <numeric>
+#include <random>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+namespace yasl {
+
+class ParallelAlgorithmTest : public testing::TestWithParam<size_t> {
+ protected:
+  void SetUp() override {
+    init_num_threads();
+    set_num_threads(4);
+  }
+};
+
+TEST_P(ParallelAlgorithmTest, Scan) {
+  const size_t n = GetParam();
+  std::mt19937_64 rng(n);
+  std::vector<int64_t> in(n);
+  for (auto& x : in) {
+    x = rng() % 1000;
+  }
+  std::vector<int64_t> expected(n);
+  std::partial_sum(in.begin(), in.end(), expected.begin());
+
+  std::vector<int64_t> out(n);
+  parallel_scan<int64_t>(in, absl::MakeSpan(out), 0, std::plus<int64_t>(),
+                         100);
+  EXPECT_EQ(out, expected);
+  // in place, and not commutative: composition of x -> a * x + b.
+  using Affine = std::pair<uint64_t, uint64_t>;
+  auto compose = [](const Affine& f, const Affine& g) {
+    return Affine(f.first * g.first, g.first * f.second + g.second);
+  };
+  std::vector<Affine> fs(n);
+  for (auto& f : fs) {
+    f = {rng() | 1, rng()};
+  }
+  std::vector<Affine> expected_fs(n);
+  Affine acc(1, 0);
+  for (size_t i = 0; i < n; ++i) {
+    acc = compose(acc, fs[i]);
+    expected_fs[i] = acc;
+  }
+  parallel_scan<Affine>(fs, absl::MakeSpan(fs), Affine(1, 0), compose, 100);
+  EXPECT_EQ(fs, expected_fs);
+}
+
+TEST_P(ParallelAlgorithmTest, StablePartition) {
+  const size_t n = GetParam();
+  std::mt19937_64 rng(n);
+  std::vector<std::pair<int, size_t>> data(n);
+  for (size_t i = 0; i < n; ++i) {
+    data[i] = {static_cast<int>(rng() % 7), i};
+  }
+  auto pred = [](const std::pair<int, size_t>& x) { return x.first < 3; };
+  auto expected = data;
+  const size_t expected_count =
+      std::stable_partition(expected.begin(), expected.end(), pred) -
+      expected.begin();
+  EXPECT_EQ(parallel_stable_partition(absl::MakeSpan(data), pred, 100),
+            expected_count);
+  EXPECT_EQ(data, expected);
+}
+
+TEST_P(ParallelAlgorithmTest, Sort) {
+  const size_t n = GetParam();
+  std::mt19937_64 rng(n);
+  std::vector<uint32_t> data(n);
+  for (auto& x : data) {
+    // plenty of duplicates.
+    x = rng() % (n / 4 + 1);
+  }
+  auto expected = data;
+  std::sort(expected.begin(), expected.end(), std::greater<uint32_t>());
+  parallel_sort(absl::MakeSpan(data), std::greater<uint32_t>(), 100);
+  EXPECT_EQ(data, expected);
+
+  // sorted and constant inputs.
+  parallel_sort(absl::MakeSpan(data), std::less<uint32_t>(), 100);
+  EXPECT_TRUE(std::is_sorted(data.begin(), data.end()));
+  std::fill(data.begin(), data.end(), 7);
+  parallel_sort(absl::MakeSpan(data), std::less<uint32_t>(), 100);
+  EXPECT_EQ(data, std::vector<uint32_t>(n, 7));
+}
+
+TEST_P(ParallelAlgorithmTest, RadixSort) {
+  const size_t n = GetParam();
+  std::mt19937_64 rng(n);
+  std::vector<uint64_t> keys64(n);
+  std::vector<uint128_t> keys128(n);
+  for (size_t i = 0; i < n; ++i) {
+    keys64[i] = rng();
+    keys128[i] = MakeUint128(rng(), rng());
+    // keys that share top bits, and small ones.
+    if (i % 3 == 0) {
+      keys64[i] = i % 5;
+      keys128[i] = MakeUint128(keys64[i - i % 6], i % 11);
+    }
+  }
+  auto expected64 = keys64;
+  std::sort(expected64.begin(), expected64.end());
+  auto expected128 = keys128;
+  std::sort(expected128.begin(), expected128.end());
+
+  parallel_radix_sort(absl::MakeSpan(keys64));
+  EXPECT_EQ(keys64, expected64);
+  parallel_radix_sort(absl::MakeSpan(keys128));
+  EXPECT_TRUE(keys128 == expected128);
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, ParallelAlgorithmTest,
+                         testing::Values(0, 1, 99, 100, 1000, 12345, 300000));
+
+}  // namespace yasl
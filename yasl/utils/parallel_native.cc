@@ -1,8 +1,17 @@
 // Copyright (c) 2016 Facebook Inc.
 #include <atomic>
-#include <future>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "absl/container/inlined_vector.h"
 
 #include "yasl/utils/parallel.h"
+#include "yasl/utils/thread_affinity.h"
 #include "yasl/utils/thread_pool.h"
 
 namespace yasl {
@@ -20,8 +29,6 @@ void _set_in_parallel_region(bool in_region) {
 
 void _set_thread_num(size_t thread_num) { thread_num_ = thread_num; }
 
-void _unset_thread_num() { thread_num_ = 0; }
-
 const int NOT_SET = -1;
 const int CONSUMED = -2;
 
@@ -35,74 +42,316 @@ const int CONSUMED = -2;
 //  - CONSUMED - pool is initialized
 std::atomic<int> num_intraop_threads{NOT_SET};
 
-int _num_pool_threads(int nthreads) {
+int _num_threads(int nthreads) {
   if (nthreads == NOT_SET) {
     nthreads = intraop_default_num_threads();
   } else {
     YASL_ENFORCE(nthreads > 0);
   }
+  return nthreads;
+}
+
+// affinity spec set by the user, read when the pool is created.
+std::mutex affinity_mutex;
+std::string affinity_spec;
+bool affinity_set = false;
+
+std::string _affinity_spec() {
+  std::lock_guard<std::mutex> lock(affinity_mutex);
+  if (affinity_set) {
+    return affinity_spec;
+  }
+  const char* env = std::getenv("YASL_THREAD_AFFINITY");
+  return env == nullptr ? "" : env;
+}
+
+// the pool of the ThreadPoolScope of this thread, a null pool runs regions
+// on the thread. pooled threads get the pool of the region they work for.
+struct PoolScope {
+  bool active = false;
+  ThreadPool* pool = nullptr;
+};
+thread_local PoolScope pool_scope_;
+
+std::shared_ptr<ThreadPool> _make_pool(int nthreads, const std::string& spec) {
+  YASL_ENFORCE(nthreads > 0);
+  if (nthreads == 1) {
+    return nullptr;
+  }
   // minus one because of the master thread
-  return nthreads - 1;
+  return std::make_shared<ThreadPool>(nthreads - 1,
+                                      ParseThreadAffinity(spec, nthreads - 1));
+}
+
+// the global pool, null for one thread. set_num_threads replaces it, running
+// regions hold a reference to theirs.
+struct GlobalPool {
+  std::mutex mutex;
+  std::shared_ptr<ThreadPool> pool;
+};
+
+GlobalPool& _global_pool() {
+  static GlobalPool global;
+  static std::once_flag once;
+  std::call_once(once, [] {
+    global.pool = _make_pool(
+        _num_threads(num_intraop_threads.exchange(CONSUMED)), _affinity_spec());
+  });
+  return global;
 }
 
-ThreadPool& _get_intraop_pool() {
-  static std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(
-      _num_pool_threads(num_intraop_threads.exchange(CONSUMED)));
-  return *pool;
+std::shared_ptr<ThreadPool> _get_intraop_pool() {
+  auto& global = _global_pool();
+  std::lock_guard<std::mutex> lock(global.mutex);
+  return global.pool;
+}
+
+// the pool regions of this thread run on, and its owner if it is the global
+// one.
+ThreadPool* _current_pool(std::shared_ptr<ThreadPool>* owner) {
+  if (pool_scope_.active) {
+    return pool_scope_.pool;
+  }
+  *owner = _get_intraop_pool();
+  return owner->get();
 }
 
 // RAII guard helps to support in_parallel_region() and get_thread_num() API.
+// the previous state is restored, a thread may run tasks of an inner region
+// or of another region while it waits for its own.
 struct ParallelRegionGuard {
-  ParallelRegionGuard(int64_t task_id) {
+  ParallelRegionGuard(int64_t task_id)
+      : prev_in_region_(in_parallel_region_), prev_thread_num_(thread_num_) {
     _set_thread_num(task_id);
     _set_in_parallel_region(true);
   }
 
   ~ParallelRegionGuard() {
-    _set_in_parallel_region(false);
-    _unset_thread_num();
+    _set_in_parallel_region(prev_in_region_);
+    _set_thread_num(prev_thread_num_);
   }
+
+ private:
+  const bool prev_in_region_;
+  const size_t prev_thread_num_;
+};
+
+// countdown latch of the tasks of one _parallel_run, keeps the first
+// exception. only the last task takes the mutex.
+class TaskGroup {
+ public:
+  explicit TaskGroup(size_t num_tasks) : remaining_(num_tasks) {}
+
+  void Done(std::exception_ptr error) {
+    if (error) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = std::move(error);
+      }
+    }
+    if (remaining_.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+      cv_.notify_all();
+    }
+  }
+
+  // runs queued tasks of pool until all tasks of the group are done, instead
+  // of blocking, then rethrows the first exception of the group.
+  void Wait(ThreadPool* pool) {
+    int idle = 0;
+    while (!done_.load()) {
+      if (pool != nullptr && pool->TryRunOne()) {
+        idle = 0;
+        continue;
+      }
+      // the group's tasks are running elsewhere. poll for a while, then
+      // sleep but wake up now and then to help with tasks queued meanwhile.
+      if (++idle < kSpinRounds) {
+        std::this_thread::yield();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait_for(lock, std::chrono::microseconds(100),
+                   [&] { return done_.load(); });
+    }
+    // the last Done may still hold the mutex.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+ private:
+  static constexpr int kSpinRounds = 64;
+
+  std::atomic<size_t> remaining_;
+  std::atomic<bool> done_{false};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::exception_ptr error_;
+};
+
+// state of one _parallel_run, lives in the caller's frame.
+struct ParallelRun {
+  ParallelRun(int64_t begin, int64_t end, size_t chunk_size,
+              const absl::FunctionRef<void(int64_t, int64_t, size_t)>& f,
+              size_t num_tasks, ThreadPool* pool)
+      : begin(begin),
+        end(end),
+        chunk_size(chunk_size),
+        f(f),
+        group(num_tasks),
+        pool(pool) {}
+
+  void RunChunk(size_t task_id) {
+    std::exception_ptr error;
+    try {
+      int64_t local_start = begin + task_id * chunk_size;
+      if (local_start < end) {
+        int64_t local_end =
+            std::min(end, static_cast<int64_t>(chunk_size + local_start));
+        ParallelRegionGuard guard(task_id);
+        // nested regions run on the same pool.
+        const PoolScope prev_scope = pool_scope_;
+        pool_scope_ = {true, pool};
+        try {
+          f(local_start, local_end, task_id);
+        } catch (...) {
+          pool_scope_ = prev_scope;
+          throw;
+        }
+        pool_scope_ = prev_scope;
+      }
+    } catch (...) {
+      error = std::current_exception();
+    }
+    group.Done(std::move(error));
+  }
+
+  const int64_t begin;
+  const int64_t end;
+  const size_t chunk_size;
+  const absl::FunctionRef<void(int64_t, int64_t, size_t)> f;
+  TaskGroup group;
+  ThreadPool* const pool;
+};
+
+// task descriptor of one chunk, posted to the pool without allocation.
+struct ChunkTask final : ThreadPool::Task {
+  void Run() override { run->RunChunk(task_id); }
+
+  ParallelRun* run = nullptr;
+  size_t task_id = 0;
 };
 
 }  // namespace
 
 namespace internal {
 
-void _parallel_run(const int64_t begin, const int64_t end,
-                   const int64_t grain_size,
-                   const std::function<void(int64_t, int64_t, size_t)>& f) {
+void _parallel_run(
+    const int64_t begin, const int64_t end, const int64_t grain_size,
+    const absl::FunctionRef<void(int64_t, int64_t, size_t)>& f) {
+  _parallel_run(begin, end, grain_size, [](size_t /* unused */) {}, f);
+}
+
+void _parallel_run(
+    const int64_t begin, const int64_t end, const int64_t grain_size,
+    const absl::FunctionRef<void(size_t)>& init,
+    const absl::FunctionRef<void(int64_t, int64_t, size_t)>& f) {
+  // keeps a global pool alive, set_num_threads may replace it meanwhile.
+  std::shared_ptr<ThreadPool> owner;
+  ThreadPool* pool = _current_pool(&owner);
+  // split by the pool taken, not by a later get_num_threads().
+  const int num_threads =
+      pool == nullptr ? 1 : static_cast<int>(pool->NumThreads()) + 1;
   size_t num_tasks;
   size_t chunk_size;
-  std::tie(num_tasks, chunk_size) =
-      internal::calc_num_tasks_and_chunk_size(begin, end, grain_size);
-
-  auto task = [f, begin, end, chunk_size](size_t task_id) {
-    int64_t local_start = begin + task_id * chunk_size;
-    if (local_start < end) {
-      int64_t local_end =
-          std::min(end, static_cast<int64_t>(chunk_size + local_start));
-      {
-        ParallelRegionGuard guard(task_id);
-        f(local_start, local_end, task_id);
-      }
-    }
-  };
+  std::tie(num_tasks, chunk_size) = internal::calc_num_tasks_and_chunk_size(
+      begin, end, grain_size, num_threads);
+  init(num_tasks);
 
-  // submit tasks
-  std::vector<std::future<void>> futures;
-  futures.reserve(num_tasks);
+  ParallelRun run(begin, end, chunk_size, f, num_tasks, pool);
+  // num_tasks is at most the number of threads, the descriptors fit on the
+  // stack on most machines.
+  absl::InlinedVector<ChunkTask, 32> tasks(num_tasks);
+  // post tasks. nested calls from a pooled thread go to its own deque.
   for (size_t i = 1; i < num_tasks; ++i) {
-    futures.push_back(_get_intraop_pool().Submit(task, i));
+    tasks[i].run = &run;
+    tasks[i].task_id = i;
+    pool->Post(&tasks[i]);
   }
   // Run the first task on the current thread directly.
-  task(0);
+  run.RunChunk(0);
+
+  // Wait for all tasks to finish, helping the pool meanwhile. the tasks
+  // refer to this frame, so even a failed task 0 waits for the others.
+  run.group.Wait(pool);
+}
+
+void _parallel_run_scheduled(
+    const int64_t begin, const int64_t end, const int64_t grain_size,
+    const Schedule schedule,
+    const absl::FunctionRef<void(int64_t, int64_t)>& f) {
+  const int64_t num_tasks =
+      std::min<int64_t>(get_num_threads(), divup(end - begin, grain_size));
+  // every task claims chunks from next until the range is used up.
+  std::atomic<int64_t> next(begin);
+  auto claim = [&](int64_t* chunk_begin, int64_t* chunk_end) {
+    if (schedule == Schedule::kDynamic) {
+      *chunk_begin = next.fetch_add(grain_size);
+      *chunk_end = std::min(end, *chunk_begin + grain_size);
+      return *chunk_begin < end;
+    }
+    int64_t start = next.load();
+    while (start < end) {
+      const int64_t size =
+          std::max(grain_size, (end - start) / (2 * num_tasks));
+      const int64_t stop = std::min(end, start + size);
+      if (next.compare_exchange_weak(start, stop)) {
+        *chunk_begin = start;
+        *chunk_end = stop;
+        return true;
+      }
+    }
+    return false;
+  };
+  _parallel_run(0, num_tasks, 1,
+                [&](int64_t /* unused */, int64_t /* unused */,
+                    size_t /* unused */) {
+                  int64_t chunk_begin;
+                  int64_t chunk_end;
+                  while (claim(&chunk_begin, &chunk_end)) {
+                    f(chunk_begin, chunk_end);
+                  }
+                });
+}
 
-  // Wait for all tasks to finish.
-  for (auto& future : futures) {
-    // wait and throw exception.
-    // if the task in thread pool throws an exception, the get() will rethrow it
-    future.get();
+int64_t _calibrate_grain_size(
+    int64_t begin, const int64_t end,
+    const absl::FunctionRef<void(int64_t, int64_t)>& f, int64_t* grain_size) {
+  // a probe shorter than this is mostly timer noise.
+  constexpr int64_t kMinProbeNs = 10000;
+  // dispatch costs about a microsecond, chunks of this keep it negligible
+  // and still balance well.
+  constexpr double kTargetChunkNs = 50000;
+  int64_t probe = 1;
+  *grain_size = 1;
+  while (begin < end) {
+    const int64_t n = std::min(probe, end - begin);
+    const auto start = std::chrono::steady_clock::now();
+    f(begin, begin + n);
+    const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+    begin += n;
+    if (ns >= kMinProbeNs) {
+      *grain_size = std::max<int64_t>(1, kTargetChunkNs * n / ns);
+      break;
+    }
+    probe *= 2;
   }
+  return begin;
 }
 
 }  // namespace internal
@@ -112,26 +361,49 @@ void init_num_threads() {}
 void set_num_threads(int nthreads) {
   YASL_ENFORCE(nthreads > 0);
   int no_value = NOT_SET;
-  if (!num_intraop_threads.compare_exchange_strong(no_value, nthreads)) {
-    // num_intraop_threads either stores a positive integer or CONSUMED,
-    // check that requested size is the same as the current one
-    int stored_nthreads = num_intraop_threads.load();
-    if (stored_nthreads <= 0) {
-      // plus one because of master thread
-      stored_nthreads = _get_intraop_pool().NumThreads() + 1;
-    }
-    if (stored_nthreads != nthreads) {
-      YASL_ENFORCE(
-          "Cannot set number of intraop threads "
-          "after parallel work has started or after set_num_threads call "
-          "when using native parallel backend");
+  if (num_intraop_threads.compare_exchange_strong(no_value, nthreads)) {
+    return;
+  }
+  int stored = NOT_SET;
+  do {
+    // a size set before the pool exists is simply replaced.
+    stored = num_intraop_threads.load();
+    if (stored == CONSUMED) {
+      break;
     }
+  } while (!num_intraop_threads.compare_exchange_weak(stored, nthreads));
+  if (stored != CONSUMED) {
+    return;
   }
+  // resizes a running pool. regions running on the old pool keep it alive
+  // until they are done, new regions get the new one.
+  auto& global = _global_pool();
+  std::lock_guard<std::mutex> lock(global.mutex);
+  const int current = global.pool == nullptr
+                          ? 1
+                          : static_cast<int>(global.pool->NumThreads()) + 1;
+  if (current != nthreads) {
+    global.pool = _make_pool(nthreads, _affinity_spec());
+  }
+}
+
+void set_thread_affinity(const std::string& spec) {
+  YASL_ENFORCE(num_intraop_threads.load() != CONSUMED,
+               "Cannot set thread affinity after parallel work has started");
+  // fails early on a bad spec.
+  ParseThreadAffinity(spec, 1);
+  std::lock_guard<std::mutex> lock(affinity_mutex);
+  affinity_spec = spec;
+  affinity_set = true;
 }
 
 int get_num_threads() {
-  // not initializing pool unnecessarily,
-  // because pool cannot be resized after initialization
+  if (pool_scope_.active) {
+    return pool_scope_.pool == nullptr
+               ? 1
+               : static_cast<int>(pool_scope_.pool->NumThreads()) + 1;
+  }
+  // not initializing pool unnecessarily
   int nthreads = num_intraop_threads.load();
   if (nthreads > 0) {
     return nthreads;
@@ -140,16 +412,43 @@ int get_num_threads() {
     return intraop_default_num_threads();
   }
   YASL_ENFORCE(nthreads == CONSUMED);
-  return _get_intraop_pool().NumThreads() + 1;
+  auto pool = _get_intraop_pool();
+  return pool == nullptr ? 1 : static_cast<int>(pool->NumThreads()) + 1;
 }
 
+void warm_up_intraop_pool() { static_cast<void>(_global_pool()); }
+
 int get_thread_num() { return thread_num_; }
 
 bool in_parallel_region() {
-  return in_parallel_region_ ||
-         (num_intraop_threads.load() == CONSUMED &&
-          // Needed as intraop_launch() doesn't set in_parallel_region().
-          _get_intraop_pool().InThreadPool());
+  if (in_parallel_region_) {
+    return true;
+  }
+  // Needed as intraop_launch() doesn't set in_parallel_region().
+  if (pool_scope_.active) {
+    return pool_scope_.pool != nullptr && pool_scope_.pool->InThreadPool();
+  }
+  if (num_intraop_threads.load() != CONSUMED) {
+    return false;
+  }
+  auto pool = _get_intraop_pool();
+  return pool != nullptr && pool->InThreadPool();
+}
+
+std::shared_ptr<ThreadPool> MakeIntraopPool(int nthreads,
+                                            const std::string& affinity) {
+  return _make_pool(nthreads, affinity);
+}
+
+ThreadPoolScope::ThreadPoolScope(std::shared_ptr<ThreadPool> pool)
+    : pool_(std::move(pool)),
+      prev_active_(pool_scope_.active),
+      prev_pool_(pool_scope_.pool) {
+  pool_scope_ = {true, pool_.get()};
+}
+
+ThreadPoolScope::~ThreadPoolScope() {
+  pool_scope_ = {prev_active_, prev_pool_};
 }
 
 }  // namespace yasl
@@ -7,26 +7,47 @@
 #include <tuple>
 #include <vector>
 
+#include "absl/functional/function_ref.h"
+
 #include "yasl/utils/parallel.h"
 
 namespace yasl {
 namespace internal {
 
 inline std::tuple<size_t, size_t> calc_num_tasks_and_chunk_size(
-    int64_t begin, int64_t end, int64_t grain_size) {
+    int64_t begin, int64_t end, int64_t grain_size, int num_threads) {
   if ((end - begin) < grain_size) {
     return std::make_tuple(1, std::max(static_cast<int64_t>(0), end - begin));
   }
   // Choose number of tasks based on grain size and number of threads.
-  size_t chunk_size = divup((end - begin), get_num_threads());
+  size_t chunk_size = divup((end - begin), num_threads);
   // Make sure each task is at least grain_size size.
   chunk_size = std::max(static_cast<size_t>(grain_size), chunk_size);
   size_t num_tasks = divup((end - begin), chunk_size);
   return std::make_tuple(num_tasks, chunk_size);
 }
 
+// f is only referenced, so launching a loop does not allocate.
+void _parallel_run(int64_t begin, int64_t end, int64_t grain_size,
+                   const absl::FunctionRef<void(int64_t, int64_t, size_t)>& f);
+
+// like above, init gets the number of tasks before any of them runs. the
+// split follows the pool the region runs on, which set_num_threads may
+// resize meanwhile, so per-task state is sized there.
 void _parallel_run(int64_t begin, int64_t end, int64_t grain_size,
-                   const std::function<void(int64_t, int64_t, size_t)>& f);
+                   const absl::FunctionRef<void(size_t)>& init,
+                   const absl::FunctionRef<void(int64_t, int64_t, size_t)>& f);
+
+// splits [begin, end) by schedule, which is not kStatic.
+void _parallel_run_scheduled(
+    int64_t begin, int64_t end, int64_t grain_size, Schedule schedule,
+    const absl::FunctionRef<void(int64_t, int64_t)>& f);
+
+// runs a prefix of [begin, end) on the calling thread to measure f, sets
+// grain_size from it and returns where the prefix ended.
+int64_t _calibrate_grain_size(
+    int64_t begin, int64_t end,
+    const absl::FunctionRef<void(int64_t, int64_t)>& f, int64_t* grain_size);
 
 }  // namespace internal
 
@@ -37,13 +58,40 @@ inline void parallel_for(const int64_t begin, const int64_t end,
   if (begin >= end) {
     return;
   }
-  if ((end - begin) < grain_size || in_parallel_region()) {
+  if ((end - begin) < grain_size) {
     f(begin, end);
     return;
   }
   internal::_parallel_run(
       begin, end, grain_size,
-      [f](int64_t fstart, int64_t fend, size_t /* unused */) { f(fstart, fend); });
+      [&f](int64_t fstart, int64_t fend, size_t /* unused */) {
+        f(fstart, fend);
+      });
+}
+
+template <class F>
+inline void parallel_for(int64_t begin, const int64_t end, int64_t grain_size,
+                         const Schedule schedule, const F& f) {
+  YASL_ENFORCE(grain_size > 0 || grain_size == kAutoGrainSize);
+  if (grain_size == kAutoGrainSize && begin < end) {
+    begin = internal::_calibrate_grain_size(
+        begin, end, [&f](int64_t fstart, int64_t fend) { f(fstart, fend); },
+        &grain_size);
+  }
+  if (begin >= end) {
+    return;
+  }
+  if (schedule == Schedule::kStatic) {
+    parallel_for(begin, end, grain_size, f);
+    return;
+  }
+  if ((end - begin) <= grain_size) {
+    f(begin, end);
+    return;
+  }
+  internal::_parallel_run_scheduled(
+      begin, end, grain_size, schedule,
+      [&f](int64_t fstart, int64_t fend) { f(fstart, fend); });
 }
 
 template <class scalar_t, class F, class SF>
@@ -54,18 +102,19 @@ inline scalar_t parallel_reduce(const int64_t begin, const int64_t end,
   if (begin >= end) {
     return ident;
   }
-  if ((end - begin) < grain_size || in_parallel_region()) {
+  if ((end - begin) < grain_size) {
     return f(begin, end, ident);
   }
-  size_t num_tasks;
-  size_t chunk_size;
-  std::tie(num_tasks, chunk_size) =
-      internal::calc_num_tasks_and_chunk_size(begin, end, grain_size);
-  std::vector<scalar_t> results(num_tasks);
-  scalar_t* results_data = results.data();
+  std::vector<scalar_t> results;
+  scalar_t* results_data = nullptr;
   internal::_parallel_run(
       begin, end, grain_size,
-      [f, ident, results_data](int64_t fstart, int64_t fend, size_t task_id) {
+      [&results, &results_data, &ident](size_t num_tasks) {
+        results.assign(num_tasks, ident);
+        results_data = results.data();
+      },
+      [&f, &ident, &results_data](int64_t fstart, int64_t fend,
+                                  size_t task_id) {
         results_data[task_id] = f(fstart, fend, ident);
       });
   scalar_t result = ident;
@@ -14,10 +14,16 @@
 
 #include "yasl/utils/parallel.h"
 
+#include <atomic>
+#include <mutex>
 #include <numeric>
+#include <set>
+#include <thread>
 
 #include "gtest/gtest.h"
 
+#include "yasl/utils/thread_pool.h"
+
 namespace yasl {
 
 struct Param {
@@ -60,6 +66,156 @@ TEST(ParallelTest, ParallelWithExceptionTest) {
                RuntimeError);
 }
 
+TEST(ParallelTest, NestedParallelTest) {
+  init_num_threads();
+  set_num_threads(4);
+
+  const int64_t rows = 64;
+  const int64_t cols = 1000;
+  std::vector<int64_t> data(rows * cols);
+  std::vector<int64_t> row_sums(rows);
+  parallel_for(0, rows, 1, [&](int64_t beg, int64_t end) {
+    const size_t outer_thread_num = get_thread_num();
+    for (int64_t r = beg; r < end; ++r) {
+      parallel_for(0, cols, 10, [&](int64_t cbeg, int64_t cend) {
+        for (int64_t c = cbeg; c < cend; ++c) {
+          data[r * cols + c] = r + c;
+        }
+      });
+      row_sums[r] = parallel_reduce(
+          0, cols, 10, int64_t(0),
+          [&](int64_t cbeg, int64_t cend, int64_t ident) {
+            for (int64_t c = cbeg; c < cend; ++c) {
+              ident += data[r * cols + c];
+            }
+            return ident;
+          },
+          [](int64_t a, int64_t b) { return a + b; });
+      // the inner regions restore the outer task's state.
+      EXPECT_TRUE(in_parallel_region());
+      EXPECT_EQ(get_thread_num(), outer_thread_num);
+    }
+  });
+
+  for (int64_t r = 0; r < rows; ++r) {
+    ASSERT_EQ(row_sums[r], r * cols + cols * (cols - 1) / 2);
+  }
+  EXPECT_FALSE(in_parallel_region());
+}
+
+TEST(ParallelTest, NestedExceptionTest) {
+  init_num_threads();
+  set_num_threads(4);
+
+  EXPECT_THROW(parallel_for(0, 16, 1,
+                            [](int64_t beg, int64_t end) {
+                              parallel_for(0, 100, 1,
+                                           [](int64_t ibeg, int64_t iend) {
+                                             if (ibeg <= 50 && 50 < iend) {
+                                               throw RuntimeError("surprise");
+                                             }
+                                           });
+                            }),
+               RuntimeError);
+}
+
+TEST(ParallelTest, ScheduleTest) {
+  init_num_threads();
+  set_num_threads(4);
+
+  for (auto schedule :
+       {Schedule::kStatic, Schedule::kDynamic, Schedule::kGuided}) {
+    for (int64_t grain_size : {int64_t{1}, int64_t{7}, kAutoGrainSize}) {
+      // irregular bodies: the cost grows with the index.
+      std::vector<std::atomic<int>> visits(3001);
+      std::atomic<int64_t> work(0);
+      parallel_for(1, visits.size(), grain_size, schedule,
+                   [&](int64_t beg, int64_t end) {
+                     for (int64_t i = beg; i < end; ++i) {
+                       visits[i]++;
+                       for (int64_t j = 0; j < i; ++j) {
+                         work.fetch_add(1, std::memory_order_relaxed);
+                       }
+                     }
+                   });
+      EXPECT_EQ(visits[0].load(), 0);
+      for (size_t i = 1; i < visits.size(); ++i) {
+        ASSERT_EQ(visits[i].load(), 1) << i;
+      }
+      EXPECT_EQ(work.load(), int64_t{3000} * 3001 / 2);
+    }
+  }
+  EXPECT_THROW(parallel_for(0, 10, 0, Schedule::kDynamic,
+                            [](int64_t beg, int64_t end) {}),
+               EnforceNotMet);
+}
+
+TEST(ParallelTest, ThreadPoolScopeTest) {
+  init_num_threads();
+  set_num_threads(4);
+
+  auto pool = MakeIntraopPool(3);
+  ASSERT_NE(pool, nullptr);
+  EXPECT_EQ(pool->NumThreads(), 2);
+  {
+    ThreadPoolScope scope(pool);
+    EXPECT_EQ(get_num_threads(), 3);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::atomic<int64_t> sum(0);
+    parallel_for(0, 64, 1, [&](int64_t beg, int64_t end) {
+      // nested regions run on the pool of the scope too.
+      EXPECT_EQ(get_num_threads(), 3);
+      sum += parallel_reduce(
+          beg * 100, end * 100, 10, int64_t(0),
+          [&](int64_t ibeg, int64_t iend, int64_t ident) {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+            return ident + (ibeg + iend - 1) * (iend - ibeg) / 2;
+          },
+          [](int64_t a, int64_t b) { return a + b; });
+    });
+    EXPECT_EQ(sum.load(), int64_t{6400} * 6399 / 2);
+    // the calling thread and the pooled ones.
+    EXPECT_LE(threads.size(), 3);
+
+    {
+      // a null pool runs regions on the calling thread.
+      ThreadPoolScope serial(MakeIntraopPool(1));
+      EXPECT_EQ(get_num_threads(), 1);
+      parallel_for(0, 100, 1, [&](int64_t beg, int64_t end) {
+        EXPECT_EQ(beg, 0);
+        EXPECT_EQ(end, 100);
+      });
+    }
+    EXPECT_EQ(get_num_threads(), 3);
+  }
+  EXPECT_EQ(get_num_threads(), 4);
+  EXPECT_FALSE(in_parallel_region());
+}
+
+TEST(ParallelTest, ResizeTest) {
+  init_num_threads();
+  set_num_threads(4);
+  // starts the pool.
+  parallel_for(0, 100, 1, [](int64_t beg, int64_t end) {});
+
+  for (int nthreads : {2, 1, 3}) {
+    set_num_threads(nthreads);
+    EXPECT_EQ(get_num_threads(), nthreads);
+    std::vector<int> data(1000, 1);
+    parallel_for(0, data.size(), 1, [&](int64_t beg, int64_t end) {
+      for (int64_t i = beg; i < end; ++i) {
+        data[i] *= 2;
+      }
+    });
+    EXPECT_EQ(std::accumulate(data.begin(), data.end(), 0), 2000);
+  }
+  set_num_threads(4);
+  EXPECT_EQ(get_num_threads(), 4);
+  EXPECT_THROW(set_num_threads(0), EnforceNotMet);
+}
+
 TEST_P(ParallelTest, ParallelReduceTest) {
   auto param = GetParam();
 
@@ -84,6 +240,40 @@ TEST_P(ParallelTest, ParallelReduceTest) {
   ASSERT_EQ(expect_sum, total_sum);
 }
 
+TEST(ParallelTest, ParallelReduceResizeTest) {
+  init_num_threads();
+  set_num_threads(4);
+  // starts the pool.
+  parallel_for(0, 100, 1, [](int64_t beg, int64_t end) {});
+
+  std::atomic<bool> stop(false);
+  std::thread resizer([&stop] {
+    for (int i = 0; !stop.load(); ++i) {
+      set_num_threads(1 + i % 8);
+    }
+  });
+
+  // a slot not filled by a task would zero the product.
+  std::vector<int64_t> data(100, 1);
+  for (int round = 0; round < 200000; ++round) {
+    int64_t product = parallel_reduce(
+        0, data.size(), 1, static_cast<int64_t>(1),
+        [&data](int64_t beg, int64_t end, int64_t ident) {
+          int64_t partial = ident;
+          for (int64_t i = beg; i < end; ++i) {
+            partial *= data[i];
+          }
+          return partial;
+        },
+        [](int64_t a, int64_t b) { return a * b; });
+    ASSERT_EQ(product, 1);
+  }
+
+  stop.store(true);
+  resizer.join();
+  set_num_threads(4);
+}
+
 INSTANTIATE_TEST_SUITE_P(ParallelTestSuit, ParallelTest,
                          testing::Values(Param{4, 123, 10}, Param{4, 123, 50},
                                          Param{4, 123, 200}));
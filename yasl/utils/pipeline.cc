@@ -0,0 +1,64 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/pipeline.h"
+
+#include <exception>
+#include <future>
+
+#include "yasl/utils/thread_pool.h"
+
+namespace yasl {
+
+void Pipeline::Run() {
+  YASL_ENFORCE(!ran_, "a pipeline runs once");
+  ran_ = true;
+  if (workers_.empty()) {
+    return;
+  }
+
+  // a thread per worker: workers block on queues and on the network, they
+  // must not wait for a free thread.
+  ThreadPool pool(workers_.size());
+  std::mutex error_mutex;
+  std::exception_ptr first_error;
+  std::vector<std::future<void>> futures;
+  futures.reserve(workers_.size());
+  for (auto& worker : workers_) {
+    futures.push_back(pool.Submit([&] {
+      try {
+        worker();
+      } catch (...) {
+        {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (!first_error) {
+            first_error = std::current_exception();
+          }
+        }
+        // unblocks and stops the other stages.
+        for (auto& cancel : cancels_) {
+          cancel();
+        }
+      }
+    }));
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+  if (first_error) {
+    std::rethrow_exception(first_error);
+  }
+}
+
+}  // namespace yasl
@@ -0,0 +1,197 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Brief: stages connected by bounded queues, so that a cpu bound stage and
+// a network bound one overlap instead of taking turns.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "yasl/base/exception.h"
+
+namespace yasl {
+
+// A multi producer, multi consumer queue of at most capacity items. A full
+// queue blocks its producers, which is the backpressure of a pipeline.
+template <class T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity) {
+    YASL_ENFORCE(capacity > 0, "capacity must > 0");
+  }
+
+  // blocks while the queue is full. false if the queue was closed, the item
+  // is dropped then.
+  bool Push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock,
+                   [this] { return closed_ || items_.size() < capacity_; });
+    if (closed_) {
+      return false;
+    }
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // blocks while the queue is empty. nullopt once it is closed and drained.
+  std::optional<T> Pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+    if (items_.empty()) {
+      return std::nullopt;
+    }
+    T item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return item;
+  }
+
+  // no more pushes, pops drain what is left.
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+  // Close and drop what is left.
+  void Cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    items_.clear();
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return items_.size();
+  }
+
+ private:
+  const size_t capacity_;
+  mutable std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<T> items_;
+  bool closed_ = false;
+};
+
+// A dag of stages connected by BoundedQueues. Run starts every stage worker
+// on a pool thread of its own, so a stage blocked on the network or on a
+// full queue never holds up another one; cpu heavy stages may still use
+// parallel_for inside. A stage closes its output queue when it is done,
+// which ends the stages downstream. If a stage throws, all queues are
+// cancelled so the other stages stop, and Run rethrows the first error.
+//
+//   Pipeline pipe;
+//   auto batches = pipe.Source<Batch>([&](const auto& emit) {
+//     for (...) if (!emit(MakeBatch())) return;
+//   });
+//   auto bufs = pipe.Map<Batch, Buffer>(batches, Serialize, /*workers=*/4);
+//   pipe.Sink<Buffer>(bufs, [&](Buffer buf) { ctx->SendAsync(...); });
+//   pipe.Run();
+class Pipeline {
+ public:
+  // capacity of the queues made by the stages.
+  explicit Pipeline(size_t queue_capacity = 4)
+      : queue_capacity_(queue_capacity) {}
+
+  template <class T>
+  std::shared_ptr<BoundedQueue<T>> MakeQueue() {
+    auto queue = std::make_shared<BoundedQueue<T>>(queue_capacity_);
+    cancels_.push_back([queue] { queue->Cancel(); });
+    return queue;
+  }
+
+  // f(emit) produces the items, emit returns false once the pipeline is
+  // cancelled and f should return.
+  template <class T, class F>
+  std::shared_ptr<BoundedQueue<T>> Source(F f) {
+    auto out = MakeQueue<T>();
+    AddWorker([out, f = std::move(f)] {
+      const std::function<bool(T)> emit = [&](T item) {
+        return out->Push(std::move(item));
+      };
+      f(emit);
+      out->Close();
+    });
+    return out;
+  }
+
+  // f(in item) -> out item, on num_workers workers. more than one worker
+  // does not keep the order of the items.
+  template <class In, class Out, class F>
+  std::shared_ptr<BoundedQueue<Out>> Map(
+      std::shared_ptr<BoundedQueue<In>> in, F f, size_t num_workers = 1) {
+    YASL_ENFORCE(num_workers > 0);
+    auto out = MakeQueue<Out>();
+    // the last worker to finish closes out.
+    auto running = std::make_shared<std::atomic<size_t>>(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+      AddWorker([in, out, f, running] {
+        while (auto item = in->Pop()) {
+          if (!out->Push(f(std::move(*item)))) {
+            break;
+          }
+        }
+        if (running->fetch_sub(1) == 1) {
+          out->Close();
+        }
+      });
+    }
+    return out;
+  }
+
+  // f(in item), on num_workers workers.
+  template <class In, class F>
+  void Sink(std::shared_ptr<BoundedQueue<In>> in, F f,
+            size_t num_workers = 1) {
+    YASL_ENFORCE(num_workers > 0);
+    for (size_t i = 0; i < num_workers; ++i) {
+      AddWorker([in, f] {
+        while (auto item = in->Pop()) {
+          f(std::move(*item));
+        }
+      });
+    }
+  }
+
+  // a worker of a custom stage, which must close its output queues when it
+  // is done.
+  void AddWorker(std::function<void()> worker) {
+    workers_.push_back(std::move(worker));
+  }
+
+  // runs all workers until they are done. rethrows the first exception of
+  // a worker. a pipeline runs once.
+  void Run();
+
+ private:
+  const size_t queue_capacity_;
+  std::vector<std::function<void()>> workers_;
+  std::vector<std::function<void()>> cancels_;
+  bool ran_ = false;
+};
+
+}  // namespace yasl
@@ -0,0 +1,113 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/pipeline.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace yasl {
+
+TEST(BoundedQueue, PushPop) {
+  BoundedQueue<int> queue(2);
+  EXPECT_TRUE(queue.Push(1));
+  EXPECT_TRUE(queue.Push(2));
+  EXPECT_EQ(queue.size(), 2);
+  std::thread consumer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(queue.Pop(), 1);
+  });
+  // blocks until the consumer made room.
+  EXPECT_TRUE(queue.Push(3));
+  consumer.join();
+  queue.Close();
+  EXPECT_FALSE(queue.Push(4));
+  EXPECT_EQ(queue.Pop(), 2);
+  EXPECT_EQ(queue.Pop(), 3);
+  EXPECT_EQ(queue.Pop(), std::nullopt);
+
+  BoundedQueue<int> cancelled(2);
+  EXPECT_TRUE(cancelled.Push(1));
+  cancelled.Cancel();
+  EXPECT_EQ(cancelled.Pop(), std::nullopt);
+}
+
+TEST(Pipeline, Stages) {
+  Pipeline pipe(2);
+  auto numbers = pipe.Source<int64_t>([](const auto& emit) {
+    for (int64_t i = 0; i < 1000; ++i) {
+      if (!emit(i)) {
+        return;
+      }
+    }
+  });
+  auto squares = pipe.Map<int64_t, int64_t>(
+      numbers, [](int64_t x) { return x * x; }, 3);
+  auto strs = pipe.Map<int64_t, std::string>(
+      squares, [](int64_t x) { return std::to_string(x); });
+  int64_t sum = 0;
+  size_t count = 0;
+  pipe.Sink<std::string>(strs, [&](const std::string& s) {
+    sum += std::stoll(s);
+    count++;
+  });
+  pipe.Run();
+  EXPECT_EQ(count, 1000);
+  EXPECT_EQ(sum, int64_t{999} * 1000 * 1999 / 6);
+  EXPECT_THROW(pipe.Run(), EnforceNotMet);
+}
+
+TEST(Pipeline, Backpressure) {
+  Pipeline pipe(2);
+  std::atomic<int64_t> produced(0);
+  std::atomic<int64_t> consumed(0);
+  std::atomic<int64_t> max_ahead(0);
+  auto items = pipe.Source<int>([&](const auto& emit) {
+    for (int i = 0; i < 50; ++i) {
+      emit(i);
+      const int64_t ahead = ++produced - consumed.load();
+      max_ahead = std::max(max_ahead.load(), ahead);
+    }
+  });
+  pipe.Sink<int>(items, [&](int) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    consumed++;
+  });
+  pipe.Run();
+  EXPECT_EQ(consumed.load(), 50);
+  // the queue, the item being consumed and the one being pushed.
+  EXPECT_LE(max_ahead.load(), 4);
+}
+
+TEST(Pipeline, Error) {
+  Pipeline pipe(2);
+  // an endless source, stopped by the failing stage.
+  auto items = pipe.Source<int>([](const auto& emit) {
+    for (int i = 0; emit(i); ++i) {
+    }
+  });
+  auto mapped = pipe.Map<int, int>(items, [](int x) {
+    if (x == 100) {
+      YASL_THROW("surprise");
+    }
+    return x;
+  });
+  pipe.Sink<int>(mapped, [](int) {});
+  EXPECT_THROW(pipe.Run(), RuntimeError);
+}
+
+}  // namespace yasl
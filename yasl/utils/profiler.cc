@@ -0,0 +1,248 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "fmt/format.h"
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+namespace yasl {
+
+namespace internal {
+
+// a scope of a thread's call tree. only the owning thread adds children or
+// counts, the children are added under the mutex of the tree so that a
+// report can walk them meanwhile.
+struct ProfileNode {
+  ProfileNode(const char* name, ProfileNode* parent)
+      : name(name), parent(parent) {}
+
+  const char* const name;
+  ProfileNode* const parent;
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> ticks{0};
+  std::vector<std::unique_ptr<ProfileNode>> children;
+};
+
+}  // namespace internal
+
+namespace {
+
+using internal::ProfileNode;
+using Clock = std::chrono::steady_clock;
+
+// the time stamp counter, which ticks at a constant rate on the x86 cpus of
+// this century and costs a fraction of a clock call.
+uint64_t Ticks() {
+#if defined(__x86_64__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+struct ProfileTree {
+  std::mutex mutex;
+  ProfileNode root{"", nullptr};
+  // the innermost open scope, of the owning thread only.
+  ProfileNode* current = &root;
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ProfileTree>> trees;
+  // ticks and time at start, to convert ticks to time.
+  const uint64_t start_ticks = Ticks();
+  const Clock::time_point start_time = Clock::now();
+
+  double TicksPerMs() {
+#if defined(__x86_64__)
+    // measured over 10ms at least.
+    auto elapsed = Clock::now() - start_time;
+    if (elapsed < std::chrono::milliseconds(10)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10) - elapsed);
+    }
+    const uint64_t ticks = Ticks();
+    elapsed = Clock::now() - start_time;
+    return (ticks - start_ticks) /
+           std::chrono::duration<double, std::milli>(elapsed).count();
+#else
+    return 1e6;
+#endif
+  }
+};
+
+Registry* GetRegistry() {
+  // leaked, threads may exit during static destruction.
+  static auto* registry = new Registry();
+  return registry;
+}
+
+ProfileTree* GetThreadTree() {
+  thread_local std::shared_ptr<ProfileTree> tree = [] {
+    auto tree = std::make_shared<ProfileTree>();
+    auto* registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry->mutex);
+    registry->trees.push_back(tree);
+    return tree;
+  }();
+  return tree.get();
+}
+
+ProfileNode* FindOrAddChild(ProfileTree* tree, ProfileNode* node,
+                            const char* name) {
+  // literals of the same name may live at several addresses.
+  for (const auto& child : node->children) {
+    if (child->name == name || std::strcmp(child->name, name) == 0) {
+      return child.get();
+    }
+  }
+  std::lock_guard<std::mutex> lock(tree->mutex);
+  node->children.push_back(std::make_unique<ProfileNode>(name, node));
+  return node->children.back().get();
+}
+
+// the trees of all threads, merged by name.
+struct MergedNode {
+  std::string name;
+  uint64_t count = 0;
+  uint64_t ticks = 0;
+  std::vector<MergedNode> children;
+};
+
+void Merge(const ProfileNode& from, MergedNode* to) {
+  to->count += from.count.load(std::memory_order_relaxed);
+  to->ticks += from.ticks.load(std::memory_order_relaxed);
+  for (const auto& child : from.children) {
+    auto it = std::find_if(
+        to->children.begin(), to->children.end(),
+        [&](const MergedNode& node) { return node.name == child->name; });
+    if (it == to->children.end()) {
+      to->children.emplace_back().name = child->name;
+      it = to->children.end() - 1;
+    }
+    Merge(*child, &*it);
+  }
+}
+
+void Flatten(const MergedNode& node, const std::string& path, size_t depth,
+             double ticks_per_ms, ProfileReport* report) {
+  for (const auto& child : node.children) {
+    ProfileReport::Entry entry;
+    entry.path = path.empty() ? child.name : path + "/" + child.name;
+    entry.depth = depth;
+    entry.count = child.count;
+    entry.total_ms = child.ticks / ticks_per_ms;
+    uint64_t inner_ticks = 0;
+    for (const auto& grandchild : child.children) {
+      inner_ticks += grandchild.ticks;
+    }
+    entry.self_ms =
+        (child.ticks - std::min(child.ticks, inner_ticks)) / ticks_per_ms;
+    const auto child_path = entry.path;
+    report->entries.push_back(std::move(entry));
+    Flatten(child, child_path, depth + 1, ticks_per_ms, report);
+  }
+}
+
+void Clear(ProfileNode* node) {
+  node->count.store(0, std::memory_order_relaxed);
+  node->ticks.store(0, std::memory_order_relaxed);
+  for (const auto& child : node->children) {
+    Clear(child.get());
+  }
+}
+
+}  // namespace
+
+namespace internal {
+
+ProfileScope::ProfileScope(const char* name) {
+  auto* tree = GetThreadTree();
+  node_ = FindOrAddChild(tree, tree->current, name);
+  tree->current = node_;
+  start_ = Ticks();
+}
+
+ProfileScope::~ProfileScope() {
+  const uint64_t ticks = Ticks() - start_;
+  // single writer, so no read-modify-write is needed.
+  node_->ticks.store(node_->ticks.load(std::memory_order_relaxed) + ticks,
+                     std::memory_order_relaxed);
+  node_->count.store(node_->count.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+  GetThreadTree()->current = node_->parent;
+}
+
+}  // namespace internal
+
+ProfileReport GetProfileReport() {
+  auto* registry = GetRegistry();
+  MergedNode root;
+  {
+    std::lock_guard<std::mutex> lock(registry->mutex);
+    for (const auto& tree : registry->trees) {
+      std::lock_guard<std::mutex> tree_lock(tree->mutex);
+      Merge(tree->root, &root);
+    }
+  }
+  ProfileReport report;
+  Flatten(root, "", 0, registry->TicksPerMs(), &report);
+  return report;
+}
+
+void ResetProfile() {
+  auto* registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry->mutex);
+  auto& trees = registry->trees;
+  // the registry holds the last reference of the tree of a finished thread.
+  trees.erase(std::remove_if(trees.begin(), trees.end(),
+                             [](const auto& tree) {
+                               return tree.use_count() == 1;
+                             }),
+              trees.end());
+  for (const auto& tree : trees) {
+    std::lock_guard<std::mutex> tree_lock(tree->mutex);
+    Clear(&tree->root);
+  }
+}
+
+std::string ProfileReport::ToString() const {
+  std::string out = fmt::format("{:>12} {:>12} {:>10}  {}\n", "total ms",
+                                "self ms", "count", "scope");
+  for (const auto& entry : entries) {
+    const auto slash = entry.path.rfind('/');
+    const auto name =
+        slash == std::string::npos ? entry.path : entry.path.substr(slash + 1);
+    out += fmt::format("{:>12.3f} {:>12.3f} {:>10}  {}{}\n", entry.total_ms,
+                       entry.self_ms, entry.count,
+                       std::string(2 * entry.depth, ' '), name);
+  }
+  return out;
+}
+
+}  // namespace yasl
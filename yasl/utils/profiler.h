@@ -0,0 +1,96 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Brief: a scoped profiler.
+//
+//   void Transpose(...) {
+//     YASL_PROFILE_SCOPE("iknp.transpose");
+//     ...
+//   }
+//
+// times the rest of the enclosing scope as a node of the call tree of the
+// calling thread, under the scopes which are open around it. GetProfileReport
+// merges the trees of all threads by path. The link context opens
+// "link.recv_wait" scopes while it waits for msgs, so communication shows up
+// next to the compute which waited for it.
+//
+// Scopes are compiled in by building with --config=profile, which defines
+// YASL_ENABLE_PROFILER; otherwise they compile to nothing.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace yasl {
+
+struct ProfileReport {
+  struct Entry {
+    // names of the scopes from the outermost one, joined by '/'.
+    std::string path;
+    size_t depth = 0;
+    uint64_t count = 0;
+    double total_ms = 0;
+    // total_ms but the time of the scopes within.
+    double self_ms = 0;
+  };
+
+  // depth first, siblings in the order they first ran.
+  std::vector<Entry> entries;
+
+  // an indented table of the entries.
+  std::string ToString() const;
+};
+
+// the call trees of all threads, running or finished, merged. scopes which
+// are still open are not counted yet.
+ProfileReport GetProfileReport();
+
+// clears what was profiled so far.
+void ResetProfile();
+
+namespace internal {
+
+struct ProfileNode;
+
+class ProfileScope {
+ public:
+  // name must outlive the process, like a string literal.
+  explicit ProfileScope(const char* name);
+  ~ProfileScope();
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  ProfileNode* node_;
+  uint64_t start_;
+};
+
+}  // namespace internal
+
+}  // namespace yasl
+
+#define YASL_PROFILE_CONCAT_IMPL(a, b) a##b
+#define YASL_PROFILE_CONCAT(a, b) YASL_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef YASL_ENABLE_PROFILER
+#define YASL_PROFILE_SCOPE(name)                      \
+  ::yasl::internal::ProfileScope YASL_PROFILE_CONCAT( \
+      yasl_profile_scope_, __LINE__)(name)
+#else
+#define YASL_PROFILE_SCOPE(name) static_cast<void>(0)
+#endif
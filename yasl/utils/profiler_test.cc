@@ -0,0 +1,104 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/profiler.h"
+
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace yasl {
+
+namespace {
+
+void Sleep(int ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+std::map<std::string, ProfileReport::Entry> ByPath(
+    const ProfileReport& report) {
+  std::map<std::string, ProfileReport::Entry> entries;
+  for (const auto& entry : report.entries) {
+    entries[entry.path] = entry;
+  }
+  return entries;
+}
+
+void Step() {
+  YASL_PROFILE_SCOPE("step");
+  {
+    YASL_PROFILE_SCOPE("compute");
+    Sleep(2);
+  }
+  YASL_PROFILE_SCOPE("wait");
+  Sleep(1);
+}
+
+}  // namespace
+
+TEST(ProfilerTest, NestedScopes) {
+  ResetProfile();
+  {
+    YASL_PROFILE_SCOPE("job");
+    for (int i = 0; i < 5; ++i) {
+      Step();
+    }
+  }
+  const auto report = GetProfileReport();
+  auto entries = ByPath(report);
+
+  ASSERT_EQ(entries.count("job"), 1);
+  EXPECT_EQ(entries["job"].count, 1);
+  EXPECT_EQ(entries["job/step"].count, 5);
+  EXPECT_EQ(entries["job/step/compute"].count, 5);
+  EXPECT_EQ(entries["job/step/compute"].depth, 2);
+  EXPECT_EQ(entries["job/step/wait"].count, 5);
+  EXPECT_GE(entries["job/step/compute"].total_ms, 9);
+  EXPECT_GE(entries["job/step/wait"].total_ms, 4);
+  EXPECT_GE(entries["job"].total_ms, entries["job/step"].total_ms);
+  EXPECT_LT(entries["job/step"].self_ms, entries["job/step"].total_ms);
+
+  // depth first.
+  EXPECT_EQ(report.entries[0].path, "job");
+  EXPECT_EQ(report.entries[1].path, "job/step");
+  EXPECT_NE(report.ToString().find("    compute"), std::string::npos);
+}
+
+TEST(ProfilerTest, MergedAcrossThreads) {
+  ResetProfile();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([] {
+      YASL_PROFILE_SCOPE("worker");
+      for (int i = 0; i < 100; ++i) {
+        YASL_PROFILE_SCOPE("item");
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto entries = ByPath(GetProfileReport());
+  EXPECT_EQ(entries["worker"].count, 4);
+  EXPECT_EQ(entries["worker/item"].count, 400);
+
+  ResetProfile();
+  EXPECT_TRUE(ByPath(GetProfileReport()).count("worker") == 0 ||
+              ByPath(GetProfileReport())["worker"].count == 0);
+}
+
+}  // namespace yasl
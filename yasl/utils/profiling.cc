@@ -0,0 +1,194 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/profiling.h"
+
+#include <unistd.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "fmt/format.h"
+#include "gperftools/heap-profiler.h"
+#include "gperftools/profiler.h"
+#include "spdlog/spdlog.h"
+
+#include "yasl/base/buffer_allocator.h"
+#include "yasl/base/exception.h"
+
+namespace yasl {
+
+namespace {
+
+struct ProfilingState {
+  std::mutex mutex;
+  bool running = false;
+  // path of the profiles of the running phase, but the suffix.
+  std::string base;
+  ProfilingOptions options;
+  // the buffer allocator before heap profiling started.
+  BufferAllocator* buffer_allocator = nullptr;
+
+  // of the signal handler.
+  ProfilingOptions signal_options;
+  size_t signal_phases = 0;
+};
+
+ProfilingState* GetState() {
+  // leaked, the signal thread never exits.
+  static auto* state = new ProfilingState();
+  return state;
+}
+
+// phases end up in file names.
+std::string FileNameOf(const std::string& phase) {
+  std::string name = phase;
+  for (auto& c : name) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' &&
+        c != '_' && c != '.') {
+      c = '_';
+    }
+  }
+  return name;
+}
+
+// the signal handler wakes up the signal thread through a pipe.
+int signal_pipe[2] = {-1, -1};
+
+void OnProfilingSignal(int) {
+  // only async signal safe calls here, the signal thread does the work.
+  const char c = 0;
+  const int saved_errno = errno;
+  static_cast<void>(write(signal_pipe[1], &c, 1));
+  errno = saved_errno;
+}
+
+void SignalLoop() {
+  auto* state = GetState();
+  while (true) {
+    char c;
+    const auto n = read(signal_pipe[0], &c, 1);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      SPDLOG_ERROR("profiling signal pipe closed, errno={}", errno);
+      return;
+    }
+    try {
+      if (IsProfiling()) {
+        StopProfiling();
+        continue;
+      }
+      ProfilingOptions options;
+      std::string phase;
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        options = state->signal_options;
+        phase = fmt::format("signal-{}", ++state->signal_phases);
+      }
+      StartProfiling(phase, options);
+    } catch (const std::exception& e) {
+      SPDLOG_ERROR("profiling by signal failed: {}", e.what());
+    }
+  }
+}
+
+}  // namespace
+
+bool StartProfiling(const std::string& phase, const ProfilingOptions& options) {
+  auto* state = GetState();
+  std::lock_guard<std::mutex> lock(state->mutex);
+  if (state->running) {
+    return false;
+  }
+  const auto base = fmt::format("{}/yasl.{}.{}", options.dir, getpid(),
+                                FileNameOf(phase));
+  if (options.cpu) {
+    const auto file = base + ".cpu.prof";
+    YASL_ENFORCE(ProfilerStart(file.c_str()),
+                 "failed to start cpu profiler, file={}", file);
+  }
+  if (options.heap) {
+    // a pooled buffer would be charged to whoever allocated it first.
+    state->buffer_allocator = GetBufferAllocator();
+    SetBufferAllocator(DefaultBufferAllocator());
+    HeapProfilerStart(base.c_str());
+  }
+  state->running = true;
+  state->base = base;
+  state->options = options;
+  SPDLOG_INFO("profiling phase {}, to {}.*", phase, base);
+  return true;
+}
+
+std::vector<std::string> StopProfiling() {
+  auto* state = GetState();
+  std::lock_guard<std::mutex> lock(state->mutex);
+  if (!state->running) {
+    return {};
+  }
+  state->running = false;
+  std::vector<std::string> files;
+  if (state->options.cpu) {
+    ProfilerStop();
+    files.push_back(state->base + ".cpu.prof");
+  }
+  if (state->options.heap) {
+    char* profile = GetHeapProfile();
+    HeapProfilerStop();
+    SetBufferAllocator(state->buffer_allocator);
+    const auto file = state->base + ".heap";
+    std::ofstream out(file, std::ios::binary);
+    out << (profile != nullptr ? profile : "");
+    std::free(profile);
+    YASL_ENFORCE(out.good(), "failed to write heap profile, file={}", file);
+    files.push_back(file);
+  }
+  SPDLOG_INFO("profiling stopped, wrote {}", fmt::join(files, ", "));
+  return files;
+}
+
+bool IsProfiling() {
+  auto* state = GetState();
+  std::lock_guard<std::mutex> lock(state->mutex);
+  return state->running;
+}
+
+void InstallProfilingSignalHandler(int signo, const ProfilingOptions& options) {
+  auto* state = GetState();
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->signal_options = options;
+  }
+  static std::once_flag once;
+  std::call_once(once, [] {
+    YASL_ENFORCE(pipe(signal_pipe) == 0,
+                 "failed to create profiling signal pipe, errno={}", errno);
+    std::thread(SignalLoop).detach();
+  });
+
+  struct sigaction action = {};
+  action.sa_handler = OnProfilingSignal;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  YASL_ENFORCE(sigaction(signo, &action, nullptr) == 0,
+               "failed to install profiling signal handler, signo={}", signo);
+}
+
+}  // namespace yasl
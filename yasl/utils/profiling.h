@@ -0,0 +1,79 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Brief: cpu and heap profiles of a running job by gperftools, whose
+// tcmalloc the yasl binaries link. A phase of a job is profiled by the api,
+// or, without a restart, by a signal which toggles profiling:
+//
+//   InstallProfilingSignalHandler(SIGUSR2);
+//   ...
+//   $ kill -USR2 <pid>   # starts a phase
+//   $ kill -USR2 <pid>   # stops it and writes the profiles
+//   $ pprof --svg ./job /tmp/yasl.<pid>.signal-1.cpu.prof
+//
+// While the heap is profiled, buffers are not pooled, so that every buffer
+// is charged to the code which allocated it.
+
+#pragma once
+
+#include <csignal>
+#include <string>
+#include <vector>
+
+namespace yasl {
+
+struct ProfilingOptions {
+  // profiles of a phase are written as
+  // <dir>/yasl.<pid>.<phase>.{cpu.prof,heap}.
+  std::string dir = "/tmp";
+  bool cpu = true;
+  bool heap = true;
+};
+
+// starts profiling a phase, false if one is running already.
+bool StartProfiling(const std::string& phase,
+                    const ProfilingOptions& options = {});
+
+// stops the running phase, returns the profiles written.
+std::vector<std::string> StopProfiling();
+
+bool IsProfiling();
+
+// profiles its lifetime as a phase, unless one is running already.
+class ScopedProfilingPhase {
+ public:
+  explicit ScopedProfilingPhase(const std::string& phase,
+                                const ProfilingOptions& options = {})
+      : started_(StartProfiling(phase, options)) {}
+
+  ~ScopedProfilingPhase() {
+    if (started_) {
+      StopProfiling();
+    }
+  }
+
+  ScopedProfilingPhase(const ScopedProfilingPhase&) = delete;
+  ScopedProfilingPhase& operator=(const ScopedProfilingPhase&) = delete;
+
+ private:
+  const bool started_;
+};
+
+// signo toggles profiling from then on, the phases are named signal-<n>.
+// the profilers are driven by a background thread, the handler itself only
+// wakes it up. installing it again replaces the options.
+void InstallProfilingSignalHandler(int signo = SIGUSR2,
+                                   const ProfilingOptions& options = {});
+
+}  // namespace yasl
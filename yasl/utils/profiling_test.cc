@@ -0,0 +1,99 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/profiling.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+
+#include "yasl/base/buffer.h"
+
+namespace yasl {
+
+namespace {
+
+ProfilingOptions TestOptions() {
+  ProfilingOptions options;
+  options.dir = ::testing::TempDir();
+  return options;
+}
+
+void Work() {
+  for (int i = 0; i < 100; ++i) {
+    Buffer buf(4096);
+    std::memset(buf.data(), i, buf.size());
+  }
+}
+
+}  // namespace
+
+TEST(ProfilingTest, Phase) {
+  const auto* pooled = GetBufferAllocator();
+  ASSERT_TRUE(StartProfiling("phase 1/a", TestOptions()));
+  EXPECT_TRUE(IsProfiling());
+  EXPECT_FALSE(StartProfiling("phase 2", TestOptions()));
+  // buffers are charged to their allocation sites meanwhile.
+  EXPECT_EQ(GetBufferAllocator(), DefaultBufferAllocator());
+  Work();
+
+  const auto files = StopProfiling();
+  EXPECT_FALSE(IsProfiling());
+  EXPECT_EQ(GetBufferAllocator(), pooled);
+  ASSERT_EQ(files.size(), 2);
+  for (const auto& file : files) {
+    EXPECT_NE(file.find(".phase_1_a."), std::string::npos) << file;
+    EXPECT_TRUE(std::filesystem::exists(file)) << file;
+    std::filesystem::remove(file);
+  }
+  EXPECT_TRUE(StopProfiling().empty());
+}
+
+TEST(ProfilingTest, ScopedPhase) {
+  auto options = TestOptions();
+  options.heap = false;
+  {
+    ScopedProfilingPhase phase("scoped", options);
+    EXPECT_TRUE(IsProfiling());
+    Work();
+  }
+  EXPECT_FALSE(IsProfiling());
+}
+
+TEST(ProfilingTest, Signal) {
+  InstallProfilingSignalHandler(SIGUSR2, TestOptions());
+  auto wait_for = [](bool profiling) {
+    for (int i = 0; i < 1000 && IsProfiling() != profiling; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return IsProfiling() == profiling;
+  };
+  ASSERT_EQ(kill(getpid(), SIGUSR2), 0);
+  ASSERT_TRUE(wait_for(true));
+  Work();
+  ASSERT_EQ(kill(getpid(), SIGUSR2), 0);
+  ASSERT_TRUE(wait_for(false));
+  const auto base =
+      fmt::format("{}/yasl.{}.signal-1", ::testing::TempDir(), getpid());
+  EXPECT_TRUE(std::filesystem::remove(base + ".cpu.prof"));
+  EXPECT_TRUE(std::filesystem::remove(base + ".heap"));
+}
+
+}  // namespace yasl
@@ -0,0 +1,84 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <thread>
+
+#include "benchmark/benchmark.h"
+
+#include "yasl/utils/lockfree_queue.h"
+#include "yasl/utils/pipeline.h"
+
+namespace yasl {
+namespace {
+
+// round trips of an item between two threads, through a queue each way, so
+// a round trip is two hand-offs.
+template <class Q>
+void BM_PingPong(benchmark::State& state) {
+  Q ping(16);
+  Q pong(16);
+  std::thread echo([&] {
+    while (auto item = ping.Pop()) {
+      pong.Push(*item);
+    }
+    pong.Close();
+  });
+  int64_t i = 0;
+  for (auto _ : state) {
+    ping.Push(i++);
+    benchmark::DoNotOptimize(pong.Pop());
+  }
+  ping.Close();
+  echo.join();
+  state.SetItemsProcessed(state.iterations());
+}
+
+// items streamed from a producer thread to the benchmark thread.
+template <class Q>
+void BM_Stream(benchmark::State& state) {
+  Q queue(state.range(0));
+  std::thread producer([&] {
+    int64_t i = 0;
+    while (queue.Push(i++)) {
+    }
+  });
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(queue.Pop());
+  }
+  // also ends a push waiting for room.
+  queue.Close();
+  producer.join();
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_PingPong, SpscQueue<int64_t>)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PingPong, MpmcQueue<int64_t>)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PingPong, BoundedQueue<int64_t>)->UseRealTime();
+
+BENCHMARK_TEMPLATE(BM_Stream, SpscQueue<int64_t>)
+    ->Arg(16)
+    ->Arg(1024)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Stream, MpmcQueue<int64_t>)
+    ->Arg(16)
+    ->Arg(1024)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Stream, BoundedQueue<int64_t>)
+    ->Arg(16)
+    ->Arg(1024)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace yasl
@@ -15,27 +15,185 @@
 
 #include "yasl/utils/serialize.h"
 
+#include <climits>
+#include <cstring>
+
+#include "absl/base/config.h"
+#include "absl/base/internal/endian.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+
+#include "yasl/base/exception.h"
 #include "yasl/utils/serializable.pb.h"
 
 namespace yasl {
 
+namespace {
+
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::internal::WireFormatLite;
+
+// An array of buffers is laid out flat, all integers little endian:
+//
+//   | version (1 byte) | count (8) | size of each buffer (8 each) | bytes |
+//
+// which is written with a single allocation and read without copying. The
+// older ArrayOfBuffer proto format is still read: its first byte is a tag
+// of field 1 or more, which never equals the version.
+constexpr uint8_t kFlatArrayVersion = 1;
+
+// ArrayOfBuffer is walked by hand, so that its buffers are copied once
+// instead of through the strings of the proto.
+const uint32_t kBufsTag = WireFormatLite::MakeTag(
+    ArrayOfBuffer::kBufsFieldNumber, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+
+template <class F>
+void ForEachBufferOfProtoArray(ByteContainerView buf, const F& f) {
+  YASL_ENFORCE(buf.size() <= INT_MAX, "array of buffers too large, size={}",
+               buf.size());
+  CodedInputStream in(buf.data(), static_cast<int>(buf.size()));
+  while (const uint32_t tag = in.ReadTag()) {
+    uint32_t length = 0;
+    YASL_ENFORCE(tag == kBufsTag && in.ReadVarint32(&length),
+                 "invalid array of buffers, tag={}", tag);
+    const size_t offset = in.CurrentPosition();
+    YASL_ENFORCE(in.Skip(length), "truncated array of buffers, size={}",
+                 buf.size());
+    f(offset, length);
+  }
+  YASL_ENFORCE(static_cast<size_t>(in.CurrentPosition()) == buf.size(),
+               "invalid array of buffers");
+}
+
+// f(offset, length) for every buffer of the serialized array.
+template <class F>
+void ForEachBufferOfArray(ByteContainerView buf, const F& f) {
+  if (buf.empty() || buf[0] != kFlatArrayVersion) {
+    ForEachBufferOfProtoArray(buf, f);
+    return;
+  }
+  constexpr size_t kHeaderSize = 1 + sizeof(uint64_t);
+  YASL_ENFORCE(buf.size() >= kHeaderSize, "truncated array of buffers");
+  const uint64_t count = absl::little_endian::Load64(buf.data() + 1);
+  YASL_ENFORCE(count <= (buf.size() - kHeaderSize) / sizeof(uint64_t),
+               "truncated array of buffers, count={}, size={}", count,
+               buf.size());
+  const uint8_t* sizes = buf.data() + kHeaderSize;
+  size_t offset = kHeaderSize + count * sizeof(uint64_t);
+  for (uint64_t i = 0; i < count; ++i) {
+    const uint64_t length =
+        absl::little_endian::Load64(sizes + i * sizeof(uint64_t));
+    YASL_ENFORCE(length <= buf.size() - offset,
+                 "truncated array of buffers, size={}", buf.size());
+    f(offset, length);
+    offset += length;
+  }
+  YASL_ENFORCE(offset == buf.size(),
+               "invalid array of buffers, {} of {} bytes used", offset,
+               buf.size());
+}
+
+size_t Int128ArrayWidth(size_t bits) {
+  YASL_ENFORCE(bits > 0 && bits <= 128 && bits % 8 == 0,
+               "bits of int128 array should be a multiple of 8 in (0, 128], "
+               "got {}",
+               bits);
+  return bits / 8;
+}
+
+Buffer SerializeLowBytes(absl::Span<const uint128_t> values, size_t width) {
+  Buffer out(static_cast<int64_t>(values.size() * width));
+  auto* p = out.data<uint8_t>();
+#ifdef ABSL_IS_LITTLE_ENDIAN
+  if (width == sizeof(uint128_t)) {
+    if (!values.empty()) {
+      std::memcpy(p, values.data(), out.size());
+    }
+    return out;
+  }
+  for (size_t i = 0; i < values.size(); ++i) {
+    std::memcpy(p + i * width, &values[i], width);
+  }
+#else
+  for (size_t i = 0; i < values.size(); ++i) {
+    for (size_t b = 0; b < width; ++b) {
+      p[i * width + b] = static_cast<uint8_t>(values[i] >> (8 * b));
+    }
+  }
+#endif
+  return out;
+}
+
+void DeserializeLowBytes(ByteContainerView buf, absl::Span<uint128_t> out,
+                         size_t width) {
+  YASL_ENFORCE(buf.size() == out.size() * width,
+               "expect {} values of {} bytes, got {} bytes", out.size(), width,
+               buf.size());
+  const uint8_t* p = buf.data();
+#ifdef ABSL_IS_LITTLE_ENDIAN
+  if (width == sizeof(uint128_t)) {
+    if (!out.empty()) {
+      std::memcpy(out.data(), p, buf.size());
+    }
+    return;
+  }
+  for (size_t i = 0; i < out.size(); ++i) {
+    uint128_t v = 0;
+    std::memcpy(&v, p + i * width, width);
+    out[i] = v;
+  }
+#else
+  for (size_t i = 0; i < out.size(); ++i) {
+    uint128_t v = 0;
+    for (size_t b = 0; b < width; ++b) {
+      v |= static_cast<uint128_t>(p[i * width + b]) << (8 * b);
+    }
+    out[i] = v;
+  }
+#endif
+}
+
+}  // namespace
+
 Buffer SerializeArrayOfBuffers(const std::vector<ByteContainerView>& bufs) {
-  ArrayOfBuffer proto;
+  Buffer header;
+  return SerializeArrayOfBuffers(bufs, &header).Flatten();
+}
+
+ByteChainView SerializeArrayOfBuffers(
+    const std::vector<ByteContainerView>& bufs, Buffer* header) {
+  header->resize(
+      static_cast<int64_t>(1 + sizeof(uint64_t) * (1 + bufs.size())));
+  auto* p = header->data<uint8_t>();
+  *p++ = kFlatArrayVersion;
+  absl::little_endian::Store64(p, bufs.size());
+  p += sizeof(uint64_t);
   for (const auto& b : bufs) {
-    proto.add_bufs(b.data(), b.size());
+    absl::little_endian::Store64(p, b.size());
+    p += sizeof(uint64_t);
   }
-  Buffer b(proto.ByteSizeLong());
-  proto.SerializePartialToArray(b.data(), b.size());
-  return b;
+  ByteChainView chain;
+  chain.Append(ByteContainerView(*header));
+  for (const auto& b : bufs) {
+    chain.Append(b);
+  }
+  return chain;
 }
 
 std::vector<Buffer> DeserializeArrayOfBuffers(ByteContainerView buf) {
-  ArrayOfBuffer proto;
   std::vector<Buffer> bufs;
-  proto.ParseFromArray(buf.data(), buf.size());
-  for (const auto& b : proto.bufs()) {
-    bufs.emplace_back(b);
-  }
+  ForEachBufferOfArray(buf, [&](size_t offset, size_t length) {
+    bufs.emplace_back(buf.data() + offset, length);
+  });
+  return bufs;
+}
+
+std::vector<SharedBuffer> DeserializeArrayOfSharedBuffers(
+    const SharedBuffer& buf) {
+  std::vector<SharedBuffer> bufs;
+  ForEachBufferOfArray(buf, [&](size_t offset, size_t length) {
+    bufs.push_back(buf.Slice(offset, length));
+  });
   return bufs;
 }
 
@@ -73,4 +231,35 @@ uint128_t DeserializeUint128(ByteContainerView buf) {
   return MakeUint128(proto.hi(), proto.lo());
 }
 
+Buffer SerializeUint128Array(absl::Span<const uint128_t> values,
+                             size_t bits) {
+  return SerializeLowBytes(values, Int128ArrayWidth(bits));
+}
+
+void DeserializeUint128ArrayInto(ByteContainerView buf,
+                                 absl::Span<uint128_t> out, size_t bits) {
+  DeserializeLowBytes(buf, out, Int128ArrayWidth(bits));
+}
+
+Buffer SerializeInt128Array(absl::Span<const int128_t> values, size_t bits) {
+  // two's complement, so the low bytes are the same as of the unsigned.
+  return SerializeLowBytes(
+      absl::MakeConstSpan(reinterpret_cast<const uint128_t*>(values.data()),
+                          values.size()),
+      Int128ArrayWidth(bits));
+}
+
+void DeserializeInt128ArrayInto(ByteContainerView buf, absl::Span<int128_t> out,
+                                size_t bits) {
+  auto* uout = reinterpret_cast<uint128_t*>(out.data());
+  DeserializeLowBytes(buf, absl::MakeSpan(uout, out.size()),
+                      Int128ArrayWidth(bits));
+  if (bits < 128) {
+    const size_t shift = 128 - bits;
+    for (auto& v : out) {
+      v = static_cast<int128_t>(static_cast<uint128_t>(v) << shift) >> shift;
+    }
+  }
+}
+
 }  // namespace yasl
@@ -17,16 +17,32 @@
 
 #include <vector>
 
+#include "absl/types/span.h"
+
 #include "yasl/base/buffer.h"
 #include "yasl/base/byte_container_view.h"
 #include "yasl/base/int128.h"
+#include "yasl/base/shared_buffer.h"
 
 namespace yasl {
 
+// packs bufs into a single buffer, a flat length prefixed format.
 Buffer SerializeArrayOfBuffers(const std::vector<ByteContainerView>& bufs);
 
+// the same array as a chain of bufs behind their count and sizes, which are
+// written to `header`, so that it is sent without copying bufs. the chain
+// refers to header and bufs.
+ByteChainView SerializeArrayOfBuffers(
+    const std::vector<ByteContainerView>& bufs, Buffer* header);
+
+// unpacks a buffer of SerializeArrayOfBuffers, which may also come in the
+// older ArrayOfBuffer proto format.
 std::vector<Buffer> DeserializeArrayOfBuffers(ByteContainerView buf);
 
+// the buffers of a serialized array as slices of buf, no copy.
+std::vector<SharedBuffer> DeserializeArrayOfSharedBuffers(
+    const SharedBuffer& buf);
+
 Buffer SerializeInt128(int128_t v);
 
 int128_t DeserializeInt128(ByteContainerView buf);
@@ -35,4 +51,21 @@ Buffer SerializeUint128(uint128_t v);
 
 uint128_t DeserializeUint128(ByteContainerView buf);
 
+// values as raw little endian integers of bits bits each, a multiple of 8.
+// bits < 128 keeps the low bits only, so values are taken mod 2^bits, which
+// is what shares of a ring of that size need.
+Buffer SerializeUint128Array(absl::Span<const uint128_t> values,
+                             size_t bits = 128);
+
+// reads out.size() values of SerializeUint128Array, with the same bits.
+void DeserializeUint128ArrayInto(ByteContainerView buf,
+                                 absl::Span<uint128_t> out, size_t bits = 128);
+
+// as the uint128 ones, values are sign extended from bits on the way back.
+Buffer SerializeInt128Array(absl::Span<const int128_t> values,
+                            size_t bits = 128);
+
+void DeserializeInt128ArrayInto(ByteContainerView buf, absl::Span<int128_t> out,
+                                size_t bits = 128);
+
 }  // namespace yasl
@@ -0,0 +1,157 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/serialize.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "yasl/utils/serializable.pb.h"
+
+namespace yasl {
+
+TEST(SerializeTest, ArrayOfBuffers) {
+  const std::vector<std::string> items = {"a", "", std::string(300, 'x'),
+                                          std::string(70000, 'y')};
+  auto packed = SerializeArrayOfBuffers({items.begin(), items.end()});
+
+  // a single allocation of the version, the count, the sizes and the bytes.
+  size_t total = 0;
+  for (const auto& item : items) {
+    total += item.size();
+  }
+  EXPECT_EQ(packed.size(), 1 + 8 * (1 + items.size()) + total);
+
+  auto bufs = DeserializeArrayOfBuffers(packed);
+  ASSERT_EQ(bufs.size(), items.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    EXPECT_EQ(std::string_view(bufs[i]), items[i]);
+  }
+
+  SharedBuffer shared(std::move(packed));
+  auto slices = DeserializeArrayOfSharedBuffers(shared);
+  ASSERT_EQ(slices.size(), items.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    EXPECT_EQ(std::string_view(slices[i]), items[i]);
+    EXPECT_GE(slices[i].data(), shared.data());
+    EXPECT_LE(slices[i].data() + slices[i].size(),
+              shared.data() + shared.size());
+  }
+
+  EXPECT_TRUE(DeserializeArrayOfBuffers(SerializeArrayOfBuffers({})).empty());
+}
+
+TEST(SerializeTest, ArrayOfBuffersChain) {
+  const std::vector<std::string> items = {"a", "", std::string(300, 'x')};
+  const std::vector<ByteContainerView> views(items.begin(), items.end());
+  Buffer header;
+  auto chain = SerializeArrayOfBuffers(views, &header);
+
+  // the header, then the items in place.
+  ASSERT_EQ(chain.parts().size(), 3);
+  EXPECT_EQ(chain.parts()[0].data(), header.data<uint8_t>());
+  EXPECT_EQ(chain.parts()[2].data(),
+            reinterpret_cast<const uint8_t*>(items[2].data()));
+
+  auto packed = chain.Flatten();
+  EXPECT_EQ(std::string_view(packed),
+            std::string_view(SerializeArrayOfBuffers(views)));
+  auto bufs = DeserializeArrayOfBuffers(packed);
+  ASSERT_EQ(bufs.size(), items.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    EXPECT_EQ(std::string_view(bufs[i]), items[i]);
+  }
+}
+
+TEST(SerializeTest, ProtoArrayOfBuffers) {
+  // the format of older peers.
+  ArrayOfBuffer proto;
+  proto.add_bufs("abc");
+  proto.add_bufs("");
+  proto.add_bufs(std::string(1000, 'z'));
+  const auto packed = proto.SerializeAsString();
+
+  auto bufs = DeserializeArrayOfBuffers(packed);
+  ASSERT_EQ(bufs.size(), 3);
+  EXPECT_EQ(std::string_view(bufs[0]), "abc");
+  EXPECT_EQ(bufs[1].size(), 0);
+  EXPECT_EQ(std::string_view(bufs[2]), std::string(1000, 'z'));
+
+  auto slices = DeserializeArrayOfSharedBuffers(SharedBuffer(packed));
+  ASSERT_EQ(slices.size(), 3);
+  EXPECT_EQ(std::string_view(slices[0]), "abc");
+
+  EXPECT_TRUE(DeserializeArrayOfBuffers(ArrayOfBuffer().SerializeAsString())
+                  .empty());
+}
+
+TEST(SerializeTest, InvalidArrayOfBuffers) {
+  auto packed = SerializeArrayOfBuffers({"abc", "defg"});
+  EXPECT_THROW(DeserializeArrayOfBuffers(
+                   ByteContainerView(packed.data(), packed.size() - 1)),
+               EnforceNotMet);
+  Int128Proto other;
+  other.set_hi(1);
+  EXPECT_THROW(DeserializeArrayOfBuffers(other.SerializeAsString()),
+               EnforceNotMet);
+}
+
+TEST(SerializeTest, Uint128Array) {
+  std::vector<uint128_t> values = {0, 1, Uint128Max(),
+                                   MakeUint128(0x0123456789abcdef, 42)};
+  for (size_t i = 0; i < 100; ++i) {
+    values.push_back(MakeUint128(i * 0x9e3779b97f4a7c15, ~i));
+  }
+
+  for (size_t bits : {8, 40, 64, 72, 128}) {
+    const auto buf = SerializeUint128Array(values, bits);
+    EXPECT_EQ(buf.size(), values.size() * bits / 8);
+    std::vector<uint128_t> out(values.size());
+    DeserializeUint128ArrayInto(buf, absl::MakeSpan(out), bits);
+    const uint128_t mask =
+        bits == 128 ? Uint128Max() : (uint128_t(1) << bits) - 1;
+    for (size_t i = 0; i < values.size(); ++i) {
+      EXPECT_EQ(out[i], values[i] & mask) << bits << " " << i;
+    }
+  }
+
+  EXPECT_THROW(SerializeUint128Array(values, 12), EnforceNotMet);
+  std::vector<uint128_t> out(3);
+  EXPECT_THROW(DeserializeUint128ArrayInto(SerializeUint128Array(values, 64),
+                                           absl::MakeSpan(out), 64),
+               EnforceNotMet);
+}
+
+TEST(SerializeTest, Int128Array) {
+  const std::vector<int128_t> values = {0, 1, -1, 127, -128, Int128Max(),
+                                        Int128Min(), -1234567890123};
+  std::vector<int128_t> out(values.size());
+  DeserializeInt128ArrayInto(SerializeInt128Array(values), absl::MakeSpan(out));
+  EXPECT_EQ(out, values);
+
+  // values which fit are sign extended back.
+  const std::vector<int128_t> small = {0, 1, -1, 127, -128, -1234567890123};
+  out.resize(small.size());
+  DeserializeInt128ArrayInto(SerializeInt128Array(small, 48),
+                             absl::MakeSpan(out), 48);
+  EXPECT_EQ(out, small);
+  DeserializeInt128ArrayInto(SerializeInt128Array(small, 8),
+                             absl::MakeSpan(out), 8);
+  EXPECT_EQ(out[3], 127);
+  EXPECT_EQ(out[4], -128);
+}
+
+}  // namespace yasl
@@ -0,0 +1,190 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/thread_affinity.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
+#include "fmt/format.h"
+
+#include "yasl/base/exception.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace yasl {
+
+namespace {
+
+// first line of a sysfs file, empty if it can not be read.
+std::string ReadSysfs(const std::string& path) {
+  std::ifstream in(path);
+  std::string line;
+  std::getline(in, line);
+  return line;
+}
+
+CpuList Intersect(const CpuList& a, const CpuList& b) {
+  CpuList out;
+  std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                        std::back_inserter(out));
+  return out;
+}
+
+}  // namespace
+
+CpuList ParseCpuList(absl::string_view str) {
+  CpuList cpus;
+  str = absl::StripAsciiWhitespace(str);
+  if (str.empty()) {
+    return cpus;
+  }
+  for (absl::string_view range : absl::StrSplit(str, ',')) {
+    std::vector<absl::string_view> ends = absl::StrSplit(range, '-');
+    int first = 0;
+    int last = 0;
+    YASL_ENFORCE(ends.size() <= 2 && absl::SimpleAtoi(ends[0], &first) &&
+                     absl::SimpleAtoi(ends.back(), &last) && first >= 0 &&
+                     first <= last,
+                 "invalid cpu list {}", std::string(str));
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+CpuList AllowedCpus() {
+  CpuList cpus;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+    return cpus;
+  }
+#endif
+  for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); ++cpu) {
+    cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+size_t NumNumaNodes() {
+  const auto online =
+      ParseCpuList(ReadSysfs("/sys/devices/system/node/online"));
+  return online.empty() ? 1 : online.back() + 1;
+}
+
+CpuList NumaNodeCpus(size_t node) {
+  YASL_ENFORCE(node < NumNumaNodes(), "numa node {} out of {}", node,
+               NumNumaNodes());
+  const auto cpulist = ReadSysfs(
+      fmt::format("/sys/devices/system/node/node{}/cpulist", node));
+  if (cpulist.empty()) {
+    return AllowedCpus();
+  }
+  return Intersect(ParseCpuList(cpulist), AllowedCpus());
+}
+
+size_t CurrentNumaNode() {
+#ifdef __linux__
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return node;
+  }
+#endif
+  return 0;
+}
+
+bool BindCurrentThread(const CpuList& cpus) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+std::vector<CpuList> ParseThreadAffinity(absl::string_view spec,
+                                         size_t num_threads) {
+  std::vector<CpuList> affinity(num_threads);
+  if (spec.empty() || spec == "none") {
+    return affinity;
+  }
+  if (spec == "cores") {
+    const auto cpus = AllowedCpus();
+    YASL_ENFORCE(!cpus.empty());
+    for (size_t i = 0; i < num_threads; ++i) {
+      affinity[i] = {cpus[i % cpus.size()]};
+    }
+    return affinity;
+  }
+  if (spec == "numa") {
+    std::vector<CpuList> nodes;
+    for (size_t node = 0; node < NumNumaNodes(); ++node) {
+      auto cpus = NumaNodeCpus(node);
+      if (!cpus.empty()) {
+        nodes.push_back(std::move(cpus));
+      }
+    }
+    YASL_ENFORCE(!nodes.empty());
+    for (size_t i = 0; i < num_threads; ++i) {
+      affinity[i] = nodes[i % nodes.size()];
+    }
+    return affinity;
+  }
+  size_t node = 0;
+  YASL_ENFORCE(absl::ConsumePrefix(&spec, "node:") &&
+                   absl::SimpleAtoi(spec, &node),
+               "unknown thread affinity {}, expect none, cores, numa or "
+               "node:N",
+               std::string(spec));
+  const auto cpus = NumaNodeCpus(node);
+  YASL_ENFORCE(!cpus.empty(), "numa node {} has no cpu to run on", node);
+  std::fill(affinity.begin(), affinity.end(), cpus);
+  return affinity;
+}
+
+Buffer AllocateNumaLocal(size_t size) {
+  Buffer buf(static_cast<int64_t>(size));
+  std::memset(buf.data(), 0, size);
+  return buf;
+}
+
+}  // namespace yasl
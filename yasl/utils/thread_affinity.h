@@ -0,0 +1,65 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Brief: cpu and numa node binding of threads. The topology is read from
+// linux sysfs, other platforms look like one node and bind nothing.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+#include "yasl/base/buffer.h"
+
+namespace yasl {
+
+// cpu ids, in increasing order.
+using CpuList = std::vector<int>;
+
+// parses the kernel's cpu list format, like "0-3,8,10-11".
+CpuList ParseCpuList(absl::string_view str);
+
+// cpus the process may run on.
+CpuList AllowedCpus();
+
+// number of numa nodes of the host, 1 if unknown.
+size_t NumNumaNodes();
+
+// cpus of numa node `node` the process may run on.
+CpuList NumaNodeCpus(size_t node);
+
+// numa node of the cpu the calling thread runs on, 0 if unknown.
+size_t CurrentNumaNode();
+
+// binds the calling thread to cpus, false if that is not supported.
+bool BindCurrentThread(const CpuList& cpus);
+
+// the cpus each of num_threads workers is bound to, from a spec:
+//   "" or "none": no binding, every list is empty.
+//   "cores":      worker i on the i-th allowed cpu, round robin.
+//   "numa":       workers round robin over the nodes, each one free to
+//                 move within the cpus of its node.
+//   "node:N":     all workers within the cpus of node N.
+std::vector<CpuList> ParseThreadAffinity(absl::string_view spec,
+                                         size_t num_threads);
+
+// a buffer of size bytes, zeroed by the calling thread. linux places a page
+// on the node of the thread that first touches it, so for a bound thread
+// this is node local scratch. only fresh pages from the kernel are placed,
+// which glibc malloc uses for 128 KiB and up.
+Buffer AllocateNumaLocal(size_t size);
+
+}  // namespace yasl
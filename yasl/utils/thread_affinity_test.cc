@@ -0,0 +1,87 @@
+// Copyright 2022 Ant Group Co., Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yasl/utils/thread_affinity.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "yasl/base/exception.h"
+
+namespace yasl {
+
+TEST(ThreadAffinity, ParseCpuList) {
+  EXPECT_EQ(ParseCpuList("0-3,8,10-11\n"),
+            CpuList({0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_EQ(ParseCpuList("5,1-2,2"), CpuList({1, 2, 5}));
+  EXPECT_TRUE(ParseCpuList("").empty());
+  EXPECT_THROW(ParseCpuList("3-1"), EnforceNotMet);
+  EXPECT_THROW(ParseCpuList("1-2-3"), EnforceNotMet);
+  EXPECT_THROW(ParseCpuList("a"), EnforceNotMet);
+}
+
+TEST(ThreadAffinity, Topology) {
+  const auto allowed = AllowedCpus();
+  ASSERT_FALSE(allowed.empty());
+  ASSERT_GE(NumNumaNodes(), 1);
+  CpuList all;
+  for (size_t node = 0; node < NumNumaNodes(); ++node) {
+    for (int cpu : NumaNodeCpus(node)) {
+      all.push_back(cpu);
+    }
+  }
+  std::sort(all.begin(), all.end());
+  EXPECT_EQ(all, allowed);
+  EXPECT_LT(CurrentNumaNode(), NumNumaNodes());
+  EXPECT_THROW(NumaNodeCpus(NumNumaNodes()), EnforceNotMet);
+}
+
+TEST(ThreadAffinity, ParseThreadAffinity) {
+  const auto allowed = AllowedCpus();
+  for (const auto& cpus : ParseThreadAffinity("none", 3)) {
+    EXPECT_TRUE(cpus.empty());
+  }
+  const auto cores = ParseThreadAffinity("cores", allowed.size() + 1);
+  ASSERT_EQ(cores.size(), allowed.size() + 1);
+  EXPECT_EQ(cores[0], CpuList({allowed[0]}));
+  EXPECT_EQ(cores.back(), CpuList({allowed[0]}));
+  for (const auto& cpus : ParseThreadAffinity("numa", 4)) {
+    EXPECT_FALSE(cpus.empty());
+  }
+  for (const auto& cpus : ParseThreadAffinity("node:0", 2)) {
+    EXPECT_EQ(cpus, NumaNodeCpus(0));
+  }
+  EXPECT_THROW(ParseThreadAffinity("sockets", 2), EnforceNotMet);
+  EXPECT_THROW(ParseThreadAffinity("node:x", 2), EnforceNotMet);
+}
+
+TEST(ThreadAffinity, BindCurrentThread) {
+  const auto allowed = AllowedCpus();
+  std::thread([&] {
+    if (!BindCurrentThread({allowed.back()})) {
+      // binding is not supported.
+      return;
+    }
+    EXPECT_EQ(AllowedCpus(), CpuList({allowed.back()}));
+    auto buf = AllocateNumaLocal(1 << 20);
+    EXPECT_EQ(buf.size(), 1 << 20);
+    EXPECT_EQ(buf.data<uint8_t>()[12345], 0);
+  }).join();
+  // other threads are not affected.
+  EXPECT_EQ(AllowedCpus(), allowed);
+}
+
+}  // namespace yasl
@@ -14,10 +14,164 @@
 
 #include "yasl/utils/thread_pool.h"
 
+#include <algorithm>
+#include <deque>
+
+#include "fmt/format.h"
 #include "spdlog/spdlog.h"
 
 namespace yasl {
 
+namespace {
+
+// Chase-Lev deque ("Correct and Efficient Work-Stealing for Weak Memory
+// Models", Le et al. 2013). The owner pushes and pops at the bottom,
+// thieves steal from the top. Seq_cst accesses stand in for the fences of
+// the paper. Arrays replaced by a grow are kept until the deque dies, as
+// thieves may still read them.
+template <class T>
+class WorkStealingDeque {
+ public:
+  WorkStealingDeque() {
+    arrays_.push_back(std::make_unique<Array>(kInitialCapacity));
+    array_.store(arrays_.back().get());
+  }
+
+  // owner only.
+  void Push(T* item) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    const int64_t t = top_.load(std::memory_order_acquire);
+    Array* a = array_.load(std::memory_order_relaxed);
+    if (b - t > a->capacity - 1) {
+      a = Grow(a, b, t);
+    }
+    a->Put(b, item);
+    bottom_.store(b + 1, std::memory_order_release);
+  }
+
+  // owner only. nullptr if empty.
+  T* Pop() {
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Array* a = array_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_seq_cst);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T* item = a->Get(b);
+    if (t == b) {
+      // the last item, race the thieves for it.
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // any thread. nullptr if empty or lost a race.
+  T* Steal() {
+    int64_t t = top_.load(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_seq_cst);
+    if (t >= b) {
+      return nullptr;
+    }
+    T* item = array_.load(std::memory_order_acquire)->Get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+ private:
+  static constexpr int64_t kInitialCapacity = 256;
+
+  struct Array {
+    explicit Array(int64_t c)
+        : capacity(c), items(new std::atomic<T*>[static_cast<size_t>(c)]) {}
+
+    T* Get(int64_t i) const {
+      return items[i & (capacity - 1)].load(std::memory_order_relaxed);
+    }
+
+    void Put(int64_t i, T* item) {
+      items[i & (capacity - 1)].store(item, std::memory_order_relaxed);
+    }
+
+    const int64_t capacity;
+    std::unique_ptr<std::atomic<T*>[]> items;
+  };
+
+  Array* Grow(Array* a, int64_t b, int64_t t) {
+    arrays_.push_back(std::make_unique<Array>(a->capacity * 2));
+    Array* grown = arrays_.back().get();
+    for (int64_t i = t; i < b; i++) {
+      grown->Put(i, a->Get(i));
+    }
+    array_.store(grown, std::memory_order_release);
+    return grown;
+  }
+
+  std::atomic<int64_t> top_{0};
+  std::atomic<int64_t> bottom_{0};
+  std::atomic<Array*> array_;
+  // owner only.
+  std::vector<std::unique_ptr<Array>> arrays_;
+};
+
+// the pool and worker index of a pooled thread.
+thread_local const void* tls_pool = nullptr;
+thread_local size_t tls_index = 0;
+
+// xorshift, for picking victims.
+uint64_t NextRandom() {
+  thread_local uint64_t state =
+      std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+// an idle worker polls this many times before it sleeps, a fork-join
+// caller usually posts its next tasks within microseconds.
+constexpr int kSpinRounds = 512;
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+}  // namespace
+
+struct ThreadPool::Worker {
+  WorkStealingDeque<Task> deque;
+  // tasks submitted from outside the pool.
+  std::mutex inbox_mutex;
+  std::deque<Task*> inbox;
+
+  Task* PopInbox(bool wait_for_lock) {
+    std::unique_lock<std::mutex> lock(inbox_mutex, std::defer_lock);
+    if (wait_for_lock) {
+      lock.lock();
+    } else if (!lock.try_lock()) {
+      return nullptr;
+    }
+    if (inbox.empty()) {
+      return nullptr;
+    }
+    Task* task = inbox.front();
+    inbox.pop_front();
+    return task;
+  }
+};
+
 size_t ThreadPool::DefaultNumThreads() {
   auto num_threads = std::thread::hardware_concurrency();
   return num_threads;
@@ -26,39 +180,131 @@ size_t ThreadPool::DefaultNumThreads() {
 ThreadPool::ThreadPool() : ThreadPool(DefaultNumThreads()) {}
 
 // the constructor just launches some amount of workers
-ThreadPool::ThreadPool(size_t num_threads) : stop_(false) {
+ThreadPool::ThreadPool(size_t num_threads)
+    : ThreadPool(num_threads, std::vector<CpuList>(num_threads)) {}
+
+ThreadPool::ThreadPool(size_t num_threads, std::vector<CpuList> affinity)
+    : affinity_(std::move(affinity)) {
   SPDLOG_INFO("Create a fixed thread pool with size {}", num_threads);
   YASL_ENFORCE(num_threads > 0, "num_threads must > 0");
+  YASL_ENFORCE(affinity_.size() == num_threads,
+               "affinity of {} threads for a pool of {}", affinity_.size(),
+               num_threads);
 
   for (size_t i = 0; i < num_threads; ++i) {
-    threads_.emplace_back(std::thread(&ThreadPool::WorkLoop, this));
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads_.emplace_back(std::thread(&ThreadPool::WorkLoop, this, i));
+  }
+}
+
+void ThreadPool::Push(Task* task) {
+  // counted first, so that pending_ never drops below the queued tasks.
+  pending_.fetch_add(1);
+  if (tls_pool == this) {
+    workers_[tls_index]->deque.Push(task);
+  } else {
+    auto& worker = workers_[next_inbox_++ % workers_.size()];
+    std::lock_guard<std::mutex> lock(worker->inbox_mutex);
+    worker->inbox.push_back(task);
+  }
+  // a worker going to sleep counts itself in sleepers_ before it checks
+  // pending_, so either it sees this task or this sees it.
+  if (sleepers_.load() > 0) {
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+    condition_.notify_one();
+  }
+}
+
+void ThreadPool::Post(Task* task) {
+  YASL_ENFORCE(!stop_, "Post on a stopped ThreadPool");
+  Push(task);
+}
+
+ThreadPool::Task* ThreadPool::FindTask(Worker* own) {
+  if (own != nullptr) {
+    if (Task* task = own->deque.Pop()) {
+      return task;
+    }
+    if (Task* task = own->PopInbox(true)) {
+      return task;
+    }
   }
+  const size_t n = workers_.size();
+  for (size_t i = 0; i < 2 * n && pending_.load() > 0; i++) {
+    auto& victim = workers_[NextRandom() % n];
+    if (Task* task = victim->deque.Steal()) {
+      return task;
+    }
+    if (Task* task = victim->PopInbox(false)) {
+      return task;
+    }
+  }
+  return nullptr;
 }
 
-void ThreadPool::WorkLoop() {
+void ThreadPool::RunTask(Task* task) {
+  pending_.fetch_sub(1);
+  // note: the exception in task() will automatically catched by FUTURE
+  // object and the exception will rethrow in caller thread on FUTURE.get()
+  // called.
+  // a task owned by the caller may be gone as soon as it ran.
+  const bool owned = task->owned_by_pool;
+  task->Run();
+  if (owned) {
+    delete task;
+  }
+}
+
+bool ThreadPool::TryRunOne() {
+  Task* task = FindTask(tls_pool == this ? workers_[tls_index].get() : nullptr);
+  if (task == nullptr) {
+    return false;
+  }
+  RunTask(task);
+  return true;
+}
+
+void ThreadPool::WorkLoop(size_t index) {
+  tls_pool = this;
+  tls_index = index;
+  if (!affinity_[index].empty() && !BindCurrentThread(affinity_[index])) {
+    SPDLOG_WARN("Failed to bind pool thread {} to cpus {}", index,
+                fmt::join(affinity_[index], ","));
+  }
   while (true) {
-    std::function<void()> task;
-
-    {
-      std::unique_lock<std::mutex> lock(this->queue_mutex_);
-      this->condition_.wait(
-          lock, [this] { return this->stop_ || !this->tasks_.empty(); });
-      if (this->stop_ && this->tasks_.empty()) {
-        return;
-      }
-      task = std::move(this->tasks_.front());
-      this->tasks_.pop();
+    if (Task* task = FindTask(workers_[index].get())) {
+      RunTask(task);
+      continue;
+    }
+    if (pending_.load() > 0) {
+      // another worker is taking it, or it is in a deque being grown.
+      std::this_thread::yield();
+      continue;
+    }
+    int spin = 0;
+    while (spin < kSpinRounds && pending_.load() == 0) {
+      CpuRelax();
+      spin++;
+    }
+    if (spin < kSpinRounds) {
+      continue;
     }
 
-    // note: the exception in task() will automatically catched by FUTURE object
-    // and the exception will rethrow in caller thread on FUTURE.get() called.
-    task();
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleepers_.fetch_add(1);
+    condition_.wait(lock, [this] { return stop_ || pending_.load() > 0; });
+    sleepers_.fetch_sub(1);
+    if (stop_ && pending_.load() == 0) {
+      return;
+    }
   }
 }
 
 // the destructor joins all threads
 ThreadPool::~ThreadPool() {
-  std::unique_lock<std::mutex> lock(queue_mutex_);
+  std::unique_lock<std::mutex> lock(sleep_mutex_);
   stop_ = true;
   lock.unlock();
 
@@ -68,11 +314,6 @@ ThreadPool::~ThreadPool() {
   }
 }
 
-bool ThreadPool::InThreadPool() const {
-  return std::any_of(threads_.begin(), threads_.end(),
-                     [](const std::thread& thread) {
-                       return thread.get_id() == std::this_thread::get_id();
-                     });
-}
+bool ThreadPool::InThreadPool() const { return tls_pool == this; }
 
 }  // namespace yasl
@@ -12,28 +12,37 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 //
-// Brief: A simple thread pool
+// Brief: A work stealing thread pool
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <type_traits>
 #include <vector>
 
 #include "yasl/base/exception.h"
+#include "yasl/utils/thread_affinity.h"
 
 namespace yasl {
 
+// Each worker owns a lock free deque. Tasks submitted by a worker are
+// pushed to and popped from the bottom of its own deque, tasks submitted by
+// other threads go round robin to the workers' inboxes. An idle worker
+// steals from the top of the deques and inboxes of random victims, so
+// there is no lock shared by all workers.
 class ThreadPool {
  public:
   ThreadPool();
   explicit ThreadPool(size_t num_threads);
+  // worker i binds itself to affinity[i], see ParseThreadAffinity. an empty
+  // list leaves the worker unbound.
+  ThreadPool(size_t num_threads, std::vector<CpuList> affinity);
 
   ThreadPool(const ThreadPool &) = delete;
   ThreadPool &operator=(const ThreadPool &) = delete;
@@ -44,6 +53,15 @@ class ThreadPool {
 
   size_t NumThreads() { return threads_.size(); }
 
+  // a task run by the pool. Submit wraps its callable into a task owned by
+  // the pool, a task given to Post stays owned by the caller.
+  struct Task {
+    virtual ~Task() = default;
+    virtual void Run() = 0;
+    // deleted by the pool after it ran.
+    bool owned_by_pool = false;
+  };
+
   // Submit task
   // if the thread pool has idle thread, the task will run immediately,
   // otherwise the task will waiting in a queue.
@@ -51,26 +69,58 @@ class ThreadPool {
   auto Submit(F &&f, Args &&...args)
       -> std::future<typename std::invoke_result_t<F, Args...>>;
 
+  // Post a task owned by the caller, who keeps it alive until it ran. No
+  // future and no allocation, for fork-join loops with short bodies; Run
+  // must not throw, the task reports its own completion.
+  void Post(Task *task);
+
   // return true if the current (self) thread is a pooled thread
   bool InThreadPool() const;
 
+  // runs one queued task on the calling thread, false if none was found.
+  // lets a thread waiting for tasks help instead of blocking a worker.
+  bool TryRunOne();
+
   // get queue length.
-  // don't need lock mutex here, because length may be changed after function
-  // returned
-  size_t GetQueueLength() const { return tasks_.size(); }
+  // tasks submitted but not yet taken by a worker, may be changed after
+  // function returned.
+  size_t GetQueueLength() const { return pending_.load(); }
 
  private:
-  void WorkLoop();
-
+  // the packaged task is the only allocation besides the future state.
+  template <class R>
+  struct PackagedTask : Task {
+    explicit PackagedTask(std::packaged_task<R()> t) : task(std::move(t)) {
+      owned_by_pool = true;
+    }
+    void Run() override { task(); }
+    std::packaged_task<R()> task;
+  };
+
+  struct Worker;
+
+  // takes ownership of the task if it is owned_by_pool.
+  void Push(Task *task);
+  void WorkLoop(size_t index);
+  // a task of worker own, its inbox, or stolen. own is nullptr outside the
+  // pool. nullptr if none found.
+  Task *FindTask(Worker *own);
+  void RunTask(Task *task);
+
+  std::vector<CpuList> affinity_;
   // need to keep track of threads so we can join them
   std::vector<std::thread> threads_;
-  // the task queue
-  std::queue<std::function<void()>> tasks_;
-
-  // synchronization
-  std::mutex queue_mutex_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  // inbox of the next task submitted from outside the pool.
+  std::atomic<size_t> next_inbox_{0};
+  // tasks pushed but not taken yet.
+  std::atomic<size_t> pending_{0};
+
+  // sleeping workers wait on condition_ until pending_ is positive.
+  std::mutex sleep_mutex_;
   std::condition_variable condition_;
-  bool stop_;
+  std::atomic<size_t> sleepers_{0};
+  std::atomic<bool> stop_{false};
 };
 
 template <class F, class... Args>
@@ -78,19 +128,13 @@ auto ThreadPool::Submit(F &&f, Args &&...args)
     -> std::future<typename std::invoke_result_t<F, Args...>> {
   using return_type = typename std::invoke_result_t<F, Args...>;
 
-  auto task = std::make_shared<std::packaged_task<return_type()>>(
-      std::bind(std::forward<F>(f), std::forward<Args>(args)...));
-
-  std::future<return_type> res = task->get_future();
-  {
-    std::unique_lock<std::mutex> lock(queue_mutex_);
+  // don't allow enqueueing after stopping the pool
+  YASL_ENFORCE(!stop_, "Submit on a stopped ThreadPool");
 
-    // don't allow enqueueing after stopping the pool
-    YASL_ENFORCE(!stop_, "Submit on a stopped ThreadPool");
-
-    tasks_.emplace([task]() { (*task)(); });
-  }
-  condition_.notify_one();
+  std::packaged_task<return_type()> task(
+      std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+  std::future<return_type> res = task.get_future();
+  Push(new PackagedTask<return_type>(std::move(task)));
   return res;
 }
 
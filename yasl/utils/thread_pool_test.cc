@@ -90,6 +90,86 @@ TEST_F(ThreadPoolTest, MoreTasksTest) {
   EXPECT_EQ(sum.load(), 10000 * kThreadPoolSize * 10);
 }
 
+// tasks submitted by a worker go to its own deque, other workers steal them.
+TEST_F(ThreadPoolTest, NestedSubmitTest) {
+  auto outer = thread_pool_.Submit([this]() {
+    EXPECT_TRUE(thread_pool_.InThreadPool());
+    std::vector<std::future<int64_t>> inner;
+    // more than the initial deque capacity.
+    for (int64_t i = 0; i < 5000; ++i) {
+      inner.push_back(thread_pool_.Submit([i]() { return i; }));
+    }
+    int64_t sum = 0;
+    for (auto& future : inner) {
+      sum += future.get();
+    }
+    return sum;
+  });
+  EXPECT_EQ(outer.get(), 5000 * 4999 / 2);
+}
+
+TEST_F(ThreadPoolTest, ManySmallTasksTest) {
+  std::atomic<int64_t> sum(0);
+  std::vector<std::future<void>> futures;
+  for (int64_t i = 0; i < 100000; ++i) {
+    futures.push_back(thread_pool_.Submit([&sum, i]() { sum += i; }));
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+  EXPECT_EQ(sum.load(), int64_t{100000} * 99999 / 2);
+  EXPECT_EQ(thread_pool_.GetQueueLength(), 0);
+}
+
+TEST_F(ThreadPoolTest, PostTest) {
+  struct AddTask : ThreadPool::Task {
+    void Run() override {
+      *sum += value;
+      done->fetch_add(1);
+    }
+    std::atomic<int64_t>* sum = nullptr;
+    std::atomic<int64_t>* done = nullptr;
+    int64_t value = 0;
+  };
+
+  std::atomic<int64_t> sum(0);
+  std::atomic<int64_t> done(0);
+  std::vector<AddTask> tasks(1000);
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    tasks[i].sum = &sum;
+    tasks[i].done = &done;
+    tasks[i].value = i;
+    thread_pool_.Post(&tasks[i]);
+  }
+  // the tasks stay owned by this frame, so wait before they go away.
+  while (done.load() < 1000) {
+    if (!thread_pool_.TryRunOne()) {
+      std::this_thread::yield();
+    }
+  }
+  EXPECT_EQ(sum.load(), 1000 * 999 / 2);
+}
+
+TEST_F(ThreadPoolTest, AffinityTest) {
+  ThreadPool pool(2, ParseThreadAffinity("cores", 2));
+  const auto allowed = AllowedCpus();
+  std::vector<std::future<CpuList>> futures;
+  for (int i = 0; i < 8; ++i) {
+    futures.push_back(pool.Submit([]() { return AllowedCpus(); }));
+  }
+  for (auto& future : futures) {
+    const auto cpus = future.get();
+#ifdef __linux__
+    ASSERT_EQ(cpus.size(), 1);
+    EXPECT_TRUE(cpus[0] == allowed[0] ||
+                cpus[0] == allowed[1 % allowed.size()]);
+#else
+    EXPECT_EQ(cpus, allowed);
+#endif
+  }
+  EXPECT_THROW(ThreadPool(2, std::vector<CpuList>(3)), EnforceNotMet);
+}
+
 TEST_F(ThreadPoolTest, ParamsTest) {
   auto func1 = [](int a) { return a; };
   auto func2 = [](int a, long b) -> int { return a + b; };